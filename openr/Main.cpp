@@ -7,6 +7,7 @@
 
 #include <syslog.h>
 #include <fstream>
+#include <mutex>
 #include <stdexcept>
 
 #include <fbzmq/async/StopEventLoopSignalHandler.h>
@@ -32,6 +33,9 @@
 #include <openr/common/BuildInfo.h>
 #include <openr/common/Constants.h>
 #include <openr/common/Flags.h>
+#include <openr/common/MemoryArenas.h>
+#include <openr/common/ModuleStartup.h>
+#include <openr/common/ThreadScheduling.h>
 #include <openr/common/ThriftUtil.h>
 #include <openr/common/Util.h>
 #include <openr/config-store/PersistentStore.h>
@@ -63,6 +67,8 @@ using namespace openr;
 using namespace folly::gen;
 
 using apache::thrift::concurrency::ThreadManager;
+using openr::messaging::QueueOptions;
+using openr::messaging::QueueOverflowPolicy;
 using openr::messaging::ReplicateQueue;
 
 namespace {
@@ -71,6 +77,9 @@ namespace {
 //
 
 const std::string inet6Path = "/proc/net/if_inet6";
+
+// Guards thread and evb lists, as modules are started concurrently
+std::mutex startEventBaseMutex;
 } // namespace
 
 // Disable background jemalloc background thread => new jemalloc-5 feature
@@ -117,9 +126,50 @@ waitForFibService(const fbzmq::ZmqEventLoop& evl, int port) {
   LOG(INFO) << "FibService up. Waited for " << waitMs << " ms.";
 }
 
+/**
+ * Options of inter-module queue, which exports its counters under given name.
+ * Bounded queue blocks writer when full.
+ */
+QueueOptions
+getQueueOptions(const std::string& name, size_t capacity = 0) {
+  QueueOptions options;
+  options.name = name;
+  options.capacity = capacity;
+  options.overflowPolicy = QueueOverflowPolicy::BLOCK;
+  return options;
+}
+
+/**
+ * Name the calling thread and apply its configured CPU pinning and scheduling
+ * policy. Misconfiguration is fatal, as it would go unnoticed otherwise.
+ * Also binds the thread to its own jemalloc arena if module memory arenas
+ * are enabled.
+ */
+void
+setupThread(const Config& config, const std::string& name) {
+  folly::setThreadName(name);
+  try {
+    setupThreadScheduling(name, config.getThreadSchedulingConfig(name));
+  } catch (const std::system_error& ex) {
+    LOG(FATAL) << "Failed to setup scheduling of thread " << name << ": "
+               << folly::exceptionStr(ex);
+  }
+  if (config.isModuleMemoryArenasEnabled()) {
+    try {
+      if (not bindModuleArena(name)) {
+        LOG(WARNING) << "Not running on jemalloc, memory of thread " << name
+                     << " won't be accounted per module";
+      }
+    } catch (const std::runtime_error& ex) {
+      LOG(ERROR) << "Failed to bind thread " << name
+                 << " to jemalloc arena: " << folly::exceptionStr(ex);
+    }
+  }
+}
+
 /**
  * Start an EventBase in a thread, maintain order of thread creation and
- * returns raw pointer of Derived class.
+ * returns raw pointer of Derived class. Safe to call concurrently.
  */
 template <typename T>
 T*
@@ -127,20 +177,26 @@ startEventBase(
     std::vector<std::thread>& allThreads,
     std::vector<std::unique_ptr<OpenrEventBase>>& orderedEvbs,
     Watchdog* watchdog,
+    const Config& config,
     const std::string& name,
     std::unique_ptr<T> evbT) {
   CHECK(evbT);
   auto t = evbT.get();
   auto evb = std::unique_ptr<OpenrEventBase>(
       reinterpret_cast<OpenrEventBase*>(evbT.release()));
+  evb->setEvbName(name);
 
   // Start a thread
-  allThreads.emplace_back(std::thread([evb = evb.get(), name]() noexcept {
-    LOG(INFO) << "Starting " << name << " thread ...";
-    folly::setThreadName(name);
-    evb->run();
-    LOG(INFO) << name << " thread got stopped.";
-  }));
+  {
+    std::lock_guard<std::mutex> lock(startEventBaseMutex);
+    allThreads.emplace_back(
+        std::thread([evb = evb.get(), &config, name]() noexcept {
+          LOG(INFO) << "Starting " << name << " thread ...";
+          setupThread(config, name);
+          evb->run();
+          LOG(INFO) << name << " thread got stopped.";
+        }));
+  }
   evb->waitUntilRunning();
 
   // Add to watchdog
@@ -150,6 +206,7 @@ startEventBase(
 
   // Emplace evb into ordered list of evbs. So that we can destroy
   // them in revserse order of their creation.
+  std::lock_guard<std::mutex> lock(startEventBaseMutex);
   orderedEvbs.emplace_back(std::move(evb));
 
   return t;
@@ -267,17 +324,34 @@ main(int argc, char** argv) {
   folly::setThreadName("openr");
 
   // Queue for inter-module communication
-  ReplicateQueue<DecisionRouteUpdate> routeUpdatesQueue;
-  ReplicateQueue<KvStoreSyncEvent> kvStoreSyncEventsQueue;
-  ReplicateQueue<openr::thrift::InterfaceDatabase> interfaceUpdatesQueue;
-  ReplicateQueue<openr::thrift::SparkNeighborEvent> neighborUpdatesQueue;
-  ReplicateQueue<openr::thrift::PrefixUpdateRequest> prefixUpdateRequestQueue;
-  ReplicateQueue<openr::thrift::Publication> kvStoreUpdatesQueue;
-  ReplicateQueue<openr::thrift::PeerUpdateRequest> peerUpdatesQueue;
-  ReplicateQueue<openr::thrift::RouteDatabaseDelta> staticRoutesUpdateQueue;
-  ReplicateQueue<openr::thrift::RouteDatabaseDelta> fibUpdatesQueue;
-  ReplicateQueue<openr::fbnl::NetlinkEvent> netlinkEventsQueue;
-  ReplicateQueue<openr::LogSample> logSampleQueue;
+  ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue(
+      getQueueOptions("route_updates", FLAGS_route_queue_capacity));
+  ReplicateQueue<KvStoreSyncEvent> kvStoreSyncEventsQueue(
+      getQueueOptions("kvstore_sync_events"));
+  ReplicateQueue<openr::InterfaceDatabaseUpdate> interfaceUpdatesQueue(
+      getQueueOptions("interface_updates"));
+  ReplicateQueue<openr::InterfaceStatusEvent> interfaceStatusEventsQueue(
+      getQueueOptions("interface_status_events"));
+  ReplicateQueue<openr::thrift::SparkNeighborEvent> neighborUpdatesQueue(
+      getQueueOptions("neighbor_updates"));
+  ReplicateQueue<openr::thrift::PrefixUpdateRequest> prefixUpdateRequestQueue(
+      getQueueOptions("prefix_update_requests"));
+  auto kvStoreUpdatesOptions = getQueueOptions("kvstore_updates");
+  kvStoreUpdatesOptions.numPriorities = Constants::kKvStoreUpdatesNumPriorities;
+  ReplicateQueue<openr::PublicationPtr> kvStoreUpdatesQueue(
+      std::move(kvStoreUpdatesOptions));
+  ReplicateQueue<openr::thrift::PeerUpdateRequest> peerUpdatesQueue(
+      getQueueOptions("peer_updates"));
+  ReplicateQueue<openr::thrift::RouteDatabaseDelta> staticRoutesUpdateQueue(
+      getQueueOptions("static_routes_updates"));
+  ReplicateQueue<openr::thrift::RouteDatabaseDelta> fibUpdatesQueue(
+      getQueueOptions("fib_updates", FLAGS_route_queue_capacity));
+  ReplicateQueue<openr::thrift::LinkStateDelta> linkStateUpdatesQueue(
+      getQueueOptions("link_state_updates"));
+  ReplicateQueue<openr::fbnl::NetlinkEvent> netlinkEventsQueue(
+      getQueueOptions("netlink_events"));
+  ReplicateQueue<openr::LogSample> logSampleQueue(
+      getQueueOptions("log_samples"));
 
   // structures to organize our modules
   std::vector<std::thread> allThreads;
@@ -290,6 +364,7 @@ main(int argc, char** argv) {
         allThreads,
         orderedEvbs,
         nullptr /* watchdog won't monitor itself */,
+        *config,
         "Watchdog",
         std::make_unique<Watchdog>(config));
   }
@@ -297,7 +372,7 @@ main(int argc, char** argv) {
   // Starting main event-loop
   std::thread mainEventLoopThread([&]() noexcept {
     LOG(INFO) << "Starting main event loop...";
-    folly::setThreadName("MainLoop");
+    setupThread(*config, "MainLoop");
     mainEventLoop.run();
     LOG(INFO) << "Main event loop got stopped";
   });
@@ -325,10 +400,14 @@ main(int argc, char** argv) {
   // Create Netlink Protocol object in a new thread
   nlEvb = std::make_unique<OpenrEventBase>();
   nlSock = std::make_unique<openr::fbnl::NetlinkProtocolSocket>(
-      nlEvb->getEvb(), netlinkEventsQueue);
+      nlEvb->getEvb(),
+      netlinkEventsQueue,
+      openr::fbnl::isIPv6RouteReplaceSupported(),
+      config->isNetlinkRouteSocketsPerFamilyEnabled(),
+      config->getNetlinkRecvBufferBytes());
   allThreads.emplace_back([&]() {
     LOG(INFO) << "Starting NetlinkEvb thread ...";
-    folly::setThreadName("NetlinkEvb");
+    setupThread(*config, "NetlinkEvb");
     nlEvb->getEvb()->loopForever();
     LOG(INFO) << "NetlinkEvb thread got stopped.";
   });
@@ -348,10 +427,11 @@ main(int argc, char** argv) {
     netlinkFibServer->setCpp2WorkerThreadName("FibTWorker");
     netlinkFibServer->setPort(*config->getConfig().fib_port_ref());
 
-    netlinkFibServerThread =
-        std::make_unique<std::thread>([&netlinkFibServer, &nlSock]() {
-          folly::setThreadName("FibService");
-          auto fibHandler = std::make_shared<NetlinkFibHandler>(nlSock.get());
+    netlinkFibServerThread = std::make_unique<std::thread>(
+        [&netlinkFibServer, &nlSock, &config]() {
+          setupThread(*config, "FibService");
+          auto fibHandler = std::make_shared<NetlinkFibHandler>(
+              nlSock.get(), config->isNextHopGroupsEnabled());
           netlinkFibServer->setInterface(std::move(fibHandler));
 
           LOG(INFO) << "Starting NetlinkFib server...";
@@ -364,157 +444,255 @@ main(int argc, char** argv) {
   OpenrEventBase ctrlEvb;
   std::thread ctrlEvbThread([&]() noexcept {
     LOG(INFO) << "Starting openrCtrl eventbase...";
-    folly::setThreadName("openrCtrl");
+    setupThread(*config, "openrCtrl");
     ctrlEvb.run();
     LOG(INFO) << "OpenrCtrl eventbase stopped...";
   });
   ctrlEvb.waitUntilRunning();
 
+  // Readers are created before any module starts, so that none misses
+  // updates of a module started ahead of it
+  auto logSampleReader = logSampleQueue.getReader();
+  auto peerUpdatesReader = peerUpdatesQueue.getReader();
+  auto prefixManagerPrefixUpdatesReader = prefixUpdateRequestQueue.getReader();
+  auto prefixManagerRouteUpdatesReader = routeUpdatesQueue.getReader();
+  auto linkMonitorNeighborUpdatesReader = neighborUpdatesQueue.getReader();
+  auto linkMonitorKvStoreSyncEventsReader = kvStoreSyncEventsQueue.getReader();
+  auto linkMonitorNetlinkEventsReader = netlinkEventsQueue.getReader();
+  auto decisionKvStoreUpdatesReader = kvStoreUpdatesQueue.getReader();
+  auto decisionStaticRoutesReader = staticRoutesUpdateQueue.getReader();
+  auto fibRouteUpdatesReader = routeUpdatesQueue.getReader();
+  auto fibInterfaceUpdatesReader = interfaceUpdatesQueue.getReader();
+  auto fibInterfaceStatusEventsReader = interfaceStatusEventsQueue.getReader();
+  const auto numSparkShards = *sparkConf.num_shards_ref();
+  std::vector<messaging::RQueue<InterfaceDatabaseUpdate>>
+      sparkInterfaceUpdatesReaders;
+  for (int32_t shardId = 0; shardId < numSparkShards; ++shardId) {
+    sparkInterfaceUpdatesReaders.emplace_back(
+        interfaceUpdatesQueue.getReader());
+  }
+
+  //
+  // Modules are started concurrently, each one once the modules it holds a
+  // pointer of are running. A module is added to orderedEvbs only after its
+  // dependencies, so they are still stopped in reverse order.
+  //
+  ModuleStartup moduleStartup(config->getNodeName());
+  PersistentStore* configStore{nullptr};
+  openr::Monitor* monitor{nullptr};
+  KvStore* kvStore{nullptr};
+  PrefixManager* prefixManager{nullptr};
+  std::vector<Spark*> sparkShards(numSparkShards, nullptr);
+  LinkMonitor* linkMonitor{nullptr};
+  Decision* decision{nullptr};
+  Fib* fib{nullptr};
+
   // Start config-store URL
-  auto configStore = startEventBase(
-      allThreads,
-      orderedEvbs,
-      watchdog,
-      "ConfigStore",
-      std::make_unique<PersistentStore>(FLAGS_config_store_filepath));
+  moduleStartup.addModule("ConfigStore", {}, [&]() {
+    configStore = startEventBase(
+        allThreads,
+        orderedEvbs,
+        watchdog,
+        *config,
+        "ConfigStore",
+        std::make_unique<PersistentStore>(FLAGS_config_store_filepath));
+  });
 
   // Start monitor Module
-  auto monitor = startEventBase(
-      allThreads,
-      orderedEvbs,
-      watchdog,
-      "Monitor",
-      std::make_unique<openr::Monitor>(
-          config,
-          Constants::kEventLogCategory.toString(),
-          logSampleQueue.getReader()));
+  moduleStartup.addModule("Monitor", {}, [&]() {
+    monitor = startEventBase(
+        allThreads,
+        orderedEvbs,
+        watchdog,
+        *config,
+        "Monitor",
+        std::make_unique<openr::Monitor>(
+            config,
+            Constants::kEventLogCategory.toString(),
+            std::move(logSampleReader)));
+  });
 
   // Start KVStore
-  auto kvStore = startEventBase(
-      allThreads,
-      orderedEvbs,
-      watchdog,
-      "KvStore",
-      std::make_unique<KvStore>(
-          context,
-          kvStoreUpdatesQueue,
-          kvStoreSyncEventsQueue,
-          peerUpdatesQueue.getReader(),
-          logSampleQueue,
-          KvStoreGlobalCmdUrl{folly::sformat(
-              "tcp://{}:{}",
-              *config->getConfig().listen_addr_ref(),
-              FLAGS_kvstore_rep_port)},
-          config,
-          maybeIpTos,
-          FLAGS_kvstore_zmq_hwm,
-          config->isKvStoreThriftEnabled(),
-          config->isPeriodicSyncEnabled()));
-
-  auto prefixManager = startEventBase(
-      allThreads,
-      orderedEvbs,
-      watchdog,
-      "PrefixManager",
-      std::make_unique<PrefixManager>(
-          prefixUpdateRequestQueue.getReader(),
-          routeUpdatesQueue.getReader(),
-          config,
-          configStore,
-          kvStore,
-          FLAGS_enable_perf_measurement,
-          initialPrefixHoldTime));
+  moduleStartup.addModule("KvStore", {}, [&]() {
+    kvStore = startEventBase(
+        allThreads,
+        orderedEvbs,
+        watchdog,
+        *config,
+        "KvStore",
+        std::make_unique<KvStore>(
+            context,
+            kvStoreUpdatesQueue,
+            kvStoreSyncEventsQueue,
+            std::move(peerUpdatesReader),
+            logSampleQueue,
+            KvStoreGlobalCmdUrl{folly::sformat(
+                "tcp://{}:{}",
+                *config->getConfig().listen_addr_ref(),
+                FLAGS_kvstore_rep_port)},
+            config,
+            maybeIpTos,
+            FLAGS_kvstore_zmq_hwm,
+            config->isKvStoreThriftEnabled(),
+            config->isPeriodicSyncEnabled()));
+  });
+
+  moduleStartup.addModule("PrefixManager", {"ConfigStore", "KvStore"}, [&]() {
+    prefixManager = startEventBase(
+        allThreads,
+        orderedEvbs,
+        watchdog,
+        *config,
+        "PrefixManager",
+        std::make_unique<PrefixManager>(
+            std::move(prefixManagerPrefixUpdatesReader),
+            std::move(prefixManagerRouteUpdatesReader),
+            config,
+            configStore,
+            kvStore,
+            FLAGS_enable_perf_measurement,
+            initialPrefixHoldTime));
+  });
 
   // Prefix Allocator to automatically allocate prefixes for nodes
   if (config->isPrefixAllocationEnabled()) {
-    startEventBase(
+    moduleStartup.addModule(
+        "PrefixAllocator", {"ConfigStore", "KvStore"}, [&]() {
+          startEventBase(
+              allThreads,
+              orderedEvbs,
+              watchdog,
+              *config,
+              "PrefixAllocator",
+              std::make_unique<PrefixAllocator>(
+                  config,
+                  nlSock.get(),
+                  kvStore,
+                  configStore,
+                  prefixUpdateRequestQueue,
+                  logSampleQueue,
+                  Constants::kPrefixAllocatorSyncInterval));
+        });
+  }
+
+  // Create Spark instances for neighbor discovery, one per shard of
+  // interfaces. All of them report to same neighborUpdatesQueue.
+  for (int32_t shardId = 0; shardId < numSparkShards; ++shardId) {
+    const auto name =
+        shardId == 0 ? "Spark" : folly::sformat("Spark-{}", shardId);
+    moduleStartup.addModule(name, {"ConfigStore"}, [&, shardId, name]() {
+      std::shared_ptr<LivenessProvider> livenessProvider{nullptr};
+      if (*sparkConf.liveness_detect_time_ms_ref() > 0) {
+        livenessProvider = pluginCreateLivenessProvider(config);
+        LOG_IF(WARNING, not livenessProvider)
+            << "Liveness detection offload configured but not supported by "
+            << "platform. Relying on heartbeats only.";
+      }
+      sparkShards.at(shardId) = startEventBase(
+          allThreads,
+          orderedEvbs,
+          watchdog,
+          *config,
+          name,
+          std::make_unique<Spark>(
+              maybeIpTos,
+              std::move(sparkInterfaceUpdatesReaders.at(shardId)),
+              neighborUpdatesQueue,
+              KvStoreCmdPort{static_cast<uint16_t>(FLAGS_kvstore_rep_port)},
+              OpenrCtrlThriftPort{
+                  static_cast<uint16_t>(FLAGS_openr_ctrl_port)},
+              std::make_shared<IoProvider>(),
+              config,
+              std::make_pair(
+                  Constants::kOpenrVersion, Constants::kOpenrSupportedVersion),
+              Constants::kMaxAllowedPps,
+              static_cast<uint32_t>(shardId),
+              std::move(livenessProvider),
+              configStore));
+    });
+  }
+
+  // Create link monitor instance.
+  moduleStartup.addModule("LinkMonitor", {"ConfigStore", "KvStore"}, [&]() {
+    linkMonitor = startEventBase(
         allThreads,
         orderedEvbs,
         watchdog,
-        "PrefixAllocator",
-        std::make_unique<PrefixAllocator>(
+        *config,
+        "LinkMonitor",
+        std::make_unique<LinkMonitor>(
             config,
             nlSock.get(),
             kvStore,
             configStore,
+            FLAGS_enable_perf_measurement,
+            interfaceUpdatesQueue,
+            interfaceStatusEventsQueue,
             prefixUpdateRequestQueue,
+            peerUpdatesQueue,
             logSampleQueue,
-            Constants::kPrefixAllocatorSyncInterval));
-  }
-
-  // Create Spark instance for neighbor discovery
-  auto spark = startEventBase(
-      allThreads,
-      orderedEvbs,
-      watchdog,
-      "Spark",
-      std::make_unique<Spark>(
-          maybeIpTos,
-          interfaceUpdatesQueue.getReader(),
-          neighborUpdatesQueue,
-          KvStoreCmdPort{static_cast<uint16_t>(FLAGS_kvstore_rep_port)},
-          OpenrCtrlThriftPort{static_cast<uint16_t>(FLAGS_openr_ctrl_port)},
-          std::make_shared<IoProvider>(),
-          config));
+            std::move(linkMonitorNeighborUpdatesReader),
+            std::move(linkMonitorKvStoreSyncEventsReader),
+            std::move(linkMonitorNetlinkEventsReader),
+            FLAGS_assume_drained,
+            FLAGS_override_drain_state,
+            initialAdjHoldTime));
+  });
 
-  // Create link monitor instance.
-  auto linkMonitor = startEventBase(
-      allThreads,
-      orderedEvbs,
-      watchdog,
-      "LinkMonitor",
-      std::make_unique<LinkMonitor>(
-          config,
-          nlSock.get(),
-          kvStore,
-          configStore,
-          FLAGS_enable_perf_measurement,
-          interfaceUpdatesQueue,
-          prefixUpdateRequestQueue,
-          peerUpdatesQueue,
-          logSampleQueue,
-          neighborUpdatesQueue.getReader(),
-          kvStoreSyncEventsQueue.getReader(),
-          netlinkEventsQueue.getReader(),
-          FLAGS_assume_drained,
-          FLAGS_override_drain_state,
-          initialAdjHoldTime));
-
-  // Wait for the above two threads to start and run before running
-  // SPF in Decision module.  This is to make sure the Decision module
-  // receives itself as one of the nodes before running the spf.
-
-  // Start Decision Module
-  auto decision = startEventBase(
-      allThreads,
-      orderedEvbs,
-      watchdog,
-      "Decision",
-      std::make_unique<Decision>(
-          config,
-          FLAGS_enable_lfa,
-          not FLAGS_enable_bgp_route_programming,
-          std::chrono::milliseconds(FLAGS_decision_debounce_min_ms),
-          std::chrono::milliseconds(FLAGS_decision_debounce_max_ms),
-          kvStoreUpdatesQueue.getReader(),
-          staticRoutesUpdateQueue.getReader(),
-          routeUpdatesQueue));
+  // Start Decision Module. It only talks to other modules through queues,
+  // whose readers exist already, so it doesn't miss own adjacencies.
+  moduleStartup.addModule("Decision", {}, [&]() {
+    std::unique_ptr<RouteComputationEngine> routeEngine{nullptr};
+    if (auto engineName = config->getRouteEngine()) {
+      routeEngine = pluginCreateRouteComputationEngine(*engineName, config);
+      LOG_IF(WARNING, not routeEngine)
+          << "Route engine " << *engineName << " not supported by platform. "
+          << "Computing routes with SpfSolver.";
+    }
+    decision = startEventBase(
+        allThreads,
+        orderedEvbs,
+        watchdog,
+        *config,
+        "Decision",
+        std::make_unique<Decision>(
+            config,
+            FLAGS_enable_lfa,
+            not FLAGS_enable_bgp_route_programming,
+            std::chrono::milliseconds(FLAGS_decision_debounce_min_ms),
+            std::chrono::milliseconds(FLAGS_decision_debounce_max_ms),
+            std::move(decisionKvStoreUpdatesReader),
+            std::move(decisionStaticRoutesReader),
+            routeUpdatesQueue,
+            &linkStateUpdatesQueue,
+            std::move(routeEngine)));
+  });
 
   // Define and start Fib Module
-  auto fib = startEventBase(
-      allThreads,
-      orderedEvbs,
-      watchdog,
-      "Fib",
-      std::make_unique<Fib>(
-          config,
-          *config->getConfig().fib_port_ref(),
-          std::chrono::seconds(3 * *sparkConf.keepalive_time_s_ref()),
-          routeUpdatesQueue.getReader(),
-          interfaceUpdatesQueue.getReader(),
-          fibUpdatesQueue,
-          logSampleQueue,
-          kvStore));
+  moduleStartup.addModule("Fib", {"KvStore"}, [&]() {
+    fib = startEventBase(
+        allThreads,
+        orderedEvbs,
+        watchdog,
+        *config,
+        "Fib",
+        std::make_unique<Fib>(
+            config,
+            *config->getConfig().fib_port_ref(),
+            std::chrono::seconds(3 * *sparkConf.keepalive_time_s_ref()),
+            std::move(fibRouteUpdatesReader),
+            std::move(fibInterfaceUpdatesReader),
+            std::move(fibInterfaceStatusEventsReader),
+            fibUpdatesQueue,
+            logSampleQueue,
+            kvStore));
+  });
+
+  try {
+    moduleStartup.run(Constants::kModuleStartupThreads);
+  } catch (const std::exception& ex) {
+    LOG(FATAL) << "Failed to start OpenR modules: " << folly::exceptionStr(ex);
+  }
 
   // Start OpenrCtrl thrift server
   apache::thrift::ThriftServer thriftCtrlServer;
@@ -570,11 +748,26 @@ main(int argc, char** argv) {
         monitor,
         configStore,
         prefixManager,
-        spark,
+        sparkShards,
         config);
   });
 
   CHECK(ctrlHandler);
+
+  // Degrade modules under memory pressure before memory limit is hit
+  if (watchdog) {
+    watchdog->addMemoryPressureCallback(
+        [decision, fib, kvStore, handler = std::weak_ptr(ctrlHandler)](
+            MemoryPressure level) {
+          decision->setMemoryPressure(level);
+          fib->setMemoryPressure(level);
+          kvStore->setMemoryPressure(level);
+          if (auto ctrlHandler = handler.lock()) {
+            ctrlHandler->setMemoryPressure(level);
+          }
+        });
+  }
+
   thriftCtrlServer.setInterface(ctrlHandler);
   thriftCtrlServer.setNumIOWorkerThreads(1);
   // Intentionally kept this as (1). If you're changing to higher number please
@@ -584,9 +777,9 @@ main(int argc, char** argv) {
   thriftCtrlServer.setTosReflect(true);
 
   // serve
-  allThreads.emplace_back(std::thread([&thriftCtrlServer]() noexcept {
+  allThreads.emplace_back(std::thread([&thriftCtrlServer, &config]() noexcept {
     LOG(INFO) << "Starting thriftCtrlServer thread ...";
-    folly::setThreadName("thriftCtrlServer");
+    setupThread(*config, "thriftCtrlServer");
     thriftCtrlServer.serve();
     LOG(INFO) << "thriftCtrlServer thread got stopped.";
   }));
@@ -606,6 +799,7 @@ main(int argc, char** argv) {
   // Stop all threads (in reverse order of their creation)
   routeUpdatesQueue.close();
   interfaceUpdatesQueue.close();
+  interfaceStatusEventsQueue.close();
   peerUpdatesQueue.close();
   neighborUpdatesQueue.close();
   kvStoreSyncEventsQueue.close();
@@ -613,6 +807,7 @@ main(int argc, char** argv) {
   kvStoreUpdatesQueue.close();
   staticRoutesUpdateQueue.close();
   fibUpdatesQueue.close();
+  linkStateUpdatesQueue.close();
   netlinkEventsQueue.close();
   logSampleQueue.close();
 
@@ -8,6 +8,7 @@
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/Format.h>
 #include <folly/futures/Promise.h>
+#include <folly/hash/Hash.h>
 
 #include <openr/allocators/PrefixAllocator.h>
 #include <openr/common/Constants.h>
@@ -394,6 +395,16 @@ PrefixAllocator::getPrefixCount(
   return (1 << std::min(31, allocPrefixLen - seedPrefix.second));
 }
 
+uint32_t
+PrefixAllocator::getHashPrefixIndex(
+    const std::string& nodeName,
+    uint32_t startIndex,
+    uint32_t endIndex) noexcept {
+  CHECK_LE(startIndex, endIndex);
+  const uint64_t rangeSize = uint64_t(endIndex) - startIndex + 1;
+  return startIndex + folly::hash::fnv64(nodeName) % rangeSize;
+}
+
 std::optional<uint32_t>
 PrefixAllocator::loadPrefixIndexFromKvStore() {
   VLOG(4) << "See if I am already allocated a prefix in kvstore";
@@ -439,7 +450,7 @@ PrefixAllocator::savePrefixIndexToDisk(std::optional<uint32_t> prefixIndex) {
 }
 
 uint32_t
-PrefixAllocator::getInitPrefixIndex() {
+PrefixAllocator::getInitPrefixIndex(uint32_t startIndex, uint32_t endIndex) {
   // initialize my prefix per the following preferrence:
   // from file > from kvstore > generate new
 
@@ -458,16 +469,12 @@ PrefixAllocator::getInitPrefixIndex() {
     return kvstorePrefixIndex.value();
   }
 
-  // Generate a new random prefix index
-  if (allocParams_.has_value()) {
-    uint32_t hashPrefixIndex =
-        hasher(myNodeName_) % getPrefixCount(*allocParams_);
-    LOG(INFO) << "Generate new initial prefix index: " << hashPrefixIndex;
-    return hashPrefixIndex;
-  }
-
-  // `0` is always a valid index in valid range
-  return 0;
+  // Generate a new prefix index by hash of my name, RangeAllocator falls back
+  // to free ones on collision
+  const auto hashPrefixIndex =
+      getHashPrefixIndex(myNodeName_, startIndex, endIndex);
+  LOG(INFO) << "Generate new initial prefix index: " << hashPrefixIndex;
+  return hashPrefixIndex;
 }
 
 void
@@ -555,7 +562,8 @@ PrefixAllocator::startAllocation(
   }
 
   rangeAllocator_->startAllocator(
-      std::make_pair(startIndex, endIndex), getInitPrefixIndex());
+      std::make_pair(startIndex, endIndex),
+      getInitPrefixIndex(startIndex, endIndex));
 }
 
 void
@@ -600,28 +608,39 @@ PrefixAllocator::applyMyPrefixIndex(std::optional<uint32_t> prefixIndex) {
 
 void
 PrefixAllocator::applyMyPrefix() {
-  if (!applyState_.first) {
+  // state changed while programming is applied once programming completes
+  if (!applyState_.first or applyInProgress_) {
     return;
   }
-  try {
-    if (applyState_.second) {
-      updateMyPrefix(*applyState_.second);
-    } else {
-      withdrawMyPrefix();
-    }
-    applyState_.first = false;
-  } catch (const std::exception& ex) {
-    LOG(ERROR)
-        << "Apply prefix failed, will retry in "
-        << Constants::kPrefixAllocatorRetryInterval.count() << " ms address: "
-        << (applyState_.second.has_value()
-                ? folly::IPAddress::networkToString(applyState_.second.value())
-                : "none");
-    retryTimer_->scheduleTimeout(Constants::kPrefixAllocatorRetryInterval);
-  }
+  applyState_.first = false;
+  applyInProgress_ = true;
+
+  const auto prefix = applyState_.second;
+  folly::makeSemiFutureWith([&]() {
+    return prefix ? updateMyPrefix(*prefix) : withdrawMyPrefix();
+  })
+      .via(getEvb())
+      .thenTry([this, prefix](folly::Try<folly::Unit>&& result) {
+        applyInProgress_ = false;
+        if (result.hasException()) {
+          LOG(ERROR) << "Apply prefix failed, will retry in "
+                     << Constants::kPrefixAllocatorRetryInterval.count()
+                     << " ms address: "
+                     << (prefix.has_value()
+                             ? folly::IPAddress::networkToString(*prefix)
+                             : "none")
+                     << ". Error: " << folly::exceptionStr(result.exception());
+          // retry with latest state
+          applyState_.first = true;
+          retryTimer_->scheduleTimeout(
+              Constants::kPrefixAllocatorRetryInterval);
+          return;
+        }
+        applyMyPrefix();
+      });
 }
 
-void
+folly::SemiFuture<folly::Unit>
 PrefixAllocator::updateMyPrefix(folly::CIDRNetwork prefix) {
   CHECK(allocParams_.has_value()) << "Alloc parameters are not set.";
   // replace previously allocated prefix with newly allocated one in
@@ -647,85 +666,65 @@ PrefixAllocator::updateMyPrefix(folly::CIDRNetwork prefix) {
   *request.prefixes_ref() = {prefixEntry};
   prefixUpdatesQueue_.push(std::move(request));
 
-  // existing global prefixes
-  std::vector<folly::CIDRNetwork> oldPrefixes{};
-  try {
-    oldPrefixes =
-        semifuture_getIfAddrs(
-            loopbackIfaceName_, prefix.first.family(), RT_SCOPE_UNIVERSE)
-            .get();
-  } catch (const fbnl::NlException& ex) {
-    LOG(ERROR)
-        << "Failed to get iface addresses from NetlinkProtocolSocket. Error: "
-        << folly::exceptionStr(ex);
-    return;
-  }
-
-  // desired global prefixes
-  auto loopbackPrefix = createLoopbackPrefix(prefix);
-  std::vector<folly::CIDRNetwork> toSyncPrefixes{loopbackPrefix};
-
-  // get a list of prefixes need to be deleted
-  std::vector<folly::CIDRNetwork> toDeletePrefixes;
-  std::set_difference(
-      oldPrefixes.begin(),
-      oldPrefixes.end(),
-      toSyncPrefixes.begin(),
-      toSyncPrefixes.end(),
-      std::inserter(toDeletePrefixes, toDeletePrefixes.begin()));
-
-  if (toDeletePrefixes.empty() && !oldPrefixes.empty()) {
-    LOG(INFO) << "Prefix not changed";
-    return;
-  }
+  if (!setLoopbackAddress_) {
+    return folly::makeSemiFuture();
+  }
+
+  // existing global prefixes, fetched once for the whole sync
+  const auto ifIndex = getIfIndex(loopbackIfaceName_).value();
+  return semifuture_getIfAddrs(
+             loopbackIfaceName_, prefix.first.family(), RT_SCOPE_UNIVERSE)
+      .deferValue([this, prefix, ifIndex, seedPrefix = allocParams_->first](
+                      std::vector<folly::CIDRNetwork>&& oldPrefixes) {
+        // desired global prefixes
+        auto loopbackPrefix = createLoopbackPrefix(prefix);
+        std::vector<folly::CIDRNetwork> toSyncPrefixes{loopbackPrefix};
+
+        // get a list of prefixes need to be deleted
+        std::vector<folly::CIDRNetwork> toDeletePrefixes;
+        std::set_difference(
+            oldPrefixes.begin(),
+            oldPrefixes.end(),
+            toSyncPrefixes.begin(),
+            toSyncPrefixes.end(),
+            std::inserter(toDeletePrefixes, toDeletePrefixes.begin()));
+
+        if (toDeletePrefixes.empty() && !oldPrefixes.empty()) {
+          LOG(INFO) << "Prefix not changed";
+          return folly::makeSemiFuture();
+        }
 
-  // delete unwanted global prefixes
-  for (const auto& toDeletePrefix : toDeletePrefixes) {
-    bool needToDelete = false;
-    if (toDeletePrefix.first.inSubnet(
-            allocParams_->first.first, allocParams_->first.second)) {
-      // delete existing prefix in the subnet as seedPrefix
-      needToDelete = true;
-    } else if (overrideGlobalAddress_ and !toDeletePrefix.first.isLinkLocal()) {
-      // delete non-link-local addresses
-      needToDelete = true;
-    }
+        // keep global prefixes which are not ours to delete
+        for (const auto& toDeletePrefix : toDeletePrefixes) {
+          // delete existing prefix in the subnet as seedPrefix and, on
+          // override, non-link-local addresses
+          const bool needToDelete =
+              toDeletePrefix.first.inSubnet(
+                  seedPrefix.first, seedPrefix.second) or
+              (overrideGlobalAddress_ and !toDeletePrefix.first.isLinkLocal());
+          if (!needToDelete) {
+            toSyncPrefixes.emplace_back(toDeletePrefix);
+            continue;
+          }
 
-    if (!needToDelete or !setLoopbackAddress_) {
-      toSyncPrefixes.emplace_back(toDeletePrefix);
-      continue;
-    }
+          LOG(INFO) << "Will delete address "
+                    << folly::IPAddress::networkToString(toDeletePrefix)
+                    << " on interface " << loopbackIfaceName_;
+        }
 
-    LOG(INFO) << "Will delete address "
-              << folly::IPAddress::networkToString(toDeletePrefix)
-              << " on interface " << loopbackIfaceName_;
-  }
-
-  // Assign new address to loopback
-  if (setLoopbackAddress_) {
-    LOG(INFO) << "Assigning address: "
-              << folly::IPAddress::networkToString(loopbackPrefix)
-              << " on interface " << loopbackIfaceName_;
-    toSyncPrefixes.emplace_back(loopbackPrefix);
-
-    try {
-      semifuture_syncIfAddrs(
-          loopbackIfaceName_,
-          prefix.first.family(),
-          RT_SCOPE_UNIVERSE,
-          toSyncPrefixes)
-          .get();
-    } catch (const std::exception& ex) {
-      LOG(ERROR) << "Failed to sync iface addresses for interface: "
-                 << loopbackIfaceName_ << " from NetlinkProtocolSocket. Error: "
-                 << folly::exceptionStr(ex);
-      throw;
-    }
-  }
+        // Assign new address to loopback
+        LOG(INFO) << "Assigning address: "
+                  << folly::IPAddress::networkToString(loopbackPrefix)
+                  << " on interface " << loopbackIfaceName_;
+        return syncIfAddrs(
+            ifIndex, RT_SCOPE_UNIVERSE, oldPrefixes, toSyncPrefixes);
+      });
 }
 
-void
+folly::SemiFuture<folly::Unit>
 PrefixAllocator::withdrawMyPrefix() {
+  auto flushFuture = folly::makeSemiFuture();
+
   // Flush existing loopback addresses
   if (setLoopbackAddress_ and allocParams_.has_value()) {
     LOG(INFO) << "Flushing existing addresses from interface "
@@ -734,40 +733,22 @@ PrefixAllocator::withdrawMyPrefix() {
     const auto& prefix = allocParams_->first;
     if (overrideGlobalAddress_) {
       // provide empty addresses for address withdrawn
-      std::vector<folly::CIDRNetwork> networks{};
-      try {
-        semifuture_syncIfAddrs(
-            loopbackIfaceName_,
-            prefix.first.family(),
-            RT_SCOPE_UNIVERSE,
-            networks)
-            .get();
-      } catch (const std::exception& ex) {
-        LOG(ERROR) << "Failed to sync iface addresses for interface: "
-                   << loopbackIfaceName_
-                   << " from NetlinkProtocolSocket. Error: "
-                   << folly::exceptionStr(ex);
-        throw;
-      }
+      flushFuture = semifuture_syncIfAddrs(
+          loopbackIfaceName_, prefix.first.family(), RT_SCOPE_UNIVERSE, {});
     } else {
-      try {
-        // delele interface address
-        semifuture_addRemoveIfAddr(false, loopbackIfaceName_, {prefix}).get();
-      } catch (const fbnl::NlException& ex) {
-        LOG(ERROR) << "Failed to del iface address: "
-                   << folly::IPAddress::networkToString(prefix)
-                   << " from NetlinkProtocolSocket. Error: "
-                   << folly::exceptionStr(ex);
-        throw;
-      }
+      // delele interface address
+      flushFuture =
+          semifuture_addRemoveIfAddr(false, loopbackIfaceName_, {prefix});
     }
   }
 
-  // withdraw prefix via prefixMgrClient
-  thrift::PrefixUpdateRequest request;
-  request.cmd_ref() = thrift::PrefixUpdateCommand::WITHDRAW_PREFIXES_BY_TYPE;
-  request.type_ref() = openr::thrift::PrefixType::PREFIX_ALLOCATOR;
-  prefixUpdatesQueue_.push(std::move(request));
+  // withdraw prefix via prefixMgrClient once addresses are flushed
+  return std::move(flushFuture).deferValue([this](folly::Unit) {
+    thrift::PrefixUpdateRequest request;
+    request.cmd_ref() = thrift::PrefixUpdateCommand::WITHDRAW_PREFIXES_BY_TYPE;
+    request.type_ref() = openr::thrift::PrefixType::PREFIX_ALLOCATOR;
+    prefixUpdatesQueue_.push(std::move(request));
+  });
 }
 
 folly::SemiFuture<folly::Unit>
@@ -776,9 +757,7 @@ PrefixAllocator::semifuture_syncIfAddrs(
     int16_t family,
     int16_t scope,
     std::vector<folly::CIDRNetwork> newAddrs) {
-  std::vector<folly::SemiFuture<int>> futures;
-  const auto ifName = iface; // Copy intended
-  const auto ifIndex = getIfIndex(ifName).value();
+  const auto ifIndex = getIfIndex(iface).value();
 
   auto networks = folly::gen::from(newAddrs) |
       folly::gen::mapped([](const folly::CIDRNetwork& network) {
@@ -791,7 +770,20 @@ PrefixAllocator::semifuture_syncIfAddrs(
             << ", addresses=" << folly::join(",", networks);
 
   // fetch existing iface address as std::vector<folly::CIDRNetwork>
-  auto oldAddrs = semifuture_getIfAddrs(iface, family, scope).get();
+  return semifuture_getIfAddrs(iface, family, scope)
+      .deferValue([this, ifIndex, scope, newAddrs = std::move(newAddrs)](
+                      std::vector<folly::CIDRNetwork>&& oldAddrs) {
+        return syncIfAddrs(ifIndex, scope, oldAddrs, newAddrs);
+      });
+}
+
+folly::SemiFuture<folly::Unit>
+PrefixAllocator::syncIfAddrs(
+    int ifIndex,
+    int16_t scope,
+    const std::vector<folly::CIDRNetwork>& oldAddrs,
+    const std::vector<folly::CIDRNetwork>& newAddrs) {
+  std::vector<folly::SemiFuture<int>> futures;
 
   // Add new addresses
   for (auto& newAddr : newAddrs) {
@@ -64,6 +64,15 @@ class PrefixAllocator : public OpenrEventBase {
   static uint32_t getPrefixCount(
       PrefixAllocationParams const& allocParams) noexcept;
 
+  // Static function to get initial prefix index of a node within
+  // [startIndex, endIndex] by hash of its name. Hash is deterministic across
+  // processes and platforms, so that a node without prefix index on disk or
+  // in KvStore claims the same one every time it starts
+  static uint32_t getHashPrefixIndex(
+      const std::string& nodeName,
+      uint32_t startIndex,
+      uint32_t endIndex) noexcept;
+
   /*
    * [Netlink Platform] util functions to add/del iface address
    */
@@ -108,8 +117,8 @@ class PrefixAllocator : public OpenrEventBase {
   // save newly elected prefix index to disk
   void savePrefixIndexToDisk(std::optional<uint32_t> prefixIndex);
 
-  // initialize my prefix
-  uint32_t getInitPrefixIndex();
+  // initialize my prefix within [startIndex, endIndex]
+  uint32_t getInitPrefixIndex(uint32_t startIndex, uint32_t endIndex);
 
   // start allocating prefixes, can be called again with new prefix
   // or `std::nullopt` if seed prefix is no longer valid to withdraw
@@ -122,11 +131,19 @@ class PrefixAllocator : public OpenrEventBase {
   void applyMyPrefixIndex(std::optional<uint32_t> prefixIndex);
   void applyMyPrefix();
 
-  // update prefix
-  void updateMyPrefix(folly::CIDRNetwork prefix);
+  // update prefix, completes once loopback addresses are programmed
+  folly::SemiFuture<folly::Unit> updateMyPrefix(folly::CIDRNetwork prefix);
+
+  // withdraw prefix, completes once loopback addresses are flushed
+  folly::SemiFuture<folly::Unit> withdrawMyPrefix();
 
-  // withdraw prefix
-  void withdrawMyPrefix();
+  // add missing and remove stale addresses of iface in one batch of netlink
+  // requests
+  folly::SemiFuture<folly::Unit> syncIfAddrs(
+      int ifIndex,
+      int16_t scope,
+      const std::vector<folly::CIDRNetwork>& oldAddrs,
+      const std::vector<folly::CIDRNetwork>& newAddrs);
 
   void logPrefixEvent(
       std::string event,
@@ -152,9 +169,6 @@ class PrefixAllocator : public OpenrEventBase {
   // Sync interval for range allocator
   const std::chrono::milliseconds syncInterval_;
 
-  // hash node ID into prefix space
-  const std::hash<std::string> hasher{};
-
   //
   // Non-const private variables
   //
@@ -210,6 +224,10 @@ class PrefixAllocator : public OpenrEventBase {
    */
   std::pair<bool, std::optional<folly::CIDRNetwork>> applyState_;
 
+  // addresses are being programmed asynchronously. State changes meanwhile
+  // are coalesced, only the latest state is programmed once it completes
+  bool applyInProgress_{false};
+
   // save alloc index from e2e-network-alllocation <value version, indices set>
   std::pair<int64_t, std::unordered_set<uint32_t>> e2eAllocIndex_{-1, {}};
 };
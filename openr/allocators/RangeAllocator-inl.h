@@ -33,6 +33,13 @@ binaryToPrimitive(const std::string& s) {
   return t;
 }
 
+inline std::string
+getCounterPrefix(const std::string& keyPrefix, const std::string& area) {
+  folly::StringPiece name(keyPrefix);
+  name.removeSuffix(':');
+  return folly::sformat("range_allocator.{}.{}", name, area);
+}
+
 } // namespace details
 
 template <typename T>
@@ -56,9 +63,10 @@ RangeAllocator<T>::RangeAllocator(
       backoff_(minBackoffDur, maxBackoffDur),
       checkValueInUseCb_(std::move(checkValueInUseCb)),
       rangeAllocTtl_(rangeAllocTtl),
-      area_(area) {
-  timeout_ = folly::AsyncTimeout::make(
-      *eventBase_->getEvb(), [this]() mutable noexcept {
+      area_(area),
+      counterPrefix_(details::getCounterPrefix(keyPrefix, area)) {
+  timeout_ = WheelTimeout::make(
+      eventBase_->getWheelTimer(), [this]() mutable noexcept {
         CHECK(allocateValue_.has_value());
         auto allocateValue = allocateValue_.value();
         allocateValue_.reset();
@@ -77,6 +85,10 @@ RangeAllocator<T>::~RangeAllocator() {
       allocateValue_.reset();
     }
 
+    if (keyPrefixSubscription_) {
+      kvStoreClient_->unsubscribeKeyPrefix(*keyPrefixSubscription_);
+    }
+
     // Unsubscribe from KvStoreClientInternal if we have been to
     if (myValue_) {
       const auto myKey = createKey(*myValue_);
@@ -129,6 +141,118 @@ RangeAllocator<T>::startAllocator(
   timeout_->scheduleTimeout(backoff_.getTimeRemainingUntilRetry());
 }
 
+template <typename T>
+void
+RangeAllocator<T>::startAllocators(
+    const std::vector<RangeAllocator<T>*>& allocators,
+    const std::pair<T, T> allocRange) {
+  if (allocators.empty()) {
+    return;
+  }
+  CHECK_LE(allocRange.first, allocRange.second) << "Invalid range.";
+  const auto& first = *allocators.front();
+  CHECK(first.eventBase_->getEvb()->isInEventBaseThread());
+  for (auto* allocator : allocators) {
+    CHECK(not allocator->hasStarted_) << "Already started";
+    CHECK_EQ(first.kvStoreClient_, allocator->kvStoreClient_);
+    CHECK_EQ(first.keyPrefix_, allocator->keyPrefix_);
+    CHECK_EQ(first.area_, allocator->area_);
+    allocator->hasStarted_ = true;
+    allocator->allocRange_ = allocRange;
+    allocator->allocRangeSize_ = allocRange.second - allocRange.first + 1;
+  }
+  const T rangeSize = first.allocRangeSize_;
+
+  // Values claimed in KvStore, and values owned by allocators in the batch
+  const auto maybeKeyMap =
+      first.kvStoreClient_->dumpAllWithPrefix(first.keyPrefix_, first.area_);
+  CHECK(maybeKeyMap.has_value())
+      << "Failed to dump keys with prefix: " << first.keyPrefix_
+      << " from kvstore in area: " << first.area_;
+  std::vector<bool> claimed(rangeSize, false);
+  std::unordered_map<std::string /* owner */, thrift::Value> ownedValues;
+  for (const auto& [_, thriftVal] : *maybeKeyMap) {
+    const auto val =
+        details::binaryToPrimitive<T>(thriftVal.value_ref().value());
+    if (val >= allocRange.first and val <= allocRange.second) {
+      claimed[val - allocRange.first] = true;
+      ownedValues.emplace(*thriftVal.originatorId_ref(), thriftVal);
+    }
+  }
+
+  std::unordered_map<std::string, thrift::Value> keyVals;
+  std::vector<RangeAllocator<T>*> pendingAllocators;
+  std::vector<RangeAllocator<T>*> ownerAllocators;
+  for (auto* allocator : allocators) {
+    // We own a value already, e.g. node rebooted w/ kvstore intact. Bump ttl
+    // version and reset ttl so that ttl is published regularly
+    auto ownedIt = ownedValues.find(allocator->nodeName_);
+    if (ownedIt != ownedValues.end()) {
+      auto newValue = ownedIt->second;
+      const auto val =
+          details::binaryToPrimitive<T>(newValue.value_ref().value());
+      *newValue.ttlVersion_ref() += 1;
+      *newValue.ttl_ref() = allocator->rangeAllocTtl_.count();
+      keyVals.emplace(allocator->createKey(val), std::move(newValue));
+      allocator->myValue_ = val;
+      ownerAllocators.emplace_back(allocator);
+      continue;
+    }
+
+    // Pick first free value from random position in range
+    const T start = folly::Random::rand64(rangeSize);
+    std::optional<T> newVal;
+    for (T i = 0; i < rangeSize; ++i) {
+      const T index = (start + i) % rangeSize;
+      const T val = allocRange.first + index;
+      if (claimed[index] or
+          (allocator->checkValueInUseCb_ and
+           allocator->checkValueInUseCb_(val))) {
+        continue;
+      }
+      claimed[index] = true;
+      newVal = val;
+      break;
+    }
+    if (not newVal.has_value()) {
+      LOG(ERROR) << "RangeAllocator " << allocator->nodeName_
+                 << ": no free value left in batch, electing one by one";
+      allocator->scheduleAllocate(allocRange.first + start);
+      continue;
+    }
+
+    VLOG(1) << "RangeAllocator " << allocator->nodeName_
+            << ": trying to allocate " << *newVal << " in batch";
+    allocator->myRequestedValue_ = *newVal;
+    keyVals.emplace(
+        allocator->createKey(*newVal),
+        thrift::Value(
+            apache::thrift::FRAGILE,
+            1 /* version */,
+            allocator->nodeName_ /* originatorId */,
+            details::primitiveToBinary(*newVal) /* value */,
+            allocator->rangeAllocTtl_.count() /* ttl */,
+            0 /* ttl version */,
+            0 /* hash */));
+    pendingAllocators.emplace_back(allocator);
+  }
+
+  // Claim all values in one publication
+  const auto ret =
+      first.kvStoreClient_->setKeys(std::move(keyVals), first.area_);
+  CHECK(ret.has_value());
+
+  // Outcome of elections is learnt from key updates as for single allocations
+  for (auto* allocator : pendingAllocators) {
+    allocator->subscribeValueKey(
+        allocator->createKey(*allocator->myRequestedValue_));
+  }
+  for (auto* allocator : ownerAllocators) {
+    allocator->callback_(allocator->myValue_);
+    allocator->subscribeValueKey(allocator->createKey(*allocator->myValue_));
+  }
+}
+
 template <typename T>
 bool
 RangeAllocator<T>::isRangeConsumed() const {
@@ -244,8 +368,14 @@ RangeAllocator<T>::tryAllocate(const T newVal) noexcept {
   }
 
   // Subscribe to updates of this newKey
+  subscribeValueKey(newKey);
+}
+
+template <typename T>
+void
+RangeAllocator<T>::subscribeValueKey(const std::string& key) noexcept {
   kvStoreClient_->subscribeKey(
-      newKey,
+      key,
       [this](
           const std::string& key,
           std::optional<thrift::Value> thriftVal) noexcept {
@@ -268,36 +398,51 @@ RangeAllocator<T>::scheduleAllocate(const T seedVal) noexcept {
   std::uniform_int_distribution<T> dist(allocRange_.first, allocRange_.second);
   auto newVal = dist(gen);
 
-  const auto maybeKeyMap = kvStoreClient_->dumpAllWithPrefix(keyPrefix_, area_);
-  CHECK(maybeKeyMap.has_value())
-      << "Failed to dump keys with prefix: " << keyPrefix_
-      << " from kvstore in area: " << area_;
-  const auto valOwners =
-      folly::gen::from(*maybeKeyMap) |
-      folly::gen::map([](std::pair<std::string, thrift::Value> const& kv) {
-        return std::make_pair(
-            details::binaryToPrimitive<T>(kv.second.value_ref().value()),
-            *kv.second.originatorId_ref());
-      }) |
-      folly::gen::as<
-          std::unordered_map<T /* value */, std::string /* owner */>>();
-
-  // look for a value I can own
+  // look for a value not claimed yet, next to random one
+  trackClaimedValues();
   T i;
   for (i = 0; i < allocRangeSize_; ++i) {
-    const auto it = valOwners.find(newVal);
-    // not owned yet or owned by higher originator if override is allowed
-    if (it == valOwners.end() or (overrideOwner_ and nodeName_ >= it->second)) {
-      if (!checkValueInUseCb_ or !checkValueInUseCb_(newVal)) {
-        // found
-        break;
-      }
+    if (not claimedValues_[newVal - allocRange_.first] and
+        (!checkValueInUseCb_ or !checkValueInUseCb_(newVal))) {
+      break;
     }
-    // try next
     newVal = (newVal < allocRange_.second) ? (newVal + 1) : allocRange_.first;
   }
+
+  // all values claimed, look for a value I can own
   if (i == allocRangeSize_) {
-    LOG(ERROR) << "All values are owned by higher originatorIds";
+    const auto maybeKeyMap =
+        kvStoreClient_->dumpAllWithPrefix(keyPrefix_, area_);
+    CHECK(maybeKeyMap.has_value())
+        << "Failed to dump keys with prefix: " << keyPrefix_
+        << " from kvstore in area: " << area_;
+    const auto valOwners =
+        folly::gen::from(*maybeKeyMap) |
+        folly::gen::map([](std::pair<std::string, thrift::Value> const& kv) {
+          return std::make_pair(
+              details::binaryToPrimitive<T>(kv.second.value_ref().value()),
+              *kv.second.originatorId_ref());
+        }) |
+        folly::gen::as<
+            std::unordered_map<T /* value */, std::string /* owner */>>();
+
+    for (i = 0; i < allocRangeSize_; ++i) {
+      const auto it = valOwners.find(newVal);
+      // not owned yet or owned by higher originator if override is allowed
+      if (it == valOwners.end() or
+          (overrideOwner_ and nodeName_ >= it->second)) {
+        if (!checkValueInUseCb_ or !checkValueInUseCb_(newVal)) {
+          // found
+          break;
+        }
+      }
+      // try next
+      newVal =
+          (newVal < allocRange_.second) ? (newVal + 1) : allocRange_.first;
+    }
+    if (i == allocRangeSize_) {
+      LOG(ERROR) << "All values are owned by higher originatorIds";
+    }
   }
 
   // Schedule timeout to allocate new value
@@ -305,6 +450,71 @@ RangeAllocator<T>::scheduleAllocate(const T seedVal) noexcept {
   timeout_->scheduleTimeout(backoff_.getTimeRemainingUntilRetry());
 }
 
+template <typename T>
+void
+RangeAllocator<T>::trackClaimedValues() noexcept {
+  if (keyPrefixSubscription_) {
+    return;
+  }
+
+  claimedValues_.assign(allocRangeSize_, false);
+  numClaimedValues_ = 0;
+  keyPrefixSubscription_ = kvStoreClient_->subscribeKeyPrefix(
+      keyPrefix_,
+      [this](
+          const std::string& key,
+          std::optional<thrift::Value> thriftVal) noexcept {
+        claimedValueUpdated(key, thriftVal);
+      },
+      area_);
+
+  const auto maybeKeyMap = kvStoreClient_->dumpAllWithPrefix(keyPrefix_, area_);
+  CHECK(maybeKeyMap.has_value())
+      << "Failed to dump keys with prefix: " << keyPrefix_
+      << " from kvstore in area: " << area_;
+  for (const auto& [key, thriftVal] : *maybeKeyMap) {
+    claimedValueUpdated(key, thriftVal);
+  }
+}
+
+template <typename T>
+void
+RangeAllocator<T>::claimedValueUpdated(
+    const std::string& key,
+    const std::optional<thrift::Value>& thriftVal) noexcept {
+  // value of expired key is known from key only
+  std::optional<T> val;
+  if (thriftVal.has_value()) {
+    val = details::binaryToPrimitive<T>(thriftVal->value_ref().value());
+  } else if (auto maybeVal = folly::tryTo<T>(
+                 folly::StringPiece(key).subpiece(keyPrefix_.size()));
+             maybeVal.hasValue()) {
+    val = *maybeVal;
+  }
+  if (not val.has_value() or *val < allocRange_.first or
+      *val > allocRange_.second) {
+    return;
+  }
+
+  const bool claimed = thriftVal.has_value();
+  const auto index = *val - allocRange_.first;
+  if (claimedValues_[index] == claimed) {
+    return;
+  }
+  claimedValues_[index] = claimed;
+  if (claimed) {
+    ++numClaimedValues_;
+  } else {
+    --numClaimedValues_;
+  }
+
+  facebook::fb303::fbData->setCounter(
+      counterPrefix_ + ".claimed_values", numClaimedValues_);
+  facebook::fb303::fbData->setCounter(
+      counterPrefix_ + ".utilization_pct",
+      static_cast<int64_t>(numClaimedValues_) * 100 / allocRangeSize_);
+}
+
 template <typename T>
 void
 RangeAllocator<T>::keyValUpdated(
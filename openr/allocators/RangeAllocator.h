@@ -10,8 +10,11 @@
 #include <chrono>
 #include <random>
 #include <string>
+#include <vector>
 
+#include <fb303/ServiceData.h>
 #include <fbzmq/async/ZmqTimeout.h>
+#include <folly/Conv.h>
 #include <folly/Format.h>
 #include <folly/Optional.h>
 #include <folly/Random.h>
@@ -19,6 +22,7 @@
 
 #include <openr/common/ExponentialBackoff.h>
 #include <openr/common/OpenrEventBase.h>
+#include <openr/common/WheelTimeout.h>
 #include <openr/if/gen-cpp2/KvStore_constants.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
 #include <openr/kvstore/KvStoreClientInternal.h>
@@ -36,7 +40,8 @@ class RangeAllocator {
    * bus.
    *
    * Idea:
-   * - Generate a random value to be claimed
+   * - Generate a random value to be claimed, out of values not claimed yet
+   *   per bitmap of claimed values kept up to date from KvStore
    * - Try electing it via KvStore. Higher originatorId wins.
    * - If we fail we should try again with another random number
    * - To ease up re-tries we use ExponentialBackoff
@@ -70,6 +75,23 @@ class RangeAllocator {
       const std::pair<T /* min */, T /* max */> allocRange,
       const std::optional<T> maybeInitValue);
 
+  /**
+   * Batched alternative to startAllocator for many allocators, e.g. ones
+   * allocating on behalf of all nodes of a fresh pod. Rather than each one
+   * electing random values with a flood round-trip and backoff per collision,
+   * values claimed in KvStore are read with a single dump, each allocator
+   * picks a distinct value from those left free (tracked in a bitmap of the
+   * range) and all picks are claimed in a single publication. Allocators
+   * which already own a value keep it. Allocators losing their pick, or left
+   * without a free value, go on electing values one by one.
+   *
+   * Allocators must share KvStoreClientInternal, key prefix and area. Must be
+   * called from the event base of the KvStoreClientInternal.
+   */
+  static void startAllocators(
+      const std::vector<RangeAllocator<T>*>& allocators,
+      const std::pair<T /* min */, T /* max */> allocRange);
+
   /**
    * Default destructor.
    */
@@ -89,6 +111,15 @@ class RangeAllocator {
   // check if the whole range has been allocated
   bool isRangeConsumed() const;
 
+  // Number of values in range claimed in KvStore, as tracked once allocator
+  // had to retry. Exported as counter
+  // `range_allocator.<key prefix>.<area>.claimed_values` along with
+  // `range_allocator.<key prefix>.<area>.utilization_pct`
+  T
+  getNumClaimedValues() const {
+    return numClaimedValues_;
+  }
+
  private:
   /**
    * Non-copyable and non-movable
@@ -105,12 +136,30 @@ class RangeAllocator {
    */
   void tryAllocate(const T newVal) noexcept;
 
+  /**
+   * Subscribe to updates of key of requested or allocated value
+   */
+  void subscribeValueKey(const std::string& key) noexcept;
+
   /**
    * Schedule allocation of a new value. A new random value will be chosen
    * based on the seed value.
    */
   void scheduleAllocate(const T seedVal) noexcept;
 
+  /**
+   * Start tracking values claimed in KvStore if not yet, with initial dump
+   * and subscription to updates of keys with our prefix.
+   */
+  void trackClaimedValues() noexcept;
+
+  /**
+   * Update claimed values on update or expiry of key.
+   */
+  void claimedValueUpdated(
+      const std::string& key,
+      const std::optional<thrift::Value>& thriftVal) noexcept;
+
   /* Invoked whenever there is an update for our currently allocated value
    */
   void keyValUpdated(
@@ -166,7 +215,7 @@ class RangeAllocator {
 
   // Scheduled timeout token
   std::optional<int64_t> allocateValue_{std::nullopt};
-  std::unique_ptr<folly::AsyncTimeout> timeout_;
+  std::unique_ptr<WheelTimeout> timeout_;
 
   // if allocator has started
   bool hasStarted_{false};
@@ -179,6 +228,17 @@ class RangeAllocator {
 
   // area ID
   const std::string area_{};
+
+  // Bitmap of values in range claimed in KvStore by any node, so that new
+  // values are picked among free ones and don't collide as range fills up
+  std::vector<bool> claimedValues_;
+  T numClaimedValues_{0};
+
+  // subscription to keys with our prefix, set when tracking claimed values
+  std::optional<int64_t> keyPrefixSubscription_;
+
+  // counter prefix for claimed values
+  const std::string counterPrefix_;
 };
 
 } // namespace openr
@@ -0,0 +1,157 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/init/Init.h>
+
+#include <openr/allocators/PrefixAllocator.h>
+#include <openr/tests/BenchmarkDriver.h>
+
+/**
+ * Defines a benchmark that allows users to record customized counter during
+ * benchmarking and passes a parameter to another one. This is common for
+ * benchmarks that need a "problem size" in addition to "number of iterations".
+ */
+#define BENCHMARK_COUNTERS_PARAM(name, counters, param) \
+  BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param, param)
+
+/*
+ * Like BENCHMARK_COUNTERS_PARAM(), but allows a custom name to be specified for
+ * each parameter, rather than using the parameter value.
+ */
+#define BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param_name, ...) \
+  BENCHMARK_IMPL_COUNTERS(                                             \
+      FB_CONCATENATE(name, FB_CONCATENATE(_, param_name)),             \
+      FOLLY_PP_STRINGIZE(name) "(" FOLLY_PP_STRINGIZE(param_name) ")", \
+      counters,                                                        \
+      iters,                                                           \
+      unsigned,                                                        \
+      iters) {                                                         \
+    name(counters, iters, ##__VA_ARGS__);                              \
+  }
+
+namespace openr {
+
+namespace {
+
+/**
+ * Simulate prefix elections of numNodes fresh nodes over prefixCount
+ * indices, in rounds of one KvStore flood each:
+ * - nodes without prefix claim their candidate, initially the index hashed
+ *   from their name
+ * - highest node name wins among claims of an index, like RangeAllocator
+ * - losers pick the free index next to a random one, as per claimed values
+ *   seen at the end of the round
+ *
+ * Returns number of rounds to converge, and number of lost claims
+ */
+std::pair<uint32_t, uint32_t>
+simulateElections(
+    const std::vector<std::string>& nodeNames, uint32_t prefixCount) {
+  const uint32_t numNodes = nodeNames.size();
+  std::vector<uint32_t> candidates(numNodes);
+  for (uint32_t i = 0; i < numNodes; ++i) {
+    candidates[i] =
+        PrefixAllocator::getHashPrefixIndex(nodeNames[i], 0, prefixCount - 1);
+  }
+
+  std::vector<bool> claimed(prefixCount, false);
+  std::vector<uint32_t> pending(numNodes);
+  std::iota(pending.begin(), pending.end(), 0);
+  uint32_t rounds{0};
+  uint32_t collisions{0};
+  while (not pending.empty()) {
+    ++rounds;
+
+    // winner of each claimed index in this round
+    std::unordered_map<uint32_t /* index */, uint32_t /* node */> winners;
+    for (const auto node : pending) {
+      auto [it, inserted] = winners.emplace(candidates[node], node);
+      if (not inserted and nodeNames[node] > nodeNames[it->second]) {
+        it->second = node;
+      }
+    }
+    for (const auto& [index, _] : winners) {
+      claimed[index] = true;
+    }
+
+    std::vector<uint32_t> losers;
+    for (const auto node : pending) {
+      if (winners.at(candidates[node]) == node) {
+        continue;
+      }
+      ++collisions;
+      uint32_t index = folly::Random::rand32(prefixCount);
+      for (uint32_t i = 0; i < prefixCount and claimed[index]; ++i) {
+        index = (index + 1) % prefixCount;
+      }
+      CHECK(not claimed[index]) << "Prefix range exhausted";
+      candidates[node] = index;
+      losers.emplace_back(node);
+    }
+    pending = std::move(losers);
+  }
+  return {rounds, collisions};
+}
+
+} // namespace
+
+/**
+ * Benchmark convergence of prefix allocation of numNodes fresh nodes over
+ * 2^prefixBits prefixes, e.g. a Terragraph-style mesh allocating /64s out of
+ * a /48. Reports flood rounds and lost claims, the time it takes in a real
+ * network being dominated by flooding.
+ */
+static void
+BM_PrefixAllocatorConvergence(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numNodes,
+    uint32_t prefixBits) {
+  auto suspender = folly::BenchmarkSuspender();
+  std::vector<std::string> nodeNames;
+  for (uint32_t i = 0; i < numNodes; ++i) {
+    nodeNames.emplace_back(folly::sformat("node-{}", i));
+  }
+
+  uint32_t rounds{0};
+  uint32_t collisions{0};
+  for (uint32_t i = 0; i < iters; ++i) {
+    suspender.dismiss(); // Start measuring benchmark time
+    const auto result = simulateElections(nodeNames, 1 << prefixBits);
+    suspender.rehire(); // Stop measuring time again
+    rounds = std::max(rounds, result.first);
+    collisions = std::max(collisions, result.second);
+  }
+  counters["rounds"] = rounds;
+  counters["collisions"] = collisions;
+}
+
+// The parameters are the number of nodes and of prefix bits
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixAllocatorConvergence, counters, 1000_12, 1000, 12);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixAllocatorConvergence, counters, 1000_16, 1000, 16);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixAllocatorConvergence, counters, 10000_14, 10000, 14);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixAllocatorConvergence, counters, 10000_16, 10000, 16);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  return openr::runBenchmarks();
+}
@@ -6,6 +6,7 @@
  */
 
 #include <atomic>
+#include <unordered_set>
 
 #include <fbzmq/zmq/Common.h>
 #include <folly/init/Init.h>
@@ -185,7 +186,7 @@ class PrefixAllocatorFixture : public ::testing::Test {
 
   // Queue for publishing prefix-updates to PrefixManager
   messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue_;
-  messaging::ReplicateQueue<DecisionRouteUpdate> routeUpdatesQueue_;
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue_;
 
   // Queue for event logs
   messaging::ReplicateQueue<LogSample> logSampleQueue_;
@@ -271,7 +272,7 @@ TEST_P(PrefixAllocTest, UniquePrefixes) {
     std::vector<std::unique_ptr<PrefixManager>> prefixManagers;
     std::vector<messaging::ReplicateQueue<thrift::PrefixUpdateRequest>>
         prefixQueues{numAllocators};
-    std::vector<messaging::ReplicateQueue<DecisionRouteUpdate>> routeQueues{
+    std::vector<messaging::ReplicateQueue<DecisionRouteUpdatePtr>> routeQueues{
         numAllocators};
     messaging::ReplicateQueue<LogSample> logSampleQueue;
     std::vector<std::unique_ptr<PrefixAllocator>> allocators;
@@ -1179,6 +1180,24 @@ TEST(PrefixAllocator, getPrefixCount) {
   }
 }
 
+TEST(PrefixAllocator, getHashPrefixIndex) {
+  // same index for same node name, within range
+  std::unordered_set<uint32_t> indices;
+  for (int i = 0; i < 1000; ++i) {
+    const auto nodeName = folly::sformat("node-{}", i);
+    const auto index = PrefixAllocator::getHashPrefixIndex(nodeName, 1, 65534);
+    EXPECT_EQ(index, PrefixAllocator::getHashPrefixIndex(nodeName, 1, 65534));
+    EXPECT_GE(index, 1);
+    EXPECT_LE(index, 65534);
+    indices.emplace(index);
+  }
+  // spread over range, collisions are rare
+  EXPECT_GT(indices.size(), 980);
+
+  // range of single index
+  EXPECT_EQ(7, PrefixAllocator::getHashPrefixIndex("node", 7, 7));
+}
+
 TEST(PrefixAllocator, parseParamsStr) {
   // Missing subnet specification in seed-prefix
   { EXPECT_ANY_THROW(auto p = PrefixAllocator::parseParamsStr("face::,64")); }
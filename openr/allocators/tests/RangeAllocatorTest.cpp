@@ -409,6 +409,145 @@ TEST_P(RangeAllocatorFixture, InsufficentRange) {
   }
 }
 
+/**
+ * Run all allocators on a single KvStoreClientInternal in batched mode. Each
+ * allocator must get a distinct value out of those left free without fights,
+ * while an allocator owning a value already keeps it.
+ */
+TEST_P(RangeAllocatorFixture, BatchedAllocation) {
+  using namespace std::chrono_literals;
+  const uint32_t start = 61;
+  // room for all allocators besides the two values claimed beforehand
+  const uint32_t end = start + kNumClients;
+  for (const auto& [val, owner] : std::vector<std::pair<uint32_t, std::string>>{
+           {start, createClientName(0)}, {start + 1, "other"}}) {
+    stores[0]->setKey(
+        folly::sformat("value:{}", val),
+        createThriftValue(
+            1 /* version */,
+            owner /* originatorId */,
+            details::primitiveToBinary(val)));
+  }
+
+  folly::Baton waitBaton;
+  std::map<int /* client id */, uint32_t /* allocated value */> allocation;
+  std::vector<std::unique_ptr<RangeAllocator<uint32_t>>> allocators;
+  for (size_t i = 0; i < kNumClients; i++) {
+    allocators.emplace_back(std::make_unique<RangeAllocator<uint32_t>>(
+        createClientName(i),
+        "value:",
+        clients[0].get(),
+        [&, i](std::optional<uint32_t> newVal) noexcept {
+          // picks never collide, hence no value is ever lost
+          ASSERT_TRUE(newVal.has_value());
+          if (i == 0) {
+            EXPECT_EQ(start, *newVal);
+          } else {
+            EXPECT_GE(*newVal, start + 2);
+            EXPECT_LE(*newVal, end);
+          }
+          EXPECT_TRUE(allocation.emplace(i, *newVal).second);
+          if (allocation.size() == kNumClients) {
+            waitBaton.post();
+          }
+        },
+        10ms /* min backoff */,
+        100ms /* max backoff */,
+        overrideOwner));
+  }
+
+  evbThread = std::thread([&]() { evb.run(); });
+  evb.waitUntilRunning();
+
+  evb.getEvb()->runInEventBaseThreadAndWait([&]() {
+    std::vector<RangeAllocator<uint32_t>*> batch;
+    for (auto& allocator : allocators) {
+      batch.emplace_back(allocator.get());
+    }
+    RangeAllocator<uint32_t>::startAllocators(batch, {start, end});
+  });
+
+  waitBaton.wait();
+
+  const auto allocatedVals = from(allocation) |
+      map([](std::pair<int, uint32_t> const& kv) { return kv.second; }) |
+      as<std::set<uint32_t>>();
+  EXPECT_EQ(kNumClients, allocatedVals.size());
+  evb.getEvb()->runInEventBaseThreadAndWait([&]() {
+    EXPECT_TRUE(allocators.front()->isRangeConsumed());
+    for (size_t i = 0; i < allocators.size(); ++i) {
+      EXPECT_EQ(allocation.at(i), allocators[i]->getValue());
+    }
+  });
+
+  for (auto& allocator : allocators) {
+    allocator.reset();
+  }
+}
+
+/**
+ * Run an allocator in an almost fully claimed range. It must pick the only
+ * free value as per claimed values tracked from KvStore.
+ */
+TEST_P(RangeAllocatorFixture, AlmostFullRange) {
+  using namespace std::chrono_literals;
+  const uint32_t start = 61;
+  const uint32_t rangeSize = 100;
+  const uint32_t end = start + rangeSize - 1;
+  const uint32_t freeVal = start + 37;
+  std::vector<std::pair<std::string, thrift::Value>> keyVals;
+  for (uint32_t val = start; val <= end; ++val) {
+    if (val == freeVal) {
+      continue;
+    }
+    // owner with higher originatorId and finite ttl, never overridden
+    keyVals.emplace_back(
+        folly::sformat("value:{}", val),
+        createThriftValue(
+            1 /* version */,
+            "zzz" /* originatorId */,
+            details::primitiveToBinary(val),
+            Constants::kRangeAllocTtl.count()));
+  }
+  stores[0]->setKeys(keyVals);
+
+  folly::Baton waitBaton;
+  auto allocator = std::make_unique<RangeAllocator<uint32_t>>(
+      createClientName(0),
+      "value:",
+      clients[0].get(),
+      [&](std::optional<uint32_t> newVal) noexcept {
+        ASSERT_TRUE(newVal.has_value());
+        EXPECT_EQ(freeVal, *newVal);
+        waitBaton.post();
+      },
+      10ms /* min backoff */,
+      100ms /* max backoff */,
+      overrideOwner);
+  // start with a claimed value
+  allocator->startAllocator({start, end}, start);
+
+  evbThread = std::thread([&]() { evb.run(); });
+  evb.waitUntilRunning();
+
+  waitBaton.wait();
+
+  // all values claimed once ours is echoed back
+  while (true) {
+    uint32_t numClaimedValues{0};
+    evb.getEvb()->runInEventBaseThreadAndWait(
+        [&]() { numClaimedValues = allocator->getNumClaimedValues(); });
+    if (numClaimedValues == rangeSize) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+  evb.getEvb()->runInEventBaseThreadAndWait(
+      [&]() { EXPECT_TRUE(allocator->isRangeConsumed()); });
+
+  allocator.reset();
+}
+
 } // namespace openr
 
 int
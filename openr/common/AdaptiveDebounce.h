@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+#include <glog/logging.h>
+
+namespace openr {
+
+/**
+ * Debounce whose wait adapts to the load instead of backing off
+ * exponentially on every invocation like AsyncDebounce.
+ *
+ * The first invocation after a quiet period, i.e. no invocation for
+ * maxBackOff, is run after minBackOff. While invocations keep arriving, the
+ * wait is the larger of the smoothed interval between invocations and the
+ * duration of the last callback, bounded by [minBackOff, maxBackOff]. Hence a
+ * single event is handled with minimal latency, while a storm of events is
+ * batched and an expensive callback is not run back to back.
+ *
+ * Invocations while the callback is scheduled are batched into it.
+ */
+template <typename Duration>
+class AdaptiveDebounce final : private folly::AsyncTimeout {
+ public:
+  using TimeoutCallback = folly::Function<void(void)>;
+
+  AdaptiveDebounce(
+      folly::EventBase* eventBase,
+      Duration minBackOff,
+      Duration maxBackOff,
+      TimeoutCallback callback)
+      : AsyncTimeout(eventBase), callback_(std::move(callback)) {
+    setBackoff(minBackOff, maxBackOff);
+  }
+
+  ~AdaptiveDebounce() override = default;
+
+  /**
+   * Change bounds of the wait. Takes effect from the next scheduled callback.
+   */
+  void
+  setBackoff(Duration minBackOff, Duration maxBackOff) {
+    CHECK_GT(minBackOff.count(), 0) << "Backoff must be positive value";
+    CHECK_LE(minBackOff.count(), maxBackOff.count());
+    minBackOff_ = minBackOff;
+    maxBackOff_ = maxBackOff;
+  }
+
+  /**
+   * Overload function operator. This method exposes debounced version of
+   * callback passed in.
+   */
+  void
+  operator()() noexcept {
+    reportEvent(std::chrono::steady_clock::now());
+  }
+
+  /**
+   * Same as operator() with the arrival time of the event passed in. Exposed
+   * for testing.
+   */
+  void
+  reportEvent(std::chrono::steady_clock::time_point now) noexcept {
+    if (lastEventTime_ and now - *lastEventTime_ < maxBackOff_) {
+      const auto interval =
+          std::chrono::duration_cast<Duration>(now - *lastEventTime_);
+      // exponentially weighted with the same weight for the latest interval
+      // and the history, reset by a quiet period
+      arrivalInterval_ = arrivalInterval_
+          ? (*arrivalInterval_ + interval) / 2
+          : interval;
+    } else {
+      arrivalInterval_ = std::nullopt;
+    }
+    lastEventTime_ = now;
+
+    if (isScheduled()) {
+      return;
+    }
+    lastWait_ = minBackOff_;
+    if (arrivalInterval_) {
+      lastWait_ = std::clamp(
+          std::max(*arrivalInterval_, callbackDuration_),
+          minBackOff_,
+          maxBackOff_);
+    }
+    scheduleTimeout(lastWait_);
+  }
+
+  /**
+   * Report how long the work triggered by the callback took. Callbacks
+   * offloading work should report once it is done.
+   */
+  void
+  reportCallbackDuration(Duration duration) {
+    callbackDuration_ = duration;
+  }
+
+  // wait chosen for the scheduled, or last run, callback
+  Duration
+  getLastWait() const {
+    return lastWait_;
+  }
+
+  // smoothed interval between invocations, maxBackOff if quiet
+  Duration
+  getArrivalInterval() const {
+    return arrivalInterval_.value_or(maxBackOff_);
+  }
+
+  Duration
+  getCallbackDuration() const {
+    return callbackDuration_;
+  }
+
+ private:
+  void
+  timeoutExpired() noexcept override {
+    callback_();
+  }
+
+  Duration minBackOff_;
+  Duration maxBackOff_;
+  TimeoutCallback callback_{nullptr};
+
+  std::optional<std::chrono::steady_clock::time_point> lastEventTime_;
+  // unset in a quiet period
+  std::optional<Duration> arrivalInterval_;
+  Duration callbackDuration_{0};
+  Duration lastWait_{0};
+};
+
+} // namespace openr
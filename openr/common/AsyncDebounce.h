@@ -39,6 +39,15 @@ class AsyncDebounce final : private folly::AsyncTimeout {
 
   ~AsyncDebounce() override = default;
 
+  /**
+   * Change bounds of the backoff. Takes effect from the next invocation, a
+   * scheduled callback keeps its timeout.
+   */
+  void
+  setBackoff(Duration minBackOff, Duration maxBackOff) {
+    backoff_ = ExponentialBackoff<Duration>(minBackOff, maxBackOff);
+  }
+
   /**
    * Overload function operator. This method exposes debounced version of
    * callback passed in.
@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/common/CompactRouteDelta.h>
+
+#include <stdexcept>
+
+#include <folly/Format.h>
+
+namespace openr {
+
+CompactRouteDeltaEncoder::CompactRouteDeltaEncoder(size_t maxNextHopGroups)
+    : maxNextHopGroups_(maxNextHopGroups) {}
+
+thrift::CompactRouteDatabaseDelta
+CompactRouteDeltaEncoder::encode(const thrift::RouteDatabaseDelta& delta) {
+  thrift::CompactRouteDatabaseDelta compactDelta;
+  if (groupIds_.size() > maxNextHopGroups_) {
+    groupIds_.clear();
+    *compactDelta.resetNextHopGroups_ref() = true;
+  }
+
+  for (auto const& route : *delta.unicastRoutesToUpdate_ref()) {
+    thrift::CompactUnicastRoute compactRoute;
+    *compactRoute.dest_ref() = route.dest;
+    *compactRoute.nextHopGroupId_ref() =
+        getGroupId(*route.nextHops_ref(), compactDelta);
+    compactRoute.adminDistance_ref().from_optional(
+        route.adminDistance_ref().to_optional());
+    compactRoute.prefixType_ref().from_optional(
+        route.prefixType_ref().to_optional());
+    compactRoute.data_ref().from_optional(route.data_ref().to_optional());
+    *compactRoute.doNotInstall_ref() = *route.doNotInstall_ref();
+    if (route.backupNextHops_ref().has_value()) {
+      compactRoute.backupNextHopGroupId_ref() =
+          getGroupId(*route.backupNextHops_ref(), compactDelta);
+    }
+    compactDelta.unicastRoutesToUpdate_ref()->emplace_back(
+        std::move(compactRoute));
+  }
+  for (auto const& route : *delta.mplsRoutesToUpdate_ref()) {
+    thrift::CompactMplsRoute compactRoute;
+    *compactRoute.topLabel_ref() = route.topLabel;
+    *compactRoute.nextHopGroupId_ref() =
+        getGroupId(*route.nextHops_ref(), compactDelta);
+    compactRoute.adminDistance_ref().from_optional(
+        route.adminDistance_ref().to_optional());
+    compactDelta.mplsRoutesToUpdate_ref()->emplace_back(
+        std::move(compactRoute));
+  }
+
+  *compactDelta.unicastRoutesToDelete_ref() =
+      *delta.unicastRoutesToDelete_ref();
+  *compactDelta.mplsRoutesToDelete_ref() = *delta.mplsRoutesToDelete_ref();
+  compactDelta.perfEvents_ref().from_optional(
+      delta.perfEvents_ref().to_optional());
+  return compactDelta;
+}
+
+int64_t
+CompactRouteDeltaEncoder::getGroupId(
+    const std::vector<thrift::NextHopThrift>& nextHops,
+    thrift::CompactRouteDatabaseDelta& delta) {
+  auto [it, inserted] = groupIds_.emplace(nextHops, nextGroupId_);
+  if (inserted) {
+    ++nextGroupId_;
+    delta.nextHopGroups_ref()->emplace(it->second, nextHops);
+  }
+  return it->second;
+}
+
+thrift::RouteDatabaseDelta
+CompactRouteDeltaDecoder::decode(thrift::CompactRouteDatabaseDelta&& delta) {
+  if (*delta.resetNextHopGroups_ref()) {
+    groups_.clear();
+  }
+  for (auto& [groupId, nextHops] : *delta.nextHopGroups_ref()) {
+    groups_[groupId] = std::move(nextHops);
+  }
+
+  thrift::RouteDatabaseDelta routeDelta;
+  for (auto& compactRoute : *delta.unicastRoutesToUpdate_ref()) {
+    thrift::UnicastRoute route;
+    route.dest = std::move(*compactRoute.dest_ref());
+    *route.nextHops_ref() = getGroup(*compactRoute.nextHopGroupId_ref());
+    route.adminDistance_ref().from_optional(
+        compactRoute.adminDistance_ref().to_optional());
+    route.prefixType_ref().from_optional(
+        compactRoute.prefixType_ref().to_optional());
+    route.data_ref().from_optional(compactRoute.data_ref().to_optional());
+    *route.doNotInstall_ref() = *compactRoute.doNotInstall_ref();
+    if (compactRoute.backupNextHopGroupId_ref().has_value()) {
+      route.backupNextHops_ref() =
+          getGroup(*compactRoute.backupNextHopGroupId_ref());
+    }
+    routeDelta.unicastRoutesToUpdate_ref()->emplace_back(std::move(route));
+  }
+  for (auto& compactRoute : *delta.mplsRoutesToUpdate_ref()) {
+    thrift::MplsRoute route;
+    route.topLabel = *compactRoute.topLabel_ref();
+    *route.nextHops_ref() = getGroup(*compactRoute.nextHopGroupId_ref());
+    route.adminDistance_ref().from_optional(
+        compactRoute.adminDistance_ref().to_optional());
+    routeDelta.mplsRoutesToUpdate_ref()->emplace_back(std::move(route));
+  }
+
+  *routeDelta.unicastRoutesToDelete_ref() =
+      std::move(*delta.unicastRoutesToDelete_ref());
+  *routeDelta.mplsRoutesToDelete_ref() =
+      std::move(*delta.mplsRoutesToDelete_ref());
+  routeDelta.perfEvents_ref().from_optional(
+      delta.perfEvents_ref().to_optional());
+  return routeDelta;
+}
+
+const std::vector<thrift::NextHopThrift>&
+CompactRouteDeltaDecoder::getGroup(int64_t groupId) const {
+  auto it = groups_.find(groupId);
+  if (it == groups_.end()) {
+    throw std::invalid_argument(
+        folly::sformat("Unknown next-hop group {}", groupId));
+  }
+  return it->second;
+}
+
+} // namespace openr
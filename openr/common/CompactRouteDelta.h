@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <openr/if/gen-cpp2/Fib_types.h>
+#include <openr/if/gen-cpp2/Network_types.h>
+
+namespace openr {
+
+/**
+ * Encoder of the RouteDatabaseDeltas of a stream into
+ * thrift::CompactRouteDatabaseDelta. Keeps the next-hop groups defined on the
+ * stream so far, so one is used per stream and deltas are to be encoded in
+ * the order they are sent.
+ *
+ * Groups are dropped all at once, by resetting them on the next delta, once
+ * there are more than maxNextHopGroups of them.
+ */
+class CompactRouteDeltaEncoder {
+ public:
+  explicit CompactRouteDeltaEncoder(size_t maxNextHopGroups);
+
+  thrift::CompactRouteDatabaseDelta encode(
+      const thrift::RouteDatabaseDelta& delta);
+
+  size_t
+  getNumNextHopGroups() const {
+    return groupIds_.size();
+  }
+
+ private:
+  // ID of group of nextHops, defining it on delta if not defined yet
+  int64_t getGroupId(
+      const std::vector<thrift::NextHopThrift>& nextHops,
+      thrift::CompactRouteDatabaseDelta& delta);
+
+  const size_t maxNextHopGroups_{0};
+
+  // groups defined on the stream
+  std::map<std::vector<thrift::NextHopThrift>, int64_t> groupIds_;
+  // IDs are not reused across resets, for the sake of debugging
+  int64_t nextGroupId_{0};
+};
+
+/**
+ * Decoder of thrift::CompactRouteDatabaseDeltas of a stream, counterpart of
+ * CompactRouteDeltaEncoder for C++ subscribers. Deltas are to be decoded in
+ * the order they are received. Throws std::invalid_argument on reference to
+ * an unknown group.
+ */
+class CompactRouteDeltaDecoder {
+ public:
+  thrift::RouteDatabaseDelta decode(thrift::CompactRouteDatabaseDelta&& delta);
+
+ private:
+  const std::vector<thrift::NextHopThrift>& getGroup(int64_t groupId) const;
+
+  // groups defined on the stream
+  std::unordered_map<int64_t, std::vector<thrift::NextHopThrift>> groups_;
+};
+
+} // namespace openr
@@ -11,6 +11,7 @@ namespace openr {
 
 constexpr double Constants::kRttChangeThreashold;
 constexpr folly::StringPiece Constants::kAdjDbMarker;
+constexpr folly::StringPiece Constants::kAdjDbDeltaMarker;
 constexpr folly::StringPiece Constants::kErrorResponse;
 constexpr folly::StringPiece Constants::kEventLogCategory;
 constexpr folly::StringPiece Constants::kFibTimeMarker;
@@ -43,19 +44,30 @@ constexpr int64_t Constants::kDefaultAdjWeight;
 constexpr int64_t Constants::kTtlInfinity;
 constexpr size_t Constants::kMaxFullSyncPendingCountThreshold;
 constexpr size_t Constants::kNumTimeSeries;
+constexpr size_t Constants::kStreamMaxPending;
+constexpr size_t Constants::kFibStreamMaxNextHopGroups;
 constexpr std::chrono::milliseconds Constants::kFloodPendingPublication;
+constexpr size_t Constants::kMaxFibRequestsInFlight;
+constexpr size_t Constants::kMaxThriftFloodRequestsInFlight;
 constexpr std::chrono::milliseconds Constants::kKeepAliveCheckInterval;
 constexpr std::chrono::milliseconds Constants::kKvStoreDbTtl;
 constexpr std::chrono::milliseconds Constants::kLinkImmediateTimeout;
+constexpr std::chrono::milliseconds Constants::kLinkBackoffBatchWindow;
 constexpr std::chrono::milliseconds Constants::kLinkThrottleTimeout;
 constexpr std::chrono::milliseconds Constants::kLongPollReqHoldTime;
+constexpr std::chrono::milliseconds Constants::kStreamMaxLag;
+constexpr size_t Constants::kCtrlMaxConcurrentPerMethod;
+constexpr size_t Constants::kCtrlMaxConcurrentBulkPerMethod;
+constexpr size_t Constants::kCtrlMaxConcurrentBulk;
 constexpr std::chrono::milliseconds Constants::kInitialBackoff;
 constexpr std::chrono::milliseconds Constants::kMaxBackoff;
 constexpr std::chrono::milliseconds Constants::kFibSyncInitialBackoff;
 constexpr std::chrono::milliseconds Constants::kFibSyncMaxBackoff;
 constexpr std::chrono::milliseconds Constants::kMaxTtlUpdateInterval;
+constexpr std::chrono::milliseconds Constants::kTtlUpdateCoalesceWindow;
 constexpr std::chrono::milliseconds Constants::kPersistentStoreInitialBackoff;
 constexpr std::chrono::milliseconds Constants::kPersistentStoreMaxBackoff;
+constexpr uint64_t Constants::kPersistentStoreCompactionRatio;
 constexpr std::chrono::milliseconds Constants::kPlatformConnTimeout;
 constexpr std::chrono::milliseconds Constants::kPlatformIntfProcTimeout;
 constexpr std::chrono::milliseconds Constants::kPlatformRoutesProcTimeout;
@@ -71,10 +83,17 @@ constexpr std::chrono::milliseconds Constants::kTtlDecrement;
 constexpr std::chrono::milliseconds Constants::kTtlInfInterval;
 constexpr std::chrono::milliseconds Constants::kTtlThreshold;
 constexpr std::chrono::seconds Constants::kConvergenceMaxDuration;
+constexpr size_t Constants::kDecisionMaxPublicationBatch;
+constexpr size_t Constants::kKvStoreUpdatesAdjPriority;
+constexpr size_t Constants::kKvStoreUpdatesDefaultPriority;
+constexpr size_t Constants::kKvStoreUpdatesNumPriorities;
+constexpr size_t Constants::kDecisionMaxRouteBuildPreemptions;
 constexpr std::chrono::seconds Constants::kCounterSubmitInterval;
 constexpr std::chrono::seconds Constants::kKeepAliveIntvl;
 constexpr std::chrono::seconds Constants::kKeepAliveTime;
 constexpr std::chrono::seconds Constants::kMemoryThresholdTime;
+constexpr folly::StringPiece Constants::kHeapProfileDir;
+constexpr size_t Constants::kModuleStartupThreads;
 constexpr std::chrono::seconds Constants::kNetlinkSyncThrottleInterval;
 constexpr std::chrono::seconds Constants::kPlatformSyncInterval;
 constexpr std::chrono::seconds Constants::kPlatformThriftIdleTimeout;
@@ -85,6 +85,9 @@ class Constants {
   static constexpr std::chrono::milliseconds kPersistentStoreInitialBackoff{
       100};
   static constexpr std::chrono::milliseconds kPersistentStoreMaxBackoff{5000};
+  // number of appends to the log on disk, before it gets compacted into a
+  // snapshot of the whole database
+  static constexpr uint64_t kPersistentStoreCompactionRatio{10000};
 
   //
   // KvStore specific
@@ -125,6 +128,10 @@ class Constants {
   static constexpr std::chrono::milliseconds kLinkThrottleTimeout{1000};
   static constexpr std::chrono::milliseconds kLinkImmediateTimeout{1};
 
+  // interfaces whose link flap backoff clears within this window of each
+  // other get advertised together
+  static constexpr std::chrono::milliseconds kLinkBackoffBatchWindow{50};
+
   // overloaded note metric value
   static constexpr uint64_t kOverloadNodeMetric{1ull << 32};
 
@@ -143,7 +150,7 @@ class Constants {
   // fixed size list of BucketedTimeSeries
   static constexpr uint32_t kMaxAllowedPps{50};
 
-  // Number of BucketedTimeSeries to spread potential neighbors across
+  // Number of token buckets to spread potential neighbors across
   // for the purpose of limiting the number of packets per second processed
   static constexpr size_t kNumTimeSeries{1024};
 
@@ -159,6 +166,9 @@ class Constants {
   static constexpr std::chrono::milliseconds kServiceConnTimeout{500};
   static constexpr std::chrono::milliseconds kServiceProcTimeout{20000};
 
+  // max number of route programming requests in flight to switch agent
+  static constexpr size_t kMaxFibRequestsInFlight{4};
+
   // time interval to sync between Open/R and Platform
   static constexpr std::chrono::seconds kPlatformSyncInterval{60};
 
@@ -188,6 +198,15 @@ class Constants {
   // Kvstore timer for flooding pending publication
   static constexpr std::chrono::milliseconds kFloodPendingPublication{100};
 
+  // Max number of most recent hops kept in nodeIds of flooded publications.
+  // Keeps publication size and loop check constant regardless of flooding
+  // path length. Longer loops end where a publication brings no news.
+  static constexpr size_t kMaxFloodPathLength{8};
+
+  // Max flooding requests pipelined to a thrift peer without ack. Keys
+  // flooded beyond are coalesced and sent in a batch once an ack arrives
+  static constexpr size_t kMaxThriftFloodRequestsInFlight{4};
+
   // KvStore database TTLs
   static constexpr std::chrono::milliseconds kKvStoreDbTtl{5min};
 
@@ -199,6 +218,7 @@ class Constants {
 
   // KvStore key markers
   static constexpr folly::StringPiece kAdjDbMarker{"adj:"};
+  static constexpr folly::StringPiece kAdjDbDeltaMarker{"adjdelta:"};
   static constexpr folly::StringPiece kPrefixDbMarker{"prefix:"};
   static constexpr folly::StringPiece kPrefixAllocMarker{"allocprefix:"};
   static constexpr folly::StringPiece kFibTimeMarker{"fibtime:"};
@@ -212,6 +232,8 @@ class Constants {
 
   // max interval to update TTL for each key in kvstore w/ finite TTL
   static constexpr std::chrono::milliseconds kMaxTtlUpdateInterval{2h};
+  // ttl updates of keys due within this window are advertised together
+  static constexpr std::chrono::milliseconds kTtlUpdateCoalesceWindow{1s};
   // TTL infinity, never expires
   // int version
   static constexpr int64_t kTtlInfinity{INT32_MIN};
@@ -229,9 +251,48 @@ class Constants {
   static constexpr uint16_t kPerfBufferSize{10};
   static constexpr std::chrono::seconds kConvergenceMaxDuration{3s};
 
+  // max number of KvStore publications Decision applies in one go, before
+  // checking for route rebuild
+  static constexpr size_t kDecisionMaxPublicationBatch{64};
+
+  // priority classes of KvStore updates queue. Adjacency keys are delivered
+  // ahead of all other keys, so that link events are not stuck behind prefix
+  // churn.
+  static constexpr size_t kKvStoreUpdatesAdjPriority{0};
+  static constexpr size_t kKvStoreUpdatesDefaultPriority{1};
+  static constexpr size_t kKvStoreUpdatesNumPriorities{2};
+
+  // max number of consecutive times a Decision route build running off the
+  // event base is restarted for newer topology, before one is let to finish
+  static constexpr size_t kDecisionMaxRouteBuildPreemptions{3};
+
+  // number of most recent Decision route rebuilds kept profiles of
+  static constexpr size_t kDecisionMaxRouteBuildProfiles{32};
+
   // hold time for longPoll requests in openrCtrl thrift server
   static constexpr std::chrono::milliseconds kLongPollReqHoldTime{20000};
 
+  // max number of updates pending to be sent to a subscriber of openrCtrl
+  // stream, before pending updates are coalesced
+  static constexpr size_t kStreamMaxPending{256};
+
+  // subscriber of openrCtrl stream, that hasn't taken an update for this long
+  // while updates are pending, is disconnected
+  static constexpr std::chrono::milliseconds kStreamMaxLag{60000};
+
+  // max number of next-hop groups defined on a compact Fib stream, before
+  // they are reset
+  static constexpr size_t kFibStreamMaxNextHopGroups{10000};
+
+  // max number of requests of an openrCtrl method running at once. Requests
+  // beyond are rejected, except critical ones e.g. drains
+  static constexpr size_t kCtrlMaxConcurrentPerMethod{64};
+
+  // max number of expensive dumps from openrCtrl running at once, per method
+  // and in total
+  static constexpr size_t kCtrlMaxConcurrentBulkPerMethod{4};
+  static constexpr size_t kCtrlMaxConcurrentBulk{8};
+
   //
   // Prefix manager specific
   //
@@ -239,6 +300,14 @@ class Constants {
   // the time we hold on to announce to KvStore
   static constexpr std::chrono::milliseconds kPrefixMgrKvThrottleTimeout{250};
 
+  // interval of full reconciliation of all prefixes with KvStore, throttled
+  // updates in between only cover prefixes changed since last sync
+  static constexpr std::chrono::seconds kPrefixMgrFullSyncInterval{300};
+
+  // number of prefixes of a bulk update PrefixManager applies at once, before
+  // yielding to its other work
+  static constexpr size_t kPrefixMgrUpdateChunkSize{1000};
+
   // Default metrics (path and source preference) for Open/R originated routes
   // (loopback address & interface subnets).
   static constexpr int32_t kDefaultPathPreference{1000}; // LIVE routes
@@ -278,6 +347,24 @@ class Constants {
 
   // Threshold time in secs to crash after reaching critical memory
   static constexpr std::chrono::seconds kMemoryThresholdTime{600};
+
+  // Memory usage must fall this many percent of the memory limit below a
+  // memory pressure level to leave it, so that the level doesn't flap
+  static constexpr int32_t kMemoryPressureHysteresisPct{5};
+
+  // Directory heap profiles are dumped into on request
+  static constexpr folly::StringPiece kHeapProfileDir{"/tmp"};
+
+  // Tick of coarse timer wheel of event bases, timeouts on it are coalesced
+  // into ticks, see OpenrEventBase::getCoarseWheelTimer()
+  static constexpr std::chrono::milliseconds kCoarseWheelTimerTick{50};
+
+  // Threads constructing modules concurrently on startup
+  static constexpr size_t kModuleStartupThreads{4};
+
+  // Threads computing routes of what-if scenarios, see
+  // Decision::getRouteDbsWhatIf()
+  static constexpr size_t kWhatIfRouteBuildThreads{4};
 };
 
 } // namespace openr
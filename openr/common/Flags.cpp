@@ -93,6 +93,11 @@ DEFINE_int32(
     250,
     "Decision debounce time to update spf in frequent adj db update "
     "(in milliseconds)");
+DEFINE_uint32(
+    route_queue_capacity,
+    0,
+    "Max number of pending updates per reader of route and fib update queues. "
+    "Writer gets blocked on full queue. 0 for unbounded queues.");
 
 //
 // TODO: [DEPRECATED] All following flags are deprecated in favor of config
@@ -48,6 +48,7 @@ DECLARE_bool(enable_lfa);
 // TODO: these should be const
 DECLARE_int32(decision_debounce_min_ms);
 DECLARE_int32(decision_debounce_max_ms);
+DECLARE_uint32(route_queue_capacity);
 
 // TODO: TO BE DEPRECATED
 DECLARE_bool(per_prefix_keys);
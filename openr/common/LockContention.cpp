@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/common/LockContention.h>
+
+#include <memory>
+
+#include <folly/Synchronized.h>
+
+namespace openr {
+
+namespace {
+
+// name -> record, records are never erased so references stay valid
+folly::Synchronized<std::map<std::string, std::unique_ptr<LockContention>>>&
+getRegistry() {
+  static folly::Synchronized<
+      std::map<std::string, std::unique_ptr<LockContention>>>
+      registry;
+  return registry;
+}
+
+} // namespace
+
+LockContention&
+LockContention::get(const std::string& name) {
+  return getRegistry().withWLock([&](auto& registry) -> LockContention& {
+    auto& record = registry[name];
+    if (not record) {
+      record.reset(new LockContention());
+    }
+    return *record;
+  });
+}
+
+std::map<std::string, int64_t>
+LockContention::getCounters() {
+  std::map<std::string, int64_t> counters;
+  getRegistry().withRLock([&](auto const& registry) {
+    for (auto const& [name, record] : registry) {
+      const auto prefix = "lock." + name;
+      counters[prefix + ".acquisitions"] =
+          record->acquisitions_.load(std::memory_order_relaxed);
+      counters[prefix + ".contentions"] =
+          record->contentions_.load(std::memory_order_relaxed);
+      counters[prefix + ".wait_us"] =
+          record->waitNs_.load(std::memory_order_relaxed) / 1000;
+    }
+  });
+  return counters;
+}
+
+void
+LockContention::addWait(std::chrono::steady_clock::duration wait) {
+  contentions_.fetch_add(1, std::memory_order_relaxed);
+  waitNs_.fetch_add(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count(),
+      std::memory_order_relaxed);
+}
+
+} // namespace openr
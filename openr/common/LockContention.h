@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace openr {
+
+/**
+ * Contention on a lock, or on a family of locks sharing a name e.g. the locks
+ * of all RWQueue instances with the same name. Locks are tried first, so an
+ * uncontended acquisition only costs a relaxed atomic increment and only
+ * waits for contended ones are timed.
+ *
+ * Totals of all records are exported by Monitor as counters:
+ * - `lock.<name>.acquisitions`: locks taken
+ * - `lock.<name>.contentions`: locks which had to be waited for
+ * - `lock.<name>.wait_us`: total time waited for locks
+ *
+ * Records are never destroyed, hold on to them e.g. as function local static
+ * or member reference:
+ *
+ *   static auto& kContention = LockContention::get("my_module.state");
+ *   auto l = kContention.lock(mutex_);
+ */
+class LockContention {
+ public:
+  // Record of given name, created on first use
+  static LockContention& get(const std::string& name);
+
+  // Totals of all records, as counters named as above
+  static std::map<std::string, int64_t> getCounters();
+
+  LockContention(LockContention const&) = delete;
+  LockContention& operator=(LockContention const&) = delete;
+
+  // Lock mutex, timing the wait if it is held by someone else
+  template <typename Mutex>
+  std::unique_lock<Mutex>
+  lock(Mutex& mutex) {
+    std::unique_lock<Mutex> l(mutex, std::try_to_lock);
+    if (not l.owns_lock()) {
+      const auto start = std::chrono::steady_clock::now();
+      l.lock();
+      addWait(std::chrono::steady_clock::now() - start);
+    }
+    acquisitions_.fetch_add(1, std::memory_order_relaxed);
+    return l;
+  }
+
+  // Call func with exclusively locked data of folly::Synchronized, timing the
+  // wait if it is held by someone else. Like Synchronized::withWLock()
+  template <typename Synchronized, typename Func>
+  decltype(auto)
+  withWLock(Synchronized& sync, Func&& func) {
+    acquisitions_.fetch_add(1, std::memory_order_relaxed);
+    {
+      auto locked = sync.tryWLock();
+      if (locked) {
+        return func(*locked);
+      }
+    }
+    const auto start = std::chrono::steady_clock::now();
+    auto locked = sync.wlock();
+    addWait(std::chrono::steady_clock::now() - start);
+    return func(*locked);
+  }
+
+ private:
+  LockContention() = default;
+
+  void addWait(std::chrono::steady_clock::duration wait);
+
+  std::atomic<uint64_t> acquisitions_{0};
+  std::atomic<uint64_t> contentions_{0};
+  std::atomic<uint64_t> waitNs_{0};
+};
+
+} // namespace openr
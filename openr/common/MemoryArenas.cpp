@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/common/MemoryArenas.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <map>
+#include <stdexcept>
+
+#include <folly/Format.h>
+#include <folly/Synchronized.h>
+#include <folly/memory/MallctlHelper.h>
+#include <folly/memory/Malloc.h>
+#include <glog/logging.h>
+
+#include <openr/common/Constants.h>
+
+namespace openr {
+
+namespace {
+
+// name -> jemalloc arena index of bound threads
+folly::Synchronized<std::map<std::string, unsigned>>&
+getArenaRegistry() {
+  static folly::Synchronized<std::map<std::string, unsigned>> registry;
+  return registry;
+}
+
+size_t
+readArenaStat(unsigned arena, const char* stat) {
+  size_t value{0};
+  folly::mallctlRead(
+      folly::sformat("stats.arenas.{}.{}", arena, stat).c_str(), &value);
+  return value;
+}
+
+} // namespace
+
+bool
+bindModuleArena(const std::string& name) {
+  if (not folly::usingJEMalloc()) {
+    return false;
+  }
+
+  unsigned arena{0};
+  folly::mallctlRead("arenas.create", &arena);
+  folly::mallctlWrite("thread.arena", arena);
+  // flush thread cache, which still holds memory of previous arena
+  folly::mallctlCall("thread.tcache.flush");
+
+  LOG(INFO) << "Thread " << name << " bound to jemalloc arena " << arena;
+  getArenaRegistry().wlock()->insert_or_assign(name, arena);
+  return true;
+}
+
+std::vector<thrift::ModuleMemoryStats>
+getModuleMemoryStats() {
+  auto arenas = getArenaRegistry().copy();
+  std::vector<thrift::ModuleMemoryStats> stats;
+  if (arenas.empty()) {
+    return stats;
+  }
+
+  // jemalloc stats are cached, bump epoch to refresh them
+  folly::mallctlWrite<uint64_t>("epoch", 1);
+  for (auto const& [name, arena] : arenas) {
+    thrift::ModuleMemoryStats moduleStats;
+    moduleStats.module_ref() = name;
+    moduleStats.arena_ref() = arena;
+    moduleStats.allocated_bytes_ref() =
+        readArenaStat(arena, "small.allocated") +
+        readArenaStat(arena, "large.allocated");
+    moduleStats.resident_bytes_ref() = readArenaStat(arena, "resident");
+    stats.emplace_back(std::move(moduleStats));
+  }
+  return stats;
+}
+
+std::string
+dumpHeapProfile() {
+  if (not folly::usingJEMalloc()) {
+    throw std::runtime_error("Heap profiling requires jemalloc");
+  }
+  bool profEnabled{false};
+  try {
+    folly::mallctlRead("opt.prof", &profEnabled);
+  } catch (const std::runtime_error&) {
+    // jemalloc built without profiling support
+  }
+  if (not profEnabled) {
+    throw std::runtime_error(
+        "Heap profiling is not enabled, start with MALLOC_CONF=prof:true");
+  }
+
+  const auto path = folly::sformat(
+      "{}/openr.{}.{}.heap",
+      Constants::kHeapProfileDir,
+      getpid(),
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+  folly::mallctlWrite("prof.dump", path.c_str());
+  LOG(INFO) << "Dumped heap profile to " << path;
+  return path;
+}
+
+} // namespace openr
@@ -0,0 +1,46 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <openr/if/gen-cpp2/OpenrCtrl_types.h>
+
+namespace openr {
+
+/**
+ * Per module memory accounting based on jemalloc arenas. Each module thread
+ * binds a dedicated arena, so that everything it allocates is accounted to
+ * its module. Memory allocated by a module but released by another one stays
+ * accounted to the allocating module, as deallocation returns memory to the
+ * arena it came from.
+ */
+
+/**
+ * Create a new arena and bind the calling thread to it, accounted under name.
+ * Returns false if not running on jemalloc. Throws std::runtime_error if
+ * jemalloc fails to create or bind the arena.
+ */
+bool bindModuleArena(const std::string& name);
+
+/**
+ * Allocated and resident bytes of every bound arena. Empty if no arena was
+ * bound.
+ */
+std::vector<thrift::ModuleMemoryStats> getModuleMemoryStats();
+
+/**
+ * Dump heap profile of the process into Constants::kHeapProfileDir and
+ * return path of the file. Requires jemalloc built with profiling and
+ * started with `prof:true` in MALLOC_CONF. Throws std::runtime_error
+ * otherwise.
+ */
+std::string dumpHeapProfile();
+
+} // namespace openr
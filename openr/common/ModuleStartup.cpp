@@ -0,0 +1,164 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/common/ModuleStartup.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <stdexcept>
+
+#include <fb303/ServiceData.h>
+#include <folly/Format.h>
+#include <folly/Synchronized.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <glog/logging.h>
+
+#include <openr/common/Util.h>
+
+namespace fb303 = facebook::fb303;
+
+namespace openr {
+
+namespace {
+
+folly::Synchronized<thrift::PerfEvents>&
+getStartupPerfEventsRegistry() {
+  static folly::Synchronized<thrift::PerfEvents> registry;
+  return registry;
+}
+
+} // namespace
+
+ModuleStartup::ModuleStartup(const std::string& nodeName)
+    : nodeName_(nodeName) {}
+
+void
+ModuleStartup::addModule(
+    const std::string& name,
+    const std::vector<std::string>& deps,
+    std::function<void()> startFn) {
+  if (moduleIndex_.count(name)) {
+    throw std::invalid_argument(
+        folly::sformat("Module {} is registered twice", name));
+  }
+  for (auto const& dep : deps) {
+    if (not moduleIndex_.count(dep)) {
+      throw std::invalid_argument(folly::sformat(
+          "Module {} depends on unknown module {}", name, dep));
+    }
+  }
+
+  const size_t index = modules_.size();
+  for (auto const& dep : deps) {
+    modules_.at(moduleIndex_.at(dep)).dependents.emplace_back(index);
+  }
+  modules_.emplace_back(Module{name, std::move(startFn), {}, deps.size()});
+  moduleIndex_.emplace(name, index);
+}
+
+void
+ModuleStartup::run(size_t numThreads) {
+  CHECK_GT(numThreads, 0);
+
+  // State of the startup, guarded by mutex_
+  std::condition_variable startupDone;
+  size_t numInProgress{0};
+  std::exception_ptr error{nullptr};
+
+  // Start module on the executor. Called with mutex_ held
+  std::function<void(size_t)> startModule;
+
+  // NOTE: destroyed first, joining its threads before state above goes away
+  folly::CPUThreadPoolExecutor executor(
+      numThreads, std::make_shared<folly::NamedThreadFactory>("ModuleStartup"));
+
+  startModule = [&](size_t index) {
+    ++numInProgress;
+    executor.add([&, index]() {
+      auto& module = modules_.at(index);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        addPerfEvent(
+            perfEvents_,
+            nodeName_,
+            folly::sformat("{}_INIT_START", module.name));
+      }
+
+      const auto startTime = std::chrono::steady_clock::now();
+      std::exception_ptr moduleError{nullptr};
+      try {
+        module.startFn();
+      } catch (...) {
+        moduleError = std::current_exception();
+      }
+      const auto initMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - startTime);
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      --numInProgress;
+      if (moduleError) {
+        LOG(ERROR) << "Failed to start " << module.name << " after "
+                   << initMs.count() << "ms";
+        if (not error) {
+          error = moduleError;
+        }
+      } else {
+        LOG(INFO) << "Started " << module.name << " in " << initMs.count()
+                  << "ms";
+        addPerfEvent(
+            perfEvents_,
+            nodeName_,
+            folly::sformat("{}_INIT_DONE", module.name));
+        fb303::fbData->setCounter(
+            folly::sformat("startup.{}.init_ms", module.name), initMs.count());
+        // no further modules are started once one failed
+        for (auto dependent : module.dependents) {
+          if (--modules_.at(dependent).numPendingDeps == 0 and not error) {
+            startModule(dependent);
+          }
+        }
+      }
+      if (numInProgress == 0) {
+        startupDone.notify_all();
+      }
+    });
+  };
+
+  const auto startTime = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (size_t index = 0; index < modules_.size(); ++index) {
+    if (modules_.at(index).numPendingDeps == 0) {
+      startModule(index);
+    }
+  }
+  startupDone.wait(lock, [&]() { return numInProgress == 0; });
+
+  const auto startupMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  fb303::fbData->setCounter("startup.init_ms", startupMs.count());
+  *getStartupPerfEventsRegistry().wlock() = perfEvents_;
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  LOG(INFO) << "Started " << modules_.size() << " modules in "
+            << startupMs.count() << "ms";
+}
+
+thrift::PerfEvents
+ModuleStartup::getPerfEvents() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return perfEvents_;
+}
+
+thrift::PerfEvents
+getModuleStartupPerfEvents() {
+  return getStartupPerfEventsRegistry().copy();
+}
+
+} // namespace openr
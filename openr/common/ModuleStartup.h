@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <openr/if/gen-cpp2/Lsdb_types.h>
+
+namespace openr {
+
+/**
+ * Dependency graph of module initialization. Modules are started
+ * concurrently, each one as soon as all modules it depends on are started.
+ * Startup of every module is recorded as perf events `<name>_INIT_START` and
+ * `<name>_INIT_DONE`.
+ */
+class ModuleStartup {
+ public:
+  explicit ModuleStartup(const std::string& nodeName);
+
+  /**
+   * Register module, started by calling startFn once all of deps are started.
+   * Dependencies must be registered first, which rules out cycles. Throws
+   * std::invalid_argument on duplicate name or unknown dependency.
+   */
+  void addModule(
+      const std::string& name,
+      const std::vector<std::string>& deps,
+      std::function<void()> startFn);
+
+  /**
+   * Start all registered modules on up to numThreads threads and block until
+   * they are started. If startFn of a module throws, modules depending on it
+   * are not started and the exception is rethrown once startups in progress
+   * are done.
+   */
+  void run(size_t numThreads);
+
+  // perf events recorded by run(), in order of their occurrence
+  thrift::PerfEvents getPerfEvents() const;
+
+ private:
+  struct Module {
+    std::string name;
+    std::function<void()> startFn;
+    // modules to start after this one
+    std::vector<size_t> dependents;
+    // dependencies not yet started
+    size_t numPendingDeps{0};
+  };
+
+  const std::string nodeName_;
+
+  // modules in order of registration
+  std::vector<Module> modules_;
+  std::unordered_map<std::string, size_t> moduleIndex_;
+
+  mutable std::mutex mutex_;
+  thrift::PerfEvents perfEvents_;
+};
+
+/**
+ * Perf events of the module startup of this process, as recorded by the last
+ * ModuleStartup::run()
+ */
+thrift::PerfEvents getModuleStartupPerfEvents();
+
+} // namespace openr
@@ -7,11 +7,28 @@
 
 #include "openr/common/OpenrEventBase.h"
 
+#include <algorithm>
+
+#include <fb303/ServiceData.h>
+#include <folly/Demangle.h>
+#include <folly/Format.h>
+#include <folly/experimental/ExecutionObserver.h>
 #include <folly/fibers/FiberManagerMap.h>
+#include <folly/futures/Future.h>
+
+#include <openr/common/Constants.h>
+
+namespace fb303 = facebook::fb303;
 
 namespace openr {
 
 namespace {
+// Interval of periodic timer, updating timestamp and reporting counters
+const std::chrono::seconds kTimeoutInterval{1};
+
+// Callbacks and fiber runs taking longer get logged
+const std::chrono::milliseconds kSlowCallbackThreshold{100};
+
 std::chrono::seconds
 getElapsedSeconds() {
   return std::chrono::duration_cast<std::chrono::seconds>(
@@ -35,8 +52,149 @@ getFmOptions() {
   options.stackSize = 256 * 1024;
   return options;
 }
+
+std::chrono::milliseconds
+toMs(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+}
 } // namespace
 
+/**
+ * Observes loop iterations, callbacks of event base and runs of fibers. Only
+ * accessed from event base thread.
+ */
+class OpenrEventBase::Stats : public folly::EventBaseObserver,
+                              public folly::ExecutionObserver {
+ public:
+  explicit Stats(const std::string& name)
+      : name_(name),
+        loopBusyKey_(folly::sformat("evb.{}.loop_busy_us", name)),
+        loopLagKey_(folly::sformat("evb.{}.loop_lag_ms", name)),
+        slowestCallbackKey_(folly::sformat("evb.{}.slowest_callback_ms", name)),
+        fiberTaskWaitKey_(folly::sformat("evb.{}.fiber_task_wait_ms", name)),
+        fiberTasksKey_(folly::sformat("evb.{}.fiber_tasks", name)),
+        wheelTimeoutsKey_(folly::sformat("evb.{}.wheel_timeouts", name)) {
+    // 1ms buckets up to 100ms
+    fb303::fbData->addHistogram(loopBusyKey_, 1000, 0, 100000);
+    fb303::fbData->exportHistogramPercentile(loopBusyKey_, 50, 95, 99);
+    fb303::fbData->addStatExportType(loopLagKey_, fb303::AVG);
+    fb303::fbData->addStatExportType(loopLagKey_, fb303::MAX);
+    fb303::fbData->addStatExportType(slowestCallbackKey_, fb303::MAX);
+    fb303::fbData->addStatExportType(fiberTaskWaitKey_, fb303::AVG);
+    fb303::fbData->addStatExportType(fiberTaskWaitKey_, fb303::MAX);
+  }
+
+  uint32_t
+  getSampleRate() const override {
+    return 1;
+  }
+
+  void
+  loopSample(int64_t busyTime, int64_t /* idleTime */) override {
+    fb303::fbData->addHistogramValue(loopBusyKey_, busyTime);
+  }
+
+  void
+  starting(uintptr_t id) noexcept override {
+    running_.emplace_back(id, std::chrono::steady_clock::now());
+  }
+
+  void
+  runnable(uintptr_t /* id */) noexcept override {}
+
+  void
+  stopped(uintptr_t id) noexcept override {
+    // Callbacks may nest, e.g. fiber run from within timeout
+    auto it = std::find_if(running_.rbegin(), running_.rend(), [id](auto& r) {
+      return r.first == id;
+    });
+    if (it == running_.rend()) {
+      return;
+    }
+    const auto duration = std::chrono::steady_clock::now() - it->second;
+    running_.erase(std::next(it).base(), running_.end());
+
+    auto taskIt = fiberTasks_.find(id);
+    if (duration > slowestCallback_) {
+      slowestCallback_ = duration;
+      slowestCallbackName_ =
+          taskIt != fiberTasks_.end() ? taskIt->second.name : "evb callback";
+    }
+    if (taskIt != fiberTasks_.end() and taskIt->second.finished) {
+      fiberTasks_.erase(taskIt);
+    }
+  }
+
+  void
+  fiberTaskStarted(
+      const std::string& name, std::chrono::steady_clock::time_point addTime) {
+    fb303::fbData->addStatValue(
+        fiberTaskWaitKey_,
+        toMs(std::chrono::steady_clock::now() - addTime).count(),
+        fb303::AVG);
+    // Fiber got started last
+    if (running_.size()) {
+      fiberTasks_[running_.back().first] = FiberTask{name, false};
+    }
+  }
+
+  void
+  fiberTaskStopped() {
+    // Forget name once fiber stops running
+    if (running_.size()) {
+      auto it = fiberTasks_.find(running_.back().first);
+      if (it != fiberTasks_.end()) {
+        it->second.finished = true;
+      }
+    }
+  }
+
+  void
+  report(
+      std::chrono::steady_clock::duration lag,
+      size_t numFiberTasks,
+      size_t numWheelTimeouts) {
+    fb303::fbData->addStatValue(loopLagKey_, toMs(lag).count(), fb303::AVG);
+    fb303::fbData->setCounter(fiberTasksKey_, numFiberTasks);
+    fb303::fbData->setCounter(wheelTimeoutsKey_, numWheelTimeouts);
+    fb303::fbData->addStatValue(
+        slowestCallbackKey_, toMs(slowestCallback_).count(), fb303::MAX);
+    if (slowestCallback_ >= kSlowCallbackThreshold) {
+      LOG(WARNING) << name_ << ": slowest callback in last "
+                   << kTimeoutInterval.count() << "s, " << slowestCallbackName_
+                   << ", took " << toMs(slowestCallback_).count() << "ms";
+    }
+    slowestCallback_ = std::chrono::steady_clock::duration(0);
+    slowestCallbackName_.clear();
+  }
+
+ private:
+  struct FiberTask {
+    std::string name;
+    // Task completed, fiber stops for last time
+    bool finished{false};
+  };
+
+  const std::string name_;
+  const std::string loopBusyKey_;
+  const std::string loopLagKey_;
+  const std::string slowestCallbackKey_;
+  const std::string fiberTaskWaitKey_;
+  const std::string fiberTasksKey_;
+  const std::string wheelTimeoutsKey_;
+
+  // Callbacks/fibers being run with their start time, innermost last
+  std::vector<std::pair<uintptr_t, std::chrono::steady_clock::time_point>>
+      running_;
+
+  // Fiber tasks by id of their fiber
+  std::unordered_map<uintptr_t, FiberTask> fiberTasks_;
+
+  // Slowest callback since last report
+  std::chrono::steady_clock::duration slowestCallback_{0};
+  std::string slowestCallbackName_;
+};
+
 EventBaseStopSignalHandler::EventBaseStopSignalHandler(folly::EventBase* evb)
     : folly::AsyncSignalHandler(evb) {}
 
@@ -122,20 +280,107 @@ OpenrEventBase::ZmqEventHandler::handlerReady(uint16_t events) noexcept {
 }
 
 OpenrEventBase::OpenrEventBase()
-    : fiberManager_(folly::fibers::getFiberManager(evb_, getFmOptions())) {
+    : coarseWheelTimer_(folly::HHWheelTimer::newTimer(
+          &evb_,
+          Constants::kCoarseWheelTimerTick,
+          folly::AsyncTimeout::InternalEnum::INTERNAL)),
+      fiberManager_(folly::fibers::getFiberManager(evb_, getFmOptions())) {
   // Periodic timer to update eventbase's timestamp. This is used by Watchdog to
   // identify stuck threads.
   // update aliveness timestamp
   timestamp_.store(std::chrono::steady_clock::now().time_since_epoch().count());
   timeout_ = folly::AsyncTimeout::make(evb_, [this]() noexcept {
-    timestamp_.store(
-        std::chrono::steady_clock::now().time_since_epoch().count());
-    timeout_->scheduleTimeout(std::chrono::seconds(1));
+    const auto now = std::chrono::steady_clock::now();
+    timestamp_.store(now.time_since_epoch().count());
+    if (stats_) {
+      const auto lag = now - timeoutExpiry_;
+      stats_->report(
+          std::max(lag, std::chrono::steady_clock::duration(0)),
+          fiberManager_.numActiveTasks(),
+          evb_.timer().count() + coarseWheelTimer_->count());
+    }
+    timeoutExpiry_ = now + kTimeoutInterval;
+    timeout_->scheduleTimeout(kTimeoutInterval);
   });
+  timeoutExpiry_ = std::chrono::steady_clock::now();
   timeout_->scheduleTimeout(0);
 }
 
-OpenrEventBase::~OpenrEventBase() {}
+OpenrEventBase::~OpenrEventBase() {
+  if (stats_) {
+    evb_.setObserver(nullptr);
+    evb_.setExecutionObserver(nullptr);
+    fiberManager_.setObserver(nullptr);
+  }
+}
+
+void
+OpenrEventBase::setEvbName(const std::string& name) {
+  CHECK(not isRunning());
+  CHECK(not stats_);
+  stats_ = std::make_shared<Stats>(name);
+  evb_.setObserver(stats_);
+  evb_.setExecutionObserver(stats_.get());
+  fiberManager_.setObserver(stats_.get());
+}
+
+std::string
+OpenrEventBase::getFiberTaskName(const std::type_info& type) {
+  // Drop argument lists, e.g. of constructor adding task to its lambda, as in
+  // `openr::Decision::Decision()::{lambda()#1}`
+  const auto demangled = folly::demangle(type);
+  std::string name;
+  int depth{0};
+  for (const char c : demangled) {
+    if (c == '(') {
+      if (depth++ == 0) {
+        name.push_back(c);
+      }
+    } else if (c == ')') {
+      if (--depth == 0) {
+        name.push_back(c);
+      }
+    } else if (depth == 0) {
+      name.push_back(c);
+    }
+  }
+  return name;
+}
+
+void
+OpenrEventBase::fiberTaskStarted(
+    const std::string& name, std::chrono::steady_clock::time_point addTime) {
+  if (stats_) {
+    stats_->fiberTaskStarted(name, addTime);
+  }
+}
+
+void
+OpenrEventBase::fiberTaskStopped() {
+  if (stats_) {
+    stats_->fiberTaskStopped();
+  }
+}
+
+#if FOLLY_HAS_COROUTINES
+void
+OpenrEventBase::addCoroTask(folly::coro::Task<void>&& task) {
+  coroTaskFutures_.emplace_back(addCoroTaskFuture(std::move(task)));
+}
+
+folly::SemiFuture<folly::Unit>
+OpenrEventBase::addCoroTaskFuture(folly::coro::Task<void>&& task) {
+  return std::move(task).scheduleOn(&evb_).start();
+}
+
+folly::coro::Task<void>
+OpenrEventBase::sleepCoro(std::chrono::milliseconds timeout) {
+  DCHECK(evb_.isInEventBaseThread());
+  auto [p, sf] = folly::makePromiseContract<folly::Unit>();
+  scheduleTimeout(timeout, [p = std::move(p)]() mutable { p.setValue(); });
+  co_await std::move(sf);
+}
+#endif
 
 void
 OpenrEventBase::run() {
@@ -147,6 +392,11 @@ OpenrEventBase::stop() {
   for (auto& future : fiberTaskFutures_) {
     future.wait();
   }
+#if FOLLY_HAS_COROUTINES
+  for (auto& future : coroTaskFutures_) {
+    future.wait();
+  }
+#endif
   evb_.terminateLoopSoon();
 }
 
@@ -8,12 +8,20 @@
 #pragma once
 
 #include <csignal>
+#include <typeinfo>
 
 #include <fbzmq/async/ZmqEventLoop.h>
 #include <fbzmq/zmq/Socket.h>
+#include <folly/ScopeGuard.h>
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/async/AsyncSignalHandler.h>
 #include <folly/io/async/EventHandler.h>
+#include <folly/io/async/HHWheelTimer.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Task.h>
+#endif
+
+#include <openr/common/WheelTimeout.h>
 
 namespace openr {
 
@@ -40,6 +48,19 @@ class OpenrEventBase {
     return &evb_;
   }
 
+  /**
+   * Name event base and export its scheduling counters under `evb.<name>.*`
+   * - loop_busy_us: busy time of loop iterations (p50, p95, p99)
+   * - loop_lag_ms: lateness of 1s periodic timer (avg, max)
+   * - slowest_callback_ms: slowest callback or fiber run per second (max),
+   *   also logged with its name if too slow
+   * - fiber_task_wait_ms: time from adding fiber task till it runs (avg, max)
+   * - fiber_tasks: number of active fiber tasks
+   * - wheel_timeouts: number of timeouts scheduled on timer wheels
+   * Must be called before running event base.
+   */
+  void setEvbName(const std::string& name);
+
   /**
    * Add a task to fiber manager. All tasks will be awaited in `stop()`.
    */
@@ -47,7 +68,7 @@ class OpenrEventBase {
   void
   addFiberTask(F&& func) {
     fiberTaskFutures_.emplace_back(
-        fiberManager_.addTaskFuture(std::move(func)));
+        fiberManager_.addTaskFuture(wrapFiberTask(std::move(func))));
   }
 
   /**
@@ -57,9 +78,33 @@ class OpenrEventBase {
   template <typename F>
   folly::Future<folly::Unit>
   addFiberTaskFuture(F&& func) {
-    return fiberManager_.addTaskFuture(std::move(func));
+    return fiberManager_.addTaskFuture(wrapFiberTask(std::move(func)));
   }
 
+#if FOLLY_HAS_COROUTINES
+  /**
+   * Run a coroutine task on event base. All tasks will be awaited in `stop()`.
+   * Tasks co_await, without blocking the event base, on
+   * - queues with `RQueue::getCoro()` or `RQueue::getBatchCoro()`
+   * - timers with `sleepCoro()`
+   * - thrift calls with their `co_*` or `semifuture_*` flavors
+   */
+  void addCoroTask(folly::coro::Task<void>&& task);
+
+  /**
+   * Another flavor of adding a coroutine task. But user will be responsible
+   * to wait for the task completion in termination sequence.
+   */
+  folly::SemiFuture<folly::Unit> addCoroTaskFuture(
+      folly::coro::Task<void>&& task);
+
+  /**
+   * Suspend calling coroutine task for timeout, driven by timers of the event
+   * base like `scheduleTimeout()`. Must be awaited on event base thread.
+   */
+  folly::coro::Task<void> sleepCoro(std::chrono::milliseconds timeout);
+#endif
+
   /**
    * EventBase API aliases
    */
@@ -102,6 +147,27 @@ class OpenrEventBase {
       std::chrono::steady_clock::time_point scheduleTime,
       folly::EventBase::Func callback);
 
+  /**
+   * Timer wheels shared by timeouts of the event base, see WheelTimeout. A
+   * wheel is driven by a single event of the event loop however many timeouts
+   * it holds, and timeouts due within a tick of each other fire in the same
+   * pass of it.
+   * - getWheelTimer(): 10ms ticks, for timeouts sensitive to latency such as
+   *   retries and hold timers
+   * - getCoarseWheelTimer(): Constants::kCoarseWheelTimerTick ticks, for
+   *   timeouts which can fire a tick late, such as keep-alives and TTL
+   *   expiry. Coalesces their deadlines into fewer wakeups.
+   */
+  folly::HHWheelTimer&
+  getWheelTimer() {
+    return evb_.timer();
+  }
+
+  folly::HHWheelTimer&
+  getCoarseWheelTimer() {
+    return *coarseWheelTimer_;
+  }
+
   /**
    * Socket/FD polling APIs
    */
@@ -114,6 +180,34 @@ class OpenrEventBase {
   void removeSocket(uintptr_t socketPtr);
 
  private:
+  class Stats;
+
+  /**
+   * Wrap fiber task to track its wait time and name its runs
+   */
+  template <typename F>
+  auto
+  wrapFiberTask(F&& func) {
+    return [this,
+            func = std::move(func),
+            name = getFiberTaskName(typeid(F)),
+            addTime = std::chrono::steady_clock::now()]() mutable {
+      fiberTaskStarted(name, addTime);
+      SCOPE_EXIT {
+        fiberTaskStopped();
+      };
+      return func();
+    };
+  }
+
+  // Readable name of fiber task from type of its function
+  static std::string getFiberTaskName(const std::type_info& type);
+
+  // Called by fiber task on start and completion
+  void fiberTaskStarted(
+      const std::string& name, std::chrono::steady_clock::time_point addTime);
+  void fiberTaskStopped();
+
   /**
    * Event handler class for sockets and fds
    */
@@ -145,19 +239,33 @@ class OpenrEventBase {
     std::unique_ptr<folly::AsyncTimeout> timeout_;
   };
 
+  // Scheduling counters, set for named event base. NOTE: declared before evb_
+  // to outlive fiber tasks run while destroying it.
+  std::shared_ptr<Stats> stats_;
+
   // EventBase object for async event polling/scheduling
   folly::EventBase evb_;
 
+  // See getCoarseWheelTimer(), declared after evb_ to be destroyed before it
+  folly::HHWheelTimer::UniquePtr coarseWheelTimer_;
+
   // FiberManager driven by evb_, for scheduling fiber tasks
   folly::fibers::FiberManager& fiberManager_;
   std::vector<folly::Future<folly::Unit>> fiberTaskFutures_;
 
+#if FOLLY_HAS_COROUTINES
+  std::vector<folly::SemiFuture<folly::Unit>> coroTaskFutures_;
+#endif
+
   // Data structure to hold fd and their handlers
   std::unordered_map<int /* fd */, ZmqEventHandler> fdHandlers_;
 
   // Timestamp
   std::atomic<std::chrono::steady_clock::duration::rep> timestamp_;
   std::unique_ptr<folly::AsyncTimeout> timeout_;
+
+  // Expected fire time of above periodic timer, to measure loop lag
+  std::chrono::steady_clock::time_point timeoutExpiry_;
 };
 
 } // namespace openr
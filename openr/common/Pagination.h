@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <iterator>
+#include <optional>
+#include <set>
+#include <vector>
+
+namespace openr {
+
+/**
+ * Keys of a page of an unordered container, in key order: the `limit`
+ * smallest distinct keys greater than `cursor`, starting from the smallest
+ * key without cursor. `getKey` maps an entry of the container to its key.
+ *
+ * The container is scanned once keeping only the keys of the page, hence a
+ * page costs O(n log limit) time and O(limit) memory, instead of sorting or
+ * copying the whole container.
+ */
+template <typename Key, typename Container, typename GetKey>
+std::vector<Key>
+getPageKeys(
+    Container const& container,
+    GetKey const& getKey,
+    std::optional<Key> const& cursor,
+    size_t limit) {
+  if (limit == 0) {
+    return {};
+  }
+  std::set<Key> keys;
+  for (auto const& entry : container) {
+    auto const& key = getKey(entry);
+    if ((cursor.has_value() and not(*cursor < key)) or keys.count(key)) {
+      continue;
+    }
+    if (keys.size() == limit) {
+      if (not(key < *keys.rbegin())) {
+        continue;
+      }
+      keys.erase(std::prev(keys.end()));
+    }
+    keys.emplace(key);
+  }
+  return std::vector<Key>(keys.begin(), keys.end());
+}
+
+} // namespace openr
@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/common/PrefixTrie.h>
+
+#include <openr/common/NetworkUtil.h>
+
+namespace openr {
+
+namespace {
+// whether node covers the given masked address of length len
+template <typename NodePtr>
+bool
+covers(NodePtr const& node, folly::IPAddress const& addr, uint8_t len) {
+  return node->len <= len and addr.mask(node->len) == node->addr;
+}
+} // namespace
+
+PrefixTrie::PrefixTrie() {
+  clear();
+}
+
+void
+PrefixTrie::clear() {
+  v4Root_ = std::make_unique<Node>(folly::IPAddress("0.0.0.0"), 0);
+  v6Root_ = std::make_unique<Node>(folly::IPAddress("::"), 0);
+  size_ = 0;
+}
+
+std::unique_ptr<PrefixTrie::Node>&
+PrefixTrie::getRoot(folly::IPAddress const& addr) {
+  return addr.isV4() ? v4Root_ : v6Root_;
+}
+
+bool
+PrefixTrie::insert(thrift::IpPrefix const& prefix) {
+  auto const len = static_cast<uint8_t>(*prefix.prefixLength_ref());
+  auto const addr = toIPAddress(*prefix.prefixAddress_ref()).mask(len);
+
+  auto* node = getRoot(addr).get();
+  while (node->len < len) {
+    auto& child = node->children.at(addr.getNthMSBit(node->len));
+    if (not child) {
+      child = std::make_unique<Node>(addr, len);
+      node = child.get();
+      break;
+    }
+    if (covers(child, addr, len)) {
+      node = child.get();
+      continue;
+    }
+
+    // split child at the longest common prefix with the new prefix
+    auto const common = folly::IPAddress::longestCommonPrefix(
+        {addr, len}, {child->addr, child->len});
+    auto branch = std::make_unique<Node>(
+        common.first.mask(common.second), common.second);
+    auto const childBit = child->addr.getNthMSBit(common.second);
+    branch->children.at(childBit) = std::move(child);
+    child = std::move(branch);
+    node = child.get();
+    if (node->len < len) {
+      node->children.at(not childBit) = std::make_unique<Node>(addr, len);
+      node = node->children.at(not childBit).get();
+    }
+    break;
+  }
+
+  if (node->prefix.has_value()) {
+    return false;
+  }
+  node->prefix = prefix;
+  ++size_;
+  return true;
+}
+
+bool
+PrefixTrie::erase(thrift::IpPrefix const& prefix) {
+  auto const len = static_cast<uint8_t>(*prefix.prefixLength_ref());
+  auto const addr = toIPAddress(*prefix.prefixAddress_ref()).mask(len);
+
+  std::unique_ptr<Node>* parent{nullptr};
+  std::unique_ptr<Node>* slot = &getRoot(addr);
+  while ((*slot)->len < len) {
+    auto& child = (*slot)->children.at(addr.getNthMSBit((*slot)->len));
+    if (not child or not covers(child, addr, len)) {
+      return false;
+    }
+    parent = slot;
+    slot = &child;
+  }
+  if ((*slot)->len != len or not(*slot)->prefix.has_value()) {
+    return false;
+  }
+  (*slot)->prefix.reset();
+  --size_;
+
+  // remove nodes which neither hold a prefix nor branch, roots stay
+  auto compress = [](std::unique_ptr<Node>& nodeSlot) {
+    auto& children = nodeSlot->children;
+    if (nodeSlot->prefix.has_value() or (children.at(0) and children.at(1))) {
+      return false;
+    }
+    auto onlyChild =
+        std::move(children.at(0) ? children.at(0) : children.at(1));
+    nodeSlot = std::move(onlyChild);
+    return true;
+  };
+  if (parent and compress(*slot) and parent != &getRoot(addr)) {
+    compress(*parent);
+  }
+  return true;
+}
+
+std::optional<thrift::IpPrefix>
+PrefixTrie::longestPrefixMatch(folly::CIDRNetwork const& network) const {
+  auto const len = network.second;
+  auto const addr = network.first.mask(len);
+
+  std::optional<thrift::IpPrefix> matchedPrefix;
+  auto const* node = addr.isV4() ? v4Root_.get() : v6Root_.get();
+  while (node and covers(node, addr, len)) {
+    if (node->prefix.has_value()) {
+      matchedPrefix = node->prefix;
+    }
+    if (node->len == len) {
+      break;
+    }
+    node = node->children.at(addr.getNthMSBit(node->len)).get();
+  }
+  return matchedPrefix;
+}
+
+std::vector<thrift::IpPrefix>
+PrefixTrie::coveringPrefixes(folly::CIDRNetwork const& network) const {
+  auto const len = network.second;
+  auto const addr = network.first.mask(len);
+
+  std::vector<thrift::IpPrefix> matchedPrefixes;
+  auto const* node = addr.isV4() ? v4Root_.get() : v6Root_.get();
+  while (node and covers(node, addr, len)) {
+    if (node->prefix.has_value()) {
+      matchedPrefixes.emplace_back(*node->prefix);
+    }
+    if (node->len == len) {
+      break;
+    }
+    node = node->children.at(addr.getNthMSBit(node->len)).get();
+  }
+  return matchedPrefixes;
+}
+
+std::vector<thrift::IpPrefix>
+PrefixTrie::coveredPrefixes(folly::CIDRNetwork const& network) const {
+  auto const len = network.second;
+  auto const addr = network.first.mask(len);
+
+  // descend to the topmost node within network
+  auto const* node = addr.isV4() ? v4Root_.get() : v6Root_.get();
+  while (node and node->len < len) {
+    if (not covers(node, addr, len)) {
+      return {};
+    }
+    node = node->children.at(addr.getNthMSBit(node->len)).get();
+  }
+  if (not node or node->addr.mask(len) != addr) {
+    return {};
+  }
+
+  // collect prefixes of its sub-trie, lower branch first
+  std::vector<thrift::IpPrefix> matchedPrefixes;
+  std::vector<Node const*> stack{node};
+  while (not stack.empty()) {
+    node = stack.back();
+    stack.pop_back();
+    if (node->prefix.has_value()) {
+      matchedPrefixes.emplace_back(*node->prefix);
+    }
+    for (auto it = node->children.rbegin(); it != node->children.rend(); ++it) {
+      if (*it) {
+        stack.emplace_back(it->get());
+      }
+    }
+  }
+  return matchedPrefixes;
+}
+
+} // namespace openr
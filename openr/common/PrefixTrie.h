@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <folly/IPAddress.h>
+
+#include <openr/if/gen-cpp2/Network_types.h>
+
+namespace openr {
+
+/**
+ * Set of IP prefixes in a path compressed binary trie, separate for v4 and v6,
+ * for longest prefix matching in O(prefix length) instead of scanning every
+ * prefix.
+ *
+ * Every node either holds a prefix of the set or branches, so there are less
+ * than two nodes per prefix.
+ */
+class PrefixTrie {
+ public:
+  PrefixTrie();
+
+  // add prefix, returns false if it exists already
+  bool insert(thrift::IpPrefix const& prefix);
+
+  // remove prefix, returns false if it does not exist
+  bool erase(thrift::IpPrefix const& prefix);
+
+  void clear();
+
+  size_t
+  size() const {
+    return size_;
+  }
+
+  // longest prefix of the set containing network, std::nullopt if none
+  std::optional<thrift::IpPrefix> longestPrefixMatch(
+      folly::CIDRNetwork const& network) const;
+
+  // all prefixes of the set containing network, shortest first
+  std::vector<thrift::IpPrefix> coveringPrefixes(
+      folly::CIDRNetwork const& network) const;
+
+  // all prefixes of the set contained in network, including network itself,
+  // in address order. O(prefix length + number of prefixes returned)
+  std::vector<thrift::IpPrefix> coveredPrefixes(
+      folly::CIDRNetwork const& network) const;
+
+ private:
+  struct Node {
+    Node(folly::IPAddress addr, uint8_t len)
+        : addr(std::move(addr)), len(len) {}
+
+    // masked address and length of the prefix covered by this node
+    folly::IPAddress addr;
+    uint8_t len{0};
+
+    // original prefix if it belongs to the set
+    std::optional<thrift::IpPrefix> prefix;
+
+    // sub-tries by the bit following `len`
+    std::array<std::unique_ptr<Node>, 2> children;
+  };
+
+  std::unique_ptr<Node>& getRoot(folly::IPAddress const& addr);
+
+  // root nodes for 0.0.0.0/0 and ::/0
+  std::unique_ptr<Node> v4Root_;
+  std::unique_ptr<Node> v6Root_;
+
+  size_t size_{0};
+};
+
+} // namespace openr
@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+namespace openr {
+
+namespace detail {
+
+inline folly::IOBufQueue&
+getSerializationQueue() {
+  thread_local folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  return queue;
+}
+
+} // namespace detail
+
+/**
+ * Compact serialize a thrift object into a per thread buffer, which keeps its
+ * capacity across calls instead of growing fresh buffers for every object.
+ * Returned range is valid until the next call on the same thread.
+ */
+template <typename T>
+folly::StringPiece
+serializeToThreadBuffer(const T& obj) {
+  auto& queue = detail::getSerializationQueue();
+  queue.clearAndTryReuseLargestBuffer();
+  apache::thrift::CompactSerializer::serialize(obj, &queue);
+  if (queue.empty()) {
+    return {};
+  }
+  if (queue.front()->isChained()) {
+    // grown beyond the reused buffer, keep a single one of the new size
+    auto buf = queue.move();
+    buf->coalesce();
+    queue.append(std::move(buf));
+  }
+  return folly::StringPiece(
+      reinterpret_cast<const char*>(queue.front()->data()),
+      queue.front()->length());
+}
+
+/**
+ * Same as fbzmq::util::writeThriftObjStr() with a compact serializer,
+ * allocating only the returned string
+ */
+template <typename T>
+std::string
+serializeCompact(const T& obj) {
+  return serializeToThreadBuffer(obj).str();
+}
+
+/**
+ * Compact serialized thrift object in a single IOBuf of exactly its size
+ */
+template <typename T>
+std::unique_ptr<folly::IOBuf>
+serializeCompactIOBuf(const T& obj) {
+  auto const data = serializeToThreadBuffer(obj);
+  return folly::IOBuf::copyBuffer(data.data(), data.size());
+}
+
+} // namespace openr
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <fb303/ServiceData.h>
+#include <folly/Function.h>
+#include <folly/Synchronized.h>
+#include <folly/executors/InlineExecutor.h>
+#include <folly/futures/Future.h>
+#include <folly/futures/SharedPromise.h>
+
+namespace openr {
+
+/**
+ * Snapshots of module state shared among callers, e.g. clients reconnecting
+ * at once to subscribe to updates. A snapshot is built once for all callers
+ * asking for it, including those asking while it is being built, and is
+ * reused until invalidate() is called on the next change of the state.
+ * Snapshot which failed to build is built anew by the next caller.
+ *
+ * Counters `<counterPrefix>.hits` and `<counterPrefix>.builds` count callers
+ * served from the cache and snapshots built.
+ */
+template <typename T>
+class SnapshotCache {
+ public:
+  using BuildFn = folly::Function<folly::SemiFuture<std::unique_ptr<T>>()>;
+
+  explicit SnapshotCache(const std::string& counterPrefix)
+      : hitsKey_(counterPrefix + ".hits"),
+        buildsKey_(counterPrefix + ".builds") {}
+
+  // Get copy of snapshot identified by key, calling build if not cached
+  folly::SemiFuture<std::unique_ptr<T>>
+  get(const std::string& key, BuildFn build) {
+    namespace fb303 = facebook::fb303;
+    std::shared_ptr<Snapshot> snapshot;
+    bool isBuilder{false};
+    snapshots_.withWLock([&](auto& snapshots) {
+      auto& cached = snapshots[key];
+      if (cached) {
+        auto future = cached->getSemiFuture();
+        if (future.isReady() and future.hasException()) {
+          cached = nullptr;
+        }
+      }
+      if (not cached) {
+        cached = std::make_shared<Snapshot>();
+        isBuilder = true;
+      }
+      snapshot = cached;
+    });
+
+    if (isBuilder) {
+      fb303::fbData->addStatValue(buildsKey_, 1, fb303::SUM);
+      // Build eagerly, as callers other than this one wait for it
+      build()
+          .via(&folly::InlineExecutor::instance())
+          .thenTry([snapshot](folly::Try<std::unique_ptr<T>>&& result) {
+            if (result.hasException()) {
+              snapshot->setException(std::move(result.exception()));
+              return;
+            }
+            snapshot->setValue(
+                std::shared_ptr<const T>(std::move(result.value())));
+          });
+    } else {
+      fb303::fbData->addStatValue(hitsKey_, 1, fb303::SUM);
+    }
+
+    return snapshot->getSemiFuture().deferValue(
+        [](std::shared_ptr<const T> value) {
+          return std::make_unique<T>(*value);
+        });
+  }
+
+  // Drop cached snapshots, as the state they were built from changed
+  void
+  invalidate() {
+    snapshots_.wlock()->clear();
+  }
+
+ private:
+  using Snapshot = folly::SharedPromise<std::shared_ptr<const T>>;
+
+  const std::string hitsKey_;
+  const std::string buildsKey_;
+
+  folly::Synchronized<
+      std::unordered_map<std::string, std::shared_ptr<Snapshot>>>
+      snapshots_;
+};
+
+} // namespace openr
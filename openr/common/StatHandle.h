@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <ctime>
+#include <memory>
+#include <string>
+
+#include <fb303/ServiceData.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
+
+namespace openr {
+
+namespace detail {
+
+// bumped by resetAllStats(), makes StatHandles look their stat up again
+inline std::atomic<uint64_t> statHandlesEpoch{0};
+
+} // namespace detail
+
+/**
+ * Handle to an fb303 stat for hot paths, e.g. per packet or per SPF run.
+ * fb303::fbData->addStatValue() looks the stat up by key in the stat map on
+ * every call, the handle does so once and then updates the stat directly.
+ * Meant to be a function local static next to the call site:
+ *
+ *   static const StatHandle kSpfRuns("decision.spf_runs", fb303::COUNT);
+ *   kSpfRuns.addValue(1);
+ *
+ * NOTE: fb303::fbData->resetAllData() drops the stats handles refer to. Use
+ * resetAllStats() instead so that handles look their stats up again.
+ */
+class StatHandle {
+ public:
+  StatHandle(std::string name, facebook::fb303::ExportType type)
+      : name_(std::move(name)), type_(type) {}
+
+  void
+  addValue(int64_t value) const {
+    getStat()->stat.addValue(std::time(nullptr), value);
+  }
+
+  const std::string&
+  getName() const {
+    return name_;
+  }
+
+ private:
+  struct Stat {
+    uint64_t epoch{0};
+    facebook::fb303::ExportedStatMapImpl::LockableStat stat;
+  };
+
+  // Stat of the current epoch, looked up lazily as fbData may not be set up
+  // yet when a static handle is constructed. Concurrent lookups of a stat
+  // resolve to the same one
+  std::shared_ptr<Stat>
+  getStat() const {
+    const auto epoch = detail::statHandlesEpoch.load(std::memory_order_acquire);
+    auto stat = stat_.load(std::memory_order_acquire);
+    if (not stat or stat->epoch != epoch) {
+      auto type = type_;
+      stat = std::make_shared<Stat>(Stat{
+          epoch,
+          facebook::fb303::fbData->getStatMap()->getLockableStat(
+              name_, &type)});
+      stat_.store(stat, std::memory_order_release);
+    }
+    return stat;
+  }
+
+  const std::string name_;
+  const facebook::fb303::ExportType type_;
+  mutable folly::atomic_shared_ptr<Stat> stat_;
+};
+
+// Reset all fb303 data, see StatHandle
+inline void
+resetAllStats() {
+  facebook::fb303::fbData->resetAllData();
+  detail::statHandlesEpoch.fetch_add(1, std::memory_order_release);
+}
+
+} // namespace openr
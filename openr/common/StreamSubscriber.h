@@ -0,0 +1,331 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fb303/ServiceData.h>
+#include <folly/ExceptionWrapper.h>
+#include <folly/Function.h>
+#include <folly/Synchronized.h>
+#include <folly/experimental/coro/Coroutine.h>
+#include <glog/logging.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/CancellationToken.h>
+#include <folly/experimental/coro/AsyncGenerator.h>
+#include <folly/experimental/coro/Baton.h>
+#include <folly/experimental/coro/CurrentExecutor.h>
+#include <folly/experimental/coro/Result.h>
+#endif
+#include <thrift/lib/cpp2/async/ServerStream.h>
+
+namespace openr {
+
+/**
+ * Updates pending to be sent to a stream client. Bounded by coalescing
+ * consecutive updates once more than maxPending are pending. A client that
+ * can't be bounded that way, or that hasn't taken an update for more than
+ * maxLag while updates are pending, is lagging too far behind and is to be
+ * disconnected.
+ */
+template <typename T>
+class StreamBuffer {
+ public:
+  // Merge `from` into `into`, which precedes it. Returns false, leaving both
+  // unchanged, if they can't be merged.
+  using MergeFn = std::function<bool(T& into, T& from)>;
+
+  StreamBuffer(
+      size_t maxPending, std::chrono::milliseconds maxLag, MergeFn merge)
+      : maxPending_(maxPending), maxLag_(maxLag), merge_(std::move(merge)) {
+    CHECK_GT(maxPending_, 0);
+  }
+
+  /**
+   * Add update. Returns false if the client is lagging too far behind, in
+   * which case the buffer is to be dropped.
+   */
+  bool
+  push(T&& item, std::chrono::steady_clock::time_point now) {
+    if (not waiting_ and not pending_.empty() and now - lastPop_ > maxLag_) {
+      return false;
+    }
+    pending_.emplace_back(std::move(item));
+    if (pending_.size() <= maxPending_) {
+      return true;
+    }
+
+    ++numCoalesced_;
+    std::deque<T> coalesced;
+    for (auto& pendingItem : pending_) {
+      if (coalesced.empty() or not merge_(coalesced.back(), pendingItem)) {
+        coalesced.emplace_back(std::move(pendingItem));
+      }
+    }
+    pending_ = std::move(coalesced);
+    return pending_.size() <= maxPending_;
+  }
+
+  // Take next update, std::nullopt if none i.e. client is waiting for one
+  std::optional<T>
+  pop(std::chrono::steady_clock::time_point now) {
+    if (pending_.empty()) {
+      waiting_ = true;
+      return std::nullopt;
+    }
+    waiting_ = false;
+    lastPop_ = now;
+    auto item = std::move(pending_.front());
+    pending_.pop_front();
+    return item;
+  }
+
+  void
+  clear() {
+    pending_.clear();
+  }
+
+  size_t
+  size() const {
+    return pending_.size();
+  }
+
+  // number of times pending updates were coalesced
+  size_t
+  getNumCoalesced() const {
+    return numCoalesced_;
+  }
+
+ private:
+  const size_t maxPending_{0};
+  const std::chrono::milliseconds maxLag_;
+  MergeFn merge_;
+
+  std::deque<T> pending_;
+  // client asked for an update while none was pending
+  bool waiting_{true};
+  std::chrono::steady_clock::time_point lastPop_;
+  size_t numCoalesced_{0};
+};
+
+/**
+ * Server side of a thrift stream whose updates are buffered in a
+ * StreamBuffer, i.e. a slow client can't make the updates pending for it
+ * grow unboundedly. Updates are pulled by thrift as the client is ready for
+ * them. Counters `<counterPrefix>.lagging` and `<counterPrefix>.dropped` count
+ * coalescing of pending updates and disconnected clients.
+ *
+ * NOTE: Without coroutine support updates are handed to thrift right away,
+ * and are buffered by it unboundedly.
+ */
+template <typename T>
+class StreamSubscriber {
+ public:
+  using MergeFn = typename StreamBuffer<T>::MergeFn;
+
+  /**
+   * Create the stream to return to the client and the subscriber to publish
+   * updates to. onComplete is called once the stream ended, be it by the
+   * client, by complete() or by disconnecting a lagging client.
+   */
+  static std::pair<
+      apache::thrift::ServerStream<T>,
+      std::shared_ptr<StreamSubscriber<T>>>
+  create(
+      const std::string& counterPrefix,
+      size_t maxPending,
+      std::chrono::milliseconds maxLag,
+      MergeFn merge,
+      folly::Function<void()> onComplete) {
+    std::shared_ptr<StreamSubscriber<T>> subscriber(new StreamSubscriber<T>(
+        counterPrefix,
+        maxPending,
+        maxLag,
+        std::move(merge),
+        std::move(onComplete)));
+#if FOLLY_HAS_COROUTINES
+    apache::thrift::ServerStream<T> stream(
+        generate(subscriber, Finisher{subscriber}));
+    return {std::move(stream), std::move(subscriber)};
+#else
+    auto streamAndPublisher = apache::thrift::ServerStream<T>::createPublisher(
+        [weakSubscriber = std::weak_ptr<StreamSubscriber<T>>(subscriber)]() {
+          if (auto subscriber = weakSubscriber.lock()) {
+            subscriber->runOnComplete();
+          }
+        });
+    subscriber->publisher_ = std::move(streamAndPublisher.second);
+    return {std::move(streamAndPublisher.first), std::move(subscriber)};
+#endif
+  }
+
+  // Publish update, disconnecting the client if it is lagging too far behind
+  void
+  publish(T item) {
+#if FOLLY_HAS_COROUTINES
+    namespace fb303 = facebook::fb303;
+    bool dropped{false};
+    state_.withWLock([&](auto& state) {
+      if (state.closed) {
+        return;
+      }
+      const auto numCoalesced = state.buffer.getNumCoalesced();
+      if (not state.buffer.push(
+              std::move(item), std::chrono::steady_clock::now())) {
+        dropped = true;
+        state.buffer.clear();
+        state.closed = true;
+        state.error = folly::make_exception_wrapper<std::runtime_error>(
+            "subscriber is lagging behind");
+      } else if (state.buffer.getNumCoalesced() != numCoalesced) {
+        fb303::fbData->addStatValue(
+            counterPrefix_ + ".lagging", 1, fb303::SUM);
+      }
+      baton_.post();
+    });
+    if (dropped) {
+      LOG(WARNING) << "Disconnecting " << counterPrefix_
+                   << " subscriber lagging behind";
+      fb303::fbData->addStatValue(counterPrefix_ + ".dropped", 1, fb303::SUM);
+      runOnComplete();
+    }
+#else
+    publisher_.withWLock([&item](auto& publisher) {
+      if (publisher.has_value()) {
+        publisher->next(std::move(item));
+      }
+    });
+#endif
+  }
+
+  // Complete the stream, after pending updates. Updates afterwards are dropped
+  void
+  complete(folly::exception_wrapper error = {}) {
+#if FOLLY_HAS_COROUTINES
+    state_.withWLock([&](auto& state) {
+      if (state.closed) {
+        return;
+      }
+      state.closed = true;
+      state.error = std::move(error);
+      baton_.post();
+    });
+#else
+    publisher_.withWLock([&error](auto& publisher) {
+      if (publisher.has_value()) {
+        if (error) {
+          std::move(*publisher).complete(std::move(error));
+        } else {
+          std::move(*publisher).complete();
+        }
+        publisher.reset();
+      }
+    });
+#endif
+    runOnComplete();
+  }
+
+ private:
+  StreamSubscriber(
+      const std::string& counterPrefix,
+      size_t maxPending,
+      std::chrono::milliseconds maxLag,
+      MergeFn merge,
+      folly::Function<void()> onComplete)
+      : counterPrefix_(counterPrefix),
+        onComplete_(std::move(onComplete)),
+        state_(State{StreamBuffer<T>(maxPending, maxLag, std::move(merge))}) {
+  }
+
+  // Call onComplete, unless it has been already
+  void
+  runOnComplete() {
+    auto onComplete = std::exchange(*onComplete_.wlock(), nullptr);
+    if (onComplete) {
+      onComplete();
+    }
+  }
+
+#if FOLLY_HAS_COROUTINES
+  // Completes the subscriber once the stream is destroyed, even if it has
+  // never been started
+  struct Finisher {
+    explicit Finisher(std::shared_ptr<StreamSubscriber<T>> subscriber)
+        : subscriber(std::move(subscriber)) {}
+    Finisher(Finisher&&) = default;
+    ~Finisher() {
+      if (subscriber) {
+        subscriber->complete();
+      }
+    }
+
+    std::shared_ptr<StreamSubscriber<T>> subscriber;
+  };
+
+  static folly::coro::AsyncGenerator<T&&>
+  generate(std::shared_ptr<StreamSubscriber<T>> self, Finisher finisher) {
+    auto token = co_await folly::coro::co_current_cancellation_token;
+    while (not token.isCancellationRequested()) {
+      std::optional<T> item;
+      bool closed{false};
+      folly::exception_wrapper error;
+      self->state_.withWLock([&](auto& state) {
+        item = state.buffer.pop(std::chrono::steady_clock::now());
+        if (not item.has_value()) {
+          closed = state.closed;
+          error = state.error;
+          self->baton_.reset();
+        }
+      });
+
+      if (item.has_value()) {
+        co_yield std::move(*item);
+        continue;
+      }
+      if (closed) {
+        if (error) {
+          co_yield folly::coro::co_error(std::move(error));
+        }
+        co_return;
+      }
+
+      folly::CancellationCallback cb(token, [&self]() { self->baton_.post(); });
+      co_await self->baton_;
+    }
+  }
+#endif
+
+  const std::string counterPrefix_;
+  folly::Synchronized<folly::Function<void()>> onComplete_;
+
+  struct State {
+    StreamBuffer<T> buffer;
+    // no further updates are accepted
+    bool closed{false};
+    // error to complete the stream with
+    folly::exception_wrapper error;
+  };
+  folly::Synchronized<State> state_;
+
+#if FOLLY_HAS_COROUTINES
+  // posted on change of state_, reset by the consumer under the lock
+  folly::coro::Baton baton_;
+#else
+  folly::Synchronized<std::optional<apache::thrift::ServerStreamPublisher<T>>>
+      publisher_;
+#endif
+};
+
+} // namespace openr
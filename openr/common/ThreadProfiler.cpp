@@ -0,0 +1,247 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/common/ThreadProfiler.h>
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Demangle.h>
+#include <folly/Format.h>
+#include <folly/String.h>
+#include <glog/logging.h>
+
+// Not defined by older glibc
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace openr {
+
+namespace {
+
+const std::chrono::milliseconds kMaxDuration{60000};
+const std::chrono::microseconds kMinInterval{100};
+const std::chrono::microseconds kMaxInterval{1000000};
+
+// Samples kept per profile, others are dropped. ~4MB of frames
+const size_t kMaxSamples{8192};
+const size_t kMaxFrames{64};
+
+// Innermost frames of a sample are the signal handler and the signal
+// trampoline of libc
+const int kSkipFrames{2};
+
+struct StackSample {
+  int depth{0};
+  std::array<void*, kMaxFrames> frames;
+};
+
+// State of the profile in progress, shared with the signal handler. Only
+// accessed by one profile at a time
+struct ProfileState {
+  std::atomic<bool> active{false};
+  // signal handlers currently running
+  std::atomic<int> inHandler{0};
+  std::atomic<size_t> numSamples{0};
+  std::vector<StackSample> samples;
+};
+
+ProfileState gState;
+
+// Serializes profiles
+std::mutex gProfileMutex;
+
+void
+onSigprof(int /* signo */, siginfo_t* /* info */, void* /* context */) {
+  const int savedErrno = errno;
+  gState.inHandler.fetch_add(1);
+  if (gState.active.load()) {
+    const auto i = gState.numSamples.fetch_add(1, std::memory_order_relaxed);
+    if (i < gState.samples.size()) {
+      auto& sample = gState.samples[i];
+      sample.depth = backtrace(sample.frames.data(), kMaxFrames);
+    }
+  }
+  gState.inHandler.fetch_sub(1);
+  errno = savedErrno;
+}
+
+void
+installSignalHandler() {
+  static std::once_flag installed;
+  std::call_once(installed, []() {
+    // backtrace() loads libgcc on first use, which is not safe in a signal
+    // handler
+    std::array<void*, kMaxFrames> frames;
+    backtrace(frames.data(), kMaxFrames);
+
+    // never uninstalled, a pending SIGPROF would terminate the process
+    struct sigaction action {};
+    action.sa_sigaction = onSigprof;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) {
+      throw std::system_error(
+          errno, std::generic_category(), "Failed to install SIGPROF handler");
+    }
+  });
+}
+
+// CPU-time clock of another thread of this process, like
+// pthread_getcpuclockid() computes it from the kernel thread id
+clockid_t
+getThreadCpuClock(pid_t tid) {
+  return (~static_cast<clockid_t>(tid) << 3) | 6 /* per thread, sched */;
+}
+
+timespec
+toTimespec(std::chrono::microseconds duration) {
+  timespec ts{};
+  ts.tv_sec = duration.count() / 1000000;
+  ts.tv_nsec = (duration.count() % 1000000) * 1000;
+  return ts;
+}
+
+std::string
+symbolize(void* addr) {
+  Dl_info info{};
+  if (dladdr(addr, &info) == 0) {
+    return folly::sformat("{}", addr);
+  }
+  if (info.dli_sname) {
+    return folly::demangle(info.dli_sname).toStdString();
+  }
+  if (info.dli_fname) {
+    std::string binary{info.dli_fname};
+    binary = binary.substr(binary.rfind('/') + 1);
+    return folly::sformat(
+        "{}+{:#x}",
+        binary,
+        reinterpret_cast<uintptr_t>(addr) -
+            reinterpret_cast<uintptr_t>(info.dli_fbase));
+  }
+  return folly::sformat("{}", addr);
+}
+
+} // namespace
+
+thrift::ThreadProfile
+profileThread(
+    pid_t tid,
+    std::chrono::milliseconds duration,
+    std::chrono::microseconds interval) {
+  if (tid <= 0) {
+    throw std::invalid_argument(folly::sformat("Invalid thread id {}", tid));
+  }
+  if (duration.count() <= 0 or duration > kMaxDuration) {
+    throw std::invalid_argument(folly::sformat(
+        "duration ({}ms) should be in (0, {}]ms",
+        duration.count(),
+        kMaxDuration.count()));
+  }
+  if (interval < kMinInterval or interval > kMaxInterval) {
+    throw std::invalid_argument(folly::sformat(
+        "interval ({}us) should be in [{}, {}]us",
+        interval.count(),
+        kMinInterval.count(),
+        kMaxInterval.count()));
+  }
+  std::unique_lock<std::mutex> l(gProfileMutex, std::try_to_lock);
+  if (not l.owns_lock()) {
+    throw std::runtime_error("Another profile is in progress");
+  }
+  installSignalHandler();
+  gState.samples.resize(kMaxSamples);
+  gState.numSamples = 0;
+
+  // deliver SIGPROF to tid every interval of its CPU time
+  sigevent event{};
+  event.sigev_notify = SIGEV_THREAD_ID;
+  event.sigev_signo = SIGPROF;
+  event.sigev_notify_thread_id = tid;
+  timer_t timer;
+  if (timer_create(getThreadCpuClock(tid), &event, &timer) != 0) {
+    throw std::system_error(
+        errno,
+        std::generic_category(),
+        folly::sformat("Failed to create profiling timer of thread {}", tid));
+  }
+  itimerspec spec{};
+  spec.it_interval = toTimespec(interval);
+  spec.it_value = spec.it_interval;
+  gState.active = true;
+  if (timer_settime(timer, 0, &spec, nullptr) != 0) {
+    const int err = errno;
+    gState.active = false;
+    timer_delete(timer);
+    throw std::system_error(
+        err,
+        std::generic_category(),
+        folly::sformat("Failed to start profiling timer of thread {}", tid));
+  }
+
+  std::this_thread::sleep_for(duration);
+
+  // stop sampling and wait for handlers which may still write samples
+  timer_delete(timer);
+  gState.active = false;
+  while (gState.inHandler.load() != 0) {
+    std::this_thread::yield();
+  }
+
+  // collapse samples into distinct stacks, outermost frame first
+  const size_t numSamples = gState.numSamples.load();
+  const size_t numKept = std::min(numSamples, gState.samples.size());
+  std::unordered_map<void*, std::string> symbols;
+  std::map<std::string, int64_t> stacks;
+  for (size_t i = 0; i < numKept; ++i) {
+    const auto& sample = gState.samples[i];
+    std::vector<folly::StringPiece> frames;
+    for (int j = sample.depth - 1; j >= kSkipFrames; --j) {
+      auto addr = sample.frames[j];
+      auto it = symbols.find(addr);
+      if (it == symbols.end()) {
+        it = symbols.emplace(addr, symbolize(addr)).first;
+      }
+      frames.emplace_back(it->second);
+    }
+    if (not frames.empty()) {
+      ++stacks[folly::join(";", frames)];
+    }
+  }
+
+  thrift::ThreadProfile profile;
+  profile.tid_ref() = tid;
+  profile.samples_ref() = numSamples;
+  profile.dropped_samples_ref() = numSamples - numKept;
+  for (const auto& [stack, count] : stacks) {
+    profile.collapsed_stacks_ref()->emplace_back(
+        folly::sformat("{} {}", stack, count));
+  }
+  LOG(INFO) << "Profiled thread " << tid << " for " << duration.count()
+            << "ms, " << numSamples << " samples in " << stacks.size()
+            << " distinct stacks";
+  return profile;
+}
+
+} // namespace openr
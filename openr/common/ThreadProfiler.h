@@ -0,0 +1,38 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+
+#include <openr/if/gen-cpp2/OpenrCtrl_types.h>
+
+namespace openr {
+
+/**
+ * Sample stacks of thread tid of this process for duration, every interval of
+ * CPU time it consumes, and return them collapsed as input of flamegraph.pl.
+ * Only running code is sampled, a thread blocked waiting for events is not.
+ * Blocks the calling thread for duration.
+ *
+ * Sampling is done in a SIGPROF handler, which stays installed once used.
+ * Frames are symbolized with dladdr(), functions of the executable get names
+ * only if it is linked with -rdynamic, else they are reported as
+ * <binary>+<offset> which can be symbolized offline e.g. with addr2line.
+ *
+ * Throws std::invalid_argument for an invalid tid, or duration or interval
+ * out of range, std::runtime_error if another profile is in progress and
+ * std::system_error if sampling can't be set up, e.g. tid doesn't exist.
+ */
+thrift::ThreadProfile profileThread(
+    pid_t tid,
+    std::chrono::milliseconds duration,
+    std::chrono::microseconds interval);
+
+} // namespace openr
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/common/ThreadScheduling.h>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <map>
+#include <system_error>
+
+#include <folly/Format.h>
+#include <folly/String.h>
+#include <folly/Synchronized.h>
+#include <glog/logging.h>
+#include <thrift/lib/cpp/util/EnumUtils.h>
+
+namespace openr {
+
+namespace {
+
+// name -> kernel thread id of registered threads
+folly::Synchronized<std::map<std::string, pid_t>>&
+getThreadRegistry() {
+  static folly::Synchronized<std::map<std::string, pid_t>> registry;
+  return registry;
+}
+
+int
+toSchedPolicy(thrift::ThreadSchedulingPolicy policy) {
+  switch (policy) {
+  case thrift::ThreadSchedulingPolicy::FIFO:
+    return SCHED_FIFO;
+  case thrift::ThreadSchedulingPolicy::RR:
+    return SCHED_RR;
+  default:
+    return SCHED_OTHER;
+  }
+}
+
+thrift::ThreadSchedulingPolicy
+fromSchedPolicy(int policy) {
+  switch (policy & ~SCHED_RESET_ON_FORK) {
+  case SCHED_FIFO:
+    return thrift::ThreadSchedulingPolicy::FIFO;
+  case SCHED_RR:
+    return thrift::ThreadSchedulingPolicy::RR;
+  default:
+    // SCHED_BATCH and SCHED_IDLE are time-sharing too
+    return thrift::ThreadSchedulingPolicy::OTHER;
+  }
+}
+
+} // namespace
+
+void
+setupThreadScheduling(
+    const std::string& name,
+    const std::optional<thrift::ThreadSchedulingConfig>& config) {
+  const pid_t tid = syscall(SYS_gettid);
+
+  // pid 0 refers to the calling thread for both calls
+  if (config and not config->cpus_ref()->empty()) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (auto cpu : *config->cpus_ref()) {
+      CPU_SET(cpu, &cpus);
+    }
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+      throw std::system_error(
+          errno,
+          std::generic_category(),
+          folly::sformat(
+              "Failed to pin thread {} to CPUs {}",
+              name,
+              folly::join(",", *config->cpus_ref())));
+    }
+  }
+  if (config and
+      *config->policy_ref() != thrift::ThreadSchedulingPolicy::OTHER) {
+    sched_param param{};
+    param.sched_priority = *config->priority_ref();
+    if (sched_setscheduler(0, toSchedPolicy(*config->policy_ref()), &param) !=
+        0) {
+      throw std::system_error(
+          errno,
+          std::generic_category(),
+          folly::sformat(
+              "Failed to set scheduling policy {} priority {} of thread {}",
+              apache::thrift::util::enumNameSafe(*config->policy_ref()),
+              *config->priority_ref(),
+              name));
+    }
+  }
+
+  if (config) {
+    LOG(INFO) << "Thread " << name << " (" << tid << ") pinned to CPUs ["
+              << folly::join(",", *config->cpus_ref()) << "] with policy "
+              << apache::thrift::util::enumNameSafe(*config->policy_ref())
+              << " priority " << *config->priority_ref();
+  }
+  getThreadRegistry().wlock()->insert_or_assign(name, tid);
+}
+
+std::vector<thrift::ThreadPlacement>
+getThreadPlacements() {
+  std::vector<thrift::ThreadPlacement> placements;
+  for (auto const& [name, tid] : getThreadRegistry().copy()) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    sched_param param{};
+    const int policy = sched_getscheduler(tid);
+    if (policy < 0 or sched_getaffinity(tid, sizeof(cpus), &cpus) != 0 or
+        sched_getparam(tid, &param) != 0) {
+      continue;
+    }
+
+    thrift::ThreadPlacement placement;
+    placement.name_ref() = name;
+    placement.tid_ref() = tid;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpus)) {
+        placement.cpus_ref()->emplace_back(cpu);
+      }
+    }
+    placement.policy_ref() = fromSchedPolicy(policy);
+    placement.priority_ref() = param.sched_priority;
+    placements.emplace_back(std::move(placement));
+  }
+  return placements;
+}
+
+} // namespace openr
@@ -0,0 +1,38 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <openr/if/gen-cpp2/OpenrConfig_types.h>
+#include <openr/if/gen-cpp2/OpenrCtrl_types.h>
+
+namespace openr {
+
+/**
+ * Pin the calling thread to CPUs and set its scheduling policy as configured,
+ * if config is set, and register the thread under name for
+ * getThreadPlacements().
+ *
+ * Throws std::system_error if the kernel rejects the config, e.g. CPUs
+ * outside of the set allowed for the process or a real-time policy without
+ * CAP_SYS_NICE.
+ */
+void setupThreadScheduling(
+    const std::string& name,
+    const std::optional<thrift::ThreadSchedulingConfig>& config);
+
+/**
+ * Placement of the registered threads as currently seen by the kernel.
+ * Threads which exited meanwhile are skipped.
+ */
+std::vector<thrift::ThreadPlacement> getThreadPlacements();
+
+} // namespace openr
@@ -7,9 +7,11 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <boost/serialization/strong_typedef.hpp>
 
@@ -37,6 +39,14 @@ BOOST_STRONG_TYPEDEF(std::string, AdjacencyDbMarker);
 BOOST_STRONG_TYPEDEF(std::string, PrefixDbMarker);
 BOOST_STRONG_TYPEDEF(std::string, AllocPrefixMarker);
 
+// Memory pressure as seen by Watchdog. Under pressure modules shed memory
+// they can rebuild on demand and pause non-critical work
+enum class MemoryPressure {
+  NONE = 0,
+  MODERATE = 1,
+  SEVERE = 2,
+};
+
 // KvStore Initial Sync Event send from KvStore to LinkMonitor
 // To signal adjancency UP event propagation
 struct KvStoreSyncEvent {
@@ -52,4 +62,36 @@ struct KvStoreSyncEvent {
   }
 };
 
+// Interface database published by LinkMonitor to Spark and Fib. Snapshot is
+// immutable and shared by all readers instead of being copied for each one.
+// Delta lists interfaces changed since previous update, so that readers only
+// need to look at those.
+struct InterfaceDatabaseUpdate {
+  std::shared_ptr<const thrift::InterfaceDatabase> snapshot;
+
+  // If false, delta is not known (e.g. first update) and readers must process
+  // the whole snapshot
+  bool isDelta{false};
+
+  // Interfaces added or changed, present in snapshot
+  std::vector<std::string> updatedInterfaces;
+
+  // Interfaces removed, absent from snapshot
+  std::vector<std::string> removedInterfaces;
+
+  InterfaceDatabaseUpdate() = default;
+
+  // Update without delta from a full interface database
+  /* implicit */ InterfaceDatabaseUpdate(thrift::InterfaceDatabase ifDb)
+      : snapshot(std::make_shared<const thrift::InterfaceDatabase>(
+            std::move(ifDb))) {}
+};
+
+// Oper state change of a single interface, sent by LinkMonitor to Fib as soon
+// as it learns about it, ahead of the throttled interface database
+struct InterfaceStatusEvent {
+  std::string ifName;
+  bool isUp{false};
+};
+
 } // namespace openr
@@ -7,14 +7,19 @@
 
 #include "Util.h"
 
+#include <algorithm>
 #include <ifaddrs.h>
+#include <map>
 #include <net/if.h>
 #include <netinet/in.h>
+#include <set>
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include <fbzmq/zmq/Common.h>
+#include <folly/compression/Compression.h>
+#include <folly/hash/SpookyHashV2.h>
 
 namespace openr {
 
@@ -23,6 +28,27 @@ KeyPrefix::KeyPrefix(std::vector<std::string> const& keyPrefixList) {
   if (keyPrefixList.empty()) {
     return;
   }
+
+  const bool allLiteral = std::all_of(
+      keyPrefixList.begin(), keyPrefixList.end(), [](std::string const& p) {
+        return p.find_first_of("\\^$.|?*+()[]{}") == std::string::npos;
+      });
+  if (allLiteral) {
+    // keep shortest prefixes only, longer ones sort right after them
+    std::vector<std::string> prefixes(keyPrefixList);
+    std::sort(prefixes.begin(), prefixes.end());
+    literalPrefixes_.emplace();
+    for (auto& prefix : prefixes) {
+      if (literalPrefixes_->empty() or
+          prefix.compare(
+              0, literalPrefixes_->back().size(), literalPrefixes_->back()) !=
+              0) {
+        literalPrefixes_->emplace_back(std::move(prefix));
+      }
+    }
+    return;
+  }
+
   re2::RE2::Options re2Options;
   re2Options.set_case_sensitive(true);
   keyPrefix_ =
@@ -45,11 +71,17 @@ KeyPrefix::KeyPrefix(std::vector<std::string> const& keyPrefixList) {
 // match the key with the list of prefixes
 bool
 KeyPrefix::keyMatch(std::string const& key) const {
+  if (literalPrefixes_) {
+    // only the greatest prefix not greater than key can be a prefix of it
+    auto it = std::upper_bound(
+        literalPrefixes_->begin(), literalPrefixes_->end(), key);
+    return it != literalPrefixes_->begin() and
+        key.compare(0, std::prev(it)->size(), *std::prev(it)) == 0;
+  }
   if (!keyPrefix_) {
     return true;
   }
-  std::vector<int> matches;
-  return keyPrefix_->Match(key, &matches);
+  return keyPrefix_->Match(key, nullptr);
 }
 
 PrefixKey::PrefixKey(
@@ -435,25 +467,163 @@ getDurationBetweenPerfEvents(
   return std::chrono::milliseconds(second - first);
 }
 
-template <class T>
+std::vector<PerfEventsStage>
+getPerfEventsStages(const thrift::PerfEvents& perfEvents) noexcept {
+  const auto& events = *perfEvents.events_ref();
+  std::vector<PerfEventsStage> stages;
+  for (size_t i = 1; i < events.size(); ++i) {
+    const auto& first = events.at(i - 1);
+    const auto& second = events.at(i);
+    stages.emplace_back(PerfEventsStage{
+        *first.eventDescr_ref(),
+        *second.eventDescr_ref(),
+        *second.nodeName_ref(),
+        *first.unixTs_ref(),
+        std::chrono::milliseconds(
+            *second.unixTs_ref() - *first.unixTs_ref())});
+  }
+  return stages;
+}
+
+size_t
+getHeapBytes(const std::string& str) {
+  // short strings are stored inline
+  return str.capacity() > 15 ? str.capacity() + 1 : 0;
+}
+
+size_t
+getHeapBytes(const thrift::BinaryAddress& addr) {
+  size_t bytes = getHeapBytes(*addr.addr_ref());
+  if (addr.ifName_ref().has_value()) {
+    bytes += getHeapBytes(*addr.ifName_ref());
+  }
+  return bytes;
+}
+
+size_t
+getHeapBytes(const thrift::IpPrefix& prefix) {
+  return getHeapBytes(*prefix.prefixAddress_ref());
+}
+
+size_t
+getHeapBytes(const thrift::NextHopThrift& nextHop) {
+  size_t bytes = getHeapBytes(*nextHop.address_ref());
+  if (nextHop.mplsAction_ref().has_value() and
+      nextHop.mplsAction_ref()->pushLabels_ref().has_value()) {
+    bytes += nextHop.mplsAction_ref()->pushLabels_ref()->capacity() *
+        sizeof(int32_t);
+  }
+  if (nextHop.area_ref().has_value()) {
+    bytes += getHeapBytes(*nextHop.area_ref());
+  }
+  if (nextHop.neighborNodeName_ref().has_value()) {
+    bytes += getHeapBytes(*nextHop.neighborNodeName_ref());
+  }
+  return bytes;
+}
+
+namespace {
+
+template <class Route>
+size_t
+getNextHopsHeapBytes(const Route& route) {
+  size_t bytes =
+      route.nextHops_ref()->capacity() * sizeof(thrift::NextHopThrift);
+  for (const auto& nextHop : *route.nextHops_ref()) {
+    bytes += getHeapBytes(nextHop);
+  }
+  return bytes;
+}
+
+} // namespace
+
+size_t
+getHeapBytes(const thrift::UnicastRoute& route) {
+  size_t bytes = getHeapBytes(*route.dest_ref()) + getNextHopsHeapBytes(route);
+  if (route.data_ref().has_value()) {
+    bytes += getHeapBytes(*route.data_ref());
+  }
+  return bytes;
+}
+
+size_t
+getHeapBytes(const thrift::MplsRoute& route) {
+  return getNextHopsHeapBytes(route);
+}
+
+size_t
+getHeapBytes(const thrift::AdjacencyDatabase& adjDb) {
+  size_t bytes = getHeapBytes(*adjDb.thisNodeName_ref()) +
+      getHeapBytes(*adjDb.area_ref()) +
+      adjDb.adjacencies_ref()->capacity() * sizeof(thrift::Adjacency);
+  for (const auto& adj : *adjDb.adjacencies_ref()) {
+    bytes += getHeapBytes(*adj.otherNodeName_ref()) +
+        getHeapBytes(*adj.ifName_ref()) + getHeapBytes(*adj.otherIfName_ref()) +
+        getHeapBytes(*adj.nextHopV4_ref()) + getHeapBytes(*adj.nextHopV6_ref());
+  }
+  return bytes;
+}
+
+size_t
+getHeapBytes(const thrift::PrefixEntry& prefixEntry) {
+  size_t bytes = getHeapBytes(*prefixEntry.prefix_ref());
+  for (const auto& tag : *prefixEntry.tags_ref()) {
+    bytes += kTreeNodeBytes + sizeof(tag) + getHeapBytes(tag);
+  }
+  bytes += prefixEntry.area_stack_ref()->capacity() * sizeof(std::string);
+  for (const auto& area : *prefixEntry.area_stack_ref()) {
+    bytes += getHeapBytes(area);
+  }
+  if (prefixEntry.data_ref().has_value()) {
+    bytes += getHeapBytes(*prefixEntry.data_ref());
+  }
+  return bytes;
+}
+
+size_t
+getHeapBytes(const thrift::Value& value) {
+  size_t bytes = getHeapBytes(*value.originatorId_ref());
+  if (value.value_ref().has_value()) {
+    bytes += getHeapBytes(*value.value_ref());
+  }
+  return bytes;
+}
+
+namespace {
+
+// SpookyHash of version, originatorId and value, each delimited so that
+// bytes can't shift between them
 int64_t
 generateHashImpl(
-    const int64_t version, const std::string& originatorId, const T& value) {
-  size_t seed = 0;
-  boost::hash_combine(seed, version);
-  boost::hash_combine(seed, originatorId);
-  if (value.has_value()) {
-    boost::hash_combine(seed, value.value());
+    const int64_t version,
+    const std::string& originatorId,
+    const std::string* value) {
+  folly::hash::SpookyHashV2 spooky;
+  spooky.Init(0, 0);
+  spooky.Update(&version, sizeof(version));
+  const uint64_t originatorIdLen = originatorId.size();
+  spooky.Update(&originatorIdLen, sizeof(originatorIdLen));
+  spooky.Update(originatorId.data(), originatorId.size());
+  const uint8_t hasValue = value ? 1 : 0;
+  spooky.Update(&hasValue, sizeof(hasValue));
+  if (value) {
+    spooky.Update(value->data(), value->size());
   }
-  return static_cast<int64_t>(seed);
+  uint64_t hash1{0};
+  uint64_t hash2{0};
+  spooky.Final(&hash1, &hash2);
+  return static_cast<int64_t>(hash1);
 }
 
+} // namespace
+
 int64_t
 generateHash(
     const int64_t version,
     const std::string& originatorId,
     const std::optional<std::string>& value) {
-  return generateHashImpl(version, originatorId, value);
+  return generateHashImpl(
+      version, originatorId, value.has_value() ? &value.value() : nullptr);
 }
 
 int64_t
@@ -461,7 +631,68 @@ generateHash(
     const int64_t version,
     const std::string& originatorId,
     const apache::thrift::optional_field_ref<const std::string&> value) {
-  return generateHashImpl(version, originatorId, value);
+  return generateHashImpl(
+      version, originatorId, value.has_value() ? &value.value() : nullptr);
+}
+
+int64_t
+generateHash(const thrift::Value& value) {
+  if (not value.value_ref().has_value()) {
+    return generateHashImpl(
+        *value.version_ref(), *value.originatorId_ref(), nullptr);
+  }
+  std::string buf;
+  return generateHashImpl(
+      *value.version_ref(),
+      *value.originatorId_ref(),
+      &getUncompressedValue(value, buf));
+}
+
+namespace {
+
+folly::io::Codec&
+getValueCodec() {
+  // codecs keep state between calls, one per thread
+  thread_local auto codec = folly::io::getCodec(folly::io::CodecType::ZSTD);
+  return *codec;
+}
+
+} // namespace
+
+bool
+compressValue(thrift::Value& value) {
+  if (not value.value_ref().has_value() or
+      value.compressed_ref().value_or(false)) {
+    return false;
+  }
+  auto compressed = getValueCodec().compress(*value.value_ref());
+  if (compressed.size() >= value.value_ref()->size()) {
+    return false;
+  }
+  value.value_ref() = std::move(compressed);
+  value.compressed_ref() = true;
+  return true;
+}
+
+void
+decompressValue(thrift::Value& value) {
+  if (not value.compressed_ref().value_or(false)) {
+    return;
+  }
+  if (value.value_ref().has_value()) {
+    value.value_ref() = getValueCodec().uncompress(*value.value_ref());
+  }
+  value.compressed_ref().reset();
+}
+
+const std::string&
+getUncompressedValue(const thrift::Value& value, std::string& buf) {
+  CHECK(value.value_ref().has_value());
+  if (not value.compressed_ref().value_or(false)) {
+    return *value.value_ref();
+  }
+  buf = getValueCodec().uncompress(*value.value_ref());
+  return buf;
 }
 
 std::string
@@ -590,6 +821,97 @@ findDeltaRoutes(
   return routeDbDelta;
 }
 
+namespace {
+
+// Merge routes to update and delete of later delta into those of earlier one
+template <typename Key, typename Route, typename GetKey>
+void
+mergeRoutes(
+    std::vector<Route>& toUpdate,
+    std::vector<Key>& toDelete,
+    std::vector<Route>&& laterToUpdate,
+    std::vector<Key>&& laterToDelete,
+    GetKey getKey) {
+  std::map<Key, Route> routes;
+  for (auto& route : toUpdate) {
+    auto key = getKey(route);
+    routes.insert_or_assign(std::move(key), std::move(route));
+  }
+  std::set<Key> deletes(toDelete.begin(), toDelete.end());
+
+  for (auto& key : laterToDelete) {
+    routes.erase(key);
+    deletes.emplace(std::move(key));
+  }
+  for (auto& route : laterToUpdate) {
+    auto key = getKey(route);
+    deletes.erase(key);
+    routes.insert_or_assign(std::move(key), std::move(route));
+  }
+
+  toUpdate.clear();
+  for (auto& kv : routes) {
+    toUpdate.emplace_back(std::move(kv.second));
+  }
+  toDelete.assign(deletes.begin(), deletes.end());
+}
+
+} // namespace
+
+void
+mergeRouteDatabaseDelta(
+    thrift::RouteDatabaseDelta& delta,
+    thrift::RouteDatabaseDelta&& laterDelta) {
+  mergeRoutes(
+      *delta.unicastRoutesToUpdate_ref(),
+      *delta.unicastRoutesToDelete_ref(),
+      std::move(*laterDelta.unicastRoutesToUpdate_ref()),
+      std::move(*laterDelta.unicastRoutesToDelete_ref()),
+      [](const thrift::UnicastRoute& route) { return route.dest; });
+  mergeRoutes(
+      *delta.mplsRoutesToUpdate_ref(),
+      *delta.mplsRoutesToDelete_ref(),
+      std::move(*laterDelta.mplsRoutesToUpdate_ref()),
+      std::move(*laterDelta.mplsRoutesToDelete_ref()),
+      [](const thrift::MplsRoute& route) { return route.topLabel; });
+  if (laterDelta.perfEvents_ref().has_value()) {
+    delta.perfEvents_ref() = std::move(*laterDelta.perfEvents_ref());
+  }
+}
+
+bool
+mergeCompactRouteDatabaseDelta(
+    thrift::CompactRouteDatabaseDelta& delta,
+    thrift::CompactRouteDatabaseDelta&& laterDelta) {
+  // routes of delta may refer to groups no longer valid after later one
+  if (*laterDelta.resetNextHopGroups_ref()) {
+    return false;
+  }
+  for (auto& [groupId, nextHops] : *laterDelta.nextHopGroups_ref()) {
+    delta.nextHopGroups_ref()->emplace(groupId, std::move(nextHops));
+  }
+  mergeRoutes(
+      *delta.unicastRoutesToUpdate_ref(),
+      *delta.unicastRoutesToDelete_ref(),
+      std::move(*laterDelta.unicastRoutesToUpdate_ref()),
+      std::move(*laterDelta.unicastRoutesToDelete_ref()),
+      [](const thrift::CompactUnicastRoute& route) {
+        return *route.dest_ref();
+      });
+  mergeRoutes(
+      *delta.mplsRoutesToUpdate_ref(),
+      *delta.mplsRoutesToDelete_ref(),
+      std::move(*laterDelta.mplsRoutesToUpdate_ref()),
+      std::move(*laterDelta.mplsRoutesToDelete_ref()),
+      [](const thrift::CompactMplsRoute& route) {
+        return *route.topLabel_ref();
+      });
+  if (laterDelta.perfEvents_ref().has_value()) {
+    delta.perfEvents_ref() = std::move(*laterDelta.perfEvents_ref());
+  }
+  return true;
+}
+
 thrift::BuildInfo
 getBuildInfoThrift() noexcept {
   return thrift::BuildInfo(
@@ -792,6 +1114,88 @@ createAdjDb(
   return adjDb;
 }
 
+namespace {
+using AdjKey = std::pair<std::string, std::string>;
+
+AdjKey
+getAdjKey(const thrift::Adjacency& adj) {
+  return {*adj.otherNodeName_ref(), *adj.ifName_ref()};
+}
+} // namespace
+
+thrift::AdjacencyDatabaseDelta
+createAdjDbDelta(
+    const thrift::AdjacencyDatabase& baseAdjDb,
+    const thrift::AdjacencyDatabase& adjDb) {
+  thrift::AdjacencyDatabaseDelta delta;
+  *delta.thisNodeName_ref() = *adjDb.thisNodeName_ref();
+  delta.perfEvents_ref().copy_from(adjDb.perfEvents_ref());
+
+  std::map<AdjKey, const thrift::Adjacency*> baseAdjs;
+  for (const auto& adj : *baseAdjDb.adjacencies_ref()) {
+    baseAdjs.emplace(getAdjKey(adj), &adj);
+  }
+  for (const auto& adj : *adjDb.adjacencies_ref()) {
+    auto it = baseAdjs.find(getAdjKey(adj));
+    if (it == baseAdjs.end()) {
+      delta.updatedAdjacencies_ref()->emplace_back(adj);
+      continue;
+    }
+    if (*it->second != adj) {
+      delta.updatedAdjacencies_ref()->emplace_back(adj);
+    }
+    baseAdjs.erase(it);
+  }
+  // whatever is left got removed
+  for (const auto& [_, adj] : baseAdjs) {
+    thrift::Adjacency removedAdj;
+    *removedAdj.otherNodeName_ref() = *adj->otherNodeName_ref();
+    *removedAdj.ifName_ref() = *adj->ifName_ref();
+    delta.removedAdjacencies_ref()->emplace_back(std::move(removedAdj));
+  }
+  return delta;
+}
+
+thrift::AdjacencyDatabase
+applyAdjDbDelta(
+    thrift::AdjacencyDatabase adjDb,
+    const thrift::AdjacencyDatabaseDelta& delta) {
+  std::map<AdjKey, const thrift::Adjacency*> updatedAdjs;
+  for (const auto& adj : *delta.updatedAdjacencies_ref()) {
+    updatedAdjs.emplace(getAdjKey(adj), &adj);
+  }
+  std::set<AdjKey> removedAdjs;
+  for (const auto& adj : *delta.removedAdjacencies_ref()) {
+    removedAdjs.emplace(getAdjKey(adj));
+  }
+
+  std::vector<thrift::Adjacency> adjs;
+  adjs.reserve(adjDb.adjacencies_ref()->size() + updatedAdjs.size());
+  for (auto& adj : *adjDb.adjacencies_ref()) {
+    auto const adjKey = getAdjKey(adj);
+    if (removedAdjs.count(adjKey)) {
+      continue;
+    }
+    auto it = updatedAdjs.find(adjKey);
+    if (it == updatedAdjs.end()) {
+      adjs.emplace_back(std::move(adj));
+      continue;
+    }
+    adjs.emplace_back(*it->second);
+    updatedAdjs.erase(it);
+  }
+  // remaining ones are new adjacencies
+  for (const auto& adj : *delta.updatedAdjacencies_ref()) {
+    if (updatedAdjs.count(getAdjKey(adj))) {
+      adjs.emplace_back(adj);
+    }
+  }
+
+  *adjDb.adjacencies_ref() = std::move(adjs);
+  adjDb.perfEvents_ref().copy_from(delta.perfEvents_ref());
+  return adjDb;
+}
+
 thrift::PrefixDatabase
 createPrefixDb(
     const std::string& nodeName,
@@ -1038,14 +1442,73 @@ createMplsRoutesWithSelectedNextHopsMap(
   return newRoutes;
 }
 
+KvStoreKeyView
+parseKvStoreKey(std::string_view key) {
+  static constexpr std::pair<folly::StringPiece, KvStoreKeyType> kMarkers[] = {
+      {Constants::kAdjDbMarker, KvStoreKeyType::ADJ_DB},
+      {Constants::kAdjDbDeltaMarker, KvStoreKeyType::ADJ_DB_DELTA},
+      {Constants::kPrefixDbMarker, KvStoreKeyType::PREFIX_DB},
+      {Constants::kPrefixAllocMarker, KvStoreKeyType::PREFIX_ALLOC},
+      {Constants::kFibTimeMarker, KvStoreKeyType::FIB_TIME},
+  };
+
+  KvStoreKeyView view;
+  const folly::StringPiece keyPiece(key.data(), key.size());
+  for (auto const& [marker, type] : kMarkers) {
+    if (keyPiece.startsWith(marker)) {
+      view.type = type;
+      break;
+    }
+  }
+
+  // node name is the second field
+  auto const nodeStart = key.find(':');
+  if (nodeStart == std::string_view::npos) {
+    return view;
+  }
+  auto rest = key.substr(nodeStart + 1);
+  auto const nodeEnd = rest.find(':');
+  view.nodeName = rest.substr(0, nodeEnd);
+  if (view.type != KvStoreKeyType::PREFIX_DB or
+      nodeEnd == std::string_view::npos) {
+    return view;
+  }
+
+  // per prefix key
+  rest = rest.substr(nodeEnd + 1);
+  auto const areaEnd = rest.find(':');
+  if (areaEnd == std::string_view::npos) {
+    return view;
+  }
+  auto const prefix = rest.substr(areaEnd + 1);
+  if (prefix.size() < 2 or prefix.front() != '[' or prefix.back() != ']') {
+    return view;
+  }
+  view.area = rest.substr(0, areaEnd);
+  view.prefix = prefix.substr(1, prefix.size() - 2);
+  return view;
+}
+
+std::optional<folly::CIDRNetwork>
+KvStoreKeyView::getPrefixNetwork() const {
+  auto const slash = prefix.rfind('/');
+  if (slash == std::string_view::npos) {
+    return std::nullopt;
+  }
+  auto const addr = folly::IPAddress::tryFromString(
+      folly::StringPiece(prefix.data(), slash));
+  auto const plen = folly::tryTo<uint8_t>(
+      folly::StringPiece(prefix.data() + slash + 1, prefix.size() - slash - 1));
+  if (addr.hasError() or plen.hasError() or
+      plen.value() > addr.value().bitCount()) {
+    return std::nullopt;
+  }
+  return folly::CIDRNetwork{addr.value().mask(plen.value()), plen.value()};
+}
+
 std::string
 getNodeNameFromKey(const std::string& key) {
-  std::vector<std::string> split;
-  folly::split(Constants::kPrefixNameSeparator.toString(), key, split);
-  if (split.size() < 2) {
-    return "";
-  }
-  return split[1];
+  return std::string(parseKvStoreKey(key).nodeName);
 }
 
 std::string
@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include <optional>
 #include <random>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <boost/functional/hash.hpp>
@@ -67,14 +69,26 @@ namespace openr {
 
 /**
  * Class to store re2 objects, provides API to match string with regex
+ *
+ * Prefixes without regex metacharacters are the common case and are matched
+ * by binary search over the sorted prefixes instead.
  */
 class KeyPrefix {
  public:
   explicit KeyPrefix(std::vector<std::string> const& keyPrefixList);
   bool keyMatch(std::string const& key) const;
 
+  // sorted literal prefixes, none of them a prefix of another, if all key
+  // prefixes are literal. Keys matching are the ones starting with any.
+  std::optional<std::vector<std::string>> const&
+  getLiteralPrefixes() const {
+    return literalPrefixes_;
+  }
+
  private:
   std::unique_ptr<re2::RE2::Set> keyPrefix_;
+
+  std::optional<std::vector<std::string>> literalPrefixes_;
 };
 
 /**
@@ -136,6 +150,37 @@ class PrefixKey {
   std::string prefixKeyString_;
 };
 
+// Type of a KvStore key, by its marker
+enum class KvStoreKeyType {
+  ADJ_DB,
+  ADJ_DB_DELTA,
+  PREFIX_DB,
+  PREFIX_ALLOC,
+  FIB_TIME,
+  OTHER,
+};
+
+/**
+ * Parts of a KvStore key "<marker><node>[:...]", as views into the parsed
+ * key which must outlive it. Per prefix keys
+ * "<prefix marker><node>:<area>:[<addr>/<plen>]" have area and prefix set,
+ * other keys have them empty.
+ */
+struct KvStoreKeyView {
+  KvStoreKeyType type{KvStoreKeyType::OTHER};
+  // same as getNodeNameFromKey()
+  std::string_view nodeName;
+  std::string_view area;
+  // "<addr>/<plen>"
+  std::string_view prefix;
+
+  // network of `prefix`, std::nullopt if not a valid per prefix key
+  std::optional<folly::CIDRNetwork> getPrefixNetwork() const;
+};
+
+// Parse KvStore key without allocating, for classifying keys of publications
+KvStoreKeyView parseKvStoreKey(std::string_view key);
+
 /**
  * Utility function to execute shell command and return true/false as
  * indication of it's success
@@ -231,9 +276,45 @@ getDurationBetweenPerfEvents(
     const std::string& firstName,
     const std::string& secondName) noexcept;
 
+/**
+ * Stage of convergence between two consecutive perf events, named after the
+ * events it starts and ends with
+ */
+struct PerfEventsStage {
+  std::string firstEvent;
+  std::string secondEvent;
+  // node of the event the stage ends with
+  std::string nodeName;
+  int64_t startUnixTs{0};
+  std::chrono::milliseconds duration{0};
+};
+std::vector<PerfEventsStage> getPerfEventsStages(
+    const thrift::PerfEvents& perfEvents) noexcept;
+
+/**
+ * Rough estimates of heap memory held by objects, i.e. not counting
+ * sizeof(object) itself. Used for per-structure memory counters, which are
+ * meant to tell which structure grows rather than to add up to the RSS.
+ */
+// overhead of an entry of std::unordered_map/set, besides the entry itself
+constexpr size_t kHashNodeBytes = 2 * sizeof(void*);
+// overhead of an entry of std::map/set, besides the entry itself
+constexpr size_t kTreeNodeBytes = 4 * sizeof(void*);
+size_t getHeapBytes(const std::string& str);
+size_t getHeapBytes(const thrift::BinaryAddress& addr);
+size_t getHeapBytes(const thrift::IpPrefix& prefix);
+size_t getHeapBytes(const thrift::NextHopThrift& nextHop);
+size_t getHeapBytes(const thrift::UnicastRoute& route);
+size_t getHeapBytes(const thrift::MplsRoute& route);
+size_t getHeapBytes(const thrift::AdjacencyDatabase& adjDb);
+size_t getHeapBytes(const thrift::PrefixEntry& prefixEntry);
+size_t getHeapBytes(const thrift::Value& value);
+
 /**
  * Generate hash for each keyval pair
- * as a abstract of version number, originator and values
+ * as a abstract of version number, originator and values.
+ * Computed once by KvStore of the originator and carried along with the
+ * value, peers keep and compare it rather than recomputing it
  */
 int64_t generateHash(
     const int64_t version,
@@ -245,6 +326,31 @@ int64_t generateHash(
     const std::string& originatorId,
     const apache::thrift::optional_field_ref<const std::string&> value);
 
+/**
+ * Hash of a thrift::Value as above, of its uncompressed value if compressed
+ */
+int64_t generateHash(const thrift::Value& value);
+
+/**
+ * Compress `value` of a thrift::Value with zstd in place and flag it as
+ * compressed, unless compression doesn't make it smaller. Hash is left as is.
+ * Returns whether the value got compressed.
+ */
+bool compressValue(thrift::Value& value);
+
+/**
+ * Decompress `value` of a thrift::Value in place if it is compressed.
+ * Throws std::runtime_error on corrupt value.
+ */
+void decompressValue(thrift::Value& value);
+
+/**
+ * `value` of a thrift::Value, decompressed into `buf` if it is compressed.
+ * Throws as decompressValue().
+ */
+const std::string& getUncompressedValue(
+    const thrift::Value& value, std::string& buf);
+
 /**
  * TO BE DEPRECATED SOON: Backward compatible with empty remoteIfName
  * Translate remote interface name from local interface name
@@ -261,6 +367,22 @@ thrift::RouteDatabaseDelta findDeltaRoutes(
     const thrift::RouteDatabase& newRouteDb,
     const thrift::RouteDatabase& oldRouteDb);
 
+/**
+ * Merge later delta into delta, i.e. the result has the same effect as
+ * applying both of them in order.
+ */
+void mergeRouteDatabaseDelta(
+    thrift::RouteDatabaseDelta& delta, thrift::RouteDatabaseDelta&& laterDelta);
+
+/**
+ * Same as mergeRouteDatabaseDelta, for compact encoding of deltas of the same
+ * stream. Returns false, leaving both unchanged, if later delta resets
+ * next-hop groups and they can't be merged.
+ */
+bool mergeCompactRouteDatabaseDelta(
+    thrift::CompactRouteDatabaseDelta& delta,
+    thrift::CompactRouteDatabaseDelta&& laterDelta);
+
 thrift::BuildInfo getBuildInfoThrift() noexcept;
 
 /**
@@ -382,6 +504,17 @@ thrift::AdjacencyDatabase createAdjDb(
     bool overLoadBit = false,
     const std::string& area = openr::thrift::KvStore_constants::kDefaultArea());
 
+// Changes of the adjacencies in `adjDb` against the ones in `baseAdjDb`.
+// Node attributes are not part of a delta.
+thrift::AdjacencyDatabaseDelta createAdjDbDelta(
+    const thrift::AdjacencyDatabase& baseAdjDb,
+    const thrift::AdjacencyDatabase& adjDb);
+
+// Apply changes of the delta on top of the adjacency database it is based on
+thrift::AdjacencyDatabase applyAdjDbDelta(
+    thrift::AdjacencyDatabase adjDb,
+    const thrift::AdjacencyDatabaseDelta& delta);
+
 thrift::PrefixDatabase createPrefixDb(
     const std::string& nodeName,
     const std::vector<thrift::PrefixEntry>& prefixEntries = {},
@@ -494,6 +627,50 @@ template <typename Key, typename MetricsWrapper>
 std::set<Key> selectBestPrefixMetrics(
     std::unordered_map<Key, MetricsWrapper> const& prefixes);
 
+/**
+ * `thrift::PrefixMetrics` packed into fixed width integers, ordered the way
+ * best route selection prefers them (higher is better). Comparing keys takes
+ * two integer comparisons instead of three signed field accesses.
+ */
+struct PrefixMetricsKey {
+  // path-preference in the upper and source-preference in the lower half
+  uint64_t preferences{0};
+  // distance, inverted as lower is preferred
+  uint32_t distance{0};
+
+  bool
+  operator==(PrefixMetricsKey const& other) const {
+    return preferences == other.preferences and distance == other.distance;
+  }
+
+  bool
+  operator<(PrefixMetricsKey const& other) const {
+    return preferences < other.preferences or
+        (preferences == other.preferences and distance < other.distance);
+  }
+};
+
+inline PrefixMetricsKey
+packPrefixMetrics(
+    int32_t pathPreference, int32_t sourcePreference, int32_t distance) {
+  // flipping the sign bit keeps the order of signed values as unsigned
+  auto const toOrdered = [](int32_t value) {
+    return static_cast<uint32_t>(value) ^ 0x80000000u;
+  };
+  return PrefixMetricsKey{
+      (static_cast<uint64_t>(toOrdered(pathPreference)) << 32) |
+          toOrdered(sourcePreference),
+      ~toOrdered(distance)};
+}
+
+inline PrefixMetricsKey
+packPrefixMetrics(thrift::PrefixMetrics const& metrics) {
+  return packPrefixMetrics(
+      *metrics.path_preference_ref(),
+      *metrics.source_preference_ref(),
+      *metrics.distance_ref());
+}
+
 // Deterministic choose one as best path from multipaths. Used in Decision.
 // Choose local if local node is a part of the multipaths.
 // Otherwise choose smallest key: allNodeAreas.begin().
@@ -548,25 +725,21 @@ template <typename Key, typename MetricsWrapper>
 std::set<Key>
 selectBestPrefixMetrics(
     std::unordered_map<Key, MetricsWrapper> const& prefixes) {
-  // Leveraging tuple for ease of comparision
-  std::tuple<int32_t, int32_t, int32_t> bestMetricsTuple{0, 0, 0};
+  PrefixMetricsKey bestMetricsKey = packPrefixMetrics(0, 0, 0);
 
   std::set<Key> bestKeys;
   for (auto& [key, metricsWrapper] : prefixes) {
-    auto& metrics = metricsWrapper.metrics_ref().value();
-    std::tuple<int32_t, int32_t, int32_t> metricsTuple{
-        metrics.path_preference_ref().value(), /* prefer-higher */
-        metrics.source_preference_ref().value(), /* prefer-higher */
-        metrics.distance_ref().value() * -1 /* prefer-lower */};
+    auto const metricsKey =
+        packPrefixMetrics(metricsWrapper.metrics_ref().value());
 
     // Skip if this is less than best metrics we've seen so far
-    if (metricsTuple < bestMetricsTuple) {
+    if (metricsKey < bestMetricsKey) {
       continue;
     }
 
     // Clear set and update best metric if this is a new best metric
-    if (metricsTuple > bestMetricsTuple) {
-      bestMetricsTuple = metricsTuple;
+    if (bestMetricsKey < metricsKey) {
+      bestMetricsKey = metricsKey;
       bestKeys.clear();
     }
 
@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "openr/common/WheelTimeout.h"
+
+#include <glog/logging.h>
+
+namespace openr {
+
+WheelTimeout::WheelTimeout(
+    folly::HHWheelTimer& wheelTimer, folly::Function<void()> cb)
+    : wheelTimer_(wheelTimer), cb_(std::move(cb)) {
+  CHECK(cb_);
+}
+
+std::unique_ptr<WheelTimeout>
+WheelTimeout::make(folly::EventBase& evb, folly::Function<void()> cb) {
+  return std::make_unique<WheelTimeout>(evb.timer(), std::move(cb));
+}
+
+std::unique_ptr<WheelTimeout>
+WheelTimeout::make(
+    folly::HHWheelTimer& wheelTimer, folly::Function<void()> cb) {
+  return std::make_unique<WheelTimeout>(wheelTimer, std::move(cb));
+}
+
+void
+WheelTimeout::scheduleTimeout(std::chrono::milliseconds timeout) {
+  // re-scheduling moves timeout to its new bucket
+  wheelTimer_.scheduleTimeout(this, timeout);
+}
+
+void
+WheelTimeout::timeoutExpired() noexcept {
+  // NOTE: callback may destroy this object, don't touch members after it
+  cb_();
+}
+
+} // namespace openr
@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include <folly/Function.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HHWheelTimer.h>
+
+namespace openr {
+
+/**
+ * Drop-in replacement for folly::AsyncTimeout for modules keeping many
+ * timers which get re-armed often, e.g. per neighbor hold timers.
+ *
+ * Instead of registering an event of its own with the event loop, timeout is
+ * kept in a bucket of event base's hashed wheel timer, which is driven by a
+ * single event. Scheduling, re-scheduling and cancelling are O(1) bucket
+ * moves. Timeouts are rounded up to the wheel tick (10ms by default).
+ *
+ * Destroying the object cancels the timeout.
+ */
+class WheelTimeout final : private folly::HHWheelTimer::Callback {
+ public:
+  WheelTimeout(folly::HHWheelTimer& wheelTimer, folly::Function<void()> cb);
+
+  ~WheelTimeout() override = default;
+
+  // Same as AsyncTimeout::make, create timeout on event base's wheel timer
+  static std::unique_ptr<WheelTimeout> make(
+      folly::EventBase& evb, folly::Function<void()> cb);
+
+  // Create timeout on given wheel timer, e.g. one of
+  // OpenrEventBase::getCoarseWheelTimer()
+  static std::unique_ptr<WheelTimeout> make(
+      folly::HHWheelTimer& wheelTimer, folly::Function<void()> cb);
+
+  // (Re-)schedule timeout to fire after given duration
+  void scheduleTimeout(std::chrono::milliseconds timeout);
+
+  void
+  cancelTimeout() {
+    folly::HHWheelTimer::Callback::cancelTimeout();
+  }
+
+  bool
+  isScheduled() const {
+    return folly::HHWheelTimer::Callback::isScheduled();
+  }
+
+ private:
+  void timeoutExpired() noexcept override;
+
+  void
+  callbackCanceled() noexcept override {}
+
+  folly::HHWheelTimer& wheelTimer_;
+  folly::Function<void()> cb_{nullptr};
+};
+
+} // namespace openr
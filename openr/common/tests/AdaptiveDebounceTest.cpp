@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <folly/io/async/EventBase.h>
+#include <openr/common/AdaptiveDebounce.h>
+
+namespace openr {
+
+TEST(AdaptiveDebounce, WaitAdaptsToLoad) {
+  folly::EventBase evb;
+
+  int numCalls{0};
+  const std::chrono::milliseconds minBackOff{10};
+  const std::chrono::milliseconds maxBackOff{100};
+  AdaptiveDebounce<std::chrono::milliseconds> debouncedFn(
+      &evb, minBackOff, maxBackOff, [&numCalls]() noexcept { ++numCalls; });
+
+  // single event is handled after min backoff
+  auto now = std::chrono::steady_clock::now();
+  debouncedFn.reportEvent(now);
+  EXPECT_EQ(minBackOff, debouncedFn.getLastWait());
+  EXPECT_EQ(maxBackOff, debouncedFn.getArrivalInterval());
+
+  // events while scheduled are batched
+  debouncedFn.reportEvent(now + std::chrono::milliseconds(2));
+  debouncedFn.reportEvent(now + std::chrono::milliseconds(4));
+  evb.loop();
+  EXPECT_EQ(1, numCalls);
+  debouncedFn.reportCallbackDuration(std::chrono::milliseconds(30));
+
+  // storm of events arriving faster than the callback runs waits for it
+  now += std::chrono::milliseconds(20);
+  debouncedFn.reportEvent(now);
+  EXPECT_LT(std::chrono::milliseconds(0), debouncedFn.getArrivalInterval());
+  EXPECT_GT(std::chrono::milliseconds(30), debouncedFn.getArrivalInterval());
+  EXPECT_EQ(std::chrono::milliseconds(30), debouncedFn.getLastWait());
+  evb.loop();
+  EXPECT_EQ(2, numCalls);
+
+  // wait is bounded by max backoff
+  debouncedFn.reportCallbackDuration(std::chrono::seconds(1));
+  now += std::chrono::milliseconds(20);
+  debouncedFn.reportEvent(now);
+  EXPECT_EQ(maxBackOff, debouncedFn.getLastWait());
+  evb.loop();
+  EXPECT_EQ(3, numCalls);
+
+  // quiet period resets to min backoff
+  now += maxBackOff * 2;
+  debouncedFn.reportEvent(now);
+  EXPECT_EQ(minBackOff, debouncedFn.getLastWait());
+  evb.loop();
+  EXPECT_EQ(4, numCalls);
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/CompactRouteDelta.h>
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/Util.h>
+
+namespace openr {
+
+namespace {
+
+const auto prefix1 = toIpPrefix("10.1.1.0/24");
+const auto prefix2 = toIpPrefix("10.2.2.0/24");
+const auto prefix3 = toIpPrefix("10.3.3.0/24");
+
+const auto nh1 = createNextHop(
+    toBinaryAddress(folly::IPAddress("fe80::1")), std::string("iface1"), 1);
+const auto nh2 = createNextHop(
+    toBinaryAddress(folly::IPAddress("fe80::2")), std::string("iface2"), 1);
+const auto mplsNh = createNextHop(
+    toBinaryAddress(folly::IPAddress("fe80::1")),
+    std::string("iface1"),
+    1,
+    createMplsAction(thrift::MplsActionCode::PHP));
+
+} // namespace
+
+TEST(CompactRouteDelta, EncodeDecode) {
+  CompactRouteDeltaEncoder encoder(10);
+  CompactRouteDeltaDecoder decoder;
+
+  thrift::RouteDatabaseDelta delta;
+  delta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix1, {nh1, nh2}));
+  auto routeWithBackup = createUnicastRoute(prefix2, {nh1, nh2});
+  routeWithBackup.backupNextHops_ref() =
+      std::vector<thrift::NextHopThrift>{nh1};
+  delta.unicastRoutesToUpdate_ref()->emplace_back(routeWithBackup);
+  delta.mplsRoutesToUpdate_ref()->emplace_back(createMplsRoute(100, {mplsNh}));
+  *delta.unicastRoutesToDelete_ref() = {prefix3};
+  *delta.mplsRoutesToDelete_ref() = {200};
+
+  // routes with the same next-hops share their group
+  auto compactDelta = encoder.encode(delta);
+  EXPECT_FALSE(*compactDelta.resetNextHopGroups_ref());
+  EXPECT_EQ(3, compactDelta.nextHopGroups_ref()->size());
+  EXPECT_EQ(3, encoder.getNumNextHopGroups());
+  EXPECT_EQ(delta, decoder.decode(std::move(compactDelta)));
+
+  // groups defined by earlier deltas are referred to only
+  thrift::RouteDatabaseDelta laterDelta;
+  laterDelta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix3, {nh1, nh2}));
+  compactDelta = encoder.encode(laterDelta);
+  EXPECT_EQ(0, compactDelta.nextHopGroups_ref()->size());
+  EXPECT_EQ(laterDelta, decoder.decode(std::move(compactDelta)));
+
+  // unknown groups are rejected
+  CompactRouteDeltaDecoder otherDecoder;
+  EXPECT_THROW(
+      otherDecoder.decode(encoder.encode(laterDelta)), std::invalid_argument);
+}
+
+TEST(CompactRouteDelta, ResetGroups) {
+  CompactRouteDeltaEncoder encoder(1);
+  CompactRouteDeltaDecoder decoder;
+
+  thrift::RouteDatabaseDelta delta;
+  delta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix1, {nh1}));
+  delta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix2, {nh2}));
+  auto compactDelta = encoder.encode(delta);
+  EXPECT_FALSE(*compactDelta.resetNextHopGroups_ref());
+  EXPECT_EQ(delta, decoder.decode(std::move(compactDelta)));
+
+  // groups are reset once beyond the limit and defined again as needed
+  thrift::RouteDatabaseDelta laterDelta;
+  laterDelta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix3, {nh1}));
+  compactDelta = encoder.encode(laterDelta);
+  EXPECT_TRUE(*compactDelta.resetNextHopGroups_ref());
+  EXPECT_EQ(1, compactDelta.nextHopGroups_ref()->size());
+  EXPECT_EQ(1, encoder.getNumNextHopGroups());
+  EXPECT_EQ(laterDelta, decoder.decode(std::move(compactDelta)));
+}
+
+TEST(CompactRouteDelta, Merge) {
+  CompactRouteDeltaEncoder encoder(10);
+
+  thrift::RouteDatabaseDelta delta;
+  delta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix1, {nh1}));
+  delta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix2, {nh1}));
+  thrift::RouteDatabaseDelta laterDelta;
+  laterDelta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix1, {nh2}));
+  *laterDelta.unicastRoutesToDelete_ref() = {prefix2};
+
+  // merged compact deltas decode to merged deltas
+  auto compactDelta = encoder.encode(delta);
+  EXPECT_TRUE(
+      mergeCompactRouteDatabaseDelta(compactDelta, encoder.encode(laterDelta)));
+  mergeRouteDatabaseDelta(delta, std::move(laterDelta));
+  CompactRouteDeltaDecoder decoder;
+  EXPECT_EQ(delta, decoder.decode(std::move(compactDelta)));
+
+  // delta resetting groups can't be merged
+  thrift::CompactRouteDatabaseDelta resetDelta;
+  *resetDelta.resetNextHopGroups_ref() = true;
+  compactDelta = encoder.encode(delta);
+  EXPECT_FALSE(
+      mergeCompactRouteDatabaseDelta(compactDelta, std::move(resetDelta)));
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
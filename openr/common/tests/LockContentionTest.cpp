@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <folly/Synchronized.h>
+#include <folly/synchronization/Baton.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/LockContention.h>
+
+namespace openr {
+
+TEST(LockContention, Uncontended) {
+  auto& contention = LockContention::get("test.uncontended");
+  EXPECT_EQ(&contention, &LockContention::get("test.uncontended"));
+
+  std::mutex mutex;
+  {
+    auto l = contention.lock(mutex);
+    EXPECT_TRUE(l.owns_lock());
+  }
+  folly::Synchronized<int> sync{0};
+  EXPECT_EQ(1, contention.withWLock(sync, [](int& val) { return ++val; }));
+
+  const auto counters = LockContention::getCounters();
+  EXPECT_EQ(2, counters.at("lock.test.uncontended.acquisitions"));
+  EXPECT_EQ(0, counters.at("lock.test.uncontended.contentions"));
+  EXPECT_EQ(0, counters.at("lock.test.uncontended.wait_us"));
+}
+
+TEST(LockContention, Contended) {
+  auto& contention = LockContention::get("test.contended");
+
+  // hold lock in another thread while locking it
+  std::mutex mutex;
+  folly::Baton<> locked;
+  std::thread holder([&]() {
+    auto l = contention.lock(mutex);
+    locked.post();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  });
+  locked.wait();
+  { auto l = contention.lock(mutex); }
+  holder.join();
+
+  const auto counters = LockContention::getCounters();
+  EXPECT_EQ(2, counters.at("lock.test.contended.acquisitions"));
+  EXPECT_EQ(1, counters.at("lock.test.contended.contentions"));
+  EXPECT_GT(counters.at("lock.test.contended.wait_us"), 0);
+}
+
+TEST(LockContention, ContendedSynchronized) {
+  auto& contention = LockContention::get("test.contended_synchronized");
+
+  folly::Synchronized<int> sync{0};
+  folly::Baton<> locked;
+  std::thread holder([&]() {
+    contention.withWLock(sync, [&](int& val) {
+      locked.post();
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      val = 1;
+    });
+  });
+  locked.wait();
+  // sees update of holder as it waited for it
+  EXPECT_EQ(1, contention.withWLock(sync, [](int& val) { return val; }));
+  holder.join();
+
+  const auto counters = LockContention::getCounters();
+  EXPECT_EQ(1, counters.at("lock.test.contended_synchronized.contentions"));
+  EXPECT_GT(counters.at("lock.test.contended_synchronized.wait_us"), 0);
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  return RUN_ALL_TESTS();
+}
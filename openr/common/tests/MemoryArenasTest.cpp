@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <memory>
+#include <thread>
+
+#include <folly/memory/Malloc.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/MemoryArenas.h>
+
+using namespace openr;
+
+namespace {
+
+std::optional<thrift::ModuleMemoryStats>
+findStats(const std::string& name) {
+  for (auto& stats : getModuleMemoryStats()) {
+    if (*stats.module_ref() == name) {
+      return stats;
+    }
+  }
+  return std::nullopt;
+}
+
+} // namespace
+
+TEST(MemoryArenasTest, AllocationsAccountedToModule) {
+  const size_t kAllocSize{16 * 1024 * 1024};
+  std::unique_ptr<char[]> buffer;
+
+  std::thread thread([&]() {
+    if (not bindModuleArena("Allocator")) {
+      return;
+    }
+    buffer = std::make_unique<char[]>(kAllocSize);
+  });
+  thread.join();
+
+  if (not folly::usingJEMalloc()) {
+    // nothing is accounted without jemalloc
+    EXPECT_EQ(std::nullopt, findStats("Allocator"));
+    return;
+  }
+
+  // memory stays accounted to the arena after the thread exited
+  auto stats = findStats("Allocator");
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_GE(*stats->allocated_bytes_ref(), kAllocSize);
+  EXPECT_GE(*stats->resident_bytes_ref(), kAllocSize);
+
+  // memory freed by another thread goes back to the allocating arena
+  buffer.reset();
+  stats = findStats("Allocator");
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_LT(*stats->allocated_bytes_ref(), kAllocSize);
+}
+
+TEST(MemoryArenasTest, HeapProfileRequiresProfiling) {
+  // tests are not started with MALLOC_CONF=prof:true
+  EXPECT_THROW(dumpHeapProfile(), std::runtime_error);
+}
+
+int
+main(int argc, char** argv) {
+  // Basic initialization
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
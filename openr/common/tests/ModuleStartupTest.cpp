@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+#include <folly/synchronization/Baton.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/ModuleStartup.h>
+
+using namespace openr;
+
+namespace {
+
+std::vector<std::string>
+getEventDescrs(const thrift::PerfEvents& perfEvents) {
+  std::vector<std::string> descrs;
+  for (auto const& event : *perfEvents.events_ref()) {
+    descrs.emplace_back(*event.eventDescr_ref());
+  }
+  return descrs;
+}
+
+size_t
+indexOf(const std::vector<std::string>& descrs, const std::string& descr) {
+  return std::find(descrs.begin(), descrs.end(), descr) - descrs.begin();
+}
+
+} // namespace
+
+TEST(ModuleStartupTest, InvalidGraph) {
+  ModuleStartup startup("node1");
+  startup.addModule("A", {}, []() {});
+  EXPECT_THROW(startup.addModule("A", {}, []() {}), std::invalid_argument);
+  EXPECT_THROW(startup.addModule("B", {"C"}, []() {}), std::invalid_argument);
+}
+
+/**
+ * Independent modules are started concurrently, dependents only after all
+ * of their dependencies
+ */
+TEST(ModuleStartupTest, StartOrder) {
+  ModuleStartup startup("node1");
+
+  // A and B block until both are starting, so they must run concurrently
+  folly::Baton<> aStarting, bStarting;
+  std::atomic<bool> aStarted{false}, bStarted{false};
+  startup.addModule("A", {}, [&]() {
+    aStarting.post();
+    bStarting.wait();
+    aStarted = true;
+  });
+  startup.addModule("B", {}, [&]() {
+    bStarting.post();
+    aStarting.wait();
+    bStarted = true;
+  });
+  startup.addModule("C", {"A", "B"}, [&]() {
+    EXPECT_TRUE(aStarted);
+    EXPECT_TRUE(bStarted);
+  });
+  startup.run(2);
+
+  const auto descrs = getEventDescrs(startup.getPerfEvents());
+  ASSERT_EQ(6, descrs.size());
+  EXPECT_LT(indexOf(descrs, "A_INIT_DONE"), indexOf(descrs, "C_INIT_START"));
+  EXPECT_LT(indexOf(descrs, "B_INIT_DONE"), indexOf(descrs, "C_INIT_START"));
+  EXPECT_EQ("C_INIT_DONE", descrs.back());
+  for (auto const& event : *startup.getPerfEvents().events_ref()) {
+    EXPECT_EQ("node1", *event.nodeName_ref());
+  }
+
+  // Recorded for the ctrl API
+  EXPECT_EQ(descrs, getEventDescrs(getModuleStartupPerfEvents()));
+}
+
+/**
+ * Dependents of a module failing to start are not started
+ */
+TEST(ModuleStartupTest, StartFailure) {
+  ModuleStartup startup("node1");
+  bool cStarted{false};
+  startup.addModule("A", {}, []() {});
+  startup.addModule("B", {"A"}, []() { throw std::runtime_error("B"); });
+  startup.addModule("C", {"B"}, [&]() { cStarted = true; });
+  EXPECT_THROW(startup.run(2), std::runtime_error);
+  EXPECT_FALSE(cStarted);
+
+  const auto descrs = getEventDescrs(startup.getPerfEvents());
+  EXPECT_EQ(
+      std::vector<std::string>({"A_INIT_START", "A_INIT_DONE", "B_INIT_START"}),
+      descrs);
+}
+
+int
+main(int argc, char** argv) {
+  // Basic initialization
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
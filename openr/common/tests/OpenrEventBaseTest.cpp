@@ -7,6 +7,7 @@
 
 #include <sys/eventfd.h>
 
+#include <fb303/ServiceData.h>
 #include <fbzmq/zmq/Context.h>
 #include <fbzmq/zmq/Socket.h>
 #include <folly/futures/Promise.h>
@@ -73,6 +74,47 @@ TEST(OpenrEventBaseTest, FiberTest) {
   EXPECT_TRUE(f.hasValue());
 }
 
+#if FOLLY_HAS_COROUTINES
+TEST(OpenrEventBaseTest, CoroTest) {
+  OpenrEventBase evb;
+
+  // test addCoroTask(), sleepCoro()
+  std::atomic<bool> slept{false};
+  auto sleepTask = [](OpenrEventBase& evb,
+                      std::atomic<bool>& slept) -> folly::coro::Task<void> {
+    EXPECT_TRUE(evb.getEvb()->isInEventBaseThread());
+    const auto start = std::chrono::steady_clock::now();
+    co_await evb.sleepCoro(std::chrono::milliseconds(100));
+    EXPECT_TRUE(evb.getEvb()->isInEventBaseThread());
+    EXPECT_LE(
+        std::chrono::milliseconds(100),
+        std::chrono::steady_clock::now() - start);
+    slept = true;
+  };
+  evb.addCoroTask(sleepTask(evb, slept));
+
+  // test addCoroTaskFuture(), awaiting a future fulfilled from elsewhere
+  folly::Promise<int> p;
+  auto awaitTask = [](folly::SemiFuture<int> sf) -> folly::coro::Task<void> {
+    auto value = co_await std::move(sf);
+    EXPECT_EQ(1, value);
+  };
+  auto f = evb.addCoroTaskFuture(awaitTask(p.getSemiFuture()));
+
+  std::thread evbThread([&]() { evb.run(); });
+  evb.waitUntilRunning();
+  EXPECT_FALSE(f.isReady());
+  p.setValue(1);
+  std::move(f).get();
+
+  // stop() waits for tasks added with addCoroTask()
+  evb.stop();
+  evb.waitUntilStopped();
+  evbThread.join();
+  EXPECT_TRUE(slept);
+}
+#endif
+
 TEST(OpenrEventBaseTest, RunnableApi) {
   OpenrEventBase evb;
 
@@ -115,6 +157,41 @@ TEST(OpenrEventBaseTest, DefaultConstructor) {
   evbThread.join();
 }
 
+TEST(OpenrEventBaseTest, SchedulingStats) {
+  OpenrEventBase evb;
+  evb.setEvbName("stats_test");
+
+  folly::Baton waitBaton;
+  evb.addFiberTask([&]() mutable noexcept {
+    // Hold on to event base thread for a while
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    waitBaton.post();
+  });
+
+  std::thread evbThread([&]() { evb.run(); });
+  evb.waitUntilRunning();
+  waitBaton.wait();
+
+  // Wait for periodic report of counters
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::seconds(2));
+  evb.stop();
+  evb.waitUntilStopped();
+  evbThread.join();
+
+  auto counters = facebook::fb303::fbData->getCounters();
+  ASSERT_EQ(1, counters.count("evb.stats_test.slowest_callback_ms.max"));
+  EXPECT_LE(150, counters.at("evb.stats_test.slowest_callback_ms.max"));
+  EXPECT_EQ(1, counters.count("evb.stats_test.fiber_task_wait_ms.avg"));
+  EXPECT_EQ(1, counters.count("evb.stats_test.loop_lag_ms.max"));
+  ASSERT_EQ(1, counters.count("evb.stats_test.fiber_tasks"));
+  EXPECT_EQ(0, counters.at("evb.stats_test.fiber_tasks"));
+  EXPECT_TRUE(std::any_of(counters.begin(), counters.end(), [](auto& kv) {
+    return kv.first.find("evb.stats_test.loop_busy_us.p99") == 0;
+  }));
+}
+
 TEST_F(OpenrEventBaseTestFixture, Timestamp) {
   // Expect non empty timestamp
   auto ts1 = evb.getTimestamp();
@@ -158,6 +235,37 @@ TEST_F(OpenrEventBaseTestFixture, TimeoutTest) {
   EXPECT_LE(std::chrono::milliseconds(200), elapsedMs);
 }
 
+/**
+ * Timeouts on coarse timer wheel due within a tick of each other fire
+ * together
+ */
+TEST_F(OpenrEventBaseTestFixture, CoarseWheelTimeoutTest) {
+  folly::Baton waitBaton;
+  std::vector<std::chrono::steady_clock::time_point> fireTimes;
+  std::unique_ptr<WheelTimeout> early;
+  std::unique_ptr<WheelTimeout> late;
+
+  evb.getEvb()->runInEventBaseThreadAndWait([&]() noexcept {
+    auto onTimeout = [&]() {
+      fireTimes.emplace_back(std::chrono::steady_clock::now());
+      if (fireTimes.size() == 2) {
+        waitBaton.post();
+      }
+    };
+    early = WheelTimeout::make(evb.getCoarseWheelTimer(), onTimeout);
+    late = WheelTimeout::make(evb.getCoarseWheelTimer(), onTimeout);
+    early->scheduleTimeout(std::chrono::milliseconds(5));
+    late->scheduleTimeout(std::chrono::milliseconds(30));
+  });
+
+  waitBaton.wait();
+  EXPECT_GT(std::chrono::milliseconds(10), fireTimes.at(1) - fireTimes.at(0));
+  evb.getEvb()->runInEventBaseThreadAndWait([&]() noexcept {
+    early.reset();
+    late.reset();
+  });
+}
+
 TEST_F(OpenrEventBaseTestFixture, ZmqSocketPollTest) {
   const auto msg = fbzmq::Message::from(std::string("test message")).value();
   const size_t expectedMsgs{16};
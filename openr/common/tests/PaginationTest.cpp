@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+#include <unordered_map>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/Pagination.h>
+
+namespace openr {
+
+TEST(PaginationTest, PagesInKeyOrder) {
+  std::unordered_map<int, std::string> entries;
+  for (int i = 9; i >= 0; --i) {
+    entries.emplace(i, std::to_string(i));
+  }
+  auto getKey = [](auto const& kv) -> int const& { return kv.first; };
+
+  // walk all pages
+  std::vector<int> allKeys;
+  std::optional<int> cursor;
+  size_t numPages{0};
+  while (true) {
+    auto keys = getPageKeys<int>(entries, getKey, cursor, 4);
+    ++numPages;
+    allKeys.insert(allKeys.end(), keys.begin(), keys.end());
+    if (keys.size() < 4) {
+      break;
+    }
+    cursor = keys.back();
+  }
+  EXPECT_EQ(3, numPages);
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}), allKeys);
+
+  // cursor past the last key and zero limit yield empty page
+  EXPECT_TRUE(getPageKeys<int>(entries, getKey, 9, 4).empty());
+  EXPECT_TRUE(getPageKeys<int>(entries, getKey, std::nullopt, 0).empty());
+}
+
+TEST(PaginationTest, DuplicateKeys) {
+  // entries sharing a key make up one entry of the page
+  std::vector<std::pair<std::string, int>> entries{
+      {"b", 1}, {"a", 2}, {"b", 3}, {"c", 4}, {"a", 5}};
+  auto getKey = [](auto const& kv) -> std::string const& { return kv.first; };
+  EXPECT_EQ(
+      std::vector<std::string>({"a", "b"}),
+      getPageKeys<std::string>(entries, getKey, std::nullopt, 2));
+  EXPECT_EQ(
+      std::vector<std::string>({"c"}),
+      getPageKeys<std::string>(entries, getKey, std::string("b"), 2));
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
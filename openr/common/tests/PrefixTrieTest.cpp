@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Random.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/PrefixTrie.h>
+
+using namespace openr;
+
+namespace {
+std::optional<std::string>
+lookup(PrefixTrie const& trie, std::string const& network) {
+  auto matchedPrefix =
+      trie.longestPrefixMatch(folly::IPAddress::createNetwork(network));
+  if (not matchedPrefix.has_value()) {
+    return std::nullopt;
+  }
+  return toString(*matchedPrefix);
+}
+
+std::vector<std::string>
+covering(PrefixTrie const& trie, std::string const& network) {
+  std::vector<std::string> prefixes;
+  for (auto const& prefix :
+       trie.coveringPrefixes(folly::IPAddress::createNetwork(network))) {
+    prefixes.emplace_back(toString(prefix));
+  }
+  return prefixes;
+}
+
+std::vector<std::string>
+covered(PrefixTrie const& trie, std::string const& network) {
+  std::vector<std::string> prefixes;
+  for (auto const& prefix :
+       trie.coveredPrefixes(folly::IPAddress::createNetwork(network))) {
+    prefixes.emplace_back(toString(prefix));
+  }
+  return prefixes;
+}
+} // namespace
+
+TEST(PrefixTrieTest, LongestPrefixMatch) {
+  PrefixTrie trie;
+  EXPECT_EQ(std::nullopt, lookup(trie, "10.0.0.1/32"));
+
+  // first prefix of an empty trie goes to its own leaf, not the root
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.0.0.0/8")));
+  EXPECT_EQ(std::nullopt, lookup(trie, "11.0.0.1/32"));
+  EXPECT_EQ(1, covered(trie, "10.0.0.0/8").size());
+  trie.clear();
+
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.0.0.0/8")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.1.0.0/16")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.1.128.0/17")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.2.0.0/16")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("fc00::/7")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("fc00:cafe::/32")));
+  EXPECT_FALSE(trie.insert(toIpPrefix("10.1.0.0/16")));
+  EXPECT_EQ(6, trie.size());
+
+  EXPECT_EQ("10.0.0.0/8", lookup(trie, "10.3.0.1/32"));
+  EXPECT_EQ("10.1.0.0/16", lookup(trie, "10.1.0.1/32"));
+  EXPECT_EQ("10.1.128.0/17", lookup(trie, "10.1.129.1/32"));
+  EXPECT_EQ("10.2.0.0/16", lookup(trie, "10.2.0.0/16"));
+  EXPECT_EQ("10.0.0.0/8", lookup(trie, "10.0.0.0/15"));
+  EXPECT_EQ(std::nullopt, lookup(trie, "10.0.0.0/7"));
+  EXPECT_EQ(std::nullopt, lookup(trie, "11.0.0.1/32"));
+  EXPECT_EQ("fc00:cafe::/32", lookup(trie, "fc00:cafe::1/128"));
+  EXPECT_EQ("fc00::/7", lookup(trie, "fd00::1/128"));
+  EXPECT_EQ(std::nullopt, lookup(trie, "::1/128"));
+
+  // removed prefixes stop matching, covering ones still do
+  EXPECT_TRUE(trie.erase(toIpPrefix("10.1.0.0/16")));
+  EXPECT_FALSE(trie.erase(toIpPrefix("10.1.0.0/16")));
+  EXPECT_FALSE(trie.erase(toIpPrefix("10.3.0.0/16")));
+  EXPECT_EQ("10.0.0.0/8", lookup(trie, "10.1.0.1/32"));
+  EXPECT_EQ("10.1.128.0/17", lookup(trie, "10.1.129.1/32"));
+  EXPECT_TRUE(trie.erase(toIpPrefix("10.0.0.0/8")));
+  EXPECT_EQ(std::nullopt, lookup(trie, "10.1.0.1/32"));
+  EXPECT_EQ(4, trie.size());
+
+  // default routes
+  EXPECT_TRUE(trie.insert(toIpPrefix("0.0.0.0/0")));
+  EXPECT_EQ("0.0.0.0/0", lookup(trie, "11.0.0.1/32"));
+  EXPECT_EQ(std::nullopt, lookup(trie, "::1/128"));
+
+  trie.clear();
+  EXPECT_EQ(0, trie.size());
+  EXPECT_EQ(std::nullopt, lookup(trie, "10.2.0.1/32"));
+}
+
+TEST(PrefixTrieTest, CoveringPrefixes) {
+  PrefixTrie trie;
+  EXPECT_TRUE(covering(trie, "10.0.0.1/32").empty());
+
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.0.0.0/8")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.1.0.0/16")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.1.128.0/17")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.2.0.0/16")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("fc00::/7")));
+
+  using Prefixes = std::vector<std::string>;
+  EXPECT_EQ(
+      (Prefixes{"10.0.0.0/8", "10.1.0.0/16", "10.1.128.0/17"}),
+      covering(trie, "10.1.129.1/32"));
+  EXPECT_EQ(
+      (Prefixes{"10.0.0.0/8", "10.1.0.0/16"}), covering(trie, "10.1.0.0/16"));
+  EXPECT_EQ((Prefixes{"10.0.0.0/8"}), covering(trie, "10.3.0.1/32"));
+  EXPECT_EQ((Prefixes{"fc00::/7"}), covering(trie, "fd00::1/128"));
+  EXPECT_TRUE(covering(trie, "10.0.0.0/7").empty());
+  EXPECT_TRUE(covering(trie, "::1/128").empty());
+
+  EXPECT_TRUE(trie.erase(toIpPrefix("10.1.0.0/16")));
+  EXPECT_EQ(
+      (Prefixes{"10.0.0.0/8", "10.1.128.0/17"}),
+      covering(trie, "10.1.129.1/32"));
+}
+
+TEST(PrefixTrieTest, CoveredPrefixes) {
+  PrefixTrie trie;
+  EXPECT_TRUE(covered(trie, "10.0.0.0/8").empty());
+
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.0.0.0/8")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.1.0.0/16")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.1.128.0/17")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("10.2.0.0/16")));
+  EXPECT_TRUE(trie.insert(toIpPrefix("fc00::/7")));
+
+  using Prefixes = std::vector<std::string>;
+  EXPECT_EQ(
+      (Prefixes{"10.0.0.0/8", "10.1.0.0/16", "10.1.128.0/17", "10.2.0.0/16"}),
+      covered(trie, "0.0.0.0/0"));
+  EXPECT_EQ(
+      (Prefixes{"10.1.0.0/16", "10.1.128.0/17", "10.2.0.0/16"}),
+      covered(trie, "10.0.0.0/14"));
+  EXPECT_EQ(
+      (Prefixes{"10.1.0.0/16", "10.1.128.0/17"}), covered(trie, "10.1.0.0/16"));
+  EXPECT_EQ((Prefixes{"10.1.128.0/17"}), covered(trie, "10.1.128.0/17"));
+  EXPECT_EQ((Prefixes{"fc00::/7"}), covered(trie, "::/0"));
+  EXPECT_TRUE(covered(trie, "10.1.0.0/17").empty());
+  EXPECT_TRUE(covered(trie, "10.3.0.0/16").empty());
+
+  EXPECT_TRUE(trie.erase(toIpPrefix("10.1.0.0/16")));
+  EXPECT_EQ((Prefixes{"10.1.128.0/17"}), covered(trie, "10.1.0.0/16"));
+}
+
+TEST(PrefixTrieTest, MatchesLinearScan) {
+  // random prefixes and lookups, compared against a scan of all prefixes
+  PrefixTrie trie;
+  std::vector<folly::CIDRNetwork> networks;
+  for (int i = 0; i < 1000; ++i) {
+    auto const len = folly::Random::rand32(8, 33);
+    auto const addr =
+        folly::IPAddressV4::fromLongHBO(folly::Random::rand32() | 0x0a000000)
+            .mask(len);
+    // skip duplicates, erasing one must not erase an expected match
+    if (trie.insert(toIpPrefix({addr, len}))) {
+      networks.emplace_back(addr, len);
+    }
+  }
+  // remove every other one
+  for (size_t i = 0; i < networks.size(); i += 2) {
+    trie.erase(toIpPrefix(networks.at(i)));
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    folly::IPAddress const addr(
+        folly::IPAddressV4::fromLongHBO(folly::Random::rand32() | 0x0a000000));
+    std::optional<folly::CIDRNetwork> expected;
+    for (size_t j = 1; j < networks.size(); j += 2) {
+      auto const& network = networks.at(j);
+      if ((not expected or network.second > expected->second) and
+          addr.inSubnet(network.first, network.second)) {
+        expected = network;
+      }
+    }
+
+    auto matchedPrefix = trie.longestPrefixMatch({addr, 32});
+    ASSERT_EQ(expected.has_value(), matchedPrefix.has_value());
+    if (expected.has_value()) {
+      EXPECT_EQ(*expected, toIPNetwork(*matchedPrefix));
+    }
+  }
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <fbzmq/zmq/Common.h>
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/SerializationBuffer.h>
+#include <openr/common/Util.h>
+#include <openr/tests/BenchmarkDriver.h>
+
+namespace openr {
+
+namespace {
+
+thrift::PrefixDatabase
+createTestPrefixDb(unsigned numOfPrefixes) {
+  std::vector<thrift::PrefixEntry> entries;
+  entries.reserve(numOfPrefixes);
+  for (unsigned i = 0; i < numOfPrefixes; ++i) {
+    entries.emplace_back(createPrefixEntry(toIpPrefix(
+        folly::sformat("fc00:{:x}:{:x}::/64", i >> 16, i & 0xffff))));
+  }
+  return createPrefixDb("node1", entries);
+}
+
+} // namespace
+
+/**
+ * Serialize a prefix database of numOfPrefixes entries with
+ * fbzmq::util::writeThriftObjStr(), as modules used to
+ */
+static void
+BM_SerializeWriteThriftObjStr(uint32_t iters, unsigned numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  apache::thrift::CompactSerializer serializer;
+  const auto prefixDb = createTestPrefixDb(numOfPrefixes);
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(
+        fbzmq::util::writeThriftObjStr(prefixDb, serializer));
+  }
+}
+
+/**
+ * Same with serializeCompact(), on the per thread buffer
+ */
+static void
+BM_SerializeCompact(uint32_t iters, unsigned numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  const auto prefixDb = createTestPrefixDb(numOfPrefixes);
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(serializeCompact(prefixDb));
+  }
+}
+
+/**
+ * Same with serializeCompactIOBuf(), as sent to KvStore peers
+ */
+static void
+BM_SerializeCompactIOBuf(uint32_t iters, unsigned numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  const auto prefixDb = createTestPrefixDb(numOfPrefixes);
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(serializeCompactIOBuf(prefixDb));
+  }
+}
+
+/**
+ * Deserialize with fbzmq::util::readThriftObjStr(), as Decision does
+ */
+static void
+BM_DeserializeReadThriftObjStr(uint32_t iters, unsigned numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  apache::thrift::CompactSerializer serializer;
+  const auto prefixDbStr = serializeCompact(createTestPrefixDb(numOfPrefixes));
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(
+        fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
+            prefixDbStr, serializer));
+  }
+}
+
+// The parameter is the number of prefixes in the prefix database
+BENCHMARK_PARAM(BM_SerializeWriteThriftObjStr, 1);
+BENCHMARK_RELATIVE_PARAM(BM_SerializeCompact, 1);
+BENCHMARK_RELATIVE_PARAM(BM_SerializeCompactIOBuf, 1);
+BENCHMARK_PARAM(BM_SerializeWriteThriftObjStr, 100);
+BENCHMARK_RELATIVE_PARAM(BM_SerializeCompact, 100);
+BENCHMARK_RELATIVE_PARAM(BM_SerializeCompactIOBuf, 100);
+BENCHMARK_PARAM(BM_SerializeWriteThriftObjStr, 10000);
+BENCHMARK_RELATIVE_PARAM(BM_SerializeCompact, 10000);
+BENCHMARK_RELATIVE_PARAM(BM_SerializeCompactIOBuf, 10000);
+
+BENCHMARK_PARAM(BM_DeserializeReadThriftObjStr, 1);
+BENCHMARK_PARAM(BM_DeserializeReadThriftObjStr, 100);
+BENCHMARK_PARAM(BM_DeserializeReadThriftObjStr, 10000);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  return openr::runBenchmarks();
+}
@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <fbzmq/zmq/Common.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/SerializationBuffer.h>
+#include <openr/common/Util.h>
+
+namespace openr {
+
+namespace {
+
+thrift::PrefixDatabase
+createTestPrefixDb(size_t numPrefixes) {
+  std::vector<thrift::PrefixEntry> entries;
+  for (size_t i = 0; i < numPrefixes; ++i) {
+    entries.emplace_back(createPrefixEntry(toIpPrefix(
+        folly::sformat("fc00:{:x}:{:x}::/64", i >> 16, i & 0xffff))));
+  }
+  return createPrefixDb("node1", entries);
+}
+
+} // namespace
+
+TEST(SerializationBuffer, SameAsCompactSerializer) {
+  apache::thrift::CompactSerializer serializer;
+  // growing and shrinking objects, serialized on the same thread buffer
+  for (size_t numPrefixes : {0, 1, 10000, 10, 20000}) {
+    auto const prefixDb = createTestPrefixDb(numPrefixes);
+    auto const expected = fbzmq::util::writeThriftObjStr(prefixDb, serializer);
+
+    EXPECT_EQ(expected, serializeCompact(prefixDb));
+    EXPECT_EQ(expected, serializeToThreadBuffer(prefixDb));
+
+    auto buf = serializeCompactIOBuf(prefixDb);
+    EXPECT_FALSE(buf->isChained());
+    EXPECT_EQ(expected, buf->moveToFbString().toStdString());
+
+    EXPECT_EQ(
+        prefixDb,
+        fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
+            serializeCompact(prefixDb), serializer));
+  }
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
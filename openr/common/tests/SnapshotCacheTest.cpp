@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <optional>
+#include <stdexcept>
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/SnapshotCache.h>
+
+namespace openr {
+
+TEST(SnapshotCache, SharedUntilInvalidated) {
+  SnapshotCache<int> cache("test.snapshot");
+  int numBuilds{0};
+  std::optional<folly::Promise<std::unique_ptr<int>>> pending;
+  auto build = [&]() {
+    ++numBuilds;
+    auto [p, f] = folly::makePromiseContract<std::unique_ptr<int>>();
+    pending = std::move(p);
+    return std::move(f);
+  };
+
+  // callers asking while snapshot is built wait for the same build
+  auto first = cache.get("key", build);
+  auto second = cache.get("key", build);
+  EXPECT_EQ(1, numBuilds);
+  pending->setValue(std::make_unique<int>(1));
+  EXPECT_EQ(1, *std::move(first).get());
+  EXPECT_EQ(1, *std::move(second).get());
+
+  // built snapshot is reused, snapshots of other keys are separate
+  EXPECT_EQ(1, *cache.get("key", build).get());
+  EXPECT_EQ(1, numBuilds);
+  auto other = cache.get("other", build);
+  EXPECT_EQ(2, numBuilds);
+  pending->setValue(std::make_unique<int>(2));
+  EXPECT_EQ(2, *std::move(other).get());
+
+  // snapshot is built anew after invalidation
+  cache.invalidate();
+  auto third = cache.get("key", build);
+  EXPECT_EQ(3, numBuilds);
+  pending->setValue(std::make_unique<int>(3));
+  EXPECT_EQ(3, *std::move(third).get());
+}
+
+TEST(SnapshotCache, RebuildOnFailure) {
+  SnapshotCache<int> cache("test.snapshot");
+  int numBuilds{0};
+  auto failingBuild = [&]() {
+    ++numBuilds;
+    return folly::makeSemiFuture<std::unique_ptr<int>>(
+        std::runtime_error("failed"));
+  };
+  EXPECT_THROW(cache.get("key", failingBuild).get(), std::runtime_error);
+  EXPECT_THROW(cache.get("key", failingBuild).get(), std::runtime_error);
+  EXPECT_EQ(2, numBuilds);
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,42 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/StatHandle.h>
+
+namespace fb303 = facebook::fb303;
+
+namespace openr {
+
+TEST(StatHandle, UpdatesStat) {
+  static const StatHandle kStat("test.stat_handle", fb303::SUM);
+
+  // updates the same stat as adding by key
+  kStat.addValue(2);
+  fb303::fbData->addStatValue("test.stat_handle", 3, fb303::SUM);
+  EXPECT_EQ(5, fb303::fbData->getCounters().at("test.stat_handle.sum"));
+
+  // stat is looked up again after reset
+  resetAllStats();
+  EXPECT_EQ(0, fb303::fbData->getCounters().count("test.stat_handle.sum"));
+  kStat.addValue(1);
+  EXPECT_EQ(1, fb303::fbData->getCounters().at("test.stat_handle.sum"));
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
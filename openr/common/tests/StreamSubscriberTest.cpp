@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/StreamSubscriber.h>
+
+namespace openr {
+
+namespace {
+
+// Updates below 100 can be merged by adding them up
+bool
+mergeSmall(int& into, int& from) {
+  if (into >= 100 or from >= 100) {
+    return false;
+  }
+  into += from;
+  return true;
+}
+
+} // namespace
+
+TEST(StreamBuffer, CoalesceOnOverflow) {
+  StreamBuffer<int> buffer(3, std::chrono::seconds(10), mergeSmall);
+  auto now = std::chrono::steady_clock::now();
+
+  // client is waiting, updates are pending up to the limit
+  EXPECT_TRUE(buffer.push(1, now));
+  EXPECT_TRUE(buffer.push(2, now));
+  EXPECT_TRUE(buffer.push(100, now));
+  EXPECT_EQ(3, buffer.size());
+  EXPECT_EQ(0, buffer.getNumCoalesced());
+
+  // one more coalesces consecutive mergeable updates
+  EXPECT_TRUE(buffer.push(4, now));
+  EXPECT_EQ(1, buffer.getNumCoalesced());
+  EXPECT_EQ(3, buffer.size());
+  EXPECT_EQ(3, buffer.pop(now));
+  EXPECT_EQ(100, buffer.pop(now));
+  EXPECT_EQ(4, buffer.pop(now));
+  EXPECT_EQ(std::nullopt, buffer.pop(now));
+}
+
+TEST(StreamBuffer, DisconnectOnOverflow) {
+  StreamBuffer<int> buffer(2, std::chrono::seconds(10), mergeSmall);
+  auto now = std::chrono::steady_clock::now();
+
+  // updates that can't be merged exceed the limit
+  EXPECT_TRUE(buffer.push(100, now));
+  EXPECT_TRUE(buffer.push(200, now));
+  EXPECT_FALSE(buffer.push(300, now));
+}
+
+TEST(StreamBuffer, DisconnectOnLag) {
+  const std::chrono::seconds maxLag{10};
+  StreamBuffer<int> buffer(10, maxLag, mergeSmall);
+  auto now = std::chrono::steady_clock::now();
+
+  // client waiting for an update isn't lagging however long it waits
+  EXPECT_EQ(std::nullopt, buffer.pop(now));
+  now += maxLag * 2;
+  EXPECT_TRUE(buffer.push(1, now));
+  EXPECT_TRUE(buffer.push(2, now));
+
+  // client took an update but not the next one for too long
+  EXPECT_EQ(1, buffer.pop(now));
+  EXPECT_TRUE(buffer.push(3, now + maxLag));
+  EXPECT_FALSE(buffer.push(4, now + maxLag + std::chrono::seconds(1)));
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
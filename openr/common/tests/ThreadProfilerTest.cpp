@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <folly/String.h>
+#include <folly/synchronization/Baton.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/ThreadProfiler.h>
+
+using namespace openr;
+
+TEST(ThreadProfilerTest, ProfileSpinningThread) {
+  // thread burning CPU to be sampled
+  std::atomic<bool> stop{false};
+  std::atomic<pid_t> tid{0};
+  folly::Baton<> started;
+  std::thread spinner([&]() {
+    tid = syscall(SYS_gettid);
+    started.post();
+    volatile uint64_t count{0};
+    while (not stop.load(std::memory_order_relaxed)) {
+      count = count + 1;
+    }
+  });
+  started.wait();
+
+  const auto profile = profileThread(
+      tid, std::chrono::milliseconds(200), std::chrono::microseconds(1000));
+  stop = true;
+  spinner.join();
+
+  EXPECT_EQ(tid.load(), *profile.tid_ref());
+  EXPECT_GT(*profile.samples_ref(), 0);
+  EXPECT_EQ(0, *profile.dropped_samples_ref());
+  ASSERT_FALSE(profile.collapsed_stacks_ref()->empty());
+
+  // "<frame>;<frame>;... <count>", counts adding up to at most the samples
+  // taken
+  int64_t total{0};
+  for (const auto& stack : *profile.collapsed_stacks_ref()) {
+    const auto pos = stack.rfind(' ');
+    ASSERT_NE(std::string::npos, pos) << stack;
+    total += folly::to<int64_t>(stack.substr(pos + 1));
+  }
+  EXPECT_GT(total, 0);
+  EXPECT_LE(total, *profile.samples_ref());
+}
+
+TEST(ThreadProfilerTest, InvalidArguments) {
+  const pid_t tid = syscall(SYS_gettid);
+  EXPECT_THROW(
+      profileThread(
+          tid, std::chrono::milliseconds(0), std::chrono::microseconds(1000)),
+      std::invalid_argument);
+  EXPECT_THROW(
+      profileThread(
+          tid, std::chrono::milliseconds(10), std::chrono::microseconds(1)),
+      std::invalid_argument);
+  EXPECT_THROW(
+      profileThread(
+          -1, std::chrono::milliseconds(10), std::chrono::microseconds(1000)),
+      std::invalid_argument);
+}
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  return RUN_ALL_TESTS();
+}
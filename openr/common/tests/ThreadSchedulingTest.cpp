@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <sched.h>
+
+#include <thread>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/ThreadScheduling.h>
+
+using namespace openr;
+
+namespace {
+
+std::optional<thrift::ThreadPlacement>
+findPlacement(const std::string& name) {
+  for (auto& placement : getThreadPlacements()) {
+    if (*placement.name_ref() == name) {
+      return placement;
+    }
+  }
+  return std::nullopt;
+}
+
+} // namespace
+
+TEST(ThreadSchedulingTest, Unconfigured) {
+  std::thread thread(
+      []() { setupThreadScheduling("Unconfigured", std::nullopt); });
+  thread.join();
+
+  // thread exited, so there is nothing to report about it
+  EXPECT_EQ(std::nullopt, findPlacement("Unconfigured"));
+
+  // calling thread is registered and keeps its placement
+  setupThreadScheduling("Main", std::nullopt);
+  auto placement = findPlacement("Main");
+  ASSERT_TRUE(placement.has_value());
+  EXPECT_FALSE(placement->cpus_ref()->empty());
+  EXPECT_EQ(thrift::ThreadSchedulingPolicy::OTHER, *placement->policy_ref());
+  EXPECT_EQ(0, *placement->priority_ref());
+}
+
+TEST(ThreadSchedulingTest, PinToCpu) {
+  // pin to first CPU we are allowed to run on
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(allowed), &allowed));
+  int cpu = 0;
+  while (not CPU_ISSET(cpu, &allowed)) {
+    ++cpu;
+  }
+
+  thrift::ThreadSchedulingConfig config;
+  config.cpus_ref() = {cpu};
+  std::thread thread([&]() {
+    setupThreadScheduling("Pinned", config);
+
+    auto placement = findPlacement("Pinned");
+    ASSERT_TRUE(placement.has_value());
+    EXPECT_EQ(std::vector<int32_t>{cpu}, *placement->cpus_ref());
+    EXPECT_EQ(thrift::ThreadSchedulingPolicy::OTHER, *placement->policy_ref());
+  });
+  thread.join();
+}
+
+TEST(ThreadSchedulingTest, InvalidCpu) {
+  // CPUs we are not allowed to run on are rejected by the kernel
+  thrift::ThreadSchedulingConfig config;
+  config.cpus_ref() = {CPU_SETSIZE - 1};
+  std::thread thread([&]() {
+    EXPECT_THROW(setupThreadScheduling("Invalid", config), std::system_error);
+  });
+  thread.join();
+}
+
+int
+main(int argc, char** argv) {
+  // Basic initialization
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
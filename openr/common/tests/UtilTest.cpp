@@ -276,6 +276,39 @@ TEST(UtilTest, PrefixKeyTest) {
   }
 }
 
+TEST(UtilTest, KeyPrefixTest) {
+  // literal prefixes, nested ones are redundant
+  KeyPrefix literal({"prefix:", "adj:", "prefix:node1", "adj"});
+  ASSERT_TRUE(literal.getLiteralPrefixes().has_value());
+  EXPECT_EQ(
+      std::vector<std::string>({"adj", "prefix:"}),
+      *literal.getLiteralPrefixes());
+  EXPECT_TRUE(literal.keyMatch("adj:node1"));
+  EXPECT_TRUE(literal.keyMatch("adj"));
+  EXPECT_TRUE(literal.keyMatch("prefix:node2"));
+  EXPECT_FALSE(literal.keyMatch("ad"));
+  EXPECT_FALSE(literal.keyMatch("prefix"));
+  EXPECT_FALSE(literal.keyMatch("allocprefix:node1"));
+  EXPECT_FALSE(literal.keyMatch("zzz"));
+
+  // empty prefix matches everything
+  KeyPrefix empty({""});
+  EXPECT_TRUE(empty.keyMatch("adj:node1"));
+  EXPECT_TRUE(empty.keyMatch(""));
+
+  // regex prefixes are matched as before
+  KeyPrefix regex({"adj:node[0-9]", "prefix:"});
+  EXPECT_FALSE(regex.getLiteralPrefixes().has_value());
+  EXPECT_TRUE(regex.keyMatch("adj:node1"));
+  EXPECT_TRUE(regex.keyMatch("prefix:node1"));
+  EXPECT_FALSE(regex.keyMatch("adj:nodex"));
+
+  // no prefixes match everything
+  KeyPrefix none(std::vector<std::string>{});
+  EXPECT_FALSE(none.getLiteralPrefixes().has_value());
+  EXPECT_TRUE(none.keyMatch("adj:node1"));
+}
+
 TEST(UtilTest, GetNodeNameFromKeyTest) {
   const std::unordered_map<std::string, std::string> expectedIo = {
       {"prefix:node1", "node1"},
@@ -288,6 +321,51 @@ TEST(UtilTest, GetNodeNameFromKeyTest) {
   }
 }
 
+TEST(UtilTest, ParseKvStoreKeyTest) {
+  auto view = parseKvStoreKey("adj:node1");
+  EXPECT_EQ(KvStoreKeyType::ADJ_DB, view.type);
+  EXPECT_EQ("node1", view.nodeName);
+  EXPECT_FALSE(view.getPrefixNetwork().has_value());
+
+  EXPECT_EQ(
+      KvStoreKeyType::ADJ_DB_DELTA, parseKvStoreKey("adjdelta:node1").type);
+  EXPECT_EQ(
+      KvStoreKeyType::PREFIX_ALLOC, parseKvStoreKey("allocprefix:1").type);
+  EXPECT_EQ(KvStoreKeyType::FIB_TIME, parseKvStoreKey("fibtime:node1").type);
+  EXPECT_EQ(KvStoreKeyType::OTHER, parseKvStoreKey("foo:node1").type);
+
+  // full prefix database key
+  view = parseKvStoreKey("prefix:node1");
+  EXPECT_EQ(KvStoreKeyType::PREFIX_DB, view.type);
+  EXPECT_EQ("node1", view.nodeName);
+  EXPECT_TRUE(view.area.empty());
+  EXPECT_FALSE(view.getPrefixNetwork().has_value());
+
+  // per prefix keys, same as PrefixKey
+  for (auto const& network :
+       {folly::IPAddress::createNetwork("10.1.0.0/16"),
+        folly::IPAddress::createNetwork("fc00:1::/64")}) {
+    const PrefixKey prefixKey("node.1", network, "area-1");
+    const auto key = prefixKey.getPrefixKey();
+    view = parseKvStoreKey(key);
+    EXPECT_EQ(KvStoreKeyType::PREFIX_DB, view.type);
+    EXPECT_EQ(prefixKey.getNodeName(), view.nodeName);
+    EXPECT_EQ(prefixKey.getPrefixArea(), view.area);
+    EXPECT_EQ(network, view.getPrefixNetwork());
+  }
+
+  // malformed per prefix keys
+  EXPECT_FALSE(parseKvStoreKey("prefix:node1:area:[10.0.0.0/33]")
+                   .getPrefixNetwork()
+                   .has_value());
+  EXPECT_FALSE(parseKvStoreKey("prefix:node1:area:[10.0.0.0]")
+                   .getPrefixNetwork()
+                   .has_value());
+  EXPECT_FALSE(parseKvStoreKey("prefix:node1:area:10.0.0.0/8")
+                   .getPrefixNetwork()
+                   .has_value());
+}
+
 // test getNthPrefix()
 TEST(UtilTest, getNthPrefix) {
   // v6 allocation parameters
@@ -559,6 +637,57 @@ TEST(UtilTest, getTotalPerfEventsDurationTest) {
   }
 }
 
+TEST(UtilTest, getPerfEventsStagesTest) {
+  {
+    thrift::PerfEvents perfEvents;
+    EXPECT_TRUE(getPerfEventsStages(perfEvents).empty());
+    addPerfEvent(perfEvents, "node1", "LINK_UP");
+    EXPECT_TRUE(getPerfEventsStages(perfEvents).empty());
+  }
+
+  {
+    thrift::PerfEvents perfEvents;
+    thrift::PerfEvent event1{apache::thrift::FRAGILE, "node1", "LINK_UP", 100};
+    perfEvents.events_ref()->emplace_back(std::move(event1));
+    thrift::PerfEvent event2{
+        apache::thrift::FRAGILE, "node2", "DECISION_RECVD", 250};
+    perfEvents.events_ref()->emplace_back(std::move(event2));
+    thrift::PerfEvent event3{
+        apache::thrift::FRAGILE, "node2", "SPF_CALCULATE", 300};
+    perfEvents.events_ref()->emplace_back(std::move(event3));
+    const auto stages = getPerfEventsStages(perfEvents);
+    ASSERT_EQ(stages.size(), 2);
+    EXPECT_EQ(stages[0].firstEvent, "LINK_UP");
+    EXPECT_EQ(stages[0].secondEvent, "DECISION_RECVD");
+    EXPECT_EQ(stages[0].nodeName, "node2");
+    EXPECT_EQ(stages[0].startUnixTs, 100);
+    EXPECT_EQ(stages[0].duration.count(), 150);
+    EXPECT_EQ(stages[1].firstEvent, "DECISION_RECVD");
+    EXPECT_EQ(stages[1].secondEvent, "SPF_CALCULATE");
+    EXPECT_EQ(stages[1].startUnixTs, 250);
+    EXPECT_EQ(stages[1].duration.count(), 50);
+  }
+}
+
+TEST(UtilTest, getHeapBytesTest) {
+  // short strings are stored inline
+  EXPECT_EQ(0, getHeapBytes(std::string("node")));
+  EXPECT_LE(1024, getHeapBytes(std::string(1024, 'x')));
+
+  // values are dominated by their payload
+  auto value = createThriftValue(1, "node", std::string(1024, 'x'));
+  EXPECT_LE(1024, getHeapBytes(value));
+  value.value_ref().reset();
+  EXPECT_GT(1024, getHeapBytes(value));
+
+  // adjacency databases grow with their adjacencies
+  thrift::AdjacencyDatabase adjDb;
+  adjDb.thisNodeName_ref() = "node";
+  const auto emptyBytes = getHeapBytes(adjDb);
+  adjDb.adjacencies_ref()->emplace_back();
+  EXPECT_LE(emptyBytes + sizeof(thrift::Adjacency), getHeapBytes(adjDb));
+}
+
 TEST(UtilTest, getDurationBetweenPerfEventsTest) {
   {
     thrift::PerfEvents perfEvents;
@@ -674,6 +803,38 @@ TEST(UtilTest, findDeltaRoutes) {
   EXPECT_EQ(res3.mplsRoutesToDelete_ref()->at(0), 2);
 }
 
+TEST(UtilTest, mergeRouteDatabaseDelta) {
+  thrift::RouteDatabaseDelta delta;
+  delta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix1, {path1_2_1}));
+  delta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix2, {path1_2_1}));
+  delta.unicastRoutesToDelete_ref()->emplace_back(prefix3);
+  delta.mplsRoutesToUpdate_ref()->emplace_back(
+      createMplsRoute(2, {path1_2_1_swap}));
+
+  // prefix1 is updated again, prefix2 deleted, prefix3 re-added
+  thrift::RouteDatabaseDelta laterDelta;
+  laterDelta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix1, {path1_2_2}));
+  laterDelta.unicastRoutesToUpdate_ref()->emplace_back(
+      createUnicastRoute(prefix3, {path1_3_1}));
+  laterDelta.unicastRoutesToDelete_ref()->emplace_back(prefix2);
+  laterDelta.mplsRoutesToDelete_ref()->emplace_back(2);
+
+  mergeRouteDatabaseDelta(delta, std::move(laterDelta));
+  EXPECT_EQ(
+      std::vector<thrift::UnicastRoute>(
+          {createUnicastRoute(prefix1, {path1_2_2}),
+           createUnicastRoute(prefix3, {path1_3_1})}),
+      *delta.unicastRoutesToUpdate_ref());
+  EXPECT_EQ(
+      std::vector<thrift::IpPrefix>({prefix2}),
+      *delta.unicastRoutesToDelete_ref());
+  EXPECT_EQ(0, delta.mplsRoutesToUpdate_ref()->size());
+  EXPECT_EQ(std::vector<int32_t>({2}), *delta.mplsRoutesToDelete_ref());
+}
+
 TEST(UtilTest, MplsLabelValidate) {
   EXPECT_TRUE(isMplsLabelValid(0));
   EXPECT_TRUE(isMplsLabelValid(1132));
@@ -753,6 +914,39 @@ TEST(UtilTest, MplsActionValidate) {
   }
 }
 
+TEST(UtilTest, AdjDbDelta) {
+  auto const adj12 = createAdjacency("2", "1/2", "2/1", "fe80::2", "", 10, 0);
+  auto const adj13 = createAdjacency("3", "1/3", "3/1", "fe80::3", "", 10, 0);
+  auto const adj14 = createAdjacency("4", "1/4", "4/1", "fe80::4", "", 10, 0);
+  auto adj13Changed = adj13;
+  adj13Changed.metric_ref() = 20;
+
+  auto const baseAdjDb = createAdjDb("1", {adj12, adj13}, 0);
+  auto const adjDb = createAdjDb("1", {adj13Changed, adj14}, 0);
+
+  // no changes
+  auto delta = createAdjDbDelta(baseAdjDb, baseAdjDb);
+  EXPECT_EQ("1", *delta.thisNodeName_ref());
+  EXPECT_TRUE(delta.updatedAdjacencies_ref()->empty());
+  EXPECT_TRUE(delta.removedAdjacencies_ref()->empty());
+  EXPECT_EQ(baseAdjDb, applyAdjDbDelta(baseAdjDb, delta));
+
+  // adj12 removed, adj13 changed, adj14 added
+  delta = createAdjDbDelta(baseAdjDb, adjDb);
+  EXPECT_EQ(2, delta.updatedAdjacencies_ref()->size());
+  ASSERT_EQ(1, delta.removedAdjacencies_ref()->size());
+  EXPECT_EQ("2", *delta.removedAdjacencies_ref()->at(0).otherNodeName_ref());
+  EXPECT_EQ("1/2", *delta.removedAdjacencies_ref()->at(0).ifName_ref());
+  EXPECT_EQ(adjDb, applyAdjDbDelta(baseAdjDb, delta));
+
+  // deltas are cumulative, i.e. reverting changes empties them again
+  auto const adjDb2 = createAdjDb("1", {adj12, adj13, adj14}, 0);
+  delta = createAdjDbDelta(baseAdjDb, adjDb2);
+  EXPECT_EQ(1, delta.updatedAdjacencies_ref()->size());
+  EXPECT_TRUE(delta.removedAdjacencies_ref()->empty());
+  EXPECT_EQ(adjDb2, applyAdjDbDelta(baseAdjDb, delta));
+}
+
 TEST(UtilTest, getPrefixForwardingTypeAndAlgorithm) {
   PrefixEntries prefixes;
 
@@ -1094,6 +1288,88 @@ TEST(UtilTest, BestMetricsSelection) {
   }
 }
 
+TEST(UtilTest, PackPrefixMetrics) {
+  // same order as comparing (path-preference, source-preference, -distance)
+  std::vector<std::tuple<int32_t, int32_t, int32_t>> metrics{
+      {-5, 0, 0},
+      {0, 0, 0},
+      {0, 0, -1},
+      {0, -1, 0},
+      {0, 1, 100},
+      {1, -100, 1},
+      {1, -100, std::numeric_limits<int32_t>::max()},
+      {std::numeric_limits<int32_t>::max(), 0, 0},
+      {std::numeric_limits<int32_t>::min(), 0, 0}};
+  for (auto const& [pp1, sp1, d1] : metrics) {
+    for (auto const& [pp2, sp2, d2] : metrics) {
+      auto const expected =
+          std::make_tuple(pp1, sp1, -int64_t{d1}) <
+          std::make_tuple(pp2, sp2, -int64_t{d2});
+      EXPECT_EQ(
+          expected,
+          packPrefixMetrics(pp1, sp1, d1) < packPrefixMetrics(pp2, sp2, d2));
+      EXPECT_EQ(
+          std::make_tuple(pp1, sp1, d1) == std::make_tuple(pp2, sp2, d2),
+          packPrefixMetrics(pp1, sp1, d1) == packPrefixMetrics(pp2, sp2, d2));
+    }
+  }
+}
+
+TEST(UtilTest, GenerateHash) {
+  const std::optional<std::string> value("value");
+  const auto hash = generateHash(1, "node1", value);
+  EXPECT_EQ(hash, generateHash(1, "node1", value));
+  EXPECT_EQ(hash, generateHash(createThriftValue(1, "node1", "value")));
+
+  // every field is covered
+  EXPECT_NE(hash, generateHash(2, "node1", value));
+  EXPECT_NE(hash, generateHash(1, "node2", value));
+  EXPECT_NE(hash, generateHash(1, "node1", std::string("value2")));
+
+  // bytes don't shift between fields, and missing value isn't empty one
+  EXPECT_NE(
+      generateHash(1, "node1", std::string("value")),
+      generateHash(1, "node1v", std::string("alue")));
+  EXPECT_NE(
+      generateHash(1, "node1", std::nullopt),
+      generateHash(1, "node1", std::string("")));
+}
+
+TEST(UtilTest, CompressValue) {
+  const std::string data(4096, 'a');
+  auto value = createThriftValue(1, "node1", data, 1000, 0, 0);
+  const auto hash = generateHash(value);
+
+  EXPECT_TRUE(compressValue(value));
+  EXPECT_TRUE(value.compressed_ref().value_or(false));
+  EXPECT_LT(value.value_ref()->size(), data.size());
+  // already compressed
+  EXPECT_FALSE(compressValue(value));
+
+  // hash and content of compressed value are of uncompressed value
+  EXPECT_EQ(hash, generateHash(value));
+  std::string buf;
+  EXPECT_EQ(data, getUncompressedValue(value, buf));
+
+  decompressValue(value);
+  EXPECT_FALSE(value.compressed_ref().has_value());
+  EXPECT_EQ(data, *value.value_ref());
+  EXPECT_EQ(
+      generateHash(
+          *value.version_ref(), *value.originatorId_ref(), value.value_ref()),
+      generateHash(value));
+
+  // not compressed if it doesn't get smaller
+  auto smallValue = createThriftValue(1, "node1", "a", 1000, 0, 0);
+  EXPECT_FALSE(compressValue(smallValue));
+  EXPECT_EQ("a", *smallValue.value_ref());
+
+  // corrupt value
+  value.value_ref() = "garbage";
+  value.compressed_ref() = true;
+  EXPECT_THROW(decompressValue(value), std::runtime_error);
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <folly/io/async/EventBase.h>
+#include <openr/common/WheelTimeout.h>
+
+namespace chrono = std::chrono;
+
+namespace openr {
+
+TEST(WheelTimeoutTest, RescheduleAndCancel) {
+  folly::EventBase evb;
+
+  int fired = 0;
+  int holdFired = 0;
+  auto timeout = WheelTimeout::make(evb, [&]() { fired++; });
+  auto holdTimeout = WheelTimeout::make(evb, [&]() { holdFired++; });
+  auto cancelledTimeout = WheelTimeout::make(evb, [&]() { FAIL(); });
+  EXPECT_FALSE(timeout->isScheduled());
+
+  timeout->scheduleTimeout(chrono::milliseconds(20));
+  holdTimeout->scheduleTimeout(chrono::milliseconds(50));
+  cancelledTimeout->scheduleTimeout(chrono::milliseconds(20));
+  EXPECT_TRUE(timeout->isScheduled());
+  cancelledTimeout->cancelTimeout();
+  EXPECT_FALSE(cancelledTimeout->isScheduled());
+
+  // keep pushing hold timeout out like a received keep-alive would, it must
+  // not fire in between
+  std::unique_ptr<WheelTimeout> refresher;
+  int refreshes = 0;
+  refresher = WheelTimeout::make(evb, [&]() {
+    EXPECT_EQ(0, holdFired);
+    if (++refreshes < 5) {
+      holdTimeout->scheduleTimeout(chrono::milliseconds(50));
+      refresher->scheduleTimeout(chrono::milliseconds(30));
+    }
+  });
+  refresher->scheduleTimeout(chrono::milliseconds(30));
+
+  // timeout destroyed while scheduled never fires
+  auto destroyedTimeout = WheelTimeout::make(evb, [&]() { FAIL(); });
+  destroyedTimeout->scheduleTimeout(chrono::milliseconds(20));
+  destroyedTimeout.reset();
+
+  auto stopTimeout = WheelTimeout::make(evb, [&]() {
+    EXPECT_EQ(1, fired);
+    EXPECT_EQ(1, holdFired);
+    evb.terminateLoopSoon();
+  });
+  stopTimeout->scheduleTimeout(chrono::milliseconds(500));
+
+  evb.loop();
+  EXPECT_EQ(1, fired);
+  EXPECT_EQ(1, holdFired);
+  EXPECT_EQ(5, refreshes);
+  EXPECT_FALSE(timeout->isScheduled());
+}
+
+TEST(WheelTimeoutTest, DestroyInCallback) {
+  folly::EventBase evb;
+
+  // owner releases timeout from within its own callback, e.g. neighbor gets
+  // removed on hold timer expiry
+  std::unique_ptr<WheelTimeout> timeout;
+  bool fired = false;
+  timeout = WheelTimeout::make(evb, [&]() {
+    fired = true;
+    evb.terminateLoopSoon();
+    // captures are gone after this
+    timeout.reset();
+  });
+  timeout->scheduleTimeout(chrono::milliseconds(10));
+
+  evb.loop();
+  EXPECT_TRUE(fired);
+  EXPECT_EQ(nullptr, timeout);
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
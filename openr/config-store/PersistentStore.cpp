@@ -9,26 +9,32 @@
 
 #include <chrono>
 
+#include <folly/Exception.h>
+#include <folly/File.h>
 #include <folly/FileUtil.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/io/IOBuf.h>
 
 #include <openr/common/Util.h>
 
 using std::exception;
 
-namespace {
-
-static const long kDbFlushRatio = 10000;
-
-} // anonymous namespace
-
 namespace openr {
 
 PersistentStore::PersistentStore(
     const std::string& storageFilePath,
     bool dryrun,
-    bool periodicallySaveToDisk)
-    : storageFilePath_(storageFilePath), dryrun_(dryrun) {
+    bool periodicallySaveToDisk,
+    uint64_t compactionRatio)
+    : storageFilePath_(storageFilePath),
+      dryrun_(dryrun),
+      compactionRatio_(compactionRatio) {
+  CHECK_GT(compactionRatio_, 0);
+  if (not dryrun_) {
+    ioWorker_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+        1, std::make_shared<folly::NamedThreadFactory>("ConfigStoreIO"));
+  }
+
   if (periodicallySaveToDisk) {
     // Create timer and backoff mechanism only if backoff is requested
     saveDbTimerBackoff_ =
@@ -57,6 +63,10 @@ PersistentStore::PersistentStore(
 }
 
 PersistentStore::~PersistentStore() {
+  // Finish pending disk IO, final snapshot supersedes it anyway
+  if (ioWorker_) {
+    ioWorker_->join();
+  }
   saveDatabaseToDisk();
 }
 
@@ -73,49 +83,49 @@ PersistentStore::store(std::string key, std::string value) {
     SYSLOG(INFO) << "Store key: " << key << ", value: " << value
                  << " to config-store";
     // Override previous value if any
+    lazyValues_.erase(key);
     database_.keyVals_ref()[key] = value;
-    auto pObject = toPersistentObject(ActionType::ADD, key, value);
-    pObjects_.emplace_back(std::move(pObject));
+    addPersistentObject(toPersistentObject(ActionType::ADD, key, value));
     maybeSaveObjectToDisk();
     p.setValue();
   });
   return sf;
 }
 
-folly::SemiFuture<bool>
-PersistentStore::erase(std::string key) {
-  folly::Promise<bool> p;
+folly::SemiFuture<folly::Unit>
+PersistentStore::storeMany(
+    std::vector<std::pair<std::string, std::string>> keyVals) {
+  folly::Promise<folly::Unit> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread(
-      [this, p = std::move(p), key = std::move(key)]() mutable noexcept {
-        SYSLOG(INFO) << "Erase key: " << key << " from config-store";
-        if (database_.keyVals_ref()->erase(key) > 0) {
-          auto pObject = toPersistentObject(ActionType::DEL, key, "");
-          pObjects_.emplace_back(std::move(pObject));
-          maybeSaveObjectToDisk();
-          p.setValue(true);
-        } else {
-          LOG(WARNING) << "Key: " << key << " doesn't exist";
-          p.setValue(false);
-        }
-      });
+  runInEventBaseThread([
+    this,
+    p = std::move(p),
+    keyVals = std::move(keyVals)
+  ]() mutable noexcept {
+    for (auto& [key, value] : keyVals) {
+      SYSLOG(INFO) << "Store key: " << key << ", value: " << value
+                   << " to config-store";
+      lazyValues_.erase(key);
+      database_.keyVals_ref()[key] = value;
+      addPersistentObject(toPersistentObject(ActionType::ADD, key, value));
+    }
+    if (not keyVals.empty()) {
+      maybeSaveObjectToDisk();
+    }
+    p.setValue();
+  });
   return sf;
 }
 
-folly::SemiFuture<std::optional<std::string>>
-PersistentStore::load(std::string key) {
-  folly::Promise<std::optional<std::string>> p;
-  auto sf = p.getSemiFuture();
-  runInEventBaseThread(
-      [this, p = std::move(p), key = std::move(key)]() mutable {
-        auto it = database_.keyVals_ref()->find(key);
-        if (it != database_.keyVals_ref()->end()) {
-          p.setValue(it->second);
-        } else {
-          p.setValue(std::nullopt);
-        }
-      });
-  return sf;
+void
+PersistentStore::addPersistentObject(PersistentObject pObject) {
+  auto [it, inserted] = pObjectIndices_.emplace(pObject.key, pObjects_.size());
+  if (inserted) {
+    pObjects_.emplace_back(std::move(pObject));
+  } else {
+    pObjects_.at(it->second) = std::move(pObject);
+    numOfCoalescedWrites_++;
+  }
 }
 
 void
@@ -136,6 +146,8 @@ PersistentStore::savePersistentObjectToDisk() noexcept {
     // Write PersistentObject to ioBuf
     std::vector<PersistentObject> newObjects;
     newObjects = std::move(pObjects_);
+    pObjects_.clear();
+    pObjectIndices_.clear();
 
     auto queue = folly::IOBufQueue(folly::IOBufQueue::cacheChainLength());
 
@@ -149,30 +161,31 @@ PersistentStore::savePersistentObjectToDisk() noexcept {
       queue.append(std::move(**buf));
     }
 
-    // Append IoBuf to disk
-    auto ioBuf = queue.move();
-    auto success = writeIoBufToDisk(ioBuf, WriteType::APPEND);
-    if (success.hasError()) {
-      LOG(ERROR) << "Failed to write PersistentObject to file '"
-                 << storageFilePath_
-                 << "'. Error: " << folly::exceptionStr(success.error());
-      return false;
-    }
-
     numOfNewWritesToDisk_++;
 
-    // Write the whole database to disk periodically
-    if (numOfNewWritesToDisk_ >= kDbFlushRatio) {
+    // Compact the whole database periodically. Snapshot is taken now, so
+    // that records appended later are queued behind the compaction.
+    std::optional<thrift::StoreDatabase> snapshot;
+    if (numOfNewWritesToDisk_ >= compactionRatio_) {
       numOfNewWritesToDisk_ = 0;
-      const auto startTs = std::chrono::steady_clock::now();
-      if (not saveDatabaseToDisk()) {
-        return false;
-      }
-      LOG(INFO) << "Updated database on disk. Took "
-                << std::chrono::duration_cast<std::chrono::milliseconds>(
-                       std::chrono::steady_clock::now() - startTs)
-                       .count()
-                << "ms";
+      materializeDatabase();
+      snapshot = database_;
+    }
+
+    // Hand off IoBuf to ioWorker_, which writes it in order of submission
+    auto written = folly::via(
+        ioWorker_.get(),
+        [this, ioBuf = queue.move(), snapshot = std::move(snapshot)]() mutable {
+          if (snapshot) {
+            return compactDatabaseOnDisk(*snapshot, std::move(ioBuf));
+          }
+          return appendRecordsToDisk(std::move(ioBuf));
+        });
+
+    // This is primarily used for unit testing, block till file is saved.
+    // Otherwise failed records are retried by ioWorker_ with next append.
+    if (not saveDbTimerBackoff_ and not std::move(written).get()) {
+      return false;
     }
   } else {
     VLOG(1) << "Skipping writing to disk in dryrun mode";
@@ -182,11 +195,61 @@ PersistentStore::savePersistentObjectToDisk() noexcept {
   return true;
 }
 
+bool
+PersistentStore::appendRecordsToDisk(
+    std::unique_ptr<folly::IOBuf> records) noexcept {
+  // Records failed before go first
+  if (records) {
+    unwrittenRecords_.append(std::move(records));
+  }
+  if (unwrittenRecords_.empty()) {
+    return true;
+  }
+
+  auto ioBuf = unwrittenRecords_.move();
+  auto success = writeIoBufToDisk(ioBuf, WriteType::APPEND);
+  if (success.hasError()) {
+    LOG(ERROR) << "Failed to write PersistentObject to file '"
+               << storageFilePath_
+               << "'. Error: " << folly::exceptionStr(success.error());
+    unwrittenRecords_.append(std::move(ioBuf));
+    return false;
+  }
+  return true;
+}
+
+bool
+PersistentStore::compactDatabaseOnDisk(
+    const thrift::StoreDatabase& snapshot,
+    std::unique_ptr<folly::IOBuf> records) noexcept {
+  const auto startTs = std::chrono::steady_clock::now();
+  if (not writeDatabaseToDisk(snapshot)) {
+    // Log on disk is still valid, keep appending to it
+    return appendRecordsToDisk(std::move(records));
+  }
+
+  // Snapshot covers all records, including the ones failed to be appended
+  unwrittenRecords_.move();
+  LOG(INFO) << "Compacted database on disk. Took "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - startTs)
+                   .count()
+            << "ms";
+  return true;
+}
+
 bool
 PersistentStore::saveDatabaseToDisk() noexcept {
+  materializeDatabase();
+  return writeDatabaseToDisk(database_);
+}
+
+bool
+PersistentStore::writeDatabaseToDisk(
+    const thrift::StoreDatabase& database) noexcept {
   std::unique_ptr<folly::IOBuf> ioBuf;
   // If database is empty, write 'kTlvFormatMarker' to disk and return
-  if (database_.keyVals_ref()->size() == 0) {
+  if (database.keyVals_ref()->size() == 0) {
     ioBuf = folly::IOBuf::copyBuffer(
         kTlvFormatMarker.data(), kTlvFormatMarker.size());
   } else {
@@ -194,8 +257,8 @@ PersistentStore::saveDatabaseToDisk() noexcept {
     auto queue = folly::IOBufQueue(folly::IOBufQueue::cacheChainLength());
     queue.append(kTlvFormatMarker.data(), kTlvFormatMarker.size());
 
-    // Encode database_ and append to queue
-    for (auto& keyPair : *database_.keyVals_ref()) {
+    // Encode database and append to queue
+    for (auto& keyPair : *database.keyVals_ref()) {
       PersistentObject pObject;
       pObject =
           toPersistentObject(ActionType::ADD, keyPair.first, keyPair.second);
@@ -230,16 +293,17 @@ PersistentStore::loadDatabaseFromDisk() noexcept {
     return true;
   }
 
-  // Read data from file
-  std::string fileData{""};
-  if (not folly::readFile(storageFilePath_.c_str(), fileData)) {
-    LOG(ERROR) << "Failed to read file contents from '" << storageFilePath_
-               << "'. Error (" << errno << "): " << folly::errnoStr(errno);
+  // Map file instead of reading it, only values accessed get copied out
+  try {
+    mapping_ = std::make_unique<folly::MemoryMapping>(storageFilePath_.c_str());
+  } catch (std::exception const& e) {
+    LOG(ERROR) << "Failed to map file '" << storageFilePath_
+               << "'. Error: " << folly::exceptionStr(e);
     return false;
   }
 
   // Create IoBuf and cursor for loading data from disk
-  auto ioBuf = folly::IOBuf::wrapBuffer(fileData.c_str(), fileData.size());
+  auto ioBuf = folly::IOBuf::wrapBuffer(mapping_->range());
   folly::io::Cursor cursor(ioBuf.get());
 
   // Read 'kTlvFormatMarker' from ioBuf
@@ -247,6 +311,7 @@ PersistentStore::loadDatabaseFromDisk() noexcept {
       cursor.readFixedString(kTlvFormatMarker.size()) != kTlvFormatMarker) {
     // Load old Format and write TlvFormat
     auto oldSuccess = loadDatabaseOldFormat(ioBuf);
+    mapping_.reset();
     if (oldSuccess.hasError()) {
       LOG(ERROR) << "Failed to read old-format file contents from '"
                  << storageFilePath_
@@ -256,13 +321,25 @@ PersistentStore::loadDatabaseFromDisk() noexcept {
     return true;
   }
   // Load TlvFormat
+  const auto startTs = std::chrono::steady_clock::now();
   auto tlvSuccess = loadDatabaseTlvFormat(ioBuf);
   if (tlvSuccess.hasError()) {
     LOG(ERROR) << "Failed to read Tlv-format file contents from '"
                << storageFilePath_
                << "'. Error: " << folly::exceptionStr(tlvSuccess.error());
+    lazyValues_.clear();
+    mapping_.reset();
     return false;
   }
+  LOG(INFO) << "Indexed " << lazyValues_.size() << " keys from "
+            << storageFilePath_ << ". Took "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - startTs)
+                   .count()
+            << "ms";
+  if (lazyValues_.empty()) {
+    mapping_.reset();
+  }
   return true;
 }
 
@@ -286,61 +363,90 @@ PersistentStore::loadDatabaseOldFormat(
 folly::Expected<folly::Unit, std::string>
 PersistentStore::loadDatabaseTlvFormat(
     const std::unique_ptr<folly::IOBuf>& ioBuf) noexcept {
-  // Parse ioBuf to persistentObject and then to `database_`
+  // Index records of ioBuf into `lazyValues_`. Same layout as
+  // decodePersistentObject(), but values are only referred, not copied.
+  CHECK(not ioBuf->isChained());
   folly::io::Cursor cursor(ioBuf.get());
-  thrift::StoreDatabase newDatabase;
-  // Read 'kTlvFormatMarker'
+  std::unordered_map<std::string, folly::StringPiece> newValues;
   try {
-    cursor.readFixedString(kTlvFormatMarker.size());
+    // Read 'kTlvFormatMarker'
+    cursor.skip(kTlvFormatMarker.size());
+
+    // Iteratively index persistentObject till end of file
+    while (cursor.canAdvance(1)) {
+      const auto type = ActionType(cursor.readBE<uint8_t>());
+      auto key = cursor.readFixedString(cursor.readBE<uint32_t>());
+      const auto length = cursor.readBE<uint32_t>();
+      const folly::StringPiece value(
+          reinterpret_cast<const char*>(cursor.data()), length);
+      cursor.skip(length);
+
+      // Add/Delete persistentObject to/from 'newValues'
+      if (type == ActionType::ADD) {
+        newValues.insert_or_assign(std::move(key), value);
+      } else if (type == ActionType::DEL) {
+        newValues.erase(key);
+      }
+    }
   } catch (std::out_of_range& e) {
     return folly::makeUnexpected<std::string>(
         folly::exceptionStr(e).toStdString());
   }
-  // Iteratively read persistentObject from disk
-  while (true) {
-    // Read and decode into persistentObject
-    auto optionalObject = decodePersistentObject(cursor);
-    if (optionalObject.hasError()) {
-      return folly::makeUnexpected(optionalObject.error());
-    }
+  database_ = thrift::StoreDatabase();
+  lazyValues_ = std::move(newValues);
+  return folly::Unit();
+}
 
-    // Read finish
-    if (not optionalObject->has_value()) {
-      break;
-    }
-    auto pObject = std::move(optionalObject->value());
-
-    // Add/Delete persistentObject to/from 'newDatabase'
-    if (pObject.type == ActionType::ADD) {
-      newDatabase.keyVals_ref()[pObject.key] =
-          pObject.data.has_value() ? pObject.data.value() : "";
-    } else if (pObject.type == ActionType::DEL) {
-      newDatabase.keyVals_ref()->erase(pObject.key);
-    }
+void
+PersistentStore::materializeValue(const std::string& key) {
+  auto it = lazyValues_.find(key);
+  if (it == lazyValues_.end()) {
+    return;
+  }
+  database_.keyVals_ref()[key] = it->second.str();
+  lazyValues_.erase(it);
+  if (lazyValues_.empty()) {
+    mapping_.reset();
   }
-  database_ = std::move(newDatabase);
-  return folly::Unit();
 }
 
-// Write over or append IoBuf to disk atomically
+void
+PersistentStore::materializeDatabase() {
+  for (auto& [key, value] : lazyValues_) {
+    database_.keyVals_ref()[key] = value.str();
+  }
+  lazyValues_.clear();
+  mapping_.reset();
+}
+
+// Write over atomically or append IoBuf to disk. Data is synced once per
+// call, so a batch of appended records costs a single sync.
 folly::Expected<folly::Unit, std::string>
 PersistentStore::writeIoBufToDisk(
     const std::unique_ptr<folly::IOBuf>& ioBuf, WriteType writeType) noexcept {
-  std::string fileData("");
   try {
+    // NOTE: ioBuf is left intact, so that caller can retry with it
     ioBuf->coalesce();
-    fileData = ioBuf->moveToFbString().toStdString();
+    const folly::StringPiece fileData(
+        reinterpret_cast<const char*>(ioBuf->data()), ioBuf->length());
 
     if (writeType == WriteType::WRITE) {
       // Write over
-      folly::writeFileAtomic(storageFilePath_.c_str(), fileData, 0666);
+      folly::writeFileAtomic(
+          storageFilePath_.c_str(),
+          fileData,
+          0666,
+          folly::SyncType::WITH_SYNC);
     } else {
       // Append to file
-      folly::writeFile(
-          fileData,
-          storageFilePath_.c_str(),
-          O_WRONLY | O_APPEND | O_CREAT,
-          0666);
+      folly::File file(
+          storageFilePath_.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0666);
+      if (folly::writeFull(file.fd(), fileData.data(), fileData.size()) < 0) {
+        folly::throwSystemError("Failed to append to file");
+      }
+      if (folly::fdatasyncNoInt(file.fd()) < 0) {
+        folly::throwSystemError("Failed to sync file");
+      }
     }
   } catch (std::exception const& e) {
     return folly::makeUnexpected<std::string>(
@@ -16,8 +16,14 @@ namespace fs = std::filesystem;
 namespace fs = std::experimental::filesystem;
 #endif
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/futures/Future.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/system/MemoryMapping.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include <openr/common/Constants.h>
@@ -51,13 +57,25 @@ struct PersistentObject {
  *
  * `storageFilePath`: Describe the path of file in file system where data will
  * be stored/retrieved from (in binary format).
+ *
+ * File is a log of TLV records, appended on every change. Changes to a key
+ * made while previous ones are pending in the backoff window are coalesced
+ * into a single record. Every `compactionRatio` appends, the log is compacted
+ * into a snapshot of the whole database. All disk IO happens on a background
+ * thread in order of submission, so neither appends nor compaction stall
+ * store()/load() callers. Compaction swaps the file atomically, records
+ * appended meanwhile go to the new file.
+ *
+ * On start the file is memory-mapped and only indexed, values are copied out
+ * of the mapping on first access.
  */
 class PersistentStore : public OpenrEventBase {
  public:
   PersistentStore(
       const std::string& storageFilePath,
       bool dryrun = false,
-      bool periodicallySaveToDisk = true);
+      bool periodicallySaveToDisk = true,
+      uint64_t compactionRatio = Constants::kPersistentStoreCompactionRatio);
 
   // Destructor will try to save DB to disk before destroying the object
   ~PersistentStore() override;
@@ -67,6 +85,11 @@ class PersistentStore : public OpenrEventBase {
     return numOfWritesToDisk_;
   }
 
+  uint64_t
+  getNumOfCoalescedWrites() const {
+    return numOfCoalescedWrites_;
+  }
+
   /**
    * Encode/Decode a PersistentObject, this can be private method, but for unit
    * test, we make it public
@@ -83,6 +106,10 @@ class PersistentStore : public OpenrEventBase {
   // Store key-value
   folly::SemiFuture<folly::Unit> store(std::string key, std::string value);
 
+  // Store multiple key-values at once, flushed to disk together
+  folly::SemiFuture<folly::Unit> storeMany(
+      std::vector<std::pair<std::string, std::string>> keyVals);
+
   // Get value for a key. `nullptr` will be returned if key doesn't exists
   folly::SemiFuture<std::optional<std::string>> load(std::string key);
 
@@ -123,21 +150,49 @@ class PersistentStore : public OpenrEventBase {
   bool saveDatabaseToDisk() noexcept;
   bool loadDatabaseFromDisk() noexcept;
 
+  // Replace file on disk atomically with snapshot of database
+  bool writeDatabaseToDisk(const thrift::StoreDatabase& database) noexcept;
+
   // Load old format file from disk, this is for compatible with the old version
   folly::Expected<folly::Unit, std::string> loadDatabaseOldFormat(
       const std::unique_ptr<folly::IOBuf>& ioBuf) noexcept;
 
-  // Load TlvFormat from disk
+  // Index TlvFormat from disk into lazyValues_
   folly::Expected<folly::Unit, std::string> loadDatabaseTlvFormat(
       const std::unique_ptr<folly::IOBuf>& ioBuf) noexcept;
 
+  // Copy value of key out of mapping_ into `database_`, if not done yet
+  void materializeValue(const std::string& key);
+
+  // Copy all values out of mapping_ and release it, e.g. before the whole
+  // `database_` is written
+  void materializeDatabase();
+
+  // Queue persistent object for next save. Replaces pending object of same
+  // key, so only the latest update of a key within backoff window is written
+  void addPersistentObject(PersistentObject pObject);
+
   // Wrapper function to save persistent object to disk immediately or later
   void maybeSaveObjectToDisk() noexcept;
 
-  // Function to save Persistent Object to local disk.
+  // Function to save Persistent Object to local disk. Only hands off the
+  // write to ioWorker_, unless periodicallySaveToDisk is false.
   bool savePersistentObjectToDisk() noexcept;
 
-  // Write IoBuf ro local disk
+  //
+  // Run on ioWorker_ only
+  //
+
+  // Append encoded records to the log on disk
+  bool appendRecordsToDisk(std::unique_ptr<folly::IOBuf> records) noexcept;
+
+  // Replace log on disk with snapshot. On failure log is kept, and records,
+  // which are covered by snapshot, are appended to it instead.
+  bool compactDatabaseOnDisk(
+      const thrift::StoreDatabase& snapshot,
+      std::unique_ptr<folly::IOBuf> records) noexcept;
+
+  // Write IoBuf ro local disk and sync it
   folly::Expected<folly::Unit, std::string> writeIoBufToDisk(
       const std::unique_ptr<folly::IOBuf>& ioBuf, WriteType writeType) noexcept;
 
@@ -151,6 +206,9 @@ class PersistentStore : public OpenrEventBase {
   // Keeps track of number of writes of PersistentObject to disk
   std::atomic<std::uint64_t> numOfNewWritesToDisk_{0};
 
+  // Keeps track of number of updates collapsed into a pending one
+  std::atomic<std::uint64_t> numOfCoalescedWrites_{0};
+
   // Location on disk where data will be synced up. A file will be created
   // if doesn't exists.
   const fs::path storageFilePath_;
@@ -158,6 +216,9 @@ class PersistentStore : public OpenrEventBase {
   // Dryrun to avoid disk writes in UTs
   bool dryrun_{false};
 
+  // Number of appends before compacting the log on disk
+  const uint64_t compactionRatio_{0};
+
   // Timer for saving database to disk
   std::unique_ptr<folly::AsyncTimeout> saveDbTimer_;
   std::unique_ptr<ExponentialBackoff<std::chrono::milliseconds>>
@@ -167,11 +228,29 @@ class PersistentStore : public OpenrEventBase {
   // layer (disk) in a file.
   thrift::StoreDatabase database_;
 
+  // File loaded on start, kept mapped till all its values are materialized
+  std::unique_ptr<folly::MemoryMapping> mapping_;
+
+  // Values in mapping_ of keys not accessed since start. A key is either in
+  // here or in `database_`, never in both.
+  std::unordered_map<std::string, folly::StringPiece> lazyValues_;
+
   // Serializer for encoding/decoding of thrift objects
   apache::thrift::CompactSerializer serializer_;
 
-  // Define a persistent object
+  // Persistent objects pending to be saved, at most one per key
   std::vector<PersistentObject> pObjects_;
+
+  // Index of pending object of a key in pObjects_
+  std::unordered_map<std::string, size_t> pObjectIndices_;
+
+  // Records failed to be appended, retried with next append. Only accessed
+  // on ioWorker_
+  folly::IOBufQueue unwrittenRecords_{folly::IOBufQueue::cacheChainLength()};
+
+  // Single thread doing all disk IO, not set in dryrun mode. Joined on
+  // destruction before final save, as its tasks refer to this
+  std::unique_ptr<folly::CPUThreadPoolExecutor> ioWorker_;
 };
 
 } // namespace openr
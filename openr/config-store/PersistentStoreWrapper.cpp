@@ -9,10 +9,15 @@
 
 namespace openr {
 
-PersistentStoreWrapper::PersistentStoreWrapper(const unsigned long tid)
+PersistentStoreWrapper::PersistentStoreWrapper(
+    const unsigned long tid, uint64_t compactionRatio)
     : filePath(folly::sformat("/tmp/aq_persistent_store_test_{}", tid)) {
   VLOG(1) << "PersistentStoreWrapper: Creating PersistentStore.";
-  store_ = std::make_unique<PersistentStore>(filePath);
+  store_ = std::make_unique<PersistentStore>(
+      filePath,
+      false /* dryrun */,
+      true /* periodicallySaveToDisk */,
+      compactionRatio);
 }
 
 void
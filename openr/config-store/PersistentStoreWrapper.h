@@ -13,7 +13,9 @@ namespace openr {
 
 class PersistentStoreWrapper {
  public:
-  explicit PersistentStoreWrapper(const unsigned long tid);
+  explicit PersistentStoreWrapper(
+      const unsigned long tid,
+      uint64_t compactionRatio = Constants::kPersistentStoreCompactionRatio);
 
   // Destructor will try to save DB to disk before destroying the object
   ~PersistentStoreWrapper() {
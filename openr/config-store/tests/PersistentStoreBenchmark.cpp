@@ -9,6 +9,7 @@
 #include <folly/Random.h>
 #include <folly/init/Init.h>
 #include <openr/config-store/PersistentStoreWrapper.h>
+#include <openr/tests/BenchmarkDriver.h>
 
 namespace {
 // kIterations <= n: change this to 10 singce n starts from 10,
@@ -91,6 +92,77 @@ BM_PersistentStoreWrite(uint32_t iters, size_t numOfStringKeys) {
   eraseKeyFromStore(stringKeys, *store);
 }
 
+/**
+ * Benchmark for writing keys to store in a single batch
+ * 1. Generate random keys
+ * 2. Write all keys to store with one storeMany call
+ * 3. Erase keys
+ */
+void
+BM_PersistentStoreWriteMany(uint32_t iters, size_t numOfStringKeys) {
+  auto suspender = folly::BenchmarkSuspender();
+  const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+  // Create new storeWrapper and perform some operations on it
+  auto store = std::make_unique<PersistentStoreWrapper>(tid);
+  store->run();
+
+  // Generate keys
+  auto stringKeys = constructRandomVector(numOfStringKeys);
+  writeKeyValueToStore(stringKeys, *store, 1);
+
+  for (uint32_t i = 0; i < iters; i++) {
+    std::vector<std::pair<std::string, std::string>> keyVals;
+    keyVals.reserve(stringKeys.size());
+    for (auto const& key : stringKeys) {
+      keyVals.emplace_back(
+          key, folly::sformat("val-{}", folly::Random::rand32()));
+    }
+    suspender.dismiss(); // Start measuring benchmark time
+    (*store)->storeMany(std::move(keyVals)).get();
+    suspender.rehire(); // Stop measuring time again
+  }
+
+  // Erase the keys and stop store before exiting
+  eraseKeyFromStore(stringKeys, *store);
+}
+
+/**
+ * Benchmark for repeatedly writing few hot keys to store, updates within
+ * backoff window get coalesced into a single record on disk
+ * 1. Generate random keys
+ * 2. Write each key numOfStringKeys times without awaiting the result
+ * 3. Erase keys
+ */
+void
+BM_PersistentStoreHotKeyWrite(uint32_t iters, size_t numOfStringKeys) {
+  auto suspender = folly::BenchmarkSuspender();
+  const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+  // Create new storeWrapper and perform some operations on it
+  auto store = std::make_unique<PersistentStoreWrapper>(tid);
+  store->run();
+
+  // Generate keys
+  auto stringKeys = constructRandomVector(kIterations);
+  writeKeyValueToStore(stringKeys, *store, 1);
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    for (size_t n = 0; n < numOfStringKeys; ++n) {
+      for (auto const& key : stringKeys) {
+        (*store)->store(key, folly::sformat("val-{}", n));
+      }
+    }
+    // Wait till all the writes are processed
+    (*store)->load(stringKeys.front()).get();
+  }
+
+  suspender.rehire(); // Stop measuring time again
+  // Erase the keys and stop store before exiting
+  eraseKeyFromStore(stringKeys, *store);
+}
+
 /**
  * Benchmark for loading keys from store
  * 1. Generate random keys
@@ -125,6 +197,46 @@ BM_PersistentStoreLoad(uint32_t iters, size_t numOfStringKeys) {
   eraseKeyFromStore(stringKeys, *store);
 }
 
+/**
+ * Benchmark for mixed writes and loads while database is being compacted
+ * 1. Generate random keys
+ * 2. Write keys to store, which gets compacted on every flush to disk
+ * 3. Alternately write and load keys, compaction keeps running meanwhile
+ * 4. Erase keys
+ */
+void
+BM_PersistentStoreMixedUnderCompaction(uint32_t iters, size_t numOfStringKeys) {
+  auto suspender = folly::BenchmarkSuspender();
+  const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+  // Create storeWrapper compacting on every flush to disk
+  auto store =
+      std::make_unique<PersistentStoreWrapper>(tid, 1 /* compactionRatio */);
+  store->run();
+
+  // Generate keys
+  auto stringKeys = constructRandomVector(numOfStringKeys);
+  writeKeyValueToStore(stringKeys, *store, 1);
+  auto iterations =
+      (stringKeys.size() / kIterations == 0) ? stringKeys.size() : kIterations;
+
+  suspender.dismiss(); // Start measuring benchmark time
+  for (uint32_t i = 0; i < iters; i++) {
+    for (size_t index = 0; index < stringKeys.size();
+         index += stringKeys.size() / iterations) {
+      (*store)
+          ->store(
+              stringKeys[index],
+              folly::sformat("val-{}", folly::Random::rand32()))
+          .get();
+      (*store)->load(stringKeys[index]).get();
+    }
+  }
+  suspender.rehire(); // Stop measuring time again
+  // Erase the keys and stop store before exiting
+  eraseKeyFromStore(stringKeys, *store);
+}
+
 /**
  * Benchmark for Creating/Destroing a store
  * 1. Generate random keys
@@ -163,11 +275,26 @@ BENCHMARK_PARAM(BM_PersistentStoreWrite, 100);
 BENCHMARK_PARAM(BM_PersistentStoreWrite, 1000);
 BENCHMARK_PARAM(BM_PersistentStoreWrite, 10000);
 
+BENCHMARK_PARAM(BM_PersistentStoreWriteMany, 10);
+BENCHMARK_PARAM(BM_PersistentStoreWriteMany, 100);
+BENCHMARK_PARAM(BM_PersistentStoreWriteMany, 1000);
+BENCHMARK_PARAM(BM_PersistentStoreWriteMany, 10000);
+
+BENCHMARK_PARAM(BM_PersistentStoreHotKeyWrite, 10);
+BENCHMARK_PARAM(BM_PersistentStoreHotKeyWrite, 100);
+BENCHMARK_PARAM(BM_PersistentStoreHotKeyWrite, 1000);
+BENCHMARK_PARAM(BM_PersistentStoreHotKeyWrite, 10000);
+
 BENCHMARK_PARAM(BM_PersistentStoreLoad, 10);
 BENCHMARK_PARAM(BM_PersistentStoreLoad, 100);
 BENCHMARK_PARAM(BM_PersistentStoreLoad, 1000);
 BENCHMARK_PARAM(BM_PersistentStoreLoad, 10000);
 
+BENCHMARK_PARAM(BM_PersistentStoreMixedUnderCompaction, 10);
+BENCHMARK_PARAM(BM_PersistentStoreMixedUnderCompaction, 100);
+BENCHMARK_PARAM(BM_PersistentStoreMixedUnderCompaction, 1000);
+BENCHMARK_PARAM(BM_PersistentStoreMixedUnderCompaction, 10000);
+
 BENCHMARK_PARAM(BM_PersistentStoreCreateDestroy, 10);
 BENCHMARK_PARAM(BM_PersistentStoreCreateDestroy, 100);
 BENCHMARK_PARAM(BM_PersistentStoreCreateDestroy, 1000);
@@ -178,6 +305,5 @@ BENCHMARK_PARAM(BM_PersistentStoreCreateDestroy, 10000);
 int
 main(int argc, char** argv) {
   folly::init(&argc, &argv);
-  folly::runBenchmarks();
-  return 0;
+  return openr::runBenchmarks();
 }
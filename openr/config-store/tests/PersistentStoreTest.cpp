@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <cstdio>
 #include <thread>
 #include <utility>
 
@@ -180,6 +181,121 @@ TEST(PersistentStoreTest, EncodeDecodePersistentObject) {
   EXPECT_EQ(false, pObjectGetDel.data.has_value());
 }
 
+TEST(PersistentStoreTest, Compaction) {
+  const auto filePath = folly::sformat(
+      "/tmp/aq_persistent_store_compaction_test_{}",
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+  std::remove(filePath.c_str());
+
+  // Every write is synchronous, log is compacted every 4th one
+  PersistentStore store(
+      filePath,
+      false /* dryrun */,
+      false /* periodicallySaveToDisk */,
+      4 /* compactionRatio */);
+  std::thread storeThread([&store]() { store.run(); });
+  store.waitUntilRunning();
+
+  for (auto index = 1; index <= 8; index++) {
+    store.store("key", folly::sformat("val-{}", index)).get();
+  }
+
+  // Compacted into latest value only
+  thrift::StoreDatabase database;
+  database.keyVals_ref()["key"] = "val-8";
+  EXPECT_EQ(database, loadDatabaseFromDisk(filePath));
+  PersistentObject pObject{ActionType::ADD, "key", std::string("val-8")};
+  const auto recordSize =
+      (*PersistentStore::encodePersistentObject(pObject))->length();
+  EXPECT_EQ(kTlvFormatMarker.size() + recordSize, fs::file_size(filePath));
+
+  // Records are appended to the compacted log
+  store.store("key", "val-9").get();
+  store.store("key2", "val").get();
+  database.keyVals_ref()["key"] = "val-9";
+  database.keyVals_ref()["key2"] = "val";
+  EXPECT_EQ(database, loadDatabaseFromDisk(filePath));
+  EXPECT_EQ(
+      kTlvFormatMarker.size() + 3 * recordSize - 1, fs::file_size(filePath));
+
+  store.stop();
+  storeThread.join();
+}
+
+TEST(PersistentStoreTest, StoreManyCoalescing) {
+  const auto filePath = folly::sformat(
+      "/tmp/aq_persistent_store_coalescing_test_{}",
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+  std::remove(filePath.c_str());
+
+  // Every write is synchronous and compacted, so file holds a snapshot
+  PersistentStore store(
+      filePath,
+      false /* dryrun */,
+      false /* periodicallySaveToDisk */,
+      1 /* compactionRatio */);
+  std::thread storeThread([&store]() { store.run(); });
+  store.waitUntilRunning();
+
+  // Batch is flushed with a single write, updates of same key collapse
+  store
+      .storeMany(
+          {{"key1", "val-1"}, {"key2", "val-2"}, {"key1", "val-1-new"}})
+      .get();
+  EXPECT_EQ(1, store.getNumOfDbWritesToDisk());
+  EXPECT_EQ(1, store.getNumOfCoalescedWrites());
+  EXPECT_EQ("val-1-new", store.load("key1").get());
+  EXPECT_EQ("val-2", store.load("key2").get());
+
+  thrift::StoreDatabase database;
+  database.keyVals_ref() = {{"key1", "val-1-new"}, {"key2", "val-2"}};
+  EXPECT_EQ(database, loadDatabaseFromDisk(filePath));
+
+  // Empty batch is a no-op
+  store.storeMany({}).get();
+  EXPECT_EQ(1, store.getNumOfDbWritesToDisk());
+
+  store.stop();
+  storeThread.join();
+}
+
+TEST(PersistentStoreTest, LazyLoad) {
+  const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+  std::string filePath;
+  {
+    PersistentStoreWrapper store(tid);
+    store.run();
+    filePath = store.filePath;
+    for (auto& [key, _] : *loadDatabaseFromDisk(filePath).keyVals_ref()) {
+      store->erase(key).get();
+    }
+    store->store("key1", "val1").get();
+    store->store("key2", "val2").get();
+    store->store("key3", "val3").get();
+    store->store("key4", "").get();
+  }
+
+  // Values get loaded from mapped file on first access only. Untouched ones
+  // are kept as well on save.
+  {
+    PersistentStoreWrapper store(tid);
+    store.run();
+    EXPECT_EQ("val1", store->load("key1").get());
+    EXPECT_EQ("val1", store->load("key1").get());
+    EXPECT_TRUE(store->erase("key2").get());
+    EXPECT_FALSE(store->erase("key2").get());
+    store->store("key3", "val3-new").get();
+    EXPECT_EQ("", store->load("key4").get());
+    EXPECT_EQ(std::nullopt, store->load("key5").get());
+  }
+
+  thrift::StoreDatabase database;
+  database.keyVals_ref() = {
+      {"key1", "val1"}, {"key3", "val3-new"}, {"key4", ""}};
+  EXPECT_EQ(database, loadDatabaseFromDisk(filePath));
+}
+
 TEST(PersistentStoreTest, BulkStoreLoad) {
   const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id());
 
@@ -1,5 +1,10 @@
 // Copyright 2004-present Facebook. All Rights Reserved.
 
+#include <sched.h>
+
+#include <cmath>
+#include <unordered_set>
+
 #include <folly/FileUtil.h>
 #include <glog/logging.h>
 #include <openr/if/gen-cpp2/KvStore_constants.h>
@@ -15,6 +20,89 @@ using openr::thrift::PrefixForwardingType;
 
 namespace openr {
 
+AreaMatcher::AreaMatcher(const std::vector<thrift::AreaConfig>& areas) {
+  re2::RE2::Options regexOpts;
+  regexOpts.set_case_sensitive(false);
+
+  // patterns are validated per area by Config::addAreaRegex
+  auto addRegexes = [&regexOpts](
+                        std::shared_ptr<re2::RE2::Set>& regexSet,
+                        std::vector<size_t>& regexArea,
+                        const std::vector<std::string>& regexes,
+                        size_t areaIdx) {
+    for (const auto& regexStr : regexes) {
+      if (not regexSet) {
+        regexSet =
+            std::make_shared<re2::RE2::Set>(regexOpts, re2::RE2::ANCHOR_BOTH);
+      }
+      std::string regexErr;
+      if (-1 == regexSet->Add(regexStr, &regexErr)) {
+        throw std::invalid_argument(folly::sformat(
+            "Failed to add regex: {}. Error: {}", regexStr, regexErr));
+      }
+      regexArea.emplace_back(areaIdx);
+    }
+  };
+
+  for (const auto& area : areas) {
+    const auto areaIdx = areas_.size();
+    areas_.emplace_back(Area{
+        *area.area_id_ref(),
+        not area.neighbor_regexes_ref()->empty(),
+        not area.interface_regexes_ref()->empty()});
+    addRegexes(
+        neighborRegexSet_,
+        neighborRegexArea_,
+        *area.neighbor_regexes_ref(),
+        areaIdx);
+    addRegexes(
+        interfaceRegexSet_,
+        interfaceRegexArea_,
+        *area.interface_regexes_ref(),
+        areaIdx);
+  }
+
+  if ((neighborRegexSet_ and not neighborRegexSet_->Compile()) or
+      (interfaceRegexSet_ and not interfaceRegexSet_->Compile())) {
+    throw std::invalid_argument(
+        folly::sformat("Area regex compilation failed"));
+  }
+}
+
+std::vector<std::string>
+AreaMatcher::match(
+    const std::string& neighborName, const std::string& ifName) const {
+  auto matchAreas = [this](
+                        const std::shared_ptr<re2::RE2::Set>& regexSet,
+                        const std::vector<size_t>& regexArea,
+                        const std::string& name) {
+    std::vector<bool> matched(areas_.size(), false);
+    std::vector<int> matches;
+    if (regexSet and regexSet->Match(name, &matches)) {
+      for (auto regexIdx : matches) {
+        matched.at(regexArea.at(regexIdx)) = true;
+      }
+    }
+    return matched;
+  };
+  const auto neighborMatched =
+      matchAreas(neighborRegexSet_, neighborRegexArea_, neighborName);
+  const auto interfaceMatched =
+      matchAreas(interfaceRegexSet_, interfaceRegexArea_, ifName);
+
+  std::vector<std::string> matchedAreas;
+  for (size_t i = 0; i < areas_.size(); ++i) {
+    const auto& area = areas_.at(i);
+    const bool matched = area.hasNeighborRegex and area.hasInterfaceRegex
+        ? (neighborMatched.at(i) and interfaceMatched.at(i))
+        : (neighborMatched.at(i) or interfaceMatched.at(i));
+    if (matched) {
+      matchedAreas.emplace_back(area.areaId);
+    }
+  }
+  return matchedAreas;
+}
+
 Config::Config(const std::string& configFile) {
   std::string contents;
   if (not folly::readFile(configFile.c_str(), contents)) {
@@ -35,6 +123,29 @@ Config::Config(const std::string& configFile) {
   populateInternalDb();
 }
 
+std::shared_ptr<const Config>
+Config::createReloadedConfig(thrift::OpenrConfig newConfig) const {
+  auto withoutTunables = [](thrift::OpenrConfig config) {
+    config.kvstore_config_ref()->flood_rate_ref().reset();
+    config.decision_config_ref()->debounce_min_ms_ref().reset();
+    config.decision_config_ref()->debounce_max_ms_ref().reset();
+    config.fib_sync_batch_size_ref() = 0;
+    return config;
+  };
+  if (not(withoutTunables(config_) == withoutTunables(newConfig))) {
+    throw std::invalid_argument(
+        "Only kvstore flood_rate, decision debounce_min_ms/debounce_max_ms "
+        "and fib_sync_batch_size can be changed without restart");
+  }
+
+  try {
+    return std::make_shared<const Config>(std::move(newConfig), version_ + 1);
+  } catch (const std::exception& ex) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid config: {}", folly::exceptionStr(ex).toStdString()));
+  }
+}
+
 std::string
 Config::getRunningConfig() const {
   auto jsonSerializer = apache::thrift::SimpleJSONSerializer();
@@ -173,7 +284,20 @@ Config::populateAreaConfig() {
         *areaConfig.area_id_ref(),
         *areaConfig.neighbor_regexes_ref(),
         *areaConfig.interface_regexes_ref());
+
+    for (const auto& summary : *areaConfig.summary_prefixes_ref()) {
+      try {
+        folly::IPAddress::createNetwork(summary);
+      } catch (const std::exception& ex) {
+        throw std::invalid_argument(folly::sformat(
+            "Invalid summary prefix: {} for area: {}. Error: {}",
+            summary,
+            *areaConfig.area_id_ref(),
+            folly::exceptionStr(ex)));
+      }
+    }
   }
+  areaMatcher_ = std::make_shared<AreaMatcher>(*config_.areas_ref());
 }
 
 void
@@ -202,6 +326,24 @@ Config::populateInternalDb() {
     throw std::invalid_argument(folly::sformat(
         "enable_ordered_fib_programming only support single area config"));
   }
+  if (*config_.fib_sync_batch_size_ref() <= 0) {
+    throw std::out_of_range(folly::sformat(
+        "fib_sync_batch_size ({}) should be > 0",
+        *config_.fib_sync_batch_size_ref()));
+  }
+  std::unordered_set<int32_t> fibPorts{*config_.fib_port_ref()};
+  for (auto const port : *config_.additional_fib_ports_ref()) {
+    if (not fibPorts.emplace(port).second) {
+      throw std::invalid_argument(folly::sformat(
+          "additional_fib_ports has port {} more than once or as fib_port",
+          port));
+    }
+  }
+  if (*config_.netlink_recv_buffer_bytes_ref() <= 0) {
+    throw std::out_of_range(folly::sformat(
+        "netlink_recv_buffer_bytes ({}) should be > 0",
+        *config_.netlink_recv_buffer_bytes_ref()));
+  }
 
   //
   // Kvstore
@@ -215,6 +357,38 @@ Config::populateInternalDb() {
       throw std::out_of_range("kvstore flood_msg_burst_size should be > 0");
     }
   }
+  if (*kvConf.merge_threads_ref() <= 0) {
+    throw std::out_of_range(folly::sformat(
+        "kvstore merge_threads ({}) should be > 0",
+        *kvConf.merge_threads_ref()));
+  }
+  if (auto minBytes = kvConf.value_compression_min_bytes_ref();
+      minBytes.has_value() and *minBytes <= 0) {
+    throw std::out_of_range(folly::sformat(
+        "kvstore value_compression_min_bytes ({}) should be > 0", *minBytes));
+  }
+  if (auto syncPeers = kvConf.initial_sync_peers_ref();
+      syncPeers.has_value() and *syncPeers <= 0) {
+    throw std::out_of_range(folly::sformat(
+        "kvstore initial_sync_peers ({}) should be > 0", *syncPeers));
+  }
+  if (auto batchWindow = kvConf.local_set_batch_window_ms_ref();
+      batchWindow.has_value() and *batchWindow <= 0) {
+    throw std::out_of_range(folly::sformat(
+        "kvstore local_set_batch_window_ms ({}) should be > 0",
+        *batchWindow));
+  }
+  for (const auto& floodScope : *kvConf.flood_scopes_ref()) {
+    if (floodScope.key_prefix_ref()->empty()) {
+      throw std::invalid_argument("kvstore flood scope key_prefix is empty");
+    }
+    if (*floodScope.scope_ref() == thrift::KvstoreFloodScopeType::SUBSCRIBERS
+        and floodScope.subscribers_ref()->empty()) {
+      throw std::invalid_argument(folly::sformat(
+          "kvstore flood scope of {} has no subscribers",
+          *floodScope.key_prefix_ref()));
+    }
+  }
 
   //
   // Spark
@@ -315,6 +489,51 @@ Config::populateInternalDb() {
         *sparkConfig.step_detector_conf_ref()->upper_threshold_ref()));
   }
 
+  if (*sparkConfig.num_shards_ref() <= 0) {
+    throw std::out_of_range(folly::sformat(
+        "num_shards ({}) should be > 0", *sparkConfig.num_shards_ref()));
+  }
+
+  if (*sparkConfig.liveness_detect_time_ms_ref() < 0) {
+    throw std::out_of_range(folly::sformat(
+        "liveness_detect_time_ms ({}) should be >= 0",
+        *sparkConfig.liveness_detect_time_ms_ref()));
+  }
+
+  //
+  // Decision
+  //
+  const auto& decisionConfig = *config_.decision_config_ref();
+  if (*decisionConfig.route_build_threads_ref() <= 0) {
+    throw std::out_of_range(folly::sformat(
+        "route_build_threads ({}) should be > 0",
+        *decisionConfig.route_build_threads_ref()));
+  }
+  if (*decisionConfig.memoized_results_max_bytes_ref() < 0) {
+    throw std::out_of_range(folly::sformat(
+        "memoized_results_max_bytes ({}) should be >= 0",
+        *decisionConfig.memoized_results_max_bytes_ref()));
+  }
+  if (const auto& engine = decisionConfig.route_engine_ref();
+      engine.has_value() and engine->empty()) {
+    throw std::invalid_argument("route_engine should not be empty");
+  }
+  if (const auto& minMs = decisionConfig.debounce_min_ms_ref()) {
+    if (*minMs <= 0) {
+      throw std::out_of_range(
+          folly::sformat("debounce_min_ms ({}) should be > 0", *minMs));
+    }
+  }
+  if (const auto& maxMs = decisionConfig.debounce_max_ms_ref()) {
+    const auto minMs = decisionConfig.debounce_min_ms_ref().value_or(1);
+    if (*maxMs < minMs) {
+      throw std::out_of_range(folly::sformat(
+          "debounce_max_ms ({}) should be >= debounce_min_ms ({})",
+          *maxMs,
+          minMs));
+    }
+  }
+
   //
   // Monitor
   //
@@ -324,6 +543,54 @@ Config::populateInternalDb() {
         "monitor_max_event_log ({}) should be >= 0",
         *monitorConfig.max_event_log_ref()));
   }
+  for (const auto& [event, rate] :
+       *monitorConfig.event_log_sample_rates_ref()) {
+    if (rate < 1) {
+      throw std::out_of_range(folly::sformat(
+          "event_log_sample_rates {}: rate ({}) should be >= 1", event, rate));
+    }
+  }
+
+  //
+  // Thread scheduling
+  //
+  for (const auto& [name, schedConf] : *config_.thread_scheduling_ref()) {
+    for (auto cpu : *schedConf.cpus_ref()) {
+      if (cpu < 0 or cpu >= CPU_SETSIZE) {
+        throw std::out_of_range(folly::sformat(
+            "thread_scheduling {}: cpu ({}) should be in [0, {})",
+            name,
+            cpu,
+            CPU_SETSIZE));
+      }
+    }
+    const auto priority = *schedConf.priority_ref();
+    switch (*schedConf.policy_ref()) {
+    case thrift::ThreadSchedulingPolicy::OTHER:
+      if (priority != 0) {
+        throw std::out_of_range(folly::sformat(
+            "thread_scheduling {}: priority ({}) should be 0 for policy OTHER",
+            name,
+            priority));
+      }
+      break;
+    case thrift::ThreadSchedulingPolicy::FIFO:
+    case thrift::ThreadSchedulingPolicy::RR:
+      if (priority < 1 or priority > 99) {
+        throw std::out_of_range(folly::sformat(
+            "thread_scheduling {}: priority ({}) should be in [1, 99] for "
+            "policy {}",
+            name,
+            priority,
+            enumName(*schedConf.policy_ref())));
+      }
+      break;
+    default:
+      throw std::invalid_argument(folly::sformat(
+          "thread_scheduling {}: invalid policy", name));
+    }
+  }
+
   //
   // Link Monitor
   //
@@ -350,6 +617,21 @@ Config::populateInternalDb() {
         *lmConf.linkflap_max_backoff_ms_ref()));
   }
 
+  // RTT metric quantization and batching
+  const auto& rttBuckets = *lmConf.rtt_metric_buckets_ref();
+  for (size_t i = 0; i < rttBuckets.size(); ++i) {
+    if (rttBuckets[i] <= 0 or (i and rttBuckets[i] <= rttBuckets[i - 1])) {
+      throw std::invalid_argument(folly::sformat(
+          "rtt_metric_buckets should be positive and increasing: [{}]",
+          folly::join(", ", rttBuckets)));
+    }
+  }
+  if (*lmConf.rtt_metric_update_window_ms_ref() < 0) {
+    throw std::out_of_range(folly::sformat(
+        "rtt_metric_update_window_ms ({}) should be >= 0",
+        *lmConf.rtt_metric_update_window_ms_ref()));
+  }
+
   // Construct the regular expressions to match interface names against
   re2::RE2::Options regexOpts;
   std::string regexErr;
@@ -475,6 +757,64 @@ Config::populateInternalDb() {
     throw std::invalid_argument(
         "enable_watchdog = true, but watchdog_config is empty");
   }
+  if (isWatchdogEnabled()) {
+    const auto& watchdogConf = getWatchdogConfig();
+    const auto moderatePct = *watchdogConf.memory_pressure_moderate_pct_ref();
+    const auto severePct = *watchdogConf.memory_pressure_severe_pct_ref();
+    if (moderatePct <= 0 or moderatePct > severePct or severePct > 100) {
+      throw std::invalid_argument(folly::sformat(
+          "watchdog_config memory pressure levels must satisfy "
+          "0 < memory_pressure_moderate_pct ({}) <= "
+          "memory_pressure_severe_pct ({}) <= 100",
+          moderatePct,
+          severePct));
+    }
+  }
+
+  //
+  // warm restart
+  //
+  if (isWarmRestartEnabled()) {
+    const auto& wrConf = getWarmRestartConfig();
+    if (wrConf.snapshot_file_path_ref()->empty()) {
+      throw std::invalid_argument(
+          "warm_restart_config.snapshot_file_path must be set");
+    }
+    if (*wrConf.snapshot_interval_s_ref() <= 0 or
+        *wrConf.max_snapshot_age_s_ref() <= 0 or
+        *wrConf.stale_time_s_ref() <= 0) {
+      throw std::invalid_argument(
+          "warm_restart_config intervals must be positive");
+    }
+  }
+
+  //
+  // prefix dampening
+  //
+  for (auto const& [type, dampConf] : *config_.prefix_dampening_config_ref()) {
+    const auto typeName =
+        apache::thrift::TEnumTraits<thrift::PrefixType>::findName(type);
+    if (*dampConf.penalty_ref() <= 0 or *dampConf.reuse_threshold_ref() <= 0 or
+        *dampConf.half_life_s_ref() <= 0 or
+        *dampConf.max_suppress_time_s_ref() <= 0) {
+      throw std::out_of_range(folly::sformat(
+          "prefix_dampening_config of {}: penalty, reuse_threshold, "
+          "half_life_s and max_suppress_time_s must be positive",
+          typeName ? typeName : "unknown type"));
+    }
+    // penalty is capped at reuse_threshold * 2^(max_suppress / half_life)
+    const double maxPenalty = *dampConf.reuse_threshold_ref() *
+        std::exp2(
+            static_cast<double>(*dampConf.max_suppress_time_s_ref()) /
+            *dampConf.half_life_s_ref());
+    if (*dampConf.suppress_threshold_ref() <= *dampConf.reuse_threshold_ref() or
+        *dampConf.suppress_threshold_ref() > maxPenalty) {
+      throw std::invalid_argument(folly::sformat(
+          "prefix_dampening_config of {}: suppress_threshold must be above "
+          "reuse_threshold and reachable within max_suppress_time_s",
+          typeName ? typeName : "unknown type"));
+    }
+  }
 
 } // namespace openr
 } // namespace openr
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <optional>
+
 #include <folly/IPAddress.h>
 #include <re2/re2.h>
 #include <re2/set.h>
@@ -31,13 +33,59 @@ struct AreaConfiguration {
   std::shared_ptr<re2::RE2::Set> interfaceRegexList{nullptr};
 };
 
+/**
+ * Regexes of all areas combined into one set per kind, so that deducing area
+ * of a neighbor takes a single match of neighbor name and one of interface
+ * name, regardless of number of areas.
+ */
+class AreaMatcher {
+ public:
+  explicit AreaMatcher(const std::vector<thrift::AreaConfig>& areas);
+
+  // areas matching neighbor on interface. Area with both neighbor and
+  // interface regexes needs both to match, otherwise the one it has.
+  std::vector<std::string> match(
+      const std::string& neighborName, const std::string& ifName) const;
+
+ private:
+  struct Area {
+    std::string areaId;
+    bool hasNeighborRegex{false};
+    bool hasInterfaceRegex{false};
+  };
+  std::vector<Area> areas_;
+
+  // combined regexes and index into areas_ of each of their patterns
+  std::shared_ptr<re2::RE2::Set> neighborRegexSet_{nullptr};
+  std::shared_ptr<re2::RE2::Set> interfaceRegexSet_{nullptr};
+  std::vector<size_t> neighborRegexArea_;
+  std::vector<size_t> interfaceRegexArea_;
+};
+
 class Config {
  public:
   explicit Config(const std::string& configFile);
-  explicit Config(thrift::OpenrConfig config) : config_(std::move(config)) {
+  explicit Config(thrift::OpenrConfig config, uint64_t version = 0)
+      : config_(std::move(config)), version_(version) {
     populateInternalDb();
   }
 
+  // Version of the running config, bumped by each reload
+  uint64_t
+  getVersion() const {
+    return version_;
+  }
+
+  /**
+   * Create next version of this config for a reload without restart. Only
+   * runtime tunable knobs may change: kvstore_config.flood_rate,
+   * decision_config.debounce_min_ms/debounce_max_ms and fib_sync_batch_size.
+   * Throws std::invalid_argument if newConfig is invalid or changes anything
+   * else.
+   */
+  std::shared_ptr<const Config> createReloadedConfig(
+      thrift::OpenrConfig newConfig) const;
+
   static PrefixAllocationParams createPrefixAllocationParams(
       const std::string& seedPfxStr, uint8_t allocationPfxLen);
 
@@ -84,6 +132,26 @@ class Config {
     return config_.enable_netlink_fib_handler_ref().value_or(false);
   }
 
+  bool
+  isNextHopGroupsEnabled() const {
+    return *config_.enable_nexthop_groups_ref();
+  }
+
+  bool
+  isFibWarmBootEnabled() const {
+    return *config_.enable_fib_warm_boot_ref();
+  }
+
+  bool
+  isNetlinkRouteSocketsPerFamilyEnabled() const {
+    return *config_.enable_netlink_route_sockets_per_family_ref();
+  }
+
+  int32_t
+  getNetlinkRecvBufferBytes() const {
+    return *config_.netlink_recv_buffer_bytes_ref();
+  }
+
   bool
   isRibPolicyEnabled() const {
     return *config_.enable_rib_policy_ref();
@@ -109,6 +177,11 @@ class Config {
     return *getMonitorConfig().enable_event_log_submission_ref();
   }
 
+  bool
+  isPerfSpansEnabled() const {
+    return *getMonitorConfig().enable_perf_spans_ref();
+  }
+
   //
   // area
   //
@@ -134,6 +207,11 @@ class Config {
     return areaConfigs_;
   }
 
+  const AreaMatcher&
+  getAreaMatcher() const {
+    return *areaMatcher_;
+  }
+
   //
   // spark
   //
@@ -238,6 +316,64 @@ class Config {
     return *config_.watchdog_config_ref();
   }
 
+  //
+  // decision
+  //
+  const thrift::DecisionConfig&
+  getDecisionConfig() const {
+    return *config_.decision_config_ref();
+  }
+
+  bool
+  isIncrementalSpfEnabled() const {
+    return *getDecisionConfig().enable_incremental_spf_ref();
+  }
+
+  int32_t
+  getRouteBuildThreads() const {
+    return *getDecisionConfig().route_build_threads_ref();
+  }
+
+  bool
+  isTopologyImpactAnalysisEnabled() const {
+    return *getDecisionConfig().enable_topology_impact_analysis_ref();
+  }
+
+  int64_t
+  getMemoizedResultsMaxBytes() const {
+    return *getDecisionConfig().memoized_results_max_bytes_ref();
+  }
+
+  bool
+  isAsyncRouteBuildEnabled() const {
+    return *getDecisionConfig().enable_async_route_build_ref();
+  }
+
+  bool
+  isAdaptiveDebounceEnabled() const {
+    return *getDecisionConfig().enable_adaptive_debounce_ref();
+  }
+
+  bool
+  isPriorityRouteUpdateEnabled() const {
+    return *getDecisionConfig().enable_priority_route_update_ref();
+  }
+
+  bool
+  isLfaBackupEnabled() const {
+    return *getDecisionConfig().enable_lfa_backup_ref();
+  }
+
+  bool
+  isUcmpEnabled() const {
+    return *getDecisionConfig().enable_ucmp_ref();
+  }
+
+  std::optional<std::string>
+  getRouteEngine() const {
+    return getDecisionConfig().route_engine_ref().to_optional();
+  }
+
   //
   // monitor
   //
@@ -246,10 +382,48 @@ class Config {
     return *config_.monitor_config_ref();
   }
 
+  bool
+  isModuleMemoryArenasEnabled() const {
+    return *config_.enable_module_memory_arenas_ref();
+  }
+
+  //
+  // warm restart
+  //
+  bool
+  isWarmRestartEnabled() const {
+    return config_.warm_restart_config_ref().has_value();
+  }
+
+  const thrift::WarmRestartConfig&
+  getWarmRestartConfig() const {
+    CHECK(isWarmRestartEnabled());
+    return *config_.warm_restart_config_ref();
+  }
+
+  //
+  // thread scheduling
+  //
+  // Config of thread name, falling back to its prefix before '-', e.g.
+  // "Spark-0" uses "Spark" unless configured explicitly
+  std::optional<thrift::ThreadSchedulingConfig>
+  getThreadSchedulingConfig(const std::string& threadName) const {
+    const auto& configs = *config_.thread_scheduling_ref();
+    auto it = configs.find(threadName);
+    if (it == configs.end()) {
+      it = configs.find(threadName.substr(0, threadName.find('-')));
+    }
+    if (it == configs.end()) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
  private:
   void populateInternalDb();
   // thrift config
   thrift::OpenrConfig config_;
+  uint64_t version_{0};
   std::unordered_set<std::string> areaIds_;
   // link monitor regexes
   std::shared_ptr<re2::RE2::Set> includeItfRegexes_{nullptr};
@@ -260,6 +434,9 @@ class Config {
 
   // areaId -> neighbor regex and interface regex mapped
   std::unordered_map<std::string /* areaId */, AreaConfiguration> areaConfigs_;
+
+  // all area regexes compiled together
+  std::shared_ptr<const AreaMatcher> areaMatcher_{nullptr};
 };
 
 } // namespace openr
@@ -191,6 +191,23 @@ TEST(ConfigTest, PopulateAreaConfig) {
     EXPECT_NO_THROW((Config(confValidArea)));
   }
 
+  // summary prefixes
+  {
+    openr::thrift::AreaConfig areaConfig;
+    *areaConfig.area_id_ref() = thrift::KvStore_constants::kDefaultArea();
+    areaConfig.interface_regexes_ref()->emplace_back("iface.*");
+    areaConfig.summary_prefixes_ref()->emplace_back("10.1.0.0/16");
+    areaConfig.summary_prefixes_ref()->emplace_back("fc00:1::/48");
+    std::vector<openr::thrift::AreaConfig> vec = {areaConfig};
+    auto confValidArea = getBasicOpenrConfig("node-1", "domain", vec);
+    EXPECT_NO_THROW((Config(confValidArea)));
+
+    areaConfig.summary_prefixes_ref()->emplace_back("10.1.0.0/33");
+    vec = {areaConfig};
+    auto confInvalidArea = getBasicOpenrConfig("node-1", "domain", vec);
+    EXPECT_THROW((Config(confInvalidArea)), std::invalid_argument);
+  }
+
   {
     openr::thrift::AreaConfig areaConfig;
     *areaConfig.area_id_ref() = thrift::KvStore_constants::kDefaultArea();
@@ -208,6 +225,34 @@ TEST(ConfigTest, PopulateAreaConfig) {
   }
 }
 
+TEST(ConfigTest, AreaMatcher) {
+  openr::thrift::AreaConfig both = getAreaConfig("both");
+  openr::thrift::AreaConfig neighborOnly;
+  *neighborOnly.area_id_ref() = "neighbor";
+  neighborOnly.neighbor_regexes_ref()->emplace_back("fsw.*");
+  neighborOnly.neighbor_regexes_ref()->emplace_back("ssw.*");
+  openr::thrift::AreaConfig interfaceOnly;
+  *interfaceOnly.area_id_ref() = "interface";
+  interfaceOnly.interface_regexes_ref()->emplace_back("po.*");
+
+  std::vector<openr::thrift::AreaConfig> vec = {
+      both, neighborOnly, interfaceOnly};
+  Config cfg(getBasicOpenrConfig("node-1", "domain", vec));
+  const auto& matcher = cfg.getAreaMatcher();
+
+  using Areas = std::vector<std::string>;
+  // area with both regexes needs both to match, case insensitively
+  EXPECT_EQ(Areas({"both"}), matcher.match("rsw001", "fboss1"));
+  EXPECT_EQ(Areas({"both"}), matcher.match("RSW001", "FBOSS1"));
+  EXPECT_EQ(Areas({}), matcher.match("rsw001", "eth0"));
+  // any regex of an area matches, anchored at both ends
+  EXPECT_EQ(Areas({"neighbor"}), matcher.match("ssw001", "eth0"));
+  EXPECT_EQ(Areas({}), matcher.match("xfsw001", "eth0"));
+  EXPECT_EQ(Areas({"interface"}), matcher.match("node-2", "po1"));
+  // multiple areas, in config order
+  EXPECT_EQ(Areas({"neighbor", "interface"}), matcher.match("fsw001", "po1"));
+}
+
 TEST(ConfigTest, PopulateInternalDb) {
   // features
 
@@ -219,6 +264,25 @@ TEST(ConfigTest, PopulateInternalDb) {
     confInvalid.enable_ordered_fib_programming_ref() = true;
     EXPECT_THROW((Config(confInvalid)), std::invalid_argument);
   }
+  // fib_sync_batch_size <= 0
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    confInvalid.fib_sync_batch_size_ref() = 0;
+    EXPECT_THROW((Config(confInvalid)), std::out_of_range);
+  }
+  // additional_fib_ports repeating fib_port
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    confInvalid.fib_port_ref() = 5909;
+    confInvalid.additional_fib_ports_ref() = {5910, 5909};
+    EXPECT_THROW((Config(confInvalid)), std::invalid_argument);
+  }
+  // netlink_recv_buffer_bytes <= 0
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    confInvalid.netlink_recv_buffer_bytes_ref() = 0;
+    EXPECT_THROW((Config(confInvalid)), std::out_of_range);
+  }
 
   // KSP2_ED_ECMP with IP
   {
@@ -258,6 +322,42 @@ TEST(ConfigTest, PopulateInternalDb) {
         ->flood_msg_burst_size_ref() = 0;
     EXPECT_THROW((Config(confInvalidFloodMsgPerSec)), std::out_of_range);
   }
+  // merge_threads <= 0
+  {
+    auto confInvalidMergeThreads = getBasicOpenrConfig();
+    confInvalidMergeThreads.kvstore_config_ref()->merge_threads_ref() = 0;
+    EXPECT_THROW((Config(confInvalidMergeThreads)), std::out_of_range);
+  }
+  // value_compression_min_bytes <= 0
+  {
+    auto confInvalidCompression = getBasicOpenrConfig();
+    confInvalidCompression.kvstore_config_ref()
+        ->value_compression_min_bytes_ref() = 0;
+    EXPECT_THROW((Config(confInvalidCompression)), std::out_of_range);
+  }
+  // initial_sync_peers <= 0
+  {
+    auto confInvalidSyncPeers = getBasicOpenrConfig();
+    confInvalidSyncPeers.kvstore_config_ref()->initial_sync_peers_ref() = 0;
+    EXPECT_THROW((Config(confInvalidSyncPeers)), std::out_of_range);
+  }
+  // local_set_batch_window_ms <= 0
+  {
+    auto confInvalidBatchWindow = getBasicOpenrConfig();
+    confInvalidBatchWindow.kvstore_config_ref()
+        ->local_set_batch_window_ms_ref() = 0;
+    EXPECT_THROW((Config(confInvalidBatchWindow)), std::out_of_range);
+  }
+  // flood scope of subscribers without subscribers
+  {
+    auto confInvalidFloodScope = getBasicOpenrConfig();
+    thrift::KvstoreFloodScope floodScope;
+    floodScope.key_prefix_ref() = "alloc:";
+    floodScope.scope_ref() = thrift::KvstoreFloodScopeType::SUBSCRIBERS;
+    confInvalidFloodScope.kvstore_config_ref()->flood_scopes_ref() = {
+        floodScope};
+    EXPECT_THROW((Config(confInvalidFloodScope)), std::invalid_argument);
+  }
 
   // Spark
 
@@ -361,6 +461,44 @@ TEST(ConfigTest, PopulateInternalDb) {
     EXPECT_THROW(auto c = Config(confInvalidSpark), std::invalid_argument);
   }
 
+  // Exception: num_shards <= 0
+  {
+    auto confInvalidSpark = getBasicOpenrConfig();
+    confInvalidSpark.spark_config_ref()->num_shards_ref() = 0;
+    EXPECT_THROW(auto c = Config(confInvalidSpark), std::out_of_range);
+  }
+
+  // Exception: liveness_detect_time_ms < 0
+  {
+    auto confInvalidSpark = getBasicOpenrConfig();
+    confInvalidSpark.spark_config_ref()->liveness_detect_time_ms_ref() = -1;
+    EXPECT_THROW(auto c = Config(confInvalidSpark), std::out_of_range);
+  }
+
+  // Decision
+
+  // Exception route_build_threads > 0
+  {
+    auto confInvalidDecision = getBasicOpenrConfig();
+    confInvalidDecision.decision_config_ref()->route_build_threads_ref() = 0;
+    EXPECT_THROW(auto c = Config(confInvalidDecision), std::out_of_range);
+  }
+
+  // Exception memoized_results_max_bytes >= 0
+  {
+    auto confInvalidDecision = getBasicOpenrConfig();
+    auto& decisionConfig = *confInvalidDecision.decision_config_ref();
+    decisionConfig.memoized_results_max_bytes_ref() = -1;
+    EXPECT_THROW(auto c = Config(confInvalidDecision), std::out_of_range);
+  }
+
+  // Exception route_engine not empty
+  {
+    auto confInvalidDecision = getBasicOpenrConfig();
+    confInvalidDecision.decision_config_ref()->route_engine_ref() = "";
+    EXPECT_THROW(auto c = Config(confInvalidDecision), std::invalid_argument);
+  }
+
   // Monitor
 
   // Exception monitor_max_event_log >= 0
@@ -369,6 +507,40 @@ TEST(ConfigTest, PopulateInternalDb) {
     confInvalidMon.monitor_config_ref()->max_event_log_ref() = -1;
     EXPECT_THROW(auto c = Config(confInvalidMon), std::out_of_range);
   }
+  // Exception event_log_sample_rates >= 1
+  {
+    auto confInvalidMon = getBasicOpenrConfig();
+    confInvalidMon.monitor_config_ref()->event_log_sample_rates_ref() = {
+        {"NEIGHBOR_UP", 0}};
+    EXPECT_THROW(auto c = Config(confInvalidMon), std::out_of_range);
+  }
+
+  // thread scheduling
+
+  // cpu out of range
+  {
+    auto confInvalidSched = getBasicOpenrConfig();
+    thrift::ThreadSchedulingConfig schedConf;
+    schedConf.cpus_ref() = {0, -1};
+    confInvalidSched.thread_scheduling_ref()->emplace("Spark", schedConf);
+    EXPECT_THROW(auto c = Config(confInvalidSched), std::out_of_range);
+  }
+  // priority with policy OTHER
+  {
+    auto confInvalidSched = getBasicOpenrConfig();
+    thrift::ThreadSchedulingConfig schedConf;
+    schedConf.priority_ref() = 10;
+    confInvalidSched.thread_scheduling_ref()->emplace("Spark", schedConf);
+    EXPECT_THROW(auto c = Config(confInvalidSched), std::out_of_range);
+  }
+  // no priority with policy FIFO
+  {
+    auto confInvalidSched = getBasicOpenrConfig();
+    thrift::ThreadSchedulingConfig schedConf;
+    schedConf.policy_ref() = thrift::ThreadSchedulingPolicy::FIFO;
+    confInvalidSched.thread_scheduling_ref()->emplace("Spark", schedConf);
+    EXPECT_THROW(auto c = Config(confInvalidSched), std::out_of_range);
+  }
 
   // link monitor
 
@@ -394,6 +566,20 @@ TEST(ConfigTest, PopulateInternalDb) {
         300000;
     EXPECT_THROW(auto c = Config(confInvalidLm), std::out_of_range);
   }
+  // rtt_metric_buckets not increasing
+  {
+    auto confInvalidLm = getBasicOpenrConfig();
+    confInvalidLm.link_monitor_config_ref()->rtt_metric_buckets_ref() = {
+        10, 50, 50};
+    EXPECT_THROW(auto c = Config(confInvalidLm), std::invalid_argument);
+  }
+  // rtt_metric_update_window_ms < 0
+  {
+    auto confInvalidLm = getBasicOpenrConfig();
+    confInvalidLm.link_monitor_config_ref()->rtt_metric_update_window_ms_ref() =
+        -1;
+    EXPECT_THROW(auto c = Config(confInvalidLm), std::out_of_range);
+  }
 
   // invalid include_interface_regexes
   {
@@ -534,6 +720,47 @@ TEST(ConfigTest, PopulateInternalDb) {
     confInvalid.enable_watchdog_ref() = true;
     EXPECT_THROW((Config(confInvalid)), std::invalid_argument);
   }
+  // memory pressure levels out of order
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    confInvalid.enable_watchdog_ref() = true;
+    thrift::WatchdogConfig watchdogConf;
+    watchdogConf.memory_pressure_moderate_pct_ref() = 90;
+    watchdogConf.memory_pressure_severe_pct_ref() = 80;
+    confInvalid.watchdog_config_ref() = watchdogConf;
+    EXPECT_THROW((Config(confInvalid)), std::invalid_argument);
+  }
+
+  // prefix dampening
+
+  // non-positive half life
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    thrift::PrefixDampeningConfig dampConf;
+    dampConf.half_life_s_ref() = 0;
+    confInvalid.prefix_dampening_config_ref()->emplace(
+        thrift::PrefixType::BGP, dampConf);
+    EXPECT_THROW((Config(confInvalid)), std::out_of_range);
+  }
+  // suppress threshold below reuse threshold
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    thrift::PrefixDampeningConfig dampConf;
+    dampConf.suppress_threshold_ref() = 500;
+    confInvalid.prefix_dampening_config_ref()->emplace(
+        thrift::PrefixType::BGP, dampConf);
+    EXPECT_THROW((Config(confInvalid)), std::invalid_argument);
+  }
+  // suppress threshold unreachable within max suppress time
+  {
+    auto confInvalid = getBasicOpenrConfig();
+    thrift::PrefixDampeningConfig dampConf;
+    dampConf.suppress_threshold_ref() = 5000;
+    dampConf.max_suppress_time_s_ref() = 900;
+    confInvalid.prefix_dampening_config_ref()->emplace(
+        thrift::PrefixType::BGP, dampConf);
+    EXPECT_THROW((Config(confInvalid)), std::invalid_argument);
+  }
 }
 
 TEST(ConfigTest, GeneralGetter) {
@@ -608,6 +835,64 @@ TEST(ConfigTest, GeneralGetter) {
   }
 }
 
+TEST(ConfigTest, ThreadSchedulingGetter) {
+  auto tConfig = getBasicOpenrConfig();
+  thrift::ThreadSchedulingConfig sparkConf;
+  sparkConf.cpus_ref() = {1};
+  sparkConf.policy_ref() = thrift::ThreadSchedulingPolicy::FIFO;
+  sparkConf.priority_ref() = 50;
+  thrift::ThreadSchedulingConfig spark0Conf;
+  spark0Conf.cpus_ref() = {2};
+  tConfig.thread_scheduling_ref()->emplace("Spark", sparkConf);
+  tConfig.thread_scheduling_ref()->emplace("Spark-0", spark0Conf);
+  auto config = Config(tConfig);
+
+  EXPECT_EQ(spark0Conf, config.getThreadSchedulingConfig("Spark-0"));
+  EXPECT_EQ(sparkConf, config.getThreadSchedulingConfig("Spark-1"));
+  EXPECT_EQ(sparkConf, config.getThreadSchedulingConfig("Spark"));
+  EXPECT_EQ(std::nullopt, config.getThreadSchedulingConfig("Decision"));
+}
+
+TEST(ConfigTest, ReloadedConfig) {
+  auto tConfig = getBasicOpenrConfig();
+  auto config = Config(tConfig);
+  EXPECT_EQ(0, config.getVersion());
+
+  // runtime tunable knobs
+  {
+    auto newTConfig = tConfig;
+    thrift::KvstoreFloodRate floodRate;
+    floodRate.flood_msg_per_sec_ref() = 100;
+    floodRate.flood_msg_burst_size_ref() = 10;
+    newTConfig.kvstore_config_ref()->flood_rate_ref() = floodRate;
+    newTConfig.decision_config_ref()->debounce_min_ms_ref() = 20;
+    newTConfig.decision_config_ref()->debounce_max_ms_ref() = 500;
+    newTConfig.fib_sync_batch_size_ref() = 100;
+
+    auto newConfig = config.createReloadedConfig(newTConfig);
+    EXPECT_EQ(1, newConfig->getVersion());
+    EXPECT_EQ(newTConfig, newConfig->getConfig());
+    EXPECT_EQ(2, newConfig->createReloadedConfig(newTConfig)->getVersion());
+  }
+
+  // invalid tunable
+  {
+    auto newTConfig = tConfig;
+    newTConfig.decision_config_ref()->debounce_min_ms_ref() = 500;
+    newTConfig.decision_config_ref()->debounce_max_ms_ref() = 20;
+    EXPECT_THROW(
+        config.createReloadedConfig(newTConfig), std::invalid_argument);
+  }
+
+  // other changes require restart
+  {
+    auto newTConfig = tConfig;
+    newTConfig.enable_v4_ref() = not tConfig.enable_v4_ref().value_or(false);
+    EXPECT_THROW(
+        config.createReloadedConfig(newTConfig), std::invalid_argument);
+  }
+}
+
 TEST(ConfigTest, KvstoreGetter) {
   auto tConfig = getBasicOpenrConfig();
   auto config = Config(tConfig);
@@ -7,14 +7,25 @@
 
 #include <openr/ctrl-server/OpenrCtrlHandler.h>
 
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
 #include <re2/re2.h>
 
 #include <folly/ExceptionString.h>
+#include <folly/executors/InlineExecutor.h>
 #include <folly/io/async/SSLContext.h>
 #include <folly/io/async/ssl/OpenSSLUtils.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 
 #include <openr/common/Constants.h>
+#include <openr/common/LockContention.h>
+#include <openr/common/MemoryArenas.h>
+#include <openr/common/ModuleStartup.h>
+#include <openr/common/ThreadProfiler.h>
+#include <openr/common/ThreadScheduling.h>
 #include <openr/common/Util.h>
 #include <openr/config-store/PersistentStore.h>
 #include <openr/decision/Decision.h>
@@ -29,6 +40,189 @@ namespace fb303 = facebook::fb303;
 
 namespace openr {
 
+namespace {
+
+using Priority = RequestAdmission::Priority;
+
+// Run request of method if admitted, failing with OpenrError otherwise. The
+// request holds its slot until its result is taken
+template <typename Request>
+std::invoke_result_t<Request>
+admitRequest(
+    RequestAdmission& admission,
+    const std::string& method,
+    Priority priority,
+    Request&& request) {
+  using Result = typename std::invoke_result_t<Request>::value_type;
+  auto ticket = admission.admit(method, priority);
+  if (not ticket.has_value()) {
+    return folly::makeSemiFuture<Result>(thrift::OpenrError(folly::sformat(
+        "Too many {} requests in flight, retry later", method)));
+  }
+  return request().deferEnsure([ticket = std::move(*ticket)]() {});
+}
+
+// KvStore dumps are expensive unless narrowed down to some keys
+Priority
+getDumpPriority(thrift::KeyDumpParams const& filter) {
+  const bool hasKeys = filter.keys_ref().has_value() and
+      std::any_of(filter.keys_ref()->begin(),
+                  filter.keys_ref()->end(),
+                  [](auto const& key) { return not key.empty(); });
+  return hasKeys or not filter.prefix_ref()->empty() or
+          not filter.originatorIds_ref()->empty()
+      ? Priority::NORMAL
+      : Priority::BULK;
+}
+
+// Pagination can't make progress without a positive page limit
+template <typename Page>
+folly::SemiFuture<std::unique_ptr<Page>>
+makeInvalidPageLimitError() {
+  return folly::makeSemiFuture<std::unique_ptr<Page>>(
+      thrift::OpenrError("Page limit must be positive"));
+}
+
+// Result of batch query of given type, set by setResult from the result
+// of the getter run for it
+template <typename T, typename SetResult>
+folly::SemiFuture<thrift::BatchResult>
+makeBatchResult(
+    thrift::BatchQueryType type,
+    folly::SemiFuture<std::unique_ptr<T>> getterFuture,
+    SetResult setResult) {
+  return std::move(getterFuture)
+      .deferTry([type, setResult = std::move(setResult)](
+                    folly::Try<std::unique_ptr<T>>&& result) mutable {
+        thrift::BatchResult batchResult;
+        *batchResult.type_ref() = type;
+        if (result.hasException()) {
+          batchResult.error_ref() = result.exception().what().toStdString();
+        } else {
+          setResult(batchResult, std::move(*result.value()));
+        }
+        return batchResult;
+      });
+}
+
+folly::SemiFuture<thrift::BatchResult>
+makeBatchError(thrift::BatchQueryType type, const std::string& error) {
+  thrift::BatchResult batchResult;
+  *batchResult.type_ref() = type;
+  batchResult.error_ref() = error;
+  return folly::makeSemiFuture(std::move(batchResult));
+}
+
+// Stream in progress of the pages of a paginated API
+template <typename Page, typename Chunk>
+struct PageStream {
+  // fetch page at given position from module
+  std::function<folly::SemiFuture<std::unique_ptr<Page>>(thrift::PageParams)>
+      getPage;
+  // entries of a page, published as one chunk
+  std::function<Chunk(Page&&)> getChunk;
+  apache::thrift::ServerStreamPublisher<Chunk> publisher;
+  // set once the client cancels the stream
+  std::shared_ptr<std::atomic<bool>> cancelled;
+};
+
+// Fetch and publish pages one after the other. The next page is requested
+// only after the previous one is published, so that the module is never
+// busy with more than a page and the whole result is never materialized.
+template <typename Page, typename Chunk>
+void
+streamNextPage(
+    std::shared_ptr<PageStream<Page, Chunk>> stream, thrift::PageParams page) {
+  auto pageFuture = stream->getPage(page);
+  std::move(pageFuture)
+      .via(&folly::InlineExecutor::instance())
+      .thenTry([stream = std::move(stream), page = std::move(page)](
+                   folly::Try<std::unique_ptr<Page>>&& result) mutable {
+        if (result.hasException()) {
+          std::move(stream->publisher).complete(std::move(result.exception()));
+          return;
+        }
+        auto nextCursor = result.value()->nextCursor_ref().to_optional();
+        stream->publisher.next(stream->getChunk(std::move(*result.value())));
+        if (not nextCursor.has_value() or *stream->cancelled) {
+          std::move(stream->publisher).complete();
+          return;
+        }
+        page.cursor_ref() = std::move(*nextCursor);
+        streamNextPage(std::move(stream), std::move(page));
+      });
+}
+
+template <typename Page, typename Chunk>
+apache::thrift::ServerStream<Chunk>
+streamPages(
+    int32_t pageSize,
+    std::function<folly::SemiFuture<std::unique_ptr<Page>>(thrift::PageParams)>
+        getPage,
+    std::function<Chunk(Page&&)> getChunk) {
+  if (pageSize <= 0) {
+    throw thrift::OpenrError("Page size must be positive");
+  }
+  auto cancelled = std::make_shared<std::atomic<bool>>(false);
+  auto streamAndPublisher =
+      apache::thrift::ServerStream<Chunk>::createPublisher(
+          [cancelled]() { *cancelled = true; });
+  auto stream = std::make_shared<PageStream<Page, Chunk>>(
+      PageStream<Page, Chunk>{std::move(getPage),
+                              std::move(getChunk),
+                              std::move(streamAndPublisher.second),
+                              std::move(cancelled)});
+
+  thrift::PageParams page;
+  *page.limit_ref() = pageSize;
+  streamNextPage(std::move(stream), std::move(page));
+  return std::move(streamAndPublisher.first);
+}
+
+// Whether "adj:" keys known to the server differ from those of a client
+// snapshot. TTL updates are not considered a change.
+bool
+isAdjKeysChanged(
+    const thrift::KeyVals& adjKeyVals, const thrift::KeyVals& snapshot) {
+  if (adjKeyVals.size() != snapshot.size()) {
+    return true;
+  }
+  for (auto const& kv : adjKeyVals) {
+    auto it = snapshot.find(kv.first);
+    if (it == snapshot.end()) {
+      return true;
+    }
+    auto const& val = kv.second;
+    auto const& snapshotVal = it->second;
+    if (*val.version_ref() != *snapshotVal.version_ref() or
+        *val.originatorId_ref() != *snapshotVal.originatorId_ref()) {
+      return true;
+    }
+    if (val.hash_ref().has_value() and snapshotVal.hash_ref().has_value() and
+        *val.hash_ref() != *snapshotVal.hash_ref()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Keys adjacency long polls are answered on, adjacency databases and the
+// deltas flooded in between (see enable_adj_db_delta)
+bool
+isAdjKey(std::string const& key) {
+  return key.find(Constants::kAdjDbMarker.toString()) == 0 or
+      key.find(Constants::kAdjDbDeltaMarker.toString()) == 0;
+}
+
+// Contention on kvStorePublishers_, which is locked on every publication
+LockContention&
+getKvStorePublishersContention() {
+  static auto& contention = LockContention::get("ctrl.kvstore_publishers");
+  return contention;
+}
+
+} // namespace
+
 OpenrCtrlHandler::OpenrCtrlHandler(
     const std::string& nodeName,
     const std::unordered_set<std::string>& acceptablePeerCommonNames,
@@ -40,7 +234,7 @@ OpenrCtrlHandler::OpenrCtrlHandler(
     Monitor* monitor,
     PersistentStore* configStore,
     PrefixManager* prefixManager,
-    Spark* spark,
+    std::vector<Spark*> sparkShards,
     std::shared_ptr<const Config> config)
     : fb303::BaseService("openr"),
       nodeName_(nodeName),
@@ -52,7 +246,7 @@ OpenrCtrlHandler::OpenrCtrlHandler(
       monitor_(monitor),
       configStore_(configStore),
       prefixManager_(prefixManager),
-      spark_(spark),
+      sparkShards_(std::move(sparkShards)),
       config_(config) {
   // Add fiber task to receive publication from KvStore
   if (kvStore_) {
@@ -68,67 +262,14 @@ OpenrCtrlHandler::OpenrCtrlHandler(
           LOG(INFO) << "Terminating KvStore publications processing fiber";
           break;
         }
+        const auto& publication = *maybePublication.value();
 
-        SYNCHRONIZED(kvStorePublishers_) {
-          for (auto& kv : kvStorePublishers_) {
-            kv.second->publish(maybePublication.value());
-          }
-        }
-
-        bool isAdjChanged = false;
-        // check if any of KeyVal has 'adj' update
-        for (auto& kv : *maybePublication.value().keyVals_ref()) {
-          auto& key = kv.first;
-          auto& val = kv.second;
-          // check if we have any value update.
-          // Ttl refreshing won't update any value.
-          if (!val.value_ref().has_value()) {
-            continue;
-          }
-
-          // "adj:*" key has changed. Update local collection
-          if (key.find(Constants::kAdjDbMarker.toString()) == 0) {
-            VLOG(3) << "Adj key: " << key << " change received";
-            isAdjChanged = true;
-            break;
-          }
-        }
+        // Invalidate before publishing, so that clients subscribing after
+        // this either get the update on their stream or a new snapshot
+        kvStoreSnapshots_.invalidate();
+        publishToKvStorePublishers(publication);
 
-        if (isAdjChanged) {
-          // thrift::Publication contains "adj:*" key change.
-          // Clean ALL pending promises
-          longPollReqs_.withWLock([&](auto& longPollReqs) {
-            for (auto& kv : longPollReqs) {
-              auto& p = kv.second.first;
-              p.setValue(true);
-            }
-            longPollReqs.clear();
-          });
-        } else {
-          longPollReqs_.withWLock([&](auto& longPollReqs) {
-            auto now = getUnixTimeStampMs();
-            std::vector<int64_t> reqsToClean;
-            for (auto& kv : longPollReqs) {
-              auto& clientId = kv.first;
-              auto& req = kv.second;
-
-              auto& p = req.first;
-              auto& timeStamp = req.second;
-              if (now - timeStamp >= Constants::kLongPollReqHoldTime.count()) {
-                LOG(INFO) << "Elapsed time: " << now - timeStamp
-                          << " is over hold limit: "
-                          << Constants::kLongPollReqHoldTime.count();
-                reqsToClean.emplace_back(clientId);
-                p.setValue(false);
-              }
-            }
-
-            // cleanup expired requests since no ADJ change observed
-            for (auto& clientId : reqsToClean) {
-              longPollReqs.erase(clientId);
-            }
-          });
-        }
+        processAdjKeysPublication(publication);
       }
     });
 
@@ -149,25 +290,83 @@ OpenrCtrlHandler::OpenrCtrlHandler(
               break;
             }
 
-            // Publish the update to all active streams
-            fibPublishers_.withWLock([&maybeUpdate](auto& fibPublishers) {
-              for (auto& fibPublisher : fibPublishers) {
-                fibPublisher.second.next(maybeUpdate.value());
+            // Refer to note on invalidation of kvStoreSnapshots_
+            fibSnapshots_.invalidate();
+
+            // Publish the update to all active streams. Publishing happens
+            // off the lock as a lagging subscriber is removed while doing so
+            std::vector<std::shared_ptr<
+                StreamSubscriber<thrift::RouteDatabaseDelta>>>
+                fibPublishers;
+            fibPublishers_.withRLock([&fibPublishers](auto& publishers) {
+              for (auto& kv : publishers) {
+                fibPublishers.emplace_back(kv.second);
               }
             });
+            for (auto& fibPublisher : fibPublishers) {
+              fibPublisher->publish(maybeUpdate.value());
+            }
+
+            std::vector<std::shared_ptr<FibCompactPublisher>>
+                fibCompactPublishers;
+            fibCompactPublishers_.withRLock(
+                [&fibCompactPublishers](auto& publishers) {
+                  for (auto& kv : publishers) {
+                    fibCompactPublishers.emplace_back(kv.second);
+                  }
+                });
+            for (auto& fibPublisher : fibCompactPublishers) {
+              fibPublisher->subscriber->publish(
+                  fibPublisher->encoder.encode(maybeUpdate.value()));
+            }
           }
         });
 
     workers_.push_back(std::move(taskFutureFib));
   }
+
+  // Add fiber task to receive link state changes from Decision
+  auto maybeLinkStateReader =
+      decision_ ? decision_->getLinkStateUpdatesReader() : std::nullopt;
+  if (maybeLinkStateReader.has_value()) {
+    hasLinkStateUpdates_ = true;
+    auto taskFutureLinkState = ctrlEvb->addFiberTaskFuture(
+        [q = std::move(*maybeLinkStateReader), this]() mutable noexcept {
+          LOG(INFO) << "Starting link state updates processing fiber";
+          while (true) {
+            auto maybeDelta = q.get(); // perform read
+            if (maybeDelta.hasError()) {
+              LOG(INFO) << "Terminating link state updates processing fiber";
+              break;
+            }
+
+            // Refer to note on publishing of Fib updates
+            std::vector<
+                std::shared_ptr<StreamSubscriber<thrift::LinkStateDelta>>>
+                linkStatePublishers;
+            linkStatePublishers_.withRLock(
+                [&linkStatePublishers](auto& publishers) {
+                  for (auto& kv : publishers) {
+                    linkStatePublishers.emplace_back(kv.second);
+                  }
+                });
+            for (auto& publisher : linkStatePublishers) {
+              publisher->publish(maybeDelta.value());
+            }
+          }
+        });
+
+    workers_.push_back(std::move(taskFutureLinkState));
+  }
 }
 
 OpenrCtrlHandler::~OpenrCtrlHandler() {
   closeKvStorePublishers();
   closeFibPublishers();
+  closeLinkStatePublishers();
 
   LOG(INFO) << "Cleanup all pending request(s).";
-  longPollReqs_.withWLock([&](auto& longPollReqs) { longPollReqs.clear(); });
+  cleanupPendingLongPollReqs();
 
   LOG(INFO)
       << "Waiting for termination of kvStoreUpdatesQueue, FibUpdatesQueue";
@@ -180,15 +379,117 @@ OpenrCtrlHandler::~OpenrCtrlHandler() {
 // Reason => `complete()` returns only when callback `onComplete` associated
 // with publisher returns. Since we acquire lock within `onComplete` callback,
 // we will run into the deadlock if `complete()` is invoked within
-// SYNCHRONIZED block
+// locked block
 void
-OpenrCtrlHandler::closeKvStorePublishers() {
-  std::vector<std::unique_ptr<KvStorePublisher>> publishers;
-  SYNCHRONIZED(kvStorePublishers_) {
-    for (auto& kv : kvStorePublishers_) {
-      publishers.emplace_back(std::move(kv.second));
+OpenrCtrlHandler::publishToKvStorePublishers(
+    const thrift::Publication& publication) {
+  // Snapshot publishers so that a slow client doesn't block subscription
+  // changes, and publishing doesn't block on them
+  std::vector<std::shared_ptr<KvStorePublisher>> publishers;
+  getKvStorePublishersContention().withWLock(
+      kvStorePublishers_, [&publishers](auto& kvStorePublishers) {
+        publishers.reserve(kvStorePublishers.size());
+        for (auto& kv : kvStorePublishers) {
+          publishers.emplace_back(kv.second);
+        }
+      });
+
+  // Filter publication once per group of publishers with identical filter
+  std::unordered_map<std::string, std::optional<thrift::Publication>>
+      filteredPubs;
+  for (auto& publisher : publishers) {
+    auto it = filteredPubs.find(publisher->getFilterKey());
+    if (it == filteredPubs.end()) {
+      it = filteredPubs
+               .emplace(
+                   publisher->getFilterKey(), publisher->filter(publication))
+               .first;
+    }
+    if (it->second.has_value()) {
+      publisher->publishFiltered(thrift::Publication(*it->second));
     }
   }
+  fb303::fbData->setCounter(
+      "subscribers.kvstore.filter_groups", filteredPubs.size());
+}
+
+void
+OpenrCtrlHandler::processAdjKeysPublication(
+    const thrift::Publication& publication) {
+  const auto now = getUnixTimeStampMs();
+  adjKeysStates_.withWLock([&](auto& adjKeysStates) {
+    auto& state = adjKeysStates[*publication.area_ref()];
+
+    bool isAdjChanged = false;
+    for (auto const& kv : *publication.keyVals_ref()) {
+      auto const& key = kv.first;
+      auto const& val = kv.second;
+      if (not isAdjKey(key)) {
+        continue;
+      }
+      if (val.value_ref().has_value()) {
+        // "adj:*" or "adjdelta:*" key has changed
+        VLOG(3) << "Adj key: " << key << " change received";
+        state.adjKeyVals.insert_or_assign(
+            key, createThriftValueWithoutBinaryValue(val));
+        isAdjChanged = true;
+        continue;
+      }
+      // Ttl refreshing won't update any value
+      auto it = state.adjKeyVals.find(key);
+      if (it != state.adjKeyVals.end() and
+          *it->second.version_ref() == *val.version_ref()) {
+        *it->second.ttl_ref() = *val.ttl_ref();
+        *it->second.ttlVersion_ref() = *val.ttlVersion_ref();
+      }
+    }
+    for (auto const& key : *publication.expiredKeys_ref()) {
+      if (not isAdjKey(key)) {
+        continue;
+      }
+      if (not state.isSynced) {
+        state.expiredBeforeSync.emplace(key);
+      }
+      isAdjChanged |= state.adjKeyVals.erase(key) > 0;
+    }
+
+    if (isAdjChanged) {
+      // Notify all requests pending for this area
+      for (auto& kv : state.longPollReqs) {
+        kv.second.first.setValue(true);
+      }
+      state.longPollReqs.clear();
+    }
+
+    // Expire requests held for too long. Requests are in order of arrival,
+    // hence only expired ones are visited.
+    for (auto& areaState : adjKeysStates) {
+      auto& longPollReqs = areaState.second.longPollReqs;
+      while (not longPollReqs.empty()) {
+        auto& req = longPollReqs.begin()->second;
+        auto& timeStamp = req.second;
+        if (now - timeStamp < Constants::kLongPollReqHoldTime.count()) {
+          break;
+        }
+        LOG(INFO) << "Elapsed time: " << now - timeStamp
+                  << " is over hold limit: "
+                  << Constants::kLongPollReqHoldTime.count();
+        req.first.setValue(false);
+        longPollReqs.erase(longPollReqs.begin());
+      }
+    }
+  });
+}
+
+void
+OpenrCtrlHandler::closeKvStorePublishers() {
+  std::vector<std::shared_ptr<KvStorePublisher>> publishers;
+  getKvStorePublishersContention().withWLock(
+      kvStorePublishers_, [&publishers](auto& kvStorePublishers) {
+        for (auto& kv : kvStorePublishers) {
+          publishers.emplace_back(std::move(kv.second));
+        }
+      });
   LOG(INFO) << "Terminating " << publishers.size()
             << " active KvStore snoop stream(s).";
   for (auto& publisher : publishers) {
@@ -199,10 +500,22 @@ OpenrCtrlHandler::closeKvStorePublishers() {
   }
 }
 
+void
+OpenrCtrlHandler::setMemoryPressure(MemoryPressure level) {
+  const bool pause = level == MemoryPressure::SEVERE;
+  if (kvStoreSnoopPaused_.exchange(pause) != pause) {
+    LOG(INFO) << (pause ? "Pausing" : "Resuming")
+              << " KvStore snoop streams on memory pressure";
+  }
+  if (pause and getNumKvStorePublishers()) {
+    closeKvStorePublishers();
+  }
+}
+
 // Refer to note on top of closeKvStorePublishers
 void
 OpenrCtrlHandler::closeFibPublishers() {
-  std::vector<apache::thrift::ServerStreamPublisher<thrift::RouteDatabaseDelta>>
+  std::vector<std::shared_ptr<StreamSubscriber<thrift::RouteDatabaseDelta>>>
       fibPublishers_close;
   fibPublishers_.withWLock([&fibPublishers_close](auto& fibPublishers) {
     for (auto& kv : fibPublishers) {
@@ -212,7 +525,36 @@ OpenrCtrlHandler::closeFibPublishers() {
   LOG(INFO) << "Terminating " << fibPublishers_close.size()
             << " active Fib snoop stream(s).";
   for (auto& fibPublisher : fibPublishers_close) {
-    std::move(fibPublisher).complete();
+    fibPublisher->complete();
+  }
+
+  std::vector<std::shared_ptr<FibCompactPublisher>> fibCompactPublishers_close;
+  fibCompactPublishers_.withWLock(
+      [&fibCompactPublishers_close](auto& fibPublishers) {
+        for (auto& kv : fibPublishers) {
+          fibCompactPublishers_close.emplace_back(std::move(kv.second));
+        }
+      });
+  LOG(INFO) << "Terminating " << fibCompactPublishers_close.size()
+            << " active compact Fib snoop stream(s).";
+  for (auto& fibPublisher : fibCompactPublishers_close) {
+    fibPublisher->subscriber->complete();
+  }
+}
+
+void
+OpenrCtrlHandler::closeLinkStatePublishers() {
+  std::vector<std::shared_ptr<StreamSubscriber<thrift::LinkStateDelta>>>
+      publishersToClose;
+  linkStatePublishers_.withWLock([&publishersToClose](auto& publishers) {
+    for (auto& kv : publishers) {
+      publishersToClose.emplace_back(std::move(kv.second));
+    }
+  });
+  LOG(INFO) << "Terminating " << publishersToClose.size()
+            << " active link state stream(s).";
+  for (auto& publisher : publishersToClose) {
+    publisher->complete();
   }
 }
 
@@ -330,6 +672,60 @@ OpenrCtrlHandler::getBuildInfo(thrift::BuildInfo& _buildInfo) {
   _buildInfo = getBuildInfoThrift();
 }
 
+void
+OpenrCtrlHandler::getThreadPlacements(
+    std::vector<thrift::ThreadPlacement>& _placements) {
+  _placements = openr::getThreadPlacements();
+}
+
+void
+OpenrCtrlHandler::getModuleMemoryStats(
+    std::vector<thrift::ModuleMemoryStats>& _stats) {
+  _stats = openr::getModuleMemoryStats();
+}
+
+void
+OpenrCtrlHandler::dumpHeapProfile(std::string& _path) {
+  try {
+    _path = openr::dumpHeapProfile();
+  } catch (const std::exception& ex) {
+    throw thrift::OpenrError(ex.what());
+  }
+}
+
+void
+OpenrCtrlHandler::profileThread(
+    thrift::ThreadProfile& _profile,
+    std::unique_ptr<std::string> threadName,
+    int32_t durationMs,
+    int32_t intervalUs) {
+  std::optional<int64_t> tid;
+  for (const auto& placement : openr::getThreadPlacements()) {
+    if (*placement.name_ref() == *threadName) {
+      tid = *placement.tid_ref();
+    }
+  }
+  if (not tid) {
+    throw thrift::OpenrError(
+        folly::sformat("Unknown thread name: {}", *threadName));
+  }
+
+  try {
+    _profile = openr::profileThread(
+        *tid,
+        std::chrono::milliseconds(durationMs),
+        std::chrono::microseconds(intervalUs));
+  } catch (const std::exception& ex) {
+    throw thrift::OpenrError(ex.what());
+  }
+  _profile.name_ref() = *threadName;
+}
+
+void
+OpenrCtrlHandler::getStartupPerfEvents(thrift::PerfEvents& _perfEvents) {
+  _perfEvents = openr::getModuleStartupPerfEvents();
+}
+
 // validate config
 void
 OpenrCtrlHandler::dryrunConfig(
@@ -354,6 +750,62 @@ OpenrCtrlHandler::dryrunConfig(
   }
 }
 
+std::optional<std::string>
+OpenrCtrlHandler::applyConfigToModules(
+    std::shared_ptr<const Config> const& config) {
+  std::vector<std::function<folly::SemiFuture<folly::Unit>()>> appliers;
+  if (kvStore_) {
+    appliers.emplace_back([&]() { return kvStore_->applyConfig(config); });
+  }
+  if (decision_) {
+    appliers.emplace_back([&]() { return decision_->applyConfig(config); });
+  }
+  if (fib_) {
+    appliers.emplace_back([&]() { return fib_->applyConfig(config); });
+  }
+
+  for (auto const& applier : appliers) {
+    try {
+      applier().get();
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Failed to apply config version " << config->getVersion()
+                 << ": " << folly::exceptionStr(ex);
+      return folly::exceptionStr(ex).toStdString();
+    }
+  }
+  return std::nullopt;
+}
+
+int64_t
+OpenrCtrlHandler::reloadConfig(std::unique_ptr<std::string> file) {
+  if (not file) {
+    throw thrift::OpenrError("Dereference nullptr for config file");
+  }
+
+  std::shared_ptr<const Config> newConfig;
+  try {
+    newConfig = config_->createReloadedConfig(Config(*file).getConfig());
+  } catch (const std::exception& ex) {
+    throw thrift::OpenrError(ex.what());
+  }
+
+  if (auto error = applyConfigToModules(newConfig)) {
+    // Roll back all modules, applying the running config is idempotent
+    LOG_IF(ERROR, applyConfigToModules(config_).has_value())
+        << "Failed to roll back to config version " << config_->getVersion();
+    throw thrift::OpenrError(folly::sformat(
+        "Failed to apply config, rolled back to version {}: {}",
+        config_->getVersion(),
+        *error));
+  }
+
+  LOG(INFO) << "Reloaded config " << *file << ", version "
+            << newConfig->getVersion();
+  fb303::fbData->setCounter("ctrl.config_version", newConfig->getVersion());
+  config_ = std::move(newConfig);
+  return config_->getVersion();
+}
+
 void
 OpenrCtrlHandler::getRunningConfig(std::string& _return) {
   _return = config_->getRunningConfig();
@@ -371,24 +823,33 @@ folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_advertisePrefixes(
     std::unique_ptr<std::vector<thrift::PrefixEntry>> prefixes) {
   CHECK(prefixManager_);
-  return prefixManager_->advertisePrefixes(std::move(*prefixes))
-      .defer([](folly::Try<bool>&&) { return folly::Unit(); });
+  return admitRequest(
+      admission_, "advertisePrefixes", Priority::CRITICAL, [&]() {
+        return prefixManager_->advertisePrefixes(std::move(*prefixes))
+            .defer([](folly::Try<bool>&&) { return folly::Unit(); });
+      });
 }
 
 folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_withdrawPrefixes(
     std::unique_ptr<std::vector<thrift::PrefixEntry>> prefixes) {
   CHECK(prefixManager_);
-  return prefixManager_->withdrawPrefixes(std::move(*prefixes))
-      .defer([](folly::Try<bool>&&) { return folly::Unit(); });
+  return admitRequest(
+      admission_, "withdrawPrefixes", Priority::CRITICAL, [&]() {
+        return prefixManager_->withdrawPrefixes(std::move(*prefixes))
+            .defer([](folly::Try<bool>&&) { return folly::Unit(); });
+      });
 }
 
 folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_withdrawPrefixesByType(
     thrift::PrefixType prefixType) {
   CHECK(prefixManager_);
-  return prefixManager_->withdrawPrefixesByType(prefixType)
-      .defer([](folly::Try<bool>&&) { return folly::Unit(); });
+  return admitRequest(
+      admission_, "withdrawPrefixesByType", Priority::CRITICAL, [&]() {
+        return prefixManager_->withdrawPrefixesByType(prefixType)
+            .defer([](folly::Try<bool>&&) { return folly::Unit(); });
+      });
 }
 
 folly::SemiFuture<folly::Unit>
@@ -396,8 +857,12 @@ OpenrCtrlHandler::semifuture_syncPrefixesByType(
     thrift::PrefixType prefixType,
     std::unique_ptr<std::vector<thrift::PrefixEntry>> prefixes) {
   CHECK(prefixManager_);
-  return prefixManager_->syncPrefixesByType(prefixType, std::move(*prefixes))
-      .defer([](folly::Try<bool>&&) { return folly::Unit(); });
+  return admitRequest(
+      admission_, "syncPrefixesByType", Priority::CRITICAL, [&]() {
+        return prefixManager_
+            ->syncPrefixesByType(prefixType, std::move(*prefixes))
+            .defer([](folly::Try<bool>&&) { return folly::Unit(); });
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::PrefixEntry>>>
@@ -422,7 +887,10 @@ folly::SemiFuture<std::unique_ptr<std::vector<thrift::AdvertisedRouteDetail>>>
 OpenrCtrlHandler::semifuture_getAdvertisedRoutesFiltered(
     std::unique_ptr<thrift::AdvertisedRouteFilter> filter) {
   CHECK(prefixManager_);
-  return prefixManager_->getAdvertisedRoutesFiltered(std::move(*filter));
+  return admitRequest(
+      admission_, "getAdvertisedRoutesFiltered", Priority::BULK, [&]() {
+        return prefixManager_->getAdvertisedRoutesFiltered(std::move(*filter));
+      });
 }
 
 //
@@ -432,34 +900,58 @@ OpenrCtrlHandler::semifuture_getAdvertisedRoutesFiltered(
 folly::SemiFuture<std::unique_ptr<thrift::RouteDatabase>>
 OpenrCtrlHandler::semifuture_getRouteDb() {
   CHECK(fib_);
-  return fib_->getRouteDb();
+  return admitRequest(admission_, "getRouteDb", Priority::BULK, [&]() {
+    return fib_->getRouteDb();
+  });
+}
+
+folly::SemiFuture<std::unique_ptr<thrift::RouteDatabasePage>>
+OpenrCtrlHandler::semifuture_getRouteDbPage(
+    std::unique_ptr<thrift::PageParams> page) {
+  CHECK(fib_);
+  if (*page->limit_ref() <= 0) {
+    return makeInvalidPageLimitError<thrift::RouteDatabasePage>();
+  }
+  return admitRequest(admission_, "getRouteDbPage", Priority::NORMAL, [&]() {
+    return fib_->getRouteDbPage(std::move(*page));
+  });
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
 OpenrCtrlHandler::semifuture_getUnicastRoutesFiltered(
     std::unique_ptr<std::vector<std::string>> prefixes) {
   CHECK(fib_);
-  return fib_->getUnicastRoutes(std::move(*prefixes));
+  return admitRequest(
+      admission_, "getUnicastRoutesFiltered", Priority::NORMAL, [&]() {
+        return fib_->getUnicastRoutes(std::move(*prefixes));
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
 OpenrCtrlHandler::semifuture_getUnicastRoutes() {
   folly::Promise<std::unique_ptr<std::vector<thrift::UnicastRoute>>> p;
   CHECK(fib_);
-  return fib_->getUnicastRoutes({});
+  return admitRequest(admission_, "getUnicastRoutes", Priority::BULK, [&]() {
+    return fib_->getUnicastRoutes({});
+  });
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::MplsRoute>>>
 OpenrCtrlHandler::semifuture_getMplsRoutes() {
   CHECK(fib_);
-  return fib_->getMplsRoutes({});
+  return admitRequest(admission_, "getMplsRoutes", Priority::BULK, [&]() {
+    return fib_->getMplsRoutes({});
+  });
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::MplsRoute>>>
 OpenrCtrlHandler::semifuture_getMplsRoutesFiltered(
     std::unique_ptr<std::vector<int32_t>> labels) {
   CHECK(fib_);
-  return fib_->getMplsRoutes(std::move(*labels));
+  return admitRequest(
+      admission_, "getMplsRoutesFiltered", Priority::NORMAL, [&]() {
+        return fib_->getMplsRoutes(std::move(*labels));
+      });
 }
 
 //
@@ -467,14 +959,36 @@ OpenrCtrlHandler::semifuture_getMplsRoutesFiltered(
 //
 folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_floodRestartingMsg() {
-  CHECK(spark_);
-  return spark_->floodRestartingMsg();
+  CHECK(not sparkShards_.empty());
+  std::vector<folly::SemiFuture<folly::Unit>> futures;
+  for (auto* spark : sparkShards_) {
+    futures.emplace_back(spark->floodRestartingMsg());
+  }
+  return folly::collect(std::move(futures)).deferValue([](auto&&) {});
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::SparkNeighbor>>>
 OpenrCtrlHandler::semifuture_getNeighbors() {
-  CHECK(spark_);
-  return spark_->getNeighbors();
+  CHECK(not sparkShards_.empty());
+  using Neighbors = std::vector<thrift::SparkNeighbor>;
+  return admitRequest(admission_, "getNeighbors", Priority::NORMAL, [&]() {
+    std::vector<folly::SemiFuture<std::unique_ptr<Neighbors>>> futures;
+    for (auto* spark : sparkShards_) {
+      futures.emplace_back(spark->getNeighbors());
+    }
+    return folly::collect(std::move(futures))
+        .deferValue(
+            [](std::vector<std::unique_ptr<Neighbors>>&& shardNeighbors) {
+              auto neighbors = std::make_unique<Neighbors>();
+              for (auto& shard : shardNeighbors) {
+                std::move(
+                    shard->begin(),
+                    shard->end(),
+                    std::back_inserter(*neighbors));
+              }
+              return neighbors;
+            });
+  });
 }
 
 //
@@ -500,32 +1014,104 @@ folly::SemiFuture<std::unique_ptr<std::vector<thrift::ReceivedRouteDetail>>>
 OpenrCtrlHandler::semifuture_getReceivedRoutesFiltered(
     std::unique_ptr<thrift::ReceivedRouteFilter> filter) {
   CHECK(decision_);
-  return decision_->getReceivedRoutesFiltered(std::move(*filter));
+  return admitRequest(
+      admission_, "getReceivedRoutesFiltered", Priority::BULK, [&]() {
+        return decision_->getReceivedRoutesFiltered(std::move(*filter));
+      });
+}
+
+folly::SemiFuture<std::unique_ptr<thrift::ReceivedRoutesPage>>
+OpenrCtrlHandler::semifuture_getReceivedRoutesFilteredPage(
+    std::unique_ptr<thrift::ReceivedRouteFilter> filter,
+    std::unique_ptr<thrift::PageParams> page) {
+  CHECK(decision_);
+  if (*page->limit_ref() <= 0) {
+    return makeInvalidPageLimitError<thrift::ReceivedRoutesPage>();
+  }
+  return admitRequest(
+      admission_, "getReceivedRoutesFilteredPage", Priority::NORMAL, [&]() {
+        return decision_->getReceivedRoutesFilteredPage(
+            std::move(*filter), std::move(*page));
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::RouteDatabase>>
 OpenrCtrlHandler::semifuture_getRouteDbComputed(
     std::unique_ptr<std::string> nodeName) {
   CHECK(decision_);
-  return decision_->getDecisionRouteDb(*nodeName);
+  return admitRequest(admission_, "getRouteDbComputed", Priority::BULK, [&]() {
+    return decision_->getDecisionRouteDb(*nodeName);
+  });
+}
+
+folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteDatabase>>>
+OpenrCtrlHandler::semifuture_getRouteDbComputedBatch(
+    std::unique_ptr<std::vector<std::string>> nodeNames) {
+  CHECK(decision_);
+  return admitRequest(
+      admission_, "getRouteDbComputedBatch", Priority::BULK, [&]() {
+        return decision_->getDecisionRouteDbs(std::move(*nodeNames));
+      });
+}
+
+folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteDatabase>>>
+OpenrCtrlHandler::semifuture_getRouteDbWhatIf(
+    std::unique_ptr<std::string> nodeName,
+    std::unique_ptr<std::vector<thrift::WhatIfScenario>> scenarios) {
+  CHECK(decision_);
+  return admitRequest(admission_, "getRouteDbWhatIf", Priority::BULK, [&]() {
+    return decision_->getRouteDbsWhatIf(
+        std::move(*nodeName), std::move(*scenarios));
+  });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::AdjDbs>>
 OpenrCtrlHandler::semifuture_getDecisionAdjacencyDbs() {
   CHECK(decision_);
-  return decision_->getDecisionAdjacencyDbs();
+  return admitRequest(
+      admission_, "getDecisionAdjacencyDbs", Priority::BULK, [&]() {
+        return decision_->getDecisionAdjacencyDbs();
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::AdjacencyDatabase>>>
 OpenrCtrlHandler::semifuture_getAllDecisionAdjacencyDbs() {
   CHECK(decision_);
-  return decision_->getAllDecisionAdjacencyDbs();
+  return admitRequest(
+      admission_, "getAllDecisionAdjacencyDbs", Priority::BULK, [&]() {
+        return decision_->getAllDecisionAdjacencyDbs();
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::PrefixDbs>>
 OpenrCtrlHandler::semifuture_getDecisionPrefixDbs() {
   CHECK(decision_);
-  return decision_->getDecisionPrefixDbs();
+  return admitRequest(
+      admission_, "getDecisionPrefixDbs", Priority::BULK, [&]() {
+        return decision_->getDecisionPrefixDbs();
+      });
+}
+
+folly::SemiFuture<std::unique_ptr<thrift::PrefixDbsPage>>
+OpenrCtrlHandler::semifuture_getDecisionPrefixDbsPage(
+    std::unique_ptr<thrift::PageParams> page) {
+  CHECK(decision_);
+  if (*page->limit_ref() <= 0) {
+    return makeInvalidPageLimitError<thrift::PrefixDbsPage>();
+  }
+  return admitRequest(
+      admission_, "getDecisionPrefixDbsPage", Priority::NORMAL, [&]() {
+        return decision_->getDecisionPrefixDbsPage(std::move(*page));
+      });
+}
+
+folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteBuildProfile>>>
+OpenrCtrlHandler::semifuture_getDecisionRouteBuildProfiles() {
+  CHECK(decision_);
+  return admitRequest(
+      admission_, "getDecisionRouteBuildProfiles", Priority::NORMAL, [&]() {
+        return decision_->getRouteBuildProfiles();
+      });
 }
 
 //
@@ -555,14 +1141,20 @@ OpenrCtrlHandler::semifuture_getKvStoreKeyValsArea(
   *params.keys_ref() = std::move(*filterKeys);
 
   CHECK(kvStore_);
-  return kvStore_->getKvStoreKeyVals(std::move(params), std::move(*area));
+  return admitRequest(
+      admission_, "getKvStoreKeyValsArea", Priority::NORMAL, [&]() {
+        return kvStore_->getKvStoreKeyVals(std::move(params), std::move(*area));
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::Publication>>
 OpenrCtrlHandler::semifuture_getKvStoreKeyValsFiltered(
     std::unique_ptr<thrift::KeyDumpParams> filter) {
   CHECK(kvStore_);
-  return kvStore_->dumpKvStoreKeys(std::move(*filter));
+  const auto priority = getDumpPriority(*filter);
+  return admitRequest(admission_, "getKvStoreKeyValsFiltered", priority, [&]() {
+    return kvStore_->dumpKvStoreKeys(std::move(*filter));
+  });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::Publication>>
@@ -570,14 +1162,37 @@ OpenrCtrlHandler::semifuture_getKvStoreKeyValsFilteredArea(
     std::unique_ptr<thrift::KeyDumpParams> filter,
     std::unique_ptr<std::string> area) {
   CHECK(kvStore_);
-  return kvStore_->dumpKvStoreKeys(std::move(*filter), std::move(*area));
+  const auto priority = getDumpPriority(*filter);
+  return admitRequest(
+      admission_, "getKvStoreKeyValsFilteredArea", priority, [&]() {
+        return kvStore_->dumpKvStoreKeys(std::move(*filter), std::move(*area));
+      });
+}
+
+folly::SemiFuture<std::unique_ptr<thrift::PublicationPage>>
+OpenrCtrlHandler::semifuture_getKvStoreKeyValsFilteredAreaPage(
+    std::unique_ptr<thrift::KeyDumpParams> filter,
+    std::unique_ptr<std::string> area,
+    std::unique_ptr<thrift::PageParams> page) {
+  CHECK(kvStore_);
+  if (*page->limit_ref() <= 0) {
+    return makeInvalidPageLimitError<thrift::PublicationPage>();
+  }
+  return admitRequest(
+      admission_, "getKvStoreKeyValsFilteredAreaPage", Priority::NORMAL, [&]() {
+        return kvStore_->dumpKvStoreKeysPage(
+            std::move(*filter), std::move(*area), std::move(*page));
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::Publication>>
 OpenrCtrlHandler::semifuture_getKvStoreHashFiltered(
     std::unique_ptr<thrift::KeyDumpParams> filter) {
   CHECK(kvStore_);
-  return kvStore_->dumpKvStoreHashes(std::move(*filter));
+  return admitRequest(
+      admission_, "getKvStoreHashFiltered", Priority::BULK, [&]() {
+        return kvStore_->dumpKvStoreHashes(std::move(*filter));
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::Publication>>
@@ -585,7 +1200,11 @@ OpenrCtrlHandler::semifuture_getKvStoreHashFilteredArea(
     std::unique_ptr<thrift::KeyDumpParams> filter,
     std::unique_ptr<std::string> area) {
   CHECK(kvStore_);
-  return kvStore_->dumpKvStoreHashes(std::move(*filter), std::move(*area));
+  return admitRequest(
+      admission_, "getKvStoreHashFilteredArea", Priority::BULK, [&]() {
+        return kvStore_->dumpKvStoreHashes(
+            std::move(*filter), std::move(*area));
+      });
 }
 
 folly::SemiFuture<folly::Unit>
@@ -593,62 +1212,121 @@ OpenrCtrlHandler::semifuture_setKvStoreKeyVals(
     std::unique_ptr<thrift::KeySetParams> setParams,
     std::unique_ptr<std::string> area) {
   CHECK(kvStore_);
-  return kvStore_->setKvStoreKeyVals(std::move(*setParams), std::move(*area));
+  return admitRequest(admission_, "setKvStoreKeyVals", Priority::NORMAL, [&]() {
+    return kvStore_->setKvStoreKeyVals(std::move(*setParams), std::move(*area));
+  });
 }
 
 folly::SemiFuture<bool>
 OpenrCtrlHandler::semifuture_longPollKvStoreAdj(
     std::unique_ptr<thrift::KeyVals> snapshot) {
+  return semifuture_longPollKvStoreAdjArea(
+      std::move(snapshot),
+      std::make_unique<std::string>(
+          thrift::KvStore_constants::kDefaultArea()));
+}
+
+folly::SemiFuture<bool>
+OpenrCtrlHandler::semifuture_longPollKvStoreAdjArea(
+    std::unique_ptr<thrift::KeyVals> snapshot,
+    std::unique_ptr<std::string> area) {
+  CHECK(kvStore_);
   folly::Promise<bool> p;
   auto sf = p.getSemiFuture();
 
   auto timeStamp = getUnixTimeStampMs();
   auto requestId = pendingRequestId_++;
 
-  thrift::KeyDumpParams params;
-
-  // build thrift::KeyVals with "adj:" key ONLY
-  // to ensure KvStore ONLY compare "adj:" key
+  // build thrift::KeyVals with "adj:" and "adjdelta:" keys ONLY
+  // to ensure ONLY adjacency keys are compared
   thrift::KeyVals adjKeyVals;
   for (auto& kv : *snapshot) {
-    if (kv.first.find(Constants::kAdjDbMarker.toString()) == 0) {
+    if (isAdjKey(kv.first)) {
       adjKeyVals.emplace(kv.first, kv.second);
     }
   }
 
-  // Only care about "adj:" key
-  *params.prefix_ref() = Constants::kAdjDbMarker;
-  params.keys_ref() = {Constants::kAdjDbMarker.toString()};
-  // Only dump difference between KvStore and client snapshot
-  params.keyValHashes_ref() = std::move(adjKeyVals);
+  // Dump adjacency keys from KvStore. Only those differing from keyValHashes
+  // are dumped if given.
+  auto dumpAdjKeys = [&](std::optional<thrift::KeyVals> keyValHashes) {
+    thrift::KeyDumpParams params;
+    *params.prefix_ref() = folly::sformat(
+        "{},{}", Constants::kAdjDbMarker, Constants::kAdjDbDeltaMarker);
+    params.keys_ref() = {
+        Constants::kAdjDbMarker.toString(),
+        Constants::kAdjDbDeltaMarker.toString()};
+    if (keyValHashes.has_value()) {
+      params.keyValHashes_ref() = std::move(*keyValHashes);
+    }
+    // Explicitly do SYNC call to KvStore
+    return kvStore_->dumpKvStoreKeys(std::move(params), *area).get();
+  };
 
-  // Explicitly do SYNC call to KvStore
-  std::unique_ptr<thrift::Publication> thriftPub{nullptr};
   try {
-    thriftPub = semifuture_getKvStoreKeyValsFiltered(
-                    std::make_unique<thrift::KeyDumpParams>(params))
-                    .get();
+    // Adj keys of the area are synced with KvStore by the first request, and
+    // are kept up to date from publications afterwards
+    bool isSynced{false};
+    adjKeysStates_.withRLock([&](auto& adjKeysStates) {
+      auto it = adjKeysStates.find(*area);
+      isSynced = it != adjKeysStates.end() and it->second.isSynced;
+    });
+    if (not isSynced) {
+      auto thriftPub = dumpAdjKeys(std::nullopt);
+      adjKeysStates_.withWLock([&](auto& adjKeysStates) {
+        auto& state = adjKeysStates[*area];
+        if (state.isSynced) {
+          return;
+        }
+        for (auto const& kv : *thriftPub->keyVals_ref()) {
+          // keys from publications are at least as recent as the dump
+          if (not state.expiredBeforeSync.count(kv.first)) {
+            state.adjKeyVals.emplace(
+                kv.first, createThriftValueWithoutBinaryValue(kv.second));
+          }
+        }
+        state.expiredBeforeSync.clear();
+        state.isSynced = true;
+      });
+    }
+
+    // Compare client snapshot with adj keys of the area and store req as
+    // pending request if consistent, without going to KvStore
+    bool isAdjChanged{false};
+    adjKeysStates_.withWLock([&](auto& adjKeysStates) {
+      auto& state = adjKeysStates[*area];
+      isAdjChanged = isAdjKeysChanged(state.adjKeyVals, adjKeyVals);
+      if (not isAdjChanged) {
+        VLOG(3) << "No adj change detected. Store req as pending request";
+        state.longPollReqs.emplace(
+            requestId, std::make_pair(std::move(p), timeStamp));
+      }
+    });
+    if (not isAdjChanged) {
+      return sf;
+    }
+
+    // Publication of the change may not have been processed yet, confirm
+    // the change with KvStore
+    auto thriftPub = dumpAdjKeys(std::move(adjKeyVals));
+    if (thriftPub->keyVals_ref()->size() > 0) {
+      VLOG(3) << "AdjKey has been added/modified. Notify immediately";
+      p.setValue(true);
+    } else if (
+        thriftPub->tobeUpdatedKeys_ref().has_value() &&
+        thriftPub->tobeUpdatedKeys_ref().value().size() > 0) {
+      VLOG(3) << "AdjKey has been deleted/expired. Notify immediately";
+      p.setValue(true);
+    } else {
+      // Client provided data is consistent with KvStore. Publication will
+      // notify the pending request.
+      VLOG(3) << "No adj change in KvStore. Store req as pending request";
+      adjKeysStates_.withWLock([&](auto& adjKeysStates) {
+        adjKeysStates[*area].longPollReqs.emplace(
+            requestId, std::make_pair(std::move(p), timeStamp));
+      });
+    }
   } catch (std::exception const& ex) {
     p.setException(thrift::OpenrError(ex.what()));
-    return sf;
-  }
-
-  if (thriftPub->keyVals_ref()->size() > 0) {
-    VLOG(3) << "AdjKey has been added/modified. Notify immediately";
-    p.setValue(true);
-  } else if (
-      thriftPub->tobeUpdatedKeys_ref().has_value() &&
-      thriftPub->tobeUpdatedKeys_ref().value().size() > 0) {
-    VLOG(3) << "AdjKey has been deleted/expired. Notify immediately";
-    p.setValue(true);
-  } else {
-    // Client provided data is consistent with KvStore.
-    // Store req for future processing when there is publication
-    // from KvStore.
-    VLOG(3) << "No adj change detected. Store req as pending request";
-    longPollReqs_.withWLock([&](auto& longPollReq) {
-      longPollReq.emplace(requestId, std::make_pair(std::move(p), timeStamp));
-    });
   }
   return sf;
 }
@@ -688,7 +1366,10 @@ folly::SemiFuture<std::unique_ptr<thrift::PeersMap>>
 OpenrCtrlHandler::semifuture_getKvStorePeersArea(
     std::unique_ptr<std::string> area) {
   CHECK(kvStore_);
-  return kvStore_->getKvStorePeers(std::move(*area));
+  return admitRequest(
+      admission_, "getKvStorePeersArea", Priority::NORMAL, [&]() {
+        return kvStore_->getKvStorePeers(std::move(*area));
+      });
 }
 
 apache::thrift::ServerStream<thrift::Publication>
@@ -697,31 +1378,38 @@ OpenrCtrlHandler::subscribeKvStoreFilter(
   // Get new client-ID (monotonically increasing)
   auto clientToken = publisherToken_++;
 
-  auto streamAndPublisher =
-      apache::thrift::ServerStream<thrift::Publication>::createPublisher(
+  auto streamAndSubscriber =
+      StreamSubscriber<thrift::Publication>::create(
+          "subscribers.kvstore",
+          Constants::kStreamMaxPending,
+          Constants::kStreamMaxLag,
+          KvStorePublisher::mergePublications,
           [this, clientToken]() {
-            SYNCHRONIZED(kvStorePublishers_) {
-              if (kvStorePublishers_.erase(clientToken)) {
-                LOG(INFO) << "KvStore snoop stream-" << clientToken
-                          << " ended.";
-              } else {
-                LOG(ERROR) << "Can't remove unknown KvStore snoop stream-"
-                           << clientToken;
-              }
-              fb303::fbData->setCounter(
-                  "subscribers.kvstore", kvStorePublishers_.size());
-            }
+            getKvStorePublishersContention().withWLock(
+                kvStorePublishers_, [clientToken](auto& kvStorePublishers) {
+                  if (kvStorePublishers.erase(clientToken)) {
+                    LOG(INFO) << "KvStore snoop stream-" << clientToken
+                              << " ended.";
+                  } else {
+                    LOG(ERROR) << "Can't remove unknown KvStore snoop stream-"
+                               << clientToken;
+                  }
+                  fb303::fbData->setCounter(
+                      "subscribers.kvstore", kvStorePublishers.size());
+                });
           });
 
-  SYNCHRONIZED(kvStorePublishers_) {
-    assert(kvStorePublishers_.count(clientToken) == 0);
-    LOG(INFO) << "KvStore snoop stream-" << clientToken << " started.";
-    auto kvStorePublisher = std::make_unique<KvStorePublisher>(
-        std::move(*filter), std::move(streamAndPublisher.second));
-    kvStorePublishers_.emplace(clientToken, std::move(kvStorePublisher));
-    fb303::fbData->setCounter("subscribers.kvstore", kvStorePublishers_.size());
-  }
-  return std::move(streamAndPublisher.first);
+  getKvStorePublishersContention().withWLock(
+      kvStorePublishers_, [&](auto& kvStorePublishers) {
+        assert(kvStorePublishers.count(clientToken) == 0);
+        LOG(INFO) << "KvStore snoop stream-" << clientToken << " started.";
+        auto kvStorePublisher = std::make_shared<KvStorePublisher>(
+            std::move(*filter), std::move(streamAndSubscriber.second));
+        kvStorePublishers.emplace(clientToken, std::move(kvStorePublisher));
+        fb303::fbData->setCounter(
+            "subscribers.kvstore", kvStorePublishers.size());
+      });
+  return std::move(streamAndSubscriber.first);
 }
 
 folly::SemiFuture<apache::thrift::ResponseAndServerStream<
@@ -737,11 +1425,27 @@ folly::SemiFuture<apache::thrift::ResponseAndServerStream<
     thrift::Publication>>
 OpenrCtrlHandler::semifuture_subscribeAndGetKvStoreFiltered(
     std::unique_ptr<thrift::KeyDumpParams> dumpParams) {
-  auto subscriptionParams =
-      std::make_unique<thrift::KeyDumpParams>(*dumpParams);
-  return semifuture_getKvStoreKeyValsFiltered(std::move(dumpParams))
+  CHECK(kvStore_);
+  if (kvStoreSnoopPaused_) {
+    return folly::makeSemiFuture<apache::thrift::ResponseAndServerStream<
+        thrift::Publication,
+        thrift::Publication>>(thrift::OpenrError(
+        "KvStore subscriptions are paused under memory pressure"));
+  }
+  // Subscribe before getting the snapshot, so that no update in between is
+  // missed. Snapshot is shared among clients subscribing with same filter.
+  auto stream = subscribeKvStoreFilter(
+      std::make_unique<thrift::KeyDumpParams>(*dumpParams));
+  auto snapshotKey =
+      apache::thrift::CompactSerializer::serialize<std::string>(*dumpParams);
+  return kvStoreSnapshots_
+      .get(
+          snapshotKey,
+          [this, params = std::move(*dumpParams)]() mutable {
+            return kvStore_->dumpKvStoreKeys(std::move(params));
+          })
       .defer(
-          [stream = subscribeKvStoreFilter(std::move(subscriptionParams))](
+          [stream = std::move(stream)](
               folly::Try<std::unique_ptr<thrift::Publication>>&& pub) mutable {
             pub.throwIfFailed();
             return apache::thrift::ResponseAndServerStream<
@@ -756,8 +1460,16 @@ OpenrCtrlHandler::subscribeFib() {
   // Get new client-ID (monotonically increasing)
   auto clientToken = publisherToken_++;
 
-  auto streamAndPublisher =
-      apache::thrift::ServerStream<thrift::RouteDatabaseDelta>::createPublisher(
+  auto streamAndSubscriber =
+      StreamSubscriber<thrift::RouteDatabaseDelta>::create(
+          "subscribers.fib",
+          Constants::kStreamMaxPending,
+          Constants::kStreamMaxLag,
+          [](thrift::RouteDatabaseDelta& delta,
+             thrift::RouteDatabaseDelta& laterDelta) {
+            mergeRouteDatabaseDelta(delta, std::move(laterDelta));
+            return true;
+          },
           [this, clientToken]() {
             fibPublishers_.withWLock([&clientToken](auto& fibPublishers) {
               if (fibPublishers.erase(clientToken)) {
@@ -772,21 +1484,24 @@ OpenrCtrlHandler::subscribeFib() {
           });
 
   fibPublishers_.withWLock([&clientToken,
-                            &streamAndPublisher](auto& fibPublishers) {
+                            &streamAndSubscriber](auto& fibPublishers) {
     assert(fibPublishers.count(clientToken) == 0);
     LOG(INFO) << "Fib snoop stream-" << clientToken << " started.";
-    fibPublishers.emplace(clientToken, std::move(streamAndPublisher.second));
+    fibPublishers.emplace(clientToken, std::move(streamAndSubscriber.second));
     fb303::fbData->setCounter("subscribers.fib", fibPublishers.size());
   });
-  return std::move(streamAndPublisher.first);
+  return std::move(streamAndSubscriber.first);
 }
 
 folly::SemiFuture<apache::thrift::ResponseAndServerStream<
     thrift::RouteDatabase,
     thrift::RouteDatabaseDelta>>
 OpenrCtrlHandler::semifuture_subscribeAndGetFib() {
+  CHECK(fib_);
   auto stream = subscribeFib();
-  return semifuture_getRouteDb().defer(
+  return fibSnapshots_
+      .get("", [this]() { return fib_->getRouteDb(); })
+      .defer(
       [stream = std::move(stream)](
           folly::Try<std::unique_ptr<thrift::RouteDatabase>>&& db) mutable {
         db.throwIfFailed();
@@ -797,47 +1512,253 @@ OpenrCtrlHandler::semifuture_subscribeAndGetFib() {
       });
 }
 
+apache::thrift::ServerStream<thrift::CompactRouteDatabaseDelta>
+OpenrCtrlHandler::subscribeFibCompact() {
+  // Get new client-ID (monotonically increasing)
+  auto clientToken = publisherToken_++;
+
+  auto streamAndSubscriber =
+      StreamSubscriber<thrift::CompactRouteDatabaseDelta>::create(
+          "subscribers.fib_compact",
+          Constants::kStreamMaxPending,
+          Constants::kStreamMaxLag,
+          [](thrift::CompactRouteDatabaseDelta& delta,
+             thrift::CompactRouteDatabaseDelta& laterDelta) {
+            return mergeCompactRouteDatabaseDelta(
+                delta, std::move(laterDelta));
+          },
+          [this, clientToken]() {
+            fibCompactPublishers_.withWLock([&clientToken](
+                                                auto& fibPublishers) {
+              if (fibPublishers.erase(clientToken)) {
+                LOG(INFO) << "Compact Fib snoop stream-" << clientToken
+                          << " ended.";
+              } else {
+                LOG(ERROR) << "Can't remove unknown compact Fib snoop stream-"
+                           << clientToken;
+              }
+              fb303::fbData->setCounter(
+                  "subscribers.fib_compact", fibPublishers.size());
+            });
+          });
+
+  auto fibPublisher = std::make_shared<FibCompactPublisher>();
+  fibPublisher->subscriber = std::move(streamAndSubscriber.second);
+  fibCompactPublishers_.withWLock([&clientToken,
+                                   &fibPublisher](auto& fibPublishers) {
+    assert(fibPublishers.count(clientToken) == 0);
+    LOG(INFO) << "Compact Fib snoop stream-" << clientToken << " started.";
+    fibPublishers.emplace(clientToken, std::move(fibPublisher));
+    fb303::fbData->setCounter("subscribers.fib_compact", fibPublishers.size());
+  });
+  return std::move(streamAndSubscriber.first);
+}
+
+folly::SemiFuture<apache::thrift::ResponseAndServerStream<
+    thrift::RouteDatabase,
+    thrift::CompactRouteDatabaseDelta>>
+OpenrCtrlHandler::semifuture_subscribeAndGetFibCompact() {
+  CHECK(fib_);
+  auto stream = subscribeFibCompact();
+  return fibSnapshots_
+      .get("", [this]() { return fib_->getRouteDb(); })
+      .defer(
+      [stream = std::move(stream)](
+          folly::Try<std::unique_ptr<thrift::RouteDatabase>>&& db) mutable {
+        db.throwIfFailed();
+        return apache::thrift::ResponseAndServerStream<
+            thrift::RouteDatabase,
+            thrift::CompactRouteDatabaseDelta>{std::move(*db.value()),
+                                               std::move(stream)};
+      });
+}
+
+apache::thrift::ServerStream<thrift::LinkStateDelta>
+OpenrCtrlHandler::subscribeLinkState() {
+  // Get new client-ID (monotonically increasing)
+  auto clientToken = publisherToken_++;
+
+  auto streamAndSubscriber = StreamSubscriber<thrift::LinkStateDelta>::create(
+      "subscribers.link_state",
+      Constants::kStreamMaxPending,
+      Constants::kStreamMaxLag,
+      [](thrift::LinkStateDelta& delta, thrift::LinkStateDelta& laterDelta) {
+        auto& changes = *delta.changes_ref();
+        auto& laterChanges = *laterDelta.changes_ref();
+        changes.insert(
+            changes.end(),
+            std::make_move_iterator(laterChanges.begin()),
+            std::make_move_iterator(laterChanges.end()));
+        return true;
+      },
+      [this, clientToken]() {
+        linkStatePublishers_.withWLock([&clientToken](auto& publishers) {
+          if (publishers.erase(clientToken)) {
+            LOG(INFO) << "Link state stream-" << clientToken << " ended.";
+          } else {
+            LOG(ERROR) << "Can't remove unknown link state stream-"
+                       << clientToken;
+          }
+          fb303::fbData->setCounter(
+              "subscribers.link_state", publishers.size());
+        });
+      });
+
+  linkStatePublishers_.withWLock(
+      [&clientToken, &streamAndSubscriber](auto& publishers) {
+        assert(publishers.count(clientToken) == 0);
+        LOG(INFO) << "Link state stream-" << clientToken << " started.";
+        publishers.emplace(
+            clientToken, std::move(streamAndSubscriber.second));
+        fb303::fbData->setCounter("subscribers.link_state", publishers.size());
+      });
+  return std::move(streamAndSubscriber.first);
+}
+
+folly::SemiFuture<apache::thrift::ResponseAndServerStream<
+    thrift::LinkStateDatabases,
+    thrift::LinkStateDelta>>
+OpenrCtrlHandler::semifuture_subscribeAndGetLinkState() {
+  CHECK(decision_);
+  if (not hasLinkStateUpdates_) {
+    throw thrift::OpenrError("Link state updates are not available");
+  }
+  // Subscribe ahead of retrieving databases, see getLinkStateDatabases()
+  auto stream = subscribeLinkState();
+  return decision_->getLinkStateDatabases().defer(
+      [stream = std::move(stream)](
+          folly::Try<std::unique_ptr<thrift::LinkStateDatabases>>&&
+              dbs) mutable {
+        dbs.throwIfFailed();
+        return apache::thrift::ResponseAndServerStream<
+            thrift::LinkStateDatabases,
+            thrift::LinkStateDelta>{std::move(*dbs.value()),
+                                    std::move(stream)};
+      });
+}
+
+apache::thrift::ServerStream<thrift::RouteDatabase>
+OpenrCtrlHandler::streamRouteDb(int32_t pageSize) {
+  CHECK(fib_);
+  return streamPages<thrift::RouteDatabasePage, thrift::RouteDatabase>(
+      pageSize,
+      [this](thrift::PageParams page) {
+        return fib_->getRouteDbPage(std::move(page));
+      },
+      [](thrift::RouteDatabasePage&& page) {
+        return std::move(*page.routeDb_ref());
+      });
+}
+
+apache::thrift::ServerStream<std::vector<thrift::ReceivedRouteDetail>>
+OpenrCtrlHandler::streamReceivedRoutesFiltered(
+    std::unique_ptr<thrift::ReceivedRouteFilter> filter, int32_t pageSize) {
+  CHECK(decision_);
+  return streamPages<
+      thrift::ReceivedRoutesPage,
+      std::vector<thrift::ReceivedRouteDetail>>(
+      pageSize,
+      [this, filter = std::move(*filter)](thrift::PageParams page) {
+        return decision_->getReceivedRoutesFilteredPage(
+            filter, std::move(page));
+      },
+      [](thrift::ReceivedRoutesPage&& page) {
+        return std::move(*page.routes_ref());
+      });
+}
+
+apache::thrift::ServerStream<thrift::PrefixDbs>
+OpenrCtrlHandler::streamDecisionPrefixDbs(int32_t pageSize) {
+  CHECK(decision_);
+  return streamPages<thrift::PrefixDbsPage, thrift::PrefixDbs>(
+      pageSize,
+      [this](thrift::PageParams page) {
+        return decision_->getDecisionPrefixDbsPage(std::move(page));
+      },
+      [](thrift::PrefixDbsPage&& page) {
+        return std::move(*page.prefixDbs_ref());
+      });
+}
+
+apache::thrift::ServerStream<thrift::Publication>
+OpenrCtrlHandler::streamKvStoreKeyValsFilteredArea(
+    std::unique_ptr<thrift::KeyDumpParams> filter,
+    std::unique_ptr<std::string> area,
+    int32_t pageSize) {
+  CHECK(kvStore_);
+  return streamPages<thrift::PublicationPage, thrift::Publication>(
+      pageSize,
+      [this, filter = std::move(*filter), area = std::move(*area)](
+          thrift::PageParams page) {
+        return kvStore_->dumpKvStoreKeysPage(filter, area, std::move(page));
+      },
+      [](thrift::PublicationPage&& page) {
+        return std::move(*page.publication_ref());
+      });
+}
+
 //
 // LinkMonitor APIs
 //
 folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_setNodeOverload() {
   CHECK(linkMonitor_);
-  return linkMonitor_->setNodeOverload(true);
+  return admitRequest(admission_, "setNodeOverload", Priority::CRITICAL, [&]() {
+    return linkMonitor_->setNodeOverload(true);
+  });
 }
 
 folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_unsetNodeOverload() {
   CHECK(linkMonitor_);
-  return linkMonitor_->setNodeOverload(false);
+  return admitRequest(
+      admission_, "unsetNodeOverload", Priority::CRITICAL, [&]() {
+        return linkMonitor_->setNodeOverload(false);
+      });
 }
 
 folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_setInterfaceOverload(
     std::unique_ptr<std::string> interfaceName) {
   CHECK(linkMonitor_);
-  return linkMonitor_->setInterfaceOverload(std::move(*interfaceName), true);
+  return admitRequest(
+      admission_, "setInterfaceOverload", Priority::CRITICAL, [&]() {
+        return linkMonitor_->setInterfaceOverload(
+            std::move(*interfaceName), true);
+      });
 }
 
 folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_unsetInterfaceOverload(
     std::unique_ptr<std::string> interfaceName) {
   CHECK(linkMonitor_);
-  return linkMonitor_->setInterfaceOverload(std::move(*interfaceName), false);
+  return admitRequest(
+      admission_, "unsetInterfaceOverload", Priority::CRITICAL, [&]() {
+        return linkMonitor_->setInterfaceOverload(
+            std::move(*interfaceName), false);
+      });
 }
 
 folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_setInterfaceMetric(
     std::unique_ptr<std::string> interfaceName, int32_t overrideMetric) {
   CHECK(linkMonitor_);
-  return linkMonitor_->setLinkMetric(std::move(*interfaceName), overrideMetric);
+  return admitRequest(
+      admission_, "setInterfaceMetric", Priority::CRITICAL, [&]() {
+        return linkMonitor_->setLinkMetric(
+            std::move(*interfaceName), overrideMetric);
+      });
 }
 
 folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_unsetInterfaceMetric(
     std::unique_ptr<std::string> interfaceName) {
   CHECK(linkMonitor_);
-  return linkMonitor_->setLinkMetric(std::move(*interfaceName), std::nullopt);
+  return admitRequest(
+      admission_, "unsetInterfaceMetric", Priority::CRITICAL, [&]() {
+        return linkMonitor_->setLinkMetric(
+            std::move(*interfaceName), std::nullopt);
+      });
 }
 
 folly::SemiFuture<folly::Unit>
@@ -846,8 +1767,11 @@ OpenrCtrlHandler::semifuture_setAdjacencyMetric(
     std::unique_ptr<std::string> adjNodeName,
     int32_t overrideMetric) {
   CHECK(linkMonitor_);
-  return linkMonitor_->setAdjacencyMetric(
-      std::move(*interfaceName), std::move(*adjNodeName), overrideMetric);
+  return admitRequest(
+      admission_, "setAdjacencyMetric", Priority::CRITICAL, [&]() {
+        return linkMonitor_->setAdjacencyMetric(
+            std::move(*interfaceName), std::move(*adjNodeName), overrideMetric);
+      });
 }
 
 folly::SemiFuture<folly::Unit>
@@ -855,20 +1779,28 @@ OpenrCtrlHandler::semifuture_unsetAdjacencyMetric(
     std::unique_ptr<std::string> interfaceName,
     std::unique_ptr<std::string> adjNodeName) {
   CHECK(linkMonitor_);
-  return linkMonitor_->setAdjacencyMetric(
-      std::move(*interfaceName), std::move(*adjNodeName), std::nullopt);
+  return admitRequest(
+      admission_, "unsetAdjacencyMetric", Priority::CRITICAL, [&]() {
+        return linkMonitor_->setAdjacencyMetric(
+            std::move(*interfaceName), std::move(*adjNodeName), std::nullopt);
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::DumpLinksReply>>
 OpenrCtrlHandler::semifuture_getInterfaces() {
   CHECK(linkMonitor_);
-  return linkMonitor_->getInterfaces();
+  return admitRequest(admission_, "getInterfaces", Priority::NORMAL, [&]() {
+    return linkMonitor_->getInterfaces();
+  });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::AdjacencyDatabase>>
 OpenrCtrlHandler::semifuture_getLinkMonitorAdjacencies() {
   CHECK(linkMonitor_);
-  return linkMonitor_->getAdjacencies();
+  return admitRequest(
+      admission_, "getLinkMonitorAdjacencies", Priority::NORMAL, [&]() {
+        return linkMonitor_->getAdjacencies();
+      });
 }
 
 //
@@ -908,7 +1840,9 @@ OpenrCtrlHandler::semifuture_getConfigKey(std::unique_ptr<std::string> key) {
 folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_setRibPolicy(
     std::unique_ptr<thrift::RibPolicy> policy) {
-  return decision_->setRibPolicy(*policy);
+  return admitRequest(admission_, "setRibPolicy", Priority::CRITICAL, [&]() {
+    return decision_->setRibPolicy(*policy);
+  });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::RibPolicy>>
@@ -918,4 +1852,135 @@ OpenrCtrlHandler::semifuture_getRibPolicy() {
   });
 }
 
+folly::SemiFuture<std::unique_ptr<std::vector<thrift::BatchResult>>>
+OpenrCtrlHandler::semifuture_getBatch(
+    std::unique_ptr<std::vector<thrift::BatchQuery>> queries) {
+  using QueryType = thrift::BatchQueryType;
+
+  // Getters are run in parallel, each of them hopping onto its module
+  std::vector<folly::SemiFuture<thrift::BatchResult>> futures;
+  futures.reserve(queries->size());
+  for (auto& query : *queries) {
+    const auto type = *query.type_ref();
+    switch (type) {
+    case QueryType::KVSTORE_PEERS:
+      if (not kvStore_) {
+        futures.emplace_back(makeBatchError(type, "KvStore is not running"));
+        break;
+      }
+      futures.emplace_back(makeBatchResult(
+          type,
+          kvStore_->getKvStorePeers(std::move(*query.area_ref())),
+          [](thrift::BatchResult& result, thrift::PeersMap&& peers) {
+            result.kvStorePeers_ref() = std::move(peers);
+          }));
+      break;
+    case QueryType::NEIGHBORS:
+      if (sparkShards_.empty()) {
+        futures.emplace_back(makeBatchError(type, "Spark is not running"));
+        break;
+      }
+      futures.emplace_back(makeBatchResult(
+          type,
+          semifuture_getNeighbors(),
+          [](thrift::BatchResult& result,
+             std::vector<thrift::SparkNeighbor>&& neighbors) {
+            result.neighbors_ref() = std::move(neighbors);
+          }));
+      break;
+    case QueryType::INTERFACES:
+      if (not linkMonitor_) {
+        futures.emplace_back(
+            makeBatchError(type, "LinkMonitor is not running"));
+        break;
+      }
+      futures.emplace_back(makeBatchResult(
+          type,
+          semifuture_getInterfaces(),
+          [](thrift::BatchResult& result,
+             thrift::DumpLinksReply&& interfaces) {
+            result.interfaces_ref() = std::move(interfaces);
+          }));
+      break;
+    case QueryType::COUNTERS: {
+      std::map<std::string, int64_t> counters;
+      if (query.counterKeys_ref().has_value()) {
+        getSelectedCounters(
+            counters,
+            std::make_unique<std::vector<std::string>>(
+                std::move(*query.counterKeys_ref())));
+      } else {
+        getCounters(counters);
+      }
+      thrift::BatchResult result;
+      *result.type_ref() = type;
+      result.counters_ref() = std::move(counters);
+      futures.emplace_back(folly::makeSemiFuture(std::move(result)));
+      break;
+    }
+    case QueryType::ROUTE_DB:
+      if (not fib_) {
+        futures.emplace_back(makeBatchError(type, "Fib is not running"));
+        break;
+      }
+      futures.emplace_back(makeBatchResult(
+          type,
+          semifuture_getRouteDb(),
+          [](thrift::BatchResult& result, thrift::RouteDatabase&& routeDb) {
+            result.routeDb_ref() = std::move(routeDb);
+          }));
+      break;
+    case QueryType::ROUTE_DB_COMPUTED:
+      if (not decision_) {
+        futures.emplace_back(makeBatchError(type, "Decision is not running"));
+        break;
+      }
+      futures.emplace_back(makeBatchResult(
+          type,
+          semifuture_getRouteDbComputed(
+              std::make_unique<std::string>(std::move(*query.nodeName_ref()))),
+          [](thrift::BatchResult& result, thrift::RouteDatabase&& routeDb) {
+            result.routeDb_ref() = std::move(routeDb);
+          }));
+      break;
+    case QueryType::DECISION_ADJACENCY_DBS:
+      if (not decision_) {
+        futures.emplace_back(makeBatchError(type, "Decision is not running"));
+        break;
+      }
+      futures.emplace_back(makeBatchResult(
+          type,
+          semifuture_getDecisionAdjacencyDbs(),
+          [](thrift::BatchResult& result, thrift::AdjDbs&& adjDbs) {
+            result.decisionAdjacencyDbs_ref() = std::move(adjDbs);
+          }));
+      break;
+    case QueryType::LINK_MONITOR_ADJACENCIES:
+      if (not linkMonitor_) {
+        futures.emplace_back(
+            makeBatchError(type, "LinkMonitor is not running"));
+        break;
+      }
+      futures.emplace_back(makeBatchResult(
+          type,
+          semifuture_getLinkMonitorAdjacencies(),
+          [](thrift::BatchResult& result,
+             thrift::AdjacencyDatabase&& adjacencies) {
+            result.linkMonitorAdjacencies_ref() = std::move(adjacencies);
+          }));
+      break;
+    default:
+      futures.emplace_back(makeBatchError(
+          type,
+          folly::sformat("Unknown query type {}", static_cast<int>(type))));
+    }
+  }
+
+  return folly::collect(std::move(futures))
+      .deferValue([](std::vector<thrift::BatchResult>&& results) {
+        return std::make_unique<std::vector<thrift::BatchResult>>(
+            std::move(results));
+      });
+}
+
 } // namespace openr
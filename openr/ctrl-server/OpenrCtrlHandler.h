@@ -7,10 +7,18 @@
 
 #pragma once
 
+#include <map>
+#include <unordered_set>
+
 #include <fb303/BaseService.h>
+#include <openr/common/CompactRouteDelta.h>
+#include <openr/common/Constants.h>
+#include <openr/common/SnapshotCache.h>
+#include <openr/common/StreamSubscriber.h>
 #include <openr/common/Types.h>
 #include <openr/config-store/PersistentStore.h>
 #include <openr/config/Config.h>
+#include <openr/ctrl-server/RequestAdmission.h>
 #include <openr/decision/Decision.h>
 #include <openr/fib/Fib.h>
 #include <openr/if/gen-cpp2/OpenrCtrlCpp.h>
@@ -39,7 +47,7 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
       Monitor* Monitor,
       PersistentStore* configStore,
       PrefixManager* prefixManager,
-      Spark* spark,
+      std::vector<Spark*> sparkShards,
       std::shared_ptr<const Config> config);
 
   ~OpenrCtrlHandler() override;
@@ -73,6 +81,8 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   void dryrunConfig(
       ::std::string& _return, std::unique_ptr<::std::string> file) override;
 
+  int64_t reloadConfig(std::unique_ptr<::std::string> file) override;
+
   //
   // Monitor APIs
   //
@@ -109,6 +119,11 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   semifuture_getReceivedRoutesFiltered(
       std::unique_ptr<thrift::ReceivedRouteFilter> filter) override;
 
+  folly::SemiFuture<std::unique_ptr<thrift::ReceivedRoutesPage>>
+  semifuture_getReceivedRoutesFilteredPage(
+      std::unique_ptr<thrift::ReceivedRouteFilter> filter,
+      std::unique_ptr<thrift::PageParams> page) override;
+
   //
   // Fib APIs
   //
@@ -116,6 +131,9 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   folly::SemiFuture<std::unique_ptr<thrift::RouteDatabase>>
   semifuture_getRouteDb() override;
 
+  folly::SemiFuture<std::unique_ptr<thrift::RouteDatabasePage>>
+  semifuture_getRouteDbPage(std::unique_ptr<thrift::PageParams> page) override;
+
   folly::SemiFuture<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
   semifuture_getUnicastRoutesFiltered(
       std::unique_ptr<std::vector<::std::string>> prefixes) override;
@@ -166,9 +184,26 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   folly::SemiFuture<std::unique_ptr<thrift::PrefixDbs>>
   semifuture_getDecisionPrefixDbs() override;
 
+  folly::SemiFuture<std::unique_ptr<thrift::PrefixDbsPage>>
+  semifuture_getDecisionPrefixDbsPage(
+      std::unique_ptr<thrift::PageParams> page) override;
+
+  folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteBuildProfile>>>
+  semifuture_getDecisionRouteBuildProfiles() override;
+
   folly::SemiFuture<std::unique_ptr<thrift::RouteDatabase>>
   semifuture_getRouteDbComputed(std::unique_ptr<std::string> nodeName) override;
 
+  folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteDatabase>>>
+  semifuture_getRouteDbComputedBatch(
+      std::unique_ptr<std::vector<std::string>> nodeNames) override;
+
+  folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteDatabase>>>
+  semifuture_getRouteDbWhatIf(
+      std::unique_ptr<std::string> nodeName,
+      std::unique_ptr<std::vector<thrift::WhatIfScenario>> scenarios)
+      override;
+
   //
   // KvStore APIs
   //
@@ -193,6 +228,12 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
       std::unique_ptr<thrift::KeyDumpParams> filter,
       std::unique_ptr<std::string> area) override;
 
+  folly::SemiFuture<std::unique_ptr<thrift::PublicationPage>>
+  semifuture_getKvStoreKeyValsFilteredAreaPage(
+      std::unique_ptr<thrift::KeyDumpParams> filter,
+      std::unique_ptr<std::string> area,
+      std::unique_ptr<thrift::PageParams> page) override;
+
   folly::SemiFuture<std::unique_ptr<thrift::Publication>>
   semifuture_getKvStoreHashFiltered(
       std::unique_ptr<thrift::KeyDumpParams> filter) override;
@@ -229,6 +270,9 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   apache::thrift::ServerStream<thrift::Publication> subscribeKvStoreFilter(
       std::unique_ptr<thrift::KeyDumpParams>);
   apache::thrift::ServerStream<thrift::RouteDatabaseDelta> subscribeFib();
+  apache::thrift::ServerStream<thrift::CompactRouteDatabaseDelta>
+  subscribeFibCompact();
+  apache::thrift::ServerStream<thrift::LinkStateDelta> subscribeLinkState();
 
   folly::SemiFuture<apache::thrift::ResponseAndServerStream<
       thrift::Publication,
@@ -246,10 +290,42 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
       thrift::RouteDatabaseDelta>>
   semifuture_subscribeAndGetFib() override;
 
+  folly::SemiFuture<apache::thrift::ResponseAndServerStream<
+      thrift::RouteDatabase,
+      thrift::CompactRouteDatabaseDelta>>
+  semifuture_subscribeAndGetFibCompact() override;
+
+  folly::SemiFuture<apache::thrift::ResponseAndServerStream<
+      thrift::LinkStateDatabases,
+      thrift::LinkStateDelta>>
+  semifuture_subscribeAndGetLinkState() override;
+
+  // Chunked variants of large result APIs, streaming their pages
+  apache::thrift::ServerStream<thrift::RouteDatabase> streamRouteDb(
+      int32_t pageSize) override;
+
+  apache::thrift::ServerStream<std::vector<thrift::ReceivedRouteDetail>>
+  streamReceivedRoutesFiltered(
+      std::unique_ptr<thrift::ReceivedRouteFilter> filter,
+      int32_t pageSize) override;
+
+  apache::thrift::ServerStream<thrift::PrefixDbs> streamDecisionPrefixDbs(
+      int32_t pageSize) override;
+
+  apache::thrift::ServerStream<thrift::Publication>
+  streamKvStoreKeyValsFilteredArea(
+      std::unique_ptr<thrift::KeyDumpParams> filter,
+      std::unique_ptr<std::string> area,
+      int32_t pageSize) override;
+
   // Long poll support
   folly::SemiFuture<bool> semifuture_longPollKvStoreAdj(
       std::unique_ptr<thrift::KeyVals> snapshot) override;
 
+  folly::SemiFuture<bool> semifuture_longPollKvStoreAdjArea(
+      std::unique_ptr<thrift::KeyVals> snapshot,
+      std::unique_ptr<std::string> area) override;
+
   //
   // LinkMonitor APIs
   //
@@ -285,6 +361,17 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   // Explicitly override blocking API call as no ASYNC needed
   void getOpenrVersion(thrift::OpenrVersions& openrVersion) override;
   void getBuildInfo(thrift::BuildInfo& buildInfo) override;
+  void getThreadPlacements(
+      std::vector<thrift::ThreadPlacement>& placements) override;
+  void getModuleMemoryStats(
+      std::vector<thrift::ModuleMemoryStats>& stats) override;
+  void dumpHeapProfile(std::string& path) override;
+  void profileThread(
+      thrift::ThreadProfile& profile,
+      std::unique_ptr<std::string> threadName,
+      int32_t durationMs,
+      int32_t intervalUs) override;
+  void getStartupPerfEvents(thrift::PerfEvents& perfEvents) override;
 
   //
   // PersistentStore APIs
@@ -310,6 +397,14 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   folly::SemiFuture<std::unique_ptr<thrift::RibPolicy>>
   semifuture_getRibPolicy() override;
 
+  //
+  // Batch APIs
+  //
+
+  folly::SemiFuture<std::unique_ptr<std::vector<thrift::BatchResult>>>
+  semifuture_getBatch(
+      std::unique_ptr<std::vector<thrift::BatchQuery>> queries) override;
+
   //
   // APIs to expose state of private variables
   //
@@ -321,7 +416,11 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
 
   inline size_t
   getNumPendingLongPollReqs() {
-    return longPollReqs_->size();
+    size_t numReqs{0};
+    for (auto const& kv : *adjKeysStates_.rlock()) {
+      numReqs += kv.second.longPollReqs.size();
+    }
+    return numReqs;
   }
 
   inline size_t
@@ -329,18 +428,47 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
     return fibPublishers_.wlock()->size();
   }
 
+  inline size_t
+  getNumFibCompactPublishers() {
+    return fibCompactPublishers_.wlock()->size();
+  }
+
+  inline size_t
+  getNumLinkStatePublishers() {
+    return linkStatePublishers_.wlock()->size();
+  }
+
+  // KvStore snoop streams are non-critical and paused under severe memory
+  // pressure: active ones are terminated and new subscriptions refused, so
+  // that clients subscribe again with a fresh snapshot once pressure is gone
+  void setMemoryPressure(MemoryPressure level);
+
   //
   // API to cleanup private variables
   //
   inline void
   cleanupPendingLongPollReqs() {
-    longPollReqs_->clear();
+    for (auto& kv : *adjKeysStates_.wlock()) {
+      kv.second.longPollReqs.clear();
+    }
   }
 
  private:
   void authorizeConnection();
+  // Publish KvStore update to all kvstore snoop publishers
+  void publishToKvStorePublishers(const thrift::Publication& publication);
   void closeKvStorePublishers();
+
+  // Update "adj:" keys of area of publication and notify long poll requests
+  // pending for them if changed. Requests held for too long are expired.
+  void processAdjKeysPublication(const thrift::Publication& publication);
   void closeFibPublishers();
+  void closeLinkStatePublishers();
+
+  // Apply tunables of config to modules, stopping at the first failure.
+  // Returns error of the failure if any
+  std::optional<std::string> applyConfigToModules(
+      std::shared_ptr<const Config> const& config);
 
   const std::string nodeName_;
   const std::unordered_set<std::string> acceptablePeerCommonNames_;
@@ -353,29 +481,76 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   Monitor* monitor_{nullptr};
   PersistentStore* configStore_{nullptr};
   PrefixManager* prefixManager_{nullptr};
-  Spark* spark_{nullptr};
+  // Spark instances, one per shard of interfaces
+  std::vector<Spark*> sparkShards_;
   std::shared_ptr<const Config> config_;
 
+  // Admission control of requests to modules, see RequestAdmission
+  RequestAdmission admission_{
+      Constants::kCtrlMaxConcurrentPerMethod,
+      Constants::kCtrlMaxConcurrentBulkPerMethod,
+      Constants::kCtrlMaxConcurrentBulk};
+
   // Publisher token (monotonically increasing) for all publishers
   std::atomic<int64_t> publisherToken_{0};
 
-  // Active kvstore snoop publishers
+  // see setMemoryPressure()
+  std::atomic<bool> kvStoreSnoopPaused_{false};
+
+  // Active kvstore snoop publishers. Shared with the KvStore updates fiber,
+  // which publishes without holding the lock.
   folly::Synchronized<
-      std::unordered_map<int64_t, std::unique_ptr<KvStorePublisher>>>
+      std::unordered_map<int64_t, std::shared_ptr<KvStorePublisher>>>
       kvStorePublishers_;
 
+  // Snapshots for clients subscribing to KvStore and Fib, invalidated on
+  // every update received from them
+  SnapshotCache<thrift::Publication> kvStoreSnapshots_{
+      "subscribers.kvstore.snapshot"};
+  SnapshotCache<thrift::RouteDatabase> fibSnapshots_{
+      "subscribers.fib.snapshot"};
+
   // Active Fib streaming publishers
   folly::Synchronized<std::unordered_map<
       int64_t,
-      apache::thrift::ServerStreamPublisher<thrift::RouteDatabaseDelta>>>
+      std::shared_ptr<StreamSubscriber<thrift::RouteDatabaseDelta>>>>
       fibPublishers_;
 
-  // pending longPoll requests from clients, which consists of
-  // 1). promise; 2). timestamp when req received on server
-  std::atomic<int64_t> pendingRequestId_{0};
+  // Active compact Fib streaming publishers, with the encoder of their
+  // stream. Encoders are only used by the Fib updates fiber, in order
+  struct FibCompactPublisher {
+    std::shared_ptr<StreamSubscriber<thrift::CompactRouteDatabaseDelta>>
+        subscriber;
+    CompactRouteDeltaEncoder encoder{Constants::kFibStreamMaxNextHopGroups};
+  };
   folly::Synchronized<
-      std::unordered_map<int64_t, std::pair<folly::Promise<bool>, int64_t>>>
-      longPollReqs_;
+      std::unordered_map<int64_t, std::shared_ptr<FibCompactPublisher>>>
+      fibCompactPublishers_;
+
+  // Active link state streaming publishers, fed if Decision publishes link
+  // state updates
+  bool hasLinkStateUpdates_{false};
+  folly::Synchronized<std::unordered_map<
+      int64_t,
+      std::shared_ptr<StreamSubscriber<thrift::LinkStateDelta>>>>
+      linkStatePublishers_;
+
+  // "adj:" keys of an area and longPoll requests pending for their change
+  struct AdjKeysState {
+    // "adj:" keys without value, as seen in publications from KvStore
+    thrift::KeyVals adjKeyVals;
+    // set once adjKeyVals is synced with KvStore by the first request
+    bool isSynced{false};
+    // adj keys expired before sync, which KvStore dump may still contain
+    std::unordered_set<std::string> expiredBeforeSync;
+    // pending longPoll requests from clients in order of arrival, which
+    // consists of 1). promise; 2). timestamp when req received on server
+    std::map<int64_t, std::pair<folly::Promise<bool>, int64_t>> longPollReqs;
+  };
+
+  std::atomic<int64_t> pendingRequestId_{0};
+  folly::Synchronized<std::unordered_map<std::string, AdjKeysState>>
+      adjKeysStates_;
 
   // fiber task future hold for kvStore update, fib update reader's
   std::vector<folly::Future<folly::Unit>> workers_;
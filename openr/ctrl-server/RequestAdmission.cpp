@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/ctrl-server/RequestAdmission.h>
+
+#include <fb303/ServiceData.h>
+#include <folly/Format.h>
+#include <folly/GLog.h>
+#include <folly/MapUtil.h>
+
+namespace fb303 = facebook::fb303;
+
+namespace openr {
+
+namespace {
+
+std::string
+getLatencyKey(const std::string& method) {
+  return folly::sformat("ctrl.{}.latency_ms", method);
+}
+
+} // namespace
+
+RequestAdmission::Ticket::Ticket(
+    std::shared_ptr<folly::Synchronized<State>> state,
+    std::string method,
+    Priority priority)
+    : state_(std::move(state)),
+      method_(std::move(method)),
+      priority_(priority),
+      startTime_(std::chrono::steady_clock::now()) {}
+
+RequestAdmission::Ticket::Ticket(Ticket&& other) noexcept
+    : state_(std::move(other.state_)),
+      method_(std::move(other.method_)),
+      priority_(other.priority_),
+      startTime_(other.startTime_) {}
+
+RequestAdmission::Ticket::~Ticket() {
+  if (not state_) {
+    return;
+  }
+  state_->withWLock([&](auto& state) {
+    --state.numInFlight.at(method_);
+    if (priority_ == Priority::BULK) {
+      --state.numBulkInFlight;
+    }
+  });
+  const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime_);
+  fb303::fbData->addHistogramValue(getLatencyKey(method_), latency.count());
+}
+
+RequestAdmission::RequestAdmission(
+    size_t maxConcurrentPerMethod,
+    size_t maxConcurrentBulkPerMethod,
+    size_t maxConcurrentBulk)
+    : maxConcurrentPerMethod_(maxConcurrentPerMethod),
+      maxConcurrentBulkPerMethod_(maxConcurrentBulkPerMethod),
+      maxConcurrentBulk_(maxConcurrentBulk),
+      state_(std::make_shared<folly::Synchronized<State>>()) {}
+
+std::optional<RequestAdmission::Ticket>
+RequestAdmission::admit(const std::string& method, Priority priority) {
+  bool isNewMethod{false};
+  const bool admitted = state_->withWLock([&](auto& state) {
+    auto [it, inserted] = state.numInFlight.emplace(method, 0);
+    isNewMethod = inserted;
+    auto& numInFlight = it->second;
+    switch (priority) {
+    case Priority::CRITICAL:
+      break;
+    case Priority::NORMAL:
+      if (numInFlight >= maxConcurrentPerMethod_) {
+        return false;
+      }
+      break;
+    case Priority::BULK:
+      if (numInFlight >= maxConcurrentBulkPerMethod_ or
+          state.numBulkInFlight >= maxConcurrentBulk_) {
+        return false;
+      }
+      ++state.numBulkInFlight;
+      break;
+    }
+    ++numInFlight;
+    return true;
+  });
+
+  if (isNewMethod) {
+    // 10ms buckets up to 10s
+    const auto latencyKey = getLatencyKey(method);
+    fb303::fbData->addHistogram(latencyKey, 10, 0, 10000);
+    fb303::fbData->exportHistogramPercentile(latencyKey, 50, 95, 99);
+  }
+  if (not admitted) {
+    FB_LOG_EVERY_MS(WARNING, 1000)
+        << "Rejecting " << method << " request, too many in flight";
+    fb303::fbData->addStatValue(
+        folly::sformat("ctrl.{}.rejected", method), 1, fb303::SUM);
+    return std::nullopt;
+  }
+  return Ticket(state_, method, priority);
+}
+
+size_t
+RequestAdmission::getNumInFlight(const std::string& method) const {
+  return folly::get_default(state_->rlock()->numInFlight, method, 0);
+}
+
+} // namespace openr
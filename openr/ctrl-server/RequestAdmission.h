@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include <folly/Synchronized.h>
+
+namespace openr {
+
+/**
+ * Admission control of openrCtrl requests, so that a flood of expensive
+ * requests e.g. unfiltered KvStore dumps from misbehaving automation can't
+ * starve the others. Requests are admitted up to a number running at once per
+ * method, depending on their priority class.
+ *
+ * Counters, per method:
+ * - `ctrl.<method>.rejected`: requests rejected
+ * - `ctrl.<method>.latency_ms`: histogram of latency of admitted requests
+ */
+class RequestAdmission {
+ public:
+  enum class Priority {
+    // always admitted, e.g. drains and prefix advertisements
+    CRITICAL,
+    // admitted up to maxConcurrentPerMethod
+    NORMAL,
+    // expensive dumps, admitted up to maxConcurrentBulkPerMethod and
+    // maxConcurrentBulk requests of any bulk method
+    BULK,
+  };
+
+  // Slot of an admitted request, released on destruction
+  class Ticket;
+
+  RequestAdmission(
+      size_t maxConcurrentPerMethod,
+      size_t maxConcurrentBulkPerMethod,
+      size_t maxConcurrentBulk);
+
+  // Admit request of method, std::nullopt if it is rejected
+  std::optional<Ticket> admit(const std::string& method, Priority priority);
+
+  // Number of admitted requests of method still running
+  size_t getNumInFlight(const std::string& method) const;
+
+ private:
+  const size_t maxConcurrentPerMethod_{0};
+  const size_t maxConcurrentBulkPerMethod_{0};
+  const size_t maxConcurrentBulk_{0};
+
+  struct State {
+    // admitted requests running, per method
+    std::unordered_map<std::string, size_t> numInFlight;
+    // admitted bulk requests running
+    size_t numBulkInFlight{0};
+  };
+
+  // shared with tickets, which may outlive this
+  std::shared_ptr<folly::Synchronized<State>> state_;
+};
+
+class RequestAdmission::Ticket {
+ public:
+  Ticket(Ticket&& other) noexcept;
+  Ticket& operator=(Ticket&&) = delete;
+  ~Ticket();
+
+ private:
+  friend class RequestAdmission;
+
+  Ticket(
+      std::shared_ptr<folly::Synchronized<State>> state,
+      std::string method,
+      Priority priority);
+
+  std::shared_ptr<folly::Synchronized<State>> state_;
+  std::string method_;
+  Priority priority_;
+  std::chrono::steady_clock::time_point startTime_;
+};
+
+} // namespace openr
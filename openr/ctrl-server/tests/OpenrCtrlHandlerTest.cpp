@@ -8,8 +8,10 @@
 #include <cstdio>
 #include <thread>
 
+#include <fb303/ServiceData.h>
 #include <fbzmq/zmq/Context.h>
 #include <folly/init/Init.h>
+#include <folly/synchronization/Baton.h>
 #include <gtest/gtest.h>
 
 #include <openr/common/Constants.h>
@@ -28,6 +30,8 @@
 
 using namespace openr;
 
+namespace fb303 = facebook::fb303;
+
 class OpenrCtrlFixture : public ::testing::Test {
  public:
   void
@@ -90,6 +94,7 @@ class OpenrCtrlFixture : public ::testing::Test {
         std::chrono::seconds(2),
         routeUpdatesQueue_.getReader(),
         interfaceUpdatesQueue_.getReader(),
+        interfaceStatusEventsQueue_.getReader(),
         fibUpdatesQueue_,
         logSampleQueue_,
         kvStoreWrapper_->getKvStore());
@@ -124,6 +129,7 @@ class OpenrCtrlFixture : public ::testing::Test {
         persistentStore.get(),
         false /* enable perf measurement */,
         interfaceUpdatesQueue_,
+        interfaceStatusEventsQueue_,
         prefixUpdatesQueue_,
         peerUpdatesQueue_,
         logSampleQueue_,
@@ -162,6 +168,7 @@ class OpenrCtrlFixture : public ::testing::Test {
     routeUpdatesQueue_.close();
     staticRoutesUpdatesQueue_.close();
     interfaceUpdatesQueue_.close();
+    interfaceStatusEventsQueue_.close();
     peerUpdatesQueue_.close();
     neighborUpdatesQueue_.close();
     prefixUpdatesQueue_.close();
@@ -222,8 +229,9 @@ class OpenrCtrlFixture : public ::testing::Test {
   }
 
  private:
-  messaging::ReplicateQueue<DecisionRouteUpdate> routeUpdatesQueue_;
-  messaging::ReplicateQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue_;
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue_;
+  messaging::ReplicateQueue<InterfaceDatabaseUpdate> interfaceUpdatesQueue_;
+  messaging::ReplicateQueue<InterfaceStatusEvent> interfaceStatusEventsQueue_;
   messaging::ReplicateQueue<thrift::PeerUpdateRequest> peerUpdatesQueue_;
   messaging::ReplicateQueue<thrift::SparkNeighborEvent> neighborUpdatesQueue_;
   messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue_;
@@ -345,6 +353,16 @@ TEST_F(OpenrCtrlFixture, RouteApis) {
     EXPECT_EQ(0, db.mplsRoutes_ref()->size());
   }
 
+  {
+    const std::string testNode("avengers@universe");
+    std::vector<thrift::RouteDatabase> dbs;
+    openrCtrlThriftClient_->sync_getRouteDbComputedBatch(
+        dbs, {testNode, ""});
+    ASSERT_EQ(2, dbs.size());
+    EXPECT_EQ(testNode, *dbs.at(0).thisNodeName_ref());
+    EXPECT_EQ(nodeName_, *dbs.at(1).thisNodeName_ref());
+  }
+
   {
     std::vector<thrift::UnicastRoute> filterRet;
     std::vector<std::string> prefixes{"10.46.2.0", "10.46.2.0/24"};
@@ -376,6 +394,38 @@ TEST_F(OpenrCtrlFixture, PerfApis) {
   EXPECT_EQ(nodeName_, db.thisNodeName_ref());
 }
 
+TEST_F(OpenrCtrlFixture, BatchApis) {
+  std::vector<thrift::BatchQuery> queries(5);
+  *queries[0].type_ref() = thrift::BatchQueryType::ROUTE_DB;
+  *queries[1].type_ref() = thrift::BatchQueryType::ROUTE_DB_COMPUTED;
+  *queries[1].nodeName_ref() = "avengers@universe";
+  *queries[2].type_ref() = thrift::BatchQueryType::DECISION_ADJACENCY_DBS;
+  *queries[3].type_ref() = thrift::BatchQueryType::COUNTERS;
+  queries[3].counterKeys_ref() = {"unknown.counter"};
+  // failing query doesn't fail the others
+  *queries[4].type_ref() = thrift::BatchQueryType::KVSTORE_PEERS;
+  *queries[4].area_ref() = "unknown-area";
+
+  std::vector<thrift::BatchResult> results;
+  openrCtrlThriftClient_->sync_getBatch(results, queries);
+  ASSERT_EQ(5, results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(*queries[i].type_ref(), *results[i].type_ref());
+  }
+
+  ASSERT_TRUE(results[0].routeDb_ref().has_value());
+  EXPECT_EQ(nodeName_, *results[0].routeDb_ref()->thisNodeName_ref());
+  ASSERT_TRUE(results[1].routeDb_ref().has_value());
+  EXPECT_EQ(
+      "avengers@universe", *results[1].routeDb_ref()->thisNodeName_ref());
+  ASSERT_TRUE(results[2].decisionAdjacencyDbs_ref().has_value());
+  EXPECT_EQ(0, results[2].decisionAdjacencyDbs_ref()->size());
+  ASSERT_TRUE(results[3].counters_ref().has_value());
+  EXPECT_EQ(0, results[3].counters_ref()->size());
+  EXPECT_FALSE(results[4].kvStorePeers_ref().has_value());
+  EXPECT_TRUE(results[4].error_ref().has_value());
+}
+
 TEST_F(OpenrCtrlFixture, DecisionApis) {
   {
     thrift::AdjDbs db;
@@ -489,6 +539,82 @@ TEST_F(OpenrCtrlFixture, KvStoreApis) {
     EXPECT_EQ(keyValsPlane.at("keyPlane2"), pub.keyVals_ref()["keyPlane2"]);
   }
 
+  // paginated, in key order
+  {
+    thrift::KeyDumpParams params;
+    *params.prefix_ref() = "key";
+    thrift::PageParams page;
+    *page.limit_ref() = 4;
+
+    std::vector<std::string> keys;
+    size_t numPages{0};
+    while (true) {
+      thrift::PublicationPage publicationPage;
+      openrCtrlThriftClient_->sync_getKvStoreKeyValsFilteredAreaPage(
+          publicationPage,
+          params,
+          thrift::KvStore_constants::kDefaultArea(),
+          page);
+      ++numPages;
+      for (auto const& [key, _] :
+           *publicationPage.publication_ref()->keyVals_ref()) {
+        keys.emplace_back(key);
+      }
+      if (not publicationPage.nextCursor_ref()) {
+        break;
+      }
+      page.cursor_ref() = *publicationPage.nextCursor_ref();
+    }
+    EXPECT_EQ(3, numPages);
+    std::sort(keys.begin(), keys.end());
+    EXPECT_EQ(
+        std::vector<std::string>(
+            {"key1",
+             "key11",
+             "key111",
+             "key2",
+             "key22",
+             "key222",
+             "key3",
+             "key33",
+             "key333"}),
+        keys);
+
+    // same pages streamed as chunks
+    folly::Baton<> streamDone;
+    std::vector<size_t> chunkSizes;
+    auto handler = openrThriftServerWrapper_->getOpenrCtrlHandler();
+    auto subscription =
+        handler
+            ->streamKvStoreKeyValsFilteredArea(
+                std::make_unique<thrift::KeyDumpParams>(params),
+                std::make_unique<std::string>(
+                    thrift::KvStore_constants::kDefaultArea()),
+                4)
+            .toClientStream()
+            .subscribeExTry(folly::getEventBase(), [&](auto&& t) {
+              if (not t.hasValue()) {
+                streamDone.post();
+                return;
+              }
+              chunkSizes.emplace_back(t->keyVals_ref()->size());
+            });
+    streamDone.wait();
+    EXPECT_EQ(std::vector<size_t>({4, 4, 1}), chunkSizes);
+    std::move(subscription).join();
+
+    // pages must make progress
+    *page.limit_ref() = 0;
+    thrift::PublicationPage publicationPage;
+    EXPECT_THROW(
+        openrCtrlThriftClient_->sync_getKvStoreKeyValsFilteredAreaPage(
+            publicationPage,
+            params,
+            thrift::KvStore_constants::kDefaultArea(),
+            page),
+        thrift::OpenrError);
+  }
+
   {
     thrift::Publication pub;
     thrift::KeyDumpParams params;
@@ -877,6 +1003,10 @@ TEST_F(OpenrCtrlFixture, subscribeAndGetKvStoreFilteredWithKeysNoTtlUpdate) {
       std::this_thread::yield();
     }
 
+    // Both clients have the same filter, publications are filtered once
+    EXPECT_EQ(
+        1, fb303::fbData->getCounter("subscribers.kvstore.filter_groups"));
+
     // Cancel subscription
     subscription.cancel();
     std::move(subscription).detach();
@@ -82,6 +82,7 @@ class LongPollFixture : public ::testing::Test {
  public:
   const std::string nodeName_{"Valar-Morghulis"};
   const std::string adjKey_ = folly::sformat("adj:{}", nodeName_);
+  const std::string adjDeltaKey_ = folly::sformat("adjdelta:{}", nodeName_);
   const std::string prefixKey_ = folly::sformat("prefix:{}", nodeName_);
 
   fbzmq::ZmqEventLoop evl_;
@@ -142,6 +143,57 @@ TEST_F(LongPollFixture, LongPollAdjAdded) {
   evlThread.join();
 }
 
+TEST_F(LongPollFixture, LongPollAdjDeltaAdded) {
+  //
+  // Adjacency changes flooded as "adjdelta:" keys only, see
+  // enable_adj_db_delta, must answer long polls like "adj:" keys.
+  //
+  bool isAdjChanged = false;
+  bool isTimeout = false;
+  std::chrono::steady_clock::time_point startTime;
+  std::chrono::steady_clock::time_point endTime;
+
+  // mimick there is a new publication from kvstore
+  evl_.scheduleTimeout(std::chrono::milliseconds(5000), [&]() noexcept {
+    LOG(INFO) << "AdjDeltaKey set...";
+    startTime = std::chrono::steady_clock::now();
+    kvStoreWrapper_->setKey(
+        adjDeltaKey_, createThriftValue(1, nodeName_, std::string("delta1")));
+    evl_.stop();
+  });
+
+  std::thread evlThread([&]() { evl_.run(); });
+  evl_.waitUntilRunning();
+
+  try {
+    thrift::KeyVals snapshot;
+    isAdjChanged = client1_->sync_longPollKvStoreAdj(snapshot);
+    endTime = std::chrono::steady_clock::now();
+  } catch (std::exception& ex) {
+    LOG(INFO) << "Exception happened: " << folly::exceptionStr(ex);
+    isTimeout = true;
+  }
+
+  ASSERT_FALSE(isTimeout);
+  ASSERT_LE(endTime - startTime, std::chrono::milliseconds(450));
+  ASSERT_TRUE(isAdjChanged);
+
+  evl_.waitUntilStopped();
+  evlThread.join();
+
+  // a client behind on the delta key is answered right away
+  kvStoreWrapper_->setKey(
+      adjDeltaKey_, createThriftValue(2, nodeName_, std::string("delta2")));
+  thrift::KeyVals snapshot;
+  snapshot.emplace(
+      adjDeltaKey_, createThriftValue(1, nodeName_, std::string("delta1")));
+  startTime = std::chrono::steady_clock::now();
+  EXPECT_TRUE(client1_->sync_longPollKvStoreAdj(snapshot));
+  EXPECT_LE(
+      std::chrono::steady_clock::now() - startTime,
+      std::chrono::milliseconds(50));
+}
+
 TEST_F(LongPollFixture, LongPollTimeout) {
   //
   // This UT mimicks the scenario there is a client side timeout since
@@ -310,6 +362,41 @@ TEST_F(LongPollFixture, LongPollAdjExpired) {
   ASSERT_TRUE(isAdjChanged);
 }
 
+TEST_F(LongPollFixture, LongPollAdjArea) {
+  //
+  // This UT mimicks the long poll of specific area. Request consistent with
+  // KvStore is held, and notified on "adj:" key change of its area.
+  //
+  auto handler = openrThriftServerWrapper_->getOpenrCtrlHandler();
+  kvStoreWrapper_->setKey(
+      adjKey_, createThriftValue(1, nodeName_, std::string("value1")));
+
+  thrift::KeyVals snapshot;
+  snapshot.emplace(
+      adjKey_, createThriftValue(1, nodeName_, std::string("value1")));
+  auto longPoll = [&]() {
+    return handler->semifuture_longPollKvStoreAdjArea(
+        std::make_unique<thrift::KeyVals>(snapshot),
+        std::make_unique<std::string>(
+            thrift::KvStore_constants::kDefaultArea()));
+  };
+
+  // request is held as it is consistent with KvStore. Retry if notified of
+  // the key set above, if its publication got processed after the request.
+  auto sf = longPoll();
+  while (sf.isReady()) {
+    EXPECT_TRUE(std::move(sf).get());
+    sf = longPoll();
+  }
+
+  kvStoreWrapper_->setKey(
+      adjKey_, createThriftValue(2, nodeName_, std::string("value2")));
+  bool isAdjChanged = std::move(sf).get();
+
+  ASSERT_TRUE(isAdjChanged);
+  EXPECT_EQ(0, handler->getNumPendingLongPollReqs());
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
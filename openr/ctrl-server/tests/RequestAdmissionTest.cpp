@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <vector>
+
+#include <fb303/ServiceData.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <openr/ctrl-server/RequestAdmission.h>
+
+namespace fb303 = facebook::fb303;
+
+namespace openr {
+
+using Priority = RequestAdmission::Priority;
+
+TEST(RequestAdmission, LimitsPerPriority) {
+  RequestAdmission admission(
+      3 /* maxConcurrentPerMethod */,
+      2 /* maxConcurrentBulkPerMethod */,
+      3 /* maxConcurrentBulk */);
+  std::vector<RequestAdmission::Ticket> tickets;
+
+  // normal requests up to the limit of the method
+  for (int i = 0; i < 3; ++i) {
+    auto ticket = admission.admit("get", Priority::NORMAL);
+    ASSERT_TRUE(ticket.has_value());
+    tickets.emplace_back(std::move(*ticket));
+  }
+  EXPECT_FALSE(admission.admit("get", Priority::NORMAL).has_value());
+  EXPECT_EQ(3, admission.getNumInFlight("get"));
+  EXPECT_EQ(1, fb303::fbData->getCounters().at("ctrl.get.rejected.sum"));
+
+  // bulk requests up to the limit of the method and of all bulk methods
+  for (auto const& method : {"dumpA", "dumpA", "dumpB"}) {
+    auto ticket = admission.admit(method, Priority::BULK);
+    ASSERT_TRUE(ticket.has_value());
+    tickets.emplace_back(std::move(*ticket));
+  }
+  EXPECT_FALSE(admission.admit("dumpA", Priority::BULK).has_value());
+  EXPECT_FALSE(admission.admit("dumpC", Priority::BULK).has_value());
+
+  // critical requests are always admitted
+  EXPECT_TRUE(admission.admit("get", Priority::CRITICAL).has_value());
+
+  // finished requests release their slot
+  tickets.clear();
+  EXPECT_EQ(0, admission.getNumInFlight("get"));
+  EXPECT_EQ(0, admission.getNumInFlight("dumpA"));
+  EXPECT_TRUE(admission.admit("dumpC", Priority::BULK).has_value());
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
@@ -7,10 +7,15 @@
 
 #include "Decision.h"
 
+#include <algorithm>
 #include <chrono>
+#include <map>
+#include <numeric>
 #include <set>
 #include <string>
+#include <tuple>
 #include <unordered_set>
+#include <utility>
 
 #include <fb303/ServiceData.h>
 #include <folly/Format.h>
@@ -18,7 +23,10 @@
 #include <folly/Memory.h>
 #include <folly/Optional.h>
 #include <folly/String.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/futures/Future.h>
+#include <folly/hash/Hash.h>
 #if FOLLY_USE_SYMBOLIZER
 #include <folly/experimental/exception_tracer/ExceptionTracer.h>
 #endif
@@ -28,6 +36,8 @@
 #include <openr/common/Util.h>
 #include <openr/decision/PrefixState.h>
 #include <openr/decision/RibEntry.h>
+#include <openr/decision/RouteComputationEngine.h>
+#include <openr/kvstore/KvStoreSnapshot.h>
 
 using namespace std;
 
@@ -41,6 +51,11 @@ using Metric = openr::LinkStateMetric;
 
 using SpfResult = openr::LinkState::SpfResult;
 
+namespace {
+// Don't bother sharding route computation into pieces smaller than this
+const size_t kMinPrefixesPerRouteBuildShard{1000};
+} // namespace
+
 namespace openr {
 
 namespace detail {
@@ -50,28 +65,51 @@ DecisionPendingUpdates::applyLinkStateChange(
     std::string const& nodeName,
     LinkState::LinkStateChange const& change,
     std::optional<thrift::PerfEvents> const& perfEvents) {
-  needsFullRebuild_ |=
-      (change.topologyChanged || change.nodeLabelChanged ||
-       // we only need a full rebuild if link attributes change locally
-       // this would be a nexthop or link label change
-       (change.linkAttributesChanged && nodeName == myNodeName_));
+  if (change.nodeLabelChanged ||
+      // we only need a full rebuild if link attributes change locally
+      // this would be a nexthop or link label change
+      (change.linkAttributesChanged && nodeName == myNodeName_)) {
+    setNeedsFullRebuild();
+  } else if (change.topologyChanged && not needsFullRebuild_) {
+    needsFullRebuild_ = true;
+    onlyTopologyChanged_ = true;
+  }
+  if (change.topologyChanged || change.linkAttributesChanged ||
+      change.nodeLabelChanged) {
+    ++generation_;
+  }
   addUpdate(perfEvents);
 }
 
 void
 DecisionPendingUpdates::applyPrefixStateChange(
-    std::unordered_set<thrift::IpPrefix>&& change,
+    std::unordered_set<folly::CIDRNetwork>&& change,
     std::optional<thrift::PerfEvents> const& perfEvents) {
+  if (not change.empty()) {
+    ++generation_;
+  }
   updatedPrefixes_.merge(std::move(change));
   addUpdate(perfEvents);
 }
 
+void
+DecisionPendingUpdates::applyStaticRoutesChange(
+    std::unordered_set<int32_t>&& labels) {
+  if (not labels.empty()) {
+    ++generation_;
+  }
+  updatedStaticLabels_.merge(std::move(labels));
+  addUpdate(std::nullopt);
+}
+
 void
 DecisionPendingUpdates::reset() {
   count_ = 0;
   perfEvents_ = std::nullopt;
   needsFullRebuild_ = false;
+  onlyTopologyChanged_ = false;
   updatedPrefixes_.clear();
+  updatedStaticLabels_.clear();
 }
 
 void
@@ -106,8 +144,325 @@ DecisionPendingUpdates::addUpdate(
     addPerfEvent(*perfEvents_, myNodeName_, "DECISION_RECEIVED");
   }
 }
+
+namespace {
+std::unordered_set<std::string>
+getOverloadedNodes(
+    LinkState const& linkState, LinkState::SpfResult const& spfResult) {
+  std::unordered_set<std::string> overloadedNodes;
+  for (auto const& [node, _] : spfResult) {
+    if (linkState.isNodeOverloaded(node)) {
+      overloadedNodes.insert(node);
+    }
+  }
+  return overloadedNodes;
+}
+
+std::map<std::pair<std::string, std::string>, LinkStateMetric>
+getLocalLinks(LinkState const& linkState, std::string const& myNodeName) {
+  std::map<std::pair<std::string, std::string>, LinkStateMetric> localLinks;
+  for (auto const& link : linkState.linksFromNode(myNodeName)) {
+    if (link->isUp()) {
+      localLinks.emplace(
+          std::make_pair(
+              link->getOtherNodeName(myNodeName),
+              link->getIfaceFromNode(myNodeName)),
+          link->getMetricFromNode(myNodeName));
+    }
+  }
+  return localLinks;
+}
+
+std::unordered_map<std::string, int32_t>
+getNodeLabels(LinkState const& linkState) {
+  std::unordered_map<std::string, int32_t> nodeLabels;
+  for (auto const& [node, adjDb] : linkState.getAdjacencyDatabases()) {
+    nodeLabels.emplace(node, *adjDb.nodeLabel_ref());
+  }
+  return nodeLabels;
+}
+
+std::unordered_set<thrift::NextHopThrift>
+getLocalNextHops(LinkState const& linkState, std::string const& myNodeName) {
+  std::unordered_set<thrift::NextHopThrift> localNextHops;
+  for (auto const& link : linkState.linksFromNode(myNodeName)) {
+    if (not link->isUp()) {
+      continue;
+    }
+    for (auto const& nhAddress :
+         {link->getNhV6FromNode(myNodeName),
+          link->getNhV4FromNode(myNodeName)}) {
+      localNextHops.emplace(createNextHop(
+          nhAddress,
+          link->getIfaceFromNode(myNodeName),
+          link->getMetricFromNode(myNodeName),
+          std::nullopt,
+          linkState.getArea(),
+          link->getOtherNodeName(myNodeName)));
+    }
+  }
+  return localNextHops;
+}
+
+thrift::LinkStateChange
+createLinkStateChange(
+    thrift::LinkStateChangeType type,
+    std::string const& area,
+    std::string const& nodeName) {
+  thrift::LinkStateChange change;
+  change.type_ref() = type;
+  change.area_ref() = area;
+  change.nodeName_ref() = nodeName;
+  return change;
+}
+
+// Adjacencies are compared without rtt and timestamp, which change without
+// affecting the topology
+bool
+isSameAdjacency(thrift::Adjacency lhs, thrift::Adjacency rhs) {
+  lhs.rtt_ref() = 0;
+  lhs.timestamp_ref() = 0;
+  rhs.rtt_ref() = 0;
+  rhs.timestamp_ref() = 0;
+  return lhs == rhs;
+}
+
+thrift::OpenrError
+createWhatIfError(
+    thrift::WhatIfScenario const& scenario, std::string const& error) {
+  return thrift::OpenrError(
+      folly::sformat("Scenario {}: {}", *scenario.name_ref(), error));
+}
+
+// Apply the changes of a what-if scenario to a fork of the topology. Link
+// changes are applied by updating the adjacency database of their node
+void
+applyWhatIfScenario(
+    thrift::WhatIfScenario const& scenario,
+    std::unordered_map<std::string, LinkState>& areaLinkStates) {
+  auto updateAdjacency = [&](thrift::WhatIfLink const& link, auto&& update) {
+    auto const& nodeName = *link.nodeName_ref();
+    auto it = areaLinkStates.find(*link.area_ref());
+    if (it == areaLinkStates.end() or not it->second.hasNode(nodeName)) {
+      throw createWhatIfError(
+          scenario,
+          folly::sformat(
+              "unknown node {} in area {}", nodeName, *link.area_ref()));
+    }
+    auto adjDb = it->second.getAdjacencyDatabases().at(nodeName);
+    auto& adjs = *adjDb.adjacencies_ref();
+    auto adjIt = std::find_if(adjs.begin(), adjs.end(), [&](auto const& adj) {
+      return *adj.ifName_ref() == *link.ifName_ref();
+    });
+    if (adjIt == adjs.end()) {
+      throw createWhatIfError(
+          scenario,
+          folly::sformat(
+              "unknown link {} of node {}", *link.ifName_ref(), nodeName));
+    }
+    update(adjs, adjIt);
+    it->second.updateAdjacencyDatabase(adjDb);
+  };
+
+  // nodes are changed in every area they are in
+  auto updateNode = [&](std::string const& nodeName, auto&& update) {
+    bool found{false};
+    for (auto& [_, linkState] : areaLinkStates) {
+      if (linkState.hasNode(nodeName)) {
+        found = true;
+        update(linkState);
+      }
+    }
+    if (not found) {
+      throw createWhatIfError(
+          scenario, folly::sformat("unknown node {}", nodeName));
+    }
+  };
+
+  for (auto const& link : *scenario.linkFailures_ref()) {
+    // links are bidirectional, dropping one adjacency takes the link down
+    updateAdjacency(link, [](auto& adjs, auto adjIt) { adjs.erase(adjIt); });
+  }
+  for (auto const& change : *scenario.metricChanges_ref()) {
+    updateAdjacency(*change.link_ref(), [&](auto&, auto adjIt) {
+      adjIt->metric_ref() = *change.metric_ref();
+    });
+  }
+  for (auto const& nodeName : *scenario.overloadedNodes_ref()) {
+    updateNode(nodeName, [&](LinkState& linkState) {
+      auto adjDb = linkState.getAdjacencyDatabases().at(nodeName);
+      adjDb.isOverloaded_ref() = true;
+      linkState.updateAdjacencyDatabase(adjDb);
+    });
+  }
+  // last, as other changes may refer to failed nodes
+  for (auto const& nodeName : *scenario.nodeFailures_ref()) {
+    updateNode(nodeName, [&](LinkState& linkState) {
+      linkState.deleteAdjacencyDatabase(nodeName);
+    });
+  }
+}
+} // namespace
+
+LinkStateSnapshot::LinkStateSnapshot(
+    LinkState const& linkState, std::string const& myNodeName)
+    : spfResult(linkState.getSpfResult(myNodeName)),
+      overloadedNodes(getOverloadedNodes(linkState, spfResult)),
+      localLinks(getLocalLinks(linkState, myNodeName)) {}
+
+std::optional<std::unordered_set<std::string>>
+LinkStateSnapshot::getChangedNodes(
+    LinkState const& linkState, std::string const& myNodeName) const {
+  if (getLocalLinks(linkState, myNodeName) != localLinks) {
+    return std::nullopt;
+  }
+
+  std::unordered_set<std::string> changedNodes;
+  auto const& newSpfResult = linkState.getSpfResult(myNodeName);
+  for (auto const& [node, result] : spfResult) {
+    auto it = newSpfResult.find(node);
+    if (it == newSpfResult.end() or it->second.metric() != result.metric() or
+        it->second.nextHops() != result.nextHops()) {
+      changedNodes.insert(node);
+    }
+  }
+  for (auto const& [node, _] : newSpfResult) {
+    if (not spfResult.count(node)) {
+      changedNodes.insert(node);
+    }
+  }
+
+  // overload bit of an announcer affects best route selection
+  auto const newOverloadedNodes = getOverloadedNodes(linkState, newSpfResult);
+  for (auto const& node : overloadedNodes) {
+    if (not newOverloadedNodes.count(node)) {
+      changedNodes.insert(node);
+    }
+  }
+  for (auto const& node : newOverloadedNodes) {
+    if (not overloadedNodes.count(node)) {
+      changedNodes.insert(node);
+    }
+  }
+  return changedNodes;
+}
+
+ChangedNodesTracker::Changes
+ChangedNodesTracker::update(
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    std::string const& myNodeName) {
+  Changes changes;
+  for (auto it = areas_.begin(); it != areas_.end();) {
+    if (areaLinkStates.count(it->first)) {
+      ++it;
+      continue;
+    }
+    it = areas_.erase(it);
+    changes.changed = changes.allNodes = true;
+  }
+
+  for (auto const& [area, linkState] : areaLinkStates) {
+    auto it = areas_.find(area);
+    if (it != areas_.end() and
+        it->second.generation == linkState.getGeneration()) {
+      continue;
+    }
+    changes.changed = true;
+    AreaInputs inputs{
+        linkState.getGeneration(),
+        LinkStateSnapshot(linkState, myNodeName),
+        getNodeLabels(linkState),
+        getLocalNextHops(linkState, myNodeName)};
+    if (it == areas_.end()) {
+      changes.allNodes = true;
+      areas_.emplace(area, std::move(inputs));
+      continue;
+    }
+
+    auto& prevInputs = it->second;
+    auto changedNodes =
+        prevInputs.snapshot.getChangedNodes(linkState, myNodeName);
+    if (not changedNodes or
+        inputs.localNextHops != prevInputs.localNextHops) {
+      changes.allNodes = true;
+    }
+    if (not changes.allNodes) {
+      changes.nodes.merge(*changedNodes);
+      auto const& prevLabels = prevInputs.nodeLabels;
+      for (auto const& [node, label] : inputs.nodeLabels) {
+        auto labelIt = prevLabels.find(node);
+        if (labelIt == prevLabels.end() or labelIt->second != label) {
+          changes.nodes.insert(node);
+        }
+      }
+      for (auto const& [node, _] : prevLabels) {
+        if (not inputs.nodeLabels.count(node)) {
+          changes.nodes.insert(node);
+        }
+      }
+    }
+    prevInputs = std::move(inputs);
+  }
+
+  // next-hops towards any node depend on the metric to the neighbors
+  for (auto const& [_, linkState] : areaLinkStates) {
+    for (auto const& link : linkState.linksFromNode(myNodeName)) {
+      auto const& neighbor = link->getOtherNodeName(myNodeName);
+      changes.allNodes |= changes.nodes.count(neighbor) > 0;
+    }
+  }
+  if (changes.allNodes) {
+    changes.nodes.clear();
+  }
+  return changes;
+}
 } // namespace detail
 
+namespace {
+int64_t
+getElapsedUs(std::chrono::steady_clock::time_point startTime) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - startTime)
+      .count();
+}
+
+// SPF work done so far in all areas
+LinkState::SpfStats
+getSpfStats(std::unordered_map<std::string, LinkState> const& areaLinkStates) {
+  LinkState::SpfStats stats;
+  for (auto const& [_, linkState] : areaLinkStates) {
+    auto const areaStats = linkState.getSpfStats();
+    stats.cacheHits += areaStats.cacheHits;
+    stats.cacheMisses += areaStats.cacheMisses;
+    stats.spfTime += areaStats.spfTime;
+  }
+  return stats;
+}
+
+// add SPF work done between two getSpfStats() to profile
+void
+addSpfStats(
+    thrift::RouteBuildProfile& profile,
+    LinkState::SpfStats const& statsBefore,
+    LinkState::SpfStats const& statsAfter) {
+  *profile.spfUs_ref() += (statsAfter.spfTime - statsBefore.spfTime).count();
+  *profile.spfCacheHits_ref() += statsAfter.cacheHits - statsBefore.cacheHits;
+  *profile.spfCacheMisses_ref() +=
+      statsAfter.cacheMisses - statsBefore.cacheMisses;
+}
+
+// set phases of a full route build to profile
+void
+setRouteBuildStats(
+    thrift::RouteBuildProfile& profile, RouteBuildStats const& stats) {
+  *profile.fullRebuild_ref() = true;
+  *profile.unicastRoutesUs_ref() = stats.unicastRoutesTime.count();
+  *profile.mplsRoutesUs_ref() = stats.mplsRoutesTime.count();
+  *profile.diffUs_ref() = stats.diffTime.count();
+  *profile.numPrefixes_ref() = stats.numPrefixes;
+}
+} // namespace
+
 DecisionRouteUpdate
 DecisionRouteDb::calculateUpdate(DecisionRouteDb&& newDb) const {
   DecisionRouteUpdate delta;
@@ -128,8 +483,16 @@ DecisionRouteDb::calculateUpdate(DecisionRouteDb&& newDb) const {
     }
   }
 
+  calculateMplsUpdate(newDb.mplsRoutes, delta);
+  return delta;
+}
+
+void
+DecisionRouteDb::calculateMplsUpdate(
+    std::unordered_map<int32_t, RibMplsEntry> const& newMplsRoutes,
+    DecisionRouteUpdate& delta) const {
   // mplsRoutesToUpdate
-  for (const auto& [label, entry] : newDb.mplsRoutes) {
+  for (const auto& [label, entry] : newMplsRoutes) {
     const auto& search = mplsRoutes.find(label);
     if (search == mplsRoutes.end() || search->second != entry) {
       delta.mplsRoutesToUpdate.emplace_back(entry);
@@ -138,11 +501,10 @@ DecisionRouteDb::calculateUpdate(DecisionRouteDb&& newDb) const {
 
   // mplsRoutesToDelete
   for (auto const& [label, _] : mplsRoutes) {
-    if (!newDb.mplsRoutes.count(label)) {
+    if (!newMplsRoutes.count(label)) {
       delta.mplsRoutesToDelete.emplace_back(label);
     }
   }
-  return delta;
 }
 
 void
@@ -172,15 +534,27 @@ class SpfSolver::SpfSolverImpl {
       bool computeLfaPaths,
       bool enableOrderedFib,
       bool bgpDryRun,
-      bool enableBestRouteSelection)
+      bool enableBestRouteSelection,
+      size_t routeBuildThreads)
       : myNodeName_(myNodeName),
         enableV4_(enableV4),
         computeLfaPaths_(computeLfaPaths),
         enableOrderedFib_(enableOrderedFib),
         bgpDryRun_(bgpDryRun),
         enableBestRouteSelection_(enableBestRouteSelection) {
+    if (routeBuildThreads > 1) {
+      routeBuildExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+          routeBuildThreads,
+          std::make_shared<folly::NamedThreadFactory>("RouteBuild"));
+    }
     // Initialize stat keys
     fb303::fbData->addStatExportType("decision.adj_db_update", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.adj_db_delta_update", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.adj_db_delta_without_base", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.skipped_unchanged_decode", fb303::COUNT);
     fb303::fbData->addStatExportType(
         "decision.incompatible_forwarding_type", fb303::COUNT);
     fb303::fbData->addStatExportType(
@@ -191,16 +565,41 @@ class SpfSolver::SpfSolverImpl {
     fb303::fbData->addStatExportType("decision.prefix_db_update", fb303::COUNT);
     fb303::fbData->addStatExportType("decision.route_build_ms", fb303::AVG);
     fb303::fbData->addStatExportType("decision.route_build_runs", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.route_build_shards", fb303::AVG);
+    fb303::fbData->addStatExportType(
+        "decision.nexthops_cache_hits", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.nexthops_cache_misses", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.best_route_selection_cache_hits", fb303::COUNT);
     fb303::fbData->addStatExportType(
         "decision.get_route_for_prefix", fb303::COUNT);
     fb303::fbData->addStatExportType(
         "decision.skipped_mpls_route", fb303::COUNT);
     fb303::fbData->addStatExportType(
         "decision.duplicate_node_label", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.node_label_routes_built", fb303::COUNT);
     fb303::fbData->addStatExportType(
         "decision.skipped_unicast_route", fb303::COUNT);
     fb303::fbData->addStatExportType("decision.spf_ms", fb303::AVG);
     fb303::fbData->addStatExportType("decision.spf_runs", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.kth_paths_cache_hits", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.kth_paths_cache_misses", fb303::COUNT);
+    fb303::fbData->addStatExportType("decision.kth_paths_us", fb303::AVG);
+    fb303::fbData->addStatExportType(
+        "decision.memoized_results_evictions", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.incremental_spf_runs", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.incremental_spf_fallbacks", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.topology_impact_rebuilds", fb303::COUNT);
+    fb303::fbData->addStatExportType(
+        "decision.topology_impact_fallbacks", fb303::COUNT);
     fb303::fbData->addStatExportType("decision.errors", fb303::COUNT);
   }
 
@@ -210,7 +609,8 @@ class SpfSolver::SpfSolverImpl {
   // mpls static route
   //
 
-  void updateStaticRoutes(thrift::RouteDatabaseDelta&& staticRoutesDelta);
+  std::unordered_set<int32_t> updateStaticRoutes(
+      thrift::RouteDatabaseDelta&& staticRoutesDelta);
 
   StaticMplsRoutes const& getStaticRoutes();
 
@@ -226,17 +626,78 @@ class SpfSolver::SpfSolverImpl {
       std::unordered_map<std::string, LinkState> const& areaLinkStates,
       PrefixState const& prefixState);
 
+  // Build only the MPLS routes (node, adjacency and static labels) of
+  // buildRouteDb(). Those of myNodeName_ are kept in mplsRoutesCache_
+  DecisionRouteDb buildMplsRouteDb(
+      const std::string& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates);
+
+  // Same as buildRouteDb() but directly returns the changes against routeDb,
+  // routes equal to the ones in routeDb are dropped as they get built
+  // Returns std::nullopt if myNodeName doesn't have any prefix database
+  std::optional<DecisionRouteUpdate> buildRouteDbDelta(
+      const std::string& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState,
+      DecisionRouteDb const& routeDb);
+
+  // Best route selection of the prefix is reused from prevBestRoutesCache if
+  // given, else from bestRoutesCache_, if its inputs didn't change
   std::optional<RibUnicastEntry> createRouteForPrefix(
       const std::string& myNodeName,
       std::unordered_map<std::string, LinkState> const& areaLinkStates,
       PrefixState const& prefixState,
-      thrift::IpPrefix const& prefix);
+      folly::CIDRNetwork const& prefix,
+      std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult> const*
+          prevBestRoutesCache = nullptr) {
+    // next-hops are only cached for routes of this node
+    NextHopsCache* nextHopsCache{nullptr};
+    if (myNodeName == myNodeName_) {
+      maybeInvalidateNextHopsCache(areaLinkStates);
+      nextHopsCache = &nextHopsCache_;
+    }
+    return createRouteForPrefix(
+        myNodeName,
+        areaLinkStates,
+        prefixState,
+        prefix,
+        bestRoutesCache_,
+        prevBestRoutesCache,
+        nextHopsCache);
+  }
 
-  std::unordered_map<thrift::IpPrefix, BestRouteSelectionResult> const&
+  std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult> const&
   getBestRoutesCache() const {
     return bestRoutesCache_;
   }
 
+  void
+  setBestRoutesCache(
+      std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult>&&
+          bestRoutesCache) {
+    bestRoutesCache_ = std::move(bestRoutesCache);
+  }
+
+  void
+  setPreemptionCheck(std::function<bool()> isPreempted) {
+    isPreempted_ = std::move(isPreempted);
+  }
+
+  void
+  setComputeLfaBackups(bool computeLfaBackups) {
+    computeLfaBackups_ = computeLfaBackups;
+  }
+
+  void
+  setComputeUcmp(bool computeUcmp) {
+    computeUcmp_ = computeUcmp;
+  }
+
+  RouteBuildStats const&
+  getLastRouteBuildStats() const {
+    return lastRouteBuildStats_;
+  }
+
   // helpers used in best path calculation
   static std::pair<Metric, std::unordered_set<std::string>> getMinCostNodes(
       const SpfResult& spfResult, const std::set<NodeAndArea>& dstNodeAreas);
@@ -249,21 +710,143 @@ class SpfSolver::SpfSolverImpl {
   SpfSolverImpl(SpfSolverImpl const&) = delete;
   SpfSolverImpl& operator=(SpfSolverImpl const&) = delete;
 
+  // SP_ECMP next-hops only depend on the topology and on the set of best
+  // announcing node-areas, which many prefixes share, e.g. routes
+  // redistributed from BGP. Key on the latter plus address family and
+  // forwarding type, std::nullopt records that there is no route. SR_MPLS
+  // next-hops also depend on prepend labels of the prefix, they are only
+  // cached if there are none. Cached next-hops are interned groups, routes
+  // created from them share the group
+  using NextHopsCacheKey = std::tuple<
+      std::set<NodeAndArea>,
+      bool /* isV4 */,
+      thrift::PrefixForwardingType>;
+  using NextHopsCache = std::map<
+      NextHopsCacheKey,
+      std::optional<std::pair<
+          NextHopSet /* next-hops */,
+          NextHopSet /* LFA backups */>>>;
+
+  // Drops entries of nextHopsCache_ towards nodes whose routes may have
+  // changed since it was last brought up to date with areaLinkStates
+  void maybeInvalidateNextHopsCache(
+      std::unordered_map<std::string, LinkState> const& areaLinkStates);
+
+  // Node and adjacency label routes of this node, kept across route builds.
+  // Node label routes are only built again for nodes whose shortest paths
+  // from this node, overload bit or node label changed, for all nodes if any
+  // local link changed, since they may then all be affected
+  struct MplsRoutesCache {
+    // LinkStates the routes are built from
+    detail::ChangedNodesTracker tracker;
+    // route of the node label of each node, duplicate labels not resolved
+    std::map<NodeAndArea, RibMplsEntry> nodeLabelRoutes;
+    std::vector<RibMplsEntry> adjLabelRoutes;
+  };
+
+  // Bring mplsRoutesCache_ up to date with areaLinkStates, nothing is
+  // rebuilt if none of them changed since
+  void updateMplsRoutesCache(
+      std::unordered_map<std::string, LinkState> const& areaLinkStates);
+
+  // Route of the node label of dstNodeArea, std::nullopt if it has no valid
+  // label or isn't reachable
+  std::optional<RibMplsEntry> createNodeLabelRoute(
+      const std::string& myNodeName,
+      NodeAndArea const& dstNodeArea,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates);
+
+  // Routes of the adjacency labels of myNodeName
+  std::vector<RibMplsEntry> createAdjLabelRoutes(
+      const std::string& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates) const;
+
+  // Add nodeLabelRoutes to routeDb. There can be a temporary collision in
+  // node label allocation. Usually happens when two segmented networks
+  // allocating labels from the same range join together. In case of such
+  // conflict we respect the node label of the smaller node name
+  static void addNodeLabelRoutes(
+      std::map<NodeAndArea, RibMplsEntry> const& nodeLabelRoutes,
+      DecisionRouteDb& routeDb);
+
+  // Creates the route for prefix and records its best route selection in
+  // bestRoutesCache. The previous selection, taken from prevBestRoutesCache
+  // if given else from bestRoutesCache, is reused if its inputs are
+  // unchanged. Next-hops are looked up in and added to nextHopsCache if one
+  // is given. Doesn't touch any other member. Given every SPF result it needs
+  // is already memoized, it is safe to call concurrently for SP_ECMP prefixes
+  // with distinct bestRoutesCache and nextHopsCache maps
+  std::optional<RibUnicastEntry> createRouteForPrefix(
+      const std::string& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState,
+      folly::CIDRNetwork const& prefix,
+      std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult>&
+          bestRoutesCache,
+      std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult> const*
+          prevBestRoutesCache,
+      NextHopsCache* nextHopsCache);
+
+  // Hash of everything selectBestRoutes() depends on for the reachable
+  // prefixEntries: the announcing node-areas, their metrics used for the
+  // selection, whether they are overloaded and the node routes are built for
+  size_t hashBestRouteSelectionInputs(
+      std::string const& myNodeName,
+      PrefixEntries const& prefixEntries,
+      bool const isBgp,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates) const;
+
+  // Unicast routes of a route build. When built against a previous route db,
+  // routes equal to the previous ones are left out
+  struct UnicastRoutes {
+    std::vector<RibUnicastEntry> routes;
+    // number of built routes whose prefix has a route in the previous db
+    size_t numPrevRoutes{0};
+    // prefixes without route, only tracked against a previous route db
+    std::unordered_set<folly::CIDRNetwork> noRoutePrefixes;
+  };
+
+  static void addUnicastRoute(
+      UnicastRoutes& unicastRoutes,
+      folly::CIDRNetwork const& prefix,
+      std::optional<RibUnicastEntry>&& maybeRoute,
+      DecisionRouteDb const* prevRouteDb);
+
+  // Create unicast routes for all prefixes, diffing them against prevRouteDb
+  // if given. Returns std::nullopt if myNodeName isn't in any area
+  std::optional<UnicastRoutes> buildUnicastRoutes(
+      const std::string& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState,
+      DecisionRouteDb const* prevRouteDb);
+
+  // Create unicast routes for all prefixes, sharding SP_ECMP prefixes across
+  // routeBuildExecutor_
+  void buildUnicastRoutesParallel(
+      const std::string& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState,
+      DecisionRouteDb const* prevRouteDb,
+      std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult> const&
+          prevBestRoutesCache,
+      UnicastRoutes& unicastRoutes);
+
   // Given prefixes and the nodes who announce it, get the ecmp routes.
   std::optional<RibUnicastEntry> selectBestPathsSpf(
       std::string const& myNodeName,
-      thrift::IpPrefix const& prefix,
+      folly::CIDRNetwork const& prefix,
       BestRouteSelectionResult const& bestRouteSelectionResult,
       PrefixEntries const& prefixEntries,
       bool const isBgp,
       thrift::PrefixForwardingType const& forwardingType,
       std::unordered_map<std::string, LinkState> const& areaLinkStates,
-      PrefixState const& prefixState);
+      PrefixState const& prefixState,
+      NextHopsCache* nextHopsCache);
 
   // Given prefixes and the nodes who announce it, get the kspf routes.
   std::optional<RibUnicastEntry> selectBestPathsKsp2(
       const string& myNodeName,
-      const thrift::IpPrefix& prefix,
+      const folly::CIDRNetwork& prefix,
       BestRouteSelectionResult const& bestRouteSelectionResult,
       PrefixEntries const& prefixEntries,
       bool isBgp,
@@ -273,17 +856,18 @@ class SpfSolver::SpfSolverImpl {
 
   std::optional<RibUnicastEntry> addBestPaths(
       const string& myNodeName,
-      const thrift::IpPrefix& prefixThrift,
+      const folly::CIDRNetwork& prefix,
       const BestRouteSelectionResult& bestRouteSelectionResult,
       const PrefixEntries& prefixEntries,
       const PrefixState& prefixState,
       const bool isBgp,
-      std::unordered_set<thrift::NextHopThrift>&& nextHops);
+      NextHopSet nextHops,
+      NextHopSet backupNextHops = {});
 
   // helper function to find the nodes for the nexthop for bgp route
   BestRouteSelectionResult runBestPathSelectionBgp(
       std::string const& myNodeName,
-      thrift::IpPrefix const& prefix,
+      folly::CIDRNetwork const& prefix,
       PrefixEntries const& prefixEntries,
       std::unordered_map<std::string, LinkState> const& areaLinkStates);
 
@@ -292,7 +876,7 @@ class SpfSolver::SpfSolverImpl {
    */
   BestRouteSelectionResult selectBestRoutes(
       std::string const& myNodeName,
-      thrift::IpPrefix const& prefix,
+      folly::CIDRNetwork const& prefix,
       PrefixEntries const& prefixEntries,
       bool const hasBgp,
       std::unordered_map<std::string, LinkState> const& areaLinkStates);
@@ -310,7 +894,7 @@ class SpfSolver::SpfSolverImpl {
       std::unordered_map<std::string, LinkState> const& areaLinkStates) const;
 
   // Give source node-name and dstNodeNames, this function returns the set of
-  // nexthops (along with LFA if enabled) towards these set of dstNodeNames
+  // nexthops (along with LFA if withLfa) towards these set of dstNodeNames
   std::pair<
       Metric /* minimum metric to destination */,
       std::unordered_map<
@@ -320,7 +904,8 @@ class SpfSolver::SpfSolverImpl {
       const std::string& srcNodeName,
       const std::set<NodeAndArea>& dstNodeAreas,
       bool perDestination,
-      std::unordered_map<std::string, LinkState> const& areaLinkStates);
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      bool withLfa);
 
   // This function converts best nexthop nodes to best nexthop adjacencies
   // which can then be passed to FIB for programming. It considers LFA and
@@ -336,17 +921,50 @@ class SpfSolver::SpfSolverImpl {
       std::unordered_map<std::pair<std::string, std::string>, Metric>
           nextHopNodes,
       std::optional<int32_t> swapLabel,
+      bool withLfa,
       std::unordered_map<std::string, LinkState> const& areaLinkStates,
       PrefixEntries const& prefixEntries = {}) const;
 
+  // Loop-free alternates per RFC 5286 towards dstNodeAreas, leaving out
+  // next-hops over an interface of any of nextHops, to be switched to once
+  // all of nextHops are down
+  std::unordered_set<thrift::NextHopThrift> getLfaBackupNextHops(
+      const std::string& myNodeName,
+      const std::set<NodeAndArea>& dstNodeAreas,
+      bool isV4,
+      std::unordered_set<thrift::NextHopThrift> const& nextHops,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixEntries const& prefixEntries);
+
+  // Weigh shortest path nextHops towards dstNodeAreas by capacity (UCMP).
+  // Capacity of a node towards the destinations is the sum over its links on
+  // shortest paths of the link weight, capped by capacity of the node at the
+  // other end, computed once per node walking the SPF DAG back from the
+  // destinations. Weights are reduced by their greatest common divisor,
+  // nextHops are returned as is if they all end up equal
+  std::unordered_set<thrift::NextHopThrift> applyUcmpWeights(
+      const std::string& myNodeName,
+      const std::set<NodeAndArea>& dstNodeAreas,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      std::unordered_set<thrift::NextHopThrift> nextHops) const;
+
   StaticMplsRoutes staticMplsRoutes_;
 
   // Cache of best route selection.
-  // - Cleared when topology changes
+  // - Rebuilt on every full route build, reusing selections whose inputs
+  //   didn't change, see hashBestRouteSelectionInputs()
   // - Updated for the prefix whenever a route is created for it
-  std::unordered_map<thrift::IpPrefix, BestRouteSelectionResult>
+  std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult>
       bestRoutesCache_;
 
+  // Cache of IP forwarded next-hops, see NextHopsCache, and the LinkStates
+  // it is valid for
+  NextHopsCache nextHopsCache_;
+  detail::ChangedNodesTracker nextHopsCacheTracker_;
+
+  // MPLS routes of myNodeName_, see MplsRoutesCache
+  MplsRoutesCache mplsRoutesCache_;
+
   const std::string myNodeName_;
 
   // is v4 enabled. If yes then Decision will forward v4 prefixes with v4
@@ -355,42 +973,68 @@ class SpfSolver::SpfSolverImpl {
 
   const bool computeLfaPaths_{false};
 
+  // see SpfSolver::setComputeLfaBackups()
+  bool computeLfaBackups_{false};
+
+  // see SpfSolver::setComputeUcmp()
+  bool computeUcmp_{false};
+
   const bool enableOrderedFib_{false};
 
   const bool bgpDryRun_{false};
 
   const bool enableBestRouteSelection_{false};
+
+  // Workers for building unicast routes, only set if more than one route
+  // build thread is configured
+  std::unique_ptr<folly::CPUThreadPoolExecutor> routeBuildExecutor_;
+
+  // see SpfSolver::setPreemptionCheck()
+  std::function<bool()> isPreempted_;
+
+  bool
+  isPreempted() const {
+    return isPreempted_ and isPreempted_();
+  }
+
+  // see SpfSolver::getLastRouteBuildStats()
+  RouteBuildStats lastRouteBuildStats_;
 };
 
-void
+std::unordered_set<int32_t>
 SpfSolver::SpfSolverImpl::updateStaticRoutes(
     thrift::RouteDatabaseDelta&& staticRoutesDelta) {
   // We don't support static routes for IP routes yet
   CHECK(staticRoutesDelta.unicastRoutesToUpdate_ref()->empty());
   CHECK(staticRoutesDelta.unicastRoutesToDelete_ref()->empty());
 
+  std::unordered_set<int32_t> changedLabels;
   // Process MPLS routes to add or update
   LOG(INFO) << "Adding/Updating static "
             << staticRoutesDelta.mplsRoutesToUpdate_ref()->size()
             << " mpls routes";
   for (auto& mplsRoute : *staticRoutesDelta.mplsRoutesToUpdate_ref()) {
     const auto topLabel = *mplsRoute.topLabel_ref();
-    staticMplsRoutes_.insert_or_assign(
-        topLabel, std::move(*mplsRoute.nextHops_ref()));
-
     VLOG(1) << "> " << std::to_string(topLabel)
             << ", NextHopsCount = " << mplsRoute.nextHops_ref()->size();
     for (auto const& nh : *mplsRoute.nextHops_ref()) {
       VLOG(2) << " via " << toString(nh);
     }
+
+    staticMplsRoutes_.insert_or_assign(
+        topLabel, std::move(*mplsRoute.nextHops_ref()));
+    changedLabels.emplace(topLabel);
   }
 
   LOG(INFO) << "Deleting " << staticRoutesDelta.mplsRoutesToDelete_ref()->size()
             << " static mpls routes";
   for (const auto& topLabel : *staticRoutesDelta.mplsRoutesToDelete_ref()) {
-    staticMplsRoutes_.erase(topLabel);
+    if (staticMplsRoutes_.erase(topLabel)) {
+      changedLabels.emplace(topLabel);
+    }
     VLOG(1) << "> " << std::to_string(topLabel);
   }
+  return changedLabels;
 }
 
 StaticMplsRoutes const&
@@ -403,49 +1047,59 @@ SpfSolver::SpfSolverImpl::createRouteForPrefix(
     const std::string& myNodeName,
     std::unordered_map<std::string, LinkState> const& areaLinkStates,
     PrefixState const& prefixState,
-    thrift::IpPrefix const& prefix) {
+    folly::CIDRNetwork const& prefix,
+    std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult>&
+        bestRoutesCache,
+    std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult> const*
+        prevBestRoutesCache,
+    NextHopsCache* nextHopsCache) {
   fb303::fbData->addStatValue("decision.get_route_for_prefix", 1, fb303::COUNT);
 
+  // Clear best route selection in prefix state, keeping the previous one
+  // around for reuse
+  auto prevSelectionNode = bestRoutesCache.extract(prefix);
+  BestRouteSelectionResult const* prevSelection{nullptr};
+  if (prevBestRoutesCache) {
+    auto it = prevBestRoutesCache->find(prefix);
+    if (it != prevBestRoutesCache->end()) {
+      prevSelection = &it->second;
+    }
+  } else if (prevSelectionNode) {
+    prevSelection = &prevSelectionNode.mapped();
+  }
+
   auto search = prefixState.prefixes().find(prefix);
   if (search == prefixState.prefixes().end()) {
     return std::nullopt;
   }
   auto const& allPrefixEntries = search->second;
 
-  // Clear best route selection in prefix state
-  bestRoutesCache_.erase(prefix);
-
   //
-  // Create list of prefix-entries from reachable nodes only
+  // Create list of prefix-entries from reachable nodes only, looking each up
+  // in the SPF result of its own area. Entries of unknown areas are kept
   // NOTE: We're copying prefix-entries and it can be expensive. Using
   // pointers for storing prefix information can be efficient (CPU & Memory)
   //
-  auto prefixEntries = folly::copy(allPrefixEntries);
-  for (auto& [area, linkState] : areaLinkStates) {
-    auto const& mySpfResult = linkState.getSpfResult(myNodeName);
-
-    // Delete entries of unreachable nodes from prefixEntries
-    for (auto it = prefixEntries.begin(); it != prefixEntries.end();) {
-      const auto& [prefixNode, prefixArea] = it->first;
-      if (area != prefixArea || mySpfResult.count(prefixNode)) {
-        ++it; // retain
-      } else {
-        it = prefixEntries.erase(it); // erase the unreachable prefix entry
-      }
+  PrefixEntries prefixEntries;
+  for (auto const& [nodeArea, prefixEntry] : allPrefixEntries) {
+    const auto& [prefixNode, prefixArea] = nodeArea;
+    auto linkStateIt = areaLinkStates.find(prefixArea);
+    if (linkStateIt == areaLinkStates.end() or
+        linkStateIt->second.getSpfResult(myNodeName).count(prefixNode)) {
+      prefixEntries.emplace(nodeArea, prefixEntry);
     }
   }
 
   // Skip if no valid prefixes
   if (prefixEntries.empty()) {
-    VLOG(2) << "Skipping route to " << toString(prefix)
+    VLOG(2) << "Skipping route to " << folly::IPAddress::networkToString(prefix)
             << " with no reachable node.";
     fb303::fbData->addStatValue("decision.no_route_to_prefix", 1, fb303::COUNT);
     return std::nullopt;
   }
 
   // Sanity check for V4 prefixes
-  const bool isV4Prefix = prefix.prefixAddress_ref()->addr_ref()->size() ==
-      folly::IPAddressV4::byteCount();
+  const bool isV4Prefix = prefix.first.isV4();
   if (isV4Prefix && !enableV4_) {
     LOG(WARNING) << "Received v4 prefix while v4 is not enabled.";
     fb303::fbData->addStatValue(
@@ -470,7 +1124,8 @@ SpfSolver::SpfSolverImpl::createRouteForPrefix(
     }
     if (isBGP and not prefixEntry.mv_ref().has_value()) {
       missingMv = true;
-      LOG(ERROR) << "Prefix entry for prefix " << toString(prefix)
+      LOG(ERROR) << "Prefix entry for prefix "
+                 << folly::IPAddress::networkToString(prefix)
                  << " advertised by " << nodeAndArea.first << ", area "
                  << nodeAndArea.second
                  << " is of type BGP and missing the metric vector.";
@@ -482,14 +1137,16 @@ SpfSolver::SpfSolverImpl::createRouteForPrefix(
   // skip adding route for BGP prefixes that have issues
   if (hasBGP) {
     if (hasNonBGP and not enableBestRouteSelection_) {
-      LOG(ERROR) << "Skipping route for " << toString(prefix)
+      LOG(ERROR) << "Skipping route for "
+                 << folly::IPAddress::networkToString(prefix)
                  << " which is advertised with BGP and non-BGP type.";
       fb303::fbData->addStatValue(
           "decision.skipped_unicast_route", 1, fb303::COUNT);
       return std::nullopt;
     }
     if (missingMv) {
-      LOG(ERROR) << "Skipping route for " << toString(prefix)
+      LOG(ERROR) << "Skipping route for "
+                 << folly::IPAddress::networkToString(prefix)
                  << " at least one advertiser is missing its metric vector.";
       fb303::fbData->addStatValue(
           "decision.skipped_unicast_route", 1, fb303::COUNT);
@@ -497,20 +1154,32 @@ SpfSolver::SpfSolverImpl::createRouteForPrefix(
     }
   }
 
-  // Perform best route selection from received route announcements
-  const auto& bestRouteSelectionResult = selectBestRoutes(
-      myNodeName, prefix, prefixEntries, hasBGP, areaLinkStates);
+  // Perform best route selection from received route announcements, unless
+  // the previous selection was made from the same inputs
+  auto const inputsHash = hashBestRouteSelectionInputs(
+      myNodeName, prefixEntries, hasBGP, areaLinkStates);
+  BestRouteSelectionResult bestRouteSelectionResult;
+  if (prevSelection and prevSelection->inputsHash == inputsHash) {
+    fb303::fbData->addStatValue(
+        "decision.best_route_selection_cache_hits", 1, fb303::COUNT);
+    bestRouteSelectionResult = *prevSelection;
+  } else {
+    bestRouteSelectionResult = selectBestRoutes(
+        myNodeName, prefix, prefixEntries, hasBGP, areaLinkStates);
+    bestRouteSelectionResult.inputsHash = inputsHash;
+  }
   if (not bestRouteSelectionResult.success) {
     return std::nullopt;
   }
   if (bestRouteSelectionResult.allNodeAreas.empty()) {
-    LOG(WARNING) << "No route to BGP prefix " << toString(prefix);
+    LOG(WARNING) << "No route to BGP prefix "
+                 << folly::IPAddress::networkToString(prefix);
     fb303::fbData->addStatValue("decision.no_route_to_prefix", 1, fb303::COUNT);
     return std::nullopt;
   }
 
   // Set best route selection in prefix state
-  bestRoutesCache_.insert_or_assign(prefix, bestRouteSelectionResult);
+  bestRoutesCache.insert_or_assign(prefix, bestRouteSelectionResult);
 
   // Skip adding route for prefixes advertised by this node. The originated
   // routes are already programmed on the system e.g. re-distributed from
@@ -545,7 +1214,8 @@ SpfSolver::SpfSolverImpl::createRouteForPrefix(
         hasBGP,
         forwardingType,
         areaLinkStates,
-        prefixState);
+        prefixState,
+        nextHopsCache);
   case thrift::PrefixForwardingAlgorithm::KSP2_ED_ECMP:
     return selectBestPathsKsp2(
         myNodeName,
@@ -559,17 +1229,71 @@ SpfSolver::SpfSolverImpl::createRouteForPrefix(
   default:
     LOG(ERROR) << "Unknown prefix algorithm type "
                << apache::thrift::util::enumNameSafe(forwardingAlgo)
-               << " for prefix " << toString(prefix);
+               << " for prefix " << folly::IPAddress::networkToString(prefix);
 
     return std::nullopt;
   }
 }
 
-std::optional<DecisionRouteDb>
-SpfSolver::SpfSolverImpl::buildRouteDb(
+void
+SpfSolver::SpfSolverImpl::maybeInvalidateNextHopsCache(
+    std::unordered_map<std::string, LinkState> const& areaLinkStates) {
+  auto const changes =
+      nextHopsCacheTracker_.update(areaLinkStates, myNodeName_);
+  if (not changes.changed) {
+    return;
+  }
+  // LFA and UCMP next-hops depend on more than shortest paths of this node
+  if (changes.allNodes or computeLfaPaths_ or computeLfaBackups_ or
+      computeUcmp_) {
+    nextHopsCache_.clear();
+    return;
+  }
+  // next-hops towards a node depend on its shortest paths in every area
+  for (auto it = nextHopsCache_.begin(); it != nextHopsCache_.end();) {
+    auto const& dstNodeAreas = std::get<0>(it->first);
+    const bool affected = std::any_of(
+        dstNodeAreas.begin(),
+        dstNodeAreas.end(),
+        [&changes](NodeAndArea const& nodeArea) {
+          return changes.nodes.count(nodeArea.first) > 0;
+        });
+    it = affected ? nextHopsCache_.erase(it) : std::next(it);
+  }
+}
+
+void
+SpfSolver::SpfSolverImpl::addUnicastRoute(
+    UnicastRoutes& unicastRoutes,
+    folly::CIDRNetwork const& prefix,
+    std::optional<RibUnicastEntry>&& maybeRoute,
+    DecisionRouteDb const* prevRouteDb) {
+  if (not maybeRoute) {
+    if (prevRouteDb) {
+      unicastRoutes.noRoutePrefixes.emplace(prefix);
+    }
+    return;
+  }
+  if (prevRouteDb) {
+    auto it = prevRouteDb->unicastRoutes.find(maybeRoute->prefix);
+    if (it != prevRouteDb->unicastRoutes.end()) {
+      ++unicastRoutes.numPrevRoutes;
+      // cheap for the common case, next-hops compare by interned group
+      if (it->second == *maybeRoute) {
+        return;
+      }
+    }
+  }
+  unicastRoutes.routes.emplace_back(std::move(maybeRoute).value());
+}
+
+std::optional<SpfSolver::SpfSolverImpl::UnicastRoutes>
+SpfSolver::SpfSolverImpl::buildUnicastRoutes(
     const std::string& myNodeName,
     std::unordered_map<std::string, LinkState> const& areaLinkStates,
-    PrefixState const& prefixState) {
+    PrefixState const& prefixState,
+    DecisionRouteDb const* prevRouteDb) {
+  lastRouteBuildStats_ = RouteBuildStats{};
   bool nodeExist{false};
   for (const auto& [_, linkState] : areaLinkStates) {
     nodeExist |= linkState.hasNode(myNodeName);
@@ -578,116 +1302,287 @@ SpfSolver::SpfSolverImpl::buildRouteDb(
     return std::nullopt;
   }
 
-  const auto startTime = std::chrono::steady_clock::now();
   fb303::fbData->addStatValue("decision.route_build_runs", 1, fb303::COUNT);
+  const auto startTime = std::chrono::steady_clock::now();
+  lastRouteBuildStats_.numPrefixes = prefixState.prefixes().size();
 
-  DecisionRouteDb routeDb{};
+  // Start over with the best route selection cache, selections of the
+  // previous build are reused where their inputs are unchanged
+  auto const prevBestRoutesCache = std::exchange(bestRoutesCache_, {});
 
-  // Clear best route selection cache
-  bestRoutesCache_.clear();
+  // Drop next-hops of announcer sets that may be gone, the rebuild will fill
+  // in the ones still in use
+  if (myNodeName == myNodeName_) {
+    nextHopsCache_.clear();
+  }
 
   // Create IPv4, IPv6 routes (includes IP -> MPLS routes)
-  for (const auto& [prefix, _] : prefixState.prefixes()) {
-    if (auto maybeRoute = createRouteForPrefix(
-            myNodeName, areaLinkStates, prefixState, prefix)) {
-      routeDb.addUnicastRoute(std::move(maybeRoute).value());
-    }
-  } // for prefixState.prefixes()
-
-  //
-  // Create MPLS routes for all nodeLabel
-  //
-  std::unordered_map<int32_t, std::pair<std::string, RibMplsEntry>> labelToNode;
-  for (const auto& [area, linkState] : areaLinkStates) {
-    for (const auto& [_, adjDb] : linkState.getAdjacencyDatabases()) {
-      const auto topLabel = *adjDb.nodeLabel_ref();
-      // Top label is not set => Non-SR mode
-      if (topLabel == 0) {
-        continue;
-      }
-      // If mpls label is not valid then ignore it
-      if (not isMplsLabelValid(topLabel)) {
-        LOG(ERROR) << "Ignoring invalid node label " << topLabel << " of node "
-                   << *adjDb.thisNodeName_ref();
-        fb303::fbData->addStatValue(
-            "decision.skipped_mpls_route", 1, fb303::COUNT);
-        continue;
+  UnicastRoutes unicastRoutes;
+  if (routeBuildExecutor_) {
+    buildUnicastRoutesParallel(
+        myNodeName,
+        areaLinkStates,
+        prefixState,
+        prevRouteDb,
+        prevBestRoutesCache,
+        unicastRoutes);
+  } else {
+    for (const auto& [prefix, _] : prefixState.prefixes()) {
+      if (isPreempted()) {
+        break;
       }
+      addUnicastRoute(
+          unicastRoutes,
+          prefix,
+          createRouteForPrefix(
+              myNodeName,
+              areaLinkStates,
+              prefixState,
+              prefix,
+              &prevBestRoutesCache),
+          prevRouteDb);
+    } // for prefixState.prefixes()
+  }
+  lastRouteBuildStats_.unicastRoutesTime =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - startTime);
+  return unicastRoutes;
+}
 
-      // There can be a temporary collision in node label allocation. Usually
-      // happens when two segmented networks allocating labels from the same
-      // range join together. In case of such conflict we respect the node label
-      // of bigger node-ID
-      auto iter = labelToNode.find(topLabel);
-      if (iter != labelToNode.end()) {
-        LOG(INFO) << "Find duplicate label " << topLabel << "from "
-                  << iter->second.first << " " << *adjDb.thisNodeName_ref();
-        fb303::fbData->addStatValue(
-            "decision.duplicate_node_label", 1, fb303::COUNT);
-        if (iter->second.first < *adjDb.thisNodeName_ref()) {
-          continue;
-        }
-      }
+std::optional<DecisionRouteDb>
+SpfSolver::SpfSolverImpl::buildRouteDb(
+    const std::string& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    PrefixState const& prefixState) {
+  const auto startTime = std::chrono::steady_clock::now();
+  auto unicastRoutes = buildUnicastRoutes(
+      myNodeName, areaLinkStates, prefixState, nullptr /* prevRouteDb */);
+  if (not unicastRoutes) {
+    return std::nullopt;
+  }
 
-      // Install POP_AND_LOOKUP for next layer
-      if (*adjDb.thisNodeName_ref() == myNodeName) {
-        thrift::NextHopThrift nh;
-        *nh.address_ref() = toBinaryAddress(folly::IPAddressV6("::"));
-        nh.area_ref() = area;
-        nh.mplsAction_ref() =
-            createMplsAction(thrift::MplsActionCode::POP_AND_LOOKUP);
-        labelToNode.erase(topLabel);
-        labelToNode.emplace(
-            topLabel,
-            std::make_pair(
-                *adjDb.thisNodeName_ref(), RibMplsEntry(topLabel, {nh})));
-        continue;
-      }
+  DecisionRouteDb routeDb{};
+  for (auto& route : unicastRoutes->routes) {
+    routeDb.addUnicastRoute(std::move(route));
+  }
 
-      // Get best nexthop towards the node
-      auto metricNhs = getNextHopsWithMetric(
-          myNodeName,
-          {{adjDb.thisNodeName_ref().value(), area}},
-          false,
-          areaLinkStates);
-      if (metricNhs.second.empty()) {
-        LOG(WARNING) << "No route to nodeLabel " << std::to_string(topLabel)
-                     << " of node " << *adjDb.thisNodeName_ref();
-        fb303::fbData->addStatValue(
-            "decision.no_route_to_label", 1, fb303::COUNT);
+  // Create MPLS routes (node, adjacency and static labels)
+  const auto mplsStartTime = std::chrono::steady_clock::now();
+  routeDb.mplsRoutes = buildMplsRouteDb(myNodeName, areaLinkStates).mplsRoutes;
+  lastRouteBuildStats_.mplsRoutesTime =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - mplsStartTime);
+
+  auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  LOG(INFO) << "Decision::buildRouteDb took " << deltaTime.count() << "ms.";
+  fb303::fbData->addStatValue(
+      "decision.route_build_ms", deltaTime.count(), fb303::AVG);
+  return routeDb;
+} // buildRouteDb
+
+std::optional<DecisionRouteUpdate>
+SpfSolver::SpfSolverImpl::buildRouteDbDelta(
+    const std::string& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    PrefixState const& prefixState,
+    DecisionRouteDb const& routeDb) {
+  const auto startTime = std::chrono::steady_clock::now();
+  auto unicastRoutes =
+      buildUnicastRoutes(myNodeName, areaLinkStates, prefixState, &routeDb);
+  if (not unicastRoutes) {
+    return std::nullopt;
+  }
+
+  DecisionRouteUpdate delta;
+  const auto diffStartTime = std::chrono::steady_clock::now();
+  for (auto& route : unicastRoutes->routes) {
+    delta.addRouteToUpdate(std::move(route));
+  }
+
+  // Every previous route was built again, there is nothing to withdraw.
+  // Otherwise withdraw the ones whose prefix is gone or has no route anymore
+  if (unicastRoutes->numPrevRoutes != routeDb.unicastRoutes.size()) {
+    for (auto const& [prefix, _] : routeDb.unicastRoutes) {
+      if (delta.unicastRoutesToUpdate.count(prefix)) {
         continue;
       }
-
-      // Create nexthops with appropriate MplsAction (PHP and SWAP). Note that
-      // all nexthops are valid for routing without loops. Fib is responsible
-      // for installing these routes by making sure it programs least cost
-      // nexthops first and of same action type (based on HW limitations)
-      labelToNode.erase(topLabel);
-      labelToNode.emplace(
-          topLabel,
-          std::make_pair(
-              adjDb.thisNodeName_ref().value(),
-              RibMplsEntry(
-                  topLabel,
-                  getNextHopsThrift(
-                      myNodeName,
-                      {{adjDb.thisNodeName_ref().value(), area}},
-                      false,
-                      false,
-                      metricNhs.first,
-                      metricNhs.second,
-                      topLabel,
-                      areaLinkStates))));
+      if (not prefixState.prefixes().count(prefix) or
+          unicastRoutes->noRoutePrefixes.count(prefix)) {
+        delta.unicastRoutesToDelete.emplace_back(prefix);
+      }
     }
   }
 
-  for (auto& [_, nodeToEntry] : labelToNode) {
-    routeDb.addMplsRoute(std::move(nodeToEntry.second));
+  const auto mplsStartTime = std::chrono::steady_clock::now();
+  auto mplsRouteDb = buildMplsRouteDb(myNodeName, areaLinkStates);
+  const auto mplsEndTime = std::chrono::steady_clock::now();
+  routeDb.calculateMplsUpdate(mplsRouteDb.mplsRoutes, delta);
+  lastRouteBuildStats_.mplsRoutesTime =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          mplsEndTime - mplsStartTime);
+  lastRouteBuildStats_.diffTime =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - diffStartTime) -
+      lastRouteBuildStats_.mplsRoutesTime;
+
+  auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  LOG(INFO) << "Decision::buildRouteDbDelta took " << deltaTime.count()
+            << "ms.";
+  fb303::fbData->addStatValue(
+      "decision.route_build_ms", deltaTime.count(), fb303::AVG);
+  return delta;
+} // buildRouteDbDelta
+
+DecisionRouteDb
+SpfSolver::SpfSolverImpl::buildMplsRouteDb(
+    const std::string& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates) {
+  DecisionRouteDb routeDb{};
+
+  //
+  // Create MPLS routes for all nodeLabel and all of our adjacencies
+  //
+  if (myNodeName == myNodeName_) {
+    updateMplsRoutesCache(areaLinkStates);
+    addNodeLabelRoutes(mplsRoutesCache_.nodeLabelRoutes, routeDb);
+    for (auto const& entry : mplsRoutesCache_.adjLabelRoutes) {
+      routeDb.addMplsRoute(RibMplsEntry(entry));
+    }
+  } else {
+    std::map<NodeAndArea, RibMplsEntry> nodeLabelRoutes;
+    for (const auto& [area, linkState] : areaLinkStates) {
+      for (const auto& [node, _] : linkState.getAdjacencyDatabases()) {
+        if (auto entry = createNodeLabelRoute(
+                myNodeName, {node, area}, areaLinkStates)) {
+          nodeLabelRoutes.emplace(
+              NodeAndArea{node, area}, std::move(entry).value());
+        }
+      }
+    }
+    addNodeLabelRoutes(nodeLabelRoutes, routeDb);
+    for (auto& entry : createAdjLabelRoutes(myNodeName, areaLinkStates)) {
+      routeDb.addMplsRoute(std::move(entry));
+    }
   }
 
   //
-  // Create MPLS routes for all of our adjacencies
+  // Add static routes
   //
+  for (const auto& [topLabel, nhs] : staticMplsRoutes_) {
+    routeDb.addMplsRoute(RibMplsEntry(
+        topLabel,
+        std::unordered_set<thrift::NextHopThrift>{nhs.begin(), nhs.end()}));
+  }
+
+  return routeDb;
+} // buildMplsRouteDb
+
+void
+SpfSolver::SpfSolverImpl::updateMplsRoutesCache(
+    std::unordered_map<std::string, LinkState> const& areaLinkStates) {
+  auto& cache = mplsRoutesCache_;
+  auto changes = cache.tracker.update(areaLinkStates, myNodeName_);
+  if (not changes.changed) {
+    return;
+  }
+
+  // LFA next-hops depend on shortest paths of the neighbors too. Routes to a
+  // node are built from its shortest paths in every area
+  auto& changedNodes = changes.nodes;
+  if (changes.allNodes or computeLfaPaths_) {
+    cache.nodeLabelRoutes.clear();
+    for (auto const& [area, linkState] : areaLinkStates) {
+      for (auto const& [node, _] : linkState.getAdjacencyDatabases()) {
+        changedNodes.insert(node);
+      }
+    }
+  }
+  for (auto const& node : changedNodes) {
+    for (auto const& [area, linkState] : areaLinkStates) {
+      cache.nodeLabelRoutes.erase(NodeAndArea{node, area});
+      if (not linkState.hasNode(node)) {
+        continue;
+      }
+      if (auto entry =
+              createNodeLabelRoute(myNodeName_, {node, area}, areaLinkStates)) {
+        cache.nodeLabelRoutes.emplace(
+            NodeAndArea{node, area}, std::move(entry).value());
+      }
+    }
+  }
+  fb303::fbData->addStatValue(
+      "decision.node_label_routes_built", changedNodes.size(), fb303::COUNT);
+
+  // adjacency label routes are as cheap to build as to compare
+  cache.adjLabelRoutes = createAdjLabelRoutes(myNodeName_, areaLinkStates);
+}
+
+std::optional<RibMplsEntry>
+SpfSolver::SpfSolverImpl::createNodeLabelRoute(
+    const std::string& myNodeName,
+    NodeAndArea const& dstNodeArea,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates) {
+  auto const& [dstNode, area] = dstNodeArea;
+  auto const& adjDb =
+      areaLinkStates.at(area).getAdjacencyDatabases().at(dstNode);
+  const auto topLabel = *adjDb.nodeLabel_ref();
+  // Top label is not set => Non-SR mode
+  if (topLabel == 0) {
+    return std::nullopt;
+  }
+  // If mpls label is not valid then ignore it
+  if (not isMplsLabelValid(topLabel)) {
+    LOG(ERROR) << "Ignoring invalid node label " << topLabel << " of node "
+               << dstNode;
+    fb303::fbData->addStatValue("decision.skipped_mpls_route", 1, fb303::COUNT);
+    return std::nullopt;
+  }
+
+  // Install POP_AND_LOOKUP for next layer
+  if (dstNode == myNodeName) {
+    thrift::NextHopThrift nh;
+    *nh.address_ref() = toBinaryAddress(folly::IPAddressV6("::"));
+    nh.area_ref() = area;
+    nh.mplsAction_ref() =
+        createMplsAction(thrift::MplsActionCode::POP_AND_LOOKUP);
+    return RibMplsEntry(topLabel, {nh});
+  }
+
+  // Get best nexthop towards the node
+  auto metricNhs = getNextHopsWithMetric(
+      myNodeName, {dstNodeArea}, false, areaLinkStates, computeLfaPaths_);
+  if (metricNhs.second.empty()) {
+    LOG(WARNING) << "No route to nodeLabel " << std::to_string(topLabel)
+                 << " of node " << dstNode;
+    fb303::fbData->addStatValue("decision.no_route_to_label", 1, fb303::COUNT);
+    return std::nullopt;
+  }
+
+  // Create nexthops with appropriate MplsAction (PHP and SWAP). Note that
+  // all nexthops are valid for routing without loops. Fib is responsible
+  // for installing these routes by making sure it programs least cost
+  // nexthops first and of same action type (based on HW limitations)
+  return RibMplsEntry(
+      topLabel,
+      getNextHopsThrift(
+          myNodeName,
+          {dstNodeArea},
+          false,
+          false,
+          metricNhs.first,
+          metricNhs.second,
+          topLabel,
+          computeLfaPaths_,
+          areaLinkStates));
+}
+
+std::vector<RibMplsEntry>
+SpfSolver::SpfSolverImpl::createAdjLabelRoutes(
+    const std::string& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates) const {
+  std::vector<RibMplsEntry> routes;
   for (const auto& [_, linkState] : areaLinkStates) {
     for (const auto& link : linkState.linksFromNode(myNodeName)) {
       const auto topLabel = link->getAdjLabelFromNode(myNodeName);
@@ -704,39 +1599,182 @@ SpfSolver::SpfSolverImpl::buildRouteDb(
         continue;
       }
 
-      routeDb.addMplsRoute(RibMplsEntry(
+      routes.emplace_back(
           topLabel,
-          {createNextHop(
+          std::unordered_set<thrift::NextHopThrift>{createNextHop(
               link->getNhV6FromNode(myNodeName),
               link->getIfaceFromNode(myNodeName),
               link->getMetricFromNode(myNodeName),
               createMplsAction(thrift::MplsActionCode::PHP),
               link->getArea(),
-              link->getOtherNodeName(myNodeName))}));
+              link->getOtherNodeName(myNodeName))});
     }
   }
+  return routes;
+}
 
-  //
-  // Add static routes
-  //
-  for (const auto& [topLabel, nhs] : staticMplsRoutes_) {
-    routeDb.addMplsRoute(RibMplsEntry(
-        topLabel,
-        std::unordered_set<thrift::NextHopThrift>{nhs.begin(), nhs.end()}));
+void
+SpfSolver::SpfSolverImpl::addNodeLabelRoutes(
+    std::map<NodeAndArea, RibMplsEntry> const& nodeLabelRoutes,
+    DecisionRouteDb& routeDb) {
+  std::unordered_map<int32_t, std::pair<std::string, RibMplsEntry const*>>
+      labelToNode;
+  for (auto const& [nodeArea, entry] : nodeLabelRoutes) {
+    auto const& node = nodeArea.first;
+    auto iter = labelToNode.find(entry.label);
+    if (iter != labelToNode.end()) {
+      LOG(INFO) << "Find duplicate label " << entry.label << "from "
+                << iter->second.first << " " << node;
+      fb303::fbData->addStatValue(
+          "decision.duplicate_node_label", 1, fb303::COUNT);
+      if (iter->second.first < node) {
+        continue;
+      }
+    }
+    labelToNode.insert_or_assign(entry.label, std::make_pair(node, &entry));
   }
 
-  auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(
-      std::chrono::steady_clock::now() - startTime);
-  LOG(INFO) << "Decision::buildRouteDb took " << deltaTime.count() << "ms.";
+  for (auto const& [_, nodeToEntry] : labelToNode) {
+    routeDb.addMplsRoute(RibMplsEntry(*nodeToEntry.second));
+  }
+}
+
+void
+SpfSolver::SpfSolverImpl::buildUnicastRoutesParallel(
+    const std::string& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    PrefixState const& prefixState,
+    DecisionRouteDb const* prevRouteDb,
+    std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult> const&
+        prevBestRoutesCache,
+    UnicastRoutes& unicastRoutes) {
+  // LinkState is only read during route computation, except for memoizing
+  // SPF results on first use. Compute every SPF result the SP_ECMP path asks
+  // for up front so that workers share them read-only, without reordering
+  // the memoized results on each lookup
+  for (auto const& [_, linkState] : areaLinkStates) {
+    linkState.getSpfResult(myNodeName);
+    if (computeLfaPaths_ or computeLfaBackups_) {
+      for (auto const& link : linkState.linksFromNode(myNodeName)) {
+        if (link->isUp()) {
+          linkState.getSpfResult(link->getOtherNodeName(myNodeName));
+        }
+      }
+    }
+  }
+
+  // KSP2_ED_ECMP memoizes k-th shortest paths per destination, those prefixes
+  // are computed inline once workers are done
+  std::vector<folly::CIDRNetwork const*> shardedPrefixes;
+  std::vector<folly::CIDRNetwork const*> inlinePrefixes;
+  shardedPrefixes.reserve(prefixState.prefixes().size());
+  for (auto const& [prefix, prefixEntries] : prefixState.prefixes()) {
+    bool const isKsp2 = std::any_of(
+        prefixEntries.begin(), prefixEntries.end(), [](auto const& kv) {
+          return *kv.second.forwardingAlgorithm_ref() ==
+              thrift::PrefixForwardingAlgorithm::KSP2_ED_ECMP;
+        });
+    (isKsp2 ? inlinePrefixes : shardedPrefixes).push_back(&prefix);
+  }
+
+  struct Shard {
+    UnicastRoutes routes;
+    std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult>
+        bestRoutesCache;
+    NextHopsCache nextHopsCache;
+  };
+  auto const numShards = std::max<size_t>(
+      1,
+      std::min<size_t>(
+          routeBuildExecutor_->numThreads(),
+          shardedPrefixes.size() / kMinPrefixesPerRouteBuildShard));
   fb303::fbData->addStatValue(
-      "decision.route_build_ms", deltaTime.count(), fb303::AVG);
-  return routeDb;
-} // buildRouteDb
+      "decision.route_build_shards", numShards, fb303::AVG);
+
+  // Shards start off next-hops cached for this node and fill their own copy,
+  // next-hop groups are shared by all of them
+  bool const isMyNode = myNodeName == myNodeName_;
+  if (isMyNode) {
+    maybeInvalidateNextHopsCache(areaLinkStates);
+  }
+  std::vector<Shard> shards(numShards);
+  for (auto& shard : shards) {
+    if (isMyNode) {
+      shard.nextHopsCache = nextHopsCache_;
+    }
+  }
+  for (auto const& [_, linkState] : areaLinkStates) {
+    linkState.setSharedSpfLookups(true);
+  }
+  std::vector<folly::Future<folly::Unit>> shardFutures;
+  shardFutures.reserve(numShards);
+  for (size_t i = 0; i < numShards; ++i) {
+    shardFutures.emplace_back(folly::via(routeBuildExecutor_.get(), [&, i]() {
+      auto& shard = shards.at(i);
+      auto const begin = shardedPrefixes.size() * i / numShards;
+      auto const end = shardedPrefixes.size() * (i + 1) / numShards;
+      for (auto j = begin; j < end and not isPreempted(); ++j) {
+        auto const& prefix = *shardedPrefixes.at(j);
+        addUnicastRoute(
+            shard.routes,
+            prefix,
+            createRouteForPrefix(
+                myNodeName,
+                areaLinkStates,
+                prefixState,
+                prefix,
+                shard.bestRoutesCache,
+                &prevBestRoutesCache,
+                &shard.nextHopsCache),
+            prevRouteDb);
+      }
+    }));
+  }
+
+  // Wait for every shard before looking at results, shards refer to locals
+  auto shardResults = folly::collectAll(std::move(shardFutures)).get();
+  for (auto const& [_, linkState] : areaLinkStates) {
+    linkState.setSharedSpfLookups(false);
+  }
+  for (auto& result : shardResults) {
+    result.throwIfFailed();
+  }
+
+  for (auto& shard : shards) {
+    auto& routes = unicastRoutes.routes;
+    routes.insert(
+        routes.end(),
+        std::make_move_iterator(shard.routes.routes.begin()),
+        std::make_move_iterator(shard.routes.routes.end()));
+    unicastRoutes.numPrevRoutes += shard.routes.numPrevRoutes;
+    unicastRoutes.noRoutePrefixes.merge(shard.routes.noRoutePrefixes);
+    bestRoutesCache_.merge(shard.bestRoutesCache);
+    if (isMyNode) {
+      nextHopsCache_.merge(shard.nextHopsCache);
+    }
+  }
+
+  for (auto const* prefix : inlinePrefixes) {
+    if (isPreempted()) {
+      break;
+    }
+    addUnicastRoute(
+        unicastRoutes,
+        *prefix,
+        createRouteForPrefix(
+            myNodeName,
+            areaLinkStates,
+            prefixState,
+            *prefix,
+            &prevBestRoutesCache),
+        prevRouteDb);
+  }
+}
 
 BestRouteSelectionResult
 SpfSolver::SpfSolverImpl::selectBestRoutes(
     std::string const& myNodeName,
-    thrift::IpPrefix const& prefix,
+    folly::CIDRNetwork const& prefix,
     PrefixEntries const& prefixEntries,
     bool const isBgp,
     std::unordered_map<std::string, LinkState> const& areaLinkStates) {
@@ -763,6 +1801,44 @@ SpfSolver::SpfSolverImpl::selectBestRoutes(
   return maybeFilterDrainedNodes(std::move(ret), areaLinkStates);
 }
 
+size_t
+SpfSolver::SpfSolverImpl::hashBestRouteSelectionInputs(
+    std::string const& myNodeName,
+    PrefixEntries const& prefixEntries,
+    bool const isBgp,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates) const {
+  // Sum of per entry hashes, which doesn't depend on the iteration order
+  size_t entriesHash{0};
+  for (auto const& [nodeAndArea, prefixEntry] : prefixEntries) {
+    auto const& [node, area] = nodeAndArea;
+    size_t entryHash = folly::hash::hash_combine(
+        node, area, areaLinkStates.at(area).isNodeOverloaded(node));
+    if (enableBestRouteSelection_) {
+      auto const& metrics = *prefixEntry.metrics_ref();
+      entryHash = folly::hash::hash_combine(
+          entryHash,
+          *metrics.path_preference_ref(),
+          *metrics.source_preference_ref(),
+          *metrics.distance_ref());
+    } else if (isBgp and prefixEntry.mv_ref().has_value()) {
+      auto const& mv = prefixEntry.mv_ref().value();
+      entryHash = folly::hash::hash_combine(entryHash, *mv.version_ref());
+      for (auto const& entity : *mv.metrics_ref()) {
+        entryHash = folly::hash::hash_combine(
+            entryHash,
+            *entity.type_ref(),
+            *entity.priority_ref(),
+            static_cast<int>(*entity.op_ref()),
+            *entity.isBestPathTieBreaker_ref(),
+            folly::hash::hash_range(
+                entity.metric_ref()->begin(), entity.metric_ref()->end()));
+      }
+    }
+    entriesHash += entryHash;
+  }
+  return folly::hash::hash_combine(myNodeName, isBgp, entriesHash);
+}
+
 std::optional<int64_t>
 SpfSolver::SpfSolverImpl::getMinNextHopThreshold(
     BestRouteSelectionResult nodes, PrefixEntries const& prefixEntries) {
@@ -806,7 +1882,7 @@ SpfSolver::SpfSolverImpl::maybeFilterDrainedNodes(
 BestRouteSelectionResult
 SpfSolver::SpfSolverImpl::runBestPathSelectionBgp(
     std::string const& myNodeName,
-    thrift::IpPrefix const& prefix,
+    folly::CIDRNetwork const& prefix,
     PrefixEntries const& prefixEntries,
     std::unordered_map<std::string, LinkState> const& areaLinkStates) {
   BestRouteSelectionResult ret;
@@ -829,11 +1905,11 @@ SpfSolver::SpfSolverImpl::runBestPathSelectionBgp(
       break;
     case MetricVectorUtils::CompareResult::TIE:
       LOG(ERROR) << "Tie ordering prefix entries. Skipping route for "
-                 << toString(prefix);
+                 << folly::IPAddress::networkToString(prefix);
       return ret;
     case MetricVectorUtils::CompareResult::ERROR:
       LOG(ERROR) << "Error ordering prefix entries. Skipping route for "
-                 << toString(prefix);
+                 << folly::IPAddress::networkToString(prefix);
       return ret;
     default:
       break;
@@ -846,18 +1922,57 @@ SpfSolver::SpfSolverImpl::runBestPathSelectionBgp(
 std::optional<RibUnicastEntry>
 SpfSolver::SpfSolverImpl::selectBestPathsSpf(
     std::string const& myNodeName,
-    thrift::IpPrefix const& prefix,
+    folly::CIDRNetwork const& prefix,
     BestRouteSelectionResult const& bestRouteSelectionResult,
     PrefixEntries const& prefixEntries,
     bool const isBgp,
     thrift::PrefixForwardingType const& forwardingType,
     std::unordered_map<std::string, LinkState> const& areaLinkStates,
-    PrefixState const& prefixState) {
-  const bool isV4Prefix = prefix.prefixAddress_ref()->addr_ref()->size() ==
-      folly::IPAddressV4::byteCount();
+    PrefixState const& prefixState,
+    NextHopsCache* nextHopsCache) {
+  const bool isV4Prefix = prefix.first.isV4();
   const bool perDestination =
       forwardingType == thrift::PrefixForwardingType::SR_MPLS;
 
+  // Per destination next-hops depend on prepend labels of the prefix
+  // entries, don't cache them if there are any
+  if (perDestination and nextHopsCache) {
+    for (auto const& nodeArea : bestRouteSelectionResult.allNodeAreas) {
+      auto it = prefixEntries.find(nodeArea);
+      if (it != prefixEntries.end() and it->second.prependLabel_ref()) {
+        nextHopsCache = nullptr;
+        break;
+      }
+    }
+  }
+  NextHopsCacheKey cacheKey{
+      bestRouteSelectionResult.allNodeAreas, isV4Prefix, forwardingType};
+  if (nextHopsCache) {
+    auto cacheIt = nextHopsCache->find(cacheKey);
+    if (cacheIt != nextHopsCache->end()) {
+      fb303::fbData->addStatValue(
+          "decision.nexthops_cache_hits", 1, fb303::COUNT);
+      if (not cacheIt->second.has_value()) {
+        VLOG(2) << "No route to prefix "
+                << folly::IPAddress::networkToString(prefix);
+        fb303::fbData->addStatValue(
+            "decision.no_route_to_prefix", 1, fb303::COUNT);
+        return std::nullopt;
+      }
+      return addBestPaths(
+          myNodeName,
+          prefix,
+          bestRouteSelectionResult,
+          prefixEntries,
+          prefixState,
+          isBgp,
+          cacheIt->second->first,
+          cacheIt->second->second);
+    }
+    fb303::fbData->addStatValue(
+        "decision.nexthops_cache_misses", 1, fb303::COUNT);
+  }
+
   // Special case for programming imported next-hops during route origination.
   // This case, programs the next-hops learned from external processes while
   // importing route, along with the computed next-hops.
@@ -878,13 +1993,57 @@ SpfSolver::SpfSolverImpl::selectBestPathsSpf(
 
   // Get next-hops
   const auto nextHopsWithMetric = getNextHopsWithMetric(
-      myNodeName, filteredBestNodeAreas, perDestination, areaLinkStates);
+      myNodeName,
+      filteredBestNodeAreas,
+      perDestination,
+      areaLinkStates,
+      computeLfaPaths_);
   if (nextHopsWithMetric.second.empty()) {
-    VLOG(2) << "No route to prefix " << toString(prefix);
+    VLOG(2) << "No route to prefix "
+            << folly::IPAddress::networkToString(prefix);
     fb303::fbData->addStatValue("decision.no_route_to_prefix", 1, fb303::COUNT);
+    if (nextHopsCache) {
+      nextHopsCache->emplace(std::move(cacheKey), std::nullopt);
+    }
     return std::nullopt;
   }
 
+  auto nextHopsThrift = getNextHopsThrift(
+      myNodeName,
+      bestRouteSelectionResult.allNodeAreas,
+      isV4Prefix,
+      perDestination,
+      nextHopsWithMetric.first,
+      nextHopsWithMetric.second,
+      std::nullopt,
+      computeLfaPaths_,
+      areaLinkStates,
+      prefixEntries);
+  if (computeUcmp_ and not computeLfaPaths_ and not perDestination) {
+    nextHopsThrift = applyUcmpWeights(
+        myNodeName,
+        filteredBestNodeAreas,
+        areaLinkStates,
+        std::move(nextHopsThrift));
+  }
+  NextHopSet nextHops = std::move(nextHopsThrift);
+
+  // LFAs already are regular next-hops with computeLfaPaths_
+  NextHopSet backupNextHops;
+  if (computeLfaBackups_ and not computeLfaPaths_ and not perDestination) {
+    backupNextHops = getLfaBackupNextHops(
+        myNodeName,
+        filteredBestNodeAreas,
+        isV4Prefix,
+        nextHops.get(),
+        areaLinkStates,
+        prefixEntries);
+  }
+  if (nextHopsCache) {
+    nextHopsCache->emplace(
+        std::move(cacheKey), std::make_pair(nextHops, backupNextHops));
+  }
+
   return addBestPaths(
       myNodeName,
       prefix,
@@ -892,22 +2051,161 @@ SpfSolver::SpfSolverImpl::selectBestPathsSpf(
       prefixEntries,
       prefixState,
       isBgp,
-      getNextHopsThrift(
-          myNodeName,
-          bestRouteSelectionResult.allNodeAreas,
-          isV4Prefix,
-          perDestination,
-          nextHopsWithMetric.first,
-          nextHopsWithMetric.second,
-          std::nullopt,
-          areaLinkStates,
-          prefixEntries));
+      std::move(nextHops),
+      std::move(backupNextHops));
+}
+
+std::unordered_set<thrift::NextHopThrift>
+SpfSolver::SpfSolverImpl::getLfaBackupNextHops(
+    const std::string& myNodeName,
+    const std::set<NodeAndArea>& dstNodeAreas,
+    bool isV4,
+    std::unordered_set<thrift::NextHopThrift> const& nextHops,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    PrefixEntries const& prefixEntries) {
+  const auto lfaNextHopsWithMetric = getNextHopsWithMetric(
+      myNodeName, dstNodeAreas, false, areaLinkStates, true);
+  if (lfaNextHopsWithMetric.second.empty()) {
+    return {};
+  }
+  auto backupNextHops = getNextHopsThrift(
+      myNodeName,
+      dstNodeAreas,
+      isV4,
+      false,
+      lfaNextHopsWithMetric.first,
+      lfaNextHopsWithMetric.second,
+      std::nullopt,
+      true,
+      areaLinkStates,
+      prefixEntries);
+
+  // a backup sharing an interface with a next-hop goes down along with it
+  std::unordered_set<std::string> ifNames;
+  for (auto const& nextHop : nextHops) {
+    if (auto ifName = nextHop.address_ref()->ifName_ref()) {
+      ifNames.emplace(*ifName);
+    }
+  }
+  for (auto it = backupNextHops.begin(); it != backupNextHops.end();) {
+    auto const& ifName = it->address_ref()->ifName_ref();
+    if (not ifName or ifNames.count(*ifName)) {
+      it = backupNextHops.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return backupNextHops;
+}
+
+std::unordered_set<thrift::NextHopThrift>
+SpfSolver::SpfSolverImpl::applyUcmpWeights(
+    const std::string& myNodeName,
+    const std::set<NodeAndArea>& dstNodeAreas,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    std::unordered_set<thrift::NextHopThrift> nextHops) const {
+  // destinations themselves take any amount of traffic
+  constexpr auto kUnbounded = std::numeric_limits<int64_t>::max();
+
+  // next-hops only lead to the closest destinations, across areas
+  Metric shortestMetric = std::numeric_limits<Metric>::max();
+  for (auto const& [_, linkState] : areaLinkStates) {
+    shortestMetric = std::min(
+        shortestMetric,
+        getMinCostNodes(linkState.getSpfResult(myNodeName), dstNodeAreas)
+            .first);
+  }
+
+  std::map<std::pair<std::string /* area */, std::string /* ifName */>, int64_t>
+      ifWeights;
+  for (auto const& [area, linkState] : areaLinkStates) {
+    auto const& spfResult = linkState.getSpfResult(myNodeName);
+    auto const minCostNodes = getMinCostNodes(spfResult, dstNodeAreas);
+    if (minCostNodes.first != shortestMetric) {
+      continue;
+    }
+
+    // Walk shortest paths back from the destinations, collecting links
+    // leaving each node of the DAG towards them
+    std::vector<std::string> dagNodes(
+        minCostNodes.second.begin(), minCostNodes.second.end());
+    std::unordered_set<std::string> seen(dagNodes.begin(), dagNodes.end());
+    std::unordered_map<std::string, std::vector<Link const*>> dagLinks;
+    for (size_t i = 0; i < dagNodes.size(); ++i) {
+      for (auto const& pathLink : spfResult.at(dagNodes.at(i)).pathLinks()) {
+        dagLinks[pathLink.prevNode].push_back(pathLink.link.get());
+        if (seen.emplace(pathLink.prevNode).second) {
+          dagNodes.push_back(pathLink.prevNode);
+        }
+      }
+    }
+
+    // Links lead to nodes of higher metric, start from the farthest ones
+    std::sort(
+        dagNodes.begin(),
+        dagNodes.end(),
+        [&spfResult](std::string const& lhs, std::string const& rhs) {
+          return spfResult.at(lhs).metric() > spfResult.at(rhs).metric();
+        });
+    std::unordered_map<std::string, int64_t> capacities;
+    for (auto const& node : dagNodes) {
+      auto it = dagLinks.find(node);
+      if (it == dagLinks.end()) {
+        capacities.emplace(node, kUnbounded);
+        continue;
+      }
+      int64_t capacity{0};
+      for (auto const* link : it->second) {
+        auto const linkCapacity = std::min(
+            std::max<int64_t>(1, link->getWeightFromNode(node)),
+            capacities.at(link->getOtherNodeName(node)));
+        capacity = kUnbounded - capacity < linkCapacity
+            ? kUnbounded
+            : capacity + linkCapacity;
+        if (node == myNodeName) {
+          ifWeights[{area, link->getIfaceFromNode(node)}] += linkCapacity;
+        }
+      }
+      capacities.emplace(node, capacity);
+    }
+  }
+
+  std::vector<int64_t> weights;
+  weights.reserve(nextHops.size());
+  int64_t divisor{0};
+  for (auto const& nextHop : nextHops) {
+    auto const& ifName = nextHop.address_ref()->ifName_ref();
+    auto it = ifWeights.end();
+    if (ifName and nextHop.area_ref()) {
+      it = ifWeights.find({*nextHop.area_ref(), *ifName});
+    }
+    if (it == ifWeights.end()) {
+      return nextHops;
+    }
+    weights.push_back(it->second);
+    divisor = std::gcd(divisor, it->second);
+  }
+  if (std::all_of(weights.begin(), weights.end(), [divisor](int64_t weight) {
+        return weight == divisor;
+      })) {
+    return nextHops;
+  }
+
+  std::unordered_set<thrift::NextHopThrift> weightedNextHops;
+  auto weightIt = weights.begin();
+  for (auto const& nextHop : nextHops) {
+    auto weightedNextHop = nextHop;
+    weightedNextHop.weight_ref() = std::min<int64_t>(
+        *weightIt++ / divisor, std::numeric_limits<int32_t>::max());
+    weightedNextHops.emplace(std::move(weightedNextHop));
+  }
+  return weightedNextHops;
 }
 
 std::optional<RibUnicastEntry>
 SpfSolver::SpfSolverImpl::selectBestPathsKsp2(
     const string& myNodeName,
-    const thrift::IpPrefix& prefix,
+    const folly::CIDRNetwork& prefix,
     BestRouteSelectionResult const& bestRouteSelectionResult,
     PrefixEntries const& prefixEntries,
     bool isBgp,
@@ -918,7 +2216,8 @@ SpfSolver::SpfSolverImpl::selectBestPathsKsp2(
   if (forwardingType != thrift::PrefixForwardingType::SR_MPLS) {
     LOG(ERROR) << "Incompatible forwarding type "
                << apache ::thrift::util::enumNameSafe(forwardingType)
-               << " for algorithm KSPF2_ED_ECMP of " << toString(prefix);
+               << " for algorithm KSPF2_ED_ECMP of "
+               << folly::IPAddress::networkToString(prefix);
 
     fb303::fbData->addStatValue(
         "decision.incompatible_forwarding_type", 1, fb303::COUNT);
@@ -1005,8 +2304,7 @@ SpfSolver::SpfSolverImpl::selectBestPathsKsp2(
             thrift::MplsActionCode::PUSH, std::nullopt, std::move(labelVec));
       }
 
-      auto const& prefixStr = *prefix.prefixAddress_ref()->addr_ref();
-      bool isV4Prefix = prefixStr.size() == folly::IPAddressV4::byteCount();
+      bool isV4Prefix = prefix.first.isV4();
 
       nextHops.emplace(createNextHop(
           isV4Prefix ? firstLink->getNhV4FromNode(myNodeName)
@@ -1032,20 +2330,20 @@ SpfSolver::SpfSolverImpl::selectBestPathsKsp2(
 std::optional<RibUnicastEntry>
 SpfSolver::SpfSolverImpl::addBestPaths(
     const string& myNodeName,
-    const thrift::IpPrefix& prefixThrift,
+    const folly::CIDRNetwork& prefix,
     const BestRouteSelectionResult& bestRouteSelectionResult,
     const PrefixEntries& prefixEntries,
     const PrefixState& prefixState,
     const bool isBgp,
-    std::unordered_set<thrift::NextHopThrift>&& nextHops) {
-  const auto prefix = toIPNetwork(prefixThrift);
-
+    NextHopSet nextHops,
+    NextHopSet backupNextHops) {
   // Apply min-nexthop requirements. Ignore the route from programming if
   // min-nexthop requirement is not met.
   auto minNextHop =
       getMinNextHopThreshold(bestRouteSelectionResult, prefixEntries);
   if (minNextHop.has_value() && minNextHop.value() > nextHops.size()) {
-    LOG(WARNING) << "Dropping route to " << toString(prefixThrift)
+    LOG(WARNING) << "Dropping route to "
+                 << folly::IPAddress::networkToString(prefix)
                  << " because of min-nexthop requirement. "
                  << "Minimum required " << minNextHop.value() << ", got "
                  << nextHops.size();
@@ -1083,12 +2381,14 @@ SpfSolver::SpfSolverImpl::addBestPaths(
   }
 
   // Create RibUnicastEntry and add it the list
-  return RibUnicastEntry(
+  RibUnicastEntry entry(
       prefix,
       std::move(nextHops),
       prefixEntries.at(bestRouteSelectionResult.bestNodeArea),
       bestRouteSelectionResult.bestNodeArea.second,
       isBgp & bgpDryRun_); // doNotInstall
+  entry.backupNexthops = std::move(backupNextHops);
+  return entry;
 }
 
 std::pair<Metric, std::unordered_set<std::string>>
@@ -1125,7 +2425,8 @@ SpfSolver::SpfSolverImpl::getNextHopsWithMetric(
     const std::string& myNodeName,
     const std::set<NodeAndArea>& dstNodeAreas,
     bool perDestination,
-    std::unordered_map<std::string, LinkState> const& areaLinkStates) {
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    bool withLfa) {
   // build up next hop nodes both nodes that are along a shortest path to the
   // prefix and, if enabled, those with an LFA path to the prefix
   std::unordered_map<
@@ -1167,7 +2468,7 @@ SpfSolver::SpfSolverImpl::getNextHopsWithMetric(
     }
 
     // add any other neighbors that have LFA paths to the prefix
-    if (computeLfaPaths_) {
+    if (withLfa) {
       for (auto link : linkState.linksFromNode(myNodeName)) {
         if (!link->isUp()) {
           continue;
@@ -1217,6 +2518,7 @@ SpfSolver::SpfSolverImpl::getNextHopsThrift(
     std::unordered_map<std::pair<std::string, std::string>, Metric>
         nextHopNodes,
     std::optional<int32_t> swapLabel,
+    bool withLfa,
     std::unordered_map<std::string, LinkState> const& areaLinkStates,
     PrefixEntries const& prefixEntries) const {
   CHECK(not nextHopNodes.empty());
@@ -1252,7 +2554,7 @@ SpfSolver::SpfSolverImpl::getNextHopsThrift(
         // towards the nexthop on shortest path are LFA routes.
         Metric distOverLink =
             link->getMetricFromNode(myNodeName) + search->second;
-        if (not computeLfaPaths_ and distOverLink != minMetric) {
+        if (not withLfa and distOverLink != minMetric) {
           continue;
         }
 
@@ -1326,18 +2628,20 @@ SpfSolver::SpfSolver(
     bool computeLfaPaths,
     bool enableOrderedFib,
     bool bgpDryRun,
-    bool enableBestRouteSelection)
+    bool enableBestRouteSelection,
+    size_t routeBuildThreads)
     : impl_(new SpfSolver::SpfSolverImpl(
           myNodeName,
           enableV4,
           computeLfaPaths,
           enableOrderedFib,
           bgpDryRun,
-          enableBestRouteSelection)) {}
+          enableBestRouteSelection,
+          routeBuildThreads)) {}
 
 SpfSolver::~SpfSolver() {}
 
-void
+std::unordered_set<int32_t>
 SpfSolver::updateStaticRoutes(thrift::RouteDatabaseDelta&& staticRoutesDelta) {
   return impl_->updateStaticRoutes(std::move(staticRoutesDelta));
 }
@@ -1352,22 +2656,66 @@ SpfSolver::createRouteForPrefix(
     const std::string& myNodeName,
     std::unordered_map<std::string, LinkState> const& areaLinkStates,
     PrefixState const& prefixState,
-    thrift::IpPrefix const& prefix) {
+    folly::CIDRNetwork const& prefix) {
   return impl_->createRouteForPrefix(
       myNodeName, areaLinkStates, prefixState, prefix);
 }
 
-std::unordered_map<thrift::IpPrefix, BestRouteSelectionResult> const&
+std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult> const&
 SpfSolver::getBestRoutesCache() const {
   return impl_->getBestRoutesCache();
 }
 
-std::optional<DecisionRouteDb>
-SpfSolver::buildRouteDb(
-    const std::string& myNodeName,
-    std::unordered_map<std::string, LinkState> const& areaLinkStates,
-    PrefixState const& prefixState) {
-  return impl_->buildRouteDb(myNodeName, areaLinkStates, prefixState);
+void
+SpfSolver::setBestRoutesCache(
+    std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult>&&
+        bestRoutesCache) {
+  impl_->setBestRoutesCache(std::move(bestRoutesCache));
+}
+
+void
+SpfSolver::setPreemptionCheck(std::function<bool()> isPreempted) {
+  impl_->setPreemptionCheck(std::move(isPreempted));
+}
+
+void
+SpfSolver::setComputeLfaBackups(bool computeLfaBackups) {
+  impl_->setComputeLfaBackups(computeLfaBackups);
+}
+
+void
+SpfSolver::setComputeUcmp(bool computeUcmp) {
+  impl_->setComputeUcmp(computeUcmp);
+}
+
+RouteBuildStats const&
+SpfSolver::getLastRouteBuildStats() const {
+  return impl_->getLastRouteBuildStats();
+}
+
+std::optional<DecisionRouteDb>
+SpfSolver::buildRouteDb(
+    const std::string& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    PrefixState const& prefixState) {
+  return impl_->buildRouteDb(myNodeName, areaLinkStates, prefixState);
+}
+
+DecisionRouteDb
+SpfSolver::buildMplsRouteDb(
+    const std::string& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates) {
+  return impl_->buildMplsRouteDb(myNodeName, areaLinkStates);
+}
+
+std::optional<DecisionRouteUpdate>
+SpfSolver::buildRouteDbDelta(
+    const std::string& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    PrefixState const& prefixState,
+    DecisionRouteDb const& routeDb) {
+  return impl_->buildRouteDbDelta(
+      myNodeName, areaLinkStates, prefixState, routeDb);
 }
 
 //
@@ -1380,25 +2728,82 @@ Decision::Decision(
     bool bgpDryRun,
     std::chrono::milliseconds debounceMinDur,
     std::chrono::milliseconds debounceMaxDur,
-    messaging::RQueue<thrift::Publication> kvStoreUpdatesQueue,
+    messaging::RQueue<PublicationPtr> kvStoreUpdatesQueue,
     messaging::RQueue<thrift::RouteDatabaseDelta> staticRoutesUpdateQueue,
-    messaging::ReplicateQueue<DecisionRouteUpdate>& routeUpdatesQueue)
+    messaging::ReplicateQueue<DecisionRouteUpdatePtr>& routeUpdatesQueue,
+    messaging::ReplicateQueue<thrift::LinkStateDelta>* linkStateUpdatesQueue,
+    std::unique_ptr<RouteComputationEngine> routeEngine)
     : config_(config),
       routeUpdatesQueue_(routeUpdatesQueue),
+      linkStateUpdatesQueue_(linkStateUpdatesQueue),
+      computeLfaPaths_(computeLfaPaths),
+      bgpDryRun_(bgpDryRun),
       myNodeName_(*config->getConfig().node_name_ref()),
       pendingUpdates_(*config->getConfig().node_name_ref()),
       rebuildRoutesDebounced_(
-          getEvb(), debounceMinDur, debounceMaxDur, [this]() noexcept {
-            rebuildRoutes("DECISION_DEBOUNCE");
-          }) {
+          getEvb(),
+          debounceMinDur,
+          debounceMaxDur,
+          [this]() noexcept { rebuildRoutesOnDebounce(); }),
+      defaultDebounceMinDur_(debounceMinDur),
+      defaultDebounceMaxDur_(debounceMaxDur) {
   auto tConfig = config->getConfig();
+  if (config->isAdaptiveDebounceEnabled()) {
+    adaptiveRebuildRoutesDebounced_ =
+        std::make_unique<AdaptiveDebounce<std::chrono::milliseconds>>(
+            getEvb(), debounceMinDur, debounceMaxDur, [this]() noexcept {
+              rebuildRoutesOnDebounce();
+            });
+  }
+  setDebounceFromConfig(*config);
   spfSolver_ = std::make_unique<SpfSolver>(
+      *tConfig.node_name_ref(),
+      tConfig.enable_v4_ref().value_or(false),
+      computeLfaPaths,
+      tConfig.enable_ordered_fib_programming_ref().value_or(false),
+      bgpDryRun,
+      config->isBestRouteSelectionEnabled(),
+      config->getRouteBuildThreads());
+  spfSolver_->setComputeLfaBackups(config->isLfaBackupEnabled());
+  spfSolver_->setComputeUcmp(config->isUcmpEnabled());
+  routeEngine_ = std::move(routeEngine);
+  if (routeEngine_) {
+    LOG(INFO) << "Computing routes with engine " << routeEngine_->getName();
+  }
+
+  if (config->isAsyncRouteBuildEnabled()) {
+    asyncSpfSolver_ = std::make_unique<SpfSolver>(
+        *tConfig.node_name_ref(),
+        tConfig.enable_v4_ref().value_or(false),
+        computeLfaPaths,
+        tConfig.enable_ordered_fib_programming_ref().value_or(false),
+        bgpDryRun,
+        config->isBestRouteSelectionEnabled(),
+        config->getRouteBuildThreads());
+    asyncSpfSolver_->setComputeLfaBackups(config->isLfaBackupEnabled());
+    asyncSpfSolver_->setComputeUcmp(config->isUcmpEnabled());
+    asyncSpfSolver_->setPreemptionCheck([this]() {
+      return asyncRouteBuildPreempted_.load(std::memory_order_relaxed);
+    });
+    routeBuildWorker_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+        1, std::make_shared<folly::NamedThreadFactory>("DecisionRouteBuild"));
+  }
+
+  computedRoutesSpfSolver_ = std::make_unique<SpfSolver>(
       *tConfig.node_name_ref(),
       tConfig.enable_v4_ref().value_or(false),
       computeLfaPaths,
       tConfig.enable_ordered_fib_programming_ref().value_or(false),
       bgpDryRun,
       config->isBestRouteSelectionEnabled());
+  computedRoutesSpfSolver_->setComputeLfaBackups(config->isLfaBackupEnabled());
+  computedRoutesSpfSolver_->setComputeUcmp(config->isUcmpEnabled());
+  computedRoutesWorker_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+      1,
+      std::make_shared<folly::NamedThreadFactory>("DecisionComputedRoutes"));
+  whatIfWorkers_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+      Constants::kWhatIfRouteBuildThreads,
+      std::make_shared<folly::NamedThreadFactory>("DecisionWhatIf"));
 
   coldStartTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
     pendingUpdates_.setNeedsFullRebuild();
@@ -1408,6 +2813,10 @@ Decision::Decision(
     coldStartTimer_->scheduleTimeout(std::chrono::seconds(*eor));
   }
 
+  if (config->isWarmRestartEnabled()) {
+    warmStartFromSnapshot(config->getWarmRestartConfig());
+  }
+
   // Schedule periodic timer for counter submission
   counterUpdateTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
     updateGlobalCounters();
@@ -1433,14 +2842,23 @@ Decision::Decision(
   addFiberTask([q = std::move(kvStoreUpdatesQueue), this]() mutable noexcept {
     LOG(INFO) << "Starting KvStore updates processing fiber";
     while (true) {
-      auto maybeThriftPub = q.get(); // perform read
-      VLOG(2) << "Received KvStore update";
-      if (maybeThriftPub.hasError()) {
+      // perform read of all pending publications
+      auto maybeThriftPubs =
+          q.getBatch(Constants::kDecisionMaxPublicationBatch);
+      if (maybeThriftPubs.hasError()) {
         LOG(INFO) << "Terminating KvStore updates processing fiber";
         break;
       }
+      VLOG(2) << "Received " << maybeThriftPubs->size() << " KvStore updates";
+      fb303::fbData->addStatValue(
+          "decision.publication_batch_size",
+          maybeThriftPubs->size(),
+          fb303::AVG);
       try {
-        processPublication(maybeThriftPub.value());
+        for (const auto& thriftPub : maybeThriftPubs.value()) {
+          refreshStaleKeys(*thriftPub);
+          processPublication(*thriftPub);
+        }
       } catch (const std::exception& e) {
 #if FOLLY_USE_SYMBOLIZER
         // collect stack strace then fail the process
@@ -1454,7 +2872,7 @@ Decision::Decision(
       }
       // compute routes with exponential backoff timer if needed
       if (pendingUpdates_.needsRouteUpdate()) {
-        rebuildRoutesDebounced_();
+        debounceRebuildRoutes();
       }
     }
   });
@@ -1471,44 +2889,199 @@ Decision::Decision(
             break;
           }
           // Apply publication and update stored update status
-          spfSolver_->updateStaticRoutes(std::move(maybeThriftPub).value());
-          pendingUpdates_.setNeedsFullRebuild(); // Mark for full DB rebuild
-          rebuildRoutesDebounced_();
+          auto staticRoutesDelta = std::move(maybeThriftPub).value();
+          if (asyncSpfSolver_) {
+            asyncStaticRoutesBacklog_.push_back(staticRoutesDelta);
+          }
+          computedRoutesWorker_->add(
+              [this, delta = staticRoutesDelta]() mutable {
+                computedRoutesSpfSolver_->updateStaticRoutes(std::move(delta));
+              });
+          pendingUpdates_.applyStaticRoutesChange(
+              spfSolver_->updateStaticRoutes(std::move(staticRoutesDelta)));
+          if (pendingUpdates_.needsRouteUpdate()) {
+            debounceRebuildRoutes();
+          }
         }
       });
 
   // Create RibPolicy timer to process routes on policy expiry
   ribPolicyTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
     LOG(WARNING) << "RibPolicy is expired";
-    pendingUpdates_.setNeedsFullRebuild();
-    rebuildRoutes("RIB_POLICY_EXPIRED");
+    if (coldStartTimer_->isScheduled() or asyncRouteBuildRunning_) {
+      pendingUpdates_.setNeedsFullRebuild();
+      rebuildRoutes("RIB_POLICY_EXPIRED");
+      return;
+    }
+    applyRibPolicyChange(ribPolicy_.get(), nullptr);
   });
 
   // Initialize some stat keys
   fb303::fbData->addStatExportType(
       "decision.rib_policy_processing.time_ms", fb303::AVG);
+  fb303::fbData->addStatExportType(
+      "decision.publication_batch_size", fb303::AVG);
+  fb303::fbData->addStatExportType("decision.async_route_builds", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "decision.async_route_build_preemptions", fb303::COUNT);
+}
+
+Decision::~Decision() {
+  // let a running route build stop early, routeBuildWorker_ is joined first
+  asyncRouteBuildPreempted_ = true;
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::RouteDatabase>>
 Decision::getDecisionRouteDb(std::string nodeName) {
-  folly::Promise<std::unique_ptr<thrift::RouteDatabase>> p;
+  return getDecisionRouteDbs({std::move(nodeName)})
+      .deferValue(
+          [](std::unique_ptr<std::vector<thrift::RouteDatabase>> routeDbs) {
+            return std::make_unique<thrift::RouteDatabase>(
+                std::move(routeDbs->at(0)));
+          });
+}
+
+folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteDatabase>>>
+Decision::getDecisionRouteDbs(std::vector<std::string> nodeNames) {
+  folly::Promise<std::unique_ptr<std::vector<thrift::RouteDatabase>>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([p = std::move(p), nodeName, this]() mutable {
-    thrift::RouteDatabase routeDb;
+  runInEventBaseThread([p = std::move(p),
+                        nodeNames = std::move(nodeNames),
+                        this]() mutable {
+    if (nodeNames.empty()) {
+      std::set<std::string> allNodeNames;
+      for (auto const& [_, linkState] : areaLinkStates_) {
+        for (auto const& kv : linkState.getAdjacencyDatabases()) {
+          allNodeNames.emplace(kv.first);
+        }
+      }
+      nodeNames.assign(allNodeNames.begin(), allNodeNames.end());
+    }
+    for (auto& nodeName : nodeNames) {
+      if (nodeName.empty()) {
+        nodeName = myNodeName_;
+      }
+    }
+
+    // Copy the topology once per generation, the copy is then read and
+    // memoizes SPF results on computedRoutesWorker_ only
+    const auto generation = pendingUpdates_.getGeneration();
+    if (not computedRoutesSnapshot_ or
+        computedRoutesSnapshot_->generation != generation) {
+      computedRoutesSnapshot_ = std::make_shared<ComputedRoutesSnapshot>();
+      computedRoutesSnapshot_->generation = generation;
+      computedRoutesSnapshot_->areaLinkStates = areaLinkStates_;
+      computedRoutesSnapshot_->prefixState = prefixState_;
+    }
+
+    computedRoutesWorker_->add([p = std::move(p),
+                                nodeNames = std::move(nodeNames),
+                                snapshot = computedRoutesSnapshot_,
+                                this]() mutable {
+      auto routeDbs = std::make_unique<std::vector<thrift::RouteDatabase>>();
+      size_t numBuilds{0};
+      for (auto const& nodeName : nodeNames) {
+        auto it = snapshot->routeDbs.find(nodeName);
+        if (it == snapshot->routeDbs.end()) {
+          ++numBuilds;
+          thrift::RouteDatabase routeDb;
+          auto maybeRouteDb = computedRoutesSpfSolver_->buildRouteDb(
+              nodeName, snapshot->areaLinkStates, snapshot->prefixState);
+          if (maybeRouteDb.has_value()) {
+            routeDb = maybeRouteDb->toThrift();
+          }
+          *routeDb.thisNodeName_ref() = nodeName;
+          it = snapshot->routeDbs.emplace(nodeName, std::move(routeDb)).first;
+        }
+        routeDbs->emplace_back(it->second);
+      }
+      for (auto const& [_, linkState] : snapshot->areaLinkStates) {
+        linkState.evictMemoizedResults();
+      }
+      fb303::fbData->addStatValue(
+          "decision.computed_route_dbs.builds", numBuilds, fb303::SUM);
+      fb303::fbData->addStatValue(
+          "decision.computed_route_dbs.hits",
+          nodeNames.size() - numBuilds,
+          fb303::SUM);
+      p.setValue(std::move(routeDbs));
+    });
+  });
+  return sf;
+}
 
+folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteDatabase>>>
+Decision::getRouteDbsWhatIf(
+    std::string nodeName, std::vector<thrift::WhatIfScenario> scenarios) {
+  using RouteDbFutures = std::vector<folly::SemiFuture<thrift::RouteDatabase>>;
+  folly::Promise<RouteDbFutures> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([p = std::move(p),
+                        nodeName = std::move(nodeName),
+                        scenarios = std::move(scenarios),
+                        this]() mutable {
     if (nodeName.empty()) {
       nodeName = myNodeName_;
     }
-    auto maybeRouteDb =
-        spfSolver_->buildRouteDb(nodeName, areaLinkStates_, prefixState_);
-    if (maybeRouteDb.has_value()) {
-      routeDb = maybeRouteDb->toThrift();
-    }
 
-    *routeDb.thisNodeName_ref() = nodeName;
-    p.setValue(std::make_unique<thrift::RouteDatabase>(std::move(routeDb)));
+    // Copy the topology once, scenarios fork it on the workers. Prefixes are
+    // not changed by scenarios and shared as is
+    auto areaLinkStates =
+        std::make_shared<const std::unordered_map<std::string, LinkState>>(
+            areaLinkStates_);
+    auto prefixState = std::make_shared<const PrefixState>(prefixState_);
+
+    RouteDbFutures futures;
+    for (auto& scenario : scenarios) {
+      futures.emplace_back(
+          folly::via(
+              whatIfWorkers_.get(),
+              [nodeName,
+               areaLinkStates,
+               prefixState,
+               config = config_,
+               computeLfaPaths = computeLfaPaths_,
+               bgpDryRun = bgpDryRun_,
+               scenario = std::move(scenario)]() {
+                // memoized SPF results are kept in the fork, not shared
+                auto forkedLinkStates = *areaLinkStates;
+                applyWhatIfScenario(scenario, forkedLinkStates);
+
+                auto const& tConfig = config->getConfig();
+                SpfSolver spfSolver(
+                    *tConfig.node_name_ref(),
+                    tConfig.enable_v4_ref().value_or(false),
+                    computeLfaPaths,
+                    tConfig.enable_ordered_fib_programming_ref().value_or(
+                        false),
+                    bgpDryRun,
+                    config->isBestRouteSelectionEnabled());
+                spfSolver.setComputeLfaBackups(config->isLfaBackupEnabled());
+                spfSolver.setComputeUcmp(config->isUcmpEnabled());
+
+                thrift::RouteDatabase routeDb;
+                auto maybeRouteDb = spfSolver.buildRouteDb(
+                    nodeName, forkedLinkStates, *prefixState);
+                if (maybeRouteDb.has_value()) {
+                  routeDb = maybeRouteDb->toThrift();
+                }
+                *routeDb.thisNodeName_ref() = nodeName;
+                return routeDb;
+              })
+              .semi());
+    }
+    fb303::fbData->addStatValue(
+        "decision.what_if.scenarios", futures.size(), fb303::SUM);
+    p.setValue(std::move(futures));
   });
-  return sf;
+  return std::move(sf)
+      .deferValue([](RouteDbFutures&& futures) {
+        return folly::collect(std::move(futures));
+      })
+      .deferValue([](std::vector<thrift::RouteDatabase>&& routeDbs) {
+        return std::make_unique<std::vector<thrift::RouteDatabase>>(
+            std::move(routeDbs));
+      });
 }
 
 folly::SemiFuture<StaticMplsRoutes>
@@ -1523,45 +3096,141 @@ Decision::getMplsStaticRoutes() {
 
 folly::SemiFuture<std::unique_ptr<thrift::AdjDbs>>
 Decision::getDecisionAdjacencyDbs() {
-  folly::Promise<std::unique_ptr<thrift::AdjDbs>> p;
+  return getReadSnapshot().deferValue(
+      [](std::shared_ptr<const ReadSnapshot> snapshot) {
+        auto const& areaAdjDbs = *snapshot->areaAdjDbs;
+        auto it = areaAdjDbs.find(thrift::KvStore_constants::kDefaultArea());
+        return std::make_unique<thrift::AdjDbs>(
+            it != areaAdjDbs.end() ? it->second : thrift::AdjDbs{});
+      });
+}
+
+folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteBuildProfile>>>
+Decision::getRouteBuildProfiles() {
+  folly::Promise<std::unique_ptr<std::vector<thrift::RouteBuildProfile>>> p;
   auto sf = p.getSemiFuture();
   runInEventBaseThread([p = std::move(p), this]() mutable {
-    auto search =
-        areaLinkStates_.find(thrift::KvStore_constants::kDefaultArea());
-    p.setValue(std::make_unique<thrift::AdjDbs>(
-        search != areaLinkStates_.end() ? search->second.getAdjacencyDatabases()
-                                        : thrift::AdjDbs{}));
+    p.setValue(std::make_unique<std::vector<thrift::RouteBuildProfile>>(
+        routeBuildProfiles_.begin(), routeBuildProfiles_.end()));
   });
   return sf;
 }
 
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::AdjacencyDatabase>>>
 Decision::getAllDecisionAdjacencyDbs() {
-  folly::Promise<std::unique_ptr<std::vector<thrift::AdjacencyDatabase>>> p;
-  auto sf = p.getSemiFuture();
-  runInEventBaseThread([p = std::move(p), this]() mutable {
-    auto adjDbs = std::make_unique<std::vector<thrift::AdjacencyDatabase>>();
-    for (auto const& [_, linkState] : areaLinkStates_) {
-      for (auto const& [_, db] : linkState.getAdjacencyDatabases()) {
-        adjDbs->push_back(db);
-      }
-    }
-    p.setValue(std::move(adjDbs));
-  });
-  return sf;
+  return getReadSnapshot().deferValue(
+      [](std::shared_ptr<const ReadSnapshot> snapshot) {
+        auto adjDbs =
+            std::make_unique<std::vector<thrift::AdjacencyDatabase>>();
+        for (auto const& [_, areaAdjDbs] : *snapshot->areaAdjDbs) {
+          for (auto const& [_, db] : areaAdjDbs) {
+            adjDbs->push_back(db);
+          }
+        }
+        return adjDbs;
+      });
 }
 
 folly::SemiFuture<std::unique_ptr<thrift::PrefixDbs>>
 Decision::getDecisionPrefixDbs() {
-  folly::Promise<std::unique_ptr<thrift::PrefixDbs>> p;
+  return getReadSnapshot().deferValue(
+      [](std::shared_ptr<const ReadSnapshot> snapshot) {
+        return std::make_unique<thrift::PrefixDbs>(*snapshot->prefixDbs);
+      });
+}
+
+std::optional<messaging::RQueue<thrift::LinkStateDelta>>
+Decision::getLinkStateUpdatesReader() {
+  if (not linkStateUpdatesQueue_) {
+    return std::nullopt;
+  }
+  return linkStateUpdatesQueue_->getReader();
+}
+
+folly::SemiFuture<std::unique_ptr<thrift::LinkStateDatabases>>
+Decision::getLinkStateDatabases() {
+  // Read snapshot is taken on Decision thread if databases changed, i.e.
+  // after any changes already published
+  return getReadSnapshot().deferValue(
+      [](std::shared_ptr<const ReadSnapshot> snapshot) {
+        auto dbs = std::make_unique<thrift::LinkStateDatabases>();
+        for (auto const& [_, areaAdjDbs] : *snapshot->areaAdjDbs) {
+          for (auto const& [_, db] : areaAdjDbs) {
+            dbs->adjacencyDbs_ref()->push_back(db);
+          }
+        }
+        *dbs->prefixDbs_ref() = *snapshot->prefixDbs;
+        return dbs;
+      });
+}
+
+folly::SemiFuture<std::shared_ptr<const Decision::ReadSnapshot>>
+Decision::getReadSnapshot() {
+  // flags are cleared only once their snapshot is published
+  if (not adjDbsChanged_.load(std::memory_order_acquire) and
+      not prefixDbsChanged_.load(std::memory_order_acquire)) {
+    return folly::makeSemiFuture(readSnapshot_.copy());
+  }
+  // take up to date snapshot on Decision thread, once for all queries until
+  // databases change again
+  folly::Promise<std::shared_ptr<const ReadSnapshot>> p;
   auto sf = p.getSemiFuture();
   runInEventBaseThread([p = std::move(p), this]() mutable {
-    p.setValue(
-        std::make_unique<thrift::PrefixDbs>(prefixState_.getPrefixDatabases()));
+    p.setValue(updateReadSnapshot());
   });
   return sf;
 }
 
+std::shared_ptr<const Decision::ReadSnapshot>
+Decision::updateReadSnapshot() {
+  auto snapshot = readSnapshot_.copy();
+  if (not adjDbsChanged_ and not prefixDbsChanged_) {
+    return snapshot;
+  }
+
+  auto newSnapshot = snapshot ? std::make_shared<ReadSnapshot>(*snapshot)
+                              : std::make_shared<ReadSnapshot>();
+  if (adjDbsChanged_) {
+    auto areaAdjDbs =
+        std::make_shared<std::unordered_map<std::string, thrift::AdjDbs>>();
+    for (auto const& [area, linkState] : areaLinkStates_) {
+      areaAdjDbs->emplace(area, linkState.getAdjacencyDatabases());
+    }
+    newSnapshot->areaAdjDbs = std::move(areaAdjDbs);
+  }
+  if (prefixDbsChanged_) {
+    newSnapshot->prefixDbs =
+        std::make_shared<thrift::PrefixDbs>(prefixState_.getPrefixDatabases());
+  }
+  fb303::fbData->addStatValue(
+      "decision.read_snapshot_updates", 1, fb303::COUNT);
+
+  // publish the snapshot before queries may skip the Decision thread
+  snapshot = std::move(newSnapshot);
+  *readSnapshot_.wlock() = snapshot;
+  adjDbsChanged_.store(false, std::memory_order_release);
+  prefixDbsChanged_.store(false, std::memory_order_release);
+  return snapshot;
+}
+
+folly::SemiFuture<std::unique_ptr<thrift::PrefixDbsPage>>
+Decision::getDecisionPrefixDbsPage(thrift::PageParams page) {
+  auto [p, sf] =
+      folly::makePromiseContract<std::unique_ptr<thrift::PrefixDbsPage>>();
+  runInEventBaseThread(
+      [p = std::move(p), page = std::move(page), this]() mutable {
+        auto prefixDbsPage = std::make_unique<thrift::PrefixDbsPage>();
+        std::optional<std::string> nextCursor;
+        *prefixDbsPage->prefixDbs_ref() = prefixState_.getPrefixDatabasesPage(
+            page.cursor_ref().to_optional(),
+            std::max(0, *page.limit_ref()),
+            nextCursor);
+        prefixDbsPage->nextCursor_ref().from_optional(std::move(nextCursor));
+        p.setValue(std::move(prefixDbsPage));
+      });
+  return std::move(sf);
+}
+
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::ReceivedRouteDetail>>>
 Decision::getReceivedRoutesFiltered(thrift::ReceivedRouteFilter filter) {
   auto [p, sf] = folly::makePromiseContract<
@@ -1572,23 +3241,7 @@ Decision::getReceivedRoutesFiltered(thrift::ReceivedRouteFilter filter) {
         auto routes = prefixState_.getReceivedRoutesFiltered(filter);
 
         // Add best path result to this
-        auto const& bestRoutesCache = spfSolver_->getBestRoutesCache();
-        for (auto& route : routes) {
-          auto const& bestRoutesIt = bestRoutesCache.find(*route.prefix_ref());
-          if (bestRoutesIt != bestRoutesCache.end()) {
-            auto const& bestRoutes = bestRoutesIt->second;
-            // Set all selected node-area
-            for (auto const& [node, area] : bestRoutes.allNodeAreas) {
-              route.bestKeys_ref()->emplace_back();
-              auto& key = route.bestKeys_ref()->back();
-              key.node_ref() = node;
-              key.area_ref() = area;
-            }
-            // Set best node-area
-            route.bestKey_ref()->node_ref() = bestRoutes.bestNodeArea.first;
-            route.bestKey_ref()->area_ref() = bestRoutes.bestNodeArea.second;
-          }
-        }
+        setBestRouteKeys(routes);
 
         // Set the promise
         p.setValue(std::make_unique<std::vector<thrift::ReceivedRouteDetail>>(
@@ -1597,6 +3250,62 @@ Decision::getReceivedRoutesFiltered(thrift::ReceivedRouteFilter filter) {
   return std::move(sf);
 }
 
+folly::SemiFuture<std::unique_ptr<thrift::ReceivedRoutesPage>>
+Decision::getReceivedRoutesFilteredPage(
+    thrift::ReceivedRouteFilter filter, thrift::PageParams page) {
+  auto [p, sf] =
+      folly::makePromiseContract<std::unique_ptr<thrift::ReceivedRoutesPage>>();
+  runInEventBaseThread([this,
+                        p = std::move(p),
+                        filter = std::move(filter),
+                        page = std::move(page)]() mutable noexcept {
+    std::optional<thrift::IpPrefix> cursor;
+    if (auto cursorStr = page.cursor_ref()) {
+      try {
+        cursor = toIpPrefix(*cursorStr);
+      } catch (std::exception const& e) {
+        p.setException(thrift::OpenrError(
+            folly::sformat("Invalid cursor {}: {}", *cursorStr, e.what())));
+        return;
+      }
+    }
+
+    auto routesPage = std::make_unique<thrift::ReceivedRoutesPage>();
+    std::optional<thrift::IpPrefix> nextCursor;
+    *routesPage->routes_ref() = prefixState_.getReceivedRoutesFilteredPage(
+        filter, cursor, std::max(0, *page.limit_ref()), nextCursor);
+    setBestRouteKeys(*routesPage->routes_ref());
+    if (nextCursor.has_value()) {
+      routesPage->nextCursor_ref() = toString(*nextCursor);
+    }
+    p.setValue(std::move(routesPage));
+  });
+  return std::move(sf);
+}
+
+void
+Decision::setBestRouteKeys(
+    std::vector<thrift::ReceivedRouteDetail>& routes) const {
+  auto const& bestRoutesCache = spfSolver_->getBestRoutesCache();
+  for (auto& route : routes) {
+    auto const& bestRoutesIt =
+        bestRoutesCache.find(toIPNetwork(*route.prefix_ref()));
+    if (bestRoutesIt != bestRoutesCache.end()) {
+      auto const& bestRoutes = bestRoutesIt->second;
+      // Set all selected node-area
+      for (auto const& [node, area] : bestRoutes.allNodeAreas) {
+        route.bestKeys_ref()->emplace_back();
+        auto& key = route.bestKeys_ref()->back();
+        key.node_ref() = node;
+        key.area_ref() = area;
+      }
+      // Set best node-area
+      route.bestKey_ref()->node_ref() = bestRoutes.bestNodeArea.first;
+      route.bestKey_ref()->area_ref() = bestRoutes.bestNodeArea.second;
+    }
+  }
+}
+
 folly::SemiFuture<folly::Unit>
 Decision::setRibPolicy(thrift::RibPolicy const& ribPolicyThrift) {
   auto [p, sf] = folly::makePromiseContract<folly::Unit>();
@@ -1628,14 +3337,22 @@ Decision::setRibPolicy(thrift::RibPolicy const& ribPolicyThrift) {
         // Update local policy instance
         LOG(INFO) << "Updating RibPolicy with new instance. Validity "
                   << durationLeft.count() << "ms";
-        ribPolicy_ = std::move(ribPolicy);
+        auto oldPolicy = std::exchange(ribPolicy_, std::move(ribPolicy));
 
         // Schedule timer for processing routes on expiry
         ribPolicyTimer_->scheduleTimeout(durationLeft);
 
-        // Trigger route computation
-        pendingUpdates_.setNeedsFullRebuild();
-        rebuildRoutes("RIB_POLICY_UPDATE");
+        if (coldStartTimer_->isScheduled() or asyncRouteBuildRunning_) {
+          // Routes are yet to be built, or are being built maybe without
+          // policy. Trigger route computation
+          pendingUpdates_.setNeedsFullRebuild();
+          rebuildRoutes("RIB_POLICY_UPDATE");
+        } else {
+          // Effects of an expired policy have been reverted already
+          applyRibPolicyChange(
+              oldPolicy and oldPolicy->isActive() ? oldPolicy.get() : nullptr,
+              ribPolicy_.get());
+        }
 
         // Mark the policy update request to be done
         p.setValue();
@@ -1643,6 +3360,86 @@ Decision::setRibPolicy(thrift::RibPolicy const& ribPolicyThrift) {
   return std::move(sf);
 }
 
+folly::SemiFuture<folly::Unit>
+Decision::applyConfig(std::shared_ptr<const Config> config) {
+  auto [p, sf] = folly::makePromiseContract<folly::Unit>();
+  runInEventBaseThread([this, p = std::move(p), config]() mutable {
+    setDebounceFromConfig(*config);
+    fb303::fbData->setCounter("decision.config_version", config->getVersion());
+    p.setValue();
+  });
+  return std::move(sf);
+}
+
+folly::SemiFuture<folly::Unit>
+Decision::setMemoryPressure(MemoryPressure level) {
+  auto [p, sf] = folly::makePromiseContract<folly::Unit>();
+  runInEventBaseThread([this, p = std::move(p), level]() mutable {
+    memoryPressure_ = level;
+    evictMemoizedResults();
+    p.setValue();
+  });
+  return std::move(sf);
+}
+
+void
+Decision::setDebounceFromConfig(const Config& config) {
+  auto const& decisionConfig = config.getDecisionConfig();
+  const auto minDur = decisionConfig.debounce_min_ms_ref()
+      ? std::chrono::milliseconds(*decisionConfig.debounce_min_ms_ref())
+      : defaultDebounceMinDur_;
+  const auto maxDur = decisionConfig.debounce_max_ms_ref()
+      ? std::chrono::milliseconds(*decisionConfig.debounce_max_ms_ref())
+      : defaultDebounceMaxDur_;
+  LOG(INFO) << "Debouncing route rebuilds between " << minDur.count()
+            << "ms and " << std::max(minDur, maxDur).count() << "ms";
+  rebuildRoutesDebounced_.setBackoff(minDur, std::max(minDur, maxDur));
+  if (adaptiveRebuildRoutesDebounced_) {
+    adaptiveRebuildRoutesDebounced_->setBackoff(
+        minDur, std::max(minDur, maxDur));
+  }
+}
+
+void
+Decision::debounceRebuildRoutes() {
+  if (adaptiveRebuildRoutesDebounced_) {
+    (*adaptiveRebuildRoutesDebounced_)();
+  } else {
+    rebuildRoutesDebounced_();
+  }
+}
+
+void
+Decision::rebuildRoutesOnDebounce() {
+  if (adaptiveRebuildRoutesDebounced_) {
+    fb303::fbData->setCounter(
+        "decision.debounce.wait_ms",
+        adaptiveRebuildRoutesDebounced_->getLastWait().count());
+    fb303::fbData->setCounter(
+        "decision.debounce.arrival_interval_ms",
+        adaptiveRebuildRoutesDebounced_->getArrivalInterval().count());
+  }
+
+  const auto startTime = std::chrono::steady_clock::now();
+  rebuildRoutes("DECISION_DEBOUNCE");
+  // an async build reports its duration once finished
+  if (not coldStartTimer_->isScheduled() and not asyncRouteBuildRunning_) {
+    reportRouteRebuildDuration(startTime);
+  }
+}
+
+void
+Decision::reportRouteRebuildDuration(
+    std::chrono::steady_clock::time_point startTime) {
+  if (not adaptiveRebuildRoutesDebounced_) {
+    return;
+  }
+  const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  adaptiveRebuildRoutesDebounced_->reportCallbackDuration(duration);
+  fb303::fbData->setCounter("decision.debounce.rebuild_ms", duration.count());
+}
+
 folly::SemiFuture<thrift::RibPolicy>
 Decision::getRibPolicy() {
   auto [p, sf] = folly::makePromiseContract<thrift::RibPolicy>();
@@ -1665,57 +3462,72 @@ Decision::getRibPolicy() {
   return std::move(sf);
 }
 
-std::optional<thrift::PrefixDatabase>
+std::optional<std::unordered_set<folly::CIDRNetwork>>
 Decision::updateNodePrefixDatabase(
-    const std::string& key, const thrift::PrefixDatabase& prefixDb) {
+    const KvStoreKeyView& keyView,
+    const thrift::PrefixDatabase& prefixDb,
+    const std::string& area) {
   auto const& nodeName = *prefixDb.thisNodeName_ref();
-
-  auto prefixKey = PrefixKey::fromStr(key);
-  // per prefix key
-  if (prefixKey.hasValue()) {
+  auto const nodeAndArea = std::make_pair(nodeName, area);
+
+  auto maybePrefix = keyView.getPrefixNetwork();
+  // per prefix key, apply as single prefix change
+  if (maybePrefix.has_value()) {
+    auto const& prefix = maybePrefix.value();
+    auto const ipPrefix = toIpPrefix(prefix);
+    auto& perPrefixEntries = perPrefixPrefixEntries_[nodeName];
     if (*prefixDb.deletePrefix_ref()) {
-      perPrefixPrefixEntries_[nodeName].erase(prefixKey.value().getIpPrefix());
-    } else {
-      CHECK_EQ(1, prefixDb.prefixEntries_ref()->size());
-      auto prefixEntry = prefixDb.prefixEntries_ref()->at(0);
-
-      // Ignore self redistributed route reflection
-      // These routes are programmed by Decision,
-      // re-origintaed by me to areas that do not have the best prefix entry
-      if (nodeName == myNodeName_ && prefixEntry.area_stack_ref()->size() > 0 &&
-          areaLinkStates_.count(prefixEntry.area_stack_ref()->back())) {
-        LOG(INFO) << "Ignore self redistributed route reflection for prefix: "
-                  << key << " area_stack: "
-                  << folly::join(",", *prefixEntry.area_stack_ref());
-        return std::nullopt;
+      perPrefixEntries.erase(ipPrefix);
+      // fall back to the entry of the full prefix database if any
+      auto const& fullDbEntries = fullDbPrefixEntries_[nodeName];
+      auto it = fullDbEntries.find(ipPrefix);
+      if (it != fullDbEntries.end()) {
+        return prefixState_.updatePrefix(nodeAndArea, prefix, it->second);
       }
-
-      perPrefixPrefixEntries_[nodeName][prefixKey.value().getIpPrefix()] =
-          prefixEntry;
+      return prefixState_.deletePrefix(nodeAndArea, prefix);
     }
-  } else {
-    // TODO: deprecate non per-prefix-key logic
-    //       fullDbPrefixEntries_ can be retired
-    fullDbPrefixEntries_[nodeName].clear();
-    for (auto const& entry : *prefixDb.prefixEntries_ref()) {
-      fullDbPrefixEntries_[nodeName][*entry.prefix_ref()] = entry;
+
+    CHECK_EQ(1, prefixDb.prefixEntries_ref()->size());
+    auto const& prefixEntry = prefixDb.prefixEntries_ref()->at(0);
+
+    // Ignore self redistributed route reflection
+    // These routes are programmed by Decision,
+    // re-origintaed by me to areas that do not have the best prefix entry
+    if (nodeName == myNodeName_ && prefixEntry.area_stack_ref()->size() > 0 &&
+        areaLinkStates_.count(prefixEntry.area_stack_ref()->back())) {
+      LOG(INFO) << "Ignore self redistributed route reflection for prefix: "
+                << keyView.prefix << " area_stack: "
+                << folly::join(",", *prefixEntry.area_stack_ref());
+      return std::nullopt;
     }
+
+    perPrefixEntries[ipPrefix] = prefixEntry;
+    return prefixState_.updatePrefix(nodeAndArea, prefix, prefixEntry);
   }
 
+  // TODO: deprecate non per-prefix-key logic
+  //       fullDbPrefixEntries_ can be retired
+  auto& fullDbEntries = fullDbPrefixEntries_[nodeName];
+  fullDbEntries.clear();
+  for (auto const& entry : *prefixDb.prefixEntries_ref()) {
+    fullDbEntries[*entry.prefix_ref()] = entry;
+  }
+
+  auto const& perPrefixEntries = perPrefixPrefixEntries_[nodeName];
   thrift::PrefixDatabase nodePrefixDb;
   *nodePrefixDb.thisNodeName_ref() = nodeName;
-  nodePrefixDb.perfEvents_ref().copy_from(prefixDb.perfEvents_ref());
+  *nodePrefixDb.area_ref() = area;
   nodePrefixDb.prefixEntries_ref()->reserve(
-      perPrefixPrefixEntries_[nodeName].size());
-  for (auto& kv : perPrefixPrefixEntries_[nodeName]) {
+      perPrefixEntries.size() + fullDbEntries.size());
+  for (auto& kv : perPrefixEntries) {
     nodePrefixDb.prefixEntries_ref()->emplace_back(kv.second);
   }
-  for (auto& kv : fullDbPrefixEntries_[nodeName]) {
-    if (not perPrefixPrefixEntries_[nodeName].count(kv.first)) {
+  for (auto& kv : fullDbEntries) {
+    if (not perPrefixEntries.count(kv.first)) {
       nodePrefixDb.prefixEntries_ref()->emplace_back(kv.second);
     }
   }
-  return nodePrefixDb;
+  return prefixState_.updatePrefixDatabase(nodePrefixDb);
 }
 
 void
@@ -1724,9 +3536,15 @@ Decision::processPublication(thrift::Publication const& thriftPub) {
   auto const& area = *thriftPub.area_ref();
 
   if (!areaLinkStates_.count(area)) {
-    areaLinkStates_.emplace(area, area);
+    areaLinkStates_.emplace(
+        area,
+        LinkState(
+            area,
+            config_->isIncrementalSpfEnabled(),
+            config_->getMemoizedResultsMaxBytes()));
   }
   auto& areaLinkState = areaLinkStates_.at(area);
+  auto& appliedValueHashes = appliedValueHashes_[area];
 
   // Nothing to process if no adj/prefix db changes
   if (thriftPub.keyVals_ref()->empty() and
@@ -1744,69 +3562,115 @@ Decision::processPublication(thrift::Publication const& thriftPub) {
 
     // parse nodeName from keys:
     //  1) prefix:*
-    //  2) adj:*
+    //  2) adj:*, adjdelta:*
     //  3) fibtime:*
-    const std::string nodeName = getNodeNameFromKey(key);
+    auto const keyView = parseKvStoreKey(key);
+    if (keyView.type == KvStoreKeyType::OTHER or
+        keyView.type == KvStoreKeyType::PREFIX_ALLOC) {
+      continue;
+    }
+
+    // skip decoding values already applied, e.g. received again on full-sync.
+    // Hashing is much cheaper than decoding. The hash carried in the value
+    // is not used as publishers may leave it unset (0)
+    const int64_t valueHash = generateHash(
+        *rawVal.version_ref(), *rawVal.originatorId_ref(), rawVal.value_ref());
+    auto [hashIt, isNewKey] = appliedValueHashes.emplace(key, valueHash);
+    if (not isNewKey) {
+      if (hashIt->second == valueHash) {
+        fb303::fbData->addStatValue(
+            "decision.skipped_unchanged_decode", 1, fb303::COUNT);
+        continue;
+      }
+      hashIt->second = valueHash;
+    }
+
+    const std::string nodeName(keyView.nodeName);
 
     try {
+      std::string uncompressedBuf;
+      auto const& value = getUncompressedValue(rawVal, uncompressedBuf);
+
       // adjacencyDb: update keys starting with "adj:"
-      if (key.find(Constants::kAdjDbMarker.toString()) == 0) {
+      if (keyView.type == KvStoreKeyType::ADJ_DB) {
         auto adjacencyDb =
             fbzmq::util::readThriftObjStr<thrift::AdjacencyDatabase>(
-                rawVal.value_ref().value(), serializer_);
+                value, serializer_);
         CHECK_EQ(nodeName, *adjacencyDb.thisNodeName_ref());
 
         // TODO - this should directly come from KvStore.
         adjacencyDb.area_ref() = area;
 
-        LinkStateMetric holdUpTtl = 0, holdDownTtl = 0;
-        if (config_->getConfig().enable_ordered_fib_programming_ref().value_or(
-                false)) {
-          if (auto maybeHoldUpTtl =
-                  areaLinkState.getHopsFromAToB(myNodeName_, nodeName)) {
-            holdUpTtl = maybeHoldUpTtl.value();
-            holdDownTtl = areaLinkState.getMaxHopsToNode(nodeName) - holdUpTtl;
+        if (adjacencyDb.snapshotId_ref().has_value()) {
+          // Deltas may arrive ahead of their snapshot
+          adjDbSnapshots_[area][nodeName] = adjacencyDb;
+          auto const& deltas = adjDbDeltas_[area];
+          auto deltaIt = deltas.find(nodeName);
+          if (deltaIt != deltas.end() and
+              *deltaIt->second.baseSnapshotId_ref() ==
+                  *adjacencyDb.snapshotId_ref()) {
+            adjacencyDb = applyAdjDbDelta(adjacencyDb, deltaIt->second);
           }
+        } else {
+          adjDbSnapshots_[area].erase(nodeName);
         }
-        fb303::fbData->addStatValue("decision.adj_db_update", 1, fb303::COUNT);
-        pendingUpdates_.applyLinkStateChange(
-            nodeName,
-            areaLinkState.updateAdjacencyDatabase(
-                adjacencyDb, holdUpTtl, holdDownTtl),
-            castToStd(adjacencyDb.perfEvents_ref()));
-        if (areaLinkState.hasHolds() && orderedFibTimer_ != nullptr &&
-            !orderedFibTimer_->isScheduled()) {
-          orderedFibTimer_->scheduleTimeout(getMaxFib());
+        processAdjacencyDatabase(area, adjacencyDb);
+        continue;
+      }
+
+      // adjacencyDb delta: update keys starting with "adjdelta:"
+      if (keyView.type == KvStoreKeyType::ADJ_DB_DELTA) {
+        auto delta =
+            fbzmq::util::readThriftObjStr<thrift::AdjacencyDatabaseDelta>(
+                value, serializer_);
+        CHECK_EQ(nodeName, *delta.thisNodeName_ref());
+
+        auto const& snapshots = adjDbSnapshots_[area];
+        auto snapshotIt = snapshots.find(nodeName);
+        bool const baseFound = snapshotIt != snapshots.end() and
+            *snapshotIt->second.snapshotId_ref() ==
+                *delta.baseSnapshotId_ref();
+        if (baseFound) {
+          fb303::fbData->addStatValue(
+              "decision.adj_db_delta_update", 1, fb303::COUNT);
+          processAdjacencyDatabase(
+              area, applyAdjDbDelta(snapshotIt->second, delta));
+        } else {
+          // wait for the snapshot, or ignore stale deltas of a previous one
+          fb303::fbData->addStatValue(
+              "decision.adj_db_delta_without_base", 1, fb303::COUNT);
         }
+        adjDbDeltas_[area][nodeName] = std::move(delta);
         continue;
       }
 
       // prefixDb: update keys starting with "prefix:"
-      if (key.find(Constants::kPrefixDbMarker.toString()) == 0) {
+      if (keyView.type == KvStoreKeyType::PREFIX_DB) {
         auto prefixDb = fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
-            rawVal.value_ref().value(), serializer_);
+            value, serializer_);
         CHECK_EQ(nodeName, *prefixDb.thisNodeName_ref());
+        prefixDbsChanged_ = true;
+        ++numDbUpdates_;
 
-        auto maybeNodePrefixDb = updateNodePrefixDatabase(key, prefixDb);
-        if (not maybeNodePrefixDb.has_value()) {
+        // TODO - area should directly come from KvStore.
+        auto maybeChanged = updateNodePrefixDatabase(keyView, prefixDb, area);
+        if (not maybeChanged.has_value()) {
           continue;
         }
-        auto nodePrefixDb = maybeNodePrefixDb.value();
-        // TODO - this should directly come from KvStore.
-        *nodePrefixDb.area_ref() = area;
 
         fb303::fbData->addStatValue(
             "decision.prefix_db_update", 1, fb303::COUNT);
+        addPrefixChanges(area, nodeName, maybeChanged.value());
         pendingUpdates_.applyPrefixStateChange(
-            prefixState_.updatePrefixDatabase(nodePrefixDb)),
-            castToStd(nodePrefixDb.perfEvents_ref());
+            std::move(maybeChanged.value()),
+            castToStd(prefixDb.perfEvents_ref()));
         continue;
       }
 
       // update keys starting with "fibTime:"
-      if (key.find(Constants::kFibTimeMarker.toString()) == 0) {
+      if (keyView.type == KvStoreKeyType::FIB_TIME) {
         try {
-          std::chrono::milliseconds fibTime{stoll(rawVal.value_ref().value())};
+          std::chrono::milliseconds fibTime{stoll(value)};
           fibTimes_[nodeName] = fibTime;
         } catch (...) {
           LOG(ERROR) << "Could not convert "
@@ -1818,15 +3682,27 @@ Decision::processPublication(thrift::Publication const& thriftPub) {
     } catch (const std::exception& e) {
       LOG(ERROR) << "Failed to deserialize info for key " << key
                  << ". Exception: " << folly::exceptionStr(e);
+      appliedValueHashes.erase(key);
     }
   }
 
   // LSDB deletion
   for (const auto& key : *thriftPub.expiredKeys_ref()) {
-    std::string nodeName = getNodeNameFromKey(key);
+    auto const keyView = parseKvStoreKey(key);
+    const std::string nodeName(keyView.nodeName);
+    appliedValueHashes.erase(key);
 
     // adjacencyDb: delete keys starting with "adj:"
-    if (key.find(Constants::kAdjDbMarker.toString()) == 0) {
+    if (keyView.type == KvStoreKeyType::ADJ_DB) {
+      adjDbSnapshots_[area].erase(nodeName);
+      auto const& adjDbs = areaLinkState.getAdjacencyDatabases();
+      auto adjDbIt = adjDbs.find(nodeName);
+      if (adjDbIt != adjDbs.end()) {
+        addAdjacencyChanges(area, nodeName, &adjDbIt->second, nullptr);
+      }
+      maybeSnapshotLinkState(area);
+      adjDbsChanged_ = true;
+      ++numDbUpdates_;
       pendingUpdates_.applyLinkStateChange(
           nodeName,
           areaLinkState.deleteAdjacencyDatabase(nodeName),
@@ -1834,25 +3710,262 @@ Decision::processPublication(thrift::Publication const& thriftPub) {
       continue;
     }
 
+    // adjacencyDb delta: delete keys starting with "adjdelta:", fall back to
+    // the plain snapshot
+    if (keyView.type == KvStoreKeyType::ADJ_DB_DELTA) {
+      adjDbDeltas_[area].erase(nodeName);
+      auto const& snapshots = adjDbSnapshots_[area];
+      auto snapshotIt = snapshots.find(nodeName);
+      if (snapshotIt != snapshots.end()) {
+        processAdjacencyDatabase(area, snapshotIt->second);
+      }
+      continue;
+    }
+
     // prefixDb: delete keys starting with "prefix:"
-    if (key.find(Constants::kPrefixDbMarker.toString()) == 0) {
+    if (keyView.type == KvStoreKeyType::PREFIX_DB) {
+      prefixDbsChanged_ = true;
+      ++numDbUpdates_;
+
       // manually build delete prefix db to signal delete just as a client would
       thrift::PrefixDatabase deletePrefixDb;
       *deletePrefixDb.thisNodeName_ref() = nodeName;
       deletePrefixDb.deletePrefix_ref() = true;
 
-      auto maybeNodePrefixDb = updateNodePrefixDatabase(key, deletePrefixDb);
-      if (not maybeNodePrefixDb.has_value()) {
+      auto maybeChanged =
+          updateNodePrefixDatabase(keyView, deletePrefixDb, area);
+      if (not maybeChanged.has_value()) {
+        continue;
+      }
+      addPrefixChanges(area, nodeName, maybeChanged.value());
+      pendingUpdates_.applyPrefixStateChange(std::move(maybeChanged.value()));
+      continue;
+    }
+  }
+
+  if (linkStateUpdatesQueue_ and
+      not pendingLinkStateDelta_.changes_ref()->empty()) {
+    linkStateUpdatesQueue_->push(std::move(pendingLinkStateDelta_));
+    pendingLinkStateDelta_ = thrift::LinkStateDelta();
+  }
+}
+
+void
+Decision::addAdjacencyChanges(
+    std::string const& area,
+    std::string const& nodeName,
+    thrift::AdjacencyDatabase const* oldDb,
+    thrift::AdjacencyDatabase const* newDb) {
+  if (not linkStateUpdatesQueue_) {
+    return;
+  }
+  auto& changes = *pendingLinkStateDelta_.changes_ref();
+
+  // adjacencies are identified by neighbor and interface
+  auto const adjKey = [](thrift::Adjacency const& adj) {
+    return std::make_pair(*adj.otherNodeName_ref(), *adj.ifName_ref());
+  };
+  std::unordered_map<
+      std::pair<std::string, std::string>,
+      thrift::Adjacency const*>
+      oldAdjs;
+  if (oldDb) {
+    for (auto const& adj : *oldDb->adjacencies_ref()) {
+      oldAdjs.emplace(adjKey(adj), &adj);
+    }
+  }
+  if (newDb) {
+    for (auto const& adj : *newDb->adjacencies_ref()) {
+      auto type = thrift::LinkStateChangeType::ADJACENCY_UP;
+      auto it = oldAdjs.find(adjKey(adj));
+      if (it != oldAdjs.end()) {
+        bool const isSame = isSameAdjacency(*it->second, adj);
+        oldAdjs.erase(it);
+        if (isSame) {
+          continue;
+        }
+        type = thrift::LinkStateChangeType::ADJACENCY_CHANGED;
+      }
+      auto change = createLinkStateChange(type, area, nodeName);
+      change.adjacency_ref() = adj;
+      changes.emplace_back(std::move(change));
+    }
+  }
+  if (oldDb) {
+    // remaining ones are down, in order of the database
+    for (auto const& adj : *oldDb->adjacencies_ref()) {
+      if (not oldAdjs.count(adjKey(adj))) {
         continue;
       }
-      auto nodePrefixDb = maybeNodePrefixDb.value();
-      // TODO - this should directly come from KvStore.
-      *nodePrefixDb.area_ref() = area;
+      auto change = createLinkStateChange(
+          thrift::LinkStateChangeType::ADJACENCY_DOWN, area, nodeName);
+      change.adjacency_ref() = adj;
+      changes.emplace_back(std::move(change));
+    }
+  }
+
+  bool const wasOverloaded = oldDb and *oldDb->isOverloaded_ref();
+  if (newDb and *newDb->isOverloaded_ref() != wasOverloaded) {
+    auto change = createLinkStateChange(
+        thrift::LinkStateChangeType::NODE_OVERLOAD, area, nodeName);
+    change.isOverloaded_ref() = *newDb->isOverloaded_ref();
+    changes.emplace_back(std::move(change));
+  }
+}
+
+void
+Decision::addPrefixChanges(
+    std::string const& area,
+    std::string const& nodeName,
+    std::unordered_set<folly::CIDRNetwork> const& prefixes) {
+  if (not linkStateUpdatesQueue_) {
+    return;
+  }
+  auto const nodeAndArea = std::make_pair(nodeName, area);
+  for (auto const& prefix : prefixes) {
+    thrift::PrefixEntry const* entry{nullptr};
+    auto it = prefixState_.prefixes().find(prefix);
+    if (it != prefixState_.prefixes().end()) {
+      auto entryIt = it->second.find(nodeAndArea);
+      if (entryIt != it->second.end()) {
+        entry = &entryIt->second;
+      }
+    }
+    auto change = createLinkStateChange(
+        entry ? thrift::LinkStateChangeType::PREFIX_ADDED
+              : thrift::LinkStateChangeType::PREFIX_REMOVED,
+        area,
+        nodeName);
+    change.prefix_ref() = toIpPrefix(prefix);
+    if (entry) {
+      change.prefixEntry_ref() = *entry;
+    }
+    pendingLinkStateDelta_.changes_ref()->emplace_back(std::move(change));
+  }
+}
+
+void
+Decision::processAdjacencyDatabase(
+    std::string const& area, thrift::AdjacencyDatabase const& adjacencyDb) {
+  auto& areaLinkState = areaLinkStates_.at(area);
+  auto const& nodeName = *adjacencyDb.thisNodeName_ref();
+
+  LinkStateMetric holdUpTtl = 0, holdDownTtl = 0;
+  if (config_->getConfig().enable_ordered_fib_programming_ref().value_or(
+          false)) {
+    if (auto maybeHoldUpTtl =
+            areaLinkState.getHopsFromAToB(myNodeName_, nodeName)) {
+      holdUpTtl = maybeHoldUpTtl.value();
+      holdDownTtl = areaLinkState.getMaxHopsToNode(nodeName) - holdUpTtl;
+    }
+  }
+  fb303::fbData->addStatValue("decision.adj_db_update", 1, fb303::COUNT);
+  auto const& adjDbs = areaLinkState.getAdjacencyDatabases();
+  auto adjDbIt = adjDbs.find(nodeName);
+  addAdjacencyChanges(
+      area,
+      nodeName,
+      adjDbIt != adjDbs.end() ? &adjDbIt->second : nullptr,
+      &adjacencyDb);
+  maybeSnapshotLinkState(area);
+  adjDbsChanged_ = true;
+  ++numDbUpdates_;
+  pendingUpdates_.applyLinkStateChange(
+      nodeName,
+      areaLinkState.updateAdjacencyDatabase(
+          adjacencyDb, holdUpTtl, holdDownTtl),
+      castToStd(adjacencyDb.perfEvents_ref()));
+  if (areaLinkState.hasHolds() && orderedFibTimer_ != nullptr &&
+      !orderedFibTimer_->isScheduled()) {
+    orderedFibTimer_->scheduleTimeout(getMaxFib());
+  }
+}
+
+void
+Decision::warmStartFromSnapshot(thrift::WarmRestartConfig const& warmConfig) {
+  auto snapshot = readKvStoreSnapshot(
+      *warmConfig.snapshot_file_path_ref(),
+      std::chrono::seconds(*warmConfig.max_snapshot_age_s_ref()));
+  if (not snapshot.has_value()) {
+    return;
+  }
 
-      pendingUpdates_.applyPrefixStateChange(
-          prefixState_.updatePrefixDatabase(nodePrefixDb));
+  size_t numKeys{0};
+  auto const& areaIds = config_->getAreaIds();
+  for (auto& [area, keyVals] : *snapshot->areaKeyVals_ref()) {
+    // skip areas no longer configured
+    if (not areaIds.count(area)) {
       continue;
     }
+    auto& staleKeys = staleKeys_[area];
+    for (auto const& [key, _] : keyVals) {
+      staleKeys.emplace(key);
+    }
+    numKeys += keyVals.size();
+
+    thrift::Publication thriftPub;
+    thriftPub.area_ref() = area;
+    thriftPub.keyVals_ref() = std::move(keyVals);
+    processPublication(thriftPub);
+  }
+  fb303::fbData->setCounter("decision.warm_start.num_keys", numKeys);
+  if (numKeys == 0) {
+    staleKeys_.clear();
+    return;
+  }
+
+  LOG(INFO) << "Warm starting from " << numKeys << " snapshot keys of "
+            << staleKeys_.size() << " areas";
+
+  // routes of the preloaded state are published without waiting for EOR
+  coldStartTimer_->cancelTimeout();
+  getEvb()->runInEventBaseThread([this]() noexcept {
+    pendingUpdates_.setNeedsFullRebuild();
+    rebuildRoutes("WARM_START_UPDATE");
+  });
+
+  staleKeysTimer_ = folly::AsyncTimeout::make(
+      *getEvb(), [this]() noexcept { expireStaleKeys(); });
+  staleKeysTimer_->scheduleTimeout(
+      std::chrono::seconds(*warmConfig.stale_time_s_ref()));
+}
+
+void
+Decision::refreshStaleKeys(thrift::Publication const& thriftPub) {
+  if (staleKeys_.empty()) {
+    return;
+  }
+  auto areaIt = staleKeys_.find(*thriftPub.area_ref());
+  if (areaIt == staleKeys_.end()) {
+    return;
+  }
+  for (auto const& [key, _] : *thriftPub.keyVals_ref()) {
+    areaIt->second.erase(key);
+  }
+  for (auto const& key : *thriftPub.expiredKeys_ref()) {
+    areaIt->second.erase(key);
+  }
+  if (areaIt->second.empty()) {
+    staleKeys_.erase(areaIt);
+  }
+}
+
+void
+Decision::expireStaleKeys() {
+  size_t numKeys{0};
+  for (auto& [area, keys] : staleKeys_) {
+    thrift::Publication thriftPub;
+    thriftPub.area_ref() = area;
+    thriftPub.expiredKeys_ref()->assign(keys.begin(), keys.end());
+    numKeys += keys.size();
+    processPublication(thriftPub);
+  }
+  staleKeys_.clear();
+
+  LOG(INFO) << "Expired " << numKeys << " stale snapshot keys";
+  fb303::fbData->setCounter("decision.warm_start.num_stale_keys", numKeys);
+  if (pendingUpdates_.needsRouteUpdate()) {
+    debounceRebuildRoutes();
   }
 }
 
@@ -1875,60 +3988,450 @@ Decision::rebuildRoutes(std::string const& event) {
     }
   }
 
+  if (asyncRouteBuildRunning_) {
+    // newer topology makes the running build stale, restart it unless it
+    // got restarted too often in a row already
+    if (pendingUpdates_.needsFullRebuild() and
+        asyncRouteBuildPreemptions_ <
+            Constants::kDecisionMaxRouteBuildPreemptions) {
+      asyncRouteBuildPreempted_ = true;
+    }
+    return;
+  }
+
+  const auto startTime = std::chrono::steady_clock::now();
+  const auto spfStatsBefore = getSpfStats(areaLinkStates_);
+  thrift::RouteBuildProfile profile;
+
+  if (pendingUpdates_.needsFullRebuild() and not ribPolicy_ and
+      config_->isPriorityRouteUpdateEnabled()) {
+    publishPriorityRouteUpdate();
+  }
+
+  // try to narrow down a topology-only full rebuild to affected prefixes
+  std::optional<std::unordered_set<folly::CIDRNetwork>> affectedPrefixes;
+  if (pendingUpdates_.onlyTopologyChanged() and not routeEngine_) {
+    affectedPrefixes = getPrefixesAffectedByTopologyChange();
+    fb303::fbData->addStatValue(
+        affectedPrefixes ? "decision.topology_impact_rebuilds"
+                         : "decision.topology_impact_fallbacks",
+        1,
+        fb303::COUNT);
+  }
+  linkStateSnapshots_.clear();
+
+  if (routeBuildWorker_ and not routeEngine_ and
+      pendingUpdates_.needsFullRebuild() and not affectedPrefixes) {
+    startAsyncRouteBuild();
+    return;
+  }
+
   DecisionRouteUpdate update;
-  if (pendingUpdates_.needsFullRebuild()) {
-    // if only static routes gets updated, we still need to update routes
-    // because there maybe routes depended on static routes.
-    auto maybeRouteDb =
-        spfSolver_->buildRouteDb(myNodeName_, areaLinkStates_, prefixState_);
+  if (pendingUpdates_.needsFullRebuild() and not affectedPrefixes and
+      not ribPolicy_ and not routeEngine_) {
+    // diff against the current routes while building, unchanged routes are
+    // never collected
+    auto maybeUpdate = spfSolver_->buildRouteDbDelta(
+        myNodeName_, areaLinkStates_, prefixState_, routeDb_);
+    setRouteBuildStats(profile, spfSolver_->getLastRouteBuildStats());
+    LOG_IF(WARNING, !maybeUpdate)
+        << "SEVERE: full route rebuild resulted in no routes";
+    update = maybeUpdate ? std::move(maybeUpdate).value()
+                         : routeDb_.calculateUpdate(DecisionRouteDb{});
+  } else if (pendingUpdates_.needsFullRebuild() and not affectedPrefixes) {
+    // RibPolicy may change routes after they are built, diff the whole db
+    auto maybeRouteDb = buildRouteDb(profile);
     LOG_IF(WARNING, !maybeRouteDb)
         << "SEVERE: full route rebuild resulted in no routes";
     auto db = std::move(maybeRouteDb).value_or(DecisionRouteDb{});
     if (ribPolicy_) {
-      auto start = std::chrono::steady_clock::now();
-      ribPolicy_->applyPolicy(db.unicastRoutes);
-      updateCounters(
-          "decision.rib_policy_processing.time_ms",
-          start,
-          std::chrono::steady_clock::now());
+      const auto ribPolicyStartTime = std::chrono::steady_clock::now();
+      applyRibPolicy(db.unicastRoutes, true /* allRoutes */);
+      *profile.ribPolicyUs_ref() = getElapsedUs(ribPolicyStartTime);
     }
+    const auto diffStartTime = std::chrono::steady_clock::now();
     update = routeDb_.calculateUpdate(std::move(db));
+    *profile.diffUs_ref() = getElapsedUs(diffStartTime);
   } else {
-    for (auto const& prefix : pendingUpdates_.updatedPrefixes()) {
-      if (auto maybeRibEntry = spfSolver_->createRouteForPrefix(
-              myNodeName_, areaLinkStates_, prefixState_, prefix)) {
+    // static routes don't depend on SPF, only they and the routes resolved
+    // through them are updated
+    std::unordered_set<folly::CIDRNetwork> staticRoutePrefixes;
+    if (not pendingUpdates_.updatedStaticLabels().empty()) {
+      staticRoutePrefixes = getPrefixesViaChangedStaticRoutes();
+      if (not affectedPrefixes) {
+        const auto mplsStartTime = std::chrono::steady_clock::now();
+        addStaticMplsRoutesChange(update);
+        *profile.mplsRoutesUs_ref() = getElapsedUs(mplsStartTime);
+      }
+    }
+    if (affectedPrefixes) {
+      // node label routes are only built again for changed nodes, static
+      // routes are included
+      affectedPrefixes->insert(
+          pendingUpdates_.updatedPrefixes().begin(),
+          pendingUpdates_.updatedPrefixes().end());
+      const auto mplsStartTime = std::chrono::steady_clock::now();
+      routeDb_.calculateMplsUpdate(
+          spfSolver_->buildMplsRouteDb(myNodeName_, areaLinkStates_)
+              .mplsRoutes,
+          update);
+      *profile.mplsRoutesUs_ref() = getElapsedUs(mplsStartTime);
+    }
+    auto const& prefixesToRebuild = affectedPrefixes
+        ? *affectedPrefixes
+        : pendingUpdates_.updatedPrefixes();
+    const auto unicastStartTime = std::chrono::steady_clock::now();
+    auto rebuildPrefix = [&](folly::CIDRNetwork const& prefix) {
+      if (auto maybeRibEntry = createRouteForPrefix(prefix)) {
         update.addRouteToUpdate(std::move(maybeRibEntry).value());
       } else {
-        update.unicastRoutesToDelete.emplace_back(toIPNetwork(prefix));
+        update.unicastRoutesToDelete.emplace_back(prefix);
       }
+    };
+    for (auto const& prefix : prefixesToRebuild) {
+      rebuildPrefix(prefix);
     }
+    size_t numPrefixes = prefixesToRebuild.size();
+    for (auto const& prefix : staticRoutePrefixes) {
+      if (not prefixesToRebuild.count(prefix)) {
+        rebuildPrefix(prefix);
+        ++numPrefixes;
+      }
+    }
+    *profile.numPrefixes_ref() = numPrefixes;
+    *profile.unicastRoutesUs_ref() = getElapsedUs(unicastStartTime);
     if (ribPolicy_) {
-      auto start = std::chrono::steady_clock::now();
+      const auto ribPolicyStartTime = std::chrono::steady_clock::now();
       auto const changes =
-          ribPolicy_->applyPolicy(update.unicastRoutesToUpdate);
-      updateCounters(
-          "decision.rib_policy_processing.time_ms",
-          start,
-          std::chrono::steady_clock::now());
+          applyRibPolicy(update.unicastRoutesToUpdate, false /* allRoutes */);
       for (auto const& prefix : changes.deletedRoutes) {
         update.unicastRoutesToDelete.push_back(prefix);
       }
+      *profile.ribPolicyUs_ref() = getElapsedUs(ribPolicyStartTime);
     }
   }
 
-  routeDb_.update(update);
-  pendingUpdates_.addEvent("ROUTE_UPDATE");
-  update.perfEvents = pendingUpdates_.moveOutEvents();
+  addSpfStats(profile, spfStatsBefore, getSpfStats(areaLinkStates_));
+  addRouteBuildProfile(std::move(profile), startTime, update);
+  publishRouteUpdate(std::move(update), pendingUpdates_.moveOutEvents());
+  pendingUpdates_.reset();
+}
+
+void
+Decision::publishPriorityRouteUpdate() {
+  // interfaces of this node with an up adjacency, in any area
+  std::unordered_set<std::string> upIfaces;
+  for (auto const& [_, linkState] : areaLinkStates_) {
+    for (auto const& link : linkState.linksFromNode(myNodeName_)) {
+      if (link->isUp()) {
+        upIfaces.emplace(link->getIfaceFromNode(myNodeName_));
+      }
+    }
+  }
+
+  DecisionRouteUpdate update;
+  update.isPriority = true;
+  for (auto const& [prefix, route] : routeDb_.unicastRoutes) {
+    const bool lostNextHop = std::any_of(
+        route.nexthops.begin(),
+        route.nexthops.end(),
+        [&upIfaces](thrift::NextHopThrift const& nextHop) {
+          auto const& ifName = nextHop.address_ref()->ifName_ref();
+          return ifName and not upIfaces.count(*ifName);
+        });
+    if (not lostNextHop) {
+      continue;
+    }
+    if (auto maybeRibEntry = createRouteForPrefix(prefix)) {
+      update.addRouteToUpdate(std::move(maybeRibEntry).value());
+    } else {
+      update.unicastRoutesToDelete.emplace_back(prefix);
+    }
+  }
+  if (update.empty()) {
+    return;
+  }
+
+  const auto numRoutes =
+      update.unicastRoutesToUpdate.size() + update.unicastRoutesToDelete.size();
+  LOG(INFO) << "Publishing priority update of " << numRoutes
+            << " routes which lost next-hops";
+  fb303::fbData->addStatValue(
+      "decision.priority_route_updates", 1, fb303::COUNT);
+  fb303::fbData->addStatValue(
+      "decision.priority_route_entries", numRoutes, fb303::SUM);
+  // perf events stay with the update of the whole rebuild
+  publishRouteUpdate(std::move(update), std::nullopt);
+}
+
+std::optional<DecisionRouteDb>
+Decision::buildRouteDb(thrift::RouteBuildProfile& profile) {
+  if (not routeEngine_) {
+    auto maybeRouteDb =
+        spfSolver_->buildRouteDb(myNodeName_, areaLinkStates_, prefixState_);
+    setRouteBuildStats(profile, spfSolver_->getLastRouteBuildStats());
+    return maybeRouteDb;
+  }
+
+  const auto startTime = std::chrono::steady_clock::now();
+  auto maybeRouteDb =
+      routeEngine_->buildRouteDb(myNodeName_, areaLinkStates_, prefixState_);
+  *profile.fullRebuild_ref() = true;
+  *profile.unicastRoutesUs_ref() = getElapsedUs(startTime);
+  if (maybeRouteDb) {
+    for (auto const& [topLabel, nhs] : spfSolver_->getStaticRoutes()) {
+      maybeRouteDb->mplsRoutes.insert_or_assign(
+          topLabel,
+          RibMplsEntry(
+              topLabel,
+              std::unordered_set<thrift::NextHopThrift>{
+                  nhs.begin(), nhs.end()}));
+    }
+  }
+  return maybeRouteDb;
+}
+
+std::optional<RibUnicastEntry>
+Decision::createRouteForPrefix(folly::CIDRNetwork const& prefix) {
+  if (routeEngine_) {
+    return routeEngine_->createRouteForPrefix(
+        myNodeName_, areaLinkStates_, prefixState_, prefix);
+  }
+  return spfSolver_->createRouteForPrefix(
+      myNodeName_, areaLinkStates_, prefixState_, prefix);
+}
+
+void
+Decision::startAsyncRouteBuild() {
+  CHECK(not asyncRouteBuildRunning_);
+  asyncRouteBuildRunning_ = true;
+  asyncRouteBuildPreempted_ = false;
+  if (asyncRouteBuildPreemptions_ == 0) {
+    asyncRouteBuildStartTime_ = std::chrono::steady_clock::now();
+  }
+  fb303::fbData->addStatValue("decision.async_route_builds", 1, fb303::COUNT);
+
+  // keep perf events of a preempted build, they are the older ones
+  auto perfEvents = pendingUpdates_.moveOutEvents();
+  if (not asyncRouteBuildPerfEvents_) {
+    asyncRouteBuildPerfEvents_ = std::move(perfEvents);
+  }
   pendingUpdates_.reset();
 
+  routeBuildWorker_->add([this,
+                          token = std::weak_ptr<folly::Unit>(
+                              asyncRouteBuildToken_),
+                          areaLinkStates = areaLinkStates_,
+                          prefixState = prefixState_,
+                          staticRoutesDeltas =
+                              std::move(asyncStaticRoutesBacklog_),
+                          withRibPolicy = ribPolicy_ != nullptr]() mutable {
+    for (auto& staticRoutesDelta : staticRoutesDeltas) {
+      asyncSpfSolver_->updateStaticRoutes(std::move(staticRoutesDelta));
+    }
+
+    AsyncRouteBuildResult result;
+    const auto spfStatsBefore = getSpfStats(areaLinkStates);
+    if (withRibPolicy) {
+      result.routeDb = asyncSpfSolver_->buildRouteDb(
+          myNodeName_, areaLinkStates, prefixState);
+    } else {
+      result.update = asyncSpfSolver_->buildRouteDbDelta(
+          myNodeName_, areaLinkStates, prefixState, routeDb_);
+    }
+    setRouteBuildStats(
+        result.profile, asyncSpfSolver_->getLastRouteBuildStats());
+    addSpfStats(result.profile, spfStatsBefore, getSpfStats(areaLinkStates));
+    *result.profile.asyncBuild_ref() = true;
+    result.bestRoutesCache = asyncSpfSolver_->getBestRoutesCache();
+
+    runInEventBaseThread(
+        [this, token = std::move(token), result = std::move(result)]() mutable {
+          if (token.lock()) {
+            finishAsyncRouteBuild(std::move(result));
+          }
+        });
+  });
+  asyncStaticRoutesBacklog_.clear();
+}
+
+void
+Decision::finishAsyncRouteBuild(AsyncRouteBuildResult&& result) {
+  asyncRouteBuildRunning_ = false;
+  if (asyncRouteBuildPreempted_) {
+    // result is partial, build again including the updates received since
+    ++asyncRouteBuildPreemptions_;
+    fb303::fbData->addStatValue(
+        "decision.async_route_build_preemptions", 1, fb303::COUNT);
+    pendingUpdates_.setNeedsFullRebuild();
+    rebuildRoutes("DECISION_ROUTE_BUILD_PREEMPTED");
+    return;
+  }
+  asyncRouteBuildPreemptions_ = 0;
+  reportRouteRebuildDuration(asyncRouteBuildStartTime_);
+
+  DecisionRouteUpdate update;
+  auto& profile = result.profile;
+  if (result.routeDb or not result.update) {
+    LOG_IF(WARNING, !result.routeDb and !result.update)
+        << "SEVERE: full route rebuild resulted in no routes";
+    auto db = std::move(result.routeDb).value_or(DecisionRouteDb{});
+    if (ribPolicy_) {
+      const auto ribPolicyStartTime = std::chrono::steady_clock::now();
+      applyRibPolicy(db.unicastRoutes, true /* allRoutes */);
+      *profile.ribPolicyUs_ref() = getElapsedUs(ribPolicyStartTime);
+    }
+    const auto diffStartTime = std::chrono::steady_clock::now();
+    update = routeDb_.calculateUpdate(std::move(db));
+    *profile.diffUs_ref() = getElapsedUs(diffStartTime);
+  } else {
+    update = std::move(result.update).value();
+  }
+  spfSolver_->setBestRoutesCache(std::move(result.bestRoutesCache));
+  addRouteBuildProfile(
+      std::move(profile), asyncRouteBuildStartTime_, update);
+
+  publishRouteUpdate(std::move(update), std::move(asyncRouteBuildPerfEvents_));
+  asyncRouteBuildPerfEvents_ = std::nullopt;
+
+  // routes for updates received during the build
+  if (pendingUpdates_.needsRouteUpdate()) {
+    debounceRebuildRoutes();
+  }
+}
+
+RibPolicy::PolicyChange
+Decision::applyRibPolicy(
+    std::unordered_map<folly::CIDRNetwork, RibUnicastEntry>& routes,
+    bool allRoutes) {
+  CHECK(ribPolicy_);
+  if (allRoutes) {
+    prePolicyRoutes_.clear();
+  } else {
+    for (auto const& [prefix, _] : routes) {
+      prePolicyRoutes_.erase(prefix);
+    }
+  }
+  auto start = std::chrono::steady_clock::now();
+  auto change = ribPolicy_->applyPolicy(routes, &prePolicyRoutes_);
+  updateCounters(
+      "decision.rib_policy_processing.time_ms",
+      start,
+      std::chrono::steady_clock::now());
+  return change;
+}
+
+void
+Decision::applyRibPolicyChange(
+    const RibPolicy* oldPolicy, const RibPolicy* newPolicy) {
+  // routes as built, of prefixes the policies transform differently
+  std::unordered_map<folly::CIDRNetwork, RibUnicastEntry> affectedRoutes;
+  for (auto const& [prefix, route] : routeDb_.unicastRoutes) {
+    if (not RibPolicy::isRouteAffected(oldPolicy, newPolicy, route)) {
+      continue;
+    }
+    auto it = prePolicyRoutes_.find(prefix);
+    if (it == prePolicyRoutes_.end()) {
+      affectedRoutes.emplace(prefix, route);
+    } else {
+      affectedRoutes.emplace(prefix, std::move(it->second));
+      prePolicyRoutes_.erase(it);
+    }
+  }
+  fb303::fbData->addStatValue(
+      "decision.rib_policy.affected_routes", affectedRoutes.size(), fb303::SUM);
+  if (newPolicy) {
+    applyRibPolicy(affectedRoutes, false /* allRoutes */);
+  }
+
+  DecisionRouteUpdate update;
+  for (auto& [prefix, route] : affectedRoutes) {
+    if (route != routeDb_.unicastRoutes.at(prefix)) {
+      update.addRouteToUpdate(std::move(route));
+    }
+  }
+  LOG(INFO) << "RibPolicy change affects " << affectedRoutes.size()
+            << " routes, " << update.unicastRoutesToUpdate.size()
+            << " of them changed";
+  if (not update.empty()) {
+    publishRouteUpdate(std::move(update), std::nullopt);
+  }
+}
+
+void
+Decision::addRouteBuildProfile(
+    thrift::RouteBuildProfile&& profile,
+    std::chrono::steady_clock::time_point startTime,
+    DecisionRouteUpdate const& update) {
+  *profile.unixTs_ref() = getUnixTimeStampMs();
+  *profile.totalUs_ref() = getElapsedUs(startTime);
+  *profile.numUnicastRoutesToUpdate_ref() = update.unicastRoutesToUpdate.size();
+  *profile.numUnicastRoutesToDelete_ref() = update.unicastRoutesToDelete.size();
+  *profile.numMplsRoutesToUpdate_ref() = update.mplsRoutesToUpdate.size();
+  *profile.numMplsRoutesToDelete_ref() = update.mplsRoutesToDelete.size();
+
+  for (auto const& [key, value] : std::vector<std::pair<std::string, int64_t>>{
+           {"decision.route_build.total_us", *profile.totalUs_ref()},
+           {"decision.route_build.spf_us", *profile.spfUs_ref()},
+           {"decision.route_build.unicast_routes_us",
+            *profile.unicastRoutesUs_ref()},
+           {"decision.route_build.mpls_routes_us",
+            *profile.mplsRoutesUs_ref()},
+           {"decision.route_build.rib_policy_us", *profile.ribPolicyUs_ref()},
+           {"decision.route_build.diff_us", *profile.diffUs_ref()},
+           {"decision.route_build.prefixes", *profile.numPrefixes_ref()},
+           {"decision.route_build.unicast_routes_to_update",
+            *profile.numUnicastRoutesToUpdate_ref()},
+           {"decision.route_build.unicast_routes_to_delete",
+            *profile.numUnicastRoutesToDelete_ref()},
+       }) {
+    fb303::fbData->addStatValue(key, value, fb303::AVG);
+  }
+  fb303::fbData->addStatValue(
+      "decision.route_build.spf_cache_hits",
+      *profile.spfCacheHits_ref(),
+      fb303::SUM);
+  fb303::fbData->addStatValue(
+      "decision.route_build.spf_cache_misses",
+      *profile.spfCacheMisses_ref(),
+      fb303::SUM);
+
+  routeBuildProfiles_.push_back(std::move(profile));
+  while (routeBuildProfiles_.size() >
+         Constants::kDecisionMaxRouteBuildProfiles) {
+    routeBuildProfiles_.pop_front();
+  }
+}
+
+void
+Decision::publishRouteUpdate(
+    DecisionRouteUpdate&& update,
+    std::optional<thrift::PerfEvents>&& perfEvents) {
+  for (auto const& prefix : update.unicastRoutesToDelete) {
+    prePolicyRoutes_.erase(prefix);
+  }
+  routeDb_.update(update);
+  evictMemoizedResults();
+  if (perfEvents) {
+    addPerfEvent(*perfEvents, myNodeName_, "ROUTE_UPDATE");
+  }
+  update.perfEvents = std::move(perfEvents);
+
   routeUpdatesQueue_.push(std::move(update));
+
+  // databases the routes got built from are read by ctrl queries
+  updateReadSnapshot();
 }
 
 bool
 Decision::decrementOrderedFibHolds() {
   bool topoChanged = false;
   bool stillHasHolds = false;
-  for (auto& [_, linkState] : areaLinkStates_) {
+  for (auto& [area, linkState] : areaLinkStates_) {
+    if (not linkState.hasHolds()) {
+      continue;
+    }
+    maybeSnapshotLinkState(area);
     pendingUpdates_.applyLinkStateChange(
         myNodeName_, linkState.decrementHolds());
     stillHasHolds |= linkState.hasHolds();
@@ -1939,6 +4442,92 @@ Decision::decrementOrderedFibHolds() {
   return stillHasHolds;
 }
 
+void
+Decision::maybeSnapshotLinkState(std::string const& area) {
+  if (not config_->isTopologyImpactAnalysisEnabled() or
+      linkStateSnapshots_.count(area)) {
+    return;
+  }
+  linkStateSnapshots_.emplace(
+      area, detail::LinkStateSnapshot(areaLinkStates_.at(area), myNodeName_));
+}
+
+std::optional<std::unordered_set<folly::CIDRNetwork>>
+Decision::getPrefixesAffectedByTopologyChange() const {
+  // LFA and KSP2_ED_ECMP routes depend on more than our own shortest paths
+  if (not config_->isTopologyImpactAnalysisEnabled() or computeLfaPaths_ or
+      config_->isLfaBackupEnabled() or prefixState_.hasKsp2PrefixEntries()) {
+    return std::nullopt;
+  }
+
+  std::unordered_set<folly::CIDRNetwork> affectedPrefixes;
+  for (auto const& [area, snapshot] : linkStateSnapshots_) {
+    auto const changedNodes =
+        snapshot.getChangedNodes(areaLinkStates_.at(area), myNodeName_);
+    if (not changedNodes) {
+      return std::nullopt;
+    }
+    for (auto const& node : *changedNodes) {
+      auto const& prefixes = prefixState_.getNodePrefixes({node, area});
+      affectedPrefixes.insert(prefixes.begin(), prefixes.end());
+    }
+  }
+  return affectedPrefixes;
+}
+
+void
+Decision::addStaticMplsRoutesChange(DecisionRouteUpdate& update) const {
+  auto const& staticRoutes = spfSolver_->getStaticRoutes();
+  for (auto const label : pendingUpdates_.updatedStaticLabels()) {
+    auto const routeIt = routeDb_.mplsRoutes.find(label);
+    auto const staticIt = staticRoutes.find(label);
+    if (staticIt == staticRoutes.end()) {
+      if (routeIt != routeDb_.mplsRoutes.end()) {
+        update.mplsRoutesToDelete.emplace_back(label);
+      }
+      continue;
+    }
+    RibMplsEntry entry(
+        label,
+        std::unordered_set<thrift::NextHopThrift>{
+            staticIt->second.begin(), staticIt->second.end()});
+    if (routeIt == routeDb_.mplsRoutes.end() or not(routeIt->second == entry)) {
+      update.mplsRoutesToUpdate.emplace_back(std::move(entry));
+    }
+  }
+}
+
+std::unordered_set<folly::CIDRNetwork>
+Decision::getPrefixesViaChangedStaticRoutes() const {
+  // routes of prefixes we advertise with a prepend label get the next-hops of
+  // its static route added
+  auto const& labels = pendingUpdates_.updatedStaticLabels();
+  std::unordered_set<folly::CIDRNetwork> prefixes;
+  for (auto const& [area, _] : areaLinkStates_) {
+    NodeAndArea const nodeAndArea{myNodeName_, area};
+    for (auto const& prefix : prefixState_.getNodePrefixes(nodeAndArea)) {
+      auto const& prefixEntry =
+          prefixState_.prefixes().at(prefix).at(nodeAndArea);
+      auto const& prependLabel = prefixEntry.prependLabel_ref();
+      if (prependLabel and labels.count(*prependLabel)) {
+        prefixes.emplace(prefix);
+      }
+    }
+  }
+  return prefixes;
+}
+
+void
+Decision::evictMemoizedResults() const {
+  for (auto const& [_, linkState] : areaLinkStates_) {
+    if (memoryPressure_ != MemoryPressure::NONE) {
+      linkState.clearMemoizedResults();
+    } else {
+      linkState.evictMemoizedResults();
+    }
+  }
+}
+
 std::chrono::milliseconds
 Decision::getMaxFib() {
   std::chrono::milliseconds maxFib{1};
@@ -1962,48 +4551,75 @@ Decision::updateCounters(
 
 void
 Decision::updateGlobalCounters() const {
-  size_t numAdjacencies = 0, numPartialAdjacencies = 0;
-  std::unordered_set<std::string> nodeSet;
-  for (auto const& [_, linkState] : areaLinkStates_) {
-    numAdjacencies += linkState.numLinks();
-    auto const& mySpfResult = linkState.getSpfResult(myNodeName_);
-    for (auto const& kv : linkState.getAdjacencyDatabases()) {
-      nodeSet.insert(kv.first);
-      const auto& adjDb = kv.second;
-      size_t numLinks = linkState.linksFromNode(kv.first).size();
-      // Consider partial adjacency only iff node is reachable from current node
-      if (mySpfResult.count(*adjDb.thisNodeName_ref()) && 0 != numLinks) {
-        // only add to the count if this node is not completely disconnected
-        size_t diff = adjDb.adjacencies_ref()->size() - numLinks;
-        // Number of links (bi-directional) must be <= number of adjacencies
-        CHECK_GE(diff, 0);
-        numPartialAdjacencies += diff;
-      }
-    }
-  }
-
-  size_t numConflictingPrefixes{0};
-  for (const auto& [prefix, prefixEntries] : prefixState_.prefixes()) {
-    if (not PrefixState::hasConflictingForwardingInfo(prefixEntries)) {
-      continue;
+  const auto version =
+      std::make_pair(numDbUpdates_, pendingUpdates_.getGeneration());
+  if (stateCounters_.version != version) {
+    StateCounters counters;
+    counters.version = version;
+    std::unordered_set<std::string> nodeSet;
+    for (auto const& [_, linkState] : areaLinkStates_) {
+      counters.numAdjacencies += linkState.numLinks();
+      counters.linkStateBytes += linkState.getLinkStateBytes();
+      auto const& mySpfResult = linkState.getSpfResult(myNodeName_);
+      for (auto const& kv : linkState.getAdjacencyDatabases()) {
+        nodeSet.insert(kv.first);
+        const auto& adjDb = kv.second;
+        size_t numLinks = linkState.linksFromNode(kv.first).size();
+        // Consider partial adjacency only iff node is reachable from current
+        // node
+        if (mySpfResult.count(*adjDb.thisNodeName_ref()) && 0 != numLinks) {
+          // only add to the count if this node is not completely disconnected
+          size_t diff = adjDb.adjacencies_ref()->size() - numLinks;
+          // Number of links (bi-directional) must be <= number of adjacencies
+          CHECK_GE(diff, 0);
+          counters.numPartialAdjacencies += diff;
+        }
+      }
     }
-    LOG(WARNING) << "Prefix " << toString(prefix) << " has conflicting "
+    counters.numNodes = nodeSet.size();
+    counters.prefixStateBytes = prefixState_.getPrefixesBytes();
+    stateCounters_ = std::move(counters);
+  }
+
+  size_t numKthPaths = 0, kthPathsBytes = 0;
+  size_t numSpfResults = 0, spfResultsBytes = 0;
+  for (auto const& [_, linkState] : areaLinkStates_) {
+    numKthPaths += linkState.getKthPathsCacheSize();
+    kthPathsBytes += linkState.getKthPathsCacheBytes();
+    numSpfResults += linkState.getSpfCacheSize();
+    spfResultsBytes += linkState.getSpfCacheBytes();
+  }
+
+  auto const& conflictingPrefixes = prefixState_.getConflictingPrefixes();
+  for (auto const& prefix : conflictingPrefixes) {
+    LOG(WARNING) << "Prefix " << folly::IPAddress::networkToString(prefix)
+                 << " has conflicting "
                  << "forwarding algorithm or type.";
-    numConflictingPrefixes += 1;
   }
 
   // Add custom counters
   fb303::fbData->setCounter(
-      "decision.num_conflicting_prefixes", numConflictingPrefixes);
+      "decision.num_conflicting_prefixes", conflictingPrefixes.size());
   fb303::fbData->setCounter(
-      "decision.num_partial_adjacencies", numPartialAdjacencies);
+      "decision.num_partial_adjacencies", stateCounters_.numPartialAdjacencies);
   fb303::fbData->setCounter(
-      "decision.num_complete_adjacencies", numAdjacencies);
+      "decision.num_complete_adjacencies", stateCounters_.numAdjacencies);
   // When node has no adjacencies then linkState reports 0
   fb303::fbData->setCounter(
-      "decision.num_nodes", std::max(nodeSet.size(), static_cast<size_t>(1ul)));
+      "decision.num_nodes",
+      std::max(stateCounters_.numNodes, static_cast<size_t>(1ul)));
   fb303::fbData->setCounter(
       "decision.num_prefixes", prefixState_.prefixes().size());
+  fb303::fbData->setCounter("decision.kth_paths_cache_size", numKthPaths);
+  fb303::fbData->setCounter("decision.kth_paths_cache_bytes", kthPathsBytes);
+  fb303::fbData->setCounter("decision.spf_cache_size", numSpfResults);
+  fb303::fbData->setCounter("decision.spf_cache_bytes", spfResultsBytes);
+  fb303::fbData->setCounter(
+      "decision.link_state_bytes", stateCounters_.linkStateBytes);
+  fb303::fbData->setCounter(
+      "decision.prefix_state_bytes", stateCounters_.prefixStateBytes);
+  fb303::fbData->setCounter(
+      "decision.num_nexthop_groups", NextHopSet::numGroups());
 }
 
 } // namespace openr
@@ -7,7 +7,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <optional>
 #include <string>
 #include <unordered_map>
 
@@ -15,14 +20,18 @@
 #include <folly/IPAddress.h>
 #include <folly/Memory.h>
 #include <folly/String.h>
+#include <folly/Synchronized.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/AsyncTimeout.h>
 #include <thrift/lib/cpp2/Thrift.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
+#include <openr/common/AdaptiveDebounce.h>
 #include <openr/common/AsyncDebounce.h>
 #include <openr/common/AsyncThrottle.h>
 #include <openr/common/OpenrEventBase.h>
+#include <openr/common/Types.h>
 #include <openr/common/Util.h>
 #include <openr/config/Config.h>
 #include <openr/decision/LinkState.h>
@@ -42,6 +51,8 @@
 
 namespace openr {
 
+class RouteComputationEngine;
+
 using StaticMplsRoutes =
     std::unordered_map<int32_t, std::vector<thrift::NextHopThrift>>;
 
@@ -63,6 +74,10 @@ struct BestRouteSelectionResult {
   // for re-distributing across areas.
   NodeAndArea bestNodeArea;
 
+  // Hash of the inputs the selection was made from. A later route build for
+  // the prefix reuses the selection if they hash the same
+  size_t inputsHash{0};
+
   /**
    * Function to check if provide node is one of the best node
    */
@@ -88,6 +103,11 @@ class DecisionRouteDb {
   // some way before calling update with it
   DecisionRouteUpdate calculateUpdate(DecisionRouteDb&& newDb) const;
 
+  // append the delta between mplsRoutes and newMplsRoutes to delta
+  void calculateMplsUpdate(
+      std::unordered_map<int32_t, RibMplsEntry> const& newMplsRoutes,
+      DecisionRouteUpdate& delta) const;
+
   // update the state of this with the DecisionRouteUpdate passed
   void update(DecisionRouteUpdate const& update);
 
@@ -135,6 +155,8 @@ class DecisionPendingUpdates {
   void
   setNeedsFullRebuild() {
     needsFullRebuild_ = true;
+    onlyTopologyChanged_ = false;
+    ++generation_;
   }
 
   bool
@@ -142,25 +164,41 @@ class DecisionPendingUpdates {
     return needsFullRebuild_;
   }
 
+  // true if the full rebuild is only needed because of topology changes, in
+  // which case only routes via changed shortest paths may be affected
+  bool
+  onlyTopologyChanged() const {
+    return needsFullRebuild_ and onlyTopologyChanged_;
+  }
+
   bool
   needsRouteUpdate() const {
-    return needsFullRebuild() || !updatedPrefixes_.empty();
+    return needsFullRebuild() || !updatedPrefixes_.empty() ||
+        !updatedStaticLabels_.empty();
   }
 
-  std::unordered_set<thrift::IpPrefix> const&
+  std::unordered_set<folly::CIDRNetwork> const&
   updatedPrefixes() const {
     return updatedPrefixes_;
   }
 
+  // top labels of static MPLS routes changed in this batch
+  std::unordered_set<int32_t> const&
+  updatedStaticLabels() const {
+    return updatedStaticLabels_;
+  }
+
   void applyLinkStateChange(
       std::string const& nodeName,
       LinkState::LinkStateChange const& change,
       std::optional<thrift::PerfEvents> const& perfEvents = std::nullopt);
 
   void applyPrefixStateChange(
-      std::unordered_set<thrift::IpPrefix>&& change,
+      std::unordered_set<folly::CIDRNetwork>&& change,
       std::optional<thrift::PerfEvents> const& perfEvents = std::nullopt);
 
+  void applyStaticRoutesChange(std::unordered_set<int32_t>&& labels);
+
   void reset();
 
   void addEvent(std::string const& eventDescription);
@@ -177,9 +215,18 @@ class DecisionPendingUpdates {
     return count_;
   }
 
+  // bumped on every change that may affect routes, not cleared by reset()
+  uint64_t
+  getGeneration() const {
+    return generation_;
+  }
+
  private:
   void addUpdate(const std::optional<thrift::PerfEvents>& perfEvents);
 
+  // see getGeneration()
+  uint64_t generation_{0};
+
   // tracks how many updates are part of this batch
   uint32_t count_{0};
 
@@ -189,15 +236,89 @@ class DecisionPendingUpdates {
   // set if we need to rebuild all routes
   bool needsFullRebuild_{false};
 
+  // set if needsFullRebuild_ was only caused by topology changes
+  bool onlyTopologyChanged_{false};
+
   // track prefixes that have changed in this batch
-  std::unordered_set<thrift::IpPrefix> updatedPrefixes_;
+  std::unordered_set<folly::CIDRNetwork> updatedPrefixes_;
+
+  // track static MPLS routes that have changed in this batch
+  std::unordered_set<int32_t> updatedStaticLabels_;
 
   // local node name to determine action on linkAttributes change
   std::string myNodeName_;
 };
 
+/**
+ * Shortest paths of a node in an area before a batch of topology changes.
+ * Compared against the LinkState after the batch to find the destinations
+ * whose routes may have changed.
+ */
+struct LinkStateSnapshot {
+  LinkStateSnapshot(LinkState const& linkState, std::string const& myNodeName);
+
+  // Returns the nodes whose shortest path metric or next-hops from myNodeName
+  // changed, or whose overload bit toggled. Returns std::nullopt if any of the
+  // local links changed, since that may affect routes to every destination.
+  std::optional<std::unordered_set<std::string>> getChangedNodes(
+      LinkState const& linkState, std::string const& myNodeName) const;
+
+  // SPF result of myNodeName
+  LinkState::SpfResult spfResult;
+
+  // overloaded nodes among spfResult
+  std::unordered_set<std::string> overloadedNodes;
+
+  // metric of up links of myNodeName, keyed on neighbor and local interface
+  std::map<std::pair<std::string, std::string>, LinkStateMetric> localLinks;
+};
+
+/**
+ * Tracks the LinkStates routes of a node were last built from, to find the
+ * destinations whose routes may have changed since. Only areas whose
+ * LinkState generation moved on are compared again.
+ */
+class ChangedNodesTracker {
+ public:
+  struct Changes {
+    // any LinkState changed since the previous update()
+    bool changed{false};
+    // routes to every node may have changed, e.g. as an area was added or
+    // a link of myNodeName or the metric to a neighbor changed
+    bool allNodes{false};
+    // nodes whose shortest paths from myNodeName, overload bit or node label
+    // changed in any area, or that were added or removed. Empty if allNodes
+    std::unordered_set<std::string> nodes;
+  };
+
+  Changes update(
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      std::string const& myNodeName);
+
+ private:
+  struct AreaInputs {
+    uint64_t generation{0};
+    LinkStateSnapshot snapshot;
+    std::unordered_map<std::string /* node */, int32_t> nodeLabels;
+    // next-hops over up links of myNodeName, v6 and v4
+    std::unordered_set<thrift::NextHopThrift> localNextHops;
+  };
+
+  std::unordered_map<std::string /* area */, AreaInputs> areas_;
+};
+
 } // namespace detail
 
+// Phases of the last full route build of an SpfSolver. Times include the SPF
+// runs the phase triggers
+struct RouteBuildStats {
+  std::chrono::microseconds unicastRoutesTime{0};
+  std::chrono::microseconds mplsRoutesTime{0};
+  // diffing against the previous routes, only done by buildRouteDbDelta()
+  std::chrono::microseconds diffTime{0};
+  size_t numPrefixes{0};
+};
+
 // The class to compute shortest-paths using Dijkstra algorithm
 class SpfSolver {
  public:
@@ -209,7 +330,8 @@ class SpfSolver {
       bool computeLfaPaths,
       bool enableOrderedFib = false,
       bool bgpDryRun = false,
-      bool enableBestRouteSelection = false);
+      bool enableBestRouteSelection = false,
+      size_t routeBuildThreads = 1);
   ~SpfSolver();
 
   //
@@ -217,7 +339,9 @@ class SpfSolver {
   // be defined in the .cpp
   //
 
-  void updateStaticRoutes(thrift::RouteDatabaseDelta&& staticRoutesDelta);
+  // returns top labels of the static MPLS routes updated or deleted
+  std::unordered_set<int32_t> updateStaticRoutes(
+      thrift::RouteDatabaseDelta&& staticRoutesDelta);
 
   StaticMplsRoutes const& getStaticRoutes();
 
@@ -229,15 +353,56 @@ class SpfSolver {
       std::unordered_map<std::string, LinkState> const& areaLinkStates,
       PrefixState const& prefixState);
 
+  // Build only the MPLS routes of buildRouteDb() for a given router. For
+  // myNodeName of this SpfSolver, node label routes are kept across calls and
+  // only built again for nodes whose shortest paths or label changed
+  DecisionRouteDb buildMplsRouteDb(
+      const std::string& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates);
+
+  // Rebuild all routes for a given router and return what changed against
+  // routeDb. Cheaper than diffing a full buildRouteDb() result as unchanged
+  // routes are dropped while building
+  // Returns std::nullopt if myNodeName doesn't have any prefix database
+  std::optional<DecisionRouteUpdate> buildRouteDbDelta(
+      const std::string& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState,
+      DecisionRouteDb const& routeDb);
+
   std::optional<RibUnicastEntry> createRouteForPrefix(
       const std::string& myNodeName,
       std::unordered_map<std::string, LinkState> const& areaLinkStates,
       PrefixState const& prefixState,
-      thrift::IpPrefix const& prefix);
+      folly::CIDRNetwork const& prefix);
 
-  std::unordered_map<thrift::IpPrefix, BestRouteSelectionResult> const&
+  std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult> const&
   getBestRoutesCache() const;
 
+  // replace best route selection results, e.g. with the ones of a rebuild
+  // done by another SpfSolver
+  void setBestRoutesCache(
+      std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult>&&
+          bestRoutesCache);
+
+  // isPreempted is polled while building unicast routes, from route build
+  // threads too. Once it returns true the build stops early and its result
+  // is incomplete, callers are expected to discard it
+  void setPreemptionCheck(std::function<bool()> isPreempted);
+
+  // Also compute loop-free alternates of IP forwarded routes as backup
+  // next-hops, see RibUnicastEntry::backupNexthops. Has no effect if LFA
+  // paths are computed as regular next-hops already
+  void setComputeLfaBackups(bool computeLfaBackups);
+
+  // Weigh IP forwarded next-hops by capacity towards the destination, see
+  // SpfSolverImpl::applyUcmpWeights(). Has no effect if LFA paths are computed
+  // as regular next-hops
+  void setComputeUcmp(bool computeUcmp);
+
+  // phases of the last buildRouteDb() or buildRouteDbDelta()
+  RouteBuildStats const& getLastRouteBuildStats() const;
+
  private:
   // no-copy
   SpfSolver(SpfSolver const&) = delete;
@@ -273,11 +438,21 @@ class Decision : public OpenrEventBase {
       bool bgpDryRun,
       std::chrono::milliseconds debounceMinDur,
       std::chrono::milliseconds debounceMaxDur,
-      messaging::RQueue<thrift::Publication> kvStoreUpdatesQueue,
+      messaging::RQueue<PublicationPtr> kvStoreUpdatesQueue,
       messaging::RQueue<thrift::RouteDatabaseDelta> staticRoutesUpdateQueue,
-      messaging::ReplicateQueue<DecisionRouteUpdate>& routeUpdatesQueue);
+      messaging::ReplicateQueue<DecisionRouteUpdatePtr>& routeUpdatesQueue,
+      messaging::ReplicateQueue<thrift::LinkStateDelta>*
+          linkStateUpdatesQueue = nullptr,
+      std::unique_ptr<RouteComputationEngine> routeEngine = nullptr);
 
-  virtual ~Decision() = default;
+  ~Decision() override;
+
+  /*
+   * Reader of link state changes applied off KvStore publications, if a queue
+   * for them was given. See getLinkStateDatabases()
+   */
+  std::optional<messaging::RQueue<thrift::LinkStateDelta>>
+  getLinkStateUpdatesReader();
 
   /*
    * Retrieve routeDb from specified node.
@@ -286,13 +461,34 @@ class Decision : public OpenrEventBase {
   folly::SemiFuture<std::unique_ptr<thrift::RouteDatabase>> getDecisionRouteDb(
       std::string nodeName);
 
+  /*
+   * Retrieve routeDbs of the given nodes, of all nodes in the topology if none
+   * given. They are built on a worker of their own against a snapshot of the
+   * topology, and cached until it changes. SPF results are shared among them.
+   */
+  folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteDatabase>>>
+  getDecisionRouteDbs(std::vector<std::string> nodeNames);
+
+  /*
+   * Retrieve routeDbs of a node, of this node if empty nodeName, for each of
+   * the given scenarios. Every scenario is applied to a fork of the topology
+   * and built on a worker pool of its own, live state is not touched.
+   * Fails with thrift::OpenrError if a scenario refers to unknown nodes or
+   * links.
+   */
+  folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteDatabase>>>
+  getRouteDbsWhatIf(
+      std::string nodeName, std::vector<thrift::WhatIfScenario> scenarios);
+
   /**
    * Retrieve static routes from Decision
    */
   folly::SemiFuture<StaticMplsRoutes> getMplsStaticRoutes();
 
   /*
-   * Retrieve AdjacencyDatabase for kDefaultArea
+   * Retrieve AdjacencyDatabase for kDefaultArea. Like
+   * getAllDecisionAdjacencyDbs() and getDecisionPrefixDbs() it is served from
+   * a read snapshot, see getReadSnapshot().
    */
   folly::SemiFuture<std::unique_ptr<thrift::AdjDbs>> getDecisionAdjacencyDbs();
 
@@ -302,17 +498,46 @@ class Decision : public OpenrEventBase {
   folly::SemiFuture<std::unique_ptr<std::vector<thrift::AdjacencyDatabase>>>
   getAllDecisionAdjacencyDbs();
 
+  /*
+   * Retrieve profiles of the most recent route rebuilds, oldest first
+   */
+  folly::SemiFuture<std::unique_ptr<std::vector<thrift::RouteBuildProfile>>>
+  getRouteBuildProfiles();
+
   /*
    * Retrieve PrefixDatabase as a map.
    */
   folly::SemiFuture<std::unique_ptr<thrift::PrefixDbs>> getDecisionPrefixDbs();
 
+  /*
+   * Retrieve adjacency and prefix databases of all areas at once. Reflects at
+   * least all changes published to the link state updates queue before the
+   * call, so that a client reading the queue from then on misses none.
+   */
+  folly::SemiFuture<std::unique_ptr<thrift::LinkStateDatabases>>
+  getLinkStateDatabases();
+
+  /*
+   * Retrieve a page of PrefixDatabases in node name order, see
+   * thrift::PageParams.
+   */
+  folly::SemiFuture<std::unique_ptr<thrift::PrefixDbsPage>>
+  getDecisionPrefixDbsPage(thrift::PageParams page);
+
   /*
    * Retrieve received routes along with best route selection output.
    */
   folly::SemiFuture<std::unique_ptr<std::vector<thrift::ReceivedRouteDetail>>>
   getReceivedRoutesFiltered(thrift::ReceivedRouteFilter filter);
 
+  /*
+   * Retrieve a page of received routes in prefix order, see
+   * thrift::PageParams. Cursor is a prefix.
+   */
+  folly::SemiFuture<std::unique_ptr<thrift::ReceivedRoutesPage>>
+  getReceivedRoutesFilteredPage(
+      thrift::ReceivedRouteFilter filter, thrift::PageParams page);
+
   /*
    * Set new or replace existing RibPolicy. This will trigger the new policy
    * run against computed routes and delta will be published.
@@ -326,6 +551,19 @@ class Decision : public OpenrEventBase {
    */
   folly::SemiFuture<thrift::RibPolicy> getRibPolicy();
 
+  /**
+   * Apply runtime tunable knobs of a reloaded config, i.e. debounce of route
+   * rebuilds. Other settings keep their values from construction.
+   */
+  folly::SemiFuture<folly::Unit> applyConfig(
+      std::shared_ptr<const Config> config);
+
+  /**
+   * Memoized shortest paths are dropped after every route computation while
+   * under memory pressure instead of being capped.
+   */
+  folly::SemiFuture<folly::Unit> setMemoryPressure(MemoryPressure level);
+
   // periodically called by counterUpdateTimer_, exposed publicly for testing
   void updateGlobalCounters() const;
 
@@ -338,9 +576,31 @@ class Decision : public OpenrEventBase {
   Decision(Decision const&) = delete;
   Decision& operator=(Decision const&) = delete;
 
+  // set best route selection result on received routes
+  void setBestRouteKeys(std::vector<thrift::ReceivedRouteDetail>& routes) const;
+
   // process publication from KvStore
   void processPublication(thrift::Publication const& thriftPub);
 
+  // apply the (possibly delta-applied) adjacency database of a node
+  void processAdjacencyDatabase(
+      std::string const& area, thrift::AdjacencyDatabase const& adjacencyDb);
+
+  // record link state changes for linkStateUpdatesQueue_, of a node's
+  // adjacency database before it is replaced (nullptr if new or deleted)
+  void addAdjacencyChanges(
+      std::string const& area,
+      std::string const& nodeName,
+      thrift::AdjacencyDatabase const* oldDb,
+      thrift::AdjacencyDatabase const* newDb);
+
+  // record link state changes for linkStateUpdatesQueue_, of prefixes of a
+  // node changed in prefixState_
+  void addPrefixChanges(
+      std::string const& area,
+      std::string const& nodeName,
+      std::unordered_set<folly::CIDRNetwork> const& prefixes);
+
   // openr config
   std::shared_ptr<const Config> config_;
 
@@ -348,6 +608,25 @@ class Decision : public OpenrEventBase {
   // gracefulRestartDuration
   std::unique_ptr<folly::AsyncTimeout> coldStartTimer_{nullptr};
 
+  /**
+   * Warm restart: preload link-state and prefix-state from the KvStore
+   * snapshot of the previous run and compute routes right away instead of
+   * waiting for coldStartTimer_. Preloaded keys not re-learned from KvStore
+   * within stale_time_s are expired by staleKeysTimer_.
+   */
+  void warmStartFromSnapshot(thrift::WarmRestartConfig const& warmConfig);
+
+  // forget stale preloaded keys received again from KvStore
+  void refreshStaleKeys(thrift::Publication const& thriftPub);
+
+  // expire preloaded keys not received from KvStore since warm start
+  void expireStaleKeys();
+
+  std::unordered_map<std::string /* area */, std::unordered_set<std::string>>
+      staleKeys_;
+
+  std::unique_ptr<folly::AsyncTimeout> staleKeysTimer_{nullptr};
+
   /**
    * Rebuild all routes and send out update delta. Check current pendingUpdates_
    * to decide which routes need rebuilding, otherwise rebuild all. Use
@@ -356,29 +635,176 @@ class Decision : public OpenrEventBase {
    */
   void rebuildRoutes(std::string const& event);
 
+  // Result of a full route rebuild done on routeBuildWorker_
+  struct AsyncRouteBuildResult {
+    // routes diffed against routeDb_, if no RibPolicy was set
+    std::optional<DecisionRouteUpdate> update;
+    // all routes, if RibPolicy was set. It is applied on the event base
+    std::optional<DecisionRouteDb> routeDb;
+    std::unordered_map<folly::CIDRNetwork, BestRouteSelectionResult>
+        bestRoutesCache;
+    // phases of the build, completed on the event base
+    thrift::RouteBuildProfile profile;
+  };
+
+  // Rebuild all routes on routeBuildWorker_, against copies of
+  // areaLinkStates_ and prefixState_ taken now. Updates received meanwhile
+  // accumulate in pendingUpdates_
+  void startAsyncRouteBuild();
+
+  /**
+   * Recompute routes with a next-hop over a link of this node which is not up
+   * anymore and publish them as a priority update, ahead of the rebuild of
+   * all routes. routeDb_ is updated with them before the rebuild.
+   */
+  void publishPriorityRouteUpdate();
+
+  // Routes of this node from routeEngine_ if set, from spfSolver_ otherwise
+  std::optional<DecisionRouteDb> buildRouteDb(
+      thrift::RouteBuildProfile& profile);
+  std::optional<RibUnicastEntry> createRouteForPrefix(
+      folly::CIDRNetwork const& prefix);
+
+  // Publish routes of the finished async build, or start over if it was
+  // preempted by newer topology
+  void finishAsyncRouteBuild(AsyncRouteBuildResult&& result);
+
+  // Apply ribPolicy_ on routes, all routes of the db if allRoutes. Routes it
+  // transforms are kept in prePolicyRoutes_ as they were built
+  RibPolicy::PolicyChange applyRibPolicy(
+      std::unordered_map<folly::CIDRNetwork, RibUnicastEntry>& routes,
+      bool allRoutes);
+
+  /**
+   * Update routes of routeDb_ for change of policy in effect from oldPolicy to
+   * newPolicy, either of them nullptr if none. Only routes the policies
+   * transform differently are reapplied newPolicy on, starting from their
+   * routes as built, and only those changed are sent out.
+   */
+  void applyRibPolicyChange(
+      const RibPolicy* oldPolicy, const RibPolicy* newPolicy);
+
+  // Complete profile of a route rebuild started at startTime with update
+  // resulting from it, export its counters and keep it for
+  // getRouteBuildProfiles()
+  void addRouteBuildProfile(
+      thrift::RouteBuildProfile&& profile,
+      std::chrono::steady_clock::time_point startTime,
+      DecisionRouteUpdate const& update);
+
+  // profiles of the most recent route rebuilds, oldest first
+  std::deque<thrift::RouteBuildProfile> routeBuildProfiles_;
+
+  // apply update to routeDb_ and send it out with perfEvents
+  void publishRouteUpdate(
+      DecisionRouteUpdate&& update,
+      std::optional<thrift::PerfEvents>&& perfEvents);
+
   // decremnts holds and send any resulting output, returns true if any
   // linkstate has remaining holds
   bool decrementOrderedFibHolds();
 
+  // enforce the memory cap of memoized shortest paths in all areas, or drop
+  // them under memory pressure, to be called once done with the results of a
+  // route computation
+  void evictMemoizedResults() const;
+
+  // record shortest paths of the area before its first topology change in
+  // the current batch, if topology impact analysis is enabled
+  void maybeSnapshotLinkState(std::string const& area);
+
+  // Returns prefixes whose routes may be affected by the topology changes of
+  // the current batch, or std::nullopt if all routes need to be rebuilt
+  std::optional<std::unordered_set<folly::CIDRNetwork>>
+  getPrefixesAffectedByTopologyChange() const;
+
+  // append static MPLS routes changed in the current batch to update
+  void addStaticMplsRoutesChange(DecisionRouteUpdate& update) const;
+
+  // prefixes of this node whose routes resolve through static MPLS routes
+  // changed in the current batch
+  std::unordered_set<folly::CIDRNetwork> getPrefixesViaChangedStaticRoutes()
+      const;
+
   void sendRouteUpdate(
       DecisionRouteDb&& routeDb,
       std::optional<thrift::PerfEvents>&& perfEvents);
 
   std::chrono::milliseconds getMaxFib();
 
-  // node to prefix entries database for nodes advertising per prefix keys
-  std::optional<thrift::PrefixDatabase> updateNodePrefixDatabase(
-      const std::string& key, const thrift::PrefixDatabase& prefixDb);
+  // apply prefix key update of a node to prefixState_. Per prefix keys are
+  // applied as single prefix changes. Returns changed prefixes, or
+  // std::nullopt if the update is ignored
+  std::optional<std::unordered_set<folly::CIDRNetwork>>
+  updateNodePrefixDatabase(
+      const KvStoreKeyView& keyView,
+      const thrift::PrefixDatabase& prefixDb,
+      const std::string& area);
+
+  //
+  // Immutable copy of adjacency and prefix databases, read by ctrl queries
+  // from their own threads. It is replaced by the Decision thread after
+  // route rebuilds, or on a query when out of date. Queries of unchanged
+  // databases then neither copy them nor run on the Decision thread.
+  //
+
+  // parts are shared with the previous snapshot if unchanged
+  struct ReadSnapshot {
+    std::shared_ptr<const std::unordered_map<std::string, thrift::AdjDbs>>
+        areaAdjDbs;
+    std::shared_ptr<const thrift::PrefixDbs> prefixDbs;
+  };
+
+  // current snapshot, up to date unless databases changed since
+  folly::SemiFuture<std::shared_ptr<const ReadSnapshot>> getReadSnapshot();
+
+  // replace snapshot if databases changed since, on Decision thread only
+  std::shared_ptr<const ReadSnapshot> updateReadSnapshot();
+
+  folly::Synchronized<std::shared_ptr<const ReadSnapshot>> readSnapshot_;
+
+  // databases changed since readSnapshot_ was taken, set on Decision thread
+  std::atomic<bool> adjDbsChanged_{true};
+  std::atomic<bool> prefixDbsChanged_{true};
+
+  // bumped along with adjDbsChanged_ and prefixDbsChanged_, never cleared
+  uint64_t numDbUpdates_{0};
+
+  // Counters of updateGlobalCounters() derived from link and prefix state,
+  // recomputed only once databases or routes may have changed
+  struct StateCounters {
+    // numDbUpdates_ and pendingUpdates_ generation they were computed at
+    std::optional<std::pair<uint64_t, uint64_t>> version;
+    size_t numAdjacencies{0};
+    size_t numPartialAdjacencies{0};
+    size_t numNodes{0};
+    size_t linkStateBytes{0};
+    size_t prefixStateBytes{0};
+  };
+  mutable StateCounters stateCounters_;
+
+  // see setMemoryPressure()
+  MemoryPressure memoryPressure_{MemoryPressure::NONE};
 
   // cached routeDb
   DecisionRouteDb routeDb_;
 
   // Queue to publish route changes
-  messaging::ReplicateQueue<DecisionRouteUpdate>& routeUpdatesQueue_;
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr>& routeUpdatesQueue_;
+
+  // Queue to publish link state changes to, optional. Changes are collected
+  // in pendingLinkStateDelta_ and published once per KvStore publication
+  messaging::ReplicateQueue<thrift::LinkStateDelta>* linkStateUpdatesQueue_{
+      nullptr};
+  thrift::LinkStateDelta pendingLinkStateDelta_;
 
   // Pointer to RibPolicy
   std::unique_ptr<RibPolicy> ribPolicy_;
 
+  // Routes of routeDb_ transformed by ribPolicy_, as they were built. Lets a
+  // policy change be applied without rebuilding routes
+  std::unordered_map<folly::CIDRNetwork, RibUnicastEntry> prePolicyRoutes_;
+
   // Timer associated with RibPolicy. Triggered when ribPolicy is expired. This
   // aims to revert the policy effects on programmed routes.
   std::unique_ptr<folly::AsyncTimeout> ribPolicyTimer_;
@@ -386,9 +812,41 @@ class Decision : public OpenrEventBase {
   // the pointer to the SPF path calculator
   std::unique_ptr<SpfSolver> spfSolver_;
 
+  // computes routes of this node in place of spfSolver_ if set. spfSolver_
+  // still keeps static routes. Incremental and async full rebuilds, which
+  // are specific to SpfSolver, are not done with it
+  std::unique_ptr<RouteComputationEngine> routeEngine_;
+
   // per area link states
   std::unordered_map<std::string, LinkState> areaLinkStates_;
 
+  // per area adjacency database snapshots, and the latest deltas on top of
+  // them, of nodes announcing their adjacencies as deltas
+  std::unordered_map<
+      std::string,
+      std::unordered_map<std::string, thrift::AdjacencyDatabase>>
+      adjDbSnapshots_;
+  std::unordered_map<
+      std::string,
+      std::unordered_map<std::string, thrift::AdjacencyDatabaseDelta>>
+      adjDbDeltas_;
+
+  // per area hashes of the last applied values of keys, to skip decoding
+  // values with unchanged content
+  std::unordered_map<
+      std::string /* area */,
+      std::unordered_map<std::string /* key */, int64_t /* hash */>>
+      appliedValueHashes_;
+
+  // per area shortest paths before the topology changes of the current batch
+  std::unordered_map<std::string, detail::LinkStateSnapshot>
+      linkStateSnapshots_;
+
+  // whether LFA paths are computed, routes then depend on neighbor's SPF
+  const bool computeLfaPaths_{false};
+
+  const bool bgpDryRun_{false};
+
   // global prefix state
   PrefixState prefixState_;
 
@@ -428,6 +886,92 @@ class Decision : public OpenrEventBase {
    * queue and static routes update queue
    */
   AsyncDebounce<std::chrono::milliseconds> rebuildRoutesDebounced_;
+
+  // debounce bounds used unless set in decision_config
+  const std::chrono::milliseconds defaultDebounceMinDur_;
+  const std::chrono::milliseconds defaultDebounceMaxDur_;
+
+  /**
+   * Replaces rebuildRoutesDebounced_ if adaptive debounce is enabled, see
+   * isAdaptiveDebounceEnabled()
+   */
+  std::unique_ptr<AdaptiveDebounce<std::chrono::milliseconds>>
+      adaptiveRebuildRoutesDebounced_;
+
+  // set bounds of rebuildRoutesDebounced_ from decision_config of config
+  void setDebounceFromConfig(const Config& config);
+
+  // trigger rebuildRoutes through the debounce in use
+  void debounceRebuildRoutes();
+
+  // callback of the debounce
+  void rebuildRoutesOnDebounce();
+
+  // feed duration of a route rebuild started at startTime to adaptive debounce
+  void reportRouteRebuildDuration(
+      std::chrono::steady_clock::time_point startTime);
+
+  //
+  // Full route rebuilds off the event base, see isAsyncRouteBuildEnabled().
+  // While a build is running routeDb_ is read by routeBuildWorker_, so it is
+  // left untouched and every other rebuild waits for the running one
+  //
+
+  // SpfSolver used on routeBuildWorker_ only
+  std::unique_ptr<SpfSolver> asyncSpfSolver_;
+
+  // static routes updates not applied to asyncSpfSolver_ yet
+  std::vector<thrift::RouteDatabaseDelta> asyncStaticRoutesBacklog_;
+
+  // set while a build is running on routeBuildWorker_
+  bool asyncRouteBuildRunning_{false};
+
+  // asks the running build to stop early, polled by asyncSpfSolver_
+  std::atomic<bool> asyncRouteBuildPreempted_{false};
+
+  // consecutive preemptions, capped to not starve route updates under churn
+  size_t asyncRouteBuildPreemptions_{0};
+
+  // start of the running build, including builds it was preempted by
+  std::chrono::steady_clock::time_point asyncRouteBuildStartTime_;
+
+  // oldest perf events of the updates covered by the running build
+  std::optional<thrift::PerfEvents> asyncRouteBuildPerfEvents_;
+
+  // builds only call back if Decision is still alive
+  std::shared_ptr<folly::Unit> asyncRouteBuildToken_{
+      std::make_shared<folly::Unit>()};
+
+  // Declared last to be joined first on destruction, as builds refer to
+  // members above
+  std::unique_ptr<folly::CPUThreadPoolExecutor> routeBuildWorker_;
+
+  //
+  // RouteDbs of any node, see getDecisionRouteDbs(). Built on
+  // computedRoutesWorker_, which alone touches the snapshot once taken
+  //
+
+  struct ComputedRoutesSnapshot {
+    // pendingUpdates_ generation the snapshot was taken at
+    uint64_t generation{0};
+    std::unordered_map<std::string, LinkState> areaLinkStates;
+    PrefixState prefixState;
+    // routeDbs built so far, keyed on node name
+    std::unordered_map<std::string, thrift::RouteDatabase> routeDbs;
+  };
+
+  // snapshot of the latest generation asked for, if any
+  std::shared_ptr<ComputedRoutesSnapshot> computedRoutesSnapshot_;
+
+  // SpfSolver used on computedRoutesWorker_ only
+  std::unique_ptr<SpfSolver> computedRoutesSpfSolver_;
+
+  // joined before the members it refers to are destroyed
+  std::unique_ptr<folly::CPUThreadPoolExecutor> computedRoutesWorker_;
+
+  // builds routes of what-if scenarios, see getRouteDbsWhatIf(). Every build
+  // owns its fork of the topology, joined first like computedRoutesWorker_
+  std::unique_ptr<folly::CPUThreadPoolExecutor> whatIfWorkers_;
 };
 
 } // namespace openr
@@ -9,10 +9,17 @@
 
 #include <algorithm>
 #include <functional>
+#include <iterator>
+#include <queue>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
 
 #include <fb303/ServiceData.h>
 #include <folly/Format.h>
+#include <folly/hash/Hash.h>
+#include <openr/common/StatHandle.h>
 #include <openr/common/Util.h>
 
 namespace fb303 = facebook::fb303;
@@ -51,6 +58,22 @@ std::hash<openr::LinkState::LinkSet>::operator()(
 
 namespace openr {
 
+namespace {
+// local interface, neighbor and its interface of a link from a node
+using LinkKey =
+    std::tuple<std::string_view, std::string_view, std::string_view>;
+
+struct LinkKeyHash {
+  size_t
+  operator()(LinkKey const& key) const {
+    return folly::hash::hash_combine(
+        std::hash<std::string_view>{}(std::get<0>(key)),
+        std::hash<std::string_view>{}(std::get<1>(key)),
+        std::hash<std::string_view>{}(std::get<2>(key)));
+  }
+};
+} // namespace
+
 template <class T>
 HoldableValue<T>::HoldableValue(T val) : val_(val) {}
 
@@ -154,6 +177,8 @@ Link::Link(
   overload2_ = *adj2.isOverloaded_ref();
   adjLabel1_ = *adj1.adjLabel_ref();
   adjLabel2_ = *adj2.adjLabel_ref();
+  weight1_ = *adj1.weight_ref();
+  weight2_ = *adj2.weight_ref();
   nhV41_ = *adj1.nextHopV4_ref();
   nhV42_ = *adj2.nextHopV4_ref();
   nhV61_ = *adj1.nextHopV6_ref();
@@ -214,6 +239,17 @@ Link::getAdjLabelFromNode(const std::string& nodeName) const {
   throw std::invalid_argument(nodeName);
 }
 
+int64_t
+Link::getWeightFromNode(const std::string& nodeName) const {
+  if (n1_ == nodeName) {
+    return weight1_;
+  }
+  if (n2_ == nodeName) {
+    return weight2_;
+  }
+  throw std::invalid_argument(nodeName);
+}
+
 bool
 Link::getOverloadFromNode(const std::string& nodeName) const {
   if (n1_ == nodeName) {
@@ -325,6 +361,17 @@ Link::setAdjLabelFromNode(const std::string& nodeName, int32_t adjLabel) {
   }
 }
 
+void
+Link::setWeightFromNode(const std::string& nodeName, int64_t weight) {
+  if (n1_ == nodeName) {
+    weight1_ = weight;
+  } else if (n2_ == nodeName) {
+    weight2_ = weight;
+  } else {
+    throw std::invalid_argument(nodeName);
+  }
+}
+
 bool
 Link::setOverloadFromNode(
     const std::string& nodeName,
@@ -376,7 +423,61 @@ Link::directionalToString(const std::string& fromNode) const {
       getIfaceFromNode(getOtherNodeName(fromNode)));
 }
 
-LinkState::LinkState(const std::string& area) : area_(area) {}
+size_t
+Link::getHeapBytes() const {
+  // qualified, as this member hides the free functions
+  size_t bytes = 0;
+  for (auto const* str :
+       {&area_,
+        &n1_,
+        &n2_,
+        &if1_,
+        &if2_,
+        &orderedNames_.first.first,
+        &orderedNames_.first.second,
+        &orderedNames_.second.first,
+        &orderedNames_.second.second}) {
+    bytes += openr::getHeapBytes(*str);
+  }
+  for (auto const* addr : {&nhV41_, &nhV42_, &nhV61_, &nhV62_}) {
+    bytes += openr::getHeapBytes(*addr);
+  }
+  return bytes;
+}
+
+LinkState::LinkState(
+    const std::string& area,
+    bool enableIncrementalSpf,
+    size_t memoizedResultsMaxBytes)
+    : area_(area),
+      enableIncrementalSpf_(enableIncrementalSpf),
+      memoizedResultsMaxBytes_(memoizedResultsMaxBytes) {}
+
+LinkState::LinkState(LinkState const& other)
+    : area_(other.area_),
+      enableIncrementalSpf_(other.enableIncrementalSpf_),
+      memoizedResultsMaxBytes_(other.memoizedResultsMaxBytes_),
+      nodeOverloads_(other.nodeOverloads_),
+      heldNodes_(other.heldNodes_),
+      adjacencyDatabases_(other.adjacencyDatabases_),
+      generation_(other.generation_) {
+  // links carry holds and are updated in place, give the copy its own
+  std::unordered_map<Link const*, std::shared_ptr<Link>> copies;
+  for (auto const& link : other.allLinks_) {
+    auto copy = std::make_shared<Link>(*link);
+    copies.emplace(link.get(), copy);
+    allLinks_.emplace(std::move(copy));
+  }
+  for (auto const& [nodeName, links] : other.linkMap_) {
+    auto& nodeLinks = linkMap_[nodeName];
+    for (auto const& link : links) {
+      nodeLinks.emplace(copies.at(link.get()));
+    }
+  }
+  for (auto const& link : other.heldLinks_) {
+    heldLinks_.emplace(copies.at(link.get()));
+  }
+}
 
 size_t
 LinkState::LinkPtrHash::operator()(const std::shared_ptr<Link>& l) const {
@@ -431,6 +532,7 @@ LinkState::removeLink(std::shared_ptr<Link> link) {
   CHECK(linkMap_.at(link->firstNodeName()).erase(link));
   CHECK(linkMap_.at(link->secondNodeName()).erase(link));
   CHECK(allLinks_.erase(link));
+  heldLinks_.erase(link);
 }
 
 void
@@ -446,12 +548,14 @@ LinkState::removeNode(const std::string& nodeName) {
     try {
       CHECK(linkMap_.at(link->getOtherNodeName(nodeName)).erase(link));
       CHECK(allLinks_.erase(link));
+      heldLinks_.erase(link);
     } catch (std::out_of_range const& e) {
       LOG(FATAL) << "std::out_of_range for " << nodeName;
     }
   }
   linkMap_.erase(search);
   nodeOverloads_.erase(nodeName);
+  heldNodes_.erase(nodeName);
 }
 
 const LinkState::LinkSet&
@@ -464,17 +568,26 @@ LinkState::linksFromNode(const std::string& nodeName) const {
   return defaultEmptySet;
 }
 
-std::vector<std::shared_ptr<Link>>
-LinkState::orderedLinksFromNode(const std::string& nodeName) const {
-  std::vector<std::shared_ptr<Link>> links;
-  if (linkMap_.count(nodeName)) {
-    links.insert(
-        links.begin(),
-        linkMap_.at(nodeName).begin(),
-        linkMap_.at(nodeName).end());
-    std::sort(links.begin(), links.end(), LinkPtrLess{});
+size_t
+LinkState::getLinkStateBytes() const {
+  // rough estimate counting the hash nodes and heap allocations of entries.
+  // Links are shared by allLinks_ and linkMap_, count them once along with
+  // their shared_ptr control block
+  size_t bytes = 0;
+  for (auto const& link : allLinks_) {
+    bytes += kHashNodeBytes + sizeof(link) + sizeof(Link) +
+        2 * sizeof(void*) + link->getHeapBytes();
+  }
+  for (auto const& [nodeName, links] : linkMap_) {
+    bytes += kHashNodeBytes + sizeof(nodeName) + sizeof(links) +
+        getHeapBytes(nodeName) + links.bucket_count() * sizeof(void*) +
+        links.size() * (kHashNodeBytes + sizeof(std::shared_ptr<Link>));
+  }
+  for (auto const& [nodeName, adjDb] : adjacencyDatabases_) {
+    bytes += kHashNodeBytes + sizeof(nodeName) + sizeof(adjDb) +
+        getHeapBytes(nodeName) + getHeapBytes(adjDb);
   }
-  return links;
+  return bytes;
 }
 
 bool
@@ -483,9 +596,16 @@ LinkState::updateNodeOverloaded(
     bool isOverloaded,
     LinkStateMetric holdUpTtl,
     LinkStateMetric holdDownTtl) {
-  if (nodeOverloads_.count(nodeName)) {
-    return nodeOverloads_.at(nodeName).updateValue(
-        isOverloaded, holdUpTtl, holdDownTtl);
+  auto it = nodeOverloads_.find(nodeName);
+  if (it != nodeOverloads_.end()) {
+    bool const changed =
+        it->second.updateValue(isOverloaded, holdUpTtl, holdDownTtl);
+    if (it->second.hasHold()) {
+      heldNodes_.emplace(nodeName);
+    } else {
+      heldNodes_.erase(nodeName);
+    }
+    return changed;
   }
   nodeOverloads_.emplace(nodeName, HoldableValue<bool>{isOverloaded});
   // don't indicate LinkState changed if this is a new node
@@ -500,34 +620,25 @@ LinkState::isNodeOverloaded(const std::string& nodeName) const {
 LinkState::LinkStateChange
 LinkState::decrementHolds() {
   LinkStateChange change;
-  for (auto& link : allLinks_) {
-    change.topologyChanged |= link->decrementHolds();
+  for (auto it = heldLinks_.begin(); it != heldLinks_.end();) {
+    change.topologyChanged |= (*it)->decrementHolds();
+    it = (*it)->hasHolds() ? std::next(it) : heldLinks_.erase(it);
   }
-  for (auto& kv : nodeOverloads_) {
-    change.topologyChanged |= kv.second.decrementTtl();
+  for (auto it = heldNodes_.begin(); it != heldNodes_.end();) {
+    auto& overload = nodeOverloads_.at(*it);
+    change.topologyChanged |= overload.decrementTtl();
+    it = overload.hasHold() ? std::next(it) : heldNodes_.erase(it);
   }
   if (change.topologyChanged) {
+    ++generation_;
+    csrGraph_.reset();
     spfResults_.clear();
     kthPathResults_.clear();
+    maxHops_.clear();
   }
   return change;
 }
 
-bool
-LinkState::hasHolds() const {
-  for (auto& link : allLinks_) {
-    if (link->hasHolds()) {
-      return true;
-    }
-  }
-  for (auto& kv : nodeOverloads_) {
-    if (kv.second.hasHold()) {
-      return true;
-    }
-  }
-  return false;
-}
-
 std::shared_ptr<Link>
 LinkState::maybeMakeLink(
     const std::string& nodeName, const thrift::Adjacency& adj) const {
@@ -546,21 +657,6 @@ LinkState::maybeMakeLink(
   return nullptr;
 }
 
-std::vector<std::shared_ptr<Link>>
-LinkState::getOrderedLinkSet(const thrift::AdjacencyDatabase& adjDb) const {
-  std::vector<std::shared_ptr<Link>> links;
-  links.reserve(adjDb.adjacencies_ref()->size());
-  for (const auto& adj : *adjDb.adjacencies_ref()) {
-    auto linkPtr = maybeMakeLink(*adjDb.thisNodeName_ref(), adj);
-    if (nullptr != linkPtr) {
-      links.emplace_back(linkPtr);
-    }
-  }
-  links.shrink_to_fit();
-  std::sort(links.begin(), links.end(), LinkState::LinkPtrLess{});
-  return links;
-}
-
 LinkState::LinkStateChange
 LinkState::updateAdjacencyDatabase(
     thrift::AdjacencyDatabase const& newAdjacencyDb,
@@ -584,136 +680,192 @@ LinkState::updateAdjacencyDatabase(
   }
 
   // Default construct if it did not exist
-  thrift::AdjacencyDatabase priorAdjacencyDb(
-      std::move(adjacencyDatabases_[nodeName]));
-  // replace
-  adjacencyDatabases_[nodeName] = newAdjacencyDb;
-
-  // for comparing old and new state, we order the links based on the tuple
-  // <nodeName1, iface1, nodeName2, iface2>, this allows us to easily discern
-  // topology changes in the single loop below
-  auto oldLinks = orderedLinksFromNode(nodeName);
-  auto newLinks = getOrderedLinkSet(newAdjacencyDb);
+  auto& adjacencyDb = adjacencyDatabases_[nodeName];
+
+  // none of the fields links are built from changed, e.g. on a refresh
+  if (*adjacencyDb.adjacencies_ref() == *newAdjacencyDb.adjacencies_ref() and
+      *adjacencyDb.nodeLabel_ref() == *newAdjacencyDb.nodeLabel_ref() and
+      *adjacencyDb.isOverloaded_ref() == *newAdjacencyDb.isOverloaded_ref() and
+      nodeOverloads_.count(nodeName)) {
+    adjacencyDb = newAdjacencyDb;
+    return change;
+  }
 
-  // fill these sets with the appropriate links
-  std::unordered_set<Link> linksUp;
-  std::unordered_set<Link> linksDown;
+  change.nodeLabelChanged =
+      *adjacencyDb.nodeLabel_ref() != *newAdjacencyDb.nodeLabel_ref();
+  // replace
+  adjacencyDb = newAdjacencyDb;
 
-  change.topologyChanged |= updateNodeOverloaded(
+  bool const nodeOverloadChanged = updateNodeOverloaded(
       nodeName, *newAdjacencyDb.isOverloaded_ref(), holdUpTtl, holdDownTtl);
-
-  change.nodeLabelChanged =
-      *priorAdjacencyDb.nodeLabel_ref() != *newAdjacencyDb.nodeLabel_ref();
-
-  auto newIter = newLinks.begin();
-  auto oldIter = oldLinks.begin();
-  while (newIter != newLinks.end() || oldIter != oldLinks.end()) {
-    if (newIter != newLinks.end() &&
-        (oldIter == oldLinks.end() || **newIter < **oldIter)) {
-      // newIter is pointing at a Link not currently present, record this as a
-      // link to add and advance newIter
-      (*newIter)->setHoldUpTtl(holdUpTtl);
-      change.topologyChanged |= (*newIter)->isUp();
-      // even if we are holding a change, we apply the change to our link state
-      // and check for holds when running spf. this ensures we don't add the
-      // same hold twice
-      addLink(*newIter);
-      VLOG(1) << "addLink " << (*newIter)->toString();
-      ++newIter;
+  change.topologyChanged |= nodeOverloadChanged;
+
+  // links whose usable metrics changed, used to repair memoized SPF results
+  std::vector<LinkChange> linkChanges;
+
+  // Diff adjacencies against the current links of the node. Existing links
+  // are updated in place, only new ones are built
+  std::unordered_map<LinkKey, std::shared_ptr<Link>, LinkKeyHash> oldLinks;
+  for (auto const& link : linksFromNode(nodeName)) {
+    auto const& otherNodeName = link->getOtherNodeName(nodeName);
+    oldLinks.emplace(
+        LinkKey{
+            link->getIfaceFromNode(nodeName),
+            otherNodeName,
+            link->getIfaceFromNode(otherNodeName)},
+        link);
+  }
+  std::vector<std::shared_ptr<Link>> newLinks;
+  std::vector<std::pair<std::shared_ptr<Link>, thrift::Adjacency const*>>
+      updatedLinks;
+  for (auto const& adj : *newAdjacencyDb.adjacencies_ref()) {
+    auto it = oldLinks.find(LinkKey{
+        *adj.ifName_ref(), *adj.otherNodeName_ref(), *adj.otherIfName_ref()});
+    if (it != oldLinks.end()) {
+      updatedLinks.emplace_back(std::move(it->second), &adj);
+      oldLinks.erase(it);
       continue;
     }
-    if (oldIter != oldLinks.end() &&
-        (newIter == newLinks.end() || **oldIter < **newIter)) {
-      // oldIter is pointing at a Link that is no longer present, record this
-      // as a link to remove and advance oldIter.
-      // If this link was previously overloaded or had a hold up, this does not
-      // change the topology.
-      change.topologyChanged |= (*oldIter)->isUp();
-      removeLink(*oldIter);
-      VLOG(1) << "removeLink " << (*oldIter)->toString();
-      ++oldIter;
-      continue;
+    if (auto link = maybeMakeLink(nodeName, adj)) {
+      newLinks.emplace_back(std::move(link));
     }
-    // The newIter and oldIter point to the same link. This link did not go up
-    // or down. The topology may still have changed though if the link overlaod
-    // or metric changed
-    auto& newLink = **newIter;
-    auto& oldLink = **oldIter;
+  }
+
+  for (auto const& [_, oldLink] : oldLinks) {
+    // oldLink is no longer present, record this as a link to remove.
+    // If this link was previously overloaded or had a hold up, this does not
+    // change the topology.
+    if (oldLink->isUp()) {
+      change.topologyChanged = true;
+      linkChanges.push_back(
+          {oldLink, getDirectedMetrics(*oldLink), DirectedMetrics{}});
+    }
+    removeLink(oldLink);
+    VLOG(1) << "removeLink " << oldLink->toString();
+  }
+
+  for (auto const& newLink : newLinks) {
+    // newLink is a Link not currently present, record this as a link to add
+    newLink->setHoldUpTtl(holdUpTtl);
+    if (newLink->isUp()) {
+      change.topologyChanged = true;
+      linkChanges.push_back(
+          {newLink, DirectedMetrics{}, getDirectedMetrics(*newLink)});
+    }
+    // even if we are holding a change, we apply the change to our link state
+    // and check for holds when running spf. this ensures we don't add the
+    // same hold twice
+    addLink(newLink);
+    if (newLink->hasHolds()) {
+      heldLinks_.emplace(newLink);
+    }
+    VLOG(1) << "addLink " << newLink->toString();
+  }
+
+  for (auto const& [linkPtr, adjPtr] : updatedLinks) {
+    // This link did not go up or down. The topology may still have changed
+    // though if the link overlaod or metric changed
+    auto const& adj = *adjPtr;
+    auto& link = *linkPtr;
+    auto const oldMetrics = getDirectedMetrics(link);
 
     // change the metric on the link object we already have
-    if (newLink.getMetricFromNode(nodeName) !=
-        oldLink.getMetricFromNode(nodeName)) {
+    if (*adj.metric_ref() != link.getMetricFromNode(nodeName)) {
       LOG(INFO) << folly::sformat(
           "Metric change on link {}: {} => {}",
-          newLink.directionalToString(nodeName),
-          oldLink.getMetricFromNode(nodeName),
-          newLink.getMetricFromNode(nodeName));
-      change.topologyChanged |= oldLink.setMetricFromNode(
-          nodeName,
-          newLink.getMetricFromNode(nodeName),
-          holdUpTtl,
-          holdDownTtl);
-    }
-
-    if (newLink.getOverloadFromNode(nodeName) !=
-        oldLink.getOverloadFromNode(nodeName)) {
+          link.directionalToString(nodeName),
+          link.getMetricFromNode(nodeName),
+          *adj.metric_ref());
+      change.topologyChanged |= link.setMetricFromNode(
+          nodeName, *adj.metric_ref(), holdUpTtl, holdDownTtl);
+    }
+
+    if (*adj.isOverloaded_ref() != link.getOverloadFromNode(nodeName)) {
       LOG(INFO) << folly::sformat(
           "Overload change on link {}: {} => {}",
-          newLink.directionalToString(nodeName),
-          oldLink.getOverloadFromNode(nodeName),
-          newLink.getOverloadFromNode(nodeName));
-      change.topologyChanged |= oldLink.setOverloadFromNode(
-          nodeName,
-          newLink.getOverloadFromNode(nodeName),
-          holdUpTtl,
-          holdDownTtl);
+          link.directionalToString(nodeName),
+          link.getOverloadFromNode(nodeName),
+          *adj.isOverloaded_ref());
+      change.topologyChanged |= link.setOverloadFromNode(
+          nodeName, *adj.isOverloaded_ref(), holdUpTtl, holdDownTtl);
+    }
+
+    if (link.hasHolds()) {
+      heldLinks_.emplace(linkPtr);
+    } else {
+      heldLinks_.erase(linkPtr);
+    }
+
+    auto newMetrics = getDirectedMetrics(link);
+    if (not(newMetrics == oldMetrics)) {
+      linkChanges.push_back({linkPtr, oldMetrics, std::move(newMetrics)});
     }
 
     // Check if adjacency label has changed
-    if (newLink.getAdjLabelFromNode(nodeName) !=
-        oldLink.getAdjLabelFromNode(nodeName)) {
+    if (*adj.adjLabel_ref() != link.getAdjLabelFromNode(nodeName)) {
       VLOG(1) << folly::sformat(
           "AdjLabel change on link {}: {} => {}",
-          newLink.directionalToString(nodeName),
-          oldLink.getAdjLabelFromNode(nodeName),
-          newLink.getAdjLabelFromNode(nodeName));
+          link.directionalToString(nodeName),
+          link.getAdjLabelFromNode(nodeName),
+          *adj.adjLabel_ref());
 
       change.linkAttributesChanged |= true;
 
       // change the adjLabel on the link object we already have
-      oldLink.setAdjLabelFromNode(
-          nodeName, newLink.getAdjLabelFromNode(nodeName));
+      link.setAdjLabelFromNode(nodeName, *adj.adjLabel_ref());
+    }
+
+    // Check if adjacency weight has changed
+    if (*adj.weight_ref() != link.getWeightFromNode(nodeName)) {
+      VLOG(1) << folly::sformat(
+          "Weight change on link {}: {} => {}",
+          link.directionalToString(nodeName),
+          link.getWeightFromNode(nodeName),
+          *adj.weight_ref());
+
+      change.linkAttributesChanged |= true;
+      link.setWeightFromNode(nodeName, *adj.weight_ref());
     }
 
     // check if local nextHops Changed
-    if (newLink.getNhV4FromNode(nodeName) !=
-        oldLink.getNhV4FromNode(nodeName)) {
+    if (*adj.nextHopV4_ref() != link.getNhV4FromNode(nodeName)) {
       VLOG(1) << folly::sformat(
           "V4-NextHop address change on link {}: {} => {}",
-          newLink.directionalToString(nodeName),
-          toString(oldLink.getNhV4FromNode(nodeName)),
-          toString(newLink.getNhV4FromNode(nodeName)));
+          link.directionalToString(nodeName),
+          toString(link.getNhV4FromNode(nodeName)),
+          toString(*adj.nextHopV4_ref()));
 
       change.linkAttributesChanged |= true;
-      oldLink.setNhV4FromNode(nodeName, newLink.getNhV4FromNode(nodeName));
+      link.setNhV4FromNode(nodeName, *adj.nextHopV4_ref());
     }
-    if (newLink.getNhV6FromNode(nodeName) !=
-        oldLink.getNhV6FromNode(nodeName)) {
+    if (*adj.nextHopV6_ref() != link.getNhV6FromNode(nodeName)) {
       VLOG(1) << folly::sformat(
           "V6-NextHop address change on link {}: {} => {}",
-          newLink.directionalToString(nodeName),
-          toString(oldLink.getNhV6FromNode(nodeName)),
-          toString(newLink.getNhV6FromNode(nodeName)));
+          link.directionalToString(nodeName),
+          toString(link.getNhV6FromNode(nodeName)),
+          toString(*adj.nextHopV6_ref()));
 
       change.linkAttributesChanged |= true;
-      oldLink.setNhV6FromNode(nodeName, newLink.getNhV6FromNode(nodeName));
+      link.setNhV6FromNode(nodeName, *adj.nextHopV6_ref());
     }
-    ++newIter;
-    ++oldIter;
   }
   if (change.topologyChanged) {
-    spfResults_.clear();
-    kthPathResults_.clear();
+    // hop counts only depend on which links and nodes can be used
+    bool usableChanged = nodeOverloadChanged;
+    for (auto const& [_, oldMetrics, newMetrics] : linkChanges) {
+      usableChanged |=
+          oldMetrics.fromFirst.has_value() != newMetrics.fromFirst.has_value();
+      usableChanged |= oldMetrics.fromSecond.has_value() !=
+          newMetrics.fromSecond.has_value();
+    }
+    if (usableChanged) {
+      maxHops_.clear();
+    }
+    updateMemoizedResults(linkChanges, not nodeOverloadChanged);
+  }
+  if (change.topologyChanged or change.linkAttributesChanged or
+      change.nodeLabelChanged) {
+    ++generation_;
   }
   return change;
 }
@@ -727,8 +879,11 @@ LinkState::deleteAdjacencyDatabase(const std::string& nodeName) {
   if (search != adjacencyDatabases_.end()) {
     removeNode(nodeName);
     adjacencyDatabases_.erase(search);
+    ++generation_;
+    csrGraph_.reset();
     spfResults_.clear();
     kthPathResults_.clear();
+    maxHops_.clear();
     change.topologyChanged = true;
   } else {
     LOG(WARNING) << "Trying to delete adjacency db for nonexisting node "
@@ -752,11 +907,39 @@ LinkState::getMetricFromAToB(
 
 LinkStateMetric
 LinkState::getMaxHopsToNode(const std::string& nodeName) const {
+  auto it = maxHops_.find(nodeName);
+  if (it != maxHops_.end()) {
+    return it->second;
+  }
+
+  // breadth first search with the same rules as runSpf(), no need to track
+  // paths and next-hops for the hop count
   LinkStateMetric max = 0;
-  for (auto const& pathsFromNode : getSpfResult(nodeName, false)) {
-    max = std::max(max, pathsFromNode.second.metric());
+  auto const& graph = getCsrGraph();
+  auto const srcIt = graph.nodeIds.find(nodeName);
+  if (srcIt != graph.nodeIds.end()) {
+    auto const src = srcIt->second;
+    std::vector<LinkStateMetric> hops(
+        graph.nodeNames.size(), std::numeric_limits<LinkStateMetric>::max());
+    std::vector<uint32_t> queue{src};
+    hops[src] = 0;
+    for (size_t i = 0; i < queue.size(); ++i) {
+      auto const node = queue[i];
+      // visited in order of hop count
+      max = hops[node];
+      if (graph.overloaded[node] and node != src) {
+        continue;
+      }
+      for (auto e = graph.offsets[node]; e < graph.offsets[node + 1]; ++e) {
+        auto const other = graph.edges[e].toNode;
+        if (hops[other] == std::numeric_limits<LinkStateMetric>::max()) {
+          hops[other] = hops[node] + 1;
+          queue.push_back(other);
+        }
+      }
+    }
   }
-  return max;
+  return maxHops_.emplace(nodeName, max).first->second;
 }
 
 std::vector<LinkState::Path> const&
@@ -764,42 +947,548 @@ LinkState::getKthPaths(
     const std::string& src, const std::string& dest, size_t k) const {
   CHECK_GE(k, 1);
   std::tuple<std::string, std::string, size_t> key(src, dest, k);
-  auto entryIter = kthPathResults_.find(key);
-  if (kthPathResults_.end() == entryIter) {
-    LinkSet linksToIgnore;
-    for (size_t i = 1; i < k; ++i) {
-      for (auto const& path : getKthPaths(src, dest, i)) {
-        for (auto const& link : path) {
-          linksToIgnore.insert(link);
+  if (auto paths = kthPathResults_.find(key)) {
+    fb303::fbData->addStatValue(
+        "decision.kth_paths_cache_hits", 1, fb303::COUNT);
+    return *paths;
+  }
+  fb303::fbData->addStatValue(
+      "decision.kth_paths_cache_misses", 1, fb303::COUNT);
+  const auto startTime = std::chrono::steady_clock::now();
+  auto paths = computeKthPaths(src, dest, k);
+  fb303::fbData->addStatValue(
+      "decision.kth_paths_us",
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - startTime)
+          .count(),
+      fb303::AVG);
+  auto const bytes = getKthPathsEntryBytes(key, paths);
+  return kthPathResults_.insert(key, std::move(paths), bytes);
+}
+
+std::vector<LinkState::Path>
+LinkState::computeKthPaths(
+    const std::string& src, const std::string& dest, size_t k) const {
+  // The shortest paths are traced on the memoized SPF result of src, which is
+  // shared by all destinations. For k > 1 the links of the previous paths are
+  // masked out on the CSR graph and the spur SPF run stops as soon as dest is
+  // settled, without computing next-hops of any node.
+  auto const& graph = getCsrGraph();
+  std::vector<bool> ignoredLinks;
+  for (size_t i = 1; i < k; ++i) {
+    for (auto const& path : getKthPaths(src, dest, i)) {
+      for (auto const& link : path) {
+        if (ignoredLinks.empty()) {
+          ignoredLinks.resize(graph.links.size(), false);
         }
+        ignoredLinks[graph.linkIds.at(link.get())] = true;
       }
     }
-    std::vector<LinkState::Path> paths;
-    auto const& res = linksToIgnore.empty() ? getSpfResult(src, true)
-                                            : runSpf(src, true, linksToIgnore);
-    if (res.count(dest)) {
-      LinkSet visitedLinks;
-      auto path = traceOnePath(src, dest, res, visitedLinks);
-      while (path && !path->empty()) {
-        paths.push_back(std::move(*path));
-        path = traceOnePath(src, dest, res, visitedLinks);
+  }
+
+  std::optional<SpfResult> spurResult;
+  if (not ignoredLinks.empty()) {
+    // there are previous paths, so both src and dest are in the graph
+    spurResult = runSpfOnCsrGraph(
+        graph.nodeIds.at(src), true, ignoredLinks, graph.nodeIds.at(dest));
+  }
+  auto const& res = spurResult ? *spurResult : getSpfResult(src, true);
+
+  std::vector<LinkState::Path> paths;
+  if (res.count(dest)) {
+    LinkSet visitedLinks;
+    auto path = traceOnePath(src, dest, res, visitedLinks);
+    while (path && !path->empty()) {
+      paths.push_back(std::move(*path));
+      path = traceOnePath(src, dest, res, visitedLinks);
+    }
+  }
+  return paths;
+}
+
+size_t
+LinkState::getKthPathsEntryBytes(
+    std::tuple<std::string, std::string, size_t> const& key,
+    std::vector<LinkState::Path> const& paths) {
+  // rough estimate counting the hash node and heap allocations of the entry
+  size_t bytes = sizeof(key) + sizeof(paths) + 2 * sizeof(void*) +
+      std::get<0>(key).capacity() + std::get<1>(key).capacity() +
+      paths.capacity() * sizeof(LinkState::Path);
+  for (auto const& path : paths) {
+    bytes += path.capacity() * sizeof(std::shared_ptr<Link>);
+  }
+  return bytes;
+}
+
+LinkState::DirectedMetrics
+LinkState::getDirectedMetrics(Link const& link) {
+  DirectedMetrics metrics;
+  if (link.isUp()) {
+    metrics.fromFirst = link.getMetricFromNode(link.firstNodeName());
+    metrics.fromSecond = link.getMetricFromNode(link.secondNodeName());
+  }
+  return metrics;
+}
+
+void
+LinkState::updateMemoizedResults(
+    std::vector<LinkChange> const& linkChanges, bool canRepair) {
+  csrGraph_.reset();
+  kthPathResults_.clear();
+  if (not enableIncrementalSpf_ or not canRepair or linkChanges.size() != 1) {
+    spfResults_.clear();
+    return;
+  }
+
+  spfResults_.update([&](auto const& key, SpfResult& result) {
+    auto const& [src, useLinkMetric] = key;
+    if (repairSpfResult(src, useLinkMetric, linkChanges.front(), result)) {
+      fb303::fbData->addStatValue(
+          "decision.incremental_spf_runs", 1, fb303::COUNT);
+      return std::make_optional(getSpfResultBytes(key, result));
+    }
+    // will be lazily recomputed with a full SPF run on next access
+    fb303::fbData->addStatValue(
+        "decision.incremental_spf_fallbacks", 1, fb303::COUNT);
+    return std::optional<size_t>();
+  });
+}
+
+namespace {
+
+// std::nullopt represents infinite cost (link is not usable)
+bool
+isMoreExpensive(
+    std::optional<LinkStateMetric> const& a,
+    std::optional<LinkStateMetric> const& b) {
+  if (not a.has_value()) {
+    return b.has_value();
+  }
+  return b.has_value() and *a > *b;
+}
+
+// Offer `nodeName` a path via `prevNodeName` while repairing a SPF result.
+// Mirrors the bookkeeping of the relax step in LinkState::runSpf()
+void
+relaxTowards(
+    LinkState::NodeSpfResult& nodeResult,
+    std::string const& nodeName,
+    LinkStateMetric candidateMetric,
+    std::shared_ptr<Link> const& link,
+    std::string const& prevNodeName,
+    LinkState::NodeSpfResult const& prevNodeResult) {
+  if (nodeResult.metric() < candidateMetric) {
+    return;
+  }
+  if (nodeResult.metric() > candidateMetric) {
+    nodeResult.reset(candidateMetric);
+  }
+  nodeResult.addPath(link, prevNodeName);
+  if (prevNodeResult.nextHops().empty()) {
+    // only the source has no nexthops, this is a directly connected node
+    nodeResult.addNextHop(nodeName);
+  } else {
+    nodeResult.addNextHops(prevNodeResult.nextHops());
+  }
+}
+
+// min-heap of <metric, nodeName>, ties broken on name as in DijkstraQ
+using RepairQueue = std::priority_queue<
+    std::pair<LinkStateMetric, std::string>,
+    std::vector<std::pair<LinkStateMetric, std::string>>,
+    std::greater<std::pair<LinkStateMetric, std::string>>>;
+
+} // namespace
+
+bool
+LinkState::repairSpfResult(
+    std::string const& src,
+    bool useLinkMetric,
+    LinkChange const& change,
+    SpfResult& result) const {
+  auto const& link = *change.link;
+  auto toWeight = [useLinkMetric](std::optional<LinkStateMetric> const& m) {
+    // any usable link has unit weight if link metrics are not used
+    return (useLinkMetric or not m.has_value())
+        ? m
+        : std::optional<LinkStateMetric>{1};
+  };
+
+  std::vector<LinkDirection> increased, decreased;
+  auto classify = [&](std::string const& from,
+                      std::optional<LinkStateMetric> const& oldMetric,
+                      std::optional<LinkStateMetric> const& newMetric) {
+    auto const oldWeight = toWeight(oldMetric);
+    auto const newWeight = toWeight(newMetric);
+    // no transit traffic through overloaded nodes, changes to links leaving
+    // them can not affect the result
+    if (from != src and isNodeOverloaded(from)) {
+      return;
+    }
+    auto const& to = link.getOtherNodeName(from);
+    if (isMoreExpensive(newWeight, oldWeight)) {
+      increased.emplace_back(from, to);
+    } else if (isMoreExpensive(oldWeight, newWeight)) {
+      decreased.emplace_back(from, to);
+    }
+  };
+  classify(
+      link.firstNodeName(),
+      change.oldMetrics.fromFirst,
+      change.newMetrics.fromFirst);
+  classify(
+      link.secondNodeName(),
+      change.oldMetrics.fromSecond,
+      change.newMetrics.fromSecond);
+
+  if (not increased.empty() and not decreased.empty()) {
+    // mixed changes are not expected from a single update, play it safe
+    return false;
+  }
+  if (not increased.empty()) {
+    return repairSpfResultOnIncrease(
+        src, useLinkMetric, link, increased, result);
+  }
+  if (not decreased.empty()) {
+    return repairSpfResultOnDecrease(src, useLinkMetric, decreased, result);
+  }
+  // nothing changed from the perspective of this result, e.g. a metric change
+  // on a hop count based result
+  return true;
+}
+
+bool
+LinkState::repairSpfResultOnIncrease(
+    std::string const& src,
+    bool useLinkMetric,
+    Link const& link,
+    std::vector<LinkDirection> const& directions,
+    SpfResult& result) const {
+  // find nodes that reach `src` over the changed link. Only these and their
+  // descendants in the shortest path DAG may be affected
+  std::vector<std::string> toVisit;
+  for (auto const& [from, to] : directions) {
+    auto search = result.find(to);
+    if (search == result.end()) {
+      continue;
+    }
+    for (auto const& pathLink : search->second.pathLinks()) {
+      if (pathLink.prevNode == from and *pathLink.link == link) {
+        toVisit.emplace_back(to);
+        break;
+      }
+    }
+  }
+  if (toVisit.empty()) {
+    // changed link is not on any shortest path
+    return true;
+  }
+
+  std::unordered_map<std::string, std::vector<std::string>> children;
+  for (auto const& [node, nodeResult] : result) {
+    for (auto const& pathLink : nodeResult.pathLinks()) {
+      children[pathLink.prevNode].emplace_back(node);
+    }
+  }
+  std::unordered_set<std::string> affected;
+  while (not toVisit.empty()) {
+    auto node = std::move(toVisit.back());
+    toVisit.pop_back();
+    if (not affected.insert(node).second) {
+      continue;
+    }
+    auto search = children.find(node);
+    if (search != children.end()) {
+      toVisit.insert(
+          toVisit.end(), search->second.begin(), search->second.end());
+    }
+  }
+  for (auto const& node : affected) {
+    result.erase(node);
+  }
+
+  // seed affected nodes with their best path via unaffected nodes. The
+  // results of unaffected nodes are final
+  std::unordered_map<std::string, NodeSpfResult> tentative;
+  RepairQueue q;
+  auto offer = [&](std::string const& node,
+                   LinkStateMetric metric,
+                   std::shared_ptr<Link> const& viaLink,
+                   std::string const& prevNode) {
+    auto [it, inserted] = tentative.emplace(node, NodeSpfResult(metric));
+    if (inserted or it->second.metric() > metric) {
+      q.emplace(metric, node);
+    }
+    relaxTowards(
+        it->second, node, metric, viaLink, prevNode, result.at(prevNode));
+  };
+  for (auto const& node : affected) {
+    for (auto const& viaLink : linksFromNode(node)) {
+      auto const& prevNode = viaLink->getOtherNodeName(node);
+      auto prevSearch = result.find(prevNode);
+      if (not viaLink->isUp() or prevSearch == result.end() or
+          (prevNode != src and isNodeOverloaded(prevNode))) {
+        continue;
+      }
+      auto const weight =
+          useLinkMetric ? viaLink->getMetricFromNode(prevNode) : 1;
+      if (weight == 0) {
+        return false;
+      }
+      offer(node, prevSearch->second.metric() + weight, viaLink, prevNode);
+    }
+  }
+
+  // Dijkstra restricted to the affected nodes
+  while (not q.empty()) {
+    auto [metric, node] = q.top();
+    q.pop();
+    auto search = tentative.find(node);
+    if (result.count(node) or search->second.metric() != metric) {
+      continue; // stale queue entry
+    }
+    result.emplace(node, std::move(search->second));
+    tentative.erase(search);
+    if (isNodeOverloaded(node)) {
+      continue;
+    }
+    for (auto const& viaLink : linksFromNode(node)) {
+      auto const& otherNode = viaLink->getOtherNodeName(node);
+      if (not viaLink->isUp() or not affected.count(otherNode) or
+          result.count(otherNode)) {
+        continue;
+      }
+      auto const weight = useLinkMetric ? viaLink->getMetricFromNode(node) : 1;
+      if (weight == 0) {
+        return false;
       }
+      offer(otherNode, metric + weight, viaLink, node);
     }
-    entryIter = kthPathResults_.emplace(key, std::move(paths)).first;
   }
-  return entryIter->second;
+  // affected nodes which were not reached are no longer reachable
+  return true;
+}
+
+bool
+LinkState::repairSpfResultOnDecrease(
+    std::string const& src,
+    bool useLinkMetric,
+    std::vector<LinkDirection> const& directions,
+    SpfResult& result) const {
+  RepairQueue q;
+  auto maybeEnqueue = [&](std::string const& node, LinkStateMetric metric) {
+    if (node == src) {
+      return;
+    }
+    auto search = result.find(node);
+    if (search == result.end() or metric <= search->second.metric()) {
+      q.emplace(metric, node);
+    }
+  };
+
+  for (auto const& [from, to] : directions) {
+    auto search = result.find(from);
+    if (search == result.end()) {
+      continue; // can't offer a path to anyone
+    }
+    for (auto const& viaLink : linksFromNode(from)) {
+      if (viaLink->isUp() and viaLink->getOtherNodeName(from) == to) {
+        auto const weight =
+            useLinkMetric ? viaLink->getMetricFromNode(from) : 1;
+        if (weight == 0) {
+          return false;
+        }
+        maybeEnqueue(to, search->second.metric() + weight);
+      }
+    }
+  }
+
+  // Dijkstra seeded from the improved links. Each popped node has its result
+  // recomputed from scratch from its neighbors, which are final by the time
+  // it is popped
+  std::unordered_set<std::string> done;
+  while (not q.empty()) {
+    auto node = q.top().second;
+    q.pop();
+    if (not done.insert(node).second) {
+      continue;
+    }
+
+    NodeSpfResult nodeResult(std::numeric_limits<LinkStateMetric>::max());
+    for (auto const& viaLink : linksFromNode(node)) {
+      auto const& prevNode = viaLink->getOtherNodeName(node);
+      auto prevSearch = result.find(prevNode);
+      if (not viaLink->isUp() or prevSearch == result.end() or
+          (prevNode != src and isNodeOverloaded(prevNode))) {
+        continue;
+      }
+      auto const weight =
+          useLinkMetric ? viaLink->getMetricFromNode(prevNode) : 1;
+      if (weight == 0) {
+        return false;
+      }
+      relaxTowards(
+          nodeResult,
+          node,
+          prevSearch->second.metric() + weight,
+          viaLink,
+          prevNode,
+          prevSearch->second);
+    }
+    CHECK(not nodeResult.pathLinks().empty());
+    auto const metric = nodeResult.metric();
+    result.insert_or_assign(node, std::move(nodeResult));
+
+    if (isNodeOverloaded(node)) {
+      continue;
+    }
+    for (auto const& viaLink : linksFromNode(node)) {
+      if (not viaLink->isUp()) {
+        continue;
+      }
+      auto const weight = useLinkMetric ? viaLink->getMetricFromNode(node) : 1;
+      if (weight == 0) {
+        return false;
+      }
+      maybeEnqueue(viaLink->getOtherNodeName(node), metric + weight);
+    }
+  }
+  return true;
 }
 
 LinkState::SpfResult const&
 LinkState::getSpfResult(
     const std::string& thisNodeName, bool useLinkMetric) const {
   std::pair<std::string, bool> key{thisNodeName, useLinkMetric};
-  auto entryIter = spfResults_.find(key);
-  if (spfResults_.end() == entryIter) {
-    auto res = runSpf(thisNodeName, useLinkMetric);
-    entryIter = spfResults_.emplace(std::move(key), std::move(res)).first;
+  if (spfResultsGuard_.sharedLookups) {
+    std::shared_lock<std::shared_mutex> lock(spfResultsGuard_.mutex);
+    if (auto result = spfResults_.peek(key)) {
+      spfStats_.cacheHits.fetch_add(1, std::memory_order_relaxed);
+      return *result;
+    }
+  } else {
+    std::unique_lock<std::shared_mutex> lock(spfResultsGuard_.mutex);
+    if (auto result = spfResults_.find(key)) {
+      spfStats_.cacheHits.fetch_add(1, std::memory_order_relaxed);
+      return *result;
+    }
+  }
+  const auto startTime = std::chrono::steady_clock::now();
+  auto res = runSpf(thisNodeName, useLinkMetric);
+  spfStats_.cacheMisses.fetch_add(1, std::memory_order_relaxed);
+  spfStats_.spfTimeUs.fetch_add(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - startTime)
+          .count(),
+      std::memory_order_relaxed);
+  auto const bytes = getSpfResultBytes(key, res);
+  std::unique_lock<std::shared_mutex> lock(spfResultsGuard_.mutex);
+  // another caller may have memoized it meanwhile
+  if (auto result = spfResults_.peek(key)) {
+    return *result;
+  }
+  return spfResults_.insert(key, std::move(res), bytes);
+}
+
+LinkState::SpfStats
+LinkState::getSpfStats() const {
+  SpfStats stats;
+  stats.cacheHits = spfStats_.cacheHits.load(std::memory_order_relaxed);
+  stats.cacheMisses = spfStats_.cacheMisses.load(std::memory_order_relaxed);
+  stats.spfTime = std::chrono::microseconds(
+      spfStats_.spfTimeUs.load(std::memory_order_relaxed));
+  return stats;
+}
+
+size_t
+LinkState::getSpfResultBytes(
+    std::pair<std::string, bool> const& key, SpfResult const& result) {
+  // rough estimate counting hash nodes and heap allocations of the entry
+  size_t bytes = sizeof(key) + sizeof(result) + key.first.capacity() +
+      result.bucket_count() * sizeof(void*);
+  size_t const nodeOverhead = 2 * sizeof(void*);
+  for (auto const& [node, nodeResult] : result) {
+    bytes += sizeof(SpfResult::value_type) + nodeOverhead + node.capacity() +
+        nodeResult.pathLinks().capacity() * sizeof(NodeSpfResult::PathLink) +
+        nodeResult.nextHops().size() * (sizeof(std::string) + nodeOverhead);
+  }
+  return bytes;
+}
+
+void
+LinkState::evictMemoizedResults() const {
+  if (not memoizedResultsMaxBytes_) {
+    return;
+  }
+  auto const spfBytes = spfResults_.bytes();
+  size_t numEvicted = kthPathResults_.evict(
+      memoizedResultsMaxBytes_ > spfBytes
+          ? memoizedResultsMaxBytes_ - spfBytes
+          : 0);
+  numEvicted += spfResults_.evict(memoizedResultsMaxBytes_);
+  if (numEvicted) {
+    fb303::fbData->addStatValue(
+        "decision.memoized_results_evictions", numEvicted, fb303::COUNT);
   }
-  return entryIter->second;
+}
+
+void
+LinkState::clearMemoizedResults() const {
+  const size_t numEvicted = spfResults_.size() + kthPathResults_.size();
+  kthPathResults_.clear();
+  spfResults_.clear();
+  if (numEvicted) {
+    fb303::fbData->addStatValue(
+        "decision.memoized_results_evictions", numEvicted, fb303::COUNT);
+  }
+}
+
+LinkState::CsrGraph const&
+LinkState::getCsrGraph() const {
+  if (csrGraph_) {
+    return *csrGraph_;
+  }
+  auto graph = std::make_unique<CsrGraph>();
+
+  graph->nodeNames.reserve(linkMap_.size());
+  for (auto const& kv : linkMap_) {
+    graph->nodeNames.emplace_back(kv.first);
+  }
+  std::sort(graph->nodeNames.begin(), graph->nodeNames.end());
+  auto const numNodes = graph->nodeNames.size();
+  graph->nodeIds.reserve(numNodes);
+  graph->overloaded.reserve(numNodes);
+  for (uint32_t id = 0; id < numNodes; ++id) {
+    auto const& nodeName = graph->nodeNames.at(id);
+    graph->nodeIds.emplace(nodeName, id);
+    graph->overloaded.push_back(isNodeOverloaded(nodeName));
+  }
+
+  auto& linkIds = graph->linkIds;
+  graph->offsets.reserve(numNodes + 1);
+  graph->edges.reserve(2 * allLinks_.size());
+  for (auto const& nodeName : graph->nodeNames) {
+    graph->offsets.push_back(graph->edges.size());
+    // keep the iteration order of linkMap_ so path links are recorded in the
+    // same order as when walking linksFromNode()
+    for (auto const& link : linkMap_.at(nodeName)) {
+      if (not link->isUp()) {
+        continue;
+      }
+      auto linkIt = linkIds.emplace(link.get(), graph->links.size()).first;
+      if (linkIt->second == graph->links.size()) {
+        graph->links.push_back(link);
+      }
+      graph->edges.push_back(CsrGraph::Edge{
+          graph->nodeIds.at(link->getOtherNodeName(nodeName)),
+          link->getMetricFromNode(nodeName),
+          linkIt->second});
+    }
+  }
+  graph->offsets.push_back(graph->edges.size());
+
+  csrGraph_ = std::move(graph);
+  return *csrGraph_;
 }
 
 /**
@@ -810,74 +1499,146 @@ LinkState::runSpf(
     const std::string& thisNodeName,
     bool useLinkMetric,
     const LinkState::LinkSet& linksToIgnore) const {
+  auto const& graph = getCsrGraph();
+  auto const srcIt = graph.nodeIds.find(thisNodeName);
+  if (srcIt == graph.nodeIds.end()) {
+    // no links, we can only reach ourselves
+    LinkState::SpfResult result;
+    result.emplace(thisNodeName, NodeSpfResult(0));
+    return result;
+  }
+
+  std::vector<bool> ignoredLinks;
+  if (not linksToIgnore.empty()) {
+    ignoredLinks.resize(graph.links.size(), false);
+    for (uint32_t l = 0; l < graph.links.size(); ++l) {
+      ignoredLinks[l] = linksToIgnore.count(graph.links[l]) != 0;
+    }
+  }
+  return runSpfOnCsrGraph(srcIt->second, useLinkMetric, ignoredLinks);
+}
+
+LinkState::SpfResult
+LinkState::runSpfOnCsrGraph(
+    uint32_t src,
+    bool useLinkMetric,
+    std::vector<bool> const& ignoredLinks,
+    std::optional<uint32_t> dest) const {
   LinkState::SpfResult result;
 
-  fb303::fbData->addStatValue("decision.spf_runs", 1, fb303::COUNT);
+  static const StatHandle kSpfRuns("decision.spf_runs", fb303::COUNT);
+  static const StatHandle kSpfMs("decision.spf_ms", fb303::AVG);
+  kSpfRuns.addValue(1);
   const auto startTime = std::chrono::steady_clock::now();
 
-  DijkstraQ q;
-  q.insertNode(thisNodeName, 0);
+  auto const& graph = getCsrGraph();
+  auto const numNodes = graph.nodeNames.size();
+
+  // per node state of the run, indexed by node id. nextHops are kept sorted
+  // so they can be merged cheaply
+  std::vector<LinkStateMetric> metrics(
+      numNodes, std::numeric_limits<LinkStateMetric>::max());
+  std::vector<bool> queued(numNodes, false);
+  std::vector<bool> settled(numNodes, false);
+  std::vector<std::vector<std::pair<uint32_t /* link */, uint32_t /* prev */>>>
+      pathLinks(numNodes);
+  std::vector<std::vector<uint32_t>> nextHops(numNodes);
+  std::vector<uint32_t> settleOrder;
+  settleOrder.reserve(numNodes);
+  std::vector<uint32_t> mergedNextHops;
+
+  DijkstraQ q(metrics);
+  metrics[src] = 0;
+  queued[src] = true;
+  q.insertNode(src);
   uint64_t loop = 0;
-  while (auto node = q.extractMin()) {
+  while (not q.empty()) {
     ++loop;
     // we've found this node's shortest paths. record it
-    auto emplaceRc = result.emplace(node->nodeName, std::move(node->result));
-    CHECK(emplaceRc.second);
+    auto const node = q.extractMin();
+    settled[node] = true;
+    settleOrder.push_back(node);
 
-    auto const& recordedNodeName = emplaceRc.first->first;
-    auto const recordedNodeMetric = emplaceRc.first->second.metric();
-    auto const& recordedNodeNextHops = emplaceRc.first->second.nextHops();
+    if (dest == node) {
+      // all shortest paths towards dest go through already settled nodes
+      break;
+    }
 
-    if (isNodeOverloaded(recordedNodeName) &&
-        recordedNodeName != thisNodeName) {
+    if (graph.overloaded[node] && node != src) {
       // no transit traffic through this node. we've recorded the nexthops to
       // this node, but will not consider any of it's adjancecies as offering
       // lower cost paths towards further away nodes. This effectively drains
       // traffic away from this node
       continue;
     }
-    // we have the shortest path nexthops for recordedNodeName. Use these
-    // nextHops for any node that is connected to recordedNodeName that doesn't
-    // already have a lower cost path from thisNodeName
+    // we have the shortest path nexthops for node. Use these nextHops for any
+    // node that is connected to node that doesn't already have a lower cost
+    // path from thisNodeName
     //
     // this is the "relax" step in the Dijkstra Algorithm pseudocode in CLRS
-    for (const auto& link : linksFromNode(recordedNodeName)) {
-      auto& otherNodeName = link->getOtherNodeName(recordedNodeName);
-      if (!link->isUp() or result.count(otherNodeName) or
-          linksToIgnore.count(link)) {
+    auto const nodeMetric = metrics[node];
+    for (auto e = graph.offsets[node]; e < graph.offsets[node + 1]; ++e) {
+      auto const& edge = graph.edges[e];
+      auto const other = edge.toNode;
+      if (settled[other] or
+          (not ignoredLinks.empty() and ignoredLinks[edge.link])) {
         continue;
       }
-      auto metric =
-          useLinkMetric ? link->getMetricFromNode(recordedNodeName) : 1;
-      auto otherNode = q.get(otherNodeName);
-      if (!otherNode) {
-        q.insertNode(otherNodeName, recordedNodeMetric + metric);
-        otherNode = q.get(otherNodeName);
+      auto const metric = nodeMetric + (useLinkMetric ? edge.metric : 1);
+      if (not queued[other]) {
+        queued[other] = true;
+        metrics[other] = metric;
+        q.insertNode(other);
       }
-      if (otherNode->result.metric() >= recordedNodeMetric + metric) {
-        // recordedNodeName is either along an alternate shortest path towards
-        // otherNodeName or is along a new shorter path. In either case,
-        // otherNodeName should use recordedNodeName's nextHops until it finds
-        // some shorter path
-        if (otherNode->result.metric() > recordedNodeMetric + metric) {
+      if (metrics[other] >= metric) {
+        // node is either along an alternate shortest path towards other or is
+        // along a new shorter path. In either case, other should use node's
+        // nextHops until it finds some shorter path
+        if (metrics[other] > metric) {
           // if this is strictly better, forget about any other paths
-          otherNode->result.reset(recordedNodeMetric + metric);
-          q.reMake();
+          metrics[other] = metric;
+          pathLinks[other].clear();
+          nextHops[other].clear();
+          q.decreaseKey(other);
+        }
+        pathLinks[other].emplace_back(edge.link, node);
+        if (dest) {
+          // only path links are needed when tracing paths towards dest
+          continue;
         }
-        otherNode->result.addPath(link, recordedNodeName);
-        otherNode->result.addNextHops(recordedNodeNextHops);
-        if (otherNode->result.nextHops().empty()) {
+        mergedNextHops.clear();
+        std::set_union(
+            nextHops[other].begin(),
+            nextHops[other].end(),
+            nextHops[node].begin(),
+            nextHops[node].end(),
+            std::back_inserter(mergedNextHops));
+        if (mergedNextHops.empty()) {
           // directly connected node
-          otherNode->result.addNextHop(otherNodeName);
+          mergedNextHops.push_back(other);
         }
+        nextHops[other].swap(mergedNextHops);
       }
     }
   }
+
+  result.reserve(settleOrder.size());
+  for (auto const node : settleOrder) {
+    NodeSpfResult nodeResult(metrics[node]);
+    for (auto const& [link, prev] : pathLinks[node]) {
+      nodeResult.addPath(graph.links[link], graph.nodeNames[prev]);
+    }
+    for (auto const nextHop : nextHops[node]) {
+      nodeResult.addNextHop(graph.nodeNames[nextHop]);
+    }
+    result.emplace(graph.nodeNames[node], std::move(nodeResult));
+  }
+
   VLOG(3) << "Dijkstra loop count: " << loop;
   auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(
       std::chrono::steady_clock::now() - startTime);
   LOG(INFO) << "SPF elapsed time: " << deltaTime.count() << "ms.";
-  fb303::fbData->addStatValue("decision.spf_ms", deltaTime.count(), fb303::AVG);
+  kSpfMs.addValue(deltaTime.count());
   return result;
 }
 
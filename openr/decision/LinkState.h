@@ -8,7 +8,12 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <list>
 #include <memory>
+#include <optional>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -101,6 +106,7 @@ class Link {
   HoldableValue<LinkStateMetric> metric1_{1}, metric2_{1};
   HoldableValue<bool> overload1_{false}, overload2_{false};
   int32_t adjLabel1_{0}, adjLabel2_{0};
+  int64_t weight1_{1}, weight2_{1};
   thrift::BinaryAddress nhV41_, nhV42_, nhV61_, nhV62_;
   LinkStateMetric holdUpTtl_{0};
 
@@ -139,6 +145,9 @@ class Link {
 
   bool getOverloadFromNode(const std::string& nodeName) const;
 
+  // weight of the adjacency, e.g. its capacity, used for UCMP
+  int64_t getWeightFromNode(const std::string& nodeName) const;
+
   const thrift::BinaryAddress& getNhV4FromNode(
       const std::string& nodeName) const;
 
@@ -159,6 +168,8 @@ class Link {
 
   void setAdjLabelFromNode(const std::string& nodeName, int32_t adjLabel);
 
+  void setWeightFromNode(const std::string& nodeName, int64_t weight);
+
   bool setOverloadFromNode(
       const std::string& nodeName,
       bool overload,
@@ -172,11 +183,127 @@ class Link {
   std::string toString() const;
 
   std::string directionalToString(const std::string& fromNode) const;
+
+  // estimated heap memory held by this link, see getHeapBytes() of Util.h
+  size_t getHeapBytes() const;
 }; // class Link
 
+// LRU ordered memoization of query results along with an estimate of the
+// memory they hold. Entries are never evicted on insertion, only by evict(),
+// so references handed out by find() and insert() remain valid until then
+template <class Key, class Value>
+class MemoizedResults {
+ public:
+  // returns nullptr if key is not memoized, otherwise marks it most recently
+  // used
+  Value*
+  find(Key const& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->value;
+  }
+
+  // same as find() without marking key used, leaves the results untouched
+  Value const*
+  peek(Key const& key) const {
+    auto it = index_.find(key);
+    return it == index_.end() ? nullptr : &it->second->value;
+  }
+
+  Value&
+  insert(Key const& key, Value&& value, size_t bytes) {
+    CHECK(not index_.count(key));
+    entries_.push_front(Entry{key, std::move(value), bytes});
+    index_.emplace(key, entries_.begin());
+    bytes_ += bytes;
+    return entries_.front().value;
+  }
+
+  // fn(key, value) updates value in place and returns its new size, or
+  // std::nullopt to drop it
+  template <class Fn>
+  void
+  update(Fn&& fn) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      bytes_ -= it->bytes;
+      auto const newBytes = fn(it->key, it->value);
+      if (newBytes) {
+        it->bytes = *newBytes;
+        bytes_ += it->bytes;
+        ++it;
+      } else {
+        index_.erase(it->key);
+        it = entries_.erase(it);
+      }
+    }
+  }
+
+  // drop least recently used entries until at most maxBytes are held,
+  // returns number of entries dropped
+  size_t
+  evict(size_t maxBytes) {
+    size_t numEvicted = 0;
+    while (bytes_ > maxBytes and not entries_.empty()) {
+      bytes_ -= entries_.back().bytes;
+      index_.erase(entries_.back().key);
+      entries_.pop_back();
+      ++numEvicted;
+    }
+    return numEvicted;
+  }
+
+  void
+  clear() {
+    index_.clear();
+    entries_.clear();
+    bytes_ = 0;
+  }
+
+  size_t
+  size() const {
+    return entries_.size();
+  }
+
+  size_t
+  bytes() const {
+    return bytes_;
+  }
+
+ private:
+  struct Entry {
+    Key key;
+    Value value;
+    size_t bytes{0};
+  };
+
+  // most recently used first
+  std::list<Entry> entries_;
+  std::unordered_map<Key, typename std::list<Entry>::iterator> index_;
+  size_t bytes_{0};
+};
+
 class LinkState {
  public:
-  explicit LinkState(const std::string& area);
+  // If enableIncrementalSpf is set, memoized SPF results are repaired in
+  // place when a single link changes instead of being thrown away.
+  // memoizedResultsMaxBytes bounds the memory held by memoized getSpfResult()
+  // and getKthPaths() results once evictMemoizedResults() is called, 0 means
+  // unbounded
+  explicit LinkState(
+      const std::string& area,
+      bool enableIncrementalSpf = false,
+      size_t memoizedResultsMaxBytes = 0);
+
+  // Deep copy, links are not shared with other. Memoized results are not
+  // copied and computed again on demand
+  LinkState(LinkState const& other);
+  LinkState(LinkState&& other) = default;
+
+  LinkState& operator=(LinkState const&) = delete;
+  LinkState& operator=(LinkState&&) = delete;
 
   struct LinkPtrHash {
     size_t operator()(const std::shared_ptr<Link>& l) const;
@@ -267,20 +394,77 @@ class LinkState {
   //
   // each is memoized all params. memoization invalidated for any topolgy
   // altering calls, i.e. if decrementHolds(), updateAdjacencyDatabase(), or
-  // deleteAdjacencyDatabase() returns with LinkState::topologyChanged set true
+  // deleteAdjacencyDatabase() returns with LinkState::topologyChanged set true.
+  // With incremental SPF enabled, memoized getSpfResult() entries are instead
+  // repaired when updateAdjacencyDatabase() changes a single link
   SpfResult const& getSpfResult(
       const std::string& nodeName, bool useLinkMetric = true) const;
 
+  // While set, getSpfResult() hits are looked up under a shared lock without
+  // marking them used, so that concurrent route build shards can share
+  // results memoized up front. Toggled by the thread owning LinkState while
+  // no lookups are running
+  void
+  setSharedSpfLookups(bool sharedSpfLookups) const {
+    spfResultsGuard_.sharedLookups = sharedSpfLookups;
+  }
+
+  // Lookups of getSpfResult() served from memoized results or not, and time
+  // spent running SPF for the latter. Counted since construction, a copy
+  // starts from zero
+  struct SpfStats {
+    size_t cacheHits{0};
+    size_t cacheMisses{0};
+    std::chrono::microseconds spfTime{0};
+  };
+  SpfStats getSpfStats() const;
+
  private:
   // LinkState belongs to a unique area
   const std::string area_;
 
+  // see getSpfStats(), atomic as memoized results are looked up by
+  // concurrent route build shards
+  struct AtomicSpfStats {
+    AtomicSpfStats() = default;
+    AtomicSpfStats(AtomicSpfStats const&) {}
+    AtomicSpfStats&
+    operator=(AtomicSpfStats const&) {
+      return *this;
+    }
+    std::atomic<size_t> cacheHits{0};
+    std::atomic<size_t> cacheMisses{0};
+    std::atomic<int64_t> spfTimeUs{0};
+  };
+  mutable AtomicSpfStats spfStats_;
+
+  // repair memoized SPF results on single link changes rather than
+  // invalidating them (dynamic SPF)
+  bool enableIncrementalSpf_{false};
+
+  // getSpfResult() may be called concurrently, lookups reorder spfResults_
+  // unless sharedLookups is set. Copies and moves get their own
+  struct SpfResultsGuard {
+    SpfResultsGuard() = default;
+    SpfResultsGuard(SpfResultsGuard const&) {}
+    SpfResultsGuard&
+    operator=(SpfResultsGuard const&) {
+      return *this;
+    }
+    std::shared_mutex mutex;
+    bool sharedLookups{false};
+  };
+  mutable SpfResultsGuard spfResultsGuard_;
+
   // memoization structure for getSpfResult()
-  mutable std::unordered_map<
+  mutable MemoizedResults<
       std::pair<std::string /* nodeName */, bool /* useLinkMetric */>,
       SpfResult>
       spfResults_;
 
+  // cap on spfResults_.bytes() + kthPathResults_.bytes(), 0 means unbounded
+  const size_t memoizedResultsMaxBytes_{0};
+
  public:
   // Trace edge-disjoint paths from dest to src.
   // I.e., no two paths returned from this function can share any links
@@ -293,9 +477,53 @@ class LinkState {
   std::vector<LinkState::Path> const& getKthPaths(
       const std::string& src, const std::string& dest, size_t k) const;
 
+  // number of memoized getKthPaths() results
+  size_t
+  getKthPathsCacheSize() const {
+    return kthPathResults_.size();
+  }
+
+  // estimated memory held by memoized getKthPaths() results
+  size_t
+  getKthPathsCacheBytes() const {
+    return kthPathResults_.bytes();
+  }
+
+  // number of memoized getSpfResult() results
+  size_t
+  getSpfCacheSize() const {
+    return spfResults_.size();
+  }
+
+  // estimated memory held by memoized getSpfResult() results
+  size_t
+  getSpfCacheBytes() const {
+    return spfResults_.bytes();
+  }
+
+  // Drop least recently used memoized results until they fit in
+  // memoizedResultsMaxBytes. KSP results go first as they are derived from
+  // SPF results. References returned by getSpfResult() and getKthPaths() are
+  // invalidated, so only call this once done with them
+  void evictMemoizedResults() const;
+
+  // Drop all memoized results, e.g. under memory pressure. Same caveat on
+  // references as evictMemoizedResults()
+  void clearMemoizedResults() const;
+
  private:
+  std::vector<LinkState::Path> computeKthPaths(
+      const std::string& src, const std::string& dest, size_t k) const;
+
+  static size_t getKthPathsEntryBytes(
+      std::tuple<std::string, std::string, size_t> const& key,
+      std::vector<LinkState::Path> const& paths);
+
+  static size_t getSpfResultBytes(
+      std::pair<std::string, bool> const& key, SpfResult const& result);
+
   // memoization structure for getKthPaths()
-  mutable std::unordered_map<
+  mutable MemoizedResults<
       std::tuple<std::string /* src */, std::string /* dest */, size_t /* k */>,
       std::vector<LinkState::Path>>
       kthPathResults_;
@@ -350,7 +578,9 @@ class LinkState {
     return getMetricFromAToB(a, b, false);
   }
 
-  // returns hop count to furthest away node connected to nodeName
+  // returns hop count to furthest away node connected to nodeName. Computed
+  // by a breadth first search and memoized until the set of usable links or
+  // node overloads changes, metric changes keep it
   LinkStateMetric getMaxHopsToNode(const std::string& nodeName) const;
 
   const std::string&
@@ -367,7 +597,11 @@ class LinkState {
 
   bool isNodeOverloaded(const std::string& nodeName) const;
 
-  bool hasHolds() const;
+  // O(1), links and nodes with holds are tracked as holds are set
+  bool
+  hasHolds() const {
+    return not heldLinks_.empty() or not heldNodes_.empty();
+  }
 
   size_t
   numLinks() const {
@@ -379,6 +613,19 @@ class LinkState {
     return linkMap_.size();
   }
 
+  // estimated memory held by the links and adjacency databases, not counting
+  // memoized results, see getSpfCacheBytes() and getKthPathsCacheBytes()
+  size_t getLinkStateBytes() const;
+
+  // bumped whenever a change to this LinkState is reported, i.e. whenever
+  // decrementHolds(), updateAdjacencyDatabase() or deleteAdjacencyDatabase()
+  // return with any LinkStateChange flag set. Lets users tag results derived
+  // from this LinkState
+  uint64_t
+  getGeneration() const {
+    return generation_;
+  }
+
   // get adjacency databases
   std::unordered_map<
       std::string /* nodeName */,
@@ -420,6 +667,63 @@ class LinkState {
       SpfResult const& result,
       LinkSet& linksToIgnore) const;
 
+  // Effective metric of a link in each direction at a point in time.
+  // std::nullopt indicates the link can not be used in that direction
+  struct DirectedMetrics {
+    std::optional<LinkStateMetric> fromFirst;
+    std::optional<LinkStateMetric> fromSecond;
+
+    bool
+    operator==(DirectedMetrics const& other) const {
+      return fromFirst == other.fromFirst && fromSecond == other.fromSecond;
+    }
+  };
+
+  static DirectedMetrics getDirectedMetrics(Link const& link);
+
+  using LinkDirection = std::pair<std::string /* from */, std::string /* to */>;
+
+  // A single link whose usable metrics changed in one update
+  struct LinkChange {
+    std::shared_ptr<Link> link;
+    DirectedMetrics oldMetrics;
+    DirectedMetrics newMetrics;
+  };
+
+  // Bring memoized state in sync after a topology change. SPF results are
+  // repaired in place if incremental SPF is enabled and the change is
+  // confined to a single link, otherwise they're invalidated.
+  void updateMemoizedResults(
+      std::vector<LinkChange> const& linkChanges, bool canRepair);
+
+  // Incrementally update an SPF result computed from `src` to reflect
+  // `change`. The rest of the graph must already reflect the change. Returns
+  // false if the result could not be repaired, in which case it must be
+  // discarded.
+  bool repairSpfResult(
+      std::string const& src,
+      bool useLinkMetric,
+      LinkChange const& change,
+      SpfResult& result) const;
+
+  // Repair when the link became more expensive or unusable in each of
+  // `directions`. Only nodes in the SPF subtree hanging off the link are
+  // recomputed.
+  bool repairSpfResultOnIncrease(
+      std::string const& src,
+      bool useLinkMetric,
+      Link const& link,
+      std::vector<LinkDirection> const& directions,
+      SpfResult& result) const;
+
+  // Repair when the link became cheaper or usable. Nodes are recomputed only
+  // when the new link offers them an equal or better path.
+  bool repairSpfResultOnDecrease(
+      std::string const& src,
+      bool useLinkMetric,
+      std::vector<LinkDirection> const& directions,
+      SpfResult& result) const;
+
   void addLink(std::shared_ptr<Link> link);
 
   void removeLink(std::shared_ptr<Link> link);
@@ -432,6 +736,38 @@ class LinkState {
       LinkStateMetric holdUpTtl,
       LinkStateMetric holdDownTtl);
 
+  // Integer indexed, compressed sparse row (CSR) representation of the
+  // usable links in this LinkState. runSpf() walks this directly so the relax
+  // step does no string hashing or pointer chasing. Lazily built and dropped
+  // on any topology change
+  struct CsrGraph {
+    struct Edge {
+      uint32_t toNode{0};
+      // metric of the link as advertised by the node this edge leaves from
+      LinkStateMetric metric{0};
+      // index into links
+      uint32_t link{0};
+    };
+
+    // interned node names. Ids are assigned in name order so that ties in
+    // Dijkstra are broken exactly as they are on node names
+    std::vector<std::string> nodeNames;
+    std::unordered_map<std::string, uint32_t> nodeIds;
+
+    // nodes not to be used for transit, indexed by node id
+    std::vector<bool> overloaded;
+
+    // edges leaving node i are edges[offsets[i]] .. edges[offsets[i + 1] - 1]
+    std::vector<uint32_t> offsets;
+    std::vector<Edge> edges;
+
+    // every up link, referred to by Edge::link
+    std::vector<std::shared_ptr<Link>> links;
+    std::unordered_map<Link const*, uint32_t> linkIds;
+  };
+
+  CsrGraph const& getCsrGraph() const;
+
   // run Dijkstra's Shortest Path First algorithm on the link state graph
   SpfResult runSpf(
       const std::string& src, /* the source node for the SPF run */
@@ -442,17 +778,20 @@ class LinkState {
           {} /* optionaly specify a set of links to not use when running */)
       const;
 
+  // runSpf() on node ids of getCsrGraph(). ignoredLinks is either empty or a
+  // mask over CsrGraph::links. If dest is set, the run stops once dest is
+  // settled and only path links are computed
+  SpfResult runSpfOnCsrGraph(
+      uint32_t src,
+      bool useLinkMetric,
+      std::vector<bool> const& ignoredLinks,
+      std::optional<uint32_t> dest = std::nullopt) const;
+
   // returns Link object if the reverse adjancency is present in
   // adjacencyDatabases_.at(adj.otherNodeName), else returns nullptr
   std::shared_ptr<Link> maybeMakeLink(
       const std::string& nodeName, const thrift::Adjacency& adj) const;
 
-  std::vector<std::shared_ptr<Link>> getOrderedLinkSet(
-      const thrift::AdjacencyDatabase& adjDb) const;
-
-  std::vector<std::shared_ptr<Link>> orderedLinksFromNode(
-      const std::string& nodeName) const;
-
   // this stores the same link object accessible from either nodeName
   std::unordered_map<std::string /* nodeName */, LinkSet> linkMap_;
 
@@ -462,76 +801,128 @@ class LinkState {
   std::unordered_map<std::string /* nodeName */, HoldableValue<bool>>
       nodeOverloads_;
 
+  // links and nodes (overload) with a hold, decrementHolds() only visits
+  // these
+  LinkSet heldLinks_;
+  std::unordered_set<std::string> heldNodes_;
+
+  // memoization structure for getMaxHopsToNode()
+  mutable std::unordered_map<std::string /* nodeName */, LinkStateMetric>
+      maxHops_;
+
   // the latest AdjacencyDatabase we've received from each node
   std::unordered_map<std::string, thrift::AdjacencyDatabase>
       adjacencyDatabases_;
 
+  // cached CSR view of the graph for runSpf(), see getCsrGraph()
+  mutable std::unique_ptr<CsrGraph> csrGraph_;
+
+  // see getGeneration()
+  uint64_t generation_{0};
+
 }; // class LinkState
 
-// Classes needed for running Dijkstra
-// In addition to implementing the priority queue at the heart of Dijkstra's
-// algorithm, this structure also allows us to store appication specfic data:
-// nexthops.
-class DijkstraQNode {
+// Priority queue at the heart of Dijkstra's algorithm. An indexed binary heap
+// of node ids of LinkState::CsrGraph, ordered by the metrics vector it is
+// constructed with, ties are broken on node id. Tracking the heap position of
+// every node allows for O(log n) decreaseKey()
+class DijkstraQ {
  public:
-  DijkstraQNode(const std::string& n, LinkStateMetric m)
-      : nodeName(n), result(m) {}
-  const std::string nodeName;
-  LinkState::NodeSpfResult result;
-};
+  explicit DijkstraQ(std::vector<LinkStateMetric> const& metrics)
+      : metrics_(metrics), positions_(metrics.size(), kNotQueued) {}
 
-class DijkstraQ {
- private:
-  std::vector<std::shared_ptr<DijkstraQNode>> heap_;
-  std::unordered_map<std::string, std::shared_ptr<DijkstraQNode>> nameToNode_;
+  bool
+  empty() const {
+    return heap_.empty();
+  }
 
-  struct {
-    bool
-    operator()(
-        std::shared_ptr<DijkstraQNode> a,
-        std::shared_ptr<DijkstraQNode> b) const {
-      if (a->result.metric() != b->result.metric()) {
-        return a->result.metric() > b->result.metric();
-      }
-      return a->nodeName > b->nodeName;
+  bool
+  contains(uint32_t nodeId) const {
+    return positions_.at(nodeId) != kNotQueued;
+  }
+
+  void
+  insertNode(uint32_t nodeId) {
+    CHECK(not contains(nodeId));
+    positions_[nodeId] = heap_.size();
+    heap_.push_back(nodeId);
+    siftUp(heap_.size() - 1);
+  }
+
+  uint32_t
+  extractMin() {
+    CHECK(not heap_.empty());
+    auto const min = heap_.front();
+    positions_[min] = kNotQueued;
+    heap_.front() = heap_.back();
+    heap_.pop_back();
+    if (not heap_.empty()) {
+      positions_[heap_.front()] = 0;
+      siftDown(0);
     }
-  } DijkstraQNodeGreater;
+    return min;
+  }
 
- public:
+  // to be called after the metric of a queued node has been lowered
   void
-  insertNode(const std::string& nodeName, LinkStateMetric d) {
-    heap_.push_back(std::make_shared<DijkstraQNode>(nodeName, d));
-    nameToNode_[nodeName] = heap_.back();
-    std::push_heap(heap_.begin(), heap_.end(), DijkstraQNodeGreater);
+  decreaseKey(uint32_t nodeId) {
+    CHECK(contains(nodeId));
+    siftUp(positions_[nodeId]);
   }
 
-  std::shared_ptr<DijkstraQNode>
-  get(const std::string& nodeName) {
-    if (nameToNode_.count(nodeName)) {
-      return nameToNode_.at(nodeName);
+ private:
+  static constexpr size_t kNotQueued = std::numeric_limits<size_t>::max();
+
+  bool
+  less(uint32_t a, uint32_t b) const {
+    if (metrics_[a] != metrics_[b]) {
+      return metrics_[a] < metrics_[b];
     }
-    return nullptr;
+    return a < b;
   }
 
-  std::shared_ptr<DijkstraQNode>
-  extractMin() {
-    if (heap_.empty()) {
-      return nullptr;
+  void
+  siftUp(size_t pos) {
+    auto const nodeId = heap_[pos];
+    while (pos > 0) {
+      auto const parent = (pos - 1) / 2;
+      if (not less(nodeId, heap_[parent])) {
+        break;
+      }
+      heap_[pos] = heap_[parent];
+      positions_[heap_[pos]] = pos;
+      pos = parent;
     }
-    auto min = heap_.at(0);
-    CHECK(nameToNode_.erase(min->nodeName));
-    std::pop_heap(heap_.begin(), heap_.end(), DijkstraQNodeGreater);
-    heap_.pop_back();
-    return min;
+    heap_[pos] = nodeId;
+    positions_[nodeId] = pos;
   }
 
   void
-  reMake() {
-    // this is a bit slow but is rarely called in our application. In fact,
-    // in networks where the metric is hop count, this will never be called
-    // and the Dijkstra run is no different than BFS
-    std::make_heap(heap_.begin(), heap_.end(), DijkstraQNodeGreater);
+  siftDown(size_t pos) {
+    auto const nodeId = heap_[pos];
+    while (true) {
+      auto child = 2 * pos + 1;
+      if (child >= heap_.size()) {
+        break;
+      }
+      if (child + 1 < heap_.size() and less(heap_[child + 1], heap_[child])) {
+        ++child;
+      }
+      if (not less(heap_[child], nodeId)) {
+        break;
+      }
+      heap_[pos] = heap_[child];
+      positions_[heap_[pos]] = pos;
+      pos = child;
+    }
+    heap_[pos] = nodeId;
+    positions_[nodeId] = pos;
   }
+
+  std::vector<LinkStateMetric> const& metrics_;
+  // position of each node id in heap_, kNotQueued if not in the queue
+  std::vector<size_t> positions_;
+  std::vector<uint32_t> heap_;
 };
 } // namespace openr
 
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/decision/NextHopGroup.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace openr {
+
+namespace {
+// order independent hash of a set of next-hops
+size_t
+hashNextHops(NextHopSet::Set const& nexthops) {
+  size_t hash = 0;
+  for (auto const& nexthop : nexthops) {
+    hash += std::hash<thrift::NextHopThrift>()(nexthop);
+  }
+  return hash;
+}
+} // namespace
+
+// All groups in use, looked up by hash of their next-hops. Groups remove
+// themselves once the last NextHopSet referring to them is gone
+struct NextHopSet::Registry {
+  std::mutex mutex;
+  std::unordered_multimap<
+      size_t /* hash */,
+      std::pair<Group const*, std::weak_ptr<const Group>>>
+      groups;
+  uint64_t nextId{1};
+
+  static Registry&
+  get() {
+    // never destroyed, groups may outlive static destruction order
+    static auto* registry = new Registry();
+    return *registry;
+  }
+};
+
+NextHopSet::NextHopSet() : group_(intern(Set{})) {}
+
+NextHopSet::NextHopSet(Set nexthops) : group_(intern(std::move(nexthops))) {}
+
+NextHopSet::NextHopSet(std::initializer_list<value_type> nexthops)
+    : group_(intern(Set(nexthops))) {}
+
+NextHopSet&
+NextHopSet::operator=(Set nexthops) {
+  group_ = intern(std::move(nexthops));
+  return *this;
+}
+
+NextHopSet::size_type
+NextHopSet::erase(value_type const& nexthop) {
+  if (not count(nexthop)) {
+    return 0;
+  }
+  auto nexthops = group_->nexthops;
+  nexthops.erase(nexthop);
+  group_ = intern(std::move(nexthops));
+  return 1;
+}
+
+void
+NextHopSet::clear() {
+  group_ = intern(Set{});
+}
+
+size_t
+NextHopSet::numGroups() {
+  auto& registry = Registry::get();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  return registry.groups.size();
+}
+
+std::shared_ptr<const NextHopSet::Group>
+NextHopSet::intern(Set&& nexthops) {
+  // the empty group is shared without going through the registry
+  static auto const* kEmptyGroup =
+      new std::shared_ptr<const Group>(std::make_shared<Group>());
+  if (nexthops.empty()) {
+    return *kEmptyGroup;
+  }
+
+  auto const hash = hashNextHops(nexthops);
+  auto& registry = Registry::get();
+
+  // groups locked below may be released by their last owner meanwhile, keep
+  // them alive until the registry is unlocked as releasing them locks it
+  std::vector<std::shared_ptr<const Group>> candidates;
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto range = registry.groups.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    auto group = it->second.second.lock();
+    if (group and group->nexthops == nexthops) {
+      return group;
+    }
+    candidates.push_back(std::move(group));
+  }
+
+  std::shared_ptr<const Group> group(
+      new Group{std::move(nexthops), hash, registry.nextId++},
+      [](Group const* group) {
+        auto& registry = Registry::get();
+        {
+          std::lock_guard<std::mutex> lock(registry.mutex);
+          auto range = registry.groups.equal_range(group->hash);
+          for (auto it = range.first; it != range.second; ++it) {
+            if (it->second.first == group) {
+              registry.groups.erase(it);
+              break;
+            }
+          }
+        }
+        delete group;
+      });
+  registry.groups.emplace(
+      hash, std::make_pair(group.get(), std::weak_ptr<const Group>(group)));
+  return group;
+}
+
+} // namespace openr
@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <initializer_list>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+
+#include <openr/common/NetworkUtil.h>
+#include <openr/if/gen-cpp2/Network_types.h>
+
+namespace openr {
+
+/**
+ * Next-hops of a route. Routes with the same next-hops share one immutable,
+ * refcounted group which is interned on construction. Equal sets of
+ * next-hops always refer to the same group while it is in use, so copying and
+ * comparing NextHopSets is cheap and many routes over few ECMP groups only
+ * store each group once.
+ *
+ * Modifiers copy the group, apply the change and intern the result.
+ */
+class NextHopSet {
+ public:
+  using Set = std::unordered_set<thrift::NextHopThrift>;
+  using value_type = Set::value_type;
+  using size_type = Set::size_type;
+  using const_iterator = Set::const_iterator;
+  using iterator = Set::const_iterator;
+
+  NextHopSet();
+
+  /* implicit */ NextHopSet(Set nexthops);
+
+  NextHopSet(std::initializer_list<value_type> nexthops);
+
+  NextHopSet& operator=(Set nexthops);
+
+  const_iterator
+  begin() const {
+    return group_->nexthops.begin();
+  }
+
+  const_iterator
+  end() const {
+    return group_->nexthops.end();
+  }
+
+  size_type
+  size() const {
+    return group_->nexthops.size();
+  }
+
+  bool
+  empty() const {
+    return group_->nexthops.empty();
+  }
+
+  size_type
+  count(value_type const& nexthop) const {
+    return group_->nexthops.count(nexthop);
+  }
+
+  const_iterator
+  find(value_type const& nexthop) const {
+    return group_->nexthops.find(nexthop);
+  }
+
+  template <class... Args>
+  std::pair<const_iterator, bool>
+  emplace(Args&&... args) {
+    value_type nexthop(std::forward<Args>(args)...);
+    if (count(nexthop)) {
+      return {find(nexthop), false};
+    }
+    auto nexthops = group_->nexthops;
+    nexthops.insert(nexthop);
+    group_ = intern(std::move(nexthops));
+    return {find(nexthop), true};
+  }
+
+  std::pair<const_iterator, bool>
+  insert(value_type const& nexthop) {
+    return emplace(nexthop);
+  }
+
+  size_type erase(value_type const& nexthop);
+
+  void clear();
+
+  // underlying set of next-hops
+  Set const&
+  get() const {
+    return group_->nexthops;
+  }
+
+  // identifies the group, equal sets of next-hops have the same id
+  uint64_t
+  id() const {
+    return group_->id;
+  }
+
+  bool
+  operator==(NextHopSet const& other) const {
+    return group_ == other.group_;
+  }
+
+  bool
+  operator!=(NextHopSet const& other) const {
+    return not(*this == other);
+  }
+
+  // number of distinct non-empty groups in use
+  static size_t numGroups();
+
+ private:
+  struct Group {
+    Set nexthops;
+    size_t hash{0};
+    uint64_t id{0};
+  };
+  struct Registry;
+
+  static std::shared_ptr<const Group> intern(Set&& nexthops);
+
+  std::shared_ptr<const Group> group_;
+};
+
+inline bool
+operator==(NextHopSet const& lhs, NextHopSet::Set const& rhs) {
+  return lhs.get() == rhs;
+}
+
+inline bool
+operator==(NextHopSet::Set const& lhs, NextHopSet const& rhs) {
+  return lhs == rhs.get();
+}
+
+inline bool
+operator!=(NextHopSet const& lhs, NextHopSet::Set const& rhs) {
+  return not(lhs == rhs);
+}
+
+inline bool
+operator!=(NextHopSet::Set const& lhs, NextHopSet const& rhs) {
+  return not(lhs == rhs);
+}
+
+} // namespace openr
@@ -7,54 +7,94 @@
 
 #include "openr/decision/PrefixState.h"
 
+#include <algorithm>
+
+#include <openr/common/Pagination.h>
 #include <openr/common/Util.h>
 
 using apache::thrift::can_throw;
 
+namespace {
+bool
+isKsp2PrefixEntry(openr::thrift::PrefixEntry const& prefixEntry) {
+  return *prefixEntry.forwardingAlgorithm_ref() ==
+      openr::thrift::PrefixForwardingAlgorithm::KSP2_ED_ECMP;
+}
+} // namespace
+
 namespace openr {
 
-std::unordered_set<thrift::IpPrefix>
+std::unordered_set<folly::CIDRNetwork>
 PrefixState::updatePrefixDatabase(thrift::PrefixDatabase const& prefixDb) {
-  std::unordered_set<thrift::IpPrefix> changed;
+  std::unordered_set<folly::CIDRNetwork> changed;
 
   auto const nodeAndArea =
       std::make_pair(*prefixDb.thisNodeName_ref(), *prefixDb.area_ref());
   auto const& nodeName = *prefixDb.thisNodeName_ref();
   auto const& area = *prefixDb.area_ref();
 
-  // Get reference existing set or create new one
-  auto& newPrefixSet = nodeToPrefixes_[nodeAndArea];
-
-  // Create copy of existing prefix set - NOTE explicit copy
-  const std::set<thrift::IpPrefix> oldPrefixSet = newPrefixSet;
-
-  // update the entry
-  newPrefixSet.clear();
+  // Convert announced prefixes once and sort them to diff against the
+  // sorted prefixes announced before
+  std::vector<std::pair<folly::CIDRNetwork, thrift::PrefixEntry const*>>
+      newEntries;
+  newEntries.reserve(prefixDb.prefixEntries_ref()->size());
   for (const auto& prefixEntry : *prefixDb.prefixEntries_ref()) {
-    newPrefixSet.emplace(*prefixEntry.prefix_ref());
+    newEntries.emplace_back(
+        toIPNetwork(*prefixEntry.prefix_ref()), &prefixEntry);
   }
+  std::stable_sort(
+      newEntries.begin(), newEntries.end(), [](auto const& a, auto const& b) {
+        return a.first < b.first;
+      });
 
-  // Remove old prefixes first
-  for (const auto& prefix : oldPrefixSet) {
-    if (newPrefixSet.count(prefix)) {
+  // Last announcement of a prefix wins if it is announced more than once
+  size_t numNewEntries{0};
+  for (size_t i = 0; i < newEntries.size(); ++i) {
+    if (i + 1 < newEntries.size() and
+        newEntries[i + 1].first == newEntries[i].first) {
+      continue;
+    }
+    newEntries[numNewEntries++] = newEntries[i];
+  }
+  newEntries.resize(numNewEntries);
+
+  // Get reference existing prefixes or create new one
+  auto& nodePrefixes = nodeToPrefixes_[nodeAndArea];
+
+  // Remove old prefixes first, walking both sorted sequences
+  auto newIt = newEntries.cbegin();
+  for (const auto& prefix : nodePrefixes) {
+    while (newIt != newEntries.cend() and newIt->first < prefix) {
+      ++newIt;
+    }
+    if (newIt != newEntries.cend() and newIt->first == prefix) {
       continue;
     }
 
-    VLOG(1) << "Prefix " << toString(prefix) << " has been withdrawn by "
-            << nodeName << " from area " << area;
+    VLOG(1) << "Prefix " << folly::IPAddress::networkToString(prefix)
+            << " has been withdrawn by " << nodeName << " from area " << area;
 
     // Update prefix
     auto& entriesByOriginator = prefixes_.at(prefix);
+    numKsp2PrefixEntries_ -=
+        isKsp2PrefixEntry(entriesByOriginator.at(nodeAndArea));
     entriesByOriginator.erase(nodeAndArea);
     if (entriesByOriginator.empty()) {
       prefixes_.erase(prefix);
+      prefixTrie_.erase(toIpPrefix(prefix));
     }
     changed.insert(prefix);
   }
 
   // update prefix entry for new announcement
-  for (const auto& prefixEntry : *prefixDb.prefixEntries_ref()) {
-    auto& entriesByOriginator = prefixes_[*prefixEntry.prefix_ref()];
+  nodePrefixes.clear();
+  for (const auto& [prefix, prefixEntryPtr] : newEntries) {
+    auto const& prefixEntry = *prefixEntryPtr;
+    nodePrefixes.emplace_back(prefix);
+    auto& entriesByOriginator = prefixes_[prefix];
+    if (entriesByOriginator.empty()) {
+      prefixTrie_.insert(toIpPrefix(prefix));
+    }
 
     // Skip rest of code, if prefix exists and has no change
     auto [it, inserted] = entriesByOriginator.emplace(nodeAndArea, prefixEntry);
@@ -64,46 +104,240 @@ PrefixState::updatePrefixDatabase(thrift::PrefixDatabase const& prefixDb) {
 
     // Update prefix
     if (not inserted) {
+      numKsp2PrefixEntries_ -= isKsp2PrefixEntry(it->second);
       it->second = prefixEntry;
     }
-    changed.insert(*prefixEntry.prefix_ref());
+    numKsp2PrefixEntries_ += isKsp2PrefixEntry(prefixEntry);
+    changed.insert(prefix);
 
-    VLOG(1) << "Prefix " << toString(*prefixEntry.prefix_ref())
+    VLOG(1) << "Prefix " << folly::IPAddress::networkToString(prefix)
             << " has been advertised/updated by node " << nodeName
             << " from area " << area;
   }
 
-  if (newPrefixSet.empty()) {
+  if (nodePrefixes.empty()) {
     nodeToPrefixes_.erase(nodeAndArea);
   }
+  for (auto const& prefix : changed) {
+    updateConflictingPrefix(prefix);
+  }
 
   // TODO: check reference count threshold for local originiated prefixes
 
   return changed;
 }
 
+std::unordered_set<folly::CIDRNetwork>
+PrefixState::updatePrefix(
+    NodeAndArea const& nodeAndArea,
+    folly::CIDRNetwork const& prefix,
+    thrift::PrefixEntry const& prefixEntry) {
+  auto& entriesByOriginator = prefixes_[prefix];
+  if (entriesByOriginator.empty()) {
+    prefixTrie_.insert(toIpPrefix(prefix));
+  }
+  auto [it, inserted] = entriesByOriginator.emplace(nodeAndArea, prefixEntry);
+  if (not inserted) {
+    if (it->second == prefixEntry) {
+      return {};
+    }
+    numKsp2PrefixEntries_ -= isKsp2PrefixEntry(it->second);
+    it->second = prefixEntry;
+  } else {
+    auto& nodePrefixes = nodeToPrefixes_[nodeAndArea];
+    nodePrefixes.insert(
+        std::lower_bound(nodePrefixes.begin(), nodePrefixes.end(), prefix),
+        prefix);
+  }
+  numKsp2PrefixEntries_ += isKsp2PrefixEntry(prefixEntry);
+  updateConflictingPrefix(prefix);
+
+  VLOG(1) << "Prefix " << folly::IPAddress::networkToString(prefix)
+          << " has been advertised/updated by node " << nodeAndArea.first
+          << " from area " << nodeAndArea.second;
+  return {prefix};
+}
+
+std::unordered_set<folly::CIDRNetwork>
+PrefixState::deletePrefix(
+    NodeAndArea const& nodeAndArea, folly::CIDRNetwork const& prefix) {
+  auto prefixIt = prefixes_.find(prefix);
+  if (prefixIt == prefixes_.end()) {
+    return {};
+  }
+  auto& entriesByOriginator = prefixIt->second;
+  auto it = entriesByOriginator.find(nodeAndArea);
+  if (it == entriesByOriginator.end()) {
+    return {};
+  }
+
+  VLOG(1) << "Prefix " << folly::IPAddress::networkToString(prefix)
+          << " has been withdrawn by " << nodeAndArea.first << " from area "
+          << nodeAndArea.second;
+
+  numKsp2PrefixEntries_ -= isKsp2PrefixEntry(it->second);
+  entriesByOriginator.erase(it);
+  if (entriesByOriginator.empty()) {
+    prefixes_.erase(prefixIt);
+    prefixTrie_.erase(toIpPrefix(prefix));
+  }
+  updateConflictingPrefix(prefix);
+
+  auto& nodePrefixes = nodeToPrefixes_.at(nodeAndArea);
+  nodePrefixes.erase(
+      std::lower_bound(nodePrefixes.begin(), nodePrefixes.end(), prefix));
+  if (nodePrefixes.empty()) {
+    nodeToPrefixes_.erase(nodeAndArea);
+  }
+  return {prefix};
+}
+
 std::unordered_map<std::string /* nodeName */, thrift::PrefixDatabase>
 PrefixState::getPrefixDatabases() const {
   std::unordered_map<std::string, thrift::PrefixDatabase> prefixDatabases;
   for (auto const& [nodeAndArea, prefixes] : nodeToPrefixes_) {
-    thrift::PrefixDatabase prefixDb;
-    *prefixDb.thisNodeName_ref() = nodeAndArea.first;
-    prefixDb.area_ref() = nodeAndArea.second;
-    for (auto const& prefix : prefixes) {
-      prefixDb.prefixEntries_ref()->emplace_back(
-          prefixes_.at(prefix).at(nodeAndArea));
+    prefixDatabases.emplace(
+        nodeAndArea.first, getPrefixDatabase(nodeAndArea, prefixes));
+  }
+  return prefixDatabases;
+}
+
+std::unordered_map<std::string, thrift::PrefixDatabase>
+PrefixState::getPrefixDatabasesPage(
+    std::optional<std::string> const& cursor,
+    size_t limit,
+    std::optional<std::string>& nextCursor) const {
+  auto const nodes = getPageKeys<std::string>(
+      nodeToPrefixes_,
+      [](auto const& kv) -> std::string const& { return kv.first.first; },
+      cursor,
+      limit);
+  if (limit > 0 and nodes.size() == limit) {
+    nextCursor = nodes.back();
+  }
+
+  std::unordered_set<std::string> const pageNodes(nodes.begin(), nodes.end());
+  std::unordered_map<std::string, thrift::PrefixDatabase> prefixDatabases;
+  for (auto const& [nodeAndArea, prefixes] : nodeToPrefixes_) {
+    if (pageNodes.count(nodeAndArea.first)) {
+      prefixDatabases.emplace(
+          nodeAndArea.first, getPrefixDatabase(nodeAndArea, prefixes));
     }
-    prefixDatabases.emplace(nodeAndArea.first, std::move(prefixDb));
   }
   return prefixDatabases;
 }
 
+thrift::PrefixDatabase
+PrefixState::getPrefixDatabase(
+    NodeAndArea const& nodeAndArea,
+    std::vector<folly::CIDRNetwork> const& prefixes) const {
+  thrift::PrefixDatabase prefixDb;
+  *prefixDb.thisNodeName_ref() = nodeAndArea.first;
+  prefixDb.area_ref() = nodeAndArea.second;
+  for (auto const& prefix : prefixes) {
+    prefixDb.prefixEntries_ref()->emplace_back(
+        prefixes_.at(prefix).at(nodeAndArea));
+  }
+  return prefixDb;
+}
+
+std::vector<folly::CIDRNetwork> const&
+PrefixState::getNodePrefixes(NodeAndArea const& nodeAndArea) const {
+  static const std::vector<folly::CIDRNetwork> kNoPrefixes;
+  auto it = nodeToPrefixes_.find(nodeAndArea);
+  return it != nodeToPrefixes_.end() ? it->second : kNoPrefixes;
+}
+
+size_t
+PrefixState::getPrefixesBytes() const {
+  // rough estimate counting the hash/tree nodes and heap allocations of entries
+  size_t bytes = 0;
+  for (auto const& [prefix, prefixEntries] : prefixes_) {
+    bytes += kHashNodeBytes + sizeof(prefix) + sizeof(prefixEntries) +
+        prefixEntries.bucket_count() * sizeof(void*);
+    for (auto const& [nodeAndArea, prefixEntry] : prefixEntries) {
+      bytes += kHashNodeBytes + sizeof(nodeAndArea) + sizeof(prefixEntry) +
+          getHeapBytes(nodeAndArea.first) + getHeapBytes(nodeAndArea.second) +
+          getHeapBytes(prefixEntry);
+    }
+  }
+  for (auto const& [nodeAndArea, prefixes] : nodeToPrefixes_) {
+    bytes += kHashNodeBytes + sizeof(nodeAndArea) + sizeof(prefixes) +
+        getHeapBytes(nodeAndArea.first) + getHeapBytes(nodeAndArea.second) +
+        prefixes.capacity() * sizeof(folly::CIDRNetwork);
+  }
+  return bytes;
+}
+
+std::optional<std::vector<folly::CIDRNetwork>>
+PrefixState::getFilteredPrefixes(
+    thrift::ReceivedRouteFilter const& filter) const {
+  std::optional<folly::CIDRNetwork> coveringPrefix;
+  if (filter.coveringPrefix_ref()) {
+    coveringPrefix = toIPNetwork(*filter.coveringPrefix_ref());
+  }
+  auto const isCovered = [&coveringPrefix](folly::CIDRNetwork const& prefix) {
+    return not coveringPrefix.has_value() or
+        (prefix.second >= coveringPrefix->second and
+         prefix.first.inSubnet(coveringPrefix->first, coveringPrefix->second));
+  };
+
+  std::vector<folly::CIDRNetwork> prefixes;
+  if (filter.prefixes_ref()) {
+    // keep order of the prefixes filter
+    for (auto const& prefix : *filter.prefixes_ref()) {
+      auto const network = toIPNetwork(prefix);
+      if (isCovered(network)) {
+        prefixes.emplace_back(network);
+      }
+    }
+    return prefixes;
+  }
+
+  if (filter.nodeName_ref() and filter.areaName_ref()) {
+    for (auto const& prefix : getNodePrefixes(
+             {*filter.nodeName_ref(), *filter.areaName_ref()})) {
+      if (isCovered(prefix)) {
+        prefixes.emplace_back(prefix);
+      }
+    }
+    return prefixes;
+  }
+
+  if (coveringPrefix.has_value()) {
+    for (auto const& prefix : prefixTrie_.coveredPrefixes(*coveringPrefix)) {
+      prefixes.emplace_back(toIPNetwork(prefix));
+    }
+    return prefixes;
+  }
+
+  if (filter.nodeName_ref() or filter.areaName_ref()) {
+    // union of prefixes of the node in all areas, or of all nodes in the area
+    for (auto const& [nodeAndArea, nodePrefixes] : nodeToPrefixes_) {
+      if ((filter.nodeName_ref() and
+           *filter.nodeName_ref() != nodeAndArea.first) or
+          (filter.areaName_ref() and
+           *filter.areaName_ref() != nodeAndArea.second)) {
+        continue;
+      }
+      prefixes.insert(prefixes.end(), nodePrefixes.begin(), nodePrefixes.end());
+    }
+    std::sort(prefixes.begin(), prefixes.end());
+    prefixes.erase(
+        std::unique(prefixes.begin(), prefixes.end()), prefixes.end());
+    return prefixes;
+  }
+
+  return std::nullopt;
+}
+
 std::vector<thrift::ReceivedRouteDetail>
 PrefixState::getReceivedRoutesFiltered(
     thrift::ReceivedRouteFilter const& filter) const {
   std::vector<thrift::ReceivedRouteDetail> routes;
-  if (filter.prefixes_ref()) {
-    for (auto& prefix : filter.prefixes_ref().value()) {
+  auto const filteredPrefixes = getFilteredPrefixes(filter);
+  if (filteredPrefixes.has_value()) {
+    for (auto const& prefix : *filteredPrefixes) {
       auto it = prefixes_.find(prefix);
       if (it == prefixes_.end()) {
         continue;
@@ -128,12 +362,57 @@ PrefixState::getReceivedRoutesFiltered(
   return routes;
 }
 
+std::vector<thrift::ReceivedRouteDetail>
+PrefixState::getReceivedRoutesFilteredPage(
+    thrift::ReceivedRouteFilter const& filter,
+    std::optional<thrift::IpPrefix> const& cursor,
+    size_t limit,
+    std::optional<thrift::IpPrefix>& nextCursor) const {
+  std::optional<folly::CIDRNetwork> cursorNetwork;
+  if (cursor.has_value()) {
+    cursorNetwork = toIPNetwork(cursor.value());
+  }
+  std::vector<folly::CIDRNetwork> pagePrefixes;
+  auto const filteredPrefixes = getFilteredPrefixes(filter);
+  if (filteredPrefixes.has_value()) {
+    pagePrefixes = getPageKeys<folly::CIDRNetwork>(
+        *filteredPrefixes,
+        [](auto const& prefix) -> folly::CIDRNetwork const& { return prefix; },
+        cursorNetwork,
+        limit);
+  } else {
+    pagePrefixes = getPageKeys<folly::CIDRNetwork>(
+        prefixes_,
+        [](auto const& kv) -> folly::CIDRNetwork const& { return kv.first; },
+        cursorNetwork,
+        limit);
+  }
+  if (limit > 0 and pagePrefixes.size() == limit) {
+    nextCursor = toIpPrefix(pagePrefixes.back());
+  }
+
+  std::vector<thrift::ReceivedRouteDetail> routes;
+  for (auto const& prefix : pagePrefixes) {
+    auto it = prefixes_.find(prefix);
+    if (it == prefixes_.end()) {
+      continue;
+    }
+    filterAndAddReceivedRoute(
+        routes,
+        filter.nodeName_ref(),
+        filter.areaName_ref(),
+        it->first,
+        it->second);
+  }
+  return routes;
+}
+
 void
 PrefixState::filterAndAddReceivedRoute(
     std::vector<thrift::ReceivedRouteDetail>& routes,
     apache::thrift::optional_field_ref<const std::string&> const& nodeFilter,
     apache::thrift::optional_field_ref<const std::string&> const& areaFilter,
-    thrift::IpPrefix const& prefix,
+    folly::CIDRNetwork const& prefix,
     PrefixEntries const& prefixEntries) {
   // Return immediately if no prefix-entry
   if (prefixEntries.empty()) {
@@ -141,7 +420,7 @@ PrefixState::filterAndAddReceivedRoute(
   }
 
   thrift::ReceivedRouteDetail routeDetail;
-  routeDetail.prefix_ref() = prefix;
+  routeDetail.prefix_ref() = toIpPrefix(prefix);
 
   // Add prefix entries and honor the filter
   for (auto& [nodeAndArea, prefixEntry] : prefixEntries) {
@@ -164,6 +443,16 @@ PrefixState::filterAndAddReceivedRoute(
   }
 }
 
+void
+PrefixState::updateConflictingPrefix(folly::CIDRNetwork const& prefix) {
+  auto it = prefixes_.find(prefix);
+  if (it != prefixes_.end() and hasConflictingForwardingInfo(it->second)) {
+    conflictingPrefixes_.insert(prefix);
+  } else {
+    conflictingPrefixes_.erase(prefix);
+  }
+}
+
 bool
 PrefixState::hasConflictingForwardingInfo(const PrefixEntries& prefixEntries) {
   // Empty prefix entries doesn't indicate conflicting information
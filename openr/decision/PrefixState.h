@@ -7,11 +7,13 @@
 
 #pragma once
 
-#include <set>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/PrefixTrie.h>
 #include <openr/common/Types.h>
 #include <openr/if/gen-cpp2/Decision_types.h>
 #include <openr/if/gen-cpp2/Lsdb_types.h>
@@ -22,22 +24,60 @@ namespace openr {
 
 class PrefixState {
  public:
-  std::unordered_map<thrift::IpPrefix, PrefixEntries> const&
+  std::unordered_map<folly::CIDRNetwork, PrefixEntries> const&
   prefixes() const {
     return prefixes_;
   }
 
   // returns set of changed prefixes (i.e. a node started advertising or
   // withdrew or any attributes changed)
-  std::unordered_set<thrift::IpPrefix> updatePrefixDatabase(
+  std::unordered_set<folly::CIDRNetwork> updatePrefixDatabase(
       thrift::PrefixDatabase const& prefixDb);
 
+  // single prefix versions of updatePrefixDatabase(), for nodes advertising
+  // per prefix keys. Return set of changed prefixes as well
+  std::unordered_set<folly::CIDRNetwork> updatePrefix(
+      NodeAndArea const& nodeAndArea,
+      folly::CIDRNetwork const& prefix,
+      thrift::PrefixEntry const& prefixEntry);
+  std::unordered_set<folly::CIDRNetwork> deletePrefix(
+      NodeAndArea const& nodeAndArea, folly::CIDRNetwork const& prefix);
+
   std::unordered_map<std::string /* nodeName */, thrift::PrefixDatabase>
   getPrefixDatabases() const;
 
+  // page of getPrefixDatabases() in node name order, see getPageKeys().
+  // nextCursor is set unless this may be the last page
+  std::unordered_map<std::string /* nodeName */, thrift::PrefixDatabase>
+  getPrefixDatabasesPage(
+      std::optional<std::string> const& cursor,
+      size_t limit,
+      std::optional<std::string>& nextCursor) const;
+
+  // prefixes advertised by the given node in the given area, sorted
+  std::vector<folly::CIDRNetwork> const& getNodePrefixes(
+      NodeAndArea const& nodeAndArea) const;
+
+  // estimated memory held by prefixes_ and nodeToPrefixes_
+  size_t getPrefixesBytes() const;
+
+  // whether any prefix entry asks for KSP2_ED_ECMP forwarding
+  bool
+  hasKsp2PrefixEntries() const {
+    return numKsp2PrefixEntries_ > 0;
+  }
+
   std::vector<thrift::ReceivedRouteDetail> getReceivedRoutesFiltered(
       thrift::ReceivedRouteFilter const& filter) const;
 
+  // page of getReceivedRoutesFiltered() in prefix order. Prefixes without
+  // routes matching the node and area filters may count towards the limit
+  std::vector<thrift::ReceivedRouteDetail> getReceivedRoutesFilteredPage(
+      thrift::ReceivedRouteFilter const& filter,
+      std::optional<thrift::IpPrefix> const& cursor,
+      size_t limit,
+      std::optional<thrift::IpPrefix>& nextCursor) const;
+
   /**
    * Filter routes only the <type> attribute
    */
@@ -45,7 +85,7 @@ class PrefixState {
       std::vector<thrift::ReceivedRouteDetail>& routes,
       apache::thrift::optional_field_ref<const std::string&> const& nodeFilter,
       apache::thrift::optional_field_ref<const std::string&> const& areaFilter,
-      thrift::IpPrefix const& prefix,
+      folly::CIDRNetwork const& prefix,
       PrefixEntries const& prefixEntries);
 
   /**
@@ -54,7 +94,27 @@ class PrefixState {
    */
   static bool hasConflictingForwardingInfo(PrefixEntries const& prefixEntries);
 
+  // prefixes whose entries have conflicting forwarding info, see
+  // hasConflictingForwardingInfo(). Kept up to date as prefixes change
+  std::unordered_set<folly::CIDRNetwork> const&
+  getConflictingPrefixes() const {
+    return conflictingPrefixes_;
+  }
+
  private:
+  thrift::PrefixDatabase getPrefixDatabase(
+      NodeAndArea const& nodeAndArea,
+      std::vector<folly::CIDRNetwork> const& prefixes) const;
+
+  // candidate prefixes of the filter looked up in the narrowest index, or
+  // std::nullopt if all prefixes are candidates. Routes of candidates still
+  // need to be matched against the node and area filters
+  std::optional<std::vector<folly::CIDRNetwork>> getFilteredPrefixes(
+      thrift::ReceivedRouteFilter const& filter) const;
+
+  // re-evaluate whether a changed prefix is in conflictingPrefixes_
+  void updateConflictingPrefix(folly::CIDRNetwork const& prefix);
+
   // TODO: Also maintain clean list of reachable prefix entries. A node might
   // become un-reachable we might still have their prefix entries, until gets
   // expired in KvStore. This will simplify logic in route computation where
@@ -65,12 +125,24 @@ class PrefixState {
   // route re-distribution
 
   // Data structure to maintain mapping from:
-  //  IpPrefix -> collection of originator(i.e. [node, area] combination)
-  std::unordered_map<thrift::IpPrefix, PrefixEntries> prefixes_;
+  //  prefix -> collection of originator(i.e. [node, area] combination)
+  // Prefixes are kept as folly::CIDRNetwork, converted once on update,
+  // as this is what route computation works with
+  std::unordered_map<folly::CIDRNetwork, PrefixEntries> prefixes_;
 
   // (Reverse Mapping) Data structure to maintain mapping from:
-  //  [node, area] combination -> set of IpPrefix
-  std::unordered_map<NodeAndArea, std::set<thrift::IpPrefix>> nodeToPrefixes_;
+  //  [node, area] combination -> sorted vector of prefixes
+  std::unordered_map<NodeAndArea, std::vector<folly::CIDRNetwork>>
+      nodeToPrefixes_;
+
+  // prefixes_ keys, for lookup of prefixes within a covering prefix
+  PrefixTrie prefixTrie_;
+
+  // number of prefix entries with KSP2_ED_ECMP forwarding algorithm
+  size_t numKsp2PrefixEntries_{0};
+
+  // see getConflictingPrefixes()
+  std::unordered_set<folly::CIDRNetwork> conflictingPrefixes_;
 
   // loopbackV4/V6 address for each node
   std::unordered_map<std::string, thrift::BinaryAddress> nodeHostLoopbacksV4_;
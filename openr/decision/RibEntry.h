@@ -13,6 +13,7 @@
 
 #include <folly/IPAddress.h>
 #include <openr/common/NetworkUtil.h>
+#include <openr/decision/NextHopGroup.h>
 #include <openr/if/gen-cpp2/Lsdb_types.h>
 #include <openr/if/gen-cpp2/Network_types.h>
 
@@ -20,10 +21,11 @@ namespace openr {
 
 struct RibEntry {
   // TODO: should this be map<area, nexthops>?
-  std::unordered_set<thrift::NextHopThrift> nexthops;
+  // interned, routes with the same next-hops share them
+  NextHopSet nexthops;
 
   // constructor
-  explicit RibEntry(std::unordered_set<thrift::NextHopThrift> nexthops)
+  explicit RibEntry(NextHopSet nexthops)
       : nexthops(std::move(nexthops)) {}
 
   RibEntry() = default;
@@ -40,18 +42,19 @@ struct RibUnicastEntry : RibEntry {
   std::string bestArea;
   // install to fib or not
   bool doNotInstall{false};
+  // Loop-free alternates over other interfaces than nexthops, not installed.
+  // Fib switches the route to them once all of nexthops are down
+  NextHopSet backupNexthops;
 
   // constructor
   explicit RibUnicastEntry(const folly::CIDRNetwork& prefix) : prefix(prefix) {}
 
-  RibUnicastEntry(
-      const folly::CIDRNetwork& prefix,
-      std::unordered_set<thrift::NextHopThrift> nexthops)
+  RibUnicastEntry(const folly::CIDRNetwork& prefix, NextHopSet nexthops)
       : RibEntry(std::move(nexthops)), prefix(prefix) {}
 
   RibUnicastEntry(
       const folly::CIDRNetwork& prefix,
-      std::unordered_set<thrift::NextHopThrift> nexthops,
+      NextHopSet nexthops,
       thrift::PrefixEntry bestPrefixEntry,
       const std::string& bestArea,
       bool doNotInstall = false)
@@ -63,8 +66,10 @@ struct RibUnicastEntry : RibEntry {
 
   bool
   operator==(const RibUnicastEntry& other) const {
-    return prefix == other.prefix && bestPrefixEntry == other.bestPrefixEntry &&
-        doNotInstall == other.doNotInstall && RibEntry::operator==(other);
+    // cheapest comparisons first, next-hops compare by interned group
+    return doNotInstall == other.doNotInstall && RibEntry::operator==(other) &&
+        backupNexthops == other.backupNexthops && prefix == other.prefix &&
+        bestPrefixEntry == other.bestPrefixEntry;
   }
 
   bool
@@ -79,6 +84,10 @@ struct RibUnicastEntry : RibEntry {
     *tUnicast.nextHops_ref() =
         std::vector<thrift::NextHopThrift>(nexthops.begin(), nexthops.end());
     *tUnicast.doNotInstall_ref() = doNotInstall;
+    if (not backupNexthops.empty()) {
+      tUnicast.backupNextHops_ref() = std::vector<thrift::NextHopThrift>(
+          backupNexthops.begin(), backupNexthops.end());
+    }
     if (*bestPrefixEntry.type_ref() == thrift::PrefixType::BGP) {
       tUnicast.prefixType_ref() = thrift::PrefixType::BGP;
       if (bestPrefixEntry.data_ref()) {
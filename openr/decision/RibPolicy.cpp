@@ -7,7 +7,12 @@
 
 #include <openr/decision/RibPolicy.h>
 
+#include <algorithm>
+#include <iterator>
+#include <optional>
+
 #include <fb303/ServiceData.h>
+#include <folly/Format.h>
 #include <folly/MapUtil.h>
 
 namespace openr {
@@ -16,8 +21,22 @@ namespace openr {
 // RibPolicyStatement
 //
 
+bool
+RibPolicyStatement::PrefixRange::contains(
+    const folly::CIDRNetwork& prefix) const {
+  return prefix.first.family() == network.first.family() and
+      prefix.second >= ge and prefix.second <= le and
+      prefix.first.mask(network.second) == network.first;
+}
+
 RibPolicyStatement::RibPolicyStatement(const thrift::RibPolicyStatement& stmt)
-    : name_(*stmt.name_ref()), action_(*stmt.action_ref()) {
+    : name_(*stmt.name_ref()),
+      matcher_(*stmt.matcher_ref()),
+      hasPrefixCriteria_(
+          matcher_.prefixes_ref().has_value() or
+          matcher_.prefix_ranges_ref().has_value()),
+      hasTagCriteria_(matcher_.tags_ref().has_value()),
+      action_(*stmt.action_ref()) {
   // Verify that at-least one action must be specified
   if (not stmt.action_ref()->set_weight_ref()) {
     thrift::OpenrError error;
@@ -27,16 +46,42 @@ RibPolicyStatement::RibPolicyStatement(const thrift::RibPolicyStatement& stmt)
   }
 
   // Verify that at-least one match criteria must be specified
-  if (not stmt.matcher_ref()->prefixes_ref()) {
+  if (not hasPrefixCriteria_ and not hasTagCriteria_) {
     thrift::OpenrError error;
     *error.message_ref() =
-        "Missing policy_statement.matcher.prefixes attribute";
+        "Missing policy_statement.matcher.prefixes, prefix_ranges or tags "
+        "attribute";
     throw error;
   }
 
   // Populate the match fields
-  for (const auto& tPrefix : *stmt.matcher_ref()->prefixes_ref()) {
-    prefixSet_.insert(toIPNetwork(tPrefix));
+  if (matcher_.prefixes_ref().has_value()) {
+    for (const auto& tPrefix : *matcher_.prefixes_ref()) {
+      prefixSet_.insert(toIPNetwork(tPrefix));
+    }
+  }
+  if (matcher_.prefix_ranges_ref().has_value()) {
+    for (const auto& range : *matcher_.prefix_ranges_ref()) {
+      const auto network = toIPNetwork(*range.prefix_ref());
+      const int32_t maxLen = network.first.bitCount();
+      const int32_t ge = range.ge_ref().value_or(network.second);
+      const int32_t le =
+          range.le_ref().value_or(range.ge_ref().has_value() ? maxLen : ge);
+      if (ge < network.second or le < ge or le > maxLen) {
+        thrift::OpenrError error;
+        *error.message_ref() = folly::sformat(
+            "Invalid policy_statement.matcher.prefix_ranges {} ge {} le {}",
+            folly::IPAddress::networkToString(network),
+            ge,
+            le);
+        throw error;
+      }
+      prefixRanges_.emplace_back(PrefixRange{
+          network, static_cast<uint8_t>(ge), static_cast<uint8_t>(le)});
+    }
+  }
+  if (matcher_.tags_ref().has_value()) {
+    tags_.insert(matcher_.tags_ref()->begin(), matcher_.tags_ref()->end());
   }
 }
 
@@ -45,16 +90,35 @@ RibPolicyStatement::toThrift() const {
   thrift::RibPolicyStatement stmt;
   *stmt.name_ref() = name_;
   *stmt.action_ref() = action_;
-  stmt.matcher_ref()->prefixes_ref() = std::vector<thrift::IpPrefix>();
-  for (auto const& prefix : prefixSet_) {
-    stmt.matcher_ref()->prefixes_ref()->emplace_back(toIpPrefix(prefix));
-  }
+  *stmt.matcher_ref() = matcher_;
   return stmt;
 }
 
 bool
 RibPolicyStatement::match(const RibUnicastEntry& route) const {
-  return prefixSet_.count(route.prefix) > 0;
+  return (not hasPrefixCriteria_ or matchPrefix(route.prefix)) and
+      (not hasTagCriteria_ or matchTags(route));
+}
+
+bool
+RibPolicyStatement::matchPrefix(const folly::CIDRNetwork& prefix) const {
+  if (prefixSet_.count(prefix)) {
+    return true;
+  }
+  return std::any_of(
+      prefixRanges_.begin(), prefixRanges_.end(), [&](auto const& range) {
+        return range.contains(prefix);
+      });
+}
+
+bool
+RibPolicyStatement::matchTags(const RibUnicastEntry& route) const {
+  for (auto const& tag : *route.bestPrefixEntry.tags_ref()) {
+    if (tags_.count(tag)) {
+      return true;
+    }
+  }
+  return false;
 }
 
 bool
@@ -62,7 +126,11 @@ RibPolicyStatement::applyAction(RibUnicastEntry& route) const {
   if (not match(route)) {
     return false;
   }
+  return transform(route);
+}
 
+bool
+RibPolicyStatement::transform(RibUnicastEntry& route) const {
   // Iterate over all next-hops. NOTE that we iterate over rvalue
   CHECK(action_.set_weight_ref().has_value());
   auto const& weightAction = action_.set_weight_ref().value();
@@ -128,6 +196,22 @@ RibPolicy::RibPolicy(thrift::RibPolicy const& policy)
   for (auto const& statement : *policy.statements_ref()) {
     policyStatements_.emplace_back(RibPolicyStatement(statement));
   }
+
+  // Index statements by their match criteria
+  for (size_t i = 0; i < policyStatements_.size(); ++i) {
+    auto const& statement = policyStatements_.at(i);
+    for (auto const& prefix : statement.prefixSet_) {
+      prefixIndex_[prefix].emplace_back(i);
+    }
+    for (auto const& range : statement.prefixRanges_) {
+      auto const rangePrefix = toIpPrefix(range.network);
+      prefixRangeTrie_.insert(rangePrefix);
+      prefixRangeIndex_[rangePrefix].emplace_back(i, range);
+    }
+    for (auto const& tag : statement.tags_) {
+      tagIndex_[tag].emplace_back(i);
+    }
+  }
 }
 
 thrift::RibPolicy
@@ -158,20 +242,74 @@ RibPolicy::isActive() const {
   return getTtlDuration().count() > 0;
 }
 
-bool
-RibPolicy::match(const RibUnicastEntry& route) const {
-  for (auto const& statement : policyStatements_) {
-    if (statement.match(route)) {
-      return true;
+std::vector<size_t>
+RibPolicy::getMatchedStatements(const RibUnicastEntry& route) const {
+  // statements matching route by prefix and by tags
+  std::vector<size_t> prefixMatches;
+  std::vector<size_t> tagMatches;
+  if (auto it = prefixIndex_.find(route.prefix); it != prefixIndex_.end()) {
+    prefixMatches = it->second;
+  }
+  if (prefixRangeTrie_.size()) {
+    for (auto const& rangePrefix :
+         prefixRangeTrie_.coveringPrefixes(route.prefix)) {
+      for (auto const& [i, range] : prefixRangeIndex_.at(rangePrefix)) {
+        if (range.contains(route.prefix)) {
+          prefixMatches.emplace_back(i);
+        }
+      }
     }
   }
-  return false;
+  for (auto const& tag : *route.bestPrefixEntry.tags_ref()) {
+    if (auto it = tagIndex_.find(tag); it != tagIndex_.end()) {
+      tagMatches.insert(tagMatches.end(), it->second.begin(), it->second.end());
+    }
+  }
+  std::sort(prefixMatches.begin(), prefixMatches.end());
+  std::sort(tagMatches.begin(), tagMatches.end());
+
+  // statement matches if it matches on every criteria it has
+  std::vector<size_t> candidates;
+  std::set_union(
+      prefixMatches.begin(),
+      prefixMatches.end(),
+      tagMatches.begin(),
+      tagMatches.end(),
+      std::back_inserter(candidates));
+  candidates.erase(
+      std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+  std::vector<size_t> matches;
+  for (auto i : candidates) {
+    auto const& statement = policyStatements_.at(i);
+    if (statement.hasPrefixCriteria_ and
+        not std::binary_search(prefixMatches.begin(), prefixMatches.end(), i)) {
+      continue;
+    }
+    if (statement.hasTagCriteria_ and
+        not std::binary_search(tagMatches.begin(), tagMatches.end(), i)) {
+      continue;
+    }
+    matches.emplace_back(i);
+  }
+  return matches;
+}
+
+bool
+RibPolicy::match(const RibUnicastEntry& route) const {
+  return not getMatchedStatements(route).empty();
 }
 
 bool
 RibPolicy::applyAction(RibUnicastEntry& route) const {
-  for (auto const& statement : policyStatements_) {
-    if (statement.applyAction(route)) {
+  return applyMatchedAction(getMatchedStatements(route), route);
+}
+
+bool
+RibPolicy::applyMatchedAction(
+    const std::vector<size_t>& matches, RibUnicastEntry& route) const {
+  for (auto i : matches) {
+    if (policyStatements_.at(i).transform(route)) {
       return true;
     }
   }
@@ -179,23 +317,63 @@ RibPolicy::applyAction(RibUnicastEntry& route) const {
 }
 
 RibPolicy::PolicyChange
-RibPolicy::applyPolicy(std::unordered_map<folly::CIDRNetwork, RibUnicastEntry>&
-                           unicastEntries) const {
+RibPolicy::applyPolicy(
+    std::unordered_map<folly::CIDRNetwork, RibUnicastEntry>& unicastEntries,
+    std::unordered_map<folly::CIDRNetwork, RibUnicastEntry>* prePolicyRoutes)
+    const {
   PolicyChange change;
   if (not isActive()) {
     return change;
   }
   auto iter = unicastEntries.begin();
   while (iter != unicastEntries.end()) {
-    if (applyAction(iter->second)) {
+    auto const matches = getMatchedStatements(iter->second);
+    if (matches.empty()) {
+      ++iter;
+      continue;
+    }
+    // copy only routes the policy may transform
+    std::optional<RibUnicastEntry> prePolicyRoute;
+    if (prePolicyRoutes) {
+      prePolicyRoute = iter->second;
+    }
+    if (applyMatchedAction(matches, iter->second)) {
       DCHECK(iter->second.nexthops.size()) << "Unexpected empty next-hops";
       change.updatedRoutes.push_back(iter->second.prefix);
       VLOG(2) << "RibPolicy transformed the route "
               << folly::IPAddress::networkToString(iter->second.prefix);
+      if (prePolicyRoute) {
+        prePolicyRoutes->insert_or_assign(
+            iter->first, std::move(*prePolicyRoute));
+      }
     }
     ++iter;
   }
   return change;
 }
 
+bool
+RibPolicy::isRouteAffected(
+    const RibPolicy* oldPolicy,
+    const RibPolicy* newPolicy,
+    const RibUnicastEntry& route) {
+  auto getActions = [&route](const RibPolicy* policy) {
+    std::vector<const thrift::RibRouteAction*> actions;
+    if (policy and policy->isActive()) {
+      for (auto i : policy->getMatchedStatements(route)) {
+        actions.emplace_back(&policy->policyStatements_.at(i).action_);
+      }
+    }
+    return actions;
+  };
+  auto const oldActions = getActions(oldPolicy);
+  auto const newActions = getActions(newPolicy);
+  return not std::equal(
+      oldActions.begin(),
+      oldActions.end(),
+      newActions.begin(),
+      newActions.end(),
+      [](auto const* lhs, auto const* rhs) { return *lhs == *rhs; });
+}
+
 } // namespace openr
@@ -6,8 +6,12 @@
  */
 
 #include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/PrefixTrie.h>
 #include <openr/decision/RibEntry.h>
 #include <openr/if/gen-cpp2/Network_types.h>
 #include <openr/if/gen-cpp2/OpenrCtrl_types.h>
@@ -22,6 +26,15 @@ namespace openr {
  */
 class RibPolicyStatement {
  public:
+  // Prefixes under `network` with length from `ge` to `le`
+  struct PrefixRange {
+    folly::CIDRNetwork network;
+    uint8_t ge{0};
+    uint8_t le{0};
+
+    bool contains(const folly::CIDRNetwork& prefix) const;
+  };
+
   explicit RibPolicyStatement(
       const thrift::RibPolicyStatement& policyStatement);
 
@@ -43,12 +56,27 @@ class RibPolicyStatement {
   bool applyAction(RibUnicastEntry& route) const;
 
  private:
+  friend class RibPolicy;
+
+  // Apply action on the route, which is known to match
+  bool transform(RibUnicastEntry& route) const;
+
+  bool matchPrefix(const folly::CIDRNetwork& prefix) const;
+  bool matchTags(const RibUnicastEntry& route) const;
+
   const std::string name_;
 
+  // Matcher as specified, criteria not specified are skipped on matching
+  const thrift::RibRouteMatcher matcher_;
+  const bool hasPrefixCriteria_{false};
+  const bool hasTagCriteria_{false};
+
   // Unordered set for efficient lookup on matching
   // NOTE: The matching requires the same prefix representation (fully
   // qualified)
   std::unordered_set<folly::CIDRNetwork> prefixSet_;
+  std::vector<PrefixRange> prefixRanges_;
+  std::unordered_set<std::string> tags_;
 
   // PolicyAction operation
   const thrift::RibRouteAction action_;
@@ -59,6 +87,10 @@ class RibPolicyStatement {
  * efficient processing of policy. Provides APIs for easier code intengration
  * for route policing.
  *
+ * Statements are indexed by their prefixes, prefix ranges and tags, so that
+ * statements matching a route are looked up in O(prefix length + tags of
+ * route) instead of matching the route against every statement.
+ *
  * Refer to `struct RibPolicy` in `OpenrCtrl.thrift` for more documentation.
  */
 class RibPolicy {
@@ -99,18 +131,48 @@ class RibPolicy {
 
   /**
    * Calls applyAction on all routes in unicastEntries, removes entries that
-   * have no remaining nexthops.
+   * have no remaining nexthops. Routes transformed are added to
+   * prePolicyRoutes as they were before, if given.
    *
    * @returns PolicyChange struct indicating unicastEntries that were modified.
    */
   PolicyChange applyPolicy(
-      std::unordered_map<folly::CIDRNetwork, RibUnicastEntry>& unicastEntries)
-      const;
+      std::unordered_map<folly::CIDRNetwork, RibUnicastEntry>& unicastEntries,
+      std::unordered_map<folly::CIDRNetwork, RibUnicastEntry>* prePolicyRoutes =
+          nullptr) const;
+
+  /**
+   * Checks if route may be transformed differently by newPolicy than by
+   * oldPolicy, i.e. if the statements matching it in them differ in action.
+   * Policy which is nullptr or not active anymore matches no route.
+   */
+  static bool isRouteAffected(
+      const RibPolicy* oldPolicy,
+      const RibPolicy* newPolicy,
+      const RibUnicastEntry& route);
 
  private:
+  // Indices of statements matching route, in order
+  std::vector<size_t> getMatchedStatements(const RibUnicastEntry& route) const;
+
+  // Apply first action of matched statements that transforms route
+  bool applyMatchedAction(
+      const std::vector<size_t>& matches, RibUnicastEntry& route) const;
+
   // List of policy statements
   std::vector<RibPolicyStatement> policyStatements_;
 
+  // Indices of statements by prefix, by prefix of their prefix ranges and by
+  // tag. Prefixes of prefix ranges are kept in a trie to look up the ranges
+  // covering a route
+  std::unordered_map<folly::CIDRNetwork, std::vector<size_t>> prefixIndex_;
+  PrefixTrie prefixRangeTrie_;
+  std::unordered_map<
+      thrift::IpPrefix,
+      std::vector<std::pair<size_t, RibPolicyStatement::PrefixRange>>>
+      prefixRangeIndex_;
+  std::unordered_map<std::string, std::vector<size_t>> tagIndex_;
+
   // Validity
   const std::chrono::steady_clock::time_point validUntilTs_;
 };
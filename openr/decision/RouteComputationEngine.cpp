@@ -0,0 +1,38 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/decision/RouteComputationEngine.h>
+
+#include <glog/logging.h>
+
+namespace openr {
+
+SpfSolverRouteEngine::SpfSolverRouteEngine(
+    std::unique_ptr<SpfSolver> spfSolver)
+    : spfSolver_(std::move(spfSolver)) {
+  CHECK(spfSolver_);
+}
+
+std::optional<DecisionRouteDb>
+SpfSolverRouteEngine::buildRouteDb(
+    std::string const& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    PrefixState const& prefixState) {
+  return spfSolver_->buildRouteDb(myNodeName, areaLinkStates, prefixState);
+}
+
+std::optional<RibUnicastEntry>
+SpfSolverRouteEngine::createRouteForPrefix(
+    std::string const& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    PrefixState const& prefixState,
+    folly::CIDRNetwork const& prefix) {
+  return spfSolver_->createRouteForPrefix(
+      myNodeName, areaLinkStates, prefixState, prefix);
+}
+
+} // namespace openr
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include <folly/IPAddress.h>
+
+#include <openr/decision/Decision.h>
+#include <openr/decision/LinkState.h>
+#include <openr/decision/PrefixState.h>
+
+namespace openr {
+
+/**
+ * Interface to an alternative route computation, e.g. a batch or offloaded
+ * SPF or an external solver, at the boundary of SpfSolver::buildRouteDb()
+ * and SpfSolver::createRouteForPrefix(). Decision uses it in place of its
+ * SpfSolver if configured, see decision_config.route_engine. Static routes
+ * are kept by Decision and added to built routes.
+ *
+ * Engines are called on the Decision thread only. Link and prefix state are
+ * snapshots of Decision, read-only to engines and not to be referred to once
+ * a call returned.
+ */
+class RouteComputationEngine {
+ public:
+  virtual ~RouteComputationEngine() = default;
+
+  virtual std::string getName() const = 0;
+
+  // Build unicast and MPLS routes of myNodeName.
+  // Returns std::nullopt if myNodeName doesn't have any prefix database
+  virtual std::optional<DecisionRouteDb> buildRouteDb(
+      std::string const& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState) = 0;
+
+  // Build route of a single prefix, std::nullopt if there is none
+  virtual std::optional<RibUnicastEntry> createRouteForPrefix(
+      std::string const& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState,
+      folly::CIDRNetwork const& prefix) = 0;
+};
+
+/**
+ * Built-in SpfSolver as RouteComputationEngine, the reference other engines
+ * are compared against in decision_benchmark
+ */
+class SpfSolverRouteEngine final : public RouteComputationEngine {
+ public:
+  static constexpr folly::StringPiece kName{"spf"};
+
+  explicit SpfSolverRouteEngine(std::unique_ptr<SpfSolver> spfSolver);
+
+  std::string
+  getName() const override {
+    return kName.str();
+  }
+
+  std::optional<DecisionRouteDb> buildRouteDb(
+      std::string const& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState) override;
+
+  std::optional<RibUnicastEntry> createRouteForPrefix(
+      std::string const& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState,
+      folly::CIDRNetwork const& prefix) override;
+
+ private:
+  std::unique_ptr<SpfSolver> spfSolver_;
+};
+
+} // namespace openr
@@ -7,7 +7,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <list>
+#include <memory>
+#include <unordered_set>
 #include <vector>
 
 #include <folly/IPAddress.h>
@@ -28,6 +31,16 @@ struct DecisionRouteUpdate {
   std::vector<int32_t> mplsRoutesToDelete;
   std::optional<thrift::PerfEvents> perfEvents = std::nullopt;
 
+  // Routes which lost next-hops, published ahead of the rest of the same
+  // route rebuild. Meant to be programmed without waiting for later updates
+  bool isPriority{false};
+
+  bool
+  empty() const {
+    return unicastRoutesToUpdate.empty() and unicastRoutesToDelete.empty() and
+        mplsRoutesToUpdate.empty() and mplsRoutesToDelete.empty();
+  }
+
   void
   addRouteToUpdate(RibUnicastEntry const& route) {
     CHECK(!unicastRoutesToUpdate.count(route.prefix));
@@ -41,8 +54,88 @@ struct DecisionRouteUpdate {
     unicastRoutesToUpdate.emplace(std::move(prefix), std::move(route));
   }
 
+  /**
+   * Merge a later update into this one. The later change of a prefix or label
+   * wins, i.e. a delete supersedes an earlier add and vice versa. Perf events
+   * of this (older) update are kept. Returns number of superseded entries.
+   */
+  size_t
+  merge(DecisionRouteUpdate&& update) {
+    size_t numSuperseded{0};
+
+    // unicast
+    std::unordered_set<folly::CIDRNetwork> deletedPrefixes(
+        unicastRoutesToDelete.begin(), unicastRoutesToDelete.end());
+    for (auto& prefix : update.unicastRoutesToDelete) {
+      numSuperseded += unicastRoutesToUpdate.erase(prefix);
+      if (deletedPrefixes.insert(prefix).second) {
+        unicastRoutesToDelete.emplace_back(std::move(prefix));
+      } else {
+        ++numSuperseded;
+      }
+    }
+    auto const numDeletes = unicastRoutesToDelete.size();
+    unicastRoutesToDelete.erase(
+        std::remove_if(
+            unicastRoutesToDelete.begin(),
+            unicastRoutesToDelete.end(),
+            [&update](folly::CIDRNetwork const& prefix) {
+              return update.unicastRoutesToUpdate.count(prefix);
+            }),
+        unicastRoutesToDelete.end());
+    numSuperseded += numDeletes - unicastRoutesToDelete.size();
+    for (auto& [prefix, route] : update.unicastRoutesToUpdate) {
+      if (unicastRoutesToUpdate.count(prefix)) {
+        ++numSuperseded;
+      }
+      unicastRoutesToUpdate.insert_or_assign(prefix, std::move(route));
+    }
+
+    // mpls
+    std::unordered_set<int32_t> updatedLabels;
+    for (auto const& route : update.mplsRoutesToUpdate) {
+      updatedLabels.emplace(route.label);
+    }
+    std::unordered_set<int32_t> deletedLabels(
+        update.mplsRoutesToDelete.begin(), update.mplsRoutesToDelete.end());
+    auto const numRoutes = mplsRoutesToUpdate.size();
+    mplsRoutesToUpdate.erase(
+        std::remove_if(
+            mplsRoutesToUpdate.begin(),
+            mplsRoutesToUpdate.end(),
+            [&](RibMplsEntry const& route) {
+              return updatedLabels.count(route.label) or
+                  deletedLabels.count(route.label);
+            }),
+        mplsRoutesToUpdate.end());
+    numSuperseded += numRoutes - mplsRoutesToUpdate.size();
+    auto const numLabels = mplsRoutesToDelete.size();
+    mplsRoutesToDelete.erase(
+        std::remove_if(
+            mplsRoutesToDelete.begin(),
+            mplsRoutesToDelete.end(),
+            [&](int32_t label) {
+              return updatedLabels.count(label) or deletedLabels.count(label);
+            }),
+        mplsRoutesToDelete.end());
+    numSuperseded += numLabels - mplsRoutesToDelete.size();
+    std::move(
+        update.mplsRoutesToUpdate.begin(),
+        update.mplsRoutesToUpdate.end(),
+        std::back_inserter(mplsRoutesToUpdate));
+    mplsRoutesToDelete.insert(
+        mplsRoutesToDelete.end(),
+        update.mplsRoutesToDelete.begin(),
+        update.mplsRoutesToDelete.end());
+
+    if (not perfEvents.has_value()) {
+      perfEvents = std::move(update.perfEvents);
+    }
+    return numSuperseded;
+  }
+
   thrift::RouteDatabaseDelta
-  toThrift() {
+  toThrift() const {
     thrift::RouteDatabaseDelta delta;
 
     // unicast
@@ -63,4 +156,8 @@ struct DecisionRouteUpdate {
   }
 };
 
+// Route updates are replicated to several readers, which share one immutable
+// instance
+using DecisionRouteUpdatePtr = std::shared_ptr<const DecisionRouteUpdate>;
+
 } // namespace openr
@@ -5,6 +5,21 @@
  * LICENSE file in the root directory of this source tree.
  */
 #include <openr/decision/tests/RoutingBenchmarkUtils.h>
+#include <openr/kvstore/KvStoreSnapshot.h>
+#include <openr/tests/BenchmarkDriver.h>
+
+DEFINE_string(
+    replay_file,
+    "",
+    "KvStore recording to replay, as written by openr_kvstore_snooper "
+    "--record_file");
+DEFINE_string(
+    replay_node, "", "Node of the recording whose routes are computed");
+DEFINE_string(
+    route_engines,
+    "",
+    "Comma separated route computation engines to benchmark route builds of "
+    "and check against SpfSolver, e.g. spf and engines of the platform plugin");
 
 namespace openr {
 
@@ -18,6 +33,22 @@ BENCHMARK_COUNTERS_PARAM(BM_DecisionGrid, counters, 10, KSP2_ED_ECMP);
 BENCHMARK_COUNTERS_PARAM(BM_DecisionGrid, counters, 100, KSP2_ED_ECMP);
 BENCHMARK_COUNTERS_PARAM(BM_DecisionGrid, counters, 1000, KSP2_ED_ECMP);
 
+// The integer parameter is the number of route build threads
+BENCHMARK_COUNTERS_PARAM(BM_DecisionGridRouteBuild, counters, 1, SP_ECMP);
+BENCHMARK_COUNTERS_PARAM(BM_DecisionGridRouteBuild, counters, 2, SP_ECMP);
+BENCHMARK_COUNTERS_PARAM(BM_DecisionGridRouteBuild, counters, 4, SP_ECMP);
+BENCHMARK_COUNTERS_PARAM(BM_DecisionGridRouteBuild, counters, 8, SP_ECMP);
+
+// The integer parameter is the number of prefixes advertised by each node of
+// a grid of 100 nodes
+BENCHMARK_COUNTERS_PARAM(BM_DecisionGridPrefixUpdate, counters, 100, SP_ECMP);
+BENCHMARK_COUNTERS_PARAM(BM_DecisionGridPrefixUpdate, counters, 1000, SP_ECMP);
+
+// The integer parameter is the number of nodes in full mesh topology
+BENCHMARK_COUNTERS_PARAM(BM_DecisionMesh, counters, 10, SP_ECMP);
+BENCHMARK_COUNTERS_PARAM(BM_DecisionMesh, counters, 100, SP_ECMP);
+BENCHMARK_COUNTERS_PARAM(BM_DecisionMesh, counters, 250, SP_ECMP);
+
 // The integer parameter is numOfGivenNodes in topology,
 // which >= numOfActualNodesInTopo.
 // numOfPods = (numOfGivenNodes - numOfSsws) / numOfFswsAndRswsPerPod
@@ -32,6 +63,53 @@ BENCHMARK_COUNTERS_PARAM(BM_DecisionFabric, counters, 5000, SP_ECMP);
 int
 main(int argc, char** argv) {
   folly::init(&argc, &argv);
-  folly::runBenchmarks();
-  return 0;
+
+  // Benchmarks on a recorded KvStore, e.g. of a production network
+  std::optional<openr::thrift::KvStoreRecording> recording;
+  if (not FLAGS_replay_file.empty()) {
+    recording = openr::readKvStoreRecording(FLAGS_replay_file);
+    CHECK(recording.has_value());
+    CHECK(recording->dump_ref()->keyVals_ref()->count(
+        folly::sformat("adj:{}", FLAGS_replay_node)))
+        << "No adjacencies of --replay_node in recording";
+    folly::addBenchmark(
+        __FILE__,
+        "BM_DecisionReplayDump",
+        [&recording](folly::UserCounters& counters, unsigned iters) {
+          openr::BM_DecisionReplayDump(
+              counters, iters, *recording, FLAGS_replay_node);
+          return iters;
+        });
+    folly::addBenchmark(
+        __FILE__,
+        "BM_DecisionReplayPublications",
+        [&recording](folly::UserCounters& counters, unsigned iters) {
+          openr::BM_DecisionReplayPublications(
+              counters, iters, *recording, FLAGS_replay_node);
+          return iters;
+        });
+  }
+
+  // Route computation engines alone, see RouteComputationEngine
+  std::vector<std::string> routeEngines;
+  folly::split(',', FLAGS_route_engines, routeEngines, true /* ignoreEmpty */);
+  for (const auto& engineName : routeEngines) {
+    for (const uint32_t numOfSws : {100, 1000}) {
+      folly::addBenchmark(
+          __FILE__,
+          folly::sformat("BM_RouteEngineGrid({}, {})", numOfSws, engineName),
+          [engineName, numOfSws](
+              folly::UserCounters& counters, unsigned iters) {
+            openr::BM_RouteEngineGrid(
+                counters,
+                iters,
+                numOfSws,
+                100 /* numberOfPrefixes */,
+                engineName);
+            return iters;
+          });
+    }
+  }
+
+  return openr::runBenchmarks();
 }
@@ -5,7 +5,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <atomic>
 #include <memory>
+#include <thread>
 
 #include <fb303/ServiceData.h>
 #include <folly/IPAddress.h>
@@ -23,9 +25,11 @@
 
 #include <openr/common/Constants.h>
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/StatHandle.h>
 #include <openr/common/Util.h>
 #include <openr/config/tests/Utils.h>
 #include <openr/decision/Decision.h>
+#include <openr/decision/RouteComputationEngine.h>
 #include <openr/decision/RouteUpdate.h>
 #include <openr/tests/OpenrThriftServerWrapper.h>
 
@@ -712,6 +716,26 @@ TEST(MplsRoutes, BasicTest) {
   validateAdjLabelRoutes(routeMap, "3", {adj32});
 }
 
+TEST(SpfSolver, StaticRoutesUpdate) {
+  SpfSolver spfSolver("1", false, false);
+  auto nh = createNextHop(toBinaryAddress("1.1.1.1"));
+
+  thrift::RouteDatabaseDelta delta;
+  delta.mplsRoutesToUpdate_ref() = {
+      createMplsRoute(32011, {nh}), createMplsRoute(32012, {nh})};
+  EXPECT_THAT(
+      spfSolver.updateStaticRoutes(std::move(delta)),
+      testing::UnorderedElementsAre(32011, 32012));
+
+  // deleting unknown labels changes nothing
+  delta = thrift::RouteDatabaseDelta();
+  delta.mplsRoutesToDelete_ref() = {32011, 32013};
+  EXPECT_THAT(
+      spfSolver.updateStaticRoutes(std::move(delta)),
+      testing::UnorderedElementsAre(32011));
+  EXPECT_EQ(1, spfSolver.getStaticRoutes().size());
+}
+
 TEST(BGPRedistribution, BasicOperation) {
   std::string nodeName("1");
   SpfSolver spfSolver(
@@ -1134,8 +1158,8 @@ TEST(Decision, BestRouteSelection) {
   //
   {
     auto bestRoutesCache = spfSolver.getBestRoutesCache();
-    ASSERT_EQ(1, bestRoutesCache.count(addr1));
-    auto& bestRoutes = bestRoutesCache.at(addr1);
+    ASSERT_EQ(1, bestRoutesCache.count(toIPNetwork(addr1)));
+    auto& bestRoutes = bestRoutesCache.at(toIPNetwork(addr1));
     EXPECT_EQ(2, bestRoutes.allNodeAreas.size());
     EXPECT_EQ(1, bestRoutes.allNodeAreas.count({"2", "0"}));
     EXPECT_EQ(1, bestRoutes.allNodeAreas.count({"3", "0"}));
@@ -1168,8 +1192,8 @@ TEST(Decision, BestRouteSelection) {
   //
   {
     auto bestRoutesCache = spfSolver.getBestRoutesCache();
-    ASSERT_EQ(1, bestRoutesCache.count(addr1));
-    auto& bestRoutes = bestRoutesCache.at(addr1);
+    ASSERT_EQ(1, bestRoutesCache.count(toIPNetwork(addr1)));
+    auto& bestRoutes = bestRoutesCache.at(toIPNetwork(addr1));
     EXPECT_EQ(1, bestRoutes.allNodeAreas.size());
     EXPECT_EQ(1, bestRoutes.allNodeAreas.count({"2", "0"}));
     EXPECT_EQ("2", bestRoutes.bestNodeArea.first);
@@ -1202,6 +1226,144 @@ TEST(Decision, BestRouteSelection) {
           createNextHopFromAdj(adj31, false, 20, push2)));
 }
 
+//
+// Best route selection is reused by route builds as long as announcements
+// and overload status of announcers are unchanged
+//
+TEST(Decision, BestRouteSelectionCache) {
+  std::string nodeName("1");
+  SpfSolver spfSolver(
+      nodeName,
+      false /* enableV4 */,
+      false /* computeLfaPaths */,
+      false /* enableOrderedFib */,
+      false /* bgpDryRun */,
+      true /* enableBestRouteSelection */);
+
+  std::unordered_map<std::string, LinkState> areaLinkStates;
+  PrefixState prefixState;
+
+  //
+  // Setup adjacencies
+  // 2 <--> 1 <--> 3
+  //
+  auto adjacencyDb1 = createAdjDb("1", {adj12, adj13}, 1);
+  auto adjacencyDb2 = createAdjDb("2", {adj21}, 2);
+  auto adjacencyDb3 = createAdjDb("3", {adj31}, 3);
+  areaLinkStates.emplace(kDefaultArea, LinkState(kDefaultArea));
+  auto& linkState = areaLinkStates.at(kDefaultArea);
+  linkState.updateAdjacencyDatabase(adjacencyDb1);
+  linkState.updateAdjacencyDatabase(adjacencyDb2);
+  linkState.updateAdjacencyDatabase(adjacencyDb3);
+
+  // node2 and node3 announce the same prefix with same metrics
+  const auto prefixEntry = createPrefixEntryWithMetrics(
+      addr1, thrift::PrefixType::DEFAULT, createMetrics(200, 0, 0));
+  prefixState.updatePrefixDatabase(createPrefixDb("2", {prefixEntry}));
+  prefixState.updatePrefixDatabase(createPrefixDb("3", {prefixEntry}));
+
+  auto getHits = []() {
+    return fb303::fbData->getCounters().at(
+        "decision.best_route_selection_cache_hits.count.60");
+  };
+  auto getBestNodeAreas = [&spfSolver]() {
+    return spfSolver.getBestRoutesCache().at(toIPNetwork(addr1)).allNodeAreas;
+  };
+
+  auto const hits = getHits();
+  ASSERT_TRUE(spfSolver.buildRouteDb("1", areaLinkStates, prefixState));
+  EXPECT_EQ(hits, getHits());
+  EXPECT_THAT(
+      getBestNodeAreas(),
+      testing::ElementsAre(
+          NodeAndArea{"2", kDefaultArea}, NodeAndArea{"3", kDefaultArea}));
+
+  // Rebuild without changes reuses the selection
+  ASSERT_TRUE(spfSolver.buildRouteDb("1", areaLinkStates, prefixState));
+  EXPECT_EQ(hits + 1, getHits());
+  EXPECT_EQ(2, getBestNodeAreas().size());
+
+  // Overloading an announcer invalidates it
+  adjacencyDb3.isOverloaded_ref() = true;
+  EXPECT_TRUE(linkState.updateAdjacencyDatabase(adjacencyDb3).topologyChanged);
+  ASSERT_TRUE(spfSolver.buildRouteDb("1", areaLinkStates, prefixState));
+  EXPECT_EQ(hits + 1, getHits());
+  EXPECT_THAT(
+      getBestNodeAreas(),
+      testing::ElementsAre(NodeAndArea{"2", kDefaultArea}));
+
+  // So does a change of metrics
+  prefixState.updatePrefixDatabase(createPrefixDb(
+      "3",
+      {createPrefixEntryWithMetrics(
+          addr1, thrift::PrefixType::DEFAULT, createMetrics(200, 100, 0))}));
+  ASSERT_TRUE(spfSolver.buildRouteDb("1", areaLinkStates, prefixState));
+  EXPECT_EQ(hits + 1, getHits());
+
+  // Routes built for another node don't reuse selections for this one
+  ASSERT_TRUE(spfSolver.buildRouteDb("2", areaLinkStates, prefixState));
+  EXPECT_EQ(hits + 1, getHits());
+}
+
+//
+// UCMP weighs next-hops by capacity towards the destination, the smaller of
+// adjacency weights along each shortest path
+//
+//       40   30
+//     1 -- 2 -- 4
+//     |         |
+//     3 ------- +
+//       10   10
+//
+TEST(Decision, UcmpWeights) {
+  std::string nodeName("1");
+  SpfSolver spfSolver(nodeName, false, false);
+  spfSolver.setComputeUcmp(true);
+
+  auto withWeight = [](thrift::Adjacency adj, int64_t weight) {
+    adj.weight_ref() = weight;
+    return adj;
+  };
+  std::unordered_map<std::string, LinkState> areaLinkStates;
+  areaLinkStates.emplace(kDefaultArea, LinkState(kDefaultArea));
+  auto& linkState = areaLinkStates.at(kDefaultArea);
+  linkState.updateAdjacencyDatabase(createAdjDb(
+      "1", {withWeight(adj12, 40), withWeight(adj13, 10)}, 1));
+  linkState.updateAdjacencyDatabase(
+      createAdjDb("2", {adj21, withWeight(adj24, 30)}, 2));
+  linkState.updateAdjacencyDatabase(
+      createAdjDb("3", {adj31, withWeight(adj34, 10)}, 3));
+  linkState.updateAdjacencyDatabase(createAdjDb("4", {adj42, adj43}, 4));
+
+  PrefixState prefixState;
+  prefixState.updatePrefixDatabase(prefixDb4);
+
+  auto weighted = [](thrift::NextHopThrift nextHop, int32_t weight) {
+    nextHop.weight_ref() = weight;
+    return nextHop;
+  };
+  auto route = spfSolver.createRouteForPrefix(
+      nodeName, areaLinkStates, prefixState, toIPNetwork(addr4));
+  ASSERT_TRUE(route.has_value());
+  EXPECT_EQ(
+      route->nexthops.get(),
+      NextHops(
+          {weighted(createNextHopFromAdj(adj12, false, 20), 3),
+           weighted(createNextHopFromAdj(adj13, false, 20), 1)}));
+
+  // balanced capacity keeps routes ECMP
+  linkState.updateAdjacencyDatabase(createAdjDb(
+      "1", {withWeight(adj12, 10), withWeight(adj13, 10)}, 1));
+  route = spfSolver.createRouteForPrefix(
+      nodeName, areaLinkStates, prefixState, toIPNetwork(addr4));
+  ASSERT_TRUE(route.has_value());
+  EXPECT_EQ(
+      route->nexthops.get(),
+      NextHops(
+          {createNextHopFromAdj(adj12, false, 20),
+           createNextHopFromAdj(adj13, false, 20)}));
+}
+
 //
 // Test topology:
 // connected bidirectionally
@@ -1813,7 +1975,7 @@ INSTANTIATE_TEST_CASE_P(
 //
 TEST_P(SimpleRingTopologyFixture, ShortestPathTest) {
   CustomSetUp(false /* disable LFA */, false /* useKsp2Ed */);
-  fb303::fbData->resetAllData();
+  resetAllStats();
   auto routeMap = getRouteMap(
       *spfSolver, {"1", "2", "3", "4"}, areaLinkStates, prefixState);
 
@@ -1945,7 +2107,7 @@ TEST_P(SimpleRingTopologyFixture, ShortestPathTest) {
 //
 TEST_P(SimpleRingTopologyFixture, DuplicateMplsRoutes) {
   CustomSetUp(false /* disable LFA */, false /* useKsp2Ed */);
-  fb303::fbData->resetAllData();
+  resetAllStats();
   // make node1's mpls label same as node2.
   adjacencyDb1.nodeLabel_ref() = 2;
   auto& linkState = areaLinkStates.at(kDefaultArea);
@@ -2292,7 +2454,7 @@ TEST_P(SimpleRingTopologyFixture, Ksp2EdEcmp) {
       true /* multipath - ignored */,
       true /* useKsp2Ed */,
       std::get<1>(GetParam()));
-  fb303::fbData->resetAllData();
+  resetAllStats();
   auto routeMap = getRouteMap(
       *spfSolver, {"1", "2", "3", "4"}, areaLinkStates, prefixState);
 
@@ -2482,7 +2644,7 @@ TEST_P(SimpleRingTopologyFixture, Ksp2EdEcmpForBGP) {
       thrift::PrefixType::BGP,
       true);
 
-  fb303::fbData->resetAllData();
+  resetAllStats();
   thrift::MetricVector mv1, mv2;
   int64_t numMetrics = 5;
   mv1.metrics_ref()->resize(numMetrics);
@@ -2666,7 +2828,7 @@ TEST_P(SimpleRingTopologyFixture, Ksp2EdEcmpForBGP123) {
       thrift::PrefixType::BGP,
       true);
 
-  fb303::fbData->resetAllData();
+  resetAllStats();
   thrift::MetricVector mv1, mv2;
   int64_t numMetrics = 5;
   mv1.metrics_ref()->resize(numMetrics);
@@ -4354,6 +4516,410 @@ TEST_P(GridTopologyFixture, ShortestPathTest) {
   EXPECT_EQ(gridDistance(src, dst, n), *nextHops.begin()->metric_ref());
 }
 
+// routes built by sharding prefixes across workers must match the ones built
+// inline on the calling thread
+TEST(GridTopology, ParallelRouteBuild) {
+  std::string nodeName("1");
+  SpfSolver serialSpfSolver(nodeName, false, true);
+  SpfSolver parallelSpfSolver(
+      nodeName,
+      false,
+      true,
+      false /* enableOrderedFib */,
+      false /* bgpDryRun */,
+      false /* enableBestRouteSelection */,
+      4 /* routeBuildThreads */);
+
+  std::unordered_map<std::string, LinkState> areaLinkStates;
+  areaLinkStates.emplace(kDefaultArea, LinkState(kDefaultArea));
+  auto& linkState = areaLinkStates.at(kDefaultArea);
+  PrefixState prefixState;
+  createGrid(linkState, prefixState, 60);
+
+  auto serialRouteDb =
+      serialSpfSolver.buildRouteDb(nodeName, areaLinkStates, prefixState);
+  auto parallelRouteDb =
+      parallelSpfSolver.buildRouteDb(nodeName, areaLinkStates, prefixState);
+  ASSERT_TRUE(serialRouteDb.has_value());
+  ASSERT_TRUE(parallelRouteDb.has_value());
+
+  // every prefix but our own
+  EXPECT_EQ(60 * 60 - 1, parallelRouteDb->unicastRoutes.size());
+  EXPECT_EQ(serialRouteDb->unicastRoutes, parallelRouteDb->unicastRoutes);
+  EXPECT_EQ(serialRouteDb->mplsRoutes, parallelRouteDb->mplsRoutes);
+  EXPECT_EQ(
+      serialSpfSolver.getBestRoutesCache().size(),
+      parallelSpfSolver.getBestRoutesCache().size());
+}
+
+// workers share SPF results memoized in a bounded cache, which is evicted
+// between builds
+TEST(GridTopology, ParallelRouteBuildBoundedMemoization) {
+  std::string nodeName("1");
+  SpfSolver serialSpfSolver(nodeName, false, true);
+  SpfSolver parallelSpfSolver(
+      nodeName,
+      false,
+      true,
+      false /* enableOrderedFib */,
+      false /* bgpDryRun */,
+      false /* enableBestRouteSelection */,
+      4 /* routeBuildThreads */);
+  parallelSpfSolver.setComputeLfaBackups(true);
+  serialSpfSolver.setComputeLfaBackups(true);
+
+  std::unordered_map<std::string, LinkState> serialLinkStates;
+  serialLinkStates.emplace(kDefaultArea, LinkState(kDefaultArea));
+  PrefixState prefixState;
+  createGrid(serialLinkStates.at(kDefaultArea), prefixState, 70);
+  auto serialRouteDb =
+      serialSpfSolver.buildRouteDb(nodeName, serialLinkStates, prefixState);
+  ASSERT_TRUE(serialRouteDb.has_value());
+
+  // room for a single SPF result, the other ones are evicted after builds.
+  // Enough prefixes for every worker to get a shard
+  auto const& serialLinkState = serialLinkStates.at(kDefaultArea);
+  const size_t maxBytes =
+      serialLinkState.getSpfCacheBytes() / serialLinkState.getSpfCacheSize();
+  std::unordered_map<std::string, LinkState> areaLinkStates;
+  areaLinkStates.emplace(
+      kDefaultArea,
+      LinkState(kDefaultArea, false /* incremental spf */, maxBytes));
+  auto& linkState = areaLinkStates.at(kDefaultArea);
+  for (auto const& [_, adjDb] : serialLinkState.getAdjacencyDatabases()) {
+    linkState.updateAdjacencyDatabase(adjDb);
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    auto parallelRouteDb =
+        parallelSpfSolver.buildRouteDb(nodeName, areaLinkStates, prefixState);
+    ASSERT_TRUE(parallelRouteDb.has_value());
+    EXPECT_EQ(70 * 70 - 1, parallelRouteDb->unicastRoutes.size());
+    EXPECT_EQ(serialRouteDb->unicastRoutes, parallelRouteDb->unicastRoutes);
+    EXPECT_EQ(serialRouteDb->mplsRoutes, parallelRouteDb->mplsRoutes);
+
+    // SPF results of this node and its neighbors were memoized for workers
+    EXPECT_GT(linkState.getSpfCacheSize(), 1);
+    linkState.evictMemoizedResults();
+    EXPECT_LE(linkState.getSpfCacheBytes(), maxBytes);
+  }
+}
+
+// building the delta against the current routes yields the same changes as
+// diffing a full route db
+TEST(GridTopology, RouteDbDelta) {
+  std::string nodeName("1");
+  SpfSolver spfSolver(nodeName, false, true);
+
+  std::unordered_map<std::string, LinkState> areaLinkStates;
+  areaLinkStates.emplace(kDefaultArea, LinkState(kDefaultArea));
+  auto& linkState = areaLinkStates.at(kDefaultArea);
+  PrefixState prefixState;
+  createGrid(linkState, prefixState, 4);
+
+  auto routeDb = spfSolver.buildRouteDb(nodeName, areaLinkStates, prefixState);
+  ASSERT_TRUE(routeDb.has_value());
+
+  // nothing changed
+  auto delta = spfSolver.buildRouteDbDelta(
+      nodeName, areaLinkStates, prefixState, *routeDb);
+  ASSERT_TRUE(delta.has_value());
+  EXPECT_EQ(0, delta->unicastRoutesToUpdate.size());
+  EXPECT_EQ(0, delta->unicastRoutesToDelete.size());
+  EXPECT_EQ(0, delta->mplsRoutesToUpdate.size());
+  EXPECT_EQ(0, delta->mplsRoutesToDelete.size());
+
+  // withdraw prefix of node 5, isolate node 4 and add a prefix to node 6
+  prefixState.updatePrefixDatabase(createPrefixDb("5"));
+  linkState.updateAdjacencyDatabase(createAdjDb("4", {}, 5));
+  prefixState.updatePrefixDatabase(createPrefixDb(
+      "6",
+      {createPrefixEntry(toIpPrefix(nodeToPrefixV6(6))),
+       createPrefixEntry(addr1)}));
+
+  auto newRouteDb =
+      spfSolver.buildRouteDb(nodeName, areaLinkStates, prefixState);
+  ASSERT_TRUE(newRouteDb.has_value());
+  auto expectedDelta = routeDb->calculateUpdate(std::move(*newRouteDb));
+  delta = spfSolver.buildRouteDbDelta(
+      nodeName, areaLinkStates, prefixState, *routeDb);
+  ASSERT_TRUE(delta.has_value());
+  EXPECT_EQ(2, delta->unicastRoutesToDelete.size());
+
+  EXPECT_EQ(expectedDelta.unicastRoutesToUpdate, delta->unicastRoutesToUpdate);
+  EXPECT_THAT(
+      delta->unicastRoutesToDelete,
+      testing::UnorderedElementsAreArray(expectedDelta.unicastRoutesToDelete));
+  EXPECT_THAT(
+      delta->mplsRoutesToUpdate,
+      testing::UnorderedElementsAreArray(expectedDelta.mplsRoutesToUpdate));
+  EXPECT_THAT(
+      delta->mplsRoutesToDelete,
+      testing::UnorderedElementsAreArray(expectedDelta.mplsRoutesToDelete));
+}
+
+// prefixes announced by the same set of nodes share next-hops, which are
+// computed once per topology
+TEST(GridTopology, NextHopsCache) {
+  std::string nodeName("1");
+  SpfSolver spfSolver(nodeName, false, true);
+
+  std::unordered_map<std::string, LinkState> areaLinkStates;
+  areaLinkStates.emplace(kDefaultArea, LinkState(kDefaultArea));
+  auto& linkState = areaLinkStates.at(kDefaultArea);
+  PrefixState prefixState;
+  createGrid(linkState, prefixState, 4);
+
+  // node 10 announces a few more prefixes next to its loopback
+  std::vector<thrift::PrefixEntry> prefixEntries{
+      createPrefixEntry(toIpPrefix(nodeToPrefixV6(10)))};
+  for (int i = 0; i < 4; ++i) {
+    prefixEntries.emplace_back(
+        createPrefixEntry(toIpPrefix(folly::sformat("fc00:{}::/64", i))));
+  }
+  prefixState.updatePrefixDatabase(createPrefixDb("10", prefixEntries));
+
+  // routes computed from scratch
+  std::vector<std::optional<RibUnicastEntry>> expectedRoutes;
+  for (auto const& entry : prefixEntries) {
+    SpfSolver freshSpfSolver(nodeName, false, true);
+    expectedRoutes.emplace_back(freshSpfSolver.createRouteForPrefix(
+        nodeName,
+        areaLinkStates,
+        prefixState,
+        toIPNetwork(*entry.prefix_ref())));
+    ASSERT_TRUE(expectedRoutes.back().has_value());
+  }
+
+  auto getCount = [](std::string const& key) {
+    return fb303::fbData->getCounters().at(key + ".count.60");
+  };
+  auto const hits = getCount("decision.nexthops_cache_hits");
+  auto const misses = getCount("decision.nexthops_cache_misses");
+  for (size_t i = 0; i < prefixEntries.size(); ++i) {
+    EXPECT_EQ(
+        expectedRoutes.at(i),
+        spfSolver.createRouteForPrefix(
+            nodeName,
+            areaLinkStates,
+            prefixState,
+            toIPNetwork(*prefixEntries.at(i).prefix_ref())));
+  }
+  EXPECT_EQ(hits + 4, getCount("decision.nexthops_cache_hits"));
+  EXPECT_EQ(misses + 1, getCount("decision.nexthops_cache_misses"));
+
+  // a topology change invalidates the cached next-hops
+  auto adjDb = linkState.getAdjacencyDatabases().at("10");
+  adjDb.isOverloaded_ref() = true;
+  EXPECT_TRUE(linkState.updateAdjacencyDatabase(adjDb).topologyChanged);
+  auto const prefix = toIPNetwork(*prefixEntries.back().prefix_ref());
+  EXPECT_TRUE(spfSolver
+                  .createRouteForPrefix(
+                      nodeName, areaLinkStates, prefixState, prefix)
+                  .has_value());
+  EXPECT_EQ(misses + 2, getCount("decision.nexthops_cache_misses"));
+}
+
+// SR_MPLS next-hops are shared as well, unless prefixes carry prepend labels
+TEST(GridTopology, NextHopsCacheSrMpls) {
+  std::string nodeName("1");
+  SpfSolver spfSolver(nodeName, false, true);
+
+  std::unordered_map<std::string, LinkState> areaLinkStates;
+  areaLinkStates.emplace(kDefaultArea, LinkState(kDefaultArea));
+  auto& linkState = areaLinkStates.at(kDefaultArea);
+  PrefixState prefixState;
+  createGrid(linkState, prefixState, 4);
+
+  std::vector<thrift::PrefixEntry> prefixEntries;
+  for (int i = 0; i < 4; ++i) {
+    prefixEntries.emplace_back(createPrefixEntry(
+        toIpPrefix(folly::sformat("fc00:{}::/64", i)),
+        thrift::PrefixType::LOOPBACK,
+        "",
+        thrift::PrefixForwardingType::SR_MPLS));
+  }
+  auto labeledEntry = createPrefixEntry(
+      toIpPrefix("fc01::/64"),
+      thrift::PrefixType::LOOPBACK,
+      "",
+      thrift::PrefixForwardingType::SR_MPLS);
+  labeledEntry.prependLabel_ref() = 60000;
+  prefixEntries.emplace_back(labeledEntry);
+  prefixEntries.emplace_back(createPrefixEntry(toIpPrefix(nodeToPrefixV6(10))));
+  prefixState.updatePrefixDatabase(createPrefixDb("10", prefixEntries));
+
+  // routes computed from scratch
+  std::vector<std::optional<RibUnicastEntry>> expectedRoutes;
+  for (auto const& entry : prefixEntries) {
+    SpfSolver freshSpfSolver(nodeName, false, true);
+    expectedRoutes.emplace_back(freshSpfSolver.createRouteForPrefix(
+        nodeName,
+        areaLinkStates,
+        prefixState,
+        toIPNetwork(*entry.prefix_ref())));
+    ASSERT_TRUE(expectedRoutes.back().has_value());
+  }
+
+  auto getCount = [](std::string const& key) {
+    return fb303::fbData->getCounters().at(key + ".count.60");
+  };
+  auto const hits = getCount("decision.nexthops_cache_hits");
+  auto const misses = getCount("decision.nexthops_cache_misses");
+  std::vector<std::optional<RibUnicastEntry>> routes;
+  for (size_t i = 0; i < prefixEntries.size(); ++i) {
+    routes.emplace_back(spfSolver.createRouteForPrefix(
+        nodeName,
+        areaLinkStates,
+        prefixState,
+        toIPNetwork(*prefixEntries.at(i).prefix_ref())));
+    EXPECT_EQ(expectedRoutes.at(i), routes.back());
+  }
+  // one miss per forwarding type, the labeled prefix isn't cached
+  EXPECT_EQ(hits + 3, getCount("decision.nexthops_cache_hits"));
+  EXPECT_EQ(misses + 2, getCount("decision.nexthops_cache_misses"));
+
+  // label stacks differ from IP forwarded next-hops towards the same node
+  EXPECT_EQ(routes.at(0)->nexthops.id(), routes.at(3)->nexthops.id());
+  EXPECT_NE(routes.at(0)->nexthops.id(), routes.at(4)->nexthops.id());
+  EXPECT_NE(routes.at(0)->nexthops.id(), routes.at(5)->nexthops.id());
+}
+
+TEST(GridTopology, IncrementalMplsRoutes) {
+  const int n = 4;
+  std::string nodeName("1");
+  SpfSolver spfSolver(nodeName, false, false);
+
+  std::unordered_map<std::string, LinkState> areaLinkStates;
+  areaLinkStates.emplace(kDefaultArea, LinkState(kDefaultArea));
+  auto& linkState = areaLinkStates.at(kDefaultArea);
+  PrefixState prefixState;
+  createGrid(linkState, prefixState, n);
+
+  auto getBuilt = []() {
+    return fb303::fbData->getCounters().at(
+        "decision.node_label_routes_built.count.60");
+  };
+  auto expectRoutesFromScratch = [&]() {
+    // routes of another node than its own are always built from scratch
+    SpfSolver freshSpfSolver("", false, false);
+    EXPECT_EQ(
+        freshSpfSolver.buildMplsRouteDb(nodeName, areaLinkStates).mplsRoutes,
+        spfSolver.buildMplsRouteDb(nodeName, areaLinkStates).mplsRoutes);
+  };
+  auto updateAdjacencies = [&](int i, int j, int32_t label, int metric) {
+    std::vector<thrift::Adjacency> adjs;
+    addAdj(i, j + 1, "0/1", adjs, n, "0/3");
+    addAdj(i - 1, j, "0/2", adjs, n, "0/4");
+    addAdj(i, j - 1, "0/3", adjs, n, "0/1");
+    addAdj(i + 1, j, "0/4", adjs, n, "0/2");
+    adjs.at(0).metric_ref() = metric;
+    linkState.updateAdjacencyDatabase(
+        createAdjDb(folly::sformat("{}", i * n + j), adjs, label));
+  };
+
+  // first build covers every node
+  auto built = getBuilt();
+  expectRoutesFromScratch();
+  EXPECT_EQ(built + n * n, getBuilt());
+
+  // nothing changed, nothing is built
+  built = getBuilt();
+  spfSolver.buildMplsRouteDb(nodeName, areaLinkStates);
+  EXPECT_EQ(built, getBuilt());
+
+  // node label change of a far away node
+  built = getBuilt();
+  updateAdjacencies(3, 1, 100, 1);
+  expectRoutesFromScratch();
+  EXPECT_EQ(built + 1, getBuilt());
+
+  // metric change of a far away link
+  built = getBuilt();
+  updateAdjacencies(3, 2, 3 * n + 2 + 1, 10);
+  expectRoutesFromScratch();
+  EXPECT_GT(built + n * n, getBuilt());
+
+  // local link change affects every node
+  built = getBuilt();
+  updateAdjacencies(0, 1, 2, 10);
+  expectRoutesFromScratch();
+  EXPECT_EQ(built + n * n, getBuilt());
+}
+
+//
+// Node 1 borders area "a" (1 - 2 - 3) and area "b" (1 - 4 - 5). A topology
+// change in area b leaves cached next-hops towards nodes of area a alone
+//
+TEST(MultiArea, NextHopsCache) {
+  std::string nodeName("1");
+  SpfSolver spfSolver(nodeName, false, false);
+
+  std::unordered_map<std::string, LinkState> areaLinkStates;
+  PrefixState prefixState;
+  auto addNode = [&](std::string const& area,
+                     std::string const& node,
+                     std::vector<thrift::Adjacency> const& adjs) {
+    areaLinkStates.emplace(area, LinkState(area));
+    areaLinkStates.at(area).updateAdjacencyDatabase(
+        createAdjDb(node, adjs, 0, false, area));
+  };
+  auto adj = [](std::string const& from, std::string const& to, int metric) {
+    return createAdjacency(
+        to,
+        folly::sformat("{}/{}", from, to),
+        folly::sformat("{}/{}", to, from),
+        folly::sformat("fe80::{}", to),
+        folly::sformat("192.168.0.{}", to),
+        metric,
+        0);
+  };
+  addNode("a", "1", {adj("1", "2", 10)});
+  addNode("a", "2", {adj("2", "1", 10), adj("2", "3", 10)});
+  addNode("a", "3", {adj("3", "2", 10)});
+  addNode("b", "1", {adj("1", "4", 10)});
+  addNode("b", "4", {adj("4", "1", 10), adj("4", "5", 10)});
+  addNode("b", "5", {adj("5", "4", 10)});
+  prefixState.updatePrefixDatabase(
+      createPrefixDb("2", {createPrefixEntry(addr2)}, "a"));
+  prefixState.updatePrefixDatabase(
+      createPrefixDb("3", {createPrefixEntry(addr3)}, "a"));
+  prefixState.updatePrefixDatabase(
+      createPrefixDb("5", {createPrefixEntry(addr5)}, "b"));
+
+  auto getCount = [](std::string const& key) {
+    return fb303::fbData->getCounters().at(key + ".count.60");
+  };
+  auto expectRoutesFromScratch = [&]() {
+    // routes of another node than its own are never cached
+    SpfSolver freshSpfSolver("", false, false);
+    for (auto const& prefix : {addr2, addr3, addr5}) {
+      auto const expected = freshSpfSolver.createRouteForPrefix(
+          nodeName, areaLinkStates, prefixState, toIPNetwork(prefix));
+      ASSERT_TRUE(expected.has_value());
+      EXPECT_EQ(
+          expected,
+          spfSolver.createRouteForPrefix(
+              nodeName, areaLinkStates, prefixState, toIPNetwork(prefix)));
+    }
+  };
+
+  auto hits = getCount("decision.nexthops_cache_hits");
+  auto misses = getCount("decision.nexthops_cache_misses");
+  expectRoutesFromScratch();
+  EXPECT_EQ(hits, getCount("decision.nexthops_cache_hits"));
+  EXPECT_EQ(misses + 3, getCount("decision.nexthops_cache_misses"));
+
+  // only the route towards node 5 is computed again
+  areaLinkStates.at("b").updateAdjacencyDatabase(createAdjDb(
+      "4", {adj("4", "1", 10), adj("4", "5", 20)}, 0, false, "b"));
+  hits = getCount("decision.nexthops_cache_hits");
+  misses = getCount("decision.nexthops_cache_misses");
+  expectRoutesFromScratch();
+  EXPECT_EQ(hits + 2, getCount("decision.nexthops_cache_hits"));
+  EXPECT_EQ(misses + 1, getCount("decision.nexthops_cache_misses"));
+}
+
 // measure SPF execution time for large networks
 TEST(GridTopology, StressTest) {
   if (!FLAGS_stress_test) {
@@ -4380,7 +4946,7 @@ class DecisionTestFixture : public ::testing::Test {
   void
   SetUp() override {
     // reset all global counters
-    fb303::fbData->resetAllData();
+    resetAllStats();
 
     auto tConfig = createConfig();
     config = std::make_shared<Config>(tConfig);
@@ -4393,7 +4959,9 @@ class DecisionTestFixture : public ::testing::Test {
         debounceTimeoutMax,
         kvStoreUpdatesQueue.getReader(),
         staticRoutesUpdateQueue.getReader(),
-        routeUpdatesQueue);
+        routeUpdatesQueue,
+        &linkStateUpdatesQueue,
+        createRouteEngine());
 
     decisionThread = std::make_unique<std::thread>([this]() {
       LOG(INFO) << "Decision thread starting";
@@ -4407,6 +4975,7 @@ class DecisionTestFixture : public ::testing::Test {
   TearDown() override {
     kvStoreUpdatesQueue.close();
     staticRoutesUpdateQueue.close();
+    linkStateUpdatesQueue.close();
 
     LOG(INFO) << "Stopping the decision thread";
     decision->stop();
@@ -4422,6 +4991,11 @@ class DecisionTestFixture : public ::testing::Test {
     return tConfig;
   }
 
+  virtual std::unique_ptr<RouteComputationEngine>
+  createRouteEngine() {
+    return nullptr;
+  }
+
   //
   // member methods
   //
@@ -4444,7 +5018,7 @@ class DecisionTestFixture : public ::testing::Test {
   recvRouteUpdates() {
     auto maybeRouteDb = routeUpdatesQueueReader.get();
     EXPECT_FALSE(maybeRouteDb.hasError());
-    auto routeDbDelta = maybeRouteDb.value();
+    auto routeDbDelta = *maybeRouteDb.value();
     return routeDbDelta;
   }
 
@@ -4565,11 +5139,14 @@ class DecisionTestFixture : public ::testing::Test {
   CompactSerializer serializer{};
 
   std::shared_ptr<Config> config;
-  messaging::ReplicateQueue<thrift::Publication> kvStoreUpdatesQueue;
+  messaging::ReplicateQueue<PublicationPtr> kvStoreUpdatesQueue;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> staticRoutesUpdateQueue;
-  messaging::ReplicateQueue<DecisionRouteUpdate> routeUpdatesQueue;
-  messaging::RQueue<DecisionRouteUpdate> routeUpdatesQueueReader{
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue;
+  messaging::RQueue<DecisionRouteUpdatePtr> routeUpdatesQueueReader{
       routeUpdatesQueue.getReader()};
+  messaging::ReplicateQueue<thrift::LinkStateDelta> linkStateUpdatesQueue;
+  messaging::RQueue<thrift::LinkStateDelta> linkStateUpdatesQueueReader{
+      linkStateUpdatesQueue.getReader()};
 
   // Decision owned by this wrapper.
   std::shared_ptr<Decision> decision{nullptr};
@@ -4787,7 +5364,7 @@ TEST_F(DecisionTestFixture, BasicOperations) {
 
   // Update 32011 and make sure only that is updated
   sendStaticRoutesUpdate(input);
-  auto routesDelta = routeUpdatesQueueReader.get().value();
+  auto routesDelta = *routeUpdatesQueueReader.get().value();
   routesDelta.perfEvents.reset();
   EXPECT_EQ(routesDelta.toThrift(), input);
 
@@ -4795,7 +5372,7 @@ TEST_F(DecisionTestFixture, BasicOperations) {
   route.topLabel = 32012;
   *input.mplsRoutesToUpdate_ref() = {route};
   sendStaticRoutesUpdate(input);
-  routesDelta = routeUpdatesQueueReader.get().value();
+  routesDelta = *routeUpdatesQueueReader.get().value();
   routesDelta.perfEvents.reset();
   EXPECT_EQ(routesDelta.toThrift(), input);
 
@@ -4816,7 +5393,7 @@ TEST_F(DecisionTestFixture, BasicOperations) {
   *input.mplsRoutesToDelete_ref() = {32011};
   sendStaticRoutesUpdate(input);
 
-  routesDelta = routeUpdatesQueueReader.get().value();
+  routesDelta = *routeUpdatesQueueReader.get().value();
   routesDelta.perfEvents.reset();
   EXPECT_EQ(routesDelta.mplsRoutesToDelete.at(0), 32011);
   EXPECT_EQ(routesDelta.mplsRoutesToUpdate.size(), 0);
@@ -4837,7 +5414,7 @@ TEST_F(DecisionTestFixture, BasicOperations) {
   input.mplsRoutesToDelete_ref()->clear();
   sendStaticRoutesUpdate(input);
 
-  routesDelta = routeUpdatesQueueReader.get().value();
+  routesDelta = *routeUpdatesQueueReader.get().value();
   routesDelta.perfEvents.reset();
   EXPECT_EQ(1, routesDelta.mplsRoutesToUpdate.size());
   EXPECT_EQ(32012, routesDelta.mplsRoutesToUpdate.at(0).label);
@@ -4866,6 +5443,231 @@ TEST_F(DecisionTestFixture, BasicOperations) {
   EXPECT_TRUE(foundLabelRoute);
 }
 
+/**
+ * RouteDbs of all nodes are built once per topology and served from cache
+ * until the topology changes.
+ */
+TEST_F(DecisionTestFixture, ComputedRouteDbs) {
+  auto getBuilds = []() {
+    return fb303::fbData->getCounters().at(
+        "decision.computed_route_dbs.builds.sum");
+  };
+
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12}, false, 1)},
+       {"adj:2", createAdjValue("2", 1, {adj21, adj23}, false, 2)},
+       {"adj:3", createAdjValue("3", 1, {adj32}, false, 3)},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})},
+       {"prefix:3", createPrefixValue("3", 1, {addr3})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvRouteUpdates();
+
+  // all nodes in name order, each matching its own query
+  auto routeDbs = decision->getDecisionRouteDbs({}).get();
+  ASSERT_EQ(3, routeDbs->size());
+  EXPECT_EQ(3, getBuilds());
+  auto routeDbMap = dumpRouteDb({"1", "2", "3"});
+  EXPECT_EQ(3, getBuilds());
+  for (auto const& routeDb : *routeDbs) {
+    auto const& nodeName = *routeDb.thisNodeName_ref();
+    EXPECT_EQ(
+        routeDbMap.at(nodeName).unicastRoutes_ref()->size(),
+        routeDb.unicastRoutes_ref()->size());
+  }
+  EXPECT_EQ("1", *routeDbs->at(0).thisNodeName_ref());
+  EXPECT_EQ(2, routeDbs->at(0).unicastRoutes_ref()->size());
+
+  // topology change builds them anew
+  publication = createThriftPublication(
+      {{"adj:2", createAdjValue("2", 2, {adj21}, false, 2)}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvRouteUpdates();
+  routeDbMap = dumpRouteDb({"1"});
+  EXPECT_EQ(4, getBuilds());
+  EXPECT_EQ(1, routeDbMap.at("1").unicastRoutes_ref()->size());
+}
+
+/**
+ * What-if scenarios are computed against forks of the topology, each on its
+ * own, and leave live routes alone.
+ */
+TEST_F(DecisionTestFixture, RouteDbsWhatIf) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12}, false, 1)},
+       {"adj:2", createAdjValue("2", 1, {adj21, adj23}, false, 2)},
+       {"adj:3", createAdjValue("3", 1, {adj32}, false, 3)},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})},
+       {"prefix:3", createPrefixValue("3", 1, {addr3})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvRouteUpdates();
+
+  thrift::WhatIfLink link23;
+  link23.area_ref() = kDefaultArea;
+  link23.nodeName_ref() = "2";
+  link23.ifName_ref() = *adj23.ifName_ref();
+
+  thrift::WhatIfScenario noChange;
+  noChange.name_ref() = "no-change";
+  thrift::WhatIfScenario linkFailure;
+  linkFailure.name_ref() = "link-failure";
+  linkFailure.linkFailures_ref()->emplace_back(link23);
+  thrift::WhatIfScenario nodeFailure;
+  nodeFailure.name_ref() = "node-failure";
+  nodeFailure.nodeFailures_ref()->emplace_back("2");
+  thrift::WhatIfScenario metricChange;
+  metricChange.name_ref() = "metric-change";
+  metricChange.metricChanges_ref()->emplace_back();
+  metricChange.metricChanges_ref()->back().link_ref() = link23;
+  metricChange.metricChanges_ref()->back().metric_ref() = 100;
+
+  auto routeDbs =
+      decision
+          ->getRouteDbsWhatIf(
+              "", {noChange, linkFailure, nodeFailure, metricChange})
+          .get();
+  ASSERT_EQ(4, routeDbs->size());
+  for (auto const& routeDb : *routeDbs) {
+    EXPECT_EQ("1", *routeDb.thisNodeName_ref());
+  }
+  EXPECT_EQ(2, routeDbs->at(0).unicastRoutes_ref()->size());
+  EXPECT_EQ(1, routeDbs->at(1).unicastRoutes_ref()->size());
+  EXPECT_EQ(0, routeDbs->at(2).unicastRoutes_ref()->size());
+  EXPECT_EQ(2, routeDbs->at(3).unicastRoutes_ref()->size());
+  for (auto const& route : *routeDbs->at(3).unicastRoutes_ref()) {
+    if (*route.dest_ref() == addr3) {
+      ASSERT_EQ(1, route.nextHops_ref()->size());
+      EXPECT_EQ(110, *route.nextHops_ref()->at(0).metric_ref());
+    }
+  }
+
+  // live routes are unaffected
+  auto routeDbMap = dumpRouteDb({"1"});
+  EXPECT_EQ(2, routeDbMap.at("1").unicastRoutes_ref()->size());
+
+  // scenarios referring to unknown nodes or links fail the query
+  thrift::WhatIfScenario unknownNode;
+  unknownNode.name_ref() = "unknown-node";
+  unknownNode.overloadedNodes_ref()->emplace_back("4");
+  EXPECT_THROW(
+      decision->getRouteDbsWhatIf("1", {noChange, unknownNode}).get(),
+      thrift::OpenrError);
+  link23.ifName_ref() = "2/4";
+  linkFailure.linkFailures_ref() = {link23};
+  EXPECT_THROW(
+      decision->getRouteDbsWhatIf("1", {linkFailure}).get(),
+      thrift::OpenrError);
+}
+
+/**
+ * Adjacency and prefix databases are read from a snapshot taken when routes
+ * are rebuilt, not copied again per query. Snapshot is up to date with the
+ * publications processed before the query.
+ */
+TEST_F(DecisionTestFixture, ReadSnapshot) {
+  auto getSnapshotUpdates = []() {
+    return fb303::fbData->getCounters().at(
+        "decision.read_snapshot_updates.count");
+  };
+
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12}, false, 1)},
+       {"adj:2", createAdjValue("2", 1, {adj21}, false, 2)},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvRouteUpdates();
+
+  const auto snapshotUpdates = getSnapshotUpdates();
+  for (int i = 0; i < 3; ++i) {
+    auto adjDbs = decision->getDecisionAdjacencyDbs().get();
+    EXPECT_EQ(2, adjDbs->size());
+    EXPECT_EQ(2, decision->getAllDecisionAdjacencyDbs().get()->size());
+    EXPECT_EQ(2, decision->getDecisionPrefixDbs().get()->size());
+  }
+  EXPECT_EQ(snapshotUpdates, getSnapshotUpdates());
+
+  // new adjacency db is seen by the next query
+  publication = createThriftPublication(
+      {{"adj:2", createAdjValue("2", 2, {}, false, 2)}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  recvRouteUpdates();
+  auto adjDbs = decision->getDecisionAdjacencyDbs().get();
+  EXPECT_TRUE(adjDbs->at("2").adjacencies_ref()->empty());
+  EXPECT_EQ(snapshotUpdates + 1, getSnapshotUpdates());
+}
+
+/**
+ * Queries issued once routes of a publication are out see its databases,
+ * also while the read snapshot is being replaced on Decision thread.
+ */
+TEST_F(DecisionTestFixture, ReadSnapshotAfterPublication) {
+  auto publishMetric = [&](int32_t metric) {
+    auto adj = adj12;
+    adj.metric_ref() = metric;
+    sendKvPublication(createThriftPublication(
+        {{"adj:1", createAdjValue("1", metric, {adj}, false, 1)},
+         {"adj:2", createAdjValue("2", 1, {adj21}, false, 2)},
+         {"prefix:1", createPrefixValue("1", 1, {addr1})},
+         {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+        {},
+        {},
+        {},
+        std::string("")));
+    recvRouteUpdates();
+  };
+  publishMetric(1);
+
+  // metric of the last publication whose routes were received
+  std::atomic<int32_t> minMetric{1};
+  std::atomic<bool> done{false};
+  std::atomic<size_t> numStale{0};
+  std::vector<std::thread> queriers;
+  for (int i = 0; i < 4; ++i) {
+    queriers.emplace_back([&]() {
+      while (not done) {
+        auto const expectedMetric = minMetric.load();
+        auto adjDbs = decision->getDecisionAdjacencyDbs().get();
+        auto const& adjs = *adjDbs->at("1").adjacencies_ref();
+        if (adjs.size() != 1 or *adjs.at(0).metric_ref() < expectedMetric) {
+          ++numStale;
+        }
+      }
+    });
+  }
+
+  for (int32_t metric = 2; metric <= 50; ++metric) {
+    publishMetric(metric);
+    minMetric = metric;
+  }
+  done = true;
+  for (auto& querier : queriers) {
+    querier.join();
+  }
+  EXPECT_EQ(0, numStale);
+}
+
 /**
  * Publish all types of update to Decision and expect that Decision emits
  * a full route database that includes all the routes as its first update.
@@ -5151,6 +5953,7 @@ TEST_F(DecisionTestFixture, SelfReditributePrefixPublication) {
  * - Set policy
  * - Get policy after setting
  * - Verify that set-policy triggers the route database change (apply policy)
+ *   of affected routes, without rebuilding routes
  * - Set the policy with 0 weight. See that route dis-appears
  * - Expire policy. Verify it triggers the route database change (undo policy)
  */
@@ -5193,6 +5996,8 @@ TEST_F(DecisionTestFixture, RibPolicy) {
   policy.ttl_secs_ref() = 1;
 
   // Set rib policy
+  const auto numSpfRuns =
+      fb303::fbData->getCounters().at("decision.spf_runs.count");
   EXPECT_NO_THROW(decision->setRibPolicy(policy).get());
 
   // Get rib policy and verify
@@ -5202,7 +6007,8 @@ TEST_F(DecisionTestFixture, RibPolicy) {
     EXPECT_GE(*policy.ttl_secs_ref(), *retrievedPolicy.ttl_secs_ref());
   }
 
-  // Expect the route database change with next-hop weight to be 2
+  // Expect the route database change with next-hop weight to be 2, applied
+  // on the affected route only without recomputing routes
   {
     auto updates = recvRouteUpdates();
     ASSERT_EQ(1, updates.unicastRoutesToUpdate.size());
@@ -5211,6 +6017,9 @@ TEST_F(DecisionTestFixture, RibPolicy) {
         *updates.unicastRoutesToUpdate.begin()
              ->second.nexthops.begin()
              ->weight_ref());
+    auto counters = fb303::fbData->getCounters();
+    EXPECT_EQ(numSpfRuns, counters.at("decision.spf_runs.count"));
+    EXPECT_EQ(1, counters.at("decision.rib_policy.affected_routes.sum"));
   }
 
   // Set the policy with empty weight. Expect route remains intact and error
@@ -5259,13 +6068,33 @@ TEST_F(DecisionTestFixture, RibPolicy) {
     EXPECT_EQ(2, counters.at("decision.rib_policy.invalidated_routes.count"));
   }
 
-  // Let the policy expire. Wait for another route database change
+  // Set the policy with weight again, and let it expire. Wait for the route
+  // database changes applying and reverting it
+  policy.statements_ref()
+      ->at(0)
+      .action_ref()
+      ->set_weight_ref()
+      ->neighbor_to_weight_ref()["2"] = 2;
+  EXPECT_NO_THROW(decision->setRibPolicy(policy).get());
   {
     auto updates = recvRouteUpdates();
-    ASSERT_EQ(0, updates.unicastRoutesToUpdate.size());
-
-    auto retrievedPolicy = decision->getRibPolicy().get();
-    EXPECT_GE(0, *retrievedPolicy.ttl_secs_ref());
+    ASSERT_EQ(1, updates.unicastRoutesToUpdate.count(toIPNetwork(addr2)));
+    EXPECT_EQ(
+        2,
+        *updates.unicastRoutesToUpdate.at(toIPNetwork(addr2))
+             .nexthops.begin()
+             ->weight_ref());
+  }
+  {
+    auto updates = recvRouteUpdates();
+    ASSERT_EQ(1, updates.unicastRoutesToUpdate.count(toIPNetwork(addr2)));
+    for (auto& nh :
+         updates.unicastRoutesToUpdate.at(toIPNetwork(addr2)).nexthops) {
+      EXPECT_FALSE(nh.weight_ref().has_value());
+    }
+
+    auto retrievedPolicy = decision->getRibPolicy().get();
+    EXPECT_GE(0, *retrievedPolicy.ttl_secs_ref());
   }
 }
 
@@ -5292,9 +6121,9 @@ TEST(Decision, RibPolicyFeatureKnob) {
   auto config = std::make_shared<Config>(tConfig);
   ASSERT_FALSE(config->isRibPolicyEnabled());
 
-  messaging::ReplicateQueue<thrift::Publication> kvStoreUpdatesQueue;
+  messaging::ReplicateQueue<PublicationPtr> kvStoreUpdatesQueue;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> staticRoutesUpdateQueue;
-  messaging::ReplicateQueue<DecisionRouteUpdate> routeUpdatesQueue;
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue;
   auto decision = std::make_unique<Decision>(
       config,
       true, /* computeLfaPaths */
@@ -5350,6 +6179,99 @@ TEST(Decision, RibPolicyFeatureKnob) {
 // received
 //
 
+//
+// Link state changes are published once per KvStore publication, and
+// databases retrieved afterwards reflect them
+//
+TEST_F(DecisionTestFixture, LinkStateUpdates) {
+  auto recvChanges = [this]() {
+    auto maybeDelta = linkStateUpdatesQueueReader.get();
+    EXPECT_FALSE(maybeDelta.hasError());
+    std::map<
+        std::pair<thrift::LinkStateChangeType, std::string>,
+        thrift::LinkStateChange>
+        changes;
+    for (auto const& change : *maybeDelta.value().changes_ref()) {
+      EXPECT_EQ(kDefaultArea, *change.area_ref());
+      changes.emplace(
+          std::make_pair(*change.type_ref(), *change.nodeName_ref()), change);
+    }
+    return changes;
+  };
+
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12})},
+       {"adj:2", createAdjValue("2", 1, {adj21})},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  auto changes = recvChanges();
+  EXPECT_EQ(3, changes.size());
+  EXPECT_EQ(
+      adj12,
+      *changes.at({thrift::LinkStateChangeType::ADJACENCY_UP, "1"})
+           .adjacency_ref());
+  EXPECT_EQ(
+      adj21,
+      *changes.at({thrift::LinkStateChangeType::ADJACENCY_UP, "2"})
+           .adjacency_ref());
+  EXPECT_EQ(
+      addr1,
+      *changes.at({thrift::LinkStateChangeType::PREFIX_ADDED, "1"})
+           .prefix_ref());
+
+  auto dbs = decision->getLinkStateDatabases().get();
+  EXPECT_EQ(2, dbs->adjacencyDbs_ref()->size());
+  EXPECT_EQ(1, dbs->prefixDbs_ref()->size());
+
+  // metric change and overload of node 1, rtt alone is no change
+  auto adj12Changed = adj12;
+  adj12Changed.metric_ref() = 100;
+  auto adj21Rtt = adj21;
+  adj21Rtt.rtt_ref() = *adj21.rtt_ref() + 1000;
+  publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 2, {adj12Changed}, true)},
+       {"adj:2", createAdjValue("2", 2, {adj21Rtt})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  changes = recvChanges();
+  EXPECT_EQ(2, changes.size());
+  EXPECT_EQ(
+      adj12Changed,
+      *changes.at({thrift::LinkStateChangeType::ADJACENCY_CHANGED, "1"})
+           .adjacency_ref());
+  EXPECT_TRUE(*changes.at({thrift::LinkStateChangeType::NODE_OVERLOAD, "1"})
+                   .isOverloaded_ref());
+
+  // expiry of adjacency and prefix databases
+  publication = createThriftPublication(
+      {}, {"adj:2", "prefix:1"}, {}, {}, std::string(""));
+  sendKvPublication(publication);
+  changes = recvChanges();
+  EXPECT_EQ(2, changes.size());
+  EXPECT_EQ(
+      adj21Rtt,
+      *changes.at({thrift::LinkStateChangeType::ADJACENCY_DOWN, "2"})
+           .adjacency_ref());
+  EXPECT_EQ(
+      addr1,
+      *changes.at({thrift::LinkStateChangeType::PREFIX_REMOVED, "1"})
+           .prefix_ref());
+  EXPECT_FALSE(changes.at({thrift::LinkStateChangeType::PREFIX_REMOVED, "1"})
+                   .prefixEntry_ref()
+                   .has_value());
+
+  dbs = decision->getLinkStateDatabases().get();
+  EXPECT_EQ(1, dbs->adjacencyDbs_ref()->size());
+  EXPECT_EQ(0, dbs->prefixDbs_ref()->size());
+}
+
 TEST_F(DecisionTestFixture, ParallelLinks) {
   auto adj12_1 =
       createAdjacency("2", "1/2-1", "2/1-1", "fe80::2", "192.168.0.2", 100, 0);
@@ -6134,12 +7056,14 @@ TEST_F(DecisionTestFixture, DecisionSubReliability) {
   // Verify counters information
   //
 
+  // duplicate publications are not decoded again
   const int64_t adjUpdateCnt = 1000 /* initial */;
-  const int64_t prefixUpdateCnt = totalSent + 1000 /* initial */ + 1 /* end */;
+  const int64_t prefixUpdateCnt = 1000 /* initial */ + 1 /* end */;
   auto counters = fb303::fbData->getCounters();
   EXPECT_EQ(4, counters["decision.spf_runs.count"]);
   EXPECT_EQ(adjUpdateCnt, counters["decision.adj_db_update.count"]);
   EXPECT_EQ(prefixUpdateCnt, counters["decision.prefix_db_update.count"]);
+  EXPECT_EQ(totalSent, counters["decision.skipped_unchanged_decode.count"]);
 }
 
 /*
@@ -6246,6 +7170,87 @@ TEST_F(DecisionTestFixture, PerPrefixKeyExpiry) {
   EXPECT_EQ(toIPNetwork(addr5), routeDbDelta.unicastRoutesToDelete.at(0));
 }
 
+//
+// Verify adjacency database deltas are applied on top of their snapshot only
+//
+// 1---2---3
+//
+TEST_F(DecisionTestFixture, AdjDbDelta) {
+  auto createValue = [this](int64_t version, auto const& obj) {
+    return createThriftValue(
+        version,
+        "2",
+        fbzmq::util::writeThriftObjStr(obj, serializer),
+        Constants::kTtlInfinity /* ttl */,
+        0 /* ttl version */,
+        0 /* hash */);
+  };
+
+  // node 2 doesn't announce adj23 in its snapshot, addr3 is not reachable
+  auto adjDb2 = createAdjDb("2", {adj21}, 2);
+  adjDb2.snapshotId_ref() = 1;
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12}, false, 1)},
+       {"adj:2", createValue(1, adjDb2)},
+       {"adj:3", createAdjValue("3", 1, {adj32}, false, 3)},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})},
+       {"prefix:3", createPrefixValue("3", 1, {addr3})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+  auto routeDbDelta = recvRouteUpdates();
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.count(toIPNetwork(addr2)));
+
+  // delta adds adj23
+  auto delta = createAdjDbDelta(adjDb2, createAdjDb("2", {adj21, adj23}, 2));
+  delta.baseSnapshotId_ref() = 1;
+  publication = createThriftPublication(
+      {{"adjdelta:2", createValue(1, delta)}}, {}, {}, {}, std::string(""));
+  sendKvPublication(publication);
+  routeDbDelta = recvRouteUpdates();
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.count(toIPNetwork(addr3)));
+
+  // new snapshot without adj23, the delta is stale now
+  adjDb2.snapshotId_ref() = 2;
+  publication = createThriftPublication(
+      {{"adj:2", createValue(2, adjDb2)}}, {}, {}, {}, std::string(""));
+  sendKvPublication(publication);
+  routeDbDelta = recvRouteUpdates();
+  EXPECT_EQ(0, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToDelete.size());
+
+  // stale deltas are ignored
+  delta.updatedAdjacencies_ref()->front().metric_ref() = 20;
+  publication = createThriftPublication(
+      {{"adjdelta:2", createValue(2, delta)}}, {}, {}, {}, std::string(""));
+  sendKvPublication(publication);
+
+  // delta on the new snapshot adds adj23 again
+  delta.baseSnapshotId_ref() = 2;
+  publication = createThriftPublication(
+      {{"adjdelta:2", createValue(3, delta)}}, {}, {}, {}, std::string(""));
+  sendKvPublication(publication);
+  routeDbDelta = recvRouteUpdates();
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.count(toIPNetwork(addr3)));
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_EQ(1, counters.at("decision.adj_db_delta_without_base.count"));
+  EXPECT_EQ(2, counters.at("decision.adj_db_delta_update.count"));
+
+  // expired delta falls back to the snapshot
+  publication =
+      createThriftPublication({}, {"adjdelta:2"}, {}, {}, std::string(""));
+  sendKvPublication(publication);
+  routeDbDelta = recvRouteUpdates();
+  EXPECT_EQ(0, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToDelete.size());
+}
+
 //
 // This test aims to verify counter reporting from Decision module
 //
@@ -6387,6 +7392,302 @@ TEST_F(DecisionTestFixture, ExceedMaxBackoff) {
   sendKvPublication(publication);
 }
 
+// DecisionTestFixture with full route rebuilds off the event base
+class AsyncRouteBuildFixture : public DecisionTestFixture {
+  openr::thrift::OpenrConfig
+  createConfig() override {
+    auto tConfig = DecisionTestFixture::createConfig();
+    tConfig.decision_config_ref()->enable_async_route_build_ref() = true;
+    return tConfig;
+  }
+};
+
+//
+// Routes built off the event base get published, and topology changes
+// arriving back-to-back, possibly while a build is running, converge to the
+// routes of the latest topology
+//
+TEST_F(AsyncRouteBuildFixture, BasicOperations) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12}, false, 1)},
+       {"adj:2", createAdjValue("2", 1, {adj21}, false, 2)},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+
+  DecisionRouteDb routeDb;
+  auto routeDbDelta = recvRouteUpdates();
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  // self mpls route, node 2 mpls route and adj12 label route
+  EXPECT_EQ(3, routeDbDelta.mplsRoutesToUpdate.size());
+  EXPECT_TRUE(routeDbDelta.perfEvents.has_value());
+  routeDb.update(routeDbDelta);
+  EXPECT_EQ(
+      routeDb.unicastRoutes.at(toIPNetwork(addr2)).nexthops.get(),
+      NextHops({createNextHopFromAdj(adj12, false, 10)}));
+
+  // add node 3, then flap link 2-3
+  std::vector<thrift::Publication> publications{
+      createThriftPublication(
+          {{"adj:2", createAdjValue("2", 2, {adj21, adj23}, false, 2)},
+           {"adj:3", createAdjValue("3", 1, {adj32}, false, 3)},
+           {"prefix:3", createPrefixValue("3", 1, {addr3})}},
+          {},
+          {},
+          {},
+          std::string("")),
+      createThriftPublication(
+          {{"adj:2", createAdjValue("2", 3, {adj21}, false, 2)}},
+          {},
+          {},
+          {},
+          std::string("")),
+      createThriftPublication(
+          {{"adj:2", createAdjValue("2", 4, {adj21, adj23}, false, 2)}},
+          {},
+          {},
+          {},
+          std::string(""))};
+  for (auto const& pub : publications) {
+    sendKvPublication(pub);
+  }
+
+  const NextHops expectedNextHops{createNextHopFromAdj(adj12, false, 20)};
+  while (true) {
+    routeDb.update(recvRouteUpdates());
+    auto it = routeDb.unicastRoutes.find(toIPNetwork(addr3));
+    if (it != routeDb.unicastRoutes.end() and
+        it->second.nexthops.get() == expectedNextHops) {
+      break;
+    }
+  }
+
+  // published routes match the ones built on the event base
+  auto thriftRouteDb = dumpRouteDb({"1"})["1"];
+  RouteMap routeMap;
+  fillRouteMap("1", routeMap, thriftRouteDb);
+  EXPECT_EQ(routeMap[make_pair("1", toString(addr3))], expectedNextHops);
+  EXPECT_EQ(
+      routeMap[make_pair("1", toString(addr2))],
+      NextHops({createNextHopFromAdj(adj12, false, 10)}));
+
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_LE(2, counters.at("decision.async_route_builds.count"));
+}
+
+// DecisionTestFixture publishing routes which lost next-hops first
+class PriorityRouteUpdateFixture : public DecisionTestFixture {
+  openr::thrift::OpenrConfig
+  createConfig() override {
+    auto tConfig = DecisionTestFixture::createConfig();
+    tConfig.decision_config_ref()->enable_priority_route_update_ref() = true;
+    return tConfig;
+  }
+};
+
+//
+// When a link of this node goes down, routes via it are published in a
+// priority update ahead of the update of the whole rebuild
+//
+TEST_F(PriorityRouteUpdateFixture, LinkDown) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12, adj13}, false, 1)},
+       {"adj:2", createAdjValue("2", 1, {adj21, adj23}, false, 2)},
+       {"adj:3", createAdjValue("3", 1, {adj31, adj32}, false, 3)},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})},
+       {"prefix:3", createPrefixValue("3", 1, {addr3})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+
+  auto routeDbDelta = recvRouteUpdates();
+  EXPECT_FALSE(routeDbDelta.isPriority);
+  EXPECT_EQ(2, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(
+      routeDbDelta.unicastRoutesToUpdate.at(toIPNetwork(addr3)).nexthops.get(),
+      NextHops({createNextHopFromAdj(adj13, false, 10)}));
+
+  // link 1-3 goes down
+  publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 2, {adj12}, false, 1)}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+
+  // only route via the link, rerouted over node 2
+  routeDbDelta = recvRouteUpdates();
+  EXPECT_TRUE(routeDbDelta.isPriority);
+  EXPECT_FALSE(routeDbDelta.perfEvents.has_value());
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(0, routeDbDelta.unicastRoutesToDelete.size());
+  EXPECT_EQ(
+      routeDbDelta.unicastRoutesToUpdate.at(toIPNetwork(addr3)).nexthops.get(),
+      NextHops({createNextHopFromAdj(adj12, false, 20)}));
+
+  // rest of the rebuild does not repeat it
+  routeDbDelta = recvRouteUpdates();
+  EXPECT_FALSE(routeDbDelta.isPriority);
+  EXPECT_EQ(0, routeDbDelta.unicastRoutesToUpdate.count(toIPNetwork(addr3)));
+
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_LE(1, counters.at("decision.priority_route_updates.count"));
+}
+
+// DecisionTestFixture precomputing LFA backup next-hops
+class LfaBackupFixture : public DecisionTestFixture {
+  openr::thrift::OpenrConfig
+  createConfig() override {
+    auto tConfig = DecisionTestFixture::createConfig();
+    tConfig.decision_config_ref()->enable_lfa_backup_ref() = true;
+    return tConfig;
+  }
+};
+
+//
+// Routes carry loop-free alternates over other interfaces as backup
+// next-hops, next to their shortest path next-hops
+//
+TEST_F(LfaBackupFixture, BackupNextHops) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12, adj13}, false, 1)},
+       {"adj:2", createAdjValue("2", 1, {adj21, adj23}, false, 2)},
+       {"adj:3", createAdjValue("3", 1, {adj31, adj32}, false, 3)},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})},
+       {"prefix:3", createPrefixValue("3", 1, {addr3})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+
+  auto routeDbDelta = recvRouteUpdates();
+  EXPECT_EQ(2, routeDbDelta.unicastRoutesToUpdate.size());
+  auto const& route2 =
+      routeDbDelta.unicastRoutesToUpdate.at(toIPNetwork(addr2));
+  EXPECT_EQ(
+      route2.nexthops.get(),
+      NextHops({createNextHopFromAdj(adj12, false, 10)}));
+  EXPECT_EQ(
+      route2.backupNexthops.get(),
+      NextHops({createNextHopFromAdj(adj13, false, 20)}));
+  auto const& route3 =
+      routeDbDelta.unicastRoutesToUpdate.at(toIPNetwork(addr3));
+  EXPECT_EQ(
+      route3.nexthops.get(),
+      NextHops({createNextHopFromAdj(adj13, false, 10)}));
+  EXPECT_EQ(
+      route3.backupNexthops.get(),
+      NextHops({createNextHopFromAdj(adj12, false, 20)}));
+
+  // backups go out to Fib along with the route
+  auto const tRoute = route2.toThrift();
+  ASSERT_TRUE(tRoute.backupNextHops_ref().has_value());
+  EXPECT_EQ(1, tRoute.backupNextHops_ref()->size());
+}
+
+// SpfSolver behind RouteComputationEngine, counting calls into it
+class CountingRouteEngine : public RouteComputationEngine {
+ public:
+  CountingRouteEngine(
+      std::atomic<size_t>& numBuildRouteDb,
+      std::atomic<size_t>& numCreateRouteForPrefix)
+      : numBuildRouteDb_(numBuildRouteDb),
+        numCreateRouteForPrefix_(numCreateRouteForPrefix),
+        spfEngine_(std::make_unique<SpfSolver>(
+            "1", false /* enableV4 */, true /* computeLfaPaths */)) {}
+
+  std::string
+  getName() const override {
+    return "counting";
+  }
+
+  std::optional<DecisionRouteDb>
+  buildRouteDb(
+      std::string const& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState) override {
+    ++numBuildRouteDb_;
+    return spfEngine_.buildRouteDb(myNodeName, areaLinkStates, prefixState);
+  }
+
+  std::optional<RibUnicastEntry>
+  createRouteForPrefix(
+      std::string const& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState,
+      folly::CIDRNetwork const& prefix) override {
+    ++numCreateRouteForPrefix_;
+    return spfEngine_.createRouteForPrefix(
+        myNodeName, areaLinkStates, prefixState, prefix);
+  }
+
+ private:
+  std::atomic<size_t>& numBuildRouteDb_;
+  std::atomic<size_t>& numCreateRouteForPrefix_;
+  SpfSolverRouteEngine spfEngine_;
+};
+
+class RouteEngineFixture : public DecisionTestFixture {
+ protected:
+  std::unique_ptr<RouteComputationEngine>
+  createRouteEngine() override {
+    return std::make_unique<CountingRouteEngine>(
+        numBuildRouteDb, numCreateRouteForPrefix);
+  }
+
+  std::atomic<size_t> numBuildRouteDb{0};
+  std::atomic<size_t> numCreateRouteForPrefix{0};
+};
+
+//
+// Routes are computed by the configured engine, full rebuilds through
+// buildRouteDb() and prefix changes through createRouteForPrefix()
+//
+TEST_F(RouteEngineFixture, RoutesFromEngine) {
+  auto publication = createThriftPublication(
+      {{"adj:1", createAdjValue("1", 1, {adj12}, false, 1)},
+       {"adj:2", createAdjValue("2", 1, {adj21}, false, 2)},
+       {"prefix:1", createPrefixValue("1", 1, {addr1})},
+       {"prefix:2", createPrefixValue("2", 1, {addr2})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+
+  auto routeDbDelta = recvRouteUpdates();
+  EXPECT_LE(1, numBuildRouteDb.load());
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(
+      routeDbDelta.unicastRoutesToUpdate.at(toIPNetwork(addr2)).nexthops.get(),
+      NextHops({createNextHopFromAdj(adj12, false, 10)}));
+  // self mpls route, node 2 mpls route and adj12 label route
+  EXPECT_EQ(3, routeDbDelta.mplsRoutesToUpdate.size());
+
+  publication = createThriftPublication(
+      {{"prefix:2", createPrefixValue("2", 2, {addr2, addr4})}},
+      {},
+      {},
+      {},
+      std::string(""));
+  sendKvPublication(publication);
+
+  routeDbDelta = recvRouteUpdates();
+  EXPECT_LE(1, numCreateRouteForPrefix.load());
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.count(toIPNetwork(addr4)));
+}
+
 // DecisionTestFixture with different enableBestRouteSelection_ input
 class EnableBestRouteSelectionFixture
     : public DecisionTestFixture,
@@ -6511,6 +7812,127 @@ TEST(DecisionPendingUpdates, needsFullRebuild) {
   EXPECT_TRUE(updates.needsFullRebuild());
 }
 
+TEST(DecisionPendingUpdates, onlyTopologyChanged) {
+  openr::detail::DecisionPendingUpdates updates("node1");
+  LinkState::LinkStateChange linkStateChange;
+  EXPECT_FALSE(updates.onlyTopologyChanged());
+
+  linkStateChange.topologyChanged = true;
+  updates.applyLinkStateChange("node2", linkStateChange);
+  EXPECT_TRUE(updates.needsFullRebuild());
+  EXPECT_TRUE(updates.onlyTopologyChanged());
+
+  // a local link attribute change needs all routes rebuilt
+  linkStateChange.topologyChanged = false;
+  linkStateChange.linkAttributesChanged = true;
+  updates.applyLinkStateChange("node1", linkStateChange);
+  EXPECT_TRUE(updates.needsFullRebuild());
+  EXPECT_FALSE(updates.onlyTopologyChanged());
+
+  // later topology changes are not narrowing it down again
+  linkStateChange.linkAttributesChanged = false;
+  linkStateChange.topologyChanged = true;
+  updates.applyLinkStateChange("node2", linkStateChange);
+  EXPECT_FALSE(updates.onlyTopologyChanged());
+
+  updates.reset();
+  EXPECT_FALSE(updates.onlyTopologyChanged());
+  updates.applyLinkStateChange("node2", linkStateChange);
+  EXPECT_TRUE(updates.onlyTopologyChanged());
+  updates.setNeedsFullRebuild();
+  EXPECT_TRUE(updates.needsFullRebuild());
+  EXPECT_FALSE(updates.onlyTopologyChanged());
+}
+
+TEST(LinkStateSnapshot, getChangedNodes) {
+  // 1 - 2
+  // |   |
+  // 3 - 4
+  LinkState linkState(kDefaultArea);
+  linkState.updateAdjacencyDatabase(createAdjDb("1", {adj12, adj13}, 1));
+  linkState.updateAdjacencyDatabase(createAdjDb("2", {adj21, adj24}, 2));
+  linkState.updateAdjacencyDatabase(createAdjDb("3", {adj31, adj34}, 3));
+  linkState.updateAdjacencyDatabase(createAdjDb("4", {adj42, adj43}, 4));
+
+  // increasing metric of 2 - 4 only changes next-hops towards 4
+  openr::detail::LinkStateSnapshot snapshot(linkState, "1");
+  auto adj24Updated = adj24;
+  auto adj42Updated = adj42;
+  adj24Updated.metric_ref() = 30;
+  adj42Updated.metric_ref() = 30;
+  linkState.updateAdjacencyDatabase(createAdjDb("2", {adj21, adj24Updated}, 2));
+  linkState.updateAdjacencyDatabase(createAdjDb("4", {adj42Updated, adj43}, 4));
+  auto changedNodes = snapshot.getChangedNodes(linkState, "1");
+  ASSERT_TRUE(changedNodes.has_value());
+  EXPECT_THAT(*changedNodes, testing::UnorderedElementsAre("4"));
+
+  // overloading 3 changes its routes and the ones through it
+  snapshot = openr::detail::LinkStateSnapshot(linkState, "1");
+  linkState.updateAdjacencyDatabase(
+      createAdjDb("3", {adj31, adj34}, 3, true /* overloaded */));
+  changedNodes = snapshot.getChangedNodes(linkState, "1");
+  ASSERT_TRUE(changedNodes.has_value());
+  EXPECT_THAT(*changedNodes, testing::UnorderedElementsAre("3", "4"));
+
+  // a local link change may change every route
+  snapshot = openr::detail::LinkStateSnapshot(linkState, "1");
+  auto adj12Updated = adj12;
+  auto adj21Updated = adj21;
+  adj12Updated.metric_ref() = 20;
+  adj21Updated.metric_ref() = 20;
+  linkState.updateAdjacencyDatabase(createAdjDb("1", {adj12Updated, adj13}, 1));
+  linkState.updateAdjacencyDatabase(
+      createAdjDb("2", {adj21Updated, adj24Updated}, 2));
+  EXPECT_FALSE(snapshot.getChangedNodes(linkState, "1").has_value());
+}
+
+TEST(ChangedNodesTracker, update) {
+  // 1 - 2
+  // |   |
+  // 3 - 4
+  std::unordered_map<std::string, LinkState> areaLinkStates;
+  areaLinkStates.emplace(kDefaultArea, LinkState(kDefaultArea));
+  auto& linkState = areaLinkStates.at(kDefaultArea);
+  linkState.updateAdjacencyDatabase(createAdjDb("1", {adj12, adj13}, 1));
+  linkState.updateAdjacencyDatabase(createAdjDb("2", {adj21, adj24}, 2));
+  linkState.updateAdjacencyDatabase(createAdjDb("3", {adj31, adj34}, 3));
+  linkState.updateAdjacencyDatabase(createAdjDb("4", {adj42, adj43}, 4));
+
+  // every node is new at first
+  openr::detail::ChangedNodesTracker tracker;
+  auto changes = tracker.update(areaLinkStates, "1");
+  EXPECT_TRUE(changes.changed);
+  EXPECT_TRUE(changes.allNodes);
+  EXPECT_FALSE(tracker.update(areaLinkStates, "1").changed);
+
+  // node label change
+  linkState.updateAdjacencyDatabase(createAdjDb("4", {adj42, adj43}, 40));
+  changes = tracker.update(areaLinkStates, "1");
+  EXPECT_TRUE(changes.changed);
+  EXPECT_FALSE(changes.allNodes);
+  EXPECT_THAT(changes.nodes, testing::UnorderedElementsAre("4"));
+
+  // shortest paths change
+  auto adj24Updated = adj24;
+  auto adj42Updated = adj42;
+  adj24Updated.metric_ref() = 30;
+  adj42Updated.metric_ref() = 30;
+  linkState.updateAdjacencyDatabase(createAdjDb("2", {adj21, adj24Updated}, 2));
+  linkState.updateAdjacencyDatabase(
+      createAdjDb("4", {adj42Updated, adj43}, 40));
+  changes = tracker.update(areaLinkStates, "1");
+  EXPECT_FALSE(changes.allNodes);
+  EXPECT_THAT(changes.nodes, testing::UnorderedElementsAre("4"));
+
+  // next-hop address change of a local link
+  auto adj12Updated = adj12;
+  adj12Updated.nextHopV6_ref() = toBinaryAddress("fe80::22");
+  linkState.updateAdjacencyDatabase(createAdjDb("1", {adj12Updated, adj13}, 1));
+  changes = tracker.update(areaLinkStates, "1");
+  EXPECT_TRUE(changes.allNodes);
+  EXPECT_TRUE(changes.nodes.empty());
+}
+
 TEST(DecisionPendingUpdates, updatedPrefixes) {
   openr::detail::DecisionPendingUpdates updates("node1");
 
@@ -6524,17 +7946,21 @@ TEST(DecisionPendingUpdates, updatedPrefixes) {
   EXPECT_FALSE(updates.needsFullRebuild());
   EXPECT_TRUE(updates.updatedPrefixes().empty());
 
-  updates.applyPrefixStateChange({addr1, addr2V4});
+  auto const network1 = toIPNetwork(addr1);
+  auto const network2 = toIPNetwork(addr2);
+  auto const network2V4 = toIPNetwork(addr2V4);
+  updates.applyPrefixStateChange({network1, network2V4});
   EXPECT_TRUE(updates.needsRouteUpdate());
   EXPECT_FALSE(updates.needsFullRebuild());
   EXPECT_THAT(
-      updates.updatedPrefixes(), testing::UnorderedElementsAre(addr1, addr2V4));
-  updates.applyPrefixStateChange({addr2});
+      updates.updatedPrefixes(),
+      testing::UnorderedElementsAre(network1, network2V4));
+  updates.applyPrefixStateChange({network2});
   EXPECT_TRUE(updates.needsRouteUpdate());
   EXPECT_FALSE(updates.needsFullRebuild());
   EXPECT_THAT(
       updates.updatedPrefixes(),
-      testing::UnorderedElementsAre(addr1, addr2V4, addr2));
+      testing::UnorderedElementsAre(network1, network2V4, network2));
 
   updates.reset();
   EXPECT_FALSE(updates.needsRouteUpdate());
@@ -6542,6 +7968,30 @@ TEST(DecisionPendingUpdates, updatedPrefixes) {
   EXPECT_TRUE(updates.updatedPrefixes().empty());
 }
 
+TEST(DecisionPendingUpdates, updatedStaticLabels) {
+  openr::detail::DecisionPendingUpdates updates("node1");
+
+  // empty update no change
+  const auto generation = updates.getGeneration();
+  updates.applyStaticRoutesChange({});
+  EXPECT_FALSE(updates.needsRouteUpdate());
+  EXPECT_EQ(generation, updates.getGeneration());
+
+  updates.applyStaticRoutesChange({32011});
+  updates.applyStaticRoutesChange({32011, 32012});
+  EXPECT_TRUE(updates.needsRouteUpdate());
+  EXPECT_FALSE(updates.needsFullRebuild());
+  EXPECT_TRUE(updates.updatedPrefixes().empty());
+  EXPECT_THAT(
+      updates.updatedStaticLabels(),
+      testing::UnorderedElementsAre(32011, 32012));
+  EXPECT_EQ(generation + 2, updates.getGeneration());
+
+  updates.reset();
+  EXPECT_FALSE(updates.needsRouteUpdate());
+  EXPECT_TRUE(updates.updatedStaticLabels().empty());
+}
+
 TEST(DecisionPendingUpdates, perfEvents) {
   openr::detail::DecisionPendingUpdates updates("node1");
   LinkState::LinkStateChange linkStateChange;
@@ -5,6 +5,10 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <random>
+#include <set>
+
+#include <folly/Format.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -108,6 +112,12 @@ TEST(LinkTest, BasicOperation) {
   EXPECT_EQ(*adj2.adjLabel_ref(), l1.getAdjLabelFromNode(n2));
   EXPECT_THROW(l1.getAdjLabelFromNode("node3"), std::invalid_argument);
 
+  EXPECT_EQ(*adj1.weight_ref(), l1.getWeightFromNode(n1));
+  EXPECT_EQ(*adj2.weight_ref(), l1.getWeightFromNode(n2));
+  EXPECT_THROW(l1.getWeightFromNode("node3"), std::invalid_argument);
+  l1.setWeightFromNode(n1, 10);
+  EXPECT_EQ(10, l1.getWeightFromNode(n1));
+
   EXPECT_FALSE(l1.getOverloadFromNode(n1));
   EXPECT_FALSE(l1.getOverloadFromNode(n2));
   EXPECT_TRUE(l1.isUp());
@@ -136,6 +146,28 @@ TEST(LinkTest, BasicOperation) {
   EXPECT_TRUE(l1 < l3 || l3 < l1);
 }
 
+TEST(DijkstraQTest, DecreaseKey) {
+  std::vector<openr::LinkStateMetric> metrics{5, 3, 8, 3, 1};
+  openr::DijkstraQ q(metrics);
+  for (uint32_t id = 0; id < metrics.size(); ++id) {
+    q.insertNode(id);
+    EXPECT_TRUE(q.contains(id));
+  }
+  EXPECT_EQ(4u, q.extractMin());
+  EXPECT_FALSE(q.contains(4));
+
+  // 2 jumps ahead of everything, 0 ties with 1 and 3, ties go to lower ids
+  metrics[2] = 2;
+  q.decreaseKey(2);
+  metrics[0] = 3;
+  q.decreaseKey(0);
+  EXPECT_EQ(2u, q.extractMin());
+  EXPECT_EQ(0u, q.extractMin());
+  EXPECT_EQ(1u, q.extractMin());
+  EXPECT_EQ(3u, q.extractMin());
+  EXPECT_TRUE(q.empty());
+}
+
 TEST(LinkStateTest, BasicOperation) {
   std::string n1 = "node1";
   std::string n2 = "node2";
@@ -186,6 +218,19 @@ TEST(LinkStateTest, BasicOperation) {
   EXPECT_TRUE(state.updateAdjacencyDatabase(adjDb1, 0, 0).topologyChanged);
   EXPECT_FALSE(state.isNodeOverloaded(n1));
 
+  // weight changes don't alter shortest paths
+  auto weightedAdj12 = adj12;
+  weightedAdj12.weight_ref() = 10;
+  auto const change = state.updateAdjacencyDatabase(
+      openr::createAdjDb(n1, {weightedAdj12, adj13}, 1), 0, 0);
+  EXPECT_FALSE(change.topologyChanged);
+  EXPECT_TRUE(change.linkAttributesChanged);
+  for (auto const& link : state.linksFromNode(n1)) {
+    EXPECT_EQ(
+        link->getOtherNodeName(n1) == n2 ? 10 : 1,
+        link->getWeightFromNode(n1));
+  }
+
   adjDb1 = openr::createAdjDb(n1, {adj13}, 1);
   EXPECT_TRUE(state.updateAdjacencyDatabase(adjDb1, 0, 0).topologyChanged);
   EXPECT_THAT(state.linksFromNode(n1), UnorderedElementsAre(Pointee(l3)));
@@ -199,6 +244,35 @@ TEST(LinkStateTest, BasicOperation) {
   EXPECT_THAT(state.linksFromNode(n3), UnorderedElementsAre(Pointee(l2)));
 }
 
+TEST(LinkStateTest, getLinkStateBytes) {
+  std::string n1 = "node1";
+  std::string n2 = "node2";
+  auto adj12 =
+      openr::createAdjacency(n2, "if2", "if1", "fe80::2", "10.0.0.2", 1, 1, 1);
+  auto adj21 =
+      openr::createAdjacency(n1, "if1", "if2", "fe80::1", "10.0.0.1", 1, 1, 1);
+
+  openr::LinkState state{kDefaultArea};
+  EXPECT_EQ(0, state.getLinkStateBytes());
+
+  // adjacency database without link yet
+  state.updateAdjacencyDatabase(openr::createAdjDb(n1, {adj12}, 1), 0, 0);
+  auto const adjDbBytes = state.getLinkStateBytes();
+  EXPECT_GT(adjDbBytes, 0);
+
+  // link is up, its object is counted as well
+  state.updateAdjacencyDatabase(openr::createAdjDb(n2, {adj21}, 2), 0, 0);
+  auto const linkBytes = state.getLinkStateBytes();
+  EXPECT_GT(linkBytes, 2 * adjDbBytes);
+
+  // memoized results are not counted
+  state.getSpfResult(n1);
+  EXPECT_EQ(linkBytes, state.getLinkStateBytes());
+
+  state.deleteAdjacencyDatabase(n2);
+  EXPECT_LT(state.getLinkStateBytes(), linkBytes);
+}
+
 TEST(LinkStateTest, pathAInPathB) {
   auto l1 = std::make_shared<openr::Link>(kDefaultArea, "1", "1/2", "2", "2/1");
   auto l2 = std::make_shared<openr::Link>(kDefaultArea, "2", "2/3", "3", "3/2");
@@ -315,6 +389,172 @@ TEST(LinkStateTest, getKthPaths) {
   }
 }
 
+TEST(LinkStateTest, getKthPathsCache) {
+  //   1------2
+  //   |      |
+  //   3------4
+  auto linkState = openr::getLinkState({
+      {1, {2, 3}},
+      {2, {1, 4}},
+      {3, {1, 4}},
+      {4, {2, 3}},
+  });
+  EXPECT_EQ(0, linkState.getKthPathsCacheSize());
+  EXPECT_EQ(0, linkState.getKthPathsCacheBytes());
+
+  auto const& firstPaths = linkState.getKthPaths("1", "4", 1);
+  EXPECT_EQ(firstPaths.size(), 2);
+  EXPECT_TRUE(linkState.getKthPaths("1", "4", 2).empty());
+  EXPECT_EQ(2, linkState.getKthPathsCacheSize());
+  auto const bytes = linkState.getKthPathsCacheBytes();
+  EXPECT_GT(bytes, 0);
+
+  // memoized results are returned as is
+  EXPECT_EQ(&firstPaths, &linkState.getKthPaths("1", "4", 1));
+  EXPECT_EQ(bytes, linkState.getKthPathsCacheBytes());
+
+  // second paths towards 2 go around the square
+  auto const& secondPaths = linkState.getKthPaths("1", "2", 2);
+  ASSERT_EQ(secondPaths.size(), 1);
+  EXPECT_EQ(secondPaths.at(0).size(), 3);
+  EXPECT_EQ(4, linkState.getKthPathsCacheSize());
+  EXPECT_GT(linkState.getKthPathsCacheBytes(), bytes);
+
+  // topology change drops all of them
+  linkState.deleteAdjacencyDatabase("4");
+  EXPECT_EQ(0, linkState.getKthPathsCacheSize());
+  EXPECT_EQ(0, linkState.getKthPathsCacheBytes());
+}
+
+TEST(MemoizedResultsTest, LruEviction) {
+  openr::MemoizedResults<int, std::string> memo;
+  memo.insert(1, "one", 10);
+  memo.insert(2, "two", 10);
+  memo.insert(3, "three", 10);
+  EXPECT_EQ(3, memo.size());
+  EXPECT_EQ(30, memo.bytes());
+
+  // 1 becomes most recently used
+  ASSERT_NE(nullptr, memo.find(1));
+  EXPECT_EQ("one", *memo.find(1));
+  EXPECT_EQ(nullptr, memo.find(4));
+
+  EXPECT_EQ(1, memo.evict(20));
+  EXPECT_EQ(nullptr, memo.find(2));
+  EXPECT_EQ(20, memo.bytes());
+
+  // resize and drop entries in place
+  memo.update([](int key, std::string& value) -> std::optional<size_t> {
+    if (key == 3) {
+      return std::nullopt;
+    }
+    value += "!";
+    return 5;
+  });
+  EXPECT_EQ(1, memo.size());
+  EXPECT_EQ(5, memo.bytes());
+  EXPECT_EQ("one!", *memo.find(1));
+
+  EXPECT_EQ(0, memo.evict(5));
+  memo.clear();
+  EXPECT_EQ(0, memo.size());
+  EXPECT_EQ(0, memo.bytes());
+}
+
+TEST(MemoizedResultsTest, PeekKeepsLruOrder) {
+  openr::MemoizedResults<int, std::string> memo;
+  memo.insert(1, "one", 10);
+  memo.insert(2, "two", 10);
+
+  // 1 stays least recently used
+  ASSERT_NE(nullptr, memo.peek(1));
+  EXPECT_EQ("one", *memo.peek(1));
+  EXPECT_EQ(nullptr, memo.peek(3));
+  EXPECT_EQ(1, memo.evict(10));
+  EXPECT_EQ(nullptr, memo.peek(1));
+  EXPECT_EQ("two", *memo.peek(2));
+}
+
+TEST(LinkStateTest, EvictMemoizedResults) {
+  auto const adjs = std::unordered_map<int, std::vector<int>>{
+      {1, {2, 3}},
+      {2, {1, 4}},
+      {3, {1, 4}},
+      {4, {2, 3}},
+  };
+  auto unbounded = openr::getLinkState(adjs);
+  for (auto const& node : {"1", "2", "3", "4"}) {
+    unbounded.getSpfResult(node);
+  }
+  EXPECT_EQ(4, unbounded.getSpfCacheSize());
+  auto const bytesPerResult = unbounded.getSpfCacheBytes() / 4;
+  EXPECT_GT(bytesPerResult, 0);
+  unbounded.evictMemoizedResults();
+  EXPECT_EQ(4, unbounded.getSpfCacheSize());
+
+  // room for about two SPF results
+  openr::LinkState bounded(
+      unbounded.getArea(), false /* incremental spf */, 2 * bytesPerResult);
+  for (auto const& [_, adjDb] : unbounded.getAdjacencyDatabases()) {
+    bounded.updateAdjacencyDatabase(adjDb);
+  }
+  bounded.getKthPaths("1", "4", 1);
+  for (auto const& node : {"1", "2", "3", "4"}) {
+    bounded.getSpfResult(node);
+  }
+  // nothing is evicted until asked to
+  EXPECT_EQ(4, bounded.getSpfCacheSize());
+  EXPECT_EQ(1, bounded.getKthPathsCacheSize());
+
+  bounded.evictMemoizedResults();
+  EXPECT_LE(
+      bounded.getSpfCacheBytes() + bounded.getKthPathsCacheBytes(),
+      2 * bytesPerResult);
+  EXPECT_EQ(0, bounded.getKthPathsCacheSize());
+  EXPECT_LT(bounded.getSpfCacheSize(), 4);
+
+  // evicted results are recomputed on demand
+  for (auto const& node : {"1", "2", "3", "4"}) {
+    auto const& expected = unbounded.getSpfResult(node);
+    auto const& actual = bounded.getSpfResult(node);
+    ASSERT_EQ(expected.size(), actual.size());
+    for (auto const& [other, result] : expected) {
+      EXPECT_EQ(result.metric(), actual.at(other).metric());
+      EXPECT_EQ(result.nextHops(), actual.at(other).nextHops());
+    }
+  }
+}
+
+TEST(LinkStateTest, Copy) {
+  auto const adjs = std::unordered_map<int, std::vector<int>>{
+      {1, {2, 3}},
+      {2, {1, 4}},
+      {3, {1, 4}},
+      {4, {2, 3}},
+  };
+  auto original = openr::getLinkState(adjs);
+  original.getSpfResult("1");
+
+  openr::LinkState copy(original);
+  EXPECT_EQ(original.getArea(), copy.getArea());
+  EXPECT_EQ(original.getGeneration(), copy.getGeneration());
+  EXPECT_EQ(0, copy.getSpfCacheSize());
+  EXPECT_EQ(original.numLinks(), copy.numLinks());
+
+  // links are equal but not shared
+  for (auto const& link : copy.linksFromNode("1")) {
+    auto it = original.linksFromNode("1").find(link);
+    ASSERT_NE(original.linksFromNode("1").end(), it);
+    EXPECT_EQ(**it, *link);
+    EXPECT_NE(it->get(), link.get());
+  }
+
+  // updates of the original don't show in the copy
+  EXPECT_TRUE(original.deleteAdjacencyDatabase("4").topologyChanged);
+  EXPECT_EQ(3, original.getSpfResult("1").size());
+  EXPECT_EQ(4, copy.getSpfResult("1").size());
+}
+
 TEST(LinkStateTest, getHopCounts) {
   {
     // box
@@ -376,6 +616,247 @@ TEST(LinkStateTest, getHopCounts) {
   }
 }
 
+// Max hop counts survive metric changes and follow link and node overloads
+TEST(LinkStateTest, MaxHopsToNodeMemoization) {
+  // line 1-2-3
+  auto adj12 =
+      openr::createAdjacency("2", "1/2", "2/1", "fe80::2", "10.0.0.2", 1, 0);
+  auto adj21 =
+      openr::createAdjacency("1", "2/1", "1/2", "fe80::1", "10.0.0.1", 1, 0);
+  auto adj23 =
+      openr::createAdjacency("3", "2/3", "3/2", "fe80::3", "10.0.0.3", 1, 0);
+  auto adj32 =
+      openr::createAdjacency("2", "3/2", "2/3", "fe80::2", "10.0.0.2", 1, 0);
+  openr::LinkState state{kDefaultArea};
+  state.updateAdjacencyDatabase(openr::createAdjDb("1", {adj12}, 1), 0, 0);
+  state.updateAdjacencyDatabase(
+      openr::createAdjDb("2", {adj21, adj23}, 2), 0, 0);
+  state.updateAdjacencyDatabase(openr::createAdjDb("3", {adj32}, 3), 0, 0);
+  EXPECT_EQ(2, state.getMaxHopsToNode("1"));
+  EXPECT_EQ(1, state.getMaxHopsToNode("2"));
+
+  adj12.metric_ref() = 5;
+  EXPECT_TRUE(state
+                  .updateAdjacencyDatabase(
+                      openr::createAdjDb("1", {adj12}, 1), 0, 0)
+                  .topologyChanged);
+  EXPECT_EQ(2, state.getMaxHopsToNode("1"));
+
+  // no transit through overloaded node 2
+  auto adjDb2 = openr::createAdjDb("2", {adj21, adj23}, 2);
+  adjDb2.isOverloaded_ref() = true;
+  EXPECT_TRUE(state.updateAdjacencyDatabase(adjDb2, 0, 0).topologyChanged);
+  EXPECT_EQ(1, state.getMaxHopsToNode("1"));
+  EXPECT_EQ(1, state.getMaxHopsToNode("2"));
+
+  adjDb2.isOverloaded_ref() = false;
+  EXPECT_TRUE(state.updateAdjacencyDatabase(adjDb2, 0, 0).topologyChanged);
+  EXPECT_EQ(2, state.getMaxHopsToNode("1"));
+  EXPECT_TRUE(state.updateAdjacencyDatabase(
+                       openr::createAdjDb("3", {}, 3), 0, 0)
+                  .topologyChanged);
+  EXPECT_EQ(1, state.getMaxHopsToNode("1"));
+  EXPECT_EQ(0, state.getMaxHopsToNode("3"));
+}
+
+// Only links and nodes with holds are visited when decrementing them
+TEST(LinkStateTest, HeldLinks) {
+  auto adj12 =
+      openr::createAdjacency("2", "1/2", "2/1", "fe80::2", "10.0.0.2", 1, 0);
+  auto adj21 =
+      openr::createAdjacency("1", "2/1", "1/2", "fe80::1", "10.0.0.1", 1, 0);
+  openr::LinkState state{kDefaultArea};
+  state.updateAdjacencyDatabase(openr::createAdjDb("1", {adj12}, 1), 0, 0);
+  EXPECT_FALSE(state.hasHolds());
+
+  // link comes up after a hold of 2
+  EXPECT_FALSE(state
+                   .updateAdjacencyDatabase(
+                       openr::createAdjDb("2", {adj21}, 2), 2, 0)
+                   .topologyChanged);
+  EXPECT_TRUE(state.hasHolds());
+  EXPECT_EQ(0, state.getSpfResult("1").count("2"));
+
+  // copies hold their own links
+  openr::LinkState copy(state);
+  EXPECT_TRUE(copy.hasHolds());
+
+  EXPECT_FALSE(state.decrementHolds().topologyChanged);
+  EXPECT_TRUE(state.hasHolds());
+  EXPECT_TRUE(state.decrementHolds().topologyChanged);
+  EXPECT_FALSE(state.hasHolds());
+  EXPECT_EQ(1, state.getSpfResult("1").count("2"));
+  EXPECT_FALSE(state.decrementHolds().topologyChanged);
+
+  EXPECT_TRUE(copy.hasHolds());
+  EXPECT_FALSE(copy.decrementHolds().topologyChanged);
+  EXPECT_TRUE(copy.decrementHolds().topologyChanged);
+  EXPECT_FALSE(copy.hasHolds());
+
+  // node overload going down is held as well
+  auto adjDb2 = openr::createAdjDb("2", {adj21}, 2);
+  adjDb2.isOverloaded_ref() = true;
+  state.updateAdjacencyDatabase(adjDb2, 0, 1);
+  EXPECT_TRUE(state.hasHolds());
+  EXPECT_FALSE(state.isNodeOverloaded("2"));
+  EXPECT_TRUE(state.decrementHolds().topologyChanged);
+  EXPECT_TRUE(state.isNodeOverloaded("2"));
+  EXPECT_FALSE(state.hasHolds());
+}
+
+TEST(LinkStateTest, UpdateLinksInPlace) {
+  auto adj12 =
+      openr::createAdjacency("2", "1/2", "2/1", "fe80::2", "10.0.0.2", 1, 0);
+  auto adj21 =
+      openr::createAdjacency("1", "2/1", "1/2", "fe80::1", "10.0.0.1", 1, 0);
+  openr::LinkState state{kDefaultArea};
+  state.updateAdjacencyDatabase(openr::createAdjDb("1", {adj12}, 1), 0, 0);
+  state.updateAdjacencyDatabase(openr::createAdjDb("2", {adj21}, 2), 0, 0);
+  ASSERT_EQ(1, state.linksFromNode("1").size());
+  auto const link = *state.linksFromNode("1").begin();
+
+  // refreshing the same database changes nothing
+  auto change = state.updateAdjacencyDatabase(
+      openr::createAdjDb("1", {adj12}, 1), 0, 0);
+  EXPECT_FALSE(change.topologyChanged);
+  EXPECT_FALSE(change.linkAttributesChanged);
+
+  // metric change updates the existing link
+  adj12.metric_ref() = 5;
+  change = state.updateAdjacencyDatabase(
+      openr::createAdjDb("1", {adj12}, 1), 0, 0);
+  EXPECT_TRUE(change.topologyChanged);
+  EXPECT_THAT(state.linksFromNode("1"), UnorderedElementsAre(link));
+  EXPECT_THAT(state.linksFromNode("2"), UnorderedElementsAre(link));
+  EXPECT_EQ(5, link->getMetricFromNode("1"));
+
+  // a different remote interface makes a new link
+  adj12.otherIfName_ref() = "2/1-new";
+  adj21.ifName_ref() = "2/1-new";
+  state.updateAdjacencyDatabase(openr::createAdjDb("2", {adj21}, 2), 0, 0);
+  EXPECT_TRUE(state.linksFromNode("1").empty());
+  state.updateAdjacencyDatabase(openr::createAdjDb("1", {adj12}, 1), 0, 0);
+  ASSERT_EQ(1, state.linksFromNode("1").size());
+  EXPECT_NE(link, *state.linksFromNode("1").begin());
+}
+
+namespace {
+
+// order independent comparison of two SPF results
+void
+expectSpfResultsEqual(
+    openr::LinkState::SpfResult const& expected,
+    openr::LinkState::SpfResult const& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (auto const& [node, expectedNodeResult] : expected) {
+    auto search = actual.find(node);
+    ASSERT_NE(search, actual.end()) << node;
+    auto const& actualNodeResult = search->second;
+    EXPECT_EQ(expectedNodeResult.metric(), actualNodeResult.metric()) << node;
+    EXPECT_EQ(expectedNodeResult.nextHops(), actualNodeResult.nextHops())
+        << node;
+    std::set<std::pair<std::string, std::string>> expectedPaths, actualPaths;
+    for (auto const& pathLink : expectedNodeResult.pathLinks()) {
+      expectedPaths.emplace(pathLink.link->toString(), pathLink.prevNode);
+    }
+    for (auto const& pathLink : actualNodeResult.pathLinks()) {
+      actualPaths.emplace(pathLink.link->toString(), pathLink.prevNode);
+    }
+    EXPECT_EQ(expectedPaths, actualPaths) << node;
+  }
+}
+
+} // namespace
+
+TEST(LinkStateTest, IncrementalSpf) {
+  // grid of kGridSize x kGridSize nodes with random metrics. Random single
+  // adjacency changes are applied and the repaired results are compared
+  // against a LinkState which always runs full SPF
+  const int kGridSize = 6;
+  std::mt19937 gen(0xdead);
+  std::uniform_int_distribution<int> metricDist(1, 8);
+
+  auto nodeName = [](int i) { return folly::sformat("{}", i); };
+  std::unordered_map<int, std::vector<openr::thrift::Adjacency>> adjs;
+  auto addAdj = [&](int a, int b) {
+    adjs[a].push_back(openr::createAdjacency(
+        nodeName(b),
+        folly::sformat("{}/{}", a, b),
+        folly::sformat("{}/{}", b, a),
+        "fe80::1",
+        "10.0.0.1",
+        metricDist(gen),
+        0));
+  };
+  for (int i = 0; i < kGridSize * kGridSize; ++i) {
+    if ((i + 1) % kGridSize) {
+      addAdj(i, i + 1);
+      addAdj(i + 1, i);
+    }
+    if (i + kGridSize < kGridSize * kGridSize) {
+      addAdj(i, i + kGridSize);
+      addAdj(i + kGridSize, i);
+    }
+  }
+
+  openr::LinkState incremental{kDefaultArea, true};
+  openr::LinkState reference{kDefaultArea, false};
+  std::unordered_map<int, bool> overloaded;
+  auto publish = [&](int node) {
+    auto adjDb =
+        openr::createAdjDb(nodeName(node), adjs[node], 0, overloaded[node]);
+    EXPECT_EQ(
+        reference.updateAdjacencyDatabase(adjDb),
+        incremental.updateAdjacencyDatabase(adjDb));
+  };
+  for (int i = 0; i < kGridSize * kGridSize; ++i) {
+    publish(i);
+  }
+
+  std::unordered_map<int, std::vector<openr::thrift::Adjacency>> removed;
+  std::uniform_int_distribution<int> nodeDist(0, kGridSize * kGridSize - 1);
+  std::uniform_int_distribution<int> actionDist(0, 19);
+  for (int iter = 0; iter < 300; ++iter) {
+    // memoize results from all nodes so that they get repaired
+    for (int i = 0; i < kGridSize * kGridSize; ++i) {
+      incremental.getSpfResult(nodeName(i), true);
+      incremental.getSpfResult(nodeName(i), false);
+    }
+
+    auto const node = nodeDist(gen);
+    auto& nodeAdjs = adjs[node];
+    auto const action = actionDist(gen);
+    if (action == 0) {
+      overloaded[node] = not overloaded[node];
+    } else if (action < 6 and not nodeAdjs.empty()) {
+      // link down
+      auto idx = std::uniform_int_distribution<size_t>(
+          0, nodeAdjs.size() - 1)(gen);
+      removed[node].push_back(nodeAdjs.at(idx));
+      nodeAdjs.erase(nodeAdjs.begin() + idx);
+    } else if (action < 11 and not removed[node].empty()) {
+      // link up
+      nodeAdjs.push_back(removed[node].back());
+      removed[node].pop_back();
+    } else if (not nodeAdjs.empty()) {
+      // metric change
+      auto idx = std::uniform_int_distribution<size_t>(
+          0, nodeAdjs.size() - 1)(gen);
+      nodeAdjs.at(idx).metric_ref() = metricDist(gen);
+    }
+    publish(node);
+
+    for (int i = 0; i < kGridSize * kGridSize; ++i) {
+      expectSpfResultsEqual(
+          reference.getSpfResult(nodeName(i), true),
+          incremental.getSpfResult(nodeName(i), true));
+      expectSpfResultsEqual(
+          reference.getSpfResult(nodeName(i), false),
+          incremental.getSpfResult(nodeName(i), false));
+    }
+  }
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
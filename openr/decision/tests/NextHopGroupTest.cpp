@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/Util.h>
+#include <openr/decision/NextHopGroup.h>
+
+using namespace openr;
+
+namespace {
+thrift::NextHopThrift
+createTestNextHop(std::string const& ifName) {
+  return createNextHop(
+      toBinaryAddress(folly::IPAddress("fe80::1")), ifName, 10);
+}
+} // namespace
+
+TEST(NextHopSetTest, Interning) {
+  auto const baseGroups = NextHopSet::numGroups();
+  auto const nh1 = createTestNextHop("iface1");
+  auto const nh2 = createTestNextHop("iface2");
+
+  NextHopSet empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty, NextHopSet(NextHopSet::Set{}));
+
+  // equal sets share the same group
+  NextHopSet set1({nh1, nh2});
+  NextHopSet set2(NextHopSet::Set{nh2, nh1});
+  EXPECT_EQ(set1, set2);
+  EXPECT_EQ(set1.id(), set2.id());
+  EXPECT_EQ(&set1.get(), &set2.get());
+  EXPECT_EQ(baseGroups + 1, NextHopSet::numGroups());
+  EXPECT_THAT(set1, testing::UnorderedElementsAre(nh1, nh2));
+  EXPECT_EQ(set1, (NextHopSet::Set{nh1, nh2}));
+
+  NextHopSet set3({nh1});
+  EXPECT_NE(set1, set3);
+  EXPECT_NE(set1.id(), set3.id());
+  EXPECT_EQ(baseGroups + 2, NextHopSet::numGroups());
+
+  // groups are released with their last user
+  set3 = NextHopSet::Set{};
+  EXPECT_EQ(baseGroups + 1, NextHopSet::numGroups());
+  set2.clear();
+  EXPECT_EQ(baseGroups + 1, NextHopSet::numGroups());
+  set1.clear();
+  EXPECT_EQ(baseGroups, NextHopSet::numGroups());
+}
+
+TEST(NextHopSetTest, CopyOnWrite) {
+  auto const nh1 = createTestNextHop("iface1");
+  auto const nh2 = createTestNextHop("iface2");
+
+  NextHopSet set1({nh1});
+  auto set2 = set1;
+  EXPECT_EQ(set1, set2);
+
+  // modifying a copy leaves the shared group untouched
+  EXPECT_TRUE(set2.emplace(nh2).second);
+  EXPECT_FALSE(set2.insert(nh2).second);
+  EXPECT_EQ(2, set2.size());
+  EXPECT_EQ(1, set1.size());
+  EXPECT_NE(set1, set2);
+  EXPECT_EQ(set2, NextHopSet({nh1, nh2}));
+
+  EXPECT_EQ(1, set2.erase(nh2));
+  EXPECT_EQ(0, set2.erase(nh2));
+  EXPECT_EQ(set1, set2);
+  EXPECT_EQ(set1.id(), set2.id());
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -41,12 +41,13 @@ class PrefixStateTestFixture : public ::testing::Test {
     return 2;
   }
 
+  // entries in prefix order, as returned by getPrefixDatabases()
   virtual thrift::PrefixDatabase
   createPrefixDbForNode(std::string const& name, size_t prefixSeed) const {
     return createPrefixDb(
         name,
-        {createPrefixEntry(getAddrFromSeed(prefixSeed, false)),
-         createPrefixEntry(getAddrFromSeed(prefixSeed, true))});
+        {createPrefixEntry(getAddrFromSeed(prefixSeed, true)),
+         createPrefixEntry(getAddrFromSeed(prefixSeed, false))});
   }
 };
 
@@ -60,8 +61,8 @@ TEST_F(PrefixStateTestFixture, basicOperation) {
       thrift::PrefixType::BREEZE;
   EXPECT_THAT(
       state_.updatePrefixDatabase(prefixDb1Updated),
-      testing::UnorderedElementsAre(
-          *prefixDb1Updated.prefixEntries_ref()->at(0).prefix_ref()));
+      testing::UnorderedElementsAre(toIPNetwork(
+          *prefixDb1Updated.prefixEntries_ref()->at(0).prefix_ref())));
   EXPECT_TRUE(state_.updatePrefixDatabase(prefixDb1Updated).empty());
   EXPECT_EQ(prefixDb1Updated, state_.getPrefixDatabases().at(dbEntry.first));
 
@@ -69,15 +70,15 @@ TEST_F(PrefixStateTestFixture, basicOperation) {
       thrift::PrefixForwardingType::SR_MPLS;
   EXPECT_THAT(
       state_.updatePrefixDatabase(prefixDb1Updated),
-      testing::UnorderedElementsAre(
-          *prefixDb1Updated.prefixEntries_ref()->at(0).prefix_ref()));
+      testing::UnorderedElementsAre(toIPNetwork(
+          *prefixDb1Updated.prefixEntries_ref()->at(0).prefix_ref())));
   EXPECT_TRUE(state_.updatePrefixDatabase(prefixDb1Updated).empty());
   EXPECT_EQ(prefixDb1Updated, state_.getPrefixDatabases().at(dbEntry.first));
 
   auto emptyPrefixDb = createPrefixDb(dbEntry.first);
-  std::unordered_set<thrift::IpPrefix> affectedPrefixes;
+  std::unordered_set<folly::CIDRNetwork> affectedPrefixes;
   for (auto const& entry : *prefixDb1Updated.prefixEntries_ref()) {
-    affectedPrefixes.insert(*entry.prefix_ref());
+    affectedPrefixes.insert(toIPNetwork(*entry.prefix_ref()));
   }
   EXPECT_THAT(
       state_.updatePrefixDatabase(emptyPrefixDb),
@@ -93,6 +94,126 @@ TEST_F(PrefixStateTestFixture, basicOperation) {
       testing::UnorderedElementsAreArray(affectedPrefixes));
 }
 
+/**
+ * Verifies `getNodePrefixes` and KSP2_ED_ECMP entry tracking
+ */
+TEST_F(PrefixStateTestFixture, NodePrefixesAndKsp2Entries) {
+  auto const& area = *prefixDbs_.at("0").area_ref();
+  std::vector<folly::CIDRNetwork> node0Prefixes;
+  for (auto const& entry : *prefixDbs_.at("0").prefixEntries_ref()) {
+    node0Prefixes.emplace_back(toIPNetwork(*entry.prefix_ref()));
+  }
+  EXPECT_EQ(node0Prefixes, state_.getNodePrefixes({"0", area}));
+  EXPECT_TRUE(state_.getNodePrefixes({"unknown", area}).empty());
+  EXPECT_FALSE(state_.hasKsp2PrefixEntries());
+
+  // Switch one entry to KSP2_ED_ECMP
+  auto prefixDb = prefixDbs_.at("0");
+  prefixDb.prefixEntries_ref()->at(0).forwardingAlgorithm_ref() =
+      thrift::PrefixForwardingAlgorithm::KSP2_ED_ECMP;
+  EXPECT_FALSE(state_.updatePrefixDatabase(prefixDb).empty());
+  EXPECT_TRUE(state_.hasKsp2PrefixEntries());
+
+  // Withdrawing the entry clears it
+  prefixDb.prefixEntries_ref()->erase(prefixDb.prefixEntries_ref()->begin());
+  EXPECT_FALSE(state_.updatePrefixDatabase(prefixDb).empty());
+  EXPECT_FALSE(state_.hasKsp2PrefixEntries());
+  EXPECT_EQ(1, state_.getNodePrefixes({"0", area}).size());
+}
+
+/**
+ * Verifies diffing of unsorted announcements against the sorted prefixes
+ * previously announced by a node
+ */
+TEST(PrefixState, UpdatePrefixDatabaseDiff) {
+  PrefixState state;
+  const NodeAndArea nodeAndArea{
+      "node0", thrift::KvStore_constants::kDefaultArea()};
+  const auto prefix1 = toIpPrefix("10.0.0.0/8");
+  const auto prefix2 = toIpPrefix("fc00::/64");
+  const auto prefix3 = toIpPrefix("192.168.0.0/16");
+
+  // Duplicate announcements of a prefix, the last one wins
+  auto prefixEntry1 = createPrefixEntry(prefix1);
+  auto prefixEntry1Bgp = createPrefixEntry(prefix1, thrift::PrefixType::BGP);
+  EXPECT_THAT(
+      state.updatePrefixDatabase(createPrefixDb(
+          "node0",
+          {createPrefixEntry(prefix2), prefixEntry1, prefixEntry1Bgp})),
+      testing::UnorderedElementsAre(
+          toIPNetwork(prefix1), toIPNetwork(prefix2)));
+  EXPECT_THAT(
+      state.getNodePrefixes(nodeAndArea),
+      testing::ElementsAre(toIPNetwork(prefix1), toIPNetwork(prefix2)));
+  EXPECT_EQ(
+      prefixEntry1Bgp,
+      state.prefixes().at(toIPNetwork(prefix1)).at(nodeAndArea));
+
+  // Withdraw prefix2 and announce prefix3, prefix1 is unchanged
+  EXPECT_THAT(
+      state.updatePrefixDatabase(createPrefixDb(
+          "node0", {createPrefixEntry(prefix3), prefixEntry1Bgp})),
+      testing::UnorderedElementsAre(
+          toIPNetwork(prefix2), toIPNetwork(prefix3)));
+  EXPECT_THAT(
+      state.getNodePrefixes(nodeAndArea),
+      testing::ElementsAre(toIPNetwork(prefix1), toIPNetwork(prefix3)));
+  EXPECT_EQ(0, state.prefixes().count(toIPNetwork(prefix2)));
+  EXPECT_EQ(2, state.prefixes().size());
+}
+
+/**
+ * Verifies single prefix updates and withdrawals of per prefix keys
+ */
+TEST(PrefixState, UpdateAndDeletePrefix) {
+  PrefixState state;
+  const NodeAndArea nodeAndArea{
+      "node0", thrift::KvStore_constants::kDefaultArea()};
+  const auto prefix1 = toIPNetwork(toIpPrefix("10.0.0.0/8"));
+  const auto prefix2 = toIPNetwork(toIpPrefix("fc00::/64"));
+  auto prefixEntry1 = createPrefixEntry(toIpPrefix(prefix1));
+  auto prefixEntry2 = createPrefixEntry(toIpPrefix(prefix2));
+
+  // Announced out of order, node prefixes stay sorted
+  EXPECT_THAT(
+      state.updatePrefix(nodeAndArea, prefix2, prefixEntry2),
+      testing::UnorderedElementsAre(prefix2));
+  EXPECT_THAT(
+      state.updatePrefix(nodeAndArea, prefix1, prefixEntry1),
+      testing::UnorderedElementsAre(prefix1));
+  EXPECT_THAT(
+      state.getNodePrefixes(nodeAndArea),
+      testing::ElementsAre(prefix1, prefix2));
+  EXPECT_EQ(
+      createPrefixDb("node0", {prefixEntry1, prefixEntry2}),
+      state.getPrefixDatabases().at("node0"));
+
+  // Unchanged entry
+  EXPECT_TRUE(state.updatePrefix(nodeAndArea, prefix1, prefixEntry1).empty());
+
+  // Changed entry
+  prefixEntry1.forwardingAlgorithm_ref() =
+      thrift::PrefixForwardingAlgorithm::KSP2_ED_ECMP;
+  EXPECT_THAT(
+      state.updatePrefix(nodeAndArea, prefix1, prefixEntry1),
+      testing::UnorderedElementsAre(prefix1));
+  EXPECT_TRUE(state.hasKsp2PrefixEntries());
+
+  // Withdrawals
+  EXPECT_THAT(
+      state.deletePrefix(nodeAndArea, prefix1),
+      testing::UnorderedElementsAre(prefix1));
+  EXPECT_FALSE(state.hasKsp2PrefixEntries());
+  EXPECT_TRUE(state.deletePrefix(nodeAndArea, prefix1).empty());
+  EXPECT_THAT(
+      state.getNodePrefixes(nodeAndArea), testing::ElementsAre(prefix2));
+  EXPECT_THAT(
+      state.deletePrefix(nodeAndArea, prefix2),
+      testing::UnorderedElementsAre(prefix2));
+  EXPECT_TRUE(state.prefixes().empty());
+  EXPECT_TRUE(state.getPrefixDatabases().empty());
+}
+
 /**
  * Verifies `getReceivedRoutesFiltered` with all filter combinations
  */
@@ -225,6 +346,104 @@ TEST(PrefixState, GetReceivedRoutes) {
   }
 }
 
+/**
+ * Verifies covering prefix filter and lookups of node and area filters in
+ * indexes, with and without pagination
+ */
+TEST(PrefixState, GetReceivedRoutesIndexed) {
+  PrefixState state;
+
+  //
+  // node0 -> area0: 10.0.0.0/8, 10.1.0.0/16, fc00::/64
+  // node0 -> area1: 10.1.0.0/16
+  // node1 -> area1: 10.1.1.0/24, 11.0.0.0/8
+  //
+  auto const prefixDb = [](std::string const& node,
+                           std::string const& area,
+                           std::vector<std::string> const& prefixes) {
+    std::vector<thrift::PrefixEntry> entries;
+    for (auto const& prefix : prefixes) {
+      entries.emplace_back(createPrefixEntry(toIpPrefix(prefix)));
+    }
+    return createPrefixDb(node, entries, area);
+  };
+  state.updatePrefixDatabase(
+      prefixDb("node0", "area0", {"10.0.0.0/8", "10.1.0.0/16", "fc00::/64"}));
+  state.updatePrefixDatabase(prefixDb("node0", "area1", {"10.1.0.0/16"}));
+  state.updatePrefixDatabase(
+      prefixDb("node1", "area1", {"10.1.1.0/24", "11.0.0.0/8"}));
+
+  using Routes = std::map<std::string, size_t /* number of routes */>;
+  auto const getRoutes = [&state](thrift::ReceivedRouteFilter const& filter) {
+    Routes routes;
+    for (auto const& route : state.getReceivedRoutesFiltered(filter)) {
+      routes.emplace(toString(*route.prefix_ref()), route.routes_ref()->size());
+    }
+
+    // Same routes page by page
+    Routes pagedRoutes;
+    std::optional<thrift::IpPrefix> cursor;
+    do {
+      std::optional<thrift::IpPrefix> nextCursor;
+      for (auto const& route :
+           state.getReceivedRoutesFilteredPage(filter, cursor, 1, nextCursor)) {
+        pagedRoutes.emplace(
+            toString(*route.prefix_ref()), route.routes_ref()->size());
+      }
+      cursor = nextCursor;
+    } while (cursor.has_value());
+    EXPECT_EQ(routes, pagedRoutes);
+    return routes;
+  };
+
+  thrift::ReceivedRouteFilter filter;
+  filter.coveringPrefix_ref() = toIpPrefix("10.0.0.0/8");
+  EXPECT_EQ(
+      (Routes{{"10.0.0.0/8", 1}, {"10.1.0.0/16", 2}, {"10.1.1.0/24", 1}}),
+      getRoutes(filter));
+
+  filter.coveringPrefix_ref() = toIpPrefix("10.1.0.0/20");
+  EXPECT_EQ((Routes{{"10.1.1.0/24", 1}}), getRoutes(filter));
+
+  filter.coveringPrefix_ref() = toIpPrefix("::/0");
+  EXPECT_EQ((Routes{{"fc00::/64", 1}}), getRoutes(filter));
+
+  filter.coveringPrefix_ref() = toIpPrefix("10.1.0.0/16");
+  filter.areaName_ref() = "area1";
+  EXPECT_EQ(
+      (Routes{{"10.1.0.0/16", 1}, {"10.1.1.0/24", 1}}), getRoutes(filter));
+
+  filter.nodeName_ref() = "node0";
+  EXPECT_EQ((Routes{{"10.1.0.0/16", 1}}), getRoutes(filter));
+
+  filter.coveringPrefix_ref().reset();
+  filter.areaName_ref().reset();
+  EXPECT_EQ(
+      (Routes{{"10.0.0.0/8", 1}, {"10.1.0.0/16", 2}, {"fc00::/64", 1}}),
+      getRoutes(filter));
+
+  filter.nodeName_ref().reset();
+  filter.areaName_ref() = "area1";
+  EXPECT_EQ(
+      (Routes{{"10.1.0.0/16", 1}, {"10.1.1.0/24", 1}, {"11.0.0.0/8", 1}}),
+      getRoutes(filter));
+
+  filter.prefixes_ref() = std::vector<thrift::IpPrefix>{
+      toIpPrefix("10.0.0.0/8"), toIpPrefix("11.0.0.0/8")};
+  filter.coveringPrefix_ref() = toIpPrefix("11.0.0.0/8");
+  EXPECT_EQ((Routes{{"11.0.0.0/8", 1}}), getRoutes(filter));
+
+  // Index follows withdrawals
+  state.updatePrefixDatabase(prefixDb("node1", "area1", {"11.0.0.0/8"}));
+  filter = thrift::ReceivedRouteFilter();
+  filter.coveringPrefix_ref() = toIpPrefix("10.1.0.0/16");
+  EXPECT_EQ((Routes{{"10.1.0.0/16", 2}}), getRoutes(filter));
+  auto const prefix = folly::IPAddress::createNetwork("10.1.0.0/16");
+  state.deletePrefix({"node0", "area0"}, prefix);
+  state.deletePrefix({"node0", "area1"}, prefix);
+  EXPECT_TRUE(getRoutes(filter).empty());
+}
+
 /**
  * Verifies the test case with empty entries. Other cases are exercised above
  */
@@ -236,7 +455,7 @@ TEST(PrefixState, FilterReceivedRoutes) {
       routes,
       filter.nodeName_ref(),
       filter.areaName_ref(),
-      thrift::IpPrefix(),
+      folly::CIDRNetwork(),
       prefixEntries);
   EXPECT_TRUE(routes.empty());
 }
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+
+#include <openr/common/Util.h>
+#include <openr/decision/RibPolicy.h>
+#include <openr/tests/BenchmarkDriver.h>
+
+namespace openr {
+
+namespace {
+
+/**
+ * Policy of numOfStatements statements, alternately matching on a prefix
+ * range and on a tag. Statement `i` selects routes under fc00:i::/32 or tagged
+ * with `tag-i`.
+ */
+thrift::RibPolicy
+createPolicy(unsigned numOfStatements) {
+  thrift::RibPolicy policy;
+  policy.ttl_secs_ref() = 3600;
+  for (unsigned i = 0; i < numOfStatements; ++i) {
+    thrift::RibPolicyStatement stmt;
+    *stmt.name_ref() = folly::sformat("statement-{}", i);
+    if (i % 2) {
+      stmt.matcher_ref()->tags_ref() =
+          std::vector<std::string>{folly::sformat("tag-{}", i)};
+    } else {
+      thrift::RibPrefixRange range;
+      *range.prefix_ref() = toIpPrefix(folly::sformat("fc00:{:x}::/32", i));
+      range.le_ref() = 64;
+      stmt.matcher_ref()->prefix_ranges_ref() =
+          std::vector<thrift::RibPrefixRange>{std::move(range)};
+    }
+    stmt.action_ref()->set_weight_ref() = thrift::RibRouteActionWeight{};
+    stmt.action_ref()->set_weight_ref()->default_weight_ref() = 1;
+    *stmt.action_ref()->set_weight_ref()->area_to_weight_ref() = {
+        {"area1", static_cast<int32_t>(i + 2)}};
+    policy.statements_ref()->emplace_back(std::move(stmt));
+  }
+  return policy;
+}
+
+} // namespace
+
+/**
+ * Benchmark for applying RibPolicy on computed routes
+ * 1. Create a policy of numOfStatements statements
+ * 2. Generate numOfRoutes /64 routes, spread over the statements by prefix or
+ *    by tag
+ * 3. Apply the policy on the routes
+ */
+static void
+BM_RibPolicyApply(
+    uint32_t iters, unsigned numOfStatements, unsigned numOfRoutes) {
+  auto suspender = folly::BenchmarkSuspender();
+  const RibPolicy policy(createPolicy(numOfStatements));
+
+  const auto nh = createNextHop(
+      toBinaryAddress("fe80::1"), "iface1", 0, std::nullopt, "area1");
+  std::unordered_map<folly::CIDRNetwork, RibUnicastEntry> entries;
+  for (unsigned i = 0; i < numOfRoutes; ++i) {
+    const auto statement = i % numOfStatements;
+    const auto prefix = folly::IPAddress::createNetwork(folly::sformat(
+        "fc00:{:x}:{:x}:{:x}::/64", statement, i >> 16, i & 0xffff));
+    RibUnicastEntry entry(prefix, {nh});
+    *entry.bestPrefixEntry.tags_ref() = {folly::sformat("tag-{}", statement)};
+    entries.emplace(prefix, std::move(entry));
+  }
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    auto routes = entries;
+
+    suspender.dismiss(); // Start measuring benchmark time
+    auto change = policy.applyPolicy(routes);
+    suspender.rehire(); // Stop measuring time again
+
+    CHECK_EQ(numOfRoutes, change.updatedRoutes.size());
+  }
+}
+
+// The parameters are the number of statements and of routes
+BENCHMARK_NAMED_PARAM(BM_RibPolicyApply, 10_10000, 10, 10000);
+BENCHMARK_NAMED_PARAM(BM_RibPolicyApply, 100_10000, 100, 10000);
+BENCHMARK_NAMED_PARAM(BM_RibPolicyApply, 1000_10000, 1000, 10000);
+BENCHMARK_NAMED_PARAM(BM_RibPolicyApply, 10_100000, 10, 100000);
+BENCHMARK_NAMED_PARAM(BM_RibPolicyApply, 1000_100000, 1000, 100000);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  return openr::runBenchmarks();
+}
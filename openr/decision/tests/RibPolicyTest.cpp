@@ -5,6 +5,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <optional>
+#include <set>
 #include <thread>
 
 #include <fb303/ServiceData.h>
@@ -44,6 +46,25 @@ createPolicy(
   return policy;
 }
 
+thrift::RibPrefixRange
+createPrefixRange(
+    const std::string& prefix,
+    std::optional<int32_t> ge = std::nullopt,
+    std::optional<int32_t> le = std::nullopt) {
+  thrift::RibPrefixRange range;
+  *range.prefix_ref() = toIpPrefix(prefix);
+  range.ge_ref().from_optional(ge);
+  range.le_ref().from_optional(le);
+  return range;
+}
+
+RibUnicastEntry
+createEntry(const std::string& prefix, std::set<std::string> tags = {}) {
+  RibUnicastEntry entry(folly::IPAddress::createNetwork(prefix));
+  *entry.bestPrefixEntry.tags_ref() = std::move(tags);
+  return entry;
+}
+
 } // namespace
 
 TEST(RibPolicyStatement, Error) {
@@ -60,6 +81,18 @@ TEST(RibPolicyStatement, Error) {
     stmt.action_ref()->set_weight_ref() = thrift::RibRouteActionWeight{};
     EXPECT_THROW((RibPolicyStatement(stmt)), thrift::OpenrError);
   }
+
+  // Create RibPolicyStatement with invalid prefix ranges
+  for (auto const& range :
+       {createPrefixRange("10.0.0.0/8", 7),
+        createPrefixRange("10.0.0.0/8", 24, 16),
+        createPrefixRange("10.0.0.0/8", std::nullopt, 33)}) {
+    thrift::RibPolicyStatement stmt;
+    stmt.action_ref()->set_weight_ref() = thrift::RibRouteActionWeight{};
+    stmt.matcher_ref()->prefix_ranges_ref() =
+        std::vector<thrift::RibPrefixRange>{range};
+    EXPECT_THROW((RibPolicyStatement(stmt)), thrift::OpenrError);
+  }
 }
 
 TEST(RibPolicy, Error) {
@@ -169,6 +202,91 @@ TEST(RibPolicy, IsActive) {
   EXPECT_FALSE(policy.isActive());
 }
 
+TEST(RibPolicyStatement, MatchPrefixRangesAndTags) {
+  auto stmt = createPolicyStatement({toIpPrefix("fc00::/64")}, 1, {});
+  stmt.matcher_ref()->prefix_ranges_ref() = std::vector<thrift::RibPrefixRange>{
+      createPrefixRange("10.0.0.0/8", std::nullopt, 24),
+      createPrefixRange("192.168.0.0/16", 32),
+      createPrefixRange("172.16.0.0/12")};
+
+  // prefixes and prefix ranges
+  {
+    auto const policyStatement = RibPolicyStatement(stmt);
+    EXPECT_TRUE(policyStatement.match(createEntry("fc00::/64")));
+    EXPECT_TRUE(policyStatement.match(createEntry("10.0.0.0/8")));
+    EXPECT_TRUE(policyStatement.match(createEntry("10.1.2.0/24")));
+    EXPECT_FALSE(policyStatement.match(createEntry("10.1.2.0/25")));
+    EXPECT_FALSE(policyStatement.match(createEntry("11.0.0.0/8")));
+    EXPECT_TRUE(policyStatement.match(createEntry("192.168.1.1/32")));
+    EXPECT_FALSE(policyStatement.match(createEntry("192.168.1.0/24")));
+    EXPECT_TRUE(policyStatement.match(createEntry("172.16.0.0/12")));
+    EXPECT_FALSE(policyStatement.match(createEntry("172.16.0.0/16")));
+
+    // matcher is preserved as specified
+    EXPECT_EQ(stmt, policyStatement.toThrift());
+  }
+
+  // prefixes and tags are both to match
+  stmt.matcher_ref()->tags_ref() = std::vector<std::string>{"tag1", "tag2"};
+  {
+    auto const policyStatement = RibPolicyStatement(stmt);
+    EXPECT_FALSE(policyStatement.match(createEntry("10.0.0.0/8")));
+    EXPECT_TRUE(policyStatement.match(createEntry("10.0.0.0/8", {"tag2"})));
+    EXPECT_FALSE(policyStatement.match(createEntry("11.0.0.0/8", {"tag2"})));
+  }
+
+  // only tags
+  stmt.matcher_ref()->prefixes_ref().reset();
+  stmt.matcher_ref()->prefix_ranges_ref().reset();
+  {
+    auto const policyStatement = RibPolicyStatement(stmt);
+    EXPECT_TRUE(
+        policyStatement.match(createEntry("11.0.0.0/8", {"tag1", "tag3"})));
+    EXPECT_FALSE(policyStatement.match(createEntry("11.0.0.0/8", {"tag3"})));
+  }
+}
+
+/**
+ * Statements matching a route through the indices of policy are applied in
+ * order, regardless of the criteria they match on.
+ */
+TEST(RibPolicy, MatchIndexed) {
+  auto stmtRange = createPolicyStatement({}, 1, {{"area1", 10}});
+  stmtRange.matcher_ref()->prefixes_ref().reset();
+  stmtRange.matcher_ref()->prefix_ranges_ref() =
+      std::vector<thrift::RibPrefixRange>{
+          createPrefixRange("fc00::/16", std::nullopt, 64)};
+  auto stmtTag = createPolicyStatement({}, 1, {{"area1", 20}});
+  stmtTag.matcher_ref()->prefixes_ref().reset();
+  stmtTag.matcher_ref()->tags_ref() = std::vector<std::string>{"tag"};
+  auto stmtPrefixAndTag =
+      createPolicyStatement({toIpPrefix("fd00::/64")}, 1, {{"area1", 30}});
+  stmtPrefixAndTag.matcher_ref()->tags_ref() =
+      std::vector<std::string>{"other-tag"};
+  auto const policy = RibPolicy(
+      createPolicy({stmtRange, stmtTag, stmtPrefixAndTag}, 10));
+
+  const auto nh = createNextHop(
+      toBinaryAddress("fe80::1"), "iface1", 0, std::nullopt, "area1");
+  auto getWeight = [&](RibUnicastEntry entry) -> std::optional<int32_t> {
+    entry.nexthops = {nh};
+    if (not policy.applyAction(entry)) {
+      return std::nullopt;
+    }
+    return *entry.nexthops.begin()->weight_ref();
+  };
+
+  EXPECT_EQ(10, getWeight(createEntry("fc00:1::/64", {"tag"})));
+  EXPECT_EQ(20, getWeight(createEntry("fc00:1::/96", {"tag"})));
+  EXPECT_EQ(20, getWeight(createEntry("fd00::/64", {"tag", "other-tag"})));
+  EXPECT_EQ(30, getWeight(createEntry("fd00::/64", {"other-tag"})));
+  EXPECT_EQ(std::nullopt, getWeight(createEntry("fd00::/64")));
+  EXPECT_EQ(std::nullopt, getWeight(createEntry("fd00:1::/64", {"other-tag"})));
+
+  EXPECT_TRUE(policy.match(createEntry("fc00::/48")));
+  EXPECT_FALSE(policy.match(createEntry("fc00::/128")));
+}
+
 /**
  * Test intends to verify the apply action logic for policy. Only first
  * transformation is applied.
@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/Util.h>
+#include <openr/decision/RouteUpdate.h>
+
+using namespace openr;
+
+namespace {
+const auto prefix1 = folly::IPAddress::createNetwork("fc00:1::/64");
+const auto prefix2 = folly::IPAddress::createNetwork("fc00:2::/64");
+const auto prefix3 = folly::IPAddress::createNetwork("fc00:3::/64");
+
+const auto nh1 =
+    createNextHop(toBinaryAddress(folly::IPAddress("fe80::1")), "iface1", 10);
+const auto nh2 =
+    createNextHop(toBinaryAddress(folly::IPAddress("fe80::2")), "iface2", 10);
+} // namespace
+
+TEST(DecisionRouteUpdateTest, MergeUnicast) {
+  DecisionRouteUpdate older;
+  older.addRouteToUpdate(RibUnicastEntry(prefix1, {nh1}));
+  older.addRouteToUpdate(RibUnicastEntry(prefix2, {nh1}));
+  older.unicastRoutesToDelete.emplace_back(prefix3);
+  older.perfEvents = thrift::PerfEvents();
+
+  // prefix1 gets new nexthops, prefix2 is deleted and prefix3 comes back
+  DecisionRouteUpdate newer;
+  newer.addRouteToUpdate(RibUnicastEntry(prefix1, {nh2}));
+  newer.addRouteToUpdate(RibUnicastEntry(prefix3, {nh2}));
+  newer.unicastRoutesToDelete.emplace_back(prefix2);
+
+  EXPECT_EQ(3, older.merge(std::move(newer)));
+  EXPECT_EQ(2, older.unicastRoutesToUpdate.size());
+  EXPECT_EQ(
+      RibUnicastEntry(prefix1, {nh2}), older.unicastRoutesToUpdate.at(prefix1));
+  EXPECT_EQ(
+      RibUnicastEntry(prefix3, {nh2}), older.unicastRoutesToUpdate.at(prefix3));
+  EXPECT_THAT(older.unicastRoutesToDelete, testing::ElementsAre(prefix2));
+  EXPECT_TRUE(older.perfEvents.has_value());
+
+  // deleting already deleted prefix again
+  DecisionRouteUpdate newest;
+  newest.unicastRoutesToDelete.emplace_back(prefix2);
+  EXPECT_EQ(1, older.merge(std::move(newest)));
+  EXPECT_THAT(older.unicastRoutesToDelete, testing::ElementsAre(prefix2));
+}
+
+TEST(DecisionRouteUpdateTest, MergeMpls) {
+  DecisionRouteUpdate older;
+  older.mplsRoutesToUpdate.emplace_back(RibMplsEntry(1, {nh1}));
+  older.mplsRoutesToUpdate.emplace_back(RibMplsEntry(2, {nh1}));
+  older.mplsRoutesToDelete.emplace_back(3);
+
+  DecisionRouteUpdate newer;
+  newer.mplsRoutesToUpdate.emplace_back(RibMplsEntry(1, {nh2}));
+  newer.mplsRoutesToUpdate.emplace_back(RibMplsEntry(3, {nh2}));
+  newer.mplsRoutesToDelete.emplace_back(2);
+  newer.perfEvents = thrift::PerfEvents();
+
+  EXPECT_EQ(3, older.merge(std::move(newer)));
+  ASSERT_EQ(2, older.mplsRoutesToUpdate.size());
+  EXPECT_EQ(RibMplsEntry(1, {nh2}), older.mplsRoutesToUpdate.at(0));
+  EXPECT_EQ(RibMplsEntry(3, {nh2}), older.mplsRoutesToUpdate.at(1));
+  EXPECT_THAT(older.mplsRoutesToDelete, testing::ElementsAre(2));
+  // perf events are taken from newer update if older had none
+  EXPECT_TRUE(older.perfEvents.has_value());
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -7,6 +7,15 @@
 
 #include <openr/decision/tests/RoutingBenchmarkUtils.h>
 
+#include <openr/monitor/SystemMetrics.h>
+#include <openr/plugin/Plugin.h>
+
+namespace {
+// time to wait for a route update after a replayed publication, longer than
+// the maximum debounce of DecisionWrapper
+const std::chrono::milliseconds kReplayRouteUpdateTimeout{2000};
+} // namespace
+
 namespace openr {
 // Get a unique Id for adjacency-label
 inline uint32_t
@@ -83,7 +92,8 @@ createAdjacencyEntry(
     const uint32_t nodeId,
     const std::string& ifName,
     std::vector<thrift::Adjacency>& adjs,
-    const std::string& otherIfName) {
+    const std::string& otherIfName,
+    const int32_t metric) {
   adjs.emplace_back(createThriftAdjacency(
       folly::sformat("{}", nodeId),
       ifName,
@@ -91,7 +101,7 @@ createAdjacencyEntry(
           "fe80:{}::{}", toHex(nodeId >> 16), toHex(nodeId & 0xffff)),
       folly::sformat(
           "10.{}.{}.{}", nodeId >> 16, (nodeId >> 8) & 0xff, nodeId & 0xff),
-      1,
+      metric,
       100001 + nodeId /* adjacency-label */,
       false /* overload-bit */,
       100,
@@ -239,6 +249,61 @@ createGrid(
   return initialPub;
 }
 
+// Add all adjacencies to node nodeId in a full mesh of n nodes
+std::vector<thrift::Adjacency>
+createMeshAdjacencys(const uint32_t nodeId, const uint32_t n) {
+  std::vector<thrift::Adjacency> adjs;
+  for (uint32_t otherId = 0; otherId < n; ++otherId) {
+    if (otherId == nodeId) {
+      continue;
+    }
+    // symmetric but uneven metrics so that the shortest path to a node is
+    // often found only after some longer one
+    createAdjacencyEntry(
+        otherId,
+        getIfName(nodeId, otherId),
+        adjs,
+        getIfName(otherId, nodeId),
+        1 + (nodeId + otherId) % 16);
+  }
+  return adjs;
+}
+
+// Create a full mesh topology with varying link metrics
+thrift::Publication
+createMesh(
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper,
+    const int n,
+    const int numPrefixes,
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm) {
+  LOG(INFO) << "mesh: " << n << " nodes";
+  LOG(INFO) << " number of prefixes " << numPrefixes;
+  thrift::Publication initialPub;
+
+  for (int nodeId = 0; nodeId < n; ++nodeId) {
+    auto nodeName = folly::sformat("{}", nodeId);
+    // Add adjs
+    auto adjs = createMeshAdjacencys(nodeId, n);
+    (*initialPub.keyVals_ref())
+        .emplace(
+            folly::sformat("adj:{}", nodeName),
+            decisionWrapper->createAdjValue(nodeName, 1, adjs, std::nullopt));
+
+    // prefixes
+    std::vector<thrift::IpPrefix> prefixes;
+    for (int i = 0; i < numPrefixes; i++) {
+      prefixes.push_back(toIpPrefix(nodeToPrefixV6(nodeId + i)));
+    }
+
+    (*initialPub.keyVals_ref())
+        .emplace(
+            folly::sformat("prefix:{}", nodeName),
+            decisionWrapper->createPrefixValue(
+                nodeName, 1, prefixes, forwardingAlgorithm));
+  }
+  return initialPub;
+}
+
 /**
  * Create Adjacencies for spine switches.
  * Each spine switch has numOfPods connections,
@@ -478,6 +543,78 @@ updateRandomGridAdjs(
       decisionWrapper, newPub, nodeName, adjs, processTimes, overloadBit);
 }
 
+//
+// Choose a random nodeId for update or revert the last updated nodeId:
+// toggle it's overload bit in AdjacencyDb
+//
+void
+updateRandomMeshAdjs(
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper,
+    std::optional<uint32_t>& selectedNode,
+    const int n,
+    std::vector<uint64_t>& processTimes) {
+  thrift::Publication newPub;
+
+  // If there has been an update, revert the update,
+  // otherwise, choose a random nodeId for update
+  auto nodeId = selectedNode.has_value() ? selectedNode.value()
+                                         : folly::Random::rand32() % n;
+
+  auto nodeName = folly::sformat("{}", nodeId);
+  auto adjs = createMeshAdjacencys(nodeId, n);
+  auto overloadBit = selectedNode.has_value() ? false : true;
+  // Record the updated nodeId
+  selectedNode = selectedNode.has_value() ? std::nullopt
+                                          : std::optional<uint32_t>(nodeId);
+
+  // Send the update to decision and receive the routes
+  sendRecvUpdate(
+      decisionWrapper, newPub, nodeName, adjs, processTimes, overloadBit);
+}
+
+//
+// Choose a random nodeId of a grid to advertise an additional prefix, or
+// withdraw it again from the last updated nodeId
+//
+void
+updateRandomGridPrefixes(
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper,
+    std::optional<uint32_t>& selectedNode,
+    const int n,
+    const int numPrefixes,
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm) {
+  // Any node but "0" and "1", routes are computed on "1" and not for its own
+  // prefixes
+  auto nodeId = selectedNode.has_value()
+      ? selectedNode.value()
+      : 2 + folly::Random::rand32() % (n * n - 2);
+  auto nodeName = folly::sformat("{}", nodeId);
+
+  std::vector<thrift::IpPrefix> prefixes;
+  for (int i = 0; i < numPrefixes; i++) {
+    prefixes.push_back(toIpPrefix(nodeToPrefixV6(nodeId + i)));
+  }
+  if (not selectedNode.has_value()) {
+    // Not advertised by any other node
+    prefixes.push_back(
+        toIpPrefix(nodeToPrefixV6(n * n + numPrefixes + nodeId)));
+  }
+  // Record the updated nodeId
+  selectedNode = selectedNode.has_value() ? std::nullopt
+                                          : std::optional<uint32_t>(nodeId);
+
+  thrift::Publication newPub;
+  (*newPub.keyVals_ref())[folly::sformat("prefix:{}", nodeName)] =
+      decisionWrapper->createPrefixValue(
+          nodeName, 2, prefixes, forwardingAlgorithm);
+
+  LOG(INFO) << "Advertising prefix update";
+  decisionWrapper->sendKvPublication(newPub);
+
+  // Receive route update from Decision
+  decisionWrapper->recvMyRouteDb();
+}
+
 //
 // Get average processTimes and insert as user counters.
 //
@@ -520,10 +657,12 @@ BM_DecisionGrid(
     uint32_t iters,
     uint32_t numOfSws,
     thrift::PrefixForwardingAlgorithm forwardingAlgorithm,
-    uint32_t numberOfPrefixes) {
+    uint32_t numberOfPrefixes,
+    uint32_t routeBuildThreads) {
   auto suspender = folly::BenchmarkSuspender();
   const std::string nodeName{"1"};
-  auto decisionWrapper = std::make_shared<DecisionWrapper>(nodeName);
+  auto decisionWrapper =
+      std::make_shared<DecisionWrapper>(nodeName, routeBuildThreads);
   int n = std::sqrt(numOfSws);
   auto initialPub =
       createGrid(decisionWrapper, n, numberOfPrefixes, forwardingAlgorithm);
@@ -556,6 +695,105 @@ BM_DecisionGrid(
   suspender.rehire(); // Stop measuring time again
   // Insert processTimes as user counters
   insertUserCounters(counters, iters, processTimes, forwardingAlgorithm);
+  insertMemoryCounters(counters, decisionWrapper);
+}
+
+//
+// Benchmark test for route computation with many prefixes on grid topology
+//
+void
+BM_DecisionGridRouteBuild(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfThreads,
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm) {
+  BM_DecisionGrid(
+      counters,
+      iters,
+      100 /* numOfSws */,
+      forwardingAlgorithm,
+      1000 /* numberOfPrefixes */,
+      numOfThreads);
+}
+
+//
+// Benchmark test for prefix updates on grid topology
+//
+void
+BM_DecisionGridPrefixUpdate(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfPrefixes,
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string nodeName{"1"};
+  const int n = 10;
+  auto decisionWrapper = std::make_shared<DecisionWrapper>(nodeName);
+  auto initialPub =
+      createGrid(decisionWrapper, n, numOfPrefixes, forwardingAlgorithm);
+
+  decisionWrapper->sendKvPublication(initialPub);
+  decisionWrapper->recvMyRouteDb();
+
+  // Record the updated nodeId
+  std::optional<uint32_t> selectedNode = std::nullopt;
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    // Advertise prefix update. This should trigger route computation for the
+    // updated prefix only
+    updateRandomGridPrefixes(
+        decisionWrapper, selectedNode, n, numOfPrefixes, forwardingAlgorithm);
+  }
+
+  suspender.rehire(); // Stop measuring time again
+  insertMemoryCounters(counters, decisionWrapper);
+}
+
+//
+// Benchmark test for full mesh topology
+//
+void
+BM_DecisionMesh(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string nodeName{"1"};
+  auto decisionWrapper = std::make_shared<DecisionWrapper>(nodeName);
+  auto initialPub =
+      createMesh(decisionWrapper, numOfSws, 1, forwardingAlgorithm);
+
+  //
+  // Publish initial link state info to KvStore, This should trigger the
+  // SPF run.
+  //
+  decisionWrapper->sendKvPublication(initialPub);
+
+  // Receive RouteUpdate from Decision
+  decisionWrapper->recvMyRouteDb();
+
+  // Record the updated nodeId
+  std::optional<uint32_t> selectedNode = std::nullopt;
+  //
+  // Customized time counter
+  // processTimes[0] is the time of sending adjDB from Kvstore (simulated) to
+  // Decision, processTimes[1] is the time of debounce, and processTimes[2] is
+  // the time of spf solver
+  //
+  std::vector<uint64_t> processTimes{0, 0, 0};
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    // Advertise adj update. This should trigger the SPF run.
+    updateRandomMeshAdjs(decisionWrapper, selectedNode, numOfSws, processTimes);
+  }
+
+  suspender.rehire(); // Stop measuring time again
+  // Insert processTimes as user counters
+  insertUserCounters(counters, iters, processTimes, forwardingAlgorithm);
+  insertMemoryCounters(counters, decisionWrapper);
 }
 
 //
@@ -627,5 +865,281 @@ BM_DecisionFabric(
   suspender.rehire(); // Stop measuring time again
   // Insert processTimes as user counters
   insertUserCounters(counters, iters, processTimes, std::nullopt);
+  insertMemoryCounters(counters, decisionWrapper);
 }
+
+//
+// Get average phases of route builds and insert as user counters.
+//
+void
+insertRouteBuildCounters(
+    folly::UserCounters& counters,
+    const std::vector<thrift::RouteBuildProfile>& profiles) {
+  if (profiles.empty()) {
+    return;
+  }
+  int64_t totalUs{0};
+  int64_t spfUs{0};
+  int64_t unicastRoutesUs{0};
+  int64_t mplsRoutesUs{0};
+  for (const auto& profile : profiles) {
+    totalUs += *profile.totalUs_ref();
+    spfUs += *profile.spfUs_ref();
+    unicastRoutesUs += *profile.unicastRoutesUs_ref();
+    mplsRoutesUs += *profile.mplsRoutesUs_ref();
+  }
+  counters["route_build_us"] = totalUs / profiles.size();
+  counters["spf_us"] = spfUs / profiles.size();
+  counters["unicast_routes_us"] = unicastRoutesUs / profiles.size();
+  counters["mpls_routes_us"] = mplsRoutesUs / profiles.size();
+}
+
+//
+// Get estimated memory of Decision structures and peak RSS of the process,
+// and insert as user counters. Peak RSS covers all benchmarks run so far in
+// the process, run one with --bm_regex to attribute it
+//
+void
+insertMemoryCounters(
+    folly::UserCounters& counters,
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper) {
+  for (const auto& [name, value] : decisionWrapper->getMemoryCounters()) {
+    // strip "decision." prefix, like other user counters
+    counters[name.substr(name.find('.') + 1)] = value;
+  }
+  counters["peak_rss_bytes"] = SystemMetrics().getPeakRSSMemBytes().value_or(0);
+}
+
+//
+// Whether publication only refreshes TTLs, which Decision ignores
+//
+bool
+isTtlRefresh(const thrift::Publication& publication) {
+  if (not publication.expiredKeys_ref()->empty()) {
+    return false;
+  }
+  for (const auto& [_, value] : *publication.keyVals_ref()) {
+    if (value.value_ref().has_value()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//
+// Benchmark test for initial route computation on a recorded KvStore dump
+//
+void
+BM_DecisionReplayDump(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    const thrift::KvStoreRecording& recording,
+    const std::string& nodeName) {
+  auto suspender = folly::BenchmarkSuspender();
+  std::vector<thrift::RouteBuildProfile> profiles;
+  for (uint32_t i = 0; i < iters; i++) {
+    auto decisionWrapper = std::make_shared<DecisionWrapper>(nodeName);
+
+    suspender.dismiss(); // Start measuring benchmark time
+    decisionWrapper->sendKvPublication(*recording.dump_ref());
+    decisionWrapper->recvMyRouteDb();
+    suspender.rehire(); // Stop measuring time again
+
+    auto nodeProfiles = decisionWrapper->getRouteBuildProfiles();
+    if (not nodeProfiles.empty()) {
+      profiles.emplace_back(std::move(nodeProfiles.back()));
+    }
+    if (i + 1 == iters) {
+      insertMemoryCounters(counters, decisionWrapper);
+    }
+  }
+  counters["keys"] = recording.dump_ref()->keyVals_ref()->size();
+  insertRouteBuildCounters(counters, profiles);
+}
+
+//
+// Benchmark test for route computation on recorded KvStore publications
+//
+void
+BM_DecisionReplayPublications(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    const thrift::KvStoreRecording& recording,
+    const std::string& nodeName) {
+  auto suspender = folly::BenchmarkSuspender();
+  std::vector<thrift::Publication> publications;
+  for (const auto& publication : *recording.publications_ref()) {
+    if (not isTtlRefresh(publication)) {
+      publications.emplace_back(publication);
+    }
+  }
+
+  // Find out publications leading to a route update with a dry run, others
+  // e.g. re-advertising unchanged adjacencies are not waited for
+  std::vector<bool> updatesRoutes;
+  {
+    auto decisionWrapper = std::make_shared<DecisionWrapper>(nodeName);
+    decisionWrapper->sendKvPublication(*recording.dump_ref());
+    decisionWrapper->recvMyRouteDb();
+    for (const auto& publication : publications) {
+      decisionWrapper->sendKvPublication(publication);
+      updatesRoutes.push_back(
+          decisionWrapper->waitForMyRouteDb(kReplayRouteUpdateTimeout));
+      if (updatesRoutes.back()) {
+        decisionWrapper->recvMyRouteDb();
+      }
+    }
+  }
+
+  std::vector<thrift::RouteBuildProfile> profiles;
+  for (uint32_t i = 0; i < iters; i++) {
+    auto decisionWrapper = std::make_shared<DecisionWrapper>(nodeName);
+    decisionWrapper->sendKvPublication(*recording.dump_ref());
+    decisionWrapper->recvMyRouteDb();
+
+    for (size_t j = 0; j < publications.size(); j++) {
+      if (not updatesRoutes[j]) {
+        decisionWrapper->sendKvPublication(publications[j]);
+        continue;
+      }
+      suspender.dismiss(); // Start measuring benchmark time
+      decisionWrapper->sendKvPublication(publications[j]);
+      CHECK(decisionWrapper->waitForMyRouteDb(kReplayRouteUpdateTimeout))
+          << "No route update for publication " << j << " unlike in dry run";
+      decisionWrapper->recvMyRouteDb();
+      suspender.rehire(); // Stop measuring time again
+
+      auto nodeProfiles = decisionWrapper->getRouteBuildProfiles();
+      if (not nodeProfiles.empty()) {
+        profiles.emplace_back(std::move(nodeProfiles.back()));
+      }
+    }
+    if (i + 1 == iters) {
+      insertMemoryCounters(counters, decisionWrapper);
+    }
+  }
+  counters["publications"] = publications.size();
+  counters["route_updates"] =
+      std::count(updatesRoutes.begin(), updatesRoutes.end(), true);
+  insertRouteBuildCounters(counters, profiles);
+}
+void
+buildRouteStates(
+    const thrift::Publication& publication,
+    std::unordered_map<std::string, LinkState>& areaLinkStates,
+    PrefixState& prefixState) {
+  CompactSerializer serializer;
+  for (const auto& [key, value] : *publication.keyVals_ref()) {
+    if (not value.value_ref().has_value()) {
+      continue;
+    }
+    if (key.find(Constants::kAdjDbMarker.toString()) == 0) {
+      auto adjDb = fbzmq::util::readThriftObjStr<thrift::AdjacencyDatabase>(
+          *value.value_ref(), serializer);
+      auto const& area = *adjDb.area_ref();
+      areaLinkStates.try_emplace(area, area)
+          .first->second.updateAdjacencyDatabase(adjDb);
+    } else if (key.find(Constants::kPrefixDbMarker.toString()) == 0) {
+      prefixState.updatePrefixDatabase(
+          fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
+              *value.value_ref(), serializer));
+    }
+  }
+}
+
+std::unique_ptr<RouteComputationEngine>
+createRouteEngine(const std::string& engineName, const std::string& nodeName) {
+  if (engineName == SpfSolverRouteEngine::kName.str()) {
+    return std::make_unique<SpfSolverRouteEngine>(std::make_unique<SpfSolver>(
+        nodeName, false /* enableV4 */, true /* computeLfaPaths */));
+  }
+  return pluginCreateRouteComputationEngine(
+      engineName, std::make_shared<Config>(getBasicOpenrConfig(nodeName)));
+}
+
+size_t
+countMismatchedRoutes(
+    const DecisionRouteDb& routeDb, const DecisionRouteDb& referenceDb) {
+  size_t numMismatched{0};
+  for (const auto& [prefix, entry] : referenceDb.unicastRoutes) {
+    auto it = routeDb.unicastRoutes.find(prefix);
+    if (it == routeDb.unicastRoutes.end() or not(it->second == entry)) {
+      LOG_IF(WARNING, numMismatched == 0)
+          << "First mismatched route: "
+          << folly::IPAddress::networkToString(prefix);
+      ++numMismatched;
+    }
+  }
+  for (const auto& [label, entry] : referenceDb.mplsRoutes) {
+    auto it = routeDb.mplsRoutes.find(label);
+    if (it == routeDb.mplsRoutes.end() or not(it->second == entry)) {
+      LOG_IF(WARNING, numMismatched == 0)
+          << "First mismatched route: label " << label;
+      ++numMismatched;
+    }
+  }
+  for (const auto& [prefix, _] : routeDb.unicastRoutes) {
+    numMismatched += referenceDb.unicastRoutes.count(prefix) == 0;
+  }
+  for (const auto& [label, _] : routeDb.mplsRoutes) {
+    numMismatched += referenceDb.mplsRoutes.count(label) == 0;
+  }
+  return numMismatched;
+}
+
+//
+// Benchmark test for full route builds of a route computation engine
+//
+void
+BM_RouteEngineGrid(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    uint32_t numberOfPrefixes,
+    const std::string& engineName) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string nodeName{"1"};
+  auto engine = createRouteEngine(engineName, nodeName);
+  CHECK(engine) << "Route engine " << engineName << " not supported";
+  auto referenceEngine =
+      createRouteEngine(SpfSolverRouteEngine::kName.str(), nodeName);
+
+  std::unordered_map<std::string, LinkState> areaLinkStates;
+  PrefixState prefixState;
+  {
+    auto decisionWrapper = std::make_shared<DecisionWrapper>(nodeName);
+    const int n = std::sqrt(numOfSws);
+    buildRouteStates(
+        createGrid(decisionWrapper, n, numberOfPrefixes, SP_ECMP),
+        areaLinkStates,
+        prefixState);
+  }
+
+  // conformance with SpfSolver, on copies of the states as engines may
+  // memoize SPF results in them
+  {
+    auto linkStates = areaLinkStates;
+    auto referenceLinkStates = areaLinkStates;
+    auto routeDb = engine->buildRouteDb(nodeName, linkStates, prefixState);
+    auto referenceDb = referenceEngine->buildRouteDb(
+        nodeName, referenceLinkStates, prefixState);
+    CHECK(referenceDb.has_value());
+    const size_t numRoutes =
+        referenceDb->unicastRoutes.size() + referenceDb->mplsRoutes.size();
+    counters["routes"] = numRoutes;
+    counters["mismatched_routes"] = routeDb.has_value()
+        ? countMismatchedRoutes(*routeDb, *referenceDb)
+        : numRoutes;
+  }
+
+  for (uint32_t i = 0; i < iters; i++) {
+    // start from the same cold state every iteration
+    auto linkStates = areaLinkStates;
+    suspender.dismiss(); // Start measuring benchmark time
+    auto routeDb = engine->buildRouteDb(nodeName, linkStates, prefixState);
+    folly::doNotOptimizeAway(routeDb);
+    suspender.rehire(); // Stop measuring time again
+  }
+}
+
 } // namespace openr
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <fb303/ServiceData.h>
 #include <folly/Benchmark.h>
 #include <folly/IPAddress.h>
 #include <folly/IPAddressV4.h>
@@ -20,6 +21,8 @@
 #include <openr/common/Util.h>
 #include <openr/config/tests/Utils.h>
 #include <openr/decision/Decision.h>
+#include <openr/decision/RouteComputationEngine.h>
+#include <openr/if/gen-cpp2/KvStore_types.h>
 #include <openr/tests/OpenrThriftServerWrapper.h>
 #include <thrift/lib/cpp2/Thrift.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
@@ -70,8 +73,11 @@ using apache::thrift::FRAGILE;
 //
 class DecisionWrapper {
  public:
-  explicit DecisionWrapper(const std::string& nodeName) {
+  explicit DecisionWrapper(
+      const std::string& nodeName, int32_t routeBuildThreads = 1) {
     auto tConfig = getBasicOpenrConfig(nodeName);
+    tConfig.decision_config_ref()->route_build_threads_ref() =
+        routeBuildThreads;
     config = std::make_shared<Config>(tConfig);
 
     decision = std::make_shared<Decision>(
@@ -108,10 +114,45 @@ class DecisionWrapper {
   DecisionRouteUpdate
   recvMyRouteDb() {
     auto maybeRouteDb = routeUpdatesQueueReader.get();
-    auto routeDb = maybeRouteDb.value();
+    auto routeDb = *maybeRouteDb.value();
     return routeDb;
   }
 
+  // Wait up to timeout for a route update to be available to recvMyRouteDb()
+  bool
+  waitForMyRouteDb(std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (routeUpdatesQueueReader.size() == 0) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+  }
+
+  std::vector<thrift::RouteBuildProfile>
+  getRouteBuildProfiles() {
+    return *decision->getRouteBuildProfiles().get();
+  }
+
+  // Refresh and get estimated memory of Decision structures
+  std::map<std::string, int64_t>
+  getMemoryCounters() {
+    decision->getEvb()->runInEventBaseThreadAndWait(
+        [this]() { decision->updateGlobalCounters(); });
+    const auto fbCounters = facebook::fb303::fbData->getCounters();
+    std::map<std::string, int64_t> memoryCounters;
+    for (const auto& name :
+         {"decision.link_state_bytes",
+          "decision.prefix_state_bytes",
+          "decision.spf_cache_bytes",
+          "decision.kth_paths_cache_bytes"}) {
+      memoryCounters[name] = fbCounters.at(name);
+    }
+    return memoryCounters;
+  }
+
   // helper function
   thrift::Value
   createAdjValue(
@@ -193,10 +234,10 @@ class DecisionWrapper {
   CompactSerializer serializer{};
 
   std::shared_ptr<Config> config;
-  messaging::ReplicateQueue<thrift::Publication> kvStoreUpdatesQueue;
-  messaging::ReplicateQueue<DecisionRouteUpdate> routeUpdatesQueue;
+  messaging::ReplicateQueue<PublicationPtr> kvStoreUpdatesQueue;
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> staticRoutesUpdateQueue;
-  messaging::RQueue<DecisionRouteUpdate> routeUpdatesQueueReader{
+  messaging::RQueue<DecisionRouteUpdatePtr> routeUpdatesQueueReader{
       routeUpdatesQueue.getReader()};
 
   // KvStore owned by this wrapper.
@@ -237,7 +278,8 @@ inline void createAdjacencyEntry(
     const uint32_t nodeId,
     const std::string& ifName,
     std::vector<thrift::Adjacency>& adjs,
-    const std::string& otherIfName);
+    const std::string& otherIfName,
+    const int32_t metric = 1);
 
 // Get ifName
 std::string getFabricIfName(const std::string& id, const std::string& otherId);
@@ -275,6 +317,17 @@ thrift::Publication createGrid(
     const int numPrefixes,
     thrift::PrefixForwardingAlgorithm forwardingAlgorithm);
 
+// Add all adjacencies to node nodeId in a full mesh of n nodes
+std::vector<thrift::Adjacency> createMeshAdjacencys(
+    const uint32_t nodeId, const uint32_t n);
+
+// Create a full mesh topology with varying link metrics
+thrift::Publication createMesh(
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper,
+    const int n,
+    const int numPrefixes,
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm);
+
 /**
  * Create Adjacencies for spine switches.
  * Each spine switch has numOfPods connections,
@@ -349,6 +402,28 @@ void updateRandomGridAdjs(
     const int n,
     std::vector<uint64_t>& processTimes);
 
+//
+// Choose a random nodeId for update or revert the last updated nodeId:
+// toggle it's overload bit in AdjacencyDb
+//
+void updateRandomMeshAdjs(
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper,
+    std::optional<uint32_t>& selectedNode,
+    const int n,
+    std::vector<uint64_t>& processTimes);
+
+//
+// Choose a random nodeId of a grid to advertise an additional prefix, or
+// withdraw it again from the last updated nodeId, by re-advertising all
+// prefixes of the node
+//
+void updateRandomGridPrefixes(
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper,
+    std::optional<uint32_t>& selectedNode,
+    const int n,
+    const int numPrefixes,
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm);
+
 //
 // Get average processTimes and insert as user counters.
 //
@@ -358,6 +433,26 @@ void insertUserCounters(
     std::vector<uint64_t>& processTimes,
     std::optional<thrift::PrefixForwardingAlgorithm> forwardingAlgorithm);
 
+//
+// Get average phases of route builds and insert as user counters.
+//
+void insertRouteBuildCounters(
+    folly::UserCounters& counters,
+    const std::vector<thrift::RouteBuildProfile>& profiles);
+
+//
+// Get estimated memory of Decision structures and peak RSS of the process,
+// and insert as user counters.
+//
+void insertMemoryCounters(
+    folly::UserCounters& counters,
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper);
+
+//
+// Whether publication only refreshes TTLs, which Decision ignores
+//
+bool isTtlRefresh(const thrift::Publication& publication);
+
 //
 // Benchmark test for grid topology
 //
@@ -366,7 +461,39 @@ void BM_DecisionGrid(
     uint32_t iters,
     uint32_t numOfSws,
     thrift::PrefixForwardingAlgorithm forwardingAlgorithm,
-    uint32_t numberOfPrefixes = 1);
+    uint32_t numberOfPrefixes = 1,
+    uint32_t routeBuildThreads = 1);
+
+//
+// Benchmark test for route computation with many prefixes on grid topology,
+// sharded across numOfThreads route build threads
+//
+void BM_DecisionGridRouteBuild(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfThreads,
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm);
+
+//
+// Benchmark test for prefix updates on grid topology, of nodes advertising
+// numOfPrefixes prefixes each
+//
+void BM_DecisionGridPrefixUpdate(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfPrefixes,
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm);
+
+//
+// Benchmark test for full mesh topology. Unequal link metrics make SPF find
+// many strictly better paths to already queued nodes, which stresses the
+// decrease-key path of DijkstraQ
+//
+void BM_DecisionMesh(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    thrift::PrefixForwardingAlgorithm forwardingAlgorithm);
 
 //
 // Benchmark test for fabric topology.
@@ -377,6 +504,64 @@ void BM_DecisionFabric(
     uint32_t numOfSws,
     thrift::PrefixForwardingAlgorithm /* TODO use this */);
 
+//
+// Benchmark test for initial route computation of nodeName on the dump of a
+// recorded KvStore, e.g. of a production network with uneven metrics,
+// overloaded nodes and prefixes with many announcers
+//
+void BM_DecisionReplayDump(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    const thrift::KvStoreRecording& recording,
+    const std::string& nodeName);
+
+//
+// Benchmark test for route computation of nodeName on the publications of a
+// recorded KvStore, replayed one at a time on top of its dump. Only the
+// publications leading to a route update are measured.
+//
+void BM_DecisionReplayPublications(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    const thrift::KvStoreRecording& recording,
+    const std::string& nodeName);
+
+//
+// Link and prefix state of the adjacency and prefix databases in publication,
+// as Decision would build them
+//
+void buildRouteStates(
+    const thrift::Publication& publication,
+    std::unordered_map<std::string, LinkState>& areaLinkStates,
+    PrefixState& prefixState);
+
+//
+// Route computation engine of given name for nodeName, SpfSolver for
+// SpfSolverRouteEngine::kName and of the platform plugin otherwise. nullptr
+// if not supported
+//
+std::unique_ptr<RouteComputationEngine> createRouteEngine(
+    const std::string& engineName, const std::string& nodeName);
+
+//
+// Number of routes missing in or differing from those of referenceDb, and
+// routes not in referenceDb
+//
+size_t countMismatchedRoutes(
+    const DecisionRouteDb& routeDb, const DecisionRouteDb& referenceDb);
+
+//
+// Benchmark test for full route builds of a route computation engine on grid
+// topology, measuring the engine only. Routes are checked against SpfSolver
+// beforehand, routes which differ are reported in mismatched_routes counter
+//
+void BM_RouteEngineGrid(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    uint32_t numberOfPrefixes,
+    const std::string& engineName);
+
 const auto SP_ECMP = thrift::PrefixForwardingAlgorithm::SP_ECMP;
 const auto KSP2_ED_ECMP = thrift::PrefixForwardingAlgorithm::KSP2_ED_ECMP;
 } // namespace openr
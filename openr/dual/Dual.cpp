@@ -7,6 +7,10 @@
 
 #include "openr/dual/Dual.h"
 
+#include <fb303/ServiceData.h>
+
+namespace fb303 = facebook::fb303;
+
 namespace openr {
 
 void
@@ -725,29 +729,43 @@ DualNode::DualNode(const std::string& nodeId, bool isRoot)
 
 void
 DualNode::peerUp(const std::string& neighbor, int64_t cost) {
-  // update local-distance
-  localDistances_[neighbor] = cost;
+  peersUp({{neighbor, cost}});
+}
 
+void
+DualNode::peerDown(const std::string& neighbor) {
+  peersDown({neighbor});
+}
+
+void
+DualNode::peersUp(const std::unordered_map<std::string, int64_t>& neighbors) {
   std::unordered_map<std::string, thrift::DualMessages> msgsToSend;
 
-  for (auto& kv : duals_) {
-    kv.second.peerUp(neighbor, cost, msgsToSend);
+  for (const auto& [neighbor, cost] : neighbors) {
+    // update local-distance
+    localDistances_[neighbor] = cost;
+
+    for (auto& kv : duals_) {
+      kv.second.peerUp(neighbor, cost, msgsToSend);
+    }
   }
 
   sendAllDualMessages(msgsToSend);
 }
 
 void
-DualNode::peerDown(const std::string& neighbor) {
-  // update local-distance
-  localDistances_[neighbor] = std::numeric_limits<int64_t>::max();
-  // clear counters
-  clearCounters(neighbor);
-
+DualNode::peersDown(const std::vector<std::string>& neighbors) {
   std::unordered_map<std::string, thrift::DualMessages> msgsToSend;
 
-  for (auto& kv : duals_) {
-    kv.second.peerDown(neighbor, msgsToSend);
+  for (const auto& neighbor : neighbors) {
+    // update local-distance
+    localDistances_[neighbor] = std::numeric_limits<int64_t>::max();
+    // clear counters
+    clearCounters(neighbor);
+
+    for (auto& kv : duals_) {
+      kv.second.peerDown(neighbor, msgsToSend);
+    }
   }
 
   sendAllDualMessages(msgsToSend);
@@ -952,7 +970,24 @@ DualNode::sendAllDualMessages(
     (*counters_[neighbor].pktSent_ref())++;
     counters_[neighbor].msgSent_ref() =
         *counters_[neighbor].msgSent_ref() + msgs.messages_ref()->size();
+    fb303::fbData->addStatValue("dual.packets_sent", 1, fb303::SUM);
+    fb303::fbData->addStatValue(
+        "dual.messages_sent", msgs.messages_ref()->size(), fb303::SUM);
+    convergenceMsgSent_ += msgs.messages_ref()->size();
+  }
+
+  // report messages sent to converge once all duals are PASSIVE again
+  if (convergenceMsgSent_ == 0) {
+    return;
+  }
+  for (const auto& kv : duals_) {
+    if (kv.second.getInfo().sm.state != DualState::PASSIVE) {
+      return;
+    }
   }
+  fb303::fbData->addStatValue(
+      "dual.convergence_messages_sent", convergenceMsgSent_, fb303::AVG);
+  convergenceMsgSent_ = 0;
 }
 
 void
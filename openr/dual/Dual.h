@@ -11,6 +11,8 @@
 #include <limits>
 #include <stack>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <folly/Format.h>
 
@@ -338,6 +340,12 @@ class DualNode {
   // peer down from neighbor
   void peerDown(const std::string& neighbor);
 
+  // peers up from many neighbors at once, e.g. on start-up, and peers down.
+  // Events are processed for all roots in one pass, and dual messages are sent
+  // to each neighbor as one packet rather than one per event
+  void peersUp(const std::unordered_map<std::string, int64_t>& neighbors);
+  void peersDown(const std::vector<std::string>& neighbors);
+
   // peer cost change from neighbor
   void peerCostChange(const std::string& neighbor, int64_t cost);
 
@@ -409,6 +417,9 @@ class DualNode {
 
   // map<neighbor-id: counters>
   std::unordered_map<std::string, thrift::DualPerNeighborCounters> counters_;
+
+  // dual messages sent since all duals were last PASSIVE
+  int64_t convergenceMsgSent_{0};
 };
 
 } // namespace openr
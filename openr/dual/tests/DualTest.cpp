@@ -15,6 +15,7 @@
 #include <folly/io/async/EventBase.h>
 #include <openr/dual/Dual.h>
 
+#include <set>
 #include <vector>
 
 using namespace openr;
@@ -1023,6 +1024,72 @@ TEST_P(DualFixture, GridTest) {
   EXPECT_TRUE(multiFailureTest(flap));
 }
 
+// Dual node recording dual messages it sends
+class DualRecordingNode final : public DualNode {
+ public:
+  explicit DualRecordingNode(const std::string& nodeId) : DualNode(nodeId) {}
+
+  bool
+  sendDualMessages(
+      const std::string& neighbor,
+      const thrift::DualMessages& msgs) noexcept override {
+    sent[neighbor].emplace_back(msgs);
+    return true;
+  }
+
+  void
+  processNexthopChange(
+      const std::string& /* rootId */,
+      const std::optional<std::string>& /* oldNh */,
+      const std::optional<std::string>& /* newNh */) noexcept override {}
+
+  std::map<std::string, std::vector<thrift::DualMessages>> sent;
+};
+
+TEST(DualNode, BatchedPeerEvents) {
+  DualRecordingNode node("node");
+
+  // discover roots r1 and r2 from neighbors of same names
+  node.peersUp({{"r1", 1}, {"r2", 1}});
+  for (const auto& root : {"r1", "r2"}) {
+    thrift::DualMessage msg;
+    *msg.dstId_ref() = root;
+    msg.distance_ref() = 0;
+    msg.type_ref() = thrift::DualMessageType::UPDATE;
+    thrift::DualMessages msgs;
+    *msgs.srcId_ref() = root;
+    msgs.messages_ref()->emplace_back(std::move(msg));
+    node.processDualMessages(msgs);
+  }
+  EXPECT_TRUE(node.hasDual("r1"));
+  EXPECT_TRUE(node.hasDual("r2"));
+  node.sent.clear();
+
+  // many peers up at once: one packet per peer, carrying updates of all roots
+  node.peersUp({{"n1", 1}, {"n2", 1}, {"n3", 1}});
+  for (const auto& neighbor : {"n1", "n2", "n3"}) {
+    ASSERT_EQ(1, node.sent.count(neighbor));
+    ASSERT_EQ(1, node.sent.at(neighbor).size());
+    std::set<std::string> roots;
+    for (const auto& msg : *node.sent.at(neighbor).front().messages_ref()) {
+      roots.emplace(*msg.dstId_ref());
+    }
+    EXPECT_EQ((std::set<std::string>{"r1", "r2"}), roots);
+    EXPECT_EQ(
+        1,
+        *node.getCounters().neighborCounters_ref()->at(neighbor).pktSent_ref());
+  }
+
+  // many peers down at once: at most one packet per remaining peer
+  node.sent.clear();
+  node.peersDown({"n1", "n2"});
+  EXPECT_FALSE(node.neighborUp("n1"));
+  EXPECT_FALSE(node.neighborUp("n2"));
+  for (const auto& [_, packets] : node.sent) {
+    EXPECT_EQ(1, packets.size());
+  }
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
@@ -7,37 +7,150 @@
 
 #include "Fib.h"
 
+#include <algorithm>
+#include <functional>
+
 #include <fb303/ServiceData.h>
 #include <fbzmq/service/logging/LogSample.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/MapUtil.h>
+#include <folly/String.h>
+#include <folly/futures/Future.h>
 #include <thrift/lib/cpp/protocol/TProtocolTypes.h>
 #include <thrift/lib/cpp/transport/THeader.h>
+#include <thrift/lib/cpp/transport/TTransportException.h>
 #include <thrift/lib/cpp2/async/HeaderClientChannel.h>
 
 #include <openr/common/Constants.h>
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/Pagination.h>
 #include <openr/common/Util.h>
 
 namespace fb303 = facebook::fb303;
 
 namespace openr {
 
+namespace {
+// Whether thrift route of entry carries BGP data, see RibUnicastEntry::toThrift
+bool
+hasBgpData(const RibUnicastEntry& route) {
+  return *route.bestPrefixEntry.type_ref() == thrift::PrefixType::BGP and
+      route.bestPrefixEntry.data_ref().has_value();
+}
+
+// Whether programming route over prevRoute leaves the agent's forwarding
+// unchanged, e.g. when only attributes of bestPrefixEntry changed
+bool
+isSameProgrammedRoute(
+    const RibUnicastEntry& prevRoute, const RibUnicastEntry& route) {
+  // next-hops are interned, equal groups compare by pointer
+  if (prevRoute.nexthops != route.nexthops or
+      prevRoute.backupNexthops != route.backupNexthops) {
+    return false;
+  }
+  const bool isBgp =
+      *route.bestPrefixEntry.type_ref() == thrift::PrefixType::BGP;
+  if (isBgp != (*prevRoute.bestPrefixEntry.type_ref() ==
+                thrift::PrefixType::BGP)) {
+    return false;
+  }
+  return not isBgp or
+      prevRoute.bestPrefixEntry.data_ref().to_optional() ==
+      route.bestPrefixEntry.data_ref().to_optional();
+}
+
+// Selected next-hops of an MPLS route in canonical order
+std::vector<thrift::NextHopThrift>
+getSelectedMplsNextHops(const std::vector<thrift::NextHopThrift>& nextHops) {
+  auto selected = selectMplsNextHops(nextHops);
+  std::sort(selected.begin(), selected.end());
+  return selected;
+}
+
+// Order in which a chunked full sync programs unicast routes. Default routes
+// first, then host routes (e.g. loopbacks), other routes from Open/R and
+// finally routes with BGP data.
+size_t
+getSyncPriority(const RibUnicastEntry& route) {
+  auto const& [addr, prefixLen] = route.prefix;
+  if (prefixLen == 0) {
+    return 0;
+  }
+  if (prefixLen == addr.bitCount()) {
+    return 1;
+  }
+  if (not hasBgpData(route)) {
+    return 2;
+  }
+  return 3;
+}
+
+// Nexthops in the form the agent reports them back, without Open/R internal
+// attributes and in canonical order
+std::vector<thrift::NextHopThrift>
+getProgrammedNextHops(std::vector<thrift::NextHopThrift> nextHops) {
+  for (auto& nextHop : nextHops) {
+    nextHop.metric_ref() = 0;
+    nextHop.area_ref().reset();
+    nextHop.neighborNodeName_ref().reset();
+  }
+  std::sort(nextHops.begin(), nextHops.end());
+  return nextHops;
+}
+
+// Program changes in requests of at most batchSize entries
+template <typename T>
+void
+forEachBatch(
+    std::vector<T> const& entries,
+    size_t batchSize,
+    std::function<void(std::vector<T>)> const& program) {
+  for (size_t i = 0; i < entries.size(); i += batchSize) {
+    program(std::vector<T>(
+        entries.begin() + i,
+        entries.begin() + std::min(i + batchSize, entries.size())));
+  }
+}
+
+// Add or remove key of a route under the interfaces of its nexthops
+template <typename Key, typename NextHops>
+void
+updateInterfaceIndex(
+    std::unordered_map<std::string, std::unordered_set<Key>>& index,
+    Key const& key,
+    NextHops const& nextHops,
+    bool add) {
+  for (auto const& nextHop : nextHops) {
+    auto const ifName = nextHop.address_ref()->ifName_ref();
+    if (not ifName.has_value()) {
+      continue;
+    }
+    if (add) {
+      index[*ifName].emplace(key);
+      continue;
+    }
+    auto it = index.find(*ifName);
+    if (it != index.end()) {
+      it->second.erase(key);
+      if (it->second.empty()) {
+        index.erase(it);
+      }
+    }
+  }
+}
+} // namespace
+
 Fib::Fib(
     std::shared_ptr<const Config> config,
     int32_t thriftPort,
     std::chrono::seconds coldStartDuration,
-    messaging::RQueue<DecisionRouteUpdate> routeUpdatesQueue,
-    messaging::RQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue,
+    messaging::RQueue<DecisionRouteUpdatePtr> routeUpdatesQueue,
+    messaging::RQueue<InterfaceDatabaseUpdate> interfaceUpdatesQueue,
+    messaging::RQueue<InterfaceStatusEvent> interfaceStatusEventsQueue,
     messaging::ReplicateQueue<thrift::RouteDatabaseDelta>& fibUpdatesQueue,
     messaging::ReplicateQueue<LogSample>& logSampleQueue,
     KvStore* kvStore)
     : myNodeName_(*config->getConfig().node_name_ref()),
-      thriftPort_(thriftPort),
-      expBackoff_(
-          Constants::kFibSyncInitialBackoff,
-          Constants::kFibSyncMaxBackoff,
-          false),
       kvStore_(kvStore),
       fibUpdatesQueue_(fibUpdatesQueue),
       logSampleQueue_(logSampleQueue) {
@@ -48,23 +161,15 @@ Fib::Fib(
       config->getConfig().enable_segment_routing_ref().value_or(false);
   enableOrderedFib_ =
       config->getConfig().enable_ordered_fib_programming_ref().value_or(false);
+  fibSyncBatchSize_ = *config->getConfig().fib_sync_batch_size_ref();
+  enableWarmBoot_ = config->isFibWarmBootEnabled();
+  enablePerfSpans_ = config->isPerfSpansEnabled();
+
+  addBackend(thriftPort);
+  for (auto const port : *tConfig.additional_fib_ports_ref()) {
+    addBackend(port);
+  }
 
-  syncRoutesTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
-    if (routeState_.hasRoutesFromDecision) {
-      if (syncRouteDb()) {
-        hasSyncedFib_ = true;
-        expBackoff_.reportSuccess();
-      } else {
-        // Apply exponential backoff and schedule next run
-        expBackoff_.reportError();
-        const auto period = expBackoff_.getTimeRemainingUntilRetry();
-        LOG(INFO) << "Scheduling fib sync after " << period.count() << "ms";
-        syncRoutesTimer_->scheduleTimeout(period);
-      }
-    }
-    fb303::fbData->setCounter(
-        "fib.synced", syncRoutesTimer_->isScheduled() ? 0 : 1);
-  });
   // On startup we do require routedb_sync so explicitly set the counter to 0
   fb303::fbData->setCounter("fib.synced", 0);
 
@@ -80,19 +185,24 @@ Fib::Fib(
     LOG(INFO)
         << "EOR time is not configured; schedule fib sync of routeDb with cold-start duration "
         << coldStartDuration.count() << "secs";
-    syncRoutesTimer_->scheduleTimeout(coldStartDuration);
+    for (auto& backend : backends_) {
+      backend->syncRoutesTimer->scheduleTimeout(coldStartDuration);
+    }
   }
 
   keepAliveTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
     // Make thrift calls to do real programming
-    try {
-      keepAliveCheck();
-    } catch (const std::exception& e) {
-      fb303::fbData->addStatValue(
-          "fib.thrift.failure.keepalive", 1, fb303::COUNT);
-      client_.reset();
-      LOG(ERROR) << "Failed to make thrift call to Switch Agent. Error: "
-                 << folly::exceptionStr(e);
+    for (auto& backend : backends_) {
+      try {
+        keepAliveCheck(*backend);
+      } catch (const std::exception& e) {
+        fb303::fbData->addStatValue(
+            "fib.thrift.failure.keepalive", 1, fb303::COUNT);
+        backend->client.reset();
+        LOG(ERROR) << "Failed to make thrift call to Switch Agent on port "
+                   << backend->thriftPort
+                   << ". Error: " << folly::exceptionStr(e);
+      }
     }
     // schedule periodically
     keepAliveTimer_->scheduleTimeout(Constants::kKeepAliveCheckInterval);
@@ -113,7 +223,39 @@ Fib::Fib(
         break;
       }
 
-      processRouteUpdates(std::move(maybeThriftObj).value().toThrift());
+      // Coalesce updates queued up meanwhile (e.g. during a flap storm), so
+      // that superseded routes are not programmed. Updates are shared with
+      // other readers, hence only copied when there is something to merge.
+      auto routeUpdate = std::move(maybeThriftObj).value();
+      fb303::fbData->setCounter("fib.route_updates_queue_depth", q.size());
+      // Routes which lost next-hops are programmed right away, ahead of the
+      // rest of the rebuild queued up behind them
+      if (routeUpdate->isPriority) {
+        fb303::fbData->addStatValue(
+            "fib.priority_route_updates", 1, fb303::COUNT);
+        processRouteUpdates(DecisionRouteUpdate(*routeUpdate));
+        continue;
+      }
+      std::optional<DecisionRouteUpdate> mergedUpdate;
+      while (q.size()) {
+        auto maybeNextUpdate = q.get();
+        if (maybeNextUpdate.hasError()) {
+          break;
+        }
+        if (not mergedUpdate) {
+          mergedUpdate = *routeUpdate;
+        }
+        auto const numSuperseded =
+            mergedUpdate->merge(DecisionRouteUpdate(*maybeNextUpdate.value()));
+        fb303::fbData->addStatValue(
+            "fib.coalesced_route_updates", 1, fb303::COUNT);
+        fb303::fbData->addStatValue(
+            "fib.coalesced_route_entries", numSuperseded, fb303::SUM);
+      }
+
+      processRouteUpdates(
+          mergedUpdate ? std::move(mergedUpdate).value()
+                       : DecisionRouteUpdate(*routeUpdate));
     }
   });
 
@@ -127,28 +269,130 @@ Fib::Fib(
         break;
       }
 
-      CHECK_EQ(myNodeName_, *maybeThriftObj.value().thisNodeName_ref());
+      CHECK_EQ(
+          myNodeName_, *maybeThriftObj.value().snapshot->thisNodeName_ref());
       processInterfaceDb(std::move(maybeThriftObj).value());
     }
   });
 
+  // Fiber to process interface status events from LinkMonitor
+  addFiberTask(
+      [q = std::move(interfaceStatusEventsQueue), this]() mutable noexcept {
+        while (true) {
+          auto maybeEvent = q.get(); // perform read
+          if (maybeEvent.hasError()) {
+            LOG(INFO) << "Terminating interface status event processing fiber";
+            break;
+          }
+          processInterfaceStatusEvent(maybeEvent.value());
+        }
+      });
+
   // Initialize stats keys
+  fb303::fbData->addStatExportType("fib.coalesced_route_entries", fb303::SUM);
+  fb303::fbData->addStatExportType("fib.suppressed_route_updates", fb303::SUM);
+  fb303::fbData->addStatExportType("fib.coalesced_route_updates", fb303::COUNT);
+  fb303::fbData->addStatExportType("fib.priority_route_updates", fb303::COUNT);
+  fb303::fbData->addStatExportType("fib.lfa_backup_activations", fb303::COUNT);
   fb303::fbData->addStatExportType("fib.convergence_time_ms", fb303::AVG);
   fb303::fbData->addStatExportType(
       "fib.local_route_program_time_ms", fb303::AVG);
   fb303::fbData->addStatExportType("fib.num_of_route_updates", fb303::SUM);
   fb303::fbData->addStatExportType("fib.process_interface_db", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "fib.interface_status_events", fb303::COUNT);
   fb303::fbData->addStatExportType("fib.process_route_db", fb303::COUNT);
   fb303::fbData->addStatExportType("fib.sync_fib_calls", fb303::COUNT);
+  fb303::fbData->addStatExportType("fib.sync_fib_chunks", fb303::COUNT);
+  fb303::fbData->addStatExportType("fib.warm_boot_sync_calls", fb303::COUNT);
   fb303::fbData->addStatExportType(
       "fib.thrift.failure.add_del_route", fb303::COUNT);
   fb303::fbData->addStatExportType(
       "fib.thrift.failure.keepalive", fb303::COUNT);
   fb303::fbData->addStatExportType("fib.thrift.failure.sync_fib", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "fib.thrift.failure.connection_lost", fb303::COUNT);
   fb303::fbData->addStatExportType("fib.route_programming.time_ms", fb303::AVG);
   fb303::fbData->addStatExportType("fib.route_sync.time_ms", fb303::AVG);
 }
 
+Fib::Backend::Backend(int32_t thriftPort)
+    : thriftPort(thriftPort),
+      expBackoff(
+          Constants::kFibSyncInitialBackoff,
+          Constants::kFibSyncMaxBackoff,
+          false),
+      retryRoutesBackoff(
+          Constants::kFibSyncInitialBackoff,
+          Constants::kFibSyncMaxBackoff,
+          false) {}
+
+void
+Fib::addBackend(int32_t port) {
+  auto& backend = *backends_.emplace_back(std::make_unique<Backend>(port));
+
+  backend.syncRoutesTimer =
+      folly::AsyncTimeout::make(*getEvb(), [this, &backend]() noexcept {
+        if (backend.numFibRequestsInFlight) {
+          // Let route programming in flight finish before the full sync, so
+          // that it can't land on top of the synced routes
+          backend.syncRoutesTimer->scheduleTimeout(
+              Constants::kFibSyncInitialBackoff);
+          return;
+        }
+        if (routeState_.hasRoutesFromDecision) {
+          if (syncRouteDb(backend)) {
+            // chunked sync schedules its next chunk until complete
+            if (not backend.syncRoutesTimer->isScheduled()) {
+              backend.hasSyncedFib = true;
+            }
+            backend.expBackoff.reportSuccess();
+          } else {
+            // Apply exponential backoff and schedule next run
+            backend.expBackoff.reportError();
+            const auto period = backend.expBackoff.getTimeRemainingUntilRetry();
+            LOG(INFO) << "Scheduling fib sync of agent on port "
+                      << backend.thriftPort << " after " << period.count()
+                      << "ms";
+            backend.syncRoutesTimer->scheduleTimeout(period);
+          }
+        }
+        bool isSynced{true};
+        for (auto const& other : backends_) {
+          isSynced &= not other->syncRoutesTimer->isScheduled();
+        }
+        fb303::fbData->setCounter("fib.synced", isSynced ? 1 : 0);
+      });
+
+  backend.retryRoutesTimer =
+      folly::AsyncTimeout::make(*getEvb(), [this, &backend]() noexcept {
+        // Replay after lost connection only if the agent still holds the
+        // routes programmed so far, else keepAliveCheck schedules a full sync
+        if (backend.checkAgentOnRetry) {
+          try {
+            keepAliveCheck(backend);
+          } catch (const std::exception& e) {
+            backend.client.reset();
+            LOG(ERROR) << "Failed to reconnect to Switch Agent on port "
+                       << backend.thriftPort
+                       << ". Error: " << folly::exceptionStr(e);
+            scheduleRetryRoutes(backend);
+            return;
+          }
+          backend.checkAgentOnRetry = false;
+        }
+        // Newer changes pending for the same prefix or label win
+        for (auto& [prefix, route] : backend.failedRoutes.unicastRoutes) {
+          backend.pendingRoutes.unicastRoutes.emplace(prefix, std::move(route));
+        }
+        for (auto& [topLabel, route] : backend.failedRoutes.mplsRoutes) {
+          backend.pendingRoutes.mplsRoutes.emplace(topLabel, std::move(route));
+        }
+        backend.failedRoutes = PendingRoutes();
+        programPendingRoutes(backend);
+      });
+}
+
 void
 Fib::stop() {
   // Stop KvStoreClient first
@@ -156,6 +400,14 @@ Fib::stop() {
     kvStoreClient_->stop();
   }
 
+  // Fail route programming in flight while Fib is still alive to handle it
+  getEvb()->runImmediatelyOrRunInEventBaseThreadAndWait([this]() {
+    for (auto& backend : backends_) {
+      backend->asyncClient.reset();
+      backend->asyncSocket.reset();
+    }
+  });
+
   // Invoke stop method of super class
   OpenrEventBase::stop();
 }
@@ -192,7 +444,7 @@ Fib::getRouteDb() {
     thrift::RouteDatabase routeDb;
     *routeDb.thisNodeName_ref() = myNodeName_;
     for (const auto& route : routeState_.unicastRoutes) {
-      routeDb.unicastRoutes_ref()->emplace_back(route.second);
+      routeDb.unicastRoutes_ref()->emplace_back(route.second.toThrift());
     }
     for (const auto& route : routeState_.mplsRoutes) {
       routeDb.mplsRoutes_ref()->emplace_back(route.second);
@@ -202,6 +454,68 @@ Fib::getRouteDb() {
   return sf;
 }
 
+folly::SemiFuture<std::unique_ptr<thrift::RouteDatabasePage>>
+Fib::getRouteDbPage(thrift::PageParams page) {
+  auto [p, sf] =
+      folly::makePromiseContract<std::unique_ptr<thrift::RouteDatabasePage>>();
+  runInEventBaseThread([p = std::move(p),
+                        page = std::move(page),
+                        this]() mutable {
+    // Prefix cursor is still within unicast routes, label cursor past them
+    std::optional<folly::CIDRNetwork> prefixCursor;
+    std::optional<uint32_t> labelCursor;
+    if (auto cursor = page.cursor_ref()) {
+      try {
+        if (cursor->find('/') != std::string::npos) {
+          prefixCursor = folly::IPAddress::createNetwork(*cursor);
+        } else {
+          labelCursor = folly::to<uint32_t>(*cursor);
+        }
+      } catch (std::exception const& e) {
+        p.setException(thrift::OpenrError(
+            folly::sformat("Invalid cursor {}: {}", *cursor, e.what())));
+        return;
+      }
+    }
+
+    auto routeDbPage = std::make_unique<thrift::RouteDatabasePage>();
+    auto& routeDb = *routeDbPage->routeDb_ref();
+    *routeDb.thisNodeName_ref() = myNodeName_;
+    size_t limit = std::max(0, *page.limit_ref());
+    if (not labelCursor.has_value()) {
+      auto const prefixes = getPageKeys<folly::CIDRNetwork>(
+          routeState_.unicastRoutes,
+          [](auto const& kv) -> folly::CIDRNetwork const& { return kv.first; },
+          prefixCursor,
+          limit);
+      for (auto const& prefix : prefixes) {
+        routeDb.unicastRoutes_ref()->emplace_back(
+            routeState_.unicastRoutes.at(prefix).toThrift());
+      }
+      if (prefixes.size() == limit and limit > 0) {
+        routeDbPage->nextCursor_ref() =
+            folly::IPAddress::networkToString(prefixes.back());
+        p.setValue(std::move(routeDbPage));
+        return;
+      }
+      limit -= prefixes.size();
+    }
+    auto const labels = getPageKeys<uint32_t>(
+        routeState_.mplsRoutes,
+        [](auto const& kv) -> uint32_t const& { return kv.first; },
+        labelCursor,
+        limit);
+    for (auto const& label : labels) {
+      routeDb.mplsRoutes_ref()->emplace_back(routeState_.mplsRoutes.at(label));
+    }
+    if (labels.size() == limit and limit > 0) {
+      routeDbPage->nextCursor_ref() = std::to_string(labels.back());
+    }
+    p.setValue(std::move(routeDbPage));
+  });
+  return std::move(sf);
+}
+
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
 Fib::getUnicastRoutes(std::vector<std::string> prefixes) {
   folly::Promise<std::unique_ptr<std::vector<thrift::UnicastRoute>>> p;
@@ -236,6 +550,34 @@ Fib::getPerfDb() {
   return sf;
 }
 
+folly::SemiFuture<folly::Unit>
+Fib::applyConfig(std::shared_ptr<const Config> config) {
+  folly::Promise<folly::Unit> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([p = std::move(p), config, this]() mutable {
+    fibSyncBatchSize_ = *config->getConfig().fib_sync_batch_size_ref();
+    fb303::fbData->setCounter("fib.config_version", config->getVersion());
+    p.setValue();
+  });
+  return sf;
+}
+
+folly::SemiFuture<folly::Unit>
+Fib::setMemoryPressure(MemoryPressure level) {
+  folly::Promise<folly::Unit> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([p = std::move(p), level, this]() mutable {
+    perfDbMaxSize_ = level == MemoryPressure::NONE
+        ? Constants::kPerfBufferSize - 1
+        : 1;
+    while (perfDb_.size() > perfDbMaxSize_) {
+      perfDb_.pop_front();
+    }
+    p.setValue();
+  });
+  return sf;
+}
+
 std::vector<thrift::UnicastRoute>
 Fib::getUnicastRoutesFiltered(std::vector<std::string> prefixes) {
   // return and send the vector<thrift::UnicastRoute>
@@ -246,7 +588,7 @@ Fib::getUnicastRoutesFiltered(std::vector<std::string> prefixes) {
   // if the params is empty, return all routes
   if (prefixes.empty()) {
     for (const auto& routes : routeState_.unicastRoutes) {
-      retRouteVec.emplace_back(routes.second);
+      retRouteVec.emplace_back(routes.second.toThrift());
     }
     return retRouteVec;
   }
@@ -264,7 +606,7 @@ Fib::getUnicastRoutesFiltered(std::vector<std::string> prefixes) {
 
     // do longest prefix match, add the matched prefix to the result set
     const auto& matchedPrefix =
-        Fib::longestPrefixMatch(inputPrefix, routeState_.unicastRoutes);
+        routeState_.unicastPrefixes.longestPrefixMatch(inputPrefix);
     if (matchedPrefix.has_value()) {
       matchPrefixSet.insert(matchedPrefix.value());
     }
@@ -272,7 +614,8 @@ Fib::getUnicastRoutesFiltered(std::vector<std::string> prefixes) {
 
   // get the routes from the prefix set
   for (const auto& prefix : matchPrefixSet) {
-    retRouteVec.emplace_back(routeState_.unicastRoutes.at(prefix));
+    retRouteVec.emplace_back(
+        routeState_.unicastRoutes.at(toIPNetwork(prefix)).toThrift());
   }
 
   return retRouteVec;
@@ -313,49 +656,119 @@ Fib::getFibUpdatesReader() {
 }
 
 void
-Fib::processRouteUpdates(thrift::RouteDatabaseDelta&& routeDelta) {
+Fib::processRouteUpdates(DecisionRouteUpdate&& routeUpdate) {
   routeState_.hasRoutesFromDecision = true;
   // Update perfEvents_ .. We replace existing perf events with new one as
   // convergence is going to be based on new data, not the old.
-  if (routeDelta.perfEvents_ref()) {
-    addPerfEvent(
-        *routeDelta.perfEvents_ref(), myNodeName_, "FIB_ROUTE_DB_RECVD");
+  if (routeUpdate.perfEvents) {
+    addPerfEvent(*routeUpdate.perfEvents, myNodeName_, "FIB_ROUTE_DB_RECVD");
   }
 
-  // Before anything, get rid of doNotInstall routes
-  auto i = routeDelta.unicastRoutesToUpdate_ref()->begin();
-  while (i != routeDelta.unicastRoutesToUpdate_ref()->end()) {
-    if (*i->doNotInstall_ref()) {
-      LOG(INFO) << "Not installing route for prefix " << toString(i->dest);
-      i = routeDelta.unicastRoutesToUpdate_ref()->erase(i);
-    } else {
-      ++i;
+  // Changes to program, in thrift form of the agent
+  thrift::RouteDatabaseDelta routeDelta;
+  routeDelta.perfEvents_ref().from_optional(std::move(routeUpdate.perfEvents));
+
+  // Changed routes are programmed again by chunked syncs in progress
+  auto const unsyncPrefix = [this](folly::CIDRNetwork const& prefix) {
+    for (auto& backend : backends_) {
+      backend->syncedPrefixes.erase(prefix);
     }
-  }
+  };
+  auto const unsyncLabel = [this](uint32_t topLabel) {
+    for (auto& backend : backends_) {
+      backend->syncedLabels.erase(topLabel);
+    }
+  };
 
-  // Add/Update unicast routes to update
-  for (const auto& route : *routeDelta.unicastRoutesToUpdate_ref()) {
-    routeState_.unicastRoutes[route.dest] = route;
-    routeState_.dirtyPrefixes.erase(route.dest);
+  // Routes whose programmed form is unchanged are only updated in state. A
+  // dirty route is programmed with shrunk next-hops and is never suppressed.
+  // Routes pending, in flight or failed are programmed with the same
+  // next-hops already, a full sync programs the updated state anyway.
+  size_t numSuppressed{0};
+
+  // Add/Update unicast routes to update, except doNotInstall ones
+  for (auto& [prefix, route] : routeUpdate.unicastRoutesToUpdate) {
+    if (route.doNotInstall) {
+      LOG(INFO) << "Not installing route for prefix "
+                << folly::IPAddress::networkToString(prefix);
+      continue;
+    }
+    auto it = routeState_.unicastRoutes.find(prefix);
+    if (it != routeState_.unicastRoutes.end()) {
+      if (not routeState_.dirtyPrefixes.count(prefix) and
+          isSameProgrammedRoute(it->second, route)) {
+        ++numSuppressed;
+      } else {
+        routeDelta.unicastRoutesToUpdate_ref()->emplace_back(route.toThrift());
+        routeState_.dirtyPrefixes.erase(prefix);
+        unsyncPrefix(prefix);
+      }
+      indexRoute(it->second, false);
+      it->second = std::move(route);
+    } else {
+      routeDelta.unicastRoutesToUpdate_ref()->emplace_back(route.toThrift());
+      it = routeState_.unicastRoutes.emplace(prefix, std::move(route)).first;
+      routeState_.unicastPrefixes.insert(
+          routeDelta.unicastRoutesToUpdate_ref()->back().dest);
+      unsyncPrefix(prefix);
+    }
+    indexRoute(it->second, true);
   }
 
   // Add mpls routes to update
-  for (const auto& route : *routeDelta.mplsRoutesToUpdate_ref()) {
-    routeState_.mplsRoutes[route.topLabel] = route;
-    routeState_.dirtyLabels.erase(route.topLabel);
+  for (const auto& entry : routeUpdate.mplsRoutesToUpdate) {
+    auto route = entry.toThrift();
+    auto it = routeState_.mplsRoutes.find(route.topLabel);
+    if (it != routeState_.mplsRoutes.end()) {
+      indexRoute(it->second, false);
+    }
+    indexRoute(route, true);
+    auto selectedNextHops = getSelectedMplsNextHops(*route.nextHops_ref());
+    auto& cachedNextHops = routeState_.mplsSelectedNextHops[route.topLabel];
+    if (it != routeState_.mplsRoutes.end() and
+        not routeState_.dirtyLabels.count(route.topLabel) and
+        cachedNextHops == selectedNextHops) {
+      ++numSuppressed;
+    } else {
+      routeState_.dirtyLabels.erase(route.topLabel);
+      unsyncLabel(route.topLabel);
+      routeDelta.mplsRoutesToUpdate_ref()->emplace_back(route);
+    }
+    cachedNextHops = std::move(selectedNextHops);
+    routeState_.mplsRoutes[route.topLabel] = std::move(route);
+  }
+  if (numSuppressed) {
+    fb303::fbData->addStatValue(
+        "fib.suppressed_route_updates", numSuppressed, fb303::SUM);
   }
 
   // Delete unicast routes
-  for (const auto& dest : *routeDelta.unicastRoutesToDelete_ref()) {
-    routeState_.unicastRoutes.erase(dest);
-    routeState_.dirtyPrefixes.erase(dest);
+  for (const auto& prefix : routeUpdate.unicastRoutesToDelete) {
+    auto it = routeState_.unicastRoutes.find(prefix);
+    if (it != routeState_.unicastRoutes.end()) {
+      indexRoute(it->second, false);
+      routeState_.unicastRoutes.erase(it);
+    }
+    auto dest = toIpPrefix(prefix);
+    routeState_.unicastPrefixes.erase(dest);
+    routeState_.dirtyPrefixes.erase(prefix);
+    unsyncPrefix(prefix);
+    routeDelta.unicastRoutesToDelete_ref()->emplace_back(std::move(dest));
   }
 
   // Delete mpls routes
-  for (const auto& topLabel : *routeDelta.mplsRoutesToDelete_ref()) {
-    routeState_.mplsRoutes.erase(topLabel);
+  for (const auto& topLabel : routeUpdate.mplsRoutesToDelete) {
+    auto it = routeState_.mplsRoutes.find(topLabel);
+    if (it != routeState_.mplsRoutes.end()) {
+      indexRoute(it->second, false);
+      routeState_.mplsRoutes.erase(it);
+    }
+    routeState_.mplsSelectedNextHops.erase(topLabel);
     routeState_.dirtyLabels.erase(topLabel);
+    unsyncLabel(topLabel);
   }
+  *routeDelta.mplsRoutesToDelete_ref() =
+      std::move(routeUpdate.mplsRoutesToDelete);
 
   // Add some counters
   fb303::fbData->addStatValue("fib.process_route_db", 1, fb303::COUNT);
@@ -364,20 +777,37 @@ Fib::processRouteUpdates(thrift::RouteDatabaseDelta&& routeDelta) {
 }
 
 void
-Fib::processInterfaceDb(thrift::InterfaceDatabase&& interfaceDb) {
+Fib::processInterfaceDb(InterfaceDatabaseUpdate&& update) {
   fb303::fbData->addStatValue("fib.process_interface_db", 1, fb303::COUNT);
 
-  if (interfaceDb.perfEvents_ref()) {
-    addPerfEvent(
-        *interfaceDb.perfEvents_ref(), myNodeName_, "FIB_INTF_DB_RECEIVED");
+  // Snapshot is shared with other readers, take a copy of perf events only
+  std::optional<thrift::PerfEvents> perfEvents;
+  if (update.snapshot->perfEvents_ref()) {
+    perfEvents = *update.snapshot->perfEvents_ref();
+    addPerfEvent(*perfEvents, myNodeName_, "FIB_INTF_DB_RECEIVED");
   }
 
   //
-  // Update interface states
+  // Update interface states. Without delta, all interfaces in snapshot are
+  // considered updated.
   //
-  for (auto const& kv : *interfaceDb.interfaces_ref()) {
-    const auto& ifName = kv.first;
-    const auto isUp = kv.second.isUp;
+  const auto& interfaces = *update.snapshot->interfaces_ref();
+  if (not update.isDelta) {
+    update.updatedInterfaces.clear();
+    for (auto const& kv : interfaces) {
+      update.updatedInterfaces.emplace_back(kv.first);
+    }
+  }
+  // Interfaces whose status changed, only routes over them are affected
+  std::vector<std::string> changedInterfaces;
+  for (auto const& ifName : update.removedInterfaces) {
+    if (interfaceStatusDb_.erase(ifName)) {
+      LOG(INFO) << "Interface " << ifName << " removed";
+      changedInterfaces.emplace_back(ifName);
+    }
+  }
+  for (auto const& ifName : update.updatedInterfaces) {
+    const auto isUp = interfaces.at(ifName).isUp;
     const auto wasUp = folly::get_default(interfaceStatusDb_, ifName, false);
 
     // UP -> DOWN transition
@@ -388,112 +818,268 @@ Fib::processInterfaceDb(thrift::InterfaceDatabase&& interfaceDb) {
     if (not wasUp and isUp) {
       LOG(INFO) << "Interface " << ifName << " transitioned from DOWN -> UP";
     }
+    if (wasUp != isUp) {
+      changedInterfaces.emplace_back(ifName);
+    }
 
     // Update new status
     interfaceStatusDb_[ifName] = isUp;
   }
 
   thrift::RouteDatabaseDelta routeDbDelta;
-  routeDbDelta.perfEvents_ref().move_from(interfaceDb.perfEvents_ref());
+  routeDbDelta.perfEvents_ref().from_optional(std::move(perfEvents));
 
-  //
-  // Compute unicast route changes
-  //
-  for (auto const& kv : routeState_.unicastRoutes) {
-    auto const& route = kv.second;
+  // Without delta all routes are re-evaluated
+  std::optional<std::vector<std::string>> ifNames;
+  if (update.isDelta) {
+    ifNames = std::move(changedInterfaces);
+  }
+  updateRoutesOverInterfaces(ifNames, routeDbDelta);
+
+  updateRoutes(routeDbDelta);
+}
 
-    // Find previous best nexthops
-    const auto& prevNextHops = *route.nextHops_ref();
+void
+Fib::processInterfaceStatusEvent(const InterfaceStatusEvent& event) {
+  fb303::fbData->addStatValue("fib.interface_status_events", 1, fb303::COUNT);
 
-    // Find valid nexthops for route
-    std::vector<thrift::NextHopThrift> validNextHops;
-    for (auto const& nextHop : *route.nextHops_ref()) {
-      const auto ifName = nextHop.address_ref()->ifName_ref();
-      if (not ifName.has_value() ||
-          (folly::get_default(interfaceStatusDb_, *ifName, false))) {
-        validNextHops.emplace_back(nextHop);
-      }
-    } // end for ... kv.second
-
-    // Remove route if no valid nexthops
-    if (not validNextHops.size()) {
-      VLOG(1) << "Removing prefix " << toString(route.dest)
-              << " because of no valid nextHops.";
-      routeDbDelta.unicastRoutesToDelete_ref()->emplace_back(*route.dest_ref());
-      routeState_.dirtyPrefixes.emplace(route.dest); // Mark prefix as dirty
-      continue; // Skip rest
-    }
-
-    if (validNextHops != prevNextHops) {
-      // Nexthop group shrink
-      VLOG(1) << "bestPaths group resize for prefix: " << toString(route.dest)
-              << ", old: " << prevNextHops.size()
-              << ", new: " << validNextHops.size();
-      thrift::UnicastRoute newRoute;
-      newRoute.dest = route.dest;
-      *newRoute.nextHops_ref() = std::move(validNextHops);
-      routeDbDelta.unicastRoutesToUpdate_ref()->emplace_back(
-          std::move(newRoute));
-      routeState_.dirtyPrefixes.emplace(route.dest); // Mark prefix as dirty
-    } else if (routeState_.dirtyPrefixes.count(route.dest)) {
-      // Nexthop group restore - previously best
-      routeDbDelta.unicastRoutesToUpdate_ref()->emplace_back(route);
-      routeState_.dirtyPrefixes.erase(route.dest); // Remove from dirty list
-    }
-  } // end for ... routeDb_.unicastRoutes
+  const auto wasUp =
+      folly::get_default(interfaceStatusDb_, event.ifName, false);
+  if (wasUp == event.isUp) {
+    return;
+  }
+  LOG(INFO) << "Interface " << event.ifName << " transitioned from "
+            << (event.isUp ? "DOWN -> UP" : "UP -> DOWN")
+            << " ahead of interface database";
+  interfaceStatusDb_[event.ifName] = event.isUp;
 
-  //
-  // Compute MPLS route changes
-  //
-  for (const auto& kv : routeState_.mplsRoutes) {
-    const auto& route = kv.second;
-
-    // Find valid nexthops for route
-    std::vector<thrift::NextHopThrift> validNextHops;
-    for (auto const& nextHop : *route.nextHops_ref()) {
-      // We don't have ifName for `POP_AND_LOOKUP` mpls action
-      auto const ifName = nextHop.address_ref()->ifName_ref();
-      if (not ifName.has_value() or
+  thrift::RouteDatabaseDelta routeDbDelta;
+  updateRoutesOverInterfaces(
+      std::vector<std::string>{event.ifName}, routeDbDelta);
+  if (routeDbDelta.unicastRoutesToUpdate_ref()->empty() and
+      routeDbDelta.unicastRoutesToDelete_ref()->empty() and
+      routeDbDelta.mplsRoutesToUpdate_ref()->empty() and
+      routeDbDelta.mplsRoutesToDelete_ref()->empty()) {
+    return;
+  }
+  updateRoutes(routeDbDelta);
+}
+
+void
+Fib::updateRoutesOverInterfaces(
+    std::optional<std::vector<std::string>> const& ifNames,
+    thrift::RouteDatabaseDelta& routeDbDelta) {
+  if (not ifNames.has_value()) {
+    for (auto const& kv : routeState_.unicastRoutes) {
+      updateRouteNextHops(kv.second, routeDbDelta);
+    }
+    for (auto const& kv : routeState_.mplsRoutes) {
+      updateRouteNextHops(kv.second, routeDbDelta);
+    }
+    return;
+  }
+
+  // Route over several of the interfaces is evaluated once
+  std::unordered_set<folly::CIDRNetwork> prefixes;
+  std::unordered_set<uint32_t> labels;
+  for (auto const& ifName : *ifNames) {
+    auto prefixesIt = routeState_.ifNameToPrefixes.find(ifName);
+    if (prefixesIt != routeState_.ifNameToPrefixes.end()) {
+      prefixes.insert(prefixesIt->second.begin(), prefixesIt->second.end());
+    }
+    auto labelsIt = routeState_.ifNameToLabels.find(ifName);
+    if (labelsIt != routeState_.ifNameToLabels.end()) {
+      labels.insert(labelsIt->second.begin(), labelsIt->second.end());
+    }
+  }
+  for (auto const& prefix : prefixes) {
+    updateRouteNextHops(routeState_.unicastRoutes.at(prefix), routeDbDelta);
+  }
+  for (auto const& label : labels) {
+    updateRouteNextHops(routeState_.mplsRoutes.at(label), routeDbDelta);
+  }
+}
+
+void
+Fib::updateRouteNextHops(
+    const RibUnicastEntry& route, thrift::RouteDatabaseDelta& routeDbDelta) {
+  // Find valid nexthops for route
+  std::vector<thrift::NextHopThrift> validNextHops;
+  for (auto const& nextHop : route.nexthops) {
+    const auto ifName = nextHop.address_ref()->ifName_ref();
+    if (not ifName.has_value() ||
+        (folly::get_default(interfaceStatusDb_, *ifName, false))) {
+      validNextHops.emplace_back(nextHop);
+    }
+  }
+
+  // Switch to loop-free alternates precomputed by Decision, if any is up,
+  // until routes get recomputed
+  bool isBackup{false};
+  if (validNextHops.empty() and not route.backupNexthops.empty()) {
+    for (auto const& nextHop : route.backupNexthops) {
+      const auto ifName = nextHop.address_ref()->ifName_ref();
+      if (ifName.has_value() and
           folly::get_default(interfaceStatusDb_, *ifName, false)) {
         validNextHops.emplace_back(nextHop);
       }
     }
+    if (not validNextHops.empty()) {
+      isBackup = true;
+      VLOG(1) << "Switching prefix "
+              << folly::IPAddress::networkToString(route.prefix) << " to "
+              << validNextHops.size() << " backup nextHops.";
+      fb303::fbData->addStatValue(
+          "fib.lfa_backup_activations", 1, fb303::COUNT);
+    }
+  }
 
-    // Find previous best nexthops
-    auto prevBestNextHops = selectMplsNextHops(*route.nextHops_ref());
+  // Remove route if no valid nexthops
+  if (not validNextHops.size()) {
+    VLOG(1) << "Removing prefix "
+            << folly::IPAddress::networkToString(route.prefix)
+            << " because of no valid nextHops.";
+    routeDbDelta.unicastRoutesToDelete_ref()->emplace_back(
+        toIpPrefix(route.prefix));
+    routeState_.dirtyPrefixes.emplace(route.prefix); // Mark prefix as dirty
+    return; // Skip rest
+  }
 
-    // Find new valid best nexthops
-    auto validBestNextHops = selectMplsNextHops(validNextHops);
+  // Valid nexthops are a subset of nexthops unless backups are used
+  if (isBackup or validNextHops.size() != route.nexthops.size()) {
+    // Nexthop group shrink
+    VLOG(1) << "bestPaths group resize for prefix: "
+            << folly::IPAddress::networkToString(route.prefix)
+            << ", old: " << route.nexthops.size()
+            << ", new: " << validNextHops.size();
+    thrift::UnicastRoute newRoute;
+    newRoute.dest = toIpPrefix(route.prefix);
+    *newRoute.nextHops_ref() = std::move(validNextHops);
+    routeDbDelta.unicastRoutesToUpdate_ref()->emplace_back(std::move(newRoute));
+    routeState_.dirtyPrefixes.emplace(route.prefix); // Mark prefix as dirty
+  } else if (routeState_.dirtyPrefixes.count(route.prefix)) {
+    // Nexthop group restore - previously best
+    routeDbDelta.unicastRoutesToUpdate_ref()->emplace_back(route.toThrift());
+    routeState_.dirtyPrefixes.erase(route.prefix); // Remove from dirty list
+  }
+}
 
-    // Remove route if no valid nexthops
-    if (not validBestNextHops.size()) {
-      VLOG(1) << "Removing label route " << *route.topLabel_ref()
-              << " because of no valid nextHops.";
-      routeDbDelta.mplsRoutesToDelete_ref()->emplace_back(
-          *route.topLabel_ref());
-      routeState_.dirtyLabels.emplace(*route.topLabel_ref()); // Mark prefix as
-                                                              // dirty
-      continue; // Skip rest
+void
+Fib::updateRouteNextHops(
+    const thrift::MplsRoute& route, thrift::RouteDatabaseDelta& routeDbDelta) {
+  // Find valid nexthops for route
+  std::vector<thrift::NextHopThrift> validNextHops;
+  for (auto const& nextHop : *route.nextHops_ref()) {
+    // We don't have ifName for `POP_AND_LOOKUP` mpls action
+    auto const ifName = nextHop.address_ref()->ifName_ref();
+    if (not ifName.has_value() or
+        folly::get_default(interfaceStatusDb_, *ifName, false)) {
+      validNextHops.emplace_back(nextHop);
     }
+  }
+
+  // Find previous best nexthops
+  auto const& prevBestNextHops =
+      routeState_.mplsSelectedNextHops.at(*route.topLabel_ref());
+
+  // Find new valid best nexthops, selection is unchanged if all are valid
+  auto validBestNextHops = validNextHops.size() == route.nextHops_ref()->size()
+      ? prevBestNextHops
+      : getSelectedMplsNextHops(validNextHops);
+
+  // Remove route if no valid nexthops
+  if (not validBestNextHops.size()) {
+    VLOG(1) << "Removing label route " << *route.topLabel_ref()
+            << " because of no valid nextHops.";
+    routeDbDelta.mplsRoutesToDelete_ref()->emplace_back(*route.topLabel_ref());
+    routeState_.dirtyLabels.emplace(*route.topLabel_ref()); // Mark as dirty
+    return; // Skip rest
+  }
+
+  if (validBestNextHops != prevBestNextHops) {
+    // Nexthop group shrink
+    VLOG(1) << "bestPaths group resize for label: " << route.topLabel
+            << ", old: " << prevBestNextHops.size()
+            << ", new: " << validBestNextHops.size();
+    thrift::MplsRoute newRoute;
+    newRoute.topLabel = route.topLabel;
+    *newRoute.nextHops_ref() = std::move(validBestNextHops);
+    routeDbDelta.mplsRoutesToUpdate_ref()->emplace_back(std::move(newRoute));
+    routeState_.dirtyLabels.emplace(route.topLabel);
+  } else if (routeState_.dirtyLabels.count(route.topLabel)) {
+    // Nexthop group restore - previously best
+    routeDbDelta.mplsRoutesToUpdate_ref()->emplace_back(route);
+    routeState_.dirtyLabels.erase(route.topLabel); // Remove from dirty list
+  }
+}
 
-    if (validBestNextHops != prevBestNextHops) {
-      // Nexthop group shrink
-      VLOG(1) << "bestPaths group resize for label: " << route.topLabel
-              << ", old: " << prevBestNextHops.size()
-              << ", new: " << validBestNextHops.size();
-      thrift::MplsRoute newRoute;
-      newRoute.topLabel = route.topLabel;
-      *newRoute.nextHops_ref() = std::move(validBestNextHops);
-      routeDbDelta.mplsRoutesToUpdate_ref()->emplace_back(std::move(newRoute));
-      routeState_.dirtyLabels.emplace(route.topLabel);
-    } else if (routeState_.dirtyLabels.count(route.topLabel)) {
-      // Nexthop group restore - previously best
-      routeDbDelta.mplsRoutesToUpdate_ref()->emplace_back(route);
-      routeState_.dirtyLabels.erase(route.topLabel); // Remove from dirty list
+void
+Fib::indexRoute(const RibUnicastEntry& route, bool add) {
+  updateInterfaceIndex(
+      routeState_.ifNameToPrefixes, route.prefix, route.nexthops, add);
+  updateInterfaceIndex(
+      routeState_.ifNameToPrefixes, route.prefix, route.backupNexthops, add);
+
+  // estimate memory held by the route, counting the hash node and heap
+  // allocations of the entry, and its next-hop groups on first reference
+  auto getNextHopsHeapBytes = [this, add](NextHopSet const& nextHops) {
+    size_t bytes{0};
+    if (nextHops.empty()) {
+      return bytes;
+    }
+    auto& refs = routeState_.nextHopGroupRefs[nextHops.id()];
+    if (add ? refs++ == 0 : --refs == 0) {
+      for (auto const& nextHop : nextHops) {
+        bytes += kHashNodeBytes + sizeof(nextHop) + getHeapBytes(nextHop);
+      }
+    }
+    if (refs == 0) {
+      routeState_.nextHopGroupRefs.erase(nextHops.id());
     }
-  } // end for ... routeDb_.mplsRoutes
+    return bytes;
+  };
+  const size_t bytes = kHashNodeBytes +
+      sizeof(std::pair<const folly::CIDRNetwork, RibUnicastEntry>) +
+      getHeapBytes(route.bestPrefixEntry) + getHeapBytes(route.bestArea) +
+      getNextHopsHeapBytes(route.nexthops) +
+      getNextHopsHeapBytes(route.backupNexthops);
+  const int64_t numBgpRoutes = hasBgpData(route) ? 1 : 0;
+  if (add) {
+    routeState_.routeStateBytes += bytes;
+    routeState_.numBgpRoutes += numBgpRoutes;
+  } else {
+    routeState_.routeStateBytes -= bytes;
+    routeState_.numBgpRoutes -= numBgpRoutes;
+  }
+}
 
-  updateRoutes(routeDbDelta);
+void
+Fib::indexRoute(const thrift::MplsRoute& route, bool add) {
+  updateInterfaceIndex(
+      routeState_.ifNameToLabels,
+      static_cast<uint32_t>(route.topLabel),
+      *route.nextHops_ref(),
+      add);
+
+  const size_t bytes = kHashNodeBytes +
+      sizeof(std::pair<const uint32_t, thrift::MplsRoute>) +
+      getHeapBytes(route);
+  if (add) {
+    routeState_.routeStateBytes += bytes;
+  } else {
+    routeState_.routeStateBytes -= bytes;
+  }
+}
+
+thrift::MplsRoute
+Fib::getMplsRouteToProgram(const thrift::MplsRoute& route) const {
+  auto const label = static_cast<uint32_t>(*route.topLabel_ref());
+  auto it = routeState_.mplsSelectedNextHops.find(label);
+  if (it == routeState_.mplsSelectedNextHops.end() or
+      routeState_.dirtyLabels.count(label)) {
+    return createMplsRoute(label, selectMplsNextHops(*route.nextHops_ref()));
+  }
+  return createMplsRoute(label, it->second);
 }
 
 thrift::PerfDatabase
@@ -540,18 +1126,15 @@ Fib::printMplsRoutesAddUpdate(
 
 void
 Fib::updateRoutes(const thrift::RouteDatabaseDelta& routeDbDelta) {
-  SCOPE_EXIT {
-    updateRoutesSemaphore_.signal(); // Release when this function returns
-  };
-  updateRoutesSemaphore_.wait();
-
   // update flat counters here as they depend on routeState_ and its change
   updateGlobalCounters();
 
   // Only for backward compatibility
-  auto const& unicastRoutesToUpdate = *routeDbDelta.unicastRoutesToUpdate_ref();
-  auto const& mplsRoutesToUpdate = createMplsRoutesWithSelectedNextHops(
-      *routeDbDelta.mplsRoutesToUpdate_ref());
+  std::vector<thrift::MplsRoute> mplsRoutesToUpdate;
+  mplsRoutesToUpdate.reserve(routeDbDelta.mplsRoutesToUpdate_ref()->size());
+  for (auto const& route : *routeDbDelta.mplsRoutesToUpdate_ref()) {
+    mplsRoutesToUpdate.emplace_back(getMplsRouteToProgram(route));
+  }
 
   if (dryrun_) {
     // Do not program routes in case of dryrun
@@ -571,44 +1154,189 @@ Fib::updateRoutes(const thrift::RouteDatabaseDelta& routeDbDelta) {
     fibUpdatesQueue_.push(routeDbDelta);
   }
 
-  if (syncRoutesTimer_->isScheduled()) {
+  for (auto& backend : backends_) {
+    updateRoutes(*backend, routeDbDelta, mplsRoutesToUpdate);
+  }
+}
+
+void
+Fib::updateRoutes(
+    Backend& backend,
+    const thrift::RouteDatabaseDelta& routeDbDelta,
+    const std::vector<thrift::MplsRoute>& mplsRoutesToUpdate) {
+  if (backend.syncRoutesTimer->isScheduled()) {
     // Check if there's any full sync scheduled,
     // if so, skip partial sync
     LOG(INFO) << "Pending full sync is scheduled, skip delta sync for now...";
     return;
-  } else if (routeState_.dirtyRouteDb or not hasSyncedFib_) {
-    if (hasSyncedFib_) {
+  } else if (backend.dirtyRouteDb or not backend.hasSyncedFib) {
+    if (backend.hasSyncedFib) {
       LOG(INFO) << "Previous route programming failed or, skip delta sync to "
                 << "enforce full fib sync...";
     } else {
       LOG(INFO) << "Syncing fib on startup...";
     }
-    syncRouteDbDebounced();
+    syncRouteDbDebounced(backend);
     return;
   }
 
-  // Make thrift calls to do real programming
+  // Coalesce changes with the ones not yet sent, latest change of a prefix or
+  // label wins
+  auto& pendingRoutes = backend.pendingRoutes;
+  auto& failedRoutes = backend.failedRoutes;
+  for (auto const& prefix : *routeDbDelta.unicastRoutesToDelete_ref()) {
+    pendingRoutes.unicastRoutes[prefix] = std::nullopt;
+    failedRoutes.unicastRoutes.erase(prefix);
+  }
+  for (auto const& route : *routeDbDelta.unicastRoutesToUpdate_ref()) {
+    pendingRoutes.unicastRoutes[*route.dest_ref()] = route;
+    failedRoutes.unicastRoutes.erase(*route.dest_ref());
+  }
+  if (enableSegmentRouting_) {
+    for (auto const& topLabel : *routeDbDelta.mplsRoutesToDelete_ref()) {
+      pendingRoutes.mplsRoutes[topLabel] = std::nullopt;
+      failedRoutes.mplsRoutes.erase(topLabel);
+    }
+    for (auto const& route : mplsRoutesToUpdate) {
+      pendingRoutes.mplsRoutes[*route.topLabel_ref()] = route;
+      failedRoutes.mplsRoutes.erase(*route.topLabel_ref());
+    }
+  }
+  if (routeDbDelta.perfEvents_ref() and not pendingRoutes.perfEvents) {
+    pendingRoutes.perfEvents = *routeDbDelta.perfEvents_ref();
+  }
+
+  programPendingRoutes(backend);
+}
+
+void
+Fib::programPendingRoutes(Backend& backend) {
+  auto& pendingRoutes = backend.pendingRoutes;
+  while (backend.numFibRequestsInFlight < Constants::kMaxFibRequestsInFlight) {
+    // Full sync will program everything, let it handle pending changes
+    if (backend.dirtyRouteDb or backend.syncRoutesTimer->isScheduled()) {
+      return;
+    }
+
+    thrift::RouteDatabaseDelta routeDbDelta;
+    for (auto it = pendingRoutes.unicastRoutes.begin();
+         it != pendingRoutes.unicastRoutes.end();) {
+      if (backend.inFlightPrefixes.count(it->first)) {
+        ++it;
+        continue;
+      }
+      if (it->second.has_value()) {
+        routeDbDelta.unicastRoutesToUpdate_ref()->emplace_back(
+            std::move(it->second).value());
+      } else {
+        routeDbDelta.unicastRoutesToDelete_ref()->emplace_back(it->first);
+      }
+      backend.inFlightPrefixes.emplace(it->first);
+      it = pendingRoutes.unicastRoutes.erase(it);
+    }
+    for (auto it = pendingRoutes.mplsRoutes.begin();
+         it != pendingRoutes.mplsRoutes.end();) {
+      if (backend.inFlightLabels.count(it->first)) {
+        ++it;
+        continue;
+      }
+      if (it->second.has_value()) {
+        routeDbDelta.mplsRoutesToUpdate_ref()->emplace_back(
+            std::move(it->second).value());
+      } else {
+        routeDbDelta.mplsRoutesToDelete_ref()->emplace_back(it->first);
+      }
+      backend.inFlightLabels.emplace(it->first);
+      it = pendingRoutes.mplsRoutes.erase(it);
+    }
+
+    if (routeDbDelta.unicastRoutesToUpdate_ref()->empty() and
+        routeDbDelta.unicastRoutesToDelete_ref()->empty() and
+        routeDbDelta.mplsRoutesToUpdate_ref()->empty() and
+        routeDbDelta.mplsRoutesToDelete_ref()->empty()) {
+      // nothing left or everything left waits on requests in flight
+      return;
+    }
+
+    if (pendingRoutes.perfEvents.has_value()) {
+      routeDbDelta.perfEvents_ref() =
+          std::move(pendingRoutes.perfEvents).value();
+      pendingRoutes.perfEvents.reset();
+    }
+    programRoutes(backend, std::move(routeDbDelta));
+  }
+}
+
+void
+Fib::programRoutes(
+    Backend& backend, thrift::RouteDatabaseDelta&& routeDbDelta) {
+  if (routeDbDelta.perfEvents_ref()) {
+    addPerfEvent(
+        *routeDbDelta.perfEvents_ref(), myNodeName_, "FIB_ROUTES_SENT");
+  }
+
+  const auto startTime = std::chrono::steady_clock::now();
+  auto futures = sendRoutes(backend, routeDbDelta);
+  ++backend.numFibRequestsInFlight;
+#if FOLLY_HAS_COROUTINES
+  addCoroTaskFuture(awaitProgramRoutes(
+      backend, std::move(futures), std::move(routeDbDelta), startTime));
+#else
+  folly::collectAll(std::move(futures))
+      .via(getEvb())
+      .thenValue([this,
+                  &backend,
+                  routeDbDelta = std::move(routeDbDelta),
+                  startTime](std::vector<folly::Try<folly::Unit>>&& results) {
+        processProgramRoutesResults(backend, routeDbDelta, startTime, results);
+      });
+#endif
+}
+
+#if FOLLY_HAS_COROUTINES
+folly::coro::Task<void>
+Fib::awaitProgramRoutes(
+    Backend& backend,
+    std::vector<folly::SemiFuture<folly::Unit>> futures,
+    thrift::RouteDatabaseDelta routeDbDelta,
+    std::chrono::steady_clock::time_point startTime) {
+  auto results = co_await folly::collectAll(std::move(futures));
+  processProgramRoutesResults(backend, routeDbDelta, startTime, results);
+}
+#endif
+
+std::vector<folly::SemiFuture<folly::Unit>>
+Fib::sendRoutes(
+    Backend& backend, thrift::RouteDatabaseDelta const& routeDbDelta) {
+  auto const& unicastRoutesToUpdate = *routeDbDelta.unicastRoutesToUpdate_ref();
+  auto const& unicastRoutesToDelete = *routeDbDelta.unicastRoutesToDelete_ref();
+  auto const& mplsRoutesToUpdate = *routeDbDelta.mplsRoutesToUpdate_ref();
+  auto const& mplsRoutesToDelete = *routeDbDelta.mplsRoutesToDelete_ref();
+
+  // Make thrift calls to do real programming. Prefixes and labels of a batch
+  // are disjoint so its requests need no ordering among each other.
+  std::vector<folly::SemiFuture<folly::Unit>> futures;
   try {
     LOG(INFO) << "Updating routes in FIB";
-    const auto startTime = std::chrono::steady_clock::now();
-    uint32_t numOfRouteUpdates = 0;
 
     // Create FIB client if doesn't exists
-    createFibClient(evb_, socket_, client_, thriftPort_);
+    createFibClient(
+        *getEvb(),
+        backend.asyncSocket,
+        backend.asyncClient,
+        backend.thriftPort);
 
     // Delete unicast routes
-    if (routeDbDelta.unicastRoutesToDelete_ref()->size()) {
-      LOG(INFO) << "Deleting "
-                << routeDbDelta.unicastRoutesToDelete_ref()->size()
+    if (unicastRoutesToDelete.size()) {
+      LOG(INFO) << "Deleting " << unicastRoutesToDelete.size()
                 << " unicast routes in FIB";
 
-      for (auto const& prefix : *routeDbDelta.unicastRoutesToDelete_ref()) {
+      for (auto const& prefix : unicastRoutesToDelete) {
         VLOG(1) << "> " << toString(prefix);
       }
 
-      numOfRouteUpdates += routeDbDelta.unicastRoutesToDelete_ref()->size();
-      client_->sync_deleteUnicastRoutes(
-          kFibId_, *routeDbDelta.unicastRoutesToDelete_ref());
+      futures.emplace_back(backend.asyncClient->semifuture_deleteUnicastRoutes(
+          kFibId_, unicastRoutesToDelete));
     }
 
     // Add unicast routes
@@ -618,64 +1346,250 @@ Fib::updateRoutes(const thrift::RouteDatabaseDelta& routeDbDelta) {
 
       printUnicastRoutesAddUpdate(unicastRoutesToUpdate);
 
-      numOfRouteUpdates += unicastRoutesToUpdate.size();
-      client_->sync_addUnicastRoutes(kFibId_, unicastRoutesToUpdate);
+      futures.emplace_back(backend.asyncClient->semifuture_addUnicastRoutes(
+          kFibId_, unicastRoutesToUpdate));
     }
 
     // Delete mpls routes
-    if (enableSegmentRouting_ &&
-        routeDbDelta.mplsRoutesToDelete_ref()->size()) {
-      LOG(INFO) << "Deleting " << routeDbDelta.mplsRoutesToDelete_ref()->size()
+    if (mplsRoutesToDelete.size()) {
+      LOG(INFO) << "Deleting " << mplsRoutesToDelete.size()
                 << " mpls routes in FIB";
 
-      for (auto const& topLabel : *routeDbDelta.mplsRoutesToDelete_ref()) {
+      for (auto const& topLabel : mplsRoutesToDelete) {
         VLOG(1) << "> " << std::to_string(topLabel);
       }
 
-      numOfRouteUpdates += routeDbDelta.mplsRoutesToDelete_ref()->size();
-      client_->sync_deleteMplsRoutes(
-          kFibId_, *routeDbDelta.mplsRoutesToDelete_ref());
+      futures.emplace_back(backend.asyncClient->semifuture_deleteMplsRoutes(
+          kFibId_, mplsRoutesToDelete));
     }
 
     // Add mpls routes
-    if (enableSegmentRouting_ && mplsRoutesToUpdate.size()) {
-      numOfRouteUpdates += mplsRoutesToUpdate.size();
+    if (mplsRoutesToUpdate.size()) {
       LOG(INFO) << "Adding/Updating " << mplsRoutesToUpdate.size()
                 << " mpls routes in FIB";
 
       printMplsRoutesAddUpdate(mplsRoutesToUpdate);
 
-      client_->sync_addMplsRoutes(kFibId_, mplsRoutesToUpdate);
+      futures.emplace_back(backend.asyncClient->semifuture_addMplsRoutes(
+          kFibId_, mplsRoutesToUpdate));
     }
+  } catch (const std::exception& e) {
+    futures.emplace_back(folly::makeSemiFuture<folly::Unit>(
+        folly::exception_wrapper{std::current_exception(), e}));
+  }
 
-    const auto elapsedTime =
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::steady_clock::now() - startTime);
-    LOG(INFO) << "It took " << elapsedTime.count() << "ms to update "
-              << "routes in FIB";
+  return futures;
+}
 
-    routeState_.dirtyRouteDb = false;
-    fb303::fbData->addStatValue(
-        "fib.route_programming.time_ms", elapsedTime.count(), fb303::AVG);
-    fb303::fbData->addStatValue(
-        "fib.num_of_route_updates", numOfRouteUpdates, fb303::SUM);
-  } catch (const std::exception& e) {
+void
+Fib::processProgramRoutesResults(
+    Backend& backend,
+    thrift::RouteDatabaseDelta const& routeDbDelta,
+    std::chrono::steady_clock::time_point startTime,
+    std::vector<folly::Try<folly::Unit>> const& results) {
+  --backend.numFibRequestsInFlight;
+  for (auto const& route : *routeDbDelta.unicastRoutesToUpdate_ref()) {
+    backend.inFlightPrefixes.erase(*route.dest_ref());
+  }
+  for (auto const& prefix : *routeDbDelta.unicastRoutesToDelete_ref()) {
+    backend.inFlightPrefixes.erase(prefix);
+  }
+  for (auto const& route : *routeDbDelta.mplsRoutesToUpdate_ref()) {
+    backend.inFlightLabels.erase(*route.topLabel_ref());
+  }
+  for (auto const& topLabel : *routeDbDelta.mplsRoutesToDelete_ref()) {
+    backend.inFlightLabels.erase(topLabel);
+  }
+
+  bool isConnectionLost{false};
+  for (auto const& result : results) {
+    if (not result.hasException()) {
+      continue;
+    }
+    // Only some routes of the batch failed, retry just them
+    using FibUpdateError = thrift::PlatformFibUpdateError;
+    if (auto const* error =
+            result.exception().get_exception<FibUpdateError>()) {
+      holdFailedRoutes(backend, routeDbDelta, *error);
+      continue;
+    }
+    // Agent may or may not have applied the request, replay it
+    using TTransportException = apache::thrift::transport::TTransportException;
+    if (result.exception().is_compatible_with<TTransportException>()) {
+      isConnectionLost = true;
+      continue;
+    }
     fb303::fbData->addStatValue(
         "fib.thrift.failure.add_del_route", 1, fb303::COUNT);
-    client_.reset();
-    routeState_.dirtyRouteDb = true;
-    syncRouteDbDebounced(); // Schedule future full sync of route DB
-    LOG(ERROR) << "Failed to update routes in FIB. Error: "
-               << folly::exceptionStr(e);
+    backend.asyncClient.reset();
+    backend.dirtyRouteDb = true;
+    syncRouteDbDebounced(backend); // Schedule future full sync of route DB
+    LOG(ERROR) << "Failed to update routes in FIB on port "
+               << backend.thriftPort
+               << ". Error: " << result.exception().what();
+    return;
+  }
+  if (isConnectionLost) {
+    holdUnackedRoutes(backend, routeDbDelta);
+    return;
+  }
+  if (backend.failedRoutes.unicastRoutes.empty() and
+      backend.failedRoutes.mplsRoutes.empty()) {
+    backend.retryRoutesBackoff.reportSuccess();
+  }
+
+  const uint32_t numOfRouteUpdates =
+      routeDbDelta.unicastRoutesToUpdate_ref()->size() +
+      routeDbDelta.unicastRoutesToDelete_ref()->size() +
+      routeDbDelta.mplsRoutesToUpdate_ref()->size() +
+      routeDbDelta.mplsRoutesToDelete_ref()->size();
+  const auto elapsedTime =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - startTime);
+  LOG(INFO) << "It took " << elapsedTime.count() << "ms to update "
+            << "routes in FIB";
+
+  fb303::fbData->addStatValue(
+      "fib.route_programming.time_ms", elapsedTime.count(), fb303::AVG);
+  fb303::fbData->addStatValue(
+      "fib.num_of_route_updates", numOfRouteUpdates, fb303::SUM);
+  // Convergence is reported once, as programmed by the primary agent
+  if (&backend == backends_.front().get()) {
+    logPerfEvents(castToStd(routeDbDelta.perfEvents_ref()));
+  }
+
+  // send changes held back by this request
+  programPendingRoutes(backend);
+}
+
+void
+Fib::holdFailedRoutes(
+    Backend& backend,
+    thrift::RouteDatabaseDelta const& routeDbDelta,
+    thrift::PlatformFibUpdateError const& error) {
+  fb303::fbData->addStatValue(
+      "fib.thrift.failure.partial_add_del_route", 1, fb303::COUNT);
+  LOG(ERROR) << "Failed to update some routes in FIB. Add/Update: "
+             << error.failedAddUpdatePrefixes_ref()->size() << " unicast, "
+             << error.failedAddUpdateMplsLabels_ref()->size()
+             << " mpls. Delete: " << error.failedDeletePrefixes_ref()->size()
+             << " unicast, " << error.failedDeleteMplsLabels_ref()->size()
+             << " mpls";
+
+  auto& failedRoutes = backend.failedRoutes;
+  auto const& pendingRoutes = backend.pendingRoutes;
+  // Changes already pending for the same prefix or label supersede failed ones
+  const std::unordered_set<thrift::IpPrefix> failedPrefixes(
+      error.failedAddUpdatePrefixes_ref()->begin(),
+      error.failedAddUpdatePrefixes_ref()->end());
+  for (auto const& route : *routeDbDelta.unicastRoutesToUpdate_ref()) {
+    if (failedPrefixes.count(*route.dest_ref()) and
+        not pendingRoutes.unicastRoutes.count(*route.dest_ref())) {
+      failedRoutes.unicastRoutes.insert_or_assign(*route.dest_ref(), route);
+    }
+  }
+  for (auto const& prefix : *error.failedDeletePrefixes_ref()) {
+    if (not pendingRoutes.unicastRoutes.count(prefix)) {
+      failedRoutes.unicastRoutes.insert_or_assign(prefix, std::nullopt);
+    }
+  }
+  const std::unordered_set<int32_t> failedLabels(
+      error.failedAddUpdateMplsLabels_ref()->begin(),
+      error.failedAddUpdateMplsLabels_ref()->end());
+  for (auto const& route : *routeDbDelta.mplsRoutesToUpdate_ref()) {
+    if (failedLabels.count(*route.topLabel_ref()) and
+        not pendingRoutes.mplsRoutes.count(*route.topLabel_ref())) {
+      failedRoutes.mplsRoutes.insert_or_assign(*route.topLabel_ref(), route);
+    }
+  }
+  for (auto const& topLabel : *error.failedDeleteMplsLabels_ref()) {
+    if (not pendingRoutes.mplsRoutes.count(topLabel)) {
+      failedRoutes.mplsRoutes.insert_or_assign(topLabel, std::nullopt);
+    }
+  }
+  scheduleRetryRoutes(backend);
+}
+
+void
+Fib::holdUnackedRoutes(
+    Backend& backend, thrift::RouteDatabaseDelta const& routeDbDelta) {
+  fb303::fbData->addStatValue(
+      "fib.thrift.failure.connection_lost", 1, fb303::COUNT);
+  LOG(ERROR) << "Lost connection to Switch Agent on port "
+             << backend.thriftPort
+             << " while updating routes in FIB, replaying them after reconnect";
+  backend.asyncClient.reset();
+  backend.checkAgentOnRetry = true;
+
+  auto& failedRoutes = backend.failedRoutes;
+  auto const& pendingRoutes = backend.pendingRoutes;
+  // Changes already pending for the same prefix or label supersede these
+  for (auto const& route : *routeDbDelta.unicastRoutesToUpdate_ref()) {
+    if (not pendingRoutes.unicastRoutes.count(*route.dest_ref())) {
+      failedRoutes.unicastRoutes.insert_or_assign(*route.dest_ref(), route);
+    }
+  }
+  for (auto const& prefix : *routeDbDelta.unicastRoutesToDelete_ref()) {
+    if (not pendingRoutes.unicastRoutes.count(prefix)) {
+      failedRoutes.unicastRoutes.insert_or_assign(prefix, std::nullopt);
+    }
+  }
+  for (auto const& route : *routeDbDelta.mplsRoutesToUpdate_ref()) {
+    if (not pendingRoutes.mplsRoutes.count(*route.topLabel_ref())) {
+      failedRoutes.mplsRoutes.insert_or_assign(*route.topLabel_ref(), route);
+    }
+  }
+  for (auto const& topLabel : *routeDbDelta.mplsRoutesToDelete_ref()) {
+    if (not pendingRoutes.mplsRoutes.count(topLabel)) {
+      failedRoutes.mplsRoutes.insert_or_assign(topLabel, std::nullopt);
+    }
+  }
+  scheduleRetryRoutes(backend);
+}
+
+void
+Fib::scheduleRetryRoutes(Backend& backend) {
+  if (not backend.retryRoutesTimer->isScheduled()) {
+    backend.retryRoutesBackoff.reportError();
+    const auto period = backend.retryRoutesBackoff.getTimeRemainingUntilRetry();
+    LOG(INFO) << "Scheduling retry of failed routes after " << period.count()
+              << "ms";
+    backend.retryRoutesTimer->scheduleTimeout(period);
   }
 }
 
 bool
-Fib::syncRouteDb() {
-  const auto& unicastRoutes =
-      createUnicastRoutesFromMap(routeState_.unicastRoutes);
-  const auto& mplsRoutes =
-      createMplsRoutesWithSelectedNextHopsMap(routeState_.mplsRoutes);
+Fib::syncRouteDb(Backend& backend) {
+  // Pending and failed changes are part of the full route DB being synced
+  backend.pendingRoutes = PendingRoutes();
+  backend.failedRoutes = PendingRoutes();
+  backend.checkAgentOnRetry = false;
+
+  if (enableWarmBoot_ and not backend.hasSyncedFib and not dryrun_) {
+    return syncRouteDbWarmBoot(backend);
+  }
+
+  // Route DBs too large for a single request are synced in chunks. Keep going
+  // with a chunked sync in progress even if routes got removed meanwhile.
+  if (not dryrun_ and
+      (routeState_.unicastRoutes.size() > fibSyncBatchSize_ or
+       (enableSegmentRouting_ and
+        routeState_.mplsRoutes.size() > fibSyncBatchSize_) or
+       not backend.syncedPrefixes.empty() or
+       not backend.syncedLabels.empty())) {
+    return syncRouteDbChunk(backend);
+  }
+
+  std::vector<thrift::UnicastRoute> unicastRoutes;
+  unicastRoutes.reserve(routeState_.unicastRoutes.size());
+  for (auto const& [_, route] : routeState_.unicastRoutes) {
+    unicastRoutes.emplace_back(route.toThrift());
+  }
+  std::vector<thrift::MplsRoute> mplsRoutes;
+  mplsRoutes.reserve(routeState_.mplsSelectedNextHops.size());
+  for (auto const& [label, nextHops] : routeState_.mplsSelectedNextHops) {
+    mplsRoutes.emplace_back(createMplsRoute(label, nextHops));
+  }
 
   // In dry run we just print the routes. No real action
   if (dryrun_) {
@@ -693,19 +1607,20 @@ Fib::syncRouteDb() {
     LOG(INFO) << "Syncing routes in FIB";
     auto startTime = std::chrono::steady_clock::now();
 
-    createFibClient(evb_, socket_, client_, thriftPort_);
+    createFibClient(evb_, backend.socket, backend.client, backend.thriftPort);
     fb303::fbData->addStatValue("fib.sync_fib_calls", 1, fb303::COUNT);
+    // Synced routes are held by this incarnation of the agent
+    backend.latestAliveSince = backend.client->sync_aliveSince();
 
     // Sync unicast routes
     LOG(INFO) << "Syncing " << unicastRoutes.size() << " unicast routes in FIB";
-    client_->sync_syncFib(kFibId_, unicastRoutes);
-    routeState_.dirtyPrefixes.clear();
+    backend.client->sync_syncFib(kFibId_, unicastRoutes);
     printUnicastRoutesAddUpdate(unicastRoutes);
 
     // Sync mpls routes
     if (enableSegmentRouting_) {
       LOG(INFO) << "Syncing " << mplsRoutes.size() << " mpls routes in FIB";
-      client_->sync_syncMplsFib(kFibId_, mplsRoutes);
+      backend.client->sync_syncMplsFib(kFibId_, mplsRoutes);
       printMplsRoutesAddUpdate(mplsRoutes);
     }
 
@@ -716,41 +1631,336 @@ Fib::syncRouteDb() {
               << "ms to sync routes in FIB";
     fb303::fbData->addStatValue(
         "fib.route_sync.time_ms", elapsedTime.count(), fb303::AVG);
-    routeState_.dirtyLabels.clear();
-    routeState_.dirtyRouteDb = false;
+    clearDirtyRoutes();
+    backend.dirtyRouteDb = false;
     return true;
   } catch (std::exception const& e) {
     fb303::fbData->addStatValue("fib.thrift.failure.sync_fib", 1, fb303::COUNT);
     LOG(ERROR) << "Failed to sync routes in FIB. Error: "
                << folly::exceptionStr(e);
-    routeState_.dirtyRouteDb = true;
-    client_.reset();
+    backend.dirtyRouteDb = true;
+    backend.client.reset();
+    return false;
+  }
+}
+
+bool
+Fib::syncRouteDbChunk(Backend& backend) {
+  if (backend.syncedPrefixes.empty() and
+      backend.syncedLabels.empty()) {
+    LOG(INFO) << "Syncing routes in FIB in chunks of " << fibSyncBatchSize_
+              << " routes";
+    backend.syncStartTime = std::chrono::steady_clock::now();
+  }
+
+  try {
+    createFibClient(evb_, backend.socket, backend.client, backend.thriftPort);
+    fb303::fbData->addStatValue("fib.sync_fib_chunks", 1, fb303::COUNT);
+    if (backend.syncedPrefixes.empty() and
+        backend.syncedLabels.empty()) {
+      // Synced routes are held by this incarnation of the agent
+      backend.latestAliveSince = backend.client->sync_aliveSince();
+    }
+
+    // Program the next chunk of unicast routes by priority
+    std::array<std::vector<const RibUnicastEntry*>, 4> unsyncedRoutes;
+    for (auto const& kv : routeState_.unicastRoutes) {
+      if (not backend.syncedPrefixes.count(kv.first)) {
+        unsyncedRoutes.at(getSyncPriority(kv.second)).emplace_back(&kv.second);
+      }
+    }
+    std::vector<const RibUnicastEntry*> chunk;
+    std::vector<thrift::UnicastRoute> unicastRoutes;
+    for (auto const& routes : unsyncedRoutes) {
+      for (auto const* route : routes) {
+        if (unicastRoutes.size() >= fibSyncBatchSize_) {
+          break;
+        }
+        chunk.emplace_back(route);
+        unicastRoutes.emplace_back(route->toThrift());
+      }
+    }
+    if (not unicastRoutes.empty()) {
+      LOG(INFO) << "Syncing chunk of " << unicastRoutes.size()
+                << " unicast routes in FIB";
+      backend.client->sync_addUnicastRoutes(kFibId_, unicastRoutes);
+      printUnicastRoutesAddUpdate(unicastRoutes);
+      for (auto const* route : chunk) {
+        backend.syncedPrefixes.emplace(route->prefix);
+      }
+      syncRouteDbDebounced(backend); // Continue with next chunk
+      return true;
+    }
+
+    // Program the next chunk of mpls routes
+    if (enableSegmentRouting_) {
+      std::vector<thrift::MplsRoute> mplsRoutes;
+      for (auto const& kv : routeState_.mplsSelectedNextHops) {
+        if (mplsRoutes.size() >= fibSyncBatchSize_) {
+          break;
+        }
+        if (not backend.syncedLabels.count(kv.first)) {
+          mplsRoutes.emplace_back(createMplsRoute(kv.first, kv.second));
+        }
+      }
+      if (not mplsRoutes.empty()) {
+        LOG(INFO) << "Syncing chunk of " << mplsRoutes.size()
+                  << " mpls routes in FIB";
+        backend.client->sync_addMplsRoutes(kFibId_, mplsRoutes);
+        printMplsRoutesAddUpdate(mplsRoutes);
+        for (auto const& route : mplsRoutes) {
+          backend.syncedLabels.emplace(*route.topLabel_ref());
+        }
+        syncRouteDbDebounced(backend); // Continue with next chunk
+        return true;
+      }
+    }
+
+    // All routes are programmed. Remove stale routes from the agent and
+    // program again what it lost meanwhile (e.g. on restart).
+    bool hasMissingRoutes{false};
+    std::vector<thrift::UnicastRoute> agentUnicastRoutes;
+    backend.client->sync_getRouteTableByClient(agentUnicastRoutes, kFibId_);
+    std::unordered_set<folly::CIDRNetwork> agentPrefixes;
+    std::vector<thrift::IpPrefix> stalePrefixes;
+    for (auto const& route : agentUnicastRoutes) {
+      auto const prefix = toIPNetwork(*route.dest_ref());
+      agentPrefixes.emplace(prefix);
+      if (not routeState_.unicastRoutes.count(prefix)) {
+        stalePrefixes.emplace_back(*route.dest_ref());
+      }
+    }
+    for (auto const& kv : routeState_.unicastRoutes) {
+      if (not agentPrefixes.count(kv.first)) {
+        backend.syncedPrefixes.erase(kv.first);
+        hasMissingRoutes = true;
+      }
+    }
+    for (size_t i = 0; i < stalePrefixes.size(); i += fibSyncBatchSize_) {
+      std::vector<thrift::IpPrefix> prefixes(
+          stalePrefixes.begin() + i,
+          stalePrefixes.begin() +
+              std::min(i + fibSyncBatchSize_, stalePrefixes.size()));
+      LOG(INFO) << "Deleting " << prefixes.size()
+                << " stale unicast routes in FIB";
+      backend.client->sync_deleteUnicastRoutes(kFibId_, prefixes);
+    }
+
+    if (enableSegmentRouting_) {
+      std::vector<thrift::MplsRoute> agentMplsRoutes;
+      backend.client->sync_getMplsRouteTableByClient(agentMplsRoutes, kFibId_);
+      std::unordered_set<uint32_t> agentLabels;
+      std::vector<int32_t> staleLabels;
+      for (auto const& route : agentMplsRoutes) {
+        agentLabels.emplace(*route.topLabel_ref());
+        if (not routeState_.mplsRoutes.count(*route.topLabel_ref())) {
+          staleLabels.emplace_back(*route.topLabel_ref());
+        }
+      }
+      for (auto const& kv : routeState_.mplsRoutes) {
+        if (not agentLabels.count(kv.first)) {
+          backend.syncedLabels.erase(kv.first);
+          hasMissingRoutes = true;
+        }
+      }
+      for (size_t i = 0; i < staleLabels.size(); i += fibSyncBatchSize_) {
+        std::vector<int32_t> labels(
+            staleLabels.begin() + i,
+            staleLabels.begin() +
+                std::min(i + fibSyncBatchSize_, staleLabels.size()));
+        LOG(INFO) << "Deleting " << labels.size()
+                  << " stale mpls routes in FIB";
+        backend.client->sync_deleteMplsRoutes(kFibId_, labels);
+      }
+    }
+
+    if (hasMissingRoutes) {
+      LOG(INFO) << "FIB lost routes during sync, programming them again";
+      syncRouteDbDebounced(backend);
+      return true;
+    }
+
+    const auto elapsedTime =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - backend.syncStartTime);
+    LOG(INFO) << "It took " << elapsedTime.count()
+              << "ms to sync routes in FIB";
+    fb303::fbData->addStatValue(
+        "fib.route_sync.time_ms", elapsedTime.count(), fb303::AVG);
+    backend.syncedPrefixes.clear();
+    backend.syncedLabels.clear();
+    clearDirtyRoutes();
+    backend.dirtyRouteDb = false;
+    return true;
+  } catch (std::exception const& e) {
+    fb303::fbData->addStatValue("fib.thrift.failure.sync_fib", 1, fb303::COUNT);
+    LOG(ERROR) << "Failed to sync routes in FIB, will resume with "
+               << backend.syncedPrefixes.size() << " unicast and "
+               << backend.syncedLabels.size()
+               << " mpls routes synced. Error: " << folly::exceptionStr(e);
+    backend.dirtyRouteDb = true;
+    backend.client.reset();
+    return false;
+  }
+}
+
+bool
+Fib::syncRouteDbWarmBoot(Backend& backend) {
+  try {
+    LOG(INFO) << "Warm-boot sync of routes in FIB";
+    const auto startTime = std::chrono::steady_clock::now();
+    createFibClient(evb_, backend.socket, backend.client, backend.thriftPort);
+    fb303::fbData->addStatValue("fib.warm_boot_sync_calls", 1, fb303::COUNT);
+    // Synced routes are held by this incarnation of the agent
+    backend.latestAliveSince = backend.client->sync_aliveSince();
+
+    // Adopt unicast routes of the agent, rewrite those which differ
+    std::vector<thrift::UnicastRoute> agentUnicastRoutes;
+    backend.client->sync_getRouteTableByClient(agentUnicastRoutes, kFibId_);
+    std::unordered_map<folly::CIDRNetwork, std::vector<thrift::NextHopThrift>>
+        agentUnicastNextHops;
+    std::vector<thrift::IpPrefix> unicastRoutesToDelete;
+    for (auto& route : agentUnicastRoutes) {
+      auto const prefix = toIPNetwork(*route.dest_ref());
+      if (not routeState_.unicastRoutes.count(prefix)) {
+        unicastRoutesToDelete.emplace_back(*route.dest_ref());
+      }
+      agentUnicastNextHops.emplace(
+          prefix, getProgrammedNextHops(std::move(*route.nextHops_ref())));
+    }
+    std::vector<thrift::UnicastRoute> unicastRoutesToUpdate;
+    for (auto const& [prefix, route] : routeState_.unicastRoutes) {
+      auto it = agentUnicastNextHops.find(prefix);
+      if (it == agentUnicastNextHops.end() or
+          it->second !=
+              getProgrammedNextHops(std::vector<thrift::NextHopThrift>(
+                  route.nexthops.begin(), route.nexthops.end()))) {
+        unicastRoutesToUpdate.emplace_back(route.toThrift());
+      }
+    }
+
+    // Same for mpls routes
+    std::vector<thrift::MplsRoute> mplsRoutesToUpdate;
+    std::vector<int32_t> mplsRoutesToDelete;
+    size_t numAgentMplsRoutes{0};
+    if (enableSegmentRouting_) {
+      std::vector<thrift::MplsRoute> agentMplsRoutes;
+      backend.client->sync_getMplsRouteTableByClient(agentMplsRoutes, kFibId_);
+      numAgentMplsRoutes = agentMplsRoutes.size();
+      std::unordered_map<int32_t, std::vector<thrift::NextHopThrift>>
+          agentMplsNextHops;
+      for (auto& route : agentMplsRoutes) {
+        agentMplsNextHops.emplace(
+            *route.topLabel_ref(),
+            getProgrammedNextHops(std::move(*route.nextHops_ref())));
+      }
+      for (auto const& [label, nextHops] : routeState_.mplsSelectedNextHops) {
+        auto mplsRoute = createMplsRoute(label, nextHops);
+        auto it = agentMplsNextHops.find(label);
+        if (it == agentMplsNextHops.end() or
+            it->second != getProgrammedNextHops(*mplsRoute.nextHops_ref())) {
+          mplsRoutesToUpdate.emplace_back(std::move(mplsRoute));
+        }
+      }
+      for (auto const& [label, _] : agentMplsNextHops) {
+        if (not routeState_.mplsRoutes.count(label)) {
+          mplsRoutesToDelete.emplace_back(label);
+        }
+      }
+    }
+
+    const size_t numRetained = routeState_.unicastRoutes.size() +
+        (enableSegmentRouting_ ? routeState_.mplsRoutes.size() : 0) -
+        unicastRoutesToUpdate.size() - mplsRoutesToUpdate.size();
+    const size_t numRewritten =
+        unicastRoutesToUpdate.size() + mplsRoutesToUpdate.size();
+    const size_t numDeleted =
+        unicastRoutesToDelete.size() + mplsRoutesToDelete.size();
+    LOG(INFO) << "Adopted " << agentUnicastRoutes.size() << " unicast and "
+              << numAgentMplsRoutes << " mpls routes from FIB. Retaining "
+              << numRetained << ", rewriting " << numRewritten
+              << " and deleting " << numDeleted << " routes";
+    fb303::fbData->setCounter("fib.warm_boot.routes_retained", numRetained);
+    fb303::fbData->setCounter("fib.warm_boot.routes_rewritten", numRewritten);
+    fb303::fbData->setCounter("fib.warm_boot.routes_deleted", numDeleted);
+
+    // Delete first, routes to update may replace covering ones
+    forEachBatch<thrift::IpPrefix>(
+        unicastRoutesToDelete,
+        fibSyncBatchSize_,
+        [this, &backend](auto prefixes) {
+          backend.client->sync_deleteUnicastRoutes(kFibId_, prefixes);
+        });
+    forEachBatch<thrift::UnicastRoute>(
+        unicastRoutesToUpdate,
+        fibSyncBatchSize_,
+        [this, &backend](auto routes) {
+          backend.client->sync_addUnicastRoutes(kFibId_, routes);
+          printUnicastRoutesAddUpdate(routes);
+        });
+    forEachBatch<int32_t>(
+        mplsRoutesToDelete, fibSyncBatchSize_, [this, &backend](auto labels) {
+          backend.client->sync_deleteMplsRoutes(kFibId_, labels);
+        });
+    forEachBatch<thrift::MplsRoute>(
+        mplsRoutesToUpdate, fibSyncBatchSize_, [this, &backend](auto routes) {
+          backend.client->sync_addMplsRoutes(kFibId_, routes);
+          printMplsRoutesAddUpdate(routes);
+        });
+
+    const auto elapsedTime =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime);
+    LOG(INFO) << "It took " << elapsedTime.count()
+              << "ms to warm-boot sync routes in FIB";
+    fb303::fbData->addStatValue(
+        "fib.route_sync.time_ms", elapsedTime.count(), fb303::AVG);
+    clearDirtyRoutes();
+    backend.dirtyRouteDb = false;
+    return true;
+  } catch (std::exception const& e) {
+    fb303::fbData->addStatValue("fib.thrift.failure.sync_fib", 1, fb303::COUNT);
+    LOG(ERROR) << "Failed to warm-boot sync routes in FIB. Error: "
+               << folly::exceptionStr(e);
+    backend.dirtyRouteDb = true;
+    backend.client.reset();
     return false;
   }
 }
 
 void
-Fib::syncRouteDbDebounced() {
-  if (!syncRoutesTimer_->isScheduled()) {
+Fib::syncRouteDbDebounced(Backend& backend) {
+  if (!backend.syncRoutesTimer->isScheduled()) {
     // Schedule an immediate run if previous one is not scheduled
-    syncRoutesTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+    backend.syncRoutesTimer->scheduleTimeout(std::chrono::milliseconds(0));
+  }
+}
+
+void
+Fib::clearDirtyRoutes() {
+  if (backends_.size() > 1) {
+    return;
   }
+  routeState_.dirtyPrefixes.clear();
+  routeState_.dirtyLabels.clear();
 }
 
 void
-Fib::keepAliveCheck() {
-  createFibClient(evb_, socket_, client_, thriftPort_);
-  int64_t aliveSince = client_->sync_aliveSince();
+Fib::keepAliveCheck(Backend& backend) {
+  createFibClient(evb_, backend.socket, backend.client, backend.thriftPort);
+  int64_t aliveSince = backend.client->sync_aliveSince();
   // Check if FIB has restarted or not
-  if (aliveSince != latestAliveSince_) {
+  if (aliveSince != backend.latestAliveSince) {
     LOG(WARNING) << "FibAgent seems to have restarted. "
                  << "Performing full route DB sync ...";
-    // set dirty flag
-    routeState_.dirtyRouteDb = true;
-    expBackoff_.reportSuccess();
-    syncRouteDbDebounced();
+    // set dirty flag, routes of a chunked sync in progress are gone
+    backend.dirtyRouteDb = true;
+    backend.syncedPrefixes.clear();
+    backend.syncedLabels.clear();
+    backend.expBackoff.reportSuccess();
+    syncRouteDbDebounced(backend);
   }
-  latestAliveSince_ = aliveSince;
+  backend.latestAliveSince = aliveSince;
 }
 
 void
@@ -804,14 +2014,9 @@ Fib::updateGlobalCounters() {
   fb303::fbData->setCounter(
       "fib.num_dirty_labels", routeState_.dirtyLabels.size());
 
-  // Count the number of bgp routes
-  int64_t bgpCounter = 0;
-  for (const auto& route : routeState_.unicastRoutes) {
-    if (route.second.data_ref().has_value()) {
-      bgpCounter++;
-    }
-  }
-  fb303::fbData->setCounter("fib.num_routes.BGP", bgpCounter);
+  fb303::fbData->setCounter("fib.num_routes.BGP", routeState_.numBgpRoutes);
+  fb303::fbData->setCounter(
+      "fib.route_state_bytes", routeState_.routeStateBytes);
 }
 
 void
@@ -877,9 +2082,11 @@ Fib::logPerfEvents(std::optional<thrift::PerfEvents> perfEvents) {
     VLOG(2) << "  " << str;
   }
 
+  exportPerfEventsStages(*perfEvents);
+
   // Add new entry to perf DB and purge extra entries
   perfDb_.push_back(std::move(perfEvents).value());
-  while (perfDb_.size() >= Constants::kPerfBufferSize) {
+  while (perfDb_.size() > perfDbMaxSize_) {
     perfDb_.pop_front();
   }
 
@@ -895,4 +2102,43 @@ Fib::logPerfEvents(std::optional<thrift::PerfEvents> perfEvents) {
   logSampleQueue_.push(sample);
 }
 
+void
+Fib::exportPerfEventsStages(const thrift::PerfEvents& perfEvents) {
+  // spans of the same convergence share its first event
+  const auto& firstEvent = perfEvents.events_ref()->front();
+  const auto traceId = folly::sformat(
+      "{}:{}", *firstEvent.nodeName_ref(), *firstEvent.unixTs_ref());
+
+  for (const auto& stage : getPerfEventsStages(perfEvents)) {
+    // e.g. fib.perf.decision_received.decision_debounce_ms
+    auto key = folly::sformat(
+        "fib.perf.{}.{}_ms", stage.firstEvent, stage.secondEvent);
+    folly::toLowerAscii(key);
+    if (perfStageHistograms_.emplace(key).second) {
+      // 10ms buckets up to the max convergence duration
+      fb303::fbData->addHistogram(
+          key,
+          10,
+          0,
+          std::chrono::milliseconds(Constants::kConvergenceMaxDuration)
+              .count());
+      fb303::fbData->exportHistogramPercentile(key, 50, 95, 99);
+    }
+    fb303::fbData->addHistogramValue(key, stage.duration.count());
+
+    if (not enablePerfSpans_) {
+      continue;
+    }
+    LogSample sample{};
+    sample.addString("event", "ROUTE_CONVERGENCE_SPAN");
+    sample.addString("trace_id", traceId);
+    sample.addString(
+        "span", folly::sformat("{}.{}", stage.firstEvent, stage.secondEvent));
+    sample.addString("span_node", stage.nodeName);
+    sample.addInt("start_unix_ts", stage.startUnixTs);
+    sample.addInt("duration_ms", stage.duration.count());
+    logSampleQueue_.push(sample);
+  }
+}
+
 } // namespace openr
@@ -7,7 +7,7 @@
 
 #pragma once
 
-#include <folly/fibers/Semaphore.h>
+#include <folly/futures/Future.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/EventBase.h>
@@ -15,12 +15,15 @@
 
 #include <openr/common/ExponentialBackoff.h>
 #include <openr/common/OpenrEventBase.h>
+#include <openr/common/PrefixTrie.h>
+#include <openr/common/Types.h>
 #include <openr/common/Util.h>
 #include <openr/config/Config.h>
 #include <openr/decision/RouteUpdate.h>
 #include <openr/if/gen-cpp2/FibService.h>
 #include <openr/if/gen-cpp2/Fib_types.h>
 #include <openr/if/gen-cpp2/LinkMonitor_types.h>
+#include <openr/if/gen-cpp2/OpenrCtrl_types.h>
 #include <openr/if/gen-cpp2/Platform_types.h>
 #include <openr/kvstore/KvStoreClientInternal.h>
 #include <openr/messaging/Queue.h>
@@ -53,8 +56,9 @@ class Fib final : public OpenrEventBase {
   Fib(std::shared_ptr<const Config> config,
       int32_t thriftPort,
       std::chrono::seconds coldStartDuration,
-      messaging::RQueue<DecisionRouteUpdate> routeUpdatesQueue,
-      messaging::RQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue,
+      messaging::RQueue<DecisionRouteUpdatePtr> routeUpdatesQueue,
+      messaging::RQueue<InterfaceDatabaseUpdate> interfaceUpdatesQueue,
+      messaging::RQueue<InterfaceStatusEvent> interfaceStatusEventsQueue,
       messaging::ReplicateQueue<thrift::RouteDatabaseDelta>& fibUpdatesQueue,
       messaging::ReplicateQueue<LogSample>& logSampleQueue,
       KvStore* kvStore);
@@ -104,6 +108,13 @@ class Fib final : public OpenrEventBase {
    */
   folly::SemiFuture<std::unique_ptr<thrift::RouteDatabase>> getRouteDb();
 
+  /**
+   * Retrieve a page of the route database, see thrift::PageParams. Cursor is
+   * a prefix while paging through unicast routes and a label afterwards.
+   */
+  folly::SemiFuture<std::unique_ptr<thrift::RouteDatabasePage>> getRouteDbPage(
+      thrift::PageParams page);
+
   /**
    * Retrieve unicast routes for specified prefixes or IP. Returns all if
    * no prefix is specified in filter list.
@@ -123,26 +134,95 @@ class Fib final : public OpenrEventBase {
    */
   folly::SemiFuture<std::unique_ptr<thrift::PerfDatabase>> getPerfDb();
 
+  /**
+   * Apply runtime tunable knobs of a reloaded config, i.e.
+   * fib_sync_batch_size. Other settings keep their values from construction.
+   */
+  folly::SemiFuture<folly::Unit> applyConfig(
+      std::shared_ptr<const Config> config);
+
+  /**
+   * Only the latest perf events are kept while under memory pressure.
+   */
+  folly::SemiFuture<folly::Unit> setMemoryPressure(MemoryPressure level);
+
   /**
    * API to get reader for fibUpdatesQueue
    */
   messaging::RQueue<thrift::RouteDatabaseDelta> getFibUpdatesReader();
 
+  /**
+   * Set flat counters/stats. Called on every route update, exposed publicly
+   * for testing
+   */
+  void updateGlobalCounters();
+
  private:
   // No-copy
   Fib(const Fib&) = delete;
   Fib& operator=(const Fib&) = delete;
 
+  struct Backend;
+
+  /**
+   * Add switch agent listening on port to the ones routes are programmed to,
+   * along with the timers of its pipeline
+   */
+  void addBackend(int32_t port);
+
   /**
-   * Process new route updates received from Decision module
+   * Process new route updates received from Decision module. Unicast routes
+   * are kept as received and only converted to thrift for the agent.
    */
-  void processRouteUpdates(thrift::RouteDatabaseDelta&& routeDelta);
+  void processRouteUpdates(DecisionRouteUpdate&& routeUpdate);
 
   /**
    * Process interface status information from LinkMonitor. We remove all
    * routes associated with interface if we detect that it just went down.
+   * Only interfaces in delta get their status updated, removed ones are
+   * considered down, and only routes over those whose status changed are
+   * re-evaluated.
+   */
+  void processInterfaceDb(InterfaceDatabaseUpdate&& update);
+
+  /**
+   * Process oper state change of a single interface from LinkMonitor, ahead
+   * of the interface database. Only routes over the interface are
+   * re-evaluated and their changes are programmed right away.
+   */
+  void processInterfaceStatusEvent(const InterfaceStatusEvent& event);
+
+  /**
+   * Re-evaluate nexthops of routes over given interfaces, or of all routes if
+   * std::nullopt, against interfaceStatusDb_ and add resulting route changes
+   * to routeDbDelta
+   */
+  void updateRoutesOverInterfaces(
+      std::optional<std::vector<std::string>> const& ifNames,
+      thrift::RouteDatabaseDelta& routeDbDelta);
+
+  /**
+   * Shrink nexthops of a route to those over interfaces which are up, or
+   * restore them once all are up again. Marks route dirty accordingly.
+   */
+  void updateRouteNextHops(
+      const RibUnicastEntry& route, thrift::RouteDatabaseDelta& routeDbDelta);
+  void updateRouteNextHops(
+      const thrift::MplsRoute& route,
+      thrift::RouteDatabaseDelta& routeDbDelta);
+
+  /**
+   * Add or remove route in the index of routes by interface
+   */
+  void indexRoute(const RibUnicastEntry& route, bool add);
+  void indexRoute(const thrift::MplsRoute& route, bool add);
+
+  /**
+   * MPLS route as programmed, i.e. with selected nexthops only. Selection of
+   * routes in routeState_ is cached, while routes shrunk on interface down
+   * carry selected nexthops already.
    */
-  void processInterfaceDb(thrift::InterfaceDatabase&& interfaceDb);
+  thrift::MplsRoute getMplsRouteToProgram(const thrift::MplsRoute& route) const;
 
   /**
    * Convert local perfDb_ into PerfDataBase
@@ -162,44 +242,138 @@ class Fib final : public OpenrEventBase {
       std::vector<int32_t> labels);
 
   /**
-   * Trigger add/del routes thrift calls
+   * Queue route changes for programming and send them to every switch agent
+   * asynchronously
    * on success no action needed
-   * on failure invokes syncRouteDbDebounced
+   * on failure invokes syncRouteDbDebounced of the agent
    */
   void updateRoutes(const thrift::RouteDatabaseDelta& routeDbDelta);
+  void updateRoutes(
+      Backend& backend,
+      const thrift::RouteDatabaseDelta& routeDbDelta,
+      const std::vector<thrift::MplsRoute>& mplsRoutesToUpdate);
+
+  /**
+   * Send queued route changes, whose prefix or label has no request in
+   * flight, until kMaxFibRequestsInFlight requests are outstanding
+   */
+  void programPendingRoutes(Backend& backend);
+
+  /**
+   * Send one batch of route changes and handle its response
+   */
+  void programRoutes(
+      Backend& backend, thrift::RouteDatabaseDelta&& routeDbDelta);
+
+#if FOLLY_HAS_COROUTINES
+  /**
+   * Await responses to a batch of route changes sent at startTime, on event
+   * base without blocking it
+   */
+  folly::coro::Task<void> awaitProgramRoutes(
+      Backend& backend,
+      std::vector<folly::SemiFuture<folly::Unit>> futures,
+      thrift::RouteDatabaseDelta routeDbDelta,
+      std::chrono::steady_clock::time_point startTime);
+#endif
+
+  /**
+   * Make thrift calls programming a batch of route changes, returns their
+   * responses to wait on
+   */
+  std::vector<folly::SemiFuture<folly::Unit>> sendRoutes(
+      Backend& backend, thrift::RouteDatabaseDelta const& routeDbDelta);
+
+  /**
+   * Handle responses to a batch of route changes sent at startTime
+   */
+  void processProgramRoutesResults(
+      Backend& backend,
+      thrift::RouteDatabaseDelta const& routeDbDelta,
+      std::chrono::steady_clock::time_point startTime,
+      std::vector<folly::Try<folly::Unit>> const& results);
+
+  /**
+   * Hold back changes of a batch the agent failed to program, as reported by
+   * PlatformFibUpdateError, to be retried on their own after backoff
+   */
+  void holdFailedRoutes(
+      Backend& backend,
+      thrift::RouteDatabaseDelta const& routeDbDelta,
+      thrift::PlatformFibUpdateError const& error);
+
+  /**
+   * Hold back all changes of a batch whose connection to the agent got lost
+   * before it was acknowledged. They are replayed after reconnecting if the
+   * agent did not restart meanwhile, as route programming is idempotent.
+   */
+  void holdUnackedRoutes(
+      Backend& backend, thrift::RouteDatabaseDelta const& routeDbDelta);
+
+  // Schedule retryRoutesTimer of agent with backoff unless already scheduled
+  void scheduleRetryRoutes(Backend& backend);
 
   /**
    * Sync the current routeDb_ with the switch agent.
    * on success no action needed
    * on failure invokes syncRouteDbDebounced
    */
-  bool syncRouteDb();
+  bool syncRouteDb(Backend& backend);
+
+  /**
+   * Sync next chunk of a route DB too large for a single request, by route
+   * priority. Once all routes are programmed, routes unknown to Fib are
+   * removed from the agent. Schedules itself until the sync completes and
+   * resumes from its progress in the backend after a failure.
+   */
+  bool syncRouteDbChunk(Backend& backend);
+
+  /**
+   * Warm-boot sync on startup. Adopt routes found in the agent and program
+   * only the difference to routeState_, in chunks of fibSyncBatchSize_.
+   * Reports number of retained, rewritten and deleted routes as counters.
+   */
+  bool syncRouteDbWarmBoot(Backend& backend);
 
   /**
    * Asynchrounsly schedules the syncRouteDb call and returns immediately. All
    * APIs should call this function to sync-routes.
    */
-  void syncRouteDbDebounced();
+  void syncRouteDbDebounced(Backend& backend);
+
+  /**
+   * Routes synced to an agent are no longer shrunk on it. With several
+   * agents, others may still hold shrunk routes, so they stay dirty.
+   */
+  void clearDirtyRoutes();
 
   /**
    * Get aliveSince from FibService, and check if Fib restarts
    * If so, push syncFib to FibService
    */
-  void keepAliveCheck();
-
-  // set flat counter/stats
-  void updateGlobalCounters();
+  void keepAliveCheck(Backend& backend);
 
   // log perf events
   void logPerfEvents(std::optional<thrift::PerfEvents> perfEvents);
 
+  // export durations of stages of perf events, and spans if enabled
+  void exportPerfEventsStages(const thrift::PerfEvents& perfEvents);
+
   // Prefix to available nexthop information. Also store perf information of
   // received route-db if provided.
   struct RouteState {
     // Non modified copy of Unicast and MPLS routes received from Decision
-    std::unordered_map<thrift::IpPrefix, thrift::UnicastRoute> unicastRoutes;
+    std::unordered_map<folly::CIDRNetwork, RibUnicastEntry> unicastRoutes;
     std::unordered_map<uint32_t, thrift::MplsRoute> mplsRoutes;
 
+    // Selected nexthops of mplsRoutes in canonical order, as programmed.
+    // Recomputed only when nexthops of the route change.
+    std::unordered_map<uint32_t, std::vector<thrift::NextHopThrift>>
+        mplsSelectedNextHops;
+
+    // prefixes of unicastRoutes for longest prefix matching
+    PrefixTrie unicastPrefixes;
+
     // indicates we've received a decision route publication and therefore have
     // routes to sync. will not synce routes with system until this is set
     bool hasRoutesFromDecision{false};
@@ -211,23 +385,116 @@ class Fib final : public OpenrEventBase {
     // - receiving new route for prefix or label
     // - full route sync happens
     // - interface up event happens for disabled nexthop
-    std::unordered_set<thrift::IpPrefix> dirtyPrefixes;
+    std::unordered_set<folly::CIDRNetwork> dirtyPrefixes;
     std::unordered_set<uint32_t> dirtyLabels;
 
+    // Routes by interface of their nexthops, including backup nexthops, so
+    // that interface events only re-evaluate routes over the interface
+    std::unordered_map<std::string, std::unordered_set<folly::CIDRNetwork>>
+        ifNameToPrefixes;
+    std::unordered_map<std::string, std::unordered_set<uint32_t>>
+        ifNameToLabels;
+
+    // Aggregates exported by updateGlobalCounters(), kept up to date by
+    // indexRoute() so that exporting them doesn't walk the routes
+    int64_t numBgpRoutes{0};
+    size_t routeStateBytes{0};
+    // routes referring to an interned next-hop group by its id, bytes of a
+    // group are counted once however many routes share it
+    std::unordered_map<uint64_t, size_t> nextHopGroupRefs;
+  };
+  RouteState routeState_;
+
+  // Route changes waiting to be programmed. Changes for the same prefix or
+  // label are coalesced and std::nullopt stands for a delete.
+  struct PendingRoutes {
+    std::unordered_map<thrift::IpPrefix, std::optional<thrift::UnicastRoute>>
+        unicastRoutes;
+    std::unordered_map<int32_t, std::optional<thrift::MplsRoute>> mplsRoutes;
+
+    // perf events of the oldest delta coalesced into this batch
+    std::optional<thrift::PerfEvents> perfEvents;
+  };
+
+  // Switch agent routes are programmed to. Each has its own pipeline of
+  // route changes, retry and sync state, so that a slow or failing agent
+  // doesn't hold back programming of the others.
+  struct Backend {
+    explicit Backend(int32_t thriftPort);
+
+    // Switch agent thrift server port
+    const int32_t thriftPort;
+
+    // Thrift client connection to switch FIB Agent using which we actually
+    // manipulate routes, on evb_ for blocking calls
+    std::shared_ptr<folly::AsyncSocket> socket{nullptr};
+    std::unique_ptr<thrift::FibServiceAsyncClient> client{nullptr};
+
+    // Thrift client on the Fib event base for asynchronous route programming
+    std::shared_ptr<folly::AsyncSocket> asyncSocket{nullptr};
+    std::unique_ptr<thrift::FibServiceAsyncClient> asyncClient{nullptr};
+
+    PendingRoutes pendingRoutes;
+
+    // Prefixes and labels of programming requests in flight. Their later
+    // changes are held back in pendingRoutes to keep updates in order.
+    std::unordered_set<thrift::IpPrefix> inFlightPrefixes;
+    std::unordered_set<int32_t> inFlightLabels;
+    size_t numFibRequestsInFlight{0};
+
+    // Callback timer to sync routes to switch agent and scheduled on
+    // route-sync failure. ExponentialBackoff timer to ease up things if they
+    // go wrong
+    std::unique_ptr<folly::AsyncTimeout> syncRoutesTimer{nullptr};
+    ExponentialBackoff<std::chrono::milliseconds> expBackoff;
+
+    // Route changes the agent failed to program while the rest of their batch
+    // succeeded. Moved back to pendingRoutes by retryRoutesTimer, unless
+    // superseded by a newer change meanwhile.
+    PendingRoutes failedRoutes;
+    std::unique_ptr<folly::AsyncTimeout> retryRoutesTimer{nullptr};
+    ExponentialBackoff<std::chrono::milliseconds> retryRoutesBackoff;
+
+    // Connection to the agent got lost, check latestAliveSince before retry
+    bool checkAgentOnRetry{false};
+
     // Flag to indicate the result of previous route programming attempt.
-    // If set, it means what currently cached in local routes has not been 100%
-    // successfully synced with agent, we have to trigger an enforced full fib
-    // sync with agent again
+    // If set, it means what currently cached in local routes has not been
+    // 100% successfully synced with agent, we have to trigger an enforced
+    // full fib sync with agent again
     bool dirtyRouteDb{false};
+
+    // Routes programmed by the chunked full sync in progress. Removed on
+    // route changes, so that they are programmed again, and cleared once the
+    // sync completes or the agent restarts.
+    std::unordered_set<folly::CIDRNetwork> syncedPrefixes;
+    std::unordered_set<uint32_t> syncedLabels;
+
+    // start of the chunked full sync in progress
+    std::chrono::steady_clock::time_point syncStartTime;
+
+    // Latest aliveSince heard from FibService, taken on every full sync as
+    // the checkpoint of the agent holding the routes programmed since. If the
+    // next one is different then it means that FibAgent has restarted and we
+    // need to perform sync.
+    int64_t latestAliveSince{0};
+
+    // moves to true after initial sync
+    bool hasSyncedFib{false};
   };
-  RouteState routeState_;
 
   // Events to capture and indicate performance of protocol convergence.
   std::deque<thrift::PerfEvents> perfDb_;
 
+  // entries perfDb_ is purged down to, shrunk under memory pressure
+  size_t perfDbMaxSize_{Constants::kPerfBufferSize - 1};
+
   // Create timestamp of recently logged perf event
   int64_t recentPerfEventCreateTs_{0};
 
+  // Histograms of perf event stages added so far
+  std::unordered_set<std::string> perfStageHistograms_;
+
   // Interface status map
   std::unordered_map<std::string /* ifName*/, bool /* isUp */>
       interfaceStatusDb_;
@@ -235,9 +502,6 @@ class Fib final : public OpenrEventBase {
   // Name of node on which OpenR is running
   const std::string myNodeName_;
 
-  // Switch agent thrift server port
-  const int32_t thriftPort_;
-
   // In dry run we do not make actual thrift call to manipulate routes
   bool dryrun_{true};
 
@@ -247,18 +511,23 @@ class Fib final : public OpenrEventBase {
   // indicates that we should publish fib programming time to kvstore
   bool enableOrderedFib_{false};
 
+  // max number of routes per request of a chunked full sync
+  size_t fibSyncBatchSize_{0};
+
+  // initial sync programs only the difference to routes in the agent
+  bool enableWarmBoot_{false};
+
+  // Log stages of perf events as spans
+  bool enablePerfSpans_{false};
+
   apache::thrift::CompactSerializer serializer_;
 
-  // Thrift client connection to switch FIB Agent using which we actually
-  // manipulate routes.
+  // Event base of blocking thrift calls to switch agents
   folly::EventBase evb_;
-  std::shared_ptr<folly::AsyncSocket> socket_{nullptr};
-  std::unique_ptr<thrift::FibServiceAsyncClient> client_{nullptr};
 
-  // Callback timer to sync routes to switch agent and scheduled on route-sync
-  // failure. ExponentialBackoff timer to ease up things if they go wrong
-  std::unique_ptr<folly::AsyncTimeout> syncRoutesTimer_{nullptr};
-  ExponentialBackoff<std::chrono::milliseconds> expBackoff_;
+  // Agent of fib_port first, whose programming reports perf events, then
+  // those of additional_fib_ports. Their clients are bound to evb_.
+  std::vector<std::unique_ptr<Backend>> backends_;
 
   // periodically send alive msg to switch agent
   std::unique_ptr<folly::AsyncTimeout> keepAliveTimer_{nullptr};
@@ -270,20 +539,8 @@ class Fib final : public OpenrEventBase {
   // Queue to publish fib updates (Fib streaming)
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta>& fibUpdatesQueue_;
 
-  // Latest aliveSince heard from FibService. If the next one is different then
-  // it means that FibAgent has restarted and we need to perform sync.
-  int64_t latestAliveSince_{0};
-
-  // moves to true after initial sync
-  bool hasSyncedFib_{false};
-
   const int16_t kFibId_{static_cast<int16_t>(thrift::FibClient::OPENR)};
 
-  // Semaphore to serialize route programming across two fibers (interface
-  // updates & route updates)
-  // NOTE: Initializing with a single slot to avoid parallel processing
-  folly::fibers::Semaphore updateRoutesSemaphore_{1};
-
   // Queue to publish the event log
   messaging::ReplicateQueue<LogSample>& logSampleQueue_;
 };
@@ -7,16 +7,20 @@
 
 #include <gtest/gtest.h>
 
+#include <fb303/ServiceData.h>
 #include <folly/Benchmark.h>
 #include <folly/init/Init.h>
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 #include <thrift/lib/cpp2/util/ScopedServerThread.h>
 
+#include <openr/common/PrefixTrie.h>
 #include <openr/config/Config.h>
 #include <openr/config/tests/Utils.h>
 #include <openr/ctrl-server/OpenrCtrlHandler.h>
 #include <openr/fib/Fib.h>
 #include <openr/messaging/ReplicateQueue.h>
+#include <openr/monitor/SystemMetrics.h>
+#include <openr/tests/BenchmarkDriver.h>
 #include <openr/tests/mocks/MockNetlinkFibHandler.h>
 #include <openr/tests/mocks/PrefixGenerator.h>
 
@@ -43,6 +47,8 @@
     name(counters, iters, ##__VA_ARGS__);                              \
   }
 
+namespace fb303 = facebook::fb303;
+
 namespace {
 // Virtual interface
 const std::string kVethNameY("vethTestY");
@@ -52,6 +58,8 @@ static const long kBitMaskLen = 128;
 static const uint32_t kDeltaSize = 10;
 // Number of nexthops
 const uint8_t kNumOfNexthops = 128;
+// Number of addresses to longest prefix match per iteration
+const uint32_t kNumOfLpmQueries = 100;
 
 } // anonymous namespace
 
@@ -94,6 +102,7 @@ class FibWrapper {
         std::chrono::seconds(2), // coldStartDuration
         routeUpdatesQueue.getReader(),
         interfaceUpdatesQueue.getReader(),
+        interfaceStatusEventsQueue.getReader(),
         fibUpdatesQueue,
         logSampleQueue,
         nullptr /* KvStore module ptr */);
@@ -117,7 +126,7 @@ class FibWrapper {
         nullptr /* monitor */,
         nullptr /* configStore */,
         nullptr /* prefixManager */,
-        nullptr /* spark */,
+        {} /* sparkShards */,
         config /* config */);
 
     evbThread = std::make_unique<std::thread>([this]() {
@@ -133,6 +142,7 @@ class FibWrapper {
     fibUpdatesQueue.close();
     routeUpdatesQueue.close();
     interfaceUpdatesQueue.close();
+    interfaceStatusEventsQueue.close();
     logSampleQueue.close();
 
     LOG(INFO) << "Stopping openr-ctrl handler";
@@ -185,8 +195,9 @@ class FibWrapper {
   std::shared_ptr<ThriftServer> server;
   ScopedServerThread fibThriftThread;
 
-  messaging::ReplicateQueue<DecisionRouteUpdate> routeUpdatesQueue;
-  messaging::ReplicateQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue;
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue;
+  messaging::ReplicateQueue<InterfaceDatabaseUpdate> interfaceUpdatesQueue;
+  messaging::ReplicateQueue<InterfaceStatusEvent> interfaceStatusEventsQueue;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> fibUpdatesQueue;
   messaging::ReplicateQueue<LogSample> logSampleQueue;
 
@@ -280,6 +291,50 @@ BM_Fib(folly::UserCounters& counters, uint32_t iters, unsigned numOfPrefixes) {
   // Add customized counters to state.
   counters["route_receive"] = processTimes[0];
   counters["route_install"] = processTimes[2];
+
+  // Memory footprint. Peak RSS is process wide, i.e. covers all benchmarks run
+  // so far, run one with --bm_regex to attribute it
+  auto fib = fibWrapper->fib;
+  fib->getEvb()->runInEventBaseThreadAndWait(
+      [fib]() { fib->updateGlobalCounters(); });
+  counters["route_state_bytes"] =
+      fb303::fbData->getCounters().at("fib.route_state_bytes");
+  counters["peak_rss_bytes"] = SystemMetrics().getPeakRSSMemBytes().value_or(0);
+}
+
+/**
+ * Benchmark for longest prefix matching of addresses against the routes
+ * 1. Generate random IpV6 /64 routes
+ * 2. Match kNumOfLpmQueries addresses within routes against them, once with
+ *    the prefix trie Fib uses and once scanning all routes
+ */
+static void
+BM_FibLongestPrefixMatch(
+    uint32_t iters, unsigned numOfPrefixes, bool useTrie) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto prefixes = PrefixGenerator::ipv6PrefixGenerator(numOfPrefixes, 64);
+  std::unordered_map<thrift::IpPrefix, thrift::UnicastRoute> unicastRoutes;
+  PrefixTrie unicastPrefixes;
+  for (auto const& prefix : prefixes) {
+    unicastRoutes.emplace(prefix, createUnicastRoute(prefix, {}));
+    unicastPrefixes.insert(prefix);
+  }
+
+  std::vector<folly::CIDRNetwork> queries;
+  for (uint32_t i = 0; i < kNumOfLpmQueries; i++) {
+    auto const& prefix = prefixes.at(i % prefixes.size());
+    queries.emplace_back(toIPAddress(*prefix.prefixAddress_ref()), 128);
+  }
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    for (auto const& query : queries) {
+      auto const matchedPrefix = useTrie
+          ? unicastPrefixes.longestPrefixMatch(query)
+          : Fib::longestPrefixMatch(query, unicastRoutes);
+      folly::doNotOptimizeAway(matchedPrefix);
+    }
+  }
 }
 
 // The parameter is the number of prefixes sent to fib
@@ -288,11 +343,18 @@ BENCHMARK_COUNTERS_PARAM(BM_Fib, counters, 100);
 BENCHMARK_COUNTERS_PARAM(BM_Fib, counters, 1000);
 BENCHMARK_COUNTERS_PARAM(BM_Fib, counters, 9000);
 
+// The first parameter is the number of routes to match against
+BENCHMARK_NAMED_PARAM(BM_FibLongestPrefixMatch, 1000_trie, 1000, true);
+BENCHMARK_NAMED_PARAM(BM_FibLongestPrefixMatch, 1000_scan, 1000, false);
+BENCHMARK_NAMED_PARAM(BM_FibLongestPrefixMatch, 10000_trie, 10000, true);
+BENCHMARK_NAMED_PARAM(BM_FibLongestPrefixMatch, 10000_scan, 10000, false);
+BENCHMARK_NAMED_PARAM(BM_FibLongestPrefixMatch, 200000_trie, 200000, true);
+BENCHMARK_NAMED_PARAM(BM_FibLongestPrefixMatch, 200000_scan, 200000, false);
+
 } // namespace openr
 
 int
 main(int argc, char** argv) {
   folly::init(&argc, &argv);
-  folly::runBenchmarks();
-  return 0;
+  return openr::runBenchmarks();
 }
@@ -12,6 +12,7 @@
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 #include <thrift/lib/cpp2/util/ScopedServerThread.h>
 
+#include <openr/common/CompactRouteDelta.h>
 #include <openr/common/NetworkUtil.h>
 #include <openr/config/Config.h>
 #include <openr/config/tests/Utils.h>
@@ -214,8 +215,13 @@ checkEqualRouteDatabaseDeltaUnicast(
 
 class FibTestFixture : public ::testing::Test {
  public:
-  explicit FibTestFixture(bool waitOnDecision = false)
-      : waitOnDecision_(waitOnDecision) {}
+  explicit FibTestFixture(
+      bool waitOnDecision = false,
+      std::optional<int32_t> fibSyncBatchSize = std::nullopt,
+      bool enableWarmBoot = false)
+      : waitOnDecision_(waitOnDecision),
+        fibSyncBatchSize_(fibSyncBatchSize),
+        enableWarmBoot_(enableWarmBoot) {}
   void
   SetUp() override {
     mockFibHandler = std::make_shared<MockNetlinkFibHandler>();
@@ -240,6 +246,11 @@ class FibTestFixture : public ::testing::Test {
     if (waitOnDecision_) {
       tConfig.eor_time_s_ref() = 1;
     }
+    if (fibSyncBatchSize_) {
+      tConfig.fib_sync_batch_size_ref() = *fibSyncBatchSize_;
+    }
+    tConfig.enable_fib_warm_boot_ref() = enableWarmBoot_;
+    tConfig.additional_fib_ports_ref() = additionalFibPorts;
 
     config = make_shared<Config>(tConfig);
 
@@ -249,6 +260,7 @@ class FibTestFixture : public ::testing::Test {
         std::chrono::seconds(2), /* coldStartDuration */
         routeUpdatesQueue.getReader(),
         interfaceUpdatesQueue.getReader(),
+        interfaceStatusEventsQueue.getReader(),
         fibUpdatesQueue,
         logSampleQueue,
         nullptr /* KvStore module ptr */);
@@ -272,7 +284,7 @@ class FibTestFixture : public ::testing::Test {
         nullptr /* monitor */,
         nullptr /* configStore */,
         nullptr /* prefixManager */,
-        nullptr /* spark */,
+        {} /* sparkShards */,
         config /* config */);
 
     evbThread = std::make_unique<std::thread>([this]() {
@@ -289,6 +301,7 @@ class FibTestFixture : public ::testing::Test {
     fibUpdatesQueue.close();
     routeUpdatesQueue.close();
     interfaceUpdatesQueue.close();
+    interfaceStatusEventsQueue.close();
     logSampleQueue.close();
 
     LOG(INFO) << "Stopping openr ctrl handler";
@@ -387,8 +400,12 @@ class FibTestFixture : public ::testing::Test {
   std::shared_ptr<ThriftServer> server;
   ScopedServerThread fibThriftThread;
 
-  messaging::ReplicateQueue<DecisionRouteUpdate> routeUpdatesQueue;
-  messaging::ReplicateQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue;
+  // agents programmed along with the one on port
+  std::vector<int32_t> additionalFibPorts;
+
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue;
+  messaging::ReplicateQueue<InterfaceDatabaseUpdate> interfaceUpdatesQueue;
+  messaging::ReplicateQueue<InterfaceStatusEvent> interfaceStatusEventsQueue;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> fibUpdatesQueue;
   messaging::ReplicateQueue<openr::LogSample> logSampleQueue;
 
@@ -405,6 +422,8 @@ class FibTestFixture : public ::testing::Test {
 
  private:
   bool waitOnDecision_{false};
+  std::optional<int32_t> fibSyncBatchSize_;
+  bool enableWarmBoot_{false};
 };
 
 // Fib single streaming client test.
@@ -602,6 +621,72 @@ TEST_F(FibTestFixture, fibStreamingTwoSubscribers) {
   }
 }
 
+// Fib compact streaming client test.
+// Verify delta route additions sharing next-hops define their next-hop group
+// once, and decode to the same updates as on the regular stream.
+TEST_F(FibTestFixture, fibStreamingCompact) {
+  {
+    std::atomic<int> received{0};
+
+    DecisionRouteUpdate routeUpdate1;
+    routeUpdate1.unicastRoutesToUpdate.emplace(
+        toIPNetwork(prefix1),
+        RibUnicastEntry(toIPNetwork(prefix1), {path1_2_1, path1_2_2}));
+    routeUpdatesQueue.push(std::move(routeUpdate1));
+
+    // Start the streaming after OpenrCtrlHandler consumes initial route update.
+    wait_for_initial_update();
+    auto responseAndSubscription =
+        handler->semifuture_subscribeAndGetFibCompact().get();
+    EXPECT_EQ(1, responseAndSubscription.response.unicastRoutes_ref()->size());
+
+    thrift::RouteDatabaseDelta routeDbExpected;
+    (*routeDbExpected.unicastRoutesToUpdate_ref())
+        .emplace_back(createUnicastRoute(prefix2, {path1_2_1, path1_2_2}));
+    (*routeDbExpected.unicastRoutesToUpdate_ref())
+        .emplace_back(createUnicastRoute(prefix3, {path1_2_1, path1_2_2}));
+    DecisionRouteUpdate routeUpdate2;
+    for (auto const& prefix : {prefix2, prefix3}) {
+      routeUpdate2.unicastRoutesToUpdate.emplace(
+          toIPNetwork(prefix),
+          RibUnicastEntry(toIPNetwork(prefix), {path1_2_1, path1_2_2}));
+    }
+
+    CompactRouteDeltaDecoder decoder;
+    auto subscription =
+        std::move(responseAndSubscription.stream)
+            .toClientStream()
+            .subscribeExTry(
+                folly::getEventBase(),
+                [&received, &decoder, &routeDbExpected](auto&& t) {
+                  if (not t.hasValue()) {
+                    return;
+                  }
+                  EXPECT_EQ(1, t->nextHopGroups_ref()->size());
+                  EXPECT_TRUE(checkEqualRouteDatabaseDeltaUnicast(
+                      routeDbExpected, decoder.decode(std::move(*t))));
+                  received++;
+                });
+
+    EXPECT_EQ(1, handler->getNumFibCompactPublishers());
+
+    routeUpdatesQueue.push(std::move(routeUpdate2));
+
+    while (received < 1) {
+      std::this_thread::yield();
+    }
+
+    // Cancel subscription
+    subscription.cancel();
+    std::move(subscription).detach();
+
+    // Wait until publisher is destroyed
+    while (handler->getNumFibCompactPublishers() != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
 TEST_F(FibTestFixture, processRouteDb) {
   // Make sure fib starts with clean route database
   std::vector<thrift::UnicastRoute> routes;
@@ -683,6 +768,133 @@ TEST_F(FibTestFixture, processRouteDb) {
   EXPECT_TRUE(checkEqualRouteDatabaseUnicast(routeDb, getRouteDb()));
 }
 
+TEST_F(FibTestFixture, processRouteDbBurst) {
+  // initial syncFib debounce
+  mockFibHandler->waitForSyncFib();
+  mockFibHandler->waitForSyncMplsFib();
+
+  // Burst of updates for the same prefixes, changes queued behind requests in
+  // flight are coalesced and only the latest one must end up programmed
+  for (int i = 0; i < 100; ++i) {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(RibUnicastEntry(
+        toIPNetwork(prefix2), {i % 2 ? path1_2_1 : path1_2_2}));
+    routeUpdate.addRouteToUpdate(RibUnicastEntry(
+        toIPNetwork(prefix3), {i % 2 ? path1_3_1 : path1_3_2}));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix2), {path1_2_1, path1_2_2}));
+    routeUpdate.unicastRoutesToDelete.emplace_back(toIPNetwork(prefix3));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+
+  std::vector<thrift::UnicastRoute> expectedRoutes{
+      createUnicastRoute(prefix2, {path1_2_1, path1_2_2})};
+  auto isProgrammed = [](std::vector<thrift::UnicastRoute> const& routes) {
+    return routes.size() == 1 and *routes.at(0).dest_ref() == prefix2 and
+        routes.at(0).nextHops_ref()->size() == 2;
+  };
+  std::vector<thrift::UnicastRoute> routes;
+  for (int retry = 0; retry < 100; ++retry) {
+    mockFibHandler->getRouteTableByClient(routes, kFibId);
+    if (isProgrammed(routes)) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  EXPECT_TRUE(isProgrammed(routes));
+  EXPECT_TRUE(checkEqualUnicastRoutes(
+      expectedRoutes, *getRouteDb().unicastRoutes_ref()));
+}
+
+TEST_F(FibTestFixture, retryFailedRoutes) {
+  // initial syncFib debounce
+  mockFibHandler->waitForSyncFib();
+  mockFibHandler->waitForSyncMplsFib();
+  const auto syncCount = mockFibHandler->getFibSyncCount();
+
+  // Route of prefix3 fails to be programmed in the same request as prefix2
+  mockFibHandler->setUnicastRoutesToFail({prefix3});
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix2), {path1_2_1, path1_2_2}));
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix3), {path1_3_1, path1_3_2}));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(1, mockFibHandler->getAddRoutesCount());
+
+  // Failed route alone is retried, without full sync
+  mockFibHandler->setUnicastRoutesToFail({});
+  while (mockFibHandler->getAddRoutesCount() < 2) {
+    mockFibHandler->waitForUpdateUnicastRoutes();
+  }
+  EXPECT_EQ(2, mockFibHandler->getAddRoutesCount());
+  EXPECT_EQ(syncCount, mockFibHandler->getFibSyncCount());
+
+  std::vector<thrift::UnicastRoute> routes;
+  mockFibHandler->getRouteTableByClient(routes, kFibId);
+  EXPECT_EQ(2, routes.size());
+}
+
+/**
+ * Updates leaving next-hops of a route unchanged are not programmed again
+ */
+TEST_F(FibTestFixture, suppressUnchangedRoutes) {
+  // initial syncFib debounce
+  mockFibHandler->waitForSyncFib();
+  mockFibHandler->waitForSyncMplsFib();
+  auto counters = facebook::fb303::fbData->getCounters();
+  const auto numSuppressed = counters["fib.suppressed_route_updates.sum"];
+
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix2), {path1_2_1, path1_2_2}));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(1, mockFibHandler->getAddRoutesCount());
+
+  // Only best prefix entry of prefix2 changes, prefix3 is new
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(RibUnicastEntry(
+        toIPNetwork(prefix2),
+        {path1_2_1, path1_2_2},
+        createPrefixEntry(prefix2, thrift::PrefixType::PREFIX_ALLOCATOR),
+        thrift::KvStore_constants::kDefaultArea()));
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix3), {path1_3_1, path1_3_2}));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(2, mockFibHandler->getAddRoutesCount());
+  EXPECT_EQ(
+      numSuppressed + 1,
+      facebook::fb303::fbData->getCounters().at(
+          "fib.suppressed_route_updates.sum"));
+
+  // Changed next-hops of prefix2 are programmed
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix2), {path1_2_1}));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(3, mockFibHandler->getAddRoutesCount());
+
+  std::vector<thrift::UnicastRoute> routes;
+  mockFibHandler->getRouteTableByClient(routes, kFibId);
+  EXPECT_EQ(2, routes.size());
+}
+
 TEST_F(FibTestFixture, processInterfaceDb) {
   // Make sure fib starts with clean route database
   std::vector<thrift::UnicastRoute> routes;
@@ -905,6 +1117,132 @@ TEST_F(FibTestFixture, processInterfaceDbWithNoIfnameNexthop) {
   EXPECT_EQ(routes[0].nextHops_ref()->size(), 1);
 }
 
+// verify that once all nexthops of a route are down, the route is switched
+// to its backup nexthops instead of being removed
+TEST_F(FibTestFixture, processInterfaceDbLfaBackup) {
+  // initial syncFib debounce
+  mockFibHandler->waitForSyncFib();
+  mockFibHandler->waitForSyncMplsFib();
+
+  // Mimic interface initially coming up
+  thrift::InterfaceDatabase intfDb(
+      FRAGILE,
+      "node-1",
+      {
+          {
+              path1_2_1.address_ref()->ifName_ref().value(),
+              createThriftInterfaceInfo(true, 121, {}),
+          },
+          {
+              path1_2_2.address_ref()->ifName_ref().value(),
+              createThriftInterfaceInfo(true, 122, {}),
+          },
+      },
+      thrift::PerfEvents());
+  intfDb.perfEvents_ref().reset();
+  interfaceUpdatesQueue.push(intfDb);
+
+  // Mimic decision publishing a route with a backup nexthop
+  {
+    DecisionRouteUpdate routeUpdate;
+    RibUnicastEntry route(toIPNetwork(prefix1), {path1_2_1});
+    route.backupNexthops = NextHopSet{path1_2_2};
+    routeUpdate.addRouteToUpdate(std::move(route));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(mockFibHandler->getAddRoutesCount(), 1);
+
+  // Mimic interface of the nexthop going down
+  thrift::InterfaceDatabase intfChange(
+      FRAGILE,
+      "node-1",
+      {
+          {
+              path1_2_1.address_ref()->ifName_ref().value(),
+              createThriftInterfaceInfo(false, 121, {}),
+          },
+      },
+      thrift::PerfEvents());
+  intfChange.perfEvents_ref().reset();
+  interfaceUpdatesQueue.push(intfChange);
+
+  // route is updated to the backup nexthop, not deleted
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(mockFibHandler->getAddRoutesCount(), 2);
+  EXPECT_EQ(mockFibHandler->getDelRoutesCount(), 0);
+  auto routes = fib->getUnicastRoutes({}).get();
+  ASSERT_EQ(1, routes->size());
+  EXPECT_EQ(
+      std::vector<thrift::NextHopThrift>({path1_2_1}),
+      *routes->at(0).nextHops_ref());
+  EXPECT_EQ(
+      std::vector<thrift::NextHopThrift>({path1_2_2}),
+      *routes->at(0).backupNextHops_ref());
+
+  auto counters = facebook::fb303::fbData->getCounters();
+  EXPECT_LE(1, counters.at("fib.lfa_backup_activations.count"));
+}
+
+/**
+ * Status event of an interface prunes and restores only routes over it,
+ * without waiting for the interface database
+ */
+TEST_F(FibTestFixture, processInterfaceStatusEvent) {
+  // initial syncFib debounce
+  mockFibHandler->waitForSyncFib();
+  mockFibHandler->waitForSyncMplsFib();
+
+  // Mimic interface initially coming up
+  thrift::InterfaceDatabase intfDb(
+      FRAGILE,
+      "node-1",
+      {
+          {
+              path1_2_1.address_ref()->ifName_ref().value(),
+              createThriftInterfaceInfo(true, 121, {}),
+          },
+          {
+              path1_2_2.address_ref()->ifName_ref().value(),
+              createThriftInterfaceInfo(true, 122, {}),
+          },
+      },
+      thrift::PerfEvents());
+  intfDb.perfEvents_ref().reset();
+  interfaceUpdatesQueue.push(intfDb);
+
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix1), {path1_2_1}));
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix2), {path1_2_2}));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(mockFibHandler->getAddRoutesCount(), 2);
+
+  // Interface of prefix1 goes down, only prefix1 is withdrawn
+  const auto ifName = path1_2_1.address_ref()->ifName_ref().value();
+  interfaceStatusEventsQueue.push(InterfaceStatusEvent{ifName, false});
+  mockFibHandler->waitForDeleteUnicastRoutes();
+  EXPECT_EQ(mockFibHandler->getAddRoutesCount(), 2);
+  EXPECT_EQ(mockFibHandler->getDelRoutesCount(), 1);
+  std::vector<thrift::UnicastRoute> routes;
+  mockFibHandler->getRouteTableByClient(routes, kFibId);
+  ASSERT_EQ(routes.size(), 1);
+  EXPECT_EQ(prefix2, routes.at(0).dest);
+
+  // Interface comes back up, prefix1 is restored
+  interfaceStatusEventsQueue.push(InterfaceStatusEvent{ifName, true});
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(mockFibHandler->getAddRoutesCount(), 3);
+  EXPECT_EQ(mockFibHandler->getDelRoutesCount(), 1);
+
+  auto counters = facebook::fb303::fbData->getCounters();
+  EXPECT_LE(2, counters.at("fib.interface_status_events.count"));
+}
+
 TEST_F(FibTestFixture, basicAddAndDelete) {
   // Make sure fib starts with clean route database
   std::vector<thrift::UnicastRoute> routes;
@@ -1082,6 +1420,93 @@ TEST_F(FibTestFixtureWaitOnDecision, WaitOnDecision) {
   EXPECT_EQ(mockFibHandler->getDelMplsRoutesCount(), 0);
 }
 
+class FibTestFixtureChunkedSync : public FibTestFixture {
+ public:
+  FibTestFixtureChunkedSync() : FibTestFixture(false, 1) {}
+
+  // wait until the agent has expected number of routes
+  bool
+  waitForRoutes(size_t numUnicastRoutes, size_t numMplsRoutes) {
+    std::vector<thrift::UnicastRoute> routes;
+    std::vector<thrift::MplsRoute> mplsRoutes;
+    for (int retry = 0; retry < 100; ++retry) {
+      mockFibHandler->getRouteTableByClient(routes, kFibId);
+      mockFibHandler->getMplsRouteTableByClient(mplsRoutes, kFibId);
+      if (routes.size() == numUnicastRoutes and
+          mplsRoutes.size() == numMplsRoutes) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return false;
+  }
+};
+
+TEST_F(FibTestFixtureChunkedSync, ChunkedSync) {
+  // Mimic decision pub sock publishing RouteDatabaseDelta
+  DecisionRouteUpdate routeUpdate;
+  routeUpdate.addRouteToUpdate(
+      RibUnicastEntry(toIPNetwork(prefix1), {path1_2_1, path1_2_2}));
+  routeUpdate.addRouteToUpdate(
+      RibUnicastEntry(toIPNetwork(prefix3), {path1_3_1}));
+  routeUpdate.mplsRoutesToUpdate.emplace_back(
+      RibMplsEntry(label1, {mpls_path1_2_1, mpls_path1_2_2}));
+  routeUpdate.mplsRoutesToUpdate.emplace_back(
+      RibMplsEntry(label2, {mpls_path1_2_2}));
+  routeUpdatesQueue.push(std::move(routeUpdate));
+
+  // routes are added one by one instead of a single syncFib
+  EXPECT_TRUE(waitForRoutes(2, 2));
+  EXPECT_EQ(mockFibHandler->getFibSyncCount(), 0);
+  EXPECT_EQ(mockFibHandler->getFibMplsSyncCount(), 0);
+  EXPECT_EQ(mockFibHandler->getAddRoutesCount(), 2);
+  EXPECT_EQ(mockFibHandler->getAddMplsRoutesCount(), 2);
+
+  // agent restart, routes get synced again
+  mockFibHandler->restart();
+  EXPECT_TRUE(waitForRoutes(2, 2));
+  EXPECT_EQ(mockFibHandler->getFibSyncCount(), 0);
+}
+
+class FibTestFixtureWarmBoot : public FibTestFixture {
+ public:
+  FibTestFixtureWarmBoot() : FibTestFixture(true, std::nullopt, true) {}
+};
+
+TEST_F(FibTestFixtureWarmBoot, WarmBoot) {
+  // Routes left in the agent by previous run
+  mockFibHandler->addUnicastRoutes(
+      kFibId,
+      std::make_unique<std::vector<thrift::UnicastRoute>>(
+          std::vector<thrift::UnicastRoute>{
+              createUnicastRoute(prefix1, {path1_2_1, path1_2_2}),
+              createUnicastRoute(prefix2, {path1_2_1}),
+              createUnicastRoute(prefix3, {path1_3_1})}));
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(mockFibHandler->getAddRoutesCount(), 3);
+
+  // prefix1 is unchanged, prefix2 changed and prefix3 is gone
+  DecisionRouteUpdate routeUpdate;
+  routeUpdate.addRouteToUpdate(
+      RibUnicastEntry(toIPNetwork(prefix1), {path1_2_1, path1_2_2}));
+  routeUpdate.addRouteToUpdate(
+      RibUnicastEntry(toIPNetwork(prefix2), {path1_2_2}));
+  routeUpdatesQueue.push(std::move(routeUpdate));
+
+  // only the difference is programmed, no full sync
+  mockFibHandler->waitForDeleteUnicastRoutes();
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(mockFibHandler->getFibSyncCount(), 0);
+  EXPECT_EQ(mockFibHandler->getFibMplsSyncCount(), 0);
+  EXPECT_EQ(mockFibHandler->getAddRoutesCount(), 4);
+  EXPECT_EQ(mockFibHandler->getDelRoutesCount(), 1);
+
+  auto counters = facebook::fb303::fbData->getCounters();
+  EXPECT_EQ(counters.at("fib.warm_boot.routes_retained"), 1);
+  EXPECT_EQ(counters.at("fib.warm_boot.routes_rewritten"), 1);
+  EXPECT_EQ(counters.at("fib.warm_boot.routes_deleted"), 1);
+}
+
 TEST_F(FibTestFixture, getMslpRoutesFilteredTest) {
   // Make sure fib starts with clean route database
   std::vector<thrift::UnicastRoute> routes;
@@ -1432,6 +1857,127 @@ TEST_F(FibTestFixture, ThriftServerError) {
   mockFibHandler->waitForSyncMplsFib();
 }
 
+/**
+ * Routes of requests lost with the connection to the agent are replayed after
+ * reconnecting, without full sync as the agent did not restart
+ */
+TEST_F(FibTestFixture, replayRoutesOnLostConnection) {
+  // initial syncFib debounce
+  mockFibHandler->waitForSyncFib();
+  mockFibHandler->waitForSyncMplsFib();
+  const auto syncCount = mockFibHandler->getFibSyncCount();
+
+  BaseThriftServer::FailureInjection failureInjection;
+  failureInjection.disconnectFraction = 1.0;
+  server->setFailureInjection(failureInjection);
+
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix2), {path1_2_1, path1_2_2}));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+  while (not folly::get_default(
+      facebook::fb303::fbData->getCounters(),
+      "fib.thrift.failure.connection_lost.count",
+      0)) {
+    std::this_thread::yield();
+  }
+
+  server->setFailureInjection(BaseThriftServer::FailureInjection());
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(1, mockFibHandler->getAddRoutesCount());
+  EXPECT_EQ(syncCount, mockFibHandler->getFibSyncCount());
+
+  std::vector<thrift::UnicastRoute> routes;
+  mockFibHandler->getRouteTableByClient(routes, kFibId);
+  EXPECT_EQ(1, routes.size());
+}
+
+class FibTestFixtureMultipleBackends : public FibTestFixture {
+ public:
+  void
+  SetUp() override {
+    secondFibHandler = std::make_shared<MockNetlinkFibHandler>();
+    secondServer = make_shared<ThriftServer>();
+    secondServer->setNumIOWorkerThreads(1);
+    secondServer->setNumAcceptThreads(1);
+    secondServer->setPort(0);
+    secondServer->setInterface(secondFibHandler);
+    secondFibThriftThread.start(secondServer);
+    additionalFibPorts.emplace_back(
+        secondFibThriftThread.getAddress()->getPort());
+
+    FibTestFixture::SetUp();
+  }
+
+  void
+  TearDown() override {
+    FibTestFixture::TearDown();
+    secondFibHandler->stop();
+    secondFibThriftThread.stop();
+  }
+
+  std::shared_ptr<MockNetlinkFibHandler> secondFibHandler;
+  std::shared_ptr<ThriftServer> secondServer;
+  ScopedServerThread secondFibThriftThread;
+};
+
+/**
+ * Routes are programmed to every agent. A failing agent is resynced on its
+ * own without holding back programming of the other one.
+ */
+TEST_F(FibTestFixtureMultipleBackends, independentBackends) {
+  // initial syncFib debounce of both agents
+  mockFibHandler->waitForSyncFib();
+  secondFibHandler->waitForSyncFib();
+
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix2), {path1_2_1, path1_2_2}));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  secondFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(1, mockFibHandler->getAddRoutesCount());
+  EXPECT_EQ(1, secondFibHandler->getAddRoutesCount());
+
+  // Second agent fails every request
+  BaseThriftServer::FailureInjection failureInjection;
+  failureInjection.errorFraction = 1.0;
+  secondServer->setFailureInjection(failureInjection);
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix3), {path1_3_1, path1_3_2}));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+  mockFibHandler->waitForUpdateUnicastRoutes();
+  EXPECT_EQ(2, mockFibHandler->getAddRoutesCount());
+  EXPECT_EQ(1, secondFibHandler->getAddRoutesCount());
+
+  // First agent keeps getting deltas meanwhile
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.unicastRoutesToDelete.emplace_back(toIPNetwork(prefix2));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+  }
+  mockFibHandler->waitForDeleteUnicastRoutes();
+  EXPECT_EQ(1, mockFibHandler->getDelRoutesCount());
+
+  // Second agent catches up with a full sync once it recovers
+  secondServer->setFailureInjection(BaseThriftServer::FailureInjection());
+  secondFibHandler->waitForSyncFib();
+
+  std::vector<thrift::UnicastRoute> routes;
+  mockFibHandler->getRouteTableByClient(routes, kFibId);
+  EXPECT_EQ(1, routes.size());
+  secondFibHandler->getRouteTableByClient(routes, kFibId);
+  ASSERT_EQ(1, routes.size());
+  EXPECT_EQ(prefix3, *routes.at(0).dest_ref());
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
@@ -13,6 +13,7 @@ namespace py3 openr.thrift
 namespace lua openr.Decision
 
 include "Lsdb.thrift"
+include "Network.thrift"
 
 typedef map<string, Lsdb.AdjacencyDatabase>
   (
@@ -23,3 +24,109 @@ typedef map<string, Lsdb.AdjacencyDatabase>
 typedef map<string, Lsdb.PrefixDatabase>
   (cpp.type = "std::unordered_map<std::string, openr::thrift::PrefixDatabase>")
   PrefixDbs
+
+/**
+ * Profile of a route rebuild of Decision. Times are in microseconds, route
+ * computation times include the SPF runs they trigger.
+ */
+struct RouteBuildProfile {
+  // unix timestamp in ms the rebuild finished at
+  1: i64 unixTs = 0
+  // all routes were rebuilt, otherwise only the ones of changed prefixes
+  2: bool fullRebuild = false
+  // built off the event base, see DecisionConfig.enable_async_route_build
+  3: bool asyncBuild = false
+  4: i64 totalUs = 0
+  // SPF runs, i.e. getSpfResult() cache misses
+  5: i64 spfUs = 0
+  6: i64 unicastRoutesUs = 0
+  7: i64 mplsRoutesUs = 0
+  8: i64 ribPolicyUs = 0
+  // diffing routes against the previous ones, when not done while building
+  9: i64 diffUs = 0
+  10: i64 numPrefixes = 0
+  11: i64 spfCacheHits = 0
+  12: i64 spfCacheMisses = 0
+  13: i64 numUnicastRoutesToUpdate = 0
+  14: i64 numUnicastRoutesToDelete = 0
+  15: i64 numMplsRoutesToUpdate = 0
+  16: i64 numMplsRoutesToDelete = 0
+}
+
+enum LinkStateChangeType {
+  // adjacency of a node appeared or disappeared
+  ADJACENCY_UP = 1
+  ADJACENCY_DOWN = 2
+  // attributes of an adjacency changed, e.g. metric or overload bit. Not
+  // emitted for rtt or timestamp only changes
+  ADJACENCY_CHANGED = 3
+  // overload bit of a node changed
+  NODE_OVERLOAD = 4
+  // node started advertising a prefix or changed its entry, or withdrew it
+  PREFIX_ADDED = 5
+  PREFIX_REMOVED = 6
+}
+
+/**
+ * Change of the link state of an area, as applied by Decision
+ */
+struct LinkStateChange {
+  1: LinkStateChangeType type
+  2: string area
+  // node advertising the adjacency or prefix
+  3: string nodeName
+  // ADJACENCY_*: adjacency as advertised after the change, or before for
+  // ADJACENCY_DOWN
+  4: optional Lsdb.Adjacency adjacency
+  // NODE_OVERLOAD: new overload bit of the node
+  5: optional bool isOverloaded
+  // PREFIX_*: prefix, with the entry of the node for PREFIX_ADDED
+  6: optional Network.IpPrefix prefix
+  7: optional Lsdb.PrefixEntry prefixEntry
+}
+
+/**
+ * Link state changes applied by Decision off one or more KvStore
+ * publications, in order
+ */
+struct LinkStateDelta {
+  1: list<LinkStateChange> changes
+}
+
+/**
+ * Link state of all areas, which a stream of LinkStateDelta starts from
+ */
+struct LinkStateDatabases {
+  1: list<Lsdb.AdjacencyDatabase> adjacencyDbs
+  2: PrefixDbs prefixDbs
+}
+
+/**
+ * Link of a node, by the interface name it is advertised with
+ */
+struct WhatIfLink {
+  1: string area
+  2: string nodeName
+  3: string ifName
+}
+
+struct WhatIfMetricChange {
+  1: WhatIfLink link
+  // applied to the adjacency of link.nodeName only, i.e. in one direction
+  2: i32 metric
+}
+
+/**
+ * Hypothetical changes to the link state, which routes are computed against
+ * without affecting the live link state
+ */
+struct WhatIfScenario {
+  1: string name
+  // links going down, in both directions
+  2: list<WhatIfLink> linkFailures
+  // nodes going down in all areas
+  3: list<string> nodeFailures
+  4: list<WhatIfMetricChange> metricChanges
+  // nodes getting overloaded in all areas
+  5: list<string> overloadedNodes
+}
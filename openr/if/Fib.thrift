@@ -32,6 +32,40 @@ struct RouteDatabaseDelta {
   6: optional Lsdb.PerfEvents perfEvents;
 }
 
+/**
+ * Compact encoding of RouteDatabaseDelta for streaming. Next-hops, mostly the
+ * same few ECMP groups across routes, are defined once per stream as a group
+ * with an ID, and routes refer to their group by ID.
+ */
+struct CompactUnicastRoute {
+  1: Network.IpPrefix dest
+  2: i64 nextHopGroupId
+  3: optional Network.AdminDistance adminDistance
+  4: optional Network.PrefixType prefixType
+  5: optional binary data
+  6: bool doNotInstall = false
+  7: optional i64 backupNextHopGroupId
+}
+
+struct CompactMplsRoute {
+  1: i32 topLabel
+  2: i64 nextHopGroupId
+  3: optional Network.AdminDistance adminDistance
+}
+
+struct CompactRouteDatabaseDelta {
+  // Groups defined by this delta, valid for the rest of the stream
+  1: map<i64, list<Network.NextHopThrift>> nextHopGroups
+  // Groups defined by earlier deltas are no longer valid. Set before groups of
+  // this delta are defined, to bound groups a subscriber has to keep
+  2: bool resetNextHopGroups = false
+  3: list<CompactUnicastRoute> unicastRoutesToUpdate
+  4: list<Network.IpPrefix> unicastRoutesToDelete
+  5: list<CompactMplsRoute> mplsRoutesToUpdate
+  6: list<i32> mplsRoutesToDelete
+  7: optional Lsdb.PerfEvents perfEvents
+}
+
 // Perf log buffer maintained by Fib
 struct PerfDatabase {
   1: string thisNodeName
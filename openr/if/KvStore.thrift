@@ -36,8 +36,15 @@ struct Value {
   5: i64 ttlVersion = 0;
   // Hash associated with `tuple<version, originatorId, value>`. Clients
   // should leave it empty and as will be computed by KvStore on `KEY_SET`
-  // operation.
+  // operation. Opaque to other stores, they keep it along with the value
+  // and only compare it, so hash algorithm can differ across versions.
   6: optional i64 hash;
+  // Set by the originator on the last value of a withdrawn key which is left
+  // to expire, see KvStoreClientInternal::clearKey(). Not covered by hash
+  7: optional bool tombstone;
+  // Set if `value` is zstd compressed, see compressValue(). Hash covers the
+  // uncompressed value
+  8: optional bool compressed;
 }
 
 typedef map<string, Value>
@@ -71,7 +78,8 @@ struct KeySetParams {
   3: bool solicitResponse = 1;
 
   // Optional attributes. List of nodes through which this publication has
-  // traversed. Client shouldn't worry about this attribute.
+  // traversed, most recent ones only. Client shouldn't worry about this
+  // attribute.
   5: optional list<string> nodeIds;
 
   // optional flood root-id, indicating which SPT this publication should be
@@ -111,6 +119,18 @@ struct KeyDumpParams {
   // kinds of updates. For example, a consumer might be interesred in
   // getting "adj:.*" keys from open/r domain.
   5: optional list<string> keys;
+
+  // optional attribute for full-sync based on KvStoreMerkleTree digests,
+  // mapping tree node to the digest of peer's key-values under it.
+  //  1) If keyValHashes is NOT set, ONLY respond with mismatchedDigests;
+  //  2) Otherwise, ONLY respond with keyVals on which hash differs among the
+  //     keys under given nodes;
+  8: optional map<i32, i64> keyValDigests
+
+  // optional digest of all key-values of peer, i.e. KvStoreMerkleTree root,
+  // along with keyValHashes. If it matches ours, stores are in sync and
+  // respond with empty keyVals and tobeUpdatedKeys right away
+  9: optional i64 keyValsDigest
 }
 
 // Peer's publication and command socket URLs
@@ -125,6 +145,9 @@ struct PeerSpec {
 
   // thrift port
   4: i32 ctrlPort = 0
+
+  // RTT to peer when it was discovered, peers closest are full-synced first
+  5: optional i64 rttUs
 }
 
 typedef map<string, PeerSpec>
@@ -233,7 +256,8 @@ struct Publication {
   3: list<string> expiredKeys;
 
   // Optional attributes. List of nodes through which this publication has
-  // traversed. Client shouldn't worry about this attribute.
+  // traversed, most recent ones only. Client shouldn't worry about this
+  // attribute.
   4: optional list<string> nodeIds;
 
   // a list of keys that needs to be updated
@@ -247,4 +271,35 @@ struct Publication {
 
   // area to which this publication belongs
   7: string area = kDefaultArea;
+
+  // nodes of KeyDumpParams.keyValDigests whose digest differs, this is only
+  // used for full-sync response to tell full-sync initiator which subtrees
+  // to descend into
+  8: optional list<i32> mismatchedDigests;
+}
+
+// Local checkpoint of KvStore key-values, used to warm start Decision after
+// restart. See OpenrConfig.warm_restart_config
+struct KvStoreSnapshot {
+  // creation time, in ms since epoch
+  1: i64 timestampMs;
+  // key-values per area
+  2: map<string, KeyVals> areaKeyVals;
+}
+
+// KvStore dump followed by the publications received after it, as recorded
+// by openr_kvstore_snooper. Used to replay production LSDBs in benchmarks
+struct KvStoreRecording {
+  1: Publication dump;
+  2: list<Publication> publications;
+  // time each of publications was received at, in ms since dump
+  3: list<i64> timestampsMs;
+}
+
+// Entry of recording file, which is a sequence of them each prefixed by its
+// size as 32 bit big endian, starting with the dump
+struct RecordedPublication {
+  // in ms since dump
+  1: i64 timestampMs;
+  2: Publication publication;
 }
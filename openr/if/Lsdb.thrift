@@ -126,6 +126,32 @@ struct AdjacencyDatabase {
 
   // Adjacency is always a part of an area.
   6: string area
+
+  // Set if the originator announces changes to this database as deltas under
+  // keys starting with "adjdelta:", see AdjacencyDatabaseDelta
+  7: optional i64 snapshotId
+}
+
+// changes to the adjacencies of a router since its last adjacency database
+// snapshot, announced under keys starting with "adjdelta:". Deltas are
+// cumulative, i.e. every delta holds all changes since the snapshot and
+// applies on top of it alone. Changes to node attributes (overload bit, node
+// label) are always announced with a new snapshot.
+struct AdjacencyDatabaseDelta {
+  // must use the same name as used in the key
+  1: string thisNodeName
+
+  // `snapshotId` of the adjacency database this delta applies on
+  2: i64 baseSnapshotId
+
+  // added or changed adjacencies, identified by otherNodeName and ifName
+  3: list<Adjacency> updatedAdjacencies
+
+  // removed adjacencies, identified by otherNodeName and ifName
+  4: list<Adjacency> removedAdjacencies
+
+  // Optional attribute to measure convergence performance
+  5: optional PerfEvents perfEvents;
 }
 
 //
@@ -109,6 +109,7 @@ enum PrefixType {
   BREEZE = 5,   // Prefixes injected via breeze
   RIB = 6,
   SLO_PREFIX_ALLOCATOR = 7,
+  SUMMARY = 8,  // Area border summaries of redistributed RIB routes
 
   // Placeholder Types
   TYPE_1 = 21,
@@ -128,6 +129,11 @@ struct UnicastRoute {
   6: optional binary data
   7: bool doNotInstall = false
 
+  // Loop-free alternates of nextHops over other interfaces, not programmed.
+  // Fib switches the route to them as soon as all of nextHops are down,
+  // ahead of route recomputation
+  8: optional list<NextHopThrift> backupNextHops
+
   41: optional NextHopThrift bestNexthop (deprecated)
 
   # DEPREDCATED - Use nextHops instead
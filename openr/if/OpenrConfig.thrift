@@ -11,6 +11,7 @@ namespace py openr.OpenrConfig
 namespace py3 openr.thrift
 
 include "BgpConfig.thrift"
+include "Network.thrift"
 
 exception ConfigError {
   1: string message
@@ -21,6 +22,28 @@ struct KvstoreFloodRate {
   2: i32 flood_msg_burst_size
 }
 
+/*
+ * How far keys are flooded from their originator
+ *
+ * AREA
+ *   => to all nodes of the area, default
+ * ONE_HOP
+ *   => to direct peers of the originator only
+ * SUBSCRIBERS
+ *   => to the direct peers of the originator listed as subscribers only
+ */
+enum KvstoreFloodScopeType {
+  AREA = 0
+  ONE_HOP = 1
+  SUBSCRIBERS = 2
+}
+
+struct KvstoreFloodScope {
+  1: string key_prefix
+  2: KvstoreFloodScopeType scope = KvstoreFloodScopeType.AREA
+  3: list<string> subscribers = []
+}
+
 struct KvstoreConfig {
   # kvstore
   1: i32 key_ttl_ms = 300000 # 5min 300*1000
@@ -35,6 +58,38 @@ struct KvstoreConfig {
   # flood optimization
   8: optional bool enable_flood_optimization
   9: optional bool is_flood_root
+
+  # full-sync with peers by comparing digests of key ranges, keys are only
+  # exchanged for ranges which differ. Peers must support it.
+  10: optional bool enable_merkle_sync
+
+  # number of threads to merge large publications into KvStore on, shared by
+  # all areas. Merging stays on the KvStore thread if set to 1
+  11: i32 merge_threads = 1
+
+  # flooding scope of keys by prefix, first matching prefix applies. Keys
+  # matching none are flooded to the whole area. All nodes of an area must
+  # agree on them, nodes drop keys received outside of their scope
+  12: list<KvstoreFloodScope> flood_scopes = []
+
+  # zstd compress values of at least this many bytes set on this node, flooded
+  # and synced compressed. All nodes of the domain must support compressed
+  # values. Disabled if unset
+  13: optional i32 value_compression_min_bytes
+
+  # run KvStore database of each area on its own thread, so that syncing and
+  # flooding in one area doesn't delay others. No effect with a single area
+  14: optional bool enable_area_threads
+
+  # full-sync with only this many peers, lowest RTT and up longest first,
+  # until one of them succeeded. The rest then only send key-values still
+  # missing instead of all of them. All peers are synced at once if unset
+  15: optional i32 initial_sync_peers
+
+  # key-values set by modules of this node (LinkMonitor, PrefixManager,
+  # allocators) within this many milliseconds of the first pending one are
+  # merged and flooded together, per area. Applied one by one if unset
+  16: optional i32 local_set_batch_window_ms
 }
 
 struct LinkMonitorConfig {
@@ -44,6 +99,17 @@ struct LinkMonitorConfig {
   4: list<string> include_interface_regexes = []
   5: list<string> exclude_interface_regexes = []
   6: list<string> redistribute_interface_regexes = []
+  # Announce changes to the adjacency database as deltas against the last
+  # full snapshot instead of re-flooding the full database
+  7: bool enable_adj_db_delta = false
+  # With use_rtt_metric, RTT based metrics (RTT in units of 100us) are
+  # rounded up to the next of these increasing buckets, RTT metrics above the
+  # largest bucket are advertised as the largest. Only changes of the bucket
+  # update the adjacency. Empty list advertises metrics as measured
+  8: list<i32> rtt_metric_buckets = []
+  # RTT changes of all neighbors within this window are applied together in
+  # one adjacency update at its end, only the latest RTT of a neighbor counts
+  9: i32 rtt_metric_update_window_ms = 0
 }
 
 struct StepDetectorConfig {
@@ -54,6 +120,24 @@ struct StepDetectorConfig {
    5: i64 ads_threshold = 500
 }
 
+/*
+ * Source of packet timestamps used for RTT measurement
+ *
+ * KERNEL_RX
+ *   => kernel receive timestamps, send time is taken in user space
+ * SOFTWARE
+ *   => kernel receive and transmit timestamps (SO_TIMESTAMPING)
+ * HARDWARE
+ *   => NIC receive and transmit timestamps, falls back to kernel ones for
+ *      packets NIC didn't stamp. NIC timestamping must be enabled and NIC
+ *      clock synchronized with system clock, e.g. with phc2sys
+ */
+enum SparkTimestampingMode {
+  KERNEL_RX = 0
+  SOFTWARE = 1
+  HARDWARE = 2
+}
+
 struct SparkConfig {
   1: i32 neighbor_discovery_port = 6666
 
@@ -65,17 +149,175 @@ struct SparkConfig {
   6: i32 graceful_restart_time_s = 30
 
   7: StepDetectorConfig step_detector_conf
+
+  8: SparkTimestampingMode timestamping_mode = SparkTimestampingMode.KERNEL_RX
+
+  # Send heartbeats in fixed-layout encoding instead of thrift on interfaces
+  # where all adjacent neighbors have announced support for it in handshake
+  9: bool enable_compact_heartbeat = false
+
+  # Number of Spark threads. Interfaces are partitioned across them by name,
+  # each thread with its own socket, so that a burst of work on some
+  # interfaces doesn't delay heartbeats on others
+  10: i32 num_shards = 1
+
+  # Hand ESTABLISHED neighbors over to a liveness provider (BFD daemon or
+  # kernel assisted session) detecting failures within this time. Heartbeat
+  # hold time remains the fallback. 0 disables.
+  11: i32 liveness_detect_time_ms = 0
+
+  # Adapt hello and heartbeat intervals of each interface to its neighbor
+  # stability: shorter right after a neighbor state change, up to 4x longer
+  # after long stable periods. Heartbeat interval stays within a third of
+  # hold time negotiated with neighbors on the interface.
+  12: bool enable_adaptive_intervals = false
+
+  # Attach a BPF filter to the Spark socket, dropping packets of interfaces
+  # Spark doesn't run on, or with hop limit other than 255, in the kernel
+  13: bool enable_ingress_filter = false
+
+  # Persist established neighbors in config store on restart, and reinstate
+  # them on the first heartbeat received after coming back up, instead of
+  # going through hello and handshake negotiation again. Requires graceful
+  # restart to be used.
+  14: bool enable_restart_resync = false
+}
+
+/*
+ * Dampening of flapping prefixes in PrefixManager, after RFC 2439. Each
+ * withdrawal of a prefix entry adds penalty to it, each change of its
+ * attributes half of it. Penalty decays exponentially with half_life_s. Entry
+ * is not advertised from when its penalty reaches suppress_threshold until it
+ * decays below reuse_threshold. Penalty is capped so that no entry stays
+ * suppressed for longer than max_suppress_time_s without flapping again.
+ */
+struct PrefixDampeningConfig {
+  1: i32 penalty = 1000
+  2: i32 suppress_threshold = 2000
+  3: i32 reuse_threshold = 750
+  4: i32 half_life_s = 900
+  5: i32 max_suppress_time_s = 3600
 }
 
 struct WatchdogConfig {
   1: i32 interval_s = 20
   2: i32 thread_timeout_s = 300
   3: i32 max_memory_mb = 800
+  # Memory pressure levels, in percent of max_memory_mb. Modules subscribed to
+  # Watchdog shed caches and pause non-critical work under pressure rather
+  # than letting memory grow to the limit, see MemoryPressure
+  4: i32 memory_pressure_moderate_pct = 70
+  5: i32 memory_pressure_severe_pct = 85
+}
+
+enum ThreadSchedulingPolicy {
+  # SCHED_OTHER, default time-sharing policy
+  OTHER = 0
+  # SCHED_FIFO, real-time first in first out
+  FIFO = 1
+  # SCHED_RR, real-time round robin
+  RR = 2
+}
+
+# CPU placement and scheduling policy of a module thread
+struct ThreadSchedulingConfig {
+  # CPUs the thread is pinned to. Not pinned if empty
+  1: list<i32> cpus = []
+
+  2: ThreadSchedulingPolicy policy = ThreadSchedulingPolicy.OTHER
+
+  # static priority of the real-time policies, 1 (lowest) to 99. Must be 0
+  # with OTHER policy
+  3: i32 priority = 0
 }
 
 struct MonitorConfig {
   1: i32 max_event_log = 100
   2: bool enable_event_log_submission  = true
+  # Log stages of route convergence as spans, one event log per stage of the
+  # perf events of every route update programmed by Fib
+  3: bool enable_perf_spans = false
+  # Keep 1 in N event logs of an "event" name, e.g. to limit overhead of
+  # frequent events like neighbor or KvStore sync events under flaps. Events
+  # not listed are all kept. Sampled out events are neither stored as recent
+  # event logs nor submitted
+  4: map<string, i32> event_log_sample_rates = {}
+}
+
+struct WarmRestartConfig {
+  # File KvStore checkpoints adjacency and prefix key-values into
+  1: string snapshot_file_path = "/tmp/openr_warm_restart_snapshot.bin"
+  2: i32 snapshot_interval_s = 60
+  # Snapshots older than this are ignored on start
+  3: i32 max_snapshot_age_s = 600
+  # How long Decision keeps preloaded key-values which are not received from
+  # KvStore. Should cover initial KvStore sync with peers
+  4: i32 stale_time_s = 60
+}
+
+struct DecisionConfig {
+  # Repair memoized SPF results in place when a single link goes up, down or
+  # changes metric instead of re-running full SPF
+  1: bool enable_incremental_spf = 0
+
+  # Number of worker threads used to compute unicast routes on a full route
+  # rebuild. Prefixes are sharded across workers. 1 computes routes inline on
+  # the Decision thread
+  2: i32 route_build_threads = 1
+
+  # On a topology change only recompute routes for prefixes announced by
+  # nodes whose shortest path metric or next-hops from this node changed,
+  # instead of rebuilding every route. Full rebuild is still done whenever
+  # the change can affect other routes, e.g. a local link changed or LFA or
+  # KSP2_ED_ECMP is in use
+  3: bool enable_topology_impact_analysis = 0
+
+  # Upper bound, per area, on memory held by memoized shortest paths
+  # computations. Least recently used results are evicted after each route
+  # computation once above it. 0 means unbounded
+  4: i64 memoized_results_max_bytes = 0
+
+  # Run full route rebuilds on a dedicated worker thread against a copy of
+  # the link and prefix state, so that the Decision thread keeps serving
+  # queries and KvStore updates meanwhile. A running rebuild is restarted
+  # when newer topology arrives
+  5: bool enable_async_route_build = 0
+
+  # Bounds of the backoff debouncing route rebuilds on topology and prefix
+  # changes. Override --decision_debounce_min_ms/max_ms if set and can be
+  # changed with a config reload
+  6: optional i32 debounce_min_ms
+  7: optional i32 debounce_max_ms
+
+  # Choose the debounce wait from recent update arrival rate and duration of
+  # the last route rebuild, within the bounds above, instead of backing off
+  # exponentially. A single update after a quiet period is handled after the
+  # min bound, while a storm of updates is batched for at least as long as a
+  # rebuild takes
+  8: bool enable_adaptive_debounce = 0
+
+  # On a topology change, first recompute and publish, as a separate update,
+  # routes with a next-hop over a link of this node which is no longer up.
+  # Fib programs them without waiting for the rest of the route rebuild
+  9: bool enable_priority_route_update = 0
+
+  # Precompute loop-free alternates (RFC 5286) of IP forwarded routes as
+  # backup next-hops over other interfaces. Fib switches a route to them
+  # right when all of its next-hops go down, without waiting for route
+  # recomputation. No effect with --enable_lfa, which programs LFAs as
+  # regular next-hops
+  10: bool enable_lfa_backup = 0
+
+  # Weigh IP forwarded SP_ECMP next-hops by the capacity towards the
+  # destination along shortest paths (UCMP), derived from weights of the
+  # adjacencies on the way, e.g. configured per interface. Routes keep equal
+  # weights while capacity is balanced. No effect with --enable_lfa
+  11: bool enable_ucmp = 0
+
+  # Compute routes of this node with the named RouteComputationEngine,
+  # provided by the platform plugin, instead of the built-in SpfSolver. Falls
+  # back to SpfSolver if the plugin doesn't provide it
+  12: optional string route_engine
 }
 
 enum PrefixForwardingType {
@@ -177,6 +419,14 @@ struct AreaConfig {
   1: string area_id
   2: list<string> interface_regexes
   3: list<string> neighbor_regexes
+
+  /**
+   * Aggregates advertised into this area in place of the more specific
+   * routes they cover, which this node redistributes from other areas.
+   * Summary gets advertised as long as at least one such route exists.
+   * e.g. ["10.1.0.0/16", "fc00:1::/48"]
+   */
+  4: list<string> summary_prefixes = []
 }
 
 /**
@@ -275,6 +525,27 @@ struct OpenrConfig {
   # Fib
   22: optional bool enable_ordered_fib_programming
   23: i32 fib_port
+  # max number of routes per request when a full route sync with the switch
+  # agent has to be split up. Smaller route DBs are synced in one request
+  29: i32 fib_sync_batch_size = 10000
+  # program unicast routes of the netlink fib handler via kernel nexthop
+  # groups shared by all routes with same nexthops. Requires linux 5.3+
+  30: bool enable_nexthop_groups = 0
+  # warm-boot: on startup adopt routes found in the switch agent and only
+  # program the difference to routes computed by Decision, instead of a full
+  # route sync. Routes of a previous run are kept in place meanwhile
+  56: bool enable_fib_warm_boot = 0
+  # program routes of the netlink fib handler over a netlink socket per
+  # address family, so that IPv4, IPv6 and MPLS routes are programmed
+  # concurrently instead of one after another
+  57: bool enable_netlink_route_sockets_per_family = 0
+  # initial receive buffer of the netlink event socket. It is doubled, up to
+  # 32MB, whenever kernel drops events as it overran
+  58: i32 netlink_recv_buffer_bytes = 1048576
+  # ports of further switch agents to program routes to along with the one on
+  # fib_port, e.g. a hardware agent next to the kernel. Each is programmed
+  # independently, a slow or failing agent doesn't hold back the others
+  59: list<i32> additional_fib_ports = []
 
   # Enables `RibPolicy` for computed routes. This knob allows thrift APIs to
   # set/get `RibPolicy` in Decision module. For more information refer to
@@ -285,6 +556,9 @@ struct OpenrConfig {
   # Config for monitor module
   25: MonitorConfig monitor_config
 
+  # Config for decision module
+  28: DecisionConfig decision_config
+
   # KvStore thrift migration flags
   # TODO: the following flags serve as rolling-out purpose
   26: bool enable_kvstore_thrift = 1
@@ -304,6 +578,29 @@ struct OpenrConfig {
   # all the expected sources.
   52: i32 prefix_hold_time_s = 15
 
+  # Scheduling of module threads, keyed on thread name, e.g. KvStore,
+  # Decision, Fib, Spark, LinkMonitor, PrefixManager, NetlinkEvb or openrCtrl.
+  # Spark shards `Spark-<id>` fall back to `Spark` config. Threads not listed
+  # keep scheduling inherited from the process. Real-time policies need
+  # CAP_SYS_NICE
+  53: map<string, ThreadSchedulingConfig> thread_scheduling = {}
+
+  # Bind each module thread to its own jemalloc arena, so that memory usage
+  # can be attributed to modules. Per module allocated and resident bytes are
+  # exported by Watchdog and through getModuleMemoryStats() API. No-op if
+  # Open/R is not linked against jemalloc
+  54: bool enable_module_memory_arenas = 0
+
+  # Checkpoint KvStore key-values periodically and preload them into Decision
+  # on restart, so that routes are computed right away instead of after full
+  # KvStore sync and eor_time_s. Preloaded key-values are marked stale, and
+  # dropped unless received from KvStore within stale_time_s
+  55: optional WarmRestartConfig warm_restart_config
+
+  # Dampening of flapping prefixes by type of the prefix entries. Types not
+  # listed are advertised without dampening
+  60: map<Network.PrefixType, PrefixDampeningConfig> prefix_dampening_config
+
   # bgp
   100: optional bool enable_bgp_peering
   102: optional BgpConfig.BgpConfig bgp_config
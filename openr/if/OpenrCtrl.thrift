@@ -48,6 +48,8 @@ struct AdvertisedRouteDetail {
 struct AdvertisedRouteFilter {
   1: optional list<Network.IpPrefix> prefixes;
   2: optional Network.PrefixType prefixType;
+  // Routes of prefixes within this prefix, including itself
+  3: optional Network.IpPrefix coveringPrefix;
 }
 
 struct ReceivedRoute {
@@ -66,6 +68,103 @@ struct ReceivedRouteFilter {
   1: optional list<Network.IpPrefix> prefixes;
   2: optional string nodeName;
   3: optional string areaName;
+  // Routes of prefixes within this prefix, including itself
+  4: optional Network.IpPrefix coveringPrefix;
+}
+
+//
+// Pagination of large results
+//
+
+/**
+ * Position in a large result fetched page by page. Entries are returned in
+ * key order and a page continues after `cursor`, the `nextCursor` of the
+ * previous page. First page is returned if cursor is absent.
+ *
+ * Filtered results may return pages with less than `limit` entries, even
+ * empty ones, before the last page. Fetch until `nextCursor` is absent.
+ */
+struct PageParams {
+  1: optional string cursor;
+  2: i32 limit = 1000;
+}
+
+/**
+ * Unicast routes in prefix order, followed by MPLS routes in label order
+ */
+struct RouteDatabasePage {
+  1: Fib.RouteDatabase routeDb;
+  // cursor of the next page, absent on the last page
+  2: optional string nextCursor;
+}
+
+/**
+ * Key-values in key order
+ */
+struct PublicationPage {
+  1: KvStore.Publication publication;
+  2: optional string nextCursor;
+}
+
+/**
+ * Prefix databases in node name order
+ */
+struct PrefixDbsPage {
+  1: Decision.PrefixDbs prefixDbs;
+  2: optional string nextCursor;
+}
+
+/**
+ * Received routes in prefix order
+ */
+struct ReceivedRoutesPage {
+  1: list<ReceivedRouteDetail> routes;
+  2: optional string nextCursor;
+}
+
+//
+// Batch query related data structures
+//
+
+/**
+ * Getters which can be queried in a batch with getBatch()
+ */
+enum BatchQueryType {
+  KVSTORE_PEERS = 1,
+  NEIGHBORS = 2,
+  INTERFACES = 3,
+  COUNTERS = 4,
+  ROUTE_DB = 5,
+  ROUTE_DB_COMPUTED = 6,
+  DECISION_ADJACENCY_DBS = 7,
+  LINK_MONITOR_ADJACENCIES = 8,
+}
+
+struct BatchQuery {
+  1: BatchQueryType type;
+  // area of KVSTORE_PEERS
+  2: string area = KvStore.kDefaultArea;
+  // node of ROUTE_DB_COMPUTED, current node if empty
+  3: string nodeName;
+  // counters of COUNTERS, all counters if absent
+  4: optional list<string> counterKeys;
+}
+
+/**
+ * Result of a BatchQuery. Only the field of the query type is set, or
+ * `error` if the query failed.
+ */
+struct BatchResult {
+  1: BatchQueryType type;
+  2: optional string error;
+  3: optional KvStore.PeersMap kvStorePeers;
+  4: optional list<Spark.SparkNeighbor> neighbors;
+  5: optional LinkMonitor.DumpLinksReply interfaces;
+  6: optional map<string, i64> counters;
+  // result of ROUTE_DB and ROUTE_DB_COMPUTED
+  7: optional Fib.RouteDatabase routeDb;
+  8: optional Decision.AdjDbs decisionAdjacencyDbs;
+  9: optional Lsdb.AdjacencyDatabase linkMonitorAdjacencies;
 }
 
 //
@@ -73,19 +172,36 @@ struct ReceivedRouteFilter {
 //
 
 /**
- * Matcher selects the routes. As of now supports selecting specified routes,
- * but can be expanded to select route by tags as well.
+ * Range of prefixes under `prefix`, with length from `ge` to `le`, e.g.
+ * `10.0.0.0/8 le 24` selects 10.0.0.0/8 and every prefix under it up to /24.
+ * `ge` defaults to length of `prefix`. `le` defaults to the max length of the
+ * address family if `ge` is set, to `ge` otherwise i.e. only `prefix` itself
+ * is selected if neither is set.
+ */
+struct RibPrefixRange {
+  1: Network.IpPrefix prefix;
+  2: optional i32 ge;
+  3: optional i32 le;
+}
+
+/**
+ * Matcher selects the routes, by prefix and/or by tags of the best prefix
+ * entry of the route.
  *
  * - Atleast one criteria must be specified for selection
- * - `AND` operator is assumed for selecting on multiple attributes.
+ * - `AND` operator is assumed for selecting on multiple attributes. `prefixes`
+ *   and `prefix_ranges` are one attribute, route is selected by prefix if it
+ *   is in either of them
  * - setting criteria to none will skip the matching
  */
 struct RibRouteMatcher {
   1: optional list<Network.IpPrefix> prefixes;
 
   // Select route based on the tag. Specifying multiple tag match on any
-  // TODO: Enable this when `PrefixEntry` have tag information available
-  // 2: optoinal list<string> tags;
+  2: optional list<string> tags;
+
+  // Select routes of prefixes in any of the ranges
+  3: optional list<RibPrefixRange> prefix_ranges;
 }
 
 /**
@@ -161,6 +277,60 @@ struct RibPolicy {
   2: i32 ttl_secs;
 }
 
+/**
+ * CPU placement and scheduling policy of an Open/R thread, as reported by the
+ * kernel. See OpenrConfig.thread_scheduling.
+ */
+struct ThreadPlacement {
+  1: string name;
+  2: i64 tid;
+  // CPUs the thread is allowed to run on
+  3: list<i32> cpus;
+  4: OpenrConfig.ThreadSchedulingPolicy policy;
+  5: i32 priority;
+}
+
+/**
+ * Memory accounted to an Open/R module through its dedicated jemalloc arena.
+ * See OpenrConfig.enable_module_memory_arenas.
+ */
+struct ModuleMemoryStats {
+  1: string module;
+  2: i32 arena;
+  // bytes in active allocations
+  3: i64 allocated_bytes;
+  // bytes in physically resident pages mapped by the arena
+  4: i64 resident_bytes;
+}
+
+/**
+ * Stacks of an Open/R thread sampled by profileThread(), collapsed as input of
+ * flamegraph.pl
+ */
+struct ThreadProfile {
+  1: string name;
+  2: i64 tid;
+  // samples taken, and of those dropped as the sample buffer was full
+  3: i64 samples;
+  4: i64 dropped_samples;
+  // "<frame>;<frame>;... <count>" per distinct stack, outermost frame first
+  5: list<string> collapsed_stacks;
+}
+
+/**
+ * Binary representation of an event log, see openr/monitor/LogSample.h. Values
+ * are keyed by type like the categories of its JSON representation
+ * ("int", "double", "normal", "normvector" and "tagset").
+ */
+struct LogSampleData {
+  // includes "time", seconds since epoch the event was generated at
+  1: map<string, i64> int_values;
+  2: map<string, double> double_values;
+  3: map<string, string> string_values;
+  4: map<string, list<string>> string_vector_values;
+  5: map<string, set<string>> string_tagset_values;
+}
+
 /**
  * Thrift service - exposes RPC APIs for interaction with all of Open/R's
  * modules.
@@ -192,6 +362,16 @@ service OpenrCtrl extends fb303_core.BaseService {
   string dryrunConfig(1: string file)
     throws (1: OpenrError error)
 
+  /**
+   * Reload config from file without restart. Only runtime tunable knobs may
+   * differ from the running config: kvstore flood_rate, decision
+   * debounce_min_ms/debounce_max_ms and fib_sync_batch_size. Config is applied
+   * to KvStore, Decision and Fib, and rolled back on all of them if any fails.
+   * Returns the new config version.
+   */
+  i64 reloadConfig(1: string file)
+    throws (1: OpenrError error)
+
   //
   // PrefixManager APIs
   //
@@ -256,12 +436,26 @@ service OpenrCtrl extends fb303_core.BaseService {
   list<ReceivedRouteDetail> getReceivedRoutesFiltered(
       1: ReceivedRouteFilter filter) throws (1: OpenrError error);
 
+  /**
+   * Paginated getReceivedRoutesFiltered for large routing tables. See
+   * PageParams.
+   */
+  ReceivedRoutesPage getReceivedRoutesFilteredPage(
+      1: ReceivedRouteFilter filter,
+      2: PageParams page) throws (1: OpenrError error);
+
   /**
    * Get route database of the current node. It is retrieved from FIB module.
    */
   Fib.RouteDatabase getRouteDb()
     throws (1: OpenrError error)
 
+  /**
+   * Paginated getRouteDb for large routing tables. See PageParams.
+   */
+  RouteDatabasePage getRouteDbPage(1: PageParams page)
+    throws (1: OpenrError error)
+
   /**
    * Get route database from decision module. Since Decision has global
    * topology information, any node can be retrieved.
@@ -271,6 +465,25 @@ service OpenrCtrl extends fb303_core.BaseService {
   Fib.RouteDatabase getRouteDbComputed(1: string nodeName)
     throws (1: OpenrError error)
 
+  /**
+   * Batch getRouteDbComputed, in the order of `nodeNames`. Routes of all
+   * nodes in the topology are returned if `nodeNames` is empty. Route
+   * databases are computed off the route computation path and cached until
+   * the topology changes, calling it for many nodes is cheap.
+   */
+  list<Fib.RouteDatabase> getRouteDbComputedBatch(1: list<string> nodeNames)
+    throws (1: OpenrError error)
+
+  /**
+   * Routes of node `nodeName` for each of `scenarios`, in their order. Routes
+   * are computed in parallel against copies of the current link state, live
+   * routes are unaffected. Current node's routes if `nodeName` is empty.
+   */
+  list<Fib.RouteDatabase> getRouteDbWhatIf(
+    1: string nodeName,
+    2: list<Decision.WhatIfScenario> scenarios,
+  ) throws (1: OpenrError error)
+
   /**
    * Get unicast routes after applying a list of prefix filter.
    * Perform longest prefix match for each input filter among the prefixes
@@ -341,6 +554,19 @@ service OpenrCtrl extends fb303_core.BaseService {
    */
   Decision.PrefixDbs getDecisionPrefixDbs() throws (1: OpenrError error)
 
+  /**
+   * Paginated getDecisionPrefixDbs for large networks. See PageParams.
+   */
+  PrefixDbsPage getDecisionPrefixDbsPage(1: PageParams page)
+    throws (1: OpenrError error)
+
+  /**
+   * Get profiles of the most recent route rebuilds, oldest first. Aggregates
+   * are exported as `decision.route_build.*` counters as well.
+   */
+  list<Decision.RouteBuildProfile> getDecisionRouteBuildProfiles()
+    throws (1: OpenrError error)
+
   //
   // Get area feature configuration
   //
@@ -381,6 +607,16 @@ service OpenrCtrl extends fb303_core.BaseService {
     2: string area = KvStore.kDefaultArea
   ) throws (1: OpenrError error)
 
+  /**
+   * Paginated getKvStoreKeyValsFilteredArea for large KvStores. See
+   * PageParams. Hash and digest based dumps for full-sync are not supported.
+   */
+  PublicationPage getKvStoreKeyValsFilteredAreaPage(
+    1: KvStore.KeyDumpParams filter,
+    2: string area = KvStore.kDefaultArea,
+    3: PageParams page
+  ) throws (1: OpenrError error)
+
   /**
    * Get kvstore metadata (no values) with filter
    */
@@ -410,6 +646,15 @@ service OpenrCtrl extends fb303_core.BaseService {
   bool longPollKvStoreAdj(1: KvStore.KeyVals snapshot)
     throws (1: OpenrError error)
 
+  /**
+   * Long poll API to get KvStore of specific area. Pending requests are
+   * notified only on "adj:" key change in their area.
+   */
+  bool longPollKvStoreAdjArea(
+    1: KvStore.KeyVals snapshot,
+    2: string area = KvStore.kDefaultArea
+  ) throws (1: OpenrError error)
+
   /**
    * Send Dual message
    */
@@ -510,6 +755,39 @@ service OpenrCtrl extends fb303_core.BaseService {
    */
   LinkMonitor.BuildInfo getBuildInfo() throws (1: OpenrError error)
 
+  /**
+   * Get CPU placement and scheduling policy of Open/R threads
+   */
+  list<ThreadPlacement> getThreadPlacements() throws (1: OpenrError error)
+
+  /**
+   * Get memory usage per module. Empty unless module memory arenas are
+   * enabled and Open/R runs on jemalloc
+   */
+  list<ModuleMemoryStats> getModuleMemoryStats() throws (1: OpenrError error)
+
+  /**
+   * Dump heap profile of the process on the local disk and return path of
+   * the file. Requires jemalloc with profiling enabled (MALLOC_CONF=prof:true)
+   */
+  string dumpHeapProfile() throws (1: OpenrError error)
+
+  /**
+   * Sample stacks of an Open/R thread, named as in getThreadPlacements(),
+   * every interval_us of CPU time it consumes for duration_ms, at most 60s.
+   * Returns once done, collapsed stacks can be rendered with flamegraph.pl
+   */
+  ThreadProfile profileThread(
+    1: string thread_name,
+    2: i32 duration_ms = 10000,
+    3: i32 interval_us = 1000) throws (1: OpenrError error)
+
+  /**
+   * Get startup timing of modules as perf events <module>_INIT_START and
+   * <module>_INIT_DONE, in order of their occurrence
+   */
+  Lsdb.PerfEvents getStartupPerfEvents() throws (1: OpenrError error)
+
   //
   // PersistentStore APIs (query / alter dynamic configuration)
   //
@@ -556,6 +834,12 @@ service OpenrCtrl extends fb303_core.BaseService {
   // Get Openr Node Name
   string getMyNodeName()
 
+  /**
+   * Run queries in one round-trip. Queries are run in parallel, results are
+   * in order of queries. A failing query doesn't fail the others.
+   */
+  list<BatchResult> getBatch(1: list<BatchQuery> queries)
+
   //
   // RibPolicy
   //
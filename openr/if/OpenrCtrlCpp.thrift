@@ -8,6 +8,7 @@
 namespace cpp2 openr.thrift
 namespace py3 openr.thrift
 
+include "openr/if/Decision.thrift"
 include "openr/if/Fib.thrift"
 include "openr/if/KvStore.thrift"
 include "openr/if/OpenrCtrl.thrift"
@@ -38,4 +39,39 @@ service OpenrCtrlCpp extends OpenrCtrl.OpenrCtrl {
 
   Fib.RouteDatabase, stream<Fib.RouteDatabaseDelta> subscribeAndGetFib()
 
+  /**
+   * Same as subscribeAndGetFib, with updates in compact encoding. See
+   * Fib.CompactRouteDatabaseDelta
+   */
+  Fib.RouteDatabase, stream<Fib.CompactRouteDatabaseDelta>
+    subscribeAndGetFibCompact()
+
+  /**
+   * Retrieve adjacency and prefix databases of all areas and subscribe for
+   * subsequent changes of them, e.g. adjacency up/down or prefix withdrawn,
+   * as applied by Decision. Like subscribeAndGetFib, no change after the
+   * snapshot is lost, though some may be reflected in the snapshot already.
+   */
+  Decision.LinkStateDatabases, stream<Decision.LinkStateDelta>
+    subscribeAndGetLinkState()
+
+  /**
+   * Stream large results in chunks of up to `pageSize` entries instead of
+   * a single response. Chunks are the pages of the paginated APIs, fetched
+   * one after the other, and the stream completes after the last one.
+   */
+  stream<Fib.RouteDatabase> streamRouteDb(1: i32 pageSize)
+
+  stream<list<OpenrCtrl.ReceivedRouteDetail>> streamReceivedRoutesFiltered(
+    1: OpenrCtrl.ReceivedRouteFilter filter,
+    2: i32 pageSize,
+  )
+
+  stream<Decision.PrefixDbs> streamDecisionPrefixDbs(1: i32 pageSize)
+
+  stream<KvStore.Publication> streamKvStoreKeyValsFilteredArea(
+    1: KvStore.KeyDumpParams filter,
+    2: string area,
+    3: i32 pageSize,
+  )
 }
@@ -48,6 +48,17 @@ exception PlatformError {
   1: string message
 } ( message = "message" )
 
+/**
+ * Routes of a batch request which failed to be programmed. Others of the batch
+ * are programmed, so that the client needs to retry only these.
+ */
+exception PlatformFibUpdateError {
+  1: list<Network.IpPrefix> failedAddUpdatePrefixes
+  2: list<Network.IpPrefix> failedDeletePrefixes
+  3: list<i32> failedAddUpdateMplsLabels
+  4: list<i32> failedDeleteMplsLabels
+}
+
 // static mapping of clientId => protocolId, priority same of admin distance
 // For Open/R.
 //    ClientId: 786 => ProtocolId: 99, Priority: 10
@@ -90,12 +101,18 @@ service FibService extends fb303_core.BaseService {
   void addUnicastRoutes(
     1: i16 clientId,
     2: list<Network.UnicastRoute> routes,
-  ) throws (1: PlatformError error)
+  ) throws (
+    1: PlatformError error,
+    2: PlatformFibUpdateError fibError,
+  )
 
   void deleteUnicastRoutes(
     1: i16 clientId,
     2: list<Network.IpPrefix> prefixes,
-  ) throws (1: PlatformError error)
+  ) throws (
+    1: PlatformError error,
+    2: PlatformFibUpdateError fibError,
+  )
 
   void syncFib(
     1: i16 clientId,
@@ -113,12 +130,18 @@ service FibService extends fb303_core.BaseService {
   void addMplsRoutes(
     1: i16 clientId,
     2: list<Network.MplsRoute> routes,
-  ) throws (1: PlatformError error)
+  ) throws (
+    1: PlatformError error,
+    2: PlatformFibUpdateError fibError,
+  )
 
   void deleteMplsRoutes(
     1: i16 clientId,
     2: list<i32> topLabels,
-  ) throws (1: PlatformError error)
+  ) throws (
+    1: PlatformError error,
+    2: PlatformFibUpdateError fibError,
+  )
 
   // Flush previous routes and install new routes without disturbing
   // traffic. Similar to syncFib API
@@ -106,6 +106,12 @@ struct SparkHandshakeMsg {
   // TODO: Remove optional qualifier after AREA negotiation
   //       is fully in use
   11: optional string neighborNodeName
+
+  // Highest version of compact heartbeat encoding sender can receive, and
+  // the id it puts into its own compact heartbeats instead of its name.
+  // Peers not announcing it only get thrift encoded heartbeats.
+  12: optional i32 compactHeartbeatVersion
+  13: optional i64 heartbeatSenderId
 }
 
 struct SparkHelloPacket {
@@ -181,3 +187,30 @@ struct SparkNeighborEvent {
   // full snapshot of neighbor information
   2: SparkNeighbor info
 }
+
+//
+// Established neighbor as persisted by Spark before graceful restart
+//
+struct SparkPersistedNeighbor {
+  // neighbor info, including label allocated for it
+  1: SparkNeighbor info
+
+  // hold times negotiated with neighbor
+  2: i64 heartbeatHoldTimeMs
+  3: i64 gracefulRestartHoldTimeMs
+
+  // id neighbor uses in compact heartbeats, if it sends them
+  4: optional i64 heartbeatSenderId
+}
+
+//
+// Spark state persisted in config store, to reinstate neighbors after
+// graceful restart
+//
+struct SparkPersistedState {
+  // unix timestamp of persisting, entries older than graceful restart hold
+  // time of neighbor are stale
+  1: i64 persistedAtMs
+
+  2: list<SparkPersistedNeighbor> neighbors
+}
@@ -7,6 +7,10 @@
 
 #include "KvStore.h"
 
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
 #include <fb303/ServiceData.h>
 #include <fbzmq/service/logging/LogSample.h>
 #include <fbzmq/zmq/Zmq.h>
@@ -14,9 +18,13 @@
 #include <folly/GLog.h>
 #include <folly/Random.h>
 #include <folly/String.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 
 #include <openr/common/Constants.h>
+#include <openr/common/SerializationBuffer.h>
+#include <openr/common/StatHandle.h>
 #include <openr/common/Util.h>
+#include <openr/kvstore/KvStoreSnapshot.h>
 #include <openr/if/gen-cpp2/OpenrCtrl_types.h>
 
 using namespace std::chrono;
@@ -49,6 +57,19 @@ getKvStoreFilters(std::shared_ptr<const openr::Config> config) {
   }
   return kvFilters;
 }
+
+// copy of value without the value binary, used to exchange hashes
+openr::thrift::Value
+getHashValue(openr::thrift::Value const& value) {
+  DCHECK(value.hash_ref().has_value());
+  openr::thrift::Value hashValue;
+  hashValue.version_ref() = *value.version_ref();
+  *hashValue.originatorId_ref() = *value.originatorId_ref();
+  hashValue.hash_ref().copy_from(value.hash_ref());
+  hashValue.ttl_ref() = *value.ttl_ref();
+  hashValue.ttlVersion_ref() = *value.ttlVersion_ref();
+  return hashValue;
+}
 } // namespace
 
 namespace openr {
@@ -119,6 +140,20 @@ KvStoreFilters::getOriginatorIdList() const {
   return originatorIds_;
 }
 
+std::vector<std::string> const*
+KvStoreFilters::getLiteralKeyPrefixes(
+    thrift::FilterOperator const& oper) const {
+  auto const& literalPrefixes = keyPrefixObjList_.getLiteralPrefixes();
+  if (keyPrefixList_.empty() or not literalPrefixes.has_value()) {
+    return nullptr;
+  }
+  // keys of matching originators match regardless of their prefix
+  if (oper == thrift::FilterOperator::OR and not originatorIds_.empty()) {
+    return nullptr;
+  }
+  return &literalPrefixes.value();
+}
+
 std::string
 KvStoreFilters::str() const {
   std::string result{};
@@ -136,7 +171,7 @@ KvStoreFilters::str() const {
 KvStore::KvStore(
     // initializers for immutable state
     fbzmq::Context& zmqContext,
-    messaging::ReplicateQueue<thrift::Publication>& kvStoreUpdatesQueue,
+    messaging::ReplicateQueue<PublicationPtr>& kvStoreUpdatesQueue,
     messaging::ReplicateQueue<KvStoreSyncEvent>& kvStoreSyncEventsQueue,
     messaging::RQueue<thrift::PeerUpdateRequest> peerUpdateQueue,
     messaging::ReplicateQueue<LogSample>& logSampleQueue,
@@ -169,7 +204,8 @@ KvStore::KvStore(
               *config->getKvStoreConfig().ttl_decrement_ms_ref()),
           config->getKvStoreConfig().enable_flood_optimization_ref().value_or(
               false),
-          config->getKvStoreConfig().is_flood_root_ref().value_or(false)),
+          config->getKvStoreConfig().is_flood_root_ref().value_or(false),
+          config->getKvStoreConfig().enable_merkle_sync_ref().value_or(false)),
       areas_(config->getAreaIds()) {
   // Schedule periodic timer for counters submission
   counterUpdateTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
@@ -225,13 +261,45 @@ KvStore::KvStore(
     }
   });
 
-  // create KvStoreDb instances
+  // merge large publications on multiple threads if configured
+  auto const mergeThreads = *config->getKvStoreConfig().merge_threads_ref();
+  if (mergeThreads > 1) {
+    mergeExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+        mergeThreads,
+        std::make_shared<folly::NamedThreadFactory>("KvStoreMerge"));
+    kvParams_.mergeExecutor = mergeExecutor_.get();
+    kvParams_.mergeThreads = mergeThreads;
+  }
+  kvParams_.floodScopes = *config->getKvStoreConfig().flood_scopes_ref();
+  if (auto minBytes =
+          config->getKvStoreConfig().value_compression_min_bytes_ref()) {
+    kvParams_.valueCompressionMinBytes = *minBytes;
+  }
+  if (auto syncPeers = config->getKvStoreConfig().initial_sync_peers_ref()) {
+    kvParams_.initialSyncPeers = *syncPeers;
+  }
+  if (auto batchWindow =
+          config->getKvStoreConfig().local_set_batch_window_ms_ref()) {
+    kvParams_.localSetBatchWindow = std::chrono::milliseconds(*batchWindow);
+  }
+
+  // create KvStoreDb instances, on event bases of their own if configured
+  const bool enableAreaThreads =
+      config->getKvStoreConfig().enable_area_threads_ref().value_or(false) and
+      areas_.size() > 1;
   for (auto const& area : areas_) {
+    OpenrEventBase* evb = this;
+    if (enableAreaThreads) {
+      auto& areaEvb = areaEvbs_[area];
+      areaEvb = std::make_unique<OpenrEventBase>();
+      areaEvb->setEvbName(folly::sformat("KvStore.{}", area));
+      evb = areaEvb.get();
+    }
     kvStoreDb_.emplace(
         std::piecewise_construct,
         std::forward_as_tuple(area),
         std::forward_as_tuple(
-            this,
+            evb,
             kvParams_,
             area,
             fbzmq::Socket<ZMQ_ROUTER, fbzmq::ZMQ_CLIENT>(
@@ -243,174 +311,379 @@ KvStore::KvStore(
             config->getKvStoreConfig().is_flood_root_ref().value_or(false),
             config->getNodeName()));
   }
+  for (auto& [area, areaEvb] : areaEvbs_) {
+    areaEvbThreads_.emplace_back([area = area, evb = areaEvb.get()]() noexcept {
+      LOG(INFO) << "Starting KvStoreDb thread of area " << area;
+      evb->run();
+      LOG(INFO) << "KvStoreDb thread of area " << area << " got stopped.";
+    });
+  }
+
+  // Checkpoint key-values periodically for warm restart
+  if (config->isWarmRestartEnabled()) {
+    warmRestartConfig_ = config->getWarmRestartConfig();
+    snapshotWriter_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+        1, std::make_shared<folly::NamedThreadFactory>("KvStoreSnapshot"));
+    snapshotTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
+      writeWarmRestartSnapshot();
+      snapshotTimer_->scheduleTimeout(std::chrono::seconds(
+          *warmRestartConfig_->snapshot_interval_s_ref()));
+    });
+    snapshotTimer_->scheduleTimeout(
+        std::chrono::seconds(*warmRestartConfig_->snapshot_interval_s_ref()));
+  }
+}
+
+void
+KvStore::writeWarmRestartSnapshot() {
+  // Only key-values Decision computes routes from
+  const KvStoreFilters filters(
+      {Constants::kAdjDbMarker.toString(),
+       Constants::kAdjDbDeltaMarker.toString(),
+       Constants::kPrefixDbMarker.toString()},
+      {} /* originatorIds */);
+
+  thrift::KvStoreSnapshot snapshot;
+  snapshot.timestampMs_ref() = getUnixTimeStampMs();
+  forEachKvStoreDb([&](std::string const& area, KvStoreDb& kvStoreDb) {
+    snapshot.areaKeyVals_ref()[area] =
+        std::move(*kvStoreDb.dumpAllWithFilters(filters).keyVals_ref());
+  });
+
+  snapshotWriter_->add(
+      [path = *warmRestartConfig_->snapshot_file_path_ref(),
+       snapshot = std::move(snapshot)]() {
+        if (writeKvStoreSnapshot(path, snapshot)) {
+          fb303::fbData->addStatValue(
+              "kvstore.warm_restart_snapshots", 1, fb303::COUNT);
+        }
+      });
 }
 
 void
 KvStore::stop() {
   getEvb()->runImmediatelyOrRunInEventBaseThreadAndWait([this]() {
+    if (snapshotTimer_) {
+      snapshotTimer_->cancelTimeout();
+    }
+    // Stop event bases of areas first. Their KvStoreDb instances are then
+    // destroyed from here, as event bases no longer running are accessible
+    // from any thread
+    for (auto& [_, areaEvb] : areaEvbs_) {
+      areaEvb->stop();
+    }
+    for (auto& thread : areaEvbThreads_) {
+      thread.join();
+    }
+    areaEvbThreads_.clear();
+
     // NOTE: destructor of every instance inside `kvStoreDb_` will gracefully
     //       exit and wait for all pending thrift requests to be processed
     //       before eventbase stops.
     kvStoreDb_.clear();
   });
 
+  // Let an in-flight snapshot finish writing
+  if (snapshotWriter_) {
+    snapshotWriter_->join();
+  }
+
   // Invoke stop method of super class
   OpenrEventBase::stop();
 }
 
 // static, public
-std::unordered_map<std::string, thrift::Value>
-KvStore::mergeKeyValues(
-    std::unordered_map<std::string, thrift::Value>& kvStore,
-    std::unordered_map<std::string, thrift::Value> const& keyVals,
+namespace {
+// Fewer key-values per shard are merged serially, as fanning out to merge
+// threads costs more than it saves
+const size_t kMinKeyValsPerMergeShard{1000};
+
+// What merging a key-value into a KvStore needs to do
+struct PreparedMerge {
+  bool updateAllNeeded{false};
+  bool updateTtlNeeded{false};
+  // value to store if updateAllNeeded, with hash filled in
+  thrift::Value newValue;
+};
+
+// Decide how to merge key-value into kvStore. Only reads kvStore, so it can
+// run concurrently for distinct keys as long as nobody modifies kvStore
+PreparedMerge
+prepareMerge(
+    std::unordered_map<std::string, thrift::Value> const& kvStore,
+    std::string const& key,
+    thrift::Value const& value,
     std::optional<KvStoreFilters> const& filters) {
-  // the publication to build if we update our KV store
-  std::unordered_map<std::string, thrift::Value> kvUpdates;
+  PreparedMerge merge;
+  if (filters.has_value() && not filters->keyMatch(key, value)) {
+    VLOG(4) << "key: " << key << " not adding from "
+            << *value.originatorId_ref();
+    return merge;
+  }
 
-  // Counters for logging
-  uint32_t ttlUpdateCnt{0}, valUpdateCnt{0};
+  // versions must start at 1; setting this to zero here means
+  // we would be beaten by any version supplied by the setter
+  int64_t myVersion{0};
+  int64_t newVersion = *value.version_ref();
 
-  for (const auto& [key, value] : keyVals) {
-    if (filters.has_value() && not filters->keyMatch(key, value)) {
-      VLOG(4) << "key: " << key << " not adding from "
-              << *value.originatorId_ref();
-      continue;
-    }
+  // Check if TTL is valid. It must be infinite or positive number
+  // Skip if invalid!
+  if (*value.ttl_ref() != Constants::kTtlInfinity && *value.ttl_ref() <= 0) {
+    return merge;
+  }
 
-    // versions must start at 1; setting this to zero here means
-    // we would be beaten by any version supplied by the setter
-    int64_t myVersion{0};
-    int64_t newVersion = *value.version_ref();
+  // if key exist, compare values first
+  // if they are the same, no need to propagate changes
+  auto kvStoreIt = kvStore.find(key);
+  if (kvStoreIt != kvStore.end()) {
+    myVersion = *kvStoreIt->second.version_ref();
+  } else {
+    VLOG(4) << "(mergeKeyValues) key: '" << key << "' not found, adding";
+  }
 
-    // Check if TTL is valid. It must be infinite or positive number
-    // Skip if invalid!
-    if (*value.ttl_ref() != Constants::kTtlInfinity && *value.ttl_ref() <= 0) {
-      continue;
-    }
+  // If we get an old value just skip it
+  if (newVersion < myVersion) {
+    return merge;
+  }
 
-    // if key exist, compare values first
-    // if they are the same, no need to propagate changes
-    auto kvStoreIt = kvStore.find(key);
-    if (kvStoreIt != kvStore.end()) {
-      myVersion = *kvStoreIt->second.version_ref();
-    } else {
-      VLOG(4) << "(mergeKeyValues) key: '" << key << "' not found, adding";
+  bool updateAllNeeded{false};
+  bool updateTtlNeeded{false};
+
+  //
+  // Check updateAll and updateTtl
+  //
+  if (value.value_ref().has_value()) {
+    if (newVersion > myVersion) {
+      // Version is newer or
+      // kvStoreIt is NULL(myVersion is set to 0)
+      updateAllNeeded = true;
+    } else if (
+        *value.originatorId_ref() > *kvStoreIt->second.originatorId_ref()) {
+      // versions are the same but originatorId is higher
+      updateAllNeeded = true;
+    } else if (
+        *value.originatorId_ref() == *kvStoreIt->second.originatorId_ref()) {
+      // This can occur after kvstore restarts or simply reconnects after
+      // disconnection. We let one of the two values win if they
+      // differ(higher in this case but can be lower as long as it's
+      // deterministic). Otherwise, local store can have new value while
+      // other stores have old value and they never sync.
+      int rc = (*value.value_ref()).compare(*kvStoreIt->second.value_ref());
+      if (rc > 0) {
+        // versions and orginatorIds are same but value is higher
+        VLOG(3) << "Previous incarnation reflected back for key " << key;
+        updateAllNeeded = true;
+      } else if (rc == 0) {
+        // versions, orginatorIds, value are all same
+        // retain higher ttlVersion
+        if (*value.ttlVersion_ref() > *kvStoreIt->second.ttlVersion_ref()) {
+          updateTtlNeeded = true;
+        }
+      }
     }
+  }
 
-    // If we get an old value just skip it
-    if (newVersion < myVersion) {
-      continue;
-    }
+  //
+  // Check updateTtl
+  //
+  if (not value.value_ref().has_value() and kvStoreIt != kvStore.end() and
+      *value.version_ref() == *kvStoreIt->second.version_ref() and
+      *value.originatorId_ref() == *kvStoreIt->second.originatorId_ref() and
+      *value.ttlVersion_ref() > *kvStoreIt->second.ttlVersion_ref()) {
+    updateTtlNeeded = true;
+  }
 
-    bool updateAllNeeded{false};
-    bool updateTtlNeeded{false};
+  if (!updateAllNeeded and !updateTtlNeeded) {
+    VLOG(3) << "(mergeKeyValues) no need to update anything for key: '" << key
+            << "'";
+    return merge;
+  }
 
-    //
-    // Check updateAll and updateTtl
-    //
-    if (value.value_ref().has_value()) {
-      if (newVersion > myVersion) {
-        // Version is newer or
-        // kvStoreIt is NULL(myVersion is set to 0)
-        updateAllNeeded = true;
-      } else if (
-          *value.originatorId_ref() > *kvStoreIt->second.originatorId_ref()) {
-        // versions are the same but originatorId is higher
-        updateAllNeeded = true;
-      } else if (
-          *value.originatorId_ref() == *kvStoreIt->second.originatorId_ref()) {
-        // This can occur after kvstore restarts or simply reconnects after
-        // disconnection. We let one of the two values win if they
-        // differ(higher in this case but can be lower as long as it's
-        // deterministic). Otherwise, local store can have new value while
-        // other stores have old value and they never sync.
-        int rc = (*value.value_ref()).compare(*kvStoreIt->second.value_ref());
-        if (rc > 0) {
-          // versions and orginatorIds are same but value is higher
-          VLOG(3) << "Previous incarnation reflected back for key " << key;
-          updateAllNeeded = true;
-        } else if (rc == 0) {
-          // versions, orginatorIds, value are all same
-          // retain higher ttlVersion
-          if (*value.ttlVersion_ref() > *kvStoreIt->second.ttlVersion_ref()) {
-            updateTtlNeeded = true;
-          }
-        }
-      }
+  VLOG(3)
+      << "Updating key: " << key << "\n  Version: " << myVersion << " -> "
+      << newVersion << "\n  Originator: "
+      << (kvStoreIt != kvStore.end() ? *kvStoreIt->second.originatorId_ref()
+                                     : "null")
+      << " -> " << *value.originatorId_ref() << "\n  TtlVersion: "
+      << (kvStoreIt != kvStore.end() ? *kvStoreIt->second.ttlVersion_ref()
+                                     : 0)
+      << " -> " << *value.ttlVersion_ref() << "\n  Ttl: "
+      << (kvStoreIt != kvStore.end() ? *kvStoreIt->second.ttl_ref() : 0)
+      << " -> " << *value.ttl_ref();
+
+  merge.updateAllNeeded = updateAllNeeded;
+  merge.updateTtlNeeded = updateTtlNeeded;
+  if (updateAllNeeded) {
+    CHECK(value.value_ref().has_value());
+    // grab the new value (this will copy, intended)
+    merge.newValue = value;
+    // update hash if it's not there
+    if (not merge.newValue.hash_ref().has_value()) {
+      merge.newValue.hash_ref() = generateHash(value);
     }
+  }
+  return merge;
+}
 
-    //
-    // Check updateTtl
-    //
-    if (not value.value_ref().has_value() and kvStoreIt != kvStore.end() and
-        *value.version_ref() == *kvStoreIt->second.version_ref() and
-        *value.originatorId_ref() == *kvStoreIt->second.originatorId_ref() and
-        *value.ttlVersion_ref() > *kvStoreIt->second.ttlVersion_ref()) {
-      updateTtlNeeded = true;
+// Filters of a key dump request
+std::pair<KvStoreFilters, thrift::FilterOperator>
+getKeyDumpFilters(thrift::KeyDumpParams const& keyDumpParams) {
+  std::vector<std::string> keyPrefixList;
+  if (keyDumpParams.keys_ref().has_value()) {
+    keyPrefixList = *keyDumpParams.keys_ref();
+  } else {
+    folly::split(",", *keyDumpParams.prefix_ref(), keyPrefixList, true);
+  }
+  thrift::FilterOperator oper = thrift::FilterOperator::OR;
+  if (keyDumpParams.oper_ref().has_value()) {
+    oper = *keyDumpParams.oper_ref();
+  }
+  return {
+      KvStoreFilters(keyPrefixList, *keyDumpParams.originatorIds_ref()), oper};
+}
+
+// Hash key-values of a set request, and compress values of at least
+// `compressionMinBytes` if set. Compressed values keep their hash, which
+// the originator computed over the uncompressed value
+void
+prepareSetKeyVals(
+    thrift::KeyVals& keyVals, std::optional<size_t> compressionMinBytes) {
+  for (auto& [_, value] : keyVals) {
+    if (not value.value_ref().has_value()) {
+      continue;
     }
+    if (value.compressed_ref().value_or(false)) {
+      if (not value.hash_ref().has_value()) {
+        value.hash_ref() = generateHash(value);
+      }
+      continue;
+    }
+    value.hash_ref() = generateHash(
+        *value.version_ref(), *value.originatorId_ref(), value.value_ref());
 
-    if (!updateAllNeeded and !updateTtlNeeded) {
-      VLOG(3) << "(mergeKeyValues) no need to update anything for key: '" << key
-              << "'";
+    auto const size = value.value_ref()->size();
+    if (not compressionMinBytes.has_value() or
+        size < compressionMinBytes.value()) {
       continue;
     }
+    auto const startTime = std::chrono::steady_clock::now();
+    if (compressValue(value)) {
+      fb303::fbData->addStatValue(
+          "kvstore.value_compression.bytes_in", size, fb303::SUM);
+      fb303::fbData->addStatValue(
+          "kvstore.value_compression.bytes_out",
+          value.value_ref()->size(),
+          fb303::SUM);
+      fb303::fbData->addStatValue(
+          "kvstore.value_compression.ratio_pct",
+          value.value_ref()->size() * 100 / size,
+          fb303::AVG);
+    }
+    fb303::fbData->addStatValue(
+        "kvstore.value_compression.time_us",
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - startTime)
+            .count(),
+        fb303::AVG);
+  }
+}
+} // namespace
 
-    VLOG(3)
-        << "Updating key: " << key << "\n  Version: " << myVersion << " -> "
-        << newVersion << "\n  Originator: "
-        << (kvStoreIt != kvStore.end() ? *kvStoreIt->second.originatorId_ref()
-                                       : "null")
-        << " -> " << *value.originatorId_ref() << "\n  TtlVersion: "
-        << (kvStoreIt != kvStore.end() ? *kvStoreIt->second.ttlVersion_ref()
-                                       : 0)
-        << " -> " << *value.ttlVersion_ref() << "\n  Ttl: "
-        << (kvStoreIt != kvStore.end() ? *kvStoreIt->second.ttl_ref() : 0)
-        << " -> " << *value.ttl_ref();
+std::unordered_map<std::string, thrift::Value>
+KvStore::mergeKeyValues(
+    std::unordered_map<std::string, thrift::Value>& kvStore,
+    std::unordered_map<std::string, thrift::Value> const& keyVals,
+    std::optional<KvStoreFilters> const& filters,
+    folly::Executor* executor,
+    size_t numShards) {
+  // the publication to build if we update our KV store
+  std::unordered_map<std::string, thrift::Value> kvUpdates;
 
-    // grab the new value (this will copy, intended)
-    thrift::Value newValue = value;
+  // Counters for logging
+  uint32_t ttlUpdateCnt{0}, valUpdateCnt{0};
 
-    if (updateAllNeeded) {
+  auto applyMerge = [&](std::string const& key,
+                        thrift::Value const& value,
+                        PreparedMerge&& merge) {
+    if (merge.updateAllNeeded) {
       ++valUpdateCnt;
       FB_LOG_EVERY_MS(INFO, 500)
           << "Updating key: " << key
           << ", Originator: " << *value.originatorId_ref()
-          << ", Version: " << newVersion
+          << ", Version: " << *value.version_ref()
           << ", TtlVersion: " << *value.ttlVersion_ref()
           << ", Ttl: " << *value.ttl_ref();
       //
-      // update everything for such key
+      // update everything for such key, the old value will be destructed
       //
-      CHECK(value.value_ref().has_value());
-      if (kvStoreIt == kvStore.end()) {
-        // create new entry
-        std::tie(kvStoreIt, std::ignore) = kvStore.emplace(
-            std::piecewise_construct,
-            std::forward_as_tuple(key),
-            std::forward_as_tuple(std::move(newValue)));
-      } else {
-        // update the entry in place, the old value will be destructed
-        kvStoreIt->second = std::move(newValue);
-      }
-      // update hash if it's not there
-      if (not kvStoreIt->second.hash_ref().has_value()) {
-        kvStoreIt->second.hash_ref() = generateHash(
-            *value.version_ref(), *value.originatorId_ref(), value.value_ref());
-      }
-    } else if (updateTtlNeeded) {
+      kvStore.insert_or_assign(key, std::move(merge.newValue));
+    } else if (merge.updateTtlNeeded) {
       ++ttlUpdateCnt;
       //
       // update ttl,ttlVersion only
       //
+      auto kvStoreIt = kvStore.find(key);
       CHECK(kvStoreIt != kvStore.end());
 
       // update TTL only, nothing else
       kvStoreIt->second.ttl_ref() = *value.ttl_ref();
       kvStoreIt->second.ttlVersion_ref() = *value.ttlVersion_ref();
+
+      // announce ttl updates without value, receivers already have it. Keeps
+      // batches of ttl refreshes compact when flooded
+      kvUpdates.emplace(key, createThriftValueWithoutBinaryValue(value));
+      return;
+    } else {
+      return;
     }
 
     // announce the update
     kvUpdates.emplace(key, value);
+  };
+
+  numShards = std::min(numShards, keyVals.size() / kMinKeyValsPerMergeShard);
+  if (not executor or numShards <= 1) {
+    for (const auto& [key, value] : keyVals) {
+      applyMerge(key, value, prepareMerge(kvStore, key, value, filters));
+    }
+  } else {
+    // Spread keys across shards by hash and prepare merges of every shard in
+    // parallel while kvStore is only read. Then apply them shard by shard,
+    // which leaves kvStore and the updates the same as merging serially
+    using KeyValPtr = std::pair<std::string const*, thrift::Value const*>;
+    std::vector<std::vector<KeyValPtr>> shardKeyVals(numShards);
+    for (const auto& [key, value] : keyVals) {
+      shardKeyVals.at(std::hash<std::string>()(key) % numShards)
+          .emplace_back(&key, &value);
+    }
+
+    std::vector<std::vector<PreparedMerge>> shardMerges(numShards);
+    std::vector<folly::Future<folly::Unit>> shardFutures;
+    shardFutures.reserve(numShards);
+    for (size_t i = 0; i < numShards; ++i) {
+      shardFutures.emplace_back(folly::via(executor, [&, i]() {
+        auto& merges = shardMerges.at(i);
+        merges.reserve(shardKeyVals.at(i).size());
+        for (auto const& [key, value] : shardKeyVals.at(i)) {
+          merges.emplace_back(prepareMerge(kvStore, *key, *value, filters));
+        }
+      }));
+    }
+
+    // Wait for every shard before applying, shards refer to locals
+    for (auto& result : folly::collectAll(std::move(shardFutures)).get()) {
+      result.throwIfFailed();
+    }
+
+    for (size_t i = 0; i < numShards; ++i) {
+      auto& keyValPtrs = shardKeyVals.at(i);
+      for (size_t j = 0; j < keyValPtrs.size(); ++j) {
+        applyMerge(
+            *keyValPtrs.at(j).first,
+            *keyValPtrs.at(j).second,
+            std::move(shardMerges.at(i).at(j)));
+      }
+    }
   }
 
   VLOG(4) << "(mergeKeyValues) updating " << kvUpdates.size()
@@ -548,7 +821,10 @@ KvStore::processRequestMsg(
   VLOG(2) << "Request received for area " << area;
   try {
     auto& kvStoreDb = kvStoreDb_.at(area);
-    auto response = kvStoreDb.processRequestMsgHelper(requestId, thriftRequest);
+    folly::Expected<fbzmq::Message, fbzmq::Error> response;
+    getAreaEvb(area)->runImmediatelyOrRunInEventBaseThreadAndWait([&]() {
+      response = kvStoreDb.processRequestMsgHelper(requestId, thriftRequest);
+    });
     if (response.hasValue()) {
       fb303::fbData->addStatValue(
           "kvstore.peers.bytes_sent", response->size(), fb303::SUM);
@@ -562,7 +838,7 @@ KvStore::processRequestMsg(
   return {folly::makeUnexpected(fbzmq::Error())};
 }
 
-messaging::RQueue<thrift::Publication>
+messaging::RQueue<PublicationPtr>
 KvStore::getKvStoreUpdatesReader() {
   return kvParams_.kvStoreUpdatesQueue.getReader();
 }
@@ -584,10 +860,11 @@ KvStore::getKvStoreKeyVals(
     thrift::KeyGetParams keyGetParams, std::string area) {
   folly::Promise<std::unique_ptr<thrift::Publication>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        keyGetParams = std::move(keyGetParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             keyGetParams = std::move(keyGetParams),
+                             area]() mutable {
     VLOG(3) << "Get key requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -611,10 +888,11 @@ KvStore::dumpKvStoreKeys(
     thrift::KeyDumpParams keyDumpParams, std::string area) {
   folly::Promise<std::unique_ptr<thrift::Publication>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        keyDumpParams = std::move(keyDumpParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             keyDumpParams = std::move(keyDumpParams),
+                             area]() mutable {
     VLOG(3) << "Dump all keys requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -624,25 +902,27 @@ KvStore::dumpKvStoreKeys(
       fb303::fbData->addStatValue("kvstore.cmd_key_dump", 1, fb303::COUNT);
 
       auto& kvStoreDb = kvStoreDb_.at(area);
-      std::vector<std::string> keyPrefixList;
-      if (keyDumpParams.keys_ref().has_value()) {
-        keyPrefixList = *keyDumpParams.keys_ref();
+      const auto [keyPrefixMatch, oper] = getKeyDumpFilters(keyDumpParams);
+
+      thrift::Publication thriftPub;
+      if (auto keyValDigests = keyDumpParams.keyValDigests_ref()) {
+        // digest based full-sync from neighbor, filters don't apply
+        thriftPub = keyDumpParams.keyValHashes_ref().has_value()
+            ? kvStoreDb.dumpDifferenceUnderNodes(
+                  *keyValDigests, keyDumpParams.keyValHashes_ref().value())
+            : kvStoreDb.dumpMismatchedDigests(*keyValDigests);
       } else {
-        folly::split(",", *keyDumpParams.prefix_ref(), keyPrefixList, true);
-      }
-      const auto keyPrefixMatch =
-          KvStoreFilters(keyPrefixList, *keyDumpParams.originatorIds_ref());
-
-      thrift::FilterOperator oper = thrift::FilterOperator::OR;
-      if (keyDumpParams.oper_ref().has_value()) {
-        oper = *keyDumpParams.oper_ref();
-      }
-
-      auto thriftPub = kvStoreDb.dumpAllWithFilters(
-          keyPrefixMatch, oper, *keyDumpParams.doNotPublishValue_ref());
-      if (keyDumpParams.keyValHashes_ref().has_value()) {
-        thriftPub = kvStoreDb.dumpDifference(
-            *thriftPub.keyVals_ref(), keyDumpParams.keyValHashes_ref().value());
+        thriftPub = keyDumpParams.keyValHashes_ref().has_value()
+            ? kvStoreDb.dumpDifferenceWithFilters(
+                  keyPrefixMatch,
+                  oper,
+                  *keyDumpParams.doNotPublishValue_ref(),
+                  keyDumpParams.keyValHashes_ref().value(),
+                  keyDumpParams.keyValsDigest_ref().to_optional())
+            : kvStoreDb.dumpAllWithFilters(
+                  keyPrefixMatch,
+                  oper,
+                  *keyDumpParams.doNotPublishValue_ref());
       }
       kvStoreDb.updatePublicationTtl(thriftPub);
       // I'm the initiator, set flood-root-id
@@ -669,15 +949,60 @@ KvStore::dumpKvStoreKeys(
   return sf;
 }
 
+folly::SemiFuture<std::unique_ptr<thrift::PublicationPage>>
+KvStore::dumpKvStoreKeysPage(
+    thrift::KeyDumpParams keyDumpParams,
+    std::string area,
+    thrift::PageParams page) {
+  auto [p, sf] =
+      folly::makePromiseContract<std::unique_ptr<thrift::PublicationPage>>();
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             keyDumpParams = std::move(keyDumpParams),
+                             area = std::move(area),
+                             page = std::move(page)]() mutable {
+    if (not kvStoreDb_.count(area)) {
+      p.setException(
+          thrift::OpenrError(folly::sformat("Invalid area: {}", area)));
+      return;
+    }
+    if (keyDumpParams.keyValHashes_ref().has_value() or
+        keyDumpParams.keyValDigests_ref().has_value()) {
+      p.setException(
+          thrift::OpenrError("Full-sync key dump can't be paginated"));
+      return;
+    }
+    fb303::fbData->addStatValue("kvstore.cmd_key_dump_page", 1, fb303::COUNT);
+
+    auto& kvStoreDb = kvStoreDb_.at(area);
+    const auto [keyPrefixMatch, oper] = getKeyDumpFilters(keyDumpParams);
+    auto publicationPage = std::make_unique<thrift::PublicationPage>();
+    std::optional<std::string> nextCursor;
+    *publicationPage->publication_ref() = kvStoreDb.dumpPageWithFilters(
+        keyPrefixMatch,
+        oper,
+        *keyDumpParams.doNotPublishValue_ref(),
+        page.cursor_ref().to_optional(),
+        std::max(0, *page.limit_ref()),
+        nextCursor);
+    kvStoreDb.updatePublicationTtl(*publicationPage->publication_ref());
+    publicationPage->nextCursor_ref().from_optional(std::move(nextCursor));
+    p.setValue(std::move(publicationPage));
+  });
+  return std::move(sf);
+}
+
 folly::SemiFuture<std::unique_ptr<thrift::Publication>>
 KvStore::dumpKvStoreHashes(
     thrift::KeyDumpParams keyDumpParams, std::string area) {
   folly::Promise<std::unique_ptr<thrift::Publication>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        keyDumpParams = std::move(keyDumpParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             keyDumpParams = std::move(keyDumpParams),
+                             area]() mutable {
     VLOG(3) << "Dump all hashes requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -708,10 +1033,11 @@ KvStore::setKvStoreKeyVals(
     thrift::KeySetParams keySetParams, std::string area) {
   folly::Promise<folly::Unit> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        keySetParams = std::move(keySetParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             keySetParams = std::move(keySetParams),
+                             area]() mutable {
     VLOG(3) << "Set key requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -731,15 +1057,8 @@ KvStore::setKvStoreKeyVals(
 
       // Update hash for key-values
       auto& kvStoreDb = kvStoreDb_.at(area);
-      for (auto& kv : *keySetParams.keyVals_ref()) {
-        auto& value = kv.second;
-        if (value.value_ref().has_value()) {
-          value.hash_ref() = generateHash(
-              *value.version_ref(),
-              *value.originatorId_ref(),
-              value.value_ref());
-        }
-      }
+      prepareSetKeyVals(
+          *keySetParams.keyVals_ref(), kvParams_.valueCompressionMinBytes);
 
       // Create publication and merge it with local KvStore
       thrift::Publication rcvdPublication;
@@ -756,6 +1075,29 @@ KvStore::setKvStoreKeyVals(
   return sf;
 }
 
+folly::SemiFuture<folly::Unit>
+KvStore::setLocalKvStoreKeyVals(thrift::KeyVals keyVals, std::string area) {
+  folly::Promise<folly::Unit> p;
+  auto sf = p.getSemiFuture();
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             keyVals = std::move(keyVals),
+                             area]() mutable {
+    VLOG(3) << "Local set key requested for AREA: " << area;
+
+    if (!kvStoreDb_.count(area)) {
+      LOG(ERROR) << "Local set key requested for invalid area: " << area;
+      p.setException(
+          thrift::OpenrError(folly::sformat("Invalid area: {}", area)));
+    } else {
+      fb303::fbData->addStatValue("kvstore.cmd_key_set", 1, fb303::COUNT);
+      kvStoreDb_.at(area).setLocalKeyVals(std::move(keyVals), std::move(p));
+    }
+  });
+  return sf;
+}
+
 folly::SemiFuture<std::unique_ptr<thrift::AreasConfig>>
 KvStore::getAreasConfig() {
   folly::Promise<std::unique_ptr<thrift::AreasConfig>> p;
@@ -773,7 +1115,8 @@ KvStore::getKvStorePeerState(
     std::string const& peerName, std::string const& area) {
   folly::Promise<std::optional<KvStorePeerState>> promise;
   auto sf = promise.getSemiFuture();
-  runInEventBaseThread(
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread(
       [this, p = std::move(promise), peerName, area]() mutable {
         if (!kvStoreDb_.count(area)) {
           p.setValue(std::nullopt);
@@ -790,7 +1133,8 @@ folly::SemiFuture<std::unique_ptr<thrift::PeersMap>>
 KvStore::getKvStorePeers(std::string area) {
   folly::Promise<std::unique_ptr<thrift::PeersMap>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this, p = std::move(p), area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this, p = std::move(p), area]() mutable {
     VLOG(2) << "Peer dump requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -811,10 +1155,11 @@ KvStore::addUpdateKvStorePeers(
     thrift::PeerAddParams peerAddParams, std::string area) {
   folly::Promise<folly::Unit> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        peerAddParams = std::move(peerAddParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             peerAddParams = std::move(peerAddParams),
+                             area]() mutable {
     auto peersToAdd = folly::gen::from(*peerAddParams.peers_ref()) |
         folly::gen::get<0>() | folly::gen::as<std::vector<std::string>>();
 
@@ -842,10 +1187,11 @@ KvStore::deleteKvStorePeers(
     thrift::PeerDelParams peerDelParams, std::string area) {
   folly::Promise<folly::Unit> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        peerDelParams = std::move(peerDelParams),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             peerDelParams = std::move(peerDelParams),
+                             area]() mutable {
     LOG(INFO) << "Peer deletion for: ["
               << folly::join(",", *peerDelParams.peerNames_ref())
               << "] in area: " << area;
@@ -870,7 +1216,8 @@ folly::SemiFuture<std::unique_ptr<thrift::SptInfos>>
 KvStore::getSpanningTreeInfos(std::string area) {
   folly::Promise<std::unique_ptr<thrift::SptInfos>> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this, p = std::move(p), area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this, p = std::move(p), area]() mutable {
     VLOG(3) << "FLOOD_TOPO_GET command requested for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -890,20 +1237,56 @@ KvStore::updateFloodTopologyChild(
     thrift::FloodTopoSetParams floodTopoSetParams, std::string area) {
   folly::Promise<folly::Unit> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        floodTopoSetParams = std::move(floodTopoSetParams),
-                        area]() mutable {
-    VLOG(2) << "FLOOD_TOPO_SET command requested for AREA: " << area;
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread(
+      [this,
+       p = std::move(p),
+       floodTopoSetParams = std::move(floodTopoSetParams),
+       area]() mutable {
+        VLOG(2) << "FLOOD_TOPO_SET command requested for AREA: " << area;
 
-    if (!kvStoreDb_.count(area)) {
-      p.setException(
-          thrift::OpenrError(folly::sformat("Invalid area: {}", area)));
-    } else {
-      auto& kvStoreDb = kvStoreDb_.at(area);
-      kvStoreDb.processFloodTopoSet(std::move(floodTopoSetParams));
-      p.setValue();
+        if (!kvStoreDb_.count(area)) {
+          p.setException(
+              thrift::OpenrError(folly::sformat("Invalid area: {}", area)));
+        } else {
+          auto& kvStoreDb = kvStoreDb_.at(area);
+          kvStoreDb.processFloodTopoSet(std::move(floodTopoSetParams));
+          p.setValue();
+        }
+      });
+  return sf;
+}
+
+folly::SemiFuture<folly::Unit>
+KvStore::applyConfig(std::shared_ptr<const Config> config) {
+  folly::Promise<folly::Unit> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([this, p = std::move(p), config]() mutable {
+    kvParams_.floodRate =
+        config->getKvStoreConfig().flood_rate_ref().to_optional();
+    forEachKvStoreDb([](std::string const&, KvStoreDb& kvStoreDb) {
+      kvStoreDb.updateFloodRate();
+    });
+    fb303::fbData->setCounter("kvstore.config_version", config->getVersion());
+    p.setValue();
+  });
+  return sf;
+}
+
+folly::SemiFuture<folly::Unit>
+KvStore::setMemoryPressure(MemoryPressure level) {
+  folly::Promise<folly::Unit> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([this, p = std::move(p), level]() mutable {
+    if (level != MemoryPressure::NONE) {
+      size_t numCompacted = 0;
+      forEachKvStoreDb([&](std::string const&, KvStoreDb& kvStoreDb) {
+        numCompacted += kvStoreDb.compactTombstones();
+      });
+      fb303::fbData->addStatValue(
+          "kvstore.compacted_tombstones", numCompacted, fb303::SUM);
     }
+    p.setValue();
   });
   return sf;
 }
@@ -913,10 +1296,11 @@ KvStore::processKvStoreDualMessage(
     thrift::DualMessages dualMessages, std::string area) {
   folly::Promise<folly::Unit> p;
   auto sf = p.getSemiFuture();
-  runInEventBaseThread([this,
-                        p = std::move(p),
-                        dualMessages = std::move(dualMessages),
-                        area]() mutable {
+  auto* evb = getAreaEvb(area);
+  evb->runInEventBaseThread([this,
+                             p = std::move(p),
+                             dualMessages = std::move(dualMessages),
+                             area]() mutable {
     VLOG(2) << "DUAL messages received for AREA: " << area;
 
     if (!kvStoreDb_.count(area)) {
@@ -947,10 +1331,10 @@ KvStore::getCounters() {
 }
 
 std::map<std::string, int64_t>
-KvStore::getGlobalCounters() const {
+KvStore::getGlobalCounters() {
   std::map<std::string, int64_t> flatCounters;
-  for (auto& kvDb : kvStoreDb_) {
-    auto kvDbCounters = kvDb.second.getCounters();
+  forEachKvStoreDb([&](std::string const&, KvStoreDb& kvStoreDb) {
+    auto kvDbCounters = kvStoreDb.getCounters();
     // add up counters for same key from all kvStoreDb instances
     flatCounters = std::accumulate(
         kvDbCounters.begin(),
@@ -961,10 +1345,25 @@ KvStore::getGlobalCounters() const {
           flatCounters[kvDbcounter.first] += kvDbcounter.second;
           return flatCounters;
         });
-  }
+  });
   return flatCounters;
 }
 
+folly::EventBase*
+KvStore::getAreaEvb(std::string const& area) {
+  auto it = areaEvbs_.find(area);
+  return it != areaEvbs_.end() ? it->second->getEvb() : getEvb();
+}
+
+void
+KvStore::forEachKvStoreDb(
+    folly::FunctionRef<void(std::string const&, KvStoreDb&)> func) {
+  for (auto& it : kvStoreDb_) {
+    getAreaEvb(it.first)->runImmediatelyOrRunInEventBaseThreadAndWait(
+        [&]() { func(it.first, it.second); });
+  }
+}
+
 //
 // This is the state transition matrix for KvStorePeerState. It is a
 // sparse-matrix with row representing `KvStorePeerState` and column
@@ -1031,6 +1430,35 @@ KvStoreDb::getPeersByState(KvStorePeerState state) {
   return res;
 }
 
+std::vector<std::string>
+KvStoreDb::getIdlePeersBySyncPriority() const {
+  std::vector<KvStorePeer const*> peers;
+  for (auto const& [_, peer] : thriftPeers_) {
+    if (peer.state == KvStorePeerState::IDLE) {
+      peers.emplace_back(&peer);
+    }
+  }
+  // peers of unknown RTT go last
+  auto const getRttUs = [](KvStorePeer const* peer) {
+    return peer->peerSpec.rttUs_ref().value_or(
+        std::numeric_limits<int64_t>::max());
+  };
+  std::sort(
+      peers.begin(),
+      peers.end(),
+      [&](KvStorePeer const* a, KvStorePeer const* b) {
+        return std::make_tuple(getRttUs(a), a->addTime, a->nodeName) <
+            std::make_tuple(getRttUs(b), b->addTime, b->nodeName);
+      });
+
+  std::vector<std::string> res;
+  res.reserve(peers.size());
+  for (auto const* peer : peers) {
+    res.emplace_back(peer->nodeName);
+  }
+  return res;
+}
+
 // static util function to log state transition
 void
 KvStoreDb::logStateTransition(
@@ -1096,6 +1524,7 @@ KvStoreDb::KvStorePeer::KvStorePeer(
 //  kvstore.thrift.num_full_sync_success: # of successful full-sync performed;
 //  kvstore.thrift.num_full_sync_failure: # of failed full-sync performed;
 //  kvstore.thrift.full_sync_duration_ms: avg time elapsed for a full-sync req;
+//  kvstore.thrift.num_merkle_sync_rounds: # of digest based full-sync req;
 //
 //  kvstore.thrift.num_flood_pub: # of flooding req issued;
 //  kvstore.thrift.num_flood_key_vals: # of keyVals one flooding req contains;
@@ -1126,20 +1555,7 @@ KvStoreDb::KvStoreDb(
       area_(area),
       peerSyncSock_(std::move(peersyncSock)),
       evb_(evb) {
-  if (kvParams_.floodRate) {
-    floodLimiter_ = std::make_unique<folly::BasicTokenBucket<>>(
-        *kvParams_.floodRate->flood_msg_per_sec_ref(),
-        *kvParams_.floodRate->flood_msg_burst_size_ref());
-    pendingPublicationTimer_ =
-        folly::AsyncTimeout::make(*evb_->getEvb(), [this]() noexcept {
-          if (!floodLimiter_->consume(1)) {
-            pendingPublicationTimer_->scheduleTimeout(
-                Constants::kFloodPendingPublication);
-            return;
-          }
-          floodBufferedUpdates();
-        });
-  }
+  updateFloodRate();
 
   LOG(INFO) << "Starting kvstore DB instance for node " << nodeId << " area "
             << area;
@@ -1149,8 +1565,13 @@ KvStoreDb::KvStoreDb(
 
   // Hook up timer with cleanupTtlCountdownQueue(). The actual scheduling
   // happens within updateTtlCountdownQueue()
-  ttlCountdownTimer_ = folly::AsyncTimeout::make(
-      *evb_->getEvb(), [this]() noexcept { cleanupTtlCountdownQueue(); });
+  ttlCountdownTimer_ = WheelTimeout::make(
+      evb_->getCoarseWheelTimer(),
+      [this]() noexcept { cleanupTtlCountdownQueue(); });
+
+  // merges key-values of local modules held back by setLocalKeyVals()
+  localSetBatchTimer_ = WheelTimeout::make(
+      evb_->getWheelTimer(), [this]() noexcept { flushLocalKeyVals(); });
 
   // Initialize fb303 counter keys for thrift
   fb303::fbData->addStatExportType(
@@ -1159,6 +1580,8 @@ KvStoreDb::KvStoreDb(
       "kvstore.thrift.num_full_sync", fb303::COUNT);
   fb303::fbData->addStatExportType(
       "kvstore.thrift.num_full_sync_success", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "kvstore.thrift.num_merkle_sync_rounds", fb303::COUNT);
   fb303::fbData->addStatExportType(
       "kvstore.thrift.num_full_sync_failure", fb303::COUNT);
   fb303::fbData->addStatExportType(
@@ -1185,6 +1608,8 @@ KvStoreDb::KvStoreDb(
       "kvstore.thrift.num_missing_keys", fb303::SUM);
   fb303::fbData->addStatExportType(
       "kvstore.thrift.num_flood_key_vals", fb303::SUM);
+  fb303::fbData->addStatExportType(
+      "kvstore.thrift.flood_coalesced_keys", fb303::SUM);
   fb303::fbData->addStatExportType(
       "kvstore.thrift.num_keyvals_update", fb303::SUM);
 
@@ -1196,12 +1621,17 @@ KvStoreDb::KvStoreDb(
   // Initialize stats keys
   fb303::fbData->addStatExportType("kvstore.cmd_hash_dump", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.cmd_key_dump", fb303::COUNT);
+  fb303::fbData->addStatExportType("kvstore.cmd_key_dump_page", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.cmd_key_get", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.cmd_key_set", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.cmd_peer_add", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.cmd_peer_dump", fb303::COUNT);
   fb303::fbData->addStatExportType("kvstore.cmd_per_del", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "kvstore.compacted_tombstones", fb303::SUM);
   fb303::fbData->addStatExportType("kvstore.expired_key_vals", fb303::SUM);
+  fb303::fbData->addStatExportType("kvstore.flood_backoff_ms", fb303::AVG);
+  fb303::fbData->addStatExportType("kvstore.flood_coalesced_keys", fb303::SUM);
   fb303::fbData->addStatExportType("kvstore.flood_duration_ms", fb303::AVG);
   fb303::fbData->addStatExportType("kvstore.full_sync_duration_ms", fb303::AVG);
   fb303::fbData->addStatExportType("kvstore.looped_publications", fb303::COUNT);
@@ -1242,25 +1672,31 @@ KvStoreDb::updateTtlCountdownQueue(const thrift::Publication& publication) {
     const auto& key = kv.first;
     const auto& value = kv.second;
 
-    if (*value.ttl_ref() != Constants::kTtlInfinity) {
-      TtlCountdownQueueEntry queueEntry;
-      queueEntry.expiryTime = std::chrono::steady_clock::now() +
-          std::chrono::milliseconds(*value.ttl_ref());
-      queueEntry.key = key;
-      queueEntry.version = *value.version_ref();
-      queueEntry.ttlVersion = *value.ttlVersion_ref();
-      queueEntry.originatorId = *value.originatorId_ref();
-
-      if ((ttlCountdownQueue_.empty() or
-           (queueEntry.expiryTime <= ttlCountdownQueue_.top().expiryTime)) and
-          ttlCountdownTimer_) {
-        // Reschedule the shorter timeout
-        ttlCountdownTimer_->scheduleTimeout(
-            std::chrono::milliseconds(*value.ttl_ref()));
-      }
+    if (*value.ttl_ref() == Constants::kTtlInfinity) {
+      // previous value of the key may have had a finite ttl
+      ttlCountdownQueue_.erase(key);
+      continue;
+    }
 
-      ttlCountdownQueue_.push(std::move(queueEntry));
+    TtlCountdownQueueEntry queueEntry;
+    queueEntry.expiryTime = std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(*value.ttl_ref());
+    queueEntry.key = key;
+    queueEntry.version = *value.version_ref();
+    queueEntry.ttlVersion = *value.ttlVersion_ref();
+    queueEntry.originatorId = *value.originatorId_ref();
+
+    if (ttlCountdownTimer_ and
+        (not ttlCountdownTimer_->isScheduled() or
+         queueEntry.expiryTime < ttlCountdownTimerExpiry_)) {
+      // Reschedule the shorter timeout
+      ttlCountdownTimerExpiry_ = queueEntry.expiryTime;
+      ttlCountdownTimer_->scheduleTimeout(
+          std::chrono::milliseconds(*value.ttl_ref()));
     }
+
+    // replaces the entry of the previous value
+    ttlCountdownQueue_.push(std::move(queueEntry));
   }
 }
 
@@ -1283,6 +1719,38 @@ KvStoreDb::getKeyVals(std::vector<std::string> const& keys) {
 }
 
 // dump the entries of my KV store whose keys match filter
+void
+KvStoreDb::updateFloodRate() {
+  if (not kvParams_.floodRate) {
+    floodLimiter_.reset();
+    if (pendingPublicationTimer_ and pendingPublicationTimer_->isScheduled()) {
+      pendingPublicationTimer_->cancelTimeout();
+      floodBufferedUpdates();
+    }
+    return;
+  }
+
+  const auto rate = *kvParams_.floodRate->flood_msg_per_sec_ref();
+  const auto burstSize = *kvParams_.floodRate->flood_msg_burst_size_ref();
+  if (floodLimiter_) {
+    floodLimiter_->reset(rate, burstSize);
+  } else {
+    floodLimiter_ =
+        std::make_unique<folly::BasicTokenBucket<>>(rate, burstSize);
+  }
+  if (not pendingPublicationTimer_) {
+    pendingPublicationTimer_ =
+        folly::AsyncTimeout::make(*evb_->getEvb(), [this]() noexcept {
+          if (!floodLimiter_->consume(1)) {
+            pendingPublicationTimer_->scheduleTimeout(
+                Constants::kFloodPendingPublication);
+            return;
+          }
+          floodBufferedUpdates();
+        });
+  }
+}
+
 thrift::Publication
 KvStoreDb::dumpAllWithFilters(
     KvStoreFilters const& kvFilters,
@@ -1291,32 +1759,49 @@ KvStoreDb::dumpAllWithFilters(
   thrift::Publication thriftPub;
   *thriftPub.area_ref() = area_;
 
-  switch (oper) {
-  case thrift::FilterOperator::AND:
-    for (auto const& kv : kvStore_) {
-      if (not kvFilters.keyMatchAll(kv.first, kv.second)) {
-        continue;
-      }
-      if (not doNotPublishValue) {
-        thriftPub.keyVals_ref()[kv.first] = kv.second;
-      } else {
-        thriftPub.keyVals_ref()[kv.first] =
-            createThriftValueWithoutBinaryValue(kv.second);
-      }
+  forEachKeyValWithFilters(
+      kvFilters, oper, [&](std::string const& key, thrift::Value const& val) {
+        if (not doNotPublishValue) {
+          thriftPub.keyVals_ref()[key] = val;
+        } else {
+          thriftPub.keyVals_ref()[key] =
+              createThriftValueWithoutBinaryValue(val);
+        }
+      });
+  return thriftPub;
+}
+
+thrift::Publication
+KvStoreDb::dumpPageWithFilters(
+    KvStoreFilters const& kvFilters,
+    thrift::FilterOperator oper,
+    bool doNotPublishValue,
+    std::optional<std::string> const& cursor,
+    size_t limit,
+    std::optional<std::string>& nextCursor) const {
+  thrift::Publication thriftPub;
+  *thriftPub.area_ref() = area_;
+
+  // keyIndex_ keeps keys in order, a page resumes right after the cursor
+  auto it = cursor.has_value() ? keyIndex_.upper_bound(*cursor)
+                               : keyIndex_.begin();
+  std::string const* lastKey{nullptr};
+  for (; it != keyIndex_.end(); ++it) {
+    auto const& [key, val] = *it->second;
+    if (not kvFilters.keyMatch(key, val, oper)) {
+      continue;
     }
-    break;
-  default:
-    for (auto const& kv : kvStore_) {
-      if (not kvFilters.keyMatch(kv.first, kv.second)) {
-        continue;
-      }
-      if (not doNotPublishValue) {
-        thriftPub.keyVals_ref()[kv.first] = kv.second;
-      } else {
-        thriftPub.keyVals_ref()[kv.first] =
-            createThriftValueWithoutBinaryValue(kv.second);
+    if (thriftPub.keyVals_ref()->size() == limit) {
+      // more entries match than fit into the page
+      if (lastKey) {
+        nextCursor = *lastKey;
       }
+      break;
     }
+    thriftPub.keyVals_ref()->emplace(
+        key,
+        doNotPublishValue ? createThriftValueWithoutBinaryValue(val) : val);
+    lastKey = &key;
   }
   return thriftPub;
 }
@@ -1324,22 +1809,51 @@ KvStoreDb::dumpAllWithFilters(
 // dump the hashes of my KV store whose keys match the given prefix
 // if prefix is the empty string, the full hash store is dumped
 thrift::Publication
-KvStoreDb::dumpHashWithFilters(KvStoreFilters const& kvFilters) const {
+KvStoreDb::dumpHashWithFilters(
+    KvStoreFilters const& kvFilters, bool excludeSettledTombstones) const {
   thrift::Publication thriftPub;
   *thriftPub.area_ref() = area_;
-  for (auto const& kv : kvStore_) {
-    if (not kvFilters.keyMatch(kv.first, kv.second)) {
-      continue;
+  excludeSettledTombstones = excludeSettledTombstones and
+      not tombstones_.empty();
+  forEachKeyValWithFilters(
+      kvFilters,
+      thrift::FilterOperator::OR,
+      [&](std::string const& key, thrift::Value const& val) {
+        if (excludeSettledTombstones and isSettledTombstone(key)) {
+          return;
+        }
+        thriftPub.keyVals_ref()->emplace(key, getHashValue(val));
+      });
+  return thriftPub;
+}
+
+void
+KvStoreDb::forEachKeyValWithFilters(
+    KvStoreFilters const& kvFilters,
+    thrift::FilterOperator oper,
+    std::function<void(std::string const&, thrift::Value const&)> const& fn)
+    const {
+  auto const* literalPrefixes = kvFilters.getLiteralKeyPrefixes(oper);
+  if (not literalPrefixes) {
+    for (auto const& kv : kvStore_) {
+      if (kvFilters.keyMatch(kv.first, kv.second, oper)) {
+        fn(kv.first, kv.second);
+      }
+    }
+    return;
+  }
+
+  // range scan keys of every prefix, prefixes don't overlap
+  for (auto const& prefix : *literalPrefixes) {
+    for (auto it = keyIndex_.lower_bound(prefix); it != keyIndex_.end() and
+         it->first.compare(0, prefix.size(), prefix) == 0;
+         ++it) {
+      auto const& [key, val] = *it->second;
+      if (kvFilters.keyMatch(key, val, oper)) {
+        fn(key, val);
+      }
     }
-    DCHECK(kv.second.hash_ref().has_value());
-    auto& value = thriftPub.keyVals_ref()[kv.first];
-    value.version_ref() = *kv.second.version_ref();
-    *value.originatorId_ref() = *kv.second.originatorId_ref();
-    value.hash_ref().copy_from(kv.second.hash_ref());
-    value.ttl_ref() = *kv.second.ttl_ref();
-    value.ttlVersion_ref() = *kv.second.ttlVersion_ref();
   }
-  return thriftPub;
 }
 
 // dump the keys on which hashes differ from given keyVals
@@ -1393,6 +1907,101 @@ KvStoreDb::dumpDifference(
   return thriftPub;
 }
 
+// same as dumpDifference(), without copying all my key-vals matching filters
+// first. Keys on which hashes match are skipped without touching values
+thrift::Publication
+KvStoreDb::dumpDifferenceWithFilters(
+    KvStoreFilters const& kvFilters,
+    thrift::FilterOperator oper,
+    bool doNotPublishValue,
+    std::unordered_map<std::string, thrift::Value> const& reqKeyVal,
+    std::optional<int64_t> reqDigest) const {
+  thrift::Publication thriftPub;
+  *thriftPub.area_ref() = area_;
+  thriftPub.tobeUpdatedKeys_ref() = std::vector<std::string>{};
+
+  // identical stores, nothing to exchange
+  if (reqDigest.has_value() and *reqDigest == getKeyValsDigest()) {
+    fb303::fbData->addStatValue(
+        "kvstore.full_sync_digest_matches", 1, fb303::COUNT);
+    return thriftPub;
+  }
+
+  // better keys or keys exist only in MY-KEY-VAL, but tombstones all peers
+  // hold which requester leaves out as well
+  forEachKeyValWithFilters(
+      kvFilters, oper, [&](std::string const& key, thrift::Value const& val) {
+        const auto reqKv = reqKeyVal.find(key);
+        if (reqKv == reqKeyVal.end() and not tombstones_.empty() and
+            isSettledTombstone(key)) {
+          return;
+        }
+        const int rc = reqKv == reqKeyVal.end()
+            ? 1
+            : KvStore::compareValues(val, reqKv->second);
+        if (rc == 1 or rc == -2) {
+          thriftPub.keyVals_ref()->emplace(
+              key,
+              doNotPublishValue ? createThriftValueWithoutBinaryValue(val)
+                                : val);
+        }
+        if (rc == -1 or rc == -2) {
+          thriftPub.tobeUpdatedKeys_ref()->emplace_back(key);
+        }
+      });
+
+  // keys exist only in REQ-KEY-VAL
+  for (auto const& [key, _] : reqKeyVal) {
+    const auto myKv = kvStore_.find(key);
+    if (myKv == kvStore_.end() or
+        not kvFilters.keyMatch(key, myKv->second, oper)) {
+      thriftPub.tobeUpdatedKeys_ref()->emplace_back(key);
+    }
+  }
+  return thriftPub;
+}
+
+// dump the nodes on which digests differ from given keyValDigests
+// thriftPub.mismatchedDigests: nodes, including unknown ones, for the
+// full-sync initiator to descend into
+thrift::Publication
+KvStoreDb::dumpMismatchedDigests(
+    std::map<int32_t, int64_t> const& keyValDigests) const {
+  thrift::Publication thriftPub;
+  *thriftPub.area_ref() = area_;
+
+  thriftPub.mismatchedDigests_ref() = std::vector<int32_t>{};
+  for (auto const& [node, digest] : keyValDigests) {
+    if (not KvStoreMerkleTree::isValidNode(node) or
+        merkleTree_.getDigest(node) != digest) {
+      thriftPub.mismatchedDigests_ref()->emplace_back(node);
+    }
+  }
+  return thriftPub;
+}
+
+// dump the keys on which hashes differ from given reqKeyVal, only looking at
+// my keys under the nodes of keyValDigests
+thrift::Publication
+KvStoreDb::dumpDifferenceUnderNodes(
+    std::map<int32_t, int64_t> const& keyValDigests,
+    std::unordered_map<std::string, thrift::Value> const& reqKeyVal) const {
+  std::unordered_map<std::string, thrift::Value> myKeyVal;
+  for (auto const& [node, _] : keyValDigests) {
+    if (not KvStoreMerkleTree::isValidNode(node)) {
+      continue;
+    }
+    merkleTree_.forEachKey(node, [&](std::string const& key) {
+      auto it = kvStore_.find(key);
+      DCHECK(it != kvStore_.end()) << "Key " << key << " not in KvStore";
+      if (it != kvStore_.end()) {
+        myKeyVal.emplace(key, it->second);
+      }
+    });
+  }
+  return dumpDifference(myKeyVal, reqKeyVal);
+}
+
 // This function serves the purpose of periodically scanning peers in
 // IDLE state and promote them to SYNCING state. The initial dump will
 // happen in async nature to unblock KvStore to process other requests.
@@ -1405,15 +2014,11 @@ KvStoreDb::requestThriftPeerSync() {
   uint32_t numThriftPeersInSync =
       getPeersByState(KvStorePeerState::SYNCING).size();
 
-  // Scan over thriftPeers to promote IDLE peers to SYNCING
-  for (auto& [peerName, thriftPeer] : thriftPeers_) {
+  // Scan over IDLE thriftPeers, best first, to promote them to SYNCING
+  for (auto const& peerName : getIdlePeersBySyncPriority()) {
+    auto& thriftPeer = thriftPeers_.at(peerName);
     auto& peerSpec = thriftPeer.peerSpec; // thrift::PeerSpec
 
-    // ignore peers in state other than IDLE
-    if (thriftPeer.state != KvStorePeerState::IDLE) {
-      continue;
-    }
-
     // update the global minimum timeout value for next try
     if (not thriftPeer.expBackoff.canTryNow()) {
       timeout =
@@ -1421,6 +2026,14 @@ KvStoreDb::requestThriftPeerSync() {
       continue;
     }
 
+    // Until a full-sync succeeded only sync with the best few peers. The
+    // rest are synced after, with mostly matching hashes to exchange
+    if (not initialSyncDone_ and kvParams_.initialSyncPeers.has_value() and
+        numThriftPeersInSync >= *kvParams_.initialSyncPeers) {
+      timeout = Constants::kMaxBackoff;
+      break;
+    }
+
     // create thrift client and do backoff if can't go through
     try {
       LOG(INFO) << "[Thrift Sync] Creating kvstore thrift client with addr: "
@@ -1438,6 +2051,8 @@ KvStoreDb::requestThriftPeerSync() {
           folly::AsyncSocket::anyAddress(), /* bindAddress */
           kvParams_.maybeIpTos /* IP_TOS value for control plane */);
       thriftPeer.client = std::move(client);
+      thriftPeer.clientId = ++lastThriftClientId_;
+      thriftPeer.numFloodRequestsInFlight = 0;
 
       // schedule periodic keepAlive time with 20% jitter variance
       auto period = addJitter<std::chrono::seconds>(
@@ -1469,57 +2084,70 @@ KvStoreDb::requestThriftPeerSync() {
     // mark peer from IDLE -> SYNCING
     numThriftPeersInSync += 1;
 
-    // build KeyDumpParam
-    thrift::KeyDumpParams params;
-    if (kvParams_.filters.has_value()) {
-      std::string keyPrefix =
-          folly::join(",", kvParams_.filters.value().getKeyPrefixes());
-      /* prefix is for backward compatibility */
-      *params.prefix_ref() = keyPrefix;
-      if (not keyPrefix.empty()) {
-        params.keys_ref() = kvParams_.filters.value().getKeyPrefixes();
+    // digests are only comparable if both stores hold every key
+    if (kvParams_.enableMerkleSync and not kvParams_.filters.has_value()) {
+      fb303::fbData->addStatValue(
+          "kvstore.thrift.num_full_sync", 1, fb303::COUNT);
+      requestMerkleSync(
+          peerName,
+          {KvStoreMerkleTree::kRoot},
+          {},
+          std::chrono::steady_clock::now());
+    } else {
+      // build KeyDumpParam
+      thrift::KeyDumpParams params;
+      if (kvParams_.filters.has_value()) {
+        std::string keyPrefix =
+            folly::join(",", kvParams_.filters.value().getKeyPrefixes());
+        /* prefix is for backward compatibility */
+        *params.prefix_ref() = keyPrefix;
+        if (not keyPrefix.empty()) {
+          params.keys_ref() = kvParams_.filters.value().getKeyPrefixes();
+        }
+        params.originatorIds_ref() =
+            kvParams_.filters.value().getOriginatorIdList();
       }
-      params.originatorIds_ref() =
-          kvParams_.filters.value().getOriginatorIdList();
-    }
-    KvStoreFilters kvFilters(
-        std::vector<std::string>{}, /* keyPrefixList */
-        std::set<std::string>{} /* originator */);
-    params.keyValHashes_ref() =
-        std::move(*dumpHashWithFilters(kvFilters).keyVals_ref());
-
-    // record telemetry for initial full-sync
-    fb303::fbData->addStatValue(
-        "kvstore.thrift.num_full_sync", 1, fb303::COUNT);
+      KvStoreFilters kvFilters(
+          std::vector<std::string>{}, /* keyPrefixList */
+          std::set<std::string>{} /* originator */);
+      params.keyValHashes_ref() = std::move(
+          *dumpHashWithFilters(kvFilters, true /* excludeSettledTombstones */)
+               .keyVals_ref());
+      params.keyValsDigest_ref() = getKeyValsDigest();
+
+      // record telemetry for initial full-sync
+      fb303::fbData->addStatValue(
+          "kvstore.thrift.num_full_sync", 1, fb303::COUNT);
 
-    // send request over thrift client and attach callback
-    auto startTime = std::chrono::steady_clock::now();
-    auto sf = thriftPeer.client->semifuture_getKvStoreKeyValsFilteredArea(
-        params, area_);
-    std::move(sf)
-        .via(evb_->getEvb())
-        .thenValue(
-            [this, peer = peerName, startTime](thrift::Publication&& pub) {
-              // state transition to INITIALIZED
-              auto endTime = std::chrono::steady_clock::now();
-              auto timeDelta =
-                  std::chrono::duration_cast<std::chrono::milliseconds>(
-                      endTime - startTime);
-              processThriftSuccess(peer, std::move(pub), timeDelta);
-            })
-        .thenError([this, peer = peerName, startTime](
-                       const folly::exception_wrapper& ew) {
-          // state transition to IDLE
-          auto endTime = std::chrono::steady_clock::now();
-          auto timeDelta =
-              std::chrono::duration_cast<std::chrono::milliseconds>(
-                  endTime - startTime);
-          processThriftFailure(peer, ew.what(), timeDelta);
+      // send request over thrift client and attach callback
+      auto startTime = std::chrono::steady_clock::now();
+      auto sf = thriftPeer.client->semifuture_getKvStoreKeyValsFilteredArea(
+          params, area_);
+      std::move(sf)
+          .via(evb_->getEvb())
+          .thenValue(
+              [this, peer = peerName, startTime](thrift::Publication&& pub) {
+                // state transition to INITIALIZED
+                auto endTime = std::chrono::steady_clock::now();
+                auto timeDelta =
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        endTime - startTime);
+                processThriftSuccess(peer, std::move(pub), timeDelta);
+              })
+          .thenError([this, peer = peerName, startTime](
+                         const folly::exception_wrapper& ew) {
+            // state transition to IDLE
+            auto endTime = std::chrono::steady_clock::now();
+            auto timeDelta =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    endTime - startTime);
+            processThriftFailure(peer, ew.what(), timeDelta);
 
-          // record telemetry for thrift calls
-          fb303::fbData->addStatValue(
-              "kvstore.thrift.num_full_sync_failure", 1, fb303::COUNT);
-        });
+            // record telemetry for thrift calls
+            fb303::fbData->addStatValue(
+                "kvstore.thrift.num_full_sync_failure", 1, fb303::COUNT);
+          });
+    }
 
     // in case pending peer size is over parallelSyncLimit,
     // wait until kMaxBackoff before sending next round of sync
@@ -1545,6 +2173,103 @@ KvStoreDb::requestThriftPeerSync() {
   }
 }
 
+void
+KvStoreDb::requestMerkleSync(
+    std::string const& peerName,
+    std::vector<int32_t> const& nodesToCompare,
+    std::vector<int32_t> nodesToSync,
+    std::chrono::steady_clock::time_point startTime) {
+  thrift::KeyDumpParams params;
+  params.keyValDigests_ref() = std::map<int32_t, int64_t>{};
+  if (not nodesToCompare.empty()) {
+    for (auto const node : nodesToCompare) {
+      params.keyValDigests_ref()->emplace(node, merkleTree_.getDigest(node));
+    }
+  } else if (not nodesToSync.empty()) {
+    // exchange key hashes under mismatching nodes only
+    std::unordered_map<std::string, thrift::Value> keyValHashes;
+    for (auto const node : nodesToSync) {
+      params.keyValDigests_ref()->emplace(node, merkleTree_.getDigest(node));
+      merkleTree_.forEachKey(node, [&](std::string const& key) {
+        keyValHashes.emplace(key, getHashValue(kvStore_.at(key)));
+      });
+    }
+    params.keyValHashes_ref() = std::move(keyValHashes);
+  } else {
+    // every digest matches, nothing to sync
+    processThriftSuccess(
+        peerName,
+        thrift::Publication{},
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime));
+    return;
+  }
+
+  fb303::fbData->addStatValue(
+      "kvstore.thrift.num_merkle_sync_rounds", 1, fb303::COUNT);
+
+  bool const isLastRound = nodesToCompare.empty();
+  auto& client = thriftPeers_.at(peerName).client;
+  auto sf = client->semifuture_getKvStoreKeyValsFilteredArea(params, area_);
+  std::move(sf)
+      .via(evb_->getEvb())
+      .thenValue([this,
+                  peer = peerName,
+                  nodesToSync = std::move(nodesToSync),
+                  isLastRound,
+                  startTime](thrift::Publication&& pub) mutable {
+        auto timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime);
+        if (isLastRound) {
+          // state transition to INITIALIZED
+          processThriftSuccess(peer, std::move(pub), timeDelta);
+          return;
+        }
+
+        // peer may be removed or reset to IDLE while descending
+        auto it = thriftPeers_.find(peer);
+        if (it == thriftPeers_.end() or
+            it->second.state != KvStorePeerState::SYNCING) {
+          LOG(WARNING) << "[Thrift Sync] Ignore digests response from: "
+                       << peer << " as it is no longer syncing";
+          return;
+        }
+
+        std::vector<int32_t> nextNodesToCompare;
+        std::vector<int32_t> mismatchedDigests;
+        if (pub.mismatchedDigests_ref().has_value()) {
+          mismatchedDigests = std::move(*pub.mismatchedDigests_ref());
+        }
+        for (auto const node : mismatchedDigests) {
+          if (not KvStoreMerkleTree::isValidNode(node)) {
+            continue;
+          }
+          // syncing few keys directly is cheaper than another round
+          if (KvStoreMerkleTree::isLeaf(node) or
+              merkleTree_.getNumKeys(node) <= KvStoreMerkleTree::kFanout) {
+            nodesToSync.emplace_back(node);
+          } else {
+            auto const children = KvStoreMerkleTree::getChildren(node);
+            nextNodesToCompare.insert(
+                nextNodesToCompare.end(), children.begin(), children.end());
+          }
+        }
+        requestMerkleSync(
+            peer, nextNodesToCompare, std::move(nodesToSync), startTime);
+      })
+      .thenError([this, peer = peerName, startTime](
+                     const folly::exception_wrapper& ew) {
+        // state transition to IDLE
+        auto timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime);
+        processThriftFailure(peer, ew.what(), timeDelta);
+
+        // record telemetry for thrift calls
+        fb303::fbData->addStatValue(
+            "kvstore.thrift.num_full_sync_failure", 1, fb303::COUNT);
+      });
+}
+
 // This function will process the full-dump response from peers:
 //  1) Merge peer's publication with local KvStoreDb;
 //  2) Send a finalized full-sync to peer for missing keys;
@@ -1608,6 +2333,11 @@ KvStoreDb::processThriftSuccess(
   // Log full-sync event via replicate queue
   logSyncEvent(peerName, timeDelta);
 
+  if (not initialSyncDone_) {
+    LOG(INFO) << "[Thrift Sync] Initial full-sync completed with: " << peerName;
+    initialSyncDone_ = true;
+  }
+
   // Successfully received full-sync response. Double the parallel
   // sync limit. This is to:
   //  1) accelerate the rest of pending full-syncs if any;
@@ -1644,21 +2374,160 @@ KvStoreDb::processThriftFailure(
             << ". Peer name: " << peerName
             << ". Processing time: " << timeDelta.count() << "ms.";
 
-  // reset client to reconnect later in next batch of thriftSyncTimer_ scanning
-  auto& peer = thriftPeers_.at(peerName);
-  peer.keepAliveTimer->cancelTimeout();
-  peer.expBackoff.reportError(); // apply exponential backoff
-  peer.client.reset();
+  // reset client to reconnect later in next batch of thriftSyncTimer_ scanning
+  auto& peer = thriftPeers_.at(peerName);
+  peer.keepAliveTimer->cancelTimeout();
+  peer.expBackoff.reportError(); // apply exponential backoff
+  peer.client.reset();
+
+  // held back keys are covered by full-sync after reconnecting, requests in
+  // flight are no longer counted once the next client is created
+  peer.pendingFloodKeys.clear();
+
+  // state transition
+  KvStorePeerState oldState = peer.state;
+  peer.state = getNextState(oldState, KvStorePeerEvent::THRIFT_API_ERROR);
+  logStateTransition(peerName, oldState, peer.state);
+
+  // Schedule another round of `thriftSyncTimer_` in case it is
+  // NOT scheduled.
+  if (not thriftSyncTimer_->isScheduled()) {
+    thriftSyncTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+  }
+}
+
+void
+KvStoreDb::floodThriftPeer(
+    std::string const& peerName, thrift::KeySetParams const& params) {
+  auto& thriftPeer = thriftPeers_.at(peerName);
+  if (thriftPeer.numFloodRequestsInFlight >=
+      Constants::kMaxThriftFloodRequestsInFlight) {
+    // hold back keys, superseding pending updates of the same key
+    std::optional<std::string> floodRootId{std::nullopt};
+    if (params.floodRootId_ref().has_value()) {
+      floodRootId = params.floodRootId_ref().value();
+    }
+    size_t numCoalescedKeys{0};
+    for (auto const& [key, _] : *params.keyVals_ref()) {
+      if (not thriftPeer.pendingFloodKeys.insert_or_assign(key, floodRootId)
+                  .second) {
+        ++numCoalescedKeys;
+      }
+    }
+    fb303::fbData->addStatValue(
+        "kvstore.thrift.flood_coalesced_keys", numCoalescedKeys, fb303::SUM);
+    return;
+  }
+
+  // record telemetry for flooding publications
+  static const StatHandle kNumFloodPub(
+      "kvstore.thrift.num_flood_pub", fb303::COUNT);
+  static const StatHandle kNumFloodKeyVals(
+      "kvstore.thrift.num_flood_key_vals", fb303::SUM);
+  kNumFloodPub.addValue(1);
+  kNumFloodKeyVals.addValue(params.keyVals_ref()->size());
+
+  ++thriftPeer.numFloodRequestsInFlight;
+  auto startTime = std::chrono::steady_clock::now();
+  auto sf = thriftPeer.client->semifuture_setKvStoreKeyVals(params, area_);
+  std::move(sf)
+      .via(evb_->getEvb())
+      .thenValue([this,
+                  peerName,
+                  clientId = thriftPeer.clientId,
+                  startTime,
+                  tombstones = getTombstones(*params.keyVals_ref())](
+                     folly::Unit&&) {
+        VLOG(4) << "Flooding ack received from peer: " << peerName;
+
+        auto endTime = std::chrono::steady_clock::now();
+        auto timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            endTime - startTime);
+
+        // record telemetry for thrift calls
+        static const StatHandle kNumFloodPubSuccess(
+            "kvstore.thrift.num_flood_pub_success", fb303::COUNT);
+        static const StatHandle kFloodPubDurationMs(
+            "kvstore.thrift.flood_pub_duration_ms", fb303::AVG);
+        kNumFloodPubSuccess.addValue(1);
+        kFloodPubDurationMs.addValue(timeDelta.count());
+
+        // check if it is valid peer(i.e. peer removed in process of flooding)
+        auto peerIt = thriftPeers_.find(peerName);
+        if (peerIt == thriftPeers_.end()) {
+          return;
+        }
+        auto& peer = peerIt->second;
+        ackTombstones(peerName, tombstones);
+        // acks of a previous client don't free up the window of this one
+        if (peer.clientId == clientId and peer.numFloodRequestsInFlight > 0) {
+          --peer.numFloodRequestsInFlight;
+        }
+        if (not peer.pendingFloodKeys.empty()) {
+          floodThriftPeerBacklog(peerName);
+        }
+      })
+      .thenError([this, peerName, clientId = thriftPeer.clientId, startTime](
+                     const folly::exception_wrapper& ew) {
+        // record telemetry for thrift calls
+        fb303::fbData->addStatValue(
+            "kvstore.thrift.num_flood_pub_failure", 1, fb303::COUNT);
+
+        // failures of a client which is gone were handled already
+        auto peerIt = thriftPeers_.find(peerName);
+        if (peerIt == thriftPeers_.end() or
+            peerIt->second.clientId != clientId or
+            not peerIt->second.client) {
+          return;
+        }
+
+        // state transition to IDLE
+        auto endTime = std::chrono::steady_clock::now();
+        auto timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            endTime - startTime);
+        processThriftFailure(peerName, ew.what(), timeDelta);
+      });
+}
+
+void
+KvStoreDb::floodThriftPeerBacklog(std::string const& peerName) {
+  auto& thriftPeer = thriftPeers_.at(peerName);
+  if (thriftPeer.state != KvStorePeerState::INITIALIZED or
+      (not thriftPeer.client)) {
+    return;
+  }
+
+  // merge pending keys per flood-root-id
+  std::unordered_map<std::optional<std::string>, std::vector<std::string>>
+      keysToFlood;
+  for (auto const& [key, floodRootId] : thriftPeer.pendingFloodKeys) {
+    keysToFlood[floodRootId].emplace_back(key);
+  }
+  thriftPeer.pendingFloodKeys.clear();
 
-  // state transition
-  KvStorePeerState oldState = peer.state;
-  peer.state = getNextState(oldState, KvStorePeerEvent::THRIFT_API_ERROR);
-  logStateTransition(peerName, oldState, peer.state);
+  for (auto const& [floodRootId, keys] : keysToFlood) {
+    thrift::Publication publication;
+    for (auto const& key : keys) {
+      auto kvStoreIt = kvStore_.find(key);
+      if (kvStoreIt != kvStore_.end()) {
+        publication.keyVals_ref()->emplace(key, kvStoreIt->second);
+      }
+    }
+    // Update ttl and remove keys which are about to expire
+    updatePublicationTtl(publication, true);
+    if (publication.keyVals_ref()->empty()) {
+      continue;
+    }
 
-  // Schedule another round of `thriftSyncTimer_` in case it is
-  // NOT scheduled.
-  if (not thriftSyncTimer_->isScheduled()) {
-    thriftSyncTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+    thrift::KeySetParams params;
+    *params.keyVals_ref() = std::move(*publication.keyVals_ref());
+    params.solicitResponse_ref() = false;
+    params.nodeIds_ref() = std::vector<std::string>{kvParams_.nodeId};
+    params.floodRootId_ref().from_optional(floodRootId);
+    params.timestamp_ms_ref() = getUnixTimeStampMs();
+
+    // held back again if batches of other flood-root-ids fill up the pipeline
+    floodThriftPeer(peerName, params);
   }
 }
 
@@ -1703,8 +2572,8 @@ KvStoreDb::addThriftPeers(
               Constants::kInitialBackoff, Constants::kMaxBackoff));
       // initialize keepAlive timer to make sure thrift client connection
       // will NOT be closed by thrift server due to inactivity
-      peer.keepAliveTimer = folly::AsyncTimeout::make(
-          *(evb_->getEvb()), [this, peerName]() noexcept {
+      peer.keepAliveTimer = WheelTimeout::make(
+          evb_->getCoarseWheelTimer(), [this, peerName]() noexcept {
             auto period = addJitter(Constants::kThriftClientKeepAliveInterval);
             auto& p = thriftPeers_.at(peerName);
             CHECK(p.client) << "thrift client is NOT initialized";
@@ -1838,11 +2707,13 @@ KvStoreDb::addPeers(
   }
 
   // process dual events if any
-  if (kvParams_.enableFloodOptimization) {
+  if (kvParams_.enableFloodOptimization and not dualPeersToAdd.empty()) {
+    std::unordered_map<std::string, int64_t> dualPeers;
     for (const auto& peer : dualPeersToAdd) {
       LOG(INFO) << "dual peer up: " << peer;
-      DualNode::peerUp(peer, 1 /* link-cost */); // use hop count as metric
+      dualPeers.emplace(peer, 1 /* link-cost */); // use hop count as metric
     }
+    DualNode::peersUp(dualPeers);
   }
 }
 
@@ -1850,23 +2721,172 @@ KvStoreDb::addPeers(
 folly::Expected<size_t, fbzmq::Error>
 KvStoreDb::sendMessageToPeer(
     const std::string& peerSocketId, const thrift::KvStoreRequest& request) {
-  auto msg = fbzmq::Message::fromThriftObj(request, serializer_).value();
-  fb303::fbData->addStatValue(
-      "kvstore.peers.bytes_sent", msg.size(), fb303::SUM);
+  auto msg =
+      fbzmq::Message::wrapBuffer(serializeCompactIOBuf(request)).value();
+  static const StatHandle kBytesSent("kvstore.peers.bytes_sent", fb303::SUM);
+  kBytesSent.addValue(msg.size());
   return peerSyncSock_.sendMultiple(
       fbzmq::Message::from(peerSocketId).value(), fbzmq::Message(), msg);
 }
 
+void
+KvStoreDb::sendFloodRequestToPeer(
+    const std::string& peerName, const thrift::KvStoreRequest& floodRequest) {
+  auto const& params = *floodRequest.keySetParams_ref();
+  auto& backlog = peerFloodBacklogs_[peerName];
+  if (backlog.pendingKeys.empty()) {
+    auto const& peerCmdSocketId = peers_.at(peerName).second;
+    auto const ret = sendMessageToPeer(peerCmdSocketId, floodRequest);
+    if (not ret.hasError()) {
+      // rely on zmq (on top of tcp) to reliably deliver message
+      ackTombstones(peerName, *params.keyVals_ref());
+      backlog.expBackoff.reportSuccess();
+      static const StatHandle kSentPublications(
+          "kvstore.sent_publications", fb303::COUNT);
+      static const StatHandle kSentKeyVals(
+          "kvstore.sent_key_vals", fb303::SUM);
+      kSentPublications.addValue(1);
+      kSentKeyVals.addValue(params.keyVals_ref()->size());
+      return;
+    }
+
+    // this could be pretty common on initial connection setup
+    LOG(ERROR) << "Failed to flood publication to peer " << peerName
+               << " using id " << peerCmdSocketId
+               << ", error: " << ret.error();
+    collectSendFailureStats(ret.error(), peerCmdSocketId);
+    backoffPeerFlood(peerName);
+  }
+
+  // queue up keys, superseding pending updates of the same key
+  std::optional<std::string> floodRootId{std::nullopt};
+  if (params.floodRootId_ref().has_value()) {
+    floodRootId = params.floodRootId_ref().value();
+  }
+  size_t numCoalescedKeys{0};
+  for (auto const& [key, _] : *params.keyVals_ref()) {
+    if (not backlog.pendingKeys.insert_or_assign(key, floodRootId).second) {
+      ++numCoalescedKeys;
+    }
+  }
+  fb303::fbData->addStatValue(
+      "kvstore.flood_coalesced_keys", numCoalescedKeys, fb303::SUM);
+}
+
+void
+KvStoreDb::floodPeerBacklog(const std::string& peerName) {
+  auto peerIt = peers_.find(peerName);
+  auto backlogIt = peerFloodBacklogs_.find(peerName);
+  if (peerIt == peers_.end() or backlogIt == peerFloodBacklogs_.end()) {
+    return;
+  }
+  auto const& peerCmdSocketId = peerIt->second.second;
+  auto& backlog = backlogIt->second;
+
+  // merge pending keys per flood-root-id
+  std::unordered_map<std::optional<std::string>, std::vector<std::string>>
+      keysToFlood;
+  for (auto const& [key, floodRootId] : backlog.pendingKeys) {
+    keysToFlood[floodRootId].emplace_back(key);
+  }
+
+  for (auto const& [floodRootId, keys] : keysToFlood) {
+    thrift::Publication publication;
+    for (auto const& key : keys) {
+      auto kvStoreIt = kvStore_.find(key);
+      if (kvStoreIt != kvStore_.end()) {
+        publication.keyVals_ref()->emplace(key, kvStoreIt->second);
+      }
+    }
+    // Update ttl and remove keys which are about to expire
+    updatePublicationTtl(publication, true);
+
+    if (not publication.keyVals_ref()->empty()) {
+      auto const numKeyVals = publication.keyVals_ref()->size();
+      thrift::KeySetParams params;
+      *params.keyVals_ref() = std::move(*publication.keyVals_ref());
+      params.solicitResponse_ref() = false;
+      params.nodeIds_ref() = std::vector<std::string>{kvParams_.nodeId};
+      params.floodRootId_ref().from_optional(floodRootId);
+      params.timestamp_ms_ref() = getUnixTimeStampMs();
+
+      thrift::KvStoreRequest floodRequest;
+      floodRequest.cmd_ref() = thrift::Command::KEY_SET;
+      floodRequest.keySetParams_ref() = std::move(params);
+      *floodRequest.area_ref() = area_;
+
+      auto const ret = sendMessageToPeer(peerCmdSocketId, floodRequest);
+      if (ret.hasError()) {
+        LOG(ERROR) << "Failed to flood backlog to peer " << peerName
+                   << " using id " << peerCmdSocketId
+                   << ", error: " << ret.error();
+        collectSendFailureStats(ret.error(), peerCmdSocketId);
+        backoffPeerFlood(peerName);
+        return;
+      }
+      ackTombstones(peerName, *floodRequest.keySetParams_ref()->keyVals_ref());
+      fb303::fbData->addStatValue("kvstore.sent_publications", 1, fb303::COUNT);
+      fb303::fbData->addStatValue(
+          "kvstore.sent_key_vals", numKeyVals, fb303::SUM);
+    }
+
+    for (auto const& key : keys) {
+      backlog.pendingKeys.erase(key);
+    }
+  }
+  backlog.expBackoff.reportSuccess();
+}
+
+void
+KvStoreDb::backoffPeerFlood(const std::string& peerName) {
+  auto& backlog = peerFloodBacklogs_.at(peerName);
+  backlog.expBackoff.reportError();
+  if (not backlog.retryTimer) {
+    backlog.retryTimer = WheelTimeout::make(
+        evb_->getWheelTimer(),
+        [this, peerName]() noexcept { floodPeerBacklog(peerName); });
+  }
+  auto const backoff = backlog.expBackoff.getTimeRemainingUntilRetry();
+  backlog.retryTimer->scheduleTimeout(backoff);
+  fb303::fbData->addStatValue(
+      "kvstore.flood_backoff_ms", backoff.count(), fb303::AVG);
+}
+
 std::map<std::string, int64_t>
 KvStoreDb::getCounters() const {
   std::map<std::string, int64_t> counters;
 
   // Add some more flat counters
   counters["kvstore.num_keys"] = kvStore_.size();
+  // rough estimate counting the hash nodes and heap allocations of entries
+  size_t keyValsBytes{0};
+  for (auto const& [key, value] : kvStore_) {
+    keyValsBytes += kHashNodeBytes + sizeof(key) + sizeof(value) +
+        getHeapBytes(key) + getHeapBytes(value);
+  }
+  counters["kvstore.key_vals_bytes"] = keyValsBytes;
   counters["kvstore.num_peers"] = peers_.size();
   // Add up pending and in-flight full sync
   counters["kvstore.pending_full_sync"] =
       peersToSyncWith_.size() + latestSentPeerSync_.size();
+  // Add up keys pending to be flooded to slow peers
+  size_t numFloodBacklogKeys{0};
+  for (auto const& [peerName, backlog] : peerFloodBacklogs_) {
+    counters[folly::sformat("kvstore.flood_backlog_keys.{}", peerName)] =
+        backlog.pendingKeys.size();
+    numFloodBacklogKeys += backlog.pendingKeys.size();
+  }
+  for (auto const& [peerName, thriftPeer] : thriftPeers_) {
+    counters[folly::sformat("kvstore.flood_backlog_keys.{}", peerName)] +=
+        thriftPeer.pendingFloodKeys.size();
+    numFloodBacklogKeys += thriftPeer.pendingFloodKeys.size();
+  }
+  counters["kvstore.flood_backlog_keys"] = numFloodBacklogKeys;
+  counters["kvstore.num_tombstones"] = tombstones_.size();
+  counters["kvstore.num_settled_tombstones"] = std::count_if(
+      tombstones_.begin(), tombstones_.end(), [this](const auto& tombstone) {
+        return isSettledTombstone(tombstone.first);
+      });
   return counters;
 }
 
@@ -1889,6 +2909,11 @@ KvStoreDb::delThriftPeers(std::vector<std::string> const& peers) {
     peerIter->second.client.reset();
     thriftPeers_.erase(peerIter);
   }
+
+  // sync with best peers first again once there are new ones
+  if (thriftPeers_.empty()) {
+    initialSyncDone_ = false;
+  }
 }
 
 // delete some peers we are subscribed to
@@ -1921,6 +2946,11 @@ KvStoreDb::delPeers(std::vector<std::string> const& peers) {
     }
 
     peersToSyncWith_.erase(peerName);
+    peerFloodBacklogs_.erase(peerName);
+    // peer may come back without the tombstones, e.g. after restart
+    for (auto& [_, tombstone] : tombstones_) {
+      tombstone.ackedPeers.erase(peerName);
+    }
     auto const& peerCmdSocketId = it->second.second;
     if (latestSentPeerSync_.count(peerCmdSocketId)) {
       latestSentPeerSync_.erase(peerCmdSocketId);
@@ -1929,11 +2959,11 @@ KvStoreDb::delPeers(std::vector<std::string> const& peers) {
   }
 
   // remove dual peers if any
-  if (kvParams_.enableFloodOptimization) {
+  if (kvParams_.enableFloodOptimization and not dualPeersToRemove.empty()) {
     for (const auto& peer : dualPeersToRemove) {
       LOG(INFO) << "dual peer down: " << peer;
-      DualNode::peerDown(peer);
     }
+    DualNode::peersDown(dualPeersToRemove);
   }
 }
 
@@ -1973,8 +3003,10 @@ KvStoreDb::requestFullSyncFromPeers() {
     std::set<std::string> originator{};
     std::vector<std::string> keyPrefixList{};
     KvStoreFilters kvFilters{keyPrefixList, originator};
-    params.keyValHashes_ref() =
-        std::move(*dumpHashWithFilters(kvFilters).keyVals_ref());
+    params.keyValHashes_ref() = std::move(
+        *dumpHashWithFilters(kvFilters, true /* excludeSettledTombstones */)
+             .keyVals_ref());
+    params.keyValsDigest_ref() = getKeyValsDigest();
 
     dumpRequest.cmd_ref() = thrift::Command::KEY_DUMP;
     dumpRequest.keyDumpParams_ref() = params;
@@ -2048,26 +3080,27 @@ void
 KvStoreDb::updatePublicationTtl(
     thrift::Publication& thriftPub, bool removeAboutToExpire) {
   auto timeNow = std::chrono::steady_clock::now();
-  for (const auto& qE : ttlCountdownQueue_) {
+  auto& keyVals = *thriftPub.keyVals_ref();
+  for (auto kv = keyVals.begin(); kv != keyVals.end();) {
     // Find key and ensure we are taking time from right entry from queue
-    auto kv = thriftPub.keyVals_ref()->find(qE.key);
-    if (kv == thriftPub.keyVals_ref()->end() or
-        *kv->second.version_ref() != qE.version or
-        *kv->second.originatorId_ref() != qE.originatorId or
-        *kv->second.ttlVersion_ref() != qE.ttlVersion) {
+    auto const* qE = ttlCountdownQueue_.find(kv->first);
+    if (not qE or *kv->second.version_ref() != qE->version or
+        *kv->second.originatorId_ref() != qE->originatorId or
+        *kv->second.ttlVersion_ref() != qE->ttlVersion) {
+      ++kv;
       continue;
     }
 
     // Compute timeLeft and do sanity check on it
-    auto timeLeft = duration_cast<milliseconds>(qE.expiryTime - timeNow);
+    auto timeLeft = duration_cast<milliseconds>(qE->expiryTime - timeNow);
     if (timeLeft <= kvParams_.ttlDecr) {
-      thriftPub.keyVals_ref()->erase(kv);
+      kv = keyVals.erase(kv);
       continue;
     }
 
     // filter key from publication if time left is below ttl threshold
     if (removeAboutToExpire and timeLeft < Constants::kTtlThreshold) {
-      thriftPub.keyVals_ref()->erase(kv);
+      kv = keyVals.erase(kv);
       continue;
     }
 
@@ -2075,6 +3108,7 @@ KvStoreDb::updatePublicationTtl(
     // deterministically whenever it is exchanged between KvStores. This will
     // avoid looping of updates between stores.
     kv->second.ttl_ref() = timeLeft.count() - kvParams_.ttlDecr.count();
+    ++kv;
   }
 }
 
@@ -2113,13 +3147,8 @@ KvStoreDb::processRequestMsgHelper(
     }
 
     // Update hash for key-values
-    for (auto& kv : *ketSetParamsVal.keyVals_ref()) {
-      auto& value = kv.second;
-      if (value.value_ref().has_value()) {
-        value.hash_ref() = generateHash(
-            *value.version_ref(), *value.originatorId_ref(), value.value_ref());
-      }
-    }
+    prepareSetKeyVals(
+        *ketSetParamsVal.keyVals_ref(), kvParams_.valueCompressionMinBytes);
 
     // Create publication and merge it with local KvStore
     thrift::Publication rcvdPublication;
@@ -2154,10 +3183,14 @@ KvStoreDb::processRequestMsgHelper(
 
     const auto keyPrefixMatch =
         KvStoreFilters(keyPrefixList, *keyDumpParamsVal.originatorIds_ref());
-    auto thriftPub = dumpAllWithFilters(keyPrefixMatch);
-    if (auto keyValHashes = keyDumpParamsVal.keyValHashes_ref()) {
-      thriftPub = dumpDifference(*thriftPub.keyVals_ref(), *keyValHashes);
-    }
+    auto thriftPub = keyDumpParamsVal.keyValHashes_ref().has_value()
+        ? dumpDifferenceWithFilters(
+              keyPrefixMatch,
+              thrift::FilterOperator::OR,
+              false /* doNotPublishValue */,
+              *keyDumpParamsVal.keyValHashes_ref(),
+              keyDumpParamsVal.keyValsDigest_ref().to_optional())
+        : dumpAllWithFilters(keyPrefixMatch);
     updatePublicationTtl(thriftPub);
     // I'm the initiator, set flood-root-id
     thriftPub.floodRootId_ref().from_optional(DualNode::getSptRootId());
@@ -2178,7 +3211,7 @@ KvStoreDb::processRequestMsgHelper(
                 << thriftPub.keyVals_ref()->size() << " key-vals and "
                 << numMissingKeys << " missing keys";
     }
-    return fbzmq::Message::fromThriftObj(thriftPub, serializer_);
+    return fbzmq::Message::wrapBuffer(serializeCompactIOBuf(thriftPub));
   }
   case thrift::Command::DUAL: {
     VLOG(2) << "DUAL messages received";
@@ -2613,41 +3646,38 @@ KvStoreDb::cleanupTtlCountdownQueue() {
   std::vector<std::string> expiredKeys;
   auto now = std::chrono::steady_clock::now();
 
-  // Iterate through ttlCountdownQueue_ until the top expires in the future
-  while (not ttlCountdownQueue_.empty()) {
-    auto top = ttlCountdownQueue_.top();
-    if (top.expiryTime > now) {
-      // Nothing in queue worth evicting
-      break;
-    }
-    auto it = kvStore_.find(top.key);
-    if (it != kvStore_.end() and *it->second.version_ref() == top.version and
-        *it->second.originatorId_ref() == top.originatorId and
-        *it->second.ttlVersion_ref() == top.ttlVersion) {
-      expiredKeys.emplace_back(top.key);
+  // Evict keys whose latest value has expired
+  for (auto const& entry : ttlCountdownQueue_.popExpired(now)) {
+    auto it = kvStore_.find(entry.key);
+    if (it != kvStore_.end() and *it->second.version_ref() == entry.version and
+        *it->second.originatorId_ref() == entry.originatorId and
+        *it->second.ttlVersion_ref() == entry.ttlVersion) {
+      expiredKeys.emplace_back(entry.key);
       LOG(WARNING)
           << "Delete expired (key, version, originatorId, ttlVersion, ttl, "
           << "node, area) "
           << folly::sformat(
                  "({}, {}, {}, {}, {}, {}, {})",
-                 top.key,
+                 entry.key,
                  *it->second.version_ref(),
                  *it->second.originatorId_ref(),
                  *it->second.ttlVersion_ref(),
                  *it->second.ttl_ref(),
                  kvParams_.nodeId,
                  area_);
-      logKvEvent("KEY_EXPIRE", top.key);
+      logKvEvent("KEY_EXPIRE", entry.key);
+      merkleTree_.erase(entry.key);
+      tombstones_.erase(entry.key);
+      keyIndex_.erase(it->first);
       kvStore_.erase(it);
     }
-    ttlCountdownQueue_.pop();
   }
 
   // Reschedule based on most recent timeout
-  if (not ttlCountdownQueue_.empty()) {
+  if (auto nextExpiryTime = ttlCountdownQueue_.getNextExpiryTime()) {
+    ttlCountdownTimerExpiry_ = *nextExpiryTime;
     ttlCountdownTimer_->scheduleTimeout(
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            ttlCountdownQueue_.top().expiryTime - now));
+        std::chrono::ceil<std::chrono::milliseconds>(*nextExpiryTime - now));
   }
 
   if (expiredKeys.empty()) {
@@ -2666,6 +3696,39 @@ KvStoreDb::cleanupTtlCountdownQueue() {
   floodPublication(std::move(expiredKeysPub));
 }
 
+size_t
+KvStoreDb::compactTombstones() {
+  std::vector<std::string> expiredKeys;
+  for (auto const& [key, _] : tombstones_) {
+    if (isSettledTombstone(key)) {
+      expiredKeys.emplace_back(key);
+    }
+  }
+  if (expiredKeys.empty()) {
+    return 0;
+  }
+
+  // same as expiry of their TTL, entries left in ttlCountdownQueue_ are
+  // skipped as keys are gone
+  for (auto const& key : expiredKeys) {
+    auto it = kvStore_.find(key);
+    CHECK(it != kvStore_.end());
+    logKvEvent("KEY_EXPIRE", key);
+    merkleTree_.erase(key);
+    tombstones_.erase(key);
+    keyIndex_.erase(it->first);
+    kvStore_.erase(it);
+  }
+  LOG(INFO) << "Expired " << expiredKeys.size()
+            << " settled tombstones early in area " << area_;
+  const size_t numExpired = expiredKeys.size();
+
+  thrift::Publication expiredKeysPub{};
+  *expiredKeysPub.expiredKeys_ref() = std::move(expiredKeys);
+  floodPublication(std::move(expiredKeysPub));
+  return numExpired;
+}
+
 void
 KvStoreDb::bufferPublication(thrift::Publication&& publication) {
   fb303::fbData->addStatValue("kvstore.rate_limit_suppress", 1, fb303::COUNT);
@@ -2728,9 +3791,10 @@ KvStoreDb::finalizeFullSync(
     const std::vector<std::string>& keys, const std::string& senderId) {
   // build keyval to be sent
   thrift::Publication updates;
+  const auto peerName = getSenderPeerName(senderId);
   for (const auto& key : keys) {
     const auto& it = kvStore_.find(key);
-    if (it != kvStore_.end()) {
+    if (it != kvStore_.end() and canFloodToPeer(key, it->second, peerName)) {
       updates.keyVals_ref()->emplace(key, it->second);
     }
   }
@@ -2742,7 +3806,6 @@ KvStoreDb::finalizeFullSync(
     return;
   }
 
-  thrift::KvStoreRequest updateRequest;
   thrift::KeySetParams params;
 
   *params.keyVals_ref() = std::move(*updates.keyVals_ref());
@@ -2751,10 +3814,6 @@ KvStoreDb::finalizeFullSync(
   params.floodRootId_ref().from_optional(DualNode::getSptRootId());
   params.timestamp_ms_ref() = getUnixTimeStampMs();
 
-  updateRequest.cmd_ref() = thrift::Command::KEY_SET;
-  updateRequest.keySetParams_ref() = params;
-  *updateRequest.area_ref() = area_;
-
   // ATTN: KvStore maintains different mechanism over 3-way full-sync.
   //  1) Over thrift peer connection;
   //  2) Over ZMQ socket;
@@ -2816,6 +3875,11 @@ KvStoreDb::finalizeFullSync(
     VLOG(1) << "finalizeFullSync back to: " << senderId
             << " with keys: " << folly::join(",", keys);
 
+    thrift::KvStoreRequest updateRequest;
+    updateRequest.cmd_ref() = thrift::Command::KEY_SET;
+    updateRequest.keySetParams_ref() = std::move(params);
+    *updateRequest.area_ref() = area_;
+
     auto const ret = sendMessageToPeer(senderId, updateRequest);
     if (ret.hasError()) {
       // this could fail when senderId goes offline
@@ -2848,6 +3912,137 @@ KvStoreDb::getFloodPeers(const std::optional<std::string>& rootId) {
   return floodPeers;
 }
 
+const thrift::KvstoreFloodScope*
+KvStoreDb::getFloodScope(const std::string& key) const {
+  for (const auto& floodScope : kvParams_.floodScopes) {
+    if (not folly::StringPiece(key).startsWith(
+            *floodScope.key_prefix_ref())) {
+      continue;
+    }
+    if (*floodScope.scope_ref() == thrift::KvstoreFloodScopeType::AREA) {
+      return nullptr;
+    }
+    return &floodScope;
+  }
+  return nullptr;
+}
+
+bool
+KvStoreDb::canFloodToPeer(
+    const std::string& key,
+    const thrift::Value& value,
+    const std::string& peerName) const {
+  const auto floodScope = getFloodScope(key);
+  if (not floodScope) {
+    return true;
+  }
+  // only the originator floods keys of limited scope
+  if (*value.originatorId_ref() != kvParams_.nodeId) {
+    return false;
+  }
+  if (*floodScope->scope_ref() == thrift::KvstoreFloodScopeType::ONE_HOP) {
+    return true;
+  }
+  const auto& subscribers = *floodScope->subscribers_ref();
+  return std::find(subscribers.begin(), subscribers.end(), peerName) !=
+      subscribers.end();
+}
+
+bool
+KvStoreDb::canAcceptFromPeer(
+    const std::string& key,
+    const thrift::Value& value,
+    const std::string& peerName) const {
+  const auto floodScope = getFloodScope(key);
+  if (not floodScope) {
+    return true;
+  }
+  // keys of limited scope are only accepted from their originator, e.g. not
+  // when a peer relays them in full-sync
+  if (*value.originatorId_ref() != peerName) {
+    return false;
+  }
+  if (*floodScope->scope_ref() == thrift::KvstoreFloodScopeType::ONE_HOP) {
+    return true;
+  }
+  const auto& subscribers = *floodScope->subscribers_ref();
+  return std::find(subscribers.begin(), subscribers.end(), kvParams_.nodeId) !=
+      subscribers.end();
+}
+
+std::string
+KvStoreDb::getSenderPeerName(const std::string& senderId) const {
+  if (kvParams_.enableKvStoreThrift) {
+    return senderId;
+  }
+  for (const auto& [peerName, peer] : peers_) {
+    if (peer.second == senderId) {
+      return peerName;
+    }
+  }
+  return senderId;
+}
+
+void
+KvStoreDb::updateTombstone(
+    const std::string& key, const thrift::Value& value) {
+  if (not value.tombstone_ref().value_or(false)) {
+    tombstones_.erase(key);
+    return;
+  }
+  auto& tombstone = tombstones_[key];
+  if (tombstone.version != *value.version_ref()) {
+    // new tombstone, no peer is known to hold it yet
+    tombstone.version = *value.version_ref();
+    tombstone.ackedPeers.clear();
+  }
+}
+
+std::vector<std::pair<std::string, int64_t>>
+KvStoreDb::getTombstones(
+    const std::unordered_map<std::string, thrift::Value>& keyVals) {
+  std::vector<std::pair<std::string, int64_t>> tombstones;
+  for (const auto& [key, value] : keyVals) {
+    if (value.tombstone_ref().value_or(false)) {
+      tombstones.emplace_back(key, *value.version_ref());
+    }
+  }
+  return tombstones;
+}
+
+void
+KvStoreDb::ackTombstones(
+    const std::string& peerName,
+    const std::unordered_map<std::string, thrift::Value>& keyVals) {
+  if (not tombstones_.empty()) {
+    ackTombstones(peerName, getTombstones(keyVals));
+  }
+}
+
+void
+KvStoreDb::ackTombstones(
+    const std::string& peerName,
+    const std::vector<std::pair<std::string, int64_t>>& tombstones) {
+  for (const auto& [key, version] : tombstones) {
+    auto it = tombstones_.find(key);
+    if (it != tombstones_.end() and it->second.version == version) {
+      it->second.ackedPeers.emplace(peerName);
+    }
+  }
+}
+
+bool
+KvStoreDb::isSettledTombstone(const std::string& key) const {
+  const auto it = tombstones_.find(key);
+  if (it == tombstones_.end()) {
+    return false;
+  }
+  const auto& ackedPeers = it->second.ackedPeers;
+  return std::all_of(peers_.begin(), peers_.end(), [&](const auto& peer) {
+    return ackedPeers.count(peer.first) != 0;
+  });
+}
+
 void
 KvStoreDb::collectSendFailureStats(
     const fbzmq::Error& error, const std::string& dstSockId) {
@@ -2857,6 +4052,51 @@ KvStoreDb::collectSendFailureStats(
       fb303::COUNT);
 }
 
+void
+KvStoreDb::publishToSubscribers(thrift::Publication&& publication) {
+  const auto isAdjKey = [](const std::string& key) {
+    return parseKvStoreKey(key).type == KvStoreKeyType::ADJ_DB;
+  };
+
+  // Move adjacency keys into their own publication
+  thrift::Publication adjPublication;
+  for (auto it = publication.keyVals_ref()->begin();
+       it != publication.keyVals_ref()->end();) {
+    if (isAdjKey(it->first)) {
+      adjPublication.keyVals_ref()->emplace(it->first, std::move(it->second));
+      it = publication.keyVals_ref()->erase(it);
+    } else {
+      ++it;
+    }
+  }
+  auto& expiredKeys = *publication.expiredKeys_ref();
+  auto adjExpiredIt = std::stable_partition(
+      expiredKeys.begin(), expiredKeys.end(), [&](const std::string& key) {
+        return not isAdjKey(key);
+      });
+  std::move(
+      adjExpiredIt,
+      expiredKeys.end(),
+      std::back_inserter(*adjPublication.expiredKeys_ref()));
+  expiredKeys.erase(adjExpiredIt, expiredKeys.end());
+
+  const bool hasAdjKeys = adjPublication.keyVals_ref()->size() or
+      adjPublication.expiredKeys_ref()->size();
+  const bool hasOtherKeys =
+      publication.keyVals_ref()->size() or expiredKeys.size();
+  if (hasAdjKeys) {
+    adjPublication.nodeIds_ref().copy_from(publication.nodeIds_ref());
+    adjPublication.floodRootId_ref().copy_from(publication.floodRootId_ref());
+    adjPublication.area_ref() = *publication.area_ref();
+    kvParams_.kvStoreUpdatesQueue.push(
+        std::move(adjPublication), Constants::kKvStoreUpdatesAdjPriority);
+  }
+  if (hasOtherKeys or not hasAdjKeys) {
+    kvParams_.kvStoreUpdatesQueue.push(
+        std::move(publication), Constants::kKvStoreUpdatesDefaultPriority);
+  }
+}
+
 void
 KvStoreDb::floodPublication(
     thrift::Publication&& publication, bool rateLimit, bool setFloodRoot) {
@@ -2892,19 +4132,35 @@ KvStoreDb::floodPublication(
   if (not publication.nodeIds_ref().has_value()) {
     publication.nodeIds_ref() = std::vector<std::string>{};
   }
-  publication.nodeIds_ref()->emplace_back(kvParams_.nodeId);
+  auto& nodeIds = *publication.nodeIds_ref();
+  nodeIds.emplace_back(kvParams_.nodeId);
+  if (nodeIds.size() > Constants::kMaxFloodPathLength) {
+    nodeIds.erase(
+        nodeIds.begin(), nodeIds.end() - Constants::kMaxFloodPathLength);
+  }
+
+  // Prepare thrift structure for flooding keyValue ONLY updates to external
+  // neighbors before handing over the publication to internal subscribers.
+  // This saves a deep copy of all values for the subscribers.
+  thrift::KeySetParams params;
+  const bool floodToPeers = not publication.keyVals_ref()->empty();
+  if (floodToPeers) {
+    *params.keyVals_ref() = *publication.keyVals_ref();
+    params.nodeIds_ref().copy_from(publication.nodeIds_ref());
+    params.floodRootId_ref().copy_from(publication.floodRootId_ref());
+  }
 
   // Flood publication to internal subscribers
-  kvParams_.kvStoreUpdatesQueue.push(publication);
-  fb303::fbData->addStatValue("kvstore.num_updates", 1, fb303::COUNT);
+  publishToSubscribers(std::move(publication));
+  static const StatHandle kNumUpdates("kvstore.num_updates", fb303::COUNT);
+  kNumUpdates.addValue(1);
 
-  // Flood keyValue ONLY updates to external neighbors
-  if (publication.keyVals_ref()->empty()) {
+  if (not floodToPeers) {
     return;
   }
 
   // Key collection to be flooded
-  auto keysToUpdate = folly::gen::from(*publication.keyVals_ref()) |
+  auto keysToUpdate = folly::gen::from(*params.keyVals_ref()) |
       folly::gen::get<0>() | folly::gen::as<std::vector<std::string>>();
 
   VLOG(2) << "Flood publication from: " << kvParams_.nodeId
@@ -2913,34 +4169,65 @@ KvStoreDb::floodPublication(
 
   if (setFloodRoot and not senderId.has_value()) {
     // I'm the initiator, set flood-root-id
-    publication.floodRootId_ref().from_optional(DualNode::getSptRootId());
+    params.floodRootId_ref().from_optional(DualNode::getSptRootId());
   }
 
-  // prepare thrift structure for flooding purpose
-  thrift::KvStoreRequest floodRequest;
-  thrift::KeySetParams params;
-
-  *params.keyVals_ref() = *publication.keyVals_ref();
   // TODO: remove solicit response when all KEY_SET request is over thrift
   params.solicitResponse_ref() = false;
-  params.nodeIds_ref().copy_from(publication.nodeIds_ref());
-  params.floodRootId_ref().copy_from(publication.floodRootId_ref());
   params.timestamp_ms_ref() = getUnixTimeStampMs();
 
-  floodRequest.cmd_ref() = thrift::Command::KEY_SET;
-  floodRequest.keySetParams_ref() = params;
-  *floodRequest.area_ref() = area_;
-
   std::optional<std::string> floodRootId{std::nullopt};
   if (params.floodRootId_ref().has_value()) {
     floodRootId = params.floodRootId_ref().value();
   }
-  const auto& floodPeers = getFloodPeers(floodRootId);
+
+  // Keys of limited flood scope are sent by their originator to all peers in
+  // scope directly, regardless of the flooding topology
+  std::unordered_map<std::string /* peerName */, thrift::KeySetParams>
+      scopedParams;
+  if (not kvParams_.floodScopes.empty()) {
+    std::unordered_map<std::string, thrift::Value> scopedKeyVals;
+    auto& keyVals = *params.keyVals_ref();
+    for (auto it = keyVals.begin(); it != keyVals.end();) {
+      if (getFloodScope(it->first)) {
+        scopedKeyVals.emplace(std::move(*it));
+        it = keyVals.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (const auto& [peerName, _] : peers_) {
+      thrift::KeySetParams peerParams;
+      for (const auto& [key, value] : scopedKeyVals) {
+        if (canFloodToPeer(key, value, peerName)) {
+          peerParams.keyVals_ref()->emplace(key, value);
+        }
+      }
+      if (peerParams.keyVals_ref()->empty()) {
+        continue;
+      }
+      peerParams.nodeIds_ref().copy_from(params.nodeIds_ref());
+      peerParams.solicitResponse_ref() = false;
+      peerParams.timestamp_ms_ref() = *params.timestamp_ms_ref();
+      scopedParams.emplace(peerName, std::move(peerParams));
+    }
+  }
+  const auto floodPeers = params.keyVals_ref()->empty()
+      ? std::unordered_set<std::string>{}
+      : getFloodPeers(floodRootId);
 
   // ATTN: KvStore maintains different ways of flooding mechanism.
   //  1) Over thrift peer connection;
   //  2) Over ZMQ socket;
   if (kvParams_.enableKvStoreThrift) {
+    for (const auto& [peerName, peerParams] : scopedParams) {
+      auto peerIt = thriftPeers_.find(peerName);
+      if (peerIt != thriftPeers_.end() and
+          peerIt->second.state == KvStorePeerState::INITIALIZED and
+          peerIt->second.client) {
+        floodThriftPeer(peerName, peerParams);
+      }
+    }
     for (const auto& peerName : floodPeers) {
       auto peerIt = thriftPeers_.find(peerName);
       if (peerIt == thriftPeers_.end()) {
@@ -2961,49 +4248,18 @@ KvStoreDb::floodPublication(
         continue;
       }
 
-      // record telemetry for flooding publications
-      fb303::fbData->addStatValue(
-          "kvstore.thrift.num_flood_pub", 1, fb303::COUNT);
-      fb303::fbData->addStatValue(
-          "kvstore.thrift.num_flood_key_vals",
-          publication.keyVals_ref()->size(),
-          fb303::SUM);
-
-      auto startTime = std::chrono::steady_clock::now();
-      auto sf = thriftPeer.client->semifuture_setKvStoreKeyVals(params, area_);
-      std::move(sf)
-          .via(evb_->getEvb())
-          .thenValue([peerName, startTime](folly::Unit&&) {
-            VLOG(4) << "Flooding ack received from peer: " << peerName;
-
-            auto endTime = std::chrono::steady_clock::now();
-            auto timeDelta =
-                std::chrono::duration_cast<std::chrono::milliseconds>(
-                    endTime - startTime);
-
-            // record telemetry for thrift calls
-            fb303::fbData->addStatValue(
-                "kvstore.thrift.num_flood_pub_success", 1, fb303::COUNT);
-            fb303::fbData->addStatValue(
-                "kvstore.thrift.flood_pub_duration_ms",
-                timeDelta.count(),
-                fb303::AVG);
-          })
-          .thenError(
-              [this, peerName, startTime](const folly::exception_wrapper& ew) {
-                // state transition to IDLE
-                auto endTime = std::chrono::steady_clock::now();
-                auto timeDelta =
-                    std::chrono::duration_cast<std::chrono::milliseconds>(
-                        endTime - startTime);
-                processThriftFailure(peerName, ew.what(), timeDelta);
-
-                // record telemetry for thrift calls
-                fb303::fbData->addStatValue(
-                    "kvstore.thrift.num_flood_pub_failure", 1, fb303::COUNT);
-              });
+      floodThriftPeer(peerName, params);
     }
   } else {
+    thrift::KvStoreRequest floodRequest;
+    floodRequest.cmd_ref() = thrift::Command::KEY_SET;
+    *floodRequest.area_ref() = area_;
+    for (auto& [peerName, peerParams] : scopedParams) {
+      floodRequest.keySetParams_ref() = std::move(peerParams);
+      sendFloodRequestToPeer(peerName, floodRequest);
+    }
+    floodRequest.keySetParams_ref() = std::move(params);
+
     for (const auto& peer : floodPeers) {
       if (senderId.has_value() && senderId.value() == peer) {
         // Do not flood towards senderId from whom we received this publication
@@ -3013,22 +4269,8 @@ KvStoreDb::floodPublication(
               << (senderId.has_value() ? senderId.value() : "N/A")
               << ", to: " << peer << ", via: " << kvParams_.nodeId;
 
-      fb303::fbData->addStatValue("kvstore.sent_publications", 1, fb303::COUNT);
-      fb303::fbData->addStatValue(
-          "kvstore.sent_key_vals",
-          publication.keyVals_ref()->size(),
-          fb303::SUM);
-
       // Send flood request
-      auto const& peerCmdSocketId = peers_.at(peer).second;
-      auto const ret = sendMessageToPeer(peerCmdSocketId, floodRequest);
-      if (ret.hasError()) {
-        // this could be pretty common on initial connection setup
-        LOG(ERROR) << "Failed to flood publication to peer " << peer
-                   << " using id " << peerCmdSocketId
-                   << ", error: " << ret.error();
-        collectSendFailureStats(ret.error(), peerCmdSocketId);
-      }
+      sendFloodRequestToPeer(peer, floodRequest);
     }
   }
 }
@@ -3038,11 +4280,12 @@ KvStoreDb::mergePublication(
     const thrift::Publication& rcvdPublication,
     std::optional<std::string> senderId) {
   // Add counters
-  fb303::fbData->addStatValue("kvstore.received_publications", 1, fb303::COUNT);
-  fb303::fbData->addStatValue(
-      "kvstore.received_key_vals",
-      rcvdPublication.keyVals_ref()->size(),
-      fb303::SUM);
+  static const StatHandle kReceivedPublications(
+      "kvstore.received_publications", fb303::COUNT);
+  static const StatHandle kReceivedKeyVals(
+      "kvstore.received_key_vals", fb303::SUM);
+  kReceivedPublications.addValue(1);
+  kReceivedKeyVals.addValue(rcvdPublication.keyVals_ref()->size());
 
   const bool needFinalizeFullSync = senderId.has_value() and
       rcvdPublication.tobeUpdatedKeys_ref().has_value() and
@@ -3062,10 +4305,58 @@ KvStoreDb::mergePublication(
     return 0;
   }
 
+  // Peer publication is received from, if any
+  std::optional<std::string> sender;
+  if (senderId.has_value()) {
+    sender = getSenderPeerName(*senderId);
+  } else if (nodeIds.has_value() and not nodeIds->empty()) {
+    sender = nodeIds->back();
+  }
+
+  // Drop keys received outside of their flood scope
+  const auto* rcvdKeyVals = &*rcvdPublication.keyVals_ref();
+  std::unordered_map<std::string, thrift::Value> keyValsInScope;
+  if (sender.has_value() and not kvParams_.floodScopes.empty()) {
+    const auto numRejected = std::count_if(
+        rcvdKeyVals->begin(), rcvdKeyVals->end(), [&](const auto& kv) {
+          return not canAcceptFromPeer(kv.first, kv.second, *sender);
+        });
+    if (numRejected) {
+      VLOG(2) << "Dropping " << numRejected << " keys from " << *sender
+              << " out of their flood scope";
+      fb303::fbData->addStatValue(
+          "kvstore.flood_scope_rejected_keys", numRejected, fb303::SUM);
+      for (const auto& [key, value] : *rcvdKeyVals) {
+        if (canAcceptFromPeer(key, value, *sender)) {
+          keyValsInScope.emplace(key, value);
+        }
+      }
+      rcvdKeyVals = &keyValsInScope;
+    }
+  }
+
   // Generate delta with local KvStore
   thrift::Publication deltaPublication;
+  const size_t numKeys = kvStore_.size();
   *deltaPublication.keyVals_ref() = KvStore::mergeKeyValues(
-      kvStore_, *rcvdPublication.keyVals_ref(), kvParams_.filters);
+      kvStore_,
+      *rcvdKeyVals,
+      kvParams_.filters,
+      kvParams_.mergeExecutor,
+      kvParams_.mergeThreads);
+  for (auto const& [key, _] : *deltaPublication.keyVals_ref()) {
+    auto const& kv = *kvStore_.find(key);
+    merkleTree_.set(key, kv.second);
+    updateTombstone(key, kv.second);
+    // merging never removes keys, only index new ones
+    if (kvStore_.size() != numKeys) {
+      keyIndex_.emplace(kv.first, &kv);
+    }
+  }
+  // sender holds the tombstones it sent, whether they were news or not
+  if (sender.has_value()) {
+    ackTombstones(*sender, *rcvdKeyVals);
+  }
   deltaPublication.floodRootId_ref().copy_from(
       rcvdPublication.floodRootId_ref());
   *deltaPublication.area_ref() = area_;
@@ -3100,6 +4391,61 @@ KvStoreDb::mergePublication(
   return kvUpdateCnt;
 }
 
+void
+KvStoreDb::setLocalKeyVals(
+    thrift::KeyVals keyVals, folly::Promise<folly::Unit> p) {
+  for (auto& [key, value] : keyVals) {
+    auto it = pendingLocalKeyVals_.find(key);
+    if (it == pendingLocalKeyVals_.end()) {
+      pendingLocalKeyVals_.emplace(key, std::move(value));
+      continue;
+    }
+    // a newer version supersedes the pending one, which would be merged and
+    // flooded only to be replaced right away
+    if (value.value_ref().has_value() and it->second.value_ref().has_value() and
+        *value.version_ref() > *it->second.version_ref()) {
+      it->second = std::move(value);
+      fb303::fbData->addStatValue(
+          "kvstore.local_set_coalesced_keys", 1, fb303::COUNT);
+      continue;
+    }
+    // otherwise keep the order in which both are merged
+    flushLocalKeyVals();
+    pendingLocalKeyVals_.emplace(key, std::move(value));
+  }
+  pendingLocalSetPromises_.emplace_back(std::move(p));
+
+  if (not kvParams_.localSetBatchWindow.has_value()) {
+    flushLocalKeyVals();
+  } else if (not localSetBatchTimer_->isScheduled()) {
+    localSetBatchTimer_->scheduleTimeout(*kvParams_.localSetBatchWindow);
+  }
+}
+
+void
+KvStoreDb::flushLocalKeyVals() {
+  localSetBatchTimer_->cancelTimeout();
+  if (pendingLocalSetPromises_.empty()) {
+    return;
+  }
+
+  fb303::fbData->addStatValue(
+      "kvstore.local_set_batch_size",
+      pendingLocalSetPromises_.size(),
+      fb303::AVG);
+  prepareSetKeyVals(pendingLocalKeyVals_, kvParams_.valueCompressionMinBytes);
+  thrift::Publication publication;
+  *publication.keyVals_ref() = std::move(pendingLocalKeyVals_);
+  pendingLocalKeyVals_.clear();
+  mergePublication(publication);
+
+  auto promises = std::move(pendingLocalSetPromises_);
+  pendingLocalSetPromises_.clear();
+  for (auto& promise : promises) {
+    promise.setValue();
+  }
+}
+
 void
 KvStoreDb::logSyncEvent(
     const std::string& peerNodeName,
@@ -8,14 +8,19 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
 
-#include <boost/heap/priority_queue.hpp>
 #include <fbzmq/zmq/Zmq.h>
+#include <folly/Function.h>
 #include <folly/Optional.h>
 #include <folly/TokenBucket.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/gen/Base.h>
 #include <folly/io/IOBuf.h>
@@ -28,17 +33,25 @@
 #include <openr/common/OpenrEventBase.h>
 #include <openr/common/Types.h>
 #include <openr/common/Util.h>
+#include <openr/common/WheelTimeout.h>
 #include <openr/config/Config.h>
 #include <openr/dual/Dual.h>
+#include <openr/kvstore/KvStoreMerkleTree.h>
+#include <openr/kvstore/TtlCountdownQueue.h>
 #include <openr/if/gen-cpp2/Dual_types.h>
 #include <openr/if/gen-cpp2/KvStore_constants.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
 #include <openr/if/gen-cpp2/OpenrConfig_types.h>
+#include <openr/if/gen-cpp2/OpenrCtrl_types.h>
 #include <openr/messaging/ReplicateQueue.h>
 #include <openr/monitor/LogSample.h>
 
 namespace openr {
 
+// KvStore updates are replicated to many readers (Decision, KvStore clients
+// of other modules, ctrl handler). All of them share one immutable instance.
+using PublicationPtr = std::shared_ptr<const thrift::Publication>;
+
 //
 // Define KvStorePeerState to maintain peer's state transition
 // during peer coming UP/DOWN for initial sync.
@@ -60,25 +73,6 @@ enum class KvStorePeerEvent {
   THRIFT_API_ERROR = 3,
 };
 
-struct TtlCountdownQueueEntry {
-  std::chrono::steady_clock::time_point expiryTime;
-  std::string key;
-  int64_t version{0};
-  int64_t ttlVersion{0};
-  std::string originatorId;
-  bool
-  operator>(TtlCountdownQueueEntry other) const {
-    return expiryTime > other.expiryTime;
-  }
-};
-
-// TODO: migrate to std::priority_queue
-using TtlCountdownQueue = boost::heap::priority_queue<
-    TtlCountdownQueueEntry,
-    // Always returns smallest first
-    boost::heap::compare<std::greater<TtlCountdownQueueEntry>>,
-    boost::heap::stable<true>>;
-
 class KvStoreFilters {
  public:
   // takes the list of comma separated key prefixes to match,
@@ -104,6 +98,11 @@ class KvStoreFilters {
   // return set of origninator IDs
   std::set<std::string> getOriginatorIdList() const;
 
+  // sorted literal key prefixes which all keys matching with `oper` start
+  // with, nullptr if there are none (e.g. regex key prefixes)
+  std::vector<std::string> const* getLiteralKeyPrefixes(
+      thrift::FilterOperator const& oper = thrift::FilterOperator::OR) const;
+
   // print filters
   std::string str() const;
 
@@ -124,7 +123,7 @@ struct KvStoreParams {
   std::string nodeId;
 
   // Queue for publishing KvStore updates to other modules within a process
-  messaging::ReplicateQueue<thrift::Publication>& kvStoreUpdatesQueue;
+  messaging::ReplicateQueue<PublicationPtr>& kvStoreUpdatesQueue;
 
   // Queue for publishing kvstore peer initial sync events
   messaging::ReplicateQueue<KvStoreSyncEvent>& kvStoreSyncEventsQueue;
@@ -153,10 +152,23 @@ struct KvStoreParams {
   std::chrono::milliseconds ttlDecr{Constants::kTtlDecrement};
   bool enableFloodOptimization{false};
   bool isFloodRoot{false};
+  // full-sync with thrift peers based on KvStoreMerkleTree digests
+  bool enableMerkleSync{false};
+  // executor to merge large publications on, shared by all areas
+  folly::Executor* mergeExecutor{nullptr};
+  size_t mergeThreads{1};
+  // flooding scope of keys by prefix, first matching prefix applies
+  std::vector<thrift::KvstoreFloodScope> floodScopes;
+  // compress values set on this node of at least this many bytes
+  std::optional<size_t> valueCompressionMinBytes;
+  // peers to full-sync with until one of them succeeded
+  std::optional<size_t> initialSyncPeers;
+  // batch key-values set by local modules within this window
+  std::optional<std::chrono::milliseconds> localSetBatchWindow;
 
   KvStoreParams(
       std::string nodeid,
-      messaging::ReplicateQueue<thrift::Publication>& kvStoreUpdatesQueue,
+      messaging::ReplicateQueue<PublicationPtr>& kvStoreUpdatesQueue,
       messaging::ReplicateQueue<KvStoreSyncEvent>& kvStoreSyncEventsQueue,
       messaging::ReplicateQueue<LogSample>& logSampleQueue,
       fbzmq::Socket<ZMQ_ROUTER, fbzmq::ZMQ_SERVER> globalCmdSock,
@@ -176,7 +188,8 @@ struct KvStoreParams {
       // TTL decrement factor
       std::chrono::milliseconds ttldecr,
       bool enableFloodOptimization,
-      bool isfloodRoot)
+      bool isfloodRoot,
+      bool enableMerkleSync)
       : nodeId(nodeid),
         kvStoreUpdatesQueue(kvStoreUpdatesQueue),
         kvStoreSyncEventsQueue(kvStoreSyncEventsQueue),
@@ -191,7 +204,8 @@ struct KvStoreParams {
         floodRate(std::move(floodrate)),
         ttlDecr(ttldecr),
         enableFloodOptimization(enableFloodOptimization),
-        isFloodRoot(isfloodRoot) {}
+        isFloodRoot(isfloodRoot),
+        enableMerkleSync(enableMerkleSync) {}
 };
 
 // The class represents a KV Store DB and stores KV pairs in internal map.
@@ -221,21 +235,66 @@ class KvStoreDb : public DualNode {
   thrift::Publication getKeyVals(std::vector<std::string> const& keys);
 
   // dump the entries of my KV store whose keys match the filter
+  // (re)configure flood rate limiting from kvParams_.floodRate. Updates held
+  // back by the limiter are flooded if it gets disabled
+  void updateFloodRate();
+
+  // expire tombstones all peers hold ahead of their TTL, to free memory under
+  // memory pressure. Returns number of tombstones expired
+  size_t compactTombstones();
+
   thrift::Publication dumpAllWithFilters(
       KvStoreFilters const& kvFilters,
       thrift::FilterOperator oper = thrift::FilterOperator::OR,
       bool doNotPublishValue = false) const;
 
+  // dump up to limit entries matching the filter, in key order after cursor.
+  // nextCursor is set if more entries match
+  thrift::Publication dumpPageWithFilters(
+      KvStoreFilters const& kvFilters,
+      thrift::FilterOperator oper,
+      bool doNotPublishValue,
+      std::optional<std::string> const& cursor,
+      size_t limit,
+      std::optional<std::string>& nextCursor) const;
+
   // dump the hashes of my KV store whose keys match the given prefix
-  // if prefix is the empty sting, the full hash store is dumped
+  // if prefix is the empty sting, the full hash store is dumped. Tombstones
+  // all peers hold can be left out for full-sync
   thrift::Publication dumpHashWithFilters(
-      KvStoreFilters const& kvFilters) const;
+      KvStoreFilters const& kvFilters,
+      bool excludeSettledTombstones = false) const;
 
   // dump the keys on which hashes differ from given keyVals
   thrift::Publication dumpDifference(
       std::unordered_map<std::string, thrift::Value> const& myKeyVal,
       std::unordered_map<std::string, thrift::Value> const& reqKeyVal) const;
 
+  // same as dumpDifference() for my keys matching filters, walking KV store
+  // in place and only copying values to send. Short-circuits if reqDigest,
+  // the digest of all key-values of requester, matches mine
+  thrift::Publication dumpDifferenceWithFilters(
+      KvStoreFilters const& kvFilters,
+      thrift::FilterOperator oper,
+      bool doNotPublishValue,
+      std::unordered_map<std::string, thrift::Value> const& reqKeyVal,
+      std::optional<int64_t> reqDigest) const;
+
+  // digest of all my key-values, see KvStoreMerkleTree
+  int64_t
+  getKeyValsDigest() const {
+    return merkleTree_.getDigest(KvStoreMerkleTree::kRoot);
+  }
+
+  // dump the KvStoreMerkleTree nodes on which digests differ from given ones
+  thrift::Publication dumpMismatchedDigests(
+      std::map<int32_t, int64_t> const& keyValDigests) const;
+
+  // same as dumpDifference() for my keys under given KvStoreMerkleTree nodes
+  thrift::Publication dumpDifferenceUnderNodes(
+      std::map<int32_t, int64_t> const& keyValDigests,
+      std::unordered_map<std::string, thrift::Value> const& reqKeyVal) const;
+
   // Merge received publication with local store and publish out the delta.
   // If senderId is set, will build <key:value> map from kvStore_ and
   // rcvdPublication.tobeUpdatedKeys and send back to senderId to update it
@@ -244,6 +303,11 @@ class KvStoreDb : public DualNode {
       thrift::Publication const& rcvdPublication,
       std::optional<std::string> senderId = std::nullopt);
 
+  // Merge key-values set by local modules. With kvParams_.localSetBatchWindow
+  // they are held back and merged with all others set within the window in
+  // one publication. Promise is fulfilled once they are merged
+  void setLocalKeyVals(thrift::KeyVals keyVals, folly::Promise<folly::Unit> p);
+
   // update Time to expire filed in Publication
   // removeAboutToExpire: knob to remove keys which are about to expire
   // and hence do not want to include them. Constants::kTtlThreshold
@@ -279,6 +343,10 @@ class KvStoreDb : public DualNode {
   // util function to fetch peer by its state
   std::vector<std::string> getPeersByState(KvStorePeerState state);
 
+  // IDLE peers in order to full-sync with, lowest RTT first, then peers added
+  // longest ago
+  std::vector<std::string> getIdlePeersBySyncPriority() const;
+
   // util function for state transition
   static KvStorePeerState getNextState(
       std::optional<KvStorePeerState> const& currState,
@@ -301,6 +369,16 @@ class KvStoreDb : public DualNode {
   // method to scan over thriftPeers to send full-dump request
   void requestThriftPeerSync();
 
+  // send one round of KvStoreMerkleTree based full-sync request to peer.
+  // Digests of nodesToCompare are sent for the peer to report mismatching
+  // ones, which are descended into next round. Once there is nothing left to
+  // compare, key hashes under nodesToSync are exchanged as regular full-sync
+  void requestMerkleSync(
+      std::string const& peerName,
+      std::vector<int32_t> const& nodesToCompare,
+      std::vector<int32_t> nodesToSync,
+      std::chrono::steady_clock::time_point startTime);
+
   // util function to process when sync response received
   void processThriftSuccess(
       std::string const& peerName,
@@ -313,6 +391,18 @@ class KvStoreDb : public DualNode {
       folly::fbstring const& exceptionStr,
       std::chrono::milliseconds timeDelta);
 
+  // Flood key-vals to thrift peer without waiting for acks of previous
+  // floods. Keys are held back in the flood backlog of the peer instead if
+  // too many requests are in flight already.
+  void floodThriftPeer(
+      std::string const& peerName, thrift::KeySetParams const& params);
+
+  // Flood latest values of the keys held back for thrift peer
+  void floodThriftPeerBacklog(std::string const& peerName);
+
+  // merge pending key-values of setLocalKeyVals()
+  void flushLocalKeyVals();
+
   // send dual messages over syncSock
   bool sendDualMessages(
       const std::string& neighbor,
@@ -353,6 +443,43 @@ class KvStoreDb : public DualNode {
   std::unordered_set<std::string> getFloodPeers(
       const std::optional<std::string>& rootId);
 
+  // flood scope of key as per first matching configured key prefix, nullptr
+  // if key is flooded to the whole area
+  const thrift::KvstoreFloodScope* getFloodScope(const std::string& key) const;
+
+  // whether key-val may be sent to peer, resp. received from peer, as per
+  // its flood scope
+  bool canFloodToPeer(
+      const std::string& key,
+      const thrift::Value& value,
+      const std::string& peerName) const;
+  bool canAcceptFromPeer(
+      const std::string& key,
+      const thrift::Value& value,
+      const std::string& peerName) const;
+
+  // name of peer with given sender id of a full-sync, which is the peer cmd
+  // socket id over ZMQ
+  std::string getSenderPeerName(const std::string& senderId) const;
+
+  // index stored value of key in tombstones_ if it is a tombstone
+  void updateTombstone(const std::string& key, const thrift::Value& value);
+
+  // record that peer holds the tombstones among key-vals
+  void ackTombstones(
+      const std::string& peerName,
+      const std::unordered_map<std::string, thrift::Value>& keyVals);
+  void ackTombstones(
+      const std::string& peerName,
+      const std::vector<std::pair<std::string, int64_t>>& tombstones);
+
+  // tombstones among key-vals with their versions
+  static std::vector<std::pair<std::string, int64_t>> getTombstones(
+      const std::unordered_map<std::string, thrift::Value>& keyVals);
+
+  // whether key is a tombstone all peers hold
+  bool isSettledTombstone(const std::string& key) const;
+
   // collect router-client send failure statistics in following form
   // "kvstore.send_failure.dst-peer-id.error-code"
   // error: fbzmq-Error
@@ -373,6 +500,14 @@ class KvStoreDb : public DualNode {
   // periodically count down and purge expired keys from CountdownQueue
   void cleanupTtlCountdownQueue();
 
+  // Invoke fn for every key-val matching filters with oper. Keys are range
+  // scanned in keyIndex_ if filters only match literal key prefixes
+  void forEachKeyValWithFilters(
+      KvStoreFilters const& kvFilters,
+      thrift::FilterOperator oper,
+      std::function<void(std::string const&, thrift::Value const&)> const& fn)
+      const;
+
   // Function to flood publication to neighbors
   // publication => data element to flood
   // rateLimit => if 'false', publication will not be rate limited
@@ -382,6 +517,11 @@ class KvStoreDb : public DualNode {
       bool rateLimit = true,
       bool setFloodRoot = true);
 
+  // Push publication to internal subscribers. Adjacency keys are split off
+  // into a publication of higher priority class, see
+  // Constants::kKvStoreUpdatesAdjPriority
+  void publishToSubscribers(thrift::Publication&& publication);
+
   // perform last step as a 3-way full-sync request
   // full-sync initiator sends back key-val to senderId (where we made
   // full-sync request to) who need to update those keys
@@ -416,6 +556,20 @@ class KvStoreDb : public DualNode {
   folly::Expected<size_t, fbzmq::Error> sendMessageToPeer(
       const std::string& peerSocketId, const thrift::KvStoreRequest& request);
 
+  // [TO BE DEPRECATED]
+  // Send flood request to peer. Keys get queued up in the flood backlog of
+  // the peer instead, if sending fails or the peer has a backlog already.
+  void sendFloodRequestToPeer(
+      const std::string& peerName, const thrift::KvStoreRequest& floodRequest);
+
+  // [TO BE DEPRECATED]
+  // Flood latest values of the keys in the backlog of peer
+  void floodPeerBacklog(const std::string& peerName);
+
+  // [TO BE DEPRECATED]
+  // Back off from flooding to peer after a send failure
+  void backoffPeerFlood(const std::string& peerName);
+
   //
   // Private variables
   //
@@ -458,18 +612,38 @@ class KvStoreDb : public DualNode {
     // peer state
     KvStorePeerState state{KvStorePeerState::IDLE};
 
+    // when peer was added
+    const std::chrono::steady_clock::time_point addTime{
+        std::chrono::steady_clock::now()};
+
     // thrift client for this peer
     std::unique_ptr<thrift::OpenrCtrlCppAsyncClient> client{nullptr};
 
     // timer to periodically send keep-alive status
     // ATTN: this mechanism serves the purpose of avoiding channel being
     //       closed from thrift server due to IDLE timeout(i.e. 60s by default)
-    std::unique_ptr<folly::AsyncTimeout> keepAliveTimer{nullptr};
+    //       Kept on coarse timer wheel, there is one per peer.
+    std::unique_ptr<WheelTimeout> keepAliveTimer{nullptr};
+
+    // id of client, unique within KvStoreDb. Responses to requests of a
+    // previous client are told apart by it
+    uint64_t clientId{0};
+
+    // number of flooding requests of client awaiting ack
+    size_t numFloodRequestsInFlight{0};
+
+    // keys held back from flooding and their flood-root-id, only their
+    // latest values are sent once requests in flight get acked
+    std::unordered_map<std::string, std::optional<std::string>>
+        pendingFloodKeys;
   };
 
   // set of peers with all info over thrift channel
   std::unordered_map<std::string, KvStorePeer> thriftPeers_{};
 
+  // last KvStorePeer::clientId handed out
+  uint64_t lastThriftClientId_{0};
+
   // [TO BE DEPRECATED]
   // The peers we will be talking to: both PUB and CMD URLs for each. We use
   // peerAddCounter_ to uniquely identify a peering session's socket-id.
@@ -486,6 +660,24 @@ class KvStoreDb : public DualNode {
   std::unordered_map<std::string, ExponentialBackoff<std::chrono::milliseconds>>
       peersToSyncWith_{};
 
+  // [TO BE DEPRECATED]
+  // Flood backlog of a peer. A slow peer (e.g. hitting the socket HWM) backs
+  // off from flooding without affecting other peers. Meanwhile updates of
+  // its keys are coalesced and only their latest values are sent on retry.
+  struct PeerFloodBacklog {
+    // pending keys and their flood-root-id
+    std::unordered_map<std::string, std::optional<std::string>> pendingKeys;
+
+    // backoff growing with consecutive send failures
+    ExponentialBackoff<std::chrono::milliseconds> expBackoff{
+        Constants::kInitialBackoff, Constants::kMaxBackoff};
+
+    // timer to flood pending keys once backoff expires
+    std::unique_ptr<WheelTimeout> retryTimer{nullptr};
+  };
+  std::unordered_map<std::string /* node-name */, PeerFloodBacklog>
+      peerFloodBacklogs_{};
+
   // [TO BE DEPRECATED]
   // Callback timer to get full KEY_DUMP from peersToSyncWith_
   std::unique_ptr<folly::AsyncTimeout> fullSyncTimer_;
@@ -496,11 +688,33 @@ class KvStoreDb : public DualNode {
   // store keys mapped to (version, originatoId, value)
   std::unordered_map<std::string, thrift::Value> kvStore_;
 
+  // digests of kvStore_ for full-sync, kept in sync with kvStore_
+  KvStoreMerkleTree merkleTree_;
+
+  // tombstones in kvStore_, i.e. last values of keys withdrawn by their
+  // originator left to expire, with the peers known to hold them. Once all
+  // peers do, they are settled and left out of full-sync
+  struct Tombstone {
+    int64_t version{0};
+    std::unordered_set<std::string> ackedPeers;
+  };
+  std::unordered_map<std::string, Tombstone> tombstones_;
+
+  // entries of kvStore_ ordered by key, to range scan keys with a common
+  // prefix. Points into kvStore_ and is kept in sync with it
+  std::map<
+      std::string_view,
+      std::pair<const std::string, thrift::Value> const*>
+      keyIndex_;
+
   // TTL count down queue
   TtlCountdownQueue ttlCountdownQueue_;
 
-  // TTL count down timer
-  std::unique_ptr<folly::AsyncTimeout> ttlCountdownTimer_;
+  // TTL count down timer, on coarse timer wheel
+  std::unique_ptr<WheelTimeout> ttlCountdownTimer_;
+
+  // expiry time the TTL count down timer is scheduled for
+  std::chrono::steady_clock::time_point ttlCountdownTimerExpiry_;
 
   // [TO BE DEPRECATED]
   // Map of latest peer sync up request send to each peer
@@ -536,6 +750,13 @@ class KvStoreDb : public DualNode {
       unordered_map<std::optional<std::string>, std::unordered_set<std::string>>
           publicationBuffer_{};
 
+  // key-values of setLocalKeyVals() pending merge, and their promises
+  thrift::KeyVals pendingLocalKeyVals_;
+  std::vector<folly::Promise<folly::Unit>> pendingLocalSetPromises_;
+
+  // timer to merge pending local key-values, on 10ms timer wheel
+  std::unique_ptr<WheelTimeout> localSetBatchTimer_;
+
   // [TO BE DEPRECATED]
   // max parallel syncs allowed. It's initialized with '2' and doubles
   // up to a max value of kMaxFullSyncPendingCountThresholdfor each full sync
@@ -545,6 +766,10 @@ class KvStoreDb : public DualNode {
   // thrift version of "parallelSyncLimit_"
   size_t parallelSyncLimitOverThrift_{2};
 
+  // whether a full-sync over thrift succeeded since having no peers.
+  // Until then only kvParams_.initialSyncPeers peers are synced with
+  bool initialSyncDone_{false};
+
   // event loop
   OpenrEventBase* evb_{nullptr};
 };
@@ -562,7 +787,7 @@ class KvStore final : public OpenrEventBase {
       // the zmq context to use for IO
       fbzmq::Context& zmqContext,
       // Queue for publishing kvstore updates
-      messaging::ReplicateQueue<thrift::Publication>& kvStoreUpdatesQueue,
+      messaging::ReplicateQueue<PublicationPtr>& kvStoreUpdatesQueue,
       // Queue for publishing kvstore peer initial sync events
       messaging::ReplicateQueue<KvStoreSyncEvent>& kvStoreSyncEventsQueue,
       // Queue for receiving peer updates
@@ -588,10 +813,15 @@ class KvStore final : public OpenrEventBase {
   // process the key-values publication, and attempt to
   // merge it in existing map (first argument)
   // Return a publication made out of the updated values
+  // If executor is given, large publications are split into up to numShards
+  // shards by key hash which are checked against kvStore in parallel. The
+  // result is the same as merging serially
   static std::unordered_map<std::string, thrift::Value> mergeKeyValues(
       std::unordered_map<std::string, thrift::Value>& kvStore,
       std::unordered_map<std::string, thrift::Value> const& update,
-      std::optional<KvStoreFilters> const& filters = std::nullopt);
+      std::optional<KvStoreFilters> const& filters = std::nullopt,
+      folly::Executor* executor = nullptr,
+      size_t numShards = 1);
 
   // compare two thrift::Values to figure out which value is better to
   // use, it will compare following attributes in order
@@ -614,10 +844,28 @@ class KvStore final : public OpenrEventBase {
       thrift::KeySetParams keySetParams,
       std::string area = openr::thrift::KvStore_constants::kDefaultArea());
 
+  // setKvStoreKeyVals() for modules of this node, batched per area as per
+  // kvstore local_set_batch_window_ms, see KvStoreDb::setLocalKeyVals()
+  folly::SemiFuture<folly::Unit> setLocalKvStoreKeyVals(
+      thrift::KeyVals keyVals,
+      std::string area = openr::thrift::KvStore_constants::kDefaultArea());
+
+  std::optional<std::chrono::milliseconds>
+  getLocalSetBatchWindow() const {
+    return kvParams_.localSetBatchWindow;
+  }
+
   folly::SemiFuture<std::unique_ptr<thrift::Publication>> dumpKvStoreKeys(
       thrift::KeyDumpParams keyDumpParams,
       std::string area = openr::thrift::KvStore_constants::kDefaultArea());
 
+  // page of dumpKvStoreKeys() in key order, see thrift::PageParams
+  folly::SemiFuture<std::unique_ptr<thrift::PublicationPage>>
+  dumpKvStoreKeysPage(
+      thrift::KeyDumpParams keyDumpParams,
+      std::string area,
+      thrift::PageParams page);
+
   folly::SemiFuture<std::unique_ptr<thrift::Publication>> dumpKvStoreHashes(
       thrift::KeyDumpParams keyDumpParams,
       std::string area = openr::thrift::KvStore_constants::kDefaultArea());
@@ -646,8 +894,20 @@ class KvStore final : public OpenrEventBase {
 
   folly::SemiFuture<std::map<std::string, int64_t>> getCounters();
 
+  /**
+   * Apply runtime tunable knobs of a reloaded config, i.e. flood rate. Other
+   * settings keep their values from construction.
+   */
+  folly::SemiFuture<folly::Unit> applyConfig(
+      std::shared_ptr<const Config> config);
+
+  /**
+   * Tombstones all peers hold are expired early while under memory pressure.
+   */
+  folly::SemiFuture<folly::Unit> setMemoryPressure(MemoryPressure level);
+
   // API to get reader for kvStoreUpdatesQueue
-  messaging::RQueue<thrift::Publication> getKvStoreUpdatesReader();
+  messaging::RQueue<PublicationPtr> getKvStoreUpdatesReader();
 
   // API to fetch state of peerNode, used for unit-testing
   folly::SemiFuture<std::optional<KvStorePeerState>> getKvStorePeerState(
@@ -678,7 +938,20 @@ class KvStore final : public OpenrEventBase {
 
   void processPeerUpdates(thrift::PeerUpdateRequest&& req);
 
-  std::map<std::string, int64_t> getGlobalCounters() const;
+  std::map<std::string, int64_t> getGlobalCounters();
+
+  // Event base the KvStoreDb of area runs on, KvStore's own unless areas run
+  // on their own threads. Unknown areas are handled on KvStore's
+  folly::EventBase* getAreaEvb(std::string const& area);
+
+  // Call func with KvStoreDb of every area on its event base and wait for it
+  void forEachKvStoreDb(
+      folly::FunctionRef<void(std::string const&, KvStoreDb&)> func);
+
+  // Checkpoint adjacency and prefix key-values of all areas for warm restart.
+  // Dump is taken on the event base, encoding and writing is done on
+  // snapshotWriter_
+  void writeWarmRestartSnapshot();
 
   //
   // Private variables
@@ -687,9 +960,23 @@ class KvStore final : public OpenrEventBase {
   // Timer for updating and submitting counters periodically
   std::unique_ptr<folly::AsyncTimeout> counterUpdateTimer_{nullptr};
 
+  // Warm restart snapshots, only set if enabled in config
+  std::optional<thrift::WarmRestartConfig> warmRestartConfig_;
+  std::unique_ptr<folly::AsyncTimeout> snapshotTimer_{nullptr};
+  std::unique_ptr<folly::CPUThreadPoolExecutor> snapshotWriter_{nullptr};
+
   // kvstore parameters common to all kvstoreDB
   KvStoreParams kvParams_;
 
+  // threads to merge large publications on, outlives kvStoreDb_
+  std::unique_ptr<folly::CPUThreadPoolExecutor> mergeExecutor_{nullptr};
+
+  // event bases and their threads of areas if enable_area_threads is set,
+  // outlive kvStoreDb_
+  std::unordered_map<std::string /* area ID */, std::unique_ptr<OpenrEventBase>>
+      areaEvbs_{};
+  std::vector<std::thread> areaEvbThreads_{};
+
   // map of area IDs and instance of KvStoreDb
   std::unordered_map<std::string /* area ID */, KvStoreDb> kvStoreDb_{};
 
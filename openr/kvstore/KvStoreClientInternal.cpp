@@ -7,6 +7,8 @@
 
 #include "KvStoreClientInternal.h"
 
+#include <algorithm>
+
 #include <openr/common/OpenrClient.h>
 #include <openr/common/Util.h>
 
@@ -15,15 +17,43 @@
 
 namespace openr {
 
+namespace {
+
+bool
+hasCompressedValues(thrift::KeyVals const& keyVals) {
+  return std::any_of(keyVals.begin(), keyVals.end(), [](auto const& kv) {
+    return kv.second.compressed_ref().value_or(false);
+  });
+}
+
+// clients work with uncompressed values only, drop ones failing to decompress
+void
+decompressValues(thrift::KeyVals& keyVals) {
+  for (auto it = keyVals.begin(); it != keyVals.end();) {
+    try {
+      decompressValue(it->second);
+      ++it;
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Failed to decompress value of key " << it->first
+                 << ". Exception: " << ex.what();
+      it = keyVals.erase(it);
+    }
+  }
+}
+
+} // namespace
+
 KvStoreClientInternal::KvStoreClientInternal(
     OpenrEventBase* eventBase,
     std::string const& nodeId,
     KvStore* kvStore,
-    std::optional<std::chrono::milliseconds> checkPersistKeyPeriod)
+    std::optional<std::chrono::milliseconds> checkPersistKeyPeriod,
+    std::chrono::milliseconds ttlUpdateCoalesceWindow)
     : nodeId_(nodeId),
       eventBase_(eventBase),
       kvStore_(kvStore),
-      checkPersistKeyPeriod_(checkPersistKeyPeriod) {
+      checkPersistKeyPeriod_(checkPersistKeyPeriod),
+      ttlUpdateCoalesceWindow_(ttlUpdateCoalesceWindow) {
   // sanity check
   CHECK_NE(eventBase_, static_cast<void*>(nullptr));
   CHECK(!nodeId.empty());
@@ -42,7 +72,7 @@ KvStoreClientInternal::KvStoreClientInternal(
         LOG(INFO) << "Terminating KvStore updates processing fiber";
         break;
       }
-      processPublication(maybePublication.value());
+      processPublication(*maybePublication.value());
     }
   });
 
@@ -76,7 +106,7 @@ void
 KvStoreClientInternal::initTimers() {
   // Create timer to advertise pending key-vals
   advertiseKeyValsTimer_ =
-      folly::AsyncTimeout::make(*eventBase_->getEvb(), [this]() noexcept {
+      WheelTimeout::make(eventBase_->getWheelTimer(), [this]() noexcept {
         VLOG(3) << "Received timeout event.";
 
         // Advertise all pending keys
@@ -93,34 +123,31 @@ KvStoreClientInternal::initTimers() {
       });
 
   // Create ttl timer
-  ttlTimer_ = folly::AsyncTimeout::make(
-      *eventBase_->getEvb(), [this]() noexcept { advertiseTtlUpdates(); });
+  ttlTimer_ = WheelTimeout::make(
+      eventBase_->getCoarseWheelTimer(),
+      [this]() noexcept { advertiseTtlUpdates(); });
 
   // Create check persistKey timer
   if (checkPersistKeyPeriod_.has_value()) {
-    checkPersistKeyTimer_ = folly::AsyncTimeout::make(
-        *eventBase_->getEvb(), [this]() noexcept { checkPersistKeyInStore(); });
-    checkPersistKeyTimer_->scheduleTimeout(checkPersistKeyPeriod_.value());
+    checkPersistKeyTimer_ = WheelTimeout::make(
+        eventBase_->getCoarseWheelTimer(),
+        [this]() noexcept { checkPersistKeyInStore(); });
   }
 }
 
 void
 KvStoreClientInternal::checkPersistKeyInStore() {
-  std::chrono::milliseconds timeout{checkPersistKeyPeriod_.value()};
-
-  // go through persisted keys map for each area
-  for (const auto& persistKeyValsEntry : persistedKeyVals_) {
-    const auto& area = persistKeyValsEntry.first;
-    auto& persistedKeyVals = persistKeyValsEntry.second;
-
-    if (persistedKeyVals.empty()) {
+  // go through keys pending verification for each area
+  for (auto& [area, persistedKeyVals] : persistedKeyVals_) {
+    auto const& keysToVerify = keysToVerify_[area];
+    if (keysToVerify.empty()) {
       continue;
     }
 
     thrift::KeyGetParams params;
     thrift::Publication pub;
-    for (auto const& key : persistedKeyVals) {
-      params.keys_ref()->emplace_back(key.first);
+    for (auto const& key : keysToVerify) {
+      params.keys_ref()->emplace_back(key);
     }
 
     // Get KvStore response
@@ -129,18 +156,14 @@ KvStoreClientInternal::checkPersistKeyInStore() {
     } catch (const std::exception& ex) {
       LOG(ERROR) << "Failed to get keyvals from kvstore. Exception: "
                  << ex.what();
-      // retry in 1 sec
-      timeout = 1000ms;
-      checkPersistKeyTimer_->scheduleTimeout(1000ms);
       continue;
     }
 
     // Find expired keys from latest KvStore
     std::unordered_map<std::string, thrift::Value> keyVals;
-    for (auto const& key : persistedKeyVals) {
-      auto rxkey = pub.keyVals_ref()->find(key.first);
-      if (rxkey == pub.keyVals_ref()->end()) {
-        keyVals.emplace(key.first, persistedKeyVals.at(key.first));
+    for (auto const& key : keysToVerify) {
+      if (not pub.keyVals_ref()->count(key)) {
+        keyVals.emplace(key, persistedKeyVals.at(key));
       }
     }
 
@@ -151,11 +174,24 @@ KvStoreClientInternal::checkPersistKeyInStore() {
         LOG(ERROR) << "Error sending SET_KEY request to KvStore.";
       }
     }
+    // verifies keys present in KvStore with our value
     processPublication(pub);
   }
 
-  timeout = std::min(timeout, checkPersistKeyPeriod_.value());
-  checkPersistKeyTimer_->scheduleTimeout(timeout);
+  scheduleCheckPersistKey();
+}
+
+void
+KvStoreClientInternal::scheduleCheckPersistKey() {
+  if (not checkPersistKeyTimer_ or checkPersistKeyTimer_->isScheduled()) {
+    return;
+  }
+  for (auto const& [_, keysToVerify] : keysToVerify_) {
+    if (not keysToVerify.empty()) {
+      checkPersistKeyTimer_->scheduleTimeout(checkPersistKeyPeriod_.value());
+      return;
+    }
+  }
 }
 
 bool
@@ -215,11 +251,13 @@ KvStoreClientInternal::persistKey(
     valueChange = true;
   } else if (
       *thriftValue.originatorId_ref() != nodeId_ ||
-      *thriftValue.value_ref() != value) {
+      *thriftValue.value_ref() != value ||
+      thriftValue.tombstone_ref().value_or(false)) {
     (*thriftValue.version_ref())++;
     thriftValue.ttlVersion_ref() = 0;
     thriftValue.value_ref() = value;
     *thriftValue.originatorId_ref() = nodeId_;
+    thriftValue.tombstone_ref().reset();
     valueChange = true;
   }
 
@@ -254,6 +292,7 @@ KvStoreClientInternal::persistKey(
       *thriftValue.version_ref(),
       *thriftValue.ttlVersion_ref(),
       ttl.count(),
+      nodeId_,
       hasTtlChanged,
       area);
 
@@ -309,6 +348,7 @@ KvStoreClientInternal::setKey(
       *thriftValue.version_ref(),
       *thriftValue.ttlVersion_ref(),
       ttl.count(),
+      nodeId_,
       false /* advertiseImmediately */,
       area);
 
@@ -320,23 +360,30 @@ KvStoreClientInternal::setKey(
     std::string const& key,
     thrift::Value const& thriftValue,
     std::string const& area /* thrift::KvStore_constants::kDefaultArea() */) {
-  CHECK(eventBase_->getEvb()->isInEventBaseThread());
-  CHECK(thriftValue.value_ref());
-
   std::unordered_map<std::string, thrift::Value> keyVals;
   keyVals.emplace(key, thriftValue);
+  return setKeys(std::move(keyVals), area);
+}
 
-  const auto ret = setKeysHelper(std::move(keyVals), area);
+std::optional<folly::Unit>
+KvStoreClientInternal::setKeys(
+    std::unordered_map<std::string, thrift::Value> keyVals,
+    std::string const& area /* thrift::KvStore_constants::kDefaultArea() */) {
+  CHECK(eventBase_->getEvb()->isInEventBaseThread());
 
-  scheduleTtlUpdates(
-      key,
-      *thriftValue.version_ref(),
-      *thriftValue.ttlVersion_ref(),
-      *thriftValue.ttl_ref(),
-      false /* advertiseImmediately */,
-      area);
+  for (auto const& [key, thriftValue] : keyVals) {
+    CHECK(thriftValue.value_ref());
+    scheduleTtlUpdates(
+        key,
+        *thriftValue.version_ref(),
+        *thriftValue.ttlVersion_ref(),
+        *thriftValue.ttl_ref(),
+        *thriftValue.originatorId_ref(),
+        false /* advertiseImmediately */,
+        area);
+  }
 
-  return ret;
+  return setKeysHelper(std::move(keyVals), area);
 }
 
 void
@@ -345,6 +392,7 @@ KvStoreClientInternal::scheduleTtlUpdates(
     uint32_t version,
     uint32_t ttlVersion,
     int64_t ttl,
+    std::string const& originatorId,
     bool advertiseImmediately,
     std::string const& area /* thrift::KvStore_constants::kDefaultArea() */) {
   // infinite TTL does not need update
@@ -359,7 +407,7 @@ KvStoreClientInternal::scheduleTtlUpdates(
   // do not send value to reduce update overhead
   thrift::Value ttlThriftValue = createThriftValue(
       version,
-      nodeId_,
+      originatorId,
       std::string("") /* value */,
       ttl,
       ttlVersion /* ttl version */,
@@ -397,6 +445,7 @@ KvStoreClientInternal::unsetKey(
   backoffs_.erase(key);
   keyTtlBackoffs_[area].erase(key);
   keysToAdvertise_[area].erase(key);
+  keysToVerify_[area].erase(key);
 }
 
 void
@@ -425,6 +474,7 @@ KvStoreClientInternal::clearKey(
   thriftValue.ttl_ref() = ttl.count();
   thriftValue.ttlVersion_ref() = 0;
   thriftValue.value_ref() = std::move(keyValue);
+  thriftValue.tombstone_ref() = true;
 
   std::unordered_map<std::string, thrift::Value> keyVals;
   keyVals.emplace(key, std::move(thriftValue));
@@ -456,6 +506,7 @@ KvStoreClientInternal::getKey(
     return std::nullopt;
   }
   VLOG(3) << "Received " << pub.keyVals_ref()->size() << " key-vals.";
+  decompressValues(*pub.keyVals_ref());
 
   auto it = pub.keyVals_ref()->find(key);
   if (it == pub.keyVals_ref()->end()) {
@@ -484,6 +535,7 @@ KvStoreClientInternal::dumpAllWithPrefix(
     LOG(ERROR) << "Failed to add peers to kvstore. Exception: " << ex.what();
     return std::nullopt;
   }
+  decompressValues(*pub.keyVals_ref());
   return *pub.keyVals_ref();
 }
 
@@ -527,6 +579,26 @@ KvStoreClientInternal::unsubscribeKeyFilter() {
   return;
 }
 
+int64_t
+KvStoreClientInternal::subscribeKeyPrefix(
+    std::string const& prefix,
+    KeyCallback callback,
+    std::string const& area /* thrift::KvStore_constants::kDefaultArea() */) {
+  CHECK(eventBase_->getEvb()->isInEventBaseThread());
+
+  const auto subscriptionId = nextKeyPrefixSubscriptionId_++;
+  keyPrefixCallbacks_.emplace(
+      subscriptionId, KeyPrefixSubscription{prefix, area, std::move(callback)});
+  return subscriptionId;
+}
+
+void
+KvStoreClientInternal::unsubscribeKeyPrefix(int64_t subscriptionId) {
+  CHECK(eventBase_->getEvb()->isInEventBaseThread());
+
+  keyPrefixCallbacks_.erase(subscriptionId);
+}
+
 void
 KvStoreClientInternal::unsubscribeKey(std::string const& key) {
   CHECK(eventBase_->getEvb()->isInEventBaseThread());
@@ -549,8 +621,15 @@ void
 KvStoreClientInternal::processExpiredKeys(
     thrift::Publication const& publication) {
   auto const& expiredKeys = *publication.expiredKeys_ref();
+  auto const& area = *publication.area_ref();
+  auto const& persistedKeyVals = persistedKeyVals_[area];
+  auto& keysToAdvertise = keysToAdvertise_[area];
 
   for (auto const& key : expiredKeys) {
+    // persisted keys are advertised back right away
+    if (persistedKeyVals.count(key)) {
+      keysToAdvertise.insert(key);
+    }
     /* callback registered by the thread */
     if (kvCallback_) {
       kvCallback_(key, std::nullopt);
@@ -560,12 +639,26 @@ KvStoreClientInternal::processExpiredKeys(
     if (cb != keyCallbacks_.end()) {
       (cb->second)(key, std::nullopt);
     }
+    /* key prefix registered callbacks */
+    for (auto& [_, subscription] : keyPrefixCallbacks_) {
+      if (subscription.area == *publication.area_ref() and
+          folly::StringPiece(key).startsWith(subscription.prefix)) {
+        subscription.callback(key, std::nullopt);
+      }
+    }
   }
 }
 
 void
 KvStoreClientInternal::processPublication(
     thrift::Publication const& publication) {
+  if (hasCompressedValues(*publication.keyVals_ref())) {
+    auto decompressed = publication;
+    decompressValues(*decompressed.keyVals_ref());
+    processPublication(decompressed);
+    return;
+  }
+
   // Go through received key-values and find out the ones which need update
   CHECK(not publication.area_ref()->empty());
   const auto& area = *publication.area_ref();
@@ -573,6 +666,7 @@ KvStoreClientInternal::processPublication(
   auto& persistedKeyVals = persistedKeyVals_[area];
   auto& keyTtlBackoffs = keyTtlBackoffs_[area];
   auto& keysToAdvertise = keysToAdvertise_[area];
+  auto& keysToVerify = keysToVerify_[area];
 
   for (auto const& kv : *publication.keyVals_ref()) {
     auto const& key = kv.first;
@@ -587,6 +681,13 @@ KvStoreClientInternal::processPublication(
       kvCallback_(key, rcvdValue);
     }
 
+    for (auto& [_, subscription] : keyPrefixCallbacks_) {
+      if (subscription.area == area and
+          folly::StringPiece(key).startsWith(subscription.prefix)) {
+        subscription.callback(key, rcvdValue);
+      }
+    }
+
     // Update local keyVals as per need
     auto it = persistedKeyVals.find(key);
     auto cb = keyCallbacks_.find(key);
@@ -693,14 +794,17 @@ KvStoreClientInternal::processPublication(
 
     if (valueChange) {
       keysToAdvertise.insert(key);
+    } else {
+      // our advertisement is in KvStore
+      keysToVerify.erase(key);
     }
   } // for
 
-  advertisePendingKeys();
-
   if (publication.expiredKeys_ref()->size()) {
     processExpiredKeys(publication);
   }
+
+  advertisePendingKeys();
 }
 
 void
@@ -757,14 +861,18 @@ KvStoreClientInternal::advertisePendingKeys() {
     // Advertise to KvStore
     const auto ret = setKeysHelper(std::move(keyVals), area);
     if (ret.has_value()) {
+      auto& keysToVerify = keysToVerify_[area];
       for (auto const& key : keys) {
         keysToAdvertise.erase(key);
+        keysToVerify.insert(key);
       }
     } else {
       LOG(ERROR) << "Error sending SET_KEY request to KvStore.";
     }
   }
 
+  scheduleCheckPersistKey();
+
   // Schedule next-timeout for processing/clearing backoffs
   VLOG(2) << "Scheduling timer after " << timeout.count() << "ms.";
   advertiseKeyValsTimer_->scheduleTimeout(timeout);
@@ -786,9 +894,19 @@ KvStoreClientInternal::advertiseTtlUpdates() {
     for (auto& kv : keyTtlBackoffs) {
       const auto& key = kv.first;
       auto& backoff = kv.second.second;
-      if (not backoff.canTryNow()) {
+      auto& thriftValue = kv.second.first;
+
+      // Advertise ttl updates due soon along with the ones due now, rather
+      // than in a publication of their own. Updates are refreshed every
+      // ttl / 4, never advance them by more than a quarter of that to not
+      // refresh short ttls back to back
+      auto const coalesceWindow = std::min(
+          ttlUpdateCoalesceWindow_,
+          std::chrono::milliseconds(*thriftValue.ttl_ref() / 16));
+      auto const timeRemaining = backoff.getTimeRemainingUntilRetry();
+      if (timeRemaining > coalesceWindow) {
         VLOG(2) << "Skipping key: " << key << ", area: " << area;
-        timeout = std::min(timeout, backoff.getTimeRemainingUntilRetry());
+        timeout = std::min(timeout, timeRemaining);
         continue;
       }
 
@@ -796,7 +914,6 @@ KvStoreClientInternal::advertiseTtlUpdates() {
       backoff.reportError();
       timeout = std::min(timeout, backoff.getTimeRemainingUntilRetry());
 
-      auto& thriftValue = kv.second.first;
       const auto it = persistedKeyVals.find(key);
       if (it != persistedKeyVals.end()) {
         // we may have got a newer vesion for persisted key
@@ -861,11 +978,16 @@ KvStoreClientInternal::setKeysHelper(
     }
   }
 
-  thrift::KeySetParams params;
-  *params.keyVals_ref() = std::move(keyVals);
+  auto sf = kvStore_->setLocalKvStoreKeyVals(std::move(keyVals), area);
+
+  // KvStore batches sets of all local clients, don't hold up this event base
+  // until the batch is merged. Sets of invalid areas are only logged by it
+  if (kvStore_->getLocalSetBatchWindow().has_value()) {
+    return folly::Unit();
+  }
 
   try {
-    kvStore_->setKvStoreKeyVals(params, area).get();
+    std::move(sf).get();
   } catch (const std::exception& ex) {
     LOG(ERROR) << "Failed to set key-val from KvStore. Exception: "
                << ex.what();
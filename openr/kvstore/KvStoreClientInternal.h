@@ -19,6 +19,7 @@
 #include <openr/common/ExponentialBackoff.h>
 #include <openr/common/OpenrClient.h>
 #include <openr/common/OpenrEventBase.h>
+#include <openr/common/WheelTimeout.h>
 #include <openr/if/gen-cpp2/KvStore_constants.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
 #include <openr/kvstore/KvStore.h>
@@ -46,12 +47,17 @@ class KvStoreClientInternal {
   /**
    * Creates and initializes all necessary sockets for communicating with
    * KvStore.
+   *
+   * TTL updates of keys falling due within `ttlUpdateCoalesceWindow` of each
+   * other are advertised together in a single publication per area.
    */
   KvStoreClientInternal(
       OpenrEventBase* eventBase,
       std::string const& nodeId,
       KvStore* kvStore,
-      std::optional<std::chrono::milliseconds> checkPersistKeyPeriod = 60000ms);
+      std::optional<std::chrono::milliseconds> checkPersistKeyPeriod = 60000ms,
+      std::chrono::milliseconds ttlUpdateCoalesceWindow =
+          Constants::kTtlUpdateCoalesceWindow);
 
   ~KvStoreClientInternal();
 
@@ -98,6 +104,14 @@ class KvStoreClientInternal {
       thrift::Value const& value,
       std::string const& area = thrift::KvStore_constants::kDefaultArea());
 
+  /**
+   * Forward several key-values to KvStore in a single publication, TTLs are
+   * updated as for setKey. Values may have originators other than this node.
+   */
+  std::optional<folly::Unit> setKeys(
+      std::unordered_map<std::string, thrift::Value> keyVals,
+      std::string const& area = thrift::KvStore_constants::kDefaultArea());
+
   /**
    * Unset key from KvStore. It really doesn't delete the key from KvStore,
    * instead it just leave it as it is.
@@ -108,7 +122,8 @@ class KvStoreClientInternal {
 
   /**
    * Clear key's value by seeting default value of empty string or value passed
-   * by the caller, cancel ttl timers, advertise with higher version.
+   * by the caller, cancel ttl timers, advertise with higher version. The value
+   * is marked as tombstone, see thrift::Value.
    */
   void clearKey(
       std::string const& key,
@@ -155,6 +170,18 @@ class KvStoreClientInternal {
   void subscribeKeyFilter(KvStoreFilters kvFilters, KeyCallback callback);
   void unsubscribeKeyFilter();
 
+  /**
+   * APIs to subscribe/unsubscribe to value changes and expiry of all keys
+   * with given prefix in area. Unlike key filter, any number of prefixes can
+   * be subscribed to at once.
+   * @return - id of subscription to unsubscribe with
+   */
+  int64_t subscribeKeyPrefix(
+      std::string const& prefix,
+      KeyCallback callback,
+      std::string const& area = thrift::KvStore_constants::kDefaultArea());
+  void unsubscribeKeyPrefix(int64_t subscriptionId);
+
   OpenrEventBase*
   getOpenrEventBase() const noexcept {
     return eventBase_;
@@ -216,6 +243,7 @@ class KvStoreClientInternal {
       uint32_t version,
       uint32_t ttlVersion,
       int64_t ttl,
+      std::string const& originatorId,
       bool advertiseImmediately,
       std::string const& area = thrift::KvStore_constants::kDefaultArea());
 
@@ -224,8 +252,18 @@ class KvStoreClientInternal {
    */
   void advertiseTtlUpdates();
 
+  /**
+   * Fallback for persisted keys whose advertisement was not seen back in a
+   * publication within `checkPersistKeyPeriod_`. Reads just those keys from
+   * KvStore and re-advertises the ones missing.
+   */
   void checkPersistKeyInStore();
 
+  /**
+   * Schedule checkPersistKeyInStore() if there are keys pending verification
+   */
+  void scheduleCheckPersistKey();
+
   /*
    * Wrapper function to initialize timer
    */
@@ -245,11 +283,15 @@ class KvStoreClientInternal {
   // Pointers to KvStore module
   KvStore* kvStore_{nullptr};
 
-  // periodic timer to check existence of persist key in kv store
+  // period after which advertised persist keys not yet seen in a publication
+  // are looked up in kv store
   std::optional<std::chrono::milliseconds> checkPersistKeyPeriod_{std::nullopt};
 
-  // check persiste key timer event
-  std::unique_ptr<folly::AsyncTimeout> checkPersistKeyTimer_;
+  // ttl updates due within this window are advertised ahead of time
+  const std::chrono::milliseconds ttlUpdateCoalesceWindow_;
+
+  // check persiste key timer event, on coarse timer wheel
+  std::unique_ptr<WheelTimeout> checkPersistKeyTimer_;
 
   //
   // Mutable state
@@ -270,6 +312,16 @@ class KvStoreClientInternal {
   // callback for updates from keys filtered with provided filter
   KeyCallback keyPrefixFilterCallback_{nullptr};
 
+  // Subscribed key prefixes to their callback functions
+  struct KeyPrefixSubscription {
+    std::string prefix;
+    std::string area;
+    KeyCallback callback;
+  };
+  std::unordered_map<int64_t /* id */, KeyPrefixSubscription>
+      keyPrefixCallbacks_;
+  int64_t nextKeyPrefixSubscriptionId_{0};
+
   // backoff associated with each key for re-advertisements
   std::unordered_map<
       std::string /* key */,
@@ -292,11 +344,17 @@ class KvStoreClientInternal {
       std::unordered_set<std::string /* key */>>
       keysToAdvertise_;
 
+  // Set of advertised persisted keys not yet seen back in a publication
+  std::unordered_map<
+      std::string /* area */,
+      std::unordered_set<std::string /* key */>>
+      keysToVerify_;
+
   // Timer to advertised pending key-vals
-  std::unique_ptr<folly::AsyncTimeout> advertiseKeyValsTimer_;
+  std::unique_ptr<WheelTimeout> advertiseKeyValsTimer_;
 
-  // Timer to advertise ttl updates for key-vals
-  std::unique_ptr<folly::AsyncTimeout> ttlTimer_;
+  // Timer to advertise ttl updates for key-vals, on coarse timer wheel
+  std::unique_ptr<WheelTimeout> ttlTimer_;
 
   // prefix key filter to apply for key updates
   KvStoreFilters keyPrefixFilter_{{}, {}};
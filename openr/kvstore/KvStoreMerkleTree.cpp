@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/kvstore/KvStoreMerkleTree.h>
+
+#include <boost/functional/hash.hpp>
+#include <glog/logging.h>
+
+namespace openr {
+
+KvStoreMerkleTree::KvStoreMerkleTree()
+    : digests_(kNumNodes, 0), numKeys_(kNumNodes, 0), leaves_(kNumLeaves) {}
+
+void
+KvStoreMerkleTree::set(std::string const& key, thrift::Value const& value) {
+  auto const leaf = getLeaf(key);
+  auto const digest = getEntryDigest(key, value);
+  auto& entries = leaves_.at(leaf - kFirstLeaf);
+  auto [it, inserted] = entries.emplace(key, digest);
+  if (inserted) {
+    updatePath(leaf, digest, 1);
+  } else if (it->second != digest) {
+    updatePath(leaf, digest - it->second, 0);
+    it->second = digest;
+  }
+}
+
+void
+KvStoreMerkleTree::erase(std::string const& key) {
+  auto const leaf = getLeaf(key);
+  auto& entries = leaves_.at(leaf - kFirstLeaf);
+  auto it = entries.find(key);
+  if (it == entries.end()) {
+    return;
+  }
+  updatePath(leaf, -it->second, -1);
+  entries.erase(it);
+}
+
+void
+KvStoreMerkleTree::clear() {
+  std::fill(digests_.begin(), digests_.end(), 0);
+  std::fill(numKeys_.begin(), numKeys_.end(), 0);
+  for (auto& entries : leaves_) {
+    entries.clear();
+  }
+}
+
+void
+KvStoreMerkleTree::forEachKey(
+    int32_t node, std::function<void(std::string const&)> const& fn) const {
+  CHECK(isValidNode(node)) << "Invalid node " << node;
+  if (not numKeys_.at(node)) {
+    return;
+  }
+  if (isLeaf(node)) {
+    for (auto const& [key, _] : leaves_.at(node - kFirstLeaf)) {
+      fn(key);
+    }
+    return;
+  }
+  for (auto const child : getChildren(node)) {
+    forEachKey(child, fn);
+  }
+}
+
+std::vector<int32_t>
+KvStoreMerkleTree::getChildren(int32_t node) {
+  CHECK(isValidNode(node)) << "Invalid node " << node;
+  std::vector<int32_t> children;
+  if (isLeaf(node)) {
+    return children;
+  }
+  children.reserve(kFanout);
+  for (int32_t i = 1; i <= kFanout; ++i) {
+    children.emplace_back(kFanout * node + i);
+  }
+  return children;
+}
+
+int32_t
+KvStoreMerkleTree::getLeaf(std::string const& key) {
+  // spread keys independent of their naming, i.e. common key prefixes
+  return kFirstLeaf + boost::hash<std::string>()(key) % kNumLeaves;
+}
+
+uint64_t
+KvStoreMerkleTree::getEntryDigest(
+    std::string const& key, thrift::Value const& value) {
+  size_t seed = 0;
+  boost::hash_combine(seed, key);
+  boost::hash_combine(seed, *value.version_ref());
+  boost::hash_combine(seed, *value.originatorId_ref());
+  boost::hash_combine(seed, value.hash_ref().value_or(0));
+  boost::hash_combine(seed, *value.ttlVersion_ref());
+  return seed;
+}
+
+void
+KvStoreMerkleTree::updatePath(
+    int32_t leaf, uint64_t digestDelta, int64_t numKeysDelta) {
+  for (auto node = leaf;; node = (node - 1) / kFanout) {
+    digests_.at(node) += digestDelta;
+    numKeys_.at(node) += numKeysDelta;
+    if (node == kRoot) {
+      break;
+    }
+  }
+}
+
+} // namespace openr
@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <openr/if/gen-cpp2/KvStore_types.h>
+
+namespace openr {
+
+namespace detail {
+constexpr int32_t
+constexprPow(int32_t base, int32_t exp) {
+  return exp == 0 ? 1 : base * constexprPow(base, exp - 1);
+}
+} // namespace detail
+
+/**
+ * Hierarchical summary of the key-values of a KvStoreDb used for full-sync
+ * between peers. Keys are spread across kNumLeaves leaves by the hash of the
+ * key. Every node of the tree holds a digest of all key-values under it and
+ * has kFanout children, down to the leaves.
+ *
+ * Two stores holding the same key-values have the same digests. Peers
+ * compare digests level by level and only descend into subtrees whose digests
+ * differ, eventually exchanging key hashes of mismatching subtrees only.
+ *
+ * Nodes are identified level by level starting with the root as 0, i.e. the
+ * children of node n are kFanout * n + 1 ... kFanout * n + kFanout. Digests
+ * ignore the TTL as it counts down independently on every store, but cover
+ * the TTL version.
+ */
+class KvStoreMerkleTree {
+ public:
+  static constexpr int32_t kFanout{16};
+  static constexpr int32_t kDepth{3};
+  static constexpr int32_t kRoot{0};
+
+  KvStoreMerkleTree();
+
+  // add or update key with value
+  void set(std::string const& key, thrift::Value const& value);
+
+  // remove key, no-op if it is not there
+  void erase(std::string const& key);
+
+  void clear();
+
+  // digest of all key-values under node
+  int64_t
+  getDigest(int32_t node) const {
+    return static_cast<int64_t>(digests_.at(node));
+  }
+
+  // number of keys under node
+  size_t
+  getNumKeys(int32_t node) const {
+    return numKeys_.at(node);
+  }
+
+  // visit all keys under given node
+  void forEachKey(
+      int32_t node, std::function<void(std::string const&)> const& fn) const;
+
+  static bool
+  isValidNode(int32_t node) {
+    return node >= 0 and node < kNumNodes;
+  }
+
+  static bool
+  isLeaf(int32_t node) {
+    return node >= kFirstLeaf and node < kNumNodes;
+  }
+
+  static std::vector<int32_t> getChildren(int32_t node);
+
+  // leaf a key belongs to
+  static int32_t getLeaf(std::string const& key);
+
+ private:
+  // digest of a single key-value
+  static uint64_t getEntryDigest(
+      std::string const& key, thrift::Value const& value);
+
+  static constexpr int32_t kNumLeaves{
+      detail::constexprPow(kFanout, kDepth)};
+  // 1 + kFanout + ... + kFanout^(kDepth - 1) inner nodes
+  static constexpr int32_t kFirstLeaf{(kNumLeaves - 1) / (kFanout - 1)};
+  static constexpr int32_t kNumNodes{kFirstLeaf + kNumLeaves};
+
+  // add delta to digests and numKeys on the path from leaf to the root
+  void updatePath(int32_t leaf, uint64_t digestDelta, int64_t numKeysDelta);
+
+  // digests and number of keys per node, digests sum up (with wrap-around)
+  // entry digests which makes updates independent of their order
+  std::vector<uint64_t> digests_;
+  std::vector<size_t> numKeys_;
+
+  // entry digest of every key, per leaf
+  std::vector<std::unordered_map<std::string, uint64_t>> leaves_;
+};
+
+} // namespace openr
@@ -7,6 +7,8 @@
 
 #include <openr/kvstore/KvStorePublisher.h>
 
+#include <unordered_set>
+
 #include <re2/re2.h>
 
 #include <folly/ExceptionString.h>
@@ -16,14 +18,18 @@
 #include <openr/common/Util.h>
 #include <openr/if/gen-cpp2/PersistentStore_types.h>
 #include <openr/kvstore/KvStore.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 
 namespace openr {
 
 KvStorePublisher::KvStorePublisher(
     thrift::KeyDumpParams filter,
-    apache::thrift::ServerStreamPublisher<thrift::Publication>&& publisher)
-    : filter_(filter), publisher_(std::move(publisher)) {
+    std::shared_ptr<StreamSubscriber<thrift::Publication>> subscriber)
+    : filter_(filter),
+      filterKey_(
+          apache::thrift::CompactSerializer::serialize<std::string>(filter)),
+      subscriber_(std::move(subscriber)) {
   std::vector<std::string> keyPrefix;
 
   if (filter.keys_ref().has_value()) {
@@ -52,6 +58,52 @@ KvStorePublisher::KvStorePublisher(
  */
 void
 KvStorePublisher::publish(const thrift::Publication& pub) {
+  auto maybePub = filter(pub);
+  if (maybePub.has_value()) {
+    publishFiltered(std::move(*maybePub));
+  }
+}
+
+void
+KvStorePublisher::publishFiltered(thrift::Publication&& pub) {
+  subscriber_->publish(std::move(pub));
+}
+
+bool
+KvStorePublisher::mergePublications(
+    thrift::Publication& publication, thrift::Publication& laterPublication) {
+  if (*publication.area_ref() != *laterPublication.area_ref()) {
+    return false;
+  }
+
+  auto& keyVals = *publication.keyVals_ref();
+  std::unordered_set<std::string> expiredKeys(
+      publication.expiredKeys_ref()->begin(),
+      publication.expiredKeys_ref()->end());
+  for (auto& key : *laterPublication.expiredKeys_ref()) {
+    keyVals.erase(key);
+    expiredKeys.emplace(std::move(key));
+  }
+  for (auto& kv : *laterPublication.keyVals_ref()) {
+    expiredKeys.erase(kv.first);
+    auto it = keyVals.find(kv.first);
+    auto& val = kv.second;
+    if (it != keyVals.end() and not val.value_ref().has_value() and
+        *it->second.version_ref() == *val.version_ref() and
+        *it->second.originatorId_ref() == *val.originatorId_ref()) {
+      // TTL update of pending value, keep the value
+      *it->second.ttl_ref() = *val.ttl_ref();
+      *it->second.ttlVersion_ref() = *val.ttlVersion_ref();
+      continue;
+    }
+    keyVals.insert_or_assign(kv.first, std::move(val));
+  }
+  *publication.expiredKeys_ref() = {expiredKeys.begin(), expiredKeys.end()};
+  return true;
+}
+
+std::optional<thrift::Publication>
+KvStorePublisher::filter(const thrift::Publication& pub) const {
   if ((not filter_.keys_ref().has_value() or (*filter_.keys_ref()).empty()) and
       (not filter_.originatorIds_ref().has_value() or
        (*filter_.originatorIds_ref()).empty()) and
@@ -59,9 +111,7 @@ KvStorePublisher::publish(const thrift::Publication& pub) {
     // No filtering criteria. Accept all updates as TTL updates are not be
     // to be updated. If we don't optimize here, we will have go through
     // key values of a publication and copy them.
-    auto filteredPub = std::make_unique<thrift::Publication>(pub);
-    publisher_.next(std::move(*filteredPub));
-    return;
+    return pub;
   }
 
   thrift::Publication publication_filtered;
@@ -113,8 +163,9 @@ KvStorePublisher::publish(const thrift::Publication& pub) {
 
   if (keyvals.size()) {
     // There is at least one key value in the publication for the client
-    publication_filtered.keyVals_ref() = keyvals;
-    publisher_.next(std::move(publication_filtered));
+    publication_filtered.keyVals_ref() = std::move(keyvals);
+    return publication_filtered;
   }
+  return std::nullopt;
 }
 } // namespace openr
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <fbzmq/zmq/Zmq.h>
+#include <openr/common/StreamSubscriber.h>
 #include <openr/common/Types.h>
 #include <openr/config/Config.h>
 #include <openr/if/gen-cpp2/KvStore_constants.h>
@@ -20,22 +21,48 @@ class KvStorePublisher {
  public:
   KvStorePublisher(
       thrift::KeyDumpParams filter,
-      apache::thrift::ServerStreamPublisher<thrift::Publication>&& publisher);
+      std::shared_ptr<StreamSubscriber<thrift::Publication>> subscriber);
 
   ~KvStorePublisher() {}
 
   // Invoked whenever there is change. Apply filter and publish changes
   void publish(const thrift::Publication& pub);
 
-  template <class... Args>
+  /**
+   * Apply filter to publication. Returns std::nullopt if nothing in it is of
+   * interest to the client. Publishers with the same getFilterKey() produce
+   * the same result, so it can be computed once and shared among them.
+   */
+  std::optional<thrift::Publication> filter(
+      const thrift::Publication& pub) const;
+
+  // Publish an already filtered publication to the client
+  void publishFiltered(thrift::Publication&& pub);
+
+  // Identifies the filter, i.e. same for all publishers with equal filter
+  const std::string&
+  getFilterKey() const {
+    return filterKey_;
+  }
+
+  // Complete the stream. Publications afterwards are dropped.
   void
-  complete(Args&&... args) {
-    std::move(publisher_).complete(std::forward<Args>(args)...);
+  complete(folly::exception_wrapper error = {}) {
+    subscriber_->complete(std::move(error));
   }
 
+  /**
+   * Merge later publication of the same area into publication, as
+   * StreamBuffer::MergeFn for coalescing publications pending for a slow
+   * client. Returns false if areas differ.
+   */
+  static bool mergePublications(
+      thrift::Publication& publication, thrift::Publication& laterPublication);
+
  private:
   thrift::KeyDumpParams filter_;
+  std::string filterKey_;
   KvStoreFilters keyPrefixFilter_{{}, {}};
-  apache::thrift::ServerStreamPublisher<thrift::Publication> publisher_;
+  std::shared_ptr<StreamSubscriber<thrift::Publication>> subscriber_;
 };
 } // namespace openr
@@ -0,0 +1,216 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/kvstore/KvStoreSnapshot.h>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+
+#include <array>
+#include <cstring>
+
+#include <folly/FileUtil.h>
+#include <folly/lang/Bits.h>
+#include <glog/logging.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include <openr/common/SerializationBuffer.h>
+#include <openr/common/Util.h>
+
+namespace openr {
+
+bool
+writeKvStoreSnapshot(
+    const std::string& filePath, const thrift::KvStoreSnapshot& snapshot) {
+  try {
+    apache::thrift::CompactSerializer serializer;
+    std::string data;
+    serializer.serialize(snapshot, &data);
+    folly::writeFileAtomic(filePath, data, 0644);
+  } catch (std::exception const& e) {
+    LOG(ERROR) << "Failed to write KvStore snapshot to '" << filePath
+               << "'. Error: " << folly::exceptionStr(e);
+    return false;
+  }
+  return true;
+}
+
+std::optional<thrift::KvStoreSnapshot>
+readKvStoreSnapshot(const std::string& filePath, std::chrono::seconds maxAge) {
+  std::string data;
+  if (not folly::readFile(filePath.c_str(), data)) {
+    LOG(INFO) << "No KvStore snapshot found at '" << filePath << "'";
+    return std::nullopt;
+  }
+
+  thrift::KvStoreSnapshot snapshot;
+  try {
+    apache::thrift::CompactSerializer serializer;
+    serializer.deserialize(data, snapshot);
+  } catch (std::exception const& e) {
+    LOG(ERROR) << "Failed to decode KvStore snapshot from '" << filePath
+               << "'. Error: " << folly::exceptionStr(e);
+    return std::nullopt;
+  }
+
+  const auto ageMs = getUnixTimeStampMs() - *snapshot.timestampMs_ref();
+  if (ageMs > std::chrono::milliseconds(maxAge).count()) {
+    LOG(INFO) << "Ignoring KvStore snapshot '" << filePath << "', it is "
+              << ageMs << "ms old";
+    return std::nullopt;
+  }
+  return snapshot;
+}
+
+namespace {
+
+// size prefix of each RecordedPublication in recording file
+using FrameSize = uint32_t;
+
+std::string
+encodeFrameSize(size_t size) {
+  const auto bigEndian = folly::Endian::big(static_cast<FrameSize>(size));
+  return std::string(
+      reinterpret_cast<const char*>(&bigEndian), sizeof(bigEndian));
+}
+
+thrift::RecordedPublication
+createRecordedPublication(
+    int64_t timestampMs, const thrift::Publication& publication) {
+  thrift::RecordedPublication recorded;
+  recorded.timestampMs_ref() = timestampMs;
+  recorded.publication_ref() = publication;
+  return recorded;
+}
+
+void
+appendFrame(std::string& data, const thrift::RecordedPublication& recorded) {
+  const auto frame = serializeToThreadBuffer(recorded);
+  data.append(encodeFrameSize(frame.size()));
+  data.append(frame.data(), frame.size());
+}
+
+} // namespace
+
+bool
+writeKvStoreRecording(
+    const std::string& filePath, const thrift::KvStoreRecording& recording) {
+  try {
+    std::string data;
+    appendFrame(data, createRecordedPublication(0, *recording.dump_ref()));
+    const auto& publications = *recording.publications_ref();
+    const auto& timestampsMs = *recording.timestampsMs_ref();
+    for (size_t i = 0; i < publications.size(); ++i) {
+      appendFrame(
+          data,
+          createRecordedPublication(
+              i < timestampsMs.size() ? timestampsMs.at(i) : 0,
+              publications.at(i)));
+    }
+    folly::writeFileAtomic(filePath, data, 0644);
+  } catch (std::exception const& e) {
+    LOG(ERROR) << "Failed to write KvStore recording to '" << filePath
+               << "'. Error: " << folly::exceptionStr(e);
+    return false;
+  }
+  return true;
+}
+
+std::optional<thrift::KvStoreRecording>
+readKvStoreRecording(const std::string& filePath) {
+  std::string data;
+  if (not folly::readFile(filePath.c_str(), data)) {
+    LOG(ERROR) << "No KvStore recording found at '" << filePath << "'";
+    return std::nullopt;
+  }
+
+  thrift::KvStoreRecording recording;
+  size_t numFrames{0};
+  size_t pos{0};
+  try {
+    while (pos < data.size()) {
+      FrameSize bigEndian{0};
+      if (data.size() - pos < sizeof(bigEndian)) {
+        break;
+      }
+      std::memcpy(&bigEndian, data.data() + pos, sizeof(bigEndian));
+      const size_t size = folly::Endian::big(bigEndian);
+      if (data.size() - pos - sizeof(bigEndian) < size) {
+        break;
+      }
+      pos += sizeof(bigEndian);
+
+      auto recorded = apache::thrift::CompactSerializer::deserialize<
+          thrift::RecordedPublication>(folly::StringPiece(&data[pos], size));
+      pos += size;
+      if (numFrames++ == 0) {
+        recording.dump_ref() = std::move(*recorded.publication_ref());
+        continue;
+      }
+      recording.publications_ref()->emplace_back(
+          std::move(*recorded.publication_ref()));
+      recording.timestampsMs_ref()->emplace_back(*recorded.timestampMs_ref());
+    }
+  } catch (std::exception const& e) {
+    LOG(ERROR) << "Failed to decode KvStore recording from '" << filePath
+               << "'. Error: " << folly::exceptionStr(e);
+    return std::nullopt;
+  }
+
+  if (numFrames == 0) {
+    LOG(ERROR) << "No dump in KvStore recording '" << filePath << "'";
+    return std::nullopt;
+  }
+  if (pos < data.size()) {
+    LOG(WARNING) << "Ignoring incomplete last publication of KvStore "
+                 << "recording '" << filePath << "'";
+  }
+  return recording;
+}
+
+KvStoreRecorder::KvStoreRecorder(const std::string& filePath)
+    : file_(filePath, O_WRONLY | O_CREAT | O_TRUNC) {}
+
+bool
+KvStoreRecorder::writeDump(const thrift::Publication& dump) {
+  dumpTime_ = std::chrono::steady_clock::now();
+  return write(std::chrono::milliseconds(0), dump);
+}
+
+bool
+KvStoreRecorder::writePublication(const thrift::Publication& publication) {
+  return write(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - dumpTime_),
+      publication);
+}
+
+bool
+KvStoreRecorder::write(
+    std::chrono::milliseconds timestamp,
+    const thrift::Publication& publication) {
+  const auto frame = serializeToThreadBuffer(
+      createRecordedPublication(timestamp.count(), publication));
+  const auto size = encodeFrameSize(frame.size());
+
+  // single write for size and frame, so that a reader never sees the size
+  // of a frame without it
+  std::array<iovec, 2> iov;
+  iov[0].iov_base = const_cast<char*>(size.data());
+  iov[0].iov_len = size.size();
+  iov[1].iov_base = const_cast<char*>(frame.data());
+  iov[1].iov_len = frame.size();
+  const auto expected = size.size() + frame.size();
+  if (folly::writevFull(file_.fd(), iov.data(), iov.size()) !=
+      static_cast<ssize_t>(expected)) {
+    PLOG(ERROR) << "Failed to append to KvStore recording";
+    return false;
+  }
+  return true;
+}
+
+} // namespace openr
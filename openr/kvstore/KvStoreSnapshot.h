@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+#include <folly/File.h>
+
+#include <openr/if/gen-cpp2/KvStore_types.h>
+
+namespace openr {
+
+/**
+ * Write snapshot to file, replacing previous one atomically. Returns false on
+ * failure. Doesn't throw exception.
+ */
+bool writeKvStoreSnapshot(
+    const std::string& filePath, const thrift::KvStoreSnapshot& snapshot);
+
+/**
+ * Read snapshot from file. Returns nullopt if file doesn't exist, can't be
+ * decoded or snapshot is older than maxAge.
+ */
+std::optional<thrift::KvStoreSnapshot> readKvStoreSnapshot(
+    const std::string& filePath, std::chrono::seconds maxAge);
+
+/**
+ * Write recording to file, replacing previous one atomically. Returns false
+ * on failure. Doesn't throw exception.
+ */
+bool writeKvStoreRecording(
+    const std::string& filePath, const thrift::KvStoreRecording& recording);
+
+/**
+ * Read recording from file. Returns nullopt if file doesn't exist or can't be
+ * decoded. Incomplete last publication, e.g. of a recorder that got killed,
+ * is ignored.
+ */
+std::optional<thrift::KvStoreRecording> readKvStoreRecording(
+    const std::string& filePath);
+
+/**
+ * Streams recording to file as publications arrive, appending each of them
+ * instead of rewriting the whole recording. Readable with
+ * readKvStoreRecording() at any time.
+ */
+class KvStoreRecorder {
+ public:
+  // Create or truncate file, throws on failure
+  explicit KvStoreRecorder(const std::string& filePath);
+
+  // Append dump, to be called once before any publication. Publications are
+  // timestamped relative to it.
+  bool writeDump(const thrift::Publication& dump);
+
+  // Append publication received now. Returns false on failure.
+  bool writePublication(const thrift::Publication& publication);
+
+ private:
+  bool write(
+      std::chrono::milliseconds timestamp,
+      const thrift::Publication& publication);
+
+  folly::File file_;
+  std::chrono::steady_clock::time_point dumpTime_;
+};
+
+} // namespace openr
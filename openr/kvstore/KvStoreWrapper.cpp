@@ -8,6 +8,7 @@
 #include "KvStoreWrapper.h"
 
 #include <memory>
+#include <thread>
 
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
@@ -26,7 +27,8 @@ KvStoreWrapper::KvStoreWrapper(
     std::shared_ptr<const Config> config,
     std::optional<messaging::RQueue<thrift::PeerUpdateRequest>>
         peerUpdatesQueue,
-    bool enableKvStoreThrift)
+    bool enableKvStoreThrift,
+    int zmqHwm)
     : nodeId(config->getNodeName()),
       globalCmdUrl(folly::sformat("inproc://{}-kvstore-global-cmd", nodeId)),
       enableKvStoreThrift_(enableKvStoreThrift) {
@@ -41,7 +43,7 @@ KvStoreWrapper::KvStoreWrapper(
       KvStoreGlobalCmdUrl{globalCmdUrl},
       config,
       std::nullopt /* ip-tos */,
-      Constants::kHighWaterMark,
+      zmqHwm,
       enableKvStoreThrift_);
 }
 
@@ -178,14 +180,48 @@ KvStoreWrapper::syncKeyVals(
   return *pub.keyVals_ref();
 }
 
+size_t
+KvStoreWrapper::replayRecording(
+    const thrift::KvStoreRecording& recording,
+    double speed,
+    std::string area) {
+  auto setKeyVals = [this, &area](const thrift::KeyVals& keyVals) {
+    if (keyVals.empty()) {
+      return;
+    }
+    thrift::KeySetParams params;
+    params.keyVals_ref() = keyVals;
+    try {
+      kvStore_->setKvStoreKeyVals(std::move(params), area).get();
+    } catch (std::exception const& e) {
+      LOG(ERROR) << "Exception to set key in kvstore: "
+                 << folly::exceptionStr(e);
+    }
+  };
+
+  setKeyVals(*recording.dump_ref()->keyVals_ref());
+  const auto start = std::chrono::steady_clock::now();
+  const auto& publications = *recording.publications_ref();
+  const auto& timestampsMs = *recording.timestampsMs_ref();
+  for (size_t i = 0; i < publications.size(); ++i) {
+    if (speed > 0 and i < timestampsMs.size()) {
+      std::this_thread::sleep_until(
+          start +
+          std::chrono::microseconds(
+              static_cast<int64_t>(timestampsMs.at(i) * 1000 / speed)));
+    }
+    setKeyVals(*publications.at(i).keyVals_ref());
+  }
+  return publications.size();
+}
+
 thrift::Publication
 KvStoreWrapper::recvPublication() {
   auto maybePublication = kvStoreUpdatesQueueReader_.get(); // perform read
   if (maybePublication.hasError()) {
     throw std::runtime_error(std::string("recvPublication failed"));
   }
-  auto pub = maybePublication.value();
-  return pub;
+  return *maybePublication.value();
 }
 
 KvStoreSyncEvent
@@ -220,6 +256,21 @@ KvStoreWrapper::addPeer(
   return true;
 }
 
+bool
+KvStoreWrapper::addPeers(thrift::PeersMap peers, std::string area) {
+  // Prepare peerAddParams
+  thrift::PeerAddParams params;
+  *params.peers_ref() = std::move(peers);
+
+  try {
+    kvStore_->addUpdateKvStorePeers(params, area).get();
+  } catch (std::exception const& e) {
+    LOG(ERROR) << "Failed to add peers: " << folly::exceptionStr(e);
+    return false;
+  }
+  return true;
+}
+
 bool
 KvStoreWrapper::delPeer(std::string peerName, std::string area) {
   // Prepare peerDelParams
@@ -35,7 +35,8 @@ class KvStoreWrapper {
       std::shared_ptr<const Config> config,
       std::optional<messaging::RQueue<thrift::PeerUpdateRequest>>
           peerUpdatesQueue = std::nullopt,
-      bool enableKvStoreThrift = false);
+      bool enableKvStoreThrift = false,
+      int zmqHwm = Constants::kHighWaterMark);
 
   ~KvStoreWrapper() {
     stop();
@@ -54,7 +55,7 @@ class KvStoreWrapper {
   /**
    * Get reader for KvStore updates queue
    */
-  messaging::RQueue<thrift::Publication>
+  messaging::RQueue<PublicationPtr>
   getReader() {
     return kvStoreUpdatesQueue_.getReader();
   }
@@ -129,6 +130,17 @@ class KvStoreWrapper {
       thrift::KeyVals const& keyValHashes,
       std::string area = thrift::KvStore_constants::kDefaultArea());
 
+  /**
+   * Replay recording into area, setting key-values of its dump and then of
+   * each of its publications at the time it got recorded, sped up by speed.
+   * Speed of 0 replays publications back to back. Expired keys are left to
+   * expire by their ttl. Returns number of publications replayed.
+   */
+  size_t replayRecording(
+      const thrift::KvStoreRecording& recording,
+      double speed = 1.0,
+      std::string area = thrift::KvStore_constants::kDefaultArea());
+
   /**
    * API to listen for a publication on PUB queue.
    */
@@ -153,6 +165,9 @@ class KvStoreWrapper {
       std::string peerName,
       thrift::PeerSpec spec,
       std::string area = thrift::KvStore_constants::kDefaultArea());
+  bool addPeers(
+      thrift::PeersMap peers,
+      std::string area = thrift::KvStore_constants::kDefaultArea());
   bool delPeer(
       std::string peerName,
       std::string area = thrift::KvStore_constants::kDefaultArea());
@@ -207,8 +222,8 @@ class KvStoreWrapper {
   apache::thrift::CompactSerializer serializer_;
 
   // Queue for streaming KvStore updates
-  messaging::ReplicateQueue<thrift::Publication> kvStoreUpdatesQueue_;
-  messaging::RQueue<thrift::Publication> kvStoreUpdatesQueueReader_{
+  messaging::ReplicateQueue<PublicationPtr> kvStoreUpdatesQueue_;
+  messaging::RQueue<PublicationPtr> kvStoreUpdatesQueueReader_{
       kvStoreUpdatesQueue_.getReader()};
 
   // Queue to get KvStore Initial Sync Updates
@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/kvstore/TtlCountdownQueue.h>
+
+namespace openr {
+
+constexpr std::chrono::milliseconds TtlCountdownQueue::kTick;
+constexpr int64_t TtlCountdownQueue::kNumSlots;
+
+TtlCountdownQueue::TtlCountdownQueue()
+    : startTime_(Clock::now()), slots_(kNumSlots) {}
+
+void
+TtlCountdownQueue::push(TtlCountdownQueueEntry entry) {
+  auto const slot = getEntryTick(entry) % kNumSlots;
+  auto& entries = slots_.at(slot);
+
+  auto it = index_.find(entry.key);
+  if (it != index_.end()) {
+    // refresh by moving the existing entry over, no reallocation
+    auto& [prevSlot, pos] = it->second;
+    *pos = std::move(entry);
+    entries.splice(entries.end(), slots_.at(prevSlot), pos);
+    prevSlot = slot;
+    return;
+  }
+
+  auto key = entry.key;
+  entries.emplace_back(std::move(entry));
+  index_.emplace(
+      std::move(key), std::make_pair(slot, std::prev(entries.end())));
+}
+
+void
+TtlCountdownQueue::erase(std::string const& key) {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return;
+  }
+  auto const& [slot, pos] = it->second;
+  slots_.at(slot).erase(pos);
+  index_.erase(it);
+}
+
+TtlCountdownQueueEntry const*
+TtlCountdownQueue::find(std::string const& key) const {
+  auto it = index_.find(key);
+  return it == index_.end() ? nullptr : &(*it->second.second);
+}
+
+std::vector<TtlCountdownQueueEntry>
+TtlCountdownQueue::popExpired(Clock::time_point now) {
+  std::vector<TtlCountdownQueueEntry> expiredEntries;
+  auto const nowTick = getTick(now);
+
+  // visit every slot at most once, even if revolutions have passed
+  auto const lastTick = std::min(nowTick, currentTick_ + kNumSlots - 1);
+  for (auto tick = currentTick_; tick <= lastTick; ++tick) {
+    auto& entries = slots_.at(tick % kNumSlots);
+    for (auto it = entries.begin(); it != entries.end();) {
+      if (it->expiryTime > now) {
+        // later tick in this slot, or not due yet within the current tick
+        ++it;
+        continue;
+      }
+      index_.erase(it->key);
+      expiredEntries.emplace_back(std::move(*it));
+      it = entries.erase(it);
+    }
+  }
+  currentTick_ = std::max(currentTick_, nowTick);
+  return expiredEntries;
+}
+
+std::optional<TtlCountdownQueue::Clock::time_point>
+TtlCountdownQueue::getNextExpiryTime() const {
+  if (empty()) {
+    return std::nullopt;
+  }
+
+  for (auto tick = currentTick_; tick < currentTick_ + kNumSlots; ++tick) {
+    std::optional<Clock::time_point> nextExpiryTime;
+    for (auto const& entry : slots_.at(tick % kNumSlots)) {
+      if (getEntryTick(entry) != tick) {
+        // expires in a later revolution
+        continue;
+      }
+      if (not nextExpiryTime or entry.expiryTime < *nextExpiryTime) {
+        nextExpiryTime = entry.expiryTime;
+      }
+    }
+    if (nextExpiryTime) {
+      return nextExpiryTime;
+    }
+  }
+  return startTime_ + kTick * (currentTick_ + kNumSlots);
+}
+
+int64_t
+TtlCountdownQueue::getTick(Clock::time_point time) const {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             time - startTime_)
+             .count() /
+      kTick.count();
+}
+
+} // namespace openr
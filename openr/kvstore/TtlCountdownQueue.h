@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace openr {
+
+struct TtlCountdownQueueEntry {
+  std::chrono::steady_clock::time_point expiryTime;
+  std::string key;
+  int64_t version{0};
+  int64_t ttlVersion{0};
+  std::string originatorId;
+};
+
+/**
+ * Expiry times of keys with finite TTL, kept in a hashed timing wheel. Every
+ * key has at most one entry, pushing an entry for a key refreshes its
+ * existing one. Both are O(1), as TTL refreshes are the most frequent kind of
+ * update in KvStore.
+ *
+ * Entries are hashed into kNumSlots slots by their expiry time in units of
+ * kTick. Entries expiring beyond one revolution of the wheel share slots with
+ * earlier ones and are skipped until due. Expiry itself is exact, the tick
+ * only determines the bucketing.
+ */
+class TtlCountdownQueue {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr std::chrono::milliseconds kTick{64};
+  // ~8.7 minutes per revolution, covering common key TTLs
+  static constexpr int64_t kNumSlots{8192};
+
+  TtlCountdownQueue();
+
+  // add entry, replacing the existing entry of its key
+  void push(TtlCountdownQueueEntry entry);
+
+  // remove entry of key, no-op if there is none
+  void erase(std::string const& key);
+
+  // entry of key, nullptr if there is none
+  TtlCountdownQueueEntry const* find(std::string const& key) const;
+
+  size_t
+  size() const {
+    return index_.size();
+  }
+
+  bool
+  empty() const {
+    return index_.empty();
+  }
+
+  // remove and return all entries expiring at or before now
+  std::vector<TtlCountdownQueueEntry> popExpired(Clock::time_point now);
+
+  // earliest expiry time of all entries, std::nullopt if empty. If all entries
+  // expire beyond the current revolution the end of it is returned instead.
+  std::optional<Clock::time_point> getNextExpiryTime() const;
+
+ private:
+  using Slot = std::list<TtlCountdownQueueEntry>;
+
+  int64_t getTick(Clock::time_point time) const;
+
+  // tick an entry is hashed with, entries already due go to the current one
+  int64_t
+  getEntryTick(TtlCountdownQueueEntry const& entry) const {
+    return std::max(getTick(entry.expiryTime), currentTick_);
+  }
+
+  // reference point of ticks
+  const Clock::time_point startTime_;
+
+  // earliest tick that may have entries which are not expired yet
+  int64_t currentTick_{0};
+
+  std::vector<Slot> slots_;
+
+  // position of the entry of every key
+  std::unordered_map<std::string, std::pair<int64_t /* slot */, Slot::iterator>>
+      index_;
+};
+
+} // namespace openr
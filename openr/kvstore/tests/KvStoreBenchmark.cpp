@@ -7,6 +7,7 @@
 
 #include <folly/Benchmark.h>
 #include <cstdlib>
+#include <thread>
 #include <unordered_set>
 
 #include <fbzmq/zmq/Zmq.h>
@@ -20,6 +21,26 @@
 #include <openr/if/gen-cpp2/KvStore_types.h>
 #include <openr/kvstore/KvStore.h>
 #include <openr/kvstore/KvStoreWrapper.h>
+#include <openr/kvstore/TtlCountdownQueue.h>
+#include <openr/monitor/SystemMetrics.h>
+#include <openr/tests/BenchmarkDriver.h>
+#include <openr/tests/OpenrThriftServerWrapper.h>
+
+/**
+ * Defines a benchmark that allows users to record customized counter during
+ * benchmarking and passes a parameter to another one. This is common for
+ * benchmarks that need a "problem size" in addition to "number of iterations".
+ */
+#define BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param_name, ...) \
+  BENCHMARK_IMPL_COUNTERS(                                             \
+      FB_CONCATENATE(name, FB_CONCATENATE(_, param_name)),             \
+      FOLLY_PP_STRINGIZE(name) "(" FOLLY_PP_STRINGIZE(param_name) ")", \
+      counters,                                                        \
+      iters,                                                           \
+      unsigned,                                                        \
+      iters) {                                                         \
+    name(counters, iters, ##__VA_ARGS__);                              \
+  }
 
 namespace {
 
@@ -31,6 +52,12 @@ const int kSizeOfKey = 32;
 // The byte size of a value
 const int kSizeOfValue = 1024;
 
+// ttl of keys refreshed in benchmarks
+const std::chrono::milliseconds kTtl(3600 * 1000);
+
+// poll interval while waiting for stores to sync
+const std::chrono::milliseconds kPollInterval(1);
+
 /**
  * Produce a random string of given length - for value generation
  */
@@ -61,7 +88,13 @@ class KvStoreTestFixture {
   }
 
   ~KvStoreTestFixture() {
-    // nothing to do
+    // close queues to unblock thrift servers bring down
+    for (auto& store : stores_) {
+      store->closeQueue();
+    }
+    for (auto& thriftServer : thriftServers_) {
+      thriftServer->stop();
+    }
     for (auto& store : stores_) {
       store->stop();
     }
@@ -71,16 +104,50 @@ class KvStoreTestFixture {
    * Helper function to create KvStoreWrapper. The underlying stores will be
    * stopped as well as destroyed automatically when test exits.
    * Retured raw pointer of an object will be freed as well.
+   *
+   * With enableThrift, store peers over thrift and gets a thrift server, see
+   * getThriftPeerSpec()
    */
   KvStoreWrapper*
-  createKvStore(const std::string& nodeId) {
+  createKvStore(const std::string& nodeId, bool enableThrift = false) {
     auto tConfig = getBasicOpenrConfig(nodeId);
     tConfig.kvstore_config_ref()->sync_interval_s_ref() =
         kDbSyncInterval.count();
     config_ = std::make_shared<Config>(tConfig);
-    auto ptr = std::make_unique<KvStoreWrapper>(context, config_);
+    auto ptr = std::make_unique<KvStoreWrapper>(
+        context, config_, std::nullopt, enableThrift);
     stores_.emplace_back(std::move(ptr));
-    return stores_.back().get();
+    auto store = stores_.back().get();
+    if (enableThrift) {
+      thriftServers_.emplace_back(std::make_unique<OpenrThriftServerWrapper>(
+          nodeId,
+          nullptr, // decision
+          nullptr, // fib
+          store->getKvStore(), // kvStore
+          nullptr, // link-monitor
+          nullptr, // monitor
+          nullptr, // config-store
+          nullptr, // prefixManager
+          nullptr, // spark
+          nullptr // config
+          ));
+      thriftServers_.back()->run();
+      thriftPorts_.emplace(
+          nodeId, thriftServers_.back()->getOpenrCtrlThriftPort());
+    }
+    return store;
+  }
+
+  /**
+   * Peer spec of a store created with enableThrift
+   */
+  thrift::PeerSpec
+  getThriftPeerSpec(KvStoreWrapper* store) const {
+    return createPeerSpec(
+        // TODO: remove dummy url once zmq deprecated
+        folly::sformat("inproc://dummy-spec-{}", store->getNodeId()),
+        Constants::kPlatformHost.toString(),
+        thriftPorts_.at(store->getNodeId()));
   }
 
  private:
@@ -90,8 +157,45 @@ class KvStoreTestFixture {
   // Internal stores
   std::shared_ptr<Config> config_;
   std::vector<std::unique_ptr<KvStoreWrapper>> stores_{};
+
+  // thrift servers of stores created with enableThrift, and their ports
+  std::vector<std::unique_ptr<OpenrThriftServerWrapper>> thriftServers_{};
+  std::unordered_map<std::string, int32_t> thriftPorts_{};
 };
 
+/**
+ * Create value of given size, with hash set
+ */
+thrift::Value
+createValue(
+    uint64_t version,
+    size_t sizeOfValue,
+    int64_t ttl = Constants::kTtlInfinity) {
+  thrift::Value thriftVal(
+      apache::thrift::FRAGILE,
+      version /* version */,
+      "kvStore" /* originatorId */,
+      genRandomStr(sizeOfValue) /* value */,
+      ttl /* ttl */,
+      0 /* ttl version */,
+      0 /* hash */);
+  thriftVal.hash_ref() = generateHash(
+      *thriftVal.version_ref(),
+      *thriftVal.originatorId_ref(),
+      thriftVal.value_ref());
+  return thriftVal;
+}
+
+/**
+ * Wait for the initial full-sync of store with peer to be done
+ */
+void
+waitForFullSync(KvStoreWrapper* store, const std::string& peerName) {
+  while (store->getPeerState(peerName) != KvStorePeerState::INITIALIZED) {
+    std::this_thread::sleep_for(kPollInterval);
+  }
+}
+
 /**
  * Merge update with kvStore:
  * 1. Randomly choose #numOfUpdateKeys keys from kvStore
@@ -220,6 +324,18 @@ BM_KvStoreMergeKeyValues(
   }
 }
 
+/**
+ * Insert estimated memory of the key-vals of kvStore and peak RSS of the
+ * process as user counters. Peak RSS covers all benchmarks run so far in the
+ * process, run one with --bm_regex to attribute it
+ */
+static void
+insertMemoryCounters(folly::UserCounters& counters, KvStoreWrapper* kvStore) {
+  counters["key_vals_bytes"] =
+      kvStore->getCounters().at("kvstore.key_vals_bytes");
+  counters["peak_rss_bytes"] = SystemMetrics().getPeakRSSMemBytes().value_or(0);
+}
+
 /**
  * Benchmark for a full dump:
  * 1. Start kvStore
@@ -227,7 +343,8 @@ BM_KvStoreMergeKeyValues(
  * 3. Benchmark the time for dumpAll()
  */
 static void
-BM_KvStoreDumpAll(uint32_t iters, size_t numOfKeysInStore) {
+BM_KvStoreDumpAll(
+    folly::UserCounters& counters, uint32_t iters, size_t numOfKeysInStore) {
   auto suspender = folly::BenchmarkSuspender();
   auto kvStoreTestFixture = std::make_unique<KvStoreTestFixture>();
   auto kvStore = kvStoreTestFixture->createKvStore("kvStore");
@@ -257,6 +374,8 @@ BM_KvStoreDumpAll(uint32_t iters, size_t numOfKeysInStore) {
   for (uint32_t i = 0; i < iters; i++) {
     kvStore->dumpAll();
   }
+  suspender.rehire(); // Stop measuring time again
+  insertMemoryCounters(counters, kvStore);
 }
 
 /**
@@ -289,6 +408,224 @@ BM_KvStoreFloodingUpdate(uint32_t iters, size_t numOfUpdateKeys) {
   }
 }
 
+/**
+ * Benchmark for initial full-sync between two stores over thrift, i.e.
+ * requestThriftPeerSync() and finalizeFullSync():
+ * 1. Start two kvStores, the first one with numOfKeys keys, the second one
+ *    with overlapPercent of them, and as many keys of its own
+ * 2. Benchmark the time for the second one to full-sync with the first one
+ */
+static void
+BM_KvStoreFullSync(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numOfKeys,
+    size_t overlapPercent) {
+  CHECK_LE(overlapPercent, 100);
+  auto suspender = folly::BenchmarkSuspender();
+  const size_t numOfOverlapKeys = numOfKeys * overlapPercent / 100;
+
+  std::vector<std::pair<std::string, thrift::Value>> keyVals1;
+  std::vector<std::pair<std::string, thrift::Value>> keyVals2;
+  for (size_t idx = 0; idx < numOfKeys; idx++) {
+    keyVals1.emplace_back(
+        genRandomStr(kSizeOfKey), createValue(1, kSizeOfValue));
+    if (idx < numOfOverlapKeys) {
+      keyVals2.emplace_back(keyVals1.back());
+    } else {
+      keyVals2.emplace_back(
+          genRandomStr(kSizeOfKey), createValue(1, kSizeOfValue));
+    }
+  }
+
+  for (uint32_t i = 0; i < iters; i++) {
+    auto kvStoreTestFixture = std::make_unique<KvStoreTestFixture>();
+    auto kvStore1 = kvStoreTestFixture->createKvStore("kvStore1", true);
+    auto kvStore2 = kvStoreTestFixture->createKvStore("kvStore2", true);
+    kvStore1->run();
+    kvStore2->run();
+    CHECK(kvStore1->setKeys(keyVals1));
+    CHECK(kvStore2->setKeys(keyVals2));
+
+    suspender.dismiss(); // Start measuring benchmark time
+    kvStore2->addPeer(
+        kvStore1->getNodeId(), kvStoreTestFixture->getThriftPeerSpec(kvStore1));
+    waitForFullSync(kvStore2, kvStore1->getNodeId());
+    suspender.rehire(); // Stop measuring time again
+    if (i + 1 == iters) {
+      insertMemoryCounters(counters, kvStore2);
+    }
+  }
+  counters["keys_to_sync"] = 2 * (numOfKeys - numOfOverlapKeys);
+}
+
+/**
+ * Benchmark for a storm of ttl refreshes:
+ * 1. Start kvStore with numOfKeys keys with ttl
+ * 2. Refresh ttl of all keys at once and wait for the publication of it
+ */
+static void
+BM_KvStoreTtlRefreshStorm(uint32_t iters, size_t numOfKeys) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto kvStoreTestFixture = std::make_unique<KvStoreTestFixture>();
+  auto kvStore = kvStoreTestFixture->createKvStore("kvStore");
+  kvStore->run();
+
+  std::vector<std::pair<std::string, thrift::Value>> keyVals;
+  for (size_t idx = 0; idx < numOfKeys; idx++) {
+    keyVals.emplace_back(
+        genRandomStr(kSizeOfKey),
+        createValue(1, kSizeOfValue, kTtl.count()));
+  }
+  CHECK(kvStore->setKeys(keyVals));
+  kvStore->recvPublication();
+
+  // Refreshes carry no value
+  for (auto& [_, thriftVal] : keyVals) {
+    thriftVal.value_ref().reset();
+  }
+
+  for (uint32_t i = 0; i < iters; i++) {
+    for (auto& [_, thriftVal] : keyVals) {
+      thriftVal.ttlVersion_ref() = *thriftVal.ttlVersion_ref() + 1;
+    }
+    suspender.dismiss(); // Start measuring benchmark time
+    kvStore->setKeys(keyVals);
+    auto pub = kvStore->recvPublication();
+    suspender.rehire(); // Stop measuring time again
+    CHECK_EQ(numOfKeys, pub.keyVals_ref()->size());
+  }
+}
+
+/**
+ * Benchmark for flooding a single key update depending on store size, which
+ * should be independent of it:
+ * 1. Start kvStore with numOfKeys keys with ttl
+ * 2. Update one key and wait for the publication of it
+ */
+static void
+BM_KvStoreFloodVsStoreSize(uint32_t iters, size_t numOfKeys) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto kvStoreTestFixture = std::make_unique<KvStoreTestFixture>();
+  auto kvStore = kvStoreTestFixture->createKvStore("kvStore");
+  kvStore->run();
+
+  std::vector<std::pair<std::string, thrift::Value>> keyVals;
+  for (size_t idx = 0; idx < numOfKeys; idx++) {
+    keyVals.emplace_back(
+        genRandomStr(kSizeOfKey),
+        createValue(1, kSizeOfValue, kTtl.count()));
+  }
+  CHECK(kvStore->setKeys(keyVals));
+  kvStore->recvPublication();
+
+  const auto key = keyVals.front().first;
+  for (uint32_t version = 2; version < iters + 2; version++) {
+    std::vector<std::pair<std::string, thrift::Value>> update{
+        {key, createValue(version, kSizeOfValue, kTtl.count())}};
+    suspender.dismiss(); // Start measuring benchmark time
+    kvStore->setKeys(update);
+    auto pub = kvStore->recvPublication();
+    suspender.rehire(); // Stop measuring time again
+    CHECK_EQ(1, pub.keyVals_ref()->size());
+  }
+}
+
+/**
+ * Benchmark for flooding large values, e.g. adjacencies of nodes with
+ * hundreds of neighbors, to a peer over thrift:
+ * 1. Start two peered kvStores
+ * 2. Set numOfUpdateKeys keys of sizeOfValue bytes into the first one and
+ *    wait until they appear in the second one
+ */
+static void
+BM_KvStoreFloodLargeValues(
+    uint32_t iters, size_t numOfUpdateKeys, size_t sizeOfValue) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto kvStoreTestFixture = std::make_unique<KvStoreTestFixture>();
+  auto kvStore1 = kvStoreTestFixture->createKvStore("kvStore1", true);
+  auto kvStore2 = kvStoreTestFixture->createKvStore("kvStore2", true);
+  kvStore1->run();
+  kvStore2->run();
+  kvStore1->addPeer(
+      kvStore2->getNodeId(), kvStoreTestFixture->getThriftPeerSpec(kvStore2));
+  kvStore2->addPeer(
+      kvStore1->getNodeId(), kvStoreTestFixture->getThriftPeerSpec(kvStore1));
+  waitForFullSync(kvStore1, kvStore2->getNodeId());
+  waitForFullSync(kvStore2, kvStore1->getNodeId());
+
+  std::vector<std::string> keys;
+  for (size_t idx = 0; idx < numOfUpdateKeys; idx++) {
+    keys.emplace_back(genRandomStr(kSizeOfKey));
+  }
+
+  for (uint32_t version = 1; version <= iters; version++) {
+    std::vector<std::pair<std::string, thrift::Value>> keyVals;
+    for (const auto& key : keys) {
+      keyVals.emplace_back(key, createValue(version, sizeOfValue));
+    }
+
+    suspender.dismiss(); // Start measuring benchmark time
+    kvStore1->setKeys(keyVals);
+    for (const auto& key : keys) {
+      while (true) {
+        auto thriftVal = kvStore2->getKey(key);
+        if (thriftVal.has_value() and *thriftVal->version_ref() == version) {
+          break;
+        }
+        std::this_thread::yield();
+      }
+    }
+    suspender.rehire(); // Stop measuring time again
+  }
+}
+
+/**
+ * Benchmark for hashing a value of given size, as done on every key set
+ */
+static void
+BM_GenerateHash(uint32_t iters, size_t sizeOfValue) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::optional<std::string> value(genRandomStr(sizeOfValue));
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(generateHash(i, "kvStore", value));
+  }
+}
+
+/**
+ * Benchmark for ttl refreshes of the ttl countdown queue:
+ * 1. Push an entry for each key
+ * 2. Refresh entries of all keys with a bumped ttl version
+ */
+static void
+BM_TtlCountdownQueueRefresh(uint32_t iters, size_t numOfKeys) {
+  auto suspender = folly::BenchmarkSuspender();
+  TtlCountdownQueue queue;
+  std::vector<TtlCountdownQueueEntry> entries(numOfKeys);
+  auto const now = TtlCountdownQueue::Clock::now();
+  for (uint32_t idx = 0; idx < numOfKeys; idx++) {
+    auto& entry = entries.at(idx);
+    entry.key = genRandomStr(kSizeOfKey);
+    entry.version = 1;
+    entry.originatorId = "kvStore";
+    entry.expiryTime = now + std::chrono::seconds(300);
+    queue.push(entry);
+  }
+
+  suspender.dismiss(); // Start measuring benchmark time
+  for (uint32_t i = 0; i < iters; i++) {
+    for (auto& entry : entries) {
+      entry.ttlVersion++;
+      entry.expiryTime += std::chrono::seconds(1);
+      queue.push(entry);
+    }
+  }
+  suspender.rehire(); // Stop measuring benchmark time
+  CHECK_EQ(numOfKeys, queue.size());
+}
+
 // The first integer parameter is number of keyVals already in store
 // The second integer parameter is the number of keyVals for update
 BENCHMARK_NAMED_PARAM(BM_KvStoreMergeKeyValues, 10_10, 10, 10);
@@ -300,10 +637,10 @@ BENCHMARK_NAMED_PARAM(BM_KvStoreMergeKeyValues, 10000_1000, 10000, 1000);
 BENCHMARK_NAMED_PARAM(BM_KvStoreMergeKeyValues, 10000_10000, 10000, 10000);
 
 // The parameter is number of keyVals already in store
-BENCHMARK_PARAM(BM_KvStoreDumpAll, 10);
-BENCHMARK_PARAM(BM_KvStoreDumpAll, 100);
-BENCHMARK_PARAM(BM_KvStoreDumpAll, 1000);
-BENCHMARK_PARAM(BM_KvStoreDumpAll, 10000);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_KvStoreDumpAll, counters, 10, 10);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_KvStoreDumpAll, counters, 100, 100);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_KvStoreDumpAll, counters, 1000, 1000);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_KvStoreDumpAll, counters, 10000, 10000);
 
 // The parameter is number of keyVals for update
 BENCHMARK_PARAM(BM_KvStoreFloodingUpdate, 10);
@@ -311,11 +648,52 @@ BENCHMARK_PARAM(BM_KvStoreFloodingUpdate, 100);
 BENCHMARK_PARAM(BM_KvStoreFloodingUpdate, 1000);
 BENCHMARK_PARAM(BM_KvStoreFloodingUpdate, 10000);
 
+// The first integer parameter is number of keys in each store
+// The second integer parameter is the percentage of keys in both stores
+BENCHMARK_COUNTERS_NAME_PARAM(BM_KvStoreFullSync, counters, 10000_0, 10000, 0);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFullSync, counters, 10000_90, 10000, 90);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFullSync, counters, 100000_0, 100000, 0);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFullSync, counters, 100000_50, 100000, 50);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFullSync, counters, 100000_90, 100000, 90);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFullSync, counters, 100000_100, 100000, 100);
+
+// The parameter is number of keys refreshed at once
+BENCHMARK_PARAM(BM_KvStoreTtlRefreshStorm, 1000);
+BENCHMARK_PARAM(BM_KvStoreTtlRefreshStorm, 10000);
+BENCHMARK_PARAM(BM_KvStoreTtlRefreshStorm, 100000);
+
+// The parameter is number of keys with ttl in store
+BENCHMARK_PARAM(BM_KvStoreFloodVsStoreSize, 100);
+BENCHMARK_PARAM(BM_KvStoreFloodVsStoreSize, 10000);
+BENCHMARK_PARAM(BM_KvStoreFloodVsStoreSize, 100000);
+
+// The first integer parameter is the number of keyVals for update
+// The second integer parameter is the byte size of their values
+BENCHMARK_NAMED_PARAM(BM_KvStoreFloodLargeValues, 10_10KB, 10, 10 * 1024);
+BENCHMARK_NAMED_PARAM(BM_KvStoreFloodLargeValues, 10_50KB, 10, 50 * 1024);
+BENCHMARK_NAMED_PARAM(BM_KvStoreFloodLargeValues, 100_10KB, 100, 10 * 1024);
+BENCHMARK_NAMED_PARAM(BM_KvStoreFloodLargeValues, 100_50KB, 100, 50 * 1024);
+
+// The parameter is the byte size of the value
+BENCHMARK_PARAM(BM_GenerateHash, 100);
+BENCHMARK_PARAM(BM_GenerateHash, 10240);
+BENCHMARK_PARAM(BM_GenerateHash, 102400);
+
+// The parameter is number of keys with ttl
+BENCHMARK_PARAM(BM_TtlCountdownQueueRefresh, 10);
+BENCHMARK_PARAM(BM_TtlCountdownQueueRefresh, 100);
+BENCHMARK_PARAM(BM_TtlCountdownQueueRefresh, 1000);
+BENCHMARK_PARAM(BM_TtlCountdownQueueRefresh, 10000);
+
 } // namespace openr
 
 int
 main(int argc, char** argv) {
   folly::init(&argc, &argv);
-  folly::runBenchmarks();
-  return 0;
+  return openr::runBenchmarks();
 }
@@ -521,6 +521,7 @@ TEST(KvStoreClientInternal, EmptyValueKey) {
         EXPECT_EQ("", maybeThriftVal.value().value_ref());
         EXPECT_EQ("node1", *maybeThriftVal.value().originatorId_ref());
         EXPECT_EQ(*maybeThriftVal.value().version_ref(), 2);
+        EXPECT_TRUE(maybeThriftVal.value().tombstone_ref().value_or(false));
       });
 
   // persist key with new value, and check for new value and higher key version
@@ -545,6 +546,7 @@ TEST(KvStoreClientInternal, EmptyValueKey) {
         EXPECT_EQ("v2", maybeThriftVal.value().value_ref());
         EXPECT_EQ("node1", *maybeThriftVal.value().originatorId_ref());
         EXPECT_EQ(*maybeThriftVal.value().version_ref(), 3);
+        EXPECT_FALSE(maybeThriftVal.value().tombstone_ref().has_value());
       });
 
   // set empty value on store1, and check for key expiry
@@ -774,6 +776,117 @@ TEST(KvStoreClientInternal, PersistKeyChangeTtlTest) {
   evbThread.join();
 }
 
+/**
+ * Test ttl updates of keys falling due close together are coalesced
+ * - Set key1 with ttl 8s, and key2 with ttl 8s 400ms later
+ *   - ttl of key1 is refreshed after 2s, key2 is due within the coalesce
+ *     window (min(1s, ttl / 16) = 500ms)
+ * - Verify after 2.2s that both keys got refreshed together
+ */
+TEST(KvStoreClientInternal, TtlUpdateCoalescingTest) {
+  fbzmq::Context context;
+  folly::Baton waitBaton;
+  const std::string nodeId{"test_store"};
+
+  // Initialize and start KvStore
+  auto config = std::make_shared<Config>(getBasicOpenrConfig(nodeId));
+  auto store = std::make_shared<KvStoreWrapper>(context, config);
+  store->run();
+
+  // Create another OpenrEventBase instance for looping clients
+  OpenrEventBase evb;
+
+  auto client1 = std::make_unique<KvStoreClientInternal>(
+      &evb, nodeId, store->getKvStore(), std::nullopt, 1000ms);
+
+  evb.scheduleTimeout(std::chrono::milliseconds(0), [&]() noexcept {
+    client1->persistKey("test-key1", "test-value1", std::chrono::seconds(8));
+  });
+  evb.scheduleTimeout(std::chrono::milliseconds(400), [&]() noexcept {
+    client1->persistKey("test-key2", "test-value2", std::chrono::seconds(8));
+  });
+
+  // Verify key2 got refreshed ahead of time along with key1
+  evb.scheduleTimeout(std::chrono::milliseconds(2200), [&]() noexcept {
+    auto maybeVal1 = client1->getKey("test-key1");
+    auto maybeVal2 = client1->getKey("test-key2");
+    ASSERT_TRUE(maybeVal1.has_value());
+    ASSERT_TRUE(maybeVal2.has_value());
+    EXPECT_EQ(1, *maybeVal1->ttlVersion_ref()); // can be flaky under stress
+    EXPECT_EQ(1, *maybeVal2->ttlVersion_ref()); // can be flaky under stress
+
+    // Synchronization primitive
+    waitBaton.post();
+  });
+
+  // Start the event loop and wait until it is finished execution.
+  std::thread evbThread([&]() { evb.run(); });
+  evb.waitUntilRunning();
+
+  // Synchronization primitive
+  waitBaton.wait();
+
+  // Stop store
+  LOG(INFO) << "Stopping store";
+  store->closeQueue();
+  client1.reset();
+  store->stop();
+  store.reset();
+
+  evb.stop();
+  evb.waitUntilStopped();
+  evbThread.join();
+}
+
+/**
+ * Keys set by two clients within local_set_batch_window_ms are merged into
+ * KvStore in one publication, superseded versions are left out
+ */
+TEST(KvStoreClientInternal, LocalSetBatchingTest) {
+  fbzmq::Context context;
+  const std::string nodeId{"test_store"};
+
+  auto tConfig = getBasicOpenrConfig(nodeId);
+  tConfig.kvstore_config_ref()->local_set_batch_window_ms_ref() = 200;
+  auto config = std::make_shared<Config>(tConfig);
+  auto store = std::make_shared<KvStoreWrapper>(context, config);
+  store->run();
+
+  OpenrEventBase evb;
+  std::thread evbThread([&]() { evb.run(); });
+  evb.waitUntilRunning();
+
+  auto client1 = std::make_unique<KvStoreClientInternal>(
+      &evb, nodeId, store->getKvStore());
+  auto client2 = std::make_unique<KvStoreClientInternal>(
+      &evb, nodeId, store->getKvStore());
+
+  evb.getEvb()->runInEventBaseThreadAndWait([&]() {
+    EXPECT_TRUE(client1->setKey("test-key1", "value1", 1).has_value());
+    EXPECT_TRUE(client2->setKey("test-key2", "value2", 1).has_value());
+    EXPECT_TRUE(client1->setKey("test-key1", "value1-new", 2).has_value());
+  });
+
+  // held back until the batch window is over
+  EXPECT_FALSE(store->getKey("test-key1").has_value());
+
+  auto pub = store->recvPublication();
+  ASSERT_EQ(2, pub.keyVals_ref()->size());
+  EXPECT_EQ(2, *pub.keyVals_ref()->at("test-key1").version_ref());
+  EXPECT_EQ("value1-new", *pub.keyVals_ref()->at("test-key1").value_ref());
+  EXPECT_EQ(1, *pub.keyVals_ref()->at("test-key2").version_ref());
+
+  store->closeQueue();
+  client1.reset();
+  client2.reset();
+  store->stop();
+  store.reset();
+
+  evb.stop();
+  evb.waitUntilStopped();
+  evbThread.join();
+}
+
 /**
  * Start a store and attach two clients to it. Set some Keys and add/del peers.
  * Verify that changes are visible in KvStore via a separate REQ socket to
@@ -1481,14 +1594,14 @@ TEST_F(MultipleAreaFixture, MultipleAreaKeyExpiry) {
 }
 
 /*
- * this test checks if the checkPersistKeyInStore() works when multiple
+ * this test checks if persisted keys are repopulated when multiple
  * areas are instantiated in the KvStore, with one area having emtpy
  * persistKeyDB.
  *
  * 1. add key in node2 by calling persistKey()
  * 2. use the kvstore API to delete the key in node2 be setting a short TTL
  * 3. verify key is deleted from node2 kvstore
- * 4. wait until checkPersistKeyInStore() kicks in to repopulate the key
+ * 4. wait until the key is repopulated
  * 5. verify kvstore in node2 has the key
  */
 TEST_F(MultipleAreaFixture, PersistKeyArea) {
@@ -1535,7 +1648,7 @@ TEST_F(MultipleAreaFixture, PersistKeyArea) {
             client2->getKey("test_ttl_key_plane", planeArea).has_value());
       });
 
-  // checkPersistKey should kick in and repopulate the key node1 kvstore,
+  // key should be repopulated in node2 kvstore
   evb.scheduleTimeout(
       std::chrono::milliseconds(scheduleAt += persistKeyTimer.count() + 500),
       [&]() noexcept {
@@ -1553,6 +1666,58 @@ TEST_F(MultipleAreaFixture, PersistKeyArea) {
   waitBaton.wait();
 }
 
+/*
+ * Persisted key expiring from KvStore is advertised back on the expiry
+ * publication, without periodic check of persisted keys (node1 client has
+ * checkPersistKeyPeriod unset).
+ */
+TEST_F(MultipleAreaFixture, PersistKeyExpiredReadvertised) {
+  const std::chrono::milliseconds ttl{Constants::kTtlThreshold.count() + 100};
+  auto scheduleAt = std::chrono::milliseconds{0}.count();
+  folly::Baton waitBaton;
+
+  evb.scheduleTimeout(
+      std::chrono::milliseconds(scheduleAt), [&]() noexcept { setUpPeers(); });
+
+  evb.scheduleTimeout(
+      std::chrono::milliseconds(scheduleAt += 10), [&]() noexcept {
+        client1->persistKey("persist_key", "persist_value", ttl, planeArea);
+      });
+
+  // expire the key in node1 kvstore by setting a low ttl value
+  evb.scheduleTimeout(
+      std::chrono::milliseconds(scheduleAt += 50), [&]() noexcept {
+        EXPECT_TRUE(client1->getKey("persist_key", planeArea).has_value());
+        thrift::Value keyExpVal = createThriftValue(
+            1,
+            node1,
+            std::string("persist_value"),
+            1, /* ttl in msec */
+            500 /* ttl version */,
+            0 /* hash */);
+        store1->setKey("persist_key", keyExpVal, std::nullopt, planeArea);
+      });
+
+  // key is back in node1 kvstore
+  evb.scheduleTimeout(
+      std::chrono::milliseconds(scheduleAt += 50), [&]() noexcept {
+        auto maybeValue = client1->getKey("persist_key", planeArea);
+        EXPECT_TRUE(maybeValue.has_value());
+        if (maybeValue.has_value()) {
+          EXPECT_EQ("persist_value", *maybeValue->value_ref());
+        }
+        // Synchronization primitive
+        waitBaton.post();
+      });
+
+  // Start the event loop and wait until it is finished execution.
+  evbThread = std::thread([&]() { evb.run(); });
+  evb.waitUntilRunning();
+
+  // Synchronization primitive
+  waitBaton.wait();
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
@@ -0,0 +1,343 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fb303/ServiceData.h>
+#include <fbzmq/zmq/Zmq.h>
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/MapUtil.h>
+#include <folly/init/Init.h>
+
+#include <openr/common/Constants.h>
+#include <openr/common/Util.h>
+#include <openr/config/Config.h>
+#include <openr/config/tests/Utils.h>
+#include <openr/kvstore/KvStoreWrapper.h>
+#include <openr/tests/BenchmarkDriver.h>
+
+/**
+ * Defines a benchmark that allows users to record customized counter during
+ * benchmarking and passes a parameter to another one. This is common for
+ * benchmarks that need a "problem size" in addition to "number of iterations".
+ */
+#define BENCHMARK_COUNTERS_PARAM(name, counters, param) \
+  BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param, param)
+
+/*
+ * Like BENCHMARK_COUNTERS_PARAM(), but allows a custom name to be specified for
+ * each parameter, rather than using the parameter value.
+ */
+#define BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param_name, ...) \
+  BENCHMARK_IMPL_COUNTERS(                                             \
+      FB_CONCATENATE(name, FB_CONCATENATE(_, param_name)),             \
+      FOLLY_PP_STRINGIZE(name) "(" FOLLY_PP_STRINGIZE(param_name) ")", \
+      counters,                                                        \
+      iters,                                                           \
+      unsigned,                                                        \
+      iters) {                                                         \
+    name(counters, iters, ##__VA_ARGS__);                              \
+  }
+
+namespace fb303 = facebook::fb303;
+
+namespace {
+
+// interval for periodic syncs, large enough not to interfere with flooding
+const std::chrono::seconds kDbSyncInterval(10000);
+
+// poll interval while waiting for stores to converge
+const std::chrono::milliseconds kPollInterval(1);
+
+// counters summed across all stores of the process
+const std::string kSentPublications{"kvstore.sent_publications.count"};
+const std::string kSentKeyVals{"kvstore.sent_key_vals.sum"};
+const std::string kBytesSent{"kvstore.peers.bytes_sent.sum"};
+const std::string kDualMessagesSent{"dual.messages_sent.sum"};
+
+int64_t
+getCounter(const std::string& name) {
+  return folly::get_default(fb303::fbData->getCounters(), name, 0);
+}
+
+} // namespace
+
+namespace openr {
+
+/**
+ * Clos fabric of KvStores in one process: every leaf peers with every spine.
+ * With flood optimization, spines are flood roots and keys are flooded along
+ * the Dual spanning tree rooted at the elected one, otherwise to all peers.
+ */
+class ClosFabric {
+ public:
+  ClosFabric(uint32_t numSpines, uint32_t numLeaves, bool floodOptimization)
+      : floodOptimization_(floodOptimization) {
+    for (uint32_t i = 0; i < numSpines; ++i) {
+      spines_.emplace_back(
+          createKvStore(folly::sformat("spine-{}", i), true /* floodRoot */));
+    }
+    for (uint32_t i = 0; i < numLeaves; ++i) {
+      leaves_.emplace_back(
+          createKvStore(folly::sformat("leaf-{}", i), false /* floodRoot */));
+    }
+    for (auto& store : stores_) {
+      store->run();
+    }
+    for (auto leaf : leaves_) {
+      for (auto spine : spines_) {
+        linkUp(leaf, spine);
+      }
+    }
+  }
+
+  ~ClosFabric() {
+    for (auto& store : stores_) {
+      store->stop();
+    }
+  }
+
+  KvStoreWrapper*
+  getSpine(uint32_t index) const {
+    return spines_.at(index);
+  }
+
+  KvStoreWrapper*
+  getLeaf(uint32_t index) const {
+    return leaves_.at(index);
+  }
+
+  void
+  linkUp(KvStoreWrapper* a, KvStoreWrapper* b) {
+    CHECK(a->addPeer(b->getNodeId(), b->getPeerSpec()));
+    CHECK(b->addPeer(a->getNodeId(), a->getPeerSpec()));
+  }
+
+  void
+  linkDown(KvStoreWrapper* a, KvStoreWrapper* b) {
+    CHECK(a->delPeer(b->getNodeId()));
+    CHECK(b->delPeer(a->getNodeId()));
+  }
+
+  /**
+   * Wait for initial syncs with all peers to be done and, with flood
+   * optimization, for all stores to agree on a converged flooding topology
+   */
+  void
+  waitForConvergence() const {
+    for (const auto& store : stores_) {
+      for (const auto& [peerName, _] : store->getPeers()) {
+        while (store->getPeerState(peerName) !=
+               KvStorePeerState::INITIALIZED) {
+          std::this_thread::sleep_for(kPollInterval);
+        }
+      }
+    }
+    if (not floodOptimization_) {
+      return;
+    }
+    while (not isFloodTopoConverged()) {
+      std::this_thread::sleep_for(kPollInterval);
+    }
+  }
+
+  /**
+   * Wait for all stores to have learnt given version of key
+   */
+  void
+  waitForKey(const std::string& key, int64_t version) const {
+    for (const auto& store : stores_) {
+      while (true) {
+        const auto value = store->getKey(key);
+        if (value.has_value() and *value->version_ref() >= version) {
+          break;
+        }
+        std::this_thread::sleep_for(kPollInterval);
+      }
+    }
+  }
+
+ private:
+  KvStoreWrapper*
+  createKvStore(const std::string& nodeId, bool floodRoot) {
+    auto tConfig = getBasicOpenrConfig(nodeId);
+    auto& kvConf = *tConfig.kvstore_config_ref();
+    kvConf.sync_interval_s_ref() = kDbSyncInterval.count();
+    kvConf.enable_flood_optimization_ref() = floodOptimization_;
+    kvConf.is_flood_root_ref() = floodOptimization_ and floodRoot;
+    configs_.emplace_back(std::make_shared<Config>(tConfig));
+    stores_.emplace_back(
+        std::make_unique<KvStoreWrapper>(context_, configs_.back()));
+    return stores_.back().get();
+  }
+
+  // all stores agree on the flood root and their spanning trees are passive
+  bool
+  isFloodTopoConverged() const {
+    std::optional<std::string> floodRootId;
+    for (const auto& store : stores_) {
+      const auto sptInfos = store->getFloodTopo();
+      const auto rootId = sptInfos.floodRootId_ref().to_optional();
+      if (not rootId.has_value() or
+          (floodRootId.has_value() and *floodRootId != *rootId)) {
+        return false;
+      }
+      floodRootId = rootId;
+      for (const auto& [_, sptInfo] : *sptInfos.infos_ref()) {
+        if (not *sptInfo.passive_ref()) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  const bool floodOptimization_{false};
+
+  fbzmq::Context context_;
+  std::vector<std::shared_ptr<Config>> configs_;
+  std::vector<std::unique_ptr<KvStoreWrapper>> stores_;
+  std::vector<KvStoreWrapper*> spines_;
+  std::vector<KvStoreWrapper*> leaves_;
+};
+
+namespace {
+
+// Counters at the start of a measurement, reported as deltas at the end
+class FloodCounters {
+ public:
+  FloodCounters()
+      : publications_(getCounter(kSentPublications)),
+        keyVals_(getCounter(kSentKeyVals)),
+        bytes_(getCounter(kBytesSent)),
+        dualMessages_(getCounter(kDualMessagesSent)) {}
+
+  void
+  report(folly::UserCounters& counters, uint32_t iters) const {
+    counters["publications"] =
+        (getCounter(kSentPublications) - publications_) / iters;
+    counters["key_vals"] = (getCounter(kSentKeyVals) - keyVals_) / iters;
+    counters["bytes"] = (getCounter(kBytesSent) - bytes_) / iters;
+    counters["dual_messages"] =
+        (getCounter(kDualMessagesSent) - dualMessages_) / iters;
+  }
+
+ private:
+  const int64_t publications_{0};
+  const int64_t keyVals_{0};
+  const int64_t bytes_{0};
+  const int64_t dualMessages_{0};
+};
+
+thrift::Value
+createValue(int64_t version) {
+  return createThriftValue(
+      version,
+      "leaf-0" /* originatorId */,
+      std::string(1024, 'x') /* value */,
+      Constants::kTtlInfinity /* ttl */,
+      0 /* ttl version */,
+      0 /* hash */);
+}
+
+} // namespace
+
+/**
+ * Benchmark convergence of a key update originated by a leaf, i.e. time until
+ * all stores of the fabric have it. Reports per update the publications,
+ * key-vals and bytes flooded across the fabric.
+ */
+static void
+BM_KvStoreFloodKeyUpdate(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numSpines,
+    uint32_t numLeaves,
+    bool floodOptimization) {
+  auto suspender = folly::BenchmarkSuspender();
+  ClosFabric fabric(numSpines, numLeaves, floodOptimization);
+  fabric.waitForConvergence();
+
+  const std::string key{"flood-key"};
+  FloodCounters floodCounters;
+  for (uint32_t i = 1; i <= iters; ++i) {
+    suspender.dismiss(); // Start measuring benchmark time
+    CHECK(fabric.getLeaf(0)->setKey(key, createValue(i)));
+    fabric.waitForKey(key, i);
+    suspender.rehire(); // Stop measuring time again
+  }
+  floodCounters.report(counters, iters);
+}
+
+/**
+ * Benchmark convergence after a link failure between a leaf and the spine
+ * most likely to be the flood root: time until the flooding topology has
+ * converged again, if optimized, and a key update from that leaf has reached
+ * all stores. Reports per failure the Dual messages exchanged as well.
+ */
+static void
+BM_KvStoreFloodLinkFailure(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numSpines,
+    uint32_t numLeaves,
+    bool floodOptimization) {
+  auto suspender = folly::BenchmarkSuspender();
+  ClosFabric fabric(numSpines, numLeaves, floodOptimization);
+  fabric.waitForConvergence();
+
+  auto leaf = fabric.getLeaf(0);
+  auto spine = fabric.getSpine(0);
+  const std::string key{"flood-key"};
+  FloodCounters floodCounters;
+  for (uint32_t i = 1; i <= iters; ++i) {
+    suspender.dismiss(); // Start measuring benchmark time
+    fabric.linkDown(leaf, spine);
+    fabric.waitForConvergence();
+    CHECK(leaf->setKey(key, createValue(i)));
+    fabric.waitForKey(key, i);
+    suspender.rehire(); // Stop measuring time again
+
+    // restore link, its full sync is not part of the measurement
+    fabric.linkUp(leaf, spine);
+    fabric.waitForConvergence();
+  }
+  floodCounters.report(counters, iters);
+}
+
+// The parameters are the number of spines and leaves, and whether flood
+// optimization is enabled
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFloodKeyUpdate, counters, 4_16_false, 4, 16, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFloodKeyUpdate, counters, 4_16_true, 4, 16, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFloodKeyUpdate, counters, 8_64_false, 8, 64, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFloodKeyUpdate, counters, 8_64_true, 8, 64, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFloodLinkFailure, counters, 4_16_false, 4, 16, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFloodLinkFailure, counters, 4_16_true, 4, 16, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFloodLinkFailure, counters, 8_64_false, 8, 64, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_KvStoreFloodLinkFailure, counters, 8_64_true, 8, 64, true);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  return openr::runBenchmarks();
+}
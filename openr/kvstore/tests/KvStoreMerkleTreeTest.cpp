@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <set>
+
+#include <folly/Format.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/Util.h>
+#include <openr/kvstore/KvStoreMerkleTree.h>
+
+using namespace openr;
+
+namespace {
+thrift::Value
+createValue(int64_t version, int64_t ttlVersion = 0) {
+  return createThriftValue(
+      version,
+      "node1",
+      std::string("value"),
+      Constants::kTtlInfinity,
+      ttlVersion,
+      generateHash(version, "node1", std::string("value")));
+}
+} // namespace
+
+TEST(KvStoreMerkleTreeTest, Digests) {
+  KvStoreMerkleTree tree1;
+  KvStoreMerkleTree tree2;
+  auto const root = KvStoreMerkleTree::kRoot;
+  EXPECT_EQ(tree1.getDigest(root), tree2.getDigest(root));
+
+  // digests don't depend on the order of updates
+  for (int i = 0; i < 100; ++i) {
+    tree1.set(folly::sformat("key{}", i), createValue(1));
+  }
+  for (int i = 99; i >= 0; --i) {
+    tree2.set(folly::sformat("key{}", i), createValue(i == 42 ? 2 : 1));
+  }
+  EXPECT_EQ(100, tree1.getNumKeys(root));
+  EXPECT_NE(tree1.getDigest(root), tree2.getDigest(root));
+
+  // only the path of the differing key mismatches
+  auto const leaf = KvStoreMerkleTree::getLeaf("key42");
+  EXPECT_TRUE(KvStoreMerkleTree::isLeaf(leaf));
+  EXPECT_NE(tree1.getDigest(leaf), tree2.getDigest(leaf));
+  size_t numMismatches = 0;
+  for (auto const child : KvStoreMerkleTree::getChildren(root)) {
+    numMismatches += tree1.getDigest(child) != tree2.getDigest(child);
+  }
+  EXPECT_EQ(1, numMismatches);
+
+  tree1.set("key42", createValue(2));
+  EXPECT_EQ(tree1.getDigest(root), tree2.getDigest(root));
+
+  // ttl version is covered as well
+  tree1.set("key42", createValue(2, 1));
+  EXPECT_NE(tree1.getDigest(root), tree2.getDigest(root));
+  tree2.set("key42", createValue(2, 1));
+  EXPECT_EQ(tree1.getDigest(root), tree2.getDigest(root));
+
+  // removing keys restores digests
+  tree1.set("key100", createValue(1));
+  EXPECT_NE(tree1.getDigest(root), tree2.getDigest(root));
+  tree1.erase("key100");
+  tree1.erase("key100");
+  EXPECT_EQ(tree1.getDigest(root), tree2.getDigest(root));
+  EXPECT_EQ(100, tree1.getNumKeys(root));
+
+  tree1.clear();
+  EXPECT_EQ(KvStoreMerkleTree().getDigest(root), tree1.getDigest(root));
+  EXPECT_EQ(0, tree1.getNumKeys(root));
+}
+
+TEST(KvStoreMerkleTreeTest, ForEachKey) {
+  KvStoreMerkleTree tree;
+  std::set<std::string> keys;
+  for (int i = 0; i < 50; ++i) {
+    keys.emplace(folly::sformat("key{}", i));
+    tree.set(folly::sformat("key{}", i), createValue(1));
+  }
+
+  std::set<std::string> rootKeys;
+  tree.forEachKey(KvStoreMerkleTree::kRoot, [&](std::string const& key) {
+    rootKeys.emplace(key);
+  });
+  EXPECT_EQ(keys, rootKeys);
+
+  // keys of children partition the keys of their parent
+  std::set<std::string> childKeys;
+  size_t numChildKeys = 0;
+  for (auto const child :
+       KvStoreMerkleTree::getChildren(KvStoreMerkleTree::kRoot)) {
+    tree.forEachKey(child, [&](std::string const& key) {
+      childKeys.emplace(key);
+      ++numChildKeys;
+    });
+  }
+  EXPECT_EQ(keys, childKeys);
+  EXPECT_EQ(keys.size(), numChildKeys);
+
+  std::set<std::string> leafKeys;
+  auto const leaf = KvStoreMerkleTree::getLeaf("key7");
+  EXPECT_TRUE(KvStoreMerkleTree::getChildren(leaf).empty());
+  tree.forEachKey(
+      leaf, [&](std::string const& key) { leafKeys.emplace(key); });
+  EXPECT_EQ(1, leafKeys.count("key7"));
+  EXPECT_EQ(leafKeys.size(), tree.getNumKeys(leaf));
+
+  EXPECT_FALSE(KvStoreMerkleTree::isValidNode(-1));
+  EXPECT_FALSE(KvStoreMerkleTree::isValidNode(leaf + 100000));
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -16,12 +16,14 @@
 #include <fb303/ServiceData.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/Format.h>
+#include <folly/MapUtil.h>
 #include <folly/Memory.h>
 #include <folly/Random.h>
 #include <folly/gen/Base.h>
 #include <gtest/gtest.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
+#include <openr/common/StatHandle.h>
 #include <openr/common/Util.h>
 #include <openr/config/Config.h>
 #include <openr/config/tests/Utils.h>
@@ -102,13 +104,16 @@ class KvStoreTestFixture : public ::testing::TestWithParam<bool> {
   createKvStore(
       std::string nodeId,
       thrift::KvstoreConfig kvStoreConf = getTestKvConf(),
-      const std::vector<thrift::AreaConfig>& areas = {}) {
+      const std::vector<thrift::AreaConfig>& areas = {},
+      int zmqHwm = Constants::kHighWaterMark) {
     auto tConfig = getBasicOpenrConfig(nodeId);
     *tConfig.kvstore_config_ref() = kvStoreConf;
     *tConfig.areas_ref() = areas;
     config_ = std::make_shared<Config>(tConfig);
 
-    stores_.emplace_back(std::make_unique<KvStoreWrapper>(context, config_));
+    stores_.emplace_back(std::make_unique<KvStoreWrapper>(
+        context, config_, std::nullopt, false /* enableKvStoreThrift */,
+        zmqHwm));
     return stores_.back().get();
   }
 
@@ -372,6 +377,9 @@ TEST_F(KvStoreTestFixture, CounterReport) {
   ASSERT_EQ(1, counters.count("kvstore.cmd_peer_add.count"));
   ASSERT_EQ(1, counters.count("kvstore.cmd_per_del.count"));
   ASSERT_EQ(1, counters.count("kvstore.expired_key_vals.sum"));
+  ASSERT_EQ(1, counters.count("kvstore.flood_backlog_keys"));
+  ASSERT_EQ(1, counters.count("kvstore.flood_backoff_ms.avg"));
+  ASSERT_EQ(1, counters.count("kvstore.flood_coalesced_keys.sum"));
   ASSERT_EQ(1, counters.count("kvstore.flood_duration_ms.avg"));
   ASSERT_EQ(1, counters.count("kvstore.full_sync_duration_ms.avg"));
   ASSERT_EQ(1, counters.count("kvstore.peers.bytes_received.sum"));
@@ -391,6 +399,9 @@ TEST_F(KvStoreTestFixture, CounterReport) {
   EXPECT_EQ(0, counters.at("kvstore.cmd_peer_add.count"));
   EXPECT_EQ(0, counters.at("kvstore.cmd_per_del.count"));
   EXPECT_EQ(0, counters.at("kvstore.expired_key_vals.sum"));
+  EXPECT_EQ(0, counters.at("kvstore.flood_backlog_keys"));
+  EXPECT_EQ(0, counters.at("kvstore.flood_backoff_ms.avg"));
+  EXPECT_EQ(0, counters.at("kvstore.flood_coalesced_keys.sum"));
   EXPECT_EQ(0, counters.at("kvstore.flood_duration_ms.avg"));
   EXPECT_EQ(0, counters.at("kvstore.full_sync_duration_ms.avg"));
   EXPECT_EQ(0, counters.at("kvstore.peers.bytes_received.sum"));
@@ -441,6 +452,92 @@ TEST_F(KvStoreTestFixture, CounterReport) {
   LOG(INFO) << "KvStore thread finished";
 }
 
+/**
+ * Verify keys flooded to a peer whose socket is full are queued up in the
+ * flood backlog, repeated updates of a key coalesce into one pending entry,
+ * and latest values are delivered once the peer drains after backoff.
+ */
+TEST_F(KvStoreTestFixture, FloodBacklogAfterSendFailure) {
+  // storeA can queue at most one message towards storeB
+  auto storeA = createKvStore("storeA", getTestKvConf(), {}, 1 /* zmqHwm */);
+  storeA->run();
+
+  // storeB is not created yet, its cmd url stays unbound and nothing drains
+  const std::string storeBCmdUrl{"inproc://storeB-kvstore-global-cmd"};
+  EXPECT_TRUE(storeA->addPeer("storeB", createPeerSpec(storeBCmdUrl, "", 0)));
+
+  auto getCoalescedKeys = []() {
+    auto counters = fb303::fbData->getCounters();
+    return counters.count("kvstore.flood_coalesced_keys.sum")
+        ? counters.at("kvstore.flood_coalesced_keys.sum")
+        : 0;
+  };
+  auto getBacklogKeys = [&storeA]() {
+    auto counters = storeA->getCounters();
+    return counters.count("kvstore.flood_backlog_keys.storeB")
+        ? counters.at("kvstore.flood_backlog_keys.storeB")
+        : 0;
+  };
+  auto setKeys = [&storeA](int64_t version) {
+    for (auto const& key : {"key1", "key2"}) {
+      EXPECT_TRUE(storeA->setKey(
+          key,
+          createThriftValue(
+              version,
+              "storeA",
+              folly::sformat("value-{}", version),
+              Constants::kTtlInfinity)));
+    }
+  };
+
+  // fill up the socket till floods fail and keys land in the backlog
+  int64_t version{0};
+  while (getBacklogKeys() == 0 and version < 10) {
+    setKeys(++version);
+  }
+  ASSERT_EQ(2, getBacklogKeys());
+
+  // further updates supersede pending keys instead of adding entries
+  const auto coalescedKeysBefore = getCoalescedKeys();
+  const int64_t latestVersion = version + 3;
+  while (version < latestVersion) {
+    setKeys(++version);
+  }
+  EXPECT_EQ(2, getBacklogKeys());
+  EXPECT_LE(coalescedKeysBefore + 6, getCoalescedKeys());
+
+  // bring up storeB, backlog gets flooded on the next retry
+  auto storeB = createKvStore("storeB");
+  storeB->run();
+
+  auto isSynced = [&]() {
+    for (auto const& key : {"key1", "key2"}) {
+      auto value = storeB->getKey(key);
+      if (not value.has_value() or *value->version_ref() != latestVersion) {
+        return false;
+      }
+    }
+    return getBacklogKeys() == 0;
+  };
+  const auto deadline =
+      steady_clock::now() + 2 * Constants::kMaxBackoff + kDbSyncInterval;
+  while (not isSynced() and steady_clock::now() < deadline) {
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  EXPECT_EQ(0, getBacklogKeys());
+  EXPECT_EQ(0, storeA->getCounters().at("kvstore.flood_backlog_keys"));
+
+  // storeB holds only the latest values
+  for (auto const& key : {"key1", "key2"}) {
+    auto value = storeB->getKey(key);
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(latestVersion, *value->version_ref());
+    EXPECT_EQ(
+        folly::sformat("value-{}", latestVersion), value->value_ref().value());
+  }
+}
+
 /**
  * Test following with single KvStore.
  * - TTL propagation is carried out correctly
@@ -1076,6 +1173,29 @@ TEST_F(KvStoreTestFixture, PeerAddUpdateRemove) {
   EXPECT_EQ(emptyPeers, store0->getPeers());
 }
 
+/**
+ * Adjacency keys are published to subscribers ahead of all other keys of the
+ * same update, in higher priority class of kvStoreUpdatesQueue.
+ */
+TEST_F(KvStoreTestFixture, AdjacencyKeysPublishedFirst) {
+  auto store = createKvStore("store");
+  store->run();
+
+  const auto adjVal = createThriftValue(1, "store", std::string("adjDb"));
+  const auto val = createThriftValue(1, "store", std::string("value"));
+  EXPECT_TRUE(store->setKeys(
+      {{"prefix:store", val}, {"adj:store", adjVal}, {"key", val}}));
+
+  auto pub = store->recvPublication();
+  EXPECT_EQ(1, pub.keyVals_ref()->size());
+  EXPECT_EQ(1, pub.keyVals_ref()->count("adj:store"));
+
+  pub = store->recvPublication();
+  EXPECT_EQ(2, pub.keyVals_ref()->size());
+  EXPECT_EQ(1, pub.keyVals_ref()->count("prefix:store"));
+  EXPECT_EQ(1, pub.keyVals_ref()->count("key"));
+}
+
 /**
  * 2 x 2 Fabric topology
  * r0, r1 are root nodes
@@ -1836,7 +1956,8 @@ TEST_F(KvStoreTestFixture, BasicSync) {
  * numbers. We also try injecting lower version number to make sure it does not
  * overwrite anything.
  *
- * Also verify the publication propagation via nodeIds attribute
+ * Also verify the publication propagation via nodeIds attribute, which is
+ * bounded to the most recent hops
  */
 TEST_F(KvStoreTestFixture, TieBreaking) {
   const std::string kOriginBase = "store";
@@ -1932,8 +2053,12 @@ TEST_F(KvStoreTestFixture, TieBreaking) {
     EXPECT_EQ(
         std::vector<std::string>{stores[0]->getNodeId()},
         pub1.nodeIds_ref().value());
+    // only most recent hops are kept
     auto expectedNodeIds = nodeIdsSeq;
     std::reverse(std::begin(expectedNodeIds), std::end(expectedNodeIds));
+    expectedNodeIds.erase(
+        expectedNodeIds.begin(),
+        expectedNodeIds.end() - Constants::kMaxFloodPathLength);
     EXPECT_EQ(expectedNodeIds, pub2.nodeIds_ref().value());
   }
 
@@ -2334,7 +2459,7 @@ TEST_F(KvStoreTestFixture, RateLimiterFlood) {
 
 TEST_F(KvStoreTestFixture, RateLimiter) {
   fbzmq::Context context;
-  fb303::fbData->resetAllData();
+  resetAllStats();
 
   const size_t messageRate{10}, burstSize{50};
   auto rateLimitConf = getTestKvConf();
@@ -2403,7 +2528,7 @@ TEST_F(KvStoreTestFixture, RateLimiter) {
   const int wait = 2; // in seconds
   int i2{0};
   uint64_t elapsedTime2{0};
-  fb303::fbData->resetAllData();
+  resetAllStats();
   do {
     thrift::Value thriftVal(
         apache::thrift::FRAGILE,
@@ -2622,6 +2747,203 @@ TEST_F(KvStoreTestFixture, FullSync) {
   EXPECT_EQ(v4->value_ref().value(), "b");
 }
 
+/**
+ * Verify full-sync between stores holding the same key-values short-circuits
+ * on matching digests, without exchanging any key-value
+ */
+TEST_F(KvStoreTestFixture, FullSyncMatchingDigests) {
+  auto storeA = createKvStore("storeA");
+  auto storeB = createKvStore("storeB");
+  storeA->run();
+  storeB->run();
+
+  for (int i = 0; i < 10; ++i) {
+    auto val = createThriftValue(
+        1 /* version */, "storeA", std::string("value"), 30000 /* ttl */);
+    val.hash_ref() = generateHash(
+        *val.version_ref(), *val.originatorId_ref(), val.value_ref());
+    const auto key = folly::sformat("key{}", i);
+    EXPECT_TRUE(storeA->setKey(key, val));
+    EXPECT_TRUE(storeB->setKey(key, val));
+  }
+
+  const auto digestMatches = [&]() {
+    return folly::get_default(
+        fb303::fbData->getCounters(),
+        "kvstore.full_sync_digest_matches.count",
+        0);
+  };
+  const auto numDigestMatches = digestMatches();
+  storeA->addPeer("storeB", storeB->getPeerSpec());
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  EXPECT_EQ(numDigestMatches + 1, digestMatches());
+
+  // stores are still in sync after a key differs
+  auto val = createThriftValue(2, "storeB", std::string("new"), 30000);
+  val.hash_ref() = generateHash(
+      *val.version_ref(), *val.originatorId_ref(), val.value_ref());
+  EXPECT_TRUE(storeB->setKey("key0", val));
+  storeA->delPeer("storeB");
+  storeA->addPeer("storeB", storeB->getPeerSpec());
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  EXPECT_EQ(numDigestMatches + 1, digestMatches());
+  EXPECT_EQ("new", storeA->getKey("key0")->value_ref().value());
+}
+
+/**
+ * Verify tombstones are tracked, and settled once all peers hold them
+ */
+TEST_F(KvStoreTestFixture, Tombstones) {
+  auto storeA = createKvStore("storeA");
+  auto storeB = createKvStore("storeB");
+  storeA->run();
+  storeB->run();
+  EXPECT_TRUE(storeA->addPeer(storeB->getNodeId(), storeB->getPeerSpec()));
+  EXPECT_TRUE(storeB->addPeer(storeA->getNodeId(), storeA->getPeerSpec()));
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+  auto tombstone = createThriftValue(
+      2 /* version */, "storeA", std::string("deleted"), 30000 /* ttl */);
+  tombstone.tombstone_ref() = true;
+  EXPECT_TRUE(storeA->setKey("prefix:storeA", tombstone));
+  EXPECT_TRUE(storeA->setKey(
+      "key", createThriftValue(1, "storeA", std::string("value"))));
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+  // flooded from A to B
+  for (auto store : {storeA, storeB}) {
+    auto counters = store->getCounters();
+    EXPECT_EQ(1, counters.at("kvstore.num_tombstones"));
+    EXPECT_EQ(1, counters.at("kvstore.num_settled_tombstones"));
+  }
+  EXPECT_TRUE(storeB->getKey("prefix:storeA")->tombstone_ref().value());
+
+  // not settled anymore with a peer which doesn't hold it
+  auto storeC = createKvStore("storeC");
+  storeC->run();
+  EXPECT_TRUE(storeA->addPeer(storeC->getNodeId(), storeC->getPeerSpec()));
+  EXPECT_EQ(0, storeA->getCounters().at("kvstore.num_settled_tombstones"));
+
+  // re-advertised key is no tombstone anymore
+  EXPECT_TRUE(storeA->setKey(
+      "prefix:storeA", createThriftValue(3, "storeA", std::string("value"))));
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  for (auto store : {storeA, storeB}) {
+    EXPECT_EQ(0, store->getCounters().at("kvstore.num_tombstones"));
+  }
+}
+
+/**
+ * Verify settled tombstones are expired early under memory pressure, while
+ * tombstones some peer may miss are kept
+ */
+TEST_F(KvStoreTestFixture, CompactTombstones) {
+  auto storeA = createKvStore("storeA");
+  auto storeB = createKvStore("storeB");
+  storeA->run();
+  storeB->run();
+  EXPECT_TRUE(storeA->addPeer(storeB->getNodeId(), storeB->getPeerSpec()));
+  EXPECT_TRUE(storeB->addPeer(storeA->getNodeId(), storeA->getPeerSpec()));
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+  auto tombstone = createThriftValue(
+      2 /* version */, "storeA", std::string("deleted"), 30000 /* ttl */);
+  tombstone.tombstone_ref() = true;
+  EXPECT_TRUE(storeA->setKey("prefix:storeA", tombstone));
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  EXPECT_EQ(1, storeA->getCounters().at("kvstore.num_settled_tombstones"));
+
+  // no compaction without memory pressure
+  storeA->getKvStore()->setMemoryPressure(MemoryPressure::NONE).get();
+  EXPECT_TRUE(storeA->getKey("prefix:storeA").has_value());
+
+  storeA->getKvStore()->setMemoryPressure(MemoryPressure::MODERATE).get();
+  EXPECT_FALSE(storeA->getKey("prefix:storeA").has_value());
+  EXPECT_EQ(0, storeA->getCounters().at("kvstore.num_tombstones"));
+  EXPECT_TRUE(storeB->getKey("prefix:storeA").has_value());
+
+  // tombstone not held by unreachable storeC stays
+  EXPECT_TRUE(storeB->addPeer(
+      "storeC", createPeerSpec("inproc://storeC-unreachable", "", 0)));
+  storeB->getKvStore()->setMemoryPressure(MemoryPressure::SEVERE).get();
+  EXPECT_TRUE(storeB->getKey("prefix:storeA").has_value());
+}
+
+/**
+ * Verify keys of limited flood scope don't travel beyond it, neither by
+ * flooding nor by full-sync, while other keys reach all stores.
+ *
+ * Topology: A -- B -- C, D full-syncs with B last
+ */
+TEST_F(KvStoreTestFixture, FloodScope) {
+  auto kvConf = getTestKvConf();
+  thrift::KvstoreFloodScope oneHop;
+  oneHop.key_prefix_ref() = "fibtime:";
+  oneHop.scope_ref() = thrift::KvstoreFloodScopeType::ONE_HOP;
+  thrift::KvstoreFloodScope subscribers;
+  subscribers.key_prefix_ref() = "alloc:";
+  subscribers.scope_ref() = thrift::KvstoreFloodScopeType::SUBSCRIBERS;
+  subscribers.subscribers_ref() = {"storeC"};
+  kvConf.flood_scopes_ref() = {oneHop, subscribers};
+
+  auto storeA = createKvStore("storeA", kvConf);
+  auto storeB = createKvStore("storeB", kvConf);
+  auto storeC = createKvStore("storeC", kvConf);
+  auto storeD = createKvStore("storeD", kvConf);
+  storeA->run();
+  storeB->run();
+  storeC->run();
+  storeD->run();
+
+  EXPECT_TRUE(storeA->addPeer(storeB->getNodeId(), storeB->getPeerSpec()));
+  EXPECT_TRUE(storeB->addPeer(storeA->getNodeId(), storeA->getPeerSpec()));
+  EXPECT_TRUE(storeB->addPeer(storeC->getNodeId(), storeC->getPeerSpec()));
+  EXPECT_TRUE(storeC->addPeer(storeB->getNodeId(), storeB->getPeerSpec()));
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+  EXPECT_TRUE(storeA->setKey(
+      "fibtime:storeA", createThriftValue(1, "storeA", std::string("a"))));
+  EXPECT_TRUE(storeB->setKey(
+      "alloc:storeB", createThriftValue(1, "storeB", std::string("b"))));
+  EXPECT_TRUE(storeB->setKey(
+      "fibtime:storeB", createThriftValue(1, "storeB", std::string("b"))));
+  EXPECT_TRUE(storeA->setKey(
+      "key:storeA", createThriftValue(1, "storeA", std::string("a"))));
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+  // one hop keys reach direct peers of originator only
+  EXPECT_TRUE(storeB->getKey("fibtime:storeA").has_value());
+  EXPECT_FALSE(storeC->getKey("fibtime:storeA").has_value());
+  EXPECT_TRUE(storeA->getKey("fibtime:storeB").has_value());
+  EXPECT_TRUE(storeC->getKey("fibtime:storeB").has_value());
+
+  // subscribed keys reach subscribed peers of originator only
+  EXPECT_FALSE(storeA->getKey("alloc:storeB").has_value());
+  EXPECT_TRUE(storeC->getKey("alloc:storeB").has_value());
+
+  // other keys reach all stores
+  EXPECT_TRUE(storeC->getKey("key:storeA").has_value());
+
+  // full-sync with B doesn't relay keys out of scope either
+  EXPECT_TRUE(storeD->addPeer(storeB->getNodeId(), storeB->getPeerSpec()));
+  EXPECT_TRUE(storeB->addPeer(storeD->getNodeId(), storeD->getPeerSpec()));
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  EXPECT_TRUE(storeD->getKey("key:storeA").has_value());
+  EXPECT_TRUE(storeD->getKey("fibtime:storeB").has_value());
+  EXPECT_FALSE(storeD->getKey("fibtime:storeA").has_value());
+  EXPECT_FALSE(storeD->getKey("alloc:storeB").has_value());
+}
+
 /* Kvstore tests related to area */
 
 /* Verify flooding is containted within an area. Add a key in one area and
@@ -2799,6 +3121,78 @@ TEST_F(KvStoreTestFixture, KeySyncMultipleArea) {
   evb.loop();
 }
 
+/**
+ * Same as KeySyncMultipleArea with areas of storeB on their own threads.
+ * Updates of both areas are published by storeB, tagged with their area.
+ */
+TEST_F(KvStoreTestFixture, KeySyncMultipleAreaThreads) {
+  thrift::AreaConfig pod, plane;
+  *pod.area_id_ref() = "pod-area";
+  pod.neighbor_regexes_ref()->emplace_back(".*");
+  *plane.area_id_ref() = "plane-area";
+  plane.neighbor_regexes_ref()->emplace_back(".*");
+
+  auto kvConf = getTestKvConf();
+  kvConf.enable_area_threads_ref() = true;
+  auto storeA = createKvStore("storeA", getTestKvConf(), {pod});
+  auto storeB = createKvStore("storeB", kvConf, {pod, plane});
+  auto storeC = createKvStore("storeC", getTestKvConf(), {plane});
+  storeA->run();
+  storeB->run();
+  storeC->run();
+
+  EXPECT_TRUE(
+      storeA->addPeer("storeB", storeB->getPeerSpec(), *pod.area_id_ref()));
+  EXPECT_TRUE(
+      storeB->addPeer("storeA", storeA->getPeerSpec(), *pod.area_id_ref()));
+  EXPECT_TRUE(
+      storeB->addPeer("storeC", storeC->getPeerSpec(), *plane.area_id_ref()));
+  EXPECT_TRUE(
+      storeC->addPeer("storeB", storeB->getPeerSpec(), *plane.area_id_ref()));
+
+  const std::string podKey{"pod-area-0"};
+  const std::string planeKey{"plane-area-0"};
+  auto thriftVal = createThriftValue(
+      1 /* version */,
+      "storeA" /* originatorId */,
+      std::string("value") /* value */,
+      Constants::kTtlInfinity /* ttl */,
+      0 /* ttl version */,
+      0 /* hash */);
+  thriftVal.hash_ref() = generateHash(
+      *thriftVal.version_ref(),
+      *thriftVal.originatorId_ref(),
+      thriftVal.value_ref());
+  EXPECT_TRUE(
+      storeA->setKey(podKey, thriftVal, std::nullopt, *pod.area_id_ref()));
+  *thriftVal.originatorId_ref() = "storeC";
+  thriftVal.hash_ref() = generateHash(
+      *thriftVal.version_ref(),
+      *thriftVal.originatorId_ref(),
+      thriftVal.value_ref());
+  EXPECT_TRUE(
+      storeC->setKey(planeKey, thriftVal, std::nullopt, *plane.area_id_ref()));
+
+  // wait for storeB to publish keys of both areas
+  std::unordered_map<std::string, std::string> keyAreas;
+  while (keyAreas.size() < 2) {
+    auto publication = storeB->recvPublication();
+    for (auto const& [key, _] : *publication.keyVals_ref()) {
+      keyAreas.emplace(key, *publication.area_ref());
+    }
+  }
+  EXPECT_EQ(*pod.area_id_ref(), keyAreas.at(podKey));
+  EXPECT_EQ(*plane.area_id_ref(), keyAreas.at(planeKey));
+
+  EXPECT_TRUE(storeB->getKey(podKey, *pod.area_id_ref()).has_value());
+  EXPECT_FALSE(storeB->getKey(podKey, *plane.area_id_ref()).has_value());
+  EXPECT_TRUE(storeB->getKey(planeKey, *plane.area_id_ref()).has_value());
+  EXPECT_FALSE(storeB->getKey(planeKey, *pod.area_id_ref()).has_value());
+
+  // counters are gathered from threads of both areas
+  EXPECT_EQ(2, storeB->getCounters().at("kvstore.num_keys"));
+}
+
 /**
  * Verify correctness of initial full sync rate limiting.
  *
@@ -9,11 +9,13 @@
 #include <thread>
 
 #include <fbzmq/zmq/Zmq.h>
+#include <folly/futures/Future.h>
 #include <folly/init/Init.h>
 #include <glog/logging.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <openr/common/StatHandle.h>
 #include <openr/config/Config.h>
 #include <openr/config/tests/Utils.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
@@ -55,8 +57,11 @@ class KvStoreThriftTestFixture : public ::testing::Test {
   }
 
   void
-  createKvStore(const std::string& nodeId) {
+  createKvStore(
+      const std::string& nodeId,
+      thrift::KvstoreConfig kvConf = thrift::KvstoreConfig()) {
     auto tConfig = getBasicOpenrConfig(nodeId);
+    *tConfig.kvstore_config_ref() = std::move(kvConf);
     stores_.emplace_back(std::make_shared<KvStoreWrapper>(
         context_,
         std::make_shared<Config>(tConfig),
@@ -399,7 +404,7 @@ TEST_F(SimpleKvStoreThriftTestFixture, FullSyncWithException) {
 //
 TEST_F(KvStoreThriftTestFixture, UnidirectionThriftFullSync) {
   // Reset fb303 data for every test to make sure clean startup
-  facebook::fb303::fbData->resetAllData();
+  resetAllStats();
 
   // spin up 2 kvStore instances and thriftServers
   const std::string node1{"node-1"};
@@ -527,6 +532,62 @@ TEST_F(KvStoreThriftTestFixture, UnidirectionThriftFullSync) {
   EXPECT_EQ(v4->value_ref().value(), value2);
 }
 
+//
+// Test case for full-sync with closest peer first.
+//
+// node1 ---> node2 (rtt 200us)
+//   |
+//   +------> node3 (rtt 100us)
+//
+// With initial_sync_peers set to 1, node1 full-syncs with node3 only and
+// with node2 once that succeeded.
+//
+TEST_F(KvStoreThriftTestFixture, InitialSyncWithClosestPeerFirst) {
+  const std::string node1{"node-1"};
+  const std::string node2{"node-2"};
+  const std::string node3{"node-3"};
+
+  thrift::KvstoreConfig kvConf;
+  kvConf.initial_sync_peers_ref() = 1;
+  createKvStore(node1, kvConf);
+  auto store1 = stores_.back();
+
+  createKvStore(node2);
+  auto store2 = stores_.back();
+  createThriftServer(node2, store2);
+  auto peerSpec2 = createPeerSpec(
+      "inproc://dummy-spec-2", // TODO: remove dummy url once zmq deprecated
+      Constants::kPlatformHost.toString(),
+      thriftServers_.back()->getOpenrCtrlThriftPort());
+  peerSpec2.rttUs_ref() = 200;
+
+  createKvStore(node3);
+  auto store3 = stores_.back();
+  createThriftServer(node3, store3);
+  auto peerSpec3 = createPeerSpec(
+      "inproc://dummy-spec-3", // TODO: remove dummy url once zmq deprecated
+      Constants::kPlatformHost.toString(),
+      thriftServers_.back()->getOpenrCtrlThriftPort());
+  peerSpec3.rttUs_ref() = 100;
+
+  // both peers hold the same key
+  const std::string key{"key"};
+  const auto val = createThriftValue(1 /* version */, node2, "value");
+  EXPECT_TRUE(store2->setKey(key, val));
+  EXPECT_TRUE(store3->setKey(key, val));
+
+  EXPECT_TRUE(store1->addPeers({{node2, peerSpec2}, {node3, peerSpec3}}));
+
+  // closest peer is synced with first
+  EXPECT_EQ(node3, store1->recvSyncEvent().nodeName);
+  EXPECT_EQ(node2, store1->recvSyncEvent().nodeName);
+  EXPECT_TRUE(verifyKvStorePeerState(
+      store1.get(), node2, KvStorePeerState::INITIALIZED));
+  EXPECT_TRUE(verifyKvStorePeerState(
+      store1.get(), node3, KvStorePeerState::INITIALIZED));
+  EXPECT_TRUE(verifyKvStoreKeyVal(store1.get(), key, val));
+}
+
 //
 // Test case for flooding publication over thrift.
 //
@@ -578,6 +639,71 @@ TEST_F(SimpleKvStoreThriftTestFixture, BasicFloodingOverThrift) {
   EXPECT_EQ(3, store2->dumpAll().size());
 }
 
+//
+// Flooding requests to a peer beyond kMaxThriftFloodRequestsInFlight are
+// held back, and only the latest values of held back keys are sent once
+// requests in flight are acked
+//
+TEST_F(SimpleKvStoreThriftTestFixture, FloodWindowCoalescing) {
+  createSimpleThriftTestTopo();
+
+  auto peerSpec1 = createPeerSpec(
+      "inproc://dummy-spec-1", // TODO: remove dummy url once zmq deprecated
+      Constants::kPlatformHost.toString(),
+      thriftServers_.back()->getOpenrCtrlThriftPort());
+  auto peerSpec2 = createPeerSpec(
+      "inproc://dummy-spec-2", // TODO: remove dummy url once zmq deprecated
+      Constants::kPlatformHost.toString(),
+      thriftServers_.front()->getOpenrCtrlThriftPort());
+  auto store1 = stores_.front();
+  auto store2 = stores_.back();
+  EXPECT_TRUE(store1->addPeer(store2->getNodeId(), peerSpec1));
+  EXPECT_TRUE(store2->addPeer(store1->getNodeId(), peerSpec2));
+  EXPECT_TRUE(verifyKvStoreKeyVal(store1.get(), key2, thriftVal2));
+  EXPECT_TRUE(verifyKvStoreKeyVal(store2.get(), key1, thriftVal1));
+
+  auto getCounter = [](std::string const& name) {
+    auto counters = facebook::fb303::fbData->getCounters();
+    return counters.count(name) ? counters.at(name) : 0;
+  };
+  const auto numFloodPub = getCounter("kvstore.thrift.num_flood_pub.count");
+  const auto numCoalescedKeys =
+      getCounter("kvstore.thrift.flood_coalesced_keys.sum");
+
+  // burst of updates of the same keys, queued up without waiting for any
+  const int numUpdates{200};
+  const std::vector<std::string> keys{"key3", "key4"};
+  std::vector<folly::SemiFuture<folly::Unit>> futures;
+  for (int version = 1; version <= numUpdates; ++version) {
+    thrift::KeySetParams params;
+    for (auto const& key : keys) {
+      params.keyVals_ref()->emplace(
+          key,
+          createThriftValue(
+              version, store2->getNodeId(), std::to_string(version)));
+    }
+    futures.emplace_back(store2->getKvStore()->setKvStoreKeyVals(
+        std::move(params), thrift::KvStore_constants::kDefaultArea()));
+  }
+  folly::collectAll(std::move(futures)).get();
+
+  // latest values make it to the peer
+  for (auto const& key : keys) {
+    EXPECT_TRUE(verifyKvStoreKeyVal(
+        store1.get(),
+        key,
+        createThriftValue(
+            numUpdates, store2->getNodeId(), std::to_string(numUpdates))));
+  }
+
+  // held back updates were coalesced instead of flooded one by one
+  EXPECT_GT(
+      getCounter("kvstore.thrift.flood_coalesced_keys.sum"), numCoalescedKeys);
+  EXPECT_LT(
+      getCounter("kvstore.thrift.num_flood_pub.count") - numFloodPub,
+      numUpdates);
+}
+
 //
 // Test case for flooding publication over thrift.
 //
@@ -9,6 +9,9 @@
 #include <thread>
 
 #include <fbzmq/zmq/Zmq.h>
+#include <folly/FileUtil.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/experimental/TestUtil.h>
 #include <folly/init/Init.h>
 #include <glog/logging.h>
 #include <gmock/gmock.h>
@@ -17,6 +20,8 @@
 #include <openr/config/Config.h>
 #include <openr/config/tests/Utils.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
+#include <openr/common/Util.h>
+#include <openr/kvstore/KvStoreSnapshot.h>
 #include <openr/kvstore/KvStoreUtil.h>
 #include <openr/kvstore/KvStoreWrapper.h>
 #include <openr/tests/OpenrThriftServerWrapper.h>
@@ -243,7 +248,9 @@ TEST(KvStore, mergeKeyValuesTest) {
     (*newKvIt->second.ttlVersion_ref())++;
     auto keyVals = KvStore::mergeKeyValues(myStore, newStore);
     EXPECT_EQ(myStore, newStore);
-    EXPECT_EQ(keyVals, newStore);
+    // ttl update is announced without value
+    EXPECT_EQ(
+        keyVals.at(key), createThriftValueWithoutBinaryValue(newKvIt->second));
   }
 
   // invalid ttl update (higher ttlVersion, smaller value)
@@ -268,6 +275,45 @@ TEST(KvStore, mergeKeyValuesTest) {
   }
 }
 
+//
+// validate mergeKeyValues on merge threads yields the same as merging serially
+//
+TEST(KvStore, mergeKeyValuesParallelTest) {
+  folly::CPUThreadPoolExecutor executor(4);
+  std::unordered_map<std::string, thrift::Value> serialStore;
+  std::unordered_map<std::string, thrift::Value> update;
+  for (int i = 0; i < 10000; ++i) {
+    auto key = folly::sformat("key{}", i);
+    serialStore.emplace(
+        key, createThriftValue(5, "node5", "dummyValue", 3600, 0, 0));
+    // mix of newer, older, ttl only and new keys
+    switch (i % 4) {
+    case 0:
+      update.emplace(key, createThriftValue(6, "node5", "newValue", 3600));
+      break;
+    case 1:
+      update.emplace(key, createThriftValue(4, "node5", "oldValue", 3600));
+      break;
+    case 2:
+      update.emplace(
+          key, createThriftValue(5, "node5", std::nullopt, 1000, 1, 0));
+      break;
+    default:
+      update.emplace(
+          folly::sformat("newKey{}", i),
+          createThriftValue(1, "node1", "value", 3600));
+    }
+  }
+  auto parallelStore = serialStore;
+
+  auto serialUpdates = KvStore::mergeKeyValues(serialStore, update);
+  auto parallelUpdates = KvStore::mergeKeyValues(
+      parallelStore, update, std::nullopt, &executor, executor.numThreads());
+  EXPECT_EQ(7500, serialUpdates.size());
+  EXPECT_EQ(serialUpdates, parallelUpdates);
+  EXPECT_EQ(serialStore, parallelStore);
+}
+
 //
 // Test compareValues method
 //
@@ -433,6 +479,120 @@ TEST_F(MultipleKvStoreTestFixture, dumpAllTest) {
   }
 }
 
+/**
+ * Snapshot written for warm restart is read back as long as it is fresh and
+ * decodable.
+ */
+TEST(KvStoreSnapshotTest, WriteAndRead) {
+  folly::test::TemporaryDirectory tmpDir;
+  const auto filePath = (tmpDir.path() / "snapshot.bin").string();
+
+  // No snapshot yet
+  EXPECT_FALSE(readKvStoreSnapshot(filePath, std::chrono::seconds(60)));
+
+  thrift::KvStoreSnapshot snapshot;
+  snapshot.timestampMs_ref() = getUnixTimeStampMs();
+  snapshot.areaKeyVals_ref()["area1"]["adj:node1"] =
+      createThriftValue(1, "node1", std::string("value1"));
+  snapshot.areaKeyVals_ref()["area2"]["prefix:node2"] =
+      createThriftValue(2, "node2", std::string("value2"));
+  ASSERT_TRUE(writeKvStoreSnapshot(filePath, snapshot));
+
+  auto maybeSnapshot = readKvStoreSnapshot(filePath, std::chrono::seconds(60));
+  ASSERT_TRUE(maybeSnapshot.has_value());
+  EXPECT_EQ(snapshot, *maybeSnapshot);
+
+  // Too old
+  snapshot.timestampMs_ref() = getUnixTimeStampMs() - 120 * 1000;
+  ASSERT_TRUE(writeKvStoreSnapshot(filePath, snapshot));
+  EXPECT_FALSE(readKvStoreSnapshot(filePath, std::chrono::seconds(60)));
+
+  // Corrupted
+  ASSERT_TRUE(folly::writeFile(std::string("garbage"), filePath.c_str()));
+  EXPECT_FALSE(readKvStoreSnapshot(filePath, std::chrono::seconds(60)));
+}
+
+/**
+ * Recording of a dump and subsequent publications is read back as written.
+ */
+TEST(KvStoreRecordingTest, WriteAndRead) {
+  folly::test::TemporaryDirectory tmpDir;
+  const auto filePath = (tmpDir.path() / "recording.bin").string();
+
+  // No recording yet
+  EXPECT_FALSE(readKvStoreRecording(filePath));
+
+  thrift::KvStoreRecording recording;
+  recording.dump_ref()->keyVals_ref()["adj:node1"] =
+      createThriftValue(1, "node1", std::string("value1"));
+  thrift::Publication publication;
+  publication.keyVals_ref()["adj:node1"] =
+      createThriftValue(2, "node1", std::string("value2"));
+  publication.expiredKeys_ref()->emplace_back("prefix:node2");
+  recording.publications_ref()->emplace_back(std::move(publication));
+  recording.timestampsMs_ref()->emplace_back(5);
+  ASSERT_TRUE(writeKvStoreRecording(filePath, recording));
+
+  auto maybeRecording = readKvStoreRecording(filePath);
+  ASSERT_TRUE(maybeRecording.has_value());
+  EXPECT_EQ(recording, *maybeRecording);
+
+  // Corrupted
+  ASSERT_TRUE(folly::writeFile(std::string("garbage"), filePath.c_str()));
+  EXPECT_FALSE(readKvStoreRecording(filePath));
+}
+
+/**
+ * Recording streamed by KvStoreRecorder is readable as written so far, also
+ * with an incomplete publication at its end.
+ */
+TEST(KvStoreRecordingTest, Recorder) {
+  folly::test::TemporaryDirectory tmpDir;
+  const auto filePath = (tmpDir.path() / "recording.bin").string();
+
+  thrift::Publication dump;
+  dump.keyVals_ref()["adj:node1"] =
+      createThriftValue(1, "node1", std::string("value1"));
+  thrift::Publication publication1;
+  publication1.keyVals_ref()["adj:node1"] =
+      createThriftValue(2, "node1", std::string("value2"));
+  thrift::Publication publication2;
+  publication2.expiredKeys_ref()->emplace_back("prefix:node2");
+
+  KvStoreRecorder recorder(filePath);
+  ASSERT_TRUE(recorder.writeDump(dump));
+  ASSERT_TRUE(recorder.writePublication(publication1));
+  {
+    auto maybeRecording = readKvStoreRecording(filePath);
+    ASSERT_TRUE(maybeRecording.has_value());
+    EXPECT_EQ(dump, *maybeRecording->dump_ref());
+    ASSERT_EQ(1, maybeRecording->publications_ref()->size());
+    EXPECT_EQ(publication1, maybeRecording->publications_ref()->at(0));
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_TRUE(recorder.writePublication(publication2));
+  {
+    auto maybeRecording = readKvStoreRecording(filePath);
+    ASSERT_TRUE(maybeRecording.has_value());
+    ASSERT_EQ(2, maybeRecording->publications_ref()->size());
+    EXPECT_EQ(publication2, maybeRecording->publications_ref()->at(1));
+    const auto& timestampsMs = *maybeRecording->timestampsMs_ref();
+    ASSERT_EQ(2, timestampsMs.size());
+    EXPECT_LE(0, timestampsMs.at(0));
+    EXPECT_LE(timestampsMs.at(0) + 10, timestampsMs.at(1));
+  }
+
+  // Size of a publication that didn't make it to the file
+  std::string data;
+  ASSERT_TRUE(folly::readFile(filePath.c_str(), data));
+  data.append(std::string("\x00\x00\x01\x00", 4));
+  ASSERT_TRUE(folly::writeFile(data, filePath.c_str()));
+  auto maybeRecording = readKvStoreRecording(filePath);
+  ASSERT_TRUE(maybeRecording.has_value());
+  EXPECT_EQ(2, maybeRecording->publications_ref()->size());
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/kvstore/TtlCountdownQueue.h>
+
+using namespace openr;
+using namespace std::chrono_literals;
+
+namespace {
+TtlCountdownQueueEntry
+createEntry(
+    std::string const& key,
+    TtlCountdownQueue::Clock::time_point expiryTime,
+    int64_t ttlVersion = 0) {
+  TtlCountdownQueueEntry entry;
+  entry.expiryTime = expiryTime;
+  entry.key = key;
+  entry.version = 1;
+  entry.ttlVersion = ttlVersion;
+  entry.originatorId = "node1";
+  return entry;
+}
+} // namespace
+
+TEST(TtlCountdownQueueTest, PushAndRefresh) {
+  TtlCountdownQueue queue;
+  auto const now = TtlCountdownQueue::Clock::now();
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.getNextExpiryTime().has_value());
+
+  queue.push(createEntry("key1", now + 1s));
+  queue.push(createEntry("key2", now + 2s));
+  EXPECT_EQ(2, queue.size());
+  EXPECT_EQ(now + 1s, queue.getNextExpiryTime());
+
+  // refreshing replaces the entry of the key
+  queue.push(createEntry("key1", now + 3s, 1));
+  EXPECT_EQ(2, queue.size());
+  ASSERT_NE(nullptr, queue.find("key1"));
+  EXPECT_EQ(1, queue.find("key1")->ttlVersion);
+  EXPECT_EQ(now + 3s, queue.find("key1")->expiryTime);
+  EXPECT_EQ(now + 2s, queue.getNextExpiryTime());
+
+  EXPECT_TRUE(queue.popExpired(now + 1s).empty());
+  auto expiredEntries = queue.popExpired(now + 2s);
+  ASSERT_EQ(1, expiredEntries.size());
+  EXPECT_EQ("key2", expiredEntries.at(0).key);
+  EXPECT_EQ(nullptr, queue.find("key2"));
+  EXPECT_EQ(now + 3s, queue.getNextExpiryTime());
+
+  // entries already due expire right away
+  queue.push(createEntry("key3", now));
+  EXPECT_EQ(now, queue.getNextExpiryTime());
+  expiredEntries = queue.popExpired(now + 2s);
+  ASSERT_EQ(1, expiredEntries.size());
+  EXPECT_EQ("key3", expiredEntries.at(0).key);
+
+  queue.erase("key1");
+  queue.erase("key1");
+  EXPECT_TRUE(queue.empty());
+  EXPECT_TRUE(queue.popExpired(now + 1h).empty());
+}
+
+TEST(TtlCountdownQueueTest, ExpiryBeyondRevolution) {
+  TtlCountdownQueue queue;
+  auto const now = TtlCountdownQueue::Clock::now();
+  auto const revolution =
+      TtlCountdownQueue::kTick * TtlCountdownQueue::kNumSlots;
+
+  // both entries share a slot
+  queue.push(createEntry("key1", now + revolution + 1s));
+  queue.push(createEntry("key2", now + 1s));
+  EXPECT_EQ(now + 1s, queue.getNextExpiryTime());
+
+  auto expiredEntries = queue.popExpired(now + 1s);
+  ASSERT_EQ(1, expiredEntries.size());
+  EXPECT_EQ("key2", expiredEntries.at(0).key);
+
+  // key1 is beyond the current revolution, check again by then at the latest
+  auto nextExpiryTime = queue.getNextExpiryTime();
+  ASSERT_TRUE(nextExpiryTime.has_value());
+  EXPECT_LE(*nextExpiryTime, now + revolution + 1s);
+  EXPECT_TRUE(queue.popExpired(now + revolution).empty());
+  EXPECT_EQ(now + revolution + 1s, queue.getNextExpiryTime());
+
+  // skipping multiple revolutions expires everything due
+  queue.push(createEntry("key2", now + 2 * revolution));
+  expiredEntries = queue.popExpired(now + 3 * revolution);
+  EXPECT_EQ(2, expiredEntries.size());
+  EXPECT_TRUE(queue.empty());
+}
+
+int
+main(int argc, char* argv[]) {
+  // Parse command line flags
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
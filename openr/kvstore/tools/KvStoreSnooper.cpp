@@ -5,23 +5,124 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <atomic>
 #include <iostream>
+#include <optional>
 
 #include <folly/init/Init.h>
 
 #include <openr/common/OpenrClient.h>
+#include <openr/config/tests/Utils.h>
+#include <openr/decision/Decision.h>
 #include <openr/kvstore/KvStore.h>
+#include <openr/kvstore/KvStoreSnapshot.h>
+#include <openr/kvstore/KvStoreWrapper.h>
 
 DEFINE_string(host, "::1", "Host to connect to");
 DEFINE_int32(port, openr::Constants::kOpenrCtrlPort, "OpenrCtrl server port");
 DEFINE_int32(connect_timeout_ms, 1000, "Connect timeout for client");
 DEFINE_int32(processing_timeout_ms, 5000, "Processing timeout for client");
+DEFINE_string(
+    record_file,
+    "",
+    "Record initial dump and received publications to this file, e.g. to "
+    "replay them with --replay_file or decision_benchmark --replay_file");
+DEFINE_bool(
+    print_publications,
+    true,
+    "Print received publications, disable to only record them on a busy "
+    "network");
+DEFINE_string(
+    replay_file,
+    "",
+    "Instead of connecting to Open/R, replay recording written with "
+    "--record_file into a local KvStore, with Decision computing routes of "
+    "--replay_node on it");
+DEFINE_double(
+    replay_speed,
+    1.0,
+    "Speed up of replay vs. the recorded times, 0 to replay publications back "
+    "to back");
+DEFINE_string(
+    replay_node, "", "Node of the recording whose routes are computed");
+
+namespace {
+
+int
+replay() {
+  CHECK(not FLAGS_replay_node.empty()) << "--replay_node must be set";
+  auto recording = openr::readKvStoreRecording(FLAGS_replay_file);
+  if (not recording.has_value()) {
+    return 1;
+  }
+  LOG(INFO) << "Replaying " << recording->dump_ref()->keyVals_ref()->size()
+            << " entries and " << recording->publications_ref()->size()
+            << " publications at speed " << FLAGS_replay_speed;
+
+  auto config = std::make_shared<openr::Config>(
+      openr::getBasicOpenrConfig(FLAGS_replay_node));
+  fbzmq::Context context;
+  openr::KvStoreWrapper kvStore(context, config);
+  kvStore.run();
+
+  openr::messaging::ReplicateQueue<openr::thrift::RouteDatabaseDelta>
+      staticRoutesUpdateQueue;
+  openr::messaging::ReplicateQueue<openr::DecisionRouteUpdatePtr>
+      routeUpdatesQueue;
+  auto routeUpdatesReader = routeUpdatesQueue.getReader();
+  openr::Decision decision(
+      config,
+      true, /* computeLfaPaths */
+      false, /* bgpDryRun */
+      std::chrono::milliseconds(10),
+      std::chrono::milliseconds(250),
+      kvStore.getReader(),
+      staticRoutesUpdateQueue.getReader(),
+      routeUpdatesQueue);
+  std::thread decisionThread([&decision]() { decision.run(); });
+  decision.waitUntilRunning();
+
+  // consume route updates in place of Fib
+  std::atomic<size_t> numRouteUpdates{0};
+  std::thread routeUpdatesThread([&routeUpdatesReader, &numRouteUpdates]() {
+    while (routeUpdatesReader.get().hasValue()) {
+      ++numRouteUpdates;
+    }
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto numPublications =
+      kvStore.replayRecording(*recording, FLAGS_replay_speed);
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  // let Decision compute routes of the last, debounced publications
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  LOG(INFO) << "Replayed " << numPublications << " publications in "
+            << elapsed.count() << "ms, Decision sent " << numRouteUpdates
+            << " route updates";
+
+  kvStore.closeQueue();
+  staticRoutesUpdateQueue.close();
+  decision.stop();
+  decisionThread.join();
+  routeUpdatesQueue.close();
+  routeUpdatesThread.join();
+  kvStore.stop();
+  return 0;
+}
+
+} // namespace
 
 int
 main(int argc, char** argv) {
   // Initialize all params
   folly::init(&argc, &argv);
 
+  if (not FLAGS_replay_file.empty()) {
+    return replay();
+  }
+
   // Define and start event base
   folly::EventBase evb;
   std::thread evbThread([&evb]() { evb.loopForever(); });
@@ -35,6 +136,11 @@ main(int argc, char** argv) {
           std::chrono::milliseconds(FLAGS_connect_timeout_ms),
           std::chrono::milliseconds(FLAGS_processing_timeout_ms));
   auto response = client->semifuture_subscribeAndGetKvStore().get();
+  std::optional<openr::KvStoreRecorder> recorder;
+  if (not FLAGS_record_file.empty()) {
+    recorder.emplace(FLAGS_record_file);
+    CHECK(recorder->writeDump(response.response));
+  }
   auto& globalKeyVals = *response.response.keyVals_ref();
   LOG(INFO) << "Stream is connected, updates will follow";
   LOG(INFO) << "Received " << globalKeyVals.size()
@@ -45,13 +151,19 @@ main(int argc, char** argv) {
       std::move(response.stream)
           .subscribeExTry(
               folly::Executor::getKeepAliveToken(&evb),
-              [&globalKeyVals](
+              [&globalKeyVals, &recorder](
                   folly::Try<openr::thrift::Publication>&& maybePub) mutable {
                 if (maybePub.hasException()) {
                   LOG(ERROR) << maybePub.exception().what();
                   return;
                 }
                 auto& pub = maybePub.value();
+                if (recorder.has_value()) {
+                  recorder->writePublication(pub);
+                }
+                if (not FLAGS_print_publications) {
+                  return;
+                }
                 // Print expired key-vals
                 for (const auto& key : *pub.expiredKeys_ref()) {
                   std::cout << "Expired Key: " << key << std::endl;
@@ -25,6 +25,7 @@
 
 #include <openr/common/Constants.h>
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/SerializationBuffer.h>
 #include <openr/common/Util.h>
 #include <openr/config/Config.h>
 #include <openr/if/gen-cpp2/LinkMonitor_types.h>
@@ -39,11 +40,17 @@ const std::string kConfigKey{"link-monitor-config"};
 
 /**
  * Transformation function to convert measured rtt (in us) to a metric value
- * to be used. Metric can never be zero.
+ * to be used, rounded up to the next of increasing buckets if any. Metric can
+ * never be zero.
  */
 int32_t
-getRttMetric(int64_t rttUs) {
-  return std::max((int)(rttUs / 100), (int)1);
+getRttMetric(int64_t rttUs, std::vector<int32_t> const& buckets) {
+  const auto metric = std::max((int)(rttUs / 100), (int)1);
+  if (buckets.empty()) {
+    return metric;
+  }
+  auto it = std::lower_bound(buckets.begin(), buckets.end(), metric);
+  return it == buckets.end() ? buckets.back() : *it;
 }
 
 void
@@ -77,7 +84,8 @@ LinkMonitor::LinkMonitor(
     KvStore* kvStore,
     PersistentStore* configStore,
     bool enablePerfMeasurement,
-    messaging::ReplicateQueue<thrift::InterfaceDatabase>& intfUpdatesQueue,
+    messaging::ReplicateQueue<InterfaceDatabaseUpdate>& intfUpdatesQueue,
+    messaging::ReplicateQueue<InterfaceStatusEvent>& intfStatusEventsQueue,
     messaging::ReplicateQueue<thrift::PrefixUpdateRequest>& prefixUpdatesQueue,
     messaging::ReplicateQueue<thrift::PeerUpdateRequest>& peerUpdatesQueue,
     messaging::ReplicateQueue<LogSample>& logSampleQueue,
@@ -95,6 +103,12 @@ LinkMonitor::LinkMonitor(
       prefixForwardingAlgorithm_(
           *config->getConfig().prefix_forwarding_algorithm_ref()),
       useRttMetric_(*config->getLinkMonitorConfig().use_rtt_metric_ref()),
+      enableAdjDbDelta_(
+          *config->getLinkMonitorConfig().enable_adj_db_delta_ref()),
+      rttMetricBuckets_(
+          *config->getLinkMonitorConfig().rtt_metric_buckets_ref()),
+      rttMetricUpdateWindow_(std::chrono::milliseconds(
+          *config->getLinkMonitorConfig().rtt_metric_update_window_ms_ref())),
       linkflapInitBackoff_(std::chrono::milliseconds(
           *config->getLinkMonitorConfig().linkflap_initial_backoff_ms_ref())),
       linkflapMaxBackoff_(std::chrono::milliseconds(
@@ -105,6 +119,7 @@ LinkMonitor::LinkMonitor(
       redistributeItfRegexes_(config->getRedistributeItfRegexes()),
       areas_(config->getAreaIds()),
       interfaceUpdatesQueue_(intfUpdatesQueue),
+      interfaceStatusEventsQueue_(intfStatusEventsQueue),
       prefixUpdatesQueue_(prefixUpdatesQueue),
       peerUpdatesQueue_(peerUpdatesQueue),
       logSampleQueue_(logSampleQueue),
@@ -132,6 +147,10 @@ LinkMonitor::LinkMonitor(
         advertiseAdjacencies();
       });
 
+  // Apply RTT changes collected over update window
+  rttChangeTimer_ = folly::AsyncTimeout::make(
+      *getEvb(), [this]() noexcept { applyRttChanges(); });
+
   // Create throttled interfaces and addresses advertiser
   advertiseIfaceAddrThrottled_ = std::make_unique<AsyncThrottle>(
       getEvb(), Constants::kLinkThrottleTimeout, [this]() noexcept {
@@ -245,13 +264,14 @@ LinkMonitor::LinkMonitor(
         }
       });
 
-  // Schedule periodic timer for InterfaceDb re-sync from Netlink Platform
+  // Timer for InterfaceDb sync from Netlink Platform. Netlink events keep
+  // InterfaceDb up to date, full sync is only needed initially and after
+  // events got lost.
   interfaceDbSyncTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
     auto success = syncInterfaces();
     if (success) {
       VLOG(2) << "InterfaceDb Sync is successful";
       expBackoff_.reportSuccess();
-      interfaceDbSyncTimer_->scheduleTimeout(Constants::kPlatformSyncInterval);
     } else {
       fb303::fbData->addStatValue(
           "link_monitor.thrift.failure.getAllLinks", 1, fb303::SUM);
@@ -283,8 +303,19 @@ LinkMonitor::LinkMonitor(
   fb303::fbData->addStatExportType(
       "link_monitor.advertise_adjacencies", fb303::SUM);
   fb303::fbData->addStatExportType("link_monitor.advertise_links", fb303::SUM);
+  fb303::fbData->addStatExportType(
+      "link_monitor.coalesced_adjacency_events", fb303::SUM);
+  fb303::fbData->addStatExportType(
+      "link_monitor.adjacency_updates", fb303::SUM);
   fb303::fbData->addStatExportType(
       "link_monitor.thrift.failure.getAllLinks", fb303::SUM);
+  fb303::fbData->addStatExportType("link_monitor.interface_syncs", fb303::SUM);
+  fb303::fbData->addStatExportType(
+      "link_monitor.interface_sync_duration_ms", fb303::AVG);
+  fb303::fbData->addStatExportType(
+      "link_monitor.redist_prefixes_advertised", fb303::SUM);
+  fb303::fbData->addStatExportType(
+      "link_monitor.redist_prefixes_withdrawn", fb303::SUM);
 }
 
 void
@@ -325,7 +356,7 @@ LinkMonitor::neighborUpEvent(const thrift::SparkNeighborEvent& event) {
       localIfName /* local ifName neighbor discovered on */,
       toString(neighborAddrV6) /* nextHopV6 */,
       toString(neighborAddrV4) /* nextHopV4 */,
-      useRttMetric_ ? getRttMetric(rttUs) : 1 /* metric */,
+      useRttMetric_ ? getRttMetric(rttUs, rttMetricBuckets_) : 1 /* metric */,
       enableSegmentRouting_ ? *info.label_ref() : 0 /* adjacency-label */,
       false /* overload bit */,
       useRttMetric_ ? rttUs : 0 /* rtt */,
@@ -367,16 +398,23 @@ LinkMonitor::neighborUpEvent(const thrift::SparkNeighborEvent& event) {
   // be overridden by KvStoreClientInternal, thus no need to explicitly remove
   // it 2) does not change: the existing connection to a neighbor is retained
   auto peerSpec = createPeerSpec(repUrl, peerAddr, openrCtrlThriftPort);
+  if (rttUs > 0) {
+    // KvStore full-syncs with closest peers first
+    peerSpec.rttUs_ref() = rttUs;
+  }
   const auto adjId = std::make_pair(remoteNodeName, localIfName);
+  // RTT measured on neighbor up supersedes earlier changes
+  pendingRttChanges_.erase(adjId);
 
   adjacencies_[adjId] = AdjacencyValue(
       peerSpec, std::move(newAdj), false /* isRestarting */, area);
+  markAdjacencyDirty(adjId);
 
   // Advertise KvStore peers immediately
   advertiseKvStorePeers(area, {{remoteNodeName, peerSpec}});
 
   // Advertise new adjancies in a throttled fashion
-  advertiseAdjacenciesThrottled_->operator()();
+  scheduleAdvertiseAdjacencies();
 }
 
 void
@@ -391,10 +429,12 @@ LinkMonitor::neighborDownEvent(const thrift::SparkNeighborEvent& event) {
   fb303::fbData->addStatValue("link_monitor.neighbor_down", 1, fb303::SUM);
 
   const auto adjId = std::make_pair(remoteNodeName, localIfName);
+  pendingRttChanges_.erase(adjId);
   auto adjValueIt = adjacencies_.find(adjId);
   if (adjValueIt != adjacencies_.end()) {
     // remove such adjacencies
     adjacencies_.erase(adjValueIt);
+    markAdjacencyDirty(adjId);
   }
   // advertise both peers and adjacencies
   advertiseKvStorePeers(area);
@@ -428,17 +468,59 @@ LinkMonitor::neighborRttChangeEvent(const thrift::SparkNeighborEvent& event) {
   const auto& remoteNodeName = *info.nodeName_ref();
   const auto& localIfName = *info.localIfName_ref();
   const auto& rttUs = *info.rttUs_ref();
-  int32_t newRttMetric = getRttMetric(rttUs);
 
-  VLOG(1) << "Metric value changed for neighbor " << remoteNodeName
-          << " on interface: " << localIfName << " to " << newRttMetric;
+  VLOG(1) << "RTT changed for neighbor " << remoteNodeName
+          << " on interface: " << localIfName << " to " << rttUs << "us";
+
+  auto adjId = std::make_pair(remoteNodeName, localIfName);
+  if (not adjacencies_.count(adjId)) {
+    return;
+  }
+  const bool isNew =
+      pendingRttChanges_.insert_or_assign(std::move(adjId), rttUs).second;
+  if (not isNew) {
+    // earlier change of neighbor within window is superseded
+    fb303::fbData->addStatValue(
+        "link_monitor.rtt_changes_coalesced", 1, fb303::SUM);
+  }
+  if (rttMetricUpdateWindow_.count() == 0) {
+    applyRttChanges();
+  } else if (not rttChangeTimer_->isScheduled()) {
+    rttChangeTimer_->scheduleTimeout(rttMetricUpdateWindow_);
+  }
+}
 
-  auto it = adjacencies_.find({remoteNodeName, localIfName});
-  if (it != adjacencies_.end()) {
+void
+LinkMonitor::applyRttChanges() {
+  size_t numUpdated = 0;
+  size_t numSuppressed = 0;
+  for (auto const& [adjId, rttUs] : pendingRttChanges_) {
+    auto it = adjacencies_.find(adjId);
+    if (it == adjacencies_.end()) {
+      continue;
+    }
     auto& adj = it->second.adjacency;
+    const auto newRttMetric = getRttMetric(rttUs, rttMetricBuckets_);
+    if (*adj.metric_ref() == newRttMetric) {
+      // RTT alone is not worth re-flooding adjacencies for
+      ++numSuppressed;
+      continue;
+    }
+    VLOG(1) << "Metric value changed for neighbor " << adjId.first
+            << " on interface: " << adjId.second << " to " << newRttMetric;
     adj.metric_ref() = newRttMetric;
     adj.rtt_ref() = rttUs;
-    advertiseAdjacenciesThrottled_->operator()();
+    markAdjacencyDirty(it->first);
+    ++numUpdated;
+  }
+  pendingRttChanges_.clear();
+
+  fb303::fbData->addStatValue(
+      "link_monitor.rtt_metric_updates", numUpdated, fb303::SUM);
+  fb303::fbData->addStatValue(
+      "link_monitor.rtt_metric_updates_suppressed", numSuppressed, fb303::SUM);
+  if (numUpdated) {
+    scheduleAdvertiseAdjacencies();
   }
 }
 
@@ -471,7 +553,8 @@ LinkMonitor::processKvStoreSyncEvent(KvStoreSyncEvent&& event) {
   SYSLOG(INFO) << "Neighbor " << nodeName << " finished Initial Sync "
                << ", area: " << area << ". Promoting Adjacency UP events.";
 
-  advertiseAdjacenciesThrottled_->operator()();
+  markNodeAdjacenciesDirty(nodeName);
+  scheduleAdvertiseAdjacencies();
 }
 
 std::unordered_map<std::string, thrift::PeerSpec>
@@ -522,6 +605,11 @@ LinkMonitor::advertiseKvStorePeers(
     if (newPeers.find(nodeName) == newPeers.end()) {
       toDelPeers.emplace_back(nodeName);
       logPeerEvent("DEL_PEER", nodeName, peer.tPeerSpec);
+
+      // adjacencies of synced peer are no longer advertised
+      if (peer.initialSynced) {
+        markNodeAdjacenciesDirty(nodeName);
+      }
     }
   }
 
@@ -615,10 +703,13 @@ LinkMonitor::advertiseAdjacencies(const std::string& area) {
   LOG(INFO) << "Updating adjacency database in KvStore with "
             << adjDb.adjacencies_ref()->size() << " entries in area: " << area;
 
-  // Persist `adj:node_Id` key into KvStore via KvStoreClientInternal
-  const auto keyName = Constants::kAdjDbMarker.toString() + nodeId_;
-  std::string adjDbStr = fbzmq::util::writeThriftObjStr(adjDb, serializer_);
-  kvStoreClient_->persistKey(keyName, adjDbStr, ttlKeyInKvStore_, area);
+  if (not enableAdjDbDelta_ or
+      not advertiseAdjacencyDatabaseDelta(area, adjDb)) {
+    // Persist `adj:node_Id` key into KvStore via KvStoreClientInternal
+    const auto keyName = Constants::kAdjDbMarker.toString() + nodeId_;
+    kvStoreClient_->persistKey(
+        keyName, serializeCompact(adjDb), ttlKeyInKvStore_, area);
+  }
 
   // Config is most likely to have changed. Update it in `ConfigStore`
   configStore_->storeThriftObj(kConfigKey, state_); // not awaiting on result
@@ -633,6 +724,46 @@ LinkMonitor::advertiseAdjacencies(const std::string& area) {
         "link_monitor.metric." + *adj.otherNodeName_ref(), *adj.metric_ref());
   }
 }
+bool
+LinkMonitor::advertiseAdjacencyDatabaseDelta(
+    const std::string& area, thrift::AdjacencyDatabase& adjDb) {
+  auto it = adjDbSnapshots_.find(area);
+  if (it != adjDbSnapshots_.end()) {
+    auto const& snapshot = it->second;
+    auto delta = createAdjDbDelta(snapshot, adjDb);
+    auto const numChanges = delta.updatedAdjacencies_ref()->size() +
+        delta.removedAdjacencies_ref()->size();
+    // Node attributes are only carried by snapshots. Also take a new
+    // snapshot once the delta grows beyond half of the snapshot.
+    if (*snapshot.isOverloaded_ref() == *adjDb.isOverloaded_ref() and
+        *snapshot.nodeLabel_ref() == *adjDb.nodeLabel_ref() and
+        2 * numChanges <= snapshot.adjacencies_ref()->size()) {
+      delta.baseSnapshotId_ref() = *snapshot.snapshotId_ref();
+
+      // Persist `adjdelta:node_Id` key into KvStore
+      const auto keyName = Constants::kAdjDbDeltaMarker.toString() + nodeId_;
+      kvStoreClient_->persistKey(
+          keyName,
+          serializeCompact(delta),
+          ttlKeyInKvStore_,
+          area);
+      fb303::fbData->addStatValue(
+          "link_monitor.advertise_adjacency_deltas", 1, fb303::SUM);
+      return true;
+    }
+  }
+
+  // Snapshot ids must be unique across restarts and increasing, as stale
+  // deltas of a previous snapshot may still be around
+  int64_t snapshotId = getUnixTimeStampMs();
+  if (it != adjDbSnapshots_.end()) {
+    snapshotId = std::max(snapshotId, *it->second.snapshotId_ref() + 1);
+  }
+  adjDb.snapshotId_ref() = snapshotId;
+  adjDbSnapshots_[area] = adjDb;
+  return false;
+}
+
 void
 LinkMonitor::advertiseAdjacencies() {
   // advertise to all areas. Once area configuration per link is implemented
@@ -658,6 +789,7 @@ LinkMonitor::advertiseIfaceAddr() {
   // Schedule new timeout if needed to advertise UP but UNSTABLE interfaces
   // once their backoff is clear.
   if (retryTime.count() != 0) {
+    retryTime += Constants::kLinkBackoffBatchWindow;
     advertiseIfaceAddrTimer_->scheduleTimeout(retryTime);
     VLOG(2) << "advertiseIfaceAddr timer scheduled in " << retryTime.count()
             << " ms";
@@ -683,8 +815,30 @@ LinkMonitor::advertiseInterfaces() {
     ifDb.interfaces_ref()->emplace(ifName, std::move(interfaceInfo));
   }
 
+  // Compute delta against previously published database. Readers share the
+  // immutable snapshot and only process changed interfaces.
+  InterfaceDatabaseUpdate update;
+  update.snapshot =
+      std::make_shared<const thrift::InterfaceDatabase>(std::move(ifDb));
+  if (advertisedIfDb_) {
+    update.isDelta = true;
+    const auto& oldInterfaces = *advertisedIfDb_->interfaces_ref();
+    for (const auto& [ifName, info] : *update.snapshot->interfaces_ref()) {
+      auto it = oldInterfaces.find(ifName);
+      if (it == oldInterfaces.end() or it->second != info) {
+        update.updatedInterfaces.emplace_back(ifName);
+      }
+    }
+    for (const auto& [ifName, _] : oldInterfaces) {
+      if (not update.snapshot->interfaces_ref()->count(ifName)) {
+        update.removedInterfaces.emplace_back(ifName);
+      }
+    }
+  }
+  advertisedIfDb_ = update.snapshot;
+
   // publish new interface database to other modules (Fib & Spark)
-  interfaceUpdatesQueue_.push(std::move(ifDb));
+  interfaceUpdatesQueue_.push(std::move(update));
 }
 
 void
@@ -692,7 +846,7 @@ LinkMonitor::advertiseRedistAddrs() {
   if (adjHoldTimer_->isScheduled()) {
     return;
   }
-  std::vector<thrift::PrefixEntry> prefixes;
+  std::unordered_map<thrift::IpPrefix, thrift::PrefixEntry> prefixes;
 
   // Add redistribute addresses
   for (auto& [_, interface] : interfaces_) {
@@ -720,39 +874,101 @@ LinkMonitor::advertiseRedistAddrs() {
         metrics.path_preference_ref() = Constants::kDefaultPathPreference;
         metrics.source_preference_ref() = Constants::kDefaultSourcePreference;
       }
-      prefixes.emplace_back(std::move(prefix));
+      auto key = *prefix.prefix_ref();
+      prefixes.insert_or_assign(std::move(key), std::move(prefix));
     }
   }
 
-  LOG_IF(INFO, prefixes.empty()) << "Advertising empty LOOPBACK addresses.";
+  // Sync all LOOPBACK prefixes initially, e.g. to withdraw stale ones persisted
+  // by previous incarnation
+  if (not redistPrefixesSynced_) {
+    LOG_IF(INFO, prefixes.empty()) << "Advertising empty LOOPBACK addresses.";
 
-  // Advertise LOOPBACK prefix via replicate queue
-  thrift::PrefixUpdateRequest request;
-  request.cmd_ref() = thrift::PrefixUpdateCommand::SYNC_PREFIXES_BY_TYPE;
-  request.type_ref() = openr::thrift::PrefixType::LOOPBACK;
-  *request.prefixes_ref() = std::move(prefixes);
+    thrift::PrefixUpdateRequest request;
+    request.cmd_ref() = thrift::PrefixUpdateCommand::SYNC_PREFIXES_BY_TYPE;
+    request.type_ref() = openr::thrift::PrefixType::LOOPBACK;
+    for (const auto& [_, prefix] : prefixes) {
+      request.prefixes_ref()->emplace_back(prefix);
+    }
+    fb303::fbData->addStatValue(
+        "link_monitor.redist_prefixes_advertised",
+        request.prefixes_ref()->size(),
+        fb303::SUM);
+
+    // publish to prefix manager
+    prefixUpdatesQueue_.push(std::move(request));
+    advertisedRedistPrefixes_ = std::move(prefixes);
+    redistPrefixesSynced_ = true;
+    return;
+  }
 
-  // publish to prefix manager
-  prefixUpdatesQueue_.push(std::move(request));
+  // Afterwards only send prefixes which changed since last advertisement
+  thrift::PrefixUpdateRequest withdrawRequest;
+  withdrawRequest.cmd_ref() = thrift::PrefixUpdateCommand::WITHDRAW_PREFIXES;
+  for (const auto& [key, prefix] : advertisedRedistPrefixes_) {
+    if (not prefixes.count(key)) {
+      withdrawRequest.prefixes_ref()->emplace_back(prefix);
+    }
+  }
+
+  thrift::PrefixUpdateRequest addRequest;
+  addRequest.cmd_ref() = thrift::PrefixUpdateCommand::ADD_PREFIXES;
+  for (const auto& [key, prefix] : prefixes) {
+    auto it = advertisedRedistPrefixes_.find(key);
+    if (it == advertisedRedistPrefixes_.end() or it->second != prefix) {
+      addRequest.prefixes_ref()->emplace_back(prefix);
+    }
+  }
+
+  if (not withdrawRequest.prefixes_ref()->empty()) {
+    fb303::fbData->addStatValue(
+        "link_monitor.redist_prefixes_withdrawn",
+        withdrawRequest.prefixes_ref()->size(),
+        fb303::SUM);
+    prefixUpdatesQueue_.push(std::move(withdrawRequest));
+  }
+  if (not addRequest.prefixes_ref()->empty()) {
+    fb303::fbData->addStatValue(
+        "link_monitor.redist_prefixes_advertised",
+        addRequest.prefixes_ref()->size(),
+        fb303::SUM);
+    prefixUpdatesQueue_.push(std::move(addRequest));
+  }
+  advertisedRedistPrefixes_ = std::move(prefixes);
 }
 
 std::chrono::milliseconds
 LinkMonitor::getRetryTimeOnUnstableInterfaces() {
-  std::chrono::milliseconds minRemainMs{0};
-  for (auto& [_, interface] : interfaces_) {
-    if (interface.isActive()) {
-      continue;
-    }
-
-    const auto& curRemainMs = interface.getBackoffDuration();
-    if (curRemainMs.count() > 0) {
-      VLOG(2) << "Interface " << interface.getIfName()
-              << " is in backoff state for " << curRemainMs.count() << "ms";
-      minRemainMs = std::min(linkflapMaxBackoff_, curRemainMs);
+  const auto now = std::chrono::steady_clock::now();
+  while (not unstableInterfaces_.empty()) {
+    const auto& [retryTime, ifName] = unstableInterfaces_.top();
+    auto it = interfaces_.find(ifName);
+    if (it != interfaces_.end() and not it->second.isActive()) {
+      const auto curRemainMs = it->second.getBackoffDuration();
+      // Entry is outdated if backoff got extended since it was added. Allow
+      // for truncation of remaining time to ms.
+      if (curRemainMs.count() > 0 and
+          now + curRemainMs <= retryTime + std::chrono::milliseconds(1)) {
+        VLOG(2) << "Interface " << ifName << " is in backoff state for "
+                << curRemainMs.count() << "ms";
+        return std::min(linkflapMaxBackoff_, curRemainMs);
+      }
     }
+    // interface is gone, stable or has a later entry
+    unstableInterfaces_.pop();
   }
 
-  return minRemainMs;
+  return std::chrono::milliseconds(0);
+}
+
+void
+LinkMonitor::trackInterfaceBackoff(InterfaceEntry& interfaceEntry) {
+  const auto backoffMs = interfaceEntry.getBackoffDuration();
+  if (backoffMs.count() > 0) {
+    unstableInterfaces_.emplace(
+        std::chrono::steady_clock::now() + backoffMs,
+        interfaceEntry.getIfName());
+  }
 }
 
 thrift::AdjacencyDatabase
@@ -765,16 +981,45 @@ LinkMonitor::buildAdjacencyDatabase(const std::string& area) {
   adjDb.nodeLabel_ref() = enableSegmentRouting_ ? *state_.nodeLabel_ref() : 0;
   *adjDb.area_ref() = area;
 
+  updateAdvertisedAdjacencies();
   for (const auto& [adjKey, adjValue] : adjacencies_) {
     // ignore unrelated area
     if (adjValue.area != area) {
       continue;
     }
+    auto it = advertisedAdjacencies_.find(adjKey);
+    if (it != advertisedAdjacencies_.end()) {
+      adjDb.adjacencies_ref()->emplace_back(it->second);
+    }
+  }
+
+  // Add perf information if enabled
+  if (enablePerfMeasurement_) {
+    thrift::PerfEvents perfEvents;
+    addPerfEvent(perfEvents, nodeId_, "ADJ_DB_UPDATED");
+    adjDb.perfEvents_ref() = perfEvents;
+  } else {
+    DCHECK(!adjDb.perfEvents_ref().has_value());
+  }
+
+  return adjDb;
+}
+
+void
+LinkMonitor::updateAdvertisedAdjacencies() {
+  for (const auto& adjKey : dirtyAdjacencies_) {
+    advertisedAdjacencies_.erase(adjKey);
+
+    auto adjValueIt = adjacencies_.find(adjKey);
+    if (adjValueIt == adjacencies_.end()) {
+      continue;
+    }
+    const auto& adjValue = adjValueIt->second;
 
     // ignore adjs that are waiting first KvStore full sync
     bool waitingInitialSync{true};
 
-    const auto& areaPeers = peers_.find(area);
+    const auto& areaPeers = peers_.find(adjValue.area);
     if (areaPeers != peers_.end()) {
       const auto& peerVal = areaPeers->second.find(adjKey.first);
       // set waitingInitialSync false if peer has reached initial sync state
@@ -807,19 +1052,45 @@ LinkMonitor::buildAdjacencyDatabase(const std::string& area) {
     adj.metric_ref() = folly::get_default(
         *state_.adjMetricOverrides_ref(), tAdjKey, *adj.metric_ref());
 
-    adjDb.adjacencies_ref()->emplace_back(std::move(adj));
+    advertisedAdjacencies_.emplace(adjKey, std::move(adj));
   }
 
-  // Add perf information if enabled
-  if (enablePerfMeasurement_) {
-    thrift::PerfEvents perfEvents;
-    addPerfEvent(perfEvents, nodeId_, "ADJ_DB_UPDATED");
-    adjDb.perfEvents_ref() = perfEvents;
-  } else {
-    DCHECK(!adjDb.perfEvents_ref().has_value());
+  fb303::fbData->addStatValue(
+      "link_monitor.adjacency_updates", dirtyAdjacencies_.size(), fb303::SUM);
+  dirtyAdjacencies_.clear();
+}
+
+void
+LinkMonitor::markAdjacencyDirty(const AdjacencyKey& adjKey) {
+  dirtyAdjacencies_.emplace(adjKey);
+}
+
+void
+LinkMonitor::markNodeAdjacenciesDirty(const std::string& nodeName) {
+  for (const auto& [adjKey, _] : adjacencies_) {
+    if (adjKey.first == nodeName) {
+      dirtyAdjacencies_.emplace(adjKey);
+    }
   }
+}
 
-  return adjDb;
+void
+LinkMonitor::markInterfaceAdjacenciesDirty(const std::string& ifName) {
+  for (const auto& [adjKey, _] : adjacencies_) {
+    if (adjKey.second == ifName) {
+      dirtyAdjacencies_.emplace(adjKey);
+    }
+  }
+}
+
+void
+LinkMonitor::scheduleAdvertiseAdjacencies() {
+  if (advertiseAdjacenciesThrottled_->isActive()) {
+    // advertised along with earlier events still pending
+    fb303::fbData->addStatValue(
+        "link_monitor.coalesced_adjacency_events", 1, fb303::SUM);
+  }
+  advertiseAdjacenciesThrottled_->operator()();
 }
 
 InterfaceEntry* FOLLY_NULLABLE
@@ -855,6 +1126,7 @@ LinkMonitor::syncInterfaces() {
   VLOG(1) << "Syncing Interface DB from Netlink Platform";
 
   // Retrieve latest link snapshot from NetlinkProtocolSocket
+  auto const startTime = std::chrono::steady_clock::now();
   std::vector<LinkEntry> links;
   try {
     links = getAllLinks().get();
@@ -877,39 +1149,60 @@ LinkMonitor::syncInterfaces() {
       continue;
     }
 
-    const std::unordered_set<folly::CIDRNetwork> oldNetworks =
-        interfaceEntry->getNetworks(); // NOTE: Copy intended
-    std::unordered_set<folly::CIDRNetwork> newNetworks;
-    for (const auto& network : link.networks) {
-      newNetworks.emplace(network);
-    }
+    const std::unordered_set<folly::CIDRNetwork> newNetworks(
+        link.networks.begin(), link.networks.end());
 
     // Update link attributes
     const bool wasUp = interfaceEntry->isUp();
     interfaceEntry->updateAttrs(link.ifIndex, link.isUp, link.weight);
+    trackInterfaceBackoff(*interfaceEntry);
     logLinkEvent(
         interfaceEntry->getIfName(),
         wasUp,
         interfaceEntry->isUp(),
         interfaceEntry->getBackoffDuration());
 
-    // Remove old addresses if they are not in new
-    for (auto const& oldNetwork : oldNetworks) {
+    // Remove old addresses if they are not in new. Collect them first, as
+    // updateAddr() modifies the networks of entry.
+    std::vector<folly::CIDRNetwork> removedNetworks;
+    for (auto const& oldNetwork : interfaceEntry->getNetworks()) {
       if (newNetworks.count(oldNetwork) == 0) {
-        interfaceEntry->updateAddr(oldNetwork, false);
+        removedNetworks.emplace_back(oldNetwork);
       }
     }
+    for (auto const& removedNetwork : removedNetworks) {
+      interfaceEntry->updateAddr(removedNetwork, false);
+    }
 
     // Add new addresses if they are not in old
     for (auto const& newNetwork : newNetworks) {
-      if (oldNetworks.count(newNetwork) == 0) {
+      if (interfaceEntry->getNetworks().count(newNetwork) == 0) {
         interfaceEntry->updateAddr(newNetwork, true);
       }
     }
   }
+
+  auto const durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  LOG(INFO) << "Synced " << links.size() << " links from Netlink Platform in "
+            << durationMs.count() << "ms";
+  fb303::fbData->addStatValue("link_monitor.interface_syncs", 1, fb303::SUM);
+  fb303::fbData->addStatValue(
+      "link_monitor.interface_sync_duration_ms",
+      durationMs.count(),
+      fb303::AVG);
   return true;
 }
 
+void
+LinkMonitor::scheduleInterfaceDbSync() {
+  // pending sync, e.g. retry of failed one, will pick up latest state anyway
+  if (interfaceDbSyncTimer_->isScheduled()) {
+    return;
+  }
+  interfaceDbSyncTimer_->scheduleTimeout(std::chrono::milliseconds(0));
+}
+
 void
 LinkMonitor::processNetlinkEvent(fbnl::NetlinkEvent&& event) {
   if (auto* link = std::get_if<fbnl::Link>(&event)) {
@@ -927,7 +1220,19 @@ LinkMonitor::processNetlinkEvent(fbnl::NetlinkEvent&& event) {
     auto interfaceEntry = getOrCreateInterfaceEntry(ifName);
     if (interfaceEntry) {
       const bool wasUp = interfaceEntry->isUp();
+      const bool wasActive = interfaceEntry->isActive();
       interfaceEntry->updateAttrs(ifIndex, isUp, Constants::kDefaultAdjWeight);
+      trackInterfaceBackoff(*interfaceEntry);
+
+      // Let Fib prune nexthops right away instead of waiting for the
+      // throttled interface database
+      const bool isActive = interfaceEntry->isActive();
+      if (wasActive != isActive and
+          checkIncludeExcludeRegex(
+              ifName, includeItfRegexes_, excludeItfRegexes_)) {
+        interfaceStatusEventsQueue_.push(
+            InterfaceStatusEvent{ifName, isActive});
+      }
       logLinkEvent(
           interfaceEntry->getIfName(),
           wasUp,
@@ -944,7 +1249,10 @@ LinkMonitor::processNetlinkEvent(fbnl::NetlinkEvent&& event) {
     // Check for interface name
     auto it = ifIndexToName_.find(ifIndex);
     if (it == ifIndexToName_.end()) {
-      LOG(ERROR) << "Address event for unknown iface index: " << ifIndex;
+      // link event got lost or InterfaceDb isn't synced yet
+      LOG(ERROR) << "Address event for unknown iface index: " << ifIndex
+                 << ". Re-syncing InterfaceDb.";
+      scheduleInterfaceDbSync();
       return;
     }
 
@@ -953,6 +1261,9 @@ LinkMonitor::processNetlinkEvent(fbnl::NetlinkEvent&& event) {
     if (interfaceEntry) {
       interfaceEntry->updateAddr(prefix.value(), isValid);
     }
+  } else if (std::holds_alternative<fbnl::NetlinkEventsLost>(event)) {
+    LOG(WARNING) << "Netlink events got lost. Re-syncing InterfaceDb.";
+    scheduleInterfaceDbSync();
   }
 }
 
@@ -1065,7 +1376,8 @@ LinkMonitor::setInterfaceOverload(
       state_.overloadedLinks_ref()->erase(interfaceName);
       SYSLOG(INFO) << "Unsetting overload bit for interface " << interfaceName;
     }
-    advertiseAdjacenciesThrottled_->operator()();
+    markInterfaceAdjacenciesDirty(interfaceName);
+    scheduleAdvertiseAdjacencies();
     p.setValue();
   });
   return sf;
@@ -1117,7 +1429,8 @@ LinkMonitor::setLinkMetric(
           SYSLOG(INFO) << "Removing metric override for interface "
                        << interfaceName;
         }
-        advertiseAdjacenciesThrottled_->operator()();
+        markInterfaceAdjacenciesDirty(interfaceName);
+        scheduleAdvertiseAdjacencies();
         p.setValue();
       });
   return sf;
@@ -1177,7 +1490,8 @@ LinkMonitor::setAdjacencyMetric(
       SYSLOG(INFO) << "Removing metric override for adjacency: [" << adjNodeName
                    << ":" << interfaceName << "]";
     }
-    advertiseAdjacenciesThrottled_->operator()();
+    markAdjacencyDirty(std::make_pair(adjNodeName, interfaceName));
+    scheduleAdvertiseAdjacencies();
     p.setValue();
   });
   return sf;
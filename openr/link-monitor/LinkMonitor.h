@@ -9,7 +9,10 @@
 
 #include <chrono>
 #include <memory>
+#include <queue>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include <fbzmq/zmq/Zmq.h>
@@ -27,7 +30,9 @@
 
 #include <openr/allocators/RangeAllocator.h>
 #include <openr/common/AsyncThrottle.h>
+#include <openr/common/NetworkUtil.h>
 #include <openr/common/OpenrEventBase.h>
+#include <openr/common/Types.h>
 #include <openr/config-store/PersistentStore.h>
 #include <openr/if/gen-cpp2/Fib_types.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
@@ -94,7 +99,8 @@ class LinkMonitor final : public OpenrEventBase {
       // enable convergence performance measurement for Adjacencies update
       bool enablePerfMeasurement,
       // producer queue
-      messaging::ReplicateQueue<thrift::InterfaceDatabase>& intfUpdatesQueue,
+      messaging::ReplicateQueue<InterfaceDatabaseUpdate>& intfUpdatesQueue,
+      messaging::ReplicateQueue<InterfaceStatusEvent>& intfStatusEventsQueue,
       messaging::ReplicateQueue<thrift::PrefixUpdateRequest>& prefixUpdatesQ,
       messaging::ReplicateQueue<thrift::PeerUpdateRequest>& peerUpdatesQueue,
       messaging::ReplicateQueue<LogSample>& logSampleQueue,
@@ -176,6 +182,10 @@ class LinkMonitor final : public OpenrEventBase {
   void neighborDownEvent(const thrift::SparkNeighborEvent& event);
   void neighborRttChangeEvent(const thrift::SparkNeighborEvent& event);
 
+  // update metrics of adjacencies from RTT changes collected in
+  // pendingRttChanges_, unless their bucket stays the same
+  void applyRttChanges();
+
   /*
    * [KvStore] initial sync event
    */
@@ -188,16 +198,23 @@ class LinkMonitor final : public OpenrEventBase {
   // process LINK/ADDR event updates from platform
   void processNetlinkEvent(fbnl::NetlinkEvent&& event);
 
-  // Used for initial interface discovery and periodic sync with system handler
-  // return true if sync is successful
+  // Used for initial interface discovery and re-sync with system handler
+  // after netlink events got lost, return true if sync is successful
   bool syncInterfaces();
 
+  // Schedule syncInterfaces() unless one is pending already
+  void scheduleInterfaceDbSync();
+
   // Get or create InterfaceEntry object.
   // Returns nullptr if ifName doesn't qualify regex match
   // used in syncInterfaces() and LINK/ADDRESS EVENT
   InterfaceEntry* FOLLY_NULLABLE
   getOrCreateInterfaceEntry(const std::string& ifName);
 
+  // Track interface in unstableInterfaces_ if it is backed off, to be called
+  // whenever its state changed
+  void trackInterfaceBackoff(InterfaceEntry& interfaceEntry);
+
   // call advertiseInterfaces() and advertiseRedistAddrs()
   // throttle updates if there's any unstable interface by
   // getRetryTimeOnUnstableInterfaces() time
@@ -251,6 +268,9 @@ class LinkMonitor final : public OpenrEventBase {
    * Called in
    * - adjHoldTimer_ during initial start
    * - and advertiseIfaceAddr() upon interface changes
+   *
+   * First call syncs all of them, later ones only advertise and withdraw the
+   * prefixes changed since.
    */
   void advertiseRedistAddrs();
 
@@ -259,7 +279,8 @@ class LinkMonitor final : public OpenrEventBase {
    */
 
   // get next try time, which should be the minimum remaining time among
-  // all unstable (getTimeRemainingUntilRetry() > 0) interfaces.
+  // all unstable (getTimeRemainingUntilRetry() > 0) interfaces, looked up
+  // in unstableInterfaces_.
   // return 0 if no more unstable interface
   std::chrono::milliseconds getRetryTimeOnUnstableInterfaces();
 
@@ -267,6 +288,25 @@ class LinkMonitor final : public OpenrEventBase {
   thrift::AdjacencyDatabase buildAdjacencyDatabase(
       const std::string& area = thrift::KvStore_constants::kDefaultArea());
 
+  // Recompute dirty entries of advertisedAdjacencies_
+  void updateAdvertisedAdjacencies();
+
+  // Mark adjacencies to be recomputed before next advertisement, after
+  // changing them or state they depend on
+  void markAdjacencyDirty(const AdjacencyKey& adjKey);
+  void markNodeAdjacenciesDirty(const std::string& nodeName);
+  void markInterfaceAdjacenciesDirty(const std::string& ifName);
+
+  // Advertise adjacencies throttled, counting events coalesced with pending
+  // advertisement
+  void scheduleAdvertiseAdjacencies();
+
+  // Advertise changes of adjDb against the last snapshot of the area as
+  // delta. Returns false if a new snapshot needs to be advertised instead, in
+  // which case adjDb becomes the new snapshot.
+  bool advertiseAdjacencyDatabaseDelta(
+      const std::string& area, thrift::AdjacencyDatabase& adjDb);
+
   // submit events to monitor
   void logNeighborEvent(thrift::SparkNeighborEvent const& event);
 
@@ -296,6 +336,12 @@ class LinkMonitor final : public OpenrEventBase {
   thrift::PrefixForwardingAlgorithm prefixForwardingAlgorithm_;
   // Use spark measured RTT to neighbor as link metric
   bool useRttMetric_{false};
+  // Advertise adjacency database changes as deltas against snapshots
+  bool enableAdjDbDelta_{false};
+  // buckets RTT metrics are rounded up to, see LinkMonitorConfig
+  const std::vector<int32_t> rttMetricBuckets_;
+  // RTT changes are collected over this window and applied together
+  const std::chrono::milliseconds rttMetricUpdateWindow_{0};
   // link flap back offs
   std::chrono::milliseconds linkflapInitBackoff_;
   std::chrono::milliseconds linkflapMaxBackoff_;
@@ -320,7 +366,11 @@ class LinkMonitor final : public OpenrEventBase {
   thrift::LinkMonitorState state_;
 
   // Queue to publish interface updates to fib/spark
-  messaging::ReplicateQueue<thrift::InterfaceDatabase>& interfaceUpdatesQueue_;
+  messaging::ReplicateQueue<InterfaceDatabaseUpdate>& interfaceUpdatesQueue_;
+
+  // Queue to publish interface status changes to fib ahead of the interface
+  // database
+  messaging::ReplicateQueue<InterfaceStatusEvent>& interfaceStatusEventsQueue_;
 
   // Queue to publish prefix updates to PrefixManager
   messaging::ReplicateQueue<thrift::PrefixUpdateRequest>& prefixUpdatesQueue_;
@@ -331,15 +381,22 @@ class LinkMonitor final : public OpenrEventBase {
   // Queue to publish the event log
   messaging::ReplicateQueue<LogSample>& logSampleQueue_;
 
-  // used for communicating over thrift/zmq sockets
-  apache::thrift::CompactSerializer serializer_;
-
   // currently active adjacencies
   // an adjacency is uniquely identified by interface and remote node
   // there can be multiple interfaces to a remote node, but at most 1 interface
   // (we use the "min" interface) for tcp connection
   std::unordered_map<AdjacencyKey, AdjacencyValue> adjacencies_;
 
+  // Adjacencies as advertised, i.e. of peers which finished initial KvStore
+  // sync and with overrides applied. Only dirty ones get recomputed.
+  std::unordered_map<AdjacencyKey, thrift::Adjacency> advertisedAdjacencies_;
+  std::unordered_set<AdjacencyKey> dirtyAdjacencies_;
+
+  // Last advertised adjacency database snapshot per area, when deltas are
+  // enabled
+  std::unordered_map<std::string /* area */, thrift::AdjacencyDatabase>
+      adjDbSnapshots_;
+
   // Previously announced KvStore peers
   std::unordered_map<
       std::string /* area */,
@@ -354,14 +411,39 @@ class LinkMonitor final : public OpenrEventBase {
   // on address events
   std::unordered_map<int64_t, std::string> ifIndexToName_;
 
+  // Last interface database published over interfaceUpdatesQueue_. Next one
+  // is published with delta against it.
+  std::shared_ptr<const thrift::InterfaceDatabase> advertisedIfDb_;
+
+  // Redistributed interface prefixes as last sent to PrefixManager
+  std::unordered_map<thrift::IpPrefix, thrift::PrefixEntry>
+      advertisedRedistPrefixes_;
+  bool redistPrefixesSynced_{false};
+
   // Throttled versions of "advertise<>" functions. It batches
   // up multiple calls and send them in one go!
   std::unique_ptr<AsyncThrottle> advertiseAdjacenciesThrottled_;
   std::unique_ptr<AsyncThrottle> advertiseIfaceAddrThrottled_;
 
+  // latest RTT of neighbors changed within current update window, applied
+  // when rttChangeTimer_ fires
+  std::unordered_map<AdjacencyKey, int64_t> pendingRttChanges_;
+  std::unique_ptr<folly::AsyncTimeout> rttChangeTimer_;
+
   // Timer for processing interfaces which are in backoff states
   std::unique_ptr<folly::AsyncTimeout> advertiseIfaceAddrTimer_;
 
+  // Min-heap of <retry time, ifName> of interfaces in backoff state, to find
+  // the next one to become stable without scanning all interfaces. Entries
+  // are added whenever backoff changes, outdated ones are dropped lazily.
+  using UnstableInterface =
+      std::pair<std::chrono::steady_clock::time_point, std::string>;
+  std::priority_queue<
+      UnstableInterface,
+      std::vector<UnstableInterface>,
+      std::greater<UnstableInterface>>
+      unstableInterfaces_;
+
   // Timer for resyncing InterfaceDb from netlink
   std::unique_ptr<folly::AsyncTimeout> interfaceDbSyncTimer_;
   ExponentialBackoff<std::chrono::milliseconds> expBackoff_;
@@ -6,8 +6,10 @@
  */
 
 #include <chrono>
+#include <set>
 #include <thread>
 
+#include <fb303/ServiceData.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/Format.h>
 #include <folly/init/Init.h>
@@ -239,6 +241,7 @@ class LinkMonitorTestFixture : public ::testing::Test {
     LOG(INFO) << "LinkMonitor test/basic operations is done";
 
     interfaceUpdatesQueue.close();
+    interfaceStatusEventsQueue.close();
     peerUpdatesQueue.close();
     neighborUpdatesQueue.close();
     kvStoreSyncEventsQueue.close();
@@ -308,9 +311,14 @@ class LinkMonitorTestFixture : public ::testing::Test {
     *lmConf.include_interface_regexes_ref() = {kTestVethNamePrefix + ".*",
                                                "iface.*"};
     *lmConf.redistribute_interface_regexes_ref() = {"loopback"};
+    updateLinkMonitorConfig(lmConf);
     return tConfig;
   }
 
+  // hook for fixtures testing non-default link monitor settings
+  virtual void
+  updateLinkMonitorConfig(thrift::LinkMonitorConfig& /* lmConf */) {}
+
   void
   createKvStore(std::shared_ptr<Config> config) {
     kvStoreWrapper = std::make_unique<KvStoreWrapper>(
@@ -330,6 +338,7 @@ class LinkMonitorTestFixture : public ::testing::Test {
         configStore.get(),
         false /* enable perf measurement */,
         interfaceUpdatesQueue,
+        interfaceStatusEventsQueue,
         prefixUpdatesQueue,
         peerUpdatesQueue,
         logSampleQueue,
@@ -355,7 +364,8 @@ class LinkMonitorTestFixture : public ::testing::Test {
   recvAndReplyIfUpdate() {
     auto ifDb = interfaceUpdatesReader.get();
     ASSERT_TRUE(ifDb.hasValue());
-    sparkIfDb = std::move(*ifDb.value().interfaces_ref());
+    lastIfUpdate = std::move(ifDb).value();
+    sparkIfDb = *lastIfUpdate.snapshot->interfaces_ref();
     LOG(INFO) << "----------- Interface Updates ----------";
     for (const auto& kv : sparkIfDb) {
       LOG(INFO) << "  Name=" << kv.first << ", Status=" << kv.second.isUp
@@ -558,14 +568,16 @@ class LinkMonitorTestFixture : public ::testing::Test {
   folly::EventBase nlEvb_;
   std::unique_ptr<fbnl::MockNetlinkProtocolSocket> nlSock{nullptr};
 
-  messaging::ReplicateQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue;
+  messaging::ReplicateQueue<InterfaceDatabaseUpdate> interfaceUpdatesQueue;
+  messaging::ReplicateQueue<InterfaceStatusEvent> interfaceStatusEventsQueue;
   messaging::ReplicateQueue<thrift::PeerUpdateRequest> peerUpdatesQueue;
   messaging::ReplicateQueue<thrift::SparkNeighborEvent> neighborUpdatesQueue;
   messaging::ReplicateQueue<KvStoreSyncEvent> kvStoreSyncEventsQueue;
   messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue;
-  messaging::ReplicateQueue<DecisionRouteUpdate> routeUpdatesQueue;
-  messaging::RQueue<thrift::InterfaceDatabase> interfaceUpdatesReader{
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue;
+  messaging::RQueue<InterfaceDatabaseUpdate> interfaceUpdatesReader{
       interfaceUpdatesQueue.getReader()};
+  InterfaceDatabaseUpdate lastIfUpdate;
   messaging::ReplicateQueue<openr::LogSample> logSampleQueue;
 
   std::unique_ptr<PersistentStore> configStore;
@@ -1024,6 +1036,13 @@ TEST_F(LinkMonitorTestFixture, Throttle) {
     }
   }
 
+  const std::string counter{"link_monitor.coalesced_adjacency_events.sum"};
+  auto getCoalescedEvents = [&counter]() {
+    auto counters = facebook::fb303::fbData->getCounters();
+    return counters.count(counter) ? counters.at(counter) : 0;
+  };
+  const auto coalescedEvents = getCoalescedEvents();
+
   // neighbor up on nb2 and nb3
   {
     auto neighborEvent = createSparkNeighborEvent(
@@ -1053,6 +1072,178 @@ TEST_F(LinkMonitorTestFixture, Throttle) {
   }
 
   checkNextAdjPub("adj:node-1");
+
+  // at least nb3 up joined the pending advertisement of nb2 up
+  EXPECT_LE(coalescedEvents + 1, getCoalescedEvents());
+}
+
+class LinkMonitorRttMetricFixture : public LinkMonitorTestFixture {
+ protected:
+  void
+  updateLinkMonitorConfig(thrift::LinkMonitorConfig& lmConf) override {
+    lmConf.use_rtt_metric_ref() = true;
+    lmConf.rtt_metric_buckets_ref() = {10, 50};
+    lmConf.rtt_metric_update_window_ms_ref() = 200;
+  }
+};
+
+// RTT metrics are quantized into buckets, and RTT changes within a window
+// are applied in one adjacency update
+TEST_F(LinkMonitorRttMetricFixture, QuantizeAndBatch) {
+  SetUp({openr::thrift::KvStore_constants::kDefaultArea()});
+
+  auto getCounter = [](std::string const& counter) {
+    auto counters = facebook::fb303::fbData->getCounters();
+    return counters.count(counter) ? counters.at(counter) : 0;
+  };
+  auto sendRttChange = [&](int64_t rttUs) {
+    auto nb = nb2;
+    nb.rttUs_ref() = rttUs;
+    neighborUpdatesQueue.push(createSparkNeighborEvent(
+        thrift::SparkNeighborEventType::NEIGHBOR_RTT_CHANGE, nb));
+  };
+  auto expectAdj = [&](int32_t metric, int64_t rttUs) {
+    auto adj = adj_2_1;
+    adj.metric_ref() = metric;
+    adj.rtt_ref() = rttUs;
+    expectedAdjDbs.push(createAdjDatabase("node-1", {adj}, kNodeLabel));
+  };
+  const auto suppressed =
+      getCounter("link_monitor.rtt_metric_updates_suppressed.sum");
+  const auto coalesced = getCounter("link_monitor.rtt_changes_coalesced.sum");
+
+  // rtt of 100us is metric 1, rounded up to bucket 10
+  neighborUpdatesQueue.push(createSparkNeighborEvent(
+      thrift::SparkNeighborEventType::NEIGHBOR_UP, nb2));
+  kvStoreSyncEventsQueue.push(KvStoreSyncEvent(
+      *nb2.nodeName_ref(), openr::thrift::KvStore_constants::kDefaultArea()));
+  expectAdj(10, 100);
+  checkNextAdjPub("adj:node-1");
+
+  // same bucket, no adjacency update
+  sendRttChange(200);
+  sendRttChange(900);
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  EXPECT_EQ(
+      suppressed + 1,
+      getCounter("link_monitor.rtt_metric_updates_suppressed.sum"));
+  EXPECT_EQ(
+      coalesced + 1, getCounter("link_monitor.rtt_changes_coalesced.sum"));
+
+  // only the latest rtt of window counts, metric beyond last bucket is capped
+  sendRttChange(3000);
+  sendRttChange(9000);
+  expectAdj(50, 9000);
+  checkNextAdjPub("adj:node-1");
+  EXPECT_EQ(
+      coalesced + 2, getCounter("link_monitor.rtt_changes_coalesced.sum"));
+}
+
+class LinkMonitorAdjDbDeltaFixture : public LinkMonitorTestFixture {
+ protected:
+  void
+  updateLinkMonitorConfig(thrift::LinkMonitorConfig& lmConf) override {
+    lmConf.enable_adj_db_delta_ref() = true;
+  }
+
+  // Receive the next advertisement of node-1, a snapshot or a delta against
+  // the last snapshot received. Returns its key, the adjacency database it
+  // amounts to is kept in adjDb
+  std::string
+  recvAdjAdvertisement() {
+    while (true) {
+      auto pub = kvStoreWrapper->recvPublication();
+      for (auto const& [key, val] : *pub.keyVals_ref()) {
+        if (not val.value_ref().has_value()) {
+          continue;
+        }
+        if (key == "adj:node-1") {
+          snapshot = fbzmq::util::readThriftObjStr<thrift::AdjacencyDatabase>(
+              *val.value_ref(), serializer);
+          EXPECT_TRUE(snapshot.snapshotId_ref().has_value());
+          adjDb = snapshot;
+          return key;
+        }
+        if (key == "adjdelta:node-1") {
+          auto delta =
+              fbzmq::util::readThriftObjStr<thrift::AdjacencyDatabaseDelta>(
+                  *val.value_ref(), serializer);
+          EXPECT_EQ(*snapshot.snapshotId_ref(), *delta.baseSnapshotId_ref());
+          adjDb = applyAdjDbDelta(snapshot, delta);
+          return key;
+        }
+      }
+    }
+  }
+
+  // otherNodeName@ifName of adjacencies in adjDb
+  std::set<std::string>
+  getAdjNames() const {
+    std::set<std::string> names;
+    for (auto const& adj : *adjDb.adjacencies_ref()) {
+      names.emplace(
+          folly::sformat("{}@{}", *adj.otherNodeName_ref(), *adj.ifName_ref()));
+    }
+    return names;
+  }
+
+  void
+  bringUp(thrift::SparkNeighbor nb, std::string const& ifName, int32_t label) {
+    nb.localIfName_ref() = ifName;
+    nb.label_ref() = label;
+    neighborUpdatesQueue.push(createSparkNeighborEvent(
+        thrift::SparkNeighborEventType::NEIGHBOR_UP, nb));
+  }
+
+  thrift::AdjacencyDatabase snapshot;
+  thrift::AdjacencyDatabase adjDb;
+};
+
+// Adjacency changes are advertised as deltas against the last snapshot until
+// they outgrow half of it, or node attributes change
+TEST_F(LinkMonitorAdjDbDeltaFixture, SnapshotRollover) {
+  SetUp({openr::thrift::KvStore_constants::kDefaultArea()});
+  using Names = std::set<std::string>;
+
+  // first adjacencies go out as snapshots, skip the empty one advertised
+  // on hold timer expiry
+  bringUp(nb2, if_2_1, 1);
+  kvStoreSyncEventsQueue.push(KvStoreSyncEvent(
+      *nb2.nodeName_ref(), openr::thrift::KvStore_constants::kDefaultArea()));
+  do {
+    EXPECT_EQ("adj:node-1", recvAdjAdvertisement());
+  } while (adjDb.adjacencies_ref()->empty());
+  EXPECT_EQ(Names({"node-2@iface_2_1"}), getAdjNames());
+
+  // 1 change against a snapshot of 1 adjacency
+  bringUp(nb2, if_2_2, 2);
+  EXPECT_EQ("adj:node-1", recvAdjAdvertisement());
+  EXPECT_EQ(Names({"node-2@iface_2_1", "node-2@iface_2_2"}), getAdjNames());
+  auto const firstSnapshotId = *snapshot.snapshotId_ref();
+
+  // 1 change against a snapshot of 2 adjacencies
+  bringUp(nb3, if_3_1, 1);
+  kvStoreSyncEventsQueue.push(KvStoreSyncEvent(
+      *nb3.nodeName_ref(), openr::thrift::KvStore_constants::kDefaultArea()));
+  EXPECT_EQ("adjdelta:node-1", recvAdjAdvertisement());
+  EXPECT_EQ(
+      Names({"node-2@iface_2_1", "node-2@iface_2_2", "node-3@iface_3_1"}),
+      getAdjNames());
+
+  // 2 changes against a snapshot of 2 adjacencies, roll over to a new one
+  bringUp(nb3, if_3_2, 2);
+  EXPECT_EQ("adj:node-1", recvAdjAdvertisement());
+  EXPECT_EQ(4, getAdjNames().size());
+  EXPECT_GT(*snapshot.snapshotId_ref(), firstSnapshotId);
+  auto const secondSnapshotId = *snapshot.snapshotId_ref();
+
+  // node attributes are only carried by snapshots
+  linkMonitor->setNodeOverload(true).get();
+  EXPECT_EQ("adj:node-1", recvAdjAdvertisement());
+  EXPECT_TRUE(*adjDb.isOverloaded_ref());
+  EXPECT_EQ(4, getAdjNames().size());
+  EXPECT_GT(*snapshot.snapshotId_ref(), secondSnapshotId);
 }
 
 // parallel adjacencies between two nodes via different interfaces
@@ -1553,6 +1744,13 @@ TEST_F(LinkMonitorTestFixture, verifyLinkEventSubscription) {
       kTestVethIfIndex[1] /* ifIndex */,
       true /* is up */);
   recvAndReplyIfUpdate();
+
+  // Only changed interface is reported in delta
+  EXPECT_TRUE(lastIfUpdate.isDelta);
+  EXPECT_EQ(
+      std::vector<std::string>({linkY}), lastIfUpdate.updatedInterfaces);
+  EXPECT_TRUE(lastIfUpdate.removedInterfaces.empty());
+
   nlEventsInjector->sendLinkEvent(
       linkX /* link name */,
       kTestVethIfIndex[0] /* ifIndex */,
@@ -1763,6 +1961,7 @@ TEST_F(LinkMonitorTestFixture, NodeLabelAlloc) {
         configStore.get(),
         false /* enable perf measurement */,
         interfaceUpdatesQueue,
+        interfaceStatusEventsQueue,
         prefixUpdatesQueue,
         peerUpdatesQueue,
         logSampleQueue,
@@ -1889,6 +2088,14 @@ TEST_F(LinkMonitorTestFixture, LoopbackPrefixAdvertisement) {
   // Withdraw prefix and see it is being withdrawn
   //
 
+  // Only withdrawn prefixes are sent to PrefixManager, not the full set
+  const std::string counter{"link_monitor.redist_prefixes_withdrawn.sum"};
+  auto getWithdrawnPrefixes = [&counter]() {
+    auto counters = facebook::fb303::fbData->getCounters();
+    return counters.count(counter) ? counters.at(counter) : 0;
+  };
+  const auto withdrawnPrefixes = getWithdrawnPrefixes();
+
   // 1) withdraw addresses WITHOUT subnet
   nlEventsInjector->sendAddrEvent("loopback", loopbackAddrV4, false);
   nlEventsInjector->sendAddrEvent("loopback", loopbackAddrV6_1, false);
@@ -1913,6 +2120,7 @@ TEST_F(LinkMonitorTestFixture, LoopbackPrefixAdvertisement) {
   }
 
   ASSERT_EQ(1, prefixes.count(toIpPrefix(loopbackAddrV6_2)));
+  EXPECT_EQ(withdrawnPrefixes + 4, getWithdrawnPrefixes());
   auto& prefixEntry = prefixes.at(toIpPrefix(loopbackAddrV6_2));
   EXPECT_EQ(
       Constants::kDefaultPathPreference,
@@ -1938,6 +2146,8 @@ TEST_F(LinkMonitorTestFixture, LoopbackPrefixAdvertisement) {
         getNextPrefixDb(nodeName, thrift::KvStore_constants::kDefaultArea());
   }
 
+  EXPECT_EQ(withdrawnPrefixes + 5, getWithdrawnPrefixes());
+
   LOG(INFO) << "All prefixes get withdrawn.";
 }
 
@@ -1974,6 +2184,46 @@ TEST_F(LinkMonitorTestFixture, GetAllLinks) {
       link.networks.at(0));
 }
 
+// InterfaceDb is re-synced from netlink platform once events got lost
+TEST_F(LinkMonitorTestFixture, SyncInterfacesOnEventsLost) {
+  SetUp({openr::thrift::KvStore_constants::kDefaultArea()});
+  const std::string linkX = kTestVethNamePrefix + "X";
+  const auto ifIndex = kTestVethIfIndex[0];
+  const auto v4Addr = "192.168.0.3/31";
+
+  // let initial InterfaceDb sync pass
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  // link and address show up without being notified
+  nlSock->setDropEvents(true);
+  EXPECT_EQ(0, nlSock->addLink(fbnl::utils::createLink(ifIndex, linkX)).get());
+  EXPECT_EQ(
+      0,
+      nlSock->addIfAddress(fbnl::utils::createIfAddress(ifIndex, v4Addr))
+          .get());
+  auto res = linkMonitor->getInterfaces().get();
+  ASSERT_NE(nullptr, res);
+  EXPECT_EQ(0, res->interfaceDetails_ref()->count(linkX));
+
+  // lost events trigger full sync
+  nlSock->setDropEvents(false);
+  while (true) {
+    res = linkMonitor->getInterfaces().get();
+    ASSERT_NE(nullptr, res);
+    if (res->interfaceDetails_ref()->count(linkX)) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+  const auto& info = *res->interfaceDetails_ref()->at(linkX).info_ref();
+  EXPECT_TRUE(*info.isUp_ref());
+  EXPECT_EQ(ifIndex, *info.ifIndex_ref());
+  ASSERT_EQ(1, info.networks_ref()->size());
+  EXPECT_EQ(
+      folly::IPAddress::createNetwork(v4Addr, -1, false /* apply mask */),
+      toIPNetwork(info.networks_ref()->at(0), false /* apply mask */));
+}
+
 TEST(LinkMonitor, GetPeersFromAdjacencies) {
   std::unordered_map<AdjacencyKey, AdjacencyValue> adjacencies;
   std::unordered_map<std::string, thrift::PeerSpec> peers;
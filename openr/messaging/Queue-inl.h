@@ -7,6 +7,11 @@
 
 #pragma once
 
+#include <thread>
+
+#include <folly/Format.h>
+#include <folly/fibers/FiberManager.h>
+
 namespace openr {
 namespace messaging {
 
@@ -31,6 +36,21 @@ RQueue<ValueType>::getCoro() {
 }
 #endif
 
+template <typename ValueType>
+folly::Expected<std::vector<ValueType>, QueueError>
+RQueue<ValueType>::getBatch(size_t maxItems) {
+  return queue_->getBatch(maxItems);
+}
+
+#if FOLLY_HAS_COROUTINES
+template <typename ValueType>
+folly::coro::Task<folly::Expected<std::vector<ValueType>, QueueError>>
+RQueue<ValueType>::getBatchCoro(size_t maxItems) {
+  auto batch = co_await queue_->getBatchCoro(maxItems);
+  co_return batch;
+}
+#endif
+
 template <typename ValueType>
 size_t
 RQueue<ValueType>::size() {
@@ -38,7 +58,57 @@ RQueue<ValueType>::size() {
 }
 
 template <typename ValueType>
-RWQueue<ValueType>::RWQueue() {}
+RWQueue<ValueType>::RWQueue() : RWQueue(QueueOptions{}) {}
+
+template <typename ValueType>
+RWQueue<ValueType>::RWQueue(QueueOptions options)
+    : options_(std::move(options)),
+      statKeys_(
+          options_.name.empty()
+              ? std::nullopt
+              : std::make_optional<StatKeys>(
+                    options_.name, options_.numPriorities)),
+      ring_(
+          options_.lockFree
+              ? std::make_unique<Ring>(
+                    options_.capacity, options_.overflowPolicy)
+              : nullptr),
+      lockContention_(LockContention::get(
+          "messaging." +
+          (options_.name.empty() ? std::string("unnamed") : options_.name))),
+      queues_(options_.numPriorities),
+      pushTimes_(statKeys_ ? options_.numPriorities : 0) {
+  CHECK_GT(options_.numPriorities, 0);
+  if (options_.lockFree) {
+    CHECK_GT(options_.capacity, 0);
+    CHECK_EQ(options_.numPriorities, 1);
+    CHECK(
+        options_.overflowPolicy == QueueOverflowPolicy::DROP or
+        options_.overflowPolicy == QueueOverflowPolicy::BLOCK);
+  }
+}
+
+template <typename ValueType>
+RWQueue<ValueType>::StatKeys::StatKeys(
+    const std::string& name, size_t numPriorities)
+    : depth("messaging." + name + ".depth"),
+      latency("messaging." + name + ".latency_us"),
+      overflows("messaging." + name + ".overflows"),
+      dropped("messaging." + name + ".dropped") {
+  namespace fb303 = facebook::fb303;
+  fb303::fbData->addStatExportType(depth, fb303::AVG);
+  fb303::fbData->addStatExportType(depth, fb303::MAX);
+  fb303::fbData->addStatExportType(latency, fb303::AVG);
+  fb303::fbData->addStatExportType(latency, fb303::MAX);
+  fb303::fbData->addStatExportType(overflows, fb303::SUM);
+  fb303::fbData->addStatExportType(dropped, fb303::SUM);
+  for (size_t i = 0; numPriorities > 1 and i < numPriorities; ++i) {
+    priorityLatency.emplace_back(
+        folly::sformat("messaging.{}.priority_{}.latency_us", name, i));
+    fb303::fbData->addStatExportType(priorityLatency.back(), fb303::AVG);
+    fb303::fbData->addStatExportType(priorityLatency.back(), fb303::MAX);
+  }
+}
 
 template <typename ValueType>
 RWQueue<ValueType>::~RWQueue() {
@@ -48,31 +118,100 @@ RWQueue<ValueType>::~RWQueue() {
 template <typename ValueType>
 template <typename ValueTypeT>
 bool
-RWQueue<ValueType>::push(ValueTypeT&& val) {
-  std::lock_guard<std::mutex> l(lock_);
-
-  // If queue is closed, don't enqueue
-  if (closed_) {
-    return false;
+RWQueue<ValueType>::push(ValueTypeT&& val, size_t priority) {
+  priority = std::min(priority, options_.numPriorities - 1);
+  if (ring_) {
+    return pushRing(std::forward<ValueTypeT>(val));
   }
 
-  if (pendingReads_.size()) {
-    // Unblock a pending read
-    auto& pendingRead = pendingReads_.front().get();
-    pendingRead.data = std::forward<ValueTypeT>(val);
-    pendingRead.baton.post();
-    pendingReads_.pop_front();
-  } else {
-    // Add data into the queue
-    queue_.emplace_back(std::forward<ValueTypeT>(val));
+  const auto policy = options_.overflowPolicy;
+  const auto isFull = [this]() {
+    return options_.capacity and numPending_ >= options_.capacity;
+  };
+  bool accepted{true};
+  bool overflow{false};
+  bool dropped{false};
+  size_t depth{0};
+  {
+    auto l = lockContention_.lock(lock_);
+    overflow = isFull();
+
+    // Wait for reader to make space
+    while (policy == QueueOverflowPolicy::BLOCK and not closed_ and isFull()) {
+      folly::fibers::Baton baton;
+      pendingWrites_.emplace_back(baton);
+      l.unlock();
+      baton.wait();
+      l.lock();
+    }
+
+    // If queue is closed, don't enqueue
+    if (closed_) {
+      return false;
+    }
+
+    if (pendingReads_.size()) {
+      // Unblock a pending read
+      auto& pendingRead = pendingReads_.front().get();
+      pendingRead.data = std::forward<ValueTypeT>(val);
+      pendingRead.priority = priority;
+      if (statKeys_) {
+        pendingRead.pushTime = std::chrono::steady_clock::now();
+      }
+      pendingRead.baton.post();
+      pendingReads_.pop_front();
+    } else if (isFull() and policy == QueueOverflowPolicy::DROP) {
+      accepted = false;
+      dropped = true;
+    } else {
+      if (isFull() and policy == QueueOverflowPolicy::DROP_OLDEST) {
+        // Drop from lowest priority class having data
+        size_t lowest = queues_.size() - 1;
+        while (queues_.at(lowest).empty()) {
+          --lowest;
+        }
+        queues_.at(lowest).pop_front();
+        if (statKeys_) {
+          pushTimes_.at(lowest).pop_front();
+        }
+        --numPending_;
+        dropped = true;
+      }
+      // Add data into the queue
+      queues_.at(priority).emplace_back(std::forward<ValueTypeT>(val));
+      if (statKeys_) {
+        pushTimes_.at(priority).emplace_back(std::chrono::steady_clock::now());
+      }
+      ++numPending_;
+    }
+    depth = numPending_;
   }
 
-  return true;
+  if (statKeys_) {
+    namespace fb303 = facebook::fb303;
+    fb303::fbData->addStatValue(statKeys_->depth, depth, fb303::AVG);
+    if (overflow) {
+      fb303::fbData->addStatValue(statKeys_->overflows, 1, fb303::SUM);
+    }
+    if (dropped) {
+      fb303::fbData->addStatValue(statKeys_->dropped, 1, fb303::SUM);
+    }
+  }
+  if (overflow and policy == QueueOverflowPolicy::SIGNAL) {
+    LOG_EVERY_N(WARNING, 100)
+        << "Queue " << options_.name << " exceeds capacity of "
+        << options_.capacity << ", has " << depth << " pending values";
+  }
+  return accepted;
 }
 
 template <typename ValueType>
 folly::Expected<ValueType, QueueError>
 RWQueue<ValueType>::get() {
+  if (ring_) {
+    return getRing();
+  }
+
   PendingRead pendingRead;
 
   // Queue is closed
@@ -92,6 +231,7 @@ RWQueue<ValueType>::get() {
   // Wait for baton and read the data
   pendingRead.baton.wait();
   if (pendingRead.data) {
+    addLatencyStat(pendingRead);
     return std::move(pendingRead.data).value();
   }
   return folly::makeUnexpected(QueueError::QUEUE_CLOSED);
@@ -101,6 +241,10 @@ RWQueue<ValueType>::get() {
 template <typename ValueType>
 folly::coro::Task<folly::Expected<ValueType, QueueError>>
 RWQueue<ValueType>::getCoro() {
+  if (ring_) {
+    co_return co_await getRingCoro();
+  }
+
   PendingRead pendingRead;
 
   // Queue is closed
@@ -118,16 +262,82 @@ RWQueue<ValueType>::getCoro() {
   // Wait for baton and read the data
   co_await pendingRead.baton;
   if (pendingRead.data) {
+    addLatencyStat(pendingRead);
     co_return std::move(pendingRead.data).value();
   }
   co_return folly::makeUnexpected(QueueError::QUEUE_CLOSED);
 }
 #endif
 
+template <typename ValueType>
+folly::Expected<std::vector<ValueType>, QueueError>
+RWQueue<ValueType>::getBatch(size_t maxItems) {
+  CHECK_GT(maxItems, 0);
+
+  // Wait for first value, rest is taken without waiting
+  auto maybeVal = get();
+  if (maybeVal.hasError()) {
+    return folly::makeUnexpected(maybeVal.error());
+  }
+  std::vector<ValueType> batch;
+  batch.emplace_back(std::move(maybeVal).value());
+  getAvailable(batch, maxItems);
+  return batch;
+}
+
+#if FOLLY_HAS_COROUTINES
+template <typename ValueType>
+folly::coro::Task<folly::Expected<std::vector<ValueType>, QueueError>>
+RWQueue<ValueType>::getBatchCoro(size_t maxItems) {
+  CHECK_GT(maxItems, 0);
+
+  // Wait for first value, rest is taken without waiting
+  auto maybeVal = co_await getCoro();
+  if (maybeVal.hasError()) {
+    co_return folly::makeUnexpected(maybeVal.error());
+  }
+  std::vector<ValueType> batch;
+  batch.emplace_back(std::move(maybeVal).value());
+  getAvailable(batch, maxItems);
+  co_return batch;
+}
+#endif
+
+template <typename ValueType>
+void
+RWQueue<ValueType>::getAvailable(
+    std::vector<ValueType>& batch, size_t maxItems) {
+  if (ring_) {
+    while (batch.size() < maxItems) {
+      auto front = ring_->queue.frontPtr();
+      if (not front) {
+        break;
+      }
+      batch.emplace_back(std::move(*front));
+      ring_->queue.popFront();
+    }
+    return;
+  }
+
+  // NOTE: deque as PendingRead is not movable
+  std::deque<PendingRead> reads;
+  {
+    auto l = lockContention_.lock(lock_);
+    while (not closed_ and numPending_ and batch.size() < maxItems) {
+      popFront(reads.emplace_back());
+      batch.emplace_back(std::move(reads.back().data).value());
+    }
+  }
+
+  for (const auto& read : reads) {
+    addLatencyStat(read);
+  }
+}
+
 template <typename ValueType>
 folly::Expected<bool, QueueError>
 RWQueue<ValueType>::getAnyImpl(PendingRead& pendingRead) {
-  std::lock_guard<std::mutex> l(lock_);
+  auto l = lockContention_.lock(lock_);
 
   // If queue is closed, return immediately
   if (closed_) {
@@ -135,9 +345,8 @@ RWQueue<ValueType>::getAnyImpl(PendingRead& pendingRead) {
   }
 
   // Perform immediate read if data is available
-  if (queue_.size()) {
-    pendingRead.data = std::move(queue_.front());
-    queue_.pop_front();
+  if (numPending_) {
+    popFront(pendingRead);
     return true;
   }
 
@@ -146,43 +355,223 @@ RWQueue<ValueType>::getAnyImpl(PendingRead& pendingRead) {
   return false;
 }
 
+template <typename ValueType>
+void
+RWQueue<ValueType>::popFront(PendingRead& pendingRead) {
+  size_t priority = 0;
+  while (queues_.at(priority).empty()) {
+    ++priority;
+  }
+  pendingRead.data = std::move(queues_.at(priority).front());
+  pendingRead.priority = priority;
+  queues_.at(priority).pop_front();
+  if (statKeys_) {
+    pendingRead.pushTime = pushTimes_.at(priority).front();
+    pushTimes_.at(priority).pop_front();
+  }
+  --numPending_;
+
+  // Unblock a pending write, there is space now
+  if (pendingWrites_.size()) {
+    pendingWrites_.front().get().post();
+    pendingWrites_.pop_front();
+  }
+}
+
+template <typename ValueType>
+void
+RWQueue<ValueType>::addLatencyStat(const PendingRead& pendingRead) {
+  if (not statKeys_) {
+    return;
+  }
+  const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - pendingRead.pushTime);
+  namespace fb303 = facebook::fb303;
+  fb303::fbData->addStatValue(
+      statKeys_->latency, latency.count(), fb303::AVG);
+  if (statKeys_->priorityLatency.size()) {
+    fb303::fbData->addStatValue(
+        statKeys_->priorityLatency.at(pendingRead.priority),
+        latency.count(),
+        fb303::AVG);
+  }
+}
+
+template <typename ValueType>
+template <typename ValueTypeT>
+bool
+RWQueue<ValueType>::pushRing(ValueTypeT&& val) {
+  namespace fb303 = facebook::fb303;
+  bool overflow{false};
+
+  // NOTE: value is only consumed by successful write
+  while (true) {
+    if (ring_->closed.load()) {
+      return false;
+    }
+    if (ring_->queue.write(std::forward<ValueTypeT>(val))) {
+      break;
+    }
+    if (statKeys_ and not overflow) {
+      fb303::fbData->addStatValue(statKeys_->overflows, 1, fb303::SUM);
+    }
+    overflow = true;
+    if (ring_->overflowPolicy == QueueOverflowPolicy::DROP) {
+      if (statKeys_) {
+        fb303::fbData->addStatValue(statKeys_->dropped, 1, fb303::SUM);
+      }
+      return false;
+    }
+    // Wait for reader to make space
+    if (folly::fibers::onFiber()) {
+      folly::fibers::yield();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  notifyRing();
+  if (statKeys_) {
+    fb303::fbData->addStatValue(
+        statKeys_->depth, ring_->queue.sizeGuess(), fb303::AVG);
+  }
+  return true;
+}
+
+template <typename ValueType>
+folly::Expected<std::optional<ValueType>, QueueError>
+RWQueue<ValueType>::tryGetRing(folly::fibers::Baton& baton) {
+  while (true) {
+    if (ring_->closed.load()) {
+      return folly::makeUnexpected(QueueError::QUEUE_CLOSED);
+    }
+    if (auto front = ring_->queue.frontPtr()) {
+      std::optional<ValueType> val(std::move(*front));
+      ring_->queue.popFront();
+      return val;
+    }
+
+    // Register as waiter, then check again not to miss concurrent push or
+    // close. Pairs with the fence in notifyRing().
+    ring_->waiter.store(&baton);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ring_->queue.isEmpty() and not ring_->closed.load()) {
+      return std::nullopt;
+    }
+
+    // Take back baton, unless writer did already and is about to post it
+    if (ring_->waiter.exchange(nullptr) != &baton) {
+      return std::nullopt;
+    }
+  }
+}
+
+template <typename ValueType>
+folly::Expected<ValueType, QueueError>
+RWQueue<ValueType>::getRing() {
+  while (true) {
+    folly::fibers::Baton baton;
+    auto maybeVal = tryGetRing(baton);
+    if (maybeVal.hasError()) {
+      return folly::makeUnexpected(maybeVal.error());
+    }
+    if (maybeVal.value()) {
+      return std::move(*maybeVal.value());
+    }
+    baton.wait();
+  }
+}
+
+#if FOLLY_HAS_COROUTINES
+template <typename ValueType>
+folly::coro::Task<folly::Expected<ValueType, QueueError>>
+RWQueue<ValueType>::getRingCoro() {
+  while (true) {
+    folly::fibers::Baton baton;
+    auto maybeVal = tryGetRing(baton);
+    if (maybeVal.hasError()) {
+      co_return folly::makeUnexpected(maybeVal.error());
+    }
+    if (maybeVal.value()) {
+      co_return std::move(*maybeVal.value());
+    }
+    co_await baton;
+  }
+}
+#endif
+
+template <typename ValueType>
+void
+RWQueue<ValueType>::notifyRing() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (auto baton = ring_->waiter.exchange(nullptr)) {
+    baton->post();
+  }
+}
+
 template <typename ValueType>
 void
 RWQueue<ValueType>::close() {
-  std::lock_guard<std::mutex> l(lock_);
+  if (ring_) {
+    ring_->closed.store(true);
+    notifyRing();
+    return;
+  }
+
+  auto l = lockContention_.lock(lock_);
 
   if (not closed_) {
     closed_ = true;
     // Either one of these must be zero
-    assert(pendingReads_.size() == 0 || queue_.size() == 0);
+    assert(pendingReads_.size() == 0 || numPending_ == 0);
     // Set empy value to all pending reads
     while (pendingReads_.size()) {
       auto& pendingRead = pendingReads_.front().get();
       pendingRead.baton.post();
       pendingReads_.pop_front();
     }
-    queue_.clear();
+    // Unblock all pending writes, these will fail
+    while (pendingWrites_.size()) {
+      pendingWrites_.front().get().post();
+      pendingWrites_.pop_front();
+    }
+    for (auto& queue : queues_) {
+      queue.clear();
+    }
+    for (auto& pushTimes : pushTimes_) {
+      pushTimes.clear();
+    }
+    numPending_ = 0;
   }
 }
 
 template <typename ValueType>
 bool
 RWQueue<ValueType>::isClosed() {
-  std::lock_guard<std::mutex> l(lock_);
+  if (ring_) {
+    return ring_->closed.load();
+  }
+  auto l = lockContention_.lock(lock_);
   return closed_;
 }
 
 template <typename ValueType>
 size_t
 RWQueue<ValueType>::size() {
-  std::lock_guard<std::mutex> l(lock_);
-  return queue_.size();
+  if (ring_) {
+    return ring_->queue.sizeGuess();
+  }
+  auto l = lockContention_.lock(lock_);
+  return numPending_;
 }
 
 template <typename ValueType>
 size_t
 RWQueue<ValueType>::numPendingReads() {
-  std::lock_guard<std::mutex> l(lock_);
+  if (ring_) {
+    return ring_->waiter.load() ? 1 : 0;
+  }
+  auto l = lockContention_.lock(lock_);
   return pendingReads_.size();
 }
 
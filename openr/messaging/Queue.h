@@ -7,18 +7,28 @@
 
 #pragma once
 
+#include <algorithm>
 #include <any>
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include <fb303/ServiceData.h>
 #include <folly/Expected.h>
+#include <folly/ProducerConsumerQueue.h>
 #include <folly/fibers/Baton.h>
 #if FOLLY_HAS_COROUTINES
 #include <folly/experimental/coro/Task.h>
 #endif
 
+#include <openr/common/LockContention.h>
+
 namespace openr {
 namespace messaging {
 
@@ -26,6 +36,49 @@ enum class QueueError {
   QUEUE_CLOSED,
 };
 
+/**
+ * Behavior of bounded queue on push when it is full
+ */
+enum class QueueOverflowPolicy {
+  // Value is dropped and push returns false
+  DROP,
+  // Writer waits for reader to make space. Yields when called on fiber.
+  BLOCK,
+  // Oldest pending value is dropped to make space. Only suits queues where
+  // newer values supersede older ones, e.g. full state snapshots.
+  DROP_OLDEST,
+  // Value is queued beyond capacity, overflow is only reported
+  SIGNAL,
+};
+
+/**
+ * Construction options of RWQueue
+ */
+struct QueueOptions {
+  // Name of queue in fb303 counters `messaging.<name>.*`. These are
+  // - depth: number of pending values on push (avg, max)
+  // - latency_us: time values spend in queue till read (avg, max)
+  // - priority_<n>.latency_us: same, per priority class, if there are many
+  // - overflows: pushes to full queue (sum)
+  // - dropped: values lost because of overflow (sum)
+  // No counters are exported for queue without name. Contention on the lock
+  // of queues is reported as `lock.messaging.<name>.*`, see LockContention.
+  std::string name;
+
+  // Max number of pending values, 0 for unbounded queue
+  size_t capacity{0};
+  QueueOverflowPolicy overflowPolicy{QueueOverflowPolicy::DROP};
+
+  // Back bounded queue with lock-free ring buffer, see RWQueue. Only supports
+  // DROP and BLOCK policies and doesn't report latency.
+  bool lockFree{false};
+
+  // Number of priority classes. Readers get pending values of class 0 first,
+  // then class 1 and so on. Order is FIFO within a class. Capacity is shared
+  // by all classes. Not supported by lock-free queue.
+  size_t numPriorities{1};
+};
+
 template <typename ValueType>
 class RWQueue;
 
@@ -51,6 +104,18 @@ class RQueue {
   folly::coro::Task<folly::Expected<ValueType, QueueError>> getCoro();
 #endif
 
+  /**
+   * Blocking read of all available data, up to maxItems, in one wake-up. Waits
+   * only if queue is empty. Lets consumer coalesce bursts of data.
+   */
+  folly::Expected<std::vector<ValueType>, QueueError> getBatch(
+      size_t maxItems);
+
+#if FOLLY_HAS_COROUTINES
+  folly::coro::Task<folly::Expected<std::vector<ValueType>, QueueError>>
+  getBatchCoro(size_t maxItems);
+#endif
+
   // Utility function to retrieve size of pending data in underlying queue
   size_t size();
 
@@ -69,19 +134,30 @@ class RQueue {
  *
  * After closing queue, all subsequent push are ignored and return false. All
  * subsequent reads return QUEUE_CLOSED error
+ *
+ * Queue can be bounded, see QueueOverflowPolicy for behavior on overflow.
+ *
+ * Lock-free bounded queue is backed by a ring buffer instead. It is single
+ * producer single consumer: pushes must come from one thread, and at most one
+ * reader may get at a time. This suits most module to module queues, which
+ * have a fixed writer thread and a single reading fiber.
  */
 template <typename ValueType>
 class RWQueue {
  public:
   RWQueue();
+  explicit RWQueue(QueueOptions options);
   ~RWQueue();
 
   /**
-   * Non blocking push. Any typed value can be pushed!
+   * Non blocking push, unless queue is full and has BLOCK policy. Any typed
+   * value can be pushed! Priority beyond the last class of queue is queued as
+   * last class. With DROP_OLDEST policy the oldest value of the lowest class
+   * is dropped.
    * Return true/false!!
    */
   template <typename ValueTypeT>
-  bool push(ValueTypeT&& val);
+  bool push(ValueTypeT&& val, size_t priority = 0);
 
   /**
    * Blocking read for native threads/fibers. In-case of fibers, the fiber
@@ -96,6 +172,18 @@ class RWQueue {
   folly::coro::Task<folly::Expected<ValueType, QueueError>> getCoro();
 #endif
 
+  /**
+   * Blocking read of all available data, up to maxItems, in one wake-up. Waits
+   * only if queue is empty.
+   */
+  folly::Expected<std::vector<ValueType>, QueueError> getBatch(
+      size_t maxItems);
+
+#if FOLLY_HAS_COROUTINES
+  folly::coro::Task<folly::Expected<std::vector<ValueType>, QueueError>>
+  getBatchCoro(size_t maxItems);
+#endif
+
   /**
    * Close the queue. All new push will be ignored and pending data will be lost
    */
@@ -116,6 +204,22 @@ class RWQueue {
   struct PendingRead {
     folly::fibers::Baton baton;
     std::optional<ValueType> data;
+    // Push time of data, only set for queue with stats
+    std::chrono::steady_clock::time_point pushTime;
+    // Priority class of data
+    size_t priority{0};
+  };
+
+  // fb303 keys of queue counters, see QueueOptions
+  struct StatKeys {
+    StatKeys(const std::string& name, size_t numPriorities);
+
+    const std::string depth;
+    const std::string latency;
+    const std::string overflows;
+    const std::string dropped;
+    // Only set for queue with many priority classes
+    std::vector<std::string> priorityLatency;
   };
 
   /**
@@ -126,8 +230,58 @@ class RWQueue {
    */
   folly::Expected<bool, QueueError> getAnyImpl(PendingRead& pendingRead);
 
-  // Lock to protect below private variables
+  // Report latency of value read by pendingRead
+  void addLatencyStat(const PendingRead& pendingRead);
+
+  // Move oldest value of highest priority class into pendingRead. Must be
+  // called with lock held and data pending.
+  void popFront(PendingRead& pendingRead);
+
+  // Non blocking read of available data into batch, up to maxItems in total
+  void getAvailable(std::vector<ValueType>& batch, size_t maxItems);
+
+  // Bounded lock-free mode
+  struct Ring {
+    // NOTE: one slot of ring buffer always stays empty
+    Ring(size_t capacity, QueueOverflowPolicy overflowPolicy)
+        : queue(capacity + 1), overflowPolicy(overflowPolicy) {}
+
+    folly::ProducerConsumerQueue<ValueType> queue;
+    const QueueOverflowPolicy overflowPolicy;
+    std::atomic<bool> closed{false};
+
+    // Baton of reader waiting for data, to be posted by writer
+    std::atomic<folly::fibers::Baton*> waiter{nullptr};
+  };
+
+  template <typename ValueTypeT>
+  bool pushRing(ValueTypeT&& val);
+
+  folly::Expected<ValueType, QueueError> getRing();
+
+#if FOLLY_HAS_COROUTINES
+  folly::coro::Task<folly::Expected<ValueType, QueueError>> getRingCoro();
+#endif
+
+  // Returns value if available. Otherwise registers baton as waiter and returns
+  // nullopt, in which case reader must wait on it before trying again.
+  folly::Expected<std::optional<ValueType>, QueueError> tryGetRing(
+      folly::fibers::Baton& baton);
+
+  // Wake up waiting reader, if any
+  void notifyRing();
+
+  const QueueOptions options_;
+
+  // Set for queue with name
+  const std::optional<StatKeys> statKeys_;
+
+  // Set for lock-free queue, none of below variables is used then
+  const std::unique_ptr<Ring> ring_;
+
+  // Lock to protect below private variables, and contention on it
   std::mutex lock_;
+  LockContention& lockContention_;
 
   // State of queue
   bool closed_{false};
@@ -135,8 +289,17 @@ class RWQueue {
   // Pending reads - readers are actively waiting for data
   std::deque<std::reference_wrapper<PendingRead>> pendingReads_;
 
-  // Pending data
-  std::deque<ValueType> queue_;
+  // Pending writes - writers are waiting for space in full queue
+  std::deque<std::reference_wrapper<folly::fibers::Baton>> pendingWrites_;
+
+  // Pending data, one FIFO per priority class
+  std::vector<std::deque<ValueType>> queues_;
+
+  // Push time of pending data, only maintained for queue with stats
+  std::vector<std::deque<std::chrono::steady_clock::time_point>> pushTimes_;
+
+  // Total number of pending values over all priority classes
+  size_t numPending_{0};
 };
 
 } // namespace messaging
@@ -11,7 +11,15 @@ namespace openr {
 namespace messaging {
 
 template <typename ValueType>
-ReplicateQueue<ValueType>::ReplicateQueue() {}
+ReplicateQueue<ValueType>::ReplicateQueue()
+    : ReplicateQueue(QueueOptions{}) {}
+
+template <typename ValueType>
+ReplicateQueue<ValueType>::ReplicateQueue(QueueOptions readerOptions)
+    : readerOptions_(std::move(readerOptions)),
+      readersContention_(&LockContention::get(folly::sformat(
+          "messaging.{}.readers",
+          readerOptions_.name.empty() ? "unnamed" : readerOptions_.name))) {}
 
 template <typename ValueType>
 ReplicateQueue<ValueType>::~ReplicateQueue() {
@@ -21,36 +29,51 @@ ReplicateQueue<ValueType>::~ReplicateQueue() {
 template <typename ValueType>
 template <typename ValueTypeT>
 bool
-ReplicateQueue<ValueType>::push(ValueTypeT&& value) {
-  std::vector<std::shared_ptr<RWQueue<ValueType>>> readers;
+ReplicateQueue<ValueType>::push(ValueTypeT&& value, size_t priority) {
+  // Wrap plain value into the immutable instance shared by all readers
+  if constexpr (
+      detail::IsSharedImmutable<ValueType>::value and
+      not std::is_constructible_v<ValueType, ValueTypeT&&>) {
+    return push(
+        std::make_shared<typename ValueType::element_type>(
+            std::forward<ValueTypeT>(value)),
+        priority);
+  } else {
+    std::vector<std::shared_ptr<RWQueue<ValueType>>> readers;
 
-  // Copy reader information - and cleans up stale reader
-  {
-    auto lockedReaders = readers_.wlock();
-    if (closed_) {
+    // Copy reader information - and cleans up stale reader
+    const bool closed =
+        readersContention_->withWLock(readers_, [&](auto& lockedReaders) {
+          if (closed_) {
+            return true;
+          }
+          for (auto it = lockedReaders.begin(); it != lockedReaders.end();) {
+            if (it->use_count() == 1) {
+              (*it)->close(); // Close before erasing
+              it = lockedReaders.erase(it);
+            } else {
+              // NOTE: intentionally copying shared_ptr
+              readers.emplace_back(*it);
+              ++it;
+            }
+          }
+          return false;
+        });
+    if (closed) {
       return false;
     }
-    for (auto it = lockedReaders->begin(); it != lockedReaders->end();) {
-      if (it->use_count() == 1) {
-        (*it)->close(); // Close before erasing
-        it = lockedReaders->erase(it);
-      } else {
-        readers.emplace_back(*it); // NOTE: intentionally copying shared_ptr
-        ++it;
+
+    // Replicate messages
+    if (readers.size()) {
+      for (size_t i = 0; i < readers.size() - 1; i++) {
+        readers.at(i)->push(ValueType(value), priority); // Intended copy
       }
+      // Perfect forwarding for last reader
+      readers.back()->push(std::forward<ValueTypeT>(value), priority);
     }
-  }
 
-  // Replicate messages
-  if (readers.size()) {
-    for (size_t i = 0; i < readers.size() - 1; i++) {
-      readers.at(i)->push(ValueType(value)); // Intended copy
-    }
-    // Perfect forwarding for last reader
-    readers.back()->push(std::forward<ValueTypeT>(value));
+    return true;
   }
-
-  return true;
 }
 
 /**
@@ -60,38 +83,42 @@ ReplicateQueue<ValueType>::push(ValueTypeT&& value) {
 template <typename ValueType>
 RQueue<ValueType>
 ReplicateQueue<ValueType>::getReader() {
-  auto lockedReaders = readers_.wlock();
-  if (closed_) {
-    throw std::runtime_error("queue is closed");
-  }
-  lockedReaders->emplace_back(std::make_shared<RWQueue<ValueType>>());
-  return RQueue<ValueType>(lockedReaders->back());
+  return readersContention_->withWLock(readers_, [&](auto& lockedReaders) {
+    if (closed_) {
+      throw std::runtime_error("queue is closed");
+    }
+    lockedReaders.emplace_back(
+        std::make_shared<RWQueue<ValueType>>(readerOptions_));
+    return RQueue<ValueType>(lockedReaders.back());
+  });
 }
 
 template <typename ValueType>
 size_t
 ReplicateQueue<ValueType>::getNumReaders() {
-  auto lockedReaders = readers_.wlock();
-  for (auto it = lockedReaders->begin(); it != lockedReaders->end();) {
-    if (it->use_count() == 1) {
-      (*it)->close(); // Close before erasing
-      it = lockedReaders->erase(it);
-    } else {
-      ++it;
+  return readersContention_->withWLock(readers_, [](auto& lockedReaders) {
+    for (auto it = lockedReaders.begin(); it != lockedReaders.end();) {
+      if (it->use_count() == 1) {
+        (*it)->close(); // Close before erasing
+        it = lockedReaders.erase(it);
+      } else {
+        ++it;
+      }
     }
-  }
-  return lockedReaders->size();
+    return lockedReaders.size();
+  });
 }
 
 template <typename ValueType>
 void
 ReplicateQueue<ValueType>::close() {
-  auto lockedReaders = readers_.wlock();
-  closed_ = true;
-  for (auto& queue : *lockedReaders) {
-    queue->close();
-  }
-  lockedReaders->clear();
+  readersContention_->withWLock(readers_, [this](auto& lockedReaders) {
+    closed_ = true;
+    for (auto& queue : lockedReaders) {
+      queue->close();
+    }
+    lockedReaders.clear();
+  });
 }
 
 } // namespace messaging
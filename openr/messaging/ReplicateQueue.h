@@ -7,23 +7,52 @@
 
 #pragma once
 
+#include <memory>
+#include <type_traits>
+
 #include <openr/messaging/Queue.h>
 
 namespace openr {
 namespace messaging {
 
+namespace detail {
+
+template <typename ValueType>
+struct IsSharedImmutable : std::false_type {};
+
+template <typename T>
+struct IsSharedImmutable<std::shared_ptr<const T>> : std::true_type {};
+
+} // namespace detail
+
 /**
  * Multiple writers and readers. Each reader gets every written element push by
  * every writer. Writer pays the cost of replicating data to all readers. If no
  * reader exists then all the messages are silently dropped.
  *
  * Pushed object must be copy constructible.
+ *
+ * Big objects consumed by several readers should be replicated as
+ * std::shared_ptr<const T>, so that all readers share one immutable instance
+ * instead of getting a copy each. Such queue also accepts plain T values,
+ * which get wrapped once on push.
  */
 template <typename ValueType>
 class ReplicateQueue {
  public:
   ReplicateQueue();
 
+  /**
+   * Replicate into reader queues created with given options. Readers share
+   * queue name and hence its counters, e.g. depth reports the slowest reader.
+   * Contention on the list of readers is reported as
+   * `lock.messaging.<name>.readers.*`, see LockContention.
+   * With BLOCK overflow policy a slow reader holds back the writer and all
+   * other readers. Lock-free readers are only valid if all pushes come from a
+   * single thread, see RWQueue.
+   */
+  explicit ReplicateQueue(QueueOptions readerOptions);
+
   ~ReplicateQueue();
 
   /**
@@ -40,10 +69,11 @@ class ReplicateQueue {
 
   /**
    * Push any value into the queue. Will get replicated to all the readers.
-   * This also cleans up any lingering queue which has no active reader
+   * This also cleans up any lingering queue which has no active reader.
+   * Priority class applies to readers with numPriorities, see QueueOptions.
    */
   template <typename ValueTypeT>
-  bool push(ValueTypeT&& value);
+  bool push(ValueTypeT&& value, size_t priority = 0);
 
   /**
    * Get new reader stream of this queue. Stream will get closed automatically
@@ -72,6 +102,12 @@ class ReplicateQueue {
  private:
   folly::Synchronized<std::list<std::shared_ptr<RWQueue<ValueType>>>> readers_;
   bool closed_{false}; // Protected by above Synchronized lock
+
+  // Options of reader queues
+  QueueOptions readerOptions_;
+
+  // Contention on readers_, never null
+  LockContention* readersContention_{nullptr};
 };
 
 } // namespace messaging
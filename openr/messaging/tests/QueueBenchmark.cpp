@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <thread>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+#include <openr/messaging/Queue.h>
+#include <openr/tests/BenchmarkDriver.h>
+
+namespace {
+// Capacity of bounded queue
+const size_t kCapacity{1024};
+} // namespace
+
+namespace openr {
+
+using messaging::QueueOptions;
+using messaging::QueueOverflowPolicy;
+using messaging::RWQueue;
+
+/**
+ * Options of lock-free bounded queue
+ */
+static QueueOptions
+getLockFreeOptions() {
+  QueueOptions options;
+  options.capacity = kCapacity;
+  options.overflowPolicy = QueueOverflowPolicy::BLOCK;
+  options.lockFree = true;
+  return options;
+}
+
+/**
+ * Push and then read back `n` messages on same thread
+ */
+static void
+pushGet(RWQueue<size_t>& q, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    q.push(i);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    folly::doNotOptimizeAway(q.get());
+  }
+}
+
+/**
+ * Stream `n` messages from writer thread to reader thread
+ */
+static void
+pushGetThreads(RWQueue<size_t>& q, size_t n) {
+  std::thread reader([&q, n]() {
+    for (size_t i = 0; i < n; ++i) {
+      folly::doNotOptimizeAway(q.get());
+    }
+  });
+  for (size_t i = 0; i < n; ++i) {
+    q.push(i);
+  }
+  reader.join();
+}
+
+/**
+ * Benchmark for messages passing through mutex protected queue on one thread
+ */
+void
+BM_QueuePushGet(uint32_t iters, size_t n) {
+  auto suspender = folly::BenchmarkSuspender();
+  RWQueue<size_t> q;
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    pushGet(q, n);
+  }
+}
+
+/**
+ * Benchmark for messages passing through bounded queue on one thread
+ */
+void
+BM_BoundedQueuePushGet(uint32_t iters, size_t n) {
+  auto suspender = folly::BenchmarkSuspender();
+  RWQueue<size_t> q(getLockFreeOptions());
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    pushGet(q, n);
+  }
+}
+
+/**
+ * Benchmark for messages passing through mutex protected queue across threads
+ */
+void
+BM_QueuePushGetThreads(uint32_t iters, size_t n) {
+  auto suspender = folly::BenchmarkSuspender();
+  RWQueue<size_t> q;
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    pushGetThreads(q, n);
+  }
+}
+
+/**
+ * Benchmark for messages passing through bounded queue across threads
+ */
+void
+BM_BoundedQueuePushGetThreads(uint32_t iters, size_t n) {
+  auto suspender = folly::BenchmarkSuspender();
+  RWQueue<size_t> q(getLockFreeOptions());
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    pushGetThreads(q, n);
+  }
+}
+
+// The parameter is the number of messages per iteration. Single threaded
+// bounded queue can't take more than its capacity before reads.
+BENCHMARK_PARAM(BM_QueuePushGet, 10);
+BENCHMARK_RELATIVE_PARAM(BM_BoundedQueuePushGet, 10);
+BENCHMARK_PARAM(BM_QueuePushGet, 1000);
+BENCHMARK_RELATIVE_PARAM(BM_BoundedQueuePushGet, 1000);
+
+BENCHMARK_PARAM(BM_QueuePushGetThreads, 1000);
+BENCHMARK_RELATIVE_PARAM(BM_BoundedQueuePushGetThreads, 1000);
+BENCHMARK_PARAM(BM_QueuePushGetThreads, 100000);
+BENCHMARK_RELATIVE_PARAM(BM_BoundedQueuePushGetThreads, 100000);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  return openr::runBenchmarks();
+}
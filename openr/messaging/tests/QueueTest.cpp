@@ -322,3 +322,296 @@ TEST(RQueueTest, ReadTest) {
   EXPECT_EQ(0, rwq->size());
 #endif
 }
+
+namespace {
+
+QueueOptions
+makeQueueOptions(
+    size_t capacity,
+    QueueOverflowPolicy overflowPolicy,
+    bool lockFree = false,
+    std::string name = "") {
+  QueueOptions options;
+  options.name = std::move(name);
+  options.capacity = capacity;
+  options.overflowPolicy = overflowPolicy;
+  options.lockFree = lockFree;
+  return options;
+}
+
+int64_t
+getCounter(const std::string& key) {
+  auto counters = facebook::fb303::fbData->getCounters();
+  auto it = counters.find(key);
+  return it != counters.end() ? it->second : 0;
+}
+
+} // namespace
+
+/**
+ * Bounded queue behavior common to locked and lock-free (param) queue
+ */
+class BoundedQueueTestFixture : public ::testing::TestWithParam<bool> {};
+
+INSTANTIATE_TEST_CASE_P(
+    BoundedQueueTest, BoundedQueueTestFixture, ::testing::Bool());
+
+TEST_P(BoundedQueueTestFixture, OrderedPushGet) {
+  RWQueue<std::string> q(
+      makeQueueOptions(4, QueueOverflowPolicy::DROP, GetParam()));
+
+  EXPECT_TRUE(q.push("one"));
+  EXPECT_TRUE(q.push("two"));
+  EXPECT_TRUE(q.push("three"));
+  EXPECT_EQ(3, q.size());
+  EXPECT_EQ(0, q.numPendingReads());
+  EXPECT_EQ("one", q.get().value());
+  EXPECT_EQ("two", q.get().value());
+  EXPECT_EQ("three", q.get().value());
+  EXPECT_EQ(0, q.size());
+}
+
+TEST_P(BoundedQueueTestFixture, DropOnOverflow) {
+  RWQueue<int> q(makeQueueOptions(2, QueueOverflowPolicy::DROP, GetParam()));
+
+  EXPECT_TRUE(q.push(1));
+  EXPECT_TRUE(q.push(2));
+  EXPECT_FALSE(q.push(3)); // Queue is full, value gets dropped
+  EXPECT_EQ(2, q.size());
+
+  EXPECT_EQ(1, q.get().value());
+  EXPECT_TRUE(q.push(4));
+  EXPECT_EQ(2, q.get().value());
+  EXPECT_EQ(4, q.get().value());
+  EXPECT_EQ(0, q.size());
+}
+
+TEST_P(BoundedQueueTestFixture, BlockOnOverflow) {
+  const int kCount{64};
+  RWQueue<int> q(makeQueueOptions(2, QueueOverflowPolicy::BLOCK, GetParam()));
+
+  folly::EventBase evb;
+  auto& manager = folly::fibers::getFiberManager(evb);
+  manager.addTask([&q]() {
+    for (int i = 0; i < kCount; ++i) {
+      EXPECT_TRUE(q.push(i)); // Blocks until reader makes space
+      EXPECT_GE(2, q.size());
+    }
+  });
+  manager.addTask([&q]() {
+    for (int i = 0; i < kCount; ++i) {
+      EXPECT_EQ(i, q.get().value());
+    }
+  });
+
+  evb.loop();
+  EXPECT_EQ(0, q.size());
+  EXPECT_EQ(0, q.numPendingReads());
+}
+
+TEST_P(BoundedQueueTestFixture, ClosedPendingRead) {
+  RWQueue<int> q(makeQueueOptions(2, QueueOverflowPolicy::DROP, GetParam()));
+
+  folly::EventBase evb;
+  auto& manager = folly::fibers::getFiberManager(evb);
+  manager.addTask([&q]() mutable {
+    EXPECT_EQ(1, q.get().value());
+    auto x = q.get(); // Perform read
+    EXPECT_TRUE(x.hasError());
+    EXPECT_EQ(x.error(), QueueError::QUEUE_CLOSED);
+  });
+
+  evb.loopOnce(); // Fiber should get stuck at the first read
+  EXPECT_EQ(1, q.numPendingReads());
+
+  q.push(1);
+  evb.loopOnce(); // Fiber should get stuck at the second read
+  EXPECT_EQ(0, q.size());
+  EXPECT_EQ(1, q.numPendingReads());
+
+  q.close();
+  evb.loopOnce();
+  EXPECT_TRUE(q.isClosed());
+  EXPECT_EQ(0, q.numPendingReads());
+  EXPECT_FALSE(q.push(2));
+  EXPECT_EQ(q.get().error(), QueueError::QUEUE_CLOSED);
+}
+
+TEST_P(BoundedQueueTestFixture, MultiThreadTest) {
+  const size_t kCount{100000};
+  RWQueue<size_t> q(
+      makeQueueOptions(64, QueueOverflowPolicy::BLOCK, GetParam()));
+
+  std::thread reader([&q]() {
+    for (size_t i = 0; i < kCount; ++i) {
+      auto maybeNum = q.get();
+      ASSERT_TRUE(maybeNum.hasValue());
+      EXPECT_EQ(i, maybeNum.value());
+    }
+    EXPECT_EQ(q.get().error(), QueueError::QUEUE_CLOSED);
+  });
+
+  for (size_t i = 0; i < kCount; ++i) {
+    EXPECT_TRUE(q.push(i));
+  }
+  // Wait for reader to drain the queue before closing it
+  while (q.size()) {
+    std::this_thread::yield();
+  }
+  q.close();
+  reader.join();
+}
+
+TEST_P(BoundedQueueTestFixture, BatchRead) {
+  RWQueue<int> q(makeQueueOptions(8, QueueOverflowPolicy::DROP, GetParam()));
+
+  for (int i = 0; i < 5; ++i) {
+    q.push(i);
+  }
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), q.getBatch(3).value());
+  EXPECT_EQ(std::vector<int>({3, 4}), q.getBatch(3).value());
+  EXPECT_EQ(0, q.size());
+
+  q.close();
+  EXPECT_EQ(q.getBatch(3).error(), QueueError::QUEUE_CLOSED);
+}
+
+TEST(RWQueueTest, DropOldestOnOverflow) {
+  RWQueue<int> q(makeQueueOptions(2, QueueOverflowPolicy::DROP_OLDEST));
+
+  EXPECT_TRUE(q.push(1));
+  EXPECT_TRUE(q.push(2));
+  EXPECT_TRUE(q.push(3)); // Queue is full, oldest value gets dropped
+  EXPECT_EQ(2, q.size());
+
+  EXPECT_EQ(2, q.get().value());
+  EXPECT_EQ(3, q.get().value());
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(RWQueueTest, SignalOnOverflow) {
+  RWQueue<int> q(makeQueueOptions(2, QueueOverflowPolicy::SIGNAL));
+
+  EXPECT_TRUE(q.push(1));
+  EXPECT_TRUE(q.push(2));
+  EXPECT_TRUE(q.push(3)); // Queue is full, value still gets queued
+  EXPECT_EQ(3, q.size());
+
+  EXPECT_EQ(1, q.get().value());
+  EXPECT_EQ(2, q.get().value());
+  EXPECT_EQ(3, q.get().value());
+}
+
+TEST(RWQueueTest, ClosedPendingWrite) {
+  RWQueue<int> q(makeQueueOptions(1, QueueOverflowPolicy::BLOCK));
+
+  folly::EventBase evb;
+  auto& manager = folly::fibers::getFiberManager(evb);
+  manager.addTask([&q]() mutable {
+    EXPECT_TRUE(q.push(1));
+    EXPECT_FALSE(q.push(2)); // Blocks till queue gets closed
+  });
+
+  evb.loopOnce(); // Fiber should get stuck at the second write
+  EXPECT_EQ(1, q.size());
+
+  q.close();
+  evb.loopOnce();
+  EXPECT_TRUE(q.isClosed());
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(RWQueueTest, Counters) {
+  const std::string kPrefix{"messaging.test_counters"};
+  RWQueue<int> q(makeQueueOptions(
+      2, QueueOverflowPolicy::DROP_OLDEST, false, "test_counters"));
+
+  const auto overflows = getCounter(kPrefix + ".overflows.sum");
+  const auto dropped = getCounter(kPrefix + ".dropped.sum");
+
+  EXPECT_TRUE(q.push(1));
+  EXPECT_TRUE(q.push(2));
+  EXPECT_TRUE(q.push(3));
+  EXPECT_EQ(2, q.get().value());
+  EXPECT_EQ(overflows + 1, getCounter(kPrefix + ".overflows.sum"));
+  EXPECT_EQ(dropped + 1, getCounter(kPrefix + ".dropped.sum"));
+  EXPECT_EQ(2, getCounter(kPrefix + ".depth.max"));
+
+  auto counters = facebook::fb303::fbData->getCounters();
+  EXPECT_EQ(1, counters.count(kPrefix + ".depth.avg"));
+  EXPECT_EQ(1, counters.count(kPrefix + ".latency_us.avg"));
+  EXPECT_EQ(1, counters.count(kPrefix + ".latency_us.max"));
+}
+
+TEST(RWQueueTest, PriorityClasses) {
+  const std::string kPrefix{"messaging.test_priorities"};
+  auto options = makeQueueOptions(
+      3, QueueOverflowPolicy::DROP_OLDEST, false, "test_priorities");
+  options.numPriorities = 2;
+  RWQueue<int> q(options);
+
+  // Higher class is read first, FIFO within class
+  EXPECT_TRUE(q.push(1, 1));
+  EXPECT_TRUE(q.push(2, 0));
+  EXPECT_TRUE(q.push(3, 0));
+  EXPECT_EQ(3, q.size());
+  EXPECT_EQ(std::vector<int>({2, 3, 1}), q.getBatch(3).value());
+
+  // Overflow drops from lowest class, beyond last class means last class
+  EXPECT_TRUE(q.push(4, 5));
+  EXPECT_TRUE(q.push(5, 1));
+  EXPECT_TRUE(q.push(6, 0));
+  EXPECT_TRUE(q.push(7, 0));
+  EXPECT_EQ(3, q.size());
+  EXPECT_EQ(6, q.get().value());
+  EXPECT_EQ(7, q.get().value());
+  EXPECT_EQ(5, q.get().value());
+
+  auto counters = facebook::fb303::fbData->getCounters();
+  EXPECT_EQ(1, counters.count(kPrefix + ".priority_0.latency_us.avg"));
+  EXPECT_EQ(1, counters.count(kPrefix + ".priority_1.latency_us.max"));
+}
+
+TEST(RQueueTest, BatchReadTest) {
+  auto rwq = std::make_shared<RWQueue<int>>();
+  RQueue<int> rq(rwq);
+
+  folly::EventBase evb;
+  auto& manager = folly::fibers::getFiberManager(evb);
+  manager.addTask([&rq]() mutable {
+    // Waits for first value only, then takes all available ones
+    EXPECT_EQ(std::vector<int>({1, 2, 3}), rq.getBatch(16).value());
+    EXPECT_EQ(rq.getBatch(16).error(), QueueError::QUEUE_CLOSED);
+  });
+
+  evb.loopOnce(); // Fiber should get stuck at the read
+  EXPECT_EQ(1, rwq->numPendingReads());
+
+  rwq->push(1);
+  rwq->push(2);
+  rwq->push(3);
+  evb.loopOnce(); // Fiber should get stuck at the second read
+  EXPECT_EQ(0, rwq->size());
+  EXPECT_EQ(1, rwq->numPendingReads());
+
+  rwq->close();
+  evb.loopOnce();
+  EXPECT_EQ(0, rwq->numPendingReads());
+
+#if FOLLY_HAS_COROUTINES
+  auto rwq2 = std::make_shared<RWQueue<int>>();
+  RQueue<int> rq2(rwq2);
+  auto coroRead = [](RQueue<int>& rq) -> folly::coro::Task<void> {
+    auto batch = co_await rq.getBatchCoro(2);
+    EXPECT_EQ(std::vector<int>({5, 6}), batch.value());
+  };
+
+  rwq2->push(5);
+  rwq2->push(6);
+  rwq2->push(7);
+  folly::ManualExecutor executor;
+  coroRead(rq2).scheduleOn(&executor).start();
+  executor.drain();
+  EXPECT_EQ(1, rwq2->size());
+#endif
+}
@@ -84,3 +84,55 @@ TEST(ReplicateQueueTest, OpenQueueTest) {
 
   q.close();
 }
+
+TEST(ReplicateQueueTest, SharedImmutableTest) {
+  ReplicateQueue<std::shared_ptr<const std::string>> q;
+  auto r1 = q.getReader();
+  auto r2 = q.getReader();
+  auto r3 = q.getReader();
+
+  // plain value gets wrapped once and shared by all readers
+  EXPECT_TRUE(q.push(std::string("hello")));
+  auto v1 = r1.get();
+  auto v2 = r2.get();
+  auto v3 = r3.get();
+  ASSERT_TRUE(v1.hasValue() and v2.hasValue() and v3.hasValue());
+  EXPECT_EQ("hello", *v1.value());
+  EXPECT_EQ(v1.value().get(), v2.value().get());
+  EXPECT_EQ(v1.value().get(), v3.value().get());
+
+  // shared value is pushed as is
+  auto value = std::make_shared<const std::string>("world");
+  EXPECT_TRUE(q.push(value));
+  EXPECT_EQ(value.get(), r1.get().value().get());
+  EXPECT_EQ(value.get(), r2.get().value().get());
+  EXPECT_EQ(value.get(), r3.get().value().get());
+
+  q.close();
+}
+
+TEST(ReplicateQueueTest, BoundedReaderTest) {
+  QueueOptions options;
+  options.capacity = 2;
+  options.overflowPolicy = QueueOverflowPolicy::DROP;
+  ReplicateQueue<int> q(options);
+  auto r1 = q.getReader();
+  auto r2 = q.getReader();
+
+  EXPECT_TRUE(q.push(1));
+  EXPECT_EQ(1, r1.get().value());
+
+  // r2 is full, value only gets replicated to r1
+  EXPECT_TRUE(q.push(2));
+  EXPECT_TRUE(q.push(3));
+  EXPECT_EQ(2, r1.size());
+  EXPECT_EQ(2, r2.size());
+  EXPECT_EQ(2, r1.get().value());
+  EXPECT_EQ(3, r1.get().value());
+  EXPECT_EQ(1, r2.get().value());
+  EXPECT_EQ(2, r2.get().value());
+
+  q.close();
+  EXPECT_EQ(r1.get().error(), QueueError::QUEUE_CLOSED);
+  EXPECT_EQ(r2.get().error(), QueueError::QUEUE_CLOSED);
+}
@@ -7,8 +7,12 @@
 
 #include "openr/monitor/LogSample.h"
 
+#include <type_traits>
+
 #include <folly/DynamicConverter.h>
+#include <folly/Format.h>
 #include <folly/json.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
 
 namespace {
 
@@ -23,6 +27,49 @@ const std::string STRINGTAGSET_KEY{"tagset"};
 
 const std::string kTimeCol{"time"};
 
+template <typename Map>
+const typename Map::mapped_type&
+getInnerValue(
+    const Map& values, folly::StringPiece keyType, folly::StringPiece key) {
+  auto it = values.find(key.str());
+  if (it == values.end()) {
+    throw std::invalid_argument(
+        folly::sformat("invalid key: {} with keyType: {} ", key, keyType));
+  }
+  return it->second;
+}
+
+// Json object of values, e.g. {"int-key": 123}, for non empty values only
+template <typename Map>
+void
+insertJsonValues(
+    folly::dynamic& json, const std::string& keyType, const Map& values) {
+  if (values.empty()) {
+    return;
+  }
+  auto& obj = json[keyType] = folly::dynamic::object;
+  for (const auto& [key, value] : values) {
+    if constexpr (std::is_arithmetic_v<typename Map::mapped_type> or
+                  std::is_same_v<typename Map::mapped_type, std::string>) {
+      obj[key] = value;
+    } else {
+      obj[key] = folly::dynamic(value.begin(), value.end());
+    }
+  }
+}
+
+template <typename Map>
+void
+readJsonValues(
+    const folly::dynamic& json, const std::string& keyType, Map& values) {
+  if (auto obj = json.get_ptr(keyType)) {
+    for (const auto& [key, value] : obj->items()) {
+      values[key.asString()] =
+          folly::convertTo<typename Map::mapped_type>(value);
+    }
+  }
+}
+
 } // anonymous namespace
 
 namespace openr {
@@ -31,9 +78,7 @@ LogSample::LogSample() : LogSample(std::chrono::system_clock::now()) {}
 
 LogSample::LogSample(std::chrono::system_clock::time_point timestamp)
     : timestamp_(timestamp) {
-  json_ = folly::dynamic::object;
-
-  // add the timestamp to the json sample
+  // add the timestamp to the sample
   addInt(
       kTimeCol,
       std::chrono::duration_cast<std::chrono::seconds>(
@@ -41,149 +86,127 @@ LogSample::LogSample(std::chrono::system_clock::time_point timestamp)
           .count());
 }
 
-LogSample::LogSample(
-    folly::dynamic json, std::chrono::system_clock::time_point timestamp)
-    : json_(json), timestamp_(timestamp) {}
+LogSample::LogSample(thrift::LogSampleData data)
+    : data_(std::move(data)),
+      // will throw if this sample doesn't have a timestamp
+      timestamp_(std::chrono::seconds(data_.int_values_ref()->at(kTimeCol))) {
+}
 
 LogSample
 LogSample::fromJson(const std::string& json) {
   auto dynamic = folly::parseJson(json);
-  // will throw if this sample doesn't have a timestamp
-  auto timestamp = std::chrono::system_clock::time_point(
-      std::chrono::seconds(dynamic[INT_KEY][kTimeCol].getInt()));
-  return LogSample(dynamic, timestamp);
+  thrift::LogSampleData data;
+  readJsonValues(dynamic, INT_KEY, *data.int_values_ref());
+  readJsonValues(dynamic, DOUBLE_KEY, *data.double_values_ref());
+  readJsonValues(dynamic, STRING_KEY, *data.string_values_ref());
+  readJsonValues(dynamic, STRINGVECTOR_KEY, *data.string_vector_values_ref());
+  readJsonValues(dynamic, STRINGTAGSET_KEY, *data.string_tagset_values_ref());
+  return LogSample(std::move(data));
 }
 
 std::string
 LogSample::toJson() const {
+  folly::dynamic json = folly::dynamic::object;
+  insertJsonValues(json, INT_KEY, *data_.int_values_ref());
+  insertJsonValues(json, DOUBLE_KEY, *data_.double_values_ref());
+  insertJsonValues(json, STRING_KEY, *data_.string_values_ref());
+  insertJsonValues(json, STRINGVECTOR_KEY, *data_.string_vector_values_ref());
+  insertJsonValues(json, STRINGTAGSET_KEY, *data_.string_tagset_values_ref());
+
   folly::json::serialization_opts opts;
   opts.sort_keys = true;
-  return folly::json::serialize(json_, opts);
+  return folly::json::serialize(json, opts);
+}
+
+LogSample
+LogSample::fromBinary(folly::StringPiece data) {
+  return LogSample(
+      apache::thrift::CompactSerializer::deserialize<thrift::LogSampleData>(
+          data));
 }
 
 void
-LogSample::addInt(folly::StringPiece key, int64_t value) {
-  if (json_.find(INT_KEY) == json_.items().end()) {
-    json_.insert(INT_KEY, folly::dynamic::object());
-  }
+LogSample::toBinary(std::string& data) const {
+  apache::thrift::CompactSerializer::serialize(data_, &data);
+}
 
-  json_[INT_KEY][key] = value;
+void
+LogSample::addInt(folly::StringPiece key, int64_t value) {
+  (*data_.int_values_ref())[key.str()] = value;
 }
 
 void
 LogSample::addDouble(folly::StringPiece key, double value) {
-  if (json_.find(DOUBLE_KEY) == json_.items().end()) {
-    json_.insert(DOUBLE_KEY, folly::dynamic::object());
-  }
-
-  json_[DOUBLE_KEY][key] = value;
+  (*data_.double_values_ref())[key.str()] = value;
 }
 
 void
 LogSample::addString(folly::StringPiece key, folly::StringPiece value) {
-  if (json_.find(STRING_KEY) == json_.items().end()) {
-    json_.insert(STRING_KEY, folly::dynamic::object());
-  }
-
-  json_[STRING_KEY][key] = value;
+  (*data_.string_values_ref())[key.str()] = value.str();
 }
 
 void
 LogSample::addStringVector(
     folly::StringPiece key, const std::vector<std::string>& values) {
-  if (json_.find(STRINGVECTOR_KEY) == json_.items().end()) {
-    json_.insert(STRINGVECTOR_KEY, folly::dynamic::object());
-  }
-
-  json_[STRINGVECTOR_KEY][key] = folly::dynamic(values.begin(), values.end());
+  (*data_.string_vector_values_ref())[key.str()] = values;
 }
 
 void
 LogSample::addStringTagset(
     folly::StringPiece key, const std::set<std::string>& tags) {
-  if (json_.find(STRINGTAGSET_KEY) == json_.items().end()) {
-    json_.insert(STRINGTAGSET_KEY, folly::dynamic::object());
-  }
-
-  json_[STRINGTAGSET_KEY][key] = folly::dynamic(tags.begin(), tags.end());
+  (*data_.string_tagset_values_ref())[key.str()] = tags;
 }
 
 int64_t
 LogSample::getInt(folly::StringPiece key) const {
-  return folly::convertTo<int64_t>(getInnerValue(INT_KEY, key));
+  return getInnerValue(*data_.int_values_ref(), INT_KEY, key);
 }
 
 double
 LogSample::getDouble(folly::StringPiece key) const {
-  return folly::convertTo<double>(getInnerValue(DOUBLE_KEY, key));
+  return getInnerValue(*data_.double_values_ref(), DOUBLE_KEY, key);
 }
 
 std::string
 LogSample::getString(folly::StringPiece key) const {
-  return folly::convertTo<std::string>(getInnerValue(STRING_KEY, key));
+  return getInnerValue(*data_.string_values_ref(), STRING_KEY, key);
 }
 
 std::vector<std::string>
 LogSample::getStringVector(folly::StringPiece key) const {
-  return folly::convertTo<std::vector<std::string>>(
-      getInnerValue(STRINGVECTOR_KEY, key));
+  return getInnerValue(
+      *data_.string_vector_values_ref(), STRINGVECTOR_KEY, key);
 }
 
 std::set<std::string>
 LogSample::getStringTagset(folly::StringPiece key) const {
-  return folly::convertTo<std::set<std::string>>(
-      getInnerValue(STRINGTAGSET_KEY, key));
+  return getInnerValue(
+      *data_.string_tagset_values_ref(), STRINGTAGSET_KEY, key);
 }
 
 bool
 LogSample::isIntSet(folly::StringPiece key) const {
-  return isInnerValueSet(INT_KEY, key);
+  return data_.int_values_ref()->count(key.str());
 }
 
 bool
 LogSample::isDoubleSet(folly::StringPiece key) const {
-  return isInnerValueSet(DOUBLE_KEY, key);
+  return data_.double_values_ref()->count(key.str());
 }
 
 bool
 LogSample::isStringSet(folly::StringPiece key) const {
-  return isInnerValueSet(STRING_KEY, key);
+  return data_.string_values_ref()->count(key.str());
 }
 
 bool
 LogSample::isStringVectorSet(folly::StringPiece key) const {
-  return isInnerValueSet(STRINGVECTOR_KEY, key);
+  return data_.string_vector_values_ref()->count(key.str());
 }
 
 bool
 LogSample::isStringTagsetSet(folly::StringPiece key) const {
-  return isInnerValueSet(STRINGTAGSET_KEY, key);
-}
-
-bool
-LogSample::isInnerValueSet(
-    folly::StringPiece keyType, folly::StringPiece key) const {
-  if (auto obj = json_.get_ptr(keyType)) {
-    if (auto data = obj->get_ptr(key)) {
-      (void)data;
-      return true;
-    }
-  }
-
-  return false;
-}
-
-const folly::dynamic&
-LogSample::getInnerValue(
-    folly::StringPiece keyType, folly::StringPiece key) const {
-  if (auto obj = json_.get_ptr(keyType)) {
-    if (auto data = obj->get_ptr(key)) {
-      return *data;
-    }
-  }
-
-  throw std::invalid_argument(
-      folly::sformat("invalid key: {} with keyType: {} ", key, keyType));
+  return data_.string_tagset_values_ref()->count(key.str());
 }
 
 } // namespace openr
@@ -13,7 +13,8 @@
 #include <vector>
 
 #include <folly/Range.h>
-#include <folly/dynamic.h>
+
+#include <openr/if/gen-cpp2/OpenrCtrl_types.h>
 
 namespace openr {
 
@@ -23,7 +24,9 @@ namespace openr {
  * over wire to some central monitoring service.
  *
  * This class is strictly meant to make things easier for services to create
- * samples and serialize them to json objects.
+ * samples and serialize them to json objects. Values are stored typed in
+ * thrift::LogSampleData, building json is deferred to toJson(). toBinary()
+ * is a cheaper and more compact alternative for keeping samples around.
  *
  * Example usecase:
  *    LogSample sample(std::chrono::system_clock::now());
@@ -52,9 +55,6 @@ class LogSample {
    */
   explicit LogSample(std::chrono::system_clock::time_point timestamp);
 
-  LogSample(
-      folly::dynamic json, std::chrono::system_clock::time_point timestamp);
-
   static LogSample fromJson(const std::string& json);
 
   /**
@@ -63,6 +63,14 @@ class LogSample {
    */
   std::string toJson() const;
 
+  /**
+   * Binary representation of the Sample, thrift::LogSampleData serialized with
+   * CompactSerializer. toBinary() appends to given string, letting callers
+   * reuse its buffer.
+   */
+  static LogSample fromBinary(folly::StringPiece data);
+  void toBinary(std::string& data) const;
+
   /**
    * Get the timestamp associated with this sample.
    */
@@ -102,13 +110,10 @@ class LogSample {
   bool isStringTagsetSet(folly::StringPiece key) const;
 
  private:
-  bool isInnerValueSet(
-      folly::StringPiece keyType, folly::StringPiece key) const;
-  const folly::dynamic& getInnerValue(
-      folly::StringPiece keyType, folly::StringPiece key) const;
+  explicit LogSample(thrift::LogSampleData data);
 
-  // Internal json representation of this sample
-  folly::dynamic json_ = folly::dynamic::object;
+  // Internal representation of this sample
+  thrift::LogSampleData data_;
 
   // Timepoint associated with this sample
   std::chrono::system_clock::time_point timestamp_;
@@ -6,7 +6,12 @@
  */
 
 #include "openr/monitor/MonitorBase.h"
+
+#include <algorithm>
+#include <unordered_map>
+
 #include <openr/common/Constants.h>
+#include <openr/common/LockContention.h>
 
 namespace openr {
 
@@ -17,9 +22,12 @@ MonitorBase::MonitorBase(
     : category_{category},
       maxLogEvents_{
           folly::to<uint32_t>(*config->getMonitorConfig().max_event_log_ref())},
+      eventLogSampleRates_{
+          *config->getMonitorConfig().event_log_sample_rates_ref()},
       startTime_{std::chrono::steady_clock::now()} {
   // Initialize stats counter
   fb303::fbData->addStatExportType("monitor.log.publish.failure", fb303::COUNT);
+  fb303::fbData->addStatExportType("monitor.log.sampled_out", fb303::COUNT);
 
   // Periodically set process cpu/uptime/memory counter
   setProcessCounterTimer_ =
@@ -48,19 +56,21 @@ MonitorBase::MonitorBase(
 
           // validate, process and publish the event logs
           try {
-            auto inputLog = maybeLog.value();
+            auto inputLog = std::move(maybeLog).value();
+
+            // throws std::invalid_argument if not exist
+            if (isSampledOut(inputLog.getString("event"))) {
+              fb303::fbData->addStatValue(
+                  "monitor.log.sampled_out", 1, fb303::COUNT);
+              continue;
+            }
+
             // add common attributes
             inputLog.addString("node_name", config->getNodeName());
             inputLog.addString("domain", *config->getConfig().domain_ref());
 
-            // throws std::invalid_argument if not exist
-            inputLog.getString("event");
-
-            // add to recent log list
-            if (recentLog_.size() >= maxLogEvents_) {
-              recentLog_.pop_front();
-            }
-            recentLog_.emplace_back(inputLog.toJson());
+            // add to recent logs
+            addRecentEventLog(inputLog);
 
             // publish the log if enable log submission
             if (config->isLogSubmissionEnabled()) {
@@ -78,7 +88,38 @@ MonitorBase::MonitorBase(
 
 std::list<std::string>
 MonitorBase::getRecentEventLogs() {
-  return recentLog_;
+  // oldest log is next to be overwritten
+  std::list<std::string> recentLogs;
+  for (size_t i = 0; i < recentLogs_.size(); ++i) {
+    const auto& data =
+        recentLogs_.at((recentLogsNext_ + i) % recentLogs_.size());
+    recentLogs.emplace_back(LogSample::fromBinary(data).toJson());
+  }
+  return recentLogs;
+}
+
+bool
+MonitorBase::isSampledOut(const std::string& event) {
+  auto it = eventLogSampleRates_.find(event);
+  if (it == eventLogSampleRates_.end() or it->second <= 1) {
+    return false;
+  }
+  // keep first log of event, and every N-th one after
+  return eventLogCounts_[event]++ % it->second != 0;
+}
+
+void
+MonitorBase::addRecentEventLog(LogSample const& eventLog) {
+  if (maxLogEvents_ == 0) {
+    return;
+  }
+  if (recentLogs_.size() < maxLogEvents_) {
+    recentLogs_.emplace_back();
+  }
+  auto& data = recentLogs_.at(recentLogsNext_);
+  data.clear();
+  eventLog.toBinary(data);
+  recentLogsNext_ = (recentLogsNext_ + 1) % maxLogEvents_;
 }
 
 void
@@ -96,11 +137,41 @@ MonitorBase::updateProcessCounters() {
     fb303::fbData->setCounter("process.memory.rss", rssMem.value());
   }
 
+  // set process.memory.peak_rss counter
+  const auto peakRssMem = systemMetrics_.getPeakRSSMemBytes();
+  if (peakRssMem.has_value()) {
+    fb303::fbData->setCounter("process.memory.peak_rss", peakRssMem.value());
+  }
+
   // set process.cpu.pct counter
   const auto cpuPct = systemMetrics_.getCPUpercentage();
   if (cpuPct.has_value()) {
     fb303::fbData->setCounter("process.cpu.pct", cpuPct.value());
   }
+
+  // set process.threads.<name>.* counters, summed over threads of same name
+  // e.g. of a thread pool
+  std::unordered_map<std::string, int64_t> threadCounters;
+  for (const auto& usage : systemMetrics_.getThreadUsages()) {
+    auto name = usage.name;
+    std::replace(name.begin(), name.end(), ' ', '_');
+    const auto prefix = "process.threads." + name;
+    if (usage.cpuPct.has_value()) {
+      threadCounters[prefix + ".cpu.pct"] += usage.cpuPct.value();
+    }
+    threadCounters[prefix + ".voluntary_ctx_switches"] +=
+        usage.voluntaryCtxSwitches;
+    threadCounters[prefix + ".involuntary_ctx_switches"] +=
+        usage.involuntaryCtxSwitches;
+  }
+  for (const auto& [key, value] : threadCounters) {
+    fb303::fbData->setCounter(key, value);
+  }
+
+  // set lock.<name>.* counters of lock contention
+  for (const auto& [key, value] : LockContention::getCounters()) {
+    fb303::fbData->setCounter(key, value);
+  }
 }
 
 } // namespace openr
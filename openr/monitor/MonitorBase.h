@@ -7,6 +7,10 @@
 
 #pragma once
 
+#include <map>
+#include <unordered_map>
+#include <vector>
+
 #include <folly/Function.h>
 
 #include <fb303/ServiceData.h>
@@ -25,9 +29,12 @@ namespace openr {
  * implements common functions:
  * 1. Start a fiber to read the log queue and export logs to database based on
  *    subclass's processEventLog() implementation.
- * 2. Store and return the most recent logs;
+ * 2. Store the most recent logs in a ring buffer in binary form, returned as
+ *    json on request. Logs can be sampled per "event" name, see
+ *    MonitorConfig.event_log_sample_rates;
  * 3. Export process counters: process.memory.rss, process.uptime,
- *    and process.cpu.pct
+ *    and process.cpu.pct, per thread CPU% and context switches as
+ *    process.threads.<name>.*, and lock contention as lock.<name>.*
  */
 class MonitorBase : public OpenrEventBase {
  public:
@@ -36,7 +43,7 @@ class MonitorBase : public OpenrEventBase {
       const std::string& category,
       messaging::RQueue<LogSample> logSampleQueue);
 
-  // Get recent event logs
+  // Get recent event logs as json, oldest first
   std::list<std::string> getRecentEventLogs();
 
   // Destructor
@@ -53,14 +60,28 @@ class MonitorBase : public OpenrEventBase {
   // Set process counters
   void updateProcessCounters();
 
+  // Whether to sample out a log of given event as per configured sample rate
+  bool isSampledOut(const std::string& event);
+
+  // Store log as most recent one, overwriting the oldest once full
+  void addRecentEventLog(LogSample const& eventLog);
+
   // Common information added to each log: "domain", "node-name", etc
   LogSample commonLogToMerge_;
 
   // Number of last log events to queue
   const uint32_t maxLogEvents_{0};
 
-  // List of recent log
-  std::list<std::string> recentLog_{};
+  // Ring buffer of recent logs, binary serialized. Buffers of overwritten
+  // logs are reused
+  std::vector<std::string> recentLogs_{};
+
+  // Position of the next log in recentLogs_, the oldest one once full
+  size_t recentLogsNext_{0};
+
+  // Keep 1 in N logs of an event, and number of logs seen per event
+  const std::map<std::string, int32_t> eventLogSampleRates_;
+  std::unordered_map<std::string, uint64_t> eventLogCounts_;
 
   // Timer to periodically set process cpu/uptime/memory counter
   std::unique_ptr<folly::AsyncTimeout> setProcessCounterTimer_;
@@ -7,8 +7,81 @@
 
 #include "openr/monitor/SystemMetrics.h"
 
+#include <unistd.h>
+
+#include <filesystem>
+#include <sstream>
+
+#include <folly/Conv.h>
+
 namespace openr {
 
+namespace {
+
+/* Read name and CPU time (in nanoseconds) of thread from
+ / /proc/self/task/<tid>/stat, e.g. "1234 (Decision) S 1 ... utime stime ..."
+ / Name may contain spaces and parentheses, so fields are parsed after the
+ / last ')'. utime and stime are the 14th and 15th fields, in clock ticks.
+*/
+bool
+readThreadStat(
+    const std::filesystem::path& taskDir,
+    std::string& name,
+    uint64_t& cpuTimeNs) {
+  std::ifstream input(taskDir / "stat");
+  std::string stat;
+  if (not std::getline(input, stat)) {
+    return false;
+  }
+  const auto nameStart = stat.find('(');
+  const auto nameEnd = stat.rfind(')');
+  if (nameStart == std::string::npos or nameEnd == std::string::npos or
+      nameEnd < nameStart) {
+    return false;
+  }
+  name = stat.substr(nameStart + 1, nameEnd - nameStart - 1);
+
+  // fields after name start with 3rd one, the state
+  std::istringstream fields(stat.substr(nameEnd + 1));
+  std::string field;
+  uint64_t utime{0}, stime{0};
+  for (int i = 3; i <= 15 and fields >> field; ++i) {
+    if (i == 14) {
+      utime = folly::to<uint64_t>(field);
+    } else if (i == 15) {
+      stime = folly::to<uint64_t>(field);
+    }
+  }
+  static const uint64_t ticksPerSec = sysconf(_SC_CLK_TCK);
+  cpuTimeNs = (utime + stime) * 1000000000 / ticksPerSec;
+  return true;
+}
+
+/* Read context switches of thread from /proc/self/task/<tid>/status, lines
+ / like "voluntary_ctxt_switches:        150"
+*/
+void
+readThreadCtxSwitches(
+    const std::filesystem::path& taskDir, SystemMetrics::ThreadUsage& usage) {
+  std::ifstream input(taskDir / "status");
+  std::string line;
+  while (std::getline(input, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    uint64_t value{0};
+    if (not(fields >> key >> value)) {
+      continue;
+    }
+    if (key == "voluntary_ctxt_switches:") {
+      usage.voluntaryCtxSwitches = value;
+    } else if (key == "nonvoluntary_ctxt_switches:") {
+      usage.involuntaryCtxSwitches = value;
+    }
+  }
+}
+
+} // namespace
+
 /* Return RSS memory the process currently used from /proc/[pid]/status.
  / The /proc is a pseudo-filesystem providing an API to kernel data
  / structures.
@@ -41,6 +114,20 @@ SystemMetrics::getRSSMemBytes() {
   return rss;
 }
 
+/* Return peak RSS memory of the process, i.e. its high water mark. Unlike
+ / the current RSS it tells how much memory a transient burst took.
+*/
+std::optional<size_t>
+SystemMetrics::getPeakRSSMemBytes() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    LOG(ERROR) << "Fail to get the peak memory usage of current process";
+    return std::nullopt;
+  }
+  // ru_maxrss is in kilobytes on Linux
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
 /* Return CPU% the process used
  / This need to be called twice to get the time difference
  / and calculate the CPU%.
@@ -74,6 +161,48 @@ SystemMetrics::getCPUpercentage() {
   return cpuPct;
 }
 
+/* Return usage of all threads of the process. Like getCPUpercentage(), CPU%
+ / of a thread is only known from the second query on which it is seen.
+ / Threads exiting while being read are skipped.
+*/
+std::vector<SystemMetrics::ThreadUsage>
+SystemMetrics::getThreadUsages() {
+  std::vector<ThreadUsage> usages;
+  std::unordered_map<pid_t, uint64_t> threadCpuTimes;
+  const auto timestamp = getCurrentNanoTime();
+  try {
+    for (const auto& entry :
+         std::filesystem::directory_iterator("/proc/self/task")) {
+      ThreadUsage usage;
+      uint64_t cpuTimeNs{0};
+      usage.tid = folly::to<pid_t>(entry.path().filename().string());
+      if (not readThreadStat(entry.path(), usage.name, cpuTimeNs)) {
+        continue;
+      }
+      readThreadCtxSwitches(entry.path(), usage);
+
+      // calculate the CPU% = (thread time diff) / (time elapsed) * 100
+      auto prevIt = prevThreadCpuTimes_.find(usage.tid);
+      if (prevIt != prevThreadCpuTimes_.end() and
+          timestamp > prevThreadCpuTimestamp_ and cpuTimeNs >= prevIt->second) {
+        usage.cpuPct = (double)(cpuTimeNs - prevIt->second) /
+            (double)(timestamp - prevThreadCpuTimestamp_) * 100;
+      }
+      threadCpuTimes.emplace(usage.tid, cpuTimeNs);
+      usages.emplace_back(std::move(usage));
+    }
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Fail to read the \"/proc/self/task\" of current process "
+               << "to get the thread usage: " << ex.what();
+  }
+
+  // update the cache for next CPU% update
+  prevThreadCpuTimes_ = std::move(threadCpuTimes);
+  prevThreadCpuTimestamp_ = timestamp;
+
+  return usages;
+}
+
 // get current timestamp
 uint64_t
 SystemMetrics::getCurrentNanoTime() {
@@ -13,6 +13,10 @@
 #include <sys/time.h>
 #include <chrono>
 #include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace openr {
 
@@ -25,9 +29,31 @@ class SystemMetrics {
   // get RSS memory the process used
   std::optional<size_t> getRSSMemBytes();
 
+  // get peak RSS memory the process used since it started
+  std::optional<size_t> getPeakRSSMemBytes();
+
   // get CPU% the process used
   std::optional<double> getCPUpercentage();
 
+  /**
+   * Usage of a thread of the process, read from /proc/self/task/<tid>
+   */
+  struct ThreadUsage {
+    pid_t tid{0};
+    // thread name as set by folly::setThreadName(), truncated to 15 chars
+    std::string name;
+    // CPU% the thread used since previous getThreadUsages() call, unset for
+    // threads not seen then
+    std::optional<double> cpuPct;
+    // context switches since thread start, voluntary ones are mostly waits
+    // for locks or IO, involuntary ones preemptions by the scheduler
+    uint64_t voluntaryCtxSwitches{0};
+    uint64_t involuntaryCtxSwitches{0};
+  };
+
+  // get usage of all threads of the process
+  std::vector<ThreadUsage> getThreadUsages();
+
  private:
   /**
   / To record CPU used time of current process (in nanoseconds)
@@ -50,6 +76,11 @@ class SystemMetrics {
   // cache for CPU used time of previous query
   ProcCpuTime prevCpuTime;
 
+  // cache for CPU used time of threads (in nanoseconds) of previous
+  // getThreadUsages() query, and its timestamp
+  std::unordered_map<pid_t, uint64_t> prevThreadCpuTimes_;
+  uint64_t prevThreadCpuTimestamp_{0};
+
   // get current timestamp (in nanoseconds)
   uint64_t static getCurrentNanoTime();
 };
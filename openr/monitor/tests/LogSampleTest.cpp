@@ -153,6 +153,29 @@ TEST(LogSampleTest, fromJsonTest) {
   EXPECT_THROW(LogSample::fromJson(jsonSampleNoTimeKey), std::exception);
 }
 
+TEST(LogSampleTest, BinaryTest) {
+  const auto timestamp =
+      std::chrono::system_clock::time_point(std::chrono::seconds(111));
+  LogSample sample(timestamp);
+  sample.addInt("int-key", 123);
+  sample.addDouble("double-key", 123.456);
+  sample.addString("string-key", "hello world");
+  sample.addStringVector("vector-key", {"val1", "val2"});
+  sample.addStringTagset("tagset-key", {"tag1", "tag2"});
+
+  // appends to existing data
+  std::string data{"prefix"};
+  sample.toBinary(data);
+  ASSERT_EQ("prefix", data.substr(0, 6));
+
+  auto decoded = LogSample::fromBinary(folly::StringPiece(data).subpiece(6));
+  EXPECT_EQ(timestamp, decoded.getTimestamp());
+  EXPECT_EQ(sample.toJson(), decoded.toJson());
+
+  // binary is more compact than json
+  EXPECT_LT(data.size() - 6, sample.toJson().size());
+}
+
 } // namespace openr
 
 int
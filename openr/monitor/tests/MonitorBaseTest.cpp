@@ -36,6 +36,9 @@ class MonitorTestFixture : public ::testing::Test {
     openr::thrift::OpenrConfig config;
     *config.node_name_ref() = "node1";
     *config.domain_ref() = "domain1";
+    config.monitor_config_ref()->max_event_log_ref() = kMaxEventLog;
+    config.monitor_config_ref()->event_log_sample_rates_ref() = {
+        {"event_sampled", 3}};
 
     monitor = make_unique<MonitorMock>(
         std::make_unique<openr::Config>(config),
@@ -68,6 +71,39 @@ class MonitorTestFixture : public ::testing::Test {
 
   // category for testing
   std::string category = "openr_scribe_mock_test";
+
+  // number of recent logs kept
+  static constexpr int32_t kMaxEventLog{3};
+
+  // Push a log of given event, and wait for it to be the most recent one
+  void
+  pushAndWait(const std::string& event, int64_t num) {
+    LogSample log;
+    log.addString("event", event);
+    log.addInt("num", num);
+    eventLogUpdatesQueue.push(log);
+    while (true) {
+      auto logs = monitor->getRecentEventLogs();
+      if (not logs.empty()) {
+        auto sample = LogSample::fromJson(logs.back());
+        if (sample.getString("event") == event and
+            sample.getInt("num") == num) {
+          return;
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  // Nums of recent logs, oldest first
+  std::vector<int64_t>
+  getRecentNums() {
+    std::vector<int64_t> nums;
+    for (const auto& log : monitor->getRecentEventLogs()) {
+      nums.emplace_back(LogSample::fromJson(log).getInt("num"));
+    }
+    return nums;
+  }
 };
 
 // Matcher macro for comparing LogSample in UT LogBasicOperation
@@ -110,6 +146,31 @@ TEST_F(MonitorTestFixture, LogBasicOperation) {
   }
 }
 
+TEST_F(MonitorTestFixture, RecentLogsRing) {
+  for (int64_t num = 0; num < 5; ++num) {
+    pushAndWait("event_unit_test", num);
+  }
+  // oldest logs are overwritten
+  EXPECT_EQ(std::vector<int64_t>({2, 3, 4}), getRecentNums());
+}
+
+TEST_F(MonitorTestFixture, LogSampling) {
+  // 1 in 3 logs of event_sampled are kept, starting with first one
+  for (int64_t num = 0; num < 7; ++num) {
+    LogSample log;
+    log.addString("event", "event_sampled");
+    log.addInt("num", num);
+    eventLogUpdatesQueue.push(log);
+  }
+  // events without sample rate are all kept
+  pushAndWait("event_unit_test", 7);
+  EXPECT_EQ(std::vector<int64_t>({3, 6, 7}), getRecentNums());
+  EXPECT_EQ(
+      4,
+      facebook::fb303::fbData->getCounters().at(
+          "monitor.log.sampled_out.count"));
+}
+
 TEST_F(MonitorTestFixture, ProcessCounterTest) {
   // Wait for calling getCPUpercentage() twice for calculating the cpu% counter
   while (true) {
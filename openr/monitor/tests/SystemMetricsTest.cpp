@@ -6,8 +6,13 @@
  */
 
 #include <openr/monitor/SystemMetrics.h>
+#include <folly/synchronization/Baton.h>
+#include <folly/system/ThreadName.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 using namespace std;
 using namespace openr;
@@ -35,12 +40,59 @@ TEST(MonitorTestFixture, SystemMetrics) {
   EXPECT_TRUE(rssMem2.has_value());
   EXPECT_GT(rssMem2.value(), rssMem1.value() + 100);
 
+  // Peak memory can't be lower than the current one
+  auto peakRssMem = systemMetrics_.getPeakRSSMemBytes();
+  EXPECT_TRUE(peakRssMem.has_value());
+  EXPECT_GE(peakRssMem.value(), rssMem2.value());
+
   // Expect the second cpu% query has value
   auto cpu2 = systemMetrics_.getCPUpercentage();
   EXPECT_TRUE(cpu2.has_value());
   EXPECT_GT(cpu2.value(), 0);
 }
 
+TEST(MonitorTestFixture, ThreadUsages) {
+  SystemMetrics systemMetrics_{};
+
+  // Spin in a named thread
+  std::atomic<bool> stop{false};
+  folly::Baton<> started;
+  std::thread spinner([&]() {
+    folly::setThreadName("TestSpinner");
+    started.post();
+    while (not stop.load()) {
+    }
+  });
+  started.wait();
+
+  const auto findSpinner =
+      [](const std::vector<SystemMetrics::ThreadUsage>& usages) {
+        return std::find_if(usages.begin(), usages.end(), [](const auto& u) {
+          return u.name == "TestSpinner";
+        });
+      };
+
+  // First query doesn't know CPU% yet
+  auto usages1 = systemMetrics_.getThreadUsages();
+  auto spinner1 = findSpinner(usages1);
+  ASSERT_NE(spinner1, usages1.end());
+  EXPECT_FALSE(spinner1->cpuPct.has_value());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  // Second query has CPU% of the spinning thread
+  auto usages2 = systemMetrics_.getThreadUsages();
+  auto spinner2 = findSpinner(usages2);
+  ASSERT_NE(spinner2, usages2.end());
+  EXPECT_EQ(spinner1->tid, spinner2->tid);
+  ASSERT_TRUE(spinner2->cpuPct.has_value());
+  EXPECT_GT(spinner2->cpuPct.value(), 10);
+  EXPECT_GE(spinner2->voluntaryCtxSwitches, spinner1->voluntaryCtxSwitches);
+
+  stop = true;
+  spinner.join();
+}
+
 int
 main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/nl/NetlinkInterfaceTable.h>
+
+namespace openr::fbnl {
+
+NetlinkInterfaceTable::NetlinkInterfaceTable()
+    : snapshot_(std::make_shared<const Snapshot>()) {}
+
+std::optional<int>
+NetlinkInterfaceTable::getIfIndex(const std::string& ifName) const {
+  auto snapshot = getSnapshot();
+  auto it = snapshot->ifNameToIndex.find(ifName);
+  if (it == snapshot->ifNameToIndex.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+std::optional<std::string>
+NetlinkInterfaceTable::getIfName(int ifIndex) const {
+  auto snapshot = getSnapshot();
+  auto it = snapshot->ifIndexToName.find(ifIndex);
+  if (it == snapshot->ifIndexToName.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+std::optional<int>
+NetlinkInterfaceTable::getLoopbackIfIndex() const {
+  return getSnapshot()->loopbackIfIndex;
+}
+
+size_t
+NetlinkInterfaceTable::size() const {
+  return getSnapshot()->ifIndexToName.size();
+}
+
+void
+NetlinkInterfaceTable::updateLink(const Link& link) {
+  const auto ifIndex = link.getIfIndex();
+  const auto& ifName = link.getLinkName();
+
+  std::lock_guard<std::mutex> lock(updateMutex_);
+  auto snapshot = getSnapshot();
+  auto it = snapshot->ifIndexToName.find(ifIndex);
+  const bool isKnownLoopback = snapshot->loopbackIfIndex == ifIndex;
+  if (it != snapshot->ifIndexToName.end() and it->second == ifName and
+      isKnownLoopback == link.isLoopback()) {
+    return; // No change, e.g. link state update or dump of existing links
+  }
+
+  auto newSnapshot = std::make_shared<Snapshot>(*snapshot);
+  if (it != snapshot->ifIndexToName.end()) {
+    // Link got renamed
+    newSnapshot->ifNameToIndex.erase(it->second);
+  }
+  newSnapshot->ifNameToIndex[ifName] = ifIndex;
+  newSnapshot->ifIndexToName[ifIndex] = ifName;
+  if (link.isLoopback()) {
+    newSnapshot->loopbackIfIndex = ifIndex;
+  } else if (isKnownLoopback) {
+    newSnapshot->loopbackIfIndex.reset();
+  }
+  std::atomic_store(
+      &snapshot_, std::shared_ptr<const Snapshot>(std::move(newSnapshot)));
+}
+
+void
+NetlinkInterfaceTable::removeLink(int ifIndex) {
+  std::lock_guard<std::mutex> lock(updateMutex_);
+  auto snapshot = getSnapshot();
+  auto it = snapshot->ifIndexToName.find(ifIndex);
+  if (it == snapshot->ifIndexToName.end()) {
+    return;
+  }
+
+  auto newSnapshot = std::make_shared<Snapshot>(*snapshot);
+  // Name may be taken by another link already
+  auto nameIt = newSnapshot->ifNameToIndex.find(it->second);
+  if (nameIt != newSnapshot->ifNameToIndex.end() and
+      nameIt->second == ifIndex) {
+    newSnapshot->ifNameToIndex.erase(nameIt);
+  }
+  newSnapshot->ifIndexToName.erase(ifIndex);
+  if (newSnapshot->loopbackIfIndex == ifIndex) {
+    newSnapshot->loopbackIfIndex.reset();
+  }
+  std::atomic_store(
+      &snapshot_, std::shared_ptr<const Snapshot>(std::move(newSnapshot)));
+}
+
+} // namespace openr::fbnl
@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include <openr/nl/NetlinkTypes.h>
+
+namespace openr::fbnl {
+
+/**
+ * Interface index <-> name mappings of the system, maintained from link
+ * events and link dumps received on netlink socket.
+ *
+ * Reads are lock-free and never wait on updates. Each update publishes a new
+ * immutable snapshot of the table, which is cheap as updates are rare and
+ * unchanged links don't create one.
+ */
+class NetlinkInterfaceTable final {
+ public:
+  NetlinkInterfaceTable();
+
+  std::optional<int> getIfIndex(const std::string& ifName) const;
+  std::optional<std::string> getIfName(int ifIndex) const;
+  std::optional<int> getLoopbackIfIndex() const;
+  size_t size() const;
+
+  // Add new link or update existing one with same index
+  void updateLink(const Link& link);
+
+  // Remove deleted link
+  void removeLink(int ifIndex);
+
+ private:
+  struct Snapshot {
+    std::unordered_map<std::string, int> ifNameToIndex;
+    std::unordered_map<int, std::string> ifIndexToName;
+    std::optional<int> loopbackIfIndex;
+  };
+
+  std::shared_ptr<const Snapshot>
+  getSnapshot() const {
+    return std::atomic_load(&snapshot_);
+  }
+
+  // Serializes updates, readers only load the snapshot
+  std::mutex updateMutex_;
+
+  std::shared_ptr<const Snapshot> snapshot_;
+};
+
+} // namespace openr::fbnl
@@ -9,18 +9,112 @@
 
 namespace openr::fbnl {
 
+NetlinkBatch::NetlinkBatch(
+    size_t numRequests, std::unordered_set<int> errorsToIgnore)
+    : numPending_(numRequests), errorsToIgnore_(std::move(errorsToIgnore)) {
+  if (numPending_ == 0) {
+    promise_.setValue(NetlinkBatchFailures{});
+  }
+}
+
+folly::SemiFuture<NetlinkBatchFailures>
+NetlinkBatch::getSemiFuture() {
+  return promise_.getSemiFuture();
+}
+
+void
+NetlinkBatch::setReturnStatus(size_t index, int status) {
+  CHECK_LT(0, numPending_) << "More results than requests in batch";
+  status = std::abs(status);
+  if (status != 0 and not errorsToIgnore_.count(status)) {
+    failures_.emplace_back(index, status);
+  }
+  if (--numPending_ == 0) {
+    promise_.setValue(std::move(failures_));
+  }
+}
+
+NetlinkMessagePool&
+NetlinkMessagePool::get() {
+  // Never destroyed, messages may outlive static objects on exit
+  static auto* pool = new NetlinkMessagePool();
+  return *pool;
+}
+
+std::unique_ptr<char[]>
+NetlinkMessagePool::acquirePage() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (not freePages_.empty()) {
+      auto page = std::move(freePages_.back());
+      freePages_.pop_back();
+      std::memset(page.get(), 0, kMaxNlPayloadSize);
+      return page;
+    }
+  }
+  ++numPages_;
+  return std::make_unique<char[]>(kMaxNlPayloadSize);
+}
+
+void
+NetlinkMessagePool::releasePage(std::unique_ptr<char[]> page) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (freePages_.size() < kMaxFreePages) {
+      freePages_.emplace_back(std::move(page));
+      return;
+    }
+  }
+  --numPages_;
+}
+
+std::pair<std::shared_ptr<char>, char*>
+NetlinkMessagePool::allocateChunk(uint32_t len) {
+  len = NLMSG_ALIGN(len);
+  if (len > kMaxChunkSize) {
+    return {nullptr, nullptr};
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (not slab_ or slabOffset_ + len > kSlabSize) {
+    // Start new slab. Previous one lives on with the messages in it
+    ++numSlabs_;
+    slab_ = std::shared_ptr<char>(new char[kSlabSize], [this](char* slab) {
+      --numSlabs_;
+      delete[] slab;
+    });
+    slabOffset_ = 0;
+  }
+  char* chunk = slab_.get() + slabOffset_;
+  slabOffset_ += len;
+  return {slab_, chunk};
+}
+
+NetlinkMessagePool::Stats
+NetlinkMessagePool::getStats() const {
+  Stats stats;
+  stats.numPages = numPages_;
+  stats.numSlabs = numSlabs_;
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats.numFreePages = freePages_.size();
+  return stats;
+}
+
 NetlinkMessage::NetlinkMessage()
-    : msghdr(reinterpret_cast<struct nlmsghdr*>(msg.data())) {}
+    : page_(NetlinkMessagePool::get().acquirePage()),
+      msghdr(reinterpret_cast<struct nlmsghdr*>(page_.get())) {}
 
-NetlinkMessage::NetlinkMessage(int type)
-    : msghdr(reinterpret_cast<struct nlmsghdr*>(msg.data())) {
+NetlinkMessage::NetlinkMessage(int type) : NetlinkMessage() {
   // initialize netlink header
   msghdr->nlmsg_len = NLMSG_LENGTH(0);
   msghdr->nlmsg_type = type;
 }
 
 NetlinkMessage::~NetlinkMessage() {
-  CHECK(promise_.isFulfilled());
+  CHECK(status_.has_value());
+  if (page_) {
+    NetlinkMessagePool::get().releasePage(std::move(page_));
+  }
 }
 
 struct nlmsghdr*
@@ -28,6 +122,28 @@ NetlinkMessage::getMessagePtr() {
   return msghdr;
 }
 
+const struct nlmsghdr*
+NetlinkMessage::getMessagePtr() const {
+  return msghdr;
+}
+
+void
+NetlinkMessage::shrinkToFit() {
+  if (not page_) {
+    return; // Already shrunk
+  }
+  auto& pool = NetlinkMessagePool::get();
+  auto [slab, chunk] = pool.allocateChunk(msghdr->nlmsg_len);
+  if (not slab) {
+    return; // Not worth packing
+  }
+  std::memcpy(chunk, page_.get(), msghdr->nlmsg_len);
+  slab_ = std::move(slab);
+  msghdr = reinterpret_cast<struct nlmsghdr*>(chunk);
+  capacity_ = NLMSG_ALIGN(msghdr->nlmsg_len);
+  pool.releasePage(std::move(page_));
+}
+
 uint16_t
 NetlinkMessage::getMessageType() const {
   return msghdr->nlmsg_type;
@@ -73,7 +189,7 @@ NetlinkMessage::addAttributes(
   uint32_t rtaLen = (RTA_LENGTH(len));
   uint32_t nlmsgAlen = NLMSG_ALIGN((msghdr)->nlmsg_len);
 
-  if (nlmsgAlen + RTA_ALIGN(rtaLen) > kMaxNlPayloadSize) {
+  if (nlmsgAlen + RTA_ALIGN(rtaLen) > capacity_) {
     LOG(ERROR) << "Space not available to add attribute type " << type;
     return ENOBUFS;
   }
@@ -93,16 +209,47 @@ NetlinkMessage::addAttributes(
   return 0;
 }
 
+char*
+NetlinkMessage::appendBytes(uint32_t len, struct nlmsghdr* const msghdr) {
+  uint32_t nlmsgAlen = NLMSG_ALIGN(msghdr->nlmsg_len);
+  if (nlmsgAlen + NLMSG_ALIGN(len) > capacity_) {
+    LOG(ERROR) << "Space not available to append " << len << " bytes";
+    return nullptr;
+  }
+  char* data = reinterpret_cast<char*>(msghdr) + nlmsgAlen;
+  memset(data, 0, NLMSG_ALIGN(len));
+  msghdr->nlmsg_len = nlmsgAlen + NLMSG_ALIGN(len);
+  return data;
+}
+
 folly::SemiFuture<int>
 NetlinkMessage::getSemiFuture() {
-  return promise_.getSemiFuture();
+  if (status_.has_value()) {
+    return folly::SemiFuture<int>(status_.value());
+  }
+  CHECK(not promise_.has_value()) << "Future is already retrieved";
+  promise_.emplace();
+  return promise_->getSemiFuture();
+}
+
+void
+NetlinkMessage::setBatch(std::shared_ptr<NetlinkBatch> batch, size_t index) {
+  batch_ = std::move(batch);
+  batchIndex_ = index;
 }
 
 void
 NetlinkMessage::setReturnStatus(int status) {
   VLOG(3) << "Netlink request completed. retval=" << status << ", "
           << folly::errnoStr(std::abs(status));
-  promise_.setValue(status);
+  status_ = status;
+  if (batch_) {
+    batch_->setReturnStatus(batchIndex_, status);
+    batch_.reset();
+  }
+  if (promise_.has_value()) {
+    promise_->setValue(status);
+  }
 }
 
 } // namespace openr::fbnl
@@ -7,8 +7,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <queue>
+#include <unordered_set>
+#include <vector>
 
 #include <limits.h>
 #include <linux/lwtunnel.h>
@@ -25,6 +30,94 @@ namespace openr::fbnl {
 
 constexpr uint16_t kMaxNlPayloadSize{4096};
 
+// Failed requests of a batch as pairs of index in batch and error code
+using NetlinkBatchFailures = std::vector<std::pair<size_t, int>>;
+
+/**
+ * Aggregated result of a batch of netlink requests. Instead of a promise per
+ * request, each request reports its return status with its index in the batch
+ * and a single promise is fulfilled with all failures once the last request
+ * completed. Error codes are reported as positive values.
+ *
+ * NOTE: Not thread-safe. Requests of a batch must complete in the same thread
+ */
+class NetlinkBatch final {
+ public:
+  NetlinkBatch(size_t numRequests, std::unordered_set<int> errorsToIgnore);
+
+  folly::SemiFuture<NetlinkBatchFailures> getSemiFuture();
+
+  void setReturnStatus(size_t index, int status);
+
+ private:
+  size_t numPending_{0};
+  const std::unordered_set<int> errorsToIgnore_;
+  NetlinkBatchFailures failures_;
+  folly::Promise<NetlinkBatchFailures> promise_;
+};
+
+/**
+ * Pool of buffers for netlink messages. Messages are built in a zeroed page of
+ * `kMaxNlPayloadSize` bytes, and pages are recycled instead of being freed.
+ * Once built, small messages are moved into a right-sized chunk of a shared
+ * slab page, so that queued requests (typically < 200 bytes) don't hold a
+ * full page each. A slab is freed along with the last message in it.
+ *
+ * Thread-safe. Messages are built in caller threads and destroyed in the
+ * event-base thread of the socket.
+ */
+class NetlinkMessagePool final {
+ public:
+  // Size of slab, in which multiple messages are packed
+  static constexpr uint32_t kSlabSize{kMaxNlPayloadSize};
+
+  // Larger messages are not worth packing and stay in their page
+  static constexpr uint32_t kMaxChunkSize{kSlabSize / 4};
+
+  // Maximum number of free pages retained for reuse
+  static constexpr size_t kMaxFreePages{64};
+
+  struct Stats {
+    // Pages, either in use by message or retained for reuse
+    int64_t numPages{0};
+    // Pages retained for reuse
+    int64_t numFreePages{0};
+    // Slabs with at-least one message in them
+    int64_t numSlabs{0};
+  };
+
+  // Process wide pool
+  static NetlinkMessagePool& get();
+
+  // Get zeroed page for building a message
+  std::unique_ptr<char[]> acquirePage();
+
+  // Return page to pool
+  void releasePage(std::unique_ptr<char[]> page);
+
+  // Allocate chunk of `len` bytes in a slab. Returns the slab, which must be
+  // kept alive as long as the chunk is in use, and pointer to the chunk.
+  // Returns nullptr for the slab if `len` exceeds `kMaxChunkSize`
+  std::pair<std::shared_ptr<char>, char*> allocateChunk(uint32_t len);
+
+  Stats getStats() const;
+
+ private:
+  NetlinkMessagePool() = default;
+
+  mutable std::mutex mutex_;
+
+  // Pages retained for reuse
+  std::vector<std::unique_ptr<char[]>> freePages_;
+
+  // Slab in which chunks are currently allocated and its used bytes
+  std::shared_ptr<char> slab_;
+  uint32_t slabOffset_{0};
+
+  std::atomic<int64_t> numPages_{0};
+  std::atomic<int64_t> numSlabs_{0};
+};
+
 /**
  * Data structure representing a netlink message, either to be sent or received.
  * It wraps `struct nlmsghdr` and provides buffer for appending message payload.
@@ -34,7 +127,9 @@ constexpr uint16_t kMaxNlPayloadSize{4096};
  * Aim of the message is to faciliate serialization and deserialization of
  * C++ object (application) to/from bytes (kernel).
  *
- * Maximum size of message is limited by `kMaxNlPayloadSize` parameter.
+ * Maximum size of message is limited by `kMaxNlPayloadSize` parameter. Buffer
+ * is drawn from `NetlinkMessagePool` and can be shrunk to fit the message,
+ * once built, via `shrinkToFit()`.
  */
 class NetlinkMessage {
  public:
@@ -47,6 +142,7 @@ class NetlinkMessage {
 
   // get pointer to NLMSG Header
   struct nlmsghdr* getMessagePtr();
+  const struct nlmsghdr* getMessagePtr() const;
 
   // get underlying nlmsg_type
   uint16_t getMessageType() const;
@@ -54,8 +150,13 @@ class NetlinkMessage {
   // get current length
   uint32_t getDataLength() const;
 
-  // Buffer to create message
-  std::array<char, kMaxNlPayloadSize> msg = {};
+  /**
+   * Move message into a right-sized chunk of a slab, if small enough, and
+   * return its page to the pool. Invoke this once message is built. Pointers
+   * into the previous buffer are invalidated and no more attributes can be
+   * added afterwards.
+   */
+  void shrinkToFit();
 
   /**
    * APIs for accumulating objects of `GET_<>` request. These APIs are invoked
@@ -72,6 +173,14 @@ class NetlinkMessage {
     CHECK(false) << "Must be implemented by subclass";
   }
 
+  // Whether a received route is of interest, based on its header. Invoked
+  // before parsing the route for `rcvdRoute(..)`, so that unwanted routes of
+  // a dump are skipped cheaply
+  virtual bool
+  wantsRoute(const struct rtmsg& /* rtm */) const {
+    return true;
+  }
+
   virtual void
   rcvdLink(Link&& /* link */) {
     CHECK(false) << "Must be implemented by subclass";
@@ -90,9 +199,17 @@ class NetlinkMessage {
   /**
    * Get SemiFuture associated with the the associated netlink request. Upon
    * receipt of the ack from kernel, the value will be set.
+   *
+   * The promise is only created on first call, requests which just report to
+   * a batch don't allocate one.
    */
   folly::SemiFuture<int> getSemiFuture();
 
+  /**
+   * Report return status to batch, as request at index, instead of the future
+   */
+  void setBatch(std::shared_ptr<NetlinkBatch> batch, size_t index);
+
   /**
    * Set the return value of the netlink request. Invoke this on receipt of the
    * ack. This must be invoked before class is destroyed.
@@ -119,6 +236,11 @@ class NetlinkMessage {
       uint32_t len,
       struct nlmsghdr* const msghdr);
 
+  // Append `len` zeroed bytes at end of message, e.g. for headers of nested
+  // attributes built in place, and update the length in NLMSG header.
+  // @returns pointer to appended bytes, nullptr if buffer is not large enough
+  char* appendBytes(uint32_t len, struct nlmsghdr* const msghdr);
+
   // add a sub RTA inside an RTA. The length of sub RTA will not be added into
   // the NLMSG header, but will be added to the parent RTA.
   struct rtattr* addSubAttributes(
@@ -129,11 +251,27 @@ class NetlinkMessage {
   NetlinkMessage(NetlinkMessage const&) = delete;
   NetlinkMessage& operator=(NetlinkMessage const&) = delete;
 
+  // Page in which message is built, until shrunk
+  std::unique_ptr<char[]> page_;
+
+  // Slab holding the message once shrunk
+  std::shared_ptr<char> slab_;
+
   // pointer to the netlink message header
-  struct nlmsghdr* const msghdr{nullptr};
+  struct nlmsghdr* msghdr{nullptr};
+
+  // Size of buffer pointed to by `msghdr`
+  uint32_t capacity_{kMaxNlPayloadSize};
 
   // Promise to relay the status code received from kernel
-  folly::Promise<int> promise_;
+  std::optional<folly::Promise<int>> promise_;
+
+  // Status code once the request completed
+  std::optional<int> status_;
+
+  // Batch to report status code to, if any
+  std::shared_ptr<NetlinkBatch> batch_;
+  size_t batchIndex_{0};
 
   // Timestamp when message object was created
   const std::chrono::steady_clock::time_point createTs_{
@@ -5,6 +5,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <sys/utsname.h>
+
+#include <cstdio>
 #include <thread>
 
 #include <fb303/ServiceData.h>
@@ -12,19 +15,135 @@
 #include <openr/common/Util.h>
 #include <openr/nl/NetlinkProtocolSocket.h>
 
+#ifndef SOL_NETLINK
+#define SOL_NETLINK 270
+#endif
+
+#ifndef NETLINK_GET_STRICT_CHK
+#define NETLINK_GET_STRICT_CHK 12
+#endif
+
 using facebook::fb303::fbData;
 namespace fb303 = facebook::fb303;
 
 namespace openr::fbnl {
 
+namespace {
+
+// Initialize message to add or delete route and shrink it to fit, as route
+// requests can be queued in large numbers. Returns 0 on success else
+// appropriate system error code
+int
+buildRouteMessage(
+    NetlinkRouteMessage& rtmMsg, const Route& route, bool isDelete) {
+  int status{0};
+  switch (route.getFamily()) {
+  case AF_INET:
+  case AF_INET6:
+    status = isDelete ? rtmMsg.deleteRoute(route) : rtmMsg.addRoute(route);
+    break;
+  case AF_MPLS:
+    status = isDelete ? rtmMsg.deleteLabelRoute(route)
+                      : rtmMsg.addLabelRoute(route);
+    break;
+  default:
+    status = -EPROTONOSUPPORT;
+  }
+  if (status == 0) {
+    rtmMsg.shrinkToFit();
+  }
+  return status;
+}
+
+// Same as `buildRouteMessage` for unicast route of thrift
+int
+buildUnicastRouteMessage(
+    NetlinkRouteMessage& rtmMsg,
+    const thrift::UnicastRoute& route,
+    const UnicastRouteAttrs& attrs,
+    bool isDelete) {
+  int status = isDelete ? rtmMsg.deleteUnicastRoute(route, attrs)
+                        : rtmMsg.addUnicastRoute(route, attrs);
+  if (status == 0) {
+    rtmMsg.shrinkToFit();
+  }
+  return status;
+}
+
+// Filter for routes of protocol in default v4 or v6 routing table
+Route
+buildRouteFilter(const folly::IPAddress& defaultAddr, uint8_t protocolId) {
+  RouteBuilder builder;
+  // Set address family with default route
+  builder.setDestination({defaultAddr, 0});
+  // Set protocol ID
+  builder.setProtocolId(protocolId);
+  builder.setType(RTN_UNSPEC); // Explicitly set type to 0
+  return builder.build();
+}
+
+} // namespace
+
+bool
+isIPv6RouteReplaceSupported(const std::string& kernelRelease) {
+  int major{0}, minor{0};
+  if (sscanf(kernelRelease.c_str(), "%d.%d", &major, &minor) != 2) {
+    return false;
+  }
+  return std::make_pair(major, minor) >= std::make_pair(4, 18);
+}
+
+bool
+isIPv6RouteReplaceSupported() {
+  struct utsname name;
+  if (uname(&name) != 0) {
+    return false;
+  }
+  return isIPv6RouteReplaceSupported(name.release);
+}
+
+NetlinkProtocolSocket::NetlinkProtocolSocket(
+    folly::EventBase* evb,
+    messaging::ReplicateQueue<NetlinkEvent>& netlinkEventsQ,
+    bool enableIPv6RouteReplaceSemantics,
+    bool enableRouteSocketsPerFamily,
+    uint32_t recvBufSize)
+    : NetlinkProtocolSocket(
+          SocketTag{},
+          evb,
+          netlinkEventsQ,
+          enableIPv6RouteReplaceSemantics,
+          true /* subscribeEvents */,
+          recvBufSize) {
+  if (not enableRouteSocketsPerFamily) {
+    return;
+  }
+  for (int family : {AF_INET, AF_INET6, AF_MPLS}) {
+    routeSockets_.emplace(
+        family,
+        std::unique_ptr<NetlinkProtocolSocket>(new NetlinkProtocolSocket(
+            SocketTag{},
+            evb,
+            netlinkEventsQ,
+            enableIPv6RouteReplaceSemantics,
+            false /* subscribeEvents */,
+            kNetlinkSockRecvBuf)));
+  }
+}
+
 NetlinkProtocolSocket::NetlinkProtocolSocket(
+    SocketTag,
     folly::EventBase* evb,
     messaging::ReplicateQueue<NetlinkEvent>& netlinkEventsQ,
-    bool enableIPv6RouteReplaceSemantics)
+    bool enableIPv6RouteReplaceSemantics,
+    bool subscribeEvents,
+    uint32_t recvBufSize)
     : EventHandler(evb),
       evb_(evb),
       netlinkEventsQueue_(netlinkEventsQ),
-      enableIPv6RouteReplaceSemantics_(enableIPv6RouteReplaceSemantics) {
+      enableIPv6RouteReplaceSemantics_(enableIPv6RouteReplaceSemantics),
+      subscribeEvents_(subscribeEvents),
+      recvBufSize_(std::min(recvBufSize, kNetlinkSockRecvBufMax)) {
   CHECK_NOTNULL(evb_);
 
   nlMessageTimer_ = folly::AsyncTimeout::make(*evb_, [this]() noexcept {
@@ -45,6 +164,7 @@ NetlinkProtocolSocket::NetlinkProtocolSocket(
       kv.second->setReturnStatus(-ETIMEDOUT);
     }
     nlSeqNumMap_.clear(); // Clear all timed out requests
+    shrinkMaxInFlight();
 
     LOG(INFO) << "Closing netlink socket. fd=" << nlSock_
               << ", port=" << portId_;
@@ -107,11 +227,22 @@ NetlinkProtocolSocket::init() {
   if (nlSock_ < 0) {
     LOG(FATAL) << "Netlink socket create failed.";
   }
-  int size = kNetlinkSockRecvBuf;
   // increase socket recv buffer size
-  if (setsockopt(nlSock_, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0) {
-    LOG(FATAL) << "Netlink socket set recv buffer failed.";
-  };
+  setRecvBufSize();
+
+  // Let kernel filter dumps on attributes of request, e.g. only return routes
+  // of requested protocol instead of all routes. Older kernels (< 4.20) dump
+  // everything and requests are filtered in user space only
+  int strictCheck = 1;
+  if (setsockopt(
+          nlSock_,
+          SOL_NETLINK,
+          NETLINK_GET_STRICT_CHK,
+          &strictCheck,
+          sizeof(strictCheck)) < 0) {
+    LOG(WARNING) << "Netlink socket strict dump checking not supported: "
+                 << folly::errnoStr(errno);
+  }
 
   // Bind on the source address. We let kernel chose the available port-ID
   struct sockaddr_nl saddr;
@@ -120,10 +251,12 @@ NetlinkProtocolSocket::init() {
   saddr.nl_pid = 0; // We let kernel assign the port-ID
   /* We can subscribe to different Netlink mutlicast groups for specific types
    * of events: link, IPv4/IPv6 address and neighbor. */
-  saddr.nl_groups = RTMGRP_LINK // listen for link events
-      | RTMGRP_IPV4_IFADDR // listen for IPv4 address events
-      | RTMGRP_IPV6_IFADDR // listen for IPv6 address events
-      | RTMGRP_NEIGH; // listen for Neighbor (ARP) events
+  if (subscribeEvents_) {
+    saddr.nl_groups = RTMGRP_LINK // listen for link events
+        | RTMGRP_IPV4_IFADDR // listen for IPv4 address events
+        | RTMGRP_IPV6_IFADDR // listen for IPv6 address events
+        | RTMGRP_NEIGH; // listen for Neighbor (ARP) events
+  }
 
   if (bind(nlSock_, (struct sockaddr*)&saddr, sizeof(saddr)) != 0) {
     LOG(FATAL) << "Failed to bind netlink socket: " << folly::errnoStr(errno);
@@ -210,24 +343,79 @@ NetlinkProtocolSocket::processAck(uint32_t ack, int status) {
     nlMessageTimer_->scheduleTimeout(kNlRequestAckTimeout);
   }
 
+  // Socket keeps up with a full window of acks while messages are waiting,
+  // allow more in flight
+  if (not msgQueue_.empty() and ++numAcksSinceResize_ >= maxInFlight_ and
+      maxInFlight_ < kMaxIovMsgLimit) {
+    maxInFlight_ = std::min(kMaxIovMsgLimit, maxInFlight_ + kMinIovMsg);
+    numAcksSinceResize_ = 0;
+    fbData->setCounter("netlink.requests.max_in_flight", maxInFlight_);
+  }
+
   // We've successfully completed at-least one message. Send more messages
   // if any pending. Here we add optimization to wait for some more acks and
   // send pending message in batch of atleast `kMinIovMsg`
-  if (nlSeqNumMap_.empty() or (kMaxIovMsg - nlSeqNumMap_.size() > kMinIovMsg)) {
+  if (nlSeqNumMap_.empty() or nlSeqNumMap_.size() + kMinIovMsg < maxInFlight_) {
     sendNetlinkMessage();
   }
 }
 
+void
+NetlinkProtocolSocket::setRecvBufSize() {
+  int size = recvBufSize_;
+  // SO_RCVBUFFORCE overrides `net.core.rmem_max` but needs CAP_NET_ADMIN,
+  // fall back to SO_RCVBUF capped by it
+  int ret =
+      setsockopt(nlSock_, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size));
+  if (ret < 0) {
+    ret = setsockopt(nlSock_, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+  }
+  if (ret < 0) {
+    LOG(FATAL) << "Netlink socket set recv buffer failed.";
+  }
+
+  // Kernel reports double of the size set, to account for its bookkeeping
+  int actualSize{0};
+  socklen_t len = sizeof(actualSize);
+  if (getsockopt(nlSock_, SOL_SOCKET, SO_RCVBUF, &actualSize, &len) == 0) {
+    VLOG(1) << "Netlink socket recv buffer size " << actualSize / 2
+            << " bytes, requested " << recvBufSize_;
+    if (subscribeEvents_) {
+      fbData->setCounter("netlink.recv_buffer.bytes", actualSize / 2);
+    }
+  }
+}
+
+void
+NetlinkProtocolSocket::growRecvBufSize() {
+  if (recvBufSize_ >= kNetlinkSockRecvBufMax) {
+    return;
+  }
+  recvBufSize_ = std::min(kNetlinkSockRecvBufMax, recvBufSize_ * 2);
+  LOG(INFO) << "Growing netlink socket recv buffer to " << recvBufSize_
+            << " bytes";
+  setRecvBufSize();
+}
+
+void
+NetlinkProtocolSocket::shrinkMaxInFlight() {
+  maxInFlight_ = std::max(kMaxIovMsg, maxInFlight_ / 2);
+  numAcksSinceResize_ = 0;
+  fbData->setCounter("netlink.requests.max_in_flight", maxInFlight_);
+}
+
 void
 NetlinkProtocolSocket::sendNetlinkMessage() {
   CHECK(evb_->isInEventBaseThread());
   struct sockaddr_nl nladdr = {
       .nl_family = AF_NETLINK, .nl_pad = 0, .nl_pid = 0, .nl_groups = 0};
-  CHECK_LE(nlSeqNumMap_.size(), kMaxIovMsg)
-      << "We must have capacity to send at-least one message!";
+  // Limit may have shrunk below the number of in-flight messages
+  if (nlSeqNumMap_.size() >= maxInFlight_) {
+    return;
+  }
   uint32_t count{0};
   const uint32_t iovSize =
-      std::min(msgQueue_.size(), kMaxIovMsg - nlSeqNumMap_.size());
+      std::min(msgQueue_.size(), maxInFlight_ - nlSeqNumMap_.size());
 
   if (!iovSize) {
     return;
@@ -286,6 +474,15 @@ NetlinkProtocolSocket::sendNetlinkMessage() {
     fbData->addStatValue("netlink.bytes.tx", bytesSent, fb303::SUM);
   }
   fbData->addStatValue("netlink.requests", outMsg->msg_iovlen, fb303::SUM);
+
+  const auto poolStats = NetlinkMessagePool::get().getStats();
+  fbData->setCounter("netlink.message_pool.pages", poolStats.numPages);
+  fbData->setCounter("netlink.message_pool.free_pages", poolStats.numFreePages);
+  fbData->setCounter("netlink.message_pool.slabs", poolStats.numSlabs);
+  fbData->setCounter(
+      "netlink.message_pool.bytes",
+      poolStats.numPages * kMaxNlPayloadSize +
+          poolStats.numSlabs * NetlinkMessagePool::kSlabSize);
   VLOG(2) << "Sent " << outMsg->msg_iovlen << " netlink requests on fd "
           << nlSock_;
 
@@ -311,13 +508,14 @@ NetlinkProtocolSocket::processMessage(
     switch (nlh->nlmsg_type) {
     case RTM_NEWROUTE:
     case RTM_DELROUTE: {
-      // next RTM message to be processed
-      auto route = NetlinkRouteMessage::parseMessage(nlh);
       if (nlSeqIt != nlSeqNumMap_.end()) {
         // Extend message timer as we received a valid ack
         nlMessageTimer_->scheduleTimeout(kNlRequestAckTimeout);
-        // Received route in response to request
-        nlSeqIt->second->rcvdRoute(std::move(route));
+        // Received route in response to request. Parse it only if wanted
+        const auto* rtm = reinterpret_cast<struct rtmsg*>(NLMSG_DATA(nlh));
+        if (nlSeqIt->second->wantsRoute(*rtm)) {
+          nlSeqIt->second->rcvdRoute(NetlinkRouteMessage::parseMessage(nlh));
+        }
       } else {
         // Route notification
         fbData->addStatValue("netlink.notifications.route", 1, fb303::SUM);
@@ -329,6 +527,11 @@ NetlinkProtocolSocket::processMessage(
     case RTM_NEWLINK: {
       // process link information received from netlink
       auto link = NetlinkLinkMessage::parseMessage(nlh);
+      if (nlh->nlmsg_type == RTM_NEWLINK) {
+        interfaceTable_.updateLink(link);
+      } else {
+        interfaceTable_.removeLink(link.getIfIndex());
+      }
 
       if (nlSeqIt != nlSeqNumMap_.end()) {
         // Extend message timer as we received a valid ack
@@ -450,6 +653,19 @@ NetlinkProtocolSocket::recvNetlinkMessage() {
     if (errno == EINTR || errno == EAGAIN) {
       return;
     }
+    if (errno == ENOBUFS) {
+      // Receive buffer overran and replies got dropped, send less at once
+      // and make room for bursts of messages to come
+      fbData->addStatValue("netlink.recv_buffer.overruns", 1, fb303::SUM);
+      shrinkMaxInFlight();
+      growRecvBufSize();
+
+      // Notifications may have been dropped as well, let subscribers re-sync
+      if (subscribeEvents_) {
+        fbData->addStatValue("netlink.notifications.lost", 1, fb303::SUM);
+        netlinkEventsQueue_.push(NetlinkEventsLost{});
+      }
+    }
     LOG(ERROR) << "Error in netlink socket receive: " << bytesRead
                << " err: " << folly::errnoStr(std::abs(errno));
     fbData->addStatValue("netlink.errors", 1, fb303::SUM);
@@ -482,32 +698,31 @@ NetlinkProtocolSocket::collectReturnStatus(
           });
 }
 
+NetlinkProtocolSocket&
+NetlinkProtocolSocket::getRouteSocket(int family) {
+  auto it = routeSockets_.find(family);
+  return it != routeSockets_.end() ? *it->second : *this;
+}
+
 folly::SemiFuture<int>
 NetlinkProtocolSocket::addRoute(const openr::fbnl::Route& route) {
+  if (auto& routeSocket = getRouteSocket(route.getFamily());
+      &routeSocket != this) {
+    return routeSocket.addRoute(route);
+  }
   VLOG(1) << "Netlink add route. " << route.str();
   auto rtmMsg = std::make_unique<NetlinkRouteMessage>();
   auto future = rtmMsg->getSemiFuture();
 
-  int status{0};
-  switch (route.getFamily()) {
-  case AF_INET6:
-    if (not enableIPv6RouteReplaceSemantics_) {
-      // Special case for IPv6 route add. We first delete the route and then
-      // add it.
-      // NOTE: We ignore the error for the deleteRoute
-      deleteRoute(route);
-    }
-    FOLLY_FALLTHROUGH;
-  case AF_INET:
-    status = rtmMsg->addRoute(route);
-    break;
-  case AF_MPLS:
-    status = rtmMsg->addLabelRoute(route);
-    break;
-  default:
-    status = -EPROTONOSUPPORT;
+  if (route.getFamily() == AF_INET6 and not enableIPv6RouteReplaceSemantics_) {
+    // Special case for IPv6 route add. We first delete the route and then
+    // add it.
+    // NOTE: We ignore the error for the deleteRoute
+    fbData->addStatValue("netlink.requests.replace_fallbacks", 1, fb303::SUM);
+    deleteRoute(route);
   }
 
+  int status = buildRouteMessage(*rtmMsg, route, false /* isDelete */);
   if (status != 0) {
     rtmMsg->setReturnStatus(status);
   } else {
@@ -519,23 +734,15 @@ NetlinkProtocolSocket::addRoute(const openr::fbnl::Route& route) {
 
 folly::SemiFuture<int>
 NetlinkProtocolSocket::deleteRoute(const openr::fbnl::Route& route) {
+  if (auto& routeSocket = getRouteSocket(route.getFamily());
+      &routeSocket != this) {
+    return routeSocket.deleteRoute(route);
+  }
   VLOG(1) << "Netlink delete route. " << route.str();
   auto rtmMsg = std::make_unique<openr::fbnl::NetlinkRouteMessage>();
   auto future = rtmMsg->getSemiFuture();
 
-  int status{0};
-  switch (route.getFamily()) {
-  case AF_INET:
-  case AF_INET6:
-    status = rtmMsg->deleteRoute(route);
-    break;
-  case AF_MPLS:
-    status = rtmMsg->deleteLabelRoute(route);
-    break;
-  default:
-    status = -EPROTONOSUPPORT;
-  }
-
+  int status = buildRouteMessage(*rtmMsg, route, true /* isDelete */);
   if (status != 0) {
     rtmMsg->setReturnStatus(status);
   } else {
@@ -545,6 +752,142 @@ NetlinkProtocolSocket::deleteRoute(const openr::fbnl::Route& route) {
   return future;
 }
 
+folly::SemiFuture<NetlinkBatchFailures>
+NetlinkProtocolSocket::addRoutes(
+    const std::vector<openr::fbnl::Route>& routes,
+    std::unordered_set<int> errorsToIgnore) {
+  return sendRouteBatch(
+      routes.size(),
+      [&](size_t i) { return routes.at(i).getFamily(); },
+      [&](NetlinkRouteMessage& rtmMsg, size_t i, bool isDelete) {
+        return buildRouteMessage(rtmMsg, routes.at(i), isDelete);
+      },
+      std::move(errorsToIgnore),
+      false /* isDelete */);
+}
+
+folly::SemiFuture<NetlinkBatchFailures>
+NetlinkProtocolSocket::deleteRoutes(
+    const std::vector<openr::fbnl::Route>& routes,
+    std::unordered_set<int> errorsToIgnore) {
+  return sendRouteBatch(
+      routes.size(),
+      [&](size_t i) { return routes.at(i).getFamily(); },
+      [&](NetlinkRouteMessage& rtmMsg, size_t i, bool isDelete) {
+        return buildRouteMessage(rtmMsg, routes.at(i), isDelete);
+      },
+      std::move(errorsToIgnore),
+      true /* isDelete */);
+}
+
+folly::SemiFuture<NetlinkBatchFailures>
+NetlinkProtocolSocket::addUnicastRoutes(
+    const std::vector<thrift::UnicastRoute>& routes,
+    const UnicastRouteAttrs& attrs,
+    std::unordered_set<int> errorsToIgnore) {
+  return sendRouteBatch(
+      routes.size(),
+      [&](size_t i) { return getUnicastRouteFamily(routes.at(i)); },
+      [&](NetlinkRouteMessage& rtmMsg, size_t i, bool isDelete) {
+        return buildUnicastRouteMessage(rtmMsg, routes.at(i), attrs, isDelete);
+      },
+      std::move(errorsToIgnore),
+      false /* isDelete */);
+}
+
+folly::SemiFuture<NetlinkBatchFailures>
+NetlinkProtocolSocket::sendRouteBatch(
+    size_t numRoutes,
+    folly::FunctionRef<int(size_t)> getFamily,
+    folly::FunctionRef<int(NetlinkRouteMessage&, size_t, bool)> buildMsg,
+    std::unordered_set<int> errorsToIgnore,
+    bool isDelete) {
+  VLOG(1) << "Netlink " << (isDelete ? "delete" : "add") << " batch of "
+          << numRoutes << " routes";
+  auto batch =
+      std::make_shared<NetlinkBatch>(numRoutes, std::move(errorsToIgnore));
+  auto future = batch->getSemiFuture();
+
+  // Build all messages before enqueuing any, so that only the event thread
+  // completes requests of the batch once the first one is enqueued. Messages
+  // are grouped by the socket they are sent on, all served by the event
+  // thread
+  std::unordered_map<
+      NetlinkProtocolSocket*,
+      std::vector<std::unique_ptr<NetlinkMessage>>>
+      socketMsgs;
+  size_t numReplaceFallbacks{0};
+  for (size_t i = 0; i < numRoutes; ++i) {
+    const int family = getFamily(i);
+    auto& msgs = socketMsgs[&getRouteSocket(family)];
+    if (not isDelete and family == AF_INET6 and
+        not enableIPv6RouteReplaceSemantics_) {
+      // See `addRoute`. Status of the delete is ignored
+      ++numReplaceFallbacks;
+      auto delMsg = std::make_unique<NetlinkRouteMessage>();
+      int status = buildMsg(*delMsg, i, true /* isDelete */);
+      if (status != 0) {
+        delMsg->setReturnStatus(status);
+      } else {
+        msgs.emplace_back(std::move(delMsg));
+      }
+    }
+
+    auto rtmMsg = std::make_unique<NetlinkRouteMessage>();
+    rtmMsg->setBatch(batch, i);
+    int status = buildMsg(*rtmMsg, i, isDelete);
+    if (status != 0) {
+      rtmMsg->setReturnStatus(status);
+    } else {
+      msgs.emplace_back(std::move(rtmMsg));
+    }
+  }
+  if (numReplaceFallbacks) {
+    fbData->addStatValue(
+        "netlink.requests.replace_fallbacks", numReplaceFallbacks, fb303::SUM);
+  }
+  for (auto& [socket, msgs] : socketMsgs) {
+    socket->notifQueue_.putMessages(
+        std::make_move_iterator(msgs.begin()),
+        std::make_move_iterator(msgs.end()));
+  }
+
+  return future;
+}
+
+folly::SemiFuture<int>
+NetlinkProtocolSocket::addNextHopObject(
+    const openr::fbnl::NextHopObject& nextHop) {
+  VLOG(1) << "Netlink add nexthop object. " << nextHop.str();
+  auto nhMsg = std::make_unique<openr::fbnl::NetlinkNextHopMessage>();
+  auto future = nhMsg->getSemiFuture();
+
+  int status = nhMsg->addNextHop(nextHop);
+  if (status != 0) {
+    nhMsg->setReturnStatus(status);
+  } else {
+    notifQueue_.putMessage(std::move(nhMsg));
+  }
+
+  return future;
+}
+
+folly::SemiFuture<int>
+NetlinkProtocolSocket::deleteNextHopObject(uint32_t id) {
+  VLOG(1) << "Netlink delete nexthop object " << id;
+  auto nhMsg = std::make_unique<openr::fbnl::NetlinkNextHopMessage>();
+  auto future = nhMsg->getSemiFuture();
+
+  int status = nhMsg->deleteNextHop(id);
+  if (status != 0) {
+    nhMsg->setReturnStatus(status);
+  } else {
+    notifQueue_.putMessage(std::move(nhMsg));
+  }
+
+  return future;
+}
+
 folly::SemiFuture<int>
 NetlinkProtocolSocket::addIfAddress(const openr::fbnl::IfAddress& ifAddr) {
   VLOG(1) << "Netlink add interface address. " << ifAddr.str();
@@ -641,24 +984,13 @@ NetlinkProtocolSocket::getAllRoutes() {
 
 folly::SemiFuture<folly::Expected<std::vector<fbnl::Route>, int>>
 NetlinkProtocolSocket::getIPv4Routes(uint8_t protocolId) {
-  fbnl::RouteBuilder builder;
-  // Set address family to MPLS with default v4 route
-  builder.setDestination({folly::IPAddressV4("0.0.0.0"), 0});
-  // Set protocol ID
-  builder.setProtocolId(protocolId);
-  builder.setType(RTN_UNSPEC); // Explicitly set type to 0
-  return getRoutes(builder.build());
+  return getRoutes(
+      buildRouteFilter(folly::IPAddressV4("0.0.0.0"), protocolId));
 }
 
 folly::SemiFuture<folly::Expected<std::vector<fbnl::Route>, int>>
 NetlinkProtocolSocket::getIPv6Routes(uint8_t protocolId) {
-  fbnl::RouteBuilder builder;
-  // Set address family to MPLS with default v6 route
-  builder.setDestination({folly::IPAddressV6("::"), 0});
-  // Set protocol ID
-  builder.setProtocolId(protocolId);
-  builder.setType(RTN_UNSPEC); // Explicitly set type to 0
-  return getRoutes(builder.build());
+  return getRoutes(buildRouteFilter(folly::IPAddressV6("::"), protocolId));
 }
 
 folly::SemiFuture<folly::Expected<std::vector<fbnl::Route>, int>>
@@ -671,4 +1003,35 @@ NetlinkProtocolSocket::getMplsRoutes(uint8_t protocolId) {
   return getRoutes(builder.build());
 }
 
+folly::SemiFuture<int>
+NetlinkProtocolSocket::streamRoutes(
+    const fbnl::Route& filter, std::function<void(fbnl::Route&&)> routeCb) {
+  VLOG(1) << "Netlink stream routes with filter. " << filter.str();
+  auto routeMsg = std::make_unique<openr::fbnl::NetlinkRouteMessage>();
+  routeMsg->setRouteCallback(std::move(routeCb));
+  auto future = routeMsg->getSemiFuture();
+
+  // Initialize message fields to get all routes
+  routeMsg->init(RTM_GETROUTE, 0, filter);
+  notifQueue_.putMessage(std::move(routeMsg));
+
+  return future;
+}
+
+folly::SemiFuture<int>
+NetlinkProtocolSocket::streamIPv4Routes(
+    uint8_t protocolId, std::function<void(fbnl::Route&&)> routeCb) {
+  return streamRoutes(
+      buildRouteFilter(folly::IPAddressV4("0.0.0.0"), protocolId),
+      std::move(routeCb));
+}
+
+folly::SemiFuture<int>
+NetlinkProtocolSocket::streamIPv6Routes(
+    uint8_t protocolId, std::function<void(fbnl::Route&&)> routeCb) {
+  return streamRoutes(
+      buildRouteFilter(folly::IPAddressV6("::"), protocolId),
+      std::move(routeCb));
+}
+
 } // namespace openr::fbnl
@@ -7,8 +7,12 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <folly/Function.h>
 #include <folly/IPAddress.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/AsyncTimeout.h>
@@ -17,29 +21,53 @@
 #include <folly/io/async/NotificationQueue.h>
 
 #include <openr/messaging/ReplicateQueue.h>
+#include <openr/nl/NetlinkInterfaceTable.h>
 #include <openr/nl/NetlinkMessage.h>
 #include <openr/nl/NetlinkRoute.h>
 #include <openr/nl/NetlinkTypes.h>
 
 namespace openr::fbnl {
 
-// Netlink event as union of LINK/ADDR/NEIGH event
-using NetlinkEvent = std::variant<fbnl::Link, fbnl::IfAddress, fbnl::Neighbor>;
+// Published when kernel dropped messages of the socket, e.g. on receive
+// buffer overrun. Subscribers must re-sync their state with a full dump, as
+// events got lost.
+struct NetlinkEventsLost {};
 
-// Receive socket buffer for netlink socket
+// Netlink event as union of LINK/ADDR/NEIGH event
+using NetlinkEvent = std::variant<
+    fbnl::Link,
+    fbnl::IfAddress,
+    fbnl::Neighbor,
+    fbnl::NetlinkEventsLost>;
+
+// Receive socket buffer for netlink socket. It is doubled, up to
+// `kNetlinkSockRecvBufMax`, whenever kernel drops messages for full buffer.
 constexpr uint32_t kNetlinkSockRecvBuf{1 * 1024 * 1024};
+constexpr uint32_t kNetlinkSockRecvBufMax{32 * 1024 * 1024};
 
 // Maximum number of in-flight messages. `kMinIovMsg` indicates the soft
 // requirement for sending bufferred messages.
 constexpr size_t kMaxIovMsg{500};
 constexpr size_t kMinIovMsg{200};
 
+// Upper bound for in-flight messages. The limit starts at `kMaxIovMsg` and
+// grows by `kMinIovMsg` for every window of acks drained while messages are
+// queued. It is halved, not below `kMaxIovMsg`, when replies are dropped for
+// full receive buffer or time out.
+constexpr size_t kMaxIovMsgLimit{2000};
+
 // Timeout for an ack from kernel for netlink messages we sent. The response for
 // big request (e.g. adding 5k routes or getting 10k routes) is sent back in
 // multiple parts. If we don't receive any part of below specified timeout, we
 // assume kernel is not responsive.
 constexpr std::chrono::milliseconds kNlRequestAckTimeout{1000};
 
+// Whether kernel of the given release (e.g. `uname -r`), or of the running
+// one, replaces IPv6 routes with NLM_F_REPLACE like it does for IPv4 and MPLS
+// routes, instead of appending paths. Supported since linux 4.18
+bool isIPv6RouteReplaceSupported(const std::string& kernelRelease);
+bool isIPv6RouteReplaceSupported();
+
 /**
  * C++ async interface for netlink APIs. It supports minimal functionality that
  * Open/R needs but can be easily extended to support any netlink message
@@ -63,9 +91,26 @@ constexpr std::chrono::milliseconds kNlRequestAckTimeout{1000};
  * Above threading model allows multiple requests to be sent in parallel and
  * process their response asynchronously. Outstanding requests to kernel is
  * rate-limited to not overwhelm the socket buffers. Rate-limiting of requests
- * is governed by params kMaxIovMsg and kMinIovMsg. This allows adding 100k
- * routes in under 2 seconds. These performance benchmarks can be observed
- * by running associated UTs and it might vary on different systems.
+ * is governed by params kMaxIovMsg, kMinIovMsg and kMaxIovMsgLimit. This
+ * allows adding 100k routes in under 2 seconds. These performance benchmarks
+ * can be observed by running associated UTs and it might vary on different
+ * systems. Batch APIs (e.g. `addRoutes`) additionally resolve a single future
+ * for all their requests instead of one per request.
+ *
+ * With `enableRouteSocketsPerFamily`, route add/delete requests are sent on a
+ * separate socket per address family (IPv4, IPv6 and MPLS), which doesn't
+ * subscribe to any events. Programming of one family then proceeds while
+ * another one, or a link/address dump, waits for acks. Requests of a family
+ * are still sent in order, hence requests for the same prefix are too. All
+ * sockets are served by the same event base.
+ *
+ * NOTE Event storms:
+ * On many link or address changes at once, kernel may overrun the receive
+ * buffer and drop notifications (ENOBUFS). Subscribers then get a
+ * `NetlinkEventsLost` to re-sync the state they track with a dump, and the
+ * receive buffer of the socket is doubled, up to `kNetlinkSockRecvBufMax`, so
+ * that further storms are absorbed. Growing the buffer beyond
+ * `net.core.rmem_max` requires CAP_NET_ADMIN.
  *
  * NOTE Logging:
  * Netlink protocol is tricky when it comes to debugging. To faciliate debugging
@@ -86,19 +131,30 @@ constexpr std::chrono::milliseconds kNlRequestAckTimeout{1000};
  *   netlink.requests.success : Request that completed successfully
  *   netlink.requests.error : Request with non zero return code
  *   netlink.requests.latency_ms : Average latency of netlink request
+ *   netlink.requests.max_in_flight : Current limit of in-flight requests
+ *   netlink.requests.replace_fallbacks : Route adds sent as delete and add
  *   netlink.bytes.rx : Bytes received over netlink socket
  *   netlink.bytes.tx : Bytes sent over netlink socket
+ *   netlink.message_pool.pages : Message pages, in use or free for reuse
+ *   netlink.message_pool.free_pages : Message pages free for reuse
+ *   netlink.message_pool.slabs : Slabs holding shrunk messages
+ *   netlink.message_pool.bytes : Memory of message pages and slabs
  *   netlink.notifications.link : Received link notifications
  *   netlink.notifications.addr : Received address notifications
  *   netlink.notifications.neighbors : Received neighbor notifications
  *   netlink.notifications.route : Received route notifications
+ *   netlink.notifications.lost : Receive buffer overruns dropping events
+ *   netlink.recv_buffer.overruns : Receive buffer overruns of any socket
+ *   netlink.recv_buffer.bytes : Current receive buffer size of event socket
  */
 class NetlinkProtocolSocket : public folly::EventHandler {
  public:
   explicit NetlinkProtocolSocket(
       folly::EventBase* evb,
       messaging::ReplicateQueue<NetlinkEvent>& netlinkEventsQ,
-      bool enableIPv6RouteReplaceSemantics = false);
+      bool enableIPv6RouteReplaceSemantics = false,
+      bool enableRouteSocketsPerFamily = false,
+      uint32_t recvBufSize = kNetlinkSockRecvBuf);
 
   virtual ~NetlinkProtocolSocket();
 
@@ -124,7 +180,9 @@ class NetlinkProtocolSocket : public folly::EventHandler {
    * first removes the route if destination is IPv6 and add all new paths. There
    * can be a breif period of packet drops when route is deleted and added
    * again. On kernel 4.18+ new IPv6 route replace semantics allows seamless
-   * route replace for IPv6. It can be enabeld by constructor parameter.
+   * route replace for IPv6. It can be enabeld by constructor parameter, see
+   * `isIPv6RouteReplaceSupported()`. Every route of all other families is
+   * added or replaced atomically with a single message.
    *
    * @returns 0 on success else appropriate system error code
    */
@@ -142,6 +200,51 @@ class NetlinkProtocolSocket : public folly::EventHandler {
    */
   virtual folly::SemiFuture<int> deleteRoute(const openr::fbnl::Route& route);
 
+  /**
+   * Add or replace routes as one batch, see `addRoute`. Instead of a future
+   * per route, the returned future is fulfilled once all routes completed,
+   * with index and error code of every failed route whose error is not in
+   * `errorsToIgnore`.
+   */
+  virtual folly::SemiFuture<NetlinkBatchFailures> addRoutes(
+      const std::vector<openr::fbnl::Route>& routes,
+      std::unordered_set<int> errorsToIgnore);
+
+  /**
+   * Delete routes as one batch, see `deleteRoute` and `addRoutes`.
+   */
+  virtual folly::SemiFuture<NetlinkBatchFailures> deleteRoutes(
+      const std::vector<openr::fbnl::Route>& routes,
+      std::unordered_set<int> errorsToIgnore);
+
+  /**
+   * Add or replace unicast routes of thrift as one batch, see `addRoutes`.
+   * Messages are encoded from thrift routes directly, without building a
+   * `Route` for each first. Only IP and MPLS PUSH nexthops are supported, see
+   * `NetlinkRouteMessage::addUnicastRoute`.
+   */
+  virtual folly::SemiFuture<NetlinkBatchFailures> addUnicastRoutes(
+      const std::vector<thrift::UnicastRoute>& routes,
+      const UnicastRouteAttrs& attrs,
+      std::unordered_set<int> errorsToIgnore);
+
+  /**
+   * Add nexthop object, single nexthop or group of nexthop objects, or replace
+   * the existing one with same id. Routes with `getNextHopId()` forward via
+   * the object as it changes. Requires linux 5.3+
+   *
+   * @returns 0 on success else appropriate system error code
+   */
+  virtual folly::SemiFuture<int> addNextHopObject(
+      const openr::fbnl::NextHopObject& nextHop);
+
+  /**
+   * Delete nexthop object. Kernel removes the routes still using it.
+   *
+   * @returns 0 on success else appropriate system error code
+   */
+  virtual folly::SemiFuture<int> deleteNextHopObject(uint32_t id);
+
   /**
    * Add an address to the interface
    *
@@ -201,6 +304,23 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   virtual folly::SemiFuture<folly::Expected<std::vector<fbnl::Route>, int>>
   getMplsRoutes(uint8_t protocolId);
 
+  /**
+   * Streaming variant of `getRoutes`. Instead of collecting all routes, each
+   * route matching filter is passed to `routeCb` as soon as it is parsed from
+   * the dump, so that callers can process large tables without holding them.
+   * Routes not matching protocol or type of filter are not even parsed.
+   *
+   * NOTE: Callback is invoked in the event-base thread
+   *
+   * @returns 0 on completion of dump else appropriate system error code
+   */
+  virtual folly::SemiFuture<int> streamRoutes(
+      const fbnl::Route& filter, std::function<void(fbnl::Route&&)> routeCb);
+  folly::SemiFuture<int> streamIPv4Routes(
+      uint8_t protocolId, std::function<void(fbnl::Route&&)> routeCb);
+  folly::SemiFuture<int> streamIPv6Routes(
+      uint8_t protocolId, std::function<void(fbnl::Route&&)> routeCb);
+
   /**
    * Utility function to accumulate result of multiple requests into one. The
    * result will be 0 if all the futures are successful else it will contains
@@ -210,6 +330,16 @@ class NetlinkProtocolSocket : public folly::EventHandler {
       std::vector<folly::SemiFuture<int>>&& futures,
       std::unordered_set<int> ignoredErrors = {});
 
+  /**
+   * Interface index <-> name mappings, kept up to date from link events and
+   * link dumps (e.g. `getAllLinks()`) of this socket. Lock-free to read from
+   * any thread.
+   */
+  const NetlinkInterfaceTable&
+  getInterfaceTable() const {
+    return interfaceTable_;
+  }
+
  protected:
   // Initialize netlink socket and add to eventloop for polling
   virtual void init();
@@ -220,10 +350,27 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   std::function<void(fbnl::IfAddress, bool)> addrEventCB_;
   std::function<void(fbnl::Neighbor, bool)> neighborEventCB_;
 
+  // Updated in event-base thread on link events and link dumps
+  NetlinkInterfaceTable interfaceTable_;
+
  private:
   NetlinkProtocolSocket(NetlinkProtocolSocket const&) = delete;
   NetlinkProtocolSocket& operator=(NetlinkProtocolSocket const&) = delete;
 
+  // Constructor of the main socket and of route sockets, which don't
+  // subscribe to events. See `enableRouteSocketsPerFamily`
+  struct SocketTag {};
+  NetlinkProtocolSocket(
+      SocketTag,
+      folly::EventBase* evb,
+      messaging::ReplicateQueue<NetlinkEvent>& netlinkEventsQ,
+      bool enableIPv6RouteReplaceSemantics,
+      bool subscribeEvents,
+      uint32_t recvBufSize);
+
+  // Socket to send route requests of the family on, this if none
+  NetlinkProtocolSocket& getRouteSocket(int family);
+
   // Implement EventHandler callback for reading netlink messages
   void handlerReady(uint16_t events) noexcept override;
 
@@ -243,6 +390,24 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   // Resume sending messages from queue_ if any pending
   void processAck(uint32_t ack, int status);
 
+  // Enqueue add or delete messages for routes reporting to one batch. Routes
+  // are passed by their number, address family and message builder by index
+  folly::SemiFuture<NetlinkBatchFailures> sendRouteBatch(
+      size_t numRoutes,
+      folly::FunctionRef<int(size_t)> getFamily,
+      folly::FunctionRef<int(NetlinkRouteMessage&, size_t, bool)> buildMsg,
+      std::unordered_set<int> errorsToIgnore,
+      bool isDelete);
+
+  // Halve limit of in-flight messages, e.g. on dropped replies
+  void shrinkMaxInFlight();
+
+  // Apply `recvBufSize_` to socket
+  void setRecvBufSize();
+
+  // Double receive buffer, up to kNetlinkSockRecvBufMax, on overrun
+  void growRecvBufSize();
+
   // Event base for serializing read/write requests to netlink socket. Also
   // ensure thread safety of private member variables.
   folly::EventBase* evb_{nullptr};
@@ -261,6 +426,17 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   // Use new IPv6 route replace semantics. See documentation for addRoute(...)
   const bool enableIPv6RouteReplaceSemantics_{false};
 
+  // Subscribe to link, address and neighbor events. Not set for route sockets
+  const bool subscribeEvents_{true};
+
+  // Receive buffer size of socket, grown on overruns and kept across
+  // re-creation of socket
+  uint32_t recvBufSize_{kNetlinkSockRecvBuf};
+
+  // Route sockets by address family, if enabled
+  std::unordered_map<int, std::unique_ptr<NetlinkProtocolSocket>>
+      routeSockets_;
+
   // Netlink socket fd. Created when class is constructed. Re-created on timeout
   // when no response is received for any of our pending requests.
   int nlSock_{-1};
@@ -298,6 +474,11 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   // corresponding entry from this map.
   std::unordered_map<uint32_t, std::shared_ptr<NetlinkMessage>> nlSeqNumMap_;
 
+  // Limit of in-flight messages in nlSeqNumMap_, adapted between kMaxIovMsg
+  // and kMaxIovMsgLimit, and number of acks since it was last changed
+  size_t maxInFlight_{kMaxIovMsg};
+  size_t numAcksSinceResize_{0};
+
   // Timer to help keep track of timeout of messages sent to kernel. It also
   // ensures the aliveness of the netlink socket-fd. Timer is
   // - Started when a new message is sent
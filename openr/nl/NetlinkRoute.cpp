@@ -7,15 +7,44 @@
 
 #include <openr/nl/NetlinkRoute.h>
 
+#include <algorithm>
+#include <array>
+#include <limits>
+
 namespace openr::fbnl {
 
+uint8_t
+toNetlinkWeight(int32_t weight, int32_t maxWeight) {
+  constexpr int32_t kMaxNetlinkWeight = std::numeric_limits<uint8_t>::max();
+  if (weight <= 0) {
+    return 0;
+  }
+  if (maxWeight <= kMaxNetlinkWeight) {
+    return weight;
+  }
+  return std::max<int64_t>(
+      1, static_cast<int64_t>(weight) * kMaxNetlinkWeight / maxWeight);
+}
+
+int
+getUnicastRouteFamily(const thrift::UnicastRoute& route) {
+  switch (route.dest.prefixAddress_ref()->addr.size()) {
+  case 4:
+    return AF_INET;
+  case 16:
+    return AF_INET6;
+  default:
+    return AF_UNSPEC;
+  }
+}
+
 NetlinkRouteMessage::NetlinkRouteMessage() {
   // get pointer to NLMSG header
   msghdr_ = getMessagePtr();
 }
 
 NetlinkRouteMessage::~NetlinkRouteMessage() {
-  CHECK(routePromise_.isFulfilled());
+  CHECK(not routePromise_.has_value() or routePromise_->isFulfilled());
 }
 
 void
@@ -39,12 +68,11 @@ NetlinkRouteMessage::rcvdRoute(Route&& route) {
   NextHopSet reversedMplsLabelNhs;
   bool reverted = false;
   for (auto nh : route.getNextHops()) {
-    auto pushLabels = nh.getPushLabels();
     // reverse the push labels becasue thrift API definition.
-    if (pushLabels.has_value()) {
+    if (nh.hasPushLabels()) {
       reverted = true;
-      std::reverse(pushLabels.value().begin(), pushLabels.value().end());
-      nh.setPushLabels(pushLabels.value());
+      auto const& pushLabels = nh.getPushLabelStack();
+      nh.setPushLabels({pushLabels.rbegin(), pushLabels.rend()});
     }
     reversedMplsLabelNhs.insert(nh);
   }
@@ -52,15 +80,35 @@ NetlinkRouteMessage::rcvdRoute(Route&& route) {
     route.setNextHops(reversedMplsLabelNhs);
   }
 
-  rcvdRoutes_.emplace_back(std::move(route));
+  if (routeCb_) {
+    routeCb_(std::move(route));
+  } else {
+    rcvdRoutes_.emplace_back(std::move(route));
+  }
+}
+
+bool
+NetlinkRouteMessage::wantsRoute(const struct rtmsg& rtm) const {
+  // NOTE: Table is filtered after parsing, as table ids above 255 are only
+  // reported in `RTA_TABLE` attribute
+  if (filters_.protocol && filters_.protocol != rtm.rtm_protocol) {
+    return false;
+  }
+  if (filters_.type && filters_.type != rtm.rtm_type) {
+    return false;
+  }
+  return true;
 }
 
 void
 NetlinkRouteMessage::setReturnStatus(int status) {
-  if (status == 0) {
-    routePromise_.setValue(std::move(rcvdRoutes_));
-  } else {
-    routePromise_.setValue(folly::makeUnexpected(status));
+  // Only GET requests expect routes
+  if (routePromise_.has_value()) {
+    if (status == 0) {
+      routePromise_->setValue(std::move(rcvdRoutes_));
+    } else {
+      routePromise_->setValue(folly::makeUnexpected(status));
+    }
   }
 
   NetlinkMessage::setReturnStatus(status);
@@ -80,9 +128,9 @@ NetlinkRouteMessage::init(int type, uint32_t rtFlags, const Route& route) {
   if (type == RTM_GETROUTE) {
     // Get routes matching subsequent criteria specified below
     msghdr_->nlmsg_flags |= NLM_F_DUMP;
-    // NOTE - Only `rtmsg_->rtm_family` will be used by kernel as filter
-    // parameter. Other parameters such as table, protocol, scope, type will
-    // need to be filtered on user side.
+    // NOTE - Without strict dump checking only `rtmsg_->rtm_family` will be
+    // used by kernel as filter parameter. Other parameters such as table,
+    // protocol, type are also filtered on user side.
     filters_.table = route.getRouteTable();
     filters_.type = route.getType();
     filters_.protocol = route.getProtocolId();
@@ -118,6 +166,25 @@ NetlinkRouteMessage::init(int type, uint32_t rtFlags, const Route& route) {
   if (rtFlag.has_value()) {
     rtmsg_->rtm_flags |= rtFlag.value();
   }
+
+  if (type == RTM_GETROUTE) {
+    // With strict dump checking, kernel filters on table, protocol and type
+    // and rejects values in header it can't filter on
+    rtmsg_->rtm_scope = RT_SCOPE_UNIVERSE;
+    rtmsg_->rtm_flags = 0;
+    if (route.getFamily() == AF_MPLS) {
+      // MPLS dump only filters on protocol
+      rtmsg_->rtm_table = RT_TABLE_UNSPEC;
+      rtmsg_->rtm_type = RTN_UNSPEC;
+    } else if (route.getRouteTable() != RT_TABLE_UNSPEC) {
+      const uint32_t table = route.getRouteTable();
+      addAttributes(
+          RTA_TABLE,
+          reinterpret_cast<const char*>(&table),
+          sizeof(uint32_t),
+          msghdr_);
+    }
+  }
 }
 
 void
@@ -311,19 +378,18 @@ NetlinkRouteMessage::addPushNexthop(
   // MPLS_IP_TUNNEL_DST sub attribute
   std::array<struct mpls_label, kMaxLabels> mplsLabel;
   size_t i = 0;
-  auto labels = path.getPushLabels();
-  if (!labels.has_value()) {
+  if (!path.hasPushLabels()) {
     LOG(ERROR) << "Labels not provided for PUSH action";
     return EINVAL;
   }
+  auto const& labels = path.getPushLabelStack();
   // abort immediately to bring attention
-  CHECK(labels.value().size() <= kMaxLabels);
-  std::reverse(labels.value().begin(), labels.value().end());
-  for (auto label : labels.value()) {
-    bool bos = i == labels.value().size() - 1 ? true : false;
-    mplsLabel[i++].entry = encodeLabel(label, bos);
+  CHECK(labels.size() <= kMaxLabels);
+  for (auto it = labels.rbegin(); it != labels.rend(); ++it) {
+    bool bos = i == labels.size() - 1 ? true : false;
+    mplsLabel[i++].entry = encodeLabel(*it, bos);
   }
-  size_t totalSize = labels.value().size() * sizeof(struct mpls_label);
+  size_t totalSize = labels.size() * sizeof(struct mpls_label);
   if (addSubAttributes(rta, MPLS_IPTUNNEL_DST, &mplsLabel, totalSize) ==
       nullptr) {
     return ENOBUFS;
@@ -615,6 +681,12 @@ NetlinkRouteMessage::parseMessage(const struct nlmsghdr* nlmsg) {
       routeBuilder.setPriority(*(reinterpret_cast<int*> RTA_DATA(routeAttr)));
     } break;
 
+    case kRtaNhId: {
+      // parse nexthop object id. Kernel reports expanded nexthops as well
+      routeBuilder.setNextHopId(
+          *(reinterpret_cast<uint32_t*> RTA_DATA(routeAttr)));
+    } break;
+
     // Nexthop attributes
     case RTA_GATEWAY:
     case RTA_OIF:
@@ -736,6 +808,16 @@ NetlinkRouteMessage::addRoute(const Route& route) {
     }
   }
 
+  // forward with nexthop object instead of inline nexthops
+  if (route.getNextHopId()) {
+    const uint32_t nextHopId = route.getNextHopId().value();
+    return addAttributes(
+        kRtaNhId,
+        reinterpret_cast<const char*>(&nextHopId),
+        sizeof(uint32_t),
+        msghdr_);
+  }
+
   return addNextHops(route);
 }
 
@@ -757,6 +839,188 @@ NetlinkRouteMessage::deleteRoute(const Route& route) {
   return addAttributes(RTA_DST, ipptr, ip.byteCount(), msghdr_);
 }
 
+int
+NetlinkRouteMessage::initUnicastRoute(
+    int type,
+    const thrift::UnicastRoute& route,
+    const UnicastRouteAttrs& attrs) {
+  const auto& addr = route.dest.prefixAddress_ref()->addr;
+  const int family = getUnicastRouteFamily(route);
+  const int prefixLen = *route.dest.prefixLength_ref();
+  if (family == AF_UNSPEC or prefixLen < 0 or
+      prefixLen > static_cast<int>(addr.size() * 8)) {
+    LOG(ERROR) << "Invalid destination of unicast route";
+    return EINVAL;
+  }
+
+  // initialize netlink header
+  msghdr_->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+  msghdr_->nlmsg_type = type;
+  msghdr_->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+  if (type == RTM_NEWROUTE) {
+    // We create new route or replace existing
+    msghdr_->nlmsg_flags |= NLM_F_CREATE | NLM_F_REPLACE;
+  }
+
+  // initialize route message header, as `init` does for `Route` of main
+  // table and universe scope
+  rtmsg_ = reinterpret_cast<struct rtmsg*>(NLMSG_DATA(msghdr_));
+  rtmsg_->rtm_family = family;
+  rtmsg_->rtm_dst_len = prefixLen;
+  rtmsg_->rtm_src_len = 0;
+  rtmsg_->rtm_tos = 0;
+  rtmsg_->rtm_table = RT_TABLE_MAIN;
+  rtmsg_->rtm_protocol = attrs.protocolId;
+  rtmsg_->rtm_scope = RT_SCOPE_UNIVERSE;
+  rtmsg_->rtm_type =
+      route.nextHops_ref()->empty() ? RTN_BLACKHOLE : RTN_UNICAST;
+  rtmsg_->rtm_flags = 0;
+
+  // destination with host bits cleared
+  std::array<uint8_t, 16> dst{};
+  memcpy(dst.data(), addr.data(), addr.size());
+  for (size_t i = 0; i < addr.size(); ++i) {
+    const int bits = std::clamp(prefixLen - static_cast<int>(i * 8), 0, 8);
+    dst[i] &= static_cast<uint8_t>(0xFF00 >> bits);
+  }
+  return addAttributes(
+      RTA_DST, reinterpret_cast<const char*>(dst.data()), addr.size(), msghdr_);
+}
+
+int
+NetlinkRouteMessage::addUnicastNextHops(
+    const thrift::UnicastRoute& route, const UnicastRouteAttrs& attrs) {
+  const auto& nextHops = *route.nextHops_ref();
+  int32_t maxWeight{0};
+  for (const auto& nh : nextHops) {
+    maxWeight = std::max(maxWeight, *nh.weight_ref());
+  }
+
+  // Nested attributes are appended at end of message. Length of enclosing
+  // one is set once all of its content is appended
+  char* const msgStart = reinterpret_cast<char*>(msghdr_);
+  auto msgLen = [this]() { return NLMSG_ALIGN(msghdr_->nlmsg_len); };
+
+  int status{0};
+  const uint32_t multipathOffset = msgLen();
+  if ((status = addAttributes(RTA_MULTIPATH, nullptr, 0, msghdr_))) {
+    return status;
+  }
+
+  for (const auto& nh : nextHops) {
+    const uint32_t rtnhOffset = msgLen();
+    auto* rtnh = reinterpret_cast<struct rtnexthop*>(
+        appendBytes(sizeof(struct rtnexthop), msghdr_));
+    if (rtnh == nullptr) {
+      return ENOBUFS;
+    }
+
+    const auto& address = *nh.address_ref();
+    if (address.ifName_ref().has_value()) {
+      std::optional<int> ifIndex;
+      if (attrs.getIfIndex) {
+        ifIndex = attrs.getIfIndex(*address.ifName_ref());
+      }
+      if (not ifIndex.has_value()) {
+        LOG(ERROR) << "Unknown nexthop interface " << *address.ifName_ref();
+        return ENODEV;
+      }
+      rtnh->rtnh_ifindex = ifIndex.value();
+    }
+
+    // Set weight if specified
+    const uint8_t weight = toNetlinkWeight(*nh.weight_ref(), maxWeight);
+    rtnh->rtnh_hops = weight ? weight - 1 : 0;
+
+    // RTA_ENCAP and RTA_ENCAP_TYPE for label push
+    if (nh.mplsAction_ref().has_value()) {
+      const auto& mplsAction = nh.mplsAction_ref().value();
+      if (*mplsAction.action_ref() != thrift::MplsActionCode::PUSH or
+          not mplsAction.pushLabels_ref().has_value() or
+          mplsAction.pushLabels_ref()->size() > kMaxLabels) {
+        LOG(ERROR) << "Unsupported MPLS action for unicast route";
+        return EINVAL;
+      }
+
+      // Thrift lists labels in reverse order of kernel
+      const auto& labels = mplsAction.pushLabels_ref().value();
+      std::array<struct mpls_label, kMaxLabels> mplsLabels;
+      for (size_t i = 0; i < labels.size(); ++i) {
+        mplsLabels[i].entry = encodeLabel(
+            labels[labels.size() - 1 - i], i == labels.size() - 1);
+      }
+
+      const uint32_t encapOffset = msgLen();
+      if ((status = addAttributes(RTA_ENCAP, nullptr, 0, msghdr_)) or
+          (status = addAttributes(
+               MPLS_IPTUNNEL_DST,
+               reinterpret_cast<const char*>(mplsLabels.data()),
+               labels.size() * sizeof(struct mpls_label),
+               msghdr_))) {
+        return status;
+      }
+      reinterpret_cast<struct rtattr*>(msgStart + encapOffset)->rta_len =
+          msgLen() - encapOffset;
+
+      const uint16_t encapType = LWTUNNEL_ENCAP_MPLS;
+      if ((status = addAttributes(
+               RTA_ENCAP_TYPE,
+               reinterpret_cast<const char*>(&encapType),
+               sizeof(encapType),
+               msghdr_))) {
+        return status;
+      }
+    }
+
+    // RTA_GATEWAY
+    if (address.addr.size() != 4 and address.addr.size() != 16) {
+      LOG(ERROR) << "Nexthop IP not provided";
+      return EINVAL;
+    }
+    if ((status = addAttributes(
+             RTA_GATEWAY, address.addr.data(), address.addr.size(), msghdr_))) {
+      return status;
+    }
+
+    rtnh->rtnh_len = msgLen() - rtnhOffset;
+  }
+
+  reinterpret_cast<struct rtattr*>(msgStart + multipathOffset)->rta_len =
+      msgLen() - multipathOffset;
+  return 0;
+}
+
+int
+NetlinkRouteMessage::addUnicastRoute(
+    const thrift::UnicastRoute& route, const UnicastRouteAttrs& attrs) {
+  int status{0};
+  if ((status = initUnicastRoute(RTM_NEWROUTE, route, attrs))) {
+    return status;
+  }
+
+  // set up admin distance
+  const uint32_t adminDistance = attrs.priority;
+  if ((status = addAttributes(
+           RTA_PRIORITY,
+           reinterpret_cast<const char*>(&adminDistance),
+           sizeof(uint32_t),
+           msghdr_))) {
+    return status;
+  }
+
+  // Empty nexthops is same as DROP (aka RTN_BLACKHOLE)
+  if (route.nextHops_ref()->empty()) {
+    return 0;
+  }
+  return addUnicastNextHops(route, attrs);
+}
+
+int
+NetlinkRouteMessage::deleteUnicastRoute(
+    const thrift::UnicastRoute& route, const UnicastRouteAttrs& attrs) {
+  return initUnicastRoute(RTM_DELROUTE, route, attrs);
+}
+
 int
 NetlinkRouteMessage::addLabelRoute(const Route& route) {
   init(RTM_NEWROUTE, 0, route);
@@ -854,7 +1118,10 @@ NetlinkLinkMessage::init(int type, uint32_t linkFlags) {
   ifinfomsg_ = reinterpret_cast<struct ifinfomsg*>((char*)msghdr_ + nlmsgAlen);
 
   ifinfomsg_->ifi_flags = linkFlags;
-  ifinfomsg_->ifi_change = 0xffffffff;
+  // NOTE: Strict dump checking rejects link dump requests with change mask
+  if (type != RTM_GETLINK) {
+    ifinfomsg_->ifi_change = 0xffffffff;
+  }
 }
 
 Link
@@ -883,6 +1150,96 @@ NetlinkLinkMessage::parseMessage(const struct nlmsghdr* nlmsg) {
   return link;
 }
 
+NetlinkNextHopMessage::NetlinkNextHopMessage() {
+  // get pointer to NLMSG header
+  msghdr_ = getMessagePtr();
+}
+
+void
+NetlinkNextHopMessage::init(int type, uint32_t flags) {
+  if (type != kRtmNewNextHop && type != kRtmDelNextHop) {
+    LOG(ERROR) << "Incorrect Netlink message type";
+    return;
+  }
+  // initialize netlink header
+  msghdr_->nlmsg_len = NLMSG_LENGTH(sizeof(struct NhMsg));
+  msghdr_->nlmsg_type = type;
+  msghdr_->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | flags;
+
+  // intialize the nexthop message header
+  auto nlmsgAlen = NLMSG_ALIGN(sizeof(struct nlmsghdr));
+  nhmsg_ = reinterpret_cast<struct NhMsg*>((char*)msghdr_ + nlmsgAlen);
+}
+
+int
+NetlinkNextHopMessage::addNextHop(const NextHopObject& nextHop) {
+  // Replacing an existing object updates all the routes using it
+  init(kRtmNewNextHop, NLM_F_CREATE | NLM_F_REPLACE);
+  nhmsg_->nh_family = nextHop.getFamily();
+  nhmsg_->nh_protocol = nextHop.getProtocolId();
+
+  const uint32_t id = nextHop.getId();
+  int status{0};
+  if ((status = addAttributes(
+           kNhaId,
+           reinterpret_cast<const char*>(&id),
+           sizeof(uint32_t),
+           msghdr_))) {
+    return status;
+  }
+
+  if (nextHop.isGroup()) {
+    if (nextHop.getGroup().empty()) {
+      LOG(ERROR) << "Empty nexthop group. " << nextHop.str();
+      return EINVAL;
+    }
+    std::vector<NhGroupMember> members;
+    for (auto const& [memberId, weight] : nextHop.getGroup()) {
+      NhGroupMember member{};
+      member.id = memberId;
+      // weight 0 is treated as default weight of 1
+      member.weight = weight ? weight - 1 : 0;
+      members.emplace_back(member);
+    }
+    return addAttributes(
+        kNhaGroup,
+        reinterpret_cast<const char*>(members.data()),
+        members.size() * sizeof(NhGroupMember),
+        msghdr_);
+  }
+
+  const auto& path = nextHop.getNextHop().value();
+  if (not path.getGateway().has_value() or not path.getIfIndex().has_value() or
+      path.getLabelAction().has_value()) {
+    LOG(ERROR) << "Nexthop object needs gateway and interface without label "
+               << "action. " << nextHop.str();
+    return EINVAL;
+  }
+
+  const uint32_t ifIndex = path.getIfIndex().value();
+  if ((status = addAttributes(
+           kNhaOif,
+           reinterpret_cast<const char*>(&ifIndex),
+           sizeof(uint32_t),
+           msghdr_))) {
+    return status;
+  }
+
+  const auto& gateway = path.getGateway().value();
+  return addAttributes(
+      kNhaGateway,
+      reinterpret_cast<const char*>(gateway.bytes()),
+      gateway.byteCount(),
+      msghdr_);
+}
+
+int
+NetlinkNextHopMessage::deleteNextHop(uint32_t id) {
+  init(kRtmDelNextHop, 0);
+  return addAttributes(
+      kNhaId, reinterpret_cast<const char*>(&id), sizeof(uint32_t), msghdr_);
+}
+
 NetlinkAddrMessage::NetlinkAddrMessage() {
   // get pointer to NLMSG header
   msghdr_ = getMessagePtr();
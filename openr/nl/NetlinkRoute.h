@@ -7,6 +7,10 @@
 
 #pragma once
 
+#include <functional>
+#include <optional>
+#include <string>
+
 #include <linux/lwtunnel.h>
 #include <linux/mpls.h>
 #include <linux/rtnetlink.h>
@@ -35,6 +39,49 @@ constexpr uint32_t kLabelShift{12};
 constexpr uint32_t kLabelMask{0xFFFFF000};
 constexpr uint32_t kLabelSizeBits{20};
 
+// Nexthop objects are supported since linux 5.3. Values of linux/nexthop.h and
+// linux/rtnetlink.h are replicated to build against older kernel headers
+constexpr uint16_t kRtmNewNextHop{104};
+constexpr uint16_t kRtmDelNextHop{105};
+constexpr uint16_t kRtaNhId{30};
+constexpr uint16_t kNhaId{1};
+constexpr uint16_t kNhaGroup{2};
+constexpr uint16_t kNhaOif{5};
+constexpr uint16_t kNhaGateway{6};
+
+// struct nhmsg
+struct NhMsg {
+  uint8_t nh_family;
+  uint8_t nh_scope;
+  uint8_t nh_protocol;
+  uint8_t resvd;
+  uint32_t nh_flags;
+};
+
+// struct nexthop_grp
+struct NhGroupMember {
+  uint32_t id;
+  uint8_t weight; // weight - 1
+  uint8_t resvd1;
+  uint16_t resvd2;
+};
+
+// Kernel multipath weights are 8 bit. Scale weights of a route down into
+// range if needed, keeping their ratio as far as possible. 0 (ECMP) is kept
+uint8_t toNetlinkWeight(int32_t weight, int32_t maxWeight);
+
+// Attributes of unicast routes encoded from thrift, see
+// `NetlinkRouteMessage::addUnicastRoute`
+struct UnicastRouteAttrs {
+  uint8_t protocolId{0};
+  uint32_t priority{0};
+  // Resolves interface name of nexthop to its index
+  std::function<std::optional<int>(const std::string&)> getIfIndex;
+};
+
+// Address family of thrift route, AF_UNSPEC if its destination is invalid
+int getUnicastRouteFamily(const thrift::UnicastRoute& route);
+
 /**
  * Message specialization for ROUTE object
  */
@@ -47,10 +94,20 @@ class NetlinkRouteMessage final : public NetlinkMessage {
   // Override setReturnStatus. Set routePromise_ with rcvdRoutes_
   void setReturnStatus(int status) override;
 
-  // Get future for received links in response to GET request
+  // Get future for received routes in response to GET request. Must be called
+  // before the request is sent
   folly::SemiFuture<folly::Expected<std::vector<Route>, int>>
   getRoutesSemiFuture() {
-    return routePromise_.getSemiFuture();
+    routePromise_.emplace();
+    return routePromise_->getSemiFuture();
+  }
+
+  // Stream routes received in response to GET request to callback instead of
+  // collecting them for `getRoutesSemiFuture()`. Callback is invoked in the
+  // event-base thread of socket. Must be called before the request is sent
+  void
+  setRouteCallback(std::function<void(Route&&)> routeCb) {
+    routeCb_ = std::move(routeCb);
   }
 
   // initiallize route message with default params
@@ -58,11 +115,13 @@ class NetlinkRouteMessage final : public NetlinkMessage {
 
   friend std::ostream&
   operator<<(std::ostream& out, NetlinkRouteMessage const& msg) {
-    out << "\nMessage type:     " << msg.msghdr_->nlmsg_type
-        << "\nMessage length:   " << msg.msghdr_->nlmsg_len
-        << "\nMessage flags:    " << std::hex << msg.msghdr_->nlmsg_flags
-        << "\nMessage sequence: " << msg.msghdr_->nlmsg_seq
-        << "\nMessage pid:      " << msg.msghdr_->nlmsg_pid << std::endl;
+    // NOTE: `msghdr_` is invalid once message is shrunk
+    const auto* msghdr = msg.getMessagePtr();
+    out << "\nMessage type:     " << msghdr->nlmsg_type
+        << "\nMessage length:   " << msghdr->nlmsg_len
+        << "\nMessage flags:    " << std::hex << msghdr->nlmsg_flags
+        << "\nMessage sequence: " << msghdr->nlmsg_seq
+        << "\nMessage pid:      " << msghdr->nlmsg_pid << std::endl;
     return out;
   }
 
@@ -72,6 +131,16 @@ class NetlinkRouteMessage final : public NetlinkMessage {
   // delete a route
   int deleteRoute(const Route& route);
 
+  // Add a unicast route of thrift, encoded directly into the message instead
+  // of building a `Route` first. Only IP and MPLS PUSH nexthops are
+  // supported, route without nexthops is added as blackhole
+  int addUnicastRoute(
+      const thrift::UnicastRoute& route, const UnicastRouteAttrs& attrs);
+
+  // Delete a unicast route of thrift, see `addUnicastRoute`
+  int deleteUnicastRoute(
+      const thrift::UnicastRoute& route, const UnicastRouteAttrs& attrs);
+
   // add label route
   int addLabelRoute(const Route& route);
 
@@ -121,6 +190,16 @@ class NetlinkRouteMessage final : public NetlinkMessage {
   // add set of nexthops
   int addNextHops(const Route& route);
 
+  // Initialize message with header and destination of thrift route
+  int initUnicastRoute(
+      int type,
+      const thrift::UnicastRoute& route,
+      const UnicastRouteAttrs& attrs);
+
+  // Add nexthops of thrift route as RTA_MULTIPATH, built in place
+  int addUnicastNextHops(
+      const thrift::UnicastRoute& route, const UnicastRouteAttrs& attrs);
+
   // Add ECMP paths
   int addMultiPathNexthop(
       std::array<char, kMaxNlPayloadSize>& nhop, const Route& route) const;
@@ -161,14 +240,45 @@ class NetlinkRouteMessage final : public NetlinkMessage {
  private:
   void rcvdRoute(Route&& route) override;
 
+  bool wantsRoute(const struct rtmsg& rtm) const override;
+
   struct {
     uint8_t table{0};
     uint8_t protocol{0};
     uint8_t type{0};
   } filters_;
 
-  folly::Promise<folly::Expected<std::vector<Route>, int>> routePromise_;
+  // Only created for GET requests, route add/delete don't need one
+  std::optional<folly::Promise<folly::Expected<std::vector<Route>, int>>>
+      routePromise_;
   std::vector<Route> rcvdRoutes_;
+
+  // Callback for streamed routes, if any
+  std::function<void(Route&&)> routeCb_;
+};
+
+/**
+ * Message specialization for NEXTHOP object
+ */
+class NetlinkNextHopMessage final : public NetlinkMessage {
+ public:
+  NetlinkNextHopMessage();
+
+  // initiallize nexthop message with default params
+  void init(int type, uint32_t flags);
+
+  // add nexthop object or replace the one with same id
+  int addNextHop(const NextHopObject& nextHop);
+
+  // delete nexthop object
+  int deleteNextHop(uint32_t id);
+
+ private:
+  // pointer to nexthop message header
+  struct NhMsg* nhmsg_{nullptr};
+
+  // pointer to the netlink message header
+  struct nlmsghdr* msghdr_{nullptr};
 };
 
 /**
@@ -10,6 +10,42 @@
 
 namespace openr::fbnl {
 
+namespace {
+
+// New snapshot with routes of changed protocols copied from cache, routes of
+// other protocols are shared with previous snapshot
+template <typename Routes>
+std::shared_ptr<const RoutesCacheSnapshot<Routes>>
+buildRoutesSnapshot(
+    const std::unordered_map<uint8_t, Routes>& cache,
+    const RoutesCacheSnapshot<Routes>& prevSnapshot,
+    std::unordered_set<uint8_t>& changedProtocols) {
+  auto snapshot = std::make_shared<RoutesCacheSnapshot<Routes>>(prevSnapshot);
+  for (auto protocolId : changedProtocols) {
+    auto it = cache.find(protocolId);
+    if (it == cache.end() or it->second.empty()) {
+      snapshot->erase(protocolId);
+    } else {
+      (*snapshot)[protocolId] = std::make_shared<const Routes>(it->second);
+    }
+  }
+  changedProtocols.clear();
+  return snapshot;
+}
+
+template <typename Routes>
+std::shared_ptr<const Routes>
+getSnapshotRoutes(
+    const RoutesCacheSnapshot<Routes>& snapshot, uint8_t protocolId) {
+  auto it = snapshot.find(protocolId);
+  if (it == snapshot.end()) {
+    return std::make_shared<const Routes>();
+  }
+  return it->second;
+}
+
+} // namespace
+
 NetlinkSocket::NetlinkSocket(
     fbzmq::ZmqEventLoop* evl,
     EventsHandler* handler,
@@ -173,6 +209,7 @@ NetlinkSocket::doUpdateRouteCache(Route route, bool updateUnicastRoute) {
   if (updateUnicastRoute) {
     auto& unicastRoutes = unicastRoutesCache_[route.getProtocolId()];
     if (route.isValid()) {
+      markUnicastRoutesChanged(route.getProtocolId());
       unicastRoutes.erase(prefix);
       unicastRoutes.emplace(prefix, std::move(route));
     }
@@ -308,7 +345,7 @@ NetlinkSocket::syncMplsRoutes(uint8_t protocolId, NlMplsRoutes newMplsRouteDb) {
       }
       // Go over MPLS routes in new routeDb, update/add
       for (auto& kv : syncDb) {
-        doAddUpdateMplsRoute(kv.second);
+        doAddUpdateMplsRoute(std::move(kv.second));
       }
       p.setValue();
       LOG(INFO) << "Sync done.";
@@ -321,21 +358,21 @@ NetlinkSocket::syncMplsRoutes(uint8_t protocolId, NlMplsRoutes newMplsRouteDb) {
   return future;
 }
 
-folly::Future<NlMplsRoutes>
+folly::Future<std::shared_ptr<const NlMplsRoutes>>
 NetlinkSocket::getCachedMplsRoutes(uint8_t protocolId) const {
   VLOG(3) << "NetlinkSocket get cached MPLS routes by protocol "
           << (int)protocolId;
-  folly::Promise<NlMplsRoutes> promise;
+  if (not mplsRoutesChanged_.load(std::memory_order_acquire)) {
+    return folly::makeFuture(
+        getSnapshotRoutes(*mplsRoutesSnapshot_.load(), protocolId));
+  }
+
+  folly::Promise<std::shared_ptr<const NlMplsRoutes>> promise;
   auto future = promise.getFuture();
 
   evl_->runImmediatelyOrInEventLoop(
       [this, p = std::move(promise), protocolId]() mutable {
-        auto iter = mplsRoutesCache_.find(protocolId);
-        if (iter != mplsRoutesCache_.end()) {
-          p.setValue(iter->second);
-        } else {
-          p.setValue(NlMplsRoutes{});
-        }
+        p.setValue(getSnapshotRoutes(*publishMplsRoutes(), protocolId));
       });
   return future;
 }
@@ -372,6 +409,7 @@ NetlinkSocket::doAddUpdateUnicastRoute(Route route) {
   }
 
   // Remove route from cache
+  markUnicastRoutesChanged(route.getProtocolId());
   unicastRoutes.erase(dest);
 
   // Add new route
@@ -446,6 +484,7 @@ NetlinkSocket::doDeleteMplsRoute(Route mplsRoute) {
         folly::sformat("Failed to delete MPLS route: {}", label.value()), err);
   }
   // Update local cache with removed prefix
+  markMplsRoutesChanged(mplsRoute.getProtocolId());
   mplsRoutes.erase(label.value());
 }
 
@@ -465,6 +504,7 @@ NetlinkSocket::doAddUpdateMplsRoute(Route mplsRoute) {
     return;
   }
 
+  markMplsRoutesChanged(mplsRoute.getProtocolId());
   mplsRoutes.erase(label.value());
   int err = static_cast<int>(nlSock_->addRoute(mplsRoute).get());
   if (err != 0 && std::abs(err) != EEXIST) {
@@ -498,6 +538,7 @@ NetlinkSocket::doDeleteUnicastRoute(Route route) {
   }
 
   // Update local cache with removed prefix
+  markUnicastRoutesChanged(route.getProtocolId());
   unicastRoutes.erase(route.getDestination());
 }
 
@@ -551,29 +592,65 @@ NetlinkSocket::doSyncUnicastRoutes(uint8_t protocolId, NlUnicastRoutes syncDb) {
   // Go over routes in new routeDb, update/add
   LOG(INFO) << "Sync: number of routes to add: " << syncDb.size();
   for (auto& kv : syncDb) {
-    doAddUpdateUnicastRoute(kv.second);
+    doAddUpdateUnicastRoute(std::move(kv.second));
   }
 }
 
-folly::Future<NlUnicastRoutes>
+folly::Future<std::shared_ptr<const NlUnicastRoutes>>
 NetlinkSocket::getCachedUnicastRoutes(uint8_t protocolId) const {
   VLOG(3) << "NetlinkSocket getCachedUnicastRoutes by protocol "
           << (int)protocolId;
-  folly::Promise<NlUnicastRoutes> promise;
+  if (not unicastRoutesChanged_.load(std::memory_order_acquire)) {
+    return folly::makeFuture(
+        getSnapshotRoutes(*unicastRoutesSnapshot_.load(), protocolId));
+  }
+
+  folly::Promise<std::shared_ptr<const NlUnicastRoutes>> promise;
   auto future = promise.getFuture();
 
   evl_->runImmediatelyOrInEventLoop(
       [this, p = std::move(promise), protocolId]() mutable {
-        auto iter = unicastRoutesCache_.find(protocolId);
-        if (iter != unicastRoutesCache_.end()) {
-          p.setValue(iter->second);
-        } else {
-          p.setValue(NlUnicastRoutes{});
-        }
+        p.setValue(getSnapshotRoutes(*publishUnicastRoutes(), protocolId));
       });
   return future;
 }
 
+void
+NetlinkSocket::markUnicastRoutesChanged(uint8_t protocolId) {
+  changedUnicastProtocols_.emplace(protocolId);
+  unicastRoutesChanged_.store(true, std::memory_order_release);
+}
+
+void
+NetlinkSocket::markMplsRoutesChanged(uint8_t protocolId) {
+  changedMplsProtocols_.emplace(protocolId);
+  mplsRoutesChanged_.store(true, std::memory_order_release);
+}
+
+std::shared_ptr<const RoutesCacheSnapshot<NlUnicastRoutes>>
+NetlinkSocket::publishUnicastRoutes() const {
+  auto snapshot = unicastRoutesSnapshot_.load();
+  if (not changedUnicastProtocols_.empty()) {
+    snapshot = buildRoutesSnapshot(
+        unicastRoutesCache_, *snapshot, changedUnicastProtocols_);
+    unicastRoutesSnapshot_.store(snapshot, std::memory_order_release);
+  }
+  unicastRoutesChanged_.store(false, std::memory_order_release);
+  return snapshot;
+}
+
+std::shared_ptr<const RoutesCacheSnapshot<NlMplsRoutes>>
+NetlinkSocket::publishMplsRoutes() const {
+  auto snapshot = mplsRoutesSnapshot_.load();
+  if (not changedMplsProtocols_.empty()) {
+    snapshot = buildRoutesSnapshot(
+        mplsRoutesCache_, *snapshot, changedMplsProtocols_);
+    mplsRoutesSnapshot_.store(snapshot, std::memory_order_release);
+  }
+  mplsRoutesChanged_.store(false, std::memory_order_release);
+  return snapshot;
+}
+
 folly::Future<int64_t>
 NetlinkSocket::getRouteCount() const {
   VLOG(3) << "NetlinkSocket get routes number";
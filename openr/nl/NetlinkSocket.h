@@ -7,10 +7,16 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
 #include <fbzmq/async/ZmqEventLoop.h>
 #include <folly/ConcurrentBitSet.h>
 #include <folly/IPAddress.h>
 #include <folly/String.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
 #include <folly/futures/Future.h>
 #include <openr/nl/NetlinkProtocolSocket.h>
 
@@ -30,6 +36,11 @@ struct PrefixCmp {
   }
 };
 
+// Immutable snapshot of route cache by protocol ID
+template <typename Routes>
+using RoutesCacheSnapshot =
+    std::unordered_map<uint8_t, std::shared_ptr<const Routes>>;
+
 /**
  * A general netlink class provides APIs that interact with kernel on route
  * programming, iface/address management, iface/route/address monitoring,
@@ -209,18 +220,20 @@ class NetlinkSocket {
       uint8_t protocolId, NlMplsRoutes newMplsRouteDb);
 
   /**
-   * Get cached unicast routing by protocol ID
+   * Get cached unicast routing by protocol ID, as immutable snapshot shared
+   * with other readers instead of a copy. Reads don't wait for event loop
+   * unless routes changed since the last read.
    * @throws fbnl::NlException
    */
-  virtual folly::Future<NlUnicastRoutes> getCachedUnicastRoutes(
-      uint8_t protocolId) const;
+  virtual folly::Future<std::shared_ptr<const NlUnicastRoutes>>
+  getCachedUnicastRoutes(uint8_t protocolId) const;
 
   /**
-   * Get cached MPLS routes by protocol ID
+   * Get cached MPLS routes by protocol ID, see getCachedUnicastRoutes
    * @throws fbnl::NlException
    */
-  virtual folly::Future<NlMplsRoutes> getCachedMplsRoutes(
-      uint8_t protocolId) const;
+  virtual folly::Future<std::shared_ptr<const NlMplsRoutes>>
+  getCachedMplsRoutes(uint8_t protocolId) const;
 
   /**
    * Get number of all cached routes
@@ -353,6 +366,16 @@ class NetlinkSocket {
 
   void doUpdateRouteCache(Route route, bool updateUnicastRoute = false);
 
+  // Mark cached routes of protocol as changed since last snapshot
+  void markUnicastRoutesChanged(uint8_t protocolId);
+  void markMplsRoutesChanged(uint8_t protocolId);
+
+  // Publish snapshot of route caches with changed protocols, in event loop
+  std::shared_ptr<const RoutesCacheSnapshot<NlUnicastRoutes>>
+  publishUnicastRoutes() const;
+  std::shared_ptr<const RoutesCacheSnapshot<NlMplsRoutes>>
+  publishMplsRoutes() const;
+
   void doAddUpdateUnicastRoute(Route route);
 
   void doDeleteUnicastRoute(Route route);
@@ -395,6 +418,23 @@ class NetlinkSocket {
    */
   NlMplsRoutesDb mplsRoutesCache_;
 
+  /**
+   * Snapshots of route caches for readers. Published lazily by the first read
+   * after cache changed, copying only routes of changed protocols.
+   */
+  mutable folly::atomic_shared_ptr<const RoutesCacheSnapshot<NlUnicastRoutes>>
+      unicastRoutesSnapshot_{
+          std::make_shared<const RoutesCacheSnapshot<NlUnicastRoutes>>()};
+  mutable folly::atomic_shared_ptr<const RoutesCacheSnapshot<NlMplsRoutes>>
+      mplsRoutesSnapshot_{
+          std::make_shared<const RoutesCacheSnapshot<NlMplsRoutes>>()};
+
+  // Protocols changed since last snapshot. Sets are accessed in event loop
+  mutable std::atomic<bool> unicastRoutesChanged_{false};
+  mutable std::atomic<bool> mplsRoutesChanged_{false};
+  mutable std::unordered_set<uint8_t> changedUnicastProtocols_;
+  mutable std::unordered_set<uint8_t> changedMplsProtocols_;
+
   EventsHandler* handler_{nullptr};
 
   std::optional<int> loopbackIfIndex_;
@@ -7,6 +7,8 @@
 
 #include <set>
 
+#include <folly/String.h>
+#include <folly/hash/Hash.h>
 #include <glog/logging.h>
 
 #include <openr/nl/NetlinkTypes.h>
@@ -222,6 +224,17 @@ RouteBuilder::getNextHops() const {
   return nextHops_;
 }
 
+RouteBuilder&
+RouteBuilder::setNextHopId(uint32_t nextHopId) {
+  nextHopId_ = nextHopId;
+  return *this;
+}
+
+std::optional<uint32_t>
+RouteBuilder::getNextHopId() const {
+  return nextHopId_;
+}
+
 uint8_t
 RouteBuilder::getFamily() const {
   return family_;
@@ -252,6 +265,7 @@ RouteBuilder::reset() {
   advMss_.reset();
   nextHops_.clear();
   routeIfName_.reset();
+  nextHopId_.reset();
 }
 
 Route::Route(const RouteBuilder& builder)
@@ -269,7 +283,8 @@ Route::Route(const RouteBuilder& builder)
       nextHops_(builder.getNextHops()),
       dst_(builder.getDestination()),
       routeIfName_(builder.getRouteIfName()),
-      mplsLabel_(builder.getMplsLabel()) {}
+      mplsLabel_(builder.getMplsLabel()),
+      nextHopId_(builder.getNextHopId()) {}
 
 Route::~Route() {}
 
@@ -297,6 +312,7 @@ Route::operator=(Route&& other) noexcept {
   routeIfName_ = std::move(other.routeIfName_);
   family_ = std::move(other.family_);
   mplsLabel_ = std::move(other.mplsLabel_);
+  nextHopId_ = std::move(other.nextHopId_);
   return *this;
 }
 
@@ -324,6 +340,7 @@ Route::operator=(const Route& other) {
   routeIfName_ = other.routeIfName_;
   family_ = other.family_;
   mplsLabel_ = other.mplsLabel_;
+  nextHopId_ = other.nextHopId_;
   return *this;
 }
 
@@ -341,7 +358,8 @@ operator==(const Route& lhs, const Route& rhs) {
        lhs.getPriority() == rhs.getPriority() && lhs.getTos() == rhs.getTos() &&
        lhs.getMtu() == rhs.getMtu() && lhs.getAdvMss() == rhs.getAdvMss() &&
        lhs.getRouteIfName() == rhs.getRouteIfName() &&
-       lhs.getFamily() == rhs.getFamily());
+       lhs.getFamily() == rhs.getFamily() &&
+       lhs.getNextHopId() == rhs.getNextHopId());
 
   if (!ret) {
     return false;
@@ -422,6 +440,11 @@ Route::getNextHops() const {
   return nextHops_;
 }
 
+std::optional<uint32_t>
+Route::getNextHopId() const {
+  return nextHopId_;
+}
+
 std::optional<std::string>
 Route::getRouteIfName() const {
   return routeIfName_;
@@ -468,6 +491,9 @@ Route::str() const {
   if (advMss_) {
     result += folly::sformat(", advmss {}", advMss_.value());
   }
+  if (nextHopId_) {
+    result += folly::sformat(", nhid {}", nextHopId_.value());
+  }
   for (auto const& nextHop : nextHops_) {
     result += "\n  " + nextHop.str();
   }
@@ -484,6 +510,69 @@ Route::setNextHops(const NextHopSet& nextHops) {
   nextHops_ = nextHops;
 }
 
+void
+Route::setNextHopId(uint32_t nextHopId) {
+  nextHopId_ = nextHopId;
+}
+
+/*==============================NextHopObject=================================*/
+
+NextHopObject::NextHopObject(
+    uint32_t id, uint8_t protocolId, const NextHop& nextHop)
+    : id_(id), protocolId_(protocolId), nextHop_(nextHop) {}
+
+NextHopObject::NextHopObject(
+    uint32_t id,
+    uint8_t protocolId,
+    std::vector<std::pair<uint32_t, uint8_t>> group)
+    : id_(id), protocolId_(protocolId), group_(std::move(group)) {}
+
+uint32_t
+NextHopObject::getId() const {
+  return id_;
+}
+
+uint8_t
+NextHopObject::getProtocolId() const {
+  return protocolId_;
+}
+
+uint8_t
+NextHopObject::getFamily() const {
+  if (nextHop_.has_value() and nextHop_->getGateway().has_value()) {
+    return nextHop_->getGateway()->family();
+  }
+  return AF_UNSPEC;
+}
+
+const std::optional<NextHop>&
+NextHopObject::getNextHop() const {
+  return nextHop_;
+}
+
+const std::vector<std::pair<uint32_t, uint8_t>>&
+NextHopObject::getGroup() const {
+  return group_;
+}
+
+bool
+NextHopObject::isGroup() const {
+  return not nextHop_.has_value();
+}
+
+std::string
+NextHopObject::str() const {
+  std::string result = folly::sformat("nhid {} proto {}", id_, protocolId_);
+  if (nextHop_.has_value()) {
+    return result + ", " + nextHop_->str();
+  }
+  std::vector<std::string> members;
+  for (auto const& [memberId, weight] : group_) {
+    members.emplace_back(folly::sformat("{}/{}", memberId, weight));
+  }
+  return result + ", group " + folly::join(",", members);
+}
+
 /*=================================NextHop====================================*/
 
 NextHop
@@ -577,47 +666,64 @@ NextHopBuilder::getFamily() const {
 }
 
 NextHop::NextHop(const NextHopBuilder& builder)
-    : ifIndex_(builder.getIfIndex()),
-      gateway_(builder.getGateway()),
-      weight_(builder.getWeight()),
-      labelAction_(builder.getLabelAction()),
-      swapLabel_(builder.getSwapLabel()),
-      pushLabels_(builder.getPushLabels()),
-      family_(builder.getFamily()) {}
+    : weight_(builder.getWeight()) {
+  if (auto ifIndex = builder.getIfIndex()) {
+    ifIndex_ = *ifIndex;
+    fields_ |= IF_INDEX;
+  }
+  if (auto gateway = builder.getGateway()) {
+    gateway_ = *gateway;
+  }
+  if (auto labelAction = builder.getLabelAction()) {
+    labelAction_ = *labelAction;
+    fields_ |= LABEL_ACTION;
+  }
+  if (auto swapLabel = builder.getSwapLabel()) {
+    swapLabel_ = *swapLabel;
+    fields_ |= SWAP_LABEL;
+  }
+  if (auto pushLabels = builder.getPushLabels()) {
+    pushLabels_.assign(pushLabels->begin(), pushLabels->end());
+    fields_ |= PUSH_LABELS;
+  }
+
+  // Same fields as before compaction, weights 0 and 1 are equivalent
+  hash_ = folly::hash::hash_combine(
+      has(IF_INDEX) ? ifIndex_ : -1,
+      gateway_.empty() ? 0 : gateway_.hash(),
+      std::max(weight_, uint8_t(1)));
+}
 
 bool
 operator==(const NextHop& lhs, const NextHop& rhs) {
-  return lhs.getIfIndex() == rhs.getIfIndex() &&
-      lhs.getGateway() == rhs.getGateway() &&
-      std::max(lhs.getWeight(), uint8_t(1)) ==
-      std::max(rhs.getWeight(), uint8_t(1)) &&
-      lhs.getLabelAction() == rhs.getLabelAction() &&
-      lhs.getSwapLabel() == rhs.getSwapLabel() &&
-      lhs.getPushLabels() == rhs.getPushLabels() &&
-      lhs.getFamily() == rhs.getFamily();
+  return lhs.hash_ == rhs.hash_ && lhs.fields_ == rhs.fields_ &&
+      (!lhs.has(NextHop::IF_INDEX) || lhs.ifIndex_ == rhs.ifIndex_) &&
+      lhs.gateway_ == rhs.gateway_ &&
+      std::max(lhs.weight_, uint8_t(1)) == std::max(rhs.weight_, uint8_t(1)) &&
+      (!lhs.has(NextHop::LABEL_ACTION) ||
+       lhs.labelAction_ == rhs.labelAction_) &&
+      (!lhs.has(NextHop::SWAP_LABEL) || lhs.swapLabel_ == rhs.swapLabel_) &&
+      lhs.pushLabels_ == rhs.pushLabels_;
 }
 
 size_t
 NextHopHash::operator()(const NextHop& nh) const {
-  size_t res = 0;
-  if (nh.getIfIndex().has_value()) {
-    res += std::hash<std::string>()(std::to_string(nh.getIfIndex().value()));
-  }
-  if (nh.getGateway().has_value()) {
-    res += std::hash<std::string>()(nh.getGateway().value().str());
-  }
-  res += std::hash<std::string>()(
-      std::to_string(std::max(nh.getWeight(), uint8_t(1))));
-  return res;
+  return nh.hash();
 }
 
 std::optional<int>
 NextHop::getIfIndex() const {
+  if (!has(IF_INDEX)) {
+    return std::nullopt;
+  }
   return ifIndex_;
 }
 
 std::optional<folly::IPAddress>
 NextHop::getGateway() const {
+  if (gateway_.empty()) {
+    return std::nullopt;
+  }
   return gateway_;
 }
 
@@ -628,28 +734,49 @@ NextHop::getWeight() const {
 
 std::optional<thrift::MplsActionCode>
 NextHop::getLabelAction() const {
+  if (!has(LABEL_ACTION)) {
+    return std::nullopt;
+  }
   return labelAction_;
 }
 
 std::optional<uint32_t>
 NextHop::getSwapLabel() const {
+  if (!has(SWAP_LABEL)) {
+    return std::nullopt;
+  }
   return swapLabel_;
 }
 
 std::optional<std::vector<int32_t>>
 NextHop::getPushLabels() const {
+  if (!has(PUSH_LABELS)) {
+    return std::nullopt;
+  }
+  return std::vector<int32_t>(pushLabels_.begin(), pushLabels_.end());
+}
+
+bool
+NextHop::hasPushLabels() const {
+  return has(PUSH_LABELS);
+}
+
+const NextHop::PushLabels&
+NextHop::getPushLabelStack() const {
   return pushLabels_;
 }
 
 void
 NextHop::setPushLabels(std::vector<int32_t> pushLabels) {
-  pushLabels_ = pushLabels;
+  // Push labels are not part of the hash
+  pushLabels_.assign(pushLabels.begin(), pushLabels.end());
+  fields_ |= PUSH_LABELS;
 }
 
 uint8_t
 NextHop::getFamily() const {
-  if (gateway_.has_value()) {
-    return gateway_.value().family();
+  if (!gateway_.empty()) {
+    return gateway_.family();
   }
   return AF_UNSPEC;
 }
@@ -659,20 +786,19 @@ NextHop::str() const {
   std::string result;
   result += folly::sformat(
       "nexthop via {}, intf-index {}, weight {}",
-      (gateway_ ? gateway_->str() : "n/a"),
-      (ifIndex_ ? std::to_string(*ifIndex_) : "n/a"),
+      (!gateway_.empty() ? gateway_.str() : "n/a"),
+      (has(IF_INDEX) ? std::to_string(ifIndex_) : "n/a"),
       std::to_string(weight_));
-  if (labelAction_.has_value()) {
+  if (has(LABEL_ACTION)) {
     result += folly::sformat(
-        " Label action {}",
-        apache::thrift::util::enumNameSafe(labelAction_.value()));
+        " Label action {}", apache::thrift::util::enumNameSafe(labelAction_));
   }
-  if (swapLabel_.has_value()) {
-    result += folly::sformat(" Swap label {}", swapLabel_.value());
+  if (has(SWAP_LABEL)) {
+    result += folly::sformat(" Swap label {}", swapLabel_);
   }
-  if (pushLabels_.has_value()) {
+  if (has(PUSH_LABELS)) {
     result += " Push Labels: ";
-    for (const auto& label : pushLabels_.value()) {
+    for (const auto& label : pushLabels_) {
       result += folly::sformat(" {} ", label);
     }
   }
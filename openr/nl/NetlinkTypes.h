@@ -15,6 +15,7 @@
 #include <folly/IPAddress.h>
 #include <folly/MacAddress.h>
 #include <folly/Optional.h>
+#include <folly/small_vector.h>
 #include <thrift/lib/cpp2/Thrift.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
@@ -95,9 +96,19 @@ class NextHopBuilder final {
   std::optional<uint8_t> family_;
 };
 
-// NOTE: No special copy+move constructor and assignment operators for this one
+/**
+ * Next-hop of a route. Kept compact as routes over large ECMP groups hold
+ * many of them: unset fields are tracked in a bitmask instead of with
+ * std::optional, short label stacks are stored inline and the hash is
+ * computed once on construction.
+ *
+ * NOTE: No special copy+move constructor and assignment operators for this one
+ */
 class NextHop final {
  public:
+  // Label stack, stored inline up to a typical segment routing depth
+  using PushLabels = folly::small_vector<int32_t, 4>;
+
   explicit NextHop(const NextHopBuilder& builder);
 
   std::optional<int> getIfIndex() const;
@@ -114,18 +125,43 @@ class NextHop final {
 
   std::optional<std::vector<int32_t>> getPushLabels() const;
 
+  // Push labels without a copy, valid if hasPushLabels()
+  bool hasPushLabels() const;
+  const PushLabels& getPushLabelStack() const;
+
   void setPushLabels(std::vector<int32_t>);
 
   uint8_t getFamily() const;
 
+  size_t
+  hash() const {
+    return hash_;
+  }
+
  private:
-  std::optional<int> ifIndex_;
-  std::optional<folly::IPAddress> gateway_;
+  friend bool operator==(const NextHop& lhs, const NextHop& rhs);
+
+  // Bits of fields_ of optional fields which are set
+  enum Field : uint8_t {
+    IF_INDEX = 1 << 0,
+    LABEL_ACTION = 1 << 1,
+    SWAP_LABEL = 1 << 2,
+    PUSH_LABELS = 1 << 3,
+  };
+
+  bool
+  has(Field field) const {
+    return fields_ & field;
+  }
+
+  folly::IPAddress gateway_; // empty if not set
+  PushLabels pushLabels_;
+  size_t hash_{0};
+  int ifIndex_{0};
+  uint32_t swapLabel_{0};
+  thrift::MplsActionCode labelAction_{thrift::MplsActionCode::PUSH};
   uint8_t weight_{0}; // default weight is 0
-  std::optional<thrift::MplsActionCode> labelAction_;
-  std::optional<uint32_t> swapLabel_;
-  std::optional<std::vector<int32_t>> pushLabels_;
-  std::optional<uint8_t> family_;
+  uint8_t fields_{0};
 };
 
 bool operator==(const NextHop& lhs, const NextHop& rhs);
@@ -248,6 +284,12 @@ class RouteBuilder {
 
   RouteBuilder& addNextHop(const NextHop& nextHop);
 
+  // Kernel nexthop object (group) to forward with instead of the nexthops.
+  // Nexthops can still be set to describe the route.
+  RouteBuilder& setNextHopId(uint32_t nextHopId);
+
+  std::optional<uint32_t> getNextHopId() const;
+
   RouteBuilder& setRouteIfName(const std::string& ifName);
 
   std::optional<std::string> getRouteIfName() const;
@@ -280,6 +322,7 @@ class RouteBuilder {
   std::optional<int> routeIfIndex_; // for multicast or link route
   std::optional<std::string> routeIfName_; // for multicast or linkroute
   std::optional<uint32_t> mplsLabel_;
+  std::optional<uint32_t> nextHopId_;
 };
 
 class Route final {
@@ -320,6 +363,8 @@ class Route final {
 
   const NextHopSet& getNextHops() const;
 
+  std::optional<uint32_t> getNextHopId() const;
+
   bool isValid() const;
 
   std::optional<std::string> getRouteIfName() const;
@@ -330,6 +375,8 @@ class Route final {
 
   void setNextHops(const NextHopSet& nextHops);
 
+  void setNextHopId(uint32_t nextHopId);
+
  private:
   uint8_t type_{RTN_UNICAST};
   uint8_t routeTable_{RT_TABLE_MAIN};
@@ -346,10 +393,50 @@ class Route final {
   folly::CIDRNetwork dst_;
   std::optional<std::string> routeIfName_;
   std::optional<uint32_t> mplsLabel_;
+  std::optional<uint32_t> nextHopId_;
 };
 
 bool operator==(const Route& lhs, const Route& rhs);
 
+/**
+ * Kernel nexthop object (RTM_NEWNEXTHOP, linux 5.3+). It is either a single
+ * nexthop via gateway and interface, or a group of other nexthop objects with
+ * weights. Routes refer to it by id instead of carrying their own nexthops, so
+ * all routes sharing a group can be updated with a single group update.
+ */
+class NextHopObject final {
+ public:
+  // single nexthop, label actions are not supported
+  NextHopObject(uint32_t id, uint8_t protocolId, const NextHop& nextHop);
+
+  // group of nexthop objects, pairs of member id and weight
+  NextHopObject(
+      uint32_t id,
+      uint8_t protocolId,
+      std::vector<std::pair<uint32_t, uint8_t>> group);
+
+  uint32_t getId() const;
+
+  uint8_t getProtocolId() const;
+
+  // AF_INET or AF_INET6 of gateway for single nexthop, else AF_UNSPEC
+  uint8_t getFamily() const;
+
+  const std::optional<NextHop>& getNextHop() const;
+
+  const std::vector<std::pair<uint32_t, uint8_t>>& getGroup() const;
+
+  bool isGroup() const;
+
+  std::string str() const;
+
+ private:
+  uint32_t id_{0};
+  uint8_t protocolId_{DEFAULT_PROTOCOL_ID};
+  std::optional<NextHop> nextHop_;
+  std::vector<std::pair<uint32_t, uint8_t>> group_;
+};
+
 class IfAddress;
 class IfAddressBuilder final {
  public:
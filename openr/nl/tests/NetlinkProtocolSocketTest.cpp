@@ -25,6 +25,8 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/Util.h>
 #include <openr/if/gen-cpp2/Network_types.h>
 #include <openr/nl/NetlinkProtocolSocket.h>
 
@@ -40,6 +42,8 @@ DEFINE_bool(
 using namespace openr;
 using namespace folly::literals::shell_literals;
 
+using openr::fbnl::NetlinkBatch;
+using openr::fbnl::NetlinkBatchFailures;
 using openr::fbnl::NetlinkProtocolSocket;
 using openr::fbnl::NetlinkRouteMessage;
 
@@ -552,12 +556,85 @@ TEST(NetlinkRouteMessage, EncodeLabel) {
   }
 }
 
+TEST(NetlinkBatch, ReturnStatus) {
+  // Empty batch is immediately fulfilled
+  {
+    NetlinkBatch batch(0, {});
+    auto future = batch.getSemiFuture();
+    ASSERT_TRUE(future.isReady());
+    EXPECT_TRUE(std::move(future).get().empty());
+  }
+
+  // Batch is fulfilled with the failures once all requests completed
+  {
+    NetlinkBatch batch(4, {EEXIST});
+    auto future = batch.getSemiFuture();
+    batch.setReturnStatus(2, -ENOENT);
+    batch.setReturnStatus(0, 0);
+    batch.setReturnStatus(3, -EEXIST);
+    EXPECT_FALSE(future.isReady());
+    batch.setReturnStatus(1, EINVAL);
+    ASSERT_TRUE(future.isReady());
+    const NetlinkBatchFailures expected{{2, ENOENT}, {1, EINVAL}};
+    EXPECT_EQ(expected, std::move(future).get());
+  }
+}
+
+TEST(NetlinkMessagePool, ShrinkToFit) {
+  auto& pool = openr::fbnl::NetlinkMessagePool::get();
+  openr::fbnl::RouteBuilder builder;
+  const auto route =
+      builder.setDestination(ipPrefix1).setProtocolId(kRouteProtoId).build();
+
+  std::vector<std::unique_ptr<NetlinkRouteMessage>> msgs;
+  for (int i = 0; i < 100; ++i) {
+    auto msg = std::make_unique<NetlinkRouteMessage>();
+    ASSERT_EQ(0, msg->deleteRoute(route));
+    const auto len = msg->getDataLength();
+    const std::string data(
+        reinterpret_cast<const char*>(msg->getMessagePtr()), len);
+
+    // Message moves out of its page, with same content
+    const auto* page = msg->getMessagePtr();
+    msg->shrinkToFit();
+    EXPECT_NE(page, msg->getMessagePtr());
+    EXPECT_EQ(len, msg->getDataLength());
+    EXPECT_EQ(
+        data,
+        std::string(
+            reinterpret_cast<const char*>(msg->getMessagePtr()), len));
+    msgs.emplace_back(std::move(msg));
+  }
+
+  // Page got recycled for every message and messages share slabs
+  auto stats = pool.getStats();
+  EXPECT_LE(1, stats.numFreePages);
+  EXPECT_LE(1, stats.numSlabs);
+  EXPECT_GT(msgs.size(), static_cast<size_t>(stats.numSlabs));
+
+  // Slabs are freed along with their messages, except the one currently
+  // allocated from
+  for (auto& msg : msgs) {
+    msg->setReturnStatus(0);
+  }
+  msgs.clear();
+  EXPECT_GE(1, pool.getStats().numSlabs);
+}
+
 /**
  * This test intends to test the delayed looping of event-base. Request is
  * made before event loop is started. This will help ensuring that socket
  * initialization and message sent happens inside event loop in sequence even
  * though message is requested to be sent before.
  */
+TEST(NetlinkProtocolSocket, IPv6RouteReplaceSupported) {
+  EXPECT_FALSE(openr::fbnl::isIPv6RouteReplaceSupported("3.10.0-1160.el7"));
+  EXPECT_FALSE(openr::fbnl::isIPv6RouteReplaceSupported("4.17.19"));
+  EXPECT_TRUE(openr::fbnl::isIPv6RouteReplaceSupported("4.18.0"));
+  EXPECT_TRUE(openr::fbnl::isIPv6RouteReplaceSupported("5.10.0-19-amd64"));
+  EXPECT_FALSE(openr::fbnl::isIPv6RouteReplaceSupported("unknown"));
+}
+
 TEST(NetlinkProtocolSocket, DelayedEventBase) {
   folly::EventBase evb;
   messaging::ReplicateQueue<openr::fbnl::NetlinkEvent> netlinkEventsQ;
@@ -1295,6 +1372,207 @@ TEST_F(NlMessageFixture, MultipleIpRoutesLabelNexthop) {
   EXPECT_EQ(0, kernelRoutes.size());
 }
 
+TEST_F(NlMessageFixture, IpRoutesBatch) {
+  // Add and delete IPv6 routes as one batch each
+  uint32_t count{100000};
+  const auto routes = buildV6RouteDb(count);
+
+  auto ackCount = getAckCount();
+  auto failures = nlSock->addRoutes(routes, {}).get();
+  EXPECT_TRUE(failures.empty());
+  EXPECT_EQ(0, getErrorCount());
+  EXPECT_GE(getAckCount(), ackCount + count);
+  // routes are deleted before they are added without replace semantics
+  EXPECT_EQ(
+      FLAGS_enable_ipv6_rr_semantics ? 0 : count,
+      facebook::fb303::fbData
+          ->getCounters()["netlink.requests.replace_fallbacks.sum"]);
+
+  auto kernelRoutes = nlSock->getIPv6Routes(kRouteProtoId).get().value();
+  EXPECT_EQ(kernelRoutes.size(), routes.size());
+  EXPECT_EQ(findRoutesInKernelRoutes(kernelRoutes, routes), count);
+
+  ackCount = getAckCount();
+  failures = nlSock->deleteRoutes(routes, {}).get();
+  EXPECT_TRUE(failures.empty());
+  EXPECT_GE(getAckCount(), ackCount + count);
+  kernelRoutes = nlSock->getIPv6Routes(kRouteProtoId).get().value();
+  EXPECT_EQ(0, kernelRoutes.size());
+
+  // Deleting again fails for every route unless ESRCH is ignored
+  failures = nlSock->deleteRoutes(routes, {}).get();
+  ASSERT_EQ(count, failures.size());
+  EXPECT_EQ(ESRCH, failures.front().second);
+  failures = nlSock->deleteRoutes(routes, {ESRCH}).get();
+  EXPECT_TRUE(failures.empty());
+}
+
+TEST_F(NlMessageFixture, RouteSocketsPerFamily) {
+  // Batch of IPv4 and IPv6 routes sent on a socket per family
+  folly::EventBase routeEvb;
+  auto routeSock = std::make_unique<NetlinkProtocolSocket>(
+      &routeEvb,
+      netlinkEventsQ,
+      FLAGS_enable_ipv6_rr_semantics,
+      true /* enableRouteSocketsPerFamily */);
+  std::thread routeEvbThread([&]() { routeEvb.loopForever(); });
+  routeEvb.waitUntilRunning();
+
+  uint32_t count{1000};
+  auto routes = buildV4RouteDb(count);
+  const auto v6Routes = buildV6RouteDb(count);
+  routes.insert(routes.end(), v6Routes.begin(), v6Routes.end());
+
+  auto ackCount = getAckCount();
+  EXPECT_TRUE(routeSock->addRoutes(routes, {}).get().empty());
+  EXPECT_EQ(0, getErrorCount());
+  EXPECT_GE(getAckCount(), ackCount + 2 * count);
+
+  auto kernelRoutes = nlSock->getIPv4Routes(kRouteProtoId).get().value();
+  EXPECT_EQ(count, kernelRoutes.size());
+  auto v6KernelRoutes = nlSock->getIPv6Routes(kRouteProtoId).get().value();
+  kernelRoutes.insert(
+      kernelRoutes.end(), v6KernelRoutes.begin(), v6KernelRoutes.end());
+  EXPECT_EQ(findRoutesInKernelRoutes(kernelRoutes, routes), 2 * count);
+
+  // single route requests are dispatched by family as well
+  EXPECT_EQ(0, routeSock->deleteRoute(routes.front()).get());
+  EXPECT_EQ(0, routeSock->deleteRoute(routes.back()).get());
+  routes.erase(routes.begin());
+  routes.pop_back();
+  EXPECT_TRUE(routeSock->deleteRoutes(routes, {}).get().empty());
+  EXPECT_EQ(0, nlSock->getIPv4Routes(kRouteProtoId).get().value().size());
+  EXPECT_EQ(0, nlSock->getIPv6Routes(kRouteProtoId).get().value().size());
+
+  routeEvb.terminateLoopSoon();
+  routeEvbThread.join();
+}
+
+TEST_F(NlMessageFixture, AddUnicastRoutesFromThrift) {
+  // Thrift routes encoded directly are same as ones built as `Route`
+  fbnl::UnicastRouteAttrs attrs;
+  attrs.protocolId = kRouteProtoId;
+  attrs.priority = kAqRouteProtoIdPriority;
+  attrs.getIfIndex = [&](const std::string& ifName) -> std::optional<int> {
+    if (ifName == kVethNameY) {
+      return ifIndexY;
+    }
+    return std::nullopt;
+  };
+
+  std::vector<thrift::UnicastRoute> thriftRoutes;
+  std::vector<fbnl::Route> routes;
+
+  // ECMP with push labels
+  thriftRoutes.emplace_back(createUnicastRoute(
+      toIpPrefix(ipPrefix1),
+      {createNextHop(
+           toBinaryAddress(ipAddrY1V6),
+           kVethNameY,
+           0,
+           createMplsAction(thrift::MplsActionCode::PUSH, {}, outLabel3)),
+       createNextHop(toBinaryAddress(ipAddrY2V6), kVethNameY)}));
+  routes.emplace_back(buildRoute(
+      kRouteProtoId,
+      ipPrefix1,
+      folly::none,
+      std::vector<fbnl::NextHop>{
+          buildNextHop(
+              outLabel3,
+              folly::none,
+              thrift::MplsActionCode::PUSH,
+              ipAddrY1V6,
+              ifIndexY),
+          buildNextHop(
+              folly::none, folly::none, folly::none, ipAddrY2V6, ifIndexY)}));
+
+  // Drop route, with host bits of destination set
+  thriftRoutes.emplace_back(createUnicastRoute(
+      toIpPrefix(folly::IPAddress::createNetwork("5502::1/64", -1, false)),
+      {}));
+  fbnl::RouteBuilder rtBuilder;
+  routes.emplace_back(rtBuilder.setDestination(ipPrefix2)
+                          .setProtocolId(kRouteProtoId)
+                          .setPriority(kAqRouteProtoIdPriority)
+                          .setType(RTN_BLACKHOLE)
+                          .setFlags(0)
+                          .setValid(true)
+                          .build());
+
+  // Unknown interface fails route alone
+  thriftRoutes.emplace_back(createUnicastRoute(
+      toIpPrefix(ipPrefix3),
+      {createNextHop(toBinaryAddress(ipAddrY1V6), "unknownIf")}));
+
+  auto failures = nlSock->addUnicastRoutes(thriftRoutes, attrs, {}).get();
+  ASSERT_EQ(1, failures.size());
+  EXPECT_EQ(2, failures.front().first);
+  EXPECT_EQ(ENODEV, failures.front().second);
+
+  auto kernelRoutes = nlSock->getIPv6Routes(kRouteProtoId).get().value();
+  EXPECT_EQ(routes.size(), kernelRoutes.size());
+  EXPECT_EQ(findRoutesInKernelRoutes(kernelRoutes, routes), routes.size());
+
+  EXPECT_TRUE(nlSock->deleteRoutes(routes, {}).get().empty());
+  EXPECT_EQ(0, nlSock->getIPv6Routes(kRouteProtoId).get().value().size());
+}
+
+TEST_F(NlMessageFixture, RecvBufferSize) {
+  // Configured receive buffer is applied beyond rmem_max as we're root
+  const uint32_t recvBufSize{4 * kNetlinkSockRecvBuf};
+  folly::EventBase sockEvb;
+  auto sock = std::make_unique<NetlinkProtocolSocket>(
+      &sockEvb,
+      netlinkEventsQ,
+      FLAGS_enable_ipv6_rr_semantics,
+      false /* enableRouteSocketsPerFamily */,
+      recvBufSize);
+  std::thread sockEvbThread([&]() { sockEvb.loopForever(); });
+  sockEvb.waitUntilRunning();
+
+  // socket is initialized once it served a request
+  EXPECT_FALSE(sock->getAllLinks().get().value().empty());
+  EXPECT_EQ(
+      recvBufSize,
+      facebook::fb303::fbData->getCounters()["netlink.recv_buffer.bytes"]);
+
+  sockEvb.terminateLoopSoon();
+  sockEvbThread.join();
+}
+
+TEST_F(NlMessageFixture, StreamIpRoutes) {
+  // Stream routes of dump to callback instead of collecting them
+  uint32_t count{1000};
+  const auto routes = buildV6RouteDb(count);
+  EXPECT_TRUE(nlSock->addRoutes(routes, {}).get().empty());
+
+  std::vector<openr::fbnl::Route> streamedRoutes;
+  EXPECT_EQ(
+      0,
+      nlSock
+          ->streamIPv6Routes(
+              kRouteProtoId,
+              [&](openr::fbnl::Route&& route) {
+                streamedRoutes.emplace_back(std::move(route));
+              })
+          .get());
+  EXPECT_EQ(count, streamedRoutes.size());
+  EXPECT_EQ(findRoutesInKernelRoutes(streamedRoutes, routes), count);
+
+  // Routes of other protocols are filtered
+  uint32_t numOtherRoutes{0};
+  EXPECT_EQ(
+      0,
+      nlSock
+          ->streamIPv6Routes(
+              kRouteProtoId + 1,
+              [&](openr::fbnl::Route&& /* route */) { ++numOtherRoutes; })
+          .get());
+  EXPECT_EQ(0, numOtherRoutes);
+
+  EXPECT_TRUE(nlSock->deleteRoutes(routes, {}).get().empty());
+}
+
 TEST_F(NlMessageFixture, LabelRouteV4Nexthop) {
   // Add label route with single path label with PHP nexthop
 
@@ -264,9 +264,9 @@ class NetlinkSocketFixture : public testing::Test {
         .get();
 
     auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-    EXPECT_EQ(1, routes.size());
-    ASSERT_EQ(1, routes.count(prefix1));
-    const Route& rt = routes.at(prefix1);
+    EXPECT_EQ(1, routes->size());
+    ASSERT_EQ(1, routes->count(prefix1));
+    const Route& rt = routes->at(prefix1);
     EXPECT_EQ(1, rt.getNextHops().size());
     EXPECT_EQ(nexthops[0], rt.getNextHops().begin()->getGateway());
 
@@ -297,9 +297,9 @@ class NetlinkSocketFixture : public testing::Test {
 
     // The route should now have only nh2
     routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-    EXPECT_EQ(1, routes.size());
-    ASSERT_EQ(1, routes.count(prefix1));
-    const Route& rt1 = routes.at(prefix1);
+    EXPECT_EQ(1, routes->size());
+    ASSERT_EQ(1, routes->count(prefix1));
+    const Route& rt1 = routes->at(prefix1);
     EXPECT_EQ(1, rt1.getNextHops().size());
     EXPECT_EQ(nexthops[0], rt1.getNextHops().begin()->getGateway());
 
@@ -316,9 +316,9 @@ class NetlinkSocketFixture : public testing::Test {
 
     // The route should now have both nh1 and nh2
     routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-    EXPECT_EQ(1, routes.size());
-    ASSERT_EQ(1, routes.count(prefix1));
-    const Route& rt2 = routes.at(prefix1);
+    EXPECT_EQ(1, routes->size());
+    ASSERT_EQ(1, routes->count(prefix1));
+    const Route& rt2 = routes->at(prefix1);
     EXPECT_EQ(2, rt2.getNextHops().size());
 
     // Check kernel
@@ -337,7 +337,7 @@ class NetlinkSocketFixture : public testing::Test {
         ->delRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops, prefix1))
         .get();
     routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-    EXPECT_EQ(0, routes.size());
+    EXPECT_EQ(0, routes->size());
 
     // - Add a route with 2 paths (nextHops)
     // - Verify it is added
@@ -354,9 +354,9 @@ class NetlinkSocketFixture : public testing::Test {
         .get();
     routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
 
-    EXPECT_EQ(1, routes.size());
-    ASSERT_EQ(1, routes.count(prefix2));
-    const Route& rt3 = routes.at(prefix2);
+    EXPECT_EQ(1, routes->size());
+    ASSERT_EQ(1, routes->count(prefix2));
+    const Route& rt3 = routes->at(prefix2);
     EXPECT_EQ(2, rt3.getNextHops().size());
 
     // Remove 1 of nextHops from the route
@@ -366,9 +366,9 @@ class NetlinkSocketFixture : public testing::Test {
         .get();
     routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
 
-    EXPECT_EQ(1, routes.size());
-    ASSERT_EQ(1, routes.count(prefix2));
-    const Route& rt4 = routes.at(prefix2);
+    EXPECT_EQ(1, routes->size());
+    ASSERT_EQ(1, routes->count(prefix2));
+    const Route& rt4 = routes->at(prefix2);
     EXPECT_EQ(1, rt4.getNextHops().size());
     EXPECT_EQ(nexthops[0], rt4.getNextHops().begin()->getGateway());
 
@@ -388,7 +388,7 @@ class NetlinkSocketFixture : public testing::Test {
         ->delRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops, prefix2))
         .get();
     routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-    EXPECT_EQ(0, routes.size());
+    EXPECT_EQ(0, routes->size());
 
     kernelRoutes = netlinkSocket->getAllRoutes();
     count = 0;
@@ -425,9 +425,9 @@ class NetlinkSocketFixture : public testing::Test {
         .get();
     auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
 
-    EXPECT_EQ(1, routes.size());
-    EXPECT_EQ(1, routes.count(prefix));
-    const Route& rt = routes.at(prefix);
+    EXPECT_EQ(1, routes->size());
+    EXPECT_EQ(1, routes->count(prefix));
+    const Route& rt = routes->at(prefix);
     EXPECT_EQ(3, rt.getNextHops().size());
     EXPECT_TRUE(CompareNextHops(nexthops, rt));
 
@@ -456,9 +456,9 @@ class NetlinkSocketFixture : public testing::Test {
 
     // The route now has nextHop 1 and nextHop 2
     routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-    EXPECT_EQ(1, routes.size());
-    ASSERT_EQ(1, routes.count(prefix));
-    const Route& rt1 = routes.at(prefix);
+    EXPECT_EQ(1, routes->size());
+    ASSERT_EQ(1, routes->count(prefix));
+    const Route& rt1 = routes->at(prefix);
     EXPECT_EQ(2, rt1.getNextHops().size());
     EXPECT_TRUE(CompareNextHops(nexthops, rt1));
 
@@ -483,9 +483,9 @@ class NetlinkSocketFixture : public testing::Test {
 
     // The route now has nextHop 1, 2, and 4
     routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-    EXPECT_EQ(1, routes.size());
-    ASSERT_EQ(1, routes.count(prefix));
-    const Route& rt2 = routes.at(prefix);
+    EXPECT_EQ(1, routes->size());
+    ASSERT_EQ(1, routes->count(prefix));
+    const Route& rt2 = routes->at(prefix);
     EXPECT_EQ(3, rt2.getNextHops().size());
     EXPECT_TRUE(CompareNextHops(nexthops, rt2));
 
@@ -504,7 +504,7 @@ class NetlinkSocketFixture : public testing::Test {
         ->delRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops, prefix))
         .get();
     routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-    EXPECT_EQ(0, routes.size());
+    EXPECT_EQ(0, routes->size());
 
     kernelRoutes = netlinkSocket->getAllRoutes();
     count = 0;
@@ -562,10 +562,10 @@ class NetlinkSocketFixture : public testing::Test {
     }
     EXPECT_EQ(2, count);
 
-    EXPECT_EQ(1, routes.count(prefix1));
-    EXPECT_EQ(1, routes.count(prefix2));
-    const Route& rt1 = routes.at(prefix1);
-    const Route& rt2 = routes.at(prefix2);
+    EXPECT_EQ(1, routes->count(prefix1));
+    EXPECT_EQ(1, routes->count(prefix2));
+    const Route& rt1 = routes->at(prefix1);
+    const Route& rt2 = routes->at(prefix2);
     EXPECT_EQ(2, rt1.getNextHops().size());
     EXPECT_EQ(1, rt2.getNextHops().size());
     EXPECT_TRUE(CompareNextHops(nexthops1, rt1));
@@ -602,10 +602,10 @@ class NetlinkSocketFixture : public testing::Test {
     }
     EXPECT_EQ(2, count);
 
-    EXPECT_EQ(1, routes.count(prefix1));
-    EXPECT_EQ(1, routes.count(prefix2));
-    const Route& rt3 = routes.at(prefix1);
-    const Route& rt4 = routes.at(prefix2);
+    EXPECT_EQ(1, routes->count(prefix1));
+    EXPECT_EQ(1, routes->count(prefix2));
+    const Route& rt3 = routes->at(prefix1);
+    const Route& rt4 = routes->at(prefix2);
     EXPECT_EQ(1, rt3.getNextHops().size());
     EXPECT_EQ(2, rt4.getNextHops().size());
     EXPECT_TRUE(CompareNextHops(nexthops1, rt3));
@@ -633,8 +633,8 @@ class NetlinkSocketFixture : public testing::Test {
     }
     EXPECT_EQ(1, count);
 
-    EXPECT_EQ(1, routes.count(prefix2));
-    const Route& rt5 = routes.at(prefix2);
+    EXPECT_EQ(1, routes->count(prefix2));
+    const Route& rt5 = routes->at(prefix2);
     EXPECT_EQ(2, rt5.getNextHops().size());
     EXPECT_TRUE(CompareNextHops(nexthops2, rt5));
 
@@ -643,14 +643,14 @@ class NetlinkSocketFixture : public testing::Test {
         ->delRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops2, prefix2))
         .get();
     routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-    EXPECT_EQ(0, routes.size());
+    EXPECT_EQ(0, routes->size());
   }
 };
 
 TEST_F(NetlinkSocketFixture, EmptyRouteTest) {
   auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId);
   SCOPE_EXIT {
-    EXPECT_EQ(0, std::move(routes).get().size());
+    EXPECT_EQ(0, std::move(routes).get()->size());
   };
 }
 
@@ -684,9 +684,9 @@ TEST_F(NetlinkSocketFixture, SingleRouteTest) {
   EXPECT_EQ(1, count);
   auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
 
-  EXPECT_EQ(1, routes.size());
-  ASSERT_EQ(1, routes.count(prefix));
-  const Route& rt = routes.at(prefix);
+  EXPECT_EQ(1, routes->size());
+  ASSERT_EQ(1, routes->count(prefix));
+  const Route& rt = routes->at(prefix);
   EXPECT_EQ(prefix, rt.getDestination());
   EXPECT_EQ(kAqRouteProtoId, rt.getProtocolId());
   EXPECT_EQ(1, rt.getNextHops().size());
@@ -697,7 +697,33 @@ TEST_F(NetlinkSocketFixture, SingleRouteTest) {
       ->delRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops, prefix))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(0, routes.size());
+  EXPECT_EQ(0, routes->size());
+}
+
+// Cached routes are shared snapshots, not affected by later updates
+TEST_F(NetlinkSocketFixture, CachedRoutesSnapshotTest) {
+  folly::CIDRNetwork prefix{folly::IPAddress("fc00:cafe:3::3"), 128};
+  std::vector<folly::IPAddress> nexthops{folly::IPAddress("fe80::1")};
+  int ifIndex = netlinkSocket->getIfIndex(kVethNameY).get();
+
+  netlinkSocket
+      ->addRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops, prefix))
+      .get();
+  auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
+  EXPECT_EQ(1, routes->count(prefix));
+
+  // Unchanged cache is read without copying it again
+  EXPECT_EQ(
+      routes,
+      netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get());
+
+  netlinkSocket
+      ->delRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops, prefix))
+      .get();
+  EXPECT_EQ(
+      0,
+      netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get()->size());
+  EXPECT_EQ(1, routes->count(prefix));
 }
 
 TEST_F(NetlinkSocketFixture, SingleRouteTestV4) {
@@ -727,9 +753,9 @@ TEST_F(NetlinkSocketFixture, SingleRouteTestV4) {
   EXPECT_EQ(1, count);
   auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
 
-  EXPECT_EQ(1, routes.size());
-  ASSERT_EQ(1, routes.count(prefix));
-  const Route& rt = routes.at(prefix);
+  EXPECT_EQ(1, routes->size());
+  ASSERT_EQ(1, routes->count(prefix));
+  const Route& rt = routes->at(prefix);
   EXPECT_EQ(prefix, rt.getDestination());
   EXPECT_EQ(kAqRouteProtoId, rt.getProtocolId());
   EXPECT_EQ(1, rt.getNextHops().size());
@@ -740,7 +766,7 @@ TEST_F(NetlinkSocketFixture, SingleRouteTestV4) {
       ->delRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops, prefix))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(0, routes.size());
+  EXPECT_EQ(0, routes->size());
 }
 
 // - Add a null route (nexthops empty)
@@ -770,9 +796,9 @@ TEST_F(NetlinkSocketFixture, NullRouteTest) {
   EXPECT_EQ(1, count);
   auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
 
-  EXPECT_EQ(1, routes.size());
-  ASSERT_EQ(1, routes.count(prefix));
-  const Route& rt = routes.at(prefix);
+  EXPECT_EQ(1, routes->size());
+  ASSERT_EQ(1, routes->count(prefix));
+  const Route& rt = routes->at(prefix);
   EXPECT_EQ(prefix, rt.getDestination());
   EXPECT_EQ(kAqRouteProtoId, rt.getProtocolId());
   // buildNullRoute does not add nexthop.
@@ -782,7 +808,7 @@ TEST_F(NetlinkSocketFixture, NullRouteTest) {
   // Delete the same route
   netlinkSocket->delRoute(buildNullRoute(kAqRouteProtoId, prefix)).get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(0, routes.size());
+  EXPECT_EQ(0, routes->size());
 }
 
 // - Add a null route (nexthops empty)
@@ -812,9 +838,9 @@ TEST_F(NetlinkSocketFixture, NullRouteV4Test) {
   EXPECT_EQ(1, count);
   auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
 
-  EXPECT_EQ(1, routes.size());
-  ASSERT_EQ(1, routes.count(prefix));
-  const Route& rt = routes.at(prefix);
+  EXPECT_EQ(1, routes->size());
+  ASSERT_EQ(1, routes->count(prefix));
+  const Route& rt = routes->at(prefix);
   EXPECT_EQ(prefix, rt.getDestination());
   EXPECT_EQ(kAqRouteProtoId, rt.getProtocolId());
   EXPECT_EQ(0, rt.getNextHops().size());
@@ -823,7 +849,7 @@ TEST_F(NetlinkSocketFixture, NullRouteV4Test) {
   // Delete the same route
   netlinkSocket->delRoute(buildNullRoute(kAqRouteProtoId, prefix)).get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(0, routes.size());
+  EXPECT_EQ(0, routes->size());
 }
 
 TEST_F(NetlinkSocketFixture, UpdateRouteTest) {
@@ -884,12 +910,12 @@ TEST_F(NetlinkSocketFixture, MultiPathTest) {
   auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
 
   SCOPE_EXIT {
-    EXPECT_EQ(0, routes.size());
+    EXPECT_EQ(0, routes->size());
   };
 
-  EXPECT_EQ(1, routes.size());
-  EXPECT_EQ(1, routes.count(prefix1));
-  const Route& rt = routes.at(prefix1);
+  EXPECT_EQ(1, routes->size());
+  EXPECT_EQ(1, routes->count(prefix1));
+  const Route& rt = routes->at(prefix1);
   EXPECT_EQ(2, rt.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nexthops1, rt));
 
@@ -898,11 +924,11 @@ TEST_F(NetlinkSocketFixture, MultiPathTest) {
       ->addRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops2, prefix2))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(2, routes.size());
-  EXPECT_EQ(1, routes.count(prefix1));
-  EXPECT_EQ(1, routes.count(prefix2));
-  const Route& rt2 = routes.at(prefix1);
-  const Route& rt3 = routes.at(prefix2);
+  EXPECT_EQ(2, routes->size());
+  EXPECT_EQ(1, routes->count(prefix1));
+  EXPECT_EQ(1, routes->count(prefix2));
+  const Route& rt2 = routes->at(prefix1);
+  const Route& rt3 = routes->at(prefix2);
   EXPECT_EQ(2, rt2.getNextHops().size());
   EXPECT_EQ(2, rt3.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nexthops1, rt2));
@@ -928,8 +954,8 @@ TEST_F(NetlinkSocketFixture, MultiPathTest) {
       ->delRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops1, prefix1))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(1, routes.count(prefix2));
-  const Route& rt4 = routes.at(prefix2);
+  EXPECT_EQ(1, routes->count(prefix2));
+  const Route& rt4 = routes->at(prefix2);
   EXPECT_EQ(2, rt4.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nexthops2, rt4));
 
@@ -937,7 +963,7 @@ TEST_F(NetlinkSocketFixture, MultiPathTest) {
       ->delRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops2, prefix2))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(0, routes.size());
+  EXPECT_EQ(0, routes->size());
 
   kernelRoutes = netlinkSocket->getAllRoutes();
   count = 0;
@@ -972,12 +998,12 @@ TEST_F(NetlinkSocketFixture, DeleteNonExistingRouteTest) {
   auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
 
   SCOPE_EXIT {
-    EXPECT_EQ(0, routes.size());
+    EXPECT_EQ(0, routes->size());
   };
 
-  EXPECT_EQ(1, routes.size());
-  EXPECT_EQ(1, routes.count(prefix1));
-  const Route& rt = routes.at(prefix1);
+  EXPECT_EQ(1, routes->size());
+  EXPECT_EQ(1, routes->count(prefix1));
+  const Route& rt = routes->at(prefix1);
   EXPECT_EQ(1, rt.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nexthops1, rt));
 
@@ -986,7 +1012,7 @@ TEST_F(NetlinkSocketFixture, DeleteNonExistingRouteTest) {
       ->delRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops1, prefix2))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(1, routes.size());
+  EXPECT_EQ(1, routes->size());
 
   // Check kernel
   auto kernelRoutes = netlinkSocket->getAllRoutes();
@@ -1004,7 +1030,7 @@ TEST_F(NetlinkSocketFixture, DeleteNonExistingRouteTest) {
       ->delRoute(buildRoute(ifIndex, kAqRouteProtoId, nexthops1, prefix1))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(0, routes.size());
+  EXPECT_EQ(0, routes->size());
 
   kernelRoutes = netlinkSocket->getAllRoutes();
   count = 0;
@@ -1044,11 +1070,11 @@ TEST_F(NetlinkSocketFixture, MultiProtocolUnicastTest) {
       ->addRoute(buildRoute(ifIndexX, kAqRouteProtoId, nextHopsV6, prefix2V6))
       .get();
   auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(2, routes.size());
-  ASSERT_EQ(1, routes.count(prefix1V6));
-  ASSERT_EQ(1, routes.count(prefix2V6));
-  const Route& rt1 = routes.at(prefix1V6);
-  const Route& rt2 = routes.at(prefix2V6);
+  EXPECT_EQ(2, routes->size());
+  ASSERT_EQ(1, routes->count(prefix1V6));
+  ASSERT_EQ(1, routes->count(prefix2V6));
+  const Route& rt1 = routes->at(prefix1V6);
+  const Route& rt2 = routes->at(prefix2V6);
   EXPECT_EQ(1, rt1.getNextHops().size());
   EXPECT_EQ(1, rt2.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHopsV6, rt1));
@@ -1063,11 +1089,11 @@ TEST_F(NetlinkSocketFixture, MultiProtocolUnicastTest) {
       ->addRoute(buildRoute(ifIndexY, kAqRouteProtoId1, nextHops1V4, prefix2V4))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId1).get();
-  EXPECT_EQ(2, routes.size());
-  ASSERT_EQ(1, routes.count(prefix1V4));
-  ASSERT_EQ(1, routes.count(prefix2V4));
-  const Route& rt3 = routes.at(prefix1V4);
-  const Route& rt4 = routes.at(prefix2V4);
+  EXPECT_EQ(2, routes->size());
+  ASSERT_EQ(1, routes->count(prefix1V4));
+  ASSERT_EQ(1, routes->count(prefix2V4));
+  const Route& rt3 = routes->at(prefix1V4);
+  const Route& rt4 = routes->at(prefix2V4);
   EXPECT_EQ(1, rt3.getNextHops().size());
   EXPECT_EQ(1, rt4.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHops1V4, rt3));
@@ -1107,9 +1133,9 @@ TEST_F(NetlinkSocketFixture, MultiProtocolUnicastTest) {
 
   // The route should now have only nh2
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(2, routes.size());
-  EXPECT_EQ(1, routes.count(prefix1V6));
-  const Route& rt5 = routes.at(prefix1V6);
+  EXPECT_EQ(2, routes->size());
+  EXPECT_EQ(1, routes->count(prefix1V6));
+  const Route& rt5 = routes->at(prefix1V6);
   EXPECT_EQ(1, rt5.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHopsV6, rt5));
 
@@ -1120,9 +1146,9 @@ TEST_F(NetlinkSocketFixture, MultiProtocolUnicastTest) {
       ->addRoute(buildRoute(ifIndexY, kAqRouteProtoId1, nextHops1V4, prefix2V4))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId1).get();
-  EXPECT_EQ(2, routes.size());
-  ASSERT_EQ(1, routes.count(prefix2V4));
-  const Route& rt6 = routes.at(prefix2V4);
+  EXPECT_EQ(2, routes->size());
+  ASSERT_EQ(1, routes->count(prefix2V4));
+  const Route& rt6 = routes->at(prefix2V4);
   EXPECT_EQ(1, rt6.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHops1V4, rt6));
 
@@ -1135,9 +1161,9 @@ TEST_F(NetlinkSocketFixture, MultiProtocolUnicastTest) {
 
   // The route should now have both nh1 and nh2
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(2, routes.size());
-  ASSERT_EQ(1, routes.count(prefix2V6));
-  const Route& rt7 = routes.at(prefix2V6);
+  EXPECT_EQ(2, routes->size());
+  ASSERT_EQ(1, routes->count(prefix2V6));
+  const Route& rt7 = routes->at(prefix2V6);
   EXPECT_EQ(2, rt7.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHopsV6, rt7));
 
@@ -1150,9 +1176,9 @@ TEST_F(NetlinkSocketFixture, MultiProtocolUnicastTest) {
 
   // The route should now have both nh3 and nh4
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId1).get();
-  EXPECT_EQ(2, routes.size());
-  EXPECT_EQ(1, routes.count(prefix1V4));
-  const Route& rt8 = routes.at(prefix1V4);
+  EXPECT_EQ(2, routes->size());
+  EXPECT_EQ(1, routes->count(prefix1V4));
+  const Route& rt8 = routes->at(prefix1V4);
   EXPECT_EQ(2, rt8.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHops1V4, rt8));
 
@@ -1183,12 +1209,12 @@ TEST_F(NetlinkSocketFixture, MultiProtocolUnicastTest) {
       ->delRoute(buildRoute(ifIndexX, kAqRouteProtoId, nextHopsV6, prefix1V6))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(1, routes.size());
+  EXPECT_EQ(1, routes->size());
   netlinkSocket
       ->delRoute(buildRoute(ifIndexX, kAqRouteProtoId, nextHopsV6, prefix2V6))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(0, routes.size());
+  EXPECT_EQ(0, routes->size());
 
   nextHops1V4.clear();
   nextHops1V4.push_back(nh2V4);
@@ -1197,14 +1223,14 @@ TEST_F(NetlinkSocketFixture, MultiProtocolUnicastTest) {
       ->delRoute(buildRoute(ifIndexY, kAqRouteProtoId1, nextHops1V4, prefix1V4))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId1).get();
-  EXPECT_EQ(1, routes.size());
+  EXPECT_EQ(1, routes->size());
   nextHops1V4.clear();
   nextHops1V4.push_back(nh2V4);
   netlinkSocket
       ->delRoute(buildRoute(ifIndexY, kAqRouteProtoId1, nextHops1V4, prefix2V4))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId1).get();
-  EXPECT_EQ(0, routes.size());
+  EXPECT_EQ(0, routes->size());
 
   kernelRoutes = netlinkSocket->getAllRoutes();
   count = 0;
@@ -1240,11 +1266,11 @@ TEST_F(NetlinkSocketFixture, MultiProtocolUnicastTestDecisionTest) {
       ->addRoute(buildRoute(ifIndexX, kAqRouteProtoId, nextHopsV6, prefix2V6))
       .get();
   auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(2, routes.size());
-  ASSERT_EQ(1, routes.count(prefix1V6));
-  ASSERT_EQ(1, routes.count(prefix2V6));
-  const Route& rt1 = routes.at(prefix1V6);
-  const Route& rt2 = routes.at(prefix2V6);
+  EXPECT_EQ(2, routes->size());
+  ASSERT_EQ(1, routes->count(prefix1V6));
+  ASSERT_EQ(1, routes->count(prefix2V6));
+  const Route& rt1 = routes->at(prefix1V6);
+  const Route& rt2 = routes->at(prefix2V6);
   EXPECT_EQ(1, rt1.getNextHops().size());
   EXPECT_EQ(1, rt2.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHopsV6, rt1));
@@ -1260,11 +1286,11 @@ TEST_F(NetlinkSocketFixture, MultiProtocolUnicastTestDecisionTest) {
       ->addRoute(buildRoute(ifIndexY, kAqRouteProtoId1, nextHops1V6, prefix2V6))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId1).get();
-  EXPECT_EQ(2, routes.size());
-  ASSERT_EQ(1, routes.count(prefix1V6));
-  ASSERT_EQ(1, routes.count(prefix2V6));
-  const Route& rt3 = routes.at(prefix1V6);
-  const Route& rt4 = routes.at(prefix2V6);
+  EXPECT_EQ(2, routes->size());
+  ASSERT_EQ(1, routes->count(prefix1V6));
+  ASSERT_EQ(1, routes->count(prefix2V6));
+  const Route& rt3 = routes->at(prefix1V6);
+  const Route& rt4 = routes->at(prefix2V6);
   EXPECT_EQ(1, rt3.getNextHops().size());
   EXPECT_EQ(1, rt4.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHops1V6, rt3));
@@ -1454,8 +1480,8 @@ TEST_F(NetlinkSocketFixture, MultiProtocolSyncUnicastRouteTest) {
       ->addRoute(buildRoute(ifIndexX, kAqRouteProtoId, nextHops2V6, prefix1V6))
       .get();
   auto routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(1, routes.size());
-  EXPECT_EQ(1, routes.count(prefix1V6));
+  EXPECT_EQ(1, routes->size());
+  EXPECT_EQ(1, routes->count(prefix1V6));
 
   // V4
   NlUnicastRoutes routeDbV4;
@@ -1479,8 +1505,8 @@ TEST_F(NetlinkSocketFixture, MultiProtocolSyncUnicastRouteTest) {
       ->addRoute(buildRoute(ifIndexY, kAqRouteProtoId1, nextHops2V4, prefix1V4))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId1).get();
-  EXPECT_EQ(1, routes.size());
-  EXPECT_EQ(1, routes.count(prefix1V4));
+  EXPECT_EQ(1, routes->size());
+  EXPECT_EQ(1, routes->count(prefix1V4));
 
   // Check kernel
   auto kernelRoutes = netlinkSocket->getAllRoutes();
@@ -1500,11 +1526,11 @@ TEST_F(NetlinkSocketFixture, MultiProtocolSyncUnicastRouteTest) {
   // Sync routeDb
   netlinkSocket->syncUnicastRoutes(kAqRouteProtoId, std::move(routeDbV6)).get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(2, routes.size());
-  EXPECT_EQ(1, routes.count(prefix1V6));
-  EXPECT_EQ(1, routes.count(prefix2V6));
-  const Route& rt1 = routes.at(prefix1V6);
-  const Route& rt2 = routes.at(prefix2V6);
+  EXPECT_EQ(2, routes->size());
+  EXPECT_EQ(1, routes->count(prefix1V6));
+  EXPECT_EQ(1, routes->count(prefix2V6));
+  const Route& rt1 = routes->at(prefix1V6);
+  const Route& rt2 = routes->at(prefix2V6);
   EXPECT_EQ(2, rt1.getNextHops().size());
   EXPECT_EQ(1, rt2.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHops1V6, rt1));
@@ -1513,11 +1539,11 @@ TEST_F(NetlinkSocketFixture, MultiProtocolSyncUnicastRouteTest) {
   netlinkSocket->syncUnicastRoutes(kAqRouteProtoId1, std::move(routeDbV4))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId1).get();
-  EXPECT_EQ(2, routes.size());
-  EXPECT_EQ(1, routes.count(prefix1V4));
-  EXPECT_EQ(1, routes.count(prefix2V4));
-  const Route& rt3 = routes.at(prefix1V4);
-  const Route& rt4 = routes.at(prefix2V4);
+  EXPECT_EQ(2, routes->size());
+  EXPECT_EQ(1, routes->count(prefix1V4));
+  EXPECT_EQ(1, routes->count(prefix2V4));
+  const Route& rt3 = routes->at(prefix1V4);
+  const Route& rt4 = routes->at(prefix2V4);
   EXPECT_EQ(2, rt3.getNextHops().size());
   EXPECT_EQ(1, rt4.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHops1V4, rt3));
@@ -1550,11 +1576,11 @@ TEST_F(NetlinkSocketFixture, MultiProtocolSyncUnicastRouteTest) {
   netlinkSocket->syncUnicastRoutes(kAqRouteProtoId, std::move(routeDbV6)).get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
 
-  EXPECT_EQ(2, routes.size());
-  EXPECT_EQ(1, routes.count(prefix1V6));
-  EXPECT_EQ(1, routes.count(prefix2V6));
-  const Route& rt5 = routes.at(prefix1V6);
-  const Route& rt6 = routes.at(prefix2V6);
+  EXPECT_EQ(2, routes->size());
+  EXPECT_EQ(1, routes->count(prefix1V6));
+  EXPECT_EQ(1, routes->count(prefix2V6));
+  const Route& rt5 = routes->at(prefix1V6);
+  const Route& rt6 = routes->at(prefix2V6);
   EXPECT_EQ(1, rt5.getNextHops().size());
   EXPECT_EQ(2, rt6.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHops1V6, rt5));
@@ -1576,11 +1602,11 @@ TEST_F(NetlinkSocketFixture, MultiProtocolSyncUnicastRouteTest) {
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId1).get();
 
-  EXPECT_EQ(2, routes.size());
-  EXPECT_EQ(1, routes.count(prefix1V4));
-  EXPECT_EQ(1, routes.count(prefix2V4));
-  const Route& rt7 = routes.at(prefix1V4);
-  const Route& rt8 = routes.at(prefix2V4);
+  EXPECT_EQ(2, routes->size());
+  EXPECT_EQ(1, routes->count(prefix1V4));
+  EXPECT_EQ(1, routes->count(prefix2V4));
+  const Route& rt7 = routes->at(prefix1V4);
+  const Route& rt8 = routes->at(prefix2V4);
   EXPECT_EQ(1, rt7.getNextHops().size());
   EXPECT_EQ(2, rt8.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHops1V4, rt7));
@@ -1594,9 +1620,9 @@ TEST_F(NetlinkSocketFixture, MultiProtocolSyncUnicastRouteTest) {
   netlinkSocket->syncUnicastRoutes(kAqRouteProtoId, std::move(routeDbV6)).get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
 
-  EXPECT_EQ(1, routes.size());
-  EXPECT_EQ(1, routes.count(prefix2V6));
-  const Route& rt9 = routes.at(prefix2V6);
+  EXPECT_EQ(1, routes->size());
+  EXPECT_EQ(1, routes->count(prefix2V6));
+  const Route& rt9 = routes->at(prefix2V6);
   EXPECT_EQ(2, rt9.getNextHops().size());
   EXPECT_TRUE(CompareNextHops(nextHops2V6, rt9));
 
@@ -1616,26 +1642,26 @@ TEST_F(NetlinkSocketFixture, MultiProtocolSyncUnicastRouteTest) {
       ->delRoute(buildRoute(ifIndexY, kAqRouteProtoId1, nextHops1V4, prefix1V4))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId1).get();
-  EXPECT_EQ(1, routes.size());
+  EXPECT_EQ(1, routes->size());
   nextHops2V4.clear();
   netlinkSocket
       ->delRoute(buildRoute(ifIndexY, kAqRouteProtoId1, nextHops2V4, prefix2V4))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId1).get();
-  EXPECT_EQ(0, routes.size());
+  EXPECT_EQ(0, routes->size());
 
   // Delete V6 route
   netlinkSocket
       ->delRoute(buildRoute(ifIndexX, kAqRouteProtoId, nextHops1V6, prefix1V6))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(1, routes.size());
+  EXPECT_EQ(1, routes->size());
   nextHops2V6.clear();
   netlinkSocket
       ->delRoute(buildRoute(ifIndexX, kAqRouteProtoId, nextHops2V6, prefix2V6))
       .get();
   routes = netlinkSocket->getCachedUnicastRoutes(kAqRouteProtoId).get();
-  EXPECT_EQ(0, routes.size());
+  EXPECT_EQ(0, routes->size());
 
   // Check kernel
   kernelRoutes = netlinkSocket->getAllRoutes();
@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <openr/nl/NetlinkInterfaceTable.h>
 #include <openr/nl/NetlinkTypes.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
@@ -59,6 +60,44 @@ TEST(NetlinkTypes, NexthopGeneralTest) {
   EXPECT_EQ(kWeight, nh.getWeight());
 }
 
+TEST(NetlinkTypes, NextHopLabelsTest) {
+  folly::IPAddress gateway("fc00:cafe:3::3");
+  NextHopBuilder builder;
+  builder.setGateway(gateway).setIfIndex(kIfIndex);
+  auto nh1 = builder.build();
+  auto nh2 = builder.setLabelAction(thrift::MplsActionCode::PUSH)
+                 .setPushLabels({1, 2, 3, 4, 5, 6})
+                 .build();
+  EXPECT_FALSE(nh1.getLabelAction().has_value());
+  EXPECT_FALSE(nh1.getSwapLabel().has_value());
+  EXPECT_FALSE(nh1.hasPushLabels());
+  EXPECT_FALSE(nh1.getPushLabels().has_value());
+  EXPECT_TRUE(nh2.hasPushLabels());
+  EXPECT_EQ(
+      std::vector<int32_t>({1, 2, 3, 4, 5, 6}), nh2.getPushLabels().value());
+  EXPECT_EQ(6, nh2.getPushLabelStack().size());
+
+  // Same hash, but not equal
+  EXPECT_EQ(nh1.hash(), nh2.hash());
+  EXPECT_FALSE(nh1 == nh2);
+
+  // Weights 0 and 1 are equivalent
+  auto nh3 = builder.setWeight(1).build();
+  EXPECT_EQ(nh2.hash(), nh3.hash());
+  EXPECT_TRUE(nh2 == nh3);
+
+  nh3.setPushLabels({1, 2});
+  EXPECT_FALSE(nh2 == nh3);
+  EXPECT_EQ(std::vector<int32_t>({1, 2}), nh3.getPushLabels().value());
+
+  // Unset ifIndex differs from any set
+  builder.reset();
+  auto nh4 = builder.setGateway(gateway).build();
+  EXPECT_FALSE(nh1 == nh4);
+  EXPECT_EQ(1, NextHopSet({nh1, nh1}).size());
+  EXPECT_EQ(4, NextHopSet({nh1, nh2, nh3, nh4}).size());
+}
+
 TEST(NetlinkTypes, RouteBaseTest) {
   folly::CIDRNetwork dst{folly::IPAddress("fc00:cafe:3::3"), 128};
   RouteBuilder builder;
@@ -348,6 +387,41 @@ TEST(NetlinkTypes, RouteOptionalParamTest) {
   EXPECT_EQ(RTN_UNICAST, route.getType());
 }
 
+TEST(NetlinkTypes, NextHopObjectTest) {
+  folly::CIDRNetwork dst{folly::IPAddress("fc00:cafe:3::3"), 128};
+  folly::IPAddress gateway("face:cafe:3::3");
+  NextHopBuilder builder;
+  auto nh = builder.setIfIndex(kIfIndex).setGateway(gateway).build();
+
+  // Route via nexthop object
+  RouteBuilder rtbuilder;
+  auto route1 = rtbuilder.setDestination(dst)
+                    .setProtocolId(kProtocolId)
+                    .addNextHop(nh)
+                    .build();
+  auto route2 = rtbuilder.setNextHopId(2).build();
+  EXPECT_FALSE(route1.getNextHopId().has_value());
+  EXPECT_EQ(2, route2.getNextHopId());
+  EXPECT_FALSE(route1 == route2);
+  route1.setNextHopId(2);
+  EXPECT_TRUE(route1 == route2);
+  rtbuilder.reset();
+  EXPECT_FALSE(rtbuilder.getNextHopId().has_value());
+
+  NextHopObject single(1, kProtocolId, nh);
+  EXPECT_EQ(1, single.getId());
+  EXPECT_EQ(kProtocolId, single.getProtocolId());
+  EXPECT_EQ(AF_INET6, single.getFamily());
+  EXPECT_FALSE(single.isGroup());
+  EXPECT_EQ(nh, single.getNextHop().value());
+
+  NextHopObject group(2, kProtocolId, {{1, 1}, {3, 2}});
+  EXPECT_EQ(AF_UNSPEC, group.getFamily());
+  EXPECT_TRUE(group.isGroup());
+  EXPECT_EQ(2, group.getGroup().size());
+  EXPECT_EQ(std::make_pair(3u, uint8_t(2)), group.getGroup().at(1));
+}
+
 TEST(NetlinkTypes, IfAddressMoveTest) {
   folly::CIDRNetwork prefix{folly::IPAddress("fc00:cafe:3::3"), 128};
   uint32_t flags = 0x01;
@@ -554,6 +628,46 @@ TEST(NetlinkTypes, LinkCopyTest) {
   EXPECT_EQ(link, link2);
 }
 
+TEST(NetlinkTypes, InterfaceTableTest) {
+  auto buildLink = [](int ifIndex, std::string ifName, unsigned int flags) {
+    LinkBuilder builder;
+    return builder.setIfIndex(ifIndex)
+        .setFlags(flags)
+        .setLinkName(std::move(ifName))
+        .build();
+  };
+
+  NetlinkInterfaceTable table;
+  EXPECT_EQ(0, table.size());
+  EXPECT_EQ(std::nullopt, table.getIfIndex("lo"));
+  EXPECT_EQ(std::nullopt, table.getLoopbackIfIndex());
+
+  table.updateLink(buildLink(1, "lo", IFF_LOOPBACK));
+  table.updateLink(buildLink(2, "eth0", IFF_RUNNING));
+  EXPECT_EQ(2, table.size());
+  EXPECT_EQ(1, table.getIfIndex("lo"));
+  EXPECT_EQ(2, table.getIfIndex("eth0"));
+  EXPECT_EQ("eth0", table.getIfName(2));
+  EXPECT_EQ(1, table.getLoopbackIfIndex());
+
+  // Rename releases the old name
+  table.updateLink(buildLink(2, "eth1", 0));
+  EXPECT_EQ(std::nullopt, table.getIfIndex("eth0"));
+  EXPECT_EQ(2, table.getIfIndex("eth1"));
+  EXPECT_EQ("eth1", table.getIfName(2));
+
+  // Name can be taken by new link before old one is removed
+  table.updateLink(buildLink(3, "eth1", 0));
+  table.removeLink(2);
+  EXPECT_EQ(3, table.getIfIndex("eth1"));
+  EXPECT_EQ(std::nullopt, table.getIfName(2));
+
+  table.removeLink(1);
+  EXPECT_EQ(std::nullopt, table.getIfIndex("lo"));
+  EXPECT_EQ(std::nullopt, table.getLoopbackIfIndex());
+  EXPECT_EQ(1, table.size());
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
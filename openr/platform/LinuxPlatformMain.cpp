@@ -19,6 +19,18 @@
 
 DEFINE_int32(
     fib_thrift_port, 60100, "Thrift server port for the NetlinkFibHandler");
+DEFINE_bool(
+    enable_nexthop_groups,
+    false,
+    "Program unicast routes via kernel nexthop groups (linux 5.3+)");
+DEFINE_bool(
+    enable_route_sockets_per_family,
+    false,
+    "Program IPv4, IPv6 and MPLS routes over a netlink socket each");
+DEFINE_uint32(
+    netlink_recv_buffer_bytes,
+    openr::fbnl::kNetlinkSockRecvBuf,
+    "Initial receive buffer of netlink socket, grown on overruns");
 
 using openr::NetlinkFibHandler;
 
@@ -40,7 +52,11 @@ main(int argc, char** argv) {
   openr::messaging::ReplicateQueue<openr::fbnl::NetlinkEvent>
       netlinkEventsQueue;
   auto nlSock = std::make_unique<openr::fbnl::NetlinkProtocolSocket>(
-      nlEvb.get(), netlinkEventsQueue);
+      nlEvb.get(),
+      netlinkEventsQueue,
+      openr::fbnl::isIPv6RouteReplaceSupported(),
+      FLAGS_enable_route_sockets_per_family,
+      FLAGS_netlink_recv_buffer_bytes);
   allThreads.emplace_back(std::thread([&nlEvb]() {
     LOG(INFO) << "Starting NetlinkProtolSocketEvl thread...";
     folly::setThreadName("NetlinkProtolSocketEvl");
@@ -50,7 +66,8 @@ main(int argc, char** argv) {
   nlEvb->waitUntilRunning();
 
   apache::thrift::ThriftServer linuxFibAgentServer;
-  auto fibHandler = std::make_shared<NetlinkFibHandler>(nlSock.get());
+  auto fibHandler = std::make_shared<NetlinkFibHandler>(
+      nlSock.get(), FLAGS_enable_nexthop_groups);
 
   // start FibService thread
   auto fibThriftThread = std::thread([fibHandler, &linuxFibAgentServer]() {
@@ -10,10 +10,12 @@
 #include <algorithm>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <thread>
 #include <utility>
 
 #include <folly/Format.h>
+#include <folly/String.h>
 #include <folly/gen/Base.h>
 
 #include <openr/common/NetworkUtil.h>
@@ -40,11 +42,44 @@ createSemiFutureWithClientIdError() {
   return std::move(sf);
 }
 
+// Deleting nexthop object unknown to kernel, e.g. after its add failed, is
+// not an error
+folly::SemiFuture<int>
+ignoreMissingNextHop(folly::SemiFuture<int>&& result) {
+  return std::move(result).deferValue(
+      [](int status) { return std::abs(status) == ENOENT ? 0 : status; });
+}
+
+// Whether nexthops of route can be encoded from thrift directly, see
+// `fbnl::NetlinkRouteMessage::addUnicastRoute`
+bool
+hasIpOrPushNextHops(const thrift::UnicastRoute& route) {
+  for (auto const& nh : *route.nextHops_ref()) {
+    if (nh.mplsAction_ref().has_value() and
+        *nh.mplsAction_ref()->action_ref() != thrift::MplsActionCode::PUSH) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Report destination of failed route from index of its request in batch
+folly::Function<void(thrift::PlatformFibUpdateError&, size_t)>
+addUnicastRouteFailure(
+    std::unique_ptr<std::vector<thrift::UnicastRoute>> routes) {
+  return [routes = std::move(routes)](
+             thrift::PlatformFibUpdateError& error, size_t index) {
+    error.failedAddUpdatePrefixes_ref()->emplace_back(routes->at(index).dest);
+  };
+}
+
 } // namespace
 
-NetlinkFibHandler::NetlinkFibHandler(fbnl::NetlinkProtocolSocket* nlSock)
+NetlinkFibHandler::NetlinkFibHandler(
+    fbnl::NetlinkProtocolSocket* nlSock, bool enableNextHopGroups)
     : facebook::fb303::BaseService("openr"),
       nlSock_(nlSock),
+      enableNextHopGroups_(enableNextHopGroups),
       startTime_(std::chrono::duration_cast<std::chrono::seconds>(
                      std::chrono::system_clock::now().time_since_epoch())
                      .count()) {
@@ -102,6 +137,28 @@ NetlinkFibHandler::collectAllResult(
       });
 }
 
+folly::SemiFuture<folly::Unit>
+NetlinkFibHandler::collectBatchResult(
+    folly::SemiFuture<fbnl::NetlinkBatchFailures>&& result,
+    folly::Function<void(thrift::PlatformFibUpdateError&, size_t)>
+        addFailure) {
+  return std::move(result).deferValue(
+      [addFailure = std::move(addFailure)](
+          fbnl::NetlinkBatchFailures&& failures) mutable {
+        if (failures.empty()) {
+          return folly::Unit();
+        }
+        LOG(ERROR) << failures.size() << " netlink request(s) of batch failed";
+        thrift::PlatformFibUpdateError error;
+        for (auto const& [index, retval] : failures) {
+          VLOG(1) << "Request " << index << " failed with error "
+                  << folly::errnoStr(retval);
+          addFailure(error, index);
+        }
+        throw error;
+      });
+}
+
 folly::SemiFuture<folly::Unit>
 NetlinkFibHandler::semifuture_addUnicastRoute(
     int16_t clientId, std::unique_ptr<thrift::UnicastRoute> route) {
@@ -130,12 +187,36 @@ NetlinkFibHandler::semifuture_addUnicastRoutes(
   LOG(INFO) << "Adding/Updating unicast routes of client "
             << getClientName(clientId) << ", numRoutes=" << routes->size();
 
-  // Add routes and return a collected semifuture
-  std::vector<folly::SemiFuture<int>> result;
+  // Encode netlink messages from thrift routes directly, as one batch
+  if (not enableNextHopGroups_ and
+      std::all_of(routes->begin(), routes->end(), hasIpOrPushNextHops)) {
+    fbnl::UnicastRouteAttrs attrs;
+    attrs.protocolId = protocol.value();
+    attrs.priority = protocolToPriority(protocol.value());
+    attrs.getIfIndex = [this](const std::string& ifName) {
+      return getIfIndex(ifName);
+    };
+    auto result = nlSock_->addUnicastRoutes(*routes, attrs, {EEXIST});
+    return collectBatchResult(
+        std::move(result), addUnicastRouteFailure(std::move(routes)));
+  }
+
+  std::vector<fbnl::Route> nlRoutes;
+  nlRoutes.reserve(routes->size());
   for (auto& route : *routes) {
-    result.emplace_back(nlSock_->addRoute(buildRoute(route, protocol.value())));
+    nlRoutes.emplace_back(buildRoute(route, protocol.value()));
   }
-  return collectAllResult(std::move(result), {EEXIST});
+  if (enableNextHopGroups_) {
+    // Add routes and return a collected semifuture
+    std::vector<folly::SemiFuture<int>> result;
+    addUnicastRoutesViaGroups(
+        std::move(nlRoutes), protocol.value(), nullptr, result);
+    return collectAllResult(std::move(result), {EEXIST});
+  }
+  // Add routes as one netlink batch
+  return collectBatchResult(
+      nlSock_->addRoutes(nlRoutes, {EEXIST}),
+      addUnicastRouteFailure(std::move(routes)));
 }
 
 folly::SemiFuture<folly::Unit>
@@ -149,15 +230,30 @@ NetlinkFibHandler::semifuture_deleteUnicastRoutes(
   LOG(INFO) << "Deleting unicast routes of client " << getClientName(clientId)
             << ", numRoutes=" << prefixes->size();
 
-  // Delete routes and return a collected semifuture
-  std::vector<folly::SemiFuture<int>> result;
+  std::vector<fbnl::Route> nlRoutes;
+  nlRoutes.reserve(prefixes->size());
   for (auto& prefix : *prefixes) {
     fbnl::RouteBuilder rtBuilder;
     rtBuilder.setDestination(toIPNetwork(prefix));
     rtBuilder.setProtocolId(protocol.value());
-    result.emplace_back(nlSock_->deleteRoute(rtBuilder.build()));
+    nlRoutes.emplace_back(rtBuilder.build());
+  }
+  if (enableNextHopGroups_) {
+    // Delete routes and return a collected semifuture
+    std::vector<folly::SemiFuture<int>> result;
+    auto state = nextHopGroups_.wlock();
+    for (auto const& nlRoute : nlRoutes) {
+      deleteUnicastRouteViaGroup(*state, nlRoute, result);
+    }
+    return collectAllResult(std::move(result), {ESRCH});
   }
-  return collectAllResult(std::move(result), {ESRCH});
+  // Delete routes as one netlink batch
+  return collectBatchResult(
+      nlSock_->deleteRoutes(nlRoutes, {ESRCH}),
+      [prefixes = std::move(prefixes)](
+          thrift::PlatformFibUpdateError& error, size_t index) {
+        error.failedDeletePrefixes_ref()->emplace_back(prefixes->at(index));
+      });
 }
 
 folly::SemiFuture<folly::Unit>
@@ -171,13 +267,19 @@ NetlinkFibHandler::semifuture_addMplsRoutes(
   LOG(INFO) << "Adding/Updating mpls routes of client "
             << getClientName(clientId) << ", numRoutes=" << routes->size();
 
-  // Add routes and return a collected semifuture
-  std::vector<folly::SemiFuture<int>> result;
+  // Add routes as one netlink batch
+  std::vector<fbnl::Route> nlRoutes;
+  nlRoutes.reserve(routes->size());
   for (auto& route : *routes) {
-    result.emplace_back(
-        nlSock_->addRoute(buildMplsRoute(route, protocol.value())));
+    nlRoutes.emplace_back(buildMplsRoute(route, protocol.value()));
   }
-  return collectAllResult(std::move(result), {EEXIST});
+  return collectBatchResult(
+      nlSock_->addRoutes(nlRoutes, {EEXIST}),
+      [routes = std::move(routes)](
+          thrift::PlatformFibUpdateError& error, size_t index) {
+        error.failedAddUpdateMplsLabels_ref()->emplace_back(
+            *routes->at(index).topLabel_ref());
+      });
 }
 
 folly::SemiFuture<folly::Unit>
@@ -191,15 +293,21 @@ NetlinkFibHandler::semifuture_deleteMplsRoutes(
   LOG(INFO) << "Deleting mpls routes of client " << getClientName(clientId)
             << ", numRoutes=" << topLabels->size();
 
-  // Delete routes and return a collected semifuture
-  std::vector<folly::SemiFuture<int>> result;
+  // Delete routes as one netlink batch
+  std::vector<fbnl::Route> nlRoutes;
+  nlRoutes.reserve(topLabels->size());
   for (auto& topLabel : *topLabels) {
     fbnl::RouteBuilder rtBuilder;
     rtBuilder.setMplsLabel(topLabel);
     rtBuilder.setProtocolId(protocol.value());
-    result.emplace_back(nlSock_->deleteRoute(rtBuilder.build()));
+    nlRoutes.emplace_back(rtBuilder.build());
   }
-  return collectAllResult(std::move(result), {ESRCH});
+  return collectBatchResult(
+      nlSock_->deleteRoutes(nlRoutes, {ESRCH}),
+      [topLabels = std::move(topLabels)](
+          thrift::PlatformFibUpdateError& error, size_t index) {
+        error.failedDeleteMplsLabels_ref()->emplace_back(topLabels->at(index));
+      });
 }
 
 folly::SemiFuture<folly::Unit>
@@ -217,65 +325,115 @@ NetlinkFibHandler::semifuture_syncFib(
   // SemiFuture vector for collecting return values of all API calls
   std::vector<folly::SemiFuture<int>> result;
 
-  // Create set of existing route
-  // NOTE: Synchronous call to retrieve all the routes. We first make both
-  // requests to retrieve IPv4 and IPv6 routes. Subsequently we wait on them
-  // to complete and prepare the map of existing routes
+  // New routes by prefix
+  std::unordered_map<folly::CIDRNetwork, fbnl::Route> newRoutes;
+  for (auto& route : *unicastRoutes) {
+    newRoutes.insert_or_assign(
+        toIPNetwork(route.dest), buildRoute(route, protocol.value()));
+  }
+
+  // Diff existing routes against the new ones while they are streamed from
+  // kernel instead of materializing all of them. Only stale routes and the
+  // sync state of new ones are retained. Nexthop groups still need all
+  // existing routes to detect routes moving between groups.
+  // NOTE: Diffing happens in the netlink event-base thread. We make both
+  // requests for IPv4 and IPv6 routes and wait on both of them to complete
+  // before accessing the diff here
   std::unordered_map<folly::CIDRNetwork, fbnl::Route> existingRoutes;
+  std::unordered_map<folly::CIDRNetwork, fbnl::Route> staleRoutes;
+  std::unordered_map<folly::CIDRNetwork, bool> inSyncPrefixes;
+  auto diffRoute = [&](fbnl::Route&& route) {
+    // Linux will report a null next-hop for RTN_BLACKHOLE type while
+    // RIB does not
+    if (route.getType() == RTN_BLACKHOLE) {
+      route.setNextHops({});
+    }
+    const auto prefix = route.getDestination();
+    if (enableNextHopGroups_) {
+      existingRoutes.emplace(prefix, std::move(route));
+      return;
+    }
+    auto it = newRoutes.find(prefix);
+    if (it == newRoutes.end()) {
+      staleRoutes.emplace(prefix, std::move(route));
+      return;
+    }
+    const bool inSync = it->second == route;
+    if (not inSync) {
+      LOG(INFO) << "Updating unicast-route "
+                << "\n[OLD] " << route.str() << "\n[NEW] "
+                << it->second.str();
+    }
+    // Keep state of the first kernel route of prefix
+    inSyncPrefixes.emplace(prefix, inSync);
+  };
   {
-    auto v4Routes = nlSock_->getIPv4Routes(protocol.value()).get();
-    auto v6Routes = nlSock_->getIPv6Routes(protocol.value()).get();
-    if (v4Routes.hasError()) {
-      throw fbnl::NlException("Failed fetching IPv4 routes", v4Routes.error());
-    }
-    if (v6Routes.hasError()) {
-      throw fbnl::NlException("Failed fetching IPv6 routes", v6Routes.error());
-    }
-    for (auto& routesPtr : {&v4Routes, &v6Routes}) {
-      for (auto& route : routesPtr->value()) {
-        const auto prefix = route.getDestination();
-        // Linux will report a null next-hop for RTN_BLACKHOLE type while
-        // RIB does not
-        if (route.getType() == RTN_BLACKHOLE) {
-          route.setNextHops({});
-        }
-        existingRoutes.emplace(prefix, std::move(route));
-      }
+    auto v4Future = nlSock_->streamIPv4Routes(protocol.value(), diffRoute);
+    auto v6Future = nlSock_->streamIPv6Routes(protocol.value(), diffRoute);
+    const auto v4Status = std::move(v4Future).get();
+    const auto v6Status = std::move(v6Future).get();
+    if (v4Status != 0) {
+      throw fbnl::NlException("Failed fetching IPv4 routes", v4Status);
+    }
+    if (v6Status != 0) {
+      throw fbnl::NlException("Failed fetching IPv6 routes", v6Status);
     }
   }
 
   // Go over the new routes. Add or update
-  std::unordered_set<folly::CIDRNetwork> newPrefixes;
-  for (auto& route : *unicastRoutes) {
-    const auto network = toIPNetwork(route.dest);
-    newPrefixes.insert(network);
-    auto nlRoute = buildRoute(route, protocol.value());
-    auto it = existingRoutes.find(network);
-    if (it != existingRoutes.end() and it->second == nlRoute) {
-      // Existing route is same as the one we're trying to add. SKIP
-      continue;
+  if (enableNextHopGroups_) {
+    std::vector<fbnl::Route> nlRoutes;
+    nlRoutes.reserve(newRoutes.size());
+    for (auto& [prefix, nlRoute] : newRoutes) {
+      nlRoutes.emplace_back(nlRoute);
     }
-    if (it != existingRoutes.end()) {
-      LOG(INFO) << "Updating unicast-route "
-                << "\n[OLD] " << it->second.str() << "\n[NEW] "
-                << nlRoute.str();
-    } else {
-      LOG(INFO) << "Adding unicast-route \n[NEW]" << nlRoute.str();
+    addUnicastRoutesViaGroups(
+        std::move(nlRoutes), protocol.value(), &existingRoutes, result);
+    for (auto& [prefix, nlRoute] : existingRoutes) {
+      if (not newRoutes.count(prefix)) {
+        staleRoutes.emplace(prefix, std::move(nlRoute));
+      }
+    }
+  } else {
+    for (auto& [prefix, nlRoute] : newRoutes) {
+      auto it = inSyncPrefixes.find(prefix);
+      if (it != inSyncPrefixes.end() and it->second) {
+        // Existing route is same as the one we're trying to add. SKIP
+        continue;
+      }
+      if (it == inSyncPrefixes.end()) {
+        LOG(INFO) << "Adding unicast-route \n[NEW]" << nlRoute.str();
+      }
+      // Add new route or replace existing one
+      result.emplace_back(nlSock_->addRoute(nlRoute));
     }
-    // Add new route or replace existing one
-    result.emplace_back(nlSock_->addRoute(nlRoute));
   }
 
   // Go over the old routes to remove stale ones
-  for (auto& [prefix, nlRoute] : existingRoutes) {
-    if (newPrefixes.count(prefix)) {
-      // not a stale route
-      continue;
-    }
+  for (auto& [prefix, nlRoute] : staleRoutes) {
     // Delete stale route
     LOG(INFO) << "Deleting unicast-route "
               << folly::IPAddress::networkToString(prefix);
-    result.emplace_back(nlSock_->deleteRoute(nlRoute));
+    if (enableNextHopGroups_) {
+      deleteUnicastRouteViaGroup(*nextHopGroups_.wlock(), nlRoute, result);
+    } else {
+      result.emplace_back(nlSock_->deleteRoute(nlRoute));
+    }
+  }
+
+  // Release groups of routes missing in kernel and in the new routes, e.g.
+  // after failed requests
+  if (enableNextHopGroups_) {
+    auto state = nextHopGroups_.wlock();
+    auto& routeGroups = state->routeGroups[protocol.value()];
+    for (auto it = routeGroups.begin(); it != routeGroups.end();) {
+      if (newRoutes.count(it->first) or existingRoutes.count(it->first)) {
+        ++it;
+        continue;
+      }
+      releaseNextHopGroup(*state, it->second, result);
+      it = routeGroups.erase(it);
+    }
   }
 
   // Return collected result
@@ -507,6 +665,11 @@ void
 NetlinkFibHandler::buildNextHop(
     fbnl::RouteBuilder& rtBuilder,
     const std::vector<thrift::NextHopThrift>& nhop) {
+  int32_t maxWeight{0};
+  for (const auto& nh : nhop) {
+    maxWeight = std::max(maxWeight, *nh.weight_ref());
+  }
+
   // add nexthops
   fbnl::NextHopBuilder nhBuilder;
   for (const auto& nh : nhop) {
@@ -515,7 +678,7 @@ NetlinkFibHandler::buildNextHop(
     }
     nhBuilder.setGateway(toIPAddress(*nh.address_ref()));
     buildMplsAction(nhBuilder, nh);
-    nhBuilder.setWeight(*nh.weight_ref());
+    nhBuilder.setWeight(fbnl::toNetlinkWeight(*nh.weight_ref(), maxWeight));
     rtBuilder.addNextHop(nhBuilder.build());
     nhBuilder.reset();
   }
@@ -542,6 +705,242 @@ NetlinkFibHandler::buildRoute(const thrift::UnicastRoute& route, int protocol) {
   return rtBuilder.build();
 }
 
+std::optional<NetlinkFibHandler::NextHopGroupKey>
+NetlinkFibHandler::getNextHopGroupKey(const fbnl::Route& route) {
+  if (route.getType() == RTN_BLACKHOLE or route.getNextHops().empty()) {
+    return std::nullopt;
+  }
+
+  NextHopGroupKey key;
+  for (auto const& nh : route.getNextHops()) {
+    if (not nh.getGateway().has_value() or not nh.getIfIndex().has_value() or
+        nh.getLabelAction().has_value()) {
+      return std::nullopt;
+    }
+    key.emplace_back(
+        NextHopKey(nh.getIfIndex().value(), nh.getGateway().value()),
+        nh.getWeight());
+  }
+  std::sort(key.begin(), key.end());
+  return key;
+}
+
+void
+NetlinkFibHandler::addUnicastRoutesViaGroups(
+    std::vector<fbnl::Route>&& routes,
+    uint8_t protocol,
+    const std::unordered_map<folly::CIDRNetwork, fbnl::Route>* existingRoutes,
+    std::vector<folly::SemiFuture<int>>& result) {
+  auto state = nextHopGroups_.wlock();
+  auto& routeGroups = state->routeGroups[protocol];
+
+  std::vector<std::optional<NextHopGroupKey>> keys;
+  keys.reserve(routes.size());
+  for (auto const& route : routes) {
+    keys.emplace_back(getNextHopGroupKey(route));
+  }
+
+  // Find groups all of whose routes move to the same new nexthops, e.g. on
+  // link down. Update those in place instead of all their routes
+  std::unordered_map<
+      uint32_t,
+      std::pair<std::optional<NextHopGroupKey>, size_t /* numRoutes */>>
+      moves;
+  for (size_t i = 0; i < routes.size(); ++i) {
+    auto it = routeGroups.find(routes.at(i).getDestination());
+    if (it == routeGroups.end() or
+        keys.at(i) == state->groups.at(it->second).key) {
+      continue;
+    }
+    auto& move = moves.emplace(it->second, std::make_pair(keys.at(i), 0))
+                     .first->second;
+    if (move.first != keys.at(i)) {
+      move.first = std::nullopt; // routes move to different nexthops
+    }
+    ++move.second;
+  }
+  std::unordered_set<uint32_t> updatedGroups;
+  for (auto const& [groupId, move] : moves) {
+    auto const& [key, numRoutes] = move;
+    if (key.has_value() and numRoutes == state->groups.at(groupId).refCount and
+        not state->groupIds.count(key.value())) {
+      updateNextHopGroup(*state, groupId, key.value(), protocol, result);
+      updatedGroups.emplace(groupId);
+    }
+  }
+
+  // Program route unless it is in kernel as is already, e.g. on sync
+  auto addRoute = [&](const fbnl::Route& route) {
+    if (existingRoutes) {
+      auto existingIt = existingRoutes->find(route.getDestination());
+      if (existingIt != existingRoutes->end() and existingIt->second == route) {
+        return;
+      }
+    }
+    VLOG(1) << "Programming unicast-route " << route.str();
+    result.emplace_back(nlSock_->addRoute(route));
+  };
+
+  for (size_t i = 0; i < routes.size(); ++i) {
+    auto& route = routes.at(i);
+    auto const& key = keys.at(i);
+    auto it = routeGroups.find(route.getDestination());
+    std::optional<uint32_t> oldGroupId;
+    if (it != routeGroups.end()) {
+      oldGroupId = it->second;
+    }
+
+    // Route can't use nexthop objects, program its nexthops
+    if (not key.has_value()) {
+      addRoute(route);
+      if (oldGroupId.has_value()) {
+        releaseNextHopGroup(*state, oldGroupId.value(), result);
+        routeGroups.erase(it);
+      }
+      continue;
+    }
+
+    if (oldGroupId.has_value() and
+        state->groups.at(oldGroupId.value()).key == key.value()) {
+      if (updatedGroups.count(oldGroupId.value())) {
+        continue; // forwards via the updated group already
+      }
+      route.setNextHopId(oldGroupId.value());
+    } else {
+      // Acquire new group before releasing the old one to keep objects of
+      // shared nexthops
+      route.setNextHopId(
+          acquireNextHopGroup(*state, key.value(), protocol, result));
+    }
+
+    addRoute(route);
+
+    const auto groupId = route.getNextHopId().value();
+    if (not oldGroupId.has_value()) {
+      routeGroups.emplace(route.getDestination(), groupId);
+    } else if (oldGroupId.value() != groupId) {
+      releaseNextHopGroup(*state, oldGroupId.value(), result);
+      it->second = groupId;
+    }
+  }
+}
+
+void
+NetlinkFibHandler::deleteUnicastRouteViaGroup(
+    NextHopGroupState& state,
+    const fbnl::Route& route,
+    std::vector<folly::SemiFuture<int>>& result) {
+  result.emplace_back(nlSock_->deleteRoute(route));
+
+  auto& routeGroups = state.routeGroups[route.getProtocolId()];
+  auto it = routeGroups.find(route.getDestination());
+  if (it != routeGroups.end()) {
+    releaseNextHopGroup(state, it->second, result);
+    routeGroups.erase(it);
+  }
+}
+
+uint32_t
+NetlinkFibHandler::acquireNextHopGroup(
+    NextHopGroupState& state,
+    const NextHopGroupKey& key,
+    uint8_t protocol,
+    std::vector<folly::SemiFuture<int>>& result) {
+  auto it = state.groupIds.find(key);
+  if (it != state.groupIds.end()) {
+    ++state.groups.at(it->second).refCount;
+    return it->second;
+  }
+
+  const auto groupId = state.nextGroupId++;
+  programNextHopGroup(state, groupId, key, protocol, result);
+  state.groupIds.emplace(key, groupId);
+  state.groups.emplace(groupId, NextHopGroup{key, 1});
+  return groupId;
+}
+
+void
+NetlinkFibHandler::releaseNextHopGroup(
+    NextHopGroupState& state,
+    uint32_t groupId,
+    std::vector<folly::SemiFuture<int>>& result) {
+  auto it = state.groups.find(groupId);
+  CHECK(it != state.groups.end());
+  if (--it->second.refCount) {
+    return;
+  }
+
+  // Delete group before its nexthops
+  result.emplace_back(
+      ignoreMissingNextHop(nlSock_->deleteNextHopObject(groupId)));
+  const auto key = std::move(it->second.key);
+  state.groupIds.erase(key);
+  state.groups.erase(it);
+  releaseNextHops(state, key, result);
+}
+
+void
+NetlinkFibHandler::updateNextHopGroup(
+    NextHopGroupState& state,
+    uint32_t groupId,
+    const NextHopGroupKey& key,
+    uint8_t protocol,
+    std::vector<folly::SemiFuture<int>>& result) {
+  auto& group = state.groups.at(groupId);
+  VLOG(1) << "Updating nexthop group " << groupId << " of " << group.refCount
+          << " routes in place";
+  programNextHopGroup(state, groupId, key, protocol, result);
+  releaseNextHops(state, group.key, result);
+  state.groupIds.erase(group.key);
+  state.groupIds.emplace(key, groupId);
+  group.key = key;
+}
+
+void
+NetlinkFibHandler::programNextHopGroup(
+    NextHopGroupState& state,
+    uint32_t groupId,
+    const NextHopGroupKey& key,
+    uint8_t protocol,
+    std::vector<folly::SemiFuture<int>>& result) {
+  std::vector<std::pair<uint32_t, uint8_t>> members;
+  for (auto const& [nextHopKey, weight] : key) {
+    auto [it, inserted] = state.nextHops.emplace(
+        nextHopKey, std::make_pair(state.nextNextHopId, 0));
+    if (inserted) {
+      ++state.nextNextHopId;
+      fbnl::NextHopBuilder nhBuilder;
+      nhBuilder.setIfIndex(nextHopKey.first).setGateway(nextHopKey.second);
+      result.emplace_back(nlSock_->addNextHopObject(fbnl::NextHopObject(
+          it->second.first, protocol, nhBuilder.build())));
+    }
+    ++it->second.second;
+    members.emplace_back(it->second.first, weight);
+  }
+
+  // Routes use a group even for single nexthop, kernel only replaces a group
+  // with another group
+  result.emplace_back(nlSock_->addNextHopObject(
+      fbnl::NextHopObject(groupId, protocol, std::move(members))));
+}
+
+void
+NetlinkFibHandler::releaseNextHops(
+    NextHopGroupState& state,
+    const NextHopGroupKey& key,
+    std::vector<folly::SemiFuture<int>>& result) {
+  for (auto const& [nextHopKey, weight] : key) {
+    auto it = state.nextHops.find(nextHopKey);
+    CHECK(it != state.nextHops.end());
+    if (--it->second.second) {
+      continue;
+    }
+    result.emplace_back(
+        ignoreMissingNextHop(nlSock_->deleteNextHopObject(it->second.first)));
+    state.nextHops.erase(it);
+  }
+}
+
 fbnl::Route
 NetlinkFibHandler::buildMplsRoute(
     const thrift::MplsRoute& mplsRoute, int protocol) {
@@ -566,82 +965,50 @@ NetlinkFibHandler::buildMplsRoute(
 
 std::optional<int>
 NetlinkFibHandler::getIfIndex(const std::string& ifName) {
-  // Lambda function to lookup ifName in cache
-  auto getCachedIndex = [this, &ifName]() -> std::optional<int> {
-    auto cache = ifNameToIndex_.rlock();
-    auto it = cache->find(ifName);
-    if (it != cache->end()) {
-      return it->second;
-    }
-    return std::nullopt;
-  };
-
-  // Lookup in cache. Return if exists
-  auto maybeIndex = getCachedIndex();
+  const auto& interfaceTable = nlSock_->getInterfaceTable();
+  auto maybeIndex = interfaceTable.getIfIndex(ifName);
   if (maybeIndex.has_value()) {
     return maybeIndex;
   }
 
-  // Update cache and return cached index
-  initializeInterfaceCache();
-  return getCachedIndex();
+  // Refresh table and lookup again
+  refreshInterfaceTable();
+  return interfaceTable.getIfIndex(ifName);
 }
 
 std::optional<std::string>
 NetlinkFibHandler::getIfName(const int ifIndex) {
-  // Lambda function to lookup ifIndex in cache
-  auto getCachedName = [this, ifIndex]() -> std::optional<std::string> {
-    auto cache = ifIndexToName_.rlock();
-    auto it = cache->find(ifIndex);
-    if (it != cache->end()) {
-      return it->second;
-    }
-    return std::nullopt;
-  };
-
-  // Lookup in cache. Return if exists
-  auto maybeName = getCachedName();
+  const auto& interfaceTable = nlSock_->getInterfaceTable();
+  auto maybeName = interfaceTable.getIfName(ifIndex);
   if (maybeName.has_value()) {
     return maybeName;
   }
 
-  // Update cache and return cached index
-  initializeInterfaceCache();
-  return getCachedName();
+  // Refresh table and lookup again
+  refreshInterfaceTable();
+  return interfaceTable.getIfName(ifIndex);
 }
 
 std::optional<int>
 NetlinkFibHandler::getLoopbackIfIndex() {
-  auto index = loopbackIfIndex_.load();
-  if (index < 0) {
-    initializeInterfaceCache();
-    index = loopbackIfIndex_.load();
+  const auto& interfaceTable = nlSock_->getInterfaceTable();
+  auto maybeIndex = interfaceTable.getLoopbackIfIndex();
+  if (maybeIndex.has_value()) {
+    return maybeIndex;
   }
 
-  if (index < 0) {
-    return std::nullopt;
-  }
-  return index;
+  // Refresh table and lookup again
+  refreshInterfaceTable();
+  return interfaceTable.getLoopbackIfIndex();
 }
 
 void
-NetlinkFibHandler::initializeInterfaceCache() noexcept {
-  auto links = nlSock_->getAllLinks().get().value();
-
-  // Acquire locks on the cache
-  auto lockedIfNameToIndex = ifNameToIndex_.wlock();
-  auto lockedIfIndexToName = ifIndexToName_.wlock();
-
-  // NOTE: We don't clear cache instead override entries
-  for (auto const& link : links) {
-    // Update name <-> index mappings
-    (*lockedIfNameToIndex)[link.getLinkName()] = link.getIfIndex();
-    (*lockedIfIndexToName)[link.getIfIndex()] = link.getLinkName();
-
-    // Update loopbackIfIndex_
-    if (link.isLoopback()) {
-      loopbackIfIndex_.store(link.getIfIndex());
-    }
+NetlinkFibHandler::refreshInterfaceTable() noexcept {
+  // Links of dump are added to the table as they are received
+  auto links = nlSock_->getAllLinks().get();
+  if (links.hasError()) {
+    LOG(ERROR) << "Failed fetching links for interface table. Error: "
+               << folly::errnoStr(std::abs(links.error()));
   }
 }
 
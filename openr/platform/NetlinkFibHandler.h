@@ -8,14 +8,18 @@
 #pragma once
 
 #include <chrono>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <fb303/BaseService.h>
 #include <fbzmq/async/ZmqTimeout.h>
 #include <folly/Expected.h>
+#include <folly/Function.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/AsyncSocket.h>
 
@@ -36,11 +40,17 @@ namespace openr {
  * - Translates netlink representation of routes to thrift for get* queries
  * - All APIs exposed are asynchronous. Sync API retries the existing routing
  *   state in synchronous way and program changes asynchrnously.
+ * - Optionally unicast routes forward via kernel nexthop groups (linux 5.3+).
+ *   Each distinct set of nexthops is programmed once as group, shared by all
+ *   routes using it. When all routes of a group move to the same new nexthops
+ *   in one request, e.g. on link down, the group is updated in place instead
+ *   of every route.
  */
 class NetlinkFibHandler : public thrift::FibServiceSvIf,
                           public facebook::fb303::BaseService {
  public:
-  explicit NetlinkFibHandler(fbnl::NetlinkProtocolSocket* nlSock);
+  explicit NetlinkFibHandler(
+      fbnl::NetlinkProtocolSocket* nlSock, bool enableNextHopGroups = false);
   ~NetlinkFibHandler() override;
 
   void
@@ -119,6 +129,16 @@ class NetlinkFibHandler : public thrift::FibServiceSvIf,
       std::vector<folly::SemiFuture<int>>&& result,
       std::set<int> errorsToIgnore);
 
+  /**
+   * Convert failures of a netlink batch request to SemiFuture<Unit>
+   * Failures if any will be converted to PlatformFibUpdateError, with route
+   * of each failed request added to it by `addFailure` from its batch index
+   */
+  static folly::SemiFuture<folly::Unit> collectBatchResult(
+      folly::SemiFuture<fbnl::NetlinkBatchFailures>&& result,
+      folly::Function<void(thrift::PlatformFibUpdateError&, size_t)>
+          addFailure);
+
  protected:
   /**
    * TODO: Migrate BGP++ to stream API for neighbor notifications. Also need to
@@ -166,9 +186,9 @@ class NetlinkFibHandler : public thrift::FibServiceSvIf,
    * APIs to convert ifName <-> ifIndex for thrift <-> netlink route conversions
    * Returns `folly::none` if can't find the mapping.
    *
-   * Cache is used for optimized response to subsequent query for same interface
-   * name or index. Entries in cache are lazily initialized on first instance by
-   * querying `getAllLinks`.
+   * Mappings are looked up lock-free in the interface table of netlink socket,
+   * which is kept up to date from link events. Only on miss, e.g. before any
+   * link is known, table is refreshed by querying `getAllLinks`.
    *
    * Returns `std::nullopt` if mapping is not found
    */
@@ -184,6 +204,92 @@ class NetlinkFibHandler : public thrift::FibServiceSvIf,
   // Used to interact with Linux kernel routing table
   fbnl::NetlinkProtocolSocket* nlSock_{nullptr};
 
+  // Nexthop (interface, gateway) and sorted nexthops with weights of a group
+  using NextHopKey = std::pair<int, folly::IPAddress>;
+  using NextHopGroupKey = std::vector<std::pair<NextHopKey, uint8_t>>;
+
+  struct NextHopGroup {
+    NextHopGroupKey key;
+    // number of routes using the group
+    size_t refCount{0};
+  };
+
+  struct NextHopGroupState {
+    // nexthop object id and number of groups using it, per nexthop
+    std::map<NextHopKey, std::pair<uint32_t, size_t>> nextHops;
+    std::map<NextHopGroupKey, uint32_t> groupIds;
+    std::unordered_map<uint32_t, NextHopGroup> groups;
+    // group used by each unicast route
+    std::unordered_map<folly::CIDRNetwork, uint32_t> routeGroups;
+    // separate id ranges, the kernel does not replace a group with a single
+    // nexthop or vice versa when reusing ids of stale objects
+    uint32_t nextNextHopId{1};
+    uint32_t nextGroupId{1u << 31};
+  };
+
+  /**
+   * Nexthop group key of route, std::nullopt if it can't use nexthop objects
+   * e.g. for blackhole routes and nexthops with label action
+   */
+  static std::optional<NextHopGroupKey> getNextHopGroupKey(
+      const fbnl::Route& route);
+
+  /**
+   * Program unicast routes via nexthop groups. Groups and nexthop objects are
+   * created before and deleted after the routes using them. Routes equal to
+   * their entry in `existingRoutes` if given are skipped.
+   */
+  void addUnicastRoutesViaGroups(
+      std::vector<fbnl::Route>&& routes,
+      uint8_t protocol,
+      const std::unordered_map<folly::CIDRNetwork, fbnl::Route>*
+          existingRoutes,
+      std::vector<folly::SemiFuture<int>>& result);
+
+  // Delete unicast route and release its nexthop group
+  void deleteUnicastRouteViaGroup(
+      NextHopGroupState& state,
+      const fbnl::Route& route,
+      std::vector<folly::SemiFuture<int>>& result);
+
+  uint32_t acquireNextHopGroup(
+      NextHopGroupState& state,
+      const NextHopGroupKey& key,
+      uint8_t protocol,
+      std::vector<folly::SemiFuture<int>>& result);
+
+  void releaseNextHopGroup(
+      NextHopGroupState& state,
+      uint32_t groupId,
+      std::vector<folly::SemiFuture<int>>& result);
+
+  // Update members of existing group in place
+  void updateNextHopGroup(
+      NextHopGroupState& state,
+      uint32_t groupId,
+      const NextHopGroupKey& key,
+      uint8_t protocol,
+      std::vector<folly::SemiFuture<int>>& result);
+
+  // Program group object with the nexthop objects of key, creating them
+  // if needed
+  void programNextHopGroup(
+      NextHopGroupState& state,
+      uint32_t groupId,
+      const NextHopGroupKey& key,
+      uint8_t protocol,
+      std::vector<folly::SemiFuture<int>>& result);
+
+  // Release the nexthop objects of key, deleting unused ones
+  void releaseNextHops(
+      NextHopGroupState& state,
+      const NextHopGroupKey& key,
+      std::vector<folly::SemiFuture<int>>& result);
+
+  const bool enableNextHopGroups_{false};
+
+  folly::Synchronized<NextHopGroupState> nextHopGroups_;
+
  private:
   /**
    * Disable copy & assignment operators
@@ -192,17 +298,9 @@ class NetlinkFibHandler : public thrift::FibServiceSvIf,
   NetlinkFibHandler& operator=(const NetlinkFibHandler&) = delete;
 
   /**
-   * Initialize cache related to interfaces. Especially loopbackIfIndex_
-   * and interface name <-> index mappings
+   * Refresh interface table of netlink socket by dumping all links
    */
-  void initializeInterfaceCache() noexcept;
-
-  // Cache for interface index <-> name mapping
-  folly::Synchronized<std::unordered_map<std::string, int>> ifNameToIndex_;
-  folly::Synchronized<std::unordered_map<int, std::string>> ifIndexToName_;
-
-  // Loopback interface index cache. Initialized to negative number
-  std::atomic<int> loopbackIfIndex_{-1};
+  void refreshInterfaceTable() noexcept;
 
   // Time when service started, in number of seconds, since epoch
   const int64_t startTime_{0};
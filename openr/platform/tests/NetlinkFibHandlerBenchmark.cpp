@@ -4,6 +4,8 @@
  * This source code is licensed under the MIT license found in the
  * LICENSE file in the root directory of this source tree.
  */
+#include <unistd.h>
+
 #include <map>
 #include <memory>
 #include <string>
@@ -22,6 +24,7 @@
 #include <folly/test/TestUtils.h>
 
 #include <openr/platform/NetlinkFibHandler.h>
+#include <openr/tests/BenchmarkDriver.h>
 #include <openr/tests/mocks/MockNetlinkProtocolSocket.h>
 #include <openr/tests/mocks/PrefixGenerator.h>
 
@@ -37,9 +40,21 @@ const std::string kVethNameY("vethTestY");
 static const uint8_t kBitMaskLen = 128;
 // Number of nexthops
 const uint8_t kNumOfNexthops = 128;
+// Number of nexthops of routes in large route DB
+const uint8_t kNumOfLargeDbNexthops = 4;
 
 const int16_t kFibId{static_cast<int16_t>(openr::thrift::FibClient::OPENR)};
 
+// Protocol of routes not owned by Open/R, e.g. BGP
+const uint8_t kForeignProtocolId{186};
+// Number of Open/R routes to sync in presence of foreign routes
+const uint32_t kNumOfSyncPrefixes{10000};
+
+// Number of routes per address family programmed in the kernel
+const uint32_t kNumOfKernelPrefixes{50000};
+// Protocol of routes programmed in the kernel
+const uint8_t kKernelProtocolId{99};
+
 } // namespace
 
 namespace openr {
@@ -113,11 +128,163 @@ BENCHMARK_PARAM(BM_NetlinkFibHandler, 100);
 BENCHMARK_PARAM(BM_NetlinkFibHandler, 1000);
 BENCHMARK_PARAM(BM_NetlinkFibHandler, 10000);
 
+/**
+ * Benchmark test to measure the time of programming a large route DB, which
+ * is sent to netlink as one batch of requests
+ * 1. Create a NetlinkFibHandler
+ * 2. Generate random IpV6 routes with few nexthops
+ * 3. Measure adding all routes through netlink
+ */
+static void
+BM_NetlinkFibHandlerLargeRouteDb(uint32_t iters, size_t numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto netlinkFibWrapper = std::make_unique<NetlinkFibWrapper>();
+
+  // Randomly generate IPV6 prefixes
+  auto prefixes = netlinkFibWrapper->prefixGenerator.ipv6PrefixGenerator(
+      numOfPrefixes, kBitMaskLen);
+
+  for (uint32_t i = 0; i < iters; i++) {
+    auto routes = std::make_unique<std::vector<thrift::UnicastRoute>>();
+    routes->reserve(prefixes.size());
+    for (auto const& prefix : prefixes) {
+      routes->emplace_back(createUnicastRoute(
+          prefix,
+          netlinkFibWrapper->prefixGenerator.getRandomNextHopsUnicast(
+              kNumOfLargeDbNexthops, kVethNameY)));
+    }
+
+    suspender.dismiss(); // Start measuring benchmark time
+    netlinkFibWrapper->fibHandler
+        ->semifuture_addUnicastRoutes(kFibId, std::move(routes))
+        .wait();
+    suspender.rehire(); // Stop measuring time again
+  }
+}
+
+// The parameter is the number of prefixes
+BENCHMARK_PARAM(BM_NetlinkFibHandlerLargeRouteDb, 100000);
+BENCHMARK_PARAM(BM_NetlinkFibHandlerLargeRouteDb, 500000);
+
+/**
+ * Benchmark test to measure the time of syncing Open/R routes while routes
+ * of another protocol are present
+ * 1. Create a NetlinkFibHandler
+ * 2. Add foreign routes and half of the Open/R routes
+ * 3. Measure syncing all Open/R routes
+ */
+static void
+BM_NetlinkFibHandlerSyncFib(uint32_t iters, size_t numOfForeignPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto netlinkFibWrapper = std::make_unique<NetlinkFibWrapper>();
+
+  // Foreign routes
+  for (auto const& prefix :
+       netlinkFibWrapper->prefixGenerator.ipv6PrefixGenerator(
+           numOfForeignPrefixes, kBitMaskLen)) {
+    fbnl::RouteBuilder builder;
+    builder.setDestination(toIPNetwork(prefix))
+        .setProtocolId(kForeignProtocolId);
+    netlinkFibWrapper->nlSock->addRoute(builder.build()).get();
+  }
+
+  auto prefixes = netlinkFibWrapper->prefixGenerator.ipv6PrefixGenerator(
+      kNumOfSyncPrefixes, kBitMaskLen);
+  for (uint32_t i = 0; i < iters; i++) {
+    auto routes = std::make_unique<std::vector<thrift::UnicastRoute>>();
+    for (auto const& prefix : prefixes) {
+      routes->emplace_back(createUnicastRoute(
+          prefix,
+          netlinkFibWrapper->prefixGenerator.getRandomNextHopsUnicast(
+              kNumOfLargeDbNexthops, kVethNameY)));
+    }
+    // Half of the routes are programmed already
+    auto existingRoutes = std::make_unique<std::vector<thrift::UnicastRoute>>(
+        routes->begin(), routes->begin() + routes->size() / 2);
+    netlinkFibWrapper->fibHandler
+        ->semifuture_syncFib(kFibId, std::move(existingRoutes))
+        .wait();
+
+    suspender.dismiss(); // Start measuring benchmark time
+    netlinkFibWrapper->fibHandler
+        ->semifuture_syncFib(kFibId, std::move(routes))
+        .wait();
+    suspender.rehire(); // Stop measuring time again
+  }
+}
+
+// The parameter is the number of foreign prefixes
+BENCHMARK_PARAM(BM_NetlinkFibHandlerSyncFib, 0);
+BENCHMARK_PARAM(BM_NetlinkFibHandlerSyncFib, 1000000);
+
+/**
+ * Benchmark test to measure programming IPv4 and IPv6 routes in the kernel as
+ * one batch, over one netlink socket or over a route socket per address
+ * family. Requires root, skipped otherwise
+ * 1. Create a NetlinkProtocolSocket
+ * 2. Generate IPv4 and IPv6 routes via loopback
+ * 3. Measure adding all routes through netlink
+ */
+static void
+BM_NetlinkRouteSocketsPerFamily(
+    uint32_t iters, bool enableRouteSocketsPerFamily) {
+  auto suspender = folly::BenchmarkSuspender();
+  if (getuid()) {
+    LOG(WARNING) << "Skipping kernel route benchmark, must run as root";
+    return;
+  }
+
+  folly::EventBase evb;
+  messaging::ReplicateQueue<NetlinkEvent> netlinkEventsQ;
+  auto nlSock = std::make_unique<NetlinkProtocolSocket>(
+      &evb,
+      netlinkEventsQ,
+      false /* enableIPv6RouteReplaceSemantics */,
+      enableRouteSocketsPerFamily);
+  std::thread evbThread([&evb]() { evb.loopForever(); });
+  evb.waitUntilRunning();
+
+  // link dump fills the interface table
+  nlSock->getAllLinks().wait();
+  const auto loIfIndex = nlSock->getInterfaceTable().getIfIndex("lo");
+  CHECK(loIfIndex.has_value());
+  std::vector<fbnl::Route> routes;
+  auto addRoute = [&](folly::CIDRNetwork const& prefix) {
+    fbnl::RouteBuilder builder;
+    builder.setDestination(prefix)
+        .setProtocolId(kKernelProtocolId)
+        .addNextHop(fbnl::NextHopBuilder().setIfIndex(*loIfIndex).build());
+    routes.emplace_back(builder.build());
+  };
+  for (uint32_t i = 0; i < kNumOfKernelPrefixes; ++i) {
+    addRoute({folly::IPAddressV4::fromLongHBO(0x0a000000 + (i << 2)), 30});
+  }
+  for (auto const& prefix : PrefixGenerator().ipv6PrefixGenerator(
+           kNumOfKernelPrefixes, kBitMaskLen)) {
+    addRoute(toIPNetwork(prefix));
+  }
+
+  for (uint32_t i = 0; i < iters; i++) {
+    suspender.dismiss(); // Start measuring benchmark time
+    nlSock->addRoutes(routes, {EEXIST}).wait();
+    suspender.rehire(); // Stop measuring time again
+    nlSock->deleteRoutes(routes, {ESRCH}).wait();
+  }
+
+  nlSock.reset();
+  netlinkEventsQ.close();
+  evb.terminateLoopSoon();
+  evbThread.join();
+}
+
+BENCHMARK_NAMED_PARAM(BM_NetlinkRouteSocketsPerFamily, one_socket, false);
+BENCHMARK_NAMED_PARAM(
+    BM_NetlinkRouteSocketsPerFamily, socket_per_family, true);
+
 } // namespace openr
 
 int
 main(int argc, char** argv) {
   folly::init(&argc, &argv);
-  folly::runBenchmarks();
-  return 0;
+  return openr::runBenchmarks();
 }
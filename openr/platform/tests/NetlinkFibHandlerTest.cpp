@@ -6,6 +6,7 @@
 #include <unistd.h>
 #include <algorithm>
 #include <chrono>
+#include <set>
 #include <stdexcept>
 
 #include <folly/Format.h>
@@ -345,6 +346,37 @@ TEST_P(FibHandlerFixture, UnicastAddUcmp) {
   EXPECT_EQ(r1, routes->at(0));
 }
 
+//
+// Routes of a batch failing to be programmed are reported while the others
+// get programmed
+//
+TEST_P(FibHandlerFixture, UnicastAddPartialFailure) {
+  const int16_t kClientId = 786;
+  const bool isV4 = GetParam();
+
+  // Second route is via an unknown interface
+  auto routesToAdd = createUnicastRoutes(3, isV4);
+  routesToAdd.at(1).nextHops_ref()->at(0).address_ref()->ifName_ref() =
+      "unknown";
+
+  try {
+    handler
+        .semifuture_addUnicastRoutes(
+            kClientId,
+            std::make_unique<std::vector<thrift::UnicastRoute>>(routesToAdd))
+        .get();
+    FAIL() << "Expected PlatformFibUpdateError";
+  } catch (const thrift::PlatformFibUpdateError& error) {
+    ASSERT_EQ(1, error.failedAddUpdatePrefixes_ref()->size());
+    EXPECT_EQ(
+        routesToAdd.at(1).dest, error.failedAddUpdatePrefixes_ref()->at(0));
+    EXPECT_EQ(0, error.failedDeletePrefixes_ref()->size());
+  }
+
+  auto routes = handler.semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(2, routes->size());
+}
+
 //
 // Add/Get route with label push action
 //
@@ -759,6 +791,128 @@ TEST_P(FibHandlerFixture, MplsMultipleClient) {
   }
 }
 
+//
+// Unicast routes via nexthop groups. Routes with same nexthops share a group,
+// which is updated in place if all its routes move to new nexthops together
+//
+TEST(NetlinkFibHandler, UnicastNextHopGroups) {
+  const int16_t kClient = 786;
+  const uint8_t kProtocol = 99;
+  folly::EventBase nlEvb;
+  fbnl::MockNetlinkProtocolSocket nlSock(&nlEvb);
+  for (size_t i = 0; i < kInterfaces.size(); ++i) {
+    ASSERT_EQ(
+        0,
+        nlSock
+            .addLink(
+                fbnl::utils::createLink(i + 1, kInterfaces.at(i), true, false))
+            .get());
+  }
+  NetlinkFibHandler handler(&nlSock, true /* enableNextHopGroups */);
+
+  auto createNextHopV6 = [](size_t index) {
+    thrift::NextHopThrift nh;
+    *nh.address_ref() = toBinaryAddress(folly::sformat(kNextHopV6, 1 + index));
+    nh.address_ref()->ifName_ref() = kInterfaces.at(index);
+    nh.weight_ref() = 0;
+    return nh;
+  };
+  auto createRoute = [&](size_t index, std::vector<size_t> nhIndices) {
+    thrift::UnicastRoute route;
+    route.dest = toIpPrefix(folly::sformat(kPrefixV6, 0, 1 + index));
+    for (auto nhIndex : nhIndices) {
+      route.nextHops_ref()->emplace_back(createNextHopV6(nhIndex));
+    }
+    return route;
+  };
+  auto addRoutes = [&](std::vector<thrift::UnicastRoute> routes) {
+    handler
+        .semifuture_addUnicastRoutes(
+            kClient,
+            std::make_unique<std::vector<thrift::UnicastRoute>>(
+                std::move(routes)))
+        .get();
+  };
+  // nexthop object id of the routes, keyed by prefix
+  auto getNextHopIds = [&]() {
+    std::map<folly::CIDRNetwork, std::optional<uint32_t>> nextHopIds;
+    for (auto const& route : nlSock.getIPv6Routes(kProtocol).get().value()) {
+      nextHopIds.emplace(route.getDestination(), route.getNextHopId());
+    }
+    return nextHopIds;
+  };
+  // gateways of group members
+  auto getGroupGateways = [&](uint32_t groupId) {
+    std::set<folly::IPAddress> gateways;
+    auto const& objects = nlSock.getNextHopObjects();
+    for (auto const& [memberId, weight] : objects.at(groupId).getGroup()) {
+      gateways.emplace(objects.at(memberId).getNextHop()->getGateway().value());
+    }
+    return gateways;
+  };
+  const folly::IPAddress nh0(folly::sformat(kNextHopV6, 1));
+  const folly::IPAddress nh1(folly::sformat(kNextHopV6, 2));
+  const folly::IPAddress nh2(folly::sformat(kNextHopV6, 3));
+
+  // Three routes via {nh0, nh1} and one via {nh0}: 2 nexthops, 2 groups
+  addRoutes({createRoute(0, {0, 1}),
+             createRoute(1, {0, 1}),
+             createRoute(2, {0, 1}),
+             createRoute(3, {0})});
+  EXPECT_EQ(4, nlSock.getNextHopObjects().size());
+  auto nextHopIds = getNextHopIds();
+  ASSERT_EQ(4, nextHopIds.size());
+  const auto sharedGroupId = nextHopIds.begin()->second.value();
+  for (auto const& [prefix, nextHopId] : nextHopIds) {
+    ASSERT_TRUE(nextHopId.has_value());
+  }
+  EXPECT_EQ(
+      (std::set<folly::IPAddress>{nh0, nh1}), getGroupGateways(sharedGroupId));
+  EXPECT_EQ(4, handler.semifuture_getRouteTableByClient(kClient).get()->size());
+
+  // nh1 goes down, all routes of the group move to {nh0, nh2}: group is
+  // updated in place, routes still refer to it and nh1 is gone
+  addRoutes(
+      {createRoute(0, {0, 2}), createRoute(1, {0, 2}), createRoute(2, {0, 2})});
+  EXPECT_EQ(4, nlSock.getNextHopObjects().size());
+  EXPECT_EQ(nextHopIds, getNextHopIds());
+  EXPECT_EQ(
+      (std::set<folly::IPAddress>{nh0, nh2}), getGroupGateways(sharedGroupId));
+
+  // one route moves to the nexthops of another group: it is pointed at that
+  // group, the shared one stays as is
+  addRoutes({createRoute(0, {0})});
+  auto newNextHopIds = getNextHopIds();
+  EXPECT_EQ(nextHopIds.rbegin()->second, newNextHopIds.begin()->second);
+  EXPECT_EQ(4, nlSock.getNextHopObjects().size());
+
+  // route without gateway interface can't use nexthop objects
+  auto inlineRoute = createRoute(4, {1});
+  inlineRoute.nextHops_ref()->at(0).address_ref()->ifName_ref().reset();
+  addRoutes({inlineRoute});
+  EXPECT_FALSE(getNextHopIds().rbegin()->second.has_value());
+
+  // sync to a single route, unused groups and nexthops are removed
+  handler
+      .semifuture_syncFib(
+          kClient,
+          std::make_unique<std::vector<thrift::UnicastRoute>>(
+              std::vector<thrift::UnicastRoute>{createRoute(1, {0, 2})}))
+      .get();
+  EXPECT_EQ(1, getNextHopIds().size());
+  EXPECT_EQ(3, nlSock.getNextHopObjects().size());
+
+  // delete last route, no nexthop object is left
+  handler
+      .semifuture_deleteUnicastRoutes(
+          kClient,
+          std::make_unique<std::vector<thrift::IpPrefix>>(
+              std::vector<thrift::IpPrefix>{createRoute(1, {}).dest}))
+      .get();
+  EXPECT_EQ(0, getNextHopIds().size());
+  EXPECT_EQ(0, nlSock.getNextHopObjects().size());
+}
+
 //
 // instantiate parameterized tests
 //
@@ -17,4 +17,15 @@ void
 pluginStop() {
   return;
 }
+
+std::shared_ptr<LivenessProvider>
+pluginCreateLivenessProvider(std::shared_ptr<const Config> /* config */) {
+  return nullptr;
+}
+
+std::unique_ptr<RouteComputationEngine>
+pluginCreateRouteComputationEngine(
+    std::string const& /* name */, std::shared_ptr<const Config> /* config */) {
+  return nullptr;
+}
 } // namespace openr
@@ -14,22 +14,34 @@
 
 #include <openr/common/Types.h>
 #include <openr/config/Config.h>
+#include <openr/decision/RouteComputationEngine.h>
 #include <openr/decision/RouteUpdate.h>
 #include <openr/if/gen-cpp2/Fib_types.h>
 #include <openr/if/gen-cpp2/PrefixManager_types.h>
 #include <openr/messaging/Queue.h>
 #include <openr/messaging/ReplicateQueue.h>
+#include <openr/spark/LivenessProvider.h>
 
 namespace openr {
 struct PluginArgs {
   messaging::ReplicateQueue<thrift::PrefixUpdateRequest>& prefixUpdatesQueue;
   messaging::ReplicateQueue<openr::thrift::RouteDatabaseDelta>&
       staticRoutesUpdateQueue;
-  messaging::RQueue<DecisionRouteUpdate> routeUpdatesQueue;
+  messaging::RQueue<DecisionRouteUpdatePtr> routeUpdatesQueue;
   std::shared_ptr<const Config> config;
   std::shared_ptr<wangle::SSLContextConfig> sslContext;
 };
 
 void pluginStart(const PluginArgs& /* pluginArgs */);
 void pluginStop();
+
+// Platform specific liveness detection for Spark neighbors, e.g. BFD. Called
+// once per Spark shard, nullptr if not supported.
+std::shared_ptr<LivenessProvider> pluginCreateLivenessProvider(
+    std::shared_ptr<const Config> /* config */);
+
+// Route computation engine of given name to use in Decision instead of
+// SpfSolver, see decision_config.route_engine. nullptr if not supported.
+std::unique_ptr<RouteComputationEngine> pluginCreateRouteComputationEngine(
+    std::string const& /* name */, std::shared_ptr<const Config> /* config */);
 } // namespace openr
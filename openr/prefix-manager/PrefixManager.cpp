@@ -7,7 +7,10 @@
 
 #include "PrefixManager.h"
 
+#include <cmath>
+
 #include <fb303/ServiceData.h>
+#include <folly/fibers/FiberManager.h>
 #include <folly/futures/Future.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 #if FOLLY_USE_SYMBOLIZER
@@ -16,6 +19,7 @@
 
 #include <openr/common/Constants.h>
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/SerializationBuffer.h>
 #include <openr/kvstore/KvStore.h>
 
 namespace fb303 = facebook::fb303;
@@ -31,11 +35,33 @@ getPrefixTypeName(thrift::PrefixType const& type) {
   return apache::thrift::TEnumTraits<thrift::PrefixType>::findName(type);
 }
 
+// dampening penalty left after elapsed time, halved every halfLife
+double
+decayPenalty(
+    double penalty,
+    std::chrono::steady_clock::duration elapsed,
+    std::chrono::seconds halfLife) {
+  return penalty *
+      std::exp2(-std::chrono::duration<double>(elapsed) / halfLife);
+}
+
+// time until dampening penalty decays below threshold, rounded up
+std::chrono::milliseconds
+timeToDecay(double penalty, double threshold, std::chrono::seconds halfLife) {
+  if (penalty < threshold) {
+    return std::chrono::milliseconds(0);
+  }
+  return std::chrono::ceil<std::chrono::milliseconds>(
+             std::chrono::duration<double>(halfLife) *
+             std::log2(penalty / threshold)) +
+      std::chrono::milliseconds(1);
+}
+
 } // namespace
 
 PrefixManager::PrefixManager(
     messaging::RQueue<thrift::PrefixUpdateRequest> prefixUpdateRequestQueue,
-    messaging::RQueue<DecisionRouteUpdate> decisionRouteUpdatesQueue,
+    messaging::RQueue<DecisionRouteUpdatePtr> decisionRouteUpdatesQueue,
     std::shared_ptr<const Config> config,
     PersistentStore* configStore,
     KvStore* kvStore,
@@ -47,7 +73,8 @@ PrefixManager::PrefixManager(
       enablePerfMeasurement_{enablePerfMeasurement},
       ttlKeyInKvStore_(std::chrono::milliseconds(
           *config->getKvStoreConfig().key_ttl_ms_ref())),
-      allAreas_{config->getAreaIds()} {
+      allAreas_{config->getAreaIds()},
+      dampeningConfigs_(*config->getConfig().prefix_dampening_config_ref()) {
   CHECK(configStore_);
   CHECK(kvStore_);
   CHECK(config);
@@ -74,6 +101,7 @@ PrefixManager::PrefixManager(
       // TODO: change persist store to use C++ struct prefixMap_
       prefixMap_[*entry.prefix_ref()][*entry.type_ref()] =
           PrefixEntry(entry, allAreas_);
+      indexPrefixEntry(*entry.prefix_ref(), *entry.type_ref());
       addPerfEventIfNotExist(
           addingEvents_[*entry.type_ref()][*entry.prefix_ref()],
           "LOADED_FROM_DISK");
@@ -85,9 +113,29 @@ PrefixManager::PrefixManager(
     buildOriginatedPrefixDb(*prefixes);
   }
 
+  // Load summary prefixes to advertise into each area
+  for (const auto& areaConfig : config->getAreas()) {
+    for (const auto& summary : *areaConfig.summary_prefixes_ref()) {
+      areaSummaryTries_[*areaConfig.area_id_ref()].insert(
+          toIpPrefix(folly::IPAddress::createNetwork(summary)));
+    }
+  }
+
+  // Create timer for periodic full sync, started after the initial one
+  fullSyncKvStoreTimer_ =
+      folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
+        syncKvStore(true /* fullSync */);
+        fullSyncKvStoreTimer_->scheduleTimeout(
+            Constants::kPrefixMgrFullSyncInterval);
+      });
+
   // Create initial timer to update all prefixes after HoldTime (2 * KA)
-  initialSyncKvStoreTimer_ = folly::AsyncTimeout::make(
-      *getEvb(), [this]() noexcept { syncKvStore(); });
+  initialSyncKvStoreTimer_ =
+      folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
+        syncKvStore(true /* fullSync */);
+        fullSyncKvStoreTimer_->scheduleTimeout(
+            Constants::kPrefixMgrFullSyncInterval);
+      });
 
   // Create throttled update state
   syncKvStoreThrottled_ = std::make_unique<AsyncThrottle>(
@@ -98,6 +146,10 @@ PrefixManager::PrefixManager(
         syncKvStore();
       });
 
+  // Create timer to reuse suppressed prefixes once their penalty decayed
+  dampeningTimer_ = folly::AsyncTimeout::make(
+      *getEvb(), [this]() noexcept { processDampening(); });
+
   // Schedule fiber to read prefix updates messages
   addFiberTask(
       [q = std::move(prefixUpdateRequestQueue), this]() mutable noexcept {
@@ -156,7 +208,7 @@ PrefixManager::PrefixManager(
           }
 
           try {
-            processDecisionRouteUpdates(std::move(maybeThriftObj).value());
+            processDecisionRouteUpdates(*maybeThriftObj.value());
           } catch (const std::exception&) {
 #if FOLLY_USE_SYMBOLIZER
             // collect stack strace then fail the process
@@ -217,6 +269,7 @@ PrefixManager::~PrefixManager() {
     // destory timers
     LOG(INFO) << "Destroyed timers inside PrefixManager";
     initialSyncKvStoreTimer_.reset();
+    fullSyncKvStoreTimer_.reset();
     syncKvStoreThrottled_.reset();
   });
   kvStoreClient_.reset();
@@ -267,6 +320,8 @@ PrefixManager::buildOriginatedPrefixDb(
       unicastEntry.doNotInstall = (*installToFib ? 0 : 1);
     }
 
+    originatedPrefixTrie_.insert(toIpPrefix(network));
+
     // ATTN: upon initialization, no supporting routes
     originatedPrefixDb_.emplace(
         network,
@@ -315,16 +370,32 @@ PrefixManager::updateKvStorePrefixEntry(PrefixEntry const& entry) {
     auto prefixKey =
         PrefixKey(nodeId_, toIPNetwork(*prefixEntry.prefix_ref()), toArea)
             .getPrefixKey();
-    auto prefixDb = createPrefixDb(nodeId_, {prefixEntry}, toArea);
+    std::optional<thrift::PerfEvents> perfEvents;
     if (enablePerfMeasurement_) {
-      prefixDb.perfEvents_ref() =
+      perfEvents =
           addingEvents_[*prefixEntry.type_ref()][*prefixEntry.prefix_ref()];
     }
-    auto prefixDbStr =
-        fbzmq::util::writeThriftObjStr(std::move(prefixDb), serializer_);
+
+    auto advertisedIt = advertisedValues_.find(prefixKey);
+    if (advertisedIt != advertisedValues_.end() and
+        advertisedIt->second.prefixEntry == prefixEntry and
+        advertisedIt->second.perfEvents == perfEvents) {
+      ++advertisedValueHits_;
+      prefixKeys.emplace(std::move(prefixKey));
+      continue;
+    }
+    ++advertisedValueMisses_;
+
+    auto prefixDb = createPrefixDb(nodeId_, {prefixEntry}, toArea);
+    if (perfEvents.has_value()) {
+      prefixDb.perfEvents_ref() = *perfEvents;
+    }
+    auto prefixDbStr = serializeCompact(prefixDb);
 
     bool changed = kvStoreClient_->persistKey(
         prefixKey, prefixDbStr, ttlKeyInKvStore_, toArea);
+    advertisedValues_[prefixKey] =
+        AdvertisedValue{prefixEntry, std::move(perfEvents), prefixDbStr};
 
     LOG_IF(INFO, changed) << "Advertising key: " << prefixKey
                           << " toArea KvStore area: " << toArea << " type: "
@@ -335,23 +406,63 @@ PrefixManager::updateKvStorePrefixEntry(PrefixEntry const& entry) {
 }
 
 void
-PrefixManager::syncKvStore() {
-  std::vector<std::pair<std::string, std::string>> keyVals;
-  std::unordered_set<std::string> nowAdvertisingKeys;
+PrefixManager::syncKvStore(bool fullSync) {
+  if (fullSync) {
+    // reconcile everything, including prefixes only left with stale keys
+    for (auto const& kv : prefixMap_) {
+      dirtyPrefixes_.emplace(kv.first);
+    }
+    for (auto const& kv : prefixToAdvertisedKeys_) {
+      dirtyPrefixes_.emplace(kv.first);
+    }
+  }
 
-  LOG(INFO) << "Syncing " << prefixMap_.size() << " prefixes in KvStore";
+  LOG(INFO) << "Syncing " << dirtyPrefixes_.size() << " of "
+            << prefixMap_.size() << " prefixes in KvStore";
+  fb303::fbData->addStatValue(
+      "prefix_manager.synced_prefixes", dirtyPrefixes_.size(), fb303::SUM);
+
+  for (auto const& prefix : dirtyPrefixes_) {
+    std::unordered_set<std::string> prefixKeys;
+    auto prefixIt = prefixMap_.find(prefix);
+    if (prefixIt != prefixMap_.end()) {
+      auto const* typeToPrefixes = &prefixIt->second;
+      CHECK(not typeToPrefixes->empty()) << "Unexpected empty entry";
+      // leave out suppressed entries of dampened prefix
+      std::unordered_map<thrift::PrefixType, PrefixEntry> unsuppressed;
+      if (dampeningStates_.count(prefix)) {
+        for (auto const& [type, entry] : *typeToPrefixes) {
+          if (not isPrefixSuppressed(prefix, type)) {
+            unsuppressed.emplace(type, entry);
+          }
+        }
+        typeToPrefixes = &unsuppressed;
+      }
+      if (not typeToPrefixes->empty()) {
+        auto bestType = *selectBestPrefixMetrics(*typeToPrefixes).begin();
+        auto& bestEntry = typeToPrefixes->at(bestType);
+        addPerfEventIfNotExist(
+            addingEvents_[bestType][prefix], "UPDATE_KVSTORE_THROTTLED");
+        prefixKeys = updateKvStorePrefixEntry(bestEntry);
+      }
+    }
 
-  for (auto const& [prefix, typeToPrefixes] : prefixMap_) {
-    CHECK(not typeToPrefixes.empty()) << "Unexpected empty entry";
-    auto bestType = *selectBestPrefixMetrics(typeToPrefixes).begin();
-    auto& bestEntry = typeToPrefixes.at(bestType);
-    addPerfEventIfNotExist(
-        addingEvents_[bestType][prefix], "UPDATE_KVSTORE_THROTTLED");
-    for (const auto& key : updateKvStorePrefixEntry(bestEntry)) {
-      nowAdvertisingKeys.emplace(key);
-      keysToClear_.erase(key);
+    // clear keys of prefix no longer advertised, e.g. prefix got withdrawn
+    // or new best entry has different destination areas
+    auto& oldKeys = prefixToAdvertisedKeys_[prefix];
+    for (auto const& key : oldKeys) {
+      if (not prefixKeys.count(key)) {
+        advertisedValues_.erase(key);
+        keysToClear_.emplace(key);
+      }
+    }
+    if (prefixKeys.empty()) {
+      prefixToAdvertisedKeys_.erase(prefix);
+    } else {
+      oldKeys = std::move(prefixKeys);
     }
   }
+  dirtyPrefixes_.clear();
 
   thrift::PrefixDatabase deletedPrefixDb;
   *deletedPrefixDb.thisNodeName_ref() = nodeId_;
@@ -362,26 +473,30 @@ PrefixManager::syncKvStore() {
         deletedPrefixDb.perfEvents_ref().value(), "WITHDRAW_THROTTLED");
   }
   for (auto const& key : keysToClear_) {
-    auto prefixKey = PrefixKey::fromStr(key);
-    if (prefixKey.hasValue()) {
+    // seen in KvStore, but still advertising it
+    if (advertisedValues_.count(key)) {
+      continue;
+    }
+    auto const keyView = parseKvStoreKey(key);
+    auto const maybePrefix = keyView.getPrefixNetwork();
+    if (maybePrefix.has_value()) {
       // needed for backward compatibility
       thrift::PrefixEntry entry;
-      entry.prefix_ref() = prefixKey.value().getIpPrefix();
+      entry.prefix_ref() = toIpPrefix(maybePrefix.value());
       *deletedPrefixDb.prefixEntries_ref() = {entry};
     }
-    LOG(INFO) << "Withdrawing key: " << key
-              << " from KvStore area: " << prefixKey->getPrefixArea();
+    const std::string area(keyView.area);
+    LOG(INFO) << "Withdrawing key: " << key << " from KvStore area: " << area;
     // one last key set with empty DB and deletePrefix set signifies withdraw
     // then the key should ttl out
     kvStoreClient_->clearKey(
         key,
-        fbzmq::util::writeThriftObjStr(std::move(deletedPrefixDb), serializer_),
+        serializeCompact(deletedPrefixDb),
         ttlKeyInKvStore_,
-        prefixKey->getPrefixArea());
+        area);
   }
 
-  // anything we don't advertise next time, we need to clear
-  keysToClear_ = std::move(nowAdvertisingKeys);
+  keysToClear_.clear();
 
   // Update flat counters
   size_t num_prefixes = 0;
@@ -391,6 +506,14 @@ PrefixManager::syncKvStore() {
   fb303::fbData->setCounter("prefix_manager.received_prefixes", num_prefixes);
   fb303::fbData->setCounter(
       "prefix_manager.advertised_prefixes", prefixMap_.size());
+  fb303::fbData->setCounter(
+      "prefix_manager.summarized_routes", ribPrefixToSummaries_.size());
+  const auto lookups = advertisedValueHits_ + advertisedValueMisses_;
+  if (lookups > 0) {
+    fb303::fbData->setCounter(
+        "prefix_manager.advertised_value_cache_hit_pct",
+        advertisedValueHits_ * 100 / lookups);
+  }
 }
 
 folly::SemiFuture<bool>
@@ -474,10 +597,11 @@ PrefixManager::getPrefixesByType(thrift::PrefixType prefixType) {
     prefixType = std::move(prefixType)
   ]() mutable noexcept {
     std::vector<thrift::PrefixEntry> prefixes;
-    for (auto const& [prefix, typeToPrefixes] : prefixMap_) {
-      auto it = typeToPrefixes.find(prefixType);
-      if (it != typeToPrefixes.end()) {
-        prefixes.emplace_back(it->second.tPrefixEntry);
+    auto typeIt = typeToPrefixes_.find(prefixType);
+    if (typeIt != typeToPrefixes_.end()) {
+      for (auto const& prefix : typeIt->second) {
+        prefixes.emplace_back(
+            prefixMap_.at(prefix).at(prefixType).tPrefixEntry);
       }
     }
     p.setValue(std::make_unique<std::vector<thrift::PrefixEntry>>(
@@ -495,15 +619,45 @@ PrefixManager::getAdvertisedRoutesFiltered(
       [this, p = std::move(p), filter = std::move(filter)]() mutable noexcept {
         auto routes =
             std::make_unique<std::vector<thrift::AdvertisedRouteDetail>>();
+        std::optional<folly::CIDRNetwork> coveringPrefix;
+        if (filter.coveringPrefix_ref()) {
+          coveringPrefix = toIPNetwork(*filter.coveringPrefix_ref());
+        }
+        auto const addRoute = [&](thrift::IpPrefix const& prefix) {
+          auto it = prefixMap_.find(prefix);
+          if (it == prefixMap_.end()) {
+            return;
+          }
+          if (coveringPrefix.has_value()) {
+            auto const network = toIPNetwork(prefix);
+            if (network.second < coveringPrefix->second or
+                not network.first.inSubnet(
+                    coveringPrefix->first, coveringPrefix->second)) {
+              return;
+            }
+          }
+          filterAndAddAdvertisedRoute(
+              *routes, filter.prefixType_ref(), it->first, it->second);
+        };
+
         if (filter.prefixes_ref()) {
           // Explicitly lookup the requested prefixes
           for (auto& prefix : filter.prefixes_ref().value()) {
-            auto it = prefixMap_.find(prefix);
-            if (it == prefixMap_.end()) {
-              continue;
+            addRoute(prefix);
+          }
+        } else if (filter.prefixType_ref()) {
+          // Lookup prefixes of the type
+          auto typeIt = typeToPrefixes_.find(*filter.prefixType_ref());
+          if (typeIt != typeToPrefixes_.end()) {
+            for (auto const& prefix : typeIt->second) {
+              addRoute(prefix);
             }
-            filterAndAddAdvertisedRoute(
-                *routes, filter.prefixType_ref(), it->first, it->second);
+          }
+        } else if (coveringPrefix.has_value()) {
+          // Lookup prefixes within the covering prefix
+          for (auto const& prefix :
+               advertisedPrefixTrie_.coveredPrefixes(*coveringPrefix)) {
+            addRoute(prefix);
           }
         } else {
           // Iterate over all prefixes
@@ -587,17 +741,35 @@ bool
 PrefixManager::advertisePrefixesImpl(
     const std::vector<thrift::PrefixEntry>& prefixes,
     const std::unordered_set<std::string>& dstAreas) {
-  std::vector<PrefixEntry> toAddOrUpdate;
-  for (const auto& prefix : prefixes) {
-    toAddOrUpdate.emplace_back(prefix, dstAreas);
+  bool updated{false};
+  const auto chunkSize = Constants::kPrefixMgrUpdateChunkSize;
+  for (size_t start = 0; start < prefixes.size(); start += chunkSize) {
+    // let other work run between chunks of bulk update, e.g. from BGP at
+    // startup. Chunks get to KvStore already while the rest is pending.
+    if (start > 0 and folly::fibers::onFiber()) {
+      folly::fibers::yield();
+    }
+
+    const auto end = std::min(prefixes.size(), start + chunkSize);
+    std::vector<PrefixEntry> toAddOrUpdate;
+    toAddOrUpdate.reserve(end - start);
+    for (auto i = start; i < end; ++i) {
+      toAddOrUpdate.emplace_back(prefixes.at(i), dstAreas);
+    }
+    updated |= advertisePrefixesImpl(toAddOrUpdate, false /* persist */);
   }
-  return advertisePrefixesImpl(toAddOrUpdate);
+
+  // persist once for whole update, it dumps the entire prefix db
+  if (updated) {
+    persistPrefixDb();
+  }
+  return updated;
 }
 
 // helpers for modifying our Prefix Db
 bool
 PrefixManager::advertisePrefixesImpl(
-    const std::vector<PrefixEntry>& prefixeInfos) {
+    const std::vector<PrefixEntry>& prefixeInfos, bool persist) {
   bool updated{false};
 
   for (const auto& entry : prefixeInfos) {
@@ -612,12 +784,15 @@ PrefixManager::advertisePrefixesImpl(
       continue;
     }
 
+    dirtyPrefixes_.emplace(prefix);
     if (prefixIt == prefixes.end()) {
       prefixes.emplace(type, entry);
+      indexPrefixEntry(prefix, type);
       addPerfEventIfNotExist(addingEvents_[type][prefix], "ADD_PREFIX");
     } else {
       prefixIt->second = entry;
       addPerfEventIfNotExist(addingEvents_[type][prefix], "UPDATE_PREFIX");
+      recordPrefixFlap(prefix, type, 0.5 /* attribute change */);
     }
     updated = true;
 
@@ -627,7 +802,9 @@ PrefixManager::advertisePrefixesImpl(
   }
 
   if (updated) {
-    persistPrefixDb();
+    if (persist) {
+      persistPrefixDb();
+    }
     syncKvStoreThrottled_->operator()();
   }
 
@@ -652,7 +829,9 @@ PrefixManager::withdrawPrefixesImpl(
   }
 
   for (const auto& prefix : prefixes) {
+    dirtyPrefixes_.emplace(*prefix.prefix_ref());
     prefixMap_.at(*prefix.prefix_ref()).erase(*prefix.type_ref());
+    recordPrefixFlap(*prefix.prefix_ref(), *prefix.type_ref(), 1.0);
     addingEvents_.at(*prefix.type_ref()).erase(*prefix.prefix_ref());
 
     SYSLOG(INFO) << "Withdrawing prefix: " << toString(*prefix.prefix_ref())
@@ -661,6 +840,7 @@ PrefixManager::withdrawPrefixesImpl(
     if (prefixMap_.at(*prefix.prefix_ref()).empty()) {
       prefixMap_.erase(*prefix.prefix_ref());
     }
+    unindexPrefixEntry(*prefix.prefix_ref(), *prefix.type_ref());
     if (addingEvents_[*prefix.type_ref()].empty()) {
       addingEvents_.erase(*prefix.type_ref());
     }
@@ -681,23 +861,30 @@ PrefixManager::syncPrefixesByTypeImpl(
     const std::unordered_set<std::string>& dstAreas) {
   LOG(INFO) << "Syncing prefixes of type: " << getPrefixTypeName(type);
   // building these lists so we can call add and remove and get detailed logging
-  std::vector<thrift::PrefixEntry> toAddOrUpdate, toRemove;
+  std::vector<thrift::PrefixEntry> toRemove;
   std::unordered_set<thrift::IpPrefix> toRemoveSet;
-  for (auto const& [prefix, typeToPrefixes] : prefixMap_) {
-    if (typeToPrefixes.count(type)) {
-      toRemoveSet.emplace(prefix);
-    }
+  auto typeIt = typeToPrefixes_.find(type);
+  if (typeIt != typeToPrefixes_.end()) {
+    toRemoveSet = typeIt->second;
   }
   for (auto const& entry : prefixEntries) {
     CHECK(type == *entry.type_ref());
     toRemoveSet.erase(*entry.prefix_ref());
-    toAddOrUpdate.emplace_back(entry);
   }
+  bool updated = false;
+  updated |= advertisePrefixesImpl(prefixEntries, dstAreas);
+
+  // advertising may have yielded, skip what got withdrawn meanwhile
   for (auto const& prefix : toRemoveSet) {
-    toRemove.emplace_back(prefixMap_.at(prefix).at(type).tPrefixEntry);
+    auto prefixIt = prefixMap_.find(prefix);
+    if (prefixIt == prefixMap_.end()) {
+      continue;
+    }
+    auto entryIt = prefixIt->second.find(type);
+    if (entryIt != prefixIt->second.end()) {
+      toRemove.emplace_back(entryIt->second.tPrefixEntry);
+    }
   }
-  bool updated = false;
-  updated |= advertisePrefixesImpl(toAddOrUpdate, dstAreas);
   updated |= withdrawPrefixesImpl(toRemove);
   return updated;
 }
@@ -705,33 +892,178 @@ PrefixManager::syncPrefixesByTypeImpl(
 bool
 PrefixManager::withdrawPrefixesByTypeImpl(thrift::PrefixType type) {
   std::vector<thrift::PrefixEntry> toRemove;
-  for (auto const& [prefix, typeToPrefixes] : prefixMap_) {
-    auto it = typeToPrefixes.find(type);
-    if (it != typeToPrefixes.end()) {
-      toRemove.emplace_back(it->second.tPrefixEntry);
+  auto typeIt = typeToPrefixes_.find(type);
+  if (typeIt != typeToPrefixes_.end()) {
+    for (auto const& prefix : typeIt->second) {
+      toRemove.emplace_back(prefixMap_.at(prefix).at(type).tPrefixEntry);
     }
   }
 
   return withdrawPrefixesImpl(toRemove);
 }
 
+void
+PrefixManager::indexPrefixEntry(
+    thrift::IpPrefix const& prefix, thrift::PrefixType type) {
+  typeToPrefixes_[type].emplace(prefix);
+  advertisedPrefixTrie_.insert(prefix);
+}
+
+void
+PrefixManager::unindexPrefixEntry(
+    thrift::IpPrefix const& prefix, thrift::PrefixType type) {
+  auto typeIt = typeToPrefixes_.find(type);
+  if (typeIt != typeToPrefixes_.end()) {
+    typeIt->second.erase(prefix);
+    if (typeIt->second.empty()) {
+      typeToPrefixes_.erase(typeIt);
+    }
+  }
+  if (not prefixMap_.count(prefix)) {
+    advertisedPrefixTrie_.erase(prefix);
+  }
+}
+
+void
+PrefixManager::recordPrefixFlap(
+    const thrift::IpPrefix& prefix, thrift::PrefixType type, double weight) {
+  auto confIt = dampeningConfigs_.find(type);
+  if (confIt == dampeningConfigs_.end()) {
+    return;
+  }
+  auto const& conf = confIt->second;
+  const std::chrono::seconds halfLife(*conf.half_life_s_ref());
+  const double reuseThreshold = *conf.reuse_threshold_ref();
+  // cap penalty so that entry is reused within max_suppress_time_s
+  const double maxPenalty = reuseThreshold *
+      std::exp2(
+          static_cast<double>(*conf.max_suppress_time_s_ref()) /
+          *conf.half_life_s_ref());
+  const auto now = std::chrono::steady_clock::now();
+
+  auto& state = dampeningStates_[prefix][type];
+  state.penalty = std::min(
+      decayPenalty(state.penalty, now - state.lastUpdate, halfLife) +
+          weight * *conf.penalty_ref(),
+      maxPenalty);
+  state.lastUpdate = now;
+  fb303::fbData->addStatValue("prefix_manager.prefix_flaps", 1, fb303::SUM);
+
+  if (not state.suppressed and
+      state.penalty >= *conf.suppress_threshold_ref()) {
+    state.suppressed = true;
+    ++numSuppressedPrefixes_;
+    dirtyPrefixes_.emplace(prefix);
+    SYSLOG(INFO) << "Suppressing flapping prefix: " << toString(prefix)
+                 << ", client: " << getPrefixTypeName(type)
+                 << ", penalty: " << state.penalty;
+    fb303::fbData->addStatValue(
+        "prefix_manager.dampening_suppressions", 1, fb303::SUM);
+    fb303::fbData->setCounter(
+        "prefix_manager.suppressed_prefixes", numSuppressedPrefixes_);
+  }
+
+  // check again once entry can be reused or forgotten
+  const auto checkIn = timeToDecay(
+      state.penalty,
+      state.suppressed ? reuseThreshold : reuseThreshold / 2,
+      halfLife);
+  if (not dampeningTimer_->isScheduled() or
+      now + checkIn < dampeningTimerExpiry_) {
+    dampeningTimerExpiry_ = now + checkIn;
+    dampeningTimer_->scheduleTimeout(checkIn);
+  }
+}
+
+bool
+PrefixManager::isPrefixSuppressed(
+    const thrift::IpPrefix& prefix, thrift::PrefixType type) const {
+  auto prefixIt = dampeningStates_.find(prefix);
+  if (prefixIt == dampeningStates_.end()) {
+    return false;
+  }
+  auto it = prefixIt->second.find(type);
+  return it != prefixIt->second.end() and it->second.suppressed;
+}
+
+void
+PrefixManager::processDampening() {
+  const auto now = std::chrono::steady_clock::now();
+  std::optional<std::chrono::milliseconds> nextCheckIn;
+  bool reused{false};
+  for (auto prefixIt = dampeningStates_.begin();
+       prefixIt != dampeningStates_.end();) {
+    auto& typeToStates = prefixIt->second;
+    for (auto it = typeToStates.begin(); it != typeToStates.end();) {
+      auto const& conf = dampeningConfigs_.at(it->first);
+      const std::chrono::seconds halfLife(*conf.half_life_s_ref());
+      const double reuseThreshold = *conf.reuse_threshold_ref();
+      auto& state = it->second;
+      state.penalty =
+          decayPenalty(state.penalty, now - state.lastUpdate, halfLife);
+      state.lastUpdate = now;
+
+      if (state.suppressed and state.penalty < reuseThreshold) {
+        state.suppressed = false;
+        --numSuppressedPrefixes_;
+        dirtyPrefixes_.emplace(prefixIt->first);
+        reused = true;
+        SYSLOG(INFO) << "Reusing dampened prefix: "
+                     << toString(prefixIt->first)
+                     << ", client: " << getPrefixTypeName(it->first);
+      }
+      if (not state.suppressed and state.penalty < reuseThreshold / 2) {
+        it = typeToStates.erase(it);
+        continue;
+      }
+
+      const auto checkIn = timeToDecay(
+          state.penalty,
+          state.suppressed ? reuseThreshold : reuseThreshold / 2,
+          halfLife);
+      nextCheckIn = nextCheckIn ? std::min(*nextCheckIn, checkIn) : checkIn;
+      ++it;
+    }
+    if (typeToStates.empty()) {
+      prefixIt = dampeningStates_.erase(prefixIt);
+    } else {
+      ++prefixIt;
+    }
+  }
+
+  fb303::fbData->setCounter(
+      "prefix_manager.suppressed_prefixes", numSuppressedPrefixes_);
+  if (reused) {
+    syncKvStoreThrottled_->operator()();
+  }
+  if (nextCheckIn) {
+    dampeningTimerExpiry_ = now + *nextCheckIn;
+    dampeningTimer_->scheduleTimeout(*nextCheckIn);
+  }
+}
+
 void
 PrefixManager::updateOriginatedPrefixOnAdvertise(
     const folly::CIDRNetwork& prefix) {
   // ATTN: ignore attribute-ONLY update for existing RIB entries
   //       as it won't affect `supporting_route_cnt`
-  auto [ribPrefixIt, inserted] =
-      ribPrefixDb_.emplace(prefix, std::vector<folly::CIDRNetwork>());
-  if (not inserted) {
+  if (originatedPrefixDb_.empty() or ribPrefixDb_.count(prefix)) {
     return;
   }
 
-  for (auto& [network, route] : originatedPrefixDb_) {
-    // folly::CIDRNetwork.first -> IPAddress
-    // folly::CIDRNetwork.second -> cidr length
-    if (not prefix.first.inSubnet(network.first, network.second)) {
-      continue;
-    }
+  // RIB prefixEntry supports every originated prefix its address is in,
+  // lookup host address to find them regardless of RIB prefix length. Only
+  // RIB prefixEntries supporting any are tracked
+  auto const coveringPrefixes = originatedPrefixTrie_.coveringPrefixes(
+      {prefix.first, prefix.first.bitCount()});
+  if (coveringPrefixes.empty()) {
+    return;
+  }
+  auto ribPrefixIt =
+      ribPrefixDb_.emplace(prefix, std::vector<folly::CIDRNetwork>()).first;
+  for (auto const& coveringPrefix : coveringPrefixes) {
+    auto const network = toIPNetwork(coveringPrefix);
+    auto& route = originatedPrefixDb_.at(network);
 
     LOG(INFO) << "[Route Origination] Adding supporting route "
               << folly::IPAddress::networkToString(prefix)
@@ -771,17 +1103,99 @@ PrefixManager::updateOriginatedPrefixOnWithdraw(
   ribPrefixDb_.erase(prefix);
 }
 
+void
+PrefixManager::updateSummaryOnAdvertise(
+    const folly::CIDRNetwork& prefix,
+    std::unordered_set<std::string>& dstAreas,
+    std::unordered_set<folly::CIDRNetwork>& changedSummaries) {
+  for (auto areaIt = dstAreas.begin(); areaIt != dstAreas.end();) {
+    auto trieIt = areaSummaryTries_.find(*areaIt);
+    if (trieIt == areaSummaryTries_.end()) {
+      ++areaIt;
+      continue;
+    }
+
+    // shortest summary strictly covering the route, route same as summary
+    // is redistributed as is
+    std::optional<folly::CIDRNetwork> summary;
+    for (auto const& coveringPrefix : trieIt->second.coveringPrefixes(prefix)) {
+      auto const network = toIPNetwork(coveringPrefix);
+      if (network.second < prefix.second) {
+        summary = network;
+        break;
+      }
+    }
+    if (not summary.has_value()) {
+      ++areaIt;
+      continue;
+    }
+
+    VLOG(1) << "[Area Summarization] Suppressing "
+            << folly::IPAddress::networkToString(prefix) << " in area "
+            << *areaIt << " by summary "
+            << folly::IPAddress::networkToString(*summary);
+
+    summaryDb_[*summary][*areaIt].emplace(prefix);
+    ribPrefixToSummaries_[prefix].emplace_back(*areaIt, *summary);
+    changedSummaries.emplace(*summary);
+    areaIt = dstAreas.erase(areaIt);
+  }
+}
+
+void
+PrefixManager::updateSummaryOnWithdraw(
+    const folly::CIDRNetwork& prefix,
+    std::unordered_set<folly::CIDRNetwork>& changedSummaries) {
+  auto ribPrefixIt = ribPrefixToSummaries_.find(prefix);
+  if (ribPrefixIt == ribPrefixToSummaries_.end()) {
+    return;
+  }
+
+  for (auto const& [area, summary] : ribPrefixIt->second) {
+    auto& areaToRoutes = summaryDb_.at(summary);
+    auto& routes = areaToRoutes.at(area);
+    routes.erase(prefix);
+    if (routes.empty()) {
+      areaToRoutes.erase(area);
+    }
+    if (areaToRoutes.empty()) {
+      summaryDb_.erase(summary);
+    }
+    changedSummaries.emplace(summary);
+  }
+  ribPrefixToSummaries_.erase(ribPrefixIt);
+}
+
 void
 PrefixManager::processDecisionRouteUpdates(
-    DecisionRouteUpdate&& decisionRouteUpdate) {
+    const DecisionRouteUpdate& decisionRouteUpdate) {
+  // With a single area nothing is redistributed, routes only matter as
+  // supporting routes of originated prefixes. Skip building redistributed
+  // entries for every route of the update.
+  if (allAreas_.size() <= 1) {
+    if (originatedPrefixDb_.empty()) {
+      return;
+    }
+    for (const auto& [prefix, _] : decisionRouteUpdate.unicastRoutesToUpdate) {
+      updateOriginatedPrefixOnAdvertise(prefix);
+    }
+    for (const auto& prefix : decisionRouteUpdate.unicastRoutesToDelete) {
+      updateOriginatedPrefixOnWithdraw(prefix);
+    }
+    return;
+  }
+
   std::vector<PrefixEntry> advertisePrefixes;
   std::vector<thrift::PrefixEntry> withdrawPrefixes;
+  std::unordered_set<folly::CIDRNetwork> changedSummaries;
 
   // Add/Update unicast routes to update
   // Self originated (include routes imported from local BGP)
   // won't show up in decisionRouteUpdate.
-  for (auto& [prefix, route] : decisionRouteUpdate.unicastRoutesToUpdate) {
-    auto& prefixEntry = route.bestPrefixEntry;
+  for (const auto& [prefix, route] :
+       decisionRouteUpdate.unicastRoutesToUpdate) {
+    // update is shared with other readers, modify own copy
+    auto prefixEntry = route.bestPrefixEntry;
 
     // NOTE: future expansion - run egress policy here
 
@@ -802,7 +1216,10 @@ PrefixManager::processDecisionRouteUpdates(
         dstAreas.erase(*nh.area_ref());
       }
     }
-    advertisePrefixes.emplace_back(prefixEntry, dstAreas);
+    // supporting routes of summaries may change with destination areas
+    updateSummaryOnWithdraw(prefix, changedSummaries);
+    updateSummaryOnAdvertise(prefix, dstAreas, changedSummaries);
+    advertisePrefixes.emplace_back(std::move(prefixEntry), std::move(dstAreas));
 
     // maybe inc supporting_route of originated prefixes
     updateOriginatedPrefixOnAdvertise(prefix);
@@ -815,17 +1232,42 @@ PrefixManager::processDecisionRouteUpdates(
 
     // maybe dec supporting_route of originated prefixes
     updateOriginatedPrefixOnWithdraw(prefix);
+    updateSummaryOnWithdraw(prefix, changedSummaries);
+  }
+
+  // advertise summaries into areas they have supporting routes in, withdraw
+  // the ones left without any
+  for (auto const& summary : changedSummaries) {
+    auto summaryIt = summaryDb_.find(summary);
+    if (summaryIt != summaryDb_.end()) {
+      std::unordered_set<std::string> dstAreas;
+      for (auto const& [area, _] : summaryIt->second) {
+        dstAreas.emplace(area);
+      }
+      advertisePrefixes.emplace_back(
+          createPrefixEntry(
+              toIpPrefix(summary),
+              thrift::PrefixType::SUMMARY,
+              "",
+              thrift::PrefixForwardingType::IP,
+              thrift::PrefixForwardingAlgorithm::SP_ECMP,
+              true /* ephemeral */),
+          std::move(dstAreas));
+      continue;
+    }
+    auto prefixIt = prefixMap_.find(toIpPrefix(summary));
+    if (prefixIt != prefixMap_.end() and
+        prefixIt->second.count(thrift::PrefixType::SUMMARY)) {
+      withdrawPrefixes.emplace_back(
+          createPrefixEntry(toIpPrefix(summary), thrift::PrefixType::SUMMARY));
+    }
   }
 
   // TODO: loop through originatedPrefixes collection and publish to decision
 
-  // Redisrtibute RIB route ONLY when there are multiple `areaId` configured .
-  // We want to keep processDecisionRouteUpdates() running as dynamic
-  // configuration could add/remove areas.
-  if (allAreas_.size() > 1) {
-    advertisePrefixesImpl(advertisePrefixes);
-    withdrawPrefixesImpl(withdrawPrefixes);
-  }
+  // Redisrtibute RIB route, there are multiple `areaId` configured
+  advertisePrefixesImpl(advertisePrefixes);
+  withdrawPrefixesImpl(withdrawPrefixes);
 
   // ignore mpls updates
 }
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <map>
+#include <optional>
 #include <string>
 #include <unordered_map>
 
@@ -17,6 +19,7 @@
 
 #include <openr/common/AsyncThrottle.h>
 #include <openr/common/OpenrEventBase.h>
+#include <openr/common/PrefixTrie.h>
 #include <openr/common/Util.h>
 #include <openr/config-store/PersistentStore.h>
 #include <openr/config/Config.h>
@@ -35,7 +38,7 @@ class PrefixManager final : public OpenrEventBase {
 
   PrefixManager(
       messaging::RQueue<thrift::PrefixUpdateRequest> prefixUpdateRequestQueue,
-      messaging::RQueue<DecisionRouteUpdate> decisionRouteUpdatesQueue,
+      messaging::RQueue<DecisionRouteUpdatePtr> decisionRouteUpdatesQueue,
       std::shared_ptr<const Config> config,
       PersistentStore* configStore,
       KvStore* kvStore,
@@ -58,7 +61,9 @@ class PrefixManager final : public OpenrEventBase {
    * Public API for PrefixManager operations:
    *
    * Write APIs - will schedule syncKvStoreThrottled_ to update kvstore,
-   * @return true if there are changes else false
+   * @return true if there are changes else false. Bulk producers should use
+   * PrefixUpdateRequest queue instead, which applies large requests in chunks
+   * and lets other PrefixManager work run in between.
    *  - add prefixes
    *  - withdraw prefixes
    *  - withdraw prefixes by type
@@ -134,13 +139,24 @@ class PrefixManager final : public OpenrEventBase {
    *
    * modify prefix db and schedule syncKvStoreThrottled_ to update kvstore
    * @return true if the db is modified
+   *
+   * thrift::PrefixEntry lists are applied in chunks of
+   * kPrefixMgrUpdateChunkSize, yielding in between when running on a fiber.
    */
   bool advertisePrefixesImpl(
       const std::vector<thrift::PrefixEntry>& prefixes,
       const std::unordered_set<std::string>& dstAreas);
-  bool advertisePrefixesImpl(const std::vector<PrefixEntry>& prefixes);
+  bool advertisePrefixesImpl(
+      const std::vector<PrefixEntry>& prefixes, bool persist = true);
   bool withdrawPrefixesImpl(const std::vector<thrift::PrefixEntry>& prefixes);
   bool withdrawPrefixesByTypeImpl(thrift::PrefixType type);
+
+  // update typeToPrefixes_ and advertisedPrefixTrie_ after an entry of the
+  // given prefix and type got added to or removed from prefixMap_
+  void indexPrefixEntry(
+      thrift::IpPrefix const& prefix, thrift::PrefixType type);
+  void unindexPrefixEntry(
+      thrift::IpPrefix const& prefix, thrift::PrefixType type);
   bool syncPrefixesByTypeImpl(
       thrift::PrefixType type,
       const std::vector<thrift::PrefixEntry>& prefixes,
@@ -150,11 +166,13 @@ class PrefixManager final : public OpenrEventBase {
   void buildOriginatedPrefixDb(
       const std::vector<thrift::OriginatedPrefix>& prefixes);
 
-  // Update kvstore with both ephemeral and non-ephemeral prefixes
-  void syncKvStore();
+  // Update kvstore with both ephemeral and non-ephemeral prefixes changed
+  // since last sync, or with all of them for full sync
+  void syncKvStore(bool fullSync = false);
 
   // add entry.tPrefixEntry in entry.dstAreas kvstore, return a set of per
-  // prefix key name for successful injected areas
+  // prefix key name for successful injected areas. Unchanged values already
+  // advertised aren't serialized again.
   std::unordered_set<std::string> updateKvStorePrefixEntry(
       PrefixEntry const& entry);
 
@@ -162,7 +180,8 @@ class PrefixManager final : public OpenrEventBase {
   void persistPrefixDb();
 
   // process decision route update, inject routes to different areas
-  void processDecisionRouteUpdates(DecisionRouteUpdate&& decisionRouteUpdate);
+  void processDecisionRouteUpdates(
+      const DecisionRouteUpdate& decisionRouteUpdate);
 
   // add event named updateEvent to perfEvents if it has value and the last
   // element is not already updateEvent
@@ -175,6 +194,35 @@ class PrefixManager final : public OpenrEventBase {
   void updateOriginatedPrefixOnAdvertise(const folly::CIDRNetwork& prefix);
   void updateOriginatedPrefixOnWithdraw(const folly::CIDRNetwork& prefix);
 
+  // [Area Summarization]
+  //
+  // Util function to update supporting routes of area summaries upon RIB
+  // route redistributed/withdrawn. Areas in which the route is suppressed by
+  // a summary are removed from dstAreas. Summaries with changed supporting
+  // routes are added to changedSummaries.
+  void updateSummaryOnAdvertise(
+      const folly::CIDRNetwork& prefix,
+      std::unordered_set<std::string>& dstAreas,
+      std::unordered_set<folly::CIDRNetwork>& changedSummaries);
+  void updateSummaryOnWithdraw(
+      const folly::CIDRNetwork& prefix,
+      std::unordered_set<folly::CIDRNetwork>& changedSummaries);
+
+  // [Prefix Dampening]
+  //
+  // Add penalty of flap to prefix entry, scaled by weight, and suppress it if
+  // flapping too often. No-op for types without dampening config.
+  void recordPrefixFlap(
+      const thrift::IpPrefix& prefix, thrift::PrefixType type, double weight);
+
+  // whether prefix entry of type is suppressed and not to be advertised
+  bool isPrefixSuppressed(
+      const thrift::IpPrefix& prefix, thrift::PrefixType type) const;
+
+  // Decay penalties, reuse suppressed entries decayed below reuse threshold
+  // and forget entries with little penalty left. Reschedules dampeningTimer_
+  void processDampening();
+
   // this node name
   const std::string nodeId_;
 
@@ -195,6 +243,9 @@ class PrefixManager final : public OpenrEventBase {
   std::unique_ptr<AsyncThrottle> syncKvStoreThrottled_;
   std::unique_ptr<folly::AsyncTimeout> initialSyncKvStoreTimer_;
 
+  // timer for periodic full sync with kvstore
+  std::unique_ptr<folly::AsyncTimeout> fullSyncKvStoreTimer_;
+
   // TTL for a key in the key value store
   const std::chrono::milliseconds ttlKeyInKvStore_;
 
@@ -209,6 +260,15 @@ class PrefixManager final : public OpenrEventBase {
       thrift::IpPrefix,
       std::unordered_map<thrift::PrefixType, PrefixEntry>>
       prefixMap_;
+
+  // (Reverse mapping of prefixMap_) prefix type -> prefixes of the type, to
+  // serve per type queries without a scan of prefixMap_
+  std::unordered_map<thrift::PrefixType, std::unordered_set<thrift::IpPrefix>>
+      typeToPrefixes_;
+
+  // keys of prefixMap_, for lookup of prefixes within a covering prefix
+  PrefixTrie advertisedPrefixTrie_;
+
   // TODO: tie break on attributes first, then choose the lowest prefix-type.
   // Redistribute routes could come from remote node from area1, but showed as
   // originated by me in area2. If I start to originate same prefix, I'll have
@@ -222,6 +282,27 @@ class PrefixManager final : public OpenrEventBase {
   // anything we no longer wish to advertise
   std::unordered_set<std::string> keysToClear_;
 
+  // prefixes added, updated or withdrawn since last syncKvStore
+  std::unordered_set<thrift::IpPrefix> dirtyPrefixes_;
+
+  // keys currently advertised for each prefix
+  std::unordered_map<thrift::IpPrefix, std::unordered_set<std::string>>
+      prefixToAdvertisedKeys_;
+
+  // value currently advertised for each key, with entry and perf events it
+  // was serialized from. Syncs finding the same input again skip
+  // serialization and persistKey.
+  struct AdvertisedValue {
+    thrift::PrefixEntry prefixEntry;
+    std::optional<thrift::PerfEvents> perfEvents;
+    std::string value;
+  };
+  std::unordered_map<std::string /* key */, AdvertisedValue> advertisedValues_;
+
+  // lookups of advertisedValues_ finding serialized value up to date or not
+  uint64_t advertisedValueHits_{0};
+  uint64_t advertisedValueMisses_{0};
+
   // perfEvents related to a given prefixEntry
   std::unordered_map<
       thrift::PrefixType,
@@ -284,6 +365,10 @@ class PrefixManager final : public OpenrEventBase {
   //
   std::unordered_map<folly::CIDRNetwork, OriginatedRoute> originatedPrefixDb_;
 
+  // keys of `originatedPrefixDb_` to find the originated prefixes a RIB
+  // prefixEntry supports without looping through all of them
+  PrefixTrie originatedPrefixTrie_;
+
   // prefixes received from decision
   // ATTN: to avoid loop through ALL entries inside `originatedPrefixes`,
   //       cache the reverse mapping:
@@ -292,6 +377,55 @@ class PrefixManager final : public OpenrEventBase {
   //
   std::unordered_map<folly::CIDRNetwork, std::vector<folly::CIDRNetwork>>
       ribPrefixDb_;
+
+  //
+  // [Area Summarization]
+  //
+  //  RIB routes redistributed into an area which are covered by one of its
+  //  `summary_prefixes` are suppressed there. The summary is advertised into
+  //  every area it has supporting routes in instead.
+  //
+
+  // summary prefixes configured per area
+  std::unordered_map<std::string /* area */, PrefixTrie> areaSummaryTries_;
+
+  // summary prefix -> area -> supporting RIB routes
+  std::unordered_map<
+      folly::CIDRNetwork,
+      std::unordered_map<std::string, std::unordered_set<folly::CIDRNetwork>>>
+      summaryDb_;
+
+  // reverse mapping: RIB route -> [(area, summary prefix)] it supports
+  std::unordered_map<
+      folly::CIDRNetwork,
+      std::vector<std::pair<std::string, folly::CIDRNetwork>>>
+      ribPrefixToSummaries_;
+
+  //
+  // [Prefix Dampening]
+  //
+  //  Flapping prefix entries are suppressed before they reach KvStore, see
+  //  thrift::PrefixDampeningConfig. Dampening state of an entry is kept while
+  //  it has penalty left, whether or not the entry is currently in prefixMap_.
+  //
+  const std::map<thrift::PrefixType, thrift::PrefixDampeningConfig>
+      dampeningConfigs_;
+
+  struct DampeningState {
+    // penalty as of lastUpdate
+    double penalty{0};
+    std::chrono::steady_clock::time_point lastUpdate;
+    bool suppressed{false};
+  };
+  std::unordered_map<
+      thrift::IpPrefix,
+      std::unordered_map<thrift::PrefixType, DampeningState>>
+      dampeningStates_;
+  size_t numSuppressedPrefixes_{0};
+
+  // fires when the next suppressed entry can be reused or entry forgotten
+  std::unique_ptr<folly::AsyncTimeout> dampeningTimer_;
+  std::chrono::steady_clock::time_point dampeningTimerExpiry_;
 }; // PrefixManager
 
 } // namespace openr
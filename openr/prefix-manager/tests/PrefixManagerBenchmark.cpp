@@ -0,0 +1,309 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <fb303/ServiceData.h>
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+
+#include <fbzmq/zmq/Zmq.h>
+
+#include <openr/config-store/PersistentStore.h>
+#include <openr/config/Config.h>
+#include <openr/config/tests/Utils.h>
+#include <openr/decision/RouteUpdate.h>
+#include <openr/kvstore/KvStoreWrapper.h>
+#include <openr/messaging/ReplicateQueue.h>
+#include <openr/prefix-manager/PrefixManager.h>
+#include <openr/tests/BenchmarkDriver.h>
+#include <openr/tests/mocks/PrefixGenerator.h>
+
+namespace {
+// Path of dryrun config store
+const std::string kConfigStorePath("/tmp/pm_benchmark_config_store.bin");
+// Prefix length of advertised prefixes
+const uint8_t kBitMaskLen = 64;
+} // anonymous namespace
+
+namespace fb303 = facebook::fb303;
+
+namespace openr {
+
+class PrefixManagerWrapper {
+ public:
+  explicit PrefixManagerWrapper(unsigned numOfOriginatedPrefixes = 0) {
+    configStore = std::make_unique<PersistentStore>(
+        kConfigStorePath, true /*dryrun*/, false /*periodicallySaveToDisk*/);
+    configStoreThread = std::make_unique<std::thread>([this]() {
+      LOG(INFO) << "ConfigStore thread starting";
+      configStore->run();
+      LOG(INFO) << "ConfigStore thread finishing";
+    });
+    configStore->waitUntilRunning();
+
+    // Originate fc00:<index>::/32 aggregates
+    auto tConfig = getBasicOpenrConfig("node-1");
+    std::vector<thrift::OriginatedPrefix> originatedPrefixes;
+    for (unsigned i = 0; i < numOfOriginatedPrefixes; i++) {
+      thrift::OriginatedPrefix originatedPrefix;
+      originatedPrefix.prefix_ref() = folly::sformat("fc00:{:x}::/32", i);
+      originatedPrefixes.emplace_back(std::move(originatedPrefix));
+    }
+    tConfig.originated_prefixes_ref() = std::move(originatedPrefixes);
+    config = std::make_shared<Config>(tConfig);
+
+    kvStoreWrapper = std::make_unique<KvStoreWrapper>(context, config);
+    kvStoreWrapper->run();
+
+    prefixManager = std::make_unique<PrefixManager>(
+        prefixUpdatesQueue.getReader(),
+        routeUpdatesQueue.getReader(),
+        config,
+        configStore.get(),
+        kvStoreWrapper->getKvStore(),
+        false /* prefix-mananger perf measurement */,
+        std::chrono::seconds{0});
+    prefixManagerThread = std::make_unique<std::thread>([this]() {
+      LOG(INFO) << "PrefixManager thread starting";
+      prefixManager->run();
+      LOG(INFO) << "PrefixManager thread finishing";
+    });
+    prefixManager->waitUntilRunning();
+  }
+
+  ~PrefixManagerWrapper() {
+    prefixUpdatesQueue.close();
+    routeUpdatesQueue.close();
+    kvStoreWrapper->closeQueue();
+
+    prefixManager->stop();
+    prefixManagerThread->join();
+    prefixManager.reset();
+
+    configStore->stop();
+    configStoreThread->join();
+    configStore.reset();
+
+    kvStoreWrapper->stop();
+    kvStoreWrapper.reset();
+  }
+
+  // Wait until originated prefixes have numOfRoutes supporting routes in total
+  void
+  waitForSupportingRoutes(size_t numOfRoutes) {
+    while (true) {
+      size_t total{0};
+      auto prefixEntries = prefixManager->getOriginatedPrefixes().get();
+      for (auto const& prefixEntry : *prefixEntries) {
+        total += prefixEntry.supporting_prefixes_ref()->size();
+      }
+      if (total == numOfRoutes) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  // Number of prefixes synced to KvStore so far
+  static int64_t
+  getSyncedPrefixes() {
+    auto counters = fb303::fbData->getCounters();
+    auto it = counters.find("prefix_manager.synced_prefixes.sum");
+    return it != counters.end() ? it->second : 0;
+  }
+
+  // Wait until KvStore syncs covered syncedPrefixes prefixes in total
+  void
+  waitForKvStoreSync(int64_t syncedPrefixes) {
+    while (getSyncedPrefixes() < syncedPrefixes) {
+      std::this_thread::yield();
+    }
+    // counter is bumped when sync starts, prefix-manager serves API calls
+    // only once it returned
+    prefixManager->getOriginatedPrefixes().get();
+  }
+
+  fbzmq::Context context;
+  messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue;
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue;
+
+  std::shared_ptr<Config> config;
+  std::unique_ptr<PersistentStore> configStore;
+  std::unique_ptr<std::thread> configStoreThread;
+  std::unique_ptr<KvStoreWrapper> kvStoreWrapper;
+  std::unique_ptr<PrefixManager> prefixManager;
+  std::unique_ptr<std::thread> prefixManagerThread;
+};
+
+// Random BGP prefixes as advertised by a BGP speaker
+static std::vector<thrift::PrefixEntry>
+generatePrefixEntries(unsigned numOfPrefixes) {
+  std::vector<thrift::PrefixEntry> prefixEntries;
+  for (auto const& prefix :
+       PrefixGenerator::ipv6PrefixGenerator(numOfPrefixes, kBitMaskLen)) {
+    prefixEntries.emplace_back(
+        createPrefixEntry(prefix, thrift::PrefixType::BGP));
+  }
+  return prefixEntries;
+}
+
+/**
+ * Benchmark for advertising prefixes through the API, e.g. BGP routes
+ * 1. Create a prefix-manager
+ * 2. Generate numOfPrefixes random prefixes
+ * 3. Advertise them and wait until prefix-manager took them over
+ * 4. Withdraw them again, not measured
+ *
+ * KvStore syncs are waited for outside of measurement, so they don't delay
+ * measured API calls.
+ */
+static void
+BM_PrefixManagerAdvertise(uint32_t iters, unsigned numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto wrapper = std::make_unique<PrefixManagerWrapper>();
+  auto const prefixEntries = generatePrefixEntries(numOfPrefixes);
+
+  for (uint32_t i = 0; i < iters; i++) {
+    int64_t syncedPrefixes =
+        PrefixManagerWrapper::getSyncedPrefixes() + prefixEntries.size();
+    suspender.dismiss(); // Start measuring benchmark time
+    wrapper->prefixManager->advertisePrefixes(prefixEntries).get();
+    suspender.rehire(); // Stop measuring time again
+    wrapper->waitForKvStoreSync(syncedPrefixes);
+
+    syncedPrefixes += prefixEntries.size();
+    wrapper->prefixManager->withdrawPrefixes(prefixEntries).get();
+    wrapper->waitForKvStoreSync(syncedPrefixes);
+  }
+}
+
+/**
+ * Benchmark for withdrawing prefixes through the API
+ * 1. Create a prefix-manager
+ * 2. Generate and advertise numOfPrefixes random prefixes, not measured
+ * 3. Withdraw them and wait until prefix-manager removed them
+ */
+static void
+BM_PrefixManagerWithdraw(uint32_t iters, unsigned numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto wrapper = std::make_unique<PrefixManagerWrapper>();
+  auto const prefixEntries = generatePrefixEntries(numOfPrefixes);
+
+  for (uint32_t i = 0; i < iters; i++) {
+    int64_t syncedPrefixes =
+        PrefixManagerWrapper::getSyncedPrefixes() + prefixEntries.size();
+    wrapper->prefixManager->advertisePrefixes(prefixEntries).get();
+    wrapper->waitForKvStoreSync(syncedPrefixes);
+
+    syncedPrefixes += prefixEntries.size();
+    suspender.dismiss(); // Start measuring benchmark time
+    wrapper->prefixManager->withdrawPrefixes(prefixEntries).get();
+    suspender.rehire(); // Stop measuring time again
+    wrapper->waitForKvStoreSync(syncedPrefixes);
+  }
+}
+
+/**
+ * Benchmark for syncing advertised prefixes into KvStore
+ * 1. Create a prefix-manager
+ * 2. Generate numOfPrefixes random prefixes
+ * 3. Advertise them and wait until the throttled KvStore sync finished,
+ *    which includes kPrefixMgrKvThrottleTimeout
+ * 4. Withdraw them again and wait for sync, not measured
+ */
+static void
+BM_PrefixManagerSyncKvStore(uint32_t iters, unsigned numOfPrefixes) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto wrapper = std::make_unique<PrefixManagerWrapper>();
+  auto const prefixEntries = generatePrefixEntries(numOfPrefixes);
+
+  for (uint32_t i = 0; i < iters; i++) {
+    int64_t syncedPrefixes =
+        PrefixManagerWrapper::getSyncedPrefixes() + prefixEntries.size();
+    suspender.dismiss(); // Start measuring benchmark time
+    wrapper->prefixManager->advertisePrefixes(prefixEntries).get();
+    wrapper->waitForKvStoreSync(syncedPrefixes);
+    suspender.rehire(); // Stop measuring time again
+
+    syncedPrefixes += prefixEntries.size();
+    wrapper->prefixManager->withdrawPrefixes(prefixEntries).get();
+    wrapper->waitForKvStoreSync(syncedPrefixes);
+  }
+}
+
+/**
+ * Benchmark for maintaining supporting routes of originated prefixes
+ * 1. Create a prefix-manager originating numOfOriginatedPrefixes aggregates
+ * 2. Generate numOfRoutes /64 routes spread over the aggregates
+ * 3. Send routes to prefix-manager as Decision would do
+ * 4. Wait until all routes are accounted as supporting routes
+ * 5. Withdraw routes again, not measured
+ */
+static void
+BM_PrefixManagerOriginatedRoutes(
+    uint32_t iters, unsigned numOfOriginatedPrefixes, unsigned numOfRoutes) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto wrapper =
+      std::make_unique<PrefixManagerWrapper>(numOfOriginatedPrefixes);
+
+  std::vector<folly::CIDRNetwork> routes;
+  for (unsigned i = 0; i < numOfRoutes; i++) {
+    routes.emplace_back(folly::IPAddress::createNetwork(folly::sformat(
+        "fc00:{:x}:{:x}:{:x}::/64",
+        i % numOfOriginatedPrefixes,
+        i >> 16,
+        i & 0xffff)));
+  }
+
+  for (uint32_t i = 0; i < iters; i++) {
+    DecisionRouteUpdate routeUpdate;
+    for (auto const& route : routes) {
+      routeUpdate.unicastRoutesToUpdate.emplace(route, RibUnicastEntry(route));
+    }
+
+    suspender.dismiss(); // Start measuring benchmark time
+    wrapper->routeUpdatesQueue.push(std::move(routeUpdate));
+    wrapper->waitForSupportingRoutes(routes.size());
+    suspender.rehire(); // Stop measuring time again
+
+    DecisionRouteUpdate withdrawUpdate;
+    withdrawUpdate.unicastRoutesToDelete = routes;
+    wrapper->routeUpdatesQueue.push(std::move(withdrawUpdate));
+    wrapper->waitForSupportingRoutes(0);
+  }
+}
+
+// The parameter is the number of advertised prefixes
+BENCHMARK_PARAM(BM_PrefixManagerAdvertise, 1000);
+BENCHMARK_PARAM(BM_PrefixManagerAdvertise, 10000);
+BENCHMARK_PARAM(BM_PrefixManagerAdvertise, 100000);
+BENCHMARK_PARAM(BM_PrefixManagerAdvertise, 1000000);
+
+BENCHMARK_PARAM(BM_PrefixManagerWithdraw, 1000);
+BENCHMARK_PARAM(BM_PrefixManagerWithdraw, 10000);
+BENCHMARK_PARAM(BM_PrefixManagerWithdraw, 100000);
+BENCHMARK_PARAM(BM_PrefixManagerWithdraw, 1000000);
+
+BENCHMARK_PARAM(BM_PrefixManagerSyncKvStore, 1000);
+BENCHMARK_PARAM(BM_PrefixManagerSyncKvStore, 10000);
+BENCHMARK_PARAM(BM_PrefixManagerSyncKvStore, 100000);
+
+// The parameters are the number of originated prefixes and of RIB routes
+BENCHMARK_NAMED_PARAM(BM_PrefixManagerOriginatedRoutes, 10_1000, 10, 1000);
+BENCHMARK_NAMED_PARAM(BM_PrefixManagerOriginatedRoutes, 100_10000, 100, 10000);
+BENCHMARK_NAMED_PARAM(
+    BM_PrefixManagerOriginatedRoutes, 1000_10000, 1000, 10000);
+BENCHMARK_NAMED_PARAM(
+    BM_PrefixManagerOriginatedRoutes, 1000_200000, 1000, 200000);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  return openr::runBenchmarks();
+}
@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <fb303/ServiceData.h>
 #include <fbzmq/zmq/Zmq.h>
 #include <folly/Format.h>
 #include <glog/logging.h>
@@ -23,6 +24,8 @@ using namespace openr;
 
 using apache::thrift::CompactSerializer;
 
+namespace fb303 = facebook::fb303;
+
 namespace {
 
 const auto addr1 = toIpPrefix("::ffff:10.1.1.1/128");
@@ -197,7 +200,7 @@ class PrefixManagerTestFixture : public testing::Test {
 
   // Queue for publishing entries to PrefixManager
   messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue;
-  messaging::ReplicateQueue<DecisionRouteUpdate> routeUpdatesQueue;
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue;
 
   std::string storageFilePath;
   std::unique_ptr<PersistentStore> configStore;
@@ -239,6 +242,141 @@ TEST_F(PrefixManagerTestFixture, AddRemovePrefix) {
   EXPECT_TRUE(prefixManager->withdrawPrefixes({ephemeralPrefixEntry9}).get());
 }
 
+//
+// Throttled syncs only recompute prefixes changed since the previous one
+//
+TEST_F(PrefixManagerTestFixture, IncrementalKvStoreSync) {
+  const std::string counter{"prefix_manager.synced_prefixes.sum"};
+  auto getSyncedPrefixes = [&counter]() {
+    auto counters = fb303::fbData->getCounters();
+    return counters.count(counter) ? counters.at(counter) : 0;
+  };
+  const auto waitTime = 2 * Constants::kPrefixMgrKvThrottleTimeout;
+
+  // let initial sync pass
+  std::this_thread::sleep_for(waitTime);
+  auto syncedPrefixes = getSyncedPrefixes();
+
+  EXPECT_TRUE(
+      prefixManager
+          ->advertisePrefixes({prefixEntry1, prefixEntry3, prefixEntry5})
+          .get());
+  std::this_thread::sleep_for(waitTime);
+  EXPECT_EQ(syncedPrefixes + 3, getSyncedPrefixes());
+  syncedPrefixes = getSyncedPrefixes();
+
+  EXPECT_TRUE(prefixManager->withdrawPrefixes({prefixEntry3}).get());
+  std::this_thread::sleep_for(waitTime);
+  EXPECT_EQ(syncedPrefixes + 1, getSyncedPrefixes());
+
+  // withdrawn key is cleared, others stay advertised
+  auto getPrefixKey = [](thrift::PrefixEntry const& entry) {
+    return PrefixKey(
+               "node-1",
+               toIPNetwork(*entry.prefix_ref()),
+               thrift::KvStore_constants::kDefaultArea())
+        .getPrefixKey();
+  };
+  auto isAdvertised = [&](thrift::PrefixEntry const& entry) {
+    auto maybeValue = kvStoreWrapper->getKey(getPrefixKey(entry));
+    if (not maybeValue.has_value()) {
+      return false;
+    }
+    auto db = fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
+        maybeValue->value_ref().value(), serializer);
+    return not *db.deletePrefix_ref();
+  };
+  EXPECT_TRUE(isAdvertised(prefixEntry1));
+  EXPECT_FALSE(isAdvertised(prefixEntry3));
+  EXPECT_TRUE(isAdvertised(prefixEntry5));
+}
+
+//
+// Prefix whose best entry didn't change isn't serialized again
+//
+TEST_F(PrefixManagerTestFixture, AdvertisedValueCache) {
+  const std::string counter{"prefix_manager.advertised_value_cache_hit_pct"};
+  const auto waitTime = 2 * Constants::kPrefixMgrKvThrottleTimeout;
+
+  EXPECT_TRUE(prefixManager->advertisePrefixes({prefixEntry1}).get());
+  std::this_thread::sleep_for(waitTime);
+  EXPECT_EQ(0, fb303::fbData->getCounter(counter));
+
+  // same prefix from another client with same metrics, lower type stays best
+  const auto bgpPrefixEntry1 =
+      createPrefixEntry(*prefixEntry1.prefix_ref(), thrift::PrefixType::BGP);
+  EXPECT_TRUE(prefixManager->advertisePrefixes({bgpPrefixEntry1}).get());
+  std::this_thread::sleep_for(waitTime);
+  EXPECT_EQ(50, fb303::fbData->getCounter(counter));
+
+  EXPECT_TRUE(prefixManager->withdrawPrefixes({bgpPrefixEntry1}).get());
+  std::this_thread::sleep_for(waitTime);
+  EXPECT_EQ(66, fb303::fbData->getCounter(counter));
+}
+
+class PrefixDampeningFixture : public PrefixManagerTestFixture {
+  thrift::OpenrConfig
+  createConfig() override {
+    auto tConfig = PrefixManagerTestFixture::createConfig();
+    thrift::PrefixDampeningConfig dampConf;
+    dampConf.penalty_ref() = 1000;
+    dampConf.suppress_threshold_ref() = 2000;
+    dampConf.reuse_threshold_ref() = 750;
+    dampConf.half_life_s_ref() = 1;
+    dampConf.max_suppress_time_s_ref() = 3;
+    tConfig.prefix_dampening_config_ref()->emplace(
+        thrift::PrefixType::BGP, dampConf);
+    return tConfig;
+  }
+};
+
+//
+// Flapping prefix of dampened type is suppressed until its penalty decays,
+// prefixes of other types are not dampened
+//
+TEST_F(PrefixDampeningFixture, SuppressFlappingPrefix) {
+  const auto waitTime = 2 * Constants::kPrefixMgrKvThrottleTimeout;
+  auto isAdvertised = [&](thrift::PrefixEntry const& entry) {
+    auto maybeValue = kvStoreWrapper->getKey(
+        PrefixKey(
+            "node-1",
+            toIPNetwork(*entry.prefix_ref()),
+            thrift::KvStore_constants::kDefaultArea())
+            .getPrefixKey());
+    if (not maybeValue.has_value()) {
+      return false;
+    }
+    auto db = fbzmq::util::readThriftObjStr<thrift::PrefixDatabase>(
+        maybeValue->value_ref().value(), serializer);
+    return not *db.deletePrefix_ref();
+  };
+
+  // three withdrawals reach suppress threshold
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(
+        prefixManager->advertisePrefixes({ephemeralPrefixEntry9, prefixEntry1})
+            .get());
+    EXPECT_TRUE(
+        prefixManager->withdrawPrefixes({ephemeralPrefixEntry9, prefixEntry1})
+            .get());
+  }
+  EXPECT_TRUE(
+      prefixManager->advertisePrefixes({ephemeralPrefixEntry9, prefixEntry1})
+          .get());
+  std::this_thread::sleep_for(waitTime);
+  EXPECT_FALSE(isAdvertised(ephemeralPrefixEntry9));
+  EXPECT_TRUE(isAdvertised(prefixEntry1));
+  EXPECT_EQ(
+      1, fb303::fbData->getCounter("prefix_manager.suppressed_prefixes"));
+
+  // penalty of ~3000 decays below reuse threshold in ~2 half-lives
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::seconds(3));
+  EXPECT_TRUE(isAdvertised(ephemeralPrefixEntry9));
+  EXPECT_EQ(
+      0, fb303::fbData->getCounter("prefix_manager.suppressed_prefixes"));
+}
+
 TEST_F(PrefixManagerTestFixture, RemoveUpdateType) {
   EXPECT_TRUE(prefixManager->advertisePrefixes({prefixEntry1}).get());
   EXPECT_TRUE(prefixManager->advertisePrefixes({prefixEntry2}).get());
@@ -1185,6 +1323,57 @@ TEST_F(PrefixManagerTestFixture, PrefixUpdatesQueue) {
 /**
  * Verifies `getAdvertisedRoutesFiltered` with all filter combinations
  */
+//
+// Requests larger than a chunk are applied piecewise, but persisted once and
+// with same end result
+//
+TEST_F(PrefixManagerTestFixture, BulkPrefixUpdatesQueue) {
+  const size_t numPrefixes = 2 * Constants::kPrefixMgrUpdateChunkSize + 1;
+  std::vector<thrift::PrefixEntry> prefixEntries;
+  for (size_t i = 0; i < numPrefixes; ++i) {
+    prefixEntries.emplace_back(createPrefixEntry(
+        toIpPrefix(folly::sformat("10.{}.{}.0/24", i / 256, i % 256)),
+        thrift::PrefixType::BGP));
+  }
+
+  // wait until PrefixManager holds given number of prefixes
+  auto waitForPrefixes = [this](size_t num) {
+    for (int i = 0; i < 100; ++i) {
+      if (prefixManager->getPrefixes().get()->size() == num) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return false;
+  };
+
+  // ADD_PREFIXES
+  {
+    thrift::PrefixUpdateRequest request;
+    request.cmd_ref() = thrift::PrefixUpdateCommand::ADD_PREFIXES;
+    *request.prefixes_ref() = prefixEntries;
+    prefixUpdatesQueue.push(std::move(request));
+
+    EXPECT_TRUE(waitForPrefixes(numPrefixes));
+    EXPECT_EQ(1, configStore->getNumOfDbWritesToDisk());
+  }
+
+  // SYNC_PREFIXES_BY_TYPE, keeping less than a chunk
+  {
+    thrift::PrefixUpdateRequest request;
+    request.cmd_ref() = thrift::PrefixUpdateCommand::SYNC_PREFIXES_BY_TYPE;
+    request.type_ref() = thrift::PrefixType::BGP;
+    prefixEntries.resize(numPrefixes / 4);
+    *request.prefixes_ref() = prefixEntries;
+    prefixUpdatesQueue.push(std::move(request));
+
+    EXPECT_TRUE(waitForPrefixes(prefixEntries.size()));
+    EXPECT_EQ(2, configStore->getNumOfDbWritesToDisk());
+    auto prefixes = prefixManager->getPrefixes().get();
+    EXPECT_THAT(*prefixes, testing::UnorderedElementsAreArray(prefixEntries));
+  }
+}
+
 TEST_F(PrefixManagerTestFixture, GetAdvertisedRoutes) {
   //
   // Add prefixes, prefix1 -> DEFAULT, LOOPBACK
@@ -1283,6 +1472,51 @@ TEST_F(PrefixManagerTestFixture, GetAdvertisedRoutes) {
     auto routes = prefixManager->getAdvertisedRoutesFiltered(filter).get();
     ASSERT_EQ(0, routes->size());
   }
+
+  //
+  // Filter on covering prefix, alone and with type
+  //
+  auto const subnet = toIpPrefix("10.1.0.0/16");
+  EXPECT_TRUE(prefixManager
+                  ->advertisePrefixes(
+                      {createPrefixEntry(subnet, thrift::PrefixType::BGP),
+                       createPrefixEntry(
+                           toIpPrefix("11.0.0.0/8"), thrift::PrefixType::BGP)})
+                  .get());
+  auto getPrefixes = [this](thrift::AdvertisedRouteFilter const& filter) {
+    std::vector<thrift::IpPrefix> prefixes;
+    for (auto const& route :
+         *prefixManager->getAdvertisedRoutesFiltered(filter).get()) {
+      prefixes.emplace_back(*route.prefix_ref());
+    }
+    return prefixes;
+  };
+  {
+    thrift::AdvertisedRouteFilter filter;
+    filter.coveringPrefix_ref() = prefix;
+    EXPECT_THAT(
+        getPrefixes(filter), testing::UnorderedElementsAre(prefix, subnet));
+
+    filter.prefixType_ref() = thrift::PrefixType::BGP;
+    EXPECT_THAT(getPrefixes(filter), testing::ElementsAre(subnet));
+
+    filter.coveringPrefix_ref() = toIpPrefix("10.1.0.0/24");
+    EXPECT_TRUE(getPrefixes(filter).empty());
+  }
+
+  //
+  // Filters follow withdrawals
+  //
+  EXPECT_TRUE(
+      prefixManager->withdrawPrefixesByType(thrift::PrefixType::BGP).get());
+  {
+    thrift::AdvertisedRouteFilter filter;
+    filter.coveringPrefix_ref() = prefix;
+    EXPECT_THAT(getPrefixes(filter), testing::ElementsAre(prefix));
+
+    filter.prefixType_ref() = thrift::PrefixType::BGP;
+    EXPECT_TRUE(getPrefixes(filter).empty());
+  }
 }
 
 /**
@@ -1394,10 +1628,10 @@ TEST_F(PrefixManagerMultiAreaTestFixture, DecisionRouteUpdates) {
     expected.emplace(keyStrC, expectedPrefixEntry1A);
 
     auto pub1 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub1, got, gotDeleted);
+    readPublication(*pub1, got, gotDeleted);
 
     auto pub2 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub2, got, gotDeleted);
+    readPublication(*pub2, got, gotDeleted);
 
     EXPECT_EQ(expected, got);
     EXPECT_EQ(0, gotDeleted.size());
@@ -1431,13 +1665,13 @@ TEST_F(PrefixManagerMultiAreaTestFixture, DecisionRouteUpdates) {
     expected.emplace(keyStrC, expectedPrefixEntry1B);
 
     auto pub1 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub1, got, gotDeleted);
+    readPublication(*pub1, got, gotDeleted);
 
     auto pub2 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub2, got, gotDeleted);
+    readPublication(*pub2, got, gotDeleted);
 
     auto pub3 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub3, got, gotDeleted);
+    readPublication(*pub3, got, gotDeleted);
 
     EXPECT_EQ(expected, got);
 
@@ -1456,10 +1690,10 @@ TEST_F(PrefixManagerMultiAreaTestFixture, DecisionRouteUpdates) {
     std::map<std::string, thrift::PrefixEntry> got, gotDeleted;
 
     auto pub1 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub1, got, gotDeleted);
+    readPublication(*pub1, got, gotDeleted);
 
     auto pub2 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub2, got, gotDeleted);
+    readPublication(*pub2, got, gotDeleted);
 
     EXPECT_EQ(0, got.size());
 
@@ -1519,7 +1753,7 @@ TEST_F(PrefixManagerMultiAreaTestFixture, DecisionRouteNexthopUpdates) {
     expected.emplace(keyStrC, expectedPrefixEntry1A);
 
     auto pub1 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub1, got, gotDeleted);
+    readPublication(*pub1, got, gotDeleted);
 
     EXPECT_EQ(expected, got);
 
@@ -1539,7 +1773,7 @@ TEST_F(PrefixManagerMultiAreaTestFixture, DecisionRouteNexthopUpdates) {
     std::map<std::string, thrift::PrefixEntry> got, gotDeleted;
 
     auto pub1 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub1, got, gotDeleted);
+    readPublication(*pub1, got, gotDeleted);
 
     EXPECT_EQ(0, got.size());
     EXPECT_EQ(1, gotDeleted.size());
@@ -1560,7 +1794,7 @@ TEST_F(PrefixManagerMultiAreaTestFixture, DecisionRouteNexthopUpdates) {
     expected.emplace(keyStrB, expectedPrefixEntry1A);
 
     auto pub1 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub1, got, gotDeleted);
+    readPublication(*pub1, got, gotDeleted);
 
     EXPECT_EQ(expected, got);
     EXPECT_EQ(0, gotDeleted.size());
@@ -1597,7 +1831,7 @@ TEST_F(PrefixManagerMultiAreaTestFixture, DecisionRouteNexthopUpdates) {
     int expectedPubCnt{3}, gotPubCnt{0};
     while (gotPubCnt < expectedPubCnt) {
       auto pub = kvStoreUpdatesQueue.get().value();
-      gotPubCnt += readPublication(pub, got, gotDeleted);
+      gotPubCnt += readPublication(*pub, got, gotDeleted);
     }
 
     EXPECT_EQ(expected, got);
@@ -1618,10 +1852,10 @@ TEST_F(PrefixManagerMultiAreaTestFixture, DecisionRouteNexthopUpdates) {
     std::map<std::string, thrift::PrefixEntry> got, gotDeleted;
 
     auto pub1 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub1, got, gotDeleted);
+    readPublication(*pub1, got, gotDeleted);
 
     auto pub2 = kvStoreUpdatesQueue.get().value();
-    readPublication(pub2, got, gotDeleted);
+    readPublication(*pub2, got, gotDeleted);
 
     EXPECT_EQ(0, got.size());
 
@@ -1631,6 +1865,135 @@ TEST_F(PrefixManagerMultiAreaTestFixture, DecisionRouteNexthopUpdates) {
   }
 }
 
+class AreaSummarizationFixture : public PrefixManagerMultiAreaTestFixture {
+  thrift::OpenrConfig
+  createConfig() override {
+    // config three areas A B C, summarize into C only
+    auto A = createAreaConfig("A", {"RSW.*"}, {".*"});
+    auto B = createAreaConfig("B", {"FSW.*"}, {".*"});
+    auto C = createAreaConfig("C", {"SSW.*"}, {".*"});
+    C.summary_prefixes_ref() = {summary_};
+
+    auto tConfig = getBasicOpenrConfig("node-1", "domain", {A, B, C});
+    tConfig.kvstore_config_ref()->sync_interval_s_ref() = 1;
+
+    return tConfig;
+  }
+
+ protected:
+  const std::string summary_ = "10.1.0.0/16";
+};
+
+/**
+ * Verify routes redistributed into an area with summary prefixes:
+ * 1. Inject route covered by summary from area A
+ *    => B receives route, C receives summary instead
+ * 2. Inject another covered route from area A
+ *    => B receives route, summary in C unchanged
+ * 3. Withdraw first route => B receives withdraw, C keeps summary
+ * 4. Withdraw second route => B and C receive withdraw
+ */
+TEST_F(AreaSummarizationFixture, SummarizeRedistributedRoutes) {
+  auto kvStoreUpdatesQueue = kvStoreWrapper->getReader();
+
+  auto path = createNextHop(
+      toBinaryAddress(folly::IPAddress("fe80::2")),
+      std::string("iface_1_2_1"),
+      1);
+  path.area_ref() = "A";
+
+  const auto prefix1 = toIpPrefix("10.1.1.0/24");
+  const auto prefix2 = toIpPrefix("10.1.2.0/24");
+  auto unicast1 = RibUnicastEntry(
+      toIPNetwork(prefix1), {path}, createPrefixEntry(prefix1), "A", false);
+  auto unicast2 = RibUnicastEntry(
+      toIPNetwork(prefix2), {path}, createPrefixEntry(prefix2), "A", false);
+
+  auto key1B = PrefixKey("node-1", toIPNetwork(prefix1), "B").getPrefixKey();
+  auto key2B = PrefixKey("node-1", toIPNetwork(prefix2), "B").getPrefixKey();
+  auto summaryKeyC =
+      PrefixKey("node-1", folly::IPAddress::createNetwork(summary_), "C")
+          .getPrefixKey();
+
+  // skip ttl updates
+  auto readPublications = [&](int pubCnt, auto& got, auto& gotDeleted) {
+    int gotPubCnt{0};
+    while (gotPubCnt < pubCnt) {
+      auto pub = kvStoreUpdatesQueue.get().value();
+      gotPubCnt += readPublication(*pub, got, gotDeleted);
+    }
+  };
+
+  //
+  // 1. route to B, summary to C
+  //
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(unicast1);
+    routeUpdatesQueue.push(std::move(routeUpdate));
+
+    std::map<std::string, thrift::PrefixEntry> got, gotDeleted;
+    readPublications(2, got, gotDeleted);
+
+    EXPECT_EQ(2, got.size());
+    EXPECT_EQ(0, gotDeleted.size());
+    EXPECT_EQ(prefix1, *got.at(key1B).prefix_ref());
+    EXPECT_EQ(thrift::PrefixType::RIB, *got.at(key1B).type_ref());
+    EXPECT_EQ(toIpPrefix(summary_), *got.at(summaryKeyC).prefix_ref());
+    EXPECT_EQ(thrift::PrefixType::SUMMARY, *got.at(summaryKeyC).type_ref());
+    EXPECT_TRUE(got.at(summaryKeyC).area_stack_ref()->empty());
+  }
+
+  //
+  // 2. route to B only
+  //
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.addRouteToUpdate(unicast2);
+    routeUpdatesQueue.push(std::move(routeUpdate));
+
+    std::map<std::string, thrift::PrefixEntry> got, gotDeleted;
+    readPublications(1, got, gotDeleted);
+
+    EXPECT_EQ(1, got.size());
+    EXPECT_EQ(0, gotDeleted.size());
+    EXPECT_EQ(prefix2, *got.at(key2B).prefix_ref());
+  }
+
+  //
+  // 3. withdraw from B only
+  //
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.unicastRoutesToDelete.emplace_back(toIPNetwork(prefix1));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+
+    std::map<std::string, thrift::PrefixEntry> got, gotDeleted;
+    readPublications(1, got, gotDeleted);
+
+    EXPECT_EQ(0, got.size());
+    EXPECT_EQ(1, gotDeleted.size());
+    EXPECT_EQ(prefix1, *gotDeleted.at(key1B).prefix_ref());
+  }
+
+  //
+  // 4. withdraw from B and summary from C
+  //
+  {
+    DecisionRouteUpdate routeUpdate;
+    routeUpdate.unicastRoutesToDelete.emplace_back(toIPNetwork(prefix2));
+    routeUpdatesQueue.push(std::move(routeUpdate));
+
+    std::map<std::string, thrift::PrefixEntry> got, gotDeleted;
+    readPublications(2, got, gotDeleted);
+
+    EXPECT_EQ(0, got.size());
+    EXPECT_EQ(2, gotDeleted.size());
+    EXPECT_EQ(prefix2, *gotDeleted.at(key2B).prefix_ref());
+    EXPECT_EQ(toIpPrefix(summary_), *gotDeleted.at(summaryKeyC).prefix_ref());
+  }
+}
+
 class RouteOriginationFixture : public PrefixManagerTestFixture {
  public:
   openr::thrift::OpenrConfig
@@ -1747,10 +2110,19 @@ TEST_F(RouteOriginationFixture, BasicAdvertiseWithdraw) {
       prefixEntryV6_2,
       thrift::KvStore_constants::kDefaultArea());
 
+  // route outside of originated prefixes, supporting none
+  auto const otherNetwork = folly::IPAddress::createNetwork("10.0.0.0/8");
+  auto unicastEntryOther = RibUnicastEntry(
+      otherNetwork,
+      {nh_1},
+      createPrefixEntry(toIpPrefix(otherNetwork), thrift::PrefixType::DEFAULT),
+      thrift::KvStore_constants::kDefaultArea());
+
   //
   // Step1: Inject:
   //  - 1 supporting route for v4Prefix;
   //  - 1 supporting route for v6Prefix;
+  //  - 1 route supporting neither;
   // Expect:
   //  - v4Prefix_ will be advertised as `min_supporting_route=1`;
   //  - v6Prefix_ will NOT be advertised as `min_supporting_route=2`;
@@ -1759,6 +2131,7 @@ TEST_F(RouteOriginationFixture, BasicAdvertiseWithdraw) {
     DecisionRouteUpdate routeUpdate;
     routeUpdate.addRouteToUpdate(unicastEntryV4_1);
     routeUpdate.addRouteToUpdate(unicastEntryV6_1);
+    routeUpdate.addRouteToUpdate(unicastEntryOther);
     routeUpdatesQueue.push(std::move(routeUpdate));
 
     auto mp = getOriginatedPrefixDb();
@@ -56,15 +56,14 @@ class DecisionRoutesComputedCmd(OpenrCtrlCmd):
     ) -> None:
         if "all" in nodes:
             nodes = self._get_all_nodes(client)
+        route_dbs = client.getRouteDbComputedBatch(list(nodes))
         if json:
             route_db_dict = {}
-            for node in nodes:
-                route_db = client.getRouteDbComputed(node)
+            for node, route_db in zip(nodes, route_dbs):
                 route_db_dict[node] = utils.route_db_to_dict(route_db)
             utils.print_routes_json(route_db_dict, prefixes, labels)
         else:
-            for node in nodes:
-                route_db = client.getRouteDbComputed(node)
+            for route_db in route_dbs:
                 utils.print_route_db(route_db, prefixes, labels)
 
     def _get_all_nodes(self, client: OpenrCtrl.Client) -> set:
@@ -695,9 +694,17 @@ class DecisionRibPolicyCmd(OpenrCtrlCmd):
         print(f"  Validity: {policy.ttl_secs}s")
         for stmt in policy.statements:
             prefixes = stmt.matcher.prefixes or []
+            prefix_ranges = [
+                self._sprint_prefix_range(r) for r in stmt.matcher.prefix_ranges or []
+            ]
+            tags = stmt.matcher.tags or []
             action = stmt.action.set_weight or ctrl_types.RibRouteActionWeight()
             print(f"  Statement: {stmt.name}")
             print(f"    Prefix Match List: {', '.join(prefixes)}")
+            if prefix_ranges:
+                print(f"    Prefix Range Match List: {', '.join(prefix_ranges)}")
+            if tags:
+                print(f"    Tag Match List: {', '.join(tags)}")
             print("    Action Set Weight:")
             print(f"      Default: {action.default_weight}")
             print("      Area:")
@@ -707,6 +714,14 @@ class DecisionRibPolicyCmd(OpenrCtrlCmd):
             for neighbor, weight in action.neighbor_to_weight.items():
                 print(f"        {neighbor}: {weight}")
 
+    def _sprint_prefix_range(self, prefix_range: ctrl_types.RibPrefixRange) -> str:
+        prefix_range_str = ipnetwork.sprint_prefix(prefix_range.prefix)
+        if prefix_range.ge is not None:
+            prefix_range_str += f" ge {prefix_range.ge}"
+        if prefix_range.le is not None:
+            prefix_range_str += f" le {prefix_range.le}"
+        return prefix_range_str
+
 
 class ReceivedRoutesCmd(OpenrCtrlCmd):
 
@@ -6,7 +6,11 @@
  */
 
 #include <glog/logging.h>
+#include <linux/errqueue.h>
 #include <net/if.h>
+#include <netinet/ip6.h>
+#include <limits>
+#include <memory>
 
 #include <folly/Format.h>
 #include <folly/SocketAddress.h>
@@ -14,6 +18,187 @@
 
 namespace openr {
 
+namespace {
+
+// the control message buffer
+// XXX: hardcoded, but this hardly should be a problem
+union RecvCtrlBuf {
+  char ctrlBuf[CMSG_SPACE(1024)];
+  struct cmsghdr align;
+};
+
+// control message buffer for source address and interface of sent packet
+union SendCtrlBuf {
+  char cbuf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+  struct cmsghdr align;
+};
+
+// cast to int64_t since ts.tv_sec is 32 bits on some platforms like arm
+std::chrono::microseconds
+toMicroseconds(struct timespec const& ts) {
+  return std::chrono::microseconds(
+      static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000);
+}
+
+// timestamp from SO_TIMESTAMPING control message, preferring the NIC one if
+// NIC has stamped the packet. Zero if neither is set
+std::chrono::microseconds
+getTimestamping(struct cmsghdr* cmsg) {
+  struct scm_timestamping tss;
+  memcpy(reinterpret_cast<void*>(&tss), CMSG_DATA(cmsg), sizeof(tss));
+  // ts[0] holds software timestamp, ts[2] raw hardware timestamp
+  if (tss.ts[2].tv_sec or tss.ts[2].tv_nsec) {
+    return toMicroseconds(tss.ts[2]);
+  }
+  return toMicroseconds(tss.ts[0]);
+}
+
+// prepare msg for receiving a single block of data into buf
+void
+prepareRecvMsg(
+    struct msghdr& msg,
+    struct iovec& entry,
+    RecvCtrlBuf& u,
+    sockaddr_storage& addrStorage,
+    unsigned char* buf,
+    int len) {
+  ::memset(&msg, 0, sizeof(msg));
+
+  // we only expect to receive one block of data, single entry
+  // in the vector
+  msg.msg_iov = &entry;
+  msg.msg_iovlen = 1;
+
+  // this part is important - if we don't zero the buffer,
+  // the CMSG_NXTHDR may burp, because it tries extracting
+  // fields from "next header" in the buffer
+  ::memset(&u.ctrlBuf[0], 0, sizeof(u.ctrlBuf));
+
+  // control message buffer used to receive dest IP from the kernel
+  msg.msg_control = u.ctrlBuf;
+  msg.msg_controllen = sizeof(u.ctrlBuf);
+
+  // prepare to receive either v4 or v6 addresses
+  ::memset(&addrStorage, 0, sizeof(addrStorage));
+  msg.msg_name = &addrStorage;
+  msg.msg_namelen = sizeof(sockaddr_storage);
+
+  // write the data here
+  entry.iov_base = buf;
+  entry.iov_len = len;
+}
+
+// extract interface, sender, hop limit and timestamp of received msg
+IoProvider::RecvResult
+parseRecvMsg(struct msghdr& msg, ssize_t bytesRead) {
+  // grab the inIndex we received this packet on and the hopLimit
+  // those are available since we requested them via socket options
+  struct cmsghdr* cmsg{nullptr};
+  int ifIndex{-1};
+  int hopLimit{0};
+
+  // use user space timestamp if kernel timestamp is not found
+  std::chrono::microseconds recvTs{
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch())};
+
+  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == IPPROTO_IPV6) {
+      if (cmsg->cmsg_type == IPV6_PKTINFO) {
+        struct in6_pktinfo pktinfo;
+        memcpy(
+            reinterpret_cast<void*>(&pktinfo),
+            CMSG_DATA(cmsg),
+            sizeof(pktinfo));
+        ifIndex = pktinfo.ipi6_ifindex;
+      } else if (cmsg->cmsg_type == IPV6_HOPLIMIT) {
+        memcpy(
+            reinterpret_cast<void*>(&hopLimit),
+            CMSG_DATA(cmsg),
+            sizeof(hopLimit));
+      }
+    }
+    if (cmsg->cmsg_level == SOL_SOCKET &&
+        (cmsg->cmsg_type == SO_TIMESTAMPNS ||
+         cmsg->cmsg_type == SCM_TIMESTAMPING)) {
+      std::chrono::microseconds kernelRecvTs{0};
+      if (cmsg->cmsg_type == SO_TIMESTAMPNS) {
+        struct timespec ts {
+          0, 0
+        };
+        memcpy(reinterpret_cast<void*>(&ts), CMSG_DATA(cmsg), sizeof(ts));
+        kernelRecvTs = toMicroseconds(ts);
+
+        // sanity check
+        DCHECK(recvTs >= kernelRecvTs) << "Time anomaly";
+      } else {
+        // NIC clock may run slightly ahead of system clock
+        kernelRecvTs = getTimestamping(cmsg);
+        if (not kernelRecvTs.count()) {
+          continue;
+        }
+      }
+
+      VLOG(4) << "Got kernel-timestamp. It took "
+              << (recvTs - kernelRecvTs).count()
+              << " us for the packet to get from kernel to user space";
+      recvTs = kernelRecvTs;
+    }
+  } // for
+
+  // build the source socket address from recvmsg data
+  folly::SocketAddress srcAddr{};
+  // this will throw if sender address was not filled in
+  srcAddr.setFromSockaddr(reinterpret_cast<struct sockaddr*>(msg.msg_name));
+
+  DCHECK(ifIndex != -1) << "ifIndex is not found";
+  DCHECK(hopLimit) << "hopLimit is not found";
+
+  return std::make_tuple(bytesRead, ifIndex, srcAddr, hopLimit, recvTs);
+}
+
+// prepare msg for sending packet to dstAddr via given interface
+void
+prepareSendMsg(
+    struct msghdr& msg,
+    struct iovec& entry,
+    SendCtrlBuf& u,
+    sockaddr_storage& addrStorage,
+    socklen_t addrLen,
+    int ifIndex,
+    folly::IPAddressV6 const& srcAddr,
+    std::string const& packet) {
+  struct cmsghdr* cmsg{nullptr};
+
+  ::memset(&msg, 0, sizeof(msg));
+  msg.msg_name = reinterpret_cast<void*>(&addrStorage);
+  msg.msg_namelen = addrLen;
+
+  // set the source address and source if index for this message
+  // this goes into ancilliary data fields
+  msg.msg_control = u.cbuf;
+  msg.msg_controllen = sizeof(u.cbuf);
+  cmsg = CMSG_FIRSTHDR(&msg);
+
+  cmsg->cmsg_level = IPPROTO_IPV6;
+  cmsg->cmsg_type = IPV6_PKTINFO;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
+
+  auto pktinfo = (struct in6_pktinfo*)CMSG_DATA(cmsg);
+  pktinfo->ipi6_ifindex = ifIndex;
+  ::memcpy(&pktinfo->ipi6_addr, srcAddr.bytes(), srcAddr.byteCount());
+
+  // the IO vector for data to be sent
+  msg.msg_iov = &entry;
+  msg.msg_iovlen = 1;
+
+  // write the data here (we need to remove the const qualifier)
+  entry.iov_base = const_cast<char*>(packet.data());
+  entry.iov_len = packet.size();
+}
+
+} // namespace
+
 int
 IoProvider::socket(int domain, int type, int protocol) {
   return ::socket(domain, type, protocol);
@@ -68,20 +253,22 @@ IoProvider::sendmsg(int sockfd, const struct msghdr* msg, int flags) {
   return ::sendmsg(sockfd, msg, flags);
 }
 
-std::tuple<
-    ssize_t /* size */,
-    int /* ifIndex */,
-    folly::SocketAddress /* srcAddr */,
-    int /* hopLimit */,
-    std::chrono::microseconds /* kernel timestamp */>
+int
+IoProvider::recvmmsg(
+    int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags) {
+  return ::recvmmsg(sockfd, msgvec, vlen, flags, nullptr /* timeout */);
+}
+
+int
+IoProvider::sendmmsg(
+    int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags) {
+  return ::sendmmsg(sockfd, msgvec, vlen, flags);
+}
+
+IoProvider::RecvResult
 IoProvider::recvMessage(
     int fd, unsigned char* buf, int len, openr::IoProvider* ioProvider) {
-  // the control message buffer
-  // XXX: hardcoded, but this hardly should be a problem
-  union {
-    char ctrlBuf[CMSG_SPACE(1024)];
-    struct cmsghdr align;
-  } u;
+  RecvCtrlBuf u;
 
   // the message header to receive into
   struct msghdr msg;
@@ -92,30 +279,7 @@ IoProvider::recvMessage(
   // for address of the sender
   sockaddr_storage addrStorage;
 
-  ::memset(&msg, 0, sizeof(msg));
-
-  // we only expect to receive one block of data, single entry
-  // in the vector
-  msg.msg_iov = &entry;
-  msg.msg_iovlen = 1;
-
-  // this part is important - if we don't zero the buffer,
-  // the CMSG_NXTHDR may burp, because it tries extracting
-  // fields from "next header" in the buffer
-  ::memset(&u.ctrlBuf[0], 0, sizeof(u.ctrlBuf));
-
-  // control message buffer used to receive dest IP from the kernel
-  msg.msg_control = u.ctrlBuf;
-  msg.msg_controllen = sizeof(u.ctrlBuf);
-
-  // prepare to receive either v4 or v6 addresses
-  ::memset(&addrStorage, 0, sizeof(addrStorage));
-  msg.msg_name = &addrStorage;
-  msg.msg_namelen = sizeof(sockaddr_storage);
-
-  // write the data here
-  entry.iov_base = buf;
-  entry.iov_len = len;
+  prepareRecvMsg(msg, entry, u, addrStorage, buf, len);
 
   ssize_t bytesRead = ioProvider->recvmsg(fd, &msg, MSG_DONTWAIT);
 
@@ -128,62 +292,103 @@ IoProvider::recvMessage(
     throw std::runtime_error("Message truncated");
   }
 
-  // grab the inIndex we received this packet on and the hopLimit
-  // those are available since we requested them via socket options
-  struct cmsghdr* cmsg{nullptr};
-  int ifIndex{-1};
-  int hopLimit{0};
+  return parseRecvMsg(msg, bytesRead);
+}
 
-  // use user space timestamp if kernel timestamp is not found
-  std::chrono::microseconds recvTs{
-      std::chrono::duration_cast<std::chrono::microseconds>(
-          std::chrono::system_clock::now().time_since_epoch())};
+std::vector<IoProvider::RecvResult>
+IoProvider::recvMessages(
+    int fd,
+    unsigned char* buf,
+    int len,
+    unsigned int vlen,
+    openr::IoProvider* ioProvider) {
+  // control buffers are too big for the stack when receiving many messages
+  auto ctrlBufs = std::make_unique<RecvCtrlBuf[]>(vlen);
+  std::vector<struct mmsghdr> msgs(vlen);
+  std::vector<struct iovec> entries(vlen);
+  std::vector<sockaddr_storage> addrStorages(vlen);
+
+  for (unsigned int i = 0; i < vlen; ++i) {
+    msgs[i].msg_len = 0;
+    prepareRecvMsg(
+        msgs[i].msg_hdr,
+        entries[i],
+        ctrlBufs[i],
+        addrStorages[i],
+        buf + i * len,
+        len);
+  }
 
-  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-    if (cmsg->cmsg_level == IPPROTO_IPV6) {
-      if (cmsg->cmsg_type == IPV6_PKTINFO) {
-        struct in6_pktinfo pktinfo;
-        memcpy(
-            reinterpret_cast<void*>(&pktinfo),
-            CMSG_DATA(cmsg),
-            sizeof(pktinfo));
-        ifIndex = pktinfo.ipi6_ifindex;
-      } else if (cmsg->cmsg_type == IPV6_HOPLIMIT) {
-        memcpy(
-            reinterpret_cast<void*>(&hopLimit),
-            CMSG_DATA(cmsg),
-            sizeof(hopLimit));
-      }
+  int numRead = ioProvider->recvmmsg(fd, msgs.data(), vlen, MSG_DONTWAIT);
+
+  if (numRead < 0) {
+    if (errno == EAGAIN or errno == EWOULDBLOCK) {
+      return {};
     }
-    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPNS) {
-      struct timespec ts {
-        0, 0
-      };
-      memcpy(reinterpret_cast<void*>(&ts), CMSG_DATA(cmsg), sizeof(ts));
-
-      // cast to int64_t since ts.tv_sec is 32 bits on some platforms like arm
-      const int64_t usecs =
-          static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
-      const std::chrono::microseconds kernelRecvTs(usecs);
-
-      // sanity check
-      DCHECK(recvTs >= kernelRecvTs) << "Time anomaly";
-      VLOG(4) << "Got kernel-timestamp. It took "
-              << (recvTs - kernelRecvTs).count()
-              << " us for the packet to get from kernel to user space";
-      recvTs = kernelRecvTs;
+    throw std::runtime_error(folly::sformat(
+        "Failed reading messages on fd {}: {}", fd, folly::errnoStr(errno)));
+  }
+
+  std::vector<RecvResult> results;
+  results.reserve(numRead);
+  for (int i = 0; i < numRead; ++i) {
+    ssize_t bytesRead = msgs[i].msg_len;
+    if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+      LOG(ERROR) << "Message truncated on fd " << fd;
+      bytesRead = -1;
     }
-  } // for
+    results.emplace_back(parseRecvMsg(msgs[i].msg_hdr, bytesRead));
+  }
+  return results;
+}
 
-  // build the source socket address from recvmsg data
-  folly::SocketAddress srcAddr{};
-  // this will throw if sender address was not filled in
-  srcAddr.setFromSockaddr(reinterpret_cast<struct sockaddr*>(&addrStorage));
+std::vector<std::pair<uint32_t, std::chrono::microseconds>>
+IoProvider::recvTxTimestamps(int fd, IoProvider* ioProvider) {
+  std::vector<std::pair<uint32_t, std::chrono::microseconds>> timestamps;
+
+  // drain whole error queue, bounded in case kernel keeps adding to it
+  for (int i = 0; i < kMaxTxTimestampsPerCall; ++i) {
+    RecvCtrlBuf u;
+    struct msghdr msg;
+    struct iovec entry;
+    sockaddr_storage addrStorage;
+    // timestamps are queued without packet data (SOF_TIMESTAMPING_OPT_TSONLY)
+    unsigned char buf[1];
+    prepareRecvMsg(msg, entry, u, addrStorage, buf, sizeof(buf));
+
+    if (ioProvider->recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      if (errno != EAGAIN and errno != EWOULDBLOCK) {
+        LOG(ERROR) << "Failed reading error queue on fd " << fd << ": "
+                   << folly::errnoStr(errno);
+      }
+      break;
+    }
 
-  DCHECK(ifIndex != -1) << "ifIndex is not found";
-  DCHECK(hopLimit) << "hopLimit is not found";
+    std::optional<uint32_t> id;
+    std::chrono::microseconds sentTs{0};
+    struct cmsghdr* cmsg{nullptr};
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET &&
+          cmsg->cmsg_type == SCM_TIMESTAMPING) {
+        sentTs = getTimestamping(cmsg);
+      } else if (
+          (cmsg->cmsg_level == IPPROTO_IPV6 &&
+           cmsg->cmsg_type == IPV6_RECVERR) ||
+          (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR)) {
+        struct sock_extended_err err;
+        memcpy(reinterpret_cast<void*>(&err), CMSG_DATA(cmsg), sizeof(err));
+        if (err.ee_errno == ENOMSG and
+            err.ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+          id = err.ee_data;
+        }
+      }
+    }
 
-  return std::make_tuple(bytesRead, ifIndex, srcAddr, hopLimit, recvTs);
+    if (id.has_value() and sentTs.count()) {
+      timestamps.emplace_back(*id, sentTs);
+    }
+  }
+  return timestamps;
 }
 
 ssize_t
@@ -195,46 +400,147 @@ IoProvider::sendMessage(
     std::string const& packet,
     IoProvider* ioProvider) {
   struct msghdr msg;
-  struct cmsghdr* cmsg{nullptr};
 
   // pack control buffer, aligned by control message hdr
-  union {
-    char cbuf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
-    struct cmsghdr align;
-  } u;
+  SendCtrlBuf u;
 
   // Set the destination address for the message
   sockaddr_storage addrStorage;
   dstAddr.getAddress(&addrStorage);
 
-  ::memset(&msg, 0, sizeof(msg));
-  msg.msg_name = reinterpret_cast<void*>(&addrStorage);
-  msg.msg_namelen = dstAddr.getActualSize();
+  // the IO vector for data to be sent
+  struct iovec entry;
 
-  // set the source address and source if index for this message
-  // this goes into ancilliary data fields
-  msg.msg_control = u.cbuf;
-  msg.msg_controllen = sizeof(u.cbuf);
-  cmsg = CMSG_FIRSTHDR(&msg);
+  prepareSendMsg(
+      msg,
+      entry,
+      u,
+      addrStorage,
+      dstAddr.getActualSize(),
+      ifIndex,
+      srcAddr,
+      packet);
 
-  cmsg->cmsg_level = IPPROTO_IPV6;
-  cmsg->cmsg_type = IPV6_PKTINFO;
-  cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
+  return ioProvider->sendmsg(fd, &msg, MSG_DONTWAIT);
+}
 
-  auto pktinfo = (struct in6_pktinfo*)CMSG_DATA(cmsg);
-  pktinfo->ipi6_ifindex = ifIndex;
-  ::memcpy(&pktinfo->ipi6_addr, srcAddr.bytes(), srcAddr.byteCount());
+std::vector<ssize_t>
+IoProvider::sendMessages(
+    int fd,
+    folly::SocketAddress dstAddr,
+    std::vector<std::tuple<
+        int /* ifIndex */,
+        folly::IPAddressV6 /* srcAddr */,
+        std::string /* packet */>> const& packets,
+    IoProvider* ioProvider) {
+  const auto numPackets = packets.size();
+  std::vector<ssize_t> bytesSent(numPackets, -1);
+  if (numPackets == 0) {
+    return bytesSent;
+  }
 
-  // the IO vector for data to be sent
-  struct iovec entry;
-  msg.msg_iov = &entry;
-  msg.msg_iovlen = 1;
+  // Set the destination address shared by all messages
+  sockaddr_storage addrStorage;
+  dstAddr.getAddress(&addrStorage);
 
-  // write the data here (we need to remove the const qualifier)
-  entry.iov_base = const_cast<char*>(packet.data());
-  entry.iov_len = packet.size();
+  std::vector<SendCtrlBuf> ctrlBufs(numPackets);
+  std::vector<struct mmsghdr> msgs(numPackets);
+  std::vector<struct iovec> entries(numPackets);
+
+  for (size_t i = 0; i < numPackets; ++i) {
+    auto const& [ifIndex, srcAddr, packet] = packets[i];
+    msgs[i].msg_len = 0;
+    prepareSendMsg(
+        msgs[i].msg_hdr,
+        entries[i],
+        ctrlBufs[i],
+        addrStorage,
+        dstAddr.getActualSize(),
+        ifIndex,
+        srcAddr,
+        packet);
+  }
 
-  return ioProvider->sendmsg(fd, &msg, MSG_DONTWAIT);
+  // Kernel stops at first message which fails to go out. Skip it and keep
+  // sending the rest so that one bad interface doesn't hold back others.
+  size_t next = 0;
+  while (next < numPackets) {
+    int numSent = ioProvider->sendmmsg(
+        fd, msgs.data() + next, numPackets - next, MSG_DONTWAIT);
+    if (numSent <= 0) {
+      VLOG(2) << "Failed sending message on fd " << fd << " due to error "
+              << folly::errnoStr(errno);
+      ++next;
+      continue;
+    }
+    for (int i = 0; i < numSent; ++i, ++next) {
+      bytesSent[next] = msgs[next].msg_len;
+    }
+  }
+  return bytesSent;
+}
+
+std::vector<struct sock_filter>
+IoProvider::buildIngressFilter(
+    std::vector<int> const& ifIndexes, int hopLimit) {
+  const uint32_t kAccept = std::numeric_limits<uint32_t>::max();
+  const uint32_t kDrop = 0;
+  // negative offsets of special loads, wrapped as the kernel expects them
+  const auto kHopLimitOff = static_cast<uint32_t>(
+      SKF_NET_OFF + static_cast<int>(offsetof(struct ip6_hdr, ip6_hlim)));
+  const auto kIfIndexOff = static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_IFINDEX);
+
+  // jumps are relative and at most 255 instructions long, so every ifIndex
+  // match is followed by its own accept
+  std::vector<struct sock_filter> program = {
+      // A <- hop limit of IPv6 header
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, kHopLimitOff),
+      BPF_JUMP(
+          BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(hopLimit), 1, 0),
+      BPF_STMT(BPF_RET | BPF_K, kDrop),
+      // A <- ifIndex of receiving interface
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, kIfIndexOff),
+  };
+  for (auto const ifIndex : ifIndexes) {
+    program.push_back(BPF_JUMP(
+        BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(ifIndex), 0, 1));
+    program.push_back(BPF_STMT(BPF_RET | BPF_K, kAccept));
+  }
+  program.push_back(BPF_STMT(BPF_RET | BPF_K, kDrop));
+  return program;
+}
+
+bool
+IoProvider::attachIngressFilter(
+    int fd,
+    std::vector<int> const& ifIndexes,
+    int hopLimit,
+    IoProvider* ioProvider) {
+  auto program = buildIngressFilter(ifIndexes, hopLimit);
+  if (program.size() <= BPF_MAXINSNS) {
+    struct sock_fprog fprog;
+    fprog.len = static_cast<unsigned short>(program.size());
+    fprog.filter = program.data();
+    if (ioProvider->setsockopt(
+            fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) == 0) {
+      return true;
+    }
+    LOG(ERROR) << "Failed attaching ingress filter on fd " << fd << ": "
+               << folly::errnoStr(errno);
+  } else {
+    LOG(ERROR) << "Ingress filter for " << ifIndexes.size()
+               << " interfaces exceeds " << BPF_MAXINSNS << " instructions";
+  }
+
+  // accept all, rather than dropping packets of interfaces left out
+  int unused = 0;
+  if (ioProvider->setsockopt(
+          fd, SOL_SOCKET, SO_DETACH_FILTER, &unused, sizeof(unused)) != 0 and
+      errno != ENOENT) {
+    LOG(ERROR) << "Failed detaching ingress filter on fd " << fd << ": "
+               << folly::errnoStr(errno);
+  }
+  return false;
 }
 
 } // namespace openr
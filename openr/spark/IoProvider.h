@@ -9,10 +9,14 @@
 
 #include <fcntl.h>
 #include <ifaddrs.h>
+#include <linux/filter.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <chrono>
+#include <optional>
+#include <tuple>
+#include <vector>
 
 #include <folly/IPAddress.h>
 #include <folly/SocketAddress.h>
@@ -59,22 +63,52 @@ class IoProvider {
 
   virtual ssize_t sendmsg(int sockfd, const struct msghdr* msg, int flags);
 
+  virtual int recvmmsg(
+      int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags);
+
+  virtual int sendmmsg(
+      int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags);
+
   virtual int setsockopt(
       int sockfd, int level, int optname, const void* optval, socklen_t optlen);
 
   // Utility functions that operate on sockets
 
-  /*
-   * Receive a message on fd, and return its size, interface index,
-   * and the source address
-   */
-  static std::tuple<
+  using RecvResult = std::tuple<
       ssize_t /* size */,
       int /* ifIndex */,
       folly::SocketAddress /* srcAddr */,
       int /* hopLimit */,
-      std::chrono::microseconds /* kernel timestamp */>
-  recvMessage(int fd, unsigned char* buf, int len, IoProvider* ioProvider);
+      std::chrono::microseconds /* kernel timestamp */>;
+
+  /*
+   * Receive a message on fd, and return its size, interface index,
+   * and the source address
+   */
+  static RecvResult recvMessage(
+      int fd, unsigned char* buf, int len, IoProvider* ioProvider);
+
+  /*
+   * Receive up to vlen messages on fd with a single call. `buf` must hold
+   * vlen * len bytes, i-th returned result describes the message written at
+   * buf + i * len. Truncated messages are reported with negative size. Returns
+   * no results if there is nothing to read.
+   */
+  static std::vector<RecvResult> recvMessages(
+      int fd,
+      unsigned char* buf,
+      int len,
+      unsigned int vlen,
+      IoProvider* ioProvider);
+
+  /*
+   * Read transmit timestamps queued on fd's error queue, when socket has
+   * SO_TIMESTAMPING enabled with SOF_TIMESTAMPING_OPT_ID. Returns the
+   * timestamp of every sent packet along with its id, which is the number of
+   * packets sent on the socket before it.
+   */
+  static std::vector<std::pair<uint32_t /* id */, std::chrono::microseconds>>
+  recvTxTimestamps(int fd, IoProvider* ioProvider);
 
   /*
    * Send message on fd via given interface to the address provided
@@ -88,7 +122,43 @@ class IoProvider {
       std::string const& packet,
       IoProvider* ioProvider);
 
+  /*
+   * Send all packets on fd to the same address with as few calls as possible,
+   * each via its own interface and source address. Returns the number of bytes
+   * sent for every packet, -1 for the ones which failed.
+   */
+  static std::vector<ssize_t> sendMessages(
+      int fd,
+      folly::SocketAddress dstAddr,
+      std::vector<std::tuple<
+          int /* ifIndex */,
+          folly::IPAddressV6 /* srcAddr */,
+          std::string /* packet */>> const& packets,
+      IoProvider* ioProvider);
+
+  /*
+   * Classic BPF program for an IPv6 UDP socket, accepting only packets which
+   * were received on one of ifIndexes and with the given hop limit. Others
+   * are dropped in the kernel, before being queued on the socket.
+   */
+  static std::vector<struct sock_filter> buildIngressFilter(
+      std::vector<int> const& ifIndexes, int hopLimit);
+
+  /*
+   * Attach buildIngressFilter() program to fd, replacing any attached before.
+   * If it can't be attached, e.g. it is too long, filter is removed from fd
+   * instead and false returned.
+   */
+  static bool attachIngressFilter(
+      int fd,
+      std::vector<int> const& ifIndexes,
+      int hopLimit,
+      IoProvider* ioProvider);
+
  private:
+  // bound on error queue messages read with one recvTxTimestamps call
+  static constexpr int kMaxTxTimestampsPerCall{64};
+
   IoProvider(IoProvider const&) = delete;
   IoProvider& operator=(IoProvider const&) = delete;
 };
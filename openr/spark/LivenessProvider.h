@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include <folly/IPAddressV6.h>
+
+namespace openr {
+
+/**
+ * Interface to an external liveness detection mechanism, e.g. a BFD daemon or
+ * a kernel/eBPF assisted echo session. Spark hands over its ESTABLISHED
+ * neighbors to it, to detect failures faster than heartbeat hold time allows
+ * without running fast user-space timers itself.
+ *
+ * Implementations must be thread-safe. Session down notifications may be
+ * delivered from any thread, but never after setSessionDownCallback(nullptr)
+ * returns.
+ */
+class LivenessProvider {
+ public:
+  struct Session {
+    // local interface the neighbor is on
+    std::string ifName;
+    int ifIndex{0};
+
+    // neighbor node name
+    std::string neighborName;
+
+    // link local addresses of both ends of the session
+    folly::IPAddressV6 localAddr;
+    folly::IPAddressV6 remoteAddr;
+
+    // requested failure detection time
+    std::chrono::milliseconds detectTime{0};
+  };
+
+  using SessionDownCallback = std::function<void(
+      std::string const& ifName, std::string const& neighborName)>;
+
+  virtual ~LivenessProvider() = default;
+
+  // register callback for sessions which lost liveness
+  virtual void setSessionDownCallback(SessionDownCallback callback) = 0;
+
+  // start monitoring liveness of neighbor, replacing an existing session of
+  // the same (ifName, neighborName)
+  virtual void addSession(Session const& session) = 0;
+
+  // stop monitoring liveness of neighbor, no-op for unknown sessions
+  virtual void removeSession(
+      std::string const& ifName, std::string const& neighborName) = 0;
+};
+
+} // namespace openr
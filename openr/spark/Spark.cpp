@@ -6,6 +6,7 @@
  */
 
 #include <ifaddrs.h>
+#include <linux/net_tstamp.h>
 #include <net/if.h>
 #include <netinet/in.h>
 
@@ -19,10 +20,12 @@
 #include <folly/fibers/FiberManagerMap.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
-#include <folly/gen/Base.h>
+#include <folly/hash/Hash.h>
+#include <folly/lang/Bits.h>
 
 #include <openr/common/Constants.h>
 #include <openr/common/NetworkUtil.h>
+#include <openr/common/StatHandle.h>
 #include <openr/common/Util.h>
 #include <openr/if/gen-cpp2/KvStore_constants.h>
 #include <openr/spark/Spark.h>
@@ -38,6 +41,11 @@ namespace {
 //
 const int kMinIpv6Mtu = 1280;
 
+//
+// Max number of packets received with a single call when socket is readable
+//
+const unsigned int kMaxRecvBatchSize = 32;
+
 //
 // The acceptable hop limit, assuming we send packets with this TTL
 //
@@ -46,6 +54,36 @@ const int kSparkHopLimit = 255;
 // number of restarting packets to send out per interface before I'm going down
 const int kNumRestartingPktSent = 3;
 
+// number of hellos per interface to keep transmit timestamps for. Neighbors
+// reflect the last hello they have received
+const size_t kMaxHelloTxTimesPerIface = 8;
+
+// bound on hellos waiting for their transmit timestamps
+const size_t kMaxPendingHellos = 1024;
+
+// transmit timestamp further than this away from user space send time
+// belongs to some other packet
+const std::chrono::microseconds kMaxTxTimeSkew = std::chrono::seconds(1);
+
+// layout of compact heartbeat, see Spark::CompactHeartbeat
+const uint8_t kCompactPacketMarker = 0;
+const uint8_t kCompactHeartbeatVersion = 1;
+const size_t kCompactHeartbeatSize = 24;
+
+// adaptive intervals: neighbor state changes within recent period shorten
+// intervals, afterwards they double once per stable period up to max factor
+const std::chrono::seconds kAdaptiveRecentPeriod{60};
+const std::chrono::seconds kAdaptiveStablePeriod{300};
+const int kAdaptiveMaxFactor{4};
+
+// bound on neighbors with cached area per interface, hellos from any name
+// can show up on a link
+const size_t kMaxNeighborAreaCacheSize = 1024;
+
+// config store key prefix of neighbors persisted across graceful restart,
+// suffixed with shard id
+const std::string kPersistedNeighborsKey{"spark-neighbors-"};
+
 //
 // Function to get current timestamp in microseconds using steady clock
 // NOTE: we use non-monotonic clock since kernel time-stamps do not support
@@ -127,11 +165,12 @@ const std::vector<std::vector<std::optional<SparkNeighState>>>
         /*
          * index 1 - WARM
          * HELLO_RCVD_INFO => NEGOTIATE;
+         * HEARTBEAT_RCVD => ESTABLISHED (restored neighbor only);
          */
         {SparkNeighState::NEGOTIATE,
          std::nullopt,
          std::nullopt,
-         std::nullopt,
+         SparkNeighState::ESTABLISHED,
          std::nullopt,
          std::nullopt,
          std::nullopt,
@@ -141,12 +180,13 @@ const std::vector<std::vector<std::optional<SparkNeighState>>>
          * index 2 - NEGOTIATE
          * HANDSHAKE_RCVD => ESTABLISHED; NEGOTIATE_TIMER_EXPIRE => WARM;
          * NEGOTIATION_FAILURE => WARM;
+         * HEARTBEAT_RCVD => ESTABLISHED (restored neighbor only);
          */
         {std::nullopt,
-         std::nullopt,
          std::nullopt,
          std::nullopt,
          SparkNeighState::ESTABLISHED,
+         SparkNeighState::ESTABLISHED,
          std::nullopt,
          SparkNeighState::WARM,
          std::nullopt,
@@ -224,14 +264,17 @@ Spark::SparkNeighbor::SparkNeighbor(
 
 Spark::Spark(
     std::optional<int> maybeIpTos,
-    messaging::RQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue,
+    messaging::RQueue<InterfaceDatabaseUpdate> interfaceUpdatesQueue,
     messaging::ReplicateQueue<thrift::SparkNeighborEvent>& neighborUpdatesQueue,
     KvStoreCmdPort kvStoreCmdPort,
     OpenrCtrlThriftPort openrCtrlThriftPort,
     std::shared_ptr<IoProvider> ioProvider,
     std::shared_ptr<const Config> config,
     std::pair<uint32_t, uint32_t> version,
-    std::optional<uint32_t> maybeMaxAllowedPps)
+    std::optional<uint32_t> maybeMaxAllowedPps,
+    uint32_t shardId,
+    std::shared_ptr<LivenessProvider> livenessProvider,
+    PersistentStore* configStore)
     : myDomainName_(*config->getConfig().domain_ref()),
       myNodeName_(config->getNodeName()),
       neighborDiscoveryPort_(static_cast<uint16_t>(
@@ -251,11 +294,29 @@ Spark::Spark(
       gracefulRestartTime_(std::chrono::seconds(
           *config->getSparkConfig().graceful_restart_time_s_ref())),
       enableV4_(config->isV4Enabled()),
+      timestampingMode_(*config->getSparkConfig().timestamping_mode_ref()),
+      enableCompactHeartbeat_(
+          *config->getSparkConfig().enable_compact_heartbeat_ref()),
+      numShards_(static_cast<uint32_t>(
+          *config->getSparkConfig().num_shards_ref())),
+      shardId_(shardId),
+      enableAdaptiveIntervals_(
+          *config->getSparkConfig().enable_adaptive_intervals_ref()),
+      enableIngressFilter_(
+          *config->getSparkConfig().enable_ingress_filter_ref()),
+      enableRestartResync_(
+          *config->getSparkConfig().enable_restart_resync_ref() and
+          configStore != nullptr),
+      configStore_(configStore),
+      myHeartbeatSenderId_(folly::hash::fnv32(config->getNodeName())),
       neighborUpdatesQueue_(neighborUpdatesQueue),
       kKvStoreCmdPort_(kvStoreCmdPort),
       kOpenrCtrlThriftPort_(openrCtrlThriftPort),
       kVersion_(apache::thrift::FRAGILE, version.first, version.second),
       ioProvider_(std::move(ioProvider)),
+      livenessProvider_(std::move(livenessProvider)),
+      livenessDetectTime_(std::chrono::milliseconds(
+          *config->getSparkConfig().liveness_detect_time_ms_ref())),
       config_(std::move(config)) {
   CHECK(gracefulRestartTime_ >= 3 * keepAliveTime_)
       << "Keep-alive-time must be less than hold-time.";
@@ -268,17 +329,32 @@ Spark::Spark(
   CHECK(fastInitHelloTime_ <= helloTime_)
       << "fastInit helloMsg interval must be smaller than normal interval";
   CHECK(ioProvider_) << "Got null IoProvider";
+  CHECK_LT(shardId_, numShards_) << "Invalid Spark shard " << shardId_;
+
+  recvBuf_.resize(kMaxRecvBatchSize * kMinIpv6Mtu);
+
+  // Liveness sessions are only used with a detect time configured
+  if (livenessDetectTime_ == std::chrono::milliseconds(0)) {
+    livenessProvider_.reset();
+  }
+  if (livenessProvider_) {
+    livenessProvider_->setSessionDownCallback(
+        [this](std::string const& ifName, std::string const& neighborName) {
+          runInEventBaseThread([this, ifName, neighborName]() noexcept {
+            processLivenessDown(ifName, neighborName);
+          });
+        });
+  }
 
-  // Initialize list of BucketedTimeSeries
-  const std::chrono::seconds sec{1};
+  // Initialize table of rate limiters
   if (maybeMaxAllowedPps) {
     maybeMaxAllowedPps_ = maybeMaxAllowedPps;
-    const int32_t numBuckets = *maybeMaxAllowedPps_ / 3;
-    for (size_t i = 0; i < Constants::kNumTimeSeries; i++) {
-      timeSeriesVector_.emplace_back(
-          folly::BucketedTimeSeries<int64_t, std::chrono::steady_clock>(
-              numBuckets, sec));
-    }
+    helloRateLimiters_.resize(Constants::kNumTimeSeries);
+  }
+
+  // Neighbors must be known before first interface is added
+  if (enableRestartResync_) {
+    loadPersistedNeighbors();
   }
 
   // Fiber to process interface updates from LinkMonitor
@@ -312,6 +388,7 @@ Spark::Spark(
   fb303::fbData->addStatExportType(
       "slo.neighbor_discovery.time_ms", fb303::AVG);
   fb303::fbData->addStatExportType("slo.neighbor_restart.time_ms", fb303::AVG);
+  fb303::fbData->addStatExportType("slo.neighbor_resync.time_ms", fb303::AVG);
 }
 
 // static util function to transform state into str
@@ -339,6 +416,18 @@ void
 Spark::stop() {
   // NOTE: explicitly wait for msg to send out before going down
   floodRestartingMsg().get();
+
+  // take back liveness detection, no callbacks into Spark after this
+  if (livenessProvider_) {
+    getEvb()->runInEventBaseThreadAndWait([this]() {
+      for (auto const& [ifName, neighbors] : sparkNeighbors_) {
+        for (auto const& [neighborName, _] : neighbors) {
+          stopLivenessSession(ifName, neighborName);
+        }
+      }
+    });
+    livenessProvider_->setSessionDownCallback(nullptr);
+  }
   OpenrEventBase::stop();
 }
 
@@ -443,9 +532,30 @@ Spark::prepareSocket(std::optional<int> maybeIpTos) noexcept {
                << folly::errnoStr(errno);
   }
 
+  // enable receive and transmit timestamping for this socket. Timestamps of
+  // sent packets are queued on socket error queue, tagged with packet id
+  if (timestampingMode_ != thrift::SparkTimestampingMode::KERNEL_RX) {
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE |
+        SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID |
+        SOF_TIMESTAMPING_OPT_TSONLY;
+    if (timestampingMode_ == thrift::SparkTimestampingMode::HARDWARE) {
+      flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_TX_HARDWARE |
+          SOF_TIMESTAMPING_RAW_HARDWARE;
+    }
+    if (ioProvider_->setsockopt(
+            fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0) {
+      LOG(ERROR) << "Failed to enable transmit timestamping. Falling back to "
+                 << "kernel receive timestamps. Error: "
+                 << folly::errnoStr(errno);
+    } else {
+      txTimestampingEnabled_ = true;
+    }
+  }
+
   // enable timestamping for this socket
   const int enabled = 1;
-  if (ioProvider_->setsockopt(
+  if (not txTimestampingEnabled_ and
+      ioProvider_->setsockopt(
           fd, SOL_SOCKET, SO_TIMESTAMPNS, &enabled, sizeof(enabled)) != 0) {
     LOG(ERROR) << "Failed to enable kernel timestamping. Measured RTTs are "
                << "likely to have more noise in them. Error: "
@@ -465,12 +575,19 @@ Spark::prepareSocket(std::optional<int> maybeIpTos) noexcept {
   });
 
   // update counters every few seconds
-  counterUpdateTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
+  counterUpdateTimer_ = WheelTimeout::make(*getEvb(), [this]() noexcept {
     updateGlobalCounters();
     // Schedule next counters update
     counterUpdateTimer_->scheduleTimeout(Constants::kCounterSubmitInterval);
   });
   counterUpdateTimer_->scheduleTimeout(Constants::kCounterSubmitInterval);
+
+  // send heartbeats periodically on all interfaces with active neighbors
+  heartbeatTimer_ = WheelTimeout::make(*getEvb(), [this]() noexcept {
+    sendHeartbeatMsgs();
+    scheduleHeartbeatTimer();
+  });
+  heartbeatTimer_->scheduleTimeout(keepAliveTime_);
 }
 
 PacketValidationResult
@@ -510,43 +627,52 @@ Spark::sanityCheckHelloPkt(
 }
 
 bool
-Spark::shouldProcessHelloPacket(
-    std::string const& ifName, folly::IPAddress const& addr) {
+Spark::shouldProcessHelloPacket(int ifIndex, folly::IPAddress const& addr) {
   if (not maybeMaxAllowedPps_.has_value()) {
     return true; // no rate limit
   }
 
-  size_t index = std::hash<std::tuple<std::string, folly::IPAddress>>{}(
-                     std::make_tuple(ifName, addr)) %
-      Constants::kNumTimeSeries;
-  // check our timeseries to see if we want to process anymore right now
-  timeSeriesVector_[index].update(std::chrono::steady_clock::now());
+  const size_t index = folly::hash::hash_combine(ifIndex, addr.hash()) %
+      helloRateLimiters_.size();
+  auto& limiter = helloRateLimiters_[index];
+
+  // refill tokens for the time elapsed since last packet. Bucket starts full
+  // as lastRefill is at the clock's epoch initially.
+  const auto now = std::chrono::steady_clock::now();
+  const double maxTokens = *maybeMaxAllowedPps_;
+  limiter.tokens = std::min(
+      maxTokens,
+      limiter.tokens +
+          maxTokens *
+              std::chrono::duration<double>(now - limiter.lastRefill).count());
+  limiter.lastRefill = now;
 
-  if (timeSeriesVector_[index].count() > *maybeMaxAllowedPps_) {
+  if (limiter.tokens < 1) {
     // drop the packet
     return false;
   }
   // otherwise, count this packet and process it
-  timeSeriesVector_[index].addValue(std::chrono::steady_clock::now(), 1);
-
+  limiter.tokens -= 1;
   return true;
 }
 
 bool
 Spark::parsePacket(
+    IoProvider::RecvResult const& recvResult,
+    const uint8_t* buf,
     thrift::SparkHelloPacket& pkt,
+    std::optional<CompactHeartbeat>& compactHeartbeat,
     std::string& ifName,
     std::chrono::microseconds& recvTime) {
-  // the read buffer
-  uint8_t buf[kMinIpv6Mtu];
-
   ssize_t bytesRead;
   int ifIndex;
   folly::SocketAddress clientAddr;
   int hopLimit;
 
-  std::tie(bytesRead, ifIndex, clientAddr, hopLimit, recvTime) =
-      IoProvider::recvMessage(mcastFd_, buf, kMinIpv6Mtu, ioProvider_.get());
+  std::tie(bytesRead, ifIndex, clientAddr, hopLimit, recvTime) = recvResult;
+
+  static const StatHandle kHelloPacketRecv(
+      "spark.hello_packet_recv", fb303::SUM);
 
   if (hopLimit < kSparkHopLimit) {
     LOG(ERROR) << "Rejecting packet from " << clientAddr.getAddressStr()
@@ -554,7 +680,29 @@ Spark::parsePacket(
     return false;
   }
 
+  // Rate limit first, so that floods are dropped at least possible cost
+  if (!shouldProcessHelloPacket(ifIndex, clientAddr.getIPAddress())) {
+    FB_LOG_EVERY_MS(ERROR, 1000)
+        << "Spark: dropping hello packets due to rate limiting on ifindex: "
+        << ifIndex << " from addr: " << clientAddr.getAddressStr();
+    static const StatHandle kHelloPacketDropped(
+        "spark.hello_packet_dropped", fb303::SUM);
+    kHelloPacketRecv.addValue(1);
+    kHelloPacketDropped.addValue(1);
+    if (ifIndexToName_.count(ifIndex)) {
+      ++ifIndexToDroppedPackets_[ifIndex];
+    }
+    return false;
+  }
+
   auto res = findInterfaceFromIfindex(ifIndex);
+  if (!res.has_value() and otherShardIfIndexes_.count(ifIndex)) {
+    VLOG(4) << "Ignoring packet on ifindex " << ifIndex
+            << " owned by another Spark shard";
+    fb303::fbData->addStatValue(
+        "spark.hello_packet_other_shard", 1, fb303::SUM);
+    return false;
+  }
   if (!res.has_value()) {
     LOG(ERROR) << "Received packet from " << clientAddr.getAddressStr()
                << " on unknown interface with index " << ifIndex
@@ -568,20 +716,16 @@ Spark::parsePacket(
           << " from " << clientAddr.getAddressStr();
 
   // update counters for packets received, dropped and processed
-  fb303::fbData->addStatValue("spark.hello_packet_recv", 1, fb303::SUM);
+  kHelloPacketRecv.addValue(1);
 
   // update counters for total size of packets received
-  fb303::fbData->addStatValue(
-      "spark.hello_packet_recv_size", bytesRead, fb303::SUM);
+  static const StatHandle kHelloPacketRecvSize(
+      "spark.hello_packet_recv_size", fb303::SUM);
+  kHelloPacketRecvSize.addValue(bytesRead);
 
-  if (!shouldProcessHelloPacket(ifName, clientAddr.getIPAddress())) {
-    LOG(ERROR) << "Spark: dropping hello packet due to rate limiting on iface: "
-               << ifName << " from addr: " << clientAddr.getAddressStr();
-    fb303::fbData->addStatValue("spark.hello_packet_dropped", 1, fb303::SUM);
-    return false;
-  }
-
-  fb303::fbData->addStatValue("spark.hello_packet_processed", 1, fb303::SUM);
+  static const StatHandle kHelloPacketProcessed(
+      "spark.hello_packet_processed", fb303::SUM);
+  kHelloPacketProcessed.addValue(1);
 
   if (bytesRead >= 0) {
     VLOG(4) << "Read a total of " << bytesRead << " bytes from fd " << mcastFd_;
@@ -592,11 +736,22 @@ Spark::parsePacket(
       return false;
     }
   } else {
-    LOG(ERROR) << "Failed reading from fd " << mcastFd_ << " error "
-               << folly::errnoStr(errno);
+    LOG(ERROR) << "Message from " << clientAddr.getAddressStr()
+               << " has been truncated";
     return false;
   }
 
+  // Compact heartbeats are decoded in place, without any copy
+  if (isCompactPacket(buf, bytesRead)) {
+    compactHeartbeat = decodeCompactHeartbeat(buf, bytesRead);
+    if (not compactHeartbeat.has_value()) {
+      LOG(INFO) << "Malformed or unsupported compact packet from "
+                << clientAddr.getAddressStr();
+      return false;
+    }
+    return true;
+  }
+
   // Copy buffer into string object and parse it into helloPacket.
   std::string readBuf(reinterpret_cast<const char*>(&buf[0]), bytesRead);
   try {
@@ -709,6 +864,7 @@ Spark::updateNeighborRtt(
 
   // Measure only if neighbor is reflecting our previous hello packet.
   auto rtt = (myRecvTime - mySentTime) - (nbrSentTime - nbrRecvTime);
+  const auto rttSample = rtt;
   VLOG(3) << "Measured new RTT for neighbor " << neighborName
           << " from remote iface " << remoteIfName << " over interface "
           << ifName << " as " << rtt.count() / 1000.0 << "ms.";
@@ -752,6 +908,15 @@ Spark::updateNeighborRtt(
       }
       // Update rttLatest
       sparkNeighbor.rttLatest = rtt;
+
+      // Update jitter with deviation from previous sample
+      if (sparkNeighbor.rttSample.count()) {
+        const auto deviation = rttSample > sparkNeighbor.rttSample
+            ? rttSample - sparkNeighbor.rttSample
+            : sparkNeighbor.rttSample - rttSample;
+        sparkNeighbor.rttJitter += (deviation - sparkNeighbor.rttJitter) / 16;
+      }
+      sparkNeighbor.rttSample = rttSample;
     }
   }
 }
@@ -787,6 +952,10 @@ Spark::sendHandshakeMsg(
   *handshakeMsg.area_ref() =
       neighborAreaId; // send neighborAreaId deduced locally
   handshakeMsg.neighborNodeName_ref() = neighborName;
+  if (enableCompactHeartbeat_) {
+    handshakeMsg.compactHeartbeatVersion_ref() = kCompactHeartbeatVersion;
+    handshakeMsg.heartbeatSenderId_ref() = myHeartbeatSenderId_;
+  }
 
   thrift::SparkHelloPacket pkt;
   pkt.handshakeMsg_ref() = std::move(handshakeMsg);
@@ -812,6 +981,8 @@ Spark::sendHandshakeMsg(
     return;
   }
 
+  recordPacketSent();
+
   // update counters for number of pkts and total size of pkts sent
   fb303::fbData->addStatValue(
       "spark.handshake.bytes_sent", packet.size(), fb303::SUM);
@@ -819,63 +990,293 @@ Spark::sendHandshakeMsg(
 }
 
 void
-Spark::sendHeartbeatMsg(std::string const& ifName) {
-  SCOPE_EXIT {
-    // increment seq# after packet has been sent (even if it didnt go out)
-    ++mySeqNum_;
-  };
+Spark::sendHeartbeatMsgs() {
+  // build heartbeat packet for every interface with active neighbors
+  std::vector<std::tuple<int, folly::IPAddressV6, std::string>> packets;
+  std::vector<std::string> ifNames;
+  auto const now = std::chrono::steady_clock::now();
+  for (auto const& kv : ifNameToActiveNeighbors_) {
+    auto const& ifName = kv.first;
+    auto interfaceIt = interfaceDb_.find(ifName);
+    if (interfaceIt == interfaceDb_.end()) {
+      continue;
+    }
 
-  SCOPE_FAIL {
-    LOG(ERROR) << "Failed sending Heartbeat packet on " << ifName;
-  };
+    // with adaptive intervals, interfaces get due at different times
+    auto adaptiveIt = ifNameToAdaptiveState_.find(ifName);
+    if (adaptiveIt != ifNameToAdaptiveState_.end()) {
+      if (adaptiveIt->second.nextHeartbeat > now) {
+        continue;
+      }
+      adaptiveIt->second.nextHeartbeat = now + getKeepAliveTime(ifName);
+    }
 
-  if (ifNameToActiveNeighbors_.find(ifName) == ifNameToActiveNeighbors_.end()) {
-    VLOG(3) << "Interface: " << ifName
-            << " hasn't have any active neighbor yet."
-            << " Skip sending out heartbeatMsg.";
-    return;
-  }
+    // in some cases, getting link-local address may fail
+    // e.g. when iface has not yet auto-configured it, or iface is removed but
+    // down event has not arrived yet
+    const auto& interfaceEntry = interfaceIt->second;
+    const auto ifIndex = interfaceEntry.ifIndex;
+    const auto v6Addr = interfaceEntry.v6LinkLocalNetwork.first;
+    if (not v6Addr.isV6()) {
+      LOG(ERROR) << "Failed sending Heartbeat packet on " << ifName
+                 << ", no v6 link-local address";
+      continue;
+    }
 
-  // in some cases, getting link-local address may fail and throw
-  // e.g. when iface has not yet auto-configured it, or iface is removed but
-  // down event has not arrived yet
-  const auto& interfaceEntry = interfaceDb_.at(ifName);
-  const auto ifIndex = interfaceEntry.ifIndex;
-  const auto v6Addr = interfaceEntry.v6LinkLocalNetwork.first;
+    // use compact encoding only if every adjacent neighbor can decode it,
+    // others on the link aren't processing heartbeats yet
+    bool compact = enableCompactHeartbeat_;
+    auto const& ifNeighbors = sparkNeighbors_.at(ifName);
+    for (auto const& neighborName : kv.second) {
+      auto neighborIt = ifNeighbors.find(neighborName);
+      if (neighborIt == ifNeighbors.end() or
+          not neighborIt->second.acceptsCompactHeartbeat) {
+        compact = false;
+        break;
+      }
+    }
 
-  // build heartbeat msg
-  thrift::SparkHeartbeatMsg heartbeatMsg;
-  *heartbeatMsg.nodeName_ref() = myNodeName_;
-  heartbeatMsg.seqNum_ref() = mySeqNum_;
+    std::string packet;
+    if (compact) {
+      // increment seq# for every packet (even if it doesnt go out)
+      packet = encodeCompactHeartbeat(CompactHeartbeat{
+          myHeartbeatSenderId_, mySeqNum_++, getCurrentTimeInUs()});
+      fb303::fbData->addStatValue(
+          "spark.heartbeat.compact_packets_sent", 1, fb303::SUM);
+    } else {
+      // build heartbeat msg
+      thrift::SparkHeartbeatMsg heartbeatMsg;
+      *heartbeatMsg.nodeName_ref() = myNodeName_;
+      // increment seq# for every packet (even if it doesnt go out)
+      heartbeatMsg.seqNum_ref() = mySeqNum_++;
+
+      thrift::SparkHelloPacket pkt;
+      pkt.heartbeatMsg_ref() = std::move(heartbeatMsg);
+
+      packet = fbzmq::util::writeThriftObjStr(pkt, serializer_);
+    }
+    if (kMinIpv6Mtu < packet.size()) {
+      LOG(ERROR) << "Heartbeat packet is too big, can't send it out.";
+      continue;
+    }
 
-  thrift::SparkHelloPacket pkt;
-  pkt.heartbeatMsg_ref() = std::move(heartbeatMsg);
+    packets.emplace_back(ifIndex, v6Addr.asV6(), std::move(packet));
+    ifNames.emplace_back(ifName);
+  }
 
-  auto packet = fbzmq::util::writeThriftObjStr(pkt, serializer_);
+  if (packets.empty()) {
+    VLOG(3) << "No interface has active neighbor yet."
+            << " Skip sending out heartbeatMsg.";
+    return;
+  }
 
-  // send the pkt
+  // send all pkts at once
   folly::SocketAddress dstAddr(
       folly::IPAddress(Constants::kSparkMcastAddr.toString()),
       neighborDiscoveryPort_);
 
-  if (kMinIpv6Mtu < packet.size()) {
-    LOG(ERROR) << "Handshake packet is too big, can't send it out.";
+  const auto bytesSent = IoProvider::sendMessages(
+      mcastFd_, dstAddr, packets, ioProvider_.get());
+
+  for (size_t i = 0; i < packets.size(); ++i) {
+    const auto packetSize = std::get<2>(packets[i]).size();
+    if ((bytesSent[i] < 0) or
+        (static_cast<size_t>(bytesSent[i]) != packetSize)) {
+      VLOG(1) << "Sending multicast to " << dstAddr.getAddressStr() << " on "
+              << ifNames[i] << " failed";
+      continue;
+    }
+
+    recordPacketSent();
+
+    // update counters for number of pkts and total size of pkts sent
+    fb303::fbData->addStatValue(
+        "spark.heartbeat.bytes_sent", packetSize, fb303::SUM);
+    fb303::fbData->addStatValue("spark.heartbeat.packets_sent", 1, fb303::SUM);
+  }
+}
+
+void
+Spark::scheduleHeartbeatTimer() {
+  if (not enableAdaptiveIntervals_) {
+    heartbeatTimer_->scheduleTimeout(keepAliveTime_);
     return;
   }
 
-  auto bytesSent = IoProvider::sendMessage(
-      mcastFd_, ifIndex, v6Addr.asV6(), dstAddr, packet, ioProvider_.get());
+  // interfaces becoming active go through state change, which reschedules.
+  // So wake up no earlier than needed by current active interfaces.
+  auto timeout = keepAliveTime_ * kAdaptiveMaxFactor;
+  auto const now = std::chrono::steady_clock::now();
+  for (auto const& kv : ifNameToActiveNeighbors_) {
+    auto adaptiveIt = ifNameToAdaptiveState_.find(kv.first);
+    if (adaptiveIt == ifNameToAdaptiveState_.end()) {
+      continue;
+    }
+    timeout = std::min(
+        timeout,
+        std::max(
+            std::chrono::milliseconds(0),
+            std::chrono::ceil<std::chrono::milliseconds>(
+                adaptiveIt->second.nextHeartbeat - now)));
+  }
+  heartbeatTimer_->scheduleTimeout(timeout);
+}
 
-  if ((bytesSent < 0) || (static_cast<size_t>(bytesSent) != packet.size())) {
-    VLOG(1) << "Sending multicast to " << dstAddr.getAddressStr() << " on "
-            << ifName << " failed due to error " << folly::errnoStr(errno);
+std::chrono::milliseconds
+Spark::getHelloTime(std::string const& ifName) const {
+  auto adaptiveIt = ifNameToAdaptiveState_.find(ifName);
+  if (adaptiveIt == ifNameToAdaptiveState_.end()) {
+    return helloTime_;
+  }
+
+  // hellos don't keep adjacencies alive, no bound from hold time needed
+  return getAdaptiveInterval(
+      helloTime_,
+      std::chrono::steady_clock::now() - adaptiveIt->second.lastStateChange,
+      helloTime_ * kAdaptiveMaxFactor);
+}
+
+std::chrono::milliseconds
+Spark::getKeepAliveTime(std::string const& ifName) const {
+  auto adaptiveIt = ifNameToAdaptiveState_.find(ifName);
+  if (adaptiveIt == ifNameToAdaptiveState_.end()) {
+    return keepAliveTime_;
+  }
+
+  // neighbors expect heartbeat within hold time negotiated with them, leave
+  // room for two losses in a row as with default configured intervals
+  auto holdTime = holdTime_;
+  for (auto const& kv : sparkNeighbors_.at(ifName)) {
+    auto const& neighbor = kv.second;
+    if (neighbor.state == SparkNeighState::ESTABLISHED) {
+      holdTime = std::min(holdTime, neighbor.heartbeatHoldTime);
+    }
+  }
+  return getAdaptiveInterval(
+      keepAliveTime_,
+      std::chrono::steady_clock::now() - adaptiveIt->second.lastStateChange,
+      holdTime / 3);
+}
+
+void
+Spark::processAdaptiveStateChange(std::string const& ifName) {
+  auto adaptiveIt = ifNameToAdaptiveState_.find(ifName);
+  if (adaptiveIt == ifNameToAdaptiveState_.end()) {
     return;
   }
 
-  // update counters for number of pkts and total size of pkts sent
-  fb303::fbData->addStatValue(
-      "spark.heartbeat.bytes_sent", packet.size(), fb303::SUM);
-  fb303::fbData->addStatValue("spark.heartbeat.packets_sent", 1, fb303::SUM);
+  auto& state = adaptiveIt->second;
+  auto const now = std::chrono::steady_clock::now();
+  state.lastStateChange = now;
+
+  auto const nextHello = now + getHelloTime(ifName);
+  if (nextHello < state.nextHello) {
+    state.nextHello = nextHello;
+    ifNameToHelloTimers_.at(ifName)->scheduleTimeout(
+        std::chrono::ceil<std::chrono::milliseconds>(nextHello - now));
+  }
+
+  state.nextHeartbeat =
+      std::min(state.nextHeartbeat, now + getKeepAliveTime(ifName));
+  scheduleHeartbeatTimer();
+}
+
+// static
+std::chrono::milliseconds
+Spark::getAdaptiveInterval(
+    std::chrono::milliseconds baseInterval,
+    std::chrono::steady_clock::duration stableFor,
+    std::chrono::milliseconds maxInterval) {
+  if (stableFor < kAdaptiveRecentPeriod) {
+    return baseInterval / 2;
+  }
+
+  int factor = 1;
+  for (auto period = kAdaptiveStablePeriod;
+       stableFor >= period and factor < kAdaptiveMaxFactor;
+       period += kAdaptiveStablePeriod) {
+    factor *= 2;
+  }
+  return std::max(baseInterval, std::min(baseInterval * factor, maxInterval));
+}
+
+void
+Spark::recordPacketSent(
+    std::string const& ifName,
+    std::optional<std::chrono::microseconds> helloSentTime) {
+  if (not txTimestampingEnabled_) {
+    return;
+  }
+
+  const auto txTimestampId = txTimestampId_++;
+  if (not helloSentTime.has_value()) {
+    return;
+  }
+  pendingHellos_.push_back(PendingHello{txTimestampId, ifName, *helloSentTime});
+  if (pendingHellos_.size() > kMaxPendingHellos) {
+    pendingHellos_.pop_front();
+  }
+}
+
+void
+Spark::processTxTimestamps() {
+  for (auto const& [id, txTime] :
+       IoProvider::recvTxTimestamps(mcastFd_, ioProvider_.get())) {
+    // timestamps arrive in send order, earlier hellos won't get one. Compare
+    // in serial number arithmetic as ids wrap around
+    while (not pendingHellos_.empty() and
+           static_cast<int32_t>(id - pendingHellos_.front().txTimestampId) >
+               0) {
+      pendingHellos_.pop_front();
+    }
+    if (pendingHellos_.empty() or
+        pendingHellos_.front().txTimestampId != id) {
+      continue; // not a hello
+    }
+
+    auto hello = std::move(pendingHellos_.front());
+    pendingHellos_.pop_front();
+    if (interfaceDb_.count(hello.ifName) == 0) {
+      continue;
+    }
+
+    // sanity check, packet ids counted by us may drift from the kernel ones
+    // if sending failed after kernel assigned one
+    const auto skew = txTime > hello.sentTime ? txTime - hello.sentTime
+                                              : hello.sentTime - txTime;
+    if (skew > kMaxTxTimeSkew) {
+      LOG(WARNING) << "Ignoring transmit timestamp of hello on "
+                   << hello.ifName << ", " << skew.count()
+                   << "us away from send time";
+      fb303::fbData->addStatValue(
+          "spark.hello.tx_timestamp_mismatch", 1, fb303::SUM);
+      continue;
+    }
+
+    VLOG(4) << "Hello on " << hello.ifName << " got transmitted "
+            << (txTime - hello.sentTime).count() << "us after send call";
+    fb303::fbData->addStatValue(
+        "spark.hello.tx_delay_us",
+        (txTime - hello.sentTime).count(),
+        fb303::AVG);
+
+    auto& txTimes = helloTxTimes_[hello.ifName];
+    txTimes[hello.sentTime] = txTime;
+    if (txTimes.size() > kMaxHelloTxTimesPerIface) {
+      txTimes.erase(txTimes.begin());
+    }
+  }
+}
+
+std::chrono::microseconds
+Spark::getHelloTxTime(
+    std::string const& ifName, std::chrono::microseconds helloSentTime) {
+  auto ifIt = helloTxTimes_.find(ifName);
+  if (ifIt == helloTxTimes_.end()) {
+    return helloSentTime;
+  }
+  auto it = ifIt->second.find(helloSentTime);
+  return it != ifIt->second.end() ? it->second : helloSentTime;
 }
 
 void
@@ -931,6 +1332,8 @@ Spark::logStateTransition(
     // reset neighbor restart time
     neighbor.restartStateTransitionTime = std::chrono::steady_clock::now();
   }
+
+  processAdaptiveStateChange(ifName);
 }
 
 void
@@ -985,7 +1388,14 @@ Spark::floodRestartingMsg() {
     }
     LOG(INFO) << "Successfully sent restarting msg to: " << interfaceDb_.size()
               << " neighbors, ready to go down";
-    p.setValue();
+    if (not enableRestartResync_) {
+      p.setValue();
+      return;
+    }
+    persistNeighbors().via(getEvb()).thenTry(
+        [p = std::move(p)](folly::Try<folly::Unit>&&) mutable {
+          p.setValue();
+        });
   });
   return sf;
 }
@@ -1012,6 +1422,9 @@ Spark::neighborUpWrapper(
     SparkNeighbor& neighbor,
     std::string const& ifName,
     std::string const& neighborName) {
+  // verified one way or the other
+  neighbor.restored = false;
+
   // stop sending out handshake msg, no longer in NEGOTIATE stage
   neighbor.negotiateTimer.reset();
 
@@ -1019,7 +1432,7 @@ Spark::neighborUpWrapper(
   neighbor.negotiateHoldTimer.reset();
 
   // create heartbeat hold timer when promote to "ESTABLISHED"
-  neighbor.heartbeatHoldTimer = folly::AsyncTimeout::make(
+  neighbor.heartbeatHoldTimer = WheelTimeout::make(
       *getEvb(), [this, ifName, neighborName]() noexcept {
         processHeartbeatTimeout(ifName, neighborName);
       });
@@ -1027,6 +1440,11 @@ Spark::neighborUpWrapper(
 
   // add neighborName to collection
   ifNameToActiveNeighbors_[ifName].emplace(neighborName);
+  if (enableAdaptiveIntervals_) {
+    scheduleHeartbeatTimer();
+  }
+
+  startLivenessSession(neighbor, ifName);
 
   // notify LinkMonitor about neighbor UP state
   notifySparkNeighborEvent(
@@ -1038,6 +1456,8 @@ Spark::neighborDownWrapper(
     SparkNeighbor const& neighbor,
     std::string const& ifName,
     std::string const& neighborName) {
+  stopLivenessSession(ifName, neighborName);
+
   // notify LinkMonitor about neighbor DOWN state
   notifySparkNeighborEvent(
       thrift::SparkNeighborEventType::NEIGHBOR_DOWN, neighbor.toThrift());
@@ -1093,6 +1513,58 @@ Spark::processHeartbeatTimeout(
   neighborDownWrapper(neighbor, ifName, neighborName);
 }
 
+void
+Spark::startLivenessSession(
+    SparkNeighbor const& neighbor, std::string const& ifName) {
+  if (not livenessProvider_) {
+    return;
+  }
+
+  auto const& interface = interfaceDb_.at(ifName);
+  LivenessProvider::Session session;
+  session.ifName = ifName;
+  session.ifIndex = interface.ifIndex;
+  session.neighborName = neighbor.nodeName;
+  session.localAddr = interface.v6LinkLocalNetwork.first.asV6();
+  session.remoteAddr = toIPAddress(neighbor.transportAddressV6).asV6();
+  session.detectTime = livenessDetectTime_;
+
+  VLOG(1) << "Starting liveness session with " << neighbor.nodeName << " on "
+          << ifName << ", detect time " << livenessDetectTime_.count() << "ms";
+  livenessProvider_->addSession(session);
+}
+
+void
+Spark::stopLivenessSession(
+    std::string const& ifName, std::string const& neighborName) {
+  if (not livenessProvider_) {
+    return;
+  }
+  livenessProvider_->removeSession(ifName, neighborName);
+}
+
+void
+Spark::processLivenessDown(
+    std::string const& ifName, std::string const& neighborName) {
+  // neighbor may be gone or restarting already, then session is stale
+  auto ifIt = sparkNeighbors_.find(ifName);
+  if (ifIt == sparkNeighbors_.end()) {
+    return;
+  }
+  auto neighborIt = ifIt->second.find(neighborName);
+  if (neighborIt == ifIt->second.end() or
+      neighborIt->second.state != SparkNeighState::ESTABLISHED) {
+    return;
+  }
+
+  LOG(INFO) << "Liveness session went down for: " << neighborName
+            << " on interface " << ifName;
+  fb303::fbData->addStatValue("spark.neighbor_liveness_down", 1, fb303::SUM);
+
+  // same as if heartbeats stopped, bring the neighbor down right away
+  processHeartbeatTimeout(ifName, neighborName);
+}
+
 void
 Spark::processNegotiateTimeout(
     std::string const& ifName, std::string const& neighborName) {
@@ -1154,7 +1626,7 @@ Spark::processGRMsg(
       thrift::SparkNeighborEventType::NEIGHBOR_RESTARTING, neighbor.toThrift());
 
   // start graceful-restart timer
-  neighbor.gracefulRestartHoldTimer = folly::AsyncTimeout::make(
+  neighbor.gracefulRestartHoldTimer = WheelTimeout::make(
       *getEvb(), [this, ifName, neighborName]() noexcept {
         // change the state back to IDLE
         processGRTimeout(ifName, neighborName);
@@ -1167,8 +1639,10 @@ Spark::processGRMsg(
   neighbor.state = getNextState(oldState, SparkNeighEvent::HELLO_RCVD_RESTART);
   logStateTransition(neighborName, ifName, oldState, neighbor.state);
 
-  // neihbor is restarting, shutdown heartbeat hold timer
+  // neihbor is restarting, shutdown heartbeat hold timer and liveness
+  // session, which is going to fail while neighbor restarts
   neighbor.heartbeatHoldTimer.reset();
+  stopLivenessSession(ifName, neighborName);
 }
 
 void
@@ -1214,8 +1688,7 @@ Spark::processHelloMsg(
     // TODO: Spark is yet to support area change due to dynamic configuration.
     //       To avoid running area deducing logic for every single helloMsg,
     //       ONLY deduce for unknown neighbors.
-    auto area =
-        getNeighborArea(neighborName, ifName, config_->getAreaConfiguration());
+    auto area = getCachedNeighborArea(neighborName, ifName);
     if (not area.has_value()) {
       return;
     }
@@ -1259,8 +1732,10 @@ Spark::processHelloMsg(
     updateNeighborRtt(
         // recvTime of neighbor helloPkt
         myRecvTimeInUs,
-        // sentTime of my helloPkt recorded by neighbor
-        std::chrono::microseconds(*ts.lastNbrMsgSentTsInUs_ref()),
+        // sentTime of my helloPkt recorded by neighbor, corrected with its
+        // transmit timestamp
+        getHelloTxTime(
+            ifName, std::chrono::microseconds(*ts.lastNbrMsgSentTsInUs_ref())),
         // recvTime of my helloPkt recorded by neighbor
         std::chrono::microseconds(*ts.lastMyMsgRcvdTsInUs_ref()),
         // sentTime of neighbor helloPkt
@@ -1292,7 +1767,9 @@ Spark::processHelloMsg(
     neighbor.seqNum = remoteSeqNum;
 
     if (tsIt == neighborInfos.end()) {
-      // Neighbor is NOT aware of us, ignore helloMsg
+      // Neighbor is NOT aware of us, ignore helloMsg. Restored neighbor has
+      // lost adjacency with us, so it needs to be negotiated again.
+      neighbor.restored = false;
       return;
     }
 
@@ -1313,7 +1790,7 @@ Spark::processHelloMsg(
 
     // Starts timer to periodically send hankshake msg
     const std::string neighborAreaId = neighbor.area;
-    neighbor.negotiateTimer = folly::AsyncTimeout::make(
+    neighbor.negotiateTimer = WheelTimeout::make(
         *getEvb(), [this, ifName, neighborName, neighborAreaId]() noexcept {
           sendHandshakeMsg(ifName, neighborName, neighborAreaId, false);
           // send out handshake msg periodically to this neighbor
@@ -1329,7 +1806,7 @@ Spark::processHelloMsg(
     neighbor.negotiateTimer->scheduleTimeout(handshakeTime_);
 
     // Starts negotiate hold-timer
-    neighbor.negotiateHoldTimer = folly::AsyncTimeout::make(
+    neighbor.negotiateHoldTimer = WheelTimeout::make(
         *getEvb(), [this, ifName, neighborName]() noexcept {
           // prevent to stucking in NEGOTIATE forever
           processNegotiateTimeout(ifName, neighborName);
@@ -1400,7 +1877,7 @@ Spark::processHelloMsg(
         neighbor.toThrift());
 
     // start heartbeat timer again to make sure neighbor is alive
-    neighbor.heartbeatHoldTimer = folly::AsyncTimeout::make(
+    neighbor.heartbeatHoldTimer = WheelTimeout::make(
         *getEvb(), [this, ifName, neighborName]() noexcept {
           processHeartbeatTimeout(ifName, neighborName);
         });
@@ -1409,6 +1886,8 @@ Spark::processHelloMsg(
     // stop the graceful-restart hold-timer
     neighbor.gracefulRestartHoldTimer.reset();
 
+    startLivenessSession(neighbor, ifName);
+
     SparkNeighState oldState = neighbor.state;
     neighbor.state = getNextState(oldState, SparkNeighEvent::HELLO_RCVD_INFO);
     logStateTransition(neighborName, ifName, oldState, neighbor.state);
@@ -1486,6 +1965,7 @@ Spark::processHandshakeMsg(
   }
 
   // update Spark neighborState
+  learnHeartbeatSenderId(ifName, neighborName, handshakeMsg);
   neighbor.kvStoreCmdPort = *handshakeMsg.kvStoreCmdPort_ref();
   neighbor.openrCtrlThriftPort = *handshakeMsg.openrCtrlThriftPort_ref();
   neighbor.transportAddressV4 = *handshakeMsg.transportAddressV4_ref();
@@ -1565,7 +2045,64 @@ Spark::processHandshakeMsg(
 void
 Spark::processHeartbeatMsg(
     thrift::SparkHeartbeatMsg const& heartbeatMsg, std::string const& ifName) {
-  auto const& neighborName = *heartbeatMsg.nodeName_ref();
+  processHeartbeat(*heartbeatMsg.nodeName_ref(), ifName);
+}
+
+void
+Spark::processCompactHeartbeat(
+    CompactHeartbeat const& heartbeat, std::string const& ifName) {
+  auto ifIt = heartbeatSenderIds_.find(ifName);
+  if (ifIt == heartbeatSenderIds_.end()) {
+    VLOG(3) << "No compact heartbeat senders known on " << ifName
+            << ". Ignore it.";
+    return;
+  }
+  auto it = ifIt->second.find(heartbeat.senderId);
+  if (it == ifIt->second.end()) {
+    VLOG(3) << "I am NOT aware of compact heartbeat sender: ("
+            << heartbeat.senderId << "). Ignore it.";
+    return;
+  }
+  processHeartbeat(it->second, ifName);
+}
+
+void
+Spark::learnHeartbeatSenderId(
+    std::string const& ifName,
+    std::string const& neighborName,
+    thrift::SparkHandshakeMsg const& handshakeMsg) {
+  auto& neighbor = sparkNeighbors_.at(ifName).at(neighborName);
+  neighbor.acceptsCompactHeartbeat = false;
+
+  auto version = handshakeMsg.compactHeartbeatVersion_ref();
+  auto senderId = handshakeMsg.heartbeatSenderId_ref();
+  if (not enableCompactHeartbeat_ or not version.has_value() or
+      not senderId.has_value() or *version < kCompactHeartbeatVersion) {
+    return;
+  }
+
+  // ids are hashes of node names, entry of other neighbor is only kept if
+  // that neighbor is still around
+  const auto id = static_cast<uint32_t>(*senderId);
+  auto& ifNeighbors = sparkNeighbors_.at(ifName);
+  auto& senderIds = heartbeatSenderIds_[ifName];
+  auto it = senderIds.find(id);
+  if (it != senderIds.end() and it->second != neighborName and
+      ifNeighbors.count(it->second)) {
+    LOG(ERROR) << "Neighbor: (" << neighborName << ") uses same compact "
+               << "heartbeat id " << id << " as (" << it->second << ") on "
+               << ifName << ". Sticking to thrift heartbeats.";
+    fb303::fbData->addStatValue(
+        "spark.heartbeat.compact_id_conflict", 1, fb303::SUM);
+    return;
+  }
+  senderIds[id] = neighborName;
+  neighbor.acceptsCompactHeartbeat = true;
+}
+
+void
+Spark::processHeartbeat(
+    std::string const& neighborName, std::string const& ifName) {
   auto& ifNeighbors = sparkNeighbors_.at(ifName);
   auto neighborIt = ifNeighbors.find(neighborName);
 
@@ -1580,6 +2117,29 @@ Spark::processHeartbeatMsg(
 
   auto& neighbor = neighborIt->second;
 
+  // Neighbor restored after graceful restart still has adjacency with us if
+  // it keeps sending heartbeats. Skip negotiation.
+  if (neighbor.restored and
+      (neighbor.state == SparkNeighState::WARM or
+       neighbor.state == SparkNeighState::NEGOTIATE)) {
+    SparkNeighState oldState = neighbor.state;
+    neighbor.state = getNextState(oldState, SparkNeighEvent::HEARTBEAT_RCVD);
+    logStateTransition(neighborName, ifName, oldState, neighbor.state);
+
+    const auto elapsedTime =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() -
+            neighbor.idleStateTransitionTime);
+    LOG(INFO) << "Neighbor: (" << neighborName << ") on interface: ("
+              << ifName << ") resynced after restart in "
+              << elapsedTime.count() << " ms";
+    fb303::fbData->addStatValue(
+        "slo.neighbor_resync.time_ms", elapsedTime.count(), fb303::AVG);
+
+    neighborUpWrapper(neighbor, ifName, neighborName);
+    return;
+  }
+
   // In case receiving heartbeat msg when it is NOT in established state,
   // Just ignore it.
   if (neighbor.state != SparkNeighState::ESTABLISHED) {
@@ -1595,22 +2155,50 @@ Spark::processHeartbeatMsg(
 
 void
 Spark::processPacket() {
-  // receive and parse pkt
-  thrift::SparkHelloPacket helloPacket;
-  std::string ifName;
-  std::chrono::microseconds myRecvTime;
-
-  if (!parsePacket(helloPacket, ifName, myRecvTime)) {
-    return;
-  }
+  // socket gets readable on pending transmit timestamps too
+  if (txTimestampingEnabled_) {
+    processTxTimestamps();
+  }
+
+  // receive whatever is pending on socket, up to a batch. Anything left
+  // keeps socket readable and gets picked up on next poll.
+  const auto recvResults = IoProvider::recvMessages(
+      mcastFd_,
+      recvBuf_.data(),
+      kMinIpv6Mtu,
+      kMaxRecvBatchSize,
+      ioProvider_.get());
+  static const StatHandle kHelloPacketRecvBatchSize(
+      "spark.hello_packet_recv_batch_size", fb303::AVG);
+  kHelloPacketRecvBatchSize.addValue(recvResults.size());
+
+  for (size_t i = 0; i < recvResults.size(); ++i) {
+    // parse pkt
+    thrift::SparkHelloPacket helloPacket;
+    std::optional<CompactHeartbeat> compactHeartbeat;
+    std::string ifName;
+    std::chrono::microseconds myRecvTime;
+
+    if (!parsePacket(
+            recvResults[i],
+            recvBuf_.data() + i * kMinIpv6Mtu,
+            helloPacket,
+            compactHeartbeat,
+            ifName,
+            myRecvTime)) {
+      continue;
+    }
 
-  // Spark specific msg processing
-  if (helloPacket.helloMsg_ref().has_value()) {
-    processHelloMsg(helloPacket.helloMsg_ref().value(), ifName, myRecvTime);
-  } else if (helloPacket.heartbeatMsg_ref().has_value()) {
-    processHeartbeatMsg(helloPacket.heartbeatMsg_ref().value(), ifName);
-  } else if (helloPacket.handshakeMsg_ref().has_value()) {
-    processHandshakeMsg(helloPacket.handshakeMsg_ref().value(), ifName);
+    // Spark specific msg processing
+    if (compactHeartbeat.has_value()) {
+      processCompactHeartbeat(*compactHeartbeat, ifName);
+    } else if (helloPacket.helloMsg_ref().has_value()) {
+      processHelloMsg(helloPacket.helloMsg_ref().value(), ifName, myRecvTime);
+    } else if (helloPacket.heartbeatMsg_ref().has_value()) {
+      processHeartbeatMsg(helloPacket.heartbeatMsg_ref().value(), ifName);
+    } else if (helloPacket.handshakeMsg_ref().has_value()) {
+      processHandshakeMsg(helloPacket.handshakeMsg_ref().value(), ifName);
+    }
   }
 }
 
@@ -1653,7 +2241,8 @@ Spark::sendHelloMsg(
   helloMsg.version_ref() = openrVer;
   helloMsg.solicitResponse_ref() = inFastInitState;
   helloMsg.restarting_ref() = restarting;
-  helloMsg.sentTsInUs_ref() = getCurrentTimeInUs().count();
+  const auto sentTime = getCurrentTimeInUs();
+  helloMsg.sentTsInUs_ref() = sentTime.count();
 
   // bake neighborInfo into helloMsg
   for (const auto& kv : sparkNeighbors_.at(ifName)) {
@@ -1691,6 +2280,8 @@ Spark::sendHelloMsg(
     return;
   }
 
+  recordPacketSent(ifName, sentTime);
+
   // update counters for number of pkts and total size of pkts sent
   fb303::fbData->addStatValue(
       "spark.hello.bytes_sent", packet.size(), fb303::SUM);
@@ -1700,24 +2291,68 @@ Spark::sendHelloMsg(
 }
 
 void
-Spark::processInterfaceUpdates(thrift::InterfaceDatabase&& ifDb) {
-  decltype(interfaceDb_) newInterfaceDb{};
-
+Spark::processInterfaceUpdates(InterfaceDatabaseUpdate&& update) {
+  const auto& ifDb = *update.snapshot;
   CHECK_EQ(*ifDb.thisNodeName_ref(), myNodeName_)
       << "Node name in ifDb " << *ifDb.thisNodeName_ref()
       << " does not match my node name " << myNodeName_;
 
+  // Interfaces to re-evaluate. Without delta all of them, including tracked
+  // ones which may be gone from the database.
+  std::set<std::string> ifNames;
+  if (update.isDelta) {
+    ifNames.insert(
+        update.updatedInterfaces.begin(), update.updatedInterfaces.end());
+    ifNames.insert(
+        update.removedInterfaces.begin(), update.removedInterfaces.end());
+  } else {
+    for (const auto& kv : *ifDb.interfaces_ref()) {
+      ifNames.emplace(kv.first);
+    }
+    for (const auto& kv : interfaceDb_) {
+      ifNames.emplace(kv.first);
+    }
+    otherShardIfIndexes_.clear();
+  }
+
+  decltype(interfaceDb_) newInterfaceDb{};
+  std::set<std::string> toAdd;
+  std::set<std::string> toDel;
+  std::set<std::string> toUpdate;
+
   //
   // To be conisdered a valid interface for Spark to track, it must:
   // - be up
   // - have a v6LinkLocal IP
   // - have an IPv4 addr when v4 is enabled
   //
-  for (const auto& kv : *ifDb.interfaces_ref()) {
-    const auto& ifName = kv.first;
-    const auto isUp = kv.second.isUp;
-    const auto& ifIndex = kv.second.ifIndex;
-    const auto& networks = *kv.second.networks_ref();
+  for (const auto& ifName : ifNames) {
+    const bool isOtherShard = getInterfaceShard(ifName, numShards_) != shardId_;
+
+    // Forget previous ifIndex of interface tracked by another shard
+    if (update.isDelta and isOtherShard and ifDbSnapshot_) {
+      auto oldIt = ifDbSnapshot_->interfaces_ref()->find(ifName);
+      if (oldIt != ifDbSnapshot_->interfaces_ref()->end()) {
+        otherShardIfIndexes_.erase(oldIt->second.ifIndex);
+      }
+    }
+
+    auto it = ifDb.interfaces_ref()->find(ifName);
+    if (it == ifDb.interfaces_ref()->end()) {
+      if (interfaceDb_.count(ifName)) {
+        toDel.emplace(ifName);
+      }
+      continue;
+    }
+    const auto isUp = it->second.isUp;
+    const auto& ifIndex = it->second.ifIndex;
+    const auto& networks = *it->second.networks_ref();
+
+    // Interface is tracked by another shard
+    if (isOtherShard) {
+      otherShardIfIndexes_.emplace(ifIndex);
+      continue;
+    }
 
     // Sort networks and use the lowest one (other node will do similar)
     std::set<folly::CIDRNetwork> v4Networks;
@@ -1731,15 +2366,20 @@ Spark::processInterfaceUpdates(thrift::InterfaceDatabase&& ifDb) {
       }
     }
 
+    bool isValid{true};
     if (!isUp) {
-      continue;
-    }
-    if (v6LinkLocalNetworks.empty()) {
+      isValid = false;
+    } else if (v6LinkLocalNetworks.empty()) {
       VLOG(2) << "IPv6 link local address not found";
-      continue;
-    }
-    if (enableV4_ && v4Networks.empty()) {
+      isValid = false;
+    } else if (enableV4_ && v4Networks.empty()) {
       VLOG(2) << "IPv4 enabled but no IPv4 addresses are configured";
+      isValid = false;
+    }
+    if (not isValid) {
+      if (interfaceDb_.count(ifName)) {
+        toDel.emplace(ifName);
+      }
       continue;
     }
 
@@ -1754,38 +2394,21 @@ Spark::processInterfaceUpdates(thrift::InterfaceDatabase&& ifDb) {
 
     newInterfaceDb.emplace(
         ifName, Interface(ifIndex, v4Network, v6LinkLocalNetwork));
+    if (interfaceDb_.count(ifName)) {
+      toUpdate.emplace(ifName);
+    } else {
+      toAdd.emplace(ifName);
+    }
   }
+  ifDbSnapshot_ = std::move(update.snapshot);
 
-  auto newIfaces = folly::gen::from(newInterfaceDb) | folly::gen::get<0>() |
-      folly::gen::as<std::set<std::string>>();
-
-  auto existingIfaces = folly::gen::from(interfaceDb_) | folly::gen::get<0>() |
-      folly::gen::as<std::set<std::string>>();
-
-  std::set<std::string> toAdd;
-  std::set<std::string> toDel;
-  std::set<std::string> toUpdate;
-
-  std::set_difference(
-      newIfaces.begin(),
-      newIfaces.end(),
-      existingIfaces.begin(),
-      existingIfaces.end(),
-      std::inserter(toAdd, toAdd.begin()));
-
-  std::set_difference(
-      existingIfaces.begin(),
-      existingIfaces.end(),
-      newIfaces.begin(),
-      newIfaces.end(),
-      std::inserter(toDel, toDel.begin()));
-
-  std::set_intersection(
-      newIfaces.begin(),
-      newIfaces.end(),
-      existingIfaces.begin(),
-      existingIfaces.end(),
-      std::inserter(toUpdate, toUpdate.begin()));
+  // Drop reverse lookup of interfaces going away or possibly changing ifIndex
+  for (const auto& ifName : toDel) {
+    ifIndexToName_.erase(interfaceDb_.at(ifName).ifIndex);
+  }
+  for (const auto& ifName : toUpdate) {
+    ifIndexToName_.erase(interfaceDb_.at(ifName).ifIndex);
+  }
 
   // remove the interfaces no longer in newdb
   deleteInterfaceFromDb(toDel);
@@ -1796,6 +2419,178 @@ Spark::processInterfaceUpdates(thrift::InterfaceDatabase&& ifDb) {
   // Updating interface. If ifindex changes, we need to unsubscribe old ifindex
   // from mcast and subscribe new one
   updateInterfaceInDb(toUpdate, newInterfaceDb);
+
+  for (const auto& ifName : toAdd) {
+    ifIndexToName_[interfaceDb_.at(ifName).ifIndex] = ifName;
+  }
+  for (const auto& ifName : toUpdate) {
+    ifIndexToName_[interfaceDb_.at(ifName).ifIndex] = ifName;
+  }
+
+  if (enableIngressFilter_ and
+      (not toDel.empty() or not toAdd.empty() or not toUpdate.empty())) {
+    updateIngressFilter();
+  }
+}
+
+void
+Spark::updateIngressFilter() {
+  std::vector<int> ifIndexes;
+  ifIndexes.reserve(interfaceDb_.size());
+  for (const auto& [_, interface] : interfaceDb_) {
+    ifIndexes.emplace_back(interface.ifIndex);
+  }
+  // on failure all packets are accepted, parsePacket() still checks them
+  if (IoProvider::attachIngressFilter(
+          mcastFd_, ifIndexes, kSparkHopLimit, ioProvider_.get())) {
+    VLOG(2) << "Attached ingress filter for " << ifIndexes.size()
+            << " interfaces";
+  }
+}
+
+folly::SemiFuture<folly::Unit>
+Spark::persistNeighbors() {
+  thrift::SparkPersistedState state;
+  state.persistedAtMs_ref() = getUnixTimeStampMs();
+  for (auto const& [ifName, neighbors] : sparkNeighbors_) {
+    auto senderIds = folly::get_ptr(heartbeatSenderIds_, ifName);
+    for (auto const& [neighborName, neighbor] : neighbors) {
+      if (neighbor.state != SparkNeighState::ESTABLISHED) {
+        continue;
+      }
+      thrift::SparkPersistedNeighbor persisted;
+      persisted.info_ref() = neighbor.toThrift();
+      persisted.heartbeatHoldTimeMs_ref() = neighbor.heartbeatHoldTime.count();
+      persisted.gracefulRestartHoldTimeMs_ref() =
+          neighbor.gracefulRestartHoldTime.count();
+      if (neighbor.acceptsCompactHeartbeat and senderIds) {
+        for (auto const& [senderId, name] : *senderIds) {
+          if (name == neighborName) {
+            persisted.heartbeatSenderId_ref() = senderId;
+            break;
+          }
+        }
+      }
+      state.neighbors_ref()->emplace_back(std::move(persisted));
+    }
+  }
+
+  LOG(INFO) << "Persisting " << state.neighbors_ref()->size()
+            << " established neighbors for restart";
+  return configStore_->storeThriftObj(
+      kPersistedNeighborsKey + std::to_string(shardId_), state);
+}
+
+void
+Spark::loadPersistedNeighbors() {
+  const auto key = kPersistedNeighborsKey + std::to_string(shardId_);
+  auto state =
+      configStore_->loadThriftObj<thrift::SparkPersistedState>(key).get();
+  if (not state.hasValue()) {
+    LOG(INFO) << "No neighbors persisted by previous Spark incarnation";
+    return;
+  }
+
+  // only valid right after the restart it was persisted for
+  configStore_->erase(key);
+
+  persistedAt_ = std::chrono::milliseconds(*state->persistedAtMs_ref());
+  for (auto& neighbor : *state->neighbors_ref()) {
+    const auto ifName = *neighbor.info_ref()->localIfName_ref();
+    persistedNeighbors_[ifName].emplace_back(std::move(neighbor));
+  }
+  LOG(INFO) << "Loaded " << state->neighbors_ref()->size()
+            << " neighbors persisted by previous Spark incarnation";
+}
+
+void
+Spark::restoreNeighbors(std::string const& ifName) {
+  auto it = persistedNeighbors_.find(ifName);
+  if (it == persistedNeighbors_.end()) {
+    return;
+  }
+
+  const std::chrono::milliseconds now(getUnixTimeStampMs());
+  auto& ifNeighbors = sparkNeighbors_.at(ifName);
+  for (auto const& persisted : it->second) {
+    auto const& info = *persisted.info_ref();
+    auto const& neighborName = *info.nodeName_ref();
+
+    // neighbor has given up on us after its graceful restart hold time
+    const std::chrono::milliseconds gracefulRestartHoldTime(
+        *persisted.gracefulRestartHoldTimeMs_ref());
+    if (now - persistedAt_ > gracefulRestartHoldTime) {
+      LOG(INFO) << "Skip restoring neighbor: (" << neighborName
+                << ") on interface: (" << ifName
+                << "), graceful restart hold time expired";
+      continue;
+    }
+
+    // area config could have changed across restart
+    if (getCachedNeighborArea(neighborName, ifName) != *info.area_ref()) {
+      LOG(INFO) << "Skip restoring neighbor: (" << neighborName
+                << ") on interface: (" << ifName << "), area changed";
+      continue;
+    }
+
+    // keep label of previous incarnation unless taken meanwhile
+    int32_t label = *info.label_ref();
+    if (not allocatedLabels_.insert(label).second) {
+      label = getNewLabelForIface(ifName);
+    }
+
+    auto rttChangeCb = [this, ifName, neighborName](const int64_t& newRtt) {
+      processRttChange(ifName, neighborName, newRtt);
+    };
+
+    ifNeighbors.emplace(
+        std::piecewise_construct,
+        std::forward_as_tuple(neighborName),
+        std::forward_as_tuple(
+            *config_->getSparkConfig().step_detector_conf_ref(),
+            myDomainName_,
+            neighborName,
+            ifName,
+            *info.remoteIfName_ref(),
+            label,
+            0, // seqNum, learned from next hello
+            keepAliveTime_,
+            std::move(rttChangeCb),
+            *info.area_ref()));
+
+    auto& neighbor = ifNeighbors.at(neighborName);
+    neighbor.restored = true;
+    neighbor.kvStoreCmdPort = *info.kvStoreCmdPort_ref();
+    neighbor.openrCtrlThriftPort = *info.openrCtrlThriftPort_ref();
+    neighbor.transportAddressV4 = *info.transportAddressV4_ref();
+    neighbor.transportAddressV6 = *info.transportAddressV6_ref();
+    neighbor.heartbeatHoldTime =
+        std::chrono::milliseconds(*persisted.heartbeatHoldTimeMs_ref());
+    neighbor.gracefulRestartHoldTime = gracefulRestartHoldTime;
+
+    // keep rtt, and thereby rtt based metric, of adjacency stable
+    neighbor.rtt = std::chrono::microseconds(*info.rttUs_ref());
+    neighbor.rttLatest = neighbor.rtt;
+
+    auto senderId = persisted.heartbeatSenderId_ref();
+    if (enableCompactHeartbeat_ and senderId.has_value()) {
+      heartbeatSenderIds_[ifName][static_cast<uint32_t>(*senderId)] =
+          neighborName;
+      neighbor.acceptsCompactHeartbeat = true;
+    }
+
+    // restored neighbor is reflected in our hellos right away, as if its
+    // hello had been received
+    SparkNeighState oldState = neighbor.state;
+    neighbor.state =
+        getNextState(oldState, SparkNeighEvent::HELLO_RCVD_NO_INFO);
+    logStateTransition(neighborName, ifName, oldState, neighbor.state);
+
+    LOG(INFO) << "Restored neighbor: (" << neighborName << ") on interface: ("
+              << ifName << "), waiting for heartbeat to verify it";
+    fb303::fbData->addStatValue("spark.neighbor.restored", 1, fb303::SUM);
+  }
+  persistedNeighbors_.erase(it);
 }
 
 void
@@ -1824,7 +2619,8 @@ Spark::deleteInterfaceFromDb(const std::set<std::string>& toDel) {
       neighborDownWrapper(neighbor, ifName, neighborName);
     }
     sparkNeighbors_.erase(ifName);
-    ifNameToHeartbeatTimers_.erase(ifName);
+    helloTxTimes_.erase(ifName);
+    heartbeatSenderIds_.erase(ifName);
 
     // unsubscribe the socket from mcast group on this interface
     // On error, log and continue
@@ -1839,6 +2635,9 @@ Spark::deleteInterfaceFromDb(const std::set<std::string>& toDel) {
     }
     // cleanup for this interface
     ifNameToHelloTimers_.erase(ifName);
+    ifNameToAdaptiveState_.erase(ifName);
+    neighborAreaCache_.erase(ifName);
+    ifIndexToDroppedPackets_.erase(interfaceDb_.at(ifName).ifIndex);
     interfaceDb_.erase(ifName);
   }
 }
@@ -1876,18 +2675,9 @@ Spark::addInterfaceToDb(
       auto result = sparkNeighbors_.emplace(
           ifName, std::unordered_map<std::string, SparkNeighbor>{});
       CHECK(result.second);
-
-      // heartbeatTimers will start as soon as intf is in UP state
-      auto heartbeatTimer =
-          folly::AsyncTimeout::make(*getEvb(), [this, ifName]() noexcept {
-            sendHeartbeatMsg(ifName);
-            // schedule heartbeatTimers periodically as soon as intf is UP
-            ifNameToHeartbeatTimers_.at(ifName)->scheduleTimeout(
-                keepAliveTime_);
-          });
-
-      ifNameToHeartbeatTimers_.emplace(ifName, std::move(heartbeatTimer));
-      ifNameToHeartbeatTimers_.at(ifName)->scheduleTimeout(keepAliveTime_);
+    }
+    if (enableRestartResync_) {
+      restoreNeighbors(ifName);
     }
 
     auto rollHelper = [](std::chrono::milliseconds timeDuration) {
@@ -1908,7 +2698,7 @@ Spark::addInterfaceToDb(
     // this is due to the fact that it may not have yet configured a link-local
     // address. The hello packet will be sent later and will have good chances
     // of making it out if small delay is introduced.
-    auto helloTimer = folly::AsyncTimeout::make(
+    auto helloTimer = WheelTimeout::make(
         *getEvb(),
         [this, ifName, timePoint, roll, rollFast]() mutable noexcept {
           VLOG(3) << "Sending hello multicast packet on interface " << ifName;
@@ -1929,12 +2719,31 @@ Spark::addInterfaceToDb(
           std::chrono::milliseconds timeoutPeriod =
               inFastInitState ? rollFast() : roll();
 
+          // scale jittered interval to the adaptive one of interface
+          auto adaptiveIt = ifNameToAdaptiveState_.find(ifName);
+          if (adaptiveIt != ifNameToAdaptiveState_.end()) {
+            if (not inFastInitState) {
+              timeoutPeriod =
+                  timeoutPeriod * getHelloTime(ifName).count() /
+                  helloTime_.count();
+            }
+            adaptiveIt->second.nextHello =
+                std::chrono::steady_clock::now() + timeoutPeriod;
+          }
+
           ifNameToHelloTimers_.at(ifName)->scheduleTimeout(timeoutPeriod);
         });
 
     // should be in fast init state when the node just starts
-    helloTimer->scheduleTimeout(rollFast());
+    auto const timeoutPeriod = rollFast();
+    helloTimer->scheduleTimeout(timeoutPeriod);
     ifNameToHelloTimers_[ifName] = std::move(helloTimer);
+
+    // new interface starts out as recently changed
+    if (enableAdaptiveIntervals_) {
+      ifNameToAdaptiveState_[ifName] = AdaptiveIntervalState{
+          timePoint, timePoint + timeoutPeriod, timePoint};
+    }
   }
 }
 
@@ -1992,12 +2801,11 @@ Spark::updateInterfaceInDb(
 
 std::optional<std::string>
 Spark::findInterfaceFromIfindex(int ifIndex) {
-  for (const auto& kv : interfaceDb_) {
-    if (kv.second.ifIndex == ifIndex) {
-      return kv.first;
-    }
+  auto it = ifIndexToName_.find(ifIndex);
+  if (it == ifIndexToName_.end()) {
+    return std::nullopt;
   }
-  return std::nullopt;
+  return it->second;
 }
 
 int32_t
@@ -2038,21 +2846,49 @@ Spark::updateGlobalCounters() {
       fb303::fbData->setCounter(
           "spark.rtt_latest_us." + neighbor.nodeName,
           neighbor.rttLatest.count());
+      fb303::fbData->setCounter(
+          "spark.rtt_jitter_us." + neighbor.nodeName + "." +
+              ifaceNeighbors.first,
+          neighbor.rttJitter.count());
       fb303::fbData->setCounter(
           "spark.seq_num." + neighbor.nodeName, neighbor.seqNum);
     }
   }
+  for (auto const& kv : interfaceDb_) {
+    fb303::fbData->setCounter(
+        "spark.hello_packet_dropped." + kv.first,
+        folly::get_default(ifIndexToDroppedPackets_, kv.second.ifIndex, 0));
+  }
+  for (auto const& kv : ifNameToAdaptiveState_) {
+    fb303::fbData->setCounter(
+        "spark.hello_interval_ms." + kv.first, getHelloTime(kv.first).count());
+    fb303::fbData->setCounter(
+        "spark.heartbeat_interval_ms." + kv.first,
+        getKeepAliveTime(kv.first).count());
+  }
   fb303::fbData->setCounter(
-      "spark.num_tracked_interfaces", sparkNeighbors_.size());
+      getShardCounterName("spark.num_tracked_interfaces"),
+      sparkNeighbors_.size());
   fb303::fbData->setCounter(
-      "spark.num_tracked_neighbors", trackedNeighborCount);
+      getShardCounterName("spark.num_tracked_neighbors"), trackedNeighborCount);
   fb303::fbData->setCounter(
-      "spark.num_adjacent_neighbors", adjacentNeighborCount);
+      getShardCounterName("spark.num_adjacent_neighbors"),
+      adjacentNeighborCount);
   fb303::fbData->setCounter(
-      "spark.tracked_adjacent_neighbors_diff",
+      getShardCounterName("spark.tracked_adjacent_neighbors_diff"),
       trackedNeighborCount - adjacentNeighborCount);
-  fb303::fbData->setCounter("spark.my_seq_num", mySeqNum_);
-  fb303::fbData->setCounter("spark.pending_timers", getEvb()->timer().count());
+  fb303::fbData->setCounter(
+      getShardCounterName("spark.my_seq_num"), mySeqNum_);
+  fb303::fbData->setCounter(
+      getShardCounterName("spark.pending_timers"), getEvb()->timer().count());
+}
+
+std::string
+Spark::getShardCounterName(const std::string& name) const {
+  if (numShards_ == 1) {
+    return name;
+  }
+  return folly::sformat("{}.shard_{}", name, shardId_);
 }
 
 // This is a static function
@@ -2060,35 +2896,15 @@ std::optional<std::string>
 Spark::getNeighborArea(
     const std::string& peerNodeName,
     const std::string& localIfName,
-    const std::unordered_map<std::string /* areaId */, AreaConfiguration>&
-        areaConfigs) {
-  std::vector<std::string> candidateAreas{};
-
-  // looping through areaIdRegexList
-  for (const auto& t : areaConfigs) {
-    const auto& areaId = t.first;
-    const auto& neighborRegex = t.second.neighborRegexList;
-    const auto& interfaceRegex = t.second.interfaceRegexList;
-
-    if (neighborRegex and interfaceRegex) {
-      if (matchRegexSet(peerNodeName, neighborRegex) and
-          matchRegexSet(localIfName, interfaceRegex)) {
-        VLOG(1) << folly::sformat(
-            "Area: {} found for neighbor: {}, interface: {}",
-            areaId,
-            peerNodeName,
-            localIfName);
-        candidateAreas.emplace_back(areaId);
-      }
-    } else if (neighborRegex and matchRegexSet(peerNodeName, neighborRegex)) {
-      VLOG(1) << folly::sformat(
-          "Area: {} found for neighbor: {}", areaId, peerNodeName);
-      candidateAreas.emplace_back(areaId);
-    } else if (interfaceRegex and matchRegexSet(localIfName, interfaceRegex)) {
-      VLOG(1) << folly::sformat(
-          "Area: {} found for interface: {}", areaId, localIfName);
-      candidateAreas.emplace_back(areaId);
-    }
+    const AreaMatcher& areaMatcher) {
+  // single pass over regexes of all areas
+  const auto candidateAreas = areaMatcher.match(peerNodeName, localIfName);
+  for (const auto& areaId : candidateAreas) {
+    VLOG(1) << folly::sformat(
+        "Area: {} found for neighbor: {}, interface: {}",
+        areaId,
+        peerNodeName,
+        localIfName);
   }
 
   if (candidateAreas.empty()) {
@@ -2104,9 +2920,76 @@ Spark::getNeighborArea(
   return candidateAreas.back();
 }
 
+std::optional<std::string>
+Spark::getCachedNeighborArea(
+    const std::string& peerNodeName, const std::string& ifName) {
+  auto& ifCache = neighborAreaCache_[ifName];
+  auto it = ifCache.find(peerNodeName);
+  if (it != ifCache.end()) {
+    fb303::fbData->addStatValue(
+        "spark.neighbor_area_cache_hit", 1, fb303::COUNT);
+    return it->second;
+  }
+
+  if (ifCache.size() >= kMaxNeighborAreaCacheSize) {
+    ifCache.clear();
+  }
+  auto area =
+      getNeighborArea(peerNodeName, ifName, config_->getAreaMatcher());
+  ifCache.emplace(peerNodeName, area);
+  return area;
+}
+
 void
 Spark::setThrowParserErrors(bool val) {
   isThrowParserErrorsOn_ = val;
 }
 
+std::string
+Spark::encodeCompactHeartbeat(CompactHeartbeat const& heartbeat) {
+  std::string packet(kCompactHeartbeatSize, '\0');
+  auto* buf = reinterpret_cast<uint8_t*>(packet.data());
+  buf[0] = kCompactPacketMarker;
+  buf[1] = kCompactHeartbeatVersion;
+  // buf[2], buf[3] are reserved
+  const uint32_t senderId = folly::Endian::big(heartbeat.senderId);
+  const uint64_t seqNum = folly::Endian::big(heartbeat.seqNum);
+  const uint64_t sentTime = folly::Endian::big(
+      static_cast<uint64_t>(heartbeat.sentTime.count()));
+  ::memcpy(buf + 4, &senderId, sizeof(senderId));
+  ::memcpy(buf + 8, &seqNum, sizeof(seqNum));
+  ::memcpy(buf + 16, &sentTime, sizeof(sentTime));
+  return packet;
+}
+
+bool
+Spark::isCompactPacket(const uint8_t* buf, size_t len) {
+  return len >= 2 and buf[0] == kCompactPacketMarker;
+}
+
+uint32_t
+Spark::getInterfaceShard(const std::string& ifName, uint32_t numShards) {
+  CHECK_GT(numShards, 0);
+  return folly::hash::fnv32(ifName) % numShards;
+}
+
+std::optional<Spark::CompactHeartbeat>
+Spark::decodeCompactHeartbeat(const uint8_t* buf, size_t len) {
+  if (not isCompactPacket(buf, len) or len != kCompactHeartbeatSize or
+      buf[1] != kCompactHeartbeatVersion) {
+    return std::nullopt;
+  }
+  uint32_t senderId;
+  uint64_t seqNum;
+  uint64_t sentTime;
+  ::memcpy(&senderId, buf + 4, sizeof(senderId));
+  ::memcpy(&seqNum, buf + 8, sizeof(seqNum));
+  ::memcpy(&sentTime, buf + 16, sizeof(sentTime));
+  return CompactHeartbeat{
+      folly::Endian::big(senderId),
+      folly::Endian::big(seqNum),
+      std::chrono::microseconds(
+          static_cast<int64_t>(folly::Endian::big(sentTime)))};
+}
+
 } // namespace openr
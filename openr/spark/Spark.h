@@ -8,11 +8,12 @@
 #pragma once
 
 #include <chrono>
+#include <deque>
 #include <functional>
+#include <map>
+#include <unordered_set>
 
 #include <folly/SocketAddress.h>
-#include <folly/io/async/AsyncTimeout.h>
-#include <folly/stats/BucketedTimeSeries.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include <openr/common/Constants.h>
@@ -20,6 +21,8 @@
 #include <openr/common/StepDetector.h>
 #include <openr/common/Types.h>
 #include <openr/common/Util.h>
+#include <openr/common/WheelTimeout.h>
+#include <openr/config-store/PersistentStore.h>
 #include <openr/config/Config.h>
 #include <openr/if/gen-cpp2/KvStore_constants.h>
 #include <openr/if/gen-cpp2/LinkMonitor_types.h>
@@ -27,6 +30,7 @@
 #include <openr/if/gen-cpp2/Spark_types.h>
 #include <openr/messaging/ReplicateQueue.h>
 #include <openr/spark/IoProvider.h>
+#include <openr/spark/LivenessProvider.h>
 
 namespace openr {
 
@@ -78,7 +82,7 @@ class Spark final : public OpenrEventBase {
  public:
   Spark(
       std::optional<int> ipTos,
-      messaging::RQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue,
+      messaging::RQueue<InterfaceDatabaseUpdate> interfaceUpdatesQueue,
       messaging::ReplicateQueue<thrift::SparkNeighborEvent>& nbrUpdatesQueue,
       KvStoreCmdPort kvStoreCmdPort,
       OpenrCtrlThriftPort openrCtrlThriftPort,
@@ -86,7 +90,10 @@ class Spark final : public OpenrEventBase {
       std::shared_ptr<const Config> config,
       std::pair<uint32_t, uint32_t> version = std::make_pair(
           Constants::kOpenrVersion, Constants::kOpenrSupportedVersion),
-      std::optional<uint32_t> maybeMaxAllowedPps = Constants::kMaxAllowedPps);
+      std::optional<uint32_t> maybeMaxAllowedPps = Constants::kMaxAllowedPps,
+      uint32_t shardId = 0,
+      std::shared_ptr<LivenessProvider> livenessProvider = nullptr,
+      PersistentStore* configStore = nullptr);
 
   ~Spark() override = default;
 
@@ -108,6 +115,50 @@ class Spark final : public OpenrEventBase {
   // Turn on the throwing of parsing errors.
   void setThrowParserErrors(bool);
 
+  //
+  // Compact heartbeat, a fixed-layout alternative to thrift encoded
+  // heartbeat for peers which have announced support for it in handshake.
+  // All fields are in network byte order:
+  //
+  //   0       1       2       3
+  //   marker  version reserved
+  //   senderId (learned from sender handshake)
+  //   seqNum (8 bytes)
+  //   sentTime in usecs (8 bytes)
+  //
+  // Marker byte is 0, which starts an empty thrift struct, so it can't be
+  // mistaken for a thrift encoded packet.
+  //
+  struct CompactHeartbeat {
+    uint32_t senderId{0};
+    uint64_t seqNum{0};
+    std::chrono::microseconds sentTime{0};
+  };
+
+  static std::string encodeCompactHeartbeat(CompactHeartbeat const& heartbeat);
+
+  // Returns std::nullopt if buf doesn't hold compact heartbeat of known
+  // version
+  static std::optional<CompactHeartbeat> decodeCompactHeartbeat(
+      const uint8_t* buf, size_t len);
+
+  // Whether packet is compact encoded, of any version
+  static bool isCompactPacket(const uint8_t* buf, size_t len);
+
+  // Spark shard handling given interface. Stable across restarts so that
+  // all shards agree on it without coordination.
+  static uint32_t getInterfaceShard(
+      const std::string& ifName, uint32_t numShards);
+
+  // Interval to use instead of configured baseInterval in adaptive mode,
+  // given time since last neighbor state change on the interface. Halved
+  // after recent changes, doubled per stable period up to a max factor, but
+  // not beyond maxInterval unless baseInterval already is.
+  static std::chrono::milliseconds getAdaptiveInterval(
+      std::chrono::milliseconds baseInterval,
+      std::chrono::steady_clock::duration stableFor,
+      std::chrono::milliseconds maxInterval);
+
  private:
   //
   // Interface tracking
@@ -152,11 +203,11 @@ class Spark final : public OpenrEventBase {
       std::string const& remoteIfName,
       uint32_t const& remoteVersion);
 
-  // Determine if we should process the next packte from this ifName, addr pair
-  bool shouldProcessHelloPacket(
-      std::string const& ifName, folly::IPAddress const& addr);
+  // Determine if we should process the next packet from this ifIndex, addr
+  // pair. Cheap enough to be checked before anything else on a packet.
+  bool shouldProcessHelloPacket(int ifIndex, folly::IPAddress const& addr);
 
-  // process hello packet from a neighbor. we want to see if
+  // process batch of hello packets pending on socket. we want to see if
   // the neighbor could be added as adjacent peer.
   void processPacket();
 
@@ -170,6 +221,20 @@ class Spark final : public OpenrEventBase {
   void processHeartbeatMsg(
       thrift::SparkHeartbeatMsg const& heartbeatMsg, std::string const& ifName);
 
+  // process compact heartbeat, sender is looked up by its learned id
+  void processCompactHeartbeat(
+      CompactHeartbeat const& heartbeat, std::string const& ifName);
+
+  // refresh hold timer of neighbor on receipt of heartbeat
+  void processHeartbeat(
+      std::string const& neighborName, std::string const& ifName);
+
+  // learn id neighbor uses in its compact heartbeats, if it supports them
+  void learnHeartbeatSenderId(
+      std::string const& ifName,
+      std::string const& neighborName,
+      thrift::SparkHandshakeMsg const& handshakeMsg);
+
   // process handshakeMsg to update sparkNeighbors_ db
   void processHandshakeMsg(
       thrift::SparkHandshakeMsg const& handshakeMsg, std::string const& ifName);
@@ -187,12 +252,39 @@ class Spark final : public OpenrEventBase {
       std::string const& neighborAreaId,
       bool isAdjEstablished);
 
-  // util call to send heartbeat msg
-  void sendHeartbeatMsg(std::string const& ifName);
+  // util call to send heartbeat msg on all interfaces with active neighbors
+  void sendHeartbeatMsgs();
+
+  // schedule heartbeatTimer_ for the next interface heartbeat is due on
+  void scheduleHeartbeatTimer();
+
+  // hello/heartbeat interval of interface, configured ones unless adaptive
+  // intervals are enabled
+  std::chrono::milliseconds getHelloTime(std::string const& ifName) const;
+  std::chrono::milliseconds getKeepAliveTime(std::string const& ifName) const;
+
+  // restart adaptive intervals of interface on neighbor state change and
+  // pull in hello/heartbeat already scheduled later than that
+  void processAdaptiveStateChange(std::string const& ifName);
+
+  // account for packet sent on mcastFd_, and remember when hello was sent to
+  // match it with its transmit timestamp
+  void recordPacketSent(
+      std::string const& ifName = "",
+      std::optional<std::chrono::microseconds> helloSentTime = std::nullopt);
+
+  // read transmit timestamps of sent packets from mcastFd_ error queue
+  void processTxTimestamps();
+
+  // transmit timestamp of hello sent on ifName at given user space time, if
+  // known. Falls back to user space time otherwise
+  std::chrono::microseconds getHelloTxTime(
+      std::string const& ifName, std::chrono::microseconds helloSentTime);
 
   // Function processes interface updates from LinkMonitor and appropriately
-  // enable/disable neighbor discovery
-  void processInterfaceUpdates(thrift::InterfaceDatabase&& interfaceUpdates);
+  // enable/disable neighbor discovery. Only interfaces in delta are looked at,
+  // unless update comes without one.
+  void processInterfaceUpdates(InterfaceDatabaseUpdate&& update);
 
   // util function to delete interface in spark
   void deleteInterfaceFromDb(const std::set<std::string>& toDel);
@@ -207,6 +299,19 @@ class Spark final : public OpenrEventBase {
       const std::set<std::string>& toUpdate,
       const std::unordered_map<std::string, Interface>& newInterfaceDb);
 
+  // attach ingress filter to mcastFd_ accepting packets of interfaceDb_ only
+  void updateIngressFilter();
+
+  // save ESTABLISHED neighbors in configStore_ before graceful restart
+  folly::SemiFuture<folly::Unit> persistNeighbors();
+
+  // load neighbors saved by previous incarnation into persistedNeighbors_
+  void loadPersistedNeighbors();
+
+  // reinstate persisted neighbors of newly added interface in WARM state,
+  // to be promoted to ESTABLISHED by their first heartbeat
+  void restoreNeighbors(std::string const& ifName);
+
   // find an interface name in the interfaceDb given an ifIndex
   std::optional<std::string> findInterfaceFromIfindex(int ifIndex);
 
@@ -218,6 +323,9 @@ class Spark final : public OpenrEventBase {
   // set flat counter/stats
   void updateGlobalCounters();
 
+  // name of flat counter, qualified with shard id when sharded
+  std::string getShardCounterName(const std::string& name) const;
+
   // utility method to add regex for:
   //
   //  tuple(areaId, neighbor_regex, interface_regex)
@@ -242,12 +350,18 @@ class Spark final : public OpenrEventBase {
   static std::optional<std::string> getNeighborArea(
       const std::string& peerNodeName,
       const std::string& ifName,
-      const std::unordered_map<std::string /* areaId */, AreaConfiguration>&
-          areaConfigs);
+      const AreaMatcher& areaMatcher);
+
+  // getNeighborArea() memoized per interface in neighborAreaCache_
+  std::optional<std::string> getCachedNeighborArea(
+      const std::string& peerNodeName, const std::string& ifName);
 
-  // function to receive and parse received pkt
+  // function to parse pkt received into buf
   bool parsePacket(
+      IoProvider::RecvResult const& recvResult,
+      const uint8_t* buf,
       thrift::SparkHelloPacket& pkt /* packet( type will be renamed later) */,
+      std::optional<CompactHeartbeat>& compactHeartbeat,
       std::string& ifName /* interface */,
       std::chrono::microseconds& recvTime /* kernel timestamp when recved */);
 
@@ -331,16 +445,16 @@ class Spark final : public OpenrEventBase {
     SparkNeighState state{SparkNeighState::IDLE};
 
     // timer to periodically send out handshake pkt
-    std::unique_ptr<folly::AsyncTimeout> negotiateTimer{nullptr};
+    std::unique_ptr<WheelTimeout> negotiateTimer{nullptr};
 
     // negotiate stage hold-timer
-    std::unique_ptr<folly::AsyncTimeout> negotiateHoldTimer{nullptr};
+    std::unique_ptr<WheelTimeout> negotiateHoldTimer{nullptr};
 
     // heartbeat hold-timer
-    std::unique_ptr<folly::AsyncTimeout> heartbeatHoldTimer{nullptr};
+    std::unique_ptr<WheelTimeout> heartbeatHoldTimer{nullptr};
 
     // graceful restart hold-timer
-    std::unique_ptr<folly::AsyncTimeout> gracefulRestartHoldTimer{nullptr};
+    std::unique_ptr<WheelTimeout> gracefulRestartHoldTimer{nullptr};
 
     // KvStore related port. Info passed to LinkMonitor for neighborEvent
     int32_t kvStoreCmdPort{0};
@@ -365,6 +479,12 @@ class Spark final : public OpenrEventBase {
     // Lastest measured RTT on receipt of every hello packet
     std::chrono::microseconds rttLatest{0};
 
+    // Last RTT sample before masking to millisecond accuracy, and smoothed
+    // mean deviation between consecutive samples (RFC 3550 interarrival
+    // jitter)
+    std::chrono::microseconds rttSample{0};
+    std::chrono::microseconds rttJitter{0};
+
     // Time when a neighbor state becomes IDLE
     std::chrono::time_point<std::chrono::steady_clock> idleStateTransitionTime =
         std::chrono::steady_clock::now();
@@ -378,6 +498,13 @@ class Spark final : public OpenrEventBase {
 
     // area on which adjacency is formed
     std::string area{};
+
+    // whether neighbor can receive compact heartbeats
+    bool acceptsCompactHeartbeat{false};
+
+    // reinstated from state persisted before graceful restart, and not yet
+    // verified by heartbeat or handshake
+    bool restored{false};
   };
 
   std::unordered_map<
@@ -428,6 +555,18 @@ class Spark final : public OpenrEventBase {
   void processHeartbeatTimeout(
       std::string const& ifName, std::string const& neighborName);
 
+  // hand over/take back liveness detection of neighbor to/from
+  // livenessProvider_. No-op without provider.
+  void startLivenessSession(
+      SparkNeighbor const& neighbor, std::string const& ifName);
+  void stopLivenessSession(
+      std::string const& ifName, std::string const& neighborName);
+
+  // process liveness loss reported by livenessProvider_, treated same as
+  // heartbeat hold timer expiry
+  void processLivenessDown(
+      std::string const& ifName, std::string const& neighborName);
+
   // process timeout for negotiate stage
   void processNegotiateTimeout(
       std::string const& ifName, std::string const& neighborName);
@@ -479,6 +618,85 @@ class Spark final : public OpenrEventBase {
   // Spark HelloMessage
   const bool enableV4_{false};
 
+  // source of packet timestamps used for RTT measurement
+  const thrift::SparkTimestampingMode timestampingMode_{
+      thrift::SparkTimestampingMode::KERNEL_RX};
+
+  // whether transmit timestamps are reported on mcastFd_ error queue
+  bool txTimestampingEnabled_{false};
+
+  // id of next packet sent on mcastFd_, as assigned by kernel to transmit
+  // timestamps (SOF_TIMESTAMPING_OPT_ID)
+  uint32_t txTimestampId_{0};
+
+  // hellos waiting for their transmit timestamp, in send order
+  struct PendingHello {
+    uint32_t txTimestampId{0};
+    std::string ifName;
+    std::chrono::microseconds sentTime{0};
+  };
+  std::deque<PendingHello> pendingHellos_;
+
+  // transmit timestamps of last hellos sent on each interface, keyed by user
+  // space send time carried in hello and reflected back by neighbors
+  std::unordered_map<
+      std::string /* ifName */,
+      std::map<
+          std::chrono::microseconds /* sentTime */,
+          std::chrono::microseconds /* txTime */>>
+      helloTxTimes_;
+
+  // send fixed-layout heartbeats to peers supporting it
+  const bool enableCompactHeartbeat_{false};
+
+  // interfaces are partitioned across numShards_ Spark instances, this one
+  // only tracks the interfaces of shardId_
+  const uint32_t numShards_{1};
+  const uint32_t shardId_{0};
+
+  // ifIndexes of interfaces tracked by other shards. Packets received on them
+  // are expected, as all shards listen on the same port.
+  std::unordered_set<int> otherShardIfIndexes_;
+
+  // adapt hello/heartbeat intervals to neighbor stability of interface
+  const bool enableAdaptiveIntervals_{false};
+
+  // drop packets of other interfaces in the kernel, see updateIngressFilter()
+  const bool enableIngressFilter_{false};
+
+  // persist neighbors across graceful restart, only set with configStore_
+  const bool enableRestartResync_{false};
+  PersistentStore* configStore_{nullptr};
+
+  // neighbors persisted by previous incarnation, yet to be restored once
+  // their interface is added
+  std::unordered_map<
+      std::string /* ifName */,
+      std::vector<thrift::SparkPersistedNeighbor>>
+      persistedNeighbors_;
+  std::chrono::milliseconds persistedAt_{0};
+
+  // per interface state of adaptive intervals, only kept if enabled
+  struct AdaptiveIntervalState {
+    // last time a neighbor on interface changed its state
+    std::chrono::steady_clock::time_point lastStateChange;
+
+    // when hello and heartbeat are due next on interface
+    std::chrono::steady_clock::time_point nextHello;
+    std::chrono::steady_clock::time_point nextHeartbeat;
+  };
+  std::unordered_map<std::string /* ifName */, AdaptiveIntervalState>
+      ifNameToAdaptiveState_;
+
+  // id carried in my compact heartbeats, announced in handshake
+  const uint32_t myHeartbeatSenderId_{0};
+
+  // ids learned from neighbor handshakes, to find sender of compact heartbeat
+  std::unordered_map<
+      std::string /* ifName */,
+      std::unordered_map<uint32_t /* senderId */, std::string /* neighbor */>>
+      heartbeatSenderIds_;
+
   // the next sequence number to be used on any interface for outgoing hellos
   // NOTE: we increment this on hello sent out of any interfaces
   uint64_t mySeqNum_{1};
@@ -503,17 +721,21 @@ class Spark final : public OpenrEventBase {
   // Map of interface entries keyed by ifName
   std::unordered_map<std::string, Interface> interfaceDb_{};
 
+  // Reverse of interfaceDb_ for ifIndex lookup of received packets
+  std::unordered_map<int, std::string> ifIndexToName_{};
+
+  // Last interface database received from LinkMonitor
+  std::shared_ptr<const thrift::InterfaceDatabase> ifDbSnapshot_;
+
   // Hello packet send timers for each interface
   std::unordered_map<
       std::string /* ifName */,
-      std::unique_ptr<folly::AsyncTimeout>>
+      std::unique_ptr<WheelTimeout>>
       ifNameToHelloTimers_{};
 
-  // heartbeat packet send timers for each interface
-  std::unordered_map<
-      std::string /* ifName */,
-      std::unique_ptr<folly::AsyncTimeout>>
-      ifNameToHeartbeatTimers_{};
+  // heartbeat packet send timer, shared by all interfaces so that all
+  // heartbeats go out with a single call
+  std::unique_ptr<WheelTimeout> heartbeatTimer_{nullptr};
 
   // number of active neighbors for each interface
   std::unordered_map<
@@ -532,16 +754,43 @@ class Spark final : public OpenrEventBase {
   // instances, hence the shared_ptr
   std::shared_ptr<IoProvider> ioProvider_{nullptr};
 
-  // vector of BucketedTimeSeries to make sure we don't take too many
-  // hello packets from any one iface, address pair
-  std::vector<folly::BucketedTimeSeries<int64_t, std::chrono::steady_clock>>
-      timeSeriesVector_{};
+  // Optional external failure detection for ESTABLISHED neighbors, within
+  // livenessDetectTime_
+  std::shared_ptr<LivenessProvider> livenessProvider_{nullptr};
+  const std::chrono::milliseconds livenessDetectTime_{0};
+
+  // buffer for receiving batch of packets at once
+  std::vector<uint8_t> recvBuf_;
+
+  // Token bucket refilled at maybeMaxAllowedPps_, holding up to a second
+  // worth of packets
+  struct HelloRateLimiter {
+    double tokens{0};
+    std::chrono::steady_clock::time_point lastRefill{};
+  };
+
+  // table of token buckets indexed by hash of (ifIndex, address), to make
+  // sure we don't take too many hello packets from any one iface, address
+  // pair
+  std::vector<HelloRateLimiter> helloRateLimiters_{};
+
+  // hello packets dropped by rate limit per ifIndex
+  std::unordered_map<int, int64_t> ifIndexToDroppedPackets_{};
 
   // global openr config
   std::shared_ptr<const Config> config_{nullptr};
 
+  // areas deduced for neighbors seen on each interface. Valid as long as
+  // config_, which is immutable, and dropped along with the interface.
+  std::unordered_map<
+      std::string /* ifName */,
+      std::unordered_map<
+          std::string /* neighborName */,
+          std::optional<std::string> /* area */>>
+      neighborAreaCache_{};
+
   // Timer for updating and submitting counters periodically
-  std::unique_ptr<folly::AsyncTimeout> counterUpdateTimer_{nullptr};
+  std::unique_ptr<WheelTimeout> counterUpdateTimer_{nullptr};
 
   // Optional rate-limit on processing inbound Spark messages
   std::optional<uint32_t> maybeMaxAllowedPps_;
@@ -16,7 +16,10 @@ SparkWrapper::SparkWrapper(
     std::pair<uint32_t, uint32_t> version,
     std::shared_ptr<IoProvider> ioProvider,
     std::shared_ptr<const Config> config,
-    bool isRateLimitEnabled)
+    bool isRateLimitEnabled,
+    uint32_t shardId,
+    std::shared_ptr<LivenessProvider> livenessProvider,
+    PersistentStore* configStore)
     : myNodeName_(myNodeName), config_(config) {
   // apply isRateLimitEnabled.
   // Using a plain bool enable/disable for rate-limit here, to leave
@@ -32,7 +35,10 @@ SparkWrapper::SparkWrapper(
             std::move(ioProvider),
             config,
             version,
-            std::nullopt) // no Spark receive rate-limit, for testing
+            std::nullopt, // no Spark receive rate-limit, for testing
+            shardId,
+            std::move(livenessProvider),
+            configStore)
       : std::make_shared<Spark>(
             std::nullopt /* ip-tos */,
             interfaceUpdatesQueue_.getReader(),
@@ -41,9 +47,11 @@ SparkWrapper::SparkWrapper(
             OpenrCtrlThriftPort{2018},
             std::move(ioProvider),
             config,
-            version
-            // Go with the default Spark rate-limit
-        );
+            version,
+            Constants::kMaxAllowedPps, // Go with the default Spark rate-limit
+            shardId,
+            std::move(livenessProvider),
+            configStore);
   // For testing - fuzz testing particularly - we want parsing errors to
   // be thrown upward, not suppressed.
   spark_->setThrowParserErrors(true);
@@ -36,7 +36,10 @@ class SparkWrapper {
       std::pair<uint32_t, uint32_t> version,
       std::shared_ptr<IoProvider> ioProvider,
       std::shared_ptr<const Config> config,
-      bool isRateLimitEnabled = true);
+      bool isRateLimitEnabled = true,
+      uint32_t shardId = 0,
+      std::shared_ptr<LivenessProvider> livenessProvider = nullptr,
+      PersistentStore* configStore = nullptr);
 
   ~SparkWrapper();
 
@@ -97,7 +100,7 @@ class SparkWrapper {
       neighborUpdatesQueue_.getReader()};
 
   // Queue to receive interface update from LinkMonitor
-  messaging::ReplicateQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue_;
+  messaging::ReplicateQueue<InterfaceDatabaseUpdate> interfaceUpdatesQueue_;
 
   // Spark owned by this wrapper.
   std::shared_ptr<Spark> spark_{nullptr};
@@ -0,0 +1,335 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <time.h>
+#include <thread>
+
+#include <fb303/ServiceData.h>
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/Util.h>
+#include <openr/config/Config.h>
+#include <openr/config/tests/Utils.h>
+#include <openr/spark/SparkWrapper.h>
+#include <openr/tests/BenchmarkDriver.h>
+#include <openr/tests/mocks/MockIoProvider.h>
+
+/**
+ * Like BENCHMARK_NAMED_PARAM(), but allows users to record customized counter
+ * during benchmarking.
+ */
+#define BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param_name, ...) \
+  BENCHMARK_IMPL_COUNTERS(                                             \
+      FB_CONCATENATE(name, FB_CONCATENATE(_, param_name)),             \
+      FOLLY_PP_STRINGIZE(name) "(" FOLLY_PP_STRINGIZE(param_name) ")", \
+      counters,                                                        \
+      iters,                                                           \
+      unsigned,                                                        \
+      iters) {                                                         \
+    name(counters, iters, ##__VA_ARGS__);                              \
+  }
+
+namespace fb303 = facebook::fb303;
+
+namespace {
+// Name of the node all others are connected to
+const std::string kHubName{"hub"};
+
+// Counter of hello packets which passed rate limiting and iface lookup
+const std::string kPacketsProcessedCounter{"spark.hello_packet_processed.sum"};
+
+// Long timers, so that periodic packets don't interfere with measurements
+const int32_t kHelloTimeS{60};
+const int32_t kKeepAliveTimeS{20};
+const int32_t kHoldTimeS{60};
+const int32_t kGracefulRestartTimeS{60};
+
+// CPU time consumed so far by the calling thread
+std::chrono::nanoseconds
+getThreadCpuTime() {
+  struct timespec ts;
+  CHECK_EQ(0, clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts));
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+int64_t
+getPacketsProcessed() {
+  auto counters = fb303::fbData->getCounters();
+  auto it = counters.find(kPacketsProcessedCounter);
+  return it == counters.end() ? 0 : it->second;
+}
+} // namespace
+
+namespace openr {
+
+/**
+ * Hub and spoke topology over MockIoProvider. Each of numNodes spokes is
+ * connected to the hub over numIfaces interfaces, so hub has
+ * numNodes * numIfaces neighbors, like a box with as many ports.
+ */
+class SparkBenchmarkTopology {
+ public:
+  SparkBenchmarkTopology(uint32_t numNodes, uint32_t numIfaces)
+      : numNodes_(numNodes), numIfaces_(numIfaces) {
+    mockIoProvider_ = std::make_shared<MockIoProvider>();
+    mockIoProviderThread_ = std::make_unique<std::thread>(
+        [this]() { mockIoProvider_->start(); });
+    mockIoProvider_->waitUntilRunning();
+
+    IfNameAndifIndex ifIndexes;
+    ConnectedIfPairs connectedPairs;
+    int ifIndex{0};
+    for (uint32_t node = 0; node < numNodes_; ++node) {
+      for (uint32_t iface = 0; iface < numIfaces_; ++iface) {
+        SparkInterfaceEntry hubIface{
+            folly::sformat("{}-{}-{}", kHubName, node, iface),
+            ++ifIndex,
+            folly::IPAddress::createNetwork("0.0.0.0/32"),
+            folly::IPAddress::createNetwork(
+                folly::sformat("fe80::{:x}:1/128", ifIndex))};
+        SparkInterfaceEntry spokeIface{
+            folly::sformat("{}-{}", getSpokeName(node), iface),
+            ++ifIndex,
+            folly::IPAddress::createNetwork("0.0.0.0/32"),
+            folly::IPAddress::createNetwork(
+                folly::sformat("fe80::{:x}:2/128", ifIndex))};
+        ifIndexes.emplace_back(hubIface.ifName, hubIface.ifIndex);
+        ifIndexes.emplace_back(spokeIface.ifName, spokeIface.ifIndex);
+        connectedPairs[hubIface.ifName] = {{spokeIface.ifName, 0}};
+        connectedPairs[spokeIface.ifName] = {{hubIface.ifName, 0}};
+        hubIfaces_.emplace_back(std::move(hubIface));
+        spokeIfaces_.emplace_back(std::move(spokeIface));
+      }
+    }
+    mockIoProvider_->addIfNameIfIndex(ifIndexes);
+    mockIoProvider_->setConnectedPairs(connectedPairs);
+
+    hub_ = createSpark(kHubName);
+    for (uint32_t node = 0; node < numNodes_; ++node) {
+      spokes_.emplace_back(createSpark(getSpokeName(node)));
+    }
+  }
+
+  ~SparkBenchmarkTopology() {
+    // Spark floods restarting packets over MockIoProvider while stopping
+    spokes_.clear();
+    hub_.reset();
+    mockIoProvider_->stop();
+    mockIoProviderThread_->join();
+  }
+
+  uint32_t
+  getNumNeighbors() const {
+    return numNodes_ * numIfaces_;
+  }
+
+  // hand interfaces to all Spark instances, which starts neighbor discovery
+  void
+  start() {
+    CHECK(hub_->updateInterfaceDb(hubIfaces_));
+    for (uint32_t node = 0; node < numNodes_; ++node) {
+      std::vector<SparkInterfaceEntry> ifaces(
+          spokeIfaces_.begin() + node * numIfaces_,
+          spokeIfaces_.begin() + (node + 1) * numIfaces_);
+      CHECK(spokes_.at(node)->updateInterfaceDb(ifaces));
+    }
+  }
+
+  // wait until hub has ESTABLISHED adjacency with all of its neighbors
+  void
+  waitForAdjacencies() {
+    for (uint32_t i = 0; i < getNumNeighbors(); ++i) {
+      CHECK(hub_->waitForEvent(
+                    thrift::SparkNeighborEventType::NEIGHBOR_UP,
+                    std::chrono::seconds(kHoldTimeS),
+                    std::chrono::seconds(kHoldTimeS))
+                .has_value());
+    }
+  }
+
+  // send one heartbeat from every neighbor to hub, as in one keep-alive
+  // interval, on behalf of the Spark instances of the spokes
+  void
+  sendHeartbeats() {
+    if (heartbeatFd_ < 0) {
+      heartbeatFd_ = mockIoProvider_->socket(AF_INET6, SOCK_DGRAM, 0);
+    }
+
+    ++heartbeatSeqNum_;
+    std::vector<std::tuple<int, folly::IPAddressV6, std::string>> packets;
+    for (uint32_t node = 0; node < numNodes_; ++node) {
+      thrift::SparkHeartbeatMsg heartbeatMsg;
+      heartbeatMsg.nodeName_ref() = getSpokeName(node);
+      heartbeatMsg.seqNum_ref() = heartbeatSeqNum_;
+      thrift::SparkHelloPacket helloPacket;
+      helloPacket.heartbeatMsg_ref() = std::move(heartbeatMsg);
+      auto packet = fbzmq::util::writeThriftObjStr(helloPacket, serializer_);
+      for (uint32_t iface = 0; iface < numIfaces_; ++iface) {
+        auto const& spokeIface = spokeIfaces_.at(node * numIfaces_ + iface);
+        packets.emplace_back(
+            spokeIface.ifIndex,
+            spokeIface.v6LinkLocalNetwork.first.asV6(),
+            packet);
+      }
+    }
+
+    folly::SocketAddress dstAddr(
+        folly::IPAddress(Constants::kSparkMcastAddr.toString()),
+        Constants::kSparkMcastPort);
+    for (auto sent : IoProvider::sendMessages(
+             heartbeatFd_, dstAddr, packets, mockIoProvider_.get())) {
+      CHECK_GT(sent, 0);
+    }
+  }
+
+  // CPU time consumed by Spark thread of hub so far
+  std::chrono::nanoseconds
+  getHubCpuTime() {
+    std::chrono::nanoseconds cpuTime{0};
+    hub_->get()->getEvb()->runInEventBaseThreadAndWait(
+        [&cpuTime]() { cpuTime = getThreadCpuTime(); });
+    return cpuTime;
+  }
+
+ private:
+  static std::string
+  getSpokeName(uint32_t node) {
+    return folly::sformat("node-{}", node);
+  }
+
+  std::shared_ptr<SparkWrapper>
+  createSpark(std::string const& nodeName) {
+    auto tConfig = getBasicOpenrConfig(
+        nodeName, "domain", {} /* areas */, false /* enableV4 */);
+    auto& sparkConfig = *tConfig.spark_config_ref();
+    sparkConfig.hello_time_s_ref() = kHelloTimeS;
+    sparkConfig.keepalive_time_s_ref() = kKeepAliveTimeS;
+    sparkConfig.hold_time_s_ref() = kHoldTimeS;
+    sparkConfig.graceful_restart_time_s_ref() = kGracefulRestartTimeS;
+    return std::make_shared<SparkWrapper>(
+        nodeName,
+        std::make_pair(
+            Constants::kOpenrVersion, Constants::kOpenrSupportedVersion),
+        mockIoProvider_,
+        std::make_shared<Config>(tConfig));
+  }
+
+  const uint32_t numNodes_{0};
+  const uint32_t numIfaces_{0};
+
+  std::shared_ptr<MockIoProvider> mockIoProvider_;
+  std::unique_ptr<std::thread> mockIoProviderThread_;
+
+  std::vector<SparkInterfaceEntry> hubIfaces_;
+  std::vector<SparkInterfaceEntry> spokeIfaces_;
+
+  std::shared_ptr<SparkWrapper> hub_;
+  std::vector<std::shared_ptr<SparkWrapper>> spokes_;
+
+  // socket to inject heartbeats from
+  int heartbeatFd_{-1};
+  int64_t heartbeatSeqNum_{0};
+  apache::thrift::CompactSerializer serializer_;
+};
+
+/**
+ * Benchmark for neighbor discovery:
+ * 1. Bring up hub and spokes with interfaces
+ * 2. Measure time until hub has ESTABLISHED adjacency with all neighbors
+ */
+static void
+BM_SparkAdjacencyEstablish(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numNodes,
+    uint32_t numIfaces) {
+  auto suspender = folly::BenchmarkSuspender();
+  std::chrono::nanoseconds hubCpuTime{0};
+  uint32_t numNeighbors{0};
+
+  for (uint32_t i = 0; i < iters; ++i) {
+    auto topology =
+        std::make_unique<SparkBenchmarkTopology>(numNodes, numIfaces);
+    numNeighbors = topology->getNumNeighbors();
+    auto const cpuTimeBefore = topology->getHubCpuTime();
+
+    suspender.dismiss(); // Start measuring benchmark time
+    topology->start();
+    topology->waitForAdjacencies();
+    suspender.rehire(); // Stop measuring benchmark time
+
+    hubCpuTime += topology->getHubCpuTime() - cpuTimeBefore;
+  }
+
+  counters["neighbors"] = numNeighbors;
+  counters["hub_cpu_us_per_neighbor"] =
+      std::chrono::duration_cast<std::chrono::microseconds>(hubCpuTime)
+          .count() /
+      (iters * numNeighbors);
+}
+
+/**
+ * Benchmark for heartbeat processing:
+ * 1. Bring up hub and spokes and wait for adjacencies
+ * 2. Send one heartbeat per neighbor to hub and measure till all of them are
+ *    processed, per iteration
+ */
+static void
+BM_SparkHeartbeatProcessing(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numNodes,
+    uint32_t numIfaces) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto topology = std::make_unique<SparkBenchmarkTopology>(numNodes, numIfaces);
+  topology->start();
+  topology->waitForAdjacencies();
+  auto const numNeighbors = topology->getNumNeighbors();
+  auto const cpuTimeBefore = topology->getHubCpuTime();
+
+  suspender.dismiss(); // Start measuring benchmark time
+  for (uint32_t i = 0; i < iters; ++i) {
+    auto const processedBefore = getPacketsProcessed();
+    topology->sendHeartbeats();
+    while (getPacketsProcessed() - processedBefore < numNeighbors) {
+      std::this_thread::yield();
+    }
+  }
+  suspender.rehire(); // Stop measuring benchmark time
+
+  auto const hubCpuTime = topology->getHubCpuTime() - cpuTimeBefore;
+  counters["neighbors"] = numNeighbors;
+  counters["hub_cpu_ns_per_heartbeat"] =
+      hubCpuTime.count() / (static_cast<int64_t>(iters) * numNeighbors);
+}
+
+// The first integer parameter is number of spoke nodes
+// The second integer parameter is number of interfaces per spoke node
+BENCHMARK_COUNTERS_NAME_PARAM(BM_SparkAdjacencyEstablish, counters, 1_1, 1, 1);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_SparkAdjacencyEstablish, counters, 8_4, 8, 4);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_SparkAdjacencyEstablish, counters, 64_1, 64, 1);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_SparkAdjacencyEstablish, counters, 64_4, 64, 4);
+
+BENCHMARK_COUNTERS_NAME_PARAM(BM_SparkHeartbeatProcessing, counters, 1_1, 1, 1);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_SparkHeartbeatProcessing, counters, 8_4, 8, 4);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_SparkHeartbeatProcessing, counters, 64_1, 64, 1);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_SparkHeartbeatProcessing, counters, 64_4, 64, 4);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  return openr::runBenchmarks();
+}
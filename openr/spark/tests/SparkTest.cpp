@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <net/if.h>
 #include <chrono>
 #include <thread>
 
@@ -14,9 +15,11 @@
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include <fb303/ServiceData.h>
+#include <folly/ScopeGuard.h>
 #include <openr/common/Constants.h>
 #include <openr/common/NetworkUtil.h>
 #include <openr/common/Util.h>
+#include <openr/config-store/PersistentStore.h>
 #include <openr/config/Config.h>
 #include <openr/config/tests/Utils.h>
 #include <openr/spark/SparkWrapper.h>
@@ -68,6 +71,56 @@ const auto RESTART = SparkNeighState::RESTART;
 
 // Domain name (same for all Tests except in DomainTest)
 const std::string kDomainName("Fire_and_Blood");
+
+// Liveness provider recording sessions, with failures injected by test
+class MockLivenessProvider : public LivenessProvider {
+ public:
+  void
+  setSessionDownCallback(SessionDownCallback callback) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callback_ = std::move(callback);
+  }
+
+  void
+  addSession(Session const& session) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sessions_[{session.ifName, session.neighborName}] = session;
+  }
+
+  void
+  removeSession(
+      std::string const& ifName, std::string const& neighborName) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sessions_.erase({ifName, neighborName});
+  }
+
+  std::optional<Session>
+  getSession(std::string const& ifName, std::string const& neighborName) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find({ifName, neighborName});
+    if (it == sessions_.end()) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  // report session as down, as BFD would on missed packets
+  void
+  sessionDown(std::string const& ifName, std::string const& neighborName) {
+    SessionDownCallback callback;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      callback = callback_;
+    }
+    ASSERT_TRUE(callback);
+    callback(ifName, neighborName);
+  }
+
+ private:
+  std::mutex mutex_;
+  SessionDownCallback callback_;
+  std::map<std::pair<std::string, std::string>, Session> sessions_;
+};
 }; // namespace
 
 class SparkFixture : public testing::Test {
@@ -109,7 +162,7 @@ class SparkFixture : public testing::Test {
 class SimpleSparkFixture : public SparkFixture {
  protected:
   void
-  createAndConnect() {
+  createAndConnect(bool enableCompactHeartbeat = false) {
     // Define interface names for the test
     mockIoProvider_->addIfNameIfIndex({{iface1, ifIndex1}, {iface2, ifIndex2}});
 
@@ -121,9 +174,13 @@ class SimpleSparkFixture : public SparkFixture {
     mockIoProvider_->setConnectedPairs(connectedPairs);
 
     auto tConfig1 = getBasicOpenrConfig("node-1", kDomainName);
+    tConfig1.spark_config_ref()->enable_compact_heartbeat_ref() =
+        enableCompactHeartbeat;
     auto config1 = std::make_shared<Config>(tConfig1);
 
     auto tConfig2 = getBasicOpenrConfig("node-2", kDomainName);
+    tConfig2.spark_config_ref()->enable_compact_heartbeat_ref() =
+        enableCompactHeartbeat;
     auto config2 = std::make_shared<Config>(tConfig2);
 
     // start one spark2 instance
@@ -392,6 +449,85 @@ TEST_F(SimpleSparkFixture, GRTest) {
   checkCounters();
 }
 
+//
+// Start 2 Spark instances and wait them forming adj. Then gracefully restart
+// one of them with restart resync enabled. It reinstates its neighbor on the
+// first heartbeat received, keeping the label, before any negotiation.
+//
+TEST_F(SimpleSparkFixture, GRResyncTest) {
+  mockIoProvider_->addIfNameIfIndex({{iface1, ifIndex1}, {iface2, ifIndex2}});
+  ConnectedIfPairs connectedPairs = {
+      {iface1, {{iface2, 10}}},
+      {iface2, {{iface1, 10}}},
+  };
+  mockIoProvider_->setConnectedPairs(connectedPairs);
+
+  // config store of node-2, kept across its restart
+  auto configStore = std::make_unique<PersistentStore>(
+      folly::sformat("/tmp/openr.spark.{}", ::getpid()), true /* dryrun */);
+  std::thread configStoreThread([&]() noexcept { configStore->run(); });
+  configStore->waitUntilRunning();
+  SCOPE_EXIT {
+    node2.reset();
+    configStore->stop();
+    configStore->waitUntilStopped();
+    configStoreThread.join();
+  };
+
+  auto createNode2 = [&](int32_t helloTimeMs) {
+    auto tConfig = getBasicOpenrConfig("node-2", kDomainName);
+    tConfig.spark_config_ref()->enable_restart_resync_ref() = true;
+    tConfig.spark_config_ref()->fastinit_hello_time_ms_ref() = helloTimeMs;
+    return std::make_shared<SparkWrapper>(
+        "node-2",
+        std::make_pair(
+            Constants::kOpenrVersion, Constants::kOpenrSupportedVersion),
+        mockIoProvider_,
+        std::make_shared<Config>(tConfig),
+        true /* isRateLimitEnabled */,
+        0 /* shardId */,
+        nullptr /* livenessProvider */,
+        configStore.get());
+  };
+
+  node1 = createSpark(
+      "node-1",
+      std::make_shared<Config>(getBasicOpenrConfig("node-1", kDomainName)));
+  node2 = createNode2(50);
+  EXPECT_TRUE(node1->updateInterfaceDb({{iface1, ifIndex1, ip1V4, ip1V6}}));
+  EXPECT_TRUE(node2->updateInterfaceDb({{iface2, ifIndex2, ip2V4, ip2V6}}));
+
+  ASSERT_TRUE(node1->waitForEvent(NB_UP).has_value());
+  auto event = node2->waitForEvent(NB_UP);
+  ASSERT_TRUE(event.has_value());
+  const auto label = *event->info_ref()->label_ref();
+
+  LOG(INFO) << "Gracefully restart node-2";
+  node2.reset();
+  ASSERT_TRUE(node1->waitForEvent(NB_RESTARTING).has_value());
+
+  // hellos of node-2 are slower than heartbeats of node-1 now, so that
+  // adjacency can't be negotiated before a heartbeat is received
+  node2 = createNode2(2000);
+  EXPECT_TRUE(node2->updateInterfaceDb({{iface2, ifIndex2, ip2V4, ip2V6}}));
+
+  event = node2->waitForEvent(NB_UP);
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ("node-1", *event->info_ref()->nodeName_ref());
+  EXPECT_EQ(label, *event->info_ref()->label_ref());
+  EXPECT_EQ(
+      std::make_pair(ip1V4.first, ip1V6.first),
+      SparkWrapper::getTransportAddrs(*event));
+  EXPECT_TRUE(node2->getSparkNeighState(iface2, "node-1") == ESTABLISHED);
+
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_EQ(1, counters["spark.neighbor.restored.sum"]);
+  EXPECT_EQ(1, counters.count("slo.neighbor_resync.time_ms.avg"));
+
+  // node-1 sees node-2 back once it hears from it
+  EXPECT_TRUE(node1->waitForEvent(NB_RESTARTED).has_value());
+}
+
 //
 // Start 2 Spark instances and wait them forming adj. Then
 // gracefully shut down one of them but NOT bring it back,
@@ -460,6 +596,130 @@ TEST_F(SimpleSparkFixture, HeartbeatTimerExpireTest) {
   }
 }
 
+//
+// Start 2 Spark instances with compact heartbeats enabled and wait them
+// forming adj. Adjacency must be kept alive by compact heartbeats.
+//
+TEST_F(SimpleSparkFixture, CompactHeartbeatTest) {
+  // create Spark instances and establish connections
+  createAndConnect(true /* enableCompactHeartbeat */);
+
+  // hold timers only get refreshed by heartbeats once adjacency is formed
+  const std::chrono::seconds holdTime(
+      *node1->getSparkConfig().hold_time_s_ref());
+  EXPECT_FALSE(
+      node1->waitForEvent(NB_DOWN, 3 * holdTime, 3 * holdTime).has_value());
+  EXPECT_FALSE(
+      node2->waitForEvent(NB_DOWN, 3 * holdTime, 3 * holdTime).has_value());
+
+  auto counters = fb303::fbData->getCounters();
+  ASSERT_EQ(1, counters.count("spark.heartbeat.compact_packets_sent.sum"));
+  EXPECT_LT(0, counters["spark.heartbeat.compact_packets_sent.sum"]);
+}
+
+TEST(SparkTest, CompactHeartbeatEncoding) {
+  Spark::CompactHeartbeat heartbeat{
+      0xdeadbeef, 0x0102030405060708, std::chrono::microseconds(1234567)};
+  auto packet = Spark::encodeCompactHeartbeat(heartbeat);
+  ASSERT_EQ(24, packet.size());
+  const auto* buf = reinterpret_cast<const uint8_t*>(packet.data());
+  EXPECT_TRUE(Spark::isCompactPacket(buf, packet.size()));
+  // network byte order
+  EXPECT_EQ(0xde, buf[4]);
+  EXPECT_EQ(0x01, buf[8]);
+
+  auto decoded = Spark::decodeCompactHeartbeat(buf, packet.size());
+  ASSERT_TRUE(decoded.has_value());
+  EXPECT_EQ(heartbeat.senderId, decoded->senderId);
+  EXPECT_EQ(heartbeat.seqNum, decoded->seqNum);
+  EXPECT_EQ(heartbeat.sentTime, decoded->sentTime);
+
+  // truncated or unknown version
+  EXPECT_FALSE(Spark::decodeCompactHeartbeat(buf, packet.size() - 1));
+  packet[1] = 2;
+  EXPECT_TRUE(Spark::isCompactPacket(buf, packet.size()));
+  EXPECT_FALSE(Spark::decodeCompactHeartbeat(buf, packet.size()));
+
+  // thrift encoded packets are never taken for compact ones
+  thrift::SparkHelloPacket helloPacket;
+  helloPacket.heartbeatMsg_ref() = thrift::SparkHeartbeatMsg();
+  CompactSerializer serializer;
+  auto thriftPacket = fbzmq::util::writeThriftObjStr(helloPacket, serializer);
+  EXPECT_FALSE(Spark::isCompactPacket(
+      reinterpret_cast<const uint8_t*>(thriftPacket.data()),
+      thriftPacket.size()));
+}
+
+//
+// Ingress filter attached to a real socket on loopback drops packets of
+// other interfaces and with lower hop limit in the kernel
+//
+TEST(SparkTest, IngressFilter) {
+  IoProvider ioProvider;
+  const int loIfIndex = if_nametoindex("lo");
+  const int rxFd = ioProvider.socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+  const int txFd = ioProvider.socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+  ASSERT_LE(0, rxFd);
+  ASSERT_LE(0, txFd);
+  SCOPE_EXIT {
+    ::close(rxFd);
+    ::close(txFd);
+  };
+
+  sockaddr_storage addrStorage;
+  folly::SocketAddress rxAddr("::1", 0);
+  rxAddr.getAddress(&addrStorage);
+  if (loIfIndex == 0 or
+      ioProvider.bind(
+          rxFd,
+          reinterpret_cast<sockaddr*>(&addrStorage),
+          rxAddr.getActualSize()) != 0) {
+    GTEST_SKIP() << "IPv6 loopback is not available";
+  }
+  rxAddr.setFromLocalAddress(folly::NetworkSocket::fromFd(rxFd));
+  rxAddr.getAddress(&addrStorage);
+
+  // whether a packet sent with given hop limit gets through
+  auto received = [&](int hopLimit) {
+    EXPECT_EQ(
+        0,
+        ioProvider.setsockopt(
+            txFd,
+            IPPROTO_IPV6,
+            IPV6_UNICAST_HOPS,
+            &hopLimit,
+            sizeof(hopLimit)));
+    EXPECT_EQ(
+        1,
+        ioProvider.sendto(
+            txFd,
+            "x",
+            1,
+            0,
+            reinterpret_cast<sockaddr*>(&addrStorage),
+            rxAddr.getActualSize()));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    char buf[8];
+    return ioProvider.recvfrom(
+               rxFd, buf, sizeof(buf), MSG_DONTWAIT, nullptr, nullptr) > 0;
+  };
+
+  ASSERT_TRUE(IoProvider::attachIngressFilter(
+      rxFd, {loIfIndex + 1, loIfIndex}, 255, &ioProvider));
+  EXPECT_TRUE(received(255));
+  EXPECT_FALSE(received(64));
+
+  ASSERT_TRUE(
+      IoProvider::attachIngressFilter(rxFd, {loIfIndex + 1}, 255, &ioProvider));
+  EXPECT_FALSE(received(255));
+
+  // too long a program for the kernel, filter is removed instead
+  std::vector<int> ifIndexes(BPF_MAXINSNS, loIfIndex + 1);
+  EXPECT_FALSE(
+      IoProvider::attachIngressFilter(rxFd, ifIndexes, 255, &ioProvider));
+  EXPECT_TRUE(received(64));
+}
+
 //
 // Start 2 Spark instances and wait them forming adj. Then
 // remove/add interface from one instance's perspective
@@ -784,6 +1044,101 @@ TEST_F(SparkFixture, HubAndSpokeTopology) {
   }
 }
 
+//
+// Run node-1 as two Spark shards, both fed the same interfaces. Each shard
+// must form adjacency only over the interface it owns.
+//
+TEST_F(SparkFixture, ShardedSparkTest) {
+  const std::string iface1_2{"iface1_2"};
+  const std::string iface1_3{"iface1_3"};
+  const int ifIndex1_2{12};
+  const int ifIndex1_3{13};
+  auto ip1V4_2 = folly::IPAddress::createNetwork("192.168.0.12", 24, true);
+  auto ip1V4_3 = folly::IPAddress::createNetwork("192.168.0.13", 24, true);
+  auto ip1V6_2 = folly::IPAddress::createNetwork("fe80::12:1/128");
+  auto ip1V6_3 = folly::IPAddress::createNetwork("fe80::13:1/128");
+
+  const uint32_t numShards{2};
+  const auto shard1_2 = Spark::getInterfaceShard(iface1_2, numShards);
+  const auto shard1_3 = Spark::getInterfaceShard(iface1_3, numShards);
+  ASSERT_NE(shard1_2, shard1_3);
+  EXPECT_EQ(shard1_2, Spark::getInterfaceShard(iface1_2, numShards));
+  EXPECT_EQ(0, Spark::getInterfaceShard(iface1_2, 1));
+
+  mockIoProvider_->addIfNameIfIndex({{iface1_2, ifIndex1_2},
+                                     {iface1_3, ifIndex1_3},
+                                     {iface2, ifIndex2},
+                                     {iface3, ifIndex3}});
+
+  ConnectedIfPairs connectedPairs = {{iface1_2, {{iface2, 10}}},
+                                     {iface1_3, {{iface3, 10}}},
+                                     {iface2, {{iface1_2, 10}}},
+                                     {iface3, {{iface1_3, 10}}}};
+  mockIoProvider_->setConnectedPairs(connectedPairs);
+
+  const std::string nodeName1 = "node-1";
+  const std::string nodeName2 = "node-2";
+  const std::string nodeName3 = "node-3";
+
+  auto tConfig1 = getBasicOpenrConfig(nodeName1, kDomainName);
+  tConfig1.spark_config_ref()->num_shards_ref() = numShards;
+  auto config1 = std::make_shared<Config>(tConfig1);
+  auto config2 =
+      std::make_shared<Config>(getBasicOpenrConfig(nodeName2, kDomainName));
+  auto config3 =
+      std::make_shared<Config>(getBasicOpenrConfig(nodeName3, kDomainName));
+
+  std::vector<std::shared_ptr<SparkWrapper>> node1Shards;
+  for (uint32_t shardId = 0; shardId < numShards; ++shardId) {
+    node1Shards.emplace_back(std::make_shared<SparkWrapper>(
+        nodeName1,
+        std::make_pair(
+            Constants::kOpenrVersion, Constants::kOpenrSupportedVersion),
+        mockIoProvider_,
+        config1,
+        true /* isRateLimitEnabled */,
+        shardId));
+  }
+  auto node2 = createSpark(nodeName2, config2);
+  auto node3 = createSpark(nodeName3, config3);
+
+  for (auto& shard : node1Shards) {
+    EXPECT_TRUE(
+        shard->updateInterfaceDb({{iface1_2, ifIndex1_2, ip1V4_2, ip1V6_2},
+                                  {iface1_3, ifIndex1_3, ip1V4_3, ip1V6_3}}));
+  }
+  EXPECT_TRUE(node2->updateInterfaceDb({{iface2, ifIndex2, ip2V4, ip2V6}}));
+  EXPECT_TRUE(node3->updateInterfaceDb({{iface3, ifIndex3, ip3V4, ip3V6}}));
+
+  // node-2 and node-3 see single node-1
+  {
+    auto event1 = node2->waitForEvent(NB_UP);
+    ASSERT_TRUE(event1.has_value());
+    EXPECT_EQ(nodeName1, *event1->info_ref()->nodeName_ref());
+    auto event2 = node3->waitForEvent(NB_UP);
+    ASSERT_TRUE(event2.has_value());
+    EXPECT_EQ(nodeName1, *event2->info_ref()->nodeName_ref());
+  }
+
+  // every shard of node-1 reports neighbor on its own interface only
+  {
+    auto event1 = node1Shards.at(shard1_2)->waitForEvent(NB_UP);
+    ASSERT_TRUE(event1.has_value());
+    EXPECT_EQ(nodeName2, *event1->info_ref()->nodeName_ref());
+    EXPECT_EQ(iface1_2, *event1->info_ref()->localIfName_ref());
+
+    auto event2 = node1Shards.at(shard1_3)->waitForEvent(NB_UP);
+    ASSERT_TRUE(event2.has_value());
+    EXPECT_EQ(nodeName3, *event2->info_ref()->nodeName_ref());
+    EXPECT_EQ(iface1_3, *event2->info_ref()->localIfName_ref());
+
+    for (auto& shard : node1Shards) {
+      auto neighbors = shard->get()->getNeighbors().get();
+      EXPECT_EQ(1, neighbors->size());
+    }
+  }
+}
+
 TEST_F(SparkFixture, FastInitTest) {
   // Define interface names for the test
   mockIoProvider_->addIfNameIfIndex({{iface1, ifIndex1}, {iface2, ifIndex2}});
@@ -1056,6 +1411,130 @@ TEST_F(SparkFixture, IgnoreUnidirectionalPeer) {
   }
 }
 
+//
+// Start 2 Spark instances, one of them offloading failure detection to
+// liveness provider. Make sure session is set up on adjacency and its loss
+// brings neighbor down well before heartbeat hold time.
+//
+TEST_F(SparkFixture, LivenessOffloadTest) {
+  mockIoProvider_->addIfNameIfIndex({{iface1, ifIndex1}, {iface2, ifIndex2}});
+  ConnectedIfPairs connectedPairs = {
+      {iface1, {{iface2, 10}}},
+      {iface2, {{iface1, 10}}},
+  };
+  mockIoProvider_->setConnectedPairs(connectedPairs);
+
+  auto tConfig1 = getBasicOpenrConfig("node-1", kDomainName);
+  tConfig1.spark_config_ref()->liveness_detect_time_ms_ref() = 50;
+  auto config1 = std::make_shared<Config>(tConfig1);
+  auto config2 =
+      std::make_shared<Config>(getBasicOpenrConfig("node-2", kDomainName));
+
+  auto livenessProvider = std::make_shared<MockLivenessProvider>();
+  auto node1 = std::make_shared<SparkWrapper>(
+      "node-1",
+      std::make_pair(
+          Constants::kOpenrVersion, Constants::kOpenrSupportedVersion),
+      mockIoProvider_,
+      config1,
+      true /* isRateLimitEnabled */,
+      0 /* shardId */,
+      livenessProvider);
+  auto node2 = createSpark("node-2", config2);
+
+  EXPECT_TRUE(node1->updateInterfaceDb({{iface1, ifIndex1, ip1V4, ip1V6}}));
+  EXPECT_TRUE(node2->updateInterfaceDb({{iface2, ifIndex2, ip2V4, ip2V6}}));
+
+  ASSERT_TRUE(node1->waitForEvent(NB_UP).has_value());
+  ASSERT_TRUE(node2->waitForEvent(NB_UP).has_value());
+
+  auto session = livenessProvider->getSession(iface1, "node-2");
+  ASSERT_TRUE(session.has_value());
+  EXPECT_EQ(ifIndex1, session->ifIndex);
+  EXPECT_EQ(ip1V6.first.asV6(), session->localAddr);
+  EXPECT_EQ(ip2V6.first.asV6(), session->remoteAddr);
+  EXPECT_EQ(std::chrono::milliseconds(50), session->detectTime);
+
+  // stale session reports are ignored
+  livenessProvider->sessionDown(iface2, "node-3");
+
+  // neighbor goes down right away, not after hold time
+  livenessProvider->sessionDown(iface1, "node-2");
+  const std::chrono::milliseconds holdTime(
+      std::chrono::seconds(*config1->getSparkConfig().hold_time_s_ref()));
+  auto event = node1->waitForEvent(NB_DOWN, holdTime / 4, holdTime / 2);
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ("node-2", *event->info_ref()->nodeName_ref());
+  EXPECT_FALSE(livenessProvider->getSession(iface1, "node-2").has_value());
+}
+
+//
+// Interface with adaptive intervals probes faster right after adjacency came
+// up, without the neighbor on default intervals losing it.
+//
+TEST_F(SparkFixture, AdaptiveIntervalsTest) {
+  mockIoProvider_->addIfNameIfIndex({{iface1, ifIndex1}, {iface2, ifIndex2}});
+  ConnectedIfPairs connectedPairs = {
+      {iface1, {{iface2, 10}}},
+      {iface2, {{iface1, 10}}},
+  };
+  mockIoProvider_->setConnectedPairs(connectedPairs);
+
+  auto tConfig1 = getBasicOpenrConfig("node-1", kDomainName);
+  tConfig1.spark_config_ref()->enable_adaptive_intervals_ref() = true;
+  auto config1 = std::make_shared<Config>(tConfig1);
+  auto config2 =
+      std::make_shared<Config>(getBasicOpenrConfig("node-2", kDomainName));
+
+  auto node1 = createSpark("node-1", config1);
+  auto node2 = createSpark("node-2", config2);
+
+  EXPECT_TRUE(node1->updateInterfaceDb({{iface1, ifIndex1, ip1V4, ip1V6}}));
+  EXPECT_TRUE(node2->updateInterfaceDb({{iface2, ifIndex2, ip2V4, ip2V6}}));
+
+  ASSERT_TRUE(node1->waitForEvent(NB_UP).has_value());
+  ASSERT_TRUE(node2->waitForEvent(NB_UP).has_value());
+
+  // outlast hold time and counter update interval
+  const std::chrono::milliseconds holdTime(
+      std::chrono::seconds(*config1->getSparkConfig().hold_time_s_ref()));
+  EXPECT_FALSE(
+      node2->waitForEvent(NB_DOWN, 3 * holdTime, 3 * holdTime).has_value());
+
+  // state changed recently, both intervals are halved
+  const std::chrono::milliseconds helloTime(
+      std::chrono::seconds(*config1->getSparkConfig().hello_time_s_ref()));
+  const std::chrono::milliseconds keepAliveTime(
+      std::chrono::seconds(*config1->getSparkConfig().keepalive_time_s_ref()));
+  auto counters = fb303::fbData->getCounters();
+  ASSERT_EQ(1, counters.count("spark.hello_interval_ms." + iface1));
+  EXPECT_EQ(
+      helloTime.count() / 2, counters["spark.hello_interval_ms." + iface1]);
+  ASSERT_EQ(1, counters.count("spark.heartbeat_interval_ms." + iface1));
+  EXPECT_EQ(
+      keepAliveTime.count() / 2,
+      counters["spark.heartbeat_interval_ms." + iface1]);
+  EXPECT_EQ(0, counters.count("spark.heartbeat_interval_ms." + iface2));
+}
+
+TEST(SparkTest, AdaptiveInterval) {
+  using namespace std::chrono_literals;
+
+  // recent state change
+  EXPECT_EQ(500ms, Spark::getAdaptiveInterval(1s, 0s, 10s));
+  EXPECT_EQ(500ms, Spark::getAdaptiveInterval(1s, 59s, 10s));
+
+  // doubled per stable period, up to max factor
+  EXPECT_EQ(1s, Spark::getAdaptiveInterval(1s, 2min, 10s));
+  EXPECT_EQ(2s, Spark::getAdaptiveInterval(1s, 6min, 10s));
+  EXPECT_EQ(4s, Spark::getAdaptiveInterval(1s, 11min, 10s));
+  EXPECT_EQ(4s, Spark::getAdaptiveInterval(1s, 24h, 10s));
+
+  // bounded, but never longer than configured
+  EXPECT_EQ(3s, Spark::getAdaptiveInterval(1s, 24h, 3s));
+  EXPECT_EQ(1s, Spark::getAdaptiveInterval(1s, 24h, 500ms));
+}
+
 //
 // Start 1 Spark instace and make its interfaces connected to its own
 // Make sure pkt loop can be handled gracefully and no ADJ will be formed.
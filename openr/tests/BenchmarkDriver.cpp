@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/tests/BenchmarkDriver.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <unordered_map>
+
+#include <folly/Benchmark.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/json.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <openr/monitor/SystemMetrics.h>
+
+DEFINE_string(
+    bm_output_json, "", "Write benchmark results as JSON report to this file");
+DEFINE_string(
+    bm_baseline_json,
+    "",
+    "Compare benchmark results against JSON report of a previous run");
+DEFINE_double(
+    bm_tolerance_pct,
+    10.0,
+    "Max slowdown in percent of a benchmark vs. baseline before failing");
+
+// Defined by folly, results are read back from this file
+DECLARE_string(bm_json_verbose);
+
+namespace openr {
+
+namespace {
+
+folly::dynamic
+readJsonFile(const std::string& path) {
+  std::string data;
+  if (not folly::readFile(path.c_str(), data)) {
+    throw std::runtime_error(folly::sformat("Failed to read {}", path));
+  }
+  return folly::parseJson(data);
+}
+
+} // namespace
+
+folly::dynamic
+toBenchmarkReport(
+    const folly::dynamic& follyResults, std::optional<int64_t> peakRssBytes) {
+  // [[file, name, time_ns, {counter: value or {"value": .., "type": ..}}]]
+  auto benchmarks = folly::dynamic::array();
+  for (const auto& result : follyResults) {
+    const auto& name = result.at(1).asString();
+    // separator lines of BENCHMARK_DRAW_LINE()
+    if (name == "-") {
+      continue;
+    }
+    auto counters = folly::dynamic::object();
+    if (result.size() > 3) {
+      for (const auto& [key, value] : result.at(3).items()) {
+        counters[key] = value.isObject() ? value.at("value") : value;
+      }
+    }
+    benchmarks.push_back(folly::dynamic::object("name", name)(
+        "time_ns", result.at(2).asDouble())("counters", std::move(counters)));
+  }
+
+  auto report = folly::dynamic::object("benchmarks", std::move(benchmarks));
+  if (peakRssBytes.has_value()) {
+    report["peak_rss_bytes"] = peakRssBytes.value();
+  }
+  return report;
+}
+
+std::vector<BenchmarkComparison>
+compareBenchmarkReports(
+    const folly::dynamic& baseline,
+    const folly::dynamic& current,
+    double tolerancePct) {
+  std::unordered_map<std::string, double> baselineNs;
+  for (const auto& benchmark : baseline.at("benchmarks")) {
+    baselineNs[benchmark.at("name").asString()] =
+        benchmark.at("time_ns").asDouble();
+  }
+
+  std::vector<BenchmarkComparison> comparisons;
+  for (const auto& benchmark : current.at("benchmarks")) {
+    const auto& name = benchmark.at("name").asString();
+    auto it = baselineNs.find(name);
+    if (it == baselineNs.end()) {
+      continue;
+    }
+    BenchmarkComparison comparison;
+    comparison.name = name;
+    comparison.baselineNs = it->second;
+    comparison.currentNs = benchmark.at("time_ns").asDouble();
+    comparison.regressed = comparison.currentNs >
+        comparison.baselineNs * (1 + tolerancePct / 100);
+    comparisons.emplace_back(std::move(comparison));
+  }
+  return comparisons;
+}
+
+int
+runBenchmarks() {
+  const bool report =
+      not FLAGS_bm_output_json.empty() or not FLAGS_bm_baseline_json.empty();
+
+  // have folly write results to a temporary file unless asked to already
+  std::string follyResultsFile = FLAGS_bm_json_verbose;
+  const bool removeFollyResultsFile = report and follyResultsFile.empty();
+  if (removeFollyResultsFile) {
+    char path[] = "/tmp/openr_benchmark_XXXXXX";
+    const int fd = mkstemp(path);
+    PCHECK(fd >= 0) << "Failed to create temporary file";
+    close(fd);
+    follyResultsFile = path;
+    FLAGS_bm_json_verbose = follyResultsFile;
+  }
+
+  folly::runBenchmarks();
+  if (not report) {
+    return 0;
+  }
+
+  const auto follyResults = readJsonFile(follyResultsFile);
+  if (removeFollyResultsFile) {
+    unlink(follyResultsFile.c_str());
+  }
+  const auto current =
+      toBenchmarkReport(follyResults, SystemMetrics().getPeakRSSMemBytes());
+
+  if (not FLAGS_bm_output_json.empty()) {
+    CHECK(folly::writeFile(
+        folly::toPrettyJson(current), FLAGS_bm_output_json.c_str()))
+        << "Failed to write " << FLAGS_bm_output_json;
+  }
+
+  if (FLAGS_bm_baseline_json.empty()) {
+    return 0;
+  }
+  const auto baseline = readJsonFile(FLAGS_bm_baseline_json);
+  int regressions{0};
+  std::cout << folly::sformat(
+                   "{:<60} {:>14} {:>14} {:>9}",
+                   "Comparison to " + FLAGS_bm_baseline_json,
+                   "baseline",
+                   "current",
+                   "change")
+            << std::endl;
+  for (const auto& comparison :
+       compareBenchmarkReports(baseline, current, FLAGS_bm_tolerance_pct)) {
+    const double changePct = comparison.baselineNs > 0
+        ? (comparison.currentNs / comparison.baselineNs - 1) * 100
+        : 0;
+    std::cout << folly::sformat(
+                     "{:<60} {:>12.0f}ns {:>12.0f}ns {:>+8.1f}%{}",
+                     comparison.name,
+                     comparison.baselineNs,
+                     comparison.currentNs,
+                     changePct,
+                     comparison.regressed ? " REGRESSED" : "")
+              << std::endl;
+    regressions += comparison.regressed ? 1 : 0;
+  }
+  if (regressions > 0) {
+    std::cout << folly::sformat(
+                     "{} benchmark(s) regressed by more than {}%",
+                     regressions,
+                     FLAGS_bm_tolerance_pct)
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace openr
@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <folly/dynamic.h>
+
+namespace openr {
+
+/**
+ * Common driver of Open/R benchmark binaries, to be called from main() after
+ * folly::init() instead of folly::runBenchmarks(). Runs the registered
+ * benchmarks and prints their results as usual, and additionally
+ * - with `--bm_output_json=<file>` writes a report of the results for
+ *   tracking them across versions:
+ *     {
+ *       "benchmarks": [{"name": .., "time_ns": .., "counters": {..}}, ..],
+ *       "peak_rss_bytes": ..
+ *     }
+ * - with `--bm_baseline_json=<file>` compares results against a report of a
+ *   previous run, failing if time per iteration of a benchmark regressed by
+ *   more than `--bm_tolerance_pct`
+ *
+ * Returns the exit code of the binary, non-zero on regression.
+ */
+int runBenchmarks();
+
+/**
+ * Report written by --bm_output_json, of results as written by folly's
+ * --bm_json_verbose
+ */
+folly::dynamic toBenchmarkReport(
+    const folly::dynamic& follyResults, std::optional<int64_t> peakRssBytes);
+
+struct BenchmarkComparison {
+  std::string name;
+  double baselineNs{0};
+  double currentNs{0};
+  // slower than baseline by more than tolerance
+  bool regressed{false};
+};
+
+/**
+ * Compare time per iteration of benchmarks in both reports, by name.
+ * Benchmarks missing in either are skipped.
+ */
+std::vector<BenchmarkComparison> compareBenchmarkReports(
+    const folly::dynamic& baseline,
+    const folly::dynamic& current,
+    double tolerancePct);
+
+} // namespace openr
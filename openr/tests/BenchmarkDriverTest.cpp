@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/json.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/tests/BenchmarkDriver.h>
+
+using namespace openr;
+
+TEST(BenchmarkDriverTest, ToBenchmarkReport) {
+  // as written by folly's --bm_json_verbose, counters with or without type
+  const auto follyResults = folly::parseJson(R"([
+    ["Bench.cpp", "BM_Plain", 100.5],
+    ["Bench.cpp", "-", 0],
+    ["Bench.cpp", "BM_Counters(10)", 2000, {"rounds": 3}],
+    ["Bench.cpp", "BM_Typed", 30, {"bytes": {"value": 42, "type": 0}}]
+  ])");
+
+  const auto report = toBenchmarkReport(follyResults, 1024);
+  const auto expected = folly::parseJson(R"({
+    "benchmarks": [
+      {"name": "BM_Plain", "time_ns": 100.5, "counters": {}},
+      {"name": "BM_Counters(10)", "time_ns": 2000.0, "counters": {"rounds": 3}},
+      {"name": "BM_Typed", "time_ns": 30.0, "counters": {"bytes": 42}}
+    ],
+    "peak_rss_bytes": 1024
+  })");
+  EXPECT_EQ(expected, report);
+
+  EXPECT_EQ(0, toBenchmarkReport(follyResults, std::nullopt)
+                   .count("peak_rss_bytes"));
+}
+
+TEST(BenchmarkDriverTest, CompareBenchmarkReports) {
+  const auto baseline = folly::parseJson(R"({
+    "benchmarks": [
+      {"name": "BM_Same", "time_ns": 100, "counters": {}},
+      {"name": "BM_Slower", "time_ns": 100, "counters": {}},
+      {"name": "BM_Faster", "time_ns": 100, "counters": {}},
+      {"name": "BM_Removed", "time_ns": 100, "counters": {}}
+    ]
+  })");
+  const auto current = folly::parseJson(R"({
+    "benchmarks": [
+      {"name": "BM_Same", "time_ns": 105, "counters": {}},
+      {"name": "BM_Slower", "time_ns": 120, "counters": {}},
+      {"name": "BM_Faster", "time_ns": 50, "counters": {}},
+      {"name": "BM_Added", "time_ns": 1000, "counters": {}}
+    ]
+  })");
+
+  // benchmarks in either report only are skipped
+  const auto comparisons = compareBenchmarkReports(baseline, current, 10);
+  ASSERT_EQ(3, comparisons.size());
+  EXPECT_EQ("BM_Same", comparisons.at(0).name);
+  EXPECT_EQ(100, comparisons.at(0).baselineNs);
+  EXPECT_EQ(105, comparisons.at(0).currentNs);
+  EXPECT_FALSE(comparisons.at(0).regressed);
+  EXPECT_EQ("BM_Slower", comparisons.at(1).name);
+  EXPECT_TRUE(comparisons.at(1).regressed);
+  EXPECT_EQ("BM_Faster", comparisons.at(2).name);
+  EXPECT_FALSE(comparisons.at(2).regressed);
+
+  // within larger tolerance
+  EXPECT_FALSE(compareBenchmarkReports(baseline, current, 25).at(1).regressed);
+}
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  return RUN_ALL_TESTS();
+}
@@ -1752,6 +1752,114 @@ TEST(MockIoProviderTestSetup, PartialMeshOfNodesTest) {
   mockIoProviderThread.join();
 }
 
+//
+// This test sends and receives batch of packets on sockets joined on
+// multiple interfaces, like Spark does.
+//
+// topology: 1 -> 3, 2 -> 4, 5 (island)
+//
+TEST(MockIoProviderTestSetup, BatchedSendRecvTest) {
+  folly::IPAddressV6 ipAddr1V6("fe80::1");
+  folly::IPAddressV6 ipAddr2V6("fe80::2");
+  folly::IPAddressV6 ipAddr5V6("fe80::5");
+
+  auto mockIoProvider = std::make_shared<MockIoProvider>();
+
+  // Start mock IoProvider thread
+  std::thread mockIoProviderThread([&]() {
+    LOG(INFO) << "Starting mockIoProvider thread.";
+    mockIoProvider->start();
+    LOG(INFO) << "mockIoProvider thread got stopped.";
+  });
+  mockIoProvider->waitUntilRunning();
+
+  mockIoProvider->addIfNameIfIndex(
+      {{"iface1", 1},
+       {"iface2", 2},
+       {"iface3", 3},
+       {"iface4", 4},
+       {"iface5", 5}});
+
+  ConnectedIfPairs connectedPairs = {
+      {"iface1", {{"iface3", 0}}},
+      {"iface2", {{"iface4", 0}}},
+  };
+  mockIoProvider->setConnectedPairs(connectedPairs);
+
+  // one socket for 1, 2 and 5, another for 3 and 4
+  const folly::IPAddress mcastAddr(kDiscardMulticastAddr);
+  int fd1 = createSocketAndJoinGroup(mockIoProvider, 1, mcastAddr);
+  int fd2 = createSocketAndJoinGroup(mockIoProvider, 3, mcastAddr);
+  for (auto const& [fd, ifIndex] :
+       std::vector<std::pair<int, int>>{{fd1, 2}, {fd1, 5}, {fd2, 4}}) {
+    struct ipv6_mreq mreq;
+    mreq.ipv6mr_interface = ifIndex;
+    EXPECT_EQ(
+        0,
+        mockIoProvider->setsockopt(
+            fd, IPPROTO_IPV6, IPV6_JOIN_GROUP, &mreq, sizeof(mreq)));
+  }
+
+  // packet on island interface fails, but doesn't hold back the rest
+  const std::string packet1("Batched message from iface1");
+  const std::string packet2("Batched message from iface2");
+  const std::string packet5("Batched message from iface5");
+  auto bytesSent = IoProvider::sendMessages(
+      fd1,
+      folly::SocketAddress(mcastAddr, kMockedUdpPort),
+      {{1, ipAddr1V6, packet1},
+       {5, ipAddr5V6, packet5},
+       {2, ipAddr2V6, packet2}},
+      mockIoProvider.get());
+  EXPECT_EQ(
+      std::vector<ssize_t>({static_cast<ssize_t>(packet1.size()),
+                            -1,
+                            static_cast<ssize_t>(packet2.size())}),
+      bytesSent);
+
+  // let both messages become due for delivery
+  waitForDataToRead(fd2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(kPollTimeout));
+
+  const unsigned int kBatchSize{8};
+  std::vector<unsigned char> recvBuf(kBatchSize * kMinIpv6PktSize);
+  auto results = IoProvider::recvMessages(
+      fd2, recvBuf.data(), kMinIpv6PktSize, kBatchSize, mockIoProvider.get());
+  ASSERT_EQ(2, results.size());
+
+  EXPECT_EQ(packet1.size(), std::get<0>(results.at(0)));
+  EXPECT_EQ(3, std::get<1>(results.at(0)));
+  EXPECT_EQ(
+      folly::IPAddress(ipAddr1V6), std::get<2>(results.at(0)).getIPAddress());
+  EXPECT_EQ(
+      packet1,
+      std::string(
+          reinterpret_cast<const char*>(recvBuf.data()), packet1.size()));
+
+  EXPECT_EQ(packet2.size(), std::get<0>(results.at(1)));
+  EXPECT_EQ(4, std::get<1>(results.at(1)));
+  EXPECT_EQ(
+      folly::IPAddress(ipAddr2V6), std::get<2>(results.at(1)).getIPAddress());
+  EXPECT_EQ(
+      packet2,
+      std::string(
+          reinterpret_cast<const char*>(recvBuf.data() + kMinIpv6PktSize),
+          packet2.size()));
+
+  // nothing left to read
+  EXPECT_TRUE(IoProvider::recvMessages(
+                  fd2,
+                  recvBuf.data(),
+                  kMinIpv6PktSize,
+                  kBatchSize,
+                  mockIoProvider.get())
+                  .empty());
+
+  // Cleanup
+  mockIoProvider->stop();
+  mockIoProviderThread.join();
+}
+
 int
 main(int argc, char* argv[]) {
   testing::InitGoogleTest(&argc, argv);
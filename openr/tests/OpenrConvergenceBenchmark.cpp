@@ -0,0 +1,548 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fbzmq/zmq/Zmq.h>
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/IPAddress.h>
+#include <folly/init/Init.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/Util.h>
+#include <openr/tests/BenchmarkDriver.h>
+#include <openr/tests/OpenrEmulator.h>
+#include <openr/tests/OpenrWrapper.h>
+#include <openr/tests/mocks/MockIoProvider.h>
+
+/**
+ * Defines a benchmark that allows users to record customized counter during
+ * benchmarking and passes a parameter to another one. This is common for
+ * benchmarks that need a "problem size" in addition to "number of iterations".
+ */
+#define BENCHMARK_COUNTERS_PARAM(name, counters, param) \
+  BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param, param)
+
+/*
+ * Like BENCHMARK_COUNTERS_PARAM(), but allows a custom name to be specified for
+ * each parameter, rather than using the parameter value.
+ */
+#define BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param_name, ...) \
+  BENCHMARK_IMPL_COUNTERS(                                             \
+      FB_CONCATENATE(name, FB_CONCATENATE(_, param_name)),             \
+      FOLLY_PP_STRINGIZE(name) "(" FOLLY_PP_STRINGIZE(param_name) ")", \
+      counters,                                                        \
+      iters,                                                           \
+      unsigned,                                                        \
+      iters) {                                                         \
+    name(counters, iters, ##__VA_ARGS__);                              \
+  }
+
+using apache::thrift::CompactSerializer;
+
+namespace {
+
+// timers as in OpenrSystemTest, link failures are detected by Spark on
+// expiry of the heartbeat hold time
+const std::chrono::seconds kKvStoreDbSyncInterval(1);
+const std::chrono::milliseconds kSpark2HelloTime(100);
+const std::chrono::milliseconds kSpark2FastInitHelloTime(20);
+const std::chrono::milliseconds kSpark2HandshakeTime(20);
+const std::chrono::milliseconds kSpark2HeartbeatTime(20);
+const std::chrono::milliseconds kSpark2HandshakeHoldTime(200);
+const std::chrono::milliseconds kSpark2HeartbeatHoldTime(500);
+const std::chrono::milliseconds kSpark2GRHoldTime(1000);
+const std::chrono::seconds kLinkMonitorAdjHoldTime(1);
+const std::chrono::milliseconds kLinkFlapInitialBackoff(1);
+const std::chrono::milliseconds kLinkFlapMaxBackoff(8);
+const std::chrono::seconds kFibColdStartDuration(1);
+
+// latency of emulated links in milliseconds
+const int32_t kLinkLatency{1};
+
+// poll interval while waiting for routes
+const std::chrono::milliseconds kPollInterval(10);
+
+// routes are considered converged once unchanged for this long
+const std::chrono::seconds kSettleTime(3);
+
+// upper bound of any convergence, to fail instead of hanging
+const std::chrono::seconds kMaxConvergenceTime(60);
+
+// Stages of convergence as per perf events of route updates
+struct Stage {
+  std::string name;
+  std::string firstEvent;
+  std::string secondEvent;
+};
+
+const std::vector<Stage> kStages = {
+    // adjacency advertised until received by Decision, i.e. KvStore flooding
+    {"kvstore", "ADJ_DB_UPDATED", "DECISION_RECEIVED"},
+    // debounce and route computation
+    {"decision", "DECISION_RECEIVED", "ROUTE_UPDATE"},
+    // route programming
+    {"fib", "ROUTE_UPDATE", "OPENR_FIB_ROUTES_PROGRAMMED"},
+};
+
+// Next-hop interfaces and metrics of unicast routes of a node, by prefix
+using Routes = openr::OpenrEmulator::Routes;
+
+// Links by index of the nodes they connect
+using Links = openr::OpenrEmulator::Links;
+
+int64_t
+getPercentile(std::vector<int64_t> values, uint32_t percentile) {
+  CHECK(not values.empty());
+  std::sort(values.begin(), values.end());
+  return values.at((values.size() - 1) * percentile / 100);
+}
+
+int64_t
+getUnixTsMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+} // namespace
+
+namespace openr {
+
+/**
+ * Network of Open/R instances in one process, glued together by a
+ * MockIoProvider. Links are failed by disconnecting their interfaces, Spark
+ * detects it and the failure propagates through LinkMonitor, KvStore,
+ * Decision and Fib of all nodes.
+ */
+class OpenrNetwork {
+ public:
+  OpenrNetwork(uint32_t numNodes, const Links& links) : links_(links) {
+    mockIoProvider_ = std::make_shared<MockIoProvider>();
+    mockIoProviderThread_ = std::make_unique<std::thread>(
+        [this]() { mockIoProvider_->start(); });
+    mockIoProvider_->waitUntilRunning();
+
+    // interfaces of each node, named after the nodes they connect
+    int ifIndex{0};
+    IfNameAndifIndex ifIndexes;
+    std::vector<std::vector<SparkInterfaceEntry>> interfaces(numNodes);
+    for (const auto& [a, b] : links_) {
+      const auto directions = {std::make_pair(a, b), std::make_pair(b, a)};
+      for (const auto& [src, dst] : directions) {
+        const auto ifName = getIfName(src, dst);
+        ifIndexes.emplace_back(ifName, ++ifIndex);
+        interfaces.at(src).push_back(SparkInterfaceEntry{
+            ifName, ifIndex, getV4Network(src), getV6Network(src)});
+      }
+    }
+    mockIoProvider_->addIfNameIfIndex(ifIndexes);
+    linksUp_.assign(links_.size(), true);
+    mockIoProvider_->setConnectedPairs(getConnectedPairs());
+
+    for (uint32_t i = 0; i < numNodes; ++i) {
+      nodes_.emplace_back(std::make_unique<OpenrWrapper<CompactSerializer>>(
+          context_,
+          folly::sformat("node-{}", i),
+          false /* v4Enabled */,
+          kKvStoreDbSyncInterval,
+          kSpark2HelloTime,
+          kSpark2FastInitHelloTime,
+          kSpark2HandshakeTime,
+          kSpark2HeartbeatTime,
+          kSpark2HandshakeHoldTime,
+          kSpark2HeartbeatHoldTime,
+          kSpark2GRHoldTime,
+          kLinkMonitorAdjHoldTime,
+          kLinkFlapInitialBackoff,
+          kLinkFlapMaxBackoff,
+          kFibColdStartDuration,
+          mockIoProvider_,
+          memLimitMB,
+          true /* enablePerfMeasurement */));
+    }
+    for (auto& node : nodes_) {
+      node->run();
+    }
+    for (uint32_t i = 0; i < numNodes; ++i) {
+      CHECK(nodes_.at(i)->sparkUpdateInterfaceDb(interfaces.at(i)));
+    }
+  }
+
+  ~OpenrNetwork() {
+    // nodes must be gone before the io provider they use
+    nodes_.clear();
+    mockIoProvider_->stop();
+    mockIoProviderThread_->join();
+  }
+
+  void
+  linkDown(size_t link) {
+    linksUp_.at(link) = false;
+    mockIoProvider_->setConnectedPairs(getConnectedPairs());
+  }
+
+  void
+  linkUp(size_t link) {
+    linksUp_.at(link) = true;
+    mockIoProvider_->setConnectedPairs(getConnectedPairs());
+  }
+
+  std::vector<Routes>
+  getRoutes() const {
+    std::vector<Routes> routes;
+    for (const auto& node : nodes_) {
+      auto& nodeRoutes = routes.emplace_back();
+      const auto routeDb = node->fibDumpRouteDatabase();
+      for (const auto& route : *routeDb.unicastRoutes_ref()) {
+        auto& nextHops = nodeRoutes[toString(*route.dest_ref())];
+        for (const auto& nextHop : *route.nextHops_ref()) {
+          nextHops.emplace(
+              nextHop.address_ref()->ifName_ref().value_or(""),
+              *nextHop.metric_ref());
+        }
+      }
+    }
+    return routes;
+  }
+
+  /**
+   * Wait for every node to have routes to the prefixes of all others, i.e.
+   * the initial convergence of the network
+   */
+  void
+  waitForFullMesh() const {
+    waitFor([this]() {
+      for (const auto& nodeRoutes : getRoutes()) {
+        if (nodeRoutes.size() < nodes_.size() - 1) {
+          return false;
+        }
+      }
+      return true;
+    });
+  }
+
+  /**
+   * Wait for routes of all nodes to be unchanged for kSettleTime
+   */
+  std::vector<Routes>
+  waitForStableRoutes() const {
+    auto routes = getRoutes();
+    auto stableSince = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - stableSince < kSettleTime) {
+      std::this_thread::sleep_for(kPollInterval);
+      auto newRoutes = getRoutes();
+      if (newRoutes != routes) {
+        routes = std::move(newRoutes);
+        stableSince = std::chrono::steady_clock::now();
+      }
+    }
+    return routes;
+  }
+
+  void
+  waitForRoutes(const std::vector<Routes>& routes) const {
+    waitFor([&]() { return getRoutes() == routes; });
+  }
+
+  /**
+   * Perf events of route updates programmed by all nodes, of changes which
+   * originated at or after given unix timestamp in milliseconds
+   */
+  std::vector<thrift::PerfEvents>
+  getPerfEvents(int64_t sinceTsMs) const {
+    std::vector<thrift::PerfEvents> perfEvents;
+    for (const auto& node : nodes_) {
+      auto perfDb = node->fibDumpPerfDatabase();
+      for (auto& events : *perfDb.eventInfo_ref()) {
+        if (not events.events_ref()->empty() and
+            *events.events_ref()->front().unixTs_ref() >= sinceTsMs) {
+          perfEvents.emplace_back(std::move(events));
+        }
+      }
+    }
+    return perfEvents;
+  }
+
+ private:
+  static std::string
+  getIfName(uint32_t src, uint32_t dst) {
+    return folly::sformat("{}/{}", src, dst);
+  }
+
+  static folly::CIDRNetwork
+  getV4Network(uint32_t node) {
+    return {folly::IPAddress(folly::sformat(
+                "192.168.{}.{}", (node + 1) / 256, (node + 1) % 256)),
+            32};
+  }
+
+  static folly::CIDRNetwork
+  getV6Network(uint32_t node) {
+    return {folly::IPAddress(folly::sformat("fe80::{:x}", node + 1)), 128};
+  }
+
+  ConnectedIfPairs
+  getConnectedPairs() const {
+    ConnectedIfPairs connectedPairs;
+    for (size_t i = 0; i < links_.size(); ++i) {
+      if (not linksUp_.at(i)) {
+        continue;
+      }
+      const auto& [a, b] = links_.at(i);
+      connectedPairs[getIfName(a, b)] = {{getIfName(b, a), kLinkLatency}};
+      connectedPairs[getIfName(b, a)] = {{getIfName(a, b), kLinkLatency}};
+    }
+    return connectedPairs;
+  }
+
+  template <typename Predicate>
+  static void
+  waitFor(Predicate predicate) {
+    const auto deadline =
+        std::chrono::steady_clock::now() + kMaxConvergenceTime;
+    while (not predicate()) {
+      CHECK(std::chrono::steady_clock::now() < deadline)
+          << "Network did not converge in " << kMaxConvergenceTime.count()
+          << "s";
+      std::this_thread::sleep_for(kPollInterval);
+    }
+  }
+
+  const Links links_;
+  std::vector<bool> linksUp_;
+
+  fbzmq::Context context_;
+  std::shared_ptr<MockIoProvider> mockIoProvider_{nullptr};
+  std::unique_ptr<std::thread> mockIoProviderThread_{nullptr};
+  std::vector<std::unique_ptr<OpenrWrapper<CompactSerializer>>> nodes_;
+};
+
+namespace {
+
+// ring of numNodes nodes
+Links
+getRingLinks(uint32_t numNodes) {
+  Links links;
+  for (uint32_t i = 0; i < numNodes; ++i) {
+    links.emplace_back(i, (i + 1) % numNodes);
+  }
+  return links;
+}
+
+// grid of numRows x numCols nodes, numbered row by row
+Links
+getGridLinks(uint32_t numRows, uint32_t numCols) {
+  Links links;
+  for (uint32_t row = 0; row < numRows; ++row) {
+    for (uint32_t col = 0; col < numCols; ++col) {
+      const auto node = row * numCols + col;
+      if (col + 1 < numCols) {
+        links.emplace_back(node, node + 1);
+      }
+      if (row + 1 < numRows) {
+        links.emplace_back(node, node + numCols);
+      }
+    }
+  }
+  return links;
+}
+
+// fabric of numSpines spines, numbered first, and numLeaves leaves, every
+// leaf being connected to every spine
+Links
+getFabricLinks(uint32_t numSpines, uint32_t numLeaves) {
+  Links links;
+  for (uint32_t spine = 0; spine < numSpines; ++spine) {
+    for (uint32_t leaf = 0; leaf < numLeaves; ++leaf) {
+      links.emplace_back(spine, numSpines + leaf);
+    }
+  }
+  return links;
+}
+
+/**
+ * Fail and restore the first link of the network iters times. Measured is
+ * the time from a failure until the routes of all nodes have converged,
+ * reported as p50/p99 along with p50/p99 of the stages of the route updates
+ * programmed, as per their perf events. Network is either OpenrNetwork or
+ * OpenrEmulator.
+ */
+template <typename Network>
+void
+runLinkFailures(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numNodes,
+    const Links& links) {
+  auto suspender = folly::BenchmarkSuspender();
+  Network network(numNodes, links);
+  network.waitForFullMesh();
+  const auto routes = network.waitForStableRoutes();
+
+  // learn the routes of the converged network without the link
+  network.linkDown(0);
+  const auto failedRoutes = network.waitForStableRoutes();
+  CHECK(failedRoutes != routes);
+  network.linkUp(0);
+  network.waitForRoutes(routes);
+
+  std::vector<int64_t> convergenceTimes;
+  std::vector<int64_t> totalTimes;
+  std::map<std::string, std::vector<int64_t>> stageTimes;
+  for (uint32_t i = 0; i < iters; ++i) {
+    // let the restored link settle, e.g. adjacency hold timers
+    network.waitForStableRoutes();
+
+    const auto startTsMs = getUnixTsMs();
+    const auto startTime = std::chrono::steady_clock::now();
+    suspender.dismiss(); // Start measuring benchmark time
+    network.linkDown(0);
+    network.waitForRoutes(failedRoutes);
+    suspender.rehire(); // Stop measuring time again
+    convergenceTimes.emplace_back(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime)
+            .count());
+
+    for (const auto& perfEvents : network.getPerfEvents(startTsMs)) {
+      totalTimes.emplace_back(getTotalPerfEventsDuration(perfEvents).count());
+      for (const auto& stage : kStages) {
+        const auto duration = getDurationBetweenPerfEvents(
+            perfEvents, stage.firstEvent, stage.secondEvent);
+        if (duration.hasValue()) {
+          stageTimes[stage.name].emplace_back(duration->count());
+        }
+      }
+    }
+
+    // restore link, its convergence is not part of the measurement
+    network.linkUp(0);
+    network.waitForRoutes(routes);
+  }
+
+  counters["p50_ms"] = getPercentile(convergenceTimes, 50);
+  counters["p99_ms"] = getPercentile(convergenceTimes, 99);
+  if (not totalTimes.empty()) {
+    counters["perf_p50_ms"] = getPercentile(totalTimes, 50);
+    counters["perf_p99_ms"] = getPercentile(totalTimes, 99);
+  }
+  for (const auto& [name, times] : stageTimes) {
+    counters[name + "_p50_ms"] = getPercentile(times, 50);
+    counters[name + "_p99_ms"] = getPercentile(times, 99);
+  }
+}
+
+} // namespace
+
+/**
+ * Benchmark convergence of a ring of numNodes nodes after a link failure
+ */
+static void
+BM_OpenrConvergenceRing(
+    folly::UserCounters& counters, uint32_t iters, uint32_t numNodes) {
+  runLinkFailures<OpenrNetwork>(
+      counters, iters, numNodes, getRingLinks(numNodes));
+}
+
+/**
+ * Benchmark convergence of a grid of numRows x numCols nodes after a link
+ * failure
+ */
+static void
+BM_OpenrConvergenceGrid(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numRows,
+    uint32_t numCols) {
+  runLinkFailures<OpenrNetwork>(
+      counters, iters, numRows * numCols, getGridLinks(numRows, numCols));
+}
+
+/**
+ * Benchmark convergence of a fabric of numSpines spines and numLeaves leaves
+ * after a link failure between a spine and a leaf
+ */
+static void
+BM_OpenrConvergenceFabric(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numSpines,
+    uint32_t numLeaves) {
+  runLinkFailures<OpenrNetwork>(
+      counters,
+      iters,
+      numSpines + numLeaves,
+      getFabricLinks(numSpines, numLeaves));
+}
+
+/**
+ * Benchmark KvStore flooding and Decision convergence of an emulated grid of
+ * numRows x numCols nodes after a link failure
+ */
+static void
+BM_OpenrEmulatedConvergenceGrid(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numRows,
+    uint32_t numCols) {
+  runLinkFailures<OpenrEmulator>(
+      counters, iters, numRows * numCols, getGridLinks(numRows, numCols));
+}
+
+/**
+ * Benchmark KvStore flooding and Decision convergence of an emulated fabric
+ * of numSpines spines and numLeaves leaves after a link failure
+ */
+static void
+BM_OpenrEmulatedConvergenceFabric(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numSpines,
+    uint32_t numLeaves) {
+  runLinkFailures<OpenrEmulator>(
+      counters,
+      iters,
+      numSpines + numLeaves,
+      getFabricLinks(numSpines, numLeaves));
+}
+
+// The parameter is the number of nodes
+BENCHMARK_COUNTERS_PARAM(BM_OpenrConvergenceRing, counters, 8);
+BENCHMARK_COUNTERS_PARAM(BM_OpenrConvergenceRing, counters, 16);
+// The parameters are the number of rows and columns
+BENCHMARK_COUNTERS_NAME_PARAM(BM_OpenrConvergenceGrid, counters, 3_3, 3, 3);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_OpenrConvergenceGrid, counters, 4_4, 4, 4);
+// The parameters are the number of spines and leaves
+BENCHMARK_COUNTERS_NAME_PARAM(BM_OpenrConvergenceFabric, counters, 2_6, 2, 6);
+BENCHMARK_COUNTERS_NAME_PARAM(BM_OpenrConvergenceFabric, counters, 4_12, 4, 12);
+// Emulated networks of hundreds to thousands of nodes
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_OpenrEmulatedConvergenceGrid, counters, 10_10, 10, 10);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_OpenrEmulatedConvergenceGrid, counters, 32_32, 32, 32);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_OpenrEmulatedConvergenceFabric, counters, 16_256, 16, 256);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_OpenrEmulatedConvergenceFabric, counters, 32_1024, 32, 1024);
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  return openr::runBenchmarks();
+}
@@ -0,0 +1,364 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <openr/tests/OpenrEmulator.h>
+
+#include <folly/Format.h>
+
+#include <openr/common/NetworkUtil.h>
+#include <openr/common/Util.h>
+#include <openr/config/tests/Utils.h>
+
+namespace {
+
+// metric of all emulated links
+const int32_t kLinkMetric{1};
+
+// perf events of route updates kept per node
+const size_t kMaxPerfEvents{32};
+
+// poll interval while waiting for routes
+const std::chrono::milliseconds kPollInterval(10);
+
+// routes are considered converged once unchanged for this long
+const std::chrono::seconds kSettleTime(3);
+
+// upper bound of any convergence, to fail instead of hanging
+const std::chrono::seconds kMaxConvergenceTime(300);
+
+std::string
+getCmdUrl(uint32_t node) {
+  return folly::sformat("inproc://emulated-{}-kvstore-cmd-global", node);
+}
+
+std::string
+getV6Address(uint32_t node) {
+  return folly::sformat("fe80::{:x}", node + 1);
+}
+
+std::string
+getV4Address(uint32_t node) {
+  return folly::sformat("192.168.{}.{}", (node + 1) / 256, (node + 1) % 256);
+}
+
+} // namespace
+
+namespace openr {
+
+struct OpenrEmulator::Node {
+  explicit Node(uint32_t id) : name(getNodeName(id)) {}
+
+  const std::string name;
+
+  std::shared_ptr<Config> config;
+
+  messaging::ReplicateQueue<PublicationPtr> kvStoreUpdatesQueue;
+  messaging::ReplicateQueue<KvStoreSyncEvent> kvStoreSyncEventsQueue;
+  messaging::ReplicateQueue<thrift::PeerUpdateRequest> peerUpdatesQueue;
+  messaging::ReplicateQueue<LogSample> logSampleQueue;
+  messaging::ReplicateQueue<thrift::RouteDatabaseDelta> staticRoutesQueue;
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue;
+
+  std::unique_ptr<KvStore> kvStore;
+  std::unique_ptr<Decision> decision;
+  std::vector<std::thread> threads;
+
+  // version of last advertised adjacency database
+  int64_t adjDbVersion{0};
+
+  // accessed on evb_ only
+  Routes routes;
+  std::deque<thrift::PerfEvents> perfEvents;
+};
+
+OpenrEmulator::OpenrEmulator(
+    uint32_t numNodes,
+    const Links& links,
+    std::chrono::milliseconds debounceMinDur,
+    std::chrono::milliseconds debounceMaxDur)
+    : links_(links), linksUp_(links.size(), true) {
+  for (uint32_t i = 0; i < numNodes; ++i) {
+    auto node = std::make_unique<Node>(i);
+    node->config = std::make_shared<Config>(getBasicOpenrConfig(
+        node->name, "emulator", {} /* area config */, false /* enableV4 */));
+
+    node->kvStore = std::make_unique<KvStore>(
+        context_,
+        node->kvStoreUpdatesQueue,
+        node->kvStoreSyncEventsQueue,
+        node->peerUpdatesQueue.getReader(),
+        node->logSampleQueue,
+        KvStoreGlobalCmdUrl{getCmdUrl(i)},
+        node->config,
+        std::nullopt /* ip-tos */);
+
+    node->decision = std::make_unique<Decision>(
+        node->config,
+        false, // computeLfaPaths
+        false, // bgpDryRun
+        debounceMinDur,
+        debounceMaxDur,
+        node->kvStoreUpdatesQueue.getReader(),
+        node->staticRoutesQueue.getReader(),
+        node->routeUpdatesQueue);
+
+    // Track routes of the node, as Fib would program them
+    evb_.addFiberTask(
+        [n = node.get(),
+         q = node->routeUpdatesQueue.getReader()]() mutable noexcept {
+          while (true) {
+            auto maybeUpdate = q.get(); // perform read
+            if (maybeUpdate.hasError()) {
+              break;
+            }
+            auto const& update = *maybeUpdate.value();
+            for (auto const& [prefix, entry] : update.unicastRoutesToUpdate) {
+              auto& nextHops = n->routes[toString(toIpPrefix(prefix))];
+              nextHops.clear();
+              for (auto const& nextHop : entry.nexthops) {
+                nextHops.emplace(
+                    nextHop.address_ref()->ifName_ref().value_or(""),
+                    *nextHop.metric_ref());
+              }
+            }
+            for (auto const& prefix : update.unicastRoutesToDelete) {
+              n->routes.erase(toString(toIpPrefix(prefix)));
+            }
+            if (update.perfEvents.has_value()) {
+              n->perfEvents.emplace_back(*update.perfEvents);
+              if (n->perfEvents.size() > kMaxPerfEvents) {
+                n->perfEvents.pop_front();
+              }
+            }
+          }
+        });
+
+    node->threads.emplace_back([kvStore = node->kvStore.get()]() noexcept {
+      kvStore->run();
+    });
+    node->kvStore->waitUntilRunning();
+    node->threads.emplace_back([decision = node->decision.get()]() noexcept {
+      decision->run();
+    });
+    node->decision->waitUntilRunning();
+    nodes_.emplace_back(std::move(node));
+  }
+
+  evbThread_ = std::thread([this]() noexcept { evb_.run(); });
+  evb_.waitUntilRunning();
+
+  // Bring up all links and advertise loopbacks
+  for (size_t link = 0; link < links_.size(); ++link) {
+    updatePeers(link, true);
+  }
+  for (uint32_t i = 0; i < numNodes; ++i) {
+    advertiseAdjacencies(i);
+
+    auto& node = *nodes_.at(i);
+    thrift::KeySetParams params;
+    params.keyVals_ref()->emplace(createPrefixKeyValue(
+        node.name,
+        1,
+        createPrefixEntry(getLoopbackPrefix(i)),
+        thrift::KvStore_constants::kDefaultArea()));
+    node.kvStore
+        ->setKvStoreKeyVals(
+            std::move(params), thrift::KvStore_constants::kDefaultArea())
+        .get();
+  }
+  LOG(INFO) << "Emulating " << numNodes << " nodes with " << links_.size()
+            << " links";
+}
+
+OpenrEmulator::~OpenrEmulator() {
+  for (auto& node : nodes_) {
+    node->kvStoreUpdatesQueue.close();
+    node->kvStoreSyncEventsQueue.close();
+    node->peerUpdatesQueue.close();
+    node->logSampleQueue.close();
+    node->staticRoutesQueue.close();
+    node->routeUpdatesQueue.close();
+  }
+  for (auto& node : nodes_) {
+    node->decision->stop();
+    node->decision->waitUntilStopped();
+    node->kvStore->stop();
+    node->kvStore->waitUntilStopped();
+    for (auto& thread : node->threads) {
+      thread.join();
+    }
+  }
+  evb_.stop();
+  evb_.waitUntilStopped();
+  evbThread_.join();
+
+  // nodes must be gone before the zmq context they use
+  nodes_.clear();
+}
+
+std::string
+OpenrEmulator::getNodeName(uint32_t node) {
+  return folly::sformat("node-{}", node);
+}
+
+std::string
+OpenrEmulator::getIfName(uint32_t src, uint32_t dst) {
+  return folly::sformat("{}/{}", src, dst);
+}
+
+thrift::IpPrefix
+OpenrEmulator::getLoopbackPrefix(uint32_t node) {
+  return toIpPrefix(folly::sformat("fc00::{:x}/128", node + 1));
+}
+
+template <typename Predicate>
+void
+OpenrEmulator::waitFor(Predicate predicate) {
+  const auto deadline = std::chrono::steady_clock::now() + kMaxConvergenceTime;
+  while (not predicate()) {
+    CHECK(std::chrono::steady_clock::now() < deadline)
+        << "Network did not converge in " << kMaxConvergenceTime.count()
+        << "s";
+    std::this_thread::sleep_for(kPollInterval);
+  }
+}
+
+void
+OpenrEmulator::linkDown(size_t link) {
+  linksUp_.at(link) = false;
+  updatePeers(link, false);
+  advertiseAdjacencies(links_.at(link).first);
+  advertiseAdjacencies(links_.at(link).second);
+}
+
+void
+OpenrEmulator::linkUp(size_t link) {
+  linksUp_.at(link) = true;
+  updatePeers(link, true);
+  advertiseAdjacencies(links_.at(link).first);
+  advertiseAdjacencies(links_.at(link).second);
+}
+
+void
+OpenrEmulator::updatePeers(size_t link, bool isUp) {
+  const auto& [a, b] = links_.at(link);
+  const auto directions = {std::make_pair(a, b), std::make_pair(b, a)};
+  for (const auto& [src, dst] : directions) {
+    thrift::PeerUpdateRequest request;
+    request.area_ref() = thrift::KvStore_constants::kDefaultArea();
+    if (isUp) {
+      thrift::PeerAddParams params;
+      params.peers_ref()->emplace(
+          getNodeName(dst), createPeerSpec(getCmdUrl(dst)));
+      request.peerAddParams_ref() = std::move(params);
+    } else {
+      thrift::PeerDelParams params;
+      params.peerNames_ref()->emplace_back(getNodeName(dst));
+      request.peerDelParams_ref() = std::move(params);
+    }
+    nodes_.at(src)->peerUpdatesQueue.push(std::move(request));
+  }
+}
+
+void
+OpenrEmulator::advertiseAdjacencies(uint32_t node) {
+  auto& n = *nodes_.at(node);
+  std::vector<thrift::Adjacency> adjs;
+  for (size_t link = 0; link < links_.size(); ++link) {
+    const auto& [a, b] = links_.at(link);
+    if (not linksUp_.at(link) or a == b or (a != node and b != node)) {
+      continue;
+    }
+    const auto other = a == node ? b : a;
+    adjs.emplace_back(createAdjacency(
+        getNodeName(other),
+        getIfName(node, other),
+        getIfName(other, node),
+        getV6Address(other),
+        getV4Address(other),
+        kLinkMetric,
+        0 /* adjLabel */));
+  }
+
+  auto adjDb = createAdjDb(n.name, adjs, 0 /* nodeLabel */);
+  thrift::PerfEvents perfEvents;
+  addPerfEvent(perfEvents, n.name, "ADJ_DB_UPDATED");
+  adjDb.perfEvents_ref() = std::move(perfEvents);
+
+  thrift::KeySetParams params;
+  params.keyVals_ref()->emplace(
+      folly::sformat("{}{}", Constants::kAdjDbMarker, n.name),
+      createThriftValue(
+          ++n.adjDbVersion,
+          n.name,
+          fbzmq::util::writeThriftObjStr(adjDb, serializer_)));
+  n.kvStore
+      ->setKvStoreKeyVals(
+          std::move(params), thrift::KvStore_constants::kDefaultArea())
+      .get();
+}
+
+std::vector<OpenrEmulator::Routes>
+OpenrEmulator::getRoutes() {
+  std::vector<Routes> routes;
+  evb_.getEvb()->runInEventBaseThreadAndWait([&]() {
+    for (const auto& node : nodes_) {
+      routes.emplace_back(node->routes);
+    }
+  });
+  return routes;
+}
+
+void
+OpenrEmulator::waitForFullMesh() {
+  waitFor([this]() {
+    for (const auto& nodeRoutes : getRoutes()) {
+      if (nodeRoutes.size() < nodes_.size() - 1) {
+        return false;
+      }
+    }
+    return true;
+  });
+}
+
+std::vector<OpenrEmulator::Routes>
+OpenrEmulator::waitForStableRoutes() {
+  auto routes = getRoutes();
+  auto stableSince = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() - stableSince < kSettleTime) {
+    std::this_thread::sleep_for(kPollInterval);
+    auto newRoutes = getRoutes();
+    if (newRoutes != routes) {
+      routes = std::move(newRoutes);
+      stableSince = std::chrono::steady_clock::now();
+    }
+  }
+  return routes;
+}
+
+void
+OpenrEmulator::waitForRoutes(const std::vector<Routes>& routes) {
+  waitFor([&]() { return getRoutes() == routes; });
+}
+
+std::vector<thrift::PerfEvents>
+OpenrEmulator::getPerfEvents(int64_t sinceTsMs) {
+  std::vector<thrift::PerfEvents> perfEvents;
+  evb_.getEvb()->runInEventBaseThreadAndWait([&]() {
+    for (const auto& node : nodes_) {
+      for (const auto& events : node->perfEvents) {
+        if (not events.events_ref()->empty() and
+            *events.events_ref()->front().unixTs_ref() >= sinceTsMs) {
+          perfEvents.emplace_back(events);
+        }
+      }
+    }
+  });
+  return perfEvents;
+}
+
+} // namespace openr
@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fbzmq/zmq/Zmq.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include <openr/common/OpenrEventBase.h>
+#include <openr/config/Config.h>
+#include <openr/decision/Decision.h>
+#include <openr/kvstore/KvStore.h>
+#include <openr/monitor/LogSample.h>
+
+namespace openr {
+
+/**
+ * Network of lightweight Open/R instances in one process, for scale testing
+ * of KvStore flooding and Decision convergence with hundreds to thousands of
+ * nodes.
+ *
+ * A node runs only KvStore and Decision, on a thread each. Roles of Spark and
+ * LinkMonitor are played by the emulator: a virtual link peers KvStores of
+ * its ends and adds an adjacency to the adjacency database of either. All
+ * nodes share one zmq context, and route updates of all of them are consumed
+ * by fibers of a single event base, which stands in for Fib.
+ *
+ * Not thread-safe, use from the same thread only
+ */
+class OpenrEmulator {
+ public:
+  // Links by index of the nodes they connect
+  using Links = std::vector<std::pair<uint32_t, uint32_t>>;
+
+  // Next-hop interfaces and metrics of unicast routes of a node, by prefix
+  using Routes = std::map<
+      std::string /* prefix */,
+      std::set<std::pair<std::string /* ifName */, int32_t /* metric */>>>;
+
+  OpenrEmulator(
+      uint32_t numNodes,
+      const Links& links,
+      std::chrono::milliseconds debounceMinDur = std::chrono::milliseconds(10),
+      std::chrono::milliseconds debounceMaxDur =
+          std::chrono::milliseconds(250));
+
+  ~OpenrEmulator();
+
+  static std::string getNodeName(uint32_t node);
+
+  static std::string getIfName(uint32_t src, uint32_t dst);
+
+  // Loopback prefix advertised by a node
+  static thrift::IpPrefix getLoopbackPrefix(uint32_t node);
+
+  size_t
+  getNumNodes() const {
+    return nodes_.size();
+  }
+
+  // Fail or restore a link, as it would be detected by Spark
+  void linkDown(size_t link);
+  void linkUp(size_t link);
+
+  // Routes of all nodes as last published by their Decision
+  std::vector<Routes> getRoutes();
+
+  /**
+   * Wait for every node to have routes to the loopbacks of all others, i.e.
+   * the initial convergence of the network
+   */
+  void waitForFullMesh();
+
+  // Wait for routes of all nodes to be unchanged for a settle time
+  std::vector<Routes> waitForStableRoutes();
+
+  void waitForRoutes(const std::vector<Routes>& routes);
+
+  /**
+   * Perf events of route updates published by all nodes, of changes which
+   * originated at or after given unix timestamp in milliseconds. Events start
+   * at ADJ_DB_UPDATED, as stamped by the emulator on link changes.
+   */
+  std::vector<thrift::PerfEvents> getPerfEvents(int64_t sinceTsMs);
+
+ private:
+  struct Node;
+
+  // Disable copy constructor
+  OpenrEmulator(OpenrEmulator const&) = delete;
+  OpenrEmulator& operator=(OpenrEmulator const&) = delete;
+
+  // Publish adjacency database of a node as per links currently up
+  void advertiseAdjacencies(uint32_t node);
+
+  // Add or remove KvStore peering of ends of a link
+  void updatePeers(size_t link, bool isUp);
+
+  template <typename Predicate>
+  static void waitFor(Predicate predicate);
+
+  const Links links_;
+  std::vector<bool> linksUp_;
+
+  // Thrift serializer object for serializing/deserializing of thrift objects
+  // to/from bytes
+  apache::thrift::CompactSerializer serializer_;
+
+  // Shared by KvStores of all nodes
+  fbzmq::Context context_;
+
+  // Consumes route updates of all nodes, state of nodes in Node::routes and
+  // Node::perfEvents is accessed on it only
+  OpenrEventBase evb_;
+  std::thread evbThread_;
+
+  std::vector<std::unique_ptr<Node>> nodes_;
+};
+
+} // namespace openr
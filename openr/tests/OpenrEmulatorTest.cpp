@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2014-present, Facebook, Inc.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <openr/common/NetworkUtil.h>
+#include <openr/tests/OpenrEmulator.h>
+
+namespace openr {
+
+//
+// Ring of 8 nodes, where routes of a node to its neighbor move to the other
+// side of the ring on failure of their link, and are restored on recovery
+//
+TEST(OpenrEmulatorTest, RingLinkFailure) {
+  const uint32_t numNodes{8};
+  OpenrEmulator::Links links;
+  for (uint32_t i = 0; i < numNodes; ++i) {
+    links.emplace_back(i, (i + 1) % numNodes);
+  }
+
+  OpenrEmulator emulator(numNodes, links);
+  EXPECT_EQ(numNodes, emulator.getNumNodes());
+  emulator.waitForFullMesh();
+  const auto routes = emulator.waitForStableRoutes();
+
+  const auto prefix1 = toString(OpenrEmulator::getLoopbackPrefix(1));
+  OpenrEmulator::Routes::mapped_type nextHops = {
+      {OpenrEmulator::getIfName(0, 1), 1}};
+  EXPECT_EQ(nextHops, routes.at(0).at(prefix1));
+
+  // node-1 is reached the long way round, 7 hops away
+  emulator.linkDown(0);
+  const auto failedRoutes = emulator.waitForStableRoutes();
+  nextHops = {{OpenrEmulator::getIfName(0, numNodes - 1),
+               static_cast<int32_t>(numNodes - 1)}};
+  EXPECT_EQ(nextHops, failedRoutes.at(0).at(prefix1));
+  EXPECT_EQ(numNodes - 1, failedRoutes.at(0).size());
+
+  emulator.linkUp(0);
+  emulator.waitForRoutes(routes);
+  EXPECT_FALSE(emulator.getPerfEvents(0).empty());
+}
+
+} // namespace openr
+
+int
+main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
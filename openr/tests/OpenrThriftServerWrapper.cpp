@@ -52,7 +52,7 @@ OpenrThriftServerWrapper::run() {
         monitor_,
         configStore_,
         prefixManager_,
-        spark_,
+        spark_ ? std::vector<Spark*>{spark_} : std::vector<Spark*>{},
         config_);
   });
 
@@ -28,7 +28,8 @@ OpenrWrapper<Serializer>::OpenrWrapper(
     std::chrono::milliseconds linkFlapMaxBackoff,
     std::chrono::seconds fibColdStartDuration,
     std::shared_ptr<IoProvider> ioProvider,
-    uint32_t memLimit)
+    uint32_t memLimit,
+    bool enablePerfMeasurement)
     : context_(context),
       nodeId_(nodeId),
       ioProvider_(std::move(ioProvider)),
@@ -60,7 +61,7 @@ OpenrWrapper<Serializer>::OpenrWrapper(
   *pfxAllocationConf.loopback_interface_ref() = "";
   pfxAllocationConf.prefix_allocation_mode_ref() =
       thrift::PrefixAllocationMode::DYNAMIC_ROOT_NODE;
-  pfxAllocationConf.seed_prefix_ref() = "fc00:cafe:babe::/62";
+  pfxAllocationConf.seed_prefix_ref() = "fc00:cafe:babe::/56";
   pfxAllocationConf.allocate_prefix_len_ref() = 64;
   tConfig.prefix_allocation_config_ref() = std::move(pfxAllocationConf);
 
@@ -169,8 +170,9 @@ OpenrWrapper<Serializer>::OpenrWrapper(
       nlSock_.get(),
       kvStore_.get(),
       configStore_.get(),
-      false /* enable perf measurement */,
+      enablePerfMeasurement,
       interfaceUpdatesQueue_,
+      interfaceStatusEventsQueue_,
       prefixUpdatesQueue_,
       peerUpdatesQueue_,
       logSampleQueue_,
@@ -198,7 +200,7 @@ OpenrWrapper<Serializer>::OpenrWrapper(
       config_,
       configStore_.get(),
       kvStore_.get(),
-      false /* prefix-mananger perf measurement */,
+      enablePerfMeasurement,
       std::chrono::seconds(0));
 
   //
@@ -223,6 +225,7 @@ OpenrWrapper<Serializer>::OpenrWrapper(
       fibColdStartDuration,
       routeUpdatesQueue_.getReader(),
       interfaceUpdatesQueue_.getReader(),
+      interfaceStatusEventsQueue_.getReader(),
       fibUpdatesQueue_,
       logSampleQueue_,
       kvStore_.get());
@@ -344,6 +347,7 @@ OpenrWrapper<Serializer>::stop() {
   routeUpdatesQueue_.close();
   peerUpdatesQueue_.close();
   interfaceUpdatesQueue_.close();
+  interfaceStatusEventsQueue_.close();
   neighborUpdatesQueue_.close();
   kvStoreSyncEventsQueue_.close();
   nlSock_->closeQueue();
@@ -463,6 +467,13 @@ OpenrWrapper<Serializer>::fibDumpRouteDatabase() {
   return std::move(*routes);
 }
 
+template <class Serializer>
+thrift::PerfDatabase
+OpenrWrapper<Serializer>::fibDumpPerfDatabase() {
+  auto perfDb = fib_->getPerfDb().get();
+  return std::move(*perfDb);
+}
+
 template <class Serializer>
 bool
 OpenrWrapper<Serializer>::addPrefixEntries(
@@ -55,7 +55,8 @@ class OpenrWrapper {
       std::chrono::milliseconds linkFlapMaxBackoff,
       std::chrono::seconds fibColdStartDuration,
       std::shared_ptr<IoProvider> ioProvider,
-      uint32_t memLimit = openr::memLimitMB);
+      uint32_t memLimit = openr::memLimitMB,
+      bool enablePerfMeasurement = false);
 
   ~OpenrWrapper() {
     stop();
@@ -85,6 +86,11 @@ class OpenrWrapper {
    */
   thrift::RouteDatabase fibDumpRouteDatabase();
 
+  /**
+   * get perf database from fib, requires perf measurement to be enabled
+   */
+  thrift::PerfDatabase fibDumpPerfDatabase();
+
   /**
    * add prefix entries into prefix manager using prefix manager client
    */
@@ -160,13 +166,14 @@ class OpenrWrapper {
   // sub module communication zmq urls and ports
   int kvStoreGlobalCmdPort_{0};
   const std::string kvStoreGlobalCmdUrl_;
-  messaging::ReplicateQueue<DecisionRouteUpdate> routeUpdatesQueue_;
-  messaging::ReplicateQueue<thrift::InterfaceDatabase> interfaceUpdatesQueue_;
+  messaging::ReplicateQueue<DecisionRouteUpdatePtr> routeUpdatesQueue_;
+  messaging::ReplicateQueue<InterfaceDatabaseUpdate> interfaceUpdatesQueue_;
+  messaging::ReplicateQueue<InterfaceStatusEvent> interfaceStatusEventsQueue_;
   messaging::ReplicateQueue<thrift::PeerUpdateRequest> peerUpdatesQueue_;
   messaging::ReplicateQueue<thrift::SparkNeighborEvent> neighborUpdatesQueue_;
   messaging::ReplicateQueue<KvStoreSyncEvent> kvStoreSyncEventsQueue_;
   messaging::ReplicateQueue<thrift::PrefixUpdateRequest> prefixUpdatesQueue_;
-  messaging::ReplicateQueue<thrift::Publication> kvStoreUpdatesQueue_;
+  messaging::ReplicateQueue<PublicationPtr> kvStoreUpdatesQueue_;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> staticRoutesQueue_;
   messaging::ReplicateQueue<thrift::RouteDatabaseDelta> fibUpdatesQueue_;
   messaging::ReplicateQueue<openr::LogSample> logSampleQueue_;
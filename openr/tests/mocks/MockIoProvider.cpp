@@ -67,7 +67,13 @@ MockIoProvider::bind(
 }
 
 ssize_t
-MockIoProvider::recvmsg(int sockFd, struct msghdr* msg, int /* flags */) {
+MockIoProvider::recvmsg(int sockFd, struct msghdr* msg, int flags) {
+  // transmit timestamps are not emulated, error queue is always empty
+  if (flags & MSG_ERRQUEUE) {
+    errno = EAGAIN;
+    return -1;
+  }
+
   std::lock_guard<std::mutex> lock(mutex_);
 
   SCOPE_FAIL {
@@ -258,6 +264,59 @@ MockIoProvider::sendmsg(int sockFd, const struct msghdr* msg, int /* flags */) {
   return -1;
 }
 
+int
+MockIoProvider::recvmmsg(
+    int sockFd, struct mmsghdr* msgvec, unsigned int vlen, int flags) {
+  VLOG(4) << "MockIoProvider::recvmmsg called";
+
+  unsigned int numRead = 0;
+  for (; numRead < vlen; ++numRead) {
+    // don't deliver messages ahead of their latency
+    if (numRead > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = mailboxes_.find(sockFd);
+      if (it == mailboxes_.end() or it->second.empty() or
+          not it->second.front().isActive()) {
+        break;
+      }
+    }
+
+    auto& msg = msgvec[numRead];
+    auto bytesRead = recvmsg(sockFd, &msg.msg_hdr, flags);
+    if (bytesRead < 0) {
+      break;
+    }
+    msg.msg_len = bytesRead;
+  }
+
+  if (numRead == 0) {
+    errno = EAGAIN;
+    return -1;
+  }
+  return numRead;
+}
+
+int
+MockIoProvider::sendmmsg(
+    int sockFd, struct mmsghdr* msgvec, unsigned int vlen, int flags) {
+  VLOG(4) << "MockIoProvider::sendmmsg called";
+
+  unsigned int numSent = 0;
+  for (; numSent < vlen; ++numSent) {
+    auto& msg = msgvec[numSent];
+    auto bytesSent = sendmsg(sockFd, &msg.msg_hdr, flags);
+    if (bytesSent < 0) {
+      break;
+    }
+    msg.msg_len = bytesSent;
+  }
+
+  if (numSent == 0) {
+    return -1;
+  }
+  return numSent;
+}
+
 //
 // Simply accept all setsockopts, and build fd to ifName mapping
 //
@@ -97,6 +97,16 @@ class MockIoProvider final : public IoProvider {
 
   ssize_t sendmsg(int sockfd, const struct msghdr* msg, int flags) override;
 
+  // Batched versions simply loop over recvmsg/sendmsg. recvmmsg stops at
+  // first message which is not yet due for delivery.
+  int recvmmsg(
+      int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags)
+      override;
+
+  int sendmmsg(
+      int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags)
+      override;
+
   int setsockopt(
       int sockfd,
       int level,
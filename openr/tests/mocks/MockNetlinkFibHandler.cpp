@@ -61,8 +61,14 @@ MockNetlinkFibHandler::deleteUnicastRoute(
 void
 MockNetlinkFibHandler::addUnicastRoutes(
     int16_t, std::unique_ptr<std::vector<openr::thrift::UnicastRoute>> routes) {
+  thrift::PlatformFibUpdateError error;
+  const auto routesToFail = unicastRoutesToFail_.copy();
   SYNCHRONIZED(unicastRouteDb_) {
     for (auto const& route : *routes) {
+      if (routesToFail.count(*route.dest_ref())) {
+        error.failedAddUpdatePrefixes_ref()->emplace_back(*route.dest_ref());
+        continue;
+      }
       auto prefix = std::make_pair(
           toIPAddress(*route.dest_ref()->prefixAddress_ref()),
           *route.dest_ref()->prefixLength_ref());
@@ -78,8 +84,12 @@ MockNetlinkFibHandler::addUnicastRoutes(
       unicastRouteDb_.emplace(prefix, newNextHops);
     }
   }
-  addRoutesCount_ += routes->size();
+  addRoutesCount_ +=
+      routes->size() - error.failedAddUpdatePrefixes_ref()->size();
   updateUnicastRoutesBaton_.post();
+  if (not error.failedAddUpdatePrefixes_ref()->empty()) {
+    throw error;
+  }
 }
 
 void
@@ -250,6 +260,12 @@ MockNetlinkFibHandler::waitForSyncMplsFib() {
   syncMplsFibBaton_.reset();
 }
 
+void
+MockNetlinkFibHandler::setUnicastRoutesToFail(
+    std::unordered_set<thrift::IpPrefix> prefixes) {
+  *unicastRoutesToFail_.wlock() = std::move(prefixes);
+}
+
 void
 MockNetlinkFibHandler::stop() {
   SYNCHRONIZED(unicastRouteDb_) {
@@ -109,6 +109,10 @@ class MockNetlinkFibHandler final : public thrift::FibServiceSvIf {
     return delMplsRoutesCount_;
   }
 
+  // Fail adding routes of these prefixes with PlatformFibUpdateError, while
+  // adding others of the same request
+  void setUnicastRoutesToFail(std::unordered_set<thrift::IpPrefix> prefixes);
+
   void stop();
 
   void restart();
@@ -120,6 +124,10 @@ class MockNetlinkFibHandler final : public thrift::FibServiceSvIf {
   // Abstract route Db to hide kernel level routing details from Fib
   folly::Synchronized<UnicastRoutes> unicastRouteDb_{};
 
+  // Prefixes whose routes fail to be added
+  folly::Synchronized<std::unordered_set<thrift::IpPrefix>>
+      unicastRoutesToFail_;
+
   // Mpls Route db
   folly::Synchronized<
       std::unordered_map<int32_t, std::vector<thrift::NextHopThrift>>>
@@ -7,6 +7,8 @@
 
 #include <openr/tests/mocks/MockNetlinkProtocolSocket.h>
 
+#include <openr/common/NetworkUtil.h>
+
 namespace openr::fbnl {
 
 namespace utils {
@@ -46,6 +48,12 @@ createIfAddress(const int ifIndex, const std::string& addrMask) {
 
 folly::SemiFuture<int>
 MockNetlinkProtocolSocket::addRoute(const fbnl::Route& route) {
+  // Like kernel, reject routes via unknown nexthop objects
+  if (route.getNextHopId() and
+      not nextHopObjects_.count(route.getNextHopId().value())) {
+    return folly::SemiFuture<int>(EINVAL);
+  }
+
   // Blindly replace existing route
   const auto proto = route.getProtocolId();
   if (route.getFamily() == AF_MPLS) {
@@ -70,13 +78,129 @@ MockNetlinkProtocolSocket::deleteRoute(const fbnl::Route& route) {
   return folly::SemiFuture<int>(cnt ? 0 : ESRCH);
 }
 
+folly::SemiFuture<fbnl::NetlinkBatchFailures>
+MockNetlinkProtocolSocket::addRoutes(
+    const std::vector<fbnl::Route>& routes,
+    std::unordered_set<int> errorsToIgnore) {
+  fbnl::NetlinkBatch batch(routes.size(), std::move(errorsToIgnore));
+  auto future = batch.getSemiFuture();
+  for (size_t i = 0; i < routes.size(); ++i) {
+    batch.setReturnStatus(i, std::move(addRoute(routes.at(i))).get());
+  }
+  return future;
+}
+
+folly::SemiFuture<fbnl::NetlinkBatchFailures>
+MockNetlinkProtocolSocket::deleteRoutes(
+    const std::vector<fbnl::Route>& routes,
+    std::unordered_set<int> errorsToIgnore) {
+  fbnl::NetlinkBatch batch(routes.size(), std::move(errorsToIgnore));
+  auto future = batch.getSemiFuture();
+  for (size_t i = 0; i < routes.size(); ++i) {
+    batch.setReturnStatus(i, std::move(deleteRoute(routes.at(i))).get());
+  }
+  return future;
+}
+
+folly::SemiFuture<fbnl::NetlinkBatchFailures>
+MockNetlinkProtocolSocket::addUnicastRoutes(
+    const std::vector<thrift::UnicastRoute>& routes,
+    const fbnl::UnicastRouteAttrs& attrs,
+    std::unordered_set<int> errorsToIgnore) {
+  // Build routes as kernel would report the encoded messages
+  fbnl::NetlinkBatch batch(routes.size(), std::move(errorsToIgnore));
+  auto future = batch.getSemiFuture();
+  for (size_t i = 0; i < routes.size(); ++i) {
+    const auto& route = routes.at(i);
+    fbnl::RouteBuilder rtBuilder;
+    rtBuilder.setDestination(toIPNetwork(route.dest))
+        .setProtocolId(attrs.protocolId)
+        .setPriority(attrs.priority)
+        .setFlags(0)
+        .setValid(true);
+    if (route.nextHops_ref()->empty()) {
+      rtBuilder.setType(RTN_BLACKHOLE);
+    }
+
+    int32_t maxWeight{0};
+    for (const auto& nh : *route.nextHops_ref()) {
+      maxWeight = std::max(maxWeight, *nh.weight_ref());
+    }
+    int status{0};
+    for (const auto& nh : *route.nextHops_ref()) {
+      fbnl::NextHopBuilder nhBuilder;
+      if (nh.address_ref()->ifName_ref()) {
+        auto ifIndex = attrs.getIfIndex(*nh.address_ref()->ifName_ref());
+        if (not ifIndex.has_value()) {
+          status = ENODEV;
+          break;
+        }
+        nhBuilder.setIfIndex(ifIndex.value());
+      }
+      nhBuilder.setGateway(toIPAddress(*nh.address_ref()));
+      if (nh.mplsAction_ref().has_value()) {
+        nhBuilder.setLabelAction(*nh.mplsAction_ref()->action_ref());
+        nhBuilder.setPushLabels(nh.mplsAction_ref()->pushLabels_ref().value());
+      }
+      nhBuilder.setWeight(toNetlinkWeight(*nh.weight_ref(), maxWeight));
+      rtBuilder.addNextHop(nhBuilder.build());
+    }
+    if (status == 0) {
+      status = std::move(addRoute(rtBuilder.build())).get();
+    }
+    batch.setReturnStatus(i, status);
+  }
+  return future;
+}
+
+folly::SemiFuture<int>
+MockNetlinkProtocolSocket::addNextHopObject(
+    const fbnl::NextHopObject& nextHop) {
+  // Like kernel, reject groups of unknown nexthop objects
+  for (auto const& [memberId, weight] : nextHop.getGroup()) {
+    if (not nextHopObjects_.count(memberId)) {
+      return folly::SemiFuture<int>(EINVAL);
+    }
+  }
+  nextHopObjects_.insert_or_assign(nextHop.getId(), nextHop);
+  return folly::SemiFuture<int>(0);
+}
+
+folly::SemiFuture<int>
+MockNetlinkProtocolSocket::deleteNextHopObject(uint32_t id) {
+  // Kernel returns ENOENT for unknown nexthop object
+  if (not nextHopObjects_.erase(id)) {
+    return folly::SemiFuture<int>(ENOENT);
+  }
+  // Kernel removes routes via deleted nexthop object
+  for (auto& [proto, routes] : unicastRoutes_) {
+    for (auto it = routes.begin(); it != routes.end();) {
+      if (it->second.getNextHopId() == id) {
+        it = routes.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  return folly::SemiFuture<int>(0);
+}
+
 folly::SemiFuture<folly::Expected<std::vector<fbnl::Route>, int>>
 MockNetlinkProtocolSocket::getRoutes(const fbnl::Route& filter) {
+  std::vector<fbnl::Route> result;
+  streamRoutes(filter, [&result](fbnl::Route&& route) {
+    result.emplace_back(std::move(route));
+  });
+  return result;
+}
+
+folly::SemiFuture<int>
+MockNetlinkProtocolSocket::streamRoutes(
+    const fbnl::Route& filter, std::function<void(fbnl::Route&&)> routeCb) {
   const auto filterFamily = filter.getFamily();
   const auto filterProto = filter.getProtocolId();
   const auto filterType = filter.getType();
 
-  std::vector<fbnl::Route> result;
   auto applyFilter = [&](const fbnl::Route& route) {
     // Filter on protocol
     if (filterProto && filterProto != route.getProtocolId()) {
@@ -93,7 +217,7 @@ MockNetlinkProtocolSocket::getRoutes(const fbnl::Route& filter) {
       return;
     }
 
-    result.emplace_back(route);
+    routeCb(fbnl::Route(route));
   };
 
   // Loop through mpls routes
@@ -110,7 +234,7 @@ MockNetlinkProtocolSocket::getRoutes(const fbnl::Route& filter) {
     }
   }
 
-  return result;
+  return folly::SemiFuture<int>(0);
 }
 
 folly::SemiFuture<int>
@@ -132,7 +256,7 @@ MockNetlinkProtocolSocket::addIfAddress(const fbnl::IfAddress& addr) {
   it->second.emplace_back(addr); // Add
 
   // Publish update via queue
-  netlinkEventsQueue_.push(addr);
+  publishEvent(addr);
   return folly::SemiFuture<int>(0);
 }
 
@@ -150,7 +274,7 @@ MockNetlinkProtocolSocket::deleteIfAddress(const fbnl::IfAddress& addr) {
       it->second.erase(addrIt);
 
       // Publish update via queue
-      netlinkEventsQueue_.push(addr);
+      publishEvent(addr);
       return folly::SemiFuture<int>(0);
     }
   }
@@ -168,16 +292,32 @@ MockNetlinkProtocolSocket::getAllIfAddresses() {
   return addrs;
 }
 
+void
+MockNetlinkProtocolSocket::setDropEvents(bool dropEvents) {
+  if (dropEvents_ and not dropEvents) {
+    netlinkEventsQueue_.push(NetlinkEventsLost{});
+  }
+  dropEvents_ = dropEvents;
+}
+
+void
+MockNetlinkProtocolSocket::publishEvent(NetlinkEvent&& event) {
+  if (not dropEvents_) {
+    netlinkEventsQueue_.push(std::move(event));
+  }
+}
+
 folly::SemiFuture<int>
 MockNetlinkProtocolSocket::addLink(const fbnl::Link& link) {
   // Add or update link
   links_[link.getIfIndex()] = link;
+  interfaceTable_.updateLink(link);
 
   // Create entry in ifAddr_ for link if doesn't exists
   ifAddrs_.emplace(link.getIfIndex(), std::list<fbnl::IfAddress>());
 
   // Publish update via queue
-  netlinkEventsQueue_.push(link);
+  publishEvent(link);
 
   return folly::SemiFuture<int>(0);
 }
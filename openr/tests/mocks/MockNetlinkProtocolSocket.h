@@ -53,8 +53,24 @@ class MockNetlinkProtocolSocket : public NetlinkProtocolSocket {
    */
   folly::SemiFuture<int> addRoute(const fbnl::Route& route) override;
   folly::SemiFuture<int> deleteRoute(const fbnl::Route& route) override;
+  folly::SemiFuture<fbnl::NetlinkBatchFailures> addRoutes(
+      const std::vector<fbnl::Route>& routes,
+      std::unordered_set<int> errorsToIgnore) override;
+  folly::SemiFuture<fbnl::NetlinkBatchFailures> deleteRoutes(
+      const std::vector<fbnl::Route>& routes,
+      std::unordered_set<int> errorsToIgnore) override;
+  folly::SemiFuture<fbnl::NetlinkBatchFailures> addUnicastRoutes(
+      const std::vector<thrift::UnicastRoute>& routes,
+      const fbnl::UnicastRouteAttrs& attrs,
+      std::unordered_set<int> errorsToIgnore) override;
+  folly::SemiFuture<int> addNextHopObject(
+      const fbnl::NextHopObject& nextHop) override;
+  folly::SemiFuture<int> deleteNextHopObject(uint32_t id) override;
   folly::SemiFuture<folly::Expected<std::vector<fbnl::Route>, int>> getRoutes(
       const fbnl::Route& filter) override;
+  folly::SemiFuture<int> streamRoutes(
+      const fbnl::Route& filter,
+      std::function<void(fbnl::Route&&)> routeCb) override;
 
   folly::SemiFuture<int> addIfAddress(const fbnl::IfAddress&) override;
   folly::SemiFuture<int> deleteIfAddress(const fbnl::IfAddress&) override;
@@ -67,6 +83,14 @@ class MockNetlinkProtocolSocket : public NetlinkProtocolSocket {
   folly::SemiFuture<folly::Expected<std::vector<fbnl::Neighbor>, int>>
   getAllNeighbors() override;
 
+  /**
+   * API to read programmed nexthop objects for testing
+   */
+  const std::map<uint32_t, fbnl::NextHopObject>&
+  getNextHopObjects() const {
+    return nextHopObjects_;
+  }
+
   /*
    * API to manipulate netlinkEvents queue
    */
@@ -85,6 +109,13 @@ class MockNetlinkProtocolSocket : public NetlinkProtocolSocket {
     netlinkEventsQueue_.close();
   }
 
+  /*
+   * API to emulate kernel dropping notifications, e.g. on receive buffer
+   * overrun. LINK/ADDR updates are applied without being published, and
+   * NetlinkEventsLost is published once events are no longer dropped.
+   */
+  void setDropEvents(bool dropEvents);
+
  protected:
   void
   init() override {
@@ -106,8 +137,17 @@ class MockNetlinkProtocolSocket : public NetlinkProtocolSocket {
       unicastRoutes_;
   std::unordered_map<uint8_t, std::map<uint32_t, fbnl::Route>> mplsRoutes_;
 
+  // map<nexthop id -> NextHopObject>
+  std::map<uint32_t, fbnl::NextHopObject> nextHopObjects_;
+
+  // publish event via queue unless events are dropped
+  void publishEvent(NetlinkEvent&& event);
+
   // queue to publish LINK/ADDR updates
   messaging::ReplicateQueue<NetlinkEvent> netlinkEventsQueue_;
+
+  // whether updates are not published, see setDropEvents()
+  bool dropEvents_{false};
 };
 
 } // namespace openr::fbnl
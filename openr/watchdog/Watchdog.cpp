@@ -7,7 +7,10 @@
 
 #include "Watchdog.h"
 
+#include <fb303/ServiceData.h>
+
 #include <openr/common/Constants.h>
+#include <openr/common/MemoryArenas.h>
 #include <openr/common/Util.h>
 
 namespace openr {
@@ -17,11 +20,19 @@ Watchdog::Watchdog(std::shared_ptr<const Config> config)
       interval_(*config->getWatchdogConfig().interval_s_ref()),
       threadTimeout_(*config->getWatchdogConfig().thread_timeout_s_ref()),
       maxMemoryMB_(*config->getWatchdogConfig().max_memory_mb_ref()),
+      memoryPressureModeratePct_(
+          *config->getWatchdogConfig().memory_pressure_moderate_pct_ref()),
+      memoryPressureSeverePct_(
+          *config->getWatchdogConfig().memory_pressure_severe_pct_ref()),
+      enableModuleMemoryArenas_(config->isModuleMemoryArenasEnabled()),
       previousStatus_(true) {
   // Schedule periodic timer for checking thread health
   watchdogTimer_ = folly::AsyncTimeout::make(*getEvb(), [this]() noexcept {
     updateCounters();
     monitorMemory();
+    if (enableModuleMemoryArenas_) {
+      updateModuleMemoryCounters();
+    }
     // Schedule next timer
     watchdogTimer_->scheduleTimeout(interval_);
   });
@@ -45,12 +56,70 @@ Watchdog::memoryLimitExceeded() {
   return result;
 }
 
+void
+Watchdog::addMemoryPressureCallback(
+    std::function<void(MemoryPressure)> callback) {
+  CHECK(callback);
+  getEvb()->runInEventBaseThreadAndWait(
+      [this, callback = std::move(callback)]() mutable {
+        memoryPressureCallbacks_.emplace_back(std::move(callback));
+      });
+}
+
+MemoryPressure
+Watchdog::getMemoryPressure() {
+  MemoryPressure result;
+  getEvb()->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [&result, this]() { result = memoryPressure_; });
+  return result;
+}
+
+void
+Watchdog::updateMemoryPressure(uint64_t memInUseBytes) {
+  if (not maxMemoryMB_) {
+    return;
+  }
+  const double memInUsePct = memInUseBytes / 1e6 * 100 / maxMemoryMB_;
+  auto levelAt = [&](int32_t offsetPct) {
+    if (memInUsePct >= memoryPressureSeverePct_ - offsetPct) {
+      return MemoryPressure::SEVERE;
+    }
+    if (memInUsePct >= memoryPressureModeratePct_ - offsetPct) {
+      return MemoryPressure::MODERATE;
+    }
+    return MemoryPressure::NONE;
+  };
+
+  auto level = levelAt(0);
+  if (level < memoryPressure_) {
+    // leave a level only once usage is well below it
+    level = std::max(level, levelAt(Constants::kMemoryPressureHysteresisPct));
+  }
+  if (level != memoryPressure_) {
+    LOG(INFO) << "Memory pressure level changed from "
+              << static_cast<int>(memoryPressure_) << " to "
+              << static_cast<int>(level) << ", memory used: " << memInUseBytes
+              << " bytes, memory limit: " << maxMemoryMB_ << " MB";
+  }
+  const bool notify = level != MemoryPressure::NONE or
+      memoryPressure_ != MemoryPressure::NONE;
+  memoryPressure_ = level;
+  fb303::fbData->setCounter(
+      "watchdog.memory_pressure", static_cast<int>(memoryPressure_));
+  if (notify) {
+    for (auto const& callback : memoryPressureCallbacks_) {
+      callback(memoryPressure_);
+    }
+  }
+}
+
 void
 Watchdog::monitorMemory() {
   auto memInUse_ = systemMetrics_.getRSSMemBytes();
   if (not memInUse_.has_value()) {
     return;
   }
+  updateMemoryPressure(memInUse_.value());
   if (memInUse_.value() / 1e6 > maxMemoryMB_) {
     LOG(WARNING) << "Memory usage critical:" << memInUse_.value() << " bytes,"
                  << " Memory limit:" << maxMemoryMB_ << " MB";
@@ -76,6 +145,20 @@ Watchdog::monitorMemory() {
   }
 }
 
+void
+Watchdog::updateModuleMemoryCounters() {
+  for (auto const& stats : getModuleMemoryStats()) {
+    fb303::fbData->setCounter(
+        folly::sformat(
+            "watchdog.memory.{}.allocated_bytes", *stats.module_ref()),
+        *stats.allocated_bytes_ref());
+    fb303::fbData->setCounter(
+        folly::sformat(
+            "watchdog.memory.{}.resident_bytes", *stats.module_ref()),
+        *stats.resident_bytes_ref());
+  }
+}
+
 void
 Watchdog::updateCounters() {
   VLOG(2) << "Checking thread aliveness counters...";
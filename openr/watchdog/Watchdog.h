@@ -7,9 +7,11 @@
 
 #pragma once
 
+#include <functional>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <fbzmq/service/monitor/SystemMetrics.h>
 #include <folly/io/async/AsyncTimeout.h>
@@ -17,6 +19,7 @@
 
 #include <openr/common/Constants.h>
 #include <openr/common/OpenrEventBase.h>
+#include <openr/common/Types.h>
 #include <openr/config/Config.h>
 
 namespace openr {
@@ -33,12 +36,25 @@ class Watchdog final : public OpenrEventBase {
 
   bool memoryLimitExceeded();
 
+  // Subscribe to memory pressure. Callback is called on the watchdog thread
+  // on every memory check while under pressure, so that modules keep shedding
+  // memory, and once more when pressure is gone. It must not block
+  void addMemoryPressureCallback(std::function<void(MemoryPressure)> callback);
+
+  MemoryPressure getMemoryPressure();
+
  private:
   void updateCounters();
 
   // monitor memory usage
   void monitorMemory();
 
+  // derive memory pressure level from memory usage and notify subscribers
+  void updateMemoryPressure(uint64_t memInUseBytes);
+
+  // export allocated and resident bytes of module memory arenas
+  void updateModuleMemoryCounters();
+
   void fireCrash(const std::string& msg);
 
   const std::string myNodeName_;
@@ -58,6 +74,17 @@ class Watchdog final : public OpenrEventBase {
   // critcal memory threhsold
   uint32_t maxMemoryMB_{0};
 
+  // memory pressure thresholds in percent of maxMemoryMB_
+  const int32_t memoryPressureModeratePct_{0};
+  const int32_t memoryPressureSeverePct_{0};
+
+  MemoryPressure memoryPressure_{MemoryPressure::NONE};
+
+  std::vector<std::function<void(MemoryPressure)>> memoryPressureCallbacks_;
+
+  // whether module threads are bound to their own jemalloc arena
+  const bool enableModuleMemoryArenas_{false};
+
   // boolean to indicate previous failure
   bool previousStatus_{true};
 